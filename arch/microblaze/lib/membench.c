@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Boot time selection of the memcpy() and memset() loops
+ *
+ * Whether unrolled cache line loops beat plain word loops depends on the
+ * core configuration (cache line length, write back or write through data
+ * cache, bus width), which is not fully described by the PVR. Time both
+ * variants on a cache hot page and keep the faster one.
+ */
+
+#define pr_fmt(fmt) "membench: " fmt
+
+#include <linux/errno.h>
+#include <linux/gfp.h>
+#include <linux/init.h>
+#include <linux/irqflags.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/timekeeping.h>
+
+#include "membench.h"
+
+bool mb_memcpy_lines __read_mostly = true;
+bool mb_memset_lines __read_mostly = true;
+
+#define MEMBENCH_LOOPS	32
+#define MEMBENCH_ROUNDS	4
+
+static u64 __init membench_run(bool memcpy_test, void *dst, void *src)
+{
+	u64 best = U64_MAX, start, delta;
+	unsigned long flags;
+	int round, i;
+
+	for (round = 0; round < MEMBENCH_ROUNDS; round++) {
+		local_irq_save(flags);
+		start = ktime_get_ns();
+		for (i = 0; i < MEMBENCH_LOOPS; i++) {
+			if (memcpy_test)
+				memcpy(dst, src, PAGE_SIZE);
+			else
+				memset(dst, i, PAGE_SIZE);
+		}
+		delta = ktime_get_ns() - start;
+		local_irq_restore(flags);
+
+		best = min(best, delta);
+	}
+
+	return best;
+}
+
+static int __init membench_init(void)
+{
+	u64 words, lines;
+	void *dst, *src;
+
+	dst = (void *)__get_free_pages(GFP_KERNEL, 1);
+	if (!dst)
+		return -ENOMEM;
+	src = dst + PAGE_SIZE;
+	memset(src, 0x5a, PAGE_SIZE);
+
+	/* fastcopy.S replaces memcpy.c and has no selectable loop */
+	if (!IS_ENABLED(CONFIG_OPT_LIB_ASM)) {
+		mb_memcpy_lines = false;
+		words = membench_run(true, dst, src);
+		mb_memcpy_lines = true;
+		lines = membench_run(true, dst, src);
+		mb_memcpy_lines = lines <= words;
+		pr_info("memcpy: words %llu ns, lines %llu ns, using %s\n",
+			words, lines, mb_memcpy_lines ? "lines" : "words");
+	}
+
+	mb_memset_lines = false;
+	words = membench_run(false, dst, src);
+	mb_memset_lines = true;
+	lines = membench_run(false, dst, src);
+	mb_memset_lines = lines <= words;
+	pr_info("memset: words %llu ns, lines %llu ns, using %s\n",
+		words, lines, mb_memset_lines ? "lines" : "words");
+
+	free_pages((unsigned long)dst, 1);
+
+	return 0;
+}
+late_initcall(membench_init);
@@ -0,0 +1,11 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef __ASM_MEMBENCH_H
+#define __ASM_MEMBENCH_H
+
+#include <linux/types.h>
+
+/* Use the cache line loops of memcpy() and memset(), see membench.c */
+extern bool mb_memcpy_lines;
+extern bool mb_memset_lines;
+
+#endif /* __ASM_MEMBENCH_H */
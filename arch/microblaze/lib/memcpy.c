@@ -31,6 +31,8 @@
 
 #include <linux/string.h>
 
+#include "membench.h"
+
 #ifdef CONFIG_OPT_LIB_FUNCTION
 void *memcpy(void *v_dst, const void *v_src, __kernel_size_t c)
 {
@@ -73,11 +75,53 @@ void *memcpy(void *v_dst, const void *v_src, __kernel_size_t c)
 		case 0x0:	/* Both byte offsets are aligned */
 			i_src  = (const void *)src;
 
+			if (mb_memcpy_lines) {
+				/* Align the destination to a cache line */
+				for (; c >= 4 && ((unsigned long)i_dst & 0x1f);
+				     c -= 4)
+					*i_dst++ = *i_src++;
+
+				/* Load a full line before storing it back */
+				for (; c >= 32; c -= 32) {
+					uint32_t w0 = i_src[0], w1 = i_src[1];
+					uint32_t w2 = i_src[2], w3 = i_src[3];
+					uint32_t w4 = i_src[4], w5 = i_src[5];
+					uint32_t w6 = i_src[6], w7 = i_src[7];
+
+					i_dst[0] = w0;
+					i_dst[1] = w1;
+					i_dst[2] = w2;
+					i_dst[3] = w3;
+					i_dst[4] = w4;
+					i_dst[5] = w5;
+					i_dst[6] = w6;
+					i_dst[7] = w7;
+					i_src += 8;
+					i_dst += 8;
+				}
+			}
+
 			for (; c >= 4; c -= 4)
 				*i_dst++ = *i_src++;
 
 			src  = (const void *)i_src;
 			break;
+#if !CONFIG_XILINX_MICROBLAZE0_USE_BARREL
+		default:
+			/*
+			 * Without a barrel shifter every shift of the merge
+			 * loops below is a sequence of single bit shifts,
+			 * which is slower than copying bytes.
+			 */
+			for (; c >= 4; c -= 4) {
+				*dst++ = *src++;
+				*dst++ = *src++;
+				*dst++ = *src++;
+				*dst++ = *src++;
+			}
+			i_dst = (void *)dst;
+			break;
+#else
 		case 0x1:	/* Unaligned - Off by 1 */
 			/* Word align the source */
 			i_src = (const void *) ((unsigned)src & ~3);
@@ -156,6 +200,7 @@ void *memcpy(void *v_dst, const void *v_src, __kernel_size_t c)
 			src = (const void *)i_src;
 			src -= 1;
 			break;
+#endif /* CONFIG_XILINX_MICROBLAZE0_USE_BARREL */
 		}
 		dst = (void *)i_dst;
 	}
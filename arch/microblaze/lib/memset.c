@@ -30,6 +30,8 @@
 #include <linux/compiler.h>
 #include <linux/string.h>
 
+#include "membench.h"
+
 #ifdef CONFIG_OPT_LIB_FUNCTION
 void *memset(void *v_src, int c, __kernel_size_t n)
 {
@@ -66,6 +68,25 @@ void *memset(void *v_src, int c, __kernel_size_t n)
 
 		i_src  = (void *)src;
 
+		if (mb_memset_lines) {
+			/* Align the destination to a cache line */
+			for (; n >= 4 && ((unsigned long)i_src & 0x1f); n -= 4)
+				*i_src++ = w32;
+
+			/* Fill a full line per iteration */
+			for (; n >= 32; n -= 32) {
+				i_src[0] = w32;
+				i_src[1] = w32;
+				i_src[2] = w32;
+				i_src[3] = w32;
+				i_src[4] = w32;
+				i_src[5] = w32;
+				i_src[6] = w32;
+				i_src[7] = w32;
+				i_src += 8;
+			}
+		}
+
 		/* Do as many full-word copies as we can */
 		for (; n >= 4; n -= 4)
 			*i_src++ = w32;
@@ -37,6 +37,11 @@ module_param(num_prealloc_fallback_crypt_ctxs, uint, 0);
 MODULE_PARM_DESC(num_prealloc_crypt_fallback_ctxs,
 		 "Number of preallocated bio fallback crypto contexts for blk-crypto to use during crypto API fallback");
 
+static unsigned int num_inflight_data_units = 16;
+module_param(num_inflight_data_units, uint, 0);
+MODULE_PARM_DESC(num_inflight_data_units,
+		 "Number of data units of a bio handed to an asynchronous crypto driver at once");
+
 struct bio_fallback_crypt_ctx {
 	struct bio_crypt_ctx crypt_ctx;
 	/*
@@ -183,30 +188,6 @@ static struct bio *blk_crypto_fallback_clone_bio(struct bio *bio_src)
 	return bio;
 }
 
-static bool
-blk_crypto_fallback_alloc_cipher_req(struct blk_crypto_keyslot *slot,
-				     struct skcipher_request **ciph_req_ret,
-				     struct crypto_wait *wait)
-{
-	struct skcipher_request *ciph_req;
-	const struct blk_crypto_fallback_keyslot *slotp;
-	int keyslot_idx = blk_crypto_keyslot_index(slot);
-
-	slotp = &blk_crypto_keyslots[keyslot_idx];
-	ciph_req = skcipher_request_alloc(slotp->tfms[slotp->crypto_mode],
-					  GFP_NOIO);
-	if (!ciph_req)
-		return false;
-
-	skcipher_request_set_callback(ciph_req,
-				      CRYPTO_TFM_REQ_MAY_BACKLOG |
-				      CRYPTO_TFM_REQ_MAY_SLEEP,
-				      crypto_req_done, wait);
-	*ciph_req_ret = ciph_req;
-
-	return true;
-}
-
 static bool blk_crypto_fallback_split_bio_if_needed(struct bio **bio_ptr)
 {
 	struct bio *bio = *bio_ptr;
@@ -251,6 +232,134 @@ static void blk_crypto_dun_to_iv(const u64 dun[BLK_CRYPTO_DUN_ARRAY_SIZE],
 		iv->dun[i] = cpu_to_le64(dun[i]);
 }
 
+/*
+ * Each data unit has its own IV, so it takes a request of its own. Waiting
+ * for each one in turn would leave an asynchronous engine (such as a SoC
+ * crypto accelerator) with a single data unit to work on, so a batch keeps
+ * up to num_inflight_data_units of them in flight and only waits when it is
+ * full or the bio is done.
+ */
+struct blk_crypto_fallback_unit {
+	struct skcipher_request *req;
+	struct crypto_wait wait;
+	struct scatterlist src, dst;
+	union blk_crypto_iv iv;
+	int err;
+};
+
+struct blk_crypto_fallback_batch {
+	unsigned int nr;	/* units submitted and not yet waited for */
+	unsigned int size;
+	struct blk_crypto_fallback_unit units[];
+};
+
+static void blk_crypto_fallback_free_batch(struct blk_crypto_fallback_batch *b)
+{
+	unsigned int i;
+
+	for (i = 0; i < b->size; i++)
+		skcipher_request_free(b->units[i].req);
+	kfree(b);
+}
+
+static struct blk_crypto_fallback_batch *
+__blk_crypto_fallback_alloc_batch(struct crypto_skcipher *tfm,
+				  unsigned int size)
+{
+	struct blk_crypto_fallback_batch *b;
+	unsigned int i;
+
+	b = kzalloc(struct_size(b, units, size), GFP_NOIO);
+	if (!b)
+		return NULL;
+
+	for (i = 0; i < size; i++) {
+		struct blk_crypto_fallback_unit *u = &b->units[i];
+
+		u->req = skcipher_request_alloc(tfm, GFP_NOIO);
+		if (!u->req) {
+			blk_crypto_fallback_free_batch(b);
+			return NULL;
+		}
+		b->size++;
+
+		crypto_init_wait(&u->wait);
+		skcipher_request_set_callback(u->req,
+					      CRYPTO_TFM_REQ_MAY_BACKLOG |
+					      CRYPTO_TFM_REQ_MAY_SLEEP,
+					      crypto_req_done, &u->wait);
+		sg_init_table(&u->src, 1);
+		sg_init_table(&u->dst, 1);
+	}
+
+	return b;
+}
+
+static struct blk_crypto_fallback_batch *
+blk_crypto_fallback_alloc_batch(struct blk_crypto_keyslot *slot)
+{
+	const struct blk_crypto_fallback_keyslot *slotp =
+		&blk_crypto_keyslots[blk_crypto_keyslot_index(slot)];
+	struct crypto_skcipher *tfm = slotp->tfms[slotp->crypto_mode];
+	struct blk_crypto_fallback_batch *b = NULL;
+
+	/* a synchronous tfm is done by the time the request returns */
+	if ((crypto_skcipher_alg(tfm)->base.cra_flags & CRYPTO_ALG_ASYNC) &&
+	    num_inflight_data_units > 1)
+		b = __blk_crypto_fallback_alloc_batch(tfm,
+						      num_inflight_data_units);
+
+	return b ?: __blk_crypto_fallback_alloc_batch(tfm, 1);
+}
+
+/* Wait for all the data units in flight. Returns 0 or the first error. */
+static int blk_crypto_fallback_flush_batch(struct blk_crypto_fallback_batch *b)
+{
+	unsigned int i;
+	int ret = 0;
+
+	for (i = 0; i < b->nr; i++) {
+		struct blk_crypto_fallback_unit *u = &b->units[i];
+		int err = crypto_wait_req(u->err, &u->wait);
+
+		if (err && !ret)
+			ret = err;
+	}
+	b->nr = 0;
+
+	return ret;
+}
+
+/*
+ * Start en/decrypting one data unit from @src to @dst, which may be the same
+ * page. Returns non-zero if an earlier data unit failed; this one is then
+ * not submitted.
+ */
+static int blk_crypto_fallback_queue_unit(struct blk_crypto_fallback_batch *b,
+					  struct page *src, struct page *dst,
+					  unsigned int offset, unsigned int len,
+					  const u64 *dun, bool encrypt)
+{
+	struct blk_crypto_fallback_unit *u;
+	int err;
+
+	if (b->nr == b->size) {
+		err = blk_crypto_fallback_flush_batch(b);
+		if (err)
+			return err;
+	}
+
+	u = &b->units[b->nr++];
+	blk_crypto_dun_to_iv(dun, &u->iv);
+	sg_set_page(&u->src, src, len, offset);
+	sg_set_page(&u->dst, dst, len, offset);
+	skcipher_request_set_crypt(u->req, &u->src, &u->dst, len, u->iv.bytes);
+
+	u->err = encrypt ? crypto_skcipher_encrypt(u->req) :
+			   crypto_skcipher_decrypt(u->req);
+	return 0;
+}
+
 /*
  * The crypto API fallback's encryption routine.
  * Allocate a bounce bio for encryption, encrypt the input bio using crypto API,
@@ -264,11 +373,8 @@ static bool blk_crypto_fallback_encrypt_bio(struct bio **bio_ptr)
 	struct bio_crypt_ctx *bc;
 	struct blk_crypto_keyslot *slot;
 	int data_unit_size;
-	struct skcipher_request *ciph_req = NULL;
-	DECLARE_CRYPTO_WAIT(wait);
+	struct blk_crypto_fallback_batch *batch;
 	u64 curr_dun[BLK_CRYPTO_DUN_ARRAY_SIZE];
-	struct scatterlist src, dst;
-	union blk_crypto_iv iv;
 	unsigned int i, j;
 	bool ret = false;
 	blk_status_t blk_st;
@@ -299,18 +405,14 @@ static bool blk_crypto_fallback_encrypt_bio(struct bio **bio_ptr)
 		goto out_put_enc_bio;
 	}
 
-	/* and then allocate an skcipher_request for it */
-	if (!blk_crypto_fallback_alloc_cipher_req(slot, &ciph_req, &wait)) {
+	/* and then allocate the skcipher_requests for it */
+	batch = blk_crypto_fallback_alloc_batch(slot);
+	if (!batch) {
 		src_bio->bi_status = BLK_STS_RESOURCE;
 		goto out_release_keyslot;
 	}
 
 	memcpy(curr_dun, bc->bc_dun, sizeof(curr_dun));
-	sg_init_table(&src, 1);
-	sg_init_table(&dst, 1);
-
-	skcipher_request_set_crypt(ciph_req, &src, &dst, data_unit_size,
-				   iv.bytes);
 
 	/* Encrypt each page in the bounce bio */
 	for (i = 0; i < enc_bio->bi_vcnt; i++) {
@@ -326,40 +428,41 @@ static bool blk_crypto_fallback_encrypt_bio(struct bio **bio_ptr)
 			goto out_free_bounce_pages;
 		}
 
-		sg_set_page(&src, plaintext_page, data_unit_size,
-			    enc_bvec->bv_offset);
-		sg_set_page(&dst, ciphertext_page, data_unit_size,
-			    enc_bvec->bv_offset);
-
 		/* Encrypt each data unit in this page */
 		for (j = 0; j < enc_bvec->bv_len; j += data_unit_size) {
-			blk_crypto_dun_to_iv(curr_dun, &iv);
-			if (crypto_wait_req(crypto_skcipher_encrypt(ciph_req),
-					    &wait)) {
+			if (blk_crypto_fallback_queue_unit(batch,
+					plaintext_page, ciphertext_page,
+					enc_bvec->bv_offset + j,
+					data_unit_size, curr_dun, true)) {
 				i++;
 				src_bio->bi_status = BLK_STS_IOERR;
 				goto out_free_bounce_pages;
 			}
 			bio_crypt_dun_increment(curr_dun, 1);
-			src.offset += data_unit_size;
-			dst.offset += data_unit_size;
 		}
 	}
 
+	if (blk_crypto_fallback_flush_batch(batch)) {
+		src_bio->bi_status = BLK_STS_IOERR;
+		goto out_free_bounce_pages;
+	}
+
 	enc_bio->bi_private = src_bio;
 	enc_bio->bi_end_io = blk_crypto_fallback_encrypt_endio;
 	*bio_ptr = enc_bio;
 	ret = true;
 
 	enc_bio = NULL;
-	goto out_free_ciph_req;
+	goto out_free_batch;
 
 out_free_bounce_pages:
+	/* nothing may still be writing to the bounce pages */
+	blk_crypto_fallback_flush_batch(batch);
 	while (i > 0)
 		mempool_free(enc_bio->bi_io_vec[--i].bv_page,
 			     blk_crypto_bounce_page_pool);
-out_free_ciph_req:
-	skcipher_request_free(ciph_req);
+out_free_batch:
+	blk_crypto_fallback_free_batch(batch);
 out_release_keyslot:
 	blk_crypto_put_keyslot(slot);
 out_put_enc_bio:
@@ -380,11 +483,8 @@ static void blk_crypto_fallback_decrypt_bio(struct work_struct *work)
 	struct bio *bio = f_ctx->bio;
 	struct bio_crypt_ctx *bc = &f_ctx->crypt_ctx;
 	struct blk_crypto_keyslot *slot;
-	struct skcipher_request *ciph_req = NULL;
-	DECLARE_CRYPTO_WAIT(wait);
+	struct blk_crypto_fallback_batch *batch;
 	u64 curr_dun[BLK_CRYPTO_DUN_ARRAY_SIZE];
-	union blk_crypto_iv iv;
-	struct scatterlist sg;
 	struct bio_vec bv;
 	struct bvec_iter iter;
 	const int data_unit_size = bc->bc_key->crypto_cfg.data_unit_size;
@@ -402,38 +502,36 @@ static void blk_crypto_fallback_decrypt_bio(struct work_struct *work)
 		goto out_no_keyslot;
 	}
 
-	/* and then allocate an skcipher_request for it */
-	if (!blk_crypto_fallback_alloc_cipher_req(slot, &ciph_req, &wait)) {
+	/* and then allocate the skcipher_requests for it */
+	batch = blk_crypto_fallback_alloc_batch(slot);
+	if (!batch) {
 		bio->bi_status = BLK_STS_RESOURCE;
-		goto out;
+		goto out_put_keyslot;
 	}
 
 	memcpy(curr_dun, bc->bc_dun, sizeof(curr_dun));
-	sg_init_table(&sg, 1);
-	skcipher_request_set_crypt(ciph_req, &sg, &sg, data_unit_size,
-				   iv.bytes);
 
 	/* Decrypt each segment in the bio */
 	__bio_for_each_segment(bv, bio, iter, f_ctx->crypt_iter) {
 		struct page *page = bv.bv_page;
 
-		sg_set_page(&sg, page, data_unit_size, bv.bv_offset);
-
 		/* Decrypt each data unit in the segment */
 		for (i = 0; i < bv.bv_len; i += data_unit_size) {
-			blk_crypto_dun_to_iv(curr_dun, &iv);
-			if (crypto_wait_req(crypto_skcipher_decrypt(ciph_req),
-					    &wait)) {
+			if (blk_crypto_fallback_queue_unit(batch, page, page,
+					bv.bv_offset + i, data_unit_size,
+					curr_dun, false)) {
 				bio->bi_status = BLK_STS_IOERR;
 				goto out;
 			}
 			bio_crypt_dun_increment(curr_dun, 1);
-			sg.offset += data_unit_size;
 		}
 	}
 
 out:
-	skcipher_request_free(ciph_req);
+	if (blk_crypto_fallback_flush_batch(batch))
+		bio->bi_status = BLK_STS_IOERR;
+	blk_crypto_fallback_free_batch(batch);
+out_put_keyslot:
 	blk_crypto_put_keyslot(slot);
 out_no_keyslot:
 	mempool_free(f_ctx, bio_fallback_crypt_ctx_pool);
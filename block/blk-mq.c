@@ -4221,9 +4221,13 @@ int blk_mq_init_allocated_queue(struct blk_mq_tag_set *set,
 	q->nr_requests = set->queue_depth;
 
 	/*
-	 * Default to classic polling
+	 * Default to classic polling, unless the driver asked for hybrid
+	 * polling sized from the completion stats.
 	 */
-	q->poll_nsec = BLK_MQ_POLL_CLASSIC;
+	if (set->flags & BLK_MQ_F_HYBRID_POLL)
+		q->poll_nsec = 0;
+	else
+		q->poll_nsec = BLK_MQ_POLL_CLASSIC;
 
 	blk_mq_init_cpu_queues(q, set->nr_hw_queues);
 	blk_mq_add_queue_tag_set(set, q);
@@ -4757,6 +4761,7 @@ static void blk_mq_poll_stats_fn(struct blk_stat_callback *cb)
 static unsigned long blk_mq_poll_nsecs(struct request_queue *q,
 				       struct request *rq)
 {
+	struct blk_rq_stat *stat;
 	unsigned long ret = 0;
 	int bucket;
 
@@ -4769,19 +4774,23 @@ static unsigned long blk_mq_poll_nsecs(struct request_queue *q,
 
 	/*
 	 * As an optimistic guess, use half of the mean service time
-	 * for this type of request. We can (and should) make this smarter.
-	 * For instance, if the completion latencies are tight, we can
-	 * get closer than just half the mean. This is especially
-	 * important on devices where the completion latencies are longer
-	 * than ~10 usec. We do use the stats for the relevant IO size
-	 * if available which does lead to better estimates.
+	 * for this type of request. If the completion latencies are tight,
+	 * get closer: sleep until as far below the fastest completion as
+	 * the mean is above it. This matters on devices where the completion
+	 * latencies are longer than ~10 usec. We do use the stats for the
+	 * relevant IO size if available which does lead to better estimates.
 	 */
 	bucket = blk_mq_poll_stats_bkt(rq);
 	if (bucket < 0)
 		return ret;
 
-	if (q->poll_stat[bucket].nr_samples)
-		ret = (q->poll_stat[bucket].mean + 1) / 2;
+	stat = &q->poll_stat[bucket];
+	if (stat->nr_samples) {
+		ret = (stat->mean + 1) / 2;
+		if (2 * stat->min > stat->mean)
+			ret = max_t(unsigned long, ret,
+				    2 * stat->min - stat->mean);
+	}
 
 	return ret;
 }
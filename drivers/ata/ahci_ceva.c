@@ -32,7 +32,8 @@
 #define PAXIC_MARID(i)	(((i) * 2) << 12)
 #define PAXIC_MARIDD(i)	((((i) * 2) + 1) << 16)
 #define PAXIC_MAWIDD(i)	((((i) * 2) + 1) << 8)
-#define PAXIC_OTL	(0x4 << 20)
+#define PAXIC_OTL(x)	(((x) & 0xf) << 20)
+#define PAXIC_OTL_DEF	0x4
 
 /* Register bit definitions for cache control */
 #define AXICC_ARCA_VAL  (0xF << 0)
@@ -58,6 +59,15 @@
 #define PTC_RX_WM_VAL	0x40
 #define PTC_RSVD	(1 << 27)
 
+/* Command Completion Coalescing registers of the generic host control */
+#define AHCI_CCC_CTL	0x14
+#define AHCI_CCC_PORTS	0x18
+
+#define CCC_CTL_EN	BIT(0)
+#define CCC_CTL_INT(x)	(((x) >> 3) & 0x1f)
+#define CCC_CTL_CC(x)	(((x) & 0xff) << 8)
+#define CCC_CTL_TV(x)	(((x) & 0xffff) << 16)
+
 #define PORT0_BASE	0x100
 #define PORT1_BASE	0x180
 
@@ -77,6 +87,16 @@ static unsigned int rx_watermark = PTC_RX_WM_VAL;
 module_param(rx_watermark, uint, 0644);
 MODULE_PARM_DESC(rx_watermark, "RxWaterMark value (0 - 0x80)");
 
+static unsigned int ccc_completions;
+module_param(ccc_completions, uint, 0644);
+MODULE_PARM_DESC(ccc_completions,
+		 "Completions per coalesced interrupt (0 - 255, 0 = off)");
+
+static unsigned int ccc_timeout = 1;
+module_param(ccc_timeout, uint, 0644);
+MODULE_PARM_DESC(ccc_timeout,
+		 "Coalesced interrupt timeout in ms (1 - 65535)");
+
 struct ceva_ahci_priv {
 	struct platform_device *ahci_pdev;
 	/* Port Phy2Cfg Register */
@@ -87,8 +107,14 @@ struct ceva_ahci_priv {
 	/* Axi Cache Control Register */
 	u32 axicc;
 	bool is_cci_enabled;
+	bool has_axicc;
+	/* Outstanding transfer limit of the Port AXI Config Register */
+	u32 axi_otl;
 	int flags;
 	struct reset_control *rst;
+	/* HOST_IRQ_STAT bit of the coalesced interrupt, 0 if disabled */
+	u32 ccc_irq;
+	u32 ccc_ports;
 };
 
 static unsigned int ceva_ahci_read_id(struct ata_device *dev,
@@ -144,11 +170,17 @@ static void ahci_ceva_setup(struct ahci_host_priv *hpriv)
 		 * Transfer limit to 72 DWord
 		 */
 		tmp = PAXIC_ADBW_BW64 | PAXIC_MAWIDD(i) | PAXIC_MARIDD(i) |
-			PAXIC_MAWID(i) | PAXIC_MARID(i) | PAXIC_OTL;
+			PAXIC_MAWID(i) | PAXIC_MARID(i) |
+			PAXIC_OTL(cevapriv->axi_otl);
 		writel(tmp, mmio + AHCI_VEND_PAXIC);
 
-		/* Set AXI cache control register if CCi is enabled */
-		if (cevapriv->is_cci_enabled) {
+		/*
+		 * Set AXI cache control register from device-tree, or for
+		 * cacheable accesses if CCI is enabled.
+		 */
+		if (cevapriv->has_axicc) {
+			writel(cevapriv->axicc, mmio + AHCI_VEND_AXICC);
+		} else if (cevapriv->is_cci_enabled) {
 			tmp = readl(mmio + AHCI_VEND_AXICC);
 			tmp |= AXICC_ARCA_VAL | AXICC_ARCF_VAL |
 				AXICC_ARCH_VAL | AXICC_ARCP_VAL |
@@ -185,6 +217,75 @@ static void ahci_ceva_setup(struct ahci_host_priv *hpriv)
 	}
 }
 
+/*
+ * Enable Command Completion Coalescing on all implemented ports. This has to
+ * run after the HBA reset done when the host is initialized or resumed,
+ * since the reset clears CCC_CTL.
+ */
+static void ahci_ceva_ccc_setup(struct ahci_host_priv *hpriv)
+{
+	void __iomem *mmio = hpriv->mmio;
+	struct ceva_ahci_priv *cevapriv = hpriv->plat_data;
+	unsigned int completions = READ_ONCE(ccc_completions);
+	unsigned int timeout = clamp(READ_ONCE(ccc_timeout), 1U, 0xffffU);
+	u32 ctl;
+
+	writel(0, mmio + AHCI_CCC_CTL);
+	cevapriv->ccc_irq = 0;
+
+	if (!completions || !(hpriv->cap & HOST_CAP_CCC))
+		return;
+
+	completions = min(completions, 0xffU);
+	ctl = readl(mmio + AHCI_CCC_CTL);
+	cevapriv->ccc_ports = hpriv->port_map;
+	cevapriv->ccc_irq = BIT(CCC_CTL_INT(ctl));
+
+	writel(cevapriv->ccc_ports, mmio + AHCI_CCC_PORTS);
+	ctl = CCC_CTL_TV(timeout) | CCC_CTL_CC(completions);
+	writel(ctl, mmio + AHCI_CCC_CTL);
+	writel(ctl | CCC_CTL_EN, mmio + AHCI_CCC_CTL);
+
+	dev_info(&cevapriv->ahci_pdev->dev,
+		 "command completion coalescing: %u cmds, %u ms\n",
+		 completions, timeout);
+}
+
+/*
+ * Same as the libahci single level handler, except that the coalesced
+ * interrupt is turned into events on all the ports taking part in it:
+ * those do not report their command completions in HOST_IRQ_STAT.
+ */
+static irqreturn_t ceva_ahci_irq_intr(int irq, void *dev_instance)
+{
+	struct ata_host *host = dev_instance;
+	struct ahci_host_priv *hpriv = host->private_data;
+	struct ceva_ahci_priv *cevapriv = hpriv->plat_data;
+	void __iomem *mmio = hpriv->mmio;
+	u32 irq_stat, irq_masked;
+	unsigned int rc;
+
+	irq_stat = readl(mmio + HOST_IRQ_STAT);
+	if (!irq_stat)
+		return IRQ_NONE;
+
+	irq_masked = irq_stat;
+	if (irq_stat & cevapriv->ccc_irq)
+		irq_masked |= cevapriv->ccc_ports;
+	irq_masked &= hpriv->port_map;
+
+	spin_lock(&host->lock);
+
+	rc = ahci_handle_port_intr(host, irq_masked);
+
+	/* HOST_IRQ_STAT is cleared after the port events, see libahci */
+	writel(irq_stat, mmio + HOST_IRQ_STAT);
+
+	spin_unlock(&host->lock);
+
+	return IRQ_RETVAL(rc || (irq_stat & cevapriv->ccc_irq));
+}
+
 static struct scsi_host_template ahci_platform_sht = {
 	AHCI_SHT(DRV_NAME),
 };
@@ -248,6 +349,18 @@ static int ceva_ahci_probe(struct platform_device *pdev)
 	if (of_property_read_bool(np, "ceva,broken-gen2"))
 		cevapriv->flags = CEVA_FLAG_BROKEN_GEN2;
 
+	/* Optional AXI cache control and transfer limit from device-tree */
+	if (!of_property_read_u32(np, "ceva,axi-cache-ctrl", &cevapriv->axicc))
+		cevapriv->has_axicc = true;
+
+	cevapriv->axi_otl = PAXIC_OTL_DEF;
+	of_property_read_u32(np, "ceva,axi-xfer-limit", &cevapriv->axi_otl);
+	if (cevapriv->axi_otl > 0xf) {
+		dev_warn(dev, "ceva,axi-xfer-limit out of range, using %u\n",
+			 PAXIC_OTL_DEF);
+		cevapriv->axi_otl = PAXIC_OTL_DEF;
+	}
+
 	/* Read OOB timing value for COMINIT from device-tree */
 	if (of_property_read_u8_array(np, "ceva,p0-cominit-params",
 					(u8 *)&cevapriv->pp2c[0], 4) < 0) {
@@ -308,6 +421,7 @@ static int ceva_ahci_probe(struct platform_device *pdev)
 	cevapriv->is_cci_enabled = (attr == DEV_DMA_COHERENT);
 
 	hpriv->plat_data = cevapriv;
+	hpriv->irq_handler = ceva_ahci_irq_intr;
 
 	/* CEVA specific initialization */
 	ahci_ceva_setup(hpriv);
@@ -317,6 +431,8 @@ static int ceva_ahci_probe(struct platform_device *pdev)
 	if (rc)
 		goto disable_resources;
 
+	ahci_ceva_ccc_setup(hpriv);
+
 	return 0;
 
 disable_resources:
@@ -346,6 +462,8 @@ static int __maybe_unused ceva_ahci_resume(struct device *dev)
 	if (rc)
 		goto disable_resources;
 
+	ahci_ceva_ccc_setup(hpriv);
+
 	/* We resumed so update PM runtime state */
 	pm_runtime_disable(dev);
 	pm_runtime_set_active(dev);
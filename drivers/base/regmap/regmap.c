@@ -2756,6 +2756,165 @@ int regmap_multi_reg_write_bypassed(struct regmap *map,
 }
 EXPORT_SYMBOL_GPL(regmap_multi_reg_write_bypassed);
 
+/*
+ * Whether the value of a register is known from the cache and can be
+ * written to the device again without side effects.
+ */
+static bool regmap_batch_cached(struct regmap *map, unsigned int reg,
+				unsigned int *val)
+{
+	if (map->cache_bypass || map->cache_type == REGCACHE_NONE)
+		return false;
+
+	if (!regmap_writeable(map, reg) || regmap_precious(map, reg))
+		return false;
+
+	return !regcache_read(map, reg, val);
+}
+
+/**
+ * regmap_multi_reg_write_async() - Write a register sequence in as few
+ *                                  transfers as possible
+ *
+ * @map: Register map to write to
+ * @regs: Array of structures containing register,value to be written
+ * @num_regs: Number of registers to write
+ *
+ * Write multiple registers to the device in the order they are supplied,
+ * like regmap_multi_reg_write(), for devices that only support the normal
+ * block write mode. This is intended for the long initialisation and
+ * profile sequences of converters and clock chips.
+ *
+ * Writes that would not change the cached value of a register are
+ * dropped. The remaining writes to successive registers are merged in
+ * block writes, and gaps shorter than a register address are bridged with
+ * the cached values of the registers in between. The block writes are
+ * scheduled asynchronously if the bus supports it, and a delay in the
+ * sequence first waits for the writes scheduled before it.
+ *
+ * regmap_async_complete() must be called to ensure that the writes have
+ * completed and to get their status.
+ *
+ * A value of zero will be returned on success, a negative errno will be
+ * returned in error cases.
+ */
+int regmap_multi_reg_write_async(struct regmap *map,
+				 const struct reg_sequence *regs,
+				 int num_regs)
+{
+	size_t val_bytes = map->format.val_bytes;
+	unsigned int stride = map->reg_stride;
+	unsigned int start = 0, next = 0, reg, val, gap, max_gap = 0;
+	bool raw = regmap_can_raw_write(map);
+	size_t count = 0;
+	void *buf = NULL;
+	int i, j, ret = 0;
+
+	if (num_regs < 0)
+		return -EINVAL;
+
+	for (i = 0; i < num_regs; i++)
+		if (!IS_ALIGNED(regs[i].reg, stride))
+			return -EINVAL;
+
+	if (raw) {
+		max_gap = (map->format.reg_bytes + map->format.pad_bytes) /
+			  val_bytes;
+		buf = kmalloc_array(num_regs, (max_gap + 1) * val_bytes,
+				    map->alloc_flags);
+		if (num_regs && !buf)
+			return -ENOMEM;
+	}
+
+	map->lock(map->lock_arg);
+
+	map->async = true;
+
+	for (i = 0; i < num_regs; i++) {
+		reg = regs[i].reg;
+
+		if (regmap_batch_cached(map, reg, &val) && val == regs[i].def)
+			goto delay;
+
+		if (!raw) {
+			ret = _regmap_write(map, reg, regs[i].def);
+			if (ret)
+				goto out;
+			goto delay;
+		}
+
+		/* Extend the pending block up to this register if possible */
+		gap = count && reg >= next ? (reg - next) / stride : UINT_MAX;
+		for (j = 0; gap <= max_gap && j < gap; j++)
+			if (!regmap_batch_cached(map, next + j * stride, &val))
+				gap = UINT_MAX;
+
+		if (gap > max_gap) {
+			if (count) {
+				ret = _regmap_raw_write(map, start, buf,
+							count * val_bytes,
+							false);
+				if (ret)
+					goto out;
+			}
+			start = reg;
+			count = 0;
+			gap = 0;
+		}
+
+		for (j = 0; j < gap; j++) {
+			regcache_read(map, next + j * stride, &val);
+			map->format.format_val(buf + count++ * val_bytes,
+					       val, 0);
+		}
+		map->format.format_val(buf + count++ * val_bytes,
+				       regs[i].def, 0);
+		next = reg + stride;
+
+		/* Later writes of the sequence are compared to this value */
+		if (!map->cache_bypass) {
+			ret = regcache_write(map, reg, regs[i].def);
+			if (ret)
+				goto out;
+		}
+
+delay:
+		if (!regs[i].delay_us)
+			continue;
+
+		if (count) {
+			ret = _regmap_raw_write(map, start, buf,
+						count * val_bytes, false);
+			if (ret)
+				goto out;
+			count = 0;
+		}
+
+		ret = regmap_async_complete(map);
+		if (ret)
+			goto out;
+
+		if (map->can_sleep)
+			fsleep(regs[i].delay_us);
+		else
+			udelay(regs[i].delay_us);
+	}
+
+	if (count)
+		ret = _regmap_raw_write(map, start, buf, count * val_bytes,
+					false);
+
+out:
+	map->async = false;
+
+	map->unlock(map->lock_arg);
+
+	kfree(buf);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(regmap_multi_reg_write_async);
+
 /**
  * regmap_raw_write_async() - Write raw values to one or more registers
  *                            asynchronously
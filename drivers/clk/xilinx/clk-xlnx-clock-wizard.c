@@ -67,6 +67,7 @@
 #define WZRD_O_MAX			128
 #define WZRD_MIN_ERR			20000
 #define WZRD_FRAC_POINTS		1000
+#define WZRD_DIV_CACHE_SIZE		16
 
 /* Get the mask from width */
 #define div_mask(width)			((1 << (width)) - 1)
@@ -106,6 +107,23 @@ struct clk_wzrd {
 	bool suspended;
 };
 
+/**
+ * struct clk_wzrd_divisors - divisors found for an output rate
+ *
+ * @rate:		requested output rate, 0 for an unused entry
+ * @parent_rate:	input rate the divisors were searched for
+ * @m:			value of the multiplier
+ * @d:			value of the common divider
+ * @o:			value of the leaf divider
+ */
+struct clk_wzrd_divisors {
+	unsigned long rate;
+	unsigned long parent_rate;
+	u32 m;
+	u32 d;
+	u32 o;
+};
+
 /**
  * struct clk_wzrd_divider - clock divider specific to clk_wzrd
  *
@@ -120,6 +138,9 @@ struct clk_wzrd {
  * @valued:	value of the common divider
  * @valueo:	value of the leaf divider
  * @lock:	register lock
+ * @cache:	divisors of the last rates, filled by round_rate so that the
+ *		search is not repeated under @lock by set_rate
+ * @cache_next:	next @cache entry to replace
  */
 struct clk_wzrd_divider {
 	struct clk_hw hw;
@@ -133,6 +154,8 @@ struct clk_wzrd_divider {
 	u32 valued;
 	u32 valueo;
 	spinlock_t *lock;  /* divider lock */
+	struct clk_wzrd_divisors cache[WZRD_DIV_CACHE_SIZE];
+	unsigned int cache_next;
 };
 
 #define to_clk_wzrd(_nb) container_of(_nb, struct clk_wzrd, nb)
@@ -223,8 +246,8 @@ static long clk_wzrd_round_rate(struct clk_hw *hw, unsigned long rate,
 	return *prate / div;
 }
 
-static int clk_wzrd_get_divisors(struct clk_hw *hw, unsigned long rate,
-				 unsigned long parent_rate)
+static int clk_wzrd_search_divisors(struct clk_hw *hw, unsigned long rate,
+				    unsigned long parent_rate)
 {
 	struct clk_wzrd_divider *divider = to_clk_wzrd_divider(hw);
 	unsigned long vco_freq, freq, diff;
@@ -258,6 +281,42 @@ static int clk_wzrd_get_divisors(struct clk_hw *hw, unsigned long rate,
 	return -EBUSY;
 }
 
+/*
+ * The search walks up to 1.7 million divisor combinations. The callers all
+ * hold the clk prepare lock, which also protects the cache.
+ */
+static int clk_wzrd_get_divisors(struct clk_hw *hw, unsigned long rate,
+				 unsigned long parent_rate)
+{
+	struct clk_wzrd_divider *divider = to_clk_wzrd_divider(hw);
+	struct clk_wzrd_divisors *entry;
+	int i, err;
+
+	for (i = 0; i < WZRD_DIV_CACHE_SIZE; i++) {
+		entry = &divider->cache[i];
+		if (entry->rate == rate && entry->parent_rate == parent_rate) {
+			divider->valuem = entry->m;
+			divider->valued = entry->d;
+			divider->valueo = entry->o;
+			return 0;
+		}
+	}
+
+	err = clk_wzrd_search_divisors(hw, rate, parent_rate);
+	if (err)
+		return err;
+
+	entry = &divider->cache[divider->cache_next];
+	divider->cache_next = (divider->cache_next + 1) % WZRD_DIV_CACHE_SIZE;
+	entry->rate = rate;
+	entry->parent_rate = parent_rate;
+	entry->m = divider->valuem;
+	entry->d = divider->valued;
+	entry->o = divider->valueo;
+
+	return 0;
+}
+
 static int clk_wzrd_dynamic_all_nolock(struct clk_hw *hw, unsigned long rate,
 				       unsigned long parent_rate)
 {
@@ -353,6 +412,14 @@ static unsigned long clk_wzrd_recalc_rate_all(struct clk_hw *hw,
 static long clk_wzrd_round_rate_all(struct clk_hw *hw, unsigned long rate,
 				    unsigned long *prate)
 {
+	/*
+	 * The fractional leaf divider gets close to any rate. Searching the
+	 * divisors here precomputes them for the set_rate that follows, or
+	 * for later ones when the rates of a set of operating points are
+	 * rounded up front.
+	 */
+	clk_wzrd_get_divisors(hw, rate, *prate);
+
 	return rate;
 }
 
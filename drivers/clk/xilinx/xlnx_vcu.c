@@ -274,13 +274,50 @@ u32 xvcu_get_num_cores(struct xvcu_device *xvcu)
 }
 EXPORT_SYMBOL_GPL(xvcu_get_num_cores);
 
+/**
+ * xvcu_clk_prewarm - Bring up the VCU PLL ahead of a job
+ * @xvcu:	Pointer to the xvcu_device structure
+ *
+ * Lock the PLL when a job is queued, so that enabling the encoder or
+ * decoder clocks when the job starts does not wait for the PLL to lock.
+ * Must be balanced with xvcu_clk_cooldown().
+ *
+ * Return:	Returns 0 on success
+ *		Negative error code otherwise
+ */
+int xvcu_clk_prewarm(struct xvcu_device *xvcu)
+{
+	return clk_prepare_enable(xvcu->pll_clk);
+}
+EXPORT_SYMBOL_GPL(xvcu_clk_prewarm);
+
+/**
+ * xvcu_clk_cooldown - Drop the PLL reference taken by xvcu_clk_prewarm()
+ * @xvcu:	Pointer to the xvcu_device structure
+ */
+void xvcu_clk_cooldown(struct xvcu_device *xvcu)
+{
+	clk_disable_unprepare(xvcu->pll_clk);
+}
+EXPORT_SYMBOL_GPL(xvcu_clk_cooldown);
+
 #define to_vcu_pll(_hw) container_of(_hw, struct vcu_pll, hw)
 
+/**
+ * struct vcu_pll - VCU PLL clock
+ * @hw: Handle between common and hardware-specific interfaces
+ * @reg_base: Base address of the VCU SLCR
+ * @fvco_min: Minimum VCO frequency
+ * @fvco_max: Maximum VCO frequency
+ * @cfg: Last configuration set through set_rate, restored on enable since
+ *	 the SLCR loses it when the VCU is power gated
+ */
 struct vcu_pll {
 	struct clk_hw hw;
 	void __iomem *reg_base;
 	unsigned long fvco_min;
 	unsigned long fvco_max;
+	const struct xvcu_pll_cfg *cfg;
 };
 
 static int xvcu_pll_wait_for_lock(struct vcu_pll *pll)
@@ -333,29 +370,55 @@ static const struct xvcu_pll_cfg *xvcu_find_cfg(int div)
 	return cfg;
 }
 
-static int xvcu_pll_set_div(struct vcu_pll *pll, int div)
+/**
+ * xvcu_pll_apply_cfg - Write the cached PLL configuration
+ * @pll:	Pointer to the VCU PLL
+ *
+ * The registers are only written when they differ from @pll->cfg, so an
+ * unchanged rate does not disturb a locked PLL.
+ *
+ * Return:	true if the registers were changed
+ */
+static bool xvcu_pll_apply_cfg(struct vcu_pll *pll)
 {
+	const struct xvcu_pll_cfg *cfg = pll->cfg;
 	void __iomem *base = pll->reg_base;
-	const struct xvcu_pll_cfg *cfg = NULL;
 	u32 vcu_pll_ctrl;
 	u32 cfg_val;
 
-	cfg = xvcu_find_cfg(div);
 	if (!cfg)
-		return -EINVAL;
+		return false;
 
 	vcu_pll_ctrl = xvcu_read(base, VCU_PLL_CTRL);
-	vcu_pll_ctrl &= ~VCU_PLL_CTRL_FBDIV;
-	vcu_pll_ctrl |= FIELD_PREP(VCU_PLL_CTRL_FBDIV, cfg->fbdiv);
-	xvcu_write(base, VCU_PLL_CTRL, vcu_pll_ctrl);
-
 	cfg_val = FIELD_PREP(VCU_PLL_CFG_RES, cfg->res) |
 		  FIELD_PREP(VCU_PLL_CFG_CP, cfg->cp) |
 		  FIELD_PREP(VCU_PLL_CFG_LFHF, cfg->lfhf) |
 		  FIELD_PREP(VCU_PLL_CFG_LOCK_CNT, cfg->lock_cnt) |
 		  FIELD_PREP(VCU_PLL_CFG_LOCK_DLY, cfg->lock_dly);
+
+	if (FIELD_GET(VCU_PLL_CTRL_FBDIV, vcu_pll_ctrl) == cfg->fbdiv &&
+	    xvcu_read(base, VCU_PLL_CFG) == cfg_val)
+		return false;
+
+	vcu_pll_ctrl &= ~VCU_PLL_CTRL_FBDIV;
+	vcu_pll_ctrl |= FIELD_PREP(VCU_PLL_CTRL_FBDIV, cfg->fbdiv);
+	xvcu_write(base, VCU_PLL_CTRL, vcu_pll_ctrl);
 	xvcu_write(base, VCU_PLL_CFG, cfg_val);
 
+	return true;
+}
+
+static int xvcu_pll_set_div(struct vcu_pll *pll, int div)
+{
+	const struct xvcu_pll_cfg *cfg = NULL;
+
+	cfg = xvcu_find_cfg(div);
+	if (!cfg)
+		return -EINVAL;
+
+	pll->cfg = cfg;
+	xvcu_pll_apply_cfg(pll);
+
 	return 0;
 }
 
@@ -400,9 +463,22 @@ static int xvcu_pll_enable(struct clk_hw *hw)
 	struct vcu_pll *pll = to_vcu_pll(hw);
 	void __iomem *base = pll->reg_base;
 	u32 vcu_pll_ctrl;
+	bool changed;
 	int ret;
 
+	changed = xvcu_pll_apply_cfg(pll);
+
+	/*
+	 * Nothing to do if the PLL is still running with the same settings,
+	 * e.g. when it was left locked by the boot loader.
+	 */
 	vcu_pll_ctrl = xvcu_read(base, VCU_PLL_CTRL);
+	if (!changed &&
+	    !(vcu_pll_ctrl & (VCU_PLL_CTRL_RESET | VCU_PLL_CTRL_POR_IN |
+			      VCU_PLL_CTRL_PWR_POR | VCU_PLL_CTRL_BYPASS)) &&
+	    (xvcu_read(base, VCU_PLL_STATUS) & VCU_PLL_STATUS_LOCK_STATUS))
+		return 0;
+
 	vcu_pll_ctrl |= VCU_PLL_CTRL_BYPASS;
 	xvcu_write(base, VCU_PLL_CTRL, vcu_pll_ctrl);
 
@@ -593,6 +669,10 @@ static int xvcu_register_clock_provider(struct xvcu_device *xvcu)
 		return PTR_ERR(hw);
 	xvcu->pll = hw;
 
+	xvcu->pll_clk = devm_clk_hw_get_clk(dev, hw, "prewarm");
+	if (IS_ERR(xvcu->pll_clk))
+		return PTR_ERR(xvcu->pll_clk);
+
 	hw = xvcu_register_pll_post(dev, "vcu_pll_post", xvcu->pll, reg_base);
 	if (IS_ERR(hw))
 		return PTR_ERR(hw);
@@ -16,11 +16,13 @@
  * @hw:		handle between common and hardware-specific interfaces
  * @flags:	hardware-specific flags
  * @clk_id:	Id of clock
+ * @state:	Cached gate state
  */
 struct zynqmp_clk_gate {
 	struct clk_hw hw;
 	u8 flags;
 	u32 clk_id;
+	struct zynqmp_clk_state state;
 };
 
 #define to_zynqmp_clk_gate(_hw) container_of(_hw, struct zynqmp_clk_gate, hw)
@@ -40,9 +42,13 @@ static int zynqmp_clk_gate_enable(struct clk_hw *hw)
 
 	ret = zynqmp_pm_clock_enable(clk_id);
 
-	if (ret)
+	if (ret) {
 		pr_debug("%s() clock enable failed for %s (id %d), ret = %d\n",
 			 __func__, clk_name, clk_id, ret);
+		zynqmp_clk_state_clear(&gate->state);
+	} else {
+		zynqmp_clk_state_set(&gate->state, 1);
+	}
 
 	return ret;
 }
@@ -60,9 +66,13 @@ static void zynqmp_clk_gate_disable(struct clk_hw *hw)
 
 	ret = zynqmp_pm_clock_disable(clk_id);
 
-	if (ret)
+	if (ret) {
 		pr_debug("%s() clock disable failed for %s (id %d), ret = %d\n",
 			 __func__, clk_name, clk_id, ret);
+		zynqmp_clk_state_clear(&gate->state);
+	} else {
+		zynqmp_clk_state_set(&gate->state, 0);
+	}
 }
 
 /**
@@ -76,8 +86,12 @@ static int zynqmp_clk_gate_is_enabled(struct clk_hw *hw)
 	struct zynqmp_clk_gate *gate = to_zynqmp_clk_gate(hw);
 	const char *clk_name = clk_hw_get_name(hw);
 	u32 clk_id = gate->clk_id;
+	u32 cached;
 	int state, ret;
 
+	if (zynqmp_clk_state_get(&gate->state, &cached))
+		return cached;
+
 	ret = zynqmp_pm_clock_getstate(clk_id, &state);
 	if (ret) {
 		pr_debug("%s() clock get state failed for %s, ret = %d\n",
@@ -85,6 +99,8 @@ static int zynqmp_clk_gate_is_enabled(struct clk_hw *hw)
 		return -EIO;
 	}
 
+	zynqmp_clk_state_set(&gate->state, state ? 1 : 0);
+
 	return state ? 1 : 0;
 }
 
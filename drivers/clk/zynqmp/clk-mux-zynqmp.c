@@ -25,11 +25,13 @@
  * @hw:		handle between common and hardware-specific interfaces
  * @flags:	hardware-specific flags
  * @clk_id:	Id of clock
+ * @state:	Cached parent index
  */
 struct zynqmp_clk_mux {
 	struct clk_hw hw;
 	u8 flags;
 	u32 clk_id;
+	struct zynqmp_clk_state state;
 };
 
 #define to_zynqmp_clk_mux(_hw) container_of(_hw, struct zynqmp_clk_mux, hw)
@@ -48,6 +50,9 @@ static u8 zynqmp_clk_mux_get_parent(struct clk_hw *hw)
 	u32 val;
 	int ret;
 
+	if (zynqmp_clk_state_get(&mux->state, &val))
+		return val;
+
 	ret = zynqmp_pm_clock_getparent(clk_id, &val);
 
 	if (ret) {
@@ -60,6 +65,8 @@ static u8 zynqmp_clk_mux_get_parent(struct clk_hw *hw)
 		return clk_hw_get_num_parents(hw);
 	}
 
+	zynqmp_clk_state_set(&mux->state, val);
+
 	return val;
 }
 
@@ -79,9 +86,13 @@ static int zynqmp_clk_mux_set_parent(struct clk_hw *hw, u8 index)
 
 	ret = zynqmp_pm_clock_setparent(clk_id, index);
 
-	if (ret)
+	if (ret) {
 		pr_debug("%s() set parent failed for clock: %s, ret = %d\n",
 			 __func__, clk_name, ret);
+		zynqmp_clk_state_clear(&mux->state);
+	} else {
+		zynqmp_clk_state_set(&mux->state, index);
+	}
 
 	return ret;
 }
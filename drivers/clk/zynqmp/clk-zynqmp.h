@@ -6,6 +6,7 @@
 #ifndef __LINUX_CLK_ZYNQMP_H_
 #define __LINUX_CLK_ZYNQMP_H_
 
+#include <linux/atomic.h>
 #include <linux/spinlock.h>
 
 #include <linux/firmware/xlnx-zynqmp.h>
@@ -65,6 +66,44 @@ struct clock_topology {
 	u8 custom_type_flag;
 };
 
+/**
+ * struct zynqmp_clk_state - Cached firmware state of a clock node
+ * @val:	Cached value
+ * @gen:	Value of zynqmp_clk_state_gen when @val was cached, 0 if never
+ *
+ * The read-side clock ops answer from the cache instead of querying the
+ * firmware. A set op refreshes the cache of its own node, and bumping
+ * zynqmp_clk_state_gen drops the cache of all nodes at once.
+ */
+struct zynqmp_clk_state {
+	u32 val;
+	u32 gen;
+};
+
+extern atomic_t zynqmp_clk_state_gen;
+
+static inline bool zynqmp_clk_state_get(const struct zynqmp_clk_state *state,
+					u32 *val)
+{
+	if (READ_ONCE(state->gen) != atomic_read(&zynqmp_clk_state_gen))
+		return false;
+
+	*val = READ_ONCE(state->val);
+	return true;
+}
+
+static inline void zynqmp_clk_state_set(struct zynqmp_clk_state *state,
+					u32 val)
+{
+	WRITE_ONCE(state->val, val);
+	WRITE_ONCE(state->gen, atomic_read(&zynqmp_clk_state_gen));
+}
+
+static inline void zynqmp_clk_state_clear(struct zynqmp_clk_state *state)
+{
+	WRITE_ONCE(state->gen, 0);
+}
+
 unsigned long zynqmp_clk_map_common_ccf_flags(const u32 zynqmp_flag);
 
 struct clk_hw *zynqmp_clk_register_pll(const char *name, u32 clk_id,
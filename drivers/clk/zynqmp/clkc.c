@@ -10,10 +10,17 @@
 #include <linux/bitfield.h>
 #include <linux/clk.h>
 #include <linux/clk-provider.h>
+#include <linux/crc32.h>
+#include <linux/fs.h>
+#include <linux/io.h>
 #include <linux/module.h>
 #include <linux/of_platform.h>
+#include <linux/of_reserved_mem.h>
 #include <linux/slab.h>
 #include <linux/string.h>
+#include <linux/syscore_ops.h>
+#include <linux/sysfs.h>
+#include <linux/vmalloc.h>
 
 #include "clk-zynqmp.h"
 
@@ -39,6 +46,11 @@
 #define CLK_GET_PARENTS_RESP_WORDS	3
 #define CLK_GET_ATTR_RESP_WORDS		1
 
+/* Topology cache image handed over by the bootloader, "ZCLK" */
+#define ZYNQMP_CLK_CACHE_MAGIC		0x4b4c435a
+#define ZYNQMP_CLK_CACHE_FORMAT		1
+#define ZYNQMP_CLK_FF_PARAMS		2
+
 enum clk_type {
 	CLK_TYPE_OUTPUT,
 	CLK_TYPE_EXTERNAL,
@@ -108,6 +120,71 @@ struct attr_resp {
 	u32 attr[CLK_GET_ATTR_RESP_WORDS];
 };
 
+/**
+ * struct zynqmp_clk_cache_hdr - Header of a clock topology cache image
+ * @magic:		ZYNQMP_CLK_CACHE_MAGIC
+ * @format:		Layout of the image, ZYNQMP_CLK_CACHE_FORMAT
+ * @api_version:	EEMI API version of the firmware the image was read from
+ * @idcode:		IDCODE of the silicon the image was read from
+ * @chip_version:	Silicon version the image was read from
+ * @num_clocks:		Number of clock records following the header
+ * @size:		Size in bytes of the clock records
+ * @crc:		crc32_le() of the clock records
+ *
+ * All fields of the image are little endian.
+ */
+struct zynqmp_clk_cache_hdr {
+	__le32 magic;
+	__le32 format;
+	__le32 api_version;
+	__le32 idcode;
+	__le32 chip_version;
+	__le32 num_clocks;
+	__le32 size;
+	__le32 crc;
+};
+
+/**
+ * struct zynqmp_clk_cache_rec - Clock record of a topology cache image
+ * @attr:		Attributes word of the clock
+ * @name:		Name of the clock
+ * @topology:		Topology words of the clock, zero terminated
+ * @ff_params:		Fixed factor multiplier and divider
+ * @num_parents:	Number of words in @parents
+ * @parents:		Parent words of the clock, without the NA_PARENT
+ *			terminator
+ */
+struct zynqmp_clk_cache_rec {
+	__le32 attr;
+	char name[CLK_GET_NAME_RESP_LEN];
+	__le32 topology[MAX_NODES];
+	__le32 ff_params[ZYNQMP_CLK_FF_PARAMS];
+	__le32 num_parents;
+	__le32 parents[];
+};
+
+/**
+ * struct zynqmp_clk_cache_entry - Firmware responses of a clock
+ * @attr:		Attributes word of the clock
+ * @name:		Name of the clock
+ * @topology:		Topology words of the clock, zero terminated
+ * @ff_params:		Fixed factor multiplier and divider
+ * @num_parents:	Number of valid words in @parents
+ * @parents:		Parent words of the clock
+ *
+ * Filled either from a cache image, in which case the firmware queries are
+ * answered from here, or from the firmware responses, in which case a new
+ * image is built out of it once the clocks are registered.
+ */
+struct zynqmp_clk_cache_entry {
+	u32 attr;
+	struct name_resp name;
+	u32 topology[MAX_NODES];
+	u32 ff_params[ZYNQMP_CLK_FF_PARAMS];
+	u32 num_parents;
+	u32 parents[MAX_PARENT];
+};
+
 static const char clk_type_postfix[][10] = {
 	[TYPE_INVALID] = "",
 	[TYPE_MUX] = "_mux",
@@ -136,6 +213,44 @@ static struct zynqmp_clock *clock;
 static struct clk_hw_onecell_data *zynqmp_data;
 static unsigned int clock_max_idx;
 
+/* Generation of the cached clock state, 0 is never current */
+atomic_t zynqmp_clk_state_gen = ATOMIC_INIT(1);
+
+static struct zynqmp_clk_cache_entry *clk_cache;
+static bool clk_cache_replay;
+static void *clk_cache_image;
+
+/**
+ * zynqmp_clk_cache_entry() - Get the cache entry of a clock
+ * @clock_id:	Clock ID or clock index
+ *
+ * Return: the entry, or NULL when the topology cache is not in use
+ */
+static struct zynqmp_clk_cache_entry *zynqmp_clk_cache_entry(u32 clock_id)
+{
+	u32 idx = FIELD_GET(CLK_ATTR_NODE_INDEX, clock_id);
+
+	if (!clk_cache || idx >= clock_max_idx)
+		return NULL;
+
+	return &clk_cache[idx];
+}
+
+/**
+ * zynqmp_clk_cache_drop() - Stop recording firmware responses
+ *
+ * Called when a query fails while recording, so that only complete images
+ * are ever handed out.
+ */
+static void zynqmp_clk_cache_drop(void)
+{
+	if (clk_cache_replay)
+		return;
+
+	kvfree(clk_cache);
+	clk_cache = NULL;
+}
+
 /**
  * zynqmp_is_valid_clock() - Check whether clock is valid or not
  * @clk_id:	Clock index
@@ -225,18 +340,28 @@ static int zynqmp_pm_clock_get_num_clocks(u32 *nclocks)
 static int zynqmp_pm_clock_get_name(u32 clock_id,
 				    struct name_resp *response)
 {
+	struct zynqmp_clk_cache_entry *entry = zynqmp_clk_cache_entry(clock_id);
 	struct zynqmp_pm_query_data qdata = {0};
 	u32 ret_payload[PAYLOAD_ARG_CNT];
 	int ret;
 
+	if (entry && clk_cache_replay) {
+		memcpy(response, &entry->name, sizeof(*response));
+		return 0;
+	}
+
 	qdata.qid = PM_QID_CLOCK_GET_NAME;
 	qdata.arg1 = clock_id;
 
 	ret = zynqmp_pm_query_data(qdata, ret_payload);
-	if (ret)
+	if (ret) {
+		zynqmp_clk_cache_drop();
 		return ret;
+	}
 
 	memcpy(response, ret_payload, sizeof(*response));
+	if (entry)
+		memcpy(&entry->name, response, sizeof(*response));
 
 	return 0;
 }
@@ -261,9 +386,17 @@ static int zynqmp_pm_clock_get_name(u32 clock_id,
 static int zynqmp_pm_clock_get_topology(u32 clock_id, u32 index,
 					struct topology_resp *response)
 {
+	struct zynqmp_clk_cache_entry *entry = zynqmp_clk_cache_entry(clock_id);
 	struct zynqmp_pm_query_data qdata = {0};
 	u32 ret_payload[PAYLOAD_ARG_CNT];
-	int ret;
+	int ret, i;
+
+	if (entry && clk_cache_replay) {
+		for (i = 0; i < ARRAY_SIZE(response->topology); i++)
+			response->topology[i] = index + i < MAX_NODES ?
+						entry->topology[index + i] : 0;
+		return 0;
+	}
 
 	qdata.qid = PM_QID_CLOCK_GET_TOPOLOGY;
 	qdata.arg1 = clock_id;
@@ -272,6 +405,16 @@ static int zynqmp_pm_clock_get_topology(u32 clock_id, u32 index,
 	ret = zynqmp_pm_query_data(qdata, ret_payload);
 	memcpy(response, &ret_payload[1], sizeof(*response));
 
+	if (ret) {
+		zynqmp_clk_cache_drop();
+		return ret;
+	}
+
+	for (i = 0; entry && i < ARRAY_SIZE(response->topology); i++) {
+		if (index + i < MAX_NODES)
+			entry->topology[index + i] = response->topology[i];
+	}
+
 	return ret;
 }
 
@@ -295,6 +438,48 @@ unsigned long zynqmp_clk_map_common_ccf_flags(const u32 zynqmp_flag)
 	return ccf_flag;
 }
 
+/**
+ * zynqmp_pm_clock_get_fixedfactor_params() - Get the fixed factor parameters
+ *					      of clock for given id
+ * @clock_id:	Clock ID
+ * @mult:	Multiplier of the fixed factor
+ * @div:	Divider of the fixed factor
+ *
+ * Return: 0 on success else error+reason
+ */
+static int zynqmp_pm_clock_get_fixedfactor_params(u32 clock_id, u32 *mult,
+						  u32 *div)
+{
+	struct zynqmp_clk_cache_entry *entry = zynqmp_clk_cache_entry(clock_id);
+	struct zynqmp_pm_query_data qdata = {0};
+	u32 ret_payload[PAYLOAD_ARG_CNT];
+	int ret;
+
+	if (entry && clk_cache_replay) {
+		*mult = entry->ff_params[0];
+		*div = entry->ff_params[1];
+		return 0;
+	}
+
+	qdata.qid = PM_QID_CLOCK_GET_FIXEDFACTOR_PARAMS;
+	qdata.arg1 = clock_id;
+
+	ret = zynqmp_pm_query_data(qdata, ret_payload);
+	if (ret) {
+		zynqmp_clk_cache_drop();
+		return ret;
+	}
+
+	*mult = ret_payload[1];
+	*div = ret_payload[2];
+	if (entry) {
+		entry->ff_params[0] = *mult;
+		entry->ff_params[1] = *div;
+	}
+
+	return 0;
+}
+
 /**
  * zynqmp_clk_register_fixed_factor() - Register fixed factor with the
  *					clock framework
@@ -313,21 +498,13 @@ struct clk_hw *zynqmp_clk_register_fixed_factor(const char *name, u32 clk_id,
 {
 	u32 mult, div;
 	struct clk_hw *hw;
-	struct zynqmp_pm_query_data qdata = {0};
-	u32 ret_payload[PAYLOAD_ARG_CNT];
 	int ret;
 	unsigned long flag;
 
-	qdata.qid = PM_QID_CLOCK_GET_FIXEDFACTOR_PARAMS;
-	qdata.arg1 = clk_id;
-
-	ret = zynqmp_pm_query_data(qdata, ret_payload);
+	ret = zynqmp_pm_clock_get_fixedfactor_params(clk_id, &mult, &div);
 	if (ret)
 		return ERR_PTR(ret);
 
-	mult = ret_payload[1];
-	div = ret_payload[2];
-
 	flag = zynqmp_clk_map_common_ccf_flags(nodes->flag);
 
 	hw = clk_hw_register_fixed_factor(NULL, name,
@@ -358,9 +535,18 @@ struct clk_hw *zynqmp_clk_register_fixed_factor(const char *name, u32 clk_id,
 static int zynqmp_pm_clock_get_parents(u32 clock_id, u32 index,
 				       struct parents_resp *response)
 {
+	struct zynqmp_clk_cache_entry *entry = zynqmp_clk_cache_entry(clock_id);
 	struct zynqmp_pm_query_data qdata = {0};
 	u32 ret_payload[PAYLOAD_ARG_CNT];
-	int ret;
+	int ret, i;
+
+	if (entry && clk_cache_replay) {
+		for (i = 0; i < ARRAY_SIZE(response->parents); i++)
+			response->parents[i] = index + i < entry->num_parents ?
+					       entry->parents[index + i] :
+					       NA_PARENT;
+		return 0;
+	}
 
 	qdata.qid = PM_QID_CLOCK_GET_PARENTS;
 	qdata.arg1 = clock_id;
@@ -369,6 +555,22 @@ static int zynqmp_pm_clock_get_parents(u32 clock_id, u32 index,
 	ret = zynqmp_pm_query_data(qdata, ret_payload);
 	memcpy(response, &ret_payload[1], sizeof(*response));
 
+	if (ret) {
+		zynqmp_clk_cache_drop();
+		return ret;
+	}
+
+	for (i = 0; entry && i < ARRAY_SIZE(response->parents); i++) {
+		if (response->parents[i] == NA_PARENT)
+			break;
+		if (index + i >= MAX_PARENT) {
+			zynqmp_clk_cache_drop();
+			break;
+		}
+		entry->parents[index + i] = response->parents[i];
+		entry->num_parents = index + i + 1;
+	}
+
 	return ret;
 }
 
@@ -384,16 +586,27 @@ static int zynqmp_pm_clock_get_parents(u32 clock_id, u32 index,
 static int zynqmp_pm_clock_get_attributes(u32 clock_id,
 					  struct attr_resp *response)
 {
+	struct zynqmp_clk_cache_entry *entry = zynqmp_clk_cache_entry(clock_id);
 	struct zynqmp_pm_query_data qdata = {0};
 	u32 ret_payload[PAYLOAD_ARG_CNT];
 	int ret;
 
+	if (entry && clk_cache_replay) {
+		response->attr[0] = entry->attr;
+		return 0;
+	}
+
 	qdata.qid = PM_QID_CLOCK_GET_ATTRIBUTES;
 	qdata.arg1 = clock_id;
 
 	ret = zynqmp_pm_query_data(qdata, ret_payload);
 	memcpy(response, &ret_payload[1], sizeof(*response));
 
+	if (ret)
+		zynqmp_clk_cache_drop();
+	else if (entry)
+		entry->attr = response->attr[0];
+
 	return ret;
 }
 
@@ -744,14 +957,231 @@ static void zynqmp_get_clock_info(void)
 	}
 }
 
+/**
+ * zynqmp_clk_cache_parse() - Load the clock entries from a cache image
+ * @image:	Cache image
+ * @size:	Size of the memory holding @image
+ *
+ * The image is only accepted when it was read on the same silicon, from a
+ * firmware implementing the same API version and describing as many clocks
+ * as the running firmware does.
+ *
+ * Return: 0 on success else error code
+ */
+static int zynqmp_clk_cache_parse(const void *image, size_t size)
+{
+	const struct zynqmp_clk_cache_hdr *hdr = image;
+	const struct zynqmp_clk_cache_rec *rec;
+	struct zynqmp_clk_cache_entry *entry;
+	u32 api_version, idcode, chip_version, len, n;
+	const u8 *p;
+	int ret, i, j;
+
+	if (size < sizeof(*hdr) ||
+	    le32_to_cpu(hdr->magic) != ZYNQMP_CLK_CACHE_MAGIC ||
+	    le32_to_cpu(hdr->format) != ZYNQMP_CLK_CACHE_FORMAT)
+		return -EINVAL;
+
+	len = le32_to_cpu(hdr->size);
+	if (len > size - sizeof(*hdr))
+		return -EINVAL;
+
+	ret = zynqmp_pm_get_api_version(&api_version);
+	if (ret)
+		return ret;
+
+	ret = zynqmp_pm_get_chipid(&idcode, &chip_version);
+	if (ret)
+		return ret;
+
+	if (le32_to_cpu(hdr->api_version) != api_version ||
+	    le32_to_cpu(hdr->idcode) != idcode ||
+	    le32_to_cpu(hdr->chip_version) != chip_version ||
+	    le32_to_cpu(hdr->num_clocks) != clock_max_idx)
+		return -ESTALE;
+
+	p = (const u8 *)(hdr + 1);
+	if (crc32_le(~0, p, len) != le32_to_cpu(hdr->crc))
+		return -EBADMSG;
+
+	for (i = 0; i < clock_max_idx; i++) {
+		rec = (const struct zynqmp_clk_cache_rec *)p;
+		entry = &clk_cache[i];
+
+		if (len < sizeof(*rec))
+			return -EINVAL;
+		n = le32_to_cpu(rec->num_parents);
+		if (n > MAX_PARENT ||
+		    len - sizeof(*rec) < n * sizeof(rec->parents[0]))
+			return -EINVAL;
+
+		entry->attr = le32_to_cpu(rec->attr);
+		memcpy(entry->name.name, rec->name, sizeof(entry->name.name));
+		for (j = 0; j < MAX_NODES; j++)
+			entry->topology[j] = le32_to_cpu(rec->topology[j]);
+		for (j = 0; j < ZYNQMP_CLK_FF_PARAMS; j++)
+			entry->ff_params[j] = le32_to_cpu(rec->ff_params[j]);
+		entry->num_parents = n;
+		for (j = 0; j < n; j++)
+			entry->parents[j] = le32_to_cpu(rec->parents[j]);
+
+		p += struct_size(rec, parents, n);
+		len -= struct_size(rec, parents, n);
+	}
+
+	return 0;
+}
+
+/**
+ * zynqmp_clk_cache_init() - Set up the clock topology cache
+ * @dev:	Device of the clock controller
+ *
+ * The cache is only used when the clock controller node has a memory-region
+ * the bootloader can place an image into. A valid image replaces all the
+ * per-clock firmware queries. Otherwise the firmware responses are recorded
+ * and offered back through the topology_cache attribute, for the bootloader
+ * to load on the next boot.
+ */
+static void zynqmp_clk_cache_init(struct device *dev)
+{
+	struct reserved_mem *rmem;
+	struct device_node *np;
+	void *image;
+	int ret;
+
+	np = of_parse_phandle(dev->of_node, "memory-region", 0);
+	if (!np)
+		return;
+
+	rmem = of_reserved_mem_lookup(np);
+	of_node_put(np);
+	if (!rmem)
+		return;
+
+	clk_cache = kvcalloc(clock_max_idx, sizeof(*clk_cache), GFP_KERNEL);
+	if (!clk_cache)
+		return;
+
+	image = memremap(rmem->base, rmem->size, MEMREMAP_WB);
+	if (!image)
+		return;
+
+	ret = zynqmp_clk_cache_parse(image, rmem->size);
+	memunmap(image);
+	if (ret) {
+		dev_info(dev, "clock topology cache not used: %d\n", ret);
+		memset(clk_cache, 0, clock_max_idx * sizeof(*clk_cache));
+		return;
+	}
+
+	clk_cache_replay = true;
+	dev_dbg(dev, "clock topology restored from cache\n");
+}
+
+static ssize_t topology_cache_read(struct file *filp, struct kobject *kobj,
+				   struct bin_attribute *attr, char *buf,
+				   loff_t off, size_t count)
+{
+	return memory_read_from_buffer(buf, count, &off, clk_cache_image,
+				       attr->size);
+}
+static BIN_ATTR_ADMIN_RO(topology_cache, 0);
+
+/**
+ * zynqmp_clk_cache_export() - Build a cache image from the recorded entries
+ * @dev:	Device of the clock controller
+ *
+ * Return: 0 on success else error code
+ */
+static int zynqmp_clk_cache_export(struct device *dev)
+{
+	struct zynqmp_clk_cache_hdr *hdr;
+	struct zynqmp_clk_cache_rec *rec;
+	struct zynqmp_clk_cache_entry *entry;
+	u32 api_version, idcode, chip_version;
+	size_t len = 0;
+	u8 *p;
+	int ret, i, j;
+
+	ret = zynqmp_pm_get_api_version(&api_version);
+	if (ret)
+		return ret;
+
+	ret = zynqmp_pm_get_chipid(&idcode, &chip_version);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < clock_max_idx; i++)
+		len += struct_size(rec, parents, clk_cache[i].num_parents);
+
+	hdr = vzalloc(sizeof(*hdr) + len);
+	if (!hdr)
+		return -ENOMEM;
+
+	p = (u8 *)(hdr + 1);
+	for (i = 0; i < clock_max_idx; i++) {
+		rec = (struct zynqmp_clk_cache_rec *)p;
+		entry = &clk_cache[i];
+
+		rec->attr = cpu_to_le32(entry->attr);
+		memcpy(rec->name, entry->name.name, sizeof(rec->name));
+		for (j = 0; j < MAX_NODES; j++)
+			rec->topology[j] = cpu_to_le32(entry->topology[j]);
+		for (j = 0; j < ZYNQMP_CLK_FF_PARAMS; j++)
+			rec->ff_params[j] = cpu_to_le32(entry->ff_params[j]);
+		rec->num_parents = cpu_to_le32(entry->num_parents);
+		for (j = 0; j < entry->num_parents; j++)
+			rec->parents[j] = cpu_to_le32(entry->parents[j]);
+
+		p += struct_size(rec, parents, entry->num_parents);
+	}
+
+	hdr->magic = cpu_to_le32(ZYNQMP_CLK_CACHE_MAGIC);
+	hdr->format = cpu_to_le32(ZYNQMP_CLK_CACHE_FORMAT);
+	hdr->api_version = cpu_to_le32(api_version);
+	hdr->idcode = cpu_to_le32(idcode);
+	hdr->chip_version = cpu_to_le32(chip_version);
+	hdr->num_clocks = cpu_to_le32(clock_max_idx);
+	hdr->size = cpu_to_le32(len);
+	hdr->crc = cpu_to_le32(crc32_le(~0, (u8 *)(hdr + 1), len));
+
+	clk_cache_image = hdr;
+	bin_attr_topology_cache.size = sizeof(*hdr) + len;
+	ret = sysfs_create_bin_file(&dev->kobj, &bin_attr_topology_cache);
+	if (ret) {
+		clk_cache_image = NULL;
+		vfree(hdr);
+	}
+
+	return ret;
+}
+
+/**
+ * zynqmp_clk_cache_fini() - Release the clock topology cache
+ * @dev:	Device of the clock controller
+ */
+static void zynqmp_clk_cache_fini(struct device *dev)
+{
+	if (!clk_cache)
+		return;
+
+	if (!clk_cache_replay && zynqmp_clk_cache_export(dev))
+		dev_warn(dev, "failed to export clock topology cache\n");
+
+	kvfree(clk_cache);
+	clk_cache = NULL;
+	clk_cache_replay = false;
+}
+
 /**
  * zynqmp_clk_setup() - Setup the clock framework and register clocks
- * @np:		Device node
+ * @dev:	Device of the clock controller
  *
  * Return: 0 on success else error code
  */
-static int zynqmp_clk_setup(struct device_node *np)
+static int zynqmp_clk_setup(struct device *dev)
 {
+	struct device_node *np = dev->of_node;
 	int ret;
 
 	ret = zynqmp_pm_clock_get_num_clocks(&clock_max_idx);
@@ -769,19 +1199,39 @@ static int zynqmp_clk_setup(struct device_node *np)
 		return -ENOMEM;
 	}
 
+	zynqmp_clk_cache_init(dev);
 	zynqmp_get_clock_info();
 	zynqmp_register_clocks(np);
+	zynqmp_clk_cache_fini(dev);
 
 	zynqmp_data->num = clock_max_idx;
 	return of_clk_add_hw_provider(np, of_clk_hw_onecell_get, zynqmp_data);
 }
 
+/**
+ * zynqmp_clk_state_resume() - Drop the cached state of all clocks
+ *
+ * The firmware may power down and restore the clock controller across a
+ * system suspend, and it does not notify the clock changes it makes on its
+ * own. This drops the cached divider, gate and mux values and the PLL
+ * modes. Run before any device resumes and touches its clocks again.
+ */
+static void zynqmp_clk_state_resume(void)
+{
+	if (atomic_inc_return(&zynqmp_clk_state_gen) == 0)
+		atomic_inc(&zynqmp_clk_state_gen);
+}
+
+static struct syscore_ops zynqmp_clk_syscore_ops = {
+	.resume = zynqmp_clk_state_resume,
+};
+
 static int zynqmp_clock_probe(struct platform_device *pdev)
 {
 	int ret;
 	struct device *dev = &pdev->dev;
 
-	ret = zynqmp_clk_setup(dev->of_node);
+	ret = zynqmp_clk_setup(dev);
 
 	return ret;
 }
@@ -801,4 +1251,25 @@ static struct platform_driver zynqmp_clock_driver = {
 	},
 	.probe = zynqmp_clock_probe,
 };
-module_platform_driver(zynqmp_clock_driver);
+
+static int __init zynqmp_clock_init(void)
+{
+	int ret;
+
+	ret = platform_driver_register(&zynqmp_clock_driver);
+	if (ret)
+		return ret;
+
+	/* Once for all binds, the hook only bumps the cache generation */
+	register_syscore_ops(&zynqmp_clk_syscore_ops);
+
+	return 0;
+}
+module_init(zynqmp_clock_init);
+
+static void __exit zynqmp_clock_exit(void)
+{
+	unregister_syscore_ops(&zynqmp_clk_syscore_ops);
+	platform_driver_unregister(&zynqmp_clock_driver);
+}
+module_exit(zynqmp_clock_exit);
@@ -36,6 +36,7 @@
  * @clk_id:	Id of clock
  * @div_type:	divisor type (TYPE_DIV1 or TYPE_DIV2)
  * @max_div:	maximum supported divisor (fetched from firmware)
+ * @state:	Cached divisor
  */
 struct zynqmp_clk_divider {
 	struct clk_hw hw;
@@ -44,6 +45,7 @@ struct zynqmp_clk_divider {
 	u32 clk_id;
 	u32 div_type;
 	u16 max_div;
+	struct zynqmp_clk_state state;
 };
 
 static inline int zynqmp_divider_get_val(unsigned long parent_rate,
@@ -69,6 +71,39 @@ static inline int zynqmp_divider_get_val(unsigned long parent_rate,
 	}
 }
 
+/**
+ * zynqmp_clk_divider_get() - Get the current divisor of divider clock
+ * @divider:	Divider clock
+ * @value:	Divisor, decoded from the power of two encoding if needed
+ *
+ * Return: 0 on success else error+reason
+ */
+static int zynqmp_clk_divider_get(struct zynqmp_clk_divider *divider,
+				  u32 *value)
+{
+	u32 div;
+	int ret;
+
+	if (zynqmp_clk_state_get(&divider->state, value))
+		return 0;
+
+	ret = zynqmp_pm_clock_getdivider(divider->clk_id, &div);
+	if (ret)
+		return ret;
+
+	if (divider->div_type == TYPE_DIV1)
+		*value = div & 0xFFFF;
+	else
+		*value = div >> 16;
+
+	if (divider->flags & CLK_DIVIDER_POWER_OF_TWO)
+		*value = 1 << *value;
+
+	zynqmp_clk_state_set(&divider->state, *value);
+
+	return 0;
+}
+
 /**
  * zynqmp_clk_divider_recalc_rate() - Recalc rate of divider clock
  * @hw:			handle between common and hardware-specific interfaces
@@ -81,24 +116,15 @@ static unsigned long zynqmp_clk_divider_recalc_rate(struct clk_hw *hw,
 {
 	struct zynqmp_clk_divider *divider = to_zynqmp_clk_divider(hw);
 	const char *clk_name = clk_hw_get_name(hw);
-	u32 clk_id = divider->clk_id;
-	u32 div_type = divider->div_type;
-	u32 div, value;
+	u32 value;
 	int ret;
 
-	ret = zynqmp_pm_clock_getdivider(clk_id, &div);
-
-	if (ret)
+	ret = zynqmp_clk_divider_get(divider, &value);
+	if (ret) {
 		pr_debug("%s() get divider failed for %s, ret = %d\n",
 			 __func__, clk_name, ret);
-
-	if (div_type == TYPE_DIV1)
-		value = div & 0xFFFF;
-	else
-		value = div >> 16;
-
-	if (divider->flags & CLK_DIVIDER_POWER_OF_TWO)
-		value = 1 << value;
+		return parent_rate;
+	}
 
 	if (!value) {
 		WARN(!(divider->flags & CLK_DIVIDER_ALLOW_ZERO),
@@ -170,27 +196,21 @@ static long zynqmp_clk_divider_round_rate(struct clk_hw *hw,
 {
 	struct zynqmp_clk_divider *divider = to_zynqmp_clk_divider(hw);
 	const char *clk_name = clk_hw_get_name(hw);
-	u32 clk_id = divider->clk_id;
 	u32 div_type = divider->div_type;
 	u32 bestdiv;
 	int ret;
 
 	/* if read only, just return current value */
 	if (divider->flags & CLK_DIVIDER_READ_ONLY) {
-		ret = zynqmp_pm_clock_getdivider(clk_id, &bestdiv);
+		ret = zynqmp_clk_divider_get(divider, &bestdiv);
 
-		if (ret)
+		if (ret) {
 			pr_debug("%s() get divider failed for %s, ret = %d\n",
 				 __func__, clk_name, ret);
-		if (div_type == TYPE_DIV1)
-			bestdiv = bestdiv & 0xFFFF;
-		else
-			bestdiv  = bestdiv >> 16;
-
-		if (divider->flags & CLK_DIVIDER_POWER_OF_TWO)
-			bestdiv = 1 << bestdiv;
+			return *prate;
+		}
 
-		return DIV_ROUND_UP_ULL((u64)*prate, bestdiv);
+		return DIV_ROUND_UP_ULL((u64)*prate, bestdiv ?: 1);
 	}
 
 	bestdiv = zynqmp_divider_get_val(*prate, rate, divider->flags);
@@ -250,6 +270,12 @@ static int zynqmp_clk_divider_set_rate(struct clk_hw *hw, unsigned long rate,
 		pr_debug("%s() set divider failed for %s, ret = %d\n",
 			 __func__, clk_name, ret);
 
+	/* Power-of-two divisors are encoded; read those back */
+	if (ret || (divider->flags & CLK_DIVIDER_POWER_OF_TWO))
+		zynqmp_clk_state_clear(&divider->state);
+	else
+		zynqmp_clk_state_set(&divider->state, value & 0xFFFF);
+
 	return ret;
 }
 
@@ -15,11 +15,18 @@
  * @hw:		Handle between common and hardware-specific interfaces
  * @clk_id:	PLL clock ID
  * @set_pll_mode:	Whether an IOCTL_SET_PLL_FRAC_MODE request be sent to ATF
+ * @mode:	Mode last read from or written to the firmware
+ * @set_rate:	Rate programmed by the last set_rate
+ * @set_valid:	@set_rate has not been consumed by recalc_rate yet, only
+ *		trusted while @mode is cached
  */
 struct zynqmp_pll {
 	struct clk_hw hw;
 	u32 clk_id;
 	bool set_pll_mode;
+	struct zynqmp_clk_state mode;
+	unsigned long set_rate;
+	bool set_valid;
 };
 
 #define to_zynqmp_pll(_hw)	container_of(_hw, struct zynqmp_pll, hw)
@@ -61,6 +68,8 @@ static inline enum pll_mode zynqmp_pll_get_mode(struct clk_hw *hw)
 		return PLL_MODE_ERROR;
 	}
 
+	zynqmp_clk_state_set(&clk->mode, ret_payload[1]);
+
 	return ret_payload[1];
 }
 
@@ -75,19 +84,25 @@ static inline void zynqmp_pll_set_mode(struct clk_hw *hw, bool on)
 	u32 clk_id = clk->clk_id;
 	const char *clk_name = clk_hw_get_name(hw);
 	int ret;
-	u32 mode;
+	u32 mode, cached;
 
 	if (on)
 		mode = PLL_MODE_FRAC;
 	else
 		mode = PLL_MODE_INT;
 
+	/* Only the driver changes the mode, until the next system resume */
+	if (zynqmp_clk_state_get(&clk->mode, &cached) && cached == mode)
+		return;
+
 	ret = zynqmp_pm_set_pll_frac_mode(clk_id, mode);
-	if (ret)
+	if (ret) {
 		pr_debug("%s() PLL set frac mode failed for %s, ret = %d\n",
 			 __func__, clk_name, ret);
-	else
+	} else {
 		clk->set_pll_mode = true;
+		zynqmp_clk_state_set(&clk->mode, mode);
+	}
 }
 
 /**
@@ -141,6 +156,17 @@ static unsigned long zynqmp_pll_recalc_rate(struct clk_hw *hw,
 	u32 ret_payload[PAYLOAD_ARG_CNT];
 	int ret;
 	enum pll_mode mode;
+	u32 cached;
+
+	/*
+	 * The framework recalculates the rate right after set_rate; reuse
+	 * the rate just programmed instead of three firmware reads.
+	 */
+	if (clk->set_valid) {
+		clk->set_valid = false;
+		if (zynqmp_clk_state_get(&clk->mode, &cached))
+			return clk->set_rate;
+	}
 
 	ret = zynqmp_pm_clock_getdivider(clk_id, &fbdiv);
 	if (ret) {
@@ -182,11 +208,13 @@ static int zynqmp_pll_set_rate(struct clk_hw *hw, unsigned long rate,
 	const char *clk_name = clk_hw_get_name(hw);
 	u32 fbdiv;
 	long rate_div, frac, m, f;
+	u32 mode;
 	int ret;
 
 	rate_div = (rate * FRAC_DIV) / parent_rate;
 	f = rate_div % FRAC_DIV;
 	zynqmp_pll_set_mode(hw, !!f);
+	clk->set_valid = false;
 
 	if (f) {
 		m = rate_div / FRAC_DIV;
@@ -201,7 +229,12 @@ static int zynqmp_pll_set_rate(struct clk_hw *hw, unsigned long rate,
 		else if (ret)
 			pr_debug("%s() set divider failed for %s, ret = %d\n",
 				 __func__, clk_name, ret);
-		zynqmp_pm_set_pll_frac_data(clk_id, f);
+		ret = zynqmp_pm_set_pll_frac_data(clk_id, f) ?: ret;
+
+		clk->set_rate = rate + frac;
+		clk->set_valid = !ret &&
+				 zynqmp_clk_state_get(&clk->mode, &mode) &&
+				 mode == PLL_MODE_FRAC;
 
 		return rate + frac;
 	}
@@ -213,6 +246,10 @@ static int zynqmp_pll_set_rate(struct clk_hw *hw, unsigned long rate,
 		pr_debug("%s() set divider failed for %s, ret = %d\n",
 			 __func__, clk_name, ret);
 
+	clk->set_rate = parent_rate * fbdiv;
+	clk->set_valid = !ret && zynqmp_clk_state_get(&clk->mode, &mode) &&
+			 mode == PLL_MODE_INT;
+
 	return parent_rate * fbdiv;
 }
 
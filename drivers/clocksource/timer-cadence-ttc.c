@@ -58,6 +58,15 @@
 #define CLK_CNTRL_PRESCALE_EN	1
 #define CNT_CNTRL_RESET		(1 << 4)
 
+/*
+ * A 32-bit counter does not need the large pre-scaler to get a usable wrap
+ * period, so run it 16 times slower than the input clock only. That keeps
+ * three steps of head room in the pre-scaler for the rate change notifier,
+ * which compensates a lower input clock by pre-scaling less.
+ */
+#define PRESCALE_EXPONENT_32	4
+#define CLK_CNTRL_PRESCALE_32	((PRESCALE_EXPONENT_32 - 1) << 1)
+
 #define MAX_F_ERR 50
 
 /**
@@ -65,12 +74,16 @@
  *
  * @base_addr:	Base address of timer
  * @freq:	Timer input clock frequency
+ * @prescale:	Pre-scaler divider of the input clock
+ * @cnt_ctrl:	Shadow of the counter control register
  * @clk:	Associated clock source
  * @clk_rate_change_nb	Notifier block for clock rate changes
  */
 struct ttc_timer {
 	void __iomem *base_addr;
 	unsigned long freq;
+	unsigned int prescale;
+	u32 cnt_ctrl;
 	struct clk *clk;
 	struct notifier_block clk_rate_change_nb;
 };
@@ -107,10 +120,13 @@ static void __iomem *ttc_sched_clock_val_reg;
 static void ttc_set_interval(struct ttc_timer *timer,
 					unsigned long cycles)
 {
-	u32 ctrl_reg;
+	/*
+	 * The counter control register is only written by this driver, so
+	 * use the shadow copy rather than reading it back on every event.
+	 */
+	u32 ctrl_reg = timer->cnt_ctrl;
 
 	/* Disable the counter, set the counter value  and re-enable counter */
-	ctrl_reg = readl_relaxed(timer->base_addr + TTC_CNT_CNTRL_OFFSET);
 	ctrl_reg |= TTC_CNT_CNTRL_DISABLE_MASK;
 	writel_relaxed(ctrl_reg, timer->base_addr + TTC_CNT_CNTRL_OFFSET);
 
@@ -120,9 +136,10 @@ static void ttc_set_interval(struct ttc_timer *timer,
 	 * Reset the counter (0x10) so that it starts from 0, one-shot
 	 * mode makes this needed for timing to be right.
 	 */
-	ctrl_reg |= CNT_CNTRL_RESET;
 	ctrl_reg &= ~TTC_CNT_CNTRL_DISABLE_MASK;
-	writel_relaxed(ctrl_reg, timer->base_addr + TTC_CNT_CNTRL_OFFSET);
+	timer->cnt_ctrl = ctrl_reg;
+	writel_relaxed(ctrl_reg | CNT_CNTRL_RESET,
+		       timer->base_addr + TTC_CNT_CNTRL_OFFSET);
 }
 
 /**
@@ -191,11 +208,10 @@ static int ttc_shutdown(struct clock_event_device *evt)
 {
 	struct ttc_timer_clockevent *ttce = to_ttc_timer_clkevent(evt);
 	struct ttc_timer *timer = &ttce->ttc;
-	u32 ctrl_reg;
 
-	ctrl_reg = readl_relaxed(timer->base_addr + TTC_CNT_CNTRL_OFFSET);
-	ctrl_reg |= TTC_CNT_CNTRL_DISABLE_MASK;
-	writel_relaxed(ctrl_reg, timer->base_addr + TTC_CNT_CNTRL_OFFSET);
+	timer->cnt_ctrl |= TTC_CNT_CNTRL_DISABLE_MASK;
+	writel_relaxed(timer->cnt_ctrl,
+		       timer->base_addr + TTC_CNT_CNTRL_OFFSET);
 	return 0;
 }
 
@@ -205,7 +221,8 @@ static int ttc_set_periodic(struct clock_event_device *evt)
 	struct ttc_timer *timer = &ttce->ttc;
 
 	ttc_set_interval(timer,
-			 DIV_ROUND_CLOSEST(ttce->ttc.freq, PRESCALE * HZ));
+			 DIV_ROUND_CLOSEST(ttce->ttc.freq,
+					   ttce->ttc.prescale * HZ));
 	return 0;
 }
 
@@ -213,11 +230,10 @@ static int ttc_resume(struct clock_event_device *evt)
 {
 	struct ttc_timer_clockevent *ttce = to_ttc_timer_clkevent(evt);
 	struct ttc_timer *timer = &ttce->ttc;
-	u32 ctrl_reg;
 
-	ctrl_reg = readl_relaxed(timer->base_addr + TTC_CNT_CNTRL_OFFSET);
-	ctrl_reg &= ~TTC_CNT_CNTRL_DISABLE_MASK;
-	writel_relaxed(ctrl_reg, timer->base_addr + TTC_CNT_CNTRL_OFFSET);
+	timer->cnt_ctrl &= ~TTC_CNT_CNTRL_DISABLE_MASK;
+	writel_relaxed(timer->cnt_ctrl,
+		       timer->base_addr + TTC_CNT_CNTRL_OFFSET);
 	return 0;
 }
 
@@ -319,6 +335,7 @@ static int __init ttc_setup_clocksource(struct clk *clk, void __iomem *base,
 					 u32 timer_width)
 {
 	struct ttc_timer_clocksource *ttccs;
+	u32 clk_ctrl;
 	int err;
 
 	ttccs = kzalloc(sizeof(*ttccs), GFP_KERNEL);
@@ -335,6 +352,14 @@ static int __init ttc_setup_clocksource(struct clk *clk, void __iomem *base,
 
 	ttccs->ttc.freq = clk_get_rate(ttccs->ttc.clk);
 
+	if (timer_width == 32) {
+		ttccs->ttc.prescale = 1 << PRESCALE_EXPONENT_32;
+		clk_ctrl = CLK_CNTRL_PRESCALE_32 | CLK_CNTRL_PRESCALE_EN;
+	} else {
+		ttccs->ttc.prescale = PRESCALE;
+		clk_ctrl = CLK_CNTRL_PRESCALE | CLK_CNTRL_PRESCALE_EN;
+	}
+
 	ttccs->ttc.clk_rate_change_nb.notifier_call =
 		ttc_rate_change_clocksource_cb;
 	ttccs->ttc.clk_rate_change_nb.next = NULL;
@@ -357,12 +382,12 @@ static int __init ttc_setup_clocksource(struct clk *clk, void __iomem *base,
 	 * it by 32 also. Let it start running now.
 	 */
 	writel_relaxed(0x0,  ttccs->ttc.base_addr + TTC_IER_OFFSET);
-	writel_relaxed(CLK_CNTRL_PRESCALE | CLK_CNTRL_PRESCALE_EN,
-		     ttccs->ttc.base_addr + TTC_CLK_CNTRL_OFFSET);
+	writel_relaxed(clk_ctrl, ttccs->ttc.base_addr + TTC_CLK_CNTRL_OFFSET);
 	writel_relaxed(CNT_CNTRL_RESET,
 		     ttccs->ttc.base_addr + TTC_CNT_CNTRL_OFFSET);
 
-	err = clocksource_register_hz(&ttccs->cs, ttccs->ttc.freq / PRESCALE);
+	err = clocksource_register_hz(&ttccs->cs,
+				      ttccs->ttc.freq / ttccs->ttc.prescale);
 	if (err) {
 		kfree(ttccs);
 		return err;
@@ -370,7 +395,7 @@ static int __init ttc_setup_clocksource(struct clk *clk, void __iomem *base,
 
 	ttc_sched_clock_val_reg = base + TTC_COUNT_VAL_OFFSET;
 	sched_clock_register(ttc_sched_clock_read, timer_width,
-			     ttccs->ttc.freq / PRESCALE);
+			     ttccs->ttc.freq / ttccs->ttc.prescale);
 
 	return 0;
 }
@@ -388,7 +413,8 @@ static int ttc_rate_change_clockevent_cb(struct notifier_block *nb,
 		/* update cached frequency */
 		ttc->freq = ndata->new_rate;
 
-		clockevents_update_freq(&ttcce->ce, ndata->new_rate / PRESCALE);
+		clockevents_update_freq(&ttcce->ce,
+					ndata->new_rate / ttc->prescale);
 
 		fallthrough;
 	case PRE_RATE_CHANGE:
@@ -399,9 +425,11 @@ static int ttc_rate_change_clockevent_cb(struct notifier_block *nb,
 }
 
 static int __init ttc_setup_clockevent(struct clk *clk,
-				       void __iomem *base, u32 irq)
+				       void __iomem *base, u32 irq,
+				       u32 timer_width)
 {
 	struct ttc_timer_clockevent *ttcce;
+	u32 clk_ctrl;
 	int err;
 
 	ttcce = kzalloc(sizeof(*ttcce), GFP_KERNEL);
@@ -427,6 +455,14 @@ static int __init ttc_setup_clockevent(struct clk *clk,
 
 	ttcce->ttc.freq = clk_get_rate(ttcce->ttc.clk);
 
+	if (timer_width == 32) {
+		ttcce->ttc.prescale = 1 << PRESCALE_EXPONENT_32;
+		clk_ctrl = CLK_CNTRL_PRESCALE_32 | CLK_CNTRL_PRESCALE_EN;
+	} else {
+		ttcce->ttc.prescale = PRESCALE;
+		clk_ctrl = CLK_CNTRL_PRESCALE | CLK_CNTRL_PRESCALE_EN;
+	}
+
 	ttcce->ttc.base_addr = base;
 	ttcce->ce.name = "ttc_clockevent";
 	ttcce->ce.features = CLOCK_EVT_FEAT_PERIODIC | CLOCK_EVT_FEAT_ONESHOT;
@@ -444,9 +480,10 @@ static int __init ttc_setup_clockevent(struct clk *clk,
 	 * is prescaled by 32 using the interval interrupt. Leave it
 	 * disabled for now.
 	 */
-	writel_relaxed(0x23, ttcce->ttc.base_addr + TTC_CNT_CNTRL_OFFSET);
-	writel_relaxed(CLK_CNTRL_PRESCALE | CLK_CNTRL_PRESCALE_EN,
-		     ttcce->ttc.base_addr + TTC_CLK_CNTRL_OFFSET);
+	ttcce->ttc.cnt_ctrl = 0x23;
+	writel_relaxed(ttcce->ttc.cnt_ctrl,
+		       ttcce->ttc.base_addr + TTC_CNT_CNTRL_OFFSET);
+	writel_relaxed(clk_ctrl, ttcce->ttc.base_addr + TTC_CLK_CNTRL_OFFSET);
 	writel_relaxed(0x1,  ttcce->ttc.base_addr + TTC_IER_OFFSET);
 
 	err = request_irq(irq, ttc_clock_event_interrupt,
@@ -455,7 +492,8 @@ static int __init ttc_setup_clockevent(struct clk *clk,
 		goto out_kfree;
 
 	clockevents_config_and_register(&ttcce->ce,
-			ttcce->ttc.freq / PRESCALE, 1, 0xfffe);
+			ttcce->ttc.freq / ttcce->ttc.prescale, 1,
+			timer_width == 32 ? 0xfffffffe : 0xfffe);
 
 	return 0;
 
@@ -529,7 +567,8 @@ static int __init ttc_timer_init(struct device_node *timer)
 	if (ret)
 		return ret;
 
-	ret = ttc_setup_clockevent(clk_ce, timer_baseaddr + 4, irq);
+	ret = ttc_setup_clockevent(clk_ce, timer_baseaddr + 4, irq,
+				   timer_width);
 	if (ret)
 		return ret;
 
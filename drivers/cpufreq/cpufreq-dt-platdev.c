@@ -91,7 +91,9 @@ static const struct of_device_id allowlist[] __initconst = {
 	{ .compatible = "ti,omap5", },
 
 	{ .compatible = "xlnx,zynq-7000", },
+#if !IS_ENABLED(CONFIG_ARM_ZYNQMP_CPUFREQ)
 	{ .compatible = "xlnx,zynqmp", },
+#endif
 
 	{ }
 };
@@ -166,6 +168,11 @@ static const struct of_device_id blocklist[] __initconst = {
 	{ .compatible = "qcom,msm8974", },
 	{ .compatible = "qcom,msm8960", },
 
+#if IS_ENABLED(CONFIG_ARM_ZYNQMP_CPUFREQ)
+	{ .compatible = "xlnx,zynqmp", },
+	{ .compatible = "xlnx,versal", },
+#endif
+
 	{ }
 };
 
@@ -0,0 +1,489 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Xilinx ZynqMP and Versal APU cpufreq driver
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ *
+ * The APU cores share a single clock (ACPU) whose rate is set by a divider
+ * behind the platform management firmware. The OPPs are mapped to divisors
+ * of the PLL feeding that divider once at probe time, so a transition is a
+ * single non-sleeping SetDivider firmware call. That makes the driver usable
+ * from the schedutil fast switch path.
+ *
+ * The clock framework is bypassed on purpose: clk_set_rate() sleeps and
+ * walks the whole clock tree for every request. Its cached rate of the CPU
+ * clock is therefore not updated by transitions.
+ */
+
+#define pr_fmt(fmt)	KBUILD_MODNAME ": " fmt
+
+#include <linux/bitfield.h>
+#include <linux/cpu.h>
+#include <linux/cpufreq.h>
+#include <linux/clk.h>
+#include <linux/err.h>
+#include <linux/firmware/xlnx-zynqmp.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/platform_device.h>
+#include <linux/pm_opp.h>
+#include <linux/regulator/consumer.h>
+#include <linux/slab.h>
+
+/* Layout of a firmware clock ID and of the SetDivider argument */
+#define ZYNQMP_CPUFREQ_CLK_INDEX	GENMASK(13, 0)
+#define ZYNQMP_CPUFREQ_DIV1_MASK	0xFFFF
+#define ZYNQMP_CPUFREQ_DIV2_KEEP	(0xFFFF << 16)
+
+/* Number of SetDivider round trips timed to get the transition latency */
+#define ZYNQMP_CPUFREQ_LAT_SAMPLES	4
+
+/**
+ * struct zynqmp_cpufreq - Private data of the driver
+ * @cpu_dev:	Device of CPU0, holding the OPP table
+ * @reg:	Optional supply of the APU, NULL if the voltage is fixed
+ * @table:	Frequency table, with the divisor as driver_data
+ * @volt:	Voltage of each @table entry in uV
+ * @clk_id:	Firmware ID of the ACPU clock
+ * @pll_rate:	Rate of the PLL ahead of the ACPU divider in Hz
+ * @latency:	Measured SetDivider round trip in ns
+ * @cur:	Index of the current @table entry
+ */
+struct zynqmp_cpufreq {
+	struct device *cpu_dev;
+	struct regulator *reg;
+	struct cpufreq_frequency_table *table;
+	unsigned long *volt;
+	u32 clk_id;
+	unsigned long pll_rate;
+	u32 latency;
+	unsigned int cur;
+};
+
+static struct zynqmp_cpufreq *zynqmp_cpufreq;
+
+/**
+ * zynqmp_cpufreq_get_div() - Read the current ACPU divisor from firmware
+ * @zc:		Driver data
+ * @div:	Current divisor
+ *
+ * Return: 0 on success else error code
+ */
+static int zynqmp_cpufreq_get_div(struct zynqmp_cpufreq *zc, u32 *div)
+{
+	int ret;
+
+	ret = zynqmp_pm_clock_getdivider(zc->clk_id, div);
+	if (ret)
+		return ret;
+
+	*div &= ZYNQMP_CPUFREQ_DIV1_MASK;
+
+	return *div ? 0 : -EINVAL;
+}
+
+/**
+ * zynqmp_cpufreq_set_div() - Program the ACPU divisor of a table entry
+ * @zc:		Driver data
+ * @index:	Index of the entry in the frequency table
+ *
+ * Safe to call from atomic context.
+ *
+ * Return: 0 on success else error code
+ */
+static int zynqmp_cpufreq_set_div(struct zynqmp_cpufreq *zc,
+				  unsigned int index)
+{
+	u32 div = zc->table[index].driver_data;
+	int ret;
+
+	ret = zynqmp_pm_clock_setdivider(zc->clk_id,
+					 ZYNQMP_CPUFREQ_DIV2_KEEP | div);
+	if (!ret)
+		WRITE_ONCE(zc->cur, index);
+
+	return ret;
+}
+
+static unsigned int zynqmp_cpufreq_get(unsigned int cpu)
+{
+	struct zynqmp_cpufreq *zc = zynqmp_cpufreq;
+	u32 div;
+
+	if (zynqmp_cpufreq_get_div(zc, &div))
+		return 0;
+
+	return zc->pll_rate / div / 1000;
+}
+
+static unsigned int zynqmp_cpufreq_fast_switch(struct cpufreq_policy *policy,
+					       unsigned int target_freq)
+{
+	struct zynqmp_cpufreq *zc = policy->driver_data;
+	int index;
+
+	index = cpufreq_frequency_table_target(policy, target_freq,
+					       CPUFREQ_RELATION_L);
+	if (zynqmp_cpufreq_set_div(zc, index))
+		return 0;
+
+	return policy->freq_table[index].frequency;
+}
+
+static int zynqmp_cpufreq_target_index(struct cpufreq_policy *policy,
+				       unsigned int index)
+{
+	struct zynqmp_cpufreq *zc = policy->driver_data;
+	unsigned int cur = READ_ONCE(zc->cur);
+	unsigned long volt = zc->volt[index];
+	int ret;
+
+	if (!zc->reg)
+		return zynqmp_cpufreq_set_div(zc, index);
+
+	/* Raise the supply ahead of the clock, lower it after */
+	if (zc->table[index].frequency > zc->table[cur].frequency) {
+		ret = regulator_set_voltage(zc->reg, volt, volt);
+		if (ret)
+			return ret;
+	}
+
+	ret = zynqmp_cpufreq_set_div(zc, index);
+	if (ret) {
+		regulator_set_voltage(zc->reg, zc->volt[cur], zc->volt[cur]);
+		return ret;
+	}
+
+	if (zc->table[index].frequency < zc->table[cur].frequency)
+		regulator_set_voltage(zc->reg, volt, volt);
+
+	return 0;
+}
+
+static int zynqmp_cpufreq_init(struct cpufreq_policy *policy)
+{
+	struct zynqmp_cpufreq *zc = zynqmp_cpufreq;
+	unsigned int latency = zc->latency;
+
+	/* All the APU cores run from the ACPU clock */
+	cpumask_setall(policy->cpus);
+	policy->driver_data = zc;
+	policy->freq_table = zc->table;
+	policy->dvfs_possible_from_any_cpu = true;
+
+	if (zc->reg)
+		latency += dev_pm_opp_get_max_volt_latency(zc->cpu_dev);
+	policy->cpuinfo.transition_latency = latency;
+
+	/* Regulator calls sleep, so only a fixed supply permits fast switch */
+	policy->fast_switch_possible = !zc->reg;
+
+	dev_pm_opp_of_register_em(zc->cpu_dev, policy->cpus);
+
+	return 0;
+}
+
+static struct cpufreq_driver zynqmp_cpufreq_driver = {
+	.name		= "zynqmp-cpufreq",
+	.flags		= CPUFREQ_NEED_INITIAL_FREQ_CHECK |
+			  CPUFREQ_IS_COOLING_DEV,
+	.verify		= cpufreq_generic_frequency_table_verify,
+	.attr		= cpufreq_generic_attr,
+	.target_index	= zynqmp_cpufreq_target_index,
+	.fast_switch	= zynqmp_cpufreq_fast_switch,
+	.get		= zynqmp_cpufreq_get,
+	.init		= zynqmp_cpufreq_init,
+};
+
+/**
+ * zynqmp_cpufreq_get_clk_id() - Get the firmware ID of the CPU clock
+ * @zc:		Driver data
+ *
+ * The clock specifier of the CPU node holds the firmware clock index. The
+ * class bits of the ID are taken from the clock attributes, the same way
+ * the clock controller driver builds them.
+ *
+ * Return: 0 on success else error code
+ */
+static int zynqmp_cpufreq_get_clk_id(struct zynqmp_cpufreq *zc)
+{
+	struct zynqmp_pm_query_data qdata = {0};
+	u32 ret_payload[PAYLOAD_ARG_CNT];
+	struct of_phandle_args spec;
+	int ret;
+
+	ret = of_parse_phandle_with_args(zc->cpu_dev->of_node, "clocks",
+					 "#clock-cells", 0, &spec);
+	if (ret)
+		return ret;
+
+	of_node_put(spec.np);
+	if (spec.args_count != 1)
+		return -EINVAL;
+
+	qdata.qid = PM_QID_CLOCK_GET_ATTRIBUTES;
+	qdata.arg1 = spec.args[0];
+
+	ret = zynqmp_pm_query_data(qdata, ret_payload);
+	if (ret)
+		return ret;
+
+	zc->clk_id = (ret_payload[1] & ~ZYNQMP_CPUFREQ_CLK_INDEX) |
+		     FIELD_PREP(ZYNQMP_CPUFREQ_CLK_INDEX, spec.args[0]);
+
+	return 0;
+}
+
+/**
+ * zynqmp_cpufreq_measure() - Time the SetDivider round trip
+ * @zc:		Driver data
+ *
+ * Rewrites the current divisor a few times, which also leaves the firmware
+ * feature check of the call cached before it is used from atomic context.
+ *
+ * Return: 0 on success else error code
+ */
+static int zynqmp_cpufreq_measure(struct zynqmp_cpufreq *zc)
+{
+	u32 div;
+	ktime_t start;
+	s64 delta;
+	int ret, i;
+
+	ret = zynqmp_cpufreq_get_div(zc, &div);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < ZYNQMP_CPUFREQ_LAT_SAMPLES; i++) {
+		start = ktime_get();
+		ret = zynqmp_pm_clock_setdivider(zc->clk_id,
+						 ZYNQMP_CPUFREQ_DIV2_KEEP | div);
+		if (ret)
+			return ret;
+
+		delta = ktime_to_ns(ktime_sub(ktime_get(), start));
+		zc->latency = max_t(u32, zc->latency, delta);
+	}
+
+	return 0;
+}
+
+/**
+ * zynqmp_cpufreq_build_table() - Map the OPPs onto ACPU divisors
+ * @zc:		Driver data
+ * @dev:	Device the tables are allocated for
+ *
+ * Each OPP gets the smallest divisor that does not exceed its frequency.
+ * OPPs that land on the same divisor as a lower one are marked invalid.
+ *
+ * Return: 0 on success else error code
+ */
+static int zynqmp_cpufreq_build_table(struct zynqmp_cpufreq *zc,
+				      struct device *dev)
+{
+	struct device *cpu_dev = zc->cpu_dev;
+	struct dev_pm_opp *opp;
+	unsigned long rate = 0;
+	unsigned int freq, prev = 0;
+	int count, i;
+	u32 div;
+
+	count = dev_pm_opp_get_opp_count(cpu_dev);
+	if (count <= 0)
+		return count ? count : -ENODEV;
+
+	zc->table = devm_kcalloc(dev, count + 1, sizeof(*zc->table),
+				 GFP_KERNEL);
+	zc->volt = devm_kcalloc(dev, count, sizeof(*zc->volt), GFP_KERNEL);
+	if (!zc->table || !zc->volt)
+		return -ENOMEM;
+
+	for (i = 0; i < count; i++, rate++) {
+		opp = dev_pm_opp_find_freq_ceil(cpu_dev, &rate);
+		if (IS_ERR(opp))
+			return PTR_ERR(opp);
+
+		zc->volt[i] = dev_pm_opp_get_voltage(opp);
+		dev_pm_opp_put(opp);
+
+		div = DIV_ROUND_UP(zc->pll_rate, rate);
+		freq = zc->pll_rate / div / 1000;
+		if (!div || div > ZYNQMP_CPUFREQ_DIV1_MASK || freq == prev) {
+			zc->table[i].frequency = CPUFREQ_ENTRY_INVALID;
+			continue;
+		}
+
+		zc->table[i].frequency = freq;
+		zc->table[i].driver_data = div;
+		prev = freq;
+	}
+	zc->table[count].frequency = CPUFREQ_TABLE_END;
+
+	return 0;
+}
+
+/**
+ * zynqmp_cpufreq_find_cur() - Get the table entry of the current divisor
+ * @zc:		Driver data
+ * @div:	Current divisor
+ *
+ * A divisor the boot firmware set up may match no entry. The lowest entry
+ * at or above the current frequency is taken then, so the first transition
+ * still orders the voltage and clock changes safely. If there is none,
+ * the highest entry is taken.
+ *
+ * Return: index of the entry in the frequency table
+ */
+static unsigned int zynqmp_cpufreq_find_cur(struct zynqmp_cpufreq *zc,
+					    u32 div)
+{
+	unsigned int freq = zc->pll_rate / div / 1000;
+	struct cpufreq_frequency_table *pos;
+	unsigned int i, cur = 0;
+
+	/* The table follows the OPPs, in ascending frequency order */
+	cpufreq_for_each_valid_entry_idx(pos, zc->table, i) {
+		cur = i;
+		if (pos->driver_data == div || pos->frequency >= freq)
+			break;
+	}
+
+	return cur;
+}
+
+static int zynqmp_cpufreq_probe(struct platform_device *pdev)
+{
+	struct zynqmp_cpufreq *zc;
+	struct device *cpu_dev;
+	struct clk *clk;
+	u32 div;
+	int ret;
+
+	cpu_dev = get_cpu_device(0);
+	if (!cpu_dev)
+		return -ENODEV;
+
+	zc = devm_kzalloc(&pdev->dev, sizeof(*zc), GFP_KERNEL);
+	if (!zc)
+		return -ENOMEM;
+	zc->cpu_dev = cpu_dev;
+
+	/* Only there to wait for the clock controller and its rate */
+	clk = clk_get(cpu_dev, NULL);
+	if (IS_ERR(clk))
+		return dev_err_probe(&pdev->dev, PTR_ERR(clk),
+				     "failed to get CPU clock\n");
+
+	ret = zynqmp_cpufreq_get_clk_id(zc);
+	if (!ret)
+		ret = zynqmp_cpufreq_get_div(zc, &div);
+	if (ret) {
+		dev_err(&pdev->dev, "failed to read the CPU divider: %d\n", ret);
+		goto put_clk;
+	}
+	zc->pll_rate = clk_get_rate(clk) * div;
+
+	zc->reg = regulator_get_optional(cpu_dev, "cpu");
+	if (IS_ERR(zc->reg)) {
+		ret = PTR_ERR(zc->reg);
+		if (ret != -ENODEV)
+			goto put_clk;
+		zc->reg = NULL;
+	}
+
+	ret = dev_pm_opp_of_cpumask_add_table(cpu_possible_mask);
+	if (ret)
+		goto put_reg;
+
+	ret = zynqmp_cpufreq_build_table(zc, &pdev->dev);
+	if (ret)
+		goto remove_opp;
+
+	ret = zynqmp_cpufreq_measure(zc);
+	if (ret)
+		goto remove_opp;
+
+	zc->cur = zynqmp_cpufreq_find_cur(zc, div);
+
+	zynqmp_cpufreq = zc;
+	platform_set_drvdata(pdev, zc);
+	ret = cpufreq_register_driver(&zynqmp_cpufreq_driver);
+	if (ret)
+		goto remove_opp;
+
+	clk_put(clk);
+	dev_info(&pdev->dev, "APU at %lu Hz, transition latency %u ns\n",
+		 zc->pll_rate / div, zc->latency);
+
+	return 0;
+
+remove_opp:
+	dev_pm_opp_of_cpumask_remove_table(cpu_possible_mask);
+put_reg:
+	if (zc->reg)
+		regulator_put(zc->reg);
+put_clk:
+	clk_put(clk);
+
+	return ret;
+}
+
+static int zynqmp_cpufreq_remove(struct platform_device *pdev)
+{
+	struct zynqmp_cpufreq *zc = platform_get_drvdata(pdev);
+
+	cpufreq_unregister_driver(&zynqmp_cpufreq_driver);
+	dev_pm_opp_of_cpumask_remove_table(cpu_possible_mask);
+	if (zc->reg)
+		regulator_put(zc->reg);
+
+	return 0;
+}
+
+static struct platform_driver zynqmp_cpufreq_platdrv = {
+	.driver = {
+		.name = "zynqmp-cpufreq",
+	},
+	.probe = zynqmp_cpufreq_probe,
+	.remove = zynqmp_cpufreq_remove,
+};
+
+static struct platform_device *zynqmp_cpufreq_pdev;
+
+static int __init zynqmp_cpufreq_module_init(void)
+{
+	int ret;
+
+	if (!of_machine_is_compatible("xlnx,zynqmp") &&
+	    !of_machine_is_compatible("xlnx,versal"))
+		return -ENODEV;
+
+	/*
+	 * Platform driver+device required for handling EPROBE_DEFER with
+	 * the firmware clock controller
+	 */
+	ret = platform_driver_register(&zynqmp_cpufreq_platdrv);
+	if (ret)
+		return ret;
+
+	zynqmp_cpufreq_pdev = platform_device_register_simple("zynqmp-cpufreq",
+							      -1, NULL, 0);
+	if (IS_ERR(zynqmp_cpufreq_pdev)) {
+		platform_driver_unregister(&zynqmp_cpufreq_platdrv);
+		return PTR_ERR(zynqmp_cpufreq_pdev);
+	}
+
+	return 0;
+}
+module_init(zynqmp_cpufreq_module_init);
+
+static void __exit zynqmp_cpufreq_module_exit(void)
+{
+	platform_device_unregister(zynqmp_cpufreq_pdev);
+	platform_driver_unregister(&zynqmp_cpufreq_platdrv);
+}
+module_exit(zynqmp_cpufreq_module_exit);
+
+MODULE_DESCRIPTION("Xilinx ZynqMP and Versal APU cpufreq driver");
+MODULE_LICENSE("GPL");
@@ -38,6 +38,11 @@ LIST_HEAD(cpuidle_detected_devices);
 static int enabled_devices;
 static int off __read_mostly;
 static int initialized __read_mostly;
+static bool measure_latency __read_mostly;
+bool cpuidle_use_measured_latency __read_mostly;
+
+/* Wake-ups this late were not caused by the timer, or were disturbed */
+#define CPUIDLE_LATENCY_SAMPLE_MAX_NS	(2 * NSEC_PER_MSEC)
 
 int cpuidle_disabled(void)
 {
@@ -193,6 +198,43 @@ int cpuidle_enter_s2idle(struct cpuidle_driver *drv, struct cpuidle_device *dev)
 }
 #endif /* CONFIG_SUSPEND */
 
+/**
+ * cpuidle_sample_exit_latency - account the wake-up delay of an idle period
+ * @dev: cpuidle device for this cpu
+ * @index: index of the state that was entered
+ *
+ * When the CPU is woken up by the timer it armed before going idle, the time
+ * between the timer expiry and the return from the idle state is the exit
+ * latency the CPU actually saw. Wake-ups before the expiry came from another
+ * interrupt and carry no such information.
+ */
+static void cpuidle_sample_exit_latency(struct cpuidle_device *dev, int index)
+{
+	struct cpuidle_state_usage *su = &dev->states_usage[index];
+	ktime_t expires = READ_ONCE(dev->next_hrtimer);
+	s64 late;
+
+	if (!expires)
+		return;
+
+	late = ktime_to_ns(ktime_sub(ktime_get(), expires));
+	if (late < 0 || late > CPUIDLE_LATENCY_SAMPLE_MAX_NS)
+		return;
+
+	/* Running average with a weight of 1/8 for the newest sample. */
+	if (su->latency_samples)
+		WRITE_ONCE(su->latency_avg_ns,
+			   su->latency_avg_ns - (su->latency_avg_ns >> 3) +
+			   (late >> 3));
+	else
+		WRITE_ONCE(su->latency_avg_ns, late);
+
+	if (late > su->latency_max_ns)
+		su->latency_max_ns = late;
+
+	WRITE_ONCE(su->latency_samples, su->latency_samples + 1);
+}
+
 /**
  * cpuidle_enter_state - enter the state and update stats
  * @dev: cpuidle device for this cpu
@@ -245,6 +287,9 @@ int cpuidle_enter_state(struct cpuidle_device *dev, struct cpuidle_driver *drv,
 	time_end = ns_to_ktime(local_clock());
 	trace_cpu_idle(PWR_EVENT_EXIT, dev->cpu);
 
+	if (measure_latency && entered_state >= 0)
+		cpuidle_sample_exit_latency(dev, entered_state);
+
 	/* The cpu is no longer idle or about to enter idle. */
 	sched_idle_set_state(NULL);
 
@@ -781,4 +826,10 @@ static int __init cpuidle_init(void)
 
 module_param(off, int, 0444);
 module_param_string(governor, param_governor, CPUIDLE_NAME_LEN, 0444);
+module_param(measure_latency, bool, 0644);
+MODULE_PARM_DESC(measure_latency, "Measure idle state exit latencies");
+module_param_named(use_measured_latency, cpuidle_use_measured_latency, bool,
+		   0644);
+MODULE_PARM_DESC(use_measured_latency,
+		 "Let governors use the measured exit latencies");
 core_initcall(cpuidle_init);
@@ -353,7 +353,7 @@ static int teo_select(struct cpuidle_driver *drv, struct cpuidle_device *dev,
 
 		idx = i;
 
-		if (s->exit_latency_ns <= latency_req)
+		if (cpuidle_state_exit_latency_ns(drv, dev, i) <= latency_req)
 			constraint_idx = i;
 
 		idx_intercept_sum = intercept_sum;
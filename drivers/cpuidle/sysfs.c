@@ -261,6 +261,23 @@ define_show_state_str_function(name)
 define_show_state_str_function(desc)
 define_show_state_ull_function(above)
 define_show_state_ull_function(below)
+define_show_state_ull_function(latency_samples)
+
+static ssize_t show_state_latency_measured(struct cpuidle_state *state,
+				struct cpuidle_state_usage *state_usage,
+				char *buf)
+{
+	return sprintf(buf, "%llu\n", div_u64(state_usage->latency_avg_ns,
+					      NSEC_PER_USEC));
+}
+
+static ssize_t show_state_latency_max(struct cpuidle_state *state,
+				      struct cpuidle_state_usage *state_usage,
+				      char *buf)
+{
+	return sprintf(buf, "%llu\n", div_u64(state_usage->latency_max_ns,
+					      NSEC_PER_USEC));
+}
 
 static ssize_t show_state_time(struct cpuidle_state *state,
 			       struct cpuidle_state_usage *state_usage,
@@ -319,6 +336,9 @@ define_one_state_rw(disable, show_state_disable, store_state_disable);
 define_one_state_ro(above, show_state_above);
 define_one_state_ro(below, show_state_below);
 define_one_state_ro(default_status, show_state_default_status);
+define_one_state_ro(latency_measured, show_state_latency_measured);
+define_one_state_ro(latency_max, show_state_latency_max);
+define_one_state_ro(latency_samples, show_state_latency_samples);
 
 static struct attribute *cpuidle_state_default_attrs[] = {
 	&attr_name.attr,
@@ -333,6 +353,9 @@ static struct attribute *cpuidle_state_default_attrs[] = {
 	&attr_above.attr,
 	&attr_below.attr,
 	&attr_default_status.attr,
+	&attr_latency_measured.attr,
+	&attr_latency_max.attr,
+	&attr_latency_samples.attr,
 	NULL
 };
 ATTRIBUTE_GROUPS(cpuidle_state_default);
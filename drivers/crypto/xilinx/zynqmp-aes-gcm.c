@@ -27,11 +27,18 @@
 #define ZYNQMP_AES_MIN_INPUT_BLK_SIZE	4U
 #define ZYNQMP_AES_WORD_LEN		4U
 #define VERSAL_AES_QWORD_LEN		16U
+#define ZYNQMP_AES_BATCH_SIZE		16U
+#define ZYNQMP_AES_QUEUE_LEN		64U
 
 #define ZYNQMP_AES_GCM_TAG_MISMATCH_ERR		0x01
 #define ZYNQMP_AES_WRONG_KEY_SRC_ERR		0x13
 #define ZYNQMP_AES_PUF_NOT_PROGRAMMED		0xE300
 
+static unsigned int min_hw_size;
+module_param(min_hw_size, uint, 0644);
+MODULE_PARM_DESC(min_hw_size,
+		 "Send requests shorter than this to the software fallback");
+
 enum zynqmp_aead_op {
 	ZYNQMP_AES_DECRYPT = 0,
 	ZYNQMP_AES_ENCRYPT
@@ -87,6 +94,13 @@ struct zynqmp_aead_tfm_ctx {
 	u32 authsize;
 	u8 keysrc;
 	struct crypto_aead *fbk_cipher;
+	struct xilinx_aead_dma_desc *desc;
+	dma_addr_t desc_dma;
+};
+
+struct xilinx_aead_batch_ent {
+	struct aead_request *req;
+	int err;
 };
 
 struct xilinx_aead_drv_ctx {
@@ -96,6 +110,9 @@ struct xilinx_aead_drv_ctx {
 	int (*aes_aead_cipher)(struct aead_request *areq);
 	int (*fallback_check)(struct zynqmp_aead_tfm_ctx *ctx,
 			      struct aead_request *areq);
+	/* Requests done by the engine thread but not yet completed */
+	struct xilinx_aead_batch_ent batch[ZYNQMP_AES_BATCH_SIZE];
+	unsigned int batch_len;
 };
 
 struct zynqmp_aead_hw_req {
@@ -125,45 +142,112 @@ struct versal_in_params {
 	u32 is_last;
 };
 
+/*
+ * Firmware request descriptor and the IV and key it points at. One block is
+ * allocated per tfm; the crypto engine runs the requests of a tfm one at a
+ * time, so it is never shared by two requests in flight.
+ */
+struct xilinx_aead_dma_desc {
+	union {
+		struct zynqmp_aead_hw_req zynqmp;
+		struct {
+			struct versal_init_ops init;
+			struct versal_in_params in;
+		} versal;
+	};
+	u8 iv[GCM_AES_IV_SIZE];
+	u8 key[ZYNQMP_AES_KEY_SIZE];
+};
+
+#define XILINX_AEAD_DESC_IV(ctx)	\
+	((ctx)->desc_dma + offsetof(struct xilinx_aead_dma_desc, iv))
+#define XILINX_AEAD_DESC_KEY(ctx)	\
+	((ctx)->desc_dma + offsetof(struct xilinx_aead_dma_desc, key))
+
+static bool zynqmp_aes_sg_direct(struct scatterlist *sg, unsigned int len)
+{
+	return sg_nents_for_len(sg, len) == 1 &&
+	       IS_ALIGNED(sg->offset, ZYNQMP_AES_WORD_LEN);
+}
+
+/*
+ * The ZynqMP firmware takes separate source and destination addresses, so
+ * a request whose data sits in one segment on each side is handed to the
+ * engine as is instead of being copied through a bounce buffer.
+ */
+static bool zynqmp_aes_map_direct(struct device *dev,
+				  struct aead_request *req,
+				  unsigned int out_size)
+{
+	if (!zynqmp_aes_sg_direct(req->src, req->cryptlen) ||
+	    !zynqmp_aes_sg_direct(req->dst, out_size))
+		return false;
+
+	if (req->src == req->dst)
+		return dma_map_sg(dev, req->src, 1, DMA_BIDIRECTIONAL) == 1;
+
+	if (dma_map_sg(dev, req->src, 1, DMA_TO_DEVICE) != 1)
+		return false;
+
+	if (dma_map_sg(dev, req->dst, 1, DMA_FROM_DEVICE) != 1) {
+		dma_unmap_sg(dev, req->src, 1, DMA_TO_DEVICE);
+		return false;
+	}
+
+	return true;
+}
+
+static void zynqmp_aes_unmap_direct(struct device *dev,
+				    struct aead_request *req)
+{
+	if (req->src == req->dst) {
+		dma_unmap_sg(dev, req->src, 1, DMA_BIDIRECTIONAL);
+	} else {
+		dma_unmap_sg(dev, req->dst, 1, DMA_FROM_DEVICE);
+		dma_unmap_sg(dev, req->src, 1, DMA_TO_DEVICE);
+	}
+}
+
 static int zynqmp_aes_aead_cipher(struct aead_request *req)
 {
 	struct crypto_aead *aead = crypto_aead_reqtfm(req);
 	struct zynqmp_aead_tfm_ctx *tfm_ctx = crypto_aead_ctx(aead);
 	struct zynqmp_aead_req_ctx *rq_ctx = aead_request_ctx(req);
+	struct zynqmp_aead_hw_req *hwreq = &tfm_ctx->desc->zynqmp;
 	struct device *dev = tfm_ctx->dev;
-	struct zynqmp_aead_hw_req *hwreq;
-	dma_addr_t dma_addr_data, dma_addr_hw_req;
-	unsigned int data_size;
+	unsigned int data_size = req->cryptlen;
+	dma_addr_t dma_addr_data = 0;
+	unsigned int out_size;
 	unsigned int status;
+	size_t dma_size = 0;
+	char *kbuf = NULL;
+	bool direct;
 	int ret;
-	size_t dma_size;
-	char *kbuf;
 	int err;
 
-	if (tfm_ctx->keysrc == ZYNQMP_AES_KUP_KEY)
-		dma_size = req->cryptlen + ZYNQMP_AES_KEY_SIZE
-			   + GCM_AES_IV_SIZE;
+	if (rq_ctx->op == ZYNQMP_AES_ENCRYPT)
+		out_size = data_size + ZYNQMP_AES_AUTH_SIZE;
 	else
-		dma_size = req->cryptlen + GCM_AES_IV_SIZE;
+		out_size = data_size - ZYNQMP_AES_AUTH_SIZE;
 
-	kbuf = dma_alloc_coherent(dev, dma_size, &dma_addr_data, GFP_KERNEL);
-	if (!kbuf)
-		return -ENOMEM;
-
-	hwreq = dma_alloc_coherent(dev, sizeof(struct zynqmp_aead_hw_req),
-				   &dma_addr_hw_req, GFP_KERNEL);
-	if (!hwreq) {
-		dma_free_coherent(dev, dma_size, kbuf, dma_addr_data);
-		return -ENOMEM;
+	direct = zynqmp_aes_map_direct(dev, req, out_size);
+	if (direct) {
+		hwreq->src = sg_dma_address(req->src);
+		hwreq->dst = sg_dma_address(req->dst);
+	} else {
+		dma_size = max(data_size, out_size);
+		kbuf = dma_alloc_coherent(dev, dma_size, &dma_addr_data,
+					  GFP_KERNEL);
+		if (!kbuf)
+			return -ENOMEM;
+
+		scatterwalk_map_and_copy(kbuf, req->src, 0, data_size, 0);
+		hwreq->src = dma_addr_data;
+		hwreq->dst = dma_addr_data;
 	}
 
-	data_size = req->cryptlen;
-	scatterwalk_map_and_copy(kbuf, req->src, 0, req->cryptlen, 0);
-	memcpy(kbuf + data_size, req->iv, GCM_AES_IV_SIZE);
-
-	hwreq->src = dma_addr_data;
-	hwreq->dst = dma_addr_data;
-	hwreq->iv = hwreq->src + data_size;
+	memcpy(tfm_ctx->desc->iv, req->iv, GCM_AES_IV_SIZE);
+	hwreq->iv = XILINX_AEAD_DESC_IV(tfm_ctx);
 	hwreq->keysrc = tfm_ctx->keysrc;
 	hwreq->op = rq_ctx->op;
 
@@ -173,15 +257,16 @@ static int zynqmp_aes_aead_cipher(struct aead_request *req)
 		hwreq->size = data_size - ZYNQMP_AES_AUTH_SIZE;
 
 	if (hwreq->keysrc == ZYNQMP_AES_KUP_KEY) {
-		memcpy(kbuf + data_size + GCM_AES_IV_SIZE,
-		       tfm_ctx->key, ZYNQMP_AES_KEY_SIZE);
-
-		hwreq->key = hwreq->src + data_size + GCM_AES_IV_SIZE;
+		memcpy(tfm_ctx->desc->key, tfm_ctx->key, ZYNQMP_AES_KEY_SIZE);
+		hwreq->key = XILINX_AEAD_DESC_KEY(tfm_ctx);
 	} else {
 		hwreq->key = 0;
 	}
 
-	ret = zynqmp_pm_aes_engine(dma_addr_hw_req, &status);
+	ret = zynqmp_pm_aes_engine(tfm_ctx->desc_dma, &status);
+
+	if (direct)
+		zynqmp_aes_unmap_direct(dev, req);
 
 	if (ret) {
 		dev_err(dev, "ERROR: AES PM API failed\n");
@@ -203,13 +288,9 @@ static int zynqmp_aes_aead_cipher(struct aead_request *req)
 		}
 		err = -status;
 	} else {
-		if (hwreq->op == ZYNQMP_AES_ENCRYPT)
-			data_size = data_size + ZYNQMP_AES_AUTH_SIZE;
-		else
-			data_size = data_size - ZYNQMP_AES_AUTH_SIZE;
-
-		sg_copy_from_buffer(req->dst, sg_nents(req->dst),
-				    kbuf, data_size);
+		if (!direct)
+			sg_copy_from_buffer(req->dst, sg_nents(req->dst),
+					    kbuf, out_size);
 		err = 0;
 	}
 
@@ -217,11 +298,7 @@ static int zynqmp_aes_aead_cipher(struct aead_request *req)
 		memzero_explicit(kbuf, dma_size);
 		dma_free_coherent(dev, dma_size, kbuf, dma_addr_data);
 	}
-	if (hwreq) {
-		memzero_explicit(hwreq, sizeof(struct zynqmp_aead_hw_req));
-		dma_free_coherent(dev, sizeof(struct zynqmp_aead_hw_req),
-				  hwreq, dma_addr_hw_req);
-	}
+	memzero_explicit(tfm_ctx->desc, sizeof(*tfm_ctx->desc));
 	return err;
 }
 
@@ -230,50 +307,31 @@ static int versal_aes_aead_cipher(struct aead_request *req)
 	struct crypto_aead *aead = crypto_aead_reqtfm(req);
 	struct zynqmp_aead_tfm_ctx *tfm_ctx = crypto_aead_ctx(aead);
 	struct zynqmp_aead_req_ctx *rq_ctx = aead_request_ctx(req);
-	dma_addr_t dma_addr_data, dma_addr_hw_req, dma_addr_in;
+	struct versal_init_ops *hwreq = &tfm_ctx->desc->versal.init;
+	struct versal_in_params *in = &tfm_ctx->desc->versal.in;
+	dma_addr_t dma_addr_hw_req, dma_addr_in, dma_addr_data;
 	u32 total_len = req->assoclen + req->cryptlen;
-	u32 key_offset = total_len + GCM_AES_IV_SIZE;
 	struct device *dev = tfm_ctx->dev;
-	struct versal_init_ops *hwreq;
-	struct versal_in_params *in;
 	u32 gcm_offset, out_len;
 	size_t dma_size;
 	char *kbuf;
 	int ret;
 
-	dma_size = key_offset + tfm_ctx->keylen;
+	/* Room for the tag appended by encryption */
+	dma_size = total_len + ZYNQMP_AES_AUTH_SIZE;
 
 	kbuf = dma_alloc_coherent(dev, dma_size, &dma_addr_data, GFP_KERNEL);
-	if (!kbuf) {
-		ret = -ENOMEM;
-		goto err;
-	}
-
-	/*
-	 * Allocated separate memory as separate structure for init ops
-	 * Also to avoid big continuous memory allocation
-	 */
-	hwreq = dma_alloc_coherent(dev, sizeof(struct versal_init_ops),
-				   &dma_addr_hw_req, GFP_KERNEL);
-	if (!hwreq) {
-		ret = -ENOMEM;
-		goto hwreq_fail;
-	}
+	if (!kbuf)
+		return -ENOMEM;
 
-	/*
-	 * Allocated separate memory as separate structure for in params
-	 * Also to avoid big continuous memory allocation
-	 */
-	in = dma_alloc_coherent(dev, sizeof(struct versal_in_params),
-				&dma_addr_in, GFP_KERNEL);
-	if (!in) {
-		ret = -ENOMEM;
-		goto in_fail;
-	}
+	dma_addr_hw_req = tfm_ctx->desc_dma +
+			  offsetof(struct xilinx_aead_dma_desc, versal.init);
+	dma_addr_in = tfm_ctx->desc_dma +
+		      offsetof(struct xilinx_aead_dma_desc, versal.in);
 
 	scatterwalk_map_and_copy(kbuf, req->src, 0, total_len, 0);
-	memcpy(kbuf + total_len, req->iv, GCM_AES_IV_SIZE);
-	hwreq->iv = dma_addr_data + total_len;
+	memcpy(tfm_ctx->desc->iv, req->iv, GCM_AES_IV_SIZE);
+	hwreq->iv = XILINX_AEAD_DESC_IV(tfm_ctx);
 	hwreq->keysrc = tfm_ctx->keysrc;
 
 	if (rq_ctx->op == ZYNQMP_AES_ENCRYPT) {
@@ -291,23 +349,22 @@ static int versal_aes_aead_cipher(struct aead_request *req)
 	else if (tfm_ctx->keylen == XSECURE_AES_KEY_SIZE_256)
 		hwreq->size = AES_KEY_SIZE_256;
 
-	memcpy(kbuf + key_offset,
-	       tfm_ctx->key, tfm_ctx->keylen);
+	memcpy(tfm_ctx->desc->key, tfm_ctx->key, tfm_ctx->keylen);
 
 	ret = versal_pm_aes_key_write(hwreq->size, hwreq->keysrc,
-				      dma_addr_data + key_offset);
+				      XILINX_AEAD_DESC_KEY(tfm_ctx));
 	if (ret)
-		goto in_fail;
+		goto out;
 
 	ret = versal_pm_aes_op_init(dma_addr_hw_req);
 	if (ret)
-		goto in_fail;
+		goto out;
 
 	if (req->assoclen > 0) {
 		/* Currently GMAC is OFF by default */
 		ret = versal_pm_aes_update_aad(dma_addr_data, req->assoclen);
 		if (ret)
-			goto in_fail;
+			goto out;
 	}
 
 	in->in_data_addr = dma_addr_data + req->assoclen;
@@ -318,32 +375,29 @@ static int versal_aes_aead_cipher(struct aead_request *req)
 		ret = versal_pm_aes_enc_update(dma_addr_in,
 					       dma_addr_data + req->assoclen);
 		if (ret)
-			goto in_fail;
+			goto out;
 
 		ret = versal_pm_aes_enc_final(dma_addr_data + gcm_offset);
 		if (ret)
-			goto in_fail;
+			goto out;
 	} else {
 		ret = versal_pm_aes_dec_update(dma_addr_in,
 					       dma_addr_data + req->assoclen);
 		if (ret)
-			goto in_fail;
+			goto out;
 
 		ret = versal_pm_aes_dec_final(dma_addr_data + gcm_offset);
 		if (ret)
-			goto in_fail;
+			goto out;
 	}
 
 	sg_copy_from_buffer(req->dst, sg_nents(req->dst),
 			    kbuf, out_len);
 
-in_fail:
-	memzero_explicit(hwreq, sizeof(struct zynqmp_aead_hw_req));
-	dma_free_coherent(dev, sizeof(struct versal_init_ops), hwreq, dma_addr_hw_req);
-hwreq_fail:
+out:
+	memzero_explicit(tfm_ctx->desc, sizeof(*tfm_ctx->desc));
 	memzero_explicit(kbuf, dma_size);
 	dma_free_coherent(dev, dma_size, kbuf, dma_addr_data);
-err:
 	return ret;
 }
 
@@ -367,6 +421,11 @@ static int zynqmp_fallback_check(struct zynqmp_aead_tfm_ctx *tfm_ctx,
 	if ((req->cryptlen % ZYNQMP_AES_WORD_LEN) != 0)
 		need_fallback = 1;
 
+	/* Only a user key can be handed to the software fallback */
+	if (tfm_ctx->keysrc == ZYNQMP_AES_KUP_KEY &&
+	    req->cryptlen < min_hw_size)
+		need_fallback = 1;
+
 	if (rq_ctx->op == ZYNQMP_AES_DECRYPT &&
 	    req->cryptlen <= ZYNQMP_AES_AUTH_SIZE) {
 		need_fallback = 1;
@@ -402,10 +461,25 @@ static int versal_fallback_check(struct zynqmp_aead_tfm_ctx *tfm_ctx,
 		need_fallback = 1;
 		goto fallback;
 	}
+	if (req->cryptlen < min_hw_size)
+		need_fallback = 1;
 fallback:
 	return need_fallback;
 }
 
+static int zynqmp_aes_complete_batch(struct crypto_engine *engine)
+{
+	struct xilinx_aead_drv_ctx *drv_ctx = dev_get_drvdata(engine->dev);
+	unsigned int i;
+
+	for (i = 0; i < drv_ctx->batch_len; i++)
+		crypto_finalize_aead_request(engine, drv_ctx->batch[i].req,
+					     drv_ctx->batch[i].err);
+	drv_ctx->batch_len = 0;
+
+	return 0;
+}
+
 static int handle_aes_req(struct crypto_engine *engine, void *req)
 {
 	struct aead_request *areq =
@@ -439,7 +513,15 @@ static int handle_aes_req(struct crypto_engine *engine, void *req)
 		err = drv_ctx->aes_aead_cipher(areq);
 	}
 
-	crypto_finalize_aead_request(engine, areq, err);
+	/*
+	 * The firmware call is synchronous; completions are deferred until
+	 * the engine queue drains so that queued requests run back to back.
+	 */
+	drv_ctx->batch[drv_ctx->batch_len].req = areq;
+	drv_ctx->batch[drv_ctx->batch_len].err = err;
+	if (++drv_ctx->batch_len == ZYNQMP_AES_BATCH_SIZE)
+		zynqmp_aes_complete_batch(engine);
+
 	return 0;
 }
 
@@ -574,6 +656,14 @@ static int aes_aead_init(struct crypto_aead *aead)
 		return PTR_ERR(tfm_ctx->fbk_cipher);
 	}
 
+	tfm_ctx->desc = dma_alloc_coherent(tfm_ctx->dev, sizeof(*tfm_ctx->desc),
+					   &tfm_ctx->desc_dma, GFP_KERNEL);
+	if (!tfm_ctx->desc) {
+		crypto_free_aead(tfm_ctx->fbk_cipher);
+		tfm_ctx->fbk_cipher = NULL;
+		return -ENOMEM;
+	}
+
 	crypto_aead_set_reqsize(aead,
 				max(sizeof(struct zynqmp_aead_req_ctx),
 				    sizeof(struct aead_request) +
@@ -591,6 +681,9 @@ static void zynqmp_aes_aead_exit(struct crypto_aead *aead)
 		crypto_free_aead(tfm_ctx->fbk_cipher);
 		tfm_ctx->fbk_cipher = NULL;
 	}
+	if (tfm_ctx->desc)
+		dma_free_coherent(tfm_ctx->dev, sizeof(*tfm_ctx->desc),
+				  tfm_ctx->desc, tfm_ctx->desc_dma);
 	memzero_explicit(tfm_ctx, sizeof(struct zynqmp_aead_tfm_ctx));
 }
 
@@ -693,7 +786,10 @@ static int zynqmp_aes_aead_probe(struct platform_device *pdev)
 		return err;
 	}
 
-	aes_drv_ctx->engine = crypto_engine_alloc_init(dev, 1);
+	aes_drv_ctx->engine =
+		crypto_engine_alloc_init_and_set(dev, true,
+						 zynqmp_aes_complete_batch,
+						 true, ZYNQMP_AES_QUEUE_LEN);
 	if (!aes_drv_ctx->engine) {
 		dev_err(dev, "Cannot alloc AES engine\n");
 		err = -ENOMEM;
@@ -5,6 +5,7 @@
  * Copyright (C) 2022-2023, Advanced Micro Devices, Inc.
  */
 #include <linux/cacheflush.h>
+#include <crypto/engine.h>
 #include <crypto/hash.h>
 #include <crypto/internal/hash.h>
 #include <crypto/sha3.h>
@@ -26,6 +27,11 @@
 
 #define ZYNQMP_DMA_BIT_MASK		32U
 #define ZYNQMP_DMA_ALLOC_FIXED_SIZE	0x1000U
+#define ZYNQMP_SHA_BATCH_SIZE		16U
+#define ZYNQMP_SHA_WORD_LEN		4U
+/* Shorter aligned segments are bounced to save firmware round trips */
+#define ZYNQMP_SHA_DIRECT_MIN		256U
+#define ZYNQMP_SHA_QUEUE_LEN		64U
 
 enum zynqmp_sha_op {
 	ZYNQMP_SHA3_INIT = 1,
@@ -33,12 +39,23 @@ enum zynqmp_sha_op {
 	ZYNQMP_SHA3_FINAL = 4,
 };
 
+struct xilinx_sha_batch_ent {
+	struct ahash_request *req;
+	int err;
+};
+
 struct xilinx_sha_drv_ctx {
-	struct shash_alg sha3_384;
+	struct ahash_alg sha3_384;
 	struct device *dev;
+	struct crypto_engine *engine;
+	int (*sha_digest)(struct ahash_request *req);
+	/* Digests done by the engine thread but not yet completed */
+	struct xilinx_sha_batch_ent batch[ZYNQMP_SHA_BATCH_SIZE];
+	unsigned int batch_len;
 };
 
 struct zynqmp_sha_tfm_ctx {
+	struct crypto_engine_ctx engine_ctx;
 	struct device *dev;
 	struct crypto_shash *fbk_tfm;
 };
@@ -47,19 +64,62 @@ struct zynqmp_sha_desc_ctx {
 	struct shash_desc fbk_req;
 };
 
+static struct xilinx_sha_drv_ctx *zynqmp_sha_drv_ctx(struct crypto_ahash *hash)
+{
+	struct crypto_alg *base = crypto_ahash_tfm(hash)->__crt_alg;
+	struct ahash_alg *alg = __crypto_ahash_alg(base);
+
+	return container_of(alg, struct xilinx_sha_drv_ctx, sha3_384);
+}
+
 static dma_addr_t update_dma_addr, final_dma_addr;
 static char *ubuf, *fbuf;
 
-static int zynqmp_sha_init_tfm(struct crypto_shash *hash)
+static int zynqmp_sha_complete_batch(struct crypto_engine *engine)
+{
+	struct xilinx_sha_drv_ctx *drv_ctx = dev_get_drvdata(engine->dev);
+	unsigned int i;
+
+	for (i = 0; i < drv_ctx->batch_len; i++)
+		crypto_finalize_hash_request(engine, drv_ctx->batch[i].req,
+					     drv_ctx->batch[i].err);
+	drv_ctx->batch_len = 0;
+
+	return 0;
+}
+
+static int handle_sha_req(struct crypto_engine *engine, void *req)
+{
+	struct ahash_request *areq =
+				container_of(req, struct ahash_request, base);
+	struct xilinx_sha_drv_ctx *drv_ctx = dev_get_drvdata(engine->dev);
+	unsigned int i = drv_ctx->batch_len++;
+
+	/*
+	 * The firmware call is synchronous; completions are deferred until
+	 * the engine queue drains so that queued digests run back to back.
+	 */
+	drv_ctx->batch[i].req = areq;
+	drv_ctx->batch[i].err = drv_ctx->sha_digest(areq);
+
+	if (drv_ctx->batch_len == ZYNQMP_SHA_BATCH_SIZE)
+		zynqmp_sha_complete_batch(engine);
+
+	return 0;
+}
+
+static int zynqmp_sha_init_tfm(struct crypto_ahash *hash)
 {
-	const char *fallback_driver_name = crypto_shash_alg_name(hash);
-	struct zynqmp_sha_tfm_ctx *tfm_ctx = crypto_shash_ctx(hash);
-	struct shash_alg *alg = crypto_shash_alg(hash);
+	const char *fallback_driver_name =
+			crypto_tfm_alg_name(crypto_ahash_tfm(hash));
+	struct zynqmp_sha_tfm_ctx *tfm_ctx = crypto_ahash_ctx(hash);
+	struct xilinx_sha_drv_ctx *drv_ctx = zynqmp_sha_drv_ctx(hash);
 	struct crypto_shash *fallback_tfm;
-	struct xilinx_sha_drv_ctx *drv_ctx;
 
-	drv_ctx = container_of(alg, struct xilinx_sha_drv_ctx, sha3_384);
 	tfm_ctx->dev = drv_ctx->dev;
+	tfm_ctx->engine_ctx.op.do_one_request = handle_sha_req;
+	tfm_ctx->engine_ctx.op.prepare_request = NULL;
+	tfm_ctx->engine_ctx.op.unprepare_request = NULL;
 
 	/* Allocate a fallback and abort if it failed. */
 	fallback_tfm = crypto_alloc_shash(fallback_driver_name, 0,
@@ -68,14 +128,15 @@ static int zynqmp_sha_init_tfm(struct crypto_shash *hash)
 		return PTR_ERR(fallback_tfm);
 
 	tfm_ctx->fbk_tfm = fallback_tfm;
-	hash->descsize += crypto_shash_descsize(tfm_ctx->fbk_tfm);
+	crypto_ahash_set_reqsize(hash, sizeof(struct zynqmp_sha_desc_ctx) +
+				 crypto_shash_descsize(tfm_ctx->fbk_tfm));
 
 	return 0;
 }
 
-static void zynqmp_sha_exit_tfm(struct crypto_shash *hash)
+static void zynqmp_sha_exit_tfm(struct crypto_ahash *hash)
 {
-	struct zynqmp_sha_tfm_ctx *tfm_ctx = crypto_shash_ctx(hash);
+	struct zynqmp_sha_tfm_ctx *tfm_ctx = crypto_ahash_ctx(hash);
 
 	if (tfm_ctx->fbk_tfm) {
 		crypto_free_shash(tfm_ctx->fbk_tfm);
@@ -85,129 +146,225 @@ static void zynqmp_sha_exit_tfm(struct crypto_shash *hash)
 	memzero_explicit(tfm_ctx, sizeof(struct zynqmp_sha_tfm_ctx));
 }
 
-static int zynqmp_sha_init(struct shash_desc *desc)
+static int zynqmp_sha_init(struct ahash_request *req)
 {
-	struct zynqmp_sha_desc_ctx *dctx = shash_desc_ctx(desc);
-	struct zynqmp_sha_tfm_ctx *tctx = crypto_shash_ctx(desc->tfm);
+	struct zynqmp_sha_desc_ctx *dctx = ahash_request_ctx(req);
+	struct zynqmp_sha_tfm_ctx *tctx =
+			crypto_ahash_ctx(crypto_ahash_reqtfm(req));
 
 	dctx->fbk_req.tfm = tctx->fbk_tfm;
 	return crypto_shash_init(&dctx->fbk_req);
 }
 
-static int zynqmp_sha_update(struct shash_desc *desc, const u8 *data, unsigned int length)
+static int zynqmp_sha_update(struct ahash_request *req)
 {
-	struct zynqmp_sha_desc_ctx *dctx = shash_desc_ctx(desc);
+	struct zynqmp_sha_desc_ctx *dctx = ahash_request_ctx(req);
 
-	return crypto_shash_update(&dctx->fbk_req, data, length);
+	return shash_ahash_update(req, &dctx->fbk_req);
 }
 
-static int zynqmp_sha_final(struct shash_desc *desc, u8 *out)
+static int zynqmp_sha_final(struct ahash_request *req)
 {
-	struct zynqmp_sha_desc_ctx *dctx = shash_desc_ctx(desc);
+	struct zynqmp_sha_desc_ctx *dctx = ahash_request_ctx(req);
 
-	return crypto_shash_final(&dctx->fbk_req, out);
+	return crypto_shash_final(&dctx->fbk_req, req->result);
 }
 
-static int zynqmp_sha_finup(struct shash_desc *desc, const u8 *data, unsigned int length, u8 *out)
+static int zynqmp_sha_finup(struct ahash_request *req)
 {
-	struct zynqmp_sha_desc_ctx *dctx = shash_desc_ctx(desc);
+	struct zynqmp_sha_desc_ctx *dctx = ahash_request_ctx(req);
 
-	return crypto_shash_finup(&dctx->fbk_req, data, length, out);
+	return shash_ahash_finup(req, &dctx->fbk_req);
 }
 
-static int zynqmp_sha_import(struct shash_desc *desc, const void *in)
+static int zynqmp_sha_import(struct ahash_request *req, const void *in)
 {
-	struct zynqmp_sha_desc_ctx *dctx = shash_desc_ctx(desc);
-	struct zynqmp_sha_tfm_ctx *tctx = crypto_shash_ctx(desc->tfm);
+	struct zynqmp_sha_desc_ctx *dctx = ahash_request_ctx(req);
+	struct zynqmp_sha_tfm_ctx *tctx =
+			crypto_ahash_ctx(crypto_ahash_reqtfm(req));
 
 	dctx->fbk_req.tfm = tctx->fbk_tfm;
 	return crypto_shash_import(&dctx->fbk_req, in);
 }
 
-static int zynqmp_sha_export(struct shash_desc *desc, void *out)
+static int zynqmp_sha_export(struct ahash_request *req, void *out)
 {
-	struct zynqmp_sha_desc_ctx *dctx = shash_desc_ctx(desc);
+	struct zynqmp_sha_desc_ctx *dctx = ahash_request_ctx(req);
 
 	return crypto_shash_export(&dctx->fbk_req, out);
 }
 
-static int zynqmp_sha_digest(struct shash_desc *desc, const u8 *data, unsigned int len, u8 *out)
+static int zynqmp_sha_digest(struct ahash_request *req)
+{
+	struct xilinx_sha_drv_ctx *drv_ctx =
+			zynqmp_sha_drv_ctx(crypto_ahash_reqtfm(req));
+
+	return crypto_transfer_hash_request_to_engine(drv_ctx->engine, req);
+}
+
+struct zynqmp_sha_walk {
+	int (*update)(u64 addr, u32 size, bool first);
+	unsigned int fill;
+	bool first;
+};
+
+static int zynqmp_sha_walk_update(struct zynqmp_sha_walk *walk, u64 addr,
+				  u32 size)
+{
+	int ret = walk->update(addr, size, walk->first);
+
+	walk->first = false;
+	return ret;
+}
+
+static int zynqmp_sha_walk_flush(struct zynqmp_sha_walk *walk)
+{
+	unsigned int fill = walk->fill;
+
+	if (!fill)
+		return 0;
+
+	walk->fill = 0;
+	flush_icache_range((unsigned long)ubuf, (unsigned long)ubuf + fill);
+	return zynqmp_sha_walk_update(walk, update_dma_addr, fill);
+}
+
+/*
+ * Feed req->src to the engine. Word aligned segments are handed to the
+ * firmware in place; anything else is gathered in ubuf. Every update but
+ * the last one is a whole number of words, as the firmware expects.
+ */
+static int zynqmp_sha_feed(struct ahash_request *req,
+			   struct zynqmp_sha_walk *walk)
+{
+	struct zynqmp_sha_tfm_ctx *tctx =
+			crypto_ahash_ctx(crypto_ahash_reqtfm(req));
+	unsigned int remaining = req->nbytes;
+	unsigned int offset = 0;
+	struct scatterlist *sg;
+	int nents, mapped, i;
+	int ret = 0;
+
+	if (!remaining)
+		return 0;
+
+	nents = sg_nents_for_len(req->src, req->nbytes);
+	if (nents < 0)
+		return nents;
+
+	mapped = dma_map_sg(tctx->dev, req->src, nents, DMA_TO_DEVICE);
+	if (!mapped)
+		return -ENOMEM;
+
+	for_each_sg(req->src, sg, mapped, i) {
+		u64 addr = sg_dma_address(sg);
+		unsigned int len = min(sg_dma_len(sg), remaining);
+
+		while (len && !ret) {
+			unsigned int chunk;
+
+			if (IS_ALIGNED(addr, ZYNQMP_SHA_WORD_LEN) &&
+			    IS_ALIGNED(walk->fill, ZYNQMP_SHA_WORD_LEN) &&
+			    (len >= ZYNQMP_SHA_DIRECT_MIN || len == remaining)) {
+				chunk = len == remaining ? len :
+					round_down(len, ZYNQMP_SHA_WORD_LEN);
+				ret = zynqmp_sha_walk_flush(walk);
+				if (!ret)
+					ret = zynqmp_sha_walk_update(walk, addr,
+								     chunk);
+			} else {
+				chunk = min(len, ZYNQMP_DMA_ALLOC_FIXED_SIZE -
+					    walk->fill);
+				sg_pcopy_to_buffer(req->src, nents,
+						   ubuf + walk->fill, chunk,
+						   offset);
+				walk->fill += chunk;
+				if (walk->fill == ZYNQMP_DMA_ALLOC_FIXED_SIZE ||
+				    chunk == remaining)
+					ret = zynqmp_sha_walk_flush(walk);
+			}
+
+			addr += chunk;
+			len -= chunk;
+			offset += chunk;
+			remaining -= chunk;
+		}
+
+		if (ret || !remaining)
+			break;
+	}
+
+	dma_unmap_sg(tctx->dev, req->src, nents, DMA_TO_DEVICE);
+	memzero_explicit(ubuf, ZYNQMP_DMA_ALLOC_FIXED_SIZE);
+
+	return ret;
+}
+
+static int zynqmp_sha_hw_update(u64 addr, u32 size, bool first)
+{
+	return zynqmp_pm_sha_hash(addr, size, ZYNQMP_SHA3_UPDATE);
+}
+
+static int zynqmp_sha_hw_digest(struct ahash_request *req)
 {
-	unsigned int remaining_len = len;
-	int update_size;
+	struct zynqmp_sha_walk walk = {
+		.update = zynqmp_sha_hw_update,
+		.first = true,
+	};
 	int ret;
 
 	ret = zynqmp_pm_sha_hash(0, 0, ZYNQMP_SHA3_INIT);
 	if (ret)
 		return ret;
 
-	while (remaining_len != 0) {
-		memzero_explicit(ubuf, ZYNQMP_DMA_ALLOC_FIXED_SIZE);
-		if (remaining_len >= ZYNQMP_DMA_ALLOC_FIXED_SIZE) {
-			update_size = ZYNQMP_DMA_ALLOC_FIXED_SIZE;
-			remaining_len -= ZYNQMP_DMA_ALLOC_FIXED_SIZE;
-		} else {
-			update_size = remaining_len;
-			remaining_len = 0;
-		}
-		memcpy(ubuf, data, update_size);
-		flush_icache_range((unsigned long)ubuf, (unsigned long)ubuf + update_size);
-		ret = zynqmp_pm_sha_hash(update_dma_addr, update_size, ZYNQMP_SHA3_UPDATE);
-		if (ret)
-			return ret;
-
-		data += update_size;
-	}
+	ret = zynqmp_sha_feed(req, &walk);
+	if (ret)
+		return ret;
 
 	ret = zynqmp_pm_sha_hash(final_dma_addr, SHA3_384_DIGEST_SIZE, ZYNQMP_SHA3_FINAL);
-	memcpy(out, fbuf, SHA3_384_DIGEST_SIZE);
+	memcpy(req->result, fbuf, SHA3_384_DIGEST_SIZE);
 	memzero_explicit(fbuf, SHA3_384_DIGEST_SIZE);
 
 	return ret;
 }
 
-static int versal_sha_digest(struct shash_desc *desc, const u8 *data,
-			     unsigned int len, u8 *out)
+static int versal_sha_hw_update(u64 addr, u32 size, bool first)
 {
-	int update_size, ret, flag = FIRST_PACKET;
-	unsigned int remaining_len = len;
-
-	while (remaining_len != 0) {
-		memzero_explicit(ubuf, ZYNQMP_DMA_ALLOC_FIXED_SIZE);
-		if (remaining_len >= ZYNQMP_DMA_ALLOC_FIXED_SIZE) {
-			update_size = ZYNQMP_DMA_ALLOC_FIXED_SIZE;
-			remaining_len -= ZYNQMP_DMA_ALLOC_FIXED_SIZE;
-		} else {
-			update_size = remaining_len;
-			remaining_len = 0;
-		}
+	u32 flag = CONTINUE_PACKET;
 
-		memcpy(ubuf, data, update_size);
-		flush_icache_range((unsigned long)ubuf,
-				   (unsigned long)ubuf + update_size);
+	if (first)
+		flag |= FIRST_PACKET;
 
-		flag |= CONTINUE_PACKET;
-		ret = versal_pm_sha_hash(update_dma_addr, 0,
-					 update_size | flag);
-		if (ret)
-			return ret;
+	return versal_pm_sha_hash(addr, 0, size | flag);
+}
 
-		data += update_size;
-		flag = RESET;
-	}
+static int versal_sha_hw_digest(struct ahash_request *req)
+{
+	struct zynqmp_sha_walk walk = {
+		.update = versal_sha_hw_update,
+		.first = true,
+	};
+	int ret, flag = FINAL_PACKET;
+
+	ret = zynqmp_sha_feed(req, &walk);
+	if (ret)
+		return ret;
+
+	if (walk.first)
+		flag |= FIRST_PACKET;
 
-	flag |= FINAL_PACKET;
 	ret = versal_pm_sha_hash(0, final_dma_addr, flag);
 	if (ret)
 		return ret;
 
-	memcpy(out, fbuf, SHA3_384_DIGEST_SIZE);
+	memcpy(req->result, fbuf, SHA3_384_DIGEST_SIZE);
 	memzero_explicit(fbuf, SHA3_384_DIGEST_SIZE);
 
 	return 0;
 }
 
 static struct xilinx_sha_drv_ctx zynqmp_sha3_drv_ctx = {
+	.sha_digest = zynqmp_sha_hw_digest,
 	.sha3_384 = {
 		.init = zynqmp_sha_init,
 		.update = zynqmp_sha_update,
@@ -218,49 +375,54 @@ static struct xilinx_sha_drv_ctx zynqmp_sha3_drv_ctx = {
 		.import = zynqmp_sha_import,
 		.init_tfm = zynqmp_sha_init_tfm,
 		.exit_tfm = zynqmp_sha_exit_tfm,
-		.descsize = sizeof(struct zynqmp_sha_desc_ctx),
-		.statesize = sizeof(struct sha3_state),
-		.digestsize = SHA3_384_DIGEST_SIZE,
-		.base = {
-			.cra_name = "sha3-384",
-			.cra_driver_name = "zynqmp-sha3-384",
-			.cra_priority = 300,
-			.cra_flags = CRYPTO_ALG_KERN_DRIVER_ONLY |
-				     CRYPTO_ALG_ALLOCATES_MEMORY |
-				     CRYPTO_ALG_NEED_FALLBACK,
-			.cra_blocksize = SHA3_384_BLOCK_SIZE,
-			.cra_ctxsize = sizeof(struct zynqmp_sha_tfm_ctx),
-			.cra_alignmask = 3,
-			.cra_module = THIS_MODULE,
+		.halg = {
+			.statesize = sizeof(struct sha3_state),
+			.digestsize = SHA3_384_DIGEST_SIZE,
+			.base = {
+				.cra_name = "sha3-384",
+				.cra_driver_name = "zynqmp-sha3-384",
+				.cra_priority = 300,
+				.cra_flags = CRYPTO_ALG_ASYNC |
+					     CRYPTO_ALG_KERN_DRIVER_ONLY |
+					     CRYPTO_ALG_ALLOCATES_MEMORY |
+					     CRYPTO_ALG_NEED_FALLBACK,
+				.cra_blocksize = SHA3_384_BLOCK_SIZE,
+				.cra_ctxsize = sizeof(struct zynqmp_sha_tfm_ctx),
+				.cra_alignmask = 3,
+				.cra_module = THIS_MODULE,
+			}
 		}
 	}
 };
 
 static struct xilinx_sha_drv_ctx versal_sha3_drv_ctx = {
+	.sha_digest = versal_sha_hw_digest,
 	.sha3_384 = {
 		.init = zynqmp_sha_init,
 		.update = zynqmp_sha_update,
 		.final = zynqmp_sha_final,
 		.finup = zynqmp_sha_finup,
+		.digest = zynqmp_sha_digest,
 		.export = zynqmp_sha_export,
 		.import = zynqmp_sha_import,
-		.digest = versal_sha_digest,
 		.init_tfm = zynqmp_sha_init_tfm,
 		.exit_tfm = zynqmp_sha_exit_tfm,
-		.descsize = sizeof(struct zynqmp_sha_desc_ctx),
-		.statesize = sizeof(struct sha3_state),
-		.digestsize = SHA3_384_DIGEST_SIZE,
-		.base = {
-			.cra_name = "sha3-384",
-			.cra_driver_name = "versal-sha3-384",
-			.cra_priority = 300,
-			.cra_flags = CRYPTO_ALG_KERN_DRIVER_ONLY |
-				CRYPTO_ALG_ALLOCATES_MEMORY |
-				CRYPTO_ALG_NEED_FALLBACK,
-			.cra_blocksize = SHA3_384_BLOCK_SIZE,
-			.cra_ctxsize = sizeof(struct zynqmp_sha_tfm_ctx),
-			.cra_alignmask = 3,
-			.cra_module = THIS_MODULE,
+		.halg = {
+			.statesize = sizeof(struct sha3_state),
+			.digestsize = SHA3_384_DIGEST_SIZE,
+			.base = {
+				.cra_name = "sha3-384",
+				.cra_driver_name = "versal-sha3-384",
+				.cra_priority = 300,
+				.cra_flags = CRYPTO_ALG_ASYNC |
+					     CRYPTO_ALG_KERN_DRIVER_ONLY |
+					     CRYPTO_ALG_ALLOCATES_MEMORY |
+					     CRYPTO_ALG_NEED_FALLBACK,
+				.cra_blocksize = SHA3_384_BLOCK_SIZE,
+				.cra_ctxsize = sizeof(struct zynqmp_sha_tfm_ctx),
+				.cra_alignmask = 3,
+				.cra_module = THIS_MODULE,
+			}
 		}
 	}
 };
@@ -315,13 +477,32 @@ static int zynqmp_sha_probe(struct platform_device *pdev)
 		goto err_mem;
 	}
 
-	err = crypto_register_shash(&sha3_drv_ctx->sha3_384);
-	if (err < 0) {
-		dev_err(dev, "Failed to register shash alg.\n");
+	sha3_drv_ctx->engine =
+		crypto_engine_alloc_init_and_set(dev, true,
+						 zynqmp_sha_complete_batch,
+						 true, ZYNQMP_SHA_QUEUE_LEN);
+	if (!sha3_drv_ctx->engine) {
+		dev_err(dev, "Cannot alloc SHA engine\n");
+		err = -ENOMEM;
 		goto err_mem1;
 	}
+
+	err = crypto_engine_start(sha3_drv_ctx->engine);
+	if (err) {
+		dev_err(dev, "Cannot start SHA engine\n");
+		goto err_engine;
+	}
+
+	err = crypto_register_ahash(&sha3_drv_ctx->sha3_384);
+	if (err < 0) {
+		dev_err(dev, "Failed to register ahash alg.\n");
+		goto err_engine;
+	}
 	return 0;
 
+err_engine:
+	crypto_engine_exit(sha3_drv_ctx->engine);
+
 err_mem1:
 	dma_free_coherent(dev, SHA3_384_DIGEST_SIZE, fbuf, final_dma_addr);
 
@@ -337,11 +518,12 @@ static int zynqmp_sha_remove(struct platform_device *pdev)
 
 	sha3_drv_ctx = platform_get_drvdata(pdev);
 
+	crypto_unregister_ahash(&sha3_drv_ctx->sha3_384);
+	crypto_engine_exit(sha3_drv_ctx->engine);
 	dma_free_coherent(sha3_drv_ctx->dev,
 			  ZYNQMP_DMA_ALLOC_FIXED_SIZE, ubuf, update_dma_addr);
 	dma_free_coherent(sha3_drv_ctx->dev,
 			  SHA3_384_DIGEST_SIZE, fbuf, final_dma_addr);
-	crypto_unregister_shash(&sha3_drv_ctx->sha3_384);
 
 	return 0;
 }
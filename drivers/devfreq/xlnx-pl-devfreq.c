@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Xilinx PL accelerator clock frequency scaling
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ *
+ * Scales the clock of an accelerator in the programmable logic, usually an
+ * output of a Clocking Wizard, between the operating points of its node.
+ * The utilisation comes from a devfreq-event device such as an AXI
+ * Performance Monitor on the accelerator memory port. Without one the
+ * userspace governor is used. The device is also a cooling device, so a
+ * thermal zone can cap the PL clock.
+ */
+
+#include <linux/clk.h>
+#include <linux/devfreq.h>
+#include <linux/devfreq-event.h>
+#include <linux/device.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/pm_opp.h>
+#include <linux/platform_device.h>
+
+#define XLNX_PL_DEVFREQ_POLL_MS	50
+
+/**
+ * struct xlnx_pl_devfreq - PL clock scaling private data
+ * @profile: devfreq profile
+ * @devfreq: devfreq device
+ * @edev: devfreq-event device giving the utilisation, or NULL
+ * @clk: accelerator clock
+ */
+struct xlnx_pl_devfreq {
+	struct devfreq_dev_profile profile;
+	struct devfreq *devfreq;
+	struct devfreq_event_dev *edev;
+	struct clk *clk;
+};
+
+static int xlnx_pl_devfreq_target(struct device *dev, unsigned long *freq,
+				  u32 flags)
+{
+	struct xlnx_pl_devfreq *priv = dev_get_drvdata(dev);
+	struct dev_pm_opp *new_opp;
+	int ret;
+
+	new_opp = devfreq_recommended_opp(dev, freq, flags);
+	if (IS_ERR(new_opp)) {
+		ret = PTR_ERR(new_opp);
+		dev_err(dev, "failed to get recommended opp: %d\n", ret);
+		return ret;
+	}
+	dev_pm_opp_put(new_opp);
+
+	if (*freq == clk_get_rate(priv->clk))
+		return 0;
+
+	return clk_set_rate(priv->clk, *freq);
+}
+
+static int xlnx_pl_devfreq_get_dev_status(struct device *dev,
+					  struct devfreq_dev_status *stat)
+{
+	struct xlnx_pl_devfreq *priv = dev_get_drvdata(dev);
+	struct devfreq_event_data edata;
+	int ret;
+
+	stat->current_frequency = clk_get_rate(priv->clk);
+	stat->busy_time = 0;
+	stat->total_time = 0;
+	if (!priv->edev)
+		return 0;
+
+	ret = devfreq_event_get_event(priv->edev, &edata);
+	if (ret < 0) {
+		dev_err(dev, "failed to get the utilisation: %d\n", ret);
+		return ret;
+	}
+
+	stat->busy_time = edata.load_count;
+	stat->total_time = edata.total_count;
+
+	return devfreq_event_set_event(priv->edev);
+}
+
+static int xlnx_pl_devfreq_get_cur_freq(struct device *dev,
+					unsigned long *freq)
+{
+	struct xlnx_pl_devfreq *priv = dev_get_drvdata(dev);
+
+	*freq = clk_get_rate(priv->clk);
+
+	return 0;
+}
+
+static void xlnx_pl_devfreq_exit(struct device *dev)
+{
+	struct xlnx_pl_devfreq *priv = dev_get_drvdata(dev);
+
+	if (priv->edev)
+		devfreq_event_disable_edev(priv->edev);
+	dev_pm_opp_of_remove_table(dev);
+}
+
+/*
+ * Rounding the rate of every operating point up front lets the clock
+ * provider precompute its dividers, the Clocking Wizard then only has to
+ * program them on a change.
+ */
+static void xlnx_pl_devfreq_prepare_opps(struct device *dev,
+					 struct xlnx_pl_devfreq *priv)
+{
+	struct dev_pm_opp *opp;
+	unsigned long freq;
+	long rate;
+
+	for (freq = 0; ; freq++) {
+		opp = dev_pm_opp_find_freq_ceil(dev, &freq);
+		if (IS_ERR(opp))
+			break;
+		dev_pm_opp_put(opp);
+
+		rate = clk_round_rate(priv->clk, freq);
+		if (rate != freq)
+			dev_warn(dev, "%lu Hz is rounded to %ld Hz\n", freq,
+				 rate);
+	}
+}
+
+static int xlnx_pl_devfreq_probe(struct platform_device *pdev)
+{
+	struct device *dev = &pdev->dev;
+	struct xlnx_pl_devfreq *priv;
+	const char *gov = DEVFREQ_GOV_USERSPACE;
+	int ret;
+
+	priv = devm_kzalloc(dev, sizeof(*priv), GFP_KERNEL);
+	if (!priv)
+		return -ENOMEM;
+	platform_set_drvdata(pdev, priv);
+
+	priv->clk = devm_clk_get(dev, NULL);
+	if (IS_ERR(priv->clk))
+		return dev_err_probe(dev, PTR_ERR(priv->clk),
+				     "failed to get the clock\n");
+
+	if (devfreq_event_get_edev_count(dev, "devfreq-events") > 0) {
+		priv->edev = devfreq_event_get_edev_by_phandle(dev,
+							       "devfreq-events",
+							       0);
+		if (IS_ERR(priv->edev))
+			return dev_err_probe(dev, PTR_ERR(priv->edev),
+					     "failed to get devfreq-event\n");
+		gov = DEVFREQ_GOV_SIMPLE_ONDEMAND;
+	}
+
+	ret = dev_pm_opp_of_add_table(dev);
+	if (ret < 0) {
+		dev_err(dev, "failed to get OPP table\n");
+		return ret;
+	}
+	xlnx_pl_devfreq_prepare_opps(dev, priv);
+
+	if (priv->edev) {
+		ret = devfreq_event_enable_edev(priv->edev);
+		if (!ret)
+			ret = devfreq_event_set_event(priv->edev);
+		if (ret < 0) {
+			dev_err(dev, "failed to start devfreq-event\n");
+			goto err_opp;
+		}
+	}
+
+	priv->profile.target = xlnx_pl_devfreq_target;
+	priv->profile.get_dev_status = xlnx_pl_devfreq_get_dev_status;
+	priv->profile.get_cur_freq = xlnx_pl_devfreq_get_cur_freq;
+	priv->profile.exit = xlnx_pl_devfreq_exit;
+	priv->profile.initial_freq = clk_get_rate(priv->clk);
+	priv->profile.polling_ms = XLNX_PL_DEVFREQ_POLL_MS;
+	priv->profile.is_cooling_device = true;
+
+	priv->devfreq = devm_devfreq_add_device(dev, &priv->profile, gov,
+						NULL);
+	if (IS_ERR(priv->devfreq)) {
+		ret = PTR_ERR(priv->devfreq);
+		dev_err(dev, "failed to add devfreq device: %d\n", ret);
+		goto err_edev;
+	}
+
+	return 0;
+
+err_edev:
+	if (priv->edev)
+		devfreq_event_disable_edev(priv->edev);
+err_opp:
+	dev_pm_opp_of_remove_table(dev);
+	return ret;
+}
+
+static const struct of_device_id xlnx_pl_devfreq_of_match[] = {
+	{ .compatible = "xlnx,pl-devfreq", },
+	{ /* sentinel */ },
+};
+MODULE_DEVICE_TABLE(of, xlnx_pl_devfreq_of_match);
+
+static struct platform_driver xlnx_pl_devfreq_driver = {
+	.probe		= xlnx_pl_devfreq_probe,
+	.driver = {
+		.name	= "xlnx-pl-devfreq",
+		.of_match_table = xlnx_pl_devfreq_of_match,
+	},
+};
+module_platform_driver(xlnx_pl_devfreq_driver);
+
+MODULE_DESCRIPTION("Xilinx PL accelerator clock frequency scaling driver");
+MODULE_LICENSE("GPL");
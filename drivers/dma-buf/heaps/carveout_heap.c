@@ -0,0 +1,445 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * DMABUF carveout heap exporter
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ *
+ * Exports the reserved-memory regions compatible with "dma-heap-carveout",
+ * for instance DDR attached to the PL, as dma-buf heaps. Each region gives a
+ * cached heap named after the region node, and an uncached one with the
+ * "-uncached" suffix, both allocating from the same bitmap of pages.
+ *
+ * The regions must be "no-map". They have no struct pages and no linear
+ * mapping, so the buffers are mapped for the devices with dma_map_resource()
+ * and the caches of the cached heap are maintained by the heap itself.
+ */
+#include <linux/dma-buf.h>
+#include <linux/dma-heap.h>
+#include <linux/dma-map-ops.h>
+#include <linux/dma-mapping.h>
+#include <linux/err.h>
+#include <linux/genalloc.h>
+#include <linux/io.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/of_fdt.h>
+#include <linux/of_reserved_mem.h>
+#include <linux/scatterlist.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+
+#define CARVEOUT_HEAP_MAX_REGIONS	8
+
+static struct reserved_mem *carveout_regions[CARVEOUT_HEAP_MAX_REGIONS];
+static unsigned int carveout_num_regions;
+
+struct carveout_heap {
+	struct dma_heap *heap;
+	struct gen_pool *pool;
+	bool cached;
+};
+
+struct carveout_heap_buffer {
+	struct carveout_heap *heap;
+	struct list_head attachments;
+	struct mutex lock;
+	unsigned long len;
+	phys_addr_t paddr;
+	int vmap_cnt;
+	void *vaddr;
+};
+
+struct dma_heap_attachment {
+	struct device *dev;
+	struct sg_table table;
+	struct list_head list;
+	bool mapped;
+};
+
+static int carveout_heap_attach(struct dma_buf *dmabuf,
+				struct dma_buf_attachment *attachment)
+{
+	struct carveout_heap_buffer *buffer = dmabuf->priv;
+	struct dma_heap_attachment *a;
+	int ret;
+
+	a = kzalloc(sizeof(*a), GFP_KERNEL);
+	if (!a)
+		return -ENOMEM;
+
+	/* The single entry only carries the DMA address, there is no page */
+	ret = sg_alloc_table(&a->table, 1, GFP_KERNEL);
+	if (ret) {
+		kfree(a);
+		return ret;
+	}
+
+	a->dev = attachment->dev;
+	INIT_LIST_HEAD(&a->list);
+	a->mapped = false;
+
+	attachment->priv = a;
+
+	mutex_lock(&buffer->lock);
+	list_add(&a->list, &buffer->attachments);
+	mutex_unlock(&buffer->lock);
+
+	return 0;
+}
+
+static void carveout_heap_detach(struct dma_buf *dmabuf,
+				 struct dma_buf_attachment *attachment)
+{
+	struct carveout_heap_buffer *buffer = dmabuf->priv;
+	struct dma_heap_attachment *a = attachment->priv;
+
+	mutex_lock(&buffer->lock);
+	list_del(&a->list);
+	mutex_unlock(&buffer->lock);
+
+	sg_free_table(&a->table);
+	kfree(a);
+}
+
+static struct sg_table *
+carveout_heap_map_dma_buf(struct dma_buf_attachment *attachment,
+			  enum dma_data_direction direction)
+{
+	struct carveout_heap_buffer *buffer = attachment->dmabuf->priv;
+	struct dma_heap_attachment *a = attachment->priv;
+	struct sg_table *table = &a->table;
+	dma_addr_t addr;
+
+	addr = dma_map_resource(attachment->dev, buffer->paddr, buffer->len,
+				direction, DMA_ATTR_SKIP_CPU_SYNC);
+	if (dma_mapping_error(attachment->dev, addr))
+		return ERR_PTR(-ENOMEM);
+
+	if (buffer->heap->cached)
+		arch_sync_dma_for_device(buffer->paddr, buffer->len, direction);
+
+	sg_dma_address(table->sgl) = addr;
+	sg_dma_len(table->sgl) = buffer->len;
+	a->mapped = true;
+	return table;
+}
+
+static void carveout_heap_unmap_dma_buf(struct dma_buf_attachment *attachment,
+					struct sg_table *table,
+					enum dma_data_direction direction)
+{
+	struct carveout_heap_buffer *buffer = attachment->dmabuf->priv;
+	struct dma_heap_attachment *a = attachment->priv;
+
+	a->mapped = false;
+	if (buffer->heap->cached)
+		arch_sync_dma_for_cpu(buffer->paddr, buffer->len, direction);
+	dma_unmap_resource(attachment->dev, sg_dma_address(table->sgl),
+			   buffer->len, direction, DMA_ATTR_SKIP_CPU_SYNC);
+}
+
+static int
+carveout_heap_dma_buf_begin_cpu_access(struct dma_buf *dmabuf,
+				       enum dma_data_direction direction)
+{
+	struct carveout_heap_buffer *buffer = dmabuf->priv;
+
+	/* The same cache lines back the kernel and the user mappings */
+	if (buffer->heap->cached)
+		arch_sync_dma_for_cpu(buffer->paddr, buffer->len, direction);
+
+	return 0;
+}
+
+static int
+carveout_heap_dma_buf_end_cpu_access(struct dma_buf *dmabuf,
+				     enum dma_data_direction direction)
+{
+	struct carveout_heap_buffer *buffer = dmabuf->priv;
+
+	if (buffer->heap->cached)
+		arch_sync_dma_for_device(buffer->paddr, buffer->len, direction);
+
+	return 0;
+}
+
+static int carveout_heap_mmap(struct dma_buf *dmabuf,
+			      struct vm_area_struct *vma)
+{
+	struct carveout_heap_buffer *buffer = dmabuf->priv;
+	unsigned long size = vma->vm_end - vma->vm_start;
+
+	if ((vma->vm_flags & (VM_SHARED | VM_MAYSHARE)) == 0)
+		return -EINVAL;
+
+	if (vma->vm_pgoff + PHYS_PFN(size) > PHYS_PFN(buffer->len))
+		return -EINVAL;
+
+	if (!buffer->heap->cached)
+		vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+
+	return remap_pfn_range(vma, vma->vm_start,
+			       PHYS_PFN(buffer->paddr) + vma->vm_pgoff, size,
+			       vma->vm_page_prot);
+}
+
+static void *carveout_heap_do_vmap(struct carveout_heap_buffer *buffer)
+{
+	void *vaddr;
+
+	vaddr = memremap(buffer->paddr, buffer->len,
+			 buffer->heap->cached ? MEMREMAP_WB : MEMREMAP_WC);
+	if (!vaddr)
+		return ERR_PTR(-ENOMEM);
+
+	return vaddr;
+}
+
+static int carveout_heap_vmap(struct dma_buf *dmabuf, struct iosys_map *map)
+{
+	struct carveout_heap_buffer *buffer = dmabuf->priv;
+	void *vaddr;
+	int ret = 0;
+
+	mutex_lock(&buffer->lock);
+	if (buffer->vmap_cnt) {
+		buffer->vmap_cnt++;
+		iosys_map_set_vaddr(map, buffer->vaddr);
+		goto out;
+	}
+
+	vaddr = carveout_heap_do_vmap(buffer);
+	if (IS_ERR(vaddr)) {
+		ret = PTR_ERR(vaddr);
+		goto out;
+	}
+	buffer->vaddr = vaddr;
+	buffer->vmap_cnt++;
+	iosys_map_set_vaddr(map, buffer->vaddr);
+out:
+	mutex_unlock(&buffer->lock);
+
+	return ret;
+}
+
+static void carveout_heap_vunmap(struct dma_buf *dmabuf,
+				 struct iosys_map *map)
+{
+	struct carveout_heap_buffer *buffer = dmabuf->priv;
+
+	mutex_lock(&buffer->lock);
+	if (!--buffer->vmap_cnt) {
+		memunmap(buffer->vaddr);
+		buffer->vaddr = NULL;
+	}
+	mutex_unlock(&buffer->lock);
+	iosys_map_clear(map);
+}
+
+static void carveout_heap_free(struct carveout_heap *heap, phys_addr_t paddr,
+			       unsigned long len)
+{
+	/* Drop the lines of a cached buffer before the pages are reused */
+	if (heap->cached)
+		arch_sync_dma_for_cpu(paddr, len, DMA_FROM_DEVICE);
+	gen_pool_free(heap->pool, paddr, len);
+}
+
+static void carveout_heap_dma_buf_release(struct dma_buf *dmabuf)
+{
+	struct carveout_heap_buffer *buffer = dmabuf->priv;
+
+	if (buffer->vmap_cnt > 0) {
+		WARN(1, "%s: buffer still mapped in the kernel\n", __func__);
+		memunmap(buffer->vaddr);
+		buffer->vaddr = NULL;
+	}
+
+	carveout_heap_free(buffer->heap, buffer->paddr, buffer->len);
+	kfree(buffer);
+}
+
+static const struct dma_buf_ops carveout_heap_buf_ops = {
+	.attach = carveout_heap_attach,
+	.detach = carveout_heap_detach,
+	.map_dma_buf = carveout_heap_map_dma_buf,
+	.unmap_dma_buf = carveout_heap_unmap_dma_buf,
+	.begin_cpu_access = carveout_heap_dma_buf_begin_cpu_access,
+	.end_cpu_access = carveout_heap_dma_buf_end_cpu_access,
+	.mmap = carveout_heap_mmap,
+	.vmap = carveout_heap_vmap,
+	.vunmap = carveout_heap_vunmap,
+	.release = carveout_heap_dma_buf_release,
+};
+
+static struct dma_buf *carveout_heap_allocate(struct dma_heap *heap,
+					      unsigned long len,
+					      unsigned long fd_flags,
+					      unsigned long heap_flags)
+{
+	struct carveout_heap *carveout_heap = dma_heap_get_drvdata(heap);
+	struct carveout_heap_buffer *buffer;
+	DEFINE_DMA_BUF_EXPORT_INFO(exp_info);
+	size_t size = PAGE_ALIGN(len);
+	struct dma_buf *dmabuf;
+	void *vaddr;
+	int ret = -ENOMEM;
+
+	buffer = kzalloc(sizeof(*buffer), GFP_KERNEL);
+	if (!buffer)
+		return ERR_PTR(-ENOMEM);
+
+	INIT_LIST_HEAD(&buffer->attachments);
+	mutex_init(&buffer->lock);
+	buffer->heap = carveout_heap;
+	buffer->len = size;
+
+	buffer->paddr = gen_pool_alloc(carveout_heap->pool, size);
+	if (!buffer->paddr)
+		goto free_buffer;
+
+	/* Clear the buffer through the mapping type of the heap */
+	vaddr = carveout_heap_do_vmap(buffer);
+	if (IS_ERR(vaddr)) {
+		ret = PTR_ERR(vaddr);
+		goto free_pool;
+	}
+	memset(vaddr, 0, size);
+	memunmap(vaddr);
+	if (carveout_heap->cached)
+		arch_sync_dma_for_device(buffer->paddr, size, DMA_TO_DEVICE);
+
+	/* create the dmabuf */
+	exp_info.exp_name = dma_heap_get_name(heap);
+	exp_info.ops = &carveout_heap_buf_ops;
+	exp_info.size = buffer->len;
+	exp_info.flags = fd_flags;
+	exp_info.priv = buffer;
+	dmabuf = dma_buf_export(&exp_info);
+	if (IS_ERR(dmabuf)) {
+		ret = PTR_ERR(dmabuf);
+		goto free_pool;
+	}
+	return dmabuf;
+
+free_pool:
+	carveout_heap_free(carveout_heap, buffer->paddr, size);
+free_buffer:
+	kfree(buffer);
+
+	return ERR_PTR(ret);
+}
+
+static const struct dma_heap_ops carveout_heap_ops = {
+	.allocate = carveout_heap_allocate,
+};
+
+static int __add_carveout_heap(struct gen_pool *pool, const char *name,
+			       bool cached)
+{
+	struct carveout_heap *carveout_heap;
+	struct dma_heap_export_info exp_info;
+
+	carveout_heap = kzalloc(sizeof(*carveout_heap), GFP_KERNEL);
+	if (!carveout_heap)
+		return -ENOMEM;
+	carveout_heap->pool = pool;
+	carveout_heap->cached = cached;
+
+	exp_info.name = name;
+	exp_info.ops = &carveout_heap_ops;
+	exp_info.priv = carveout_heap;
+
+	carveout_heap->heap = dma_heap_add(&exp_info);
+	if (IS_ERR(carveout_heap->heap)) {
+		int ret = PTR_ERR(carveout_heap->heap);
+
+		kfree(carveout_heap);
+		return ret;
+	}
+
+	return 0;
+}
+
+static int add_carveout_heap(struct reserved_mem *rmem)
+{
+	struct gen_pool *pool;
+	char *name, *uncached;
+	int ret;
+
+	pool = gen_pool_create(PAGE_SHIFT, NUMA_NO_NODE);
+	if (!pool)
+		return -ENOMEM;
+
+	ret = gen_pool_add(pool, rmem->base, rmem->size, NUMA_NO_NODE);
+	if (ret)
+		goto destroy_pool;
+
+	/* Heaps are named after the node, without the unit address */
+	ret = -ENOMEM;
+	name = kstrndup(rmem->name, strcspn(rmem->name, "@"), GFP_KERNEL);
+	if (!name)
+		goto destroy_pool;
+	uncached = kasprintf(GFP_KERNEL, "%s-uncached", name);
+	if (!uncached)
+		goto free_name;
+
+	ret = __add_carveout_heap(pool, name, true);
+	if (ret)
+		goto free_uncached;
+
+	/* dma_heap_add() can't be undone, keep the cached heap anyway */
+	ret = __add_carveout_heap(pool, uncached, false);
+	if (ret)
+		pr_err("%s: failed to add %s heap: %d\n", __func__, uncached,
+		       ret);
+
+	return 0;
+
+free_uncached:
+	kfree(uncached);
+free_name:
+	kfree(name);
+destroy_pool:
+	gen_pool_destroy(pool);
+	return ret;
+}
+
+static int add_carveout_heaps(void)
+{
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < carveout_num_regions; i++) {
+		ret = add_carveout_heap(carveout_regions[i]);
+		if (ret)
+			pr_err("%s: failed to add heap for %s: %d\n", __func__,
+			       carveout_regions[i]->name, ret);
+	}
+
+	return 0;
+}
+module_init(add_carveout_heaps);
+
+static int __init carveout_heap_rmem_init(struct reserved_mem *rmem)
+{
+	if (!of_get_flat_dt_prop(rmem->fdt_node, "no-map", NULL)) {
+		pr_err("%s: %s must be no-map\n", __func__, rmem->name);
+		return -EINVAL;
+	}
+
+	if (carveout_num_regions == CARVEOUT_HEAP_MAX_REGIONS) {
+		pr_err("%s: too many regions, %s is ignored\n", __func__,
+		       rmem->name);
+		return -ENOSPC;
+	}
+
+	carveout_regions[carveout_num_regions++] = rmem;
+
+	return 0;
+}
+RESERVEDMEM_OF_DECLARE(carveout_heap, "dma-heap-carveout",
+		       carveout_heap_rmem_init);
+
+MODULE_DESCRIPTION("DMA-BUF Carveout Heap");
+MODULE_LICENSE("GPL v2");
@@ -10,9 +10,11 @@
  *	Andrew F. Davis <afd@ti.com>
  */
 #include <linux/cma.h>
+#include <linux/completion.h>
 #include <linux/dma-buf.h>
 #include <linux/dma-heap.h>
 #include <linux/dma-map-ops.h>
+#include <linux/dmaengine.h>
 #include <linux/err.h>
 #include <linux/highmem.h>
 #include <linux/io.h>
@@ -22,6 +24,10 @@
 #include <linux/slab.h>
 #include <linux/vmalloc.h>
 
+static unsigned long dma_clear_min;
+module_param(dma_clear_min, ulong, 0644);
+MODULE_PARM_DESC(dma_clear_min,
+		 "Minimum size in bytes of the buffers cleared by DMA (0 = off)");
 
 struct cma_heap {
 	struct dma_heap *heap;
@@ -273,6 +279,60 @@ static const struct dma_buf_ops cma_heap_buf_ops = {
 	.release = cma_heap_dma_buf_release,
 };
 
+static void cma_heap_dma_clear_done(void *param)
+{
+	complete(param);
+}
+
+/*
+ * Clear the buffer with a DMA engine supporting memset, which doesn't stall
+ * the CPU on large buffers. Returns non zero if the buffer has to be cleared
+ * by the CPU instead.
+ */
+static int cma_heap_dma_clear(struct page *pages, size_t size)
+{
+	DECLARE_COMPLETION_ONSTACK(done);
+	struct dma_async_tx_descriptor *tx;
+	struct dma_chan *chan;
+	dma_cap_mask_t mask;
+	struct device *dev;
+	dma_addr_t addr;
+	int ret = -EIO;
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_MEMSET, mask);
+	chan = dma_request_channel(mask, NULL, NULL);
+	if (!chan)
+		return -ENODEV;
+
+	dev = chan->device->dev;
+	addr = dma_map_page(dev, pages, 0, size, DMA_FROM_DEVICE);
+	if (dma_mapping_error(dev, addr))
+		goto release;
+
+	tx = dmaengine_prep_dma_memset(chan, addr, 0, size,
+				       DMA_PREP_INTERRUPT);
+	if (!tx)
+		goto unmap;
+
+	tx->callback = cma_heap_dma_clear_done;
+	tx->callback_param = &done;
+	if (dma_submit_error(dmaengine_submit(tx)))
+		goto unmap;
+
+	dma_async_issue_pending(chan);
+	if (wait_for_completion_timeout(&done, msecs_to_jiffies(1000)))
+		ret = 0;
+	else
+		dmaengine_terminate_sync(chan);
+
+unmap:
+	dma_unmap_page(dev, addr, size, DMA_FROM_DEVICE);
+release:
+	dma_release_channel(chan);
+	return ret;
+}
+
 static struct dma_buf *cma_heap_allocate(struct dma_heap *heap,
 					 unsigned long len,
 					 unsigned long fd_flags,
@@ -305,7 +365,10 @@ static struct dma_buf *cma_heap_allocate(struct dma_heap *heap,
 		goto free_buffer;
 
 	/* Clear the cma pages */
-	if (PageHighMem(cma_pages)) {
+	if (dma_clear_min && size >= dma_clear_min &&
+	    !cma_heap_dma_clear(cma_pages, size)) {
+		/* Cleared by the DMA engine */
+	} else if (PageHighMem(cma_pages)) {
 		unsigned long nr_clear_pages = pagecount;
 		struct page *page = cma_pages;
 
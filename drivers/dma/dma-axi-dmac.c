@@ -12,6 +12,7 @@
 #include <linux/dma-mapping.h>
 #include <linux/dmaengine.h>
 #include <linux/err.h>
+#include <linux/hrtimer.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/kernel.h>
@@ -84,9 +85,12 @@
 #define AXI_DMAC_REG_DBG2		0x444
 #define AXI_DMAC_REG_PARTIAL_XFER_LEN	0x44c
 #define AXI_DMAC_REG_PARTIAL_XFER_ID	0x450
+#define AXI_DMAC_REG_SG_ADDRESS		0x47c
+#define AXI_DMAC_REG_SG_ADDRESS_HIGH	0x4bc
 
 #define AXI_DMAC_CTRL_ENABLE		BIT(0)
 #define AXI_DMAC_CTRL_PAUSE		BIT(1)
+#define AXI_DMAC_CTRL_ENABLE_SG		BIT(2)
 
 #define AXI_DMAC_IRQ_SOT		BIT(0)
 #define AXI_DMAC_IRQ_EOT		BIT(1)
@@ -97,9 +101,40 @@
 
 #define AXI_DMAC_FLAG_PARTIAL_XFER_DONE BIT(31)
 
+#define AXI_DMAC_HW_FLAG_LAST		BIT(0)
+#define AXI_DMAC_HW_FLAG_IRQ		BIT(1)
+
 /* The maximum ID allocated by the hardware is 31 */
 #define AXI_DMAC_SG_UNUSED 32U
 
+static unsigned int irq_coalesce = 1;
+module_param(irq_coalesce, uint, 0644);
+MODULE_PARM_DESC(irq_coalesce,
+		 "Descriptors completed per interrupt in SG mode (default: 1)");
+
+static unsigned int irq_coalesce_usecs = 100;
+module_param(irq_coalesce_usecs, uint, 0644);
+MODULE_PARM_DESC(irq_coalesce_usecs,
+		 "Coalesced completion delay in us, 0 disables (default: 100)");
+
+/*
+ * In-memory descriptor fetched by the core in scatter-gather mode. The layout
+ * mirrors the transfer registers, lengths are minus one like the register
+ * values, and the core follows @next_sg_addr until it sees the LAST flag.
+ */
+struct axi_dmac_hw_desc {
+	u32 flags;
+	u32 id;
+	u64 dest_addr;
+	u64 src_addr;
+	u64 next_sg_addr;
+	u32 y_len;
+	u32 x_len;
+	u32 src_stride;
+	u32 dst_stride;
+	u64 __pad[2];
+};
+
 struct axi_dmac_sg {
 	dma_addr_t src_addr;
 	dma_addr_t dest_addr;
@@ -120,6 +155,11 @@ struct axi_dmac_desc {
 	unsigned int num_submitted;
 	unsigned int num_completed;
 	unsigned int num_sgs;
+
+	struct axi_dmac_hw_desc *hw;
+	dma_addr_t hw_phys;
+	size_t hw_size;
+
 	struct axi_dmac_sg sg[];
 };
 
@@ -142,6 +182,10 @@ struct axi_dmac_chan {
 	bool hw_partial_xfer;
 	bool hw_cyclic;
 	bool hw_2d;
+	bool hw_sg;
+
+	unsigned int num_coalesced;
+	struct hrtimer coalesce_timer;
 };
 
 struct axi_dmac {
@@ -207,6 +251,54 @@ static bool axi_dmac_check_addr(struct axi_dmac_chan *chan, dma_addr_t addr)
 	return true;
 }
 
+/*
+ * Only every irq_coalesce-th chain interrupts on completion, with the chains
+ * in between reaped by the next interrupt or by the coalescing timer. The last
+ * issued chain always interrupts, so a stream never stalls waiting on the
+ * timer, and the timer bounds the completion latency of the others.
+ */
+static void axi_dmac_coalesce_hw_sg(struct axi_dmac_chan *chan,
+	struct axi_dmac_desc *desc)
+{
+	struct axi_dmac_hw_desc *hw = &desc->hw[desc->num_sgs - 1];
+	unsigned int usecs = READ_ONCE(irq_coalesce_usecs);
+
+	if (usecs && ++chan->num_coalesced < READ_ONCE(irq_coalesce) &&
+	    !list_empty(&chan->vchan.desc_issued)) {
+		hw->flags &= ~AXI_DMAC_HW_FLAG_IRQ;
+		if (!hrtimer_active(&chan->coalesce_timer))
+			hrtimer_start(&chan->coalesce_timer,
+				      ns_to_ktime(usecs * NSEC_PER_USEC),
+				      HRTIMER_MODE_REL);
+	} else {
+		hw->flags |= AXI_DMAC_HW_FLAG_IRQ;
+		chan->num_coalesced = 0;
+	}
+}
+
+static void axi_dmac_start_hw_sg(struct axi_dmac_chan *chan,
+	struct axi_dmac_desc *desc)
+{
+	struct axi_dmac *dmac = chan_to_axi_dmac(chan);
+	unsigned int i;
+
+	/*
+	 * A cyclic chain loops back onto itself in memory, so without a
+	 * callback to call there is no reason to interrupt at period ends.
+	 */
+	if (desc->cyclic && !desc->vdesc.tx.callback) {
+		for (i = 0; i < desc->num_sgs; i++)
+			desc->hw[i].flags &= ~AXI_DMAC_HW_FLAG_IRQ;
+	} else if (!desc->cyclic) {
+		axi_dmac_coalesce_hw_sg(chan, desc);
+	}
+
+	axi_dmac_write(dmac, AXI_DMAC_REG_SG_ADDRESS,
+		lower_32_bits(desc->hw_phys));
+	axi_dmac_write(dmac, AXI_DMAC_REG_SG_ADDRESS_HIGH,
+		upper_32_bits(desc->hw_phys));
+}
+
 static void axi_dmac_start_transfer(struct axi_dmac_chan *chan)
 {
 	struct axi_dmac *dmac = chan_to_axi_dmac(chan);
@@ -237,20 +329,34 @@ static void axi_dmac_start_transfer(struct axi_dmac_chan *chan)
 		return;
 	}
 
-	desc->num_submitted++;
-	if (desc->num_submitted == desc->num_sgs ||
-	    desc->have_partial_xfer) {
-		if (desc->cyclic)
-			desc->num_submitted = 0; /* Start again */
-		else
-			chan->next_desc = NULL;
+	if (chan->hw_sg) {
+		/* The whole chain is handed to the core in one go */
+		desc->num_submitted = desc->num_sgs;
+		chan->next_desc = NULL;
 		flags |= AXI_DMAC_FLAG_LAST;
 	} else {
-		chan->next_desc = desc;
+		desc->num_submitted++;
+		if (desc->num_submitted == desc->num_sgs ||
+		    desc->have_partial_xfer) {
+			if (desc->cyclic)
+				desc->num_submitted = 0; /* Start again */
+			else
+				chan->next_desc = NULL;
+			flags |= AXI_DMAC_FLAG_LAST;
+		} else {
+			chan->next_desc = desc;
+		}
 	}
 
 	sg->id = axi_dmac_read(dmac, AXI_DMAC_REG_TRANSFER_ID);
 
+	if (chan->hw_sg) {
+		axi_dmac_start_hw_sg(chan, desc);
+		axi_dmac_write(dmac, AXI_DMAC_REG_FLAGS, flags);
+		axi_dmac_write(dmac, AXI_DMAC_REG_START_TRANSFER, 1);
+		return;
+	}
+
 	if (axi_dmac_dest_is_mem(chan)) {
 		axi_dmac_write(dmac, AXI_DMAC_REG_DEST_ADDRESS, sg->dest_addr);
 		axi_dmac_write(dmac, AXI_DMAC_REG_DEST_STRIDE, sg->dest_stride);
@@ -362,6 +468,41 @@ static void axi_dmac_compute_residue(struct axi_dmac_chan *chan,
 	}
 }
 
+/*
+ * In scatter-gather mode a descriptor chain is a single transfer for the core,
+ * identified by the ID of its first segment. Cyclic chains never complete and
+ * only interrupt at the end of each period.
+ */
+static bool axi_dmac_hw_sg_transfer_done(struct axi_dmac_chan *chan,
+	struct axi_dmac_desc *active, unsigned int completed_transfers)
+{
+	struct axi_dmac_sg *sg;
+	bool start_next = false;
+
+	do {
+		if (active->cyclic) {
+			vchan_cyclic_callback(&active->vdesc);
+			break;
+		}
+
+		sg = &active->sg[0];
+		if (sg->id == AXI_DMAC_SG_UNUSED) /* Not yet submitted */
+			break;
+		if (!(BIT(sg->id) & completed_transfers))
+			break;
+
+		sg->id = AXI_DMAC_SG_UNUSED;
+		active->num_completed = active->num_sgs;
+		list_del(&active->vdesc.node);
+		vchan_cookie_complete(&active->vdesc);
+		active = axi_dmac_active_desc(chan);
+		/* A slot in the transfer queue has become available */
+		start_next = true;
+	} while (active);
+
+	return start_next;
+}
+
 static bool axi_dmac_transfer_done(struct axi_dmac_chan *chan,
 	unsigned int completed_transfers)
 {
@@ -373,6 +514,10 @@ static bool axi_dmac_transfer_done(struct axi_dmac_chan *chan,
 	if (!active)
 		return false;
 
+	if (chan->hw_sg)
+		return axi_dmac_hw_sg_transfer_done(chan, active,
+			completed_transfers);
+
 	if (chan->hw_partial_xfer &&
 	    (completed_transfers & AXI_DMAC_FLAG_PARTIAL_XFER_DONE))
 		axi_dmac_dequeue_partial_xfers(chan);
@@ -439,6 +584,43 @@ static irqreturn_t axi_dmac_interrupt_handler(int irq, void *devid)
 	return IRQ_HANDLED;
 }
 
+static bool axi_dmac_has_coalesced(struct axi_dmac_chan *chan)
+{
+	struct axi_dmac_desc *desc;
+
+	list_for_each_entry(desc, &chan->active_descs, vdesc.node) {
+		if (!desc->cyclic &&
+		    !(desc->hw[desc->num_sgs - 1].flags & AXI_DMAC_HW_FLAG_IRQ))
+			return true;
+	}
+
+	return false;
+}
+
+static enum hrtimer_restart axi_dmac_coalesce_timer(struct hrtimer *timer)
+{
+	struct axi_dmac_chan *chan = container_of(timer, struct axi_dmac_chan,
+		coalesce_timer);
+	struct axi_dmac *dmac = chan_to_axi_dmac(chan);
+	enum hrtimer_restart ret = HRTIMER_NORESTART;
+	unsigned int completed, usecs;
+	unsigned long flags;
+
+	spin_lock_irqsave(&chan->vchan.lock, flags);
+	completed = axi_dmac_read(dmac, AXI_DMAC_REG_TRANSFER_DONE);
+	if (axi_dmac_transfer_done(chan, completed))
+		axi_dmac_start_transfer(chan);
+
+	if (axi_dmac_has_coalesced(chan)) {
+		usecs = max(READ_ONCE(irq_coalesce_usecs), 1U);
+		hrtimer_forward_now(timer, ns_to_ktime(usecs * NSEC_PER_USEC));
+		ret = HRTIMER_RESTART;
+	}
+	spin_unlock_irqrestore(&chan->vchan.lock, flags);
+
+	return ret;
+}
+
 static int axi_dmac_terminate_all(struct dma_chan *c)
 {
 	struct axi_dmac_chan *chan = to_axi_dmac_chan(c);
@@ -449,6 +631,7 @@ static int axi_dmac_terminate_all(struct dma_chan *c)
 	spin_lock_irqsave(&chan->vchan.lock, flags);
 	axi_dmac_write(dmac, AXI_DMAC_REG_CTRL, 0);
 	chan->next_desc = NULL;
+	chan->num_coalesced = 0;
 	vchan_get_all_descriptors(&chan->vchan, &head);
 	list_splice_tail_init(&chan->active_descs, &head);
 	spin_unlock_irqrestore(&chan->vchan.lock, flags);
@@ -462,6 +645,7 @@ static void axi_dmac_synchronize(struct dma_chan *c)
 {
 	struct axi_dmac_chan *chan = to_axi_dmac_chan(c);
 
+	hrtimer_cancel(&chan->coalesce_timer);
 	vchan_synchronize(&chan->vchan);
 }
 
@@ -469,9 +653,13 @@ static void axi_dmac_issue_pending(struct dma_chan *c)
 {
 	struct axi_dmac_chan *chan = to_axi_dmac_chan(c);
 	struct axi_dmac *dmac = chan_to_axi_dmac(chan);
+	unsigned int ctrl = AXI_DMAC_CTRL_ENABLE;
 	unsigned long flags;
 
-	axi_dmac_write(dmac, AXI_DMAC_REG_CTRL, AXI_DMAC_CTRL_ENABLE);
+	if (chan->hw_sg)
+		ctrl |= AXI_DMAC_CTRL_ENABLE_SG;
+
+	axi_dmac_write(dmac, AXI_DMAC_REG_CTRL, ctrl);
 
 	spin_lock_irqsave(&chan->vchan.lock, flags);
 	if (vchan_issue_pending(&chan->vchan))
@@ -479,8 +667,10 @@ static void axi_dmac_issue_pending(struct dma_chan *c)
 	spin_unlock_irqrestore(&chan->vchan.lock, flags);
 }
 
-static struct axi_dmac_desc *axi_dmac_alloc_desc(unsigned int num_sgs)
+static struct axi_dmac_desc *axi_dmac_alloc_desc(struct axi_dmac_chan *chan,
+	unsigned int num_sgs)
 {
+	struct axi_dmac *dmac = chan_to_axi_dmac(chan);
 	struct axi_dmac_desc *desc;
 	unsigned int i;
 
@@ -488,6 +678,16 @@ static struct axi_dmac_desc *axi_dmac_alloc_desc(unsigned int num_sgs)
 	if (!desc)
 		return NULL;
 
+	if (chan->hw_sg) {
+		desc->hw_size = PAGE_ALIGN(num_sgs * sizeof(*desc->hw));
+		desc->hw = dma_alloc_coherent(dmac->dma_dev.dev, desc->hw_size,
+			&desc->hw_phys, GFP_NOWAIT);
+		if (!desc->hw) {
+			kfree(desc);
+			return NULL;
+		}
+	}
+
 	for (i = 0; i < num_sgs; i++)
 		desc->sg[i].id = AXI_DMAC_SG_UNUSED;
 
@@ -496,6 +696,57 @@ static struct axi_dmac_desc *axi_dmac_alloc_desc(unsigned int num_sgs)
 	return desc;
 }
 
+static void axi_dmac_free_desc(struct axi_dmac_chan *chan,
+	struct axi_dmac_desc *desc)
+{
+	struct axi_dmac *dmac = chan_to_axi_dmac(chan);
+
+	if (desc->hw)
+		dma_free_coherent(dmac->dma_dev.dev, desc->hw_size, desc->hw,
+			desc->hw_phys);
+	kfree(desc);
+}
+
+/*
+ * Translates the segments of a descriptor into the in-memory chain walked by
+ * the core in scatter-gather mode. An interrupt is requested every
+ * @sgs_per_irq segments, which is the period length for cyclic transfers.
+ */
+static void axi_dmac_fill_hw_desc(struct axi_dmac_chan *chan,
+	struct axi_dmac_desc *desc, unsigned int sgs_per_irq)
+{
+	struct axi_dmac_hw_desc *hw;
+	struct axi_dmac_sg *sg;
+	unsigned int i;
+
+	if (!desc->hw)
+		return;
+
+	for (i = 0; i < desc->num_sgs; i++) {
+		sg = &desc->sg[i];
+		hw = &desc->hw[i];
+
+		hw->flags = 0;
+		hw->id = 0;
+		hw->dest_addr = sg->dest_addr;
+		hw->src_addr = sg->src_addr;
+		hw->x_len = sg->x_len - 1;
+		hw->y_len = sg->y_len - 1;
+		hw->src_stride = sg->src_stride;
+		hw->dst_stride = sg->dest_stride;
+		hw->next_sg_addr = desc->hw_phys + (i + 1) * sizeof(*hw);
+
+		if ((i + 1) % sgs_per_irq == 0)
+			hw->flags |= AXI_DMAC_HW_FLAG_IRQ;
+	}
+
+	hw = &desc->hw[desc->num_sgs - 1];
+	if (desc->cyclic)
+		hw->next_sg_addr = desc->hw_phys;
+	else
+		hw->flags |= AXI_DMAC_HW_FLAG_LAST | AXI_DMAC_HW_FLAG_IRQ;
+}
+
 static struct axi_dmac_sg *axi_dmac_fill_linear_sg(struct axi_dmac_chan *chan,
 	enum dma_transfer_direction direction, dma_addr_t addr,
 	unsigned int num_periods, unsigned int period_len,
@@ -563,7 +814,7 @@ static struct dma_async_tx_descriptor *axi_dmac_prep_slave_sg(
 	for_each_sg(sgl, sg, sg_len, i)
 		num_sgs += DIV_ROUND_UP(sg_dma_len(sg), chan->max_length);
 
-	desc = axi_dmac_alloc_desc(num_sgs);
+	desc = axi_dmac_alloc_desc(chan, num_sgs);
 	if (!desc)
 		return NULL;
 
@@ -572,7 +823,7 @@ static struct dma_async_tx_descriptor *axi_dmac_prep_slave_sg(
 	for_each_sg(sgl, sg, sg_len, i) {
 		if (!axi_dmac_check_addr(chan, sg_dma_address(sg)) ||
 		    !axi_dmac_check_len(chan, sg_dma_len(sg))) {
-			kfree(desc);
+			axi_dmac_free_desc(chan, desc);
 			return NULL;
 		}
 
@@ -581,6 +832,53 @@ static struct dma_async_tx_descriptor *axi_dmac_prep_slave_sg(
 	}
 
 	desc->cyclic = false;
+	axi_dmac_fill_hw_desc(chan, desc, num_sgs);
+
+	return vchan_tx_prep(&chan->vchan, &desc->vdesc, flags);
+}
+
+static struct dma_async_tx_descriptor *axi_dmac_prep_batch(
+	struct dma_chan *c, const struct dma_batch_xfer *xfers,
+	unsigned int nr, enum dma_transfer_direction direction,
+	unsigned long flags)
+{
+	struct axi_dmac_chan *chan = to_axi_dmac_chan(c);
+	struct axi_dmac_desc *desc;
+	struct axi_dmac_sg *dsg;
+	unsigned int num_sgs;
+	dma_addr_t addr;
+	unsigned int i;
+
+	if (direction != chan->direction ||
+	    (direction != DMA_MEM_TO_DEV && direction != DMA_DEV_TO_MEM))
+		return NULL;
+
+	num_sgs = 0;
+	for (i = 0; i < nr; i++)
+		num_sgs += DIV_ROUND_UP(xfers[i].len, chan->max_length);
+
+	desc = axi_dmac_alloc_desc(chan, num_sgs);
+	if (!desc)
+		return NULL;
+
+	dsg = desc->sg;
+
+	/* Each transfer is one or more segments of a single descriptor */
+	for (i = 0; i < nr; i++) {
+		addr = direction == DMA_MEM_TO_DEV ? xfers[i].src :
+						     xfers[i].dst;
+		if (!axi_dmac_check_addr(chan, addr) ||
+		    !axi_dmac_check_len(chan, xfers[i].len)) {
+			axi_dmac_free_desc(chan, desc);
+			return NULL;
+		}
+
+		dsg = axi_dmac_fill_linear_sg(chan, direction, addr, 1,
+			xfers[i].len, dsg);
+	}
+
+	desc->cyclic = false;
+	axi_dmac_fill_hw_desc(chan, desc, num_sgs);
 
 	return vchan_tx_prep(&chan->vchan, &desc->vdesc, flags);
 }
@@ -622,7 +920,7 @@ static struct dma_async_tx_descriptor *axi_dmac_prep_dma_cyclic(
 	num_periods = buf_len / period_len;
 	num_segments = DIV_ROUND_UP(period_len, chan->max_length);
 
-	desc = axi_dmac_alloc_desc(num_periods * num_segments);
+	desc = axi_dmac_alloc_desc(chan, num_periods * num_segments);
 	if (!desc)
 		return NULL;
 
@@ -630,6 +928,7 @@ static struct dma_async_tx_descriptor *axi_dmac_prep_dma_cyclic(
 		period_len, desc->sg);
 
 	desc->cyclic = true;
+	axi_dmac_fill_hw_desc(chan, desc, num_segments);
 
 	return vchan_tx_prep(&chan->vchan, &desc->vdesc, flags);
 }
@@ -677,7 +976,7 @@ static struct dma_async_tx_descriptor *axi_dmac_prep_interleaved(
 			return NULL;
 	}
 
-	desc = axi_dmac_alloc_desc(1);
+	desc = axi_dmac_alloc_desc(chan, 1);
 	if (!desc)
 		return NULL;
 
@@ -702,9 +1001,86 @@ static struct dma_async_tx_descriptor *axi_dmac_prep_interleaved(
 	if (flags & DMA_CYCLIC)
 		desc->cyclic = true;
 
+	axi_dmac_fill_hw_desc(chan, desc, 1);
+
 	return vchan_tx_prep(&chan->vchan, &desc->vdesc, flags);
 }
 
+/*
+ * The current address register tells how far the core got into the segment it
+ * is working on, which allows clients to consume data of a large block before
+ * the whole block has completed.
+ */
+static unsigned int axi_dmac_active_residue(struct axi_dmac_chan *chan,
+	struct axi_dmac_desc *desc)
+{
+	struct axi_dmac *dmac = chan_to_axi_dmac(chan);
+	bool dest_mem = axi_dmac_dest_is_mem(chan);
+	unsigned int i, total, residue = 0;
+	bool found = false;
+	struct axi_dmac_sg *sg;
+	u32 cur, start;
+
+	if (!dest_mem && !axi_dmac_src_is_mem(chan))
+		cur = 0;
+	else if (dest_mem)
+		cur = axi_dmac_read(dmac, AXI_DMAC_REG_CURRENT_DEST_ADDR);
+	else
+		cur = axi_dmac_read(dmac, AXI_DMAC_REG_CURRENT_SRC_ADDR);
+
+	for (i = desc->num_completed; i < desc->num_sgs; i++) {
+		sg = &desc->sg[i];
+		total = axi_dmac_total_sg_bytes(chan, sg);
+		start = lower_32_bits(dest_mem ? sg->dest_addr : sg->src_addr);
+
+		/* Strided segments are not contiguous, count them in full */
+		if (!found && cur && sg->y_len == 1 &&
+		    cur - start < total) {
+			residue += total - (cur - start);
+			found = true;
+		} else {
+			residue += total;
+		}
+	}
+
+	return residue;
+}
+
+static enum dma_status axi_dmac_tx_status(struct dma_chan *c,
+	dma_cookie_t cookie, struct dma_tx_state *state)
+{
+	struct axi_dmac_chan *chan = to_axi_dmac_chan(c);
+	struct axi_dmac_desc *active, *desc;
+	struct virt_dma_desc *vdesc;
+	unsigned int residue = 0;
+	enum dma_status ret;
+	unsigned long flags;
+	unsigned int i;
+
+	ret = dma_cookie_status(c, cookie, state);
+	if (ret == DMA_COMPLETE || !state)
+		return ret;
+
+	spin_lock_irqsave(&chan->vchan.lock, flags);
+	active = axi_dmac_active_desc(chan);
+	if (active && active->vdesc.tx.cookie == cookie) {
+		residue = axi_dmac_active_residue(chan, active);
+	} else {
+		vdesc = vchan_find_desc(&chan->vchan, cookie);
+		if (vdesc) {
+			desc = to_axi_dmac_desc(vdesc);
+			for (i = 0; i < desc->num_sgs; i++)
+				residue += axi_dmac_total_sg_bytes(chan,
+					&desc->sg[i]);
+		}
+	}
+	spin_unlock_irqrestore(&chan->vchan.lock, flags);
+
+	dma_set_residue(state, residue);
+
+	return ret;
+}
+
 static void axi_dmac_free_chan_resources(struct dma_chan *c)
 {
 	vchan_free_chan_resources(to_virt_chan(c));
@@ -712,7 +1088,8 @@ static void axi_dmac_free_chan_resources(struct dma_chan *c)
 
 static void axi_dmac_desc_free(struct virt_dma_desc *vdesc)
 {
-	kfree(container_of(vdesc, struct axi_dmac_desc, vdesc));
+	axi_dmac_free_desc(to_axi_dmac_chan(vdesc->tx.chan),
+		to_axi_dmac_desc(vdesc));
 }
 
 static bool axi_dmac_regmap_rdwr(struct device *dev, unsigned int reg)
@@ -741,6 +1118,8 @@ static bool axi_dmac_regmap_rdwr(struct device *dev, unsigned int reg)
 	case AXI_DMAC_REG_DBG2:
 	case AXI_DMAC_REG_PARTIAL_XFER_LEN:
 	case AXI_DMAC_REG_PARTIAL_XFER_ID:
+	case AXI_DMAC_REG_SG_ADDRESS:
+	case AXI_DMAC_REG_SG_ADDRESS_HIGH:
 		return true;
 	default:
 		return false;
@@ -751,7 +1130,7 @@ static const struct regmap_config axi_dmac_regmap_config = {
 	.reg_bits = 32,
 	.val_bits = 32,
 	.reg_stride = 4,
-	.max_register = AXI_DMAC_REG_PARTIAL_XFER_ID,
+	.max_register = AXI_DMAC_REG_SG_ADDRESS_HIGH,
 	.readable_reg = axi_dmac_regmap_rdwr,
 	.writeable_reg = axi_dmac_regmap_rdwr,
 };
@@ -921,6 +1300,11 @@ static int axi_dmac_detect_caps(struct axi_dmac *dmac, unsigned int version)
 	if (version >= ADI_AXI_PCORE_VER(4, 2, 'a'))
 		chan->hw_partial_xfer = true;
 
+	/* Cores built with descriptor support implement the SG address */
+	axi_dmac_write(dmac, AXI_DMAC_REG_SG_ADDRESS, 0xffffffff);
+	if (axi_dmac_read(dmac, AXI_DMAC_REG_SG_ADDRESS))
+		chan->hw_sg = true;
+
 	if (version >= ADI_AXI_PCORE_VER(4, 1, 'a')) {
 		axi_dmac_write(dmac, AXI_DMAC_REG_X_LENGTH, 0x00);
 		chan->length_align_mask =
@@ -975,6 +1359,9 @@ static int axi_dmac_probe(struct platform_device *pdev)
 		goto err_clk_disable;
 
 	INIT_LIST_HEAD(&dmac->chan.active_descs);
+	hrtimer_init(&dmac->chan.coalesce_timer, CLOCK_MONOTONIC,
+		     HRTIMER_MODE_REL);
+	dmac->chan.coalesce_timer.function = axi_dmac_coalesce_timer;
 
 	dma_set_max_seg_size(&pdev->dev, UINT_MAX);
 
@@ -983,12 +1370,13 @@ static int axi_dmac_probe(struct platform_device *pdev)
 	dma_cap_set(DMA_CYCLIC, dma_dev->cap_mask);
 	dma_cap_set(DMA_INTERLEAVE, dma_dev->cap_mask);
 	dma_dev->device_free_chan_resources = axi_dmac_free_chan_resources;
-	dma_dev->device_tx_status = dma_cookie_status;
+	dma_dev->device_tx_status = axi_dmac_tx_status;
 	dma_dev->device_issue_pending = axi_dmac_issue_pending;
 	dma_dev->device_prep_slave_sg = axi_dmac_prep_slave_sg;
 	dma_dev->device_config = axi_dmac_device_config;
 	dma_dev->device_prep_dma_cyclic = axi_dmac_prep_dma_cyclic;
 	dma_dev->device_prep_interleaved_dma = axi_dmac_prep_interleaved;
+	dma_dev->device_prep_batch = axi_dmac_prep_batch;
 	dma_dev->device_terminate_all = axi_dmac_terminate_all;
 	dma_dev->device_synchronize = axi_dmac_synchronize;
 	dma_dev->dev = &pdev->dev;
@@ -996,7 +1384,7 @@ static int axi_dmac_probe(struct platform_device *pdev)
 	dma_dev->src_addr_widths = BIT(dmac->chan.src_width);
 	dma_dev->dst_addr_widths = BIT(dmac->chan.dest_width);
 	dma_dev->directions = BIT(dmac->chan.direction);
-	dma_dev->residue_granularity = DMA_RESIDUE_GRANULARITY_DESCRIPTOR;
+	dma_dev->residue_granularity = DMA_RESIDUE_GRANULARITY_BURST;
 	INIT_LIST_HEAD(&dma_dev->channels);
 
 	dmac->chan.vchan.desc_free = axi_dmac_desc_free;
@@ -1008,7 +1396,14 @@ static int axi_dmac_probe(struct platform_device *pdev)
 
 	dma_dev->copy_align = (dmac->chan.address_align_mask + 1);
 
-	axi_dmac_write(dmac, AXI_DMAC_REG_IRQ_MASK, 0x00);
+	/*
+	 * In scatter-gather mode queue space is only reclaimed on completion,
+	 * so the start-of-transfer interrupt is of no use.
+	 */
+	if (dmac->chan.hw_sg)
+		axi_dmac_write(dmac, AXI_DMAC_REG_IRQ_MASK, AXI_DMAC_IRQ_SOT);
+	else
+		axi_dmac_write(dmac, AXI_DMAC_REG_IRQ_MASK, 0x00);
 
 	if (of_dma_is_coherent(pdev->dev.of_node)) {
 		ret = axi_dmac_read(dmac, AXI_DMAC_REG_COHERENCY_DESC);
@@ -1065,6 +1460,7 @@ static int axi_dmac_remove(struct platform_device *pdev)
 
 	of_dma_controller_free(pdev->dev.of_node);
 	free_irq(dmac->irq, dmac);
+	hrtimer_cancel(&dmac->chan.coalesce_timer);
 	tasklet_kill(&dmac->chan.vchan.task);
 	dma_async_device_unregister(&dmac->dma_dev);
 	clk_disable_unprepare(dmac->clk);
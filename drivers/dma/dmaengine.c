@@ -567,6 +567,98 @@ void dma_issue_pending_all(void)
 }
 EXPORT_SYMBOL(dma_issue_pending_all);
 
+static struct dma_async_tx_descriptor *
+dmaengine_prep_batch_xfer(struct dma_chan *chan,
+			  const struct dma_batch_xfer *xfer,
+			  enum dma_transfer_direction direction,
+			  unsigned long flags)
+{
+	if (direction == DMA_MEM_TO_MEM)
+		return dmaengine_prep_dma_memcpy(chan, xfer->dst, xfer->src,
+						 xfer->len, flags);
+
+	return dmaengine_prep_slave_single(chan,
+					   direction == DMA_MEM_TO_DEV ?
+					   xfer->src : xfer->dst,
+					   xfer->len, direction, flags);
+}
+
+/**
+ * dmaengine_submit_batch - prepare, submit and issue an array of transfers
+ * @chan: target DMA channel
+ * @xfers: transfers of the batch, in order
+ * @nr: number of entries in @xfers
+ * @direction: direction of all the transfers
+ * @flags: DMA_PREP_* flags of the batch
+ * @callback: optional callback run once the whole batch completed
+ * @callback_param: parameter of @callback
+ *
+ * Drivers implementing device_prep_batch build a single transaction for the
+ * whole batch, taking the channel lock and ringing the doorbell once. For
+ * the others every transfer is prepared and submitted on its own and only
+ * the last one interrupts. If preparing a transfer fails, the transfers
+ * submitted before it are still issued but @callback is not called.
+ *
+ * Return: the cookie of the last transfer of the batch, or a negative error
+ */
+dma_cookie_t dmaengine_submit_batch(struct dma_chan *chan,
+				    const struct dma_batch_xfer *xfers,
+				    unsigned int nr,
+				    enum dma_transfer_direction direction,
+				    unsigned long flags,
+				    dma_async_tx_callback_result callback,
+				    void *callback_param)
+{
+	struct dma_device *device = chan->device;
+	struct dma_async_tx_descriptor *tx;
+	dma_cookie_t cookie = -EINVAL;
+	unsigned int i;
+
+	if (!nr)
+		return -EINVAL;
+
+	if (device->device_prep_batch) {
+		tx = device->device_prep_batch(chan, xfers, nr, direction,
+					       flags);
+		if (!tx)
+			return -ENOMEM;
+
+		tx->callback_result = callback;
+		tx->callback_param = callback_param;
+		cookie = dmaengine_submit(tx);
+		if (!dma_submit_error(cookie))
+			dma_async_issue_pending(chan);
+		return cookie;
+	}
+
+	for (i = 0; i < nr; i++) {
+		bool last = i == nr - 1;
+
+		tx = dmaengine_prep_batch_xfer(chan, &xfers[i], direction,
+					       last ? flags :
+					       flags & ~DMA_PREP_INTERRUPT);
+		if (!tx) {
+			cookie = -ENOMEM;
+			break;
+		}
+
+		if (last) {
+			tx->callback_result = callback;
+			tx->callback_param = callback_param;
+		}
+
+		cookie = dmaengine_submit(tx);
+		if (dma_submit_error(cookie))
+			break;
+	}
+
+	if (i)
+		dma_async_issue_pending(chan);
+
+	return cookie;
+}
+EXPORT_SYMBOL_GPL(dmaengine_submit_batch);
+
 int dma_get_slave_caps(struct dma_chan *chan, struct dma_slave_caps *caps)
 {
 	struct dma_device *device;
@@ -1153,6 +1245,13 @@ int dma_async_device_register(struct dma_device *device)
 		return -EIO;
 	}
 
+	if (dma_has_cap(DMA_MEMCPY_SG, device->cap_mask) && !device->device_prep_dma_memcpy_sg) {
+		dev_err(device->dev,
+			"Device claims capability %s, but op is not defined\n",
+			"DMA_MEMCPY_SG");
+		return -EIO;
+	}
+
 	if (dma_has_cap(DMA_XOR, device->cap_mask) && !device->device_prep_dma_xor) {
 		dev_err(device->dev,
 			"Device claims capability %s, but op is not defined\n",
@@ -48,8 +48,12 @@
 #include <linux/slab.h>
 #include <linux/clk.h>
 #include <linux/io-64-nonatomic-lo-hi.h>
+#include <linux/ktime.h>
+#include <linux/wait_bit.h>
 
 #include "../dmaengine.h"
+#include "xilinx_dma_compl.h"
+#include "xilinx_dma_stats.h"
 
 /* Register/Descriptor Offsets */
 #define XILINX_DMA_MM2S_CTRL_OFFSET		0x0000
@@ -101,6 +105,7 @@
 #define XILINX_DMA_REG_TAILDESC		0x0010
 #define XILINX_DMA_REG_REG_INDEX		0x0014
 #define XILINX_DMA_REG_FRMSTORE		0x0018
+#define XILINX_DMA_FRMSTORE_MASK		GENMASK(4, 0)
 #define XILINX_DMA_REG_THRESHOLD		0x001c
 #define XILINX_DMA_REG_FRMPTR_STS		0x0024
 #define XILINX_DMA_REG_PARK_PTR		0x0028
@@ -112,11 +117,14 @@
 
 /* Register Direct Mode Registers */
 #define XILINX_DMA_REG_VSIZE			0x0000
+#define XILINX_DMA_VSIZE_MAX			GENMASK(12, 0)
 #define XILINX_DMA_REG_HSIZE			0x0004
+#define XILINX_DMA_HSIZE_MAX			GENMASK(15, 0)
 
 #define XILINX_DMA_REG_FRMDLY_STRIDE		0x0008
 #define XILINX_DMA_FRMDLY_STRIDE_FRMDLY_SHIFT	24
 #define XILINX_DMA_FRMDLY_STRIDE_STRIDE_SHIFT	0
+#define XILINX_DMA_FRMDLY_STRIDE_STRIDE_MAX	GENMASK(15, 0)
 
 #define XILINX_VDMA_REG_START_ADDRESS(n)	(0x000c + 4 * (n))
 #define XILINX_VDMA_REG_START_ADDRESS_64(n)	(0x000c + 8 * (n))
@@ -134,6 +142,10 @@
 		 XILINX_DMA_DMASR_DLY_CNT_IRQ | \
 		 XILINX_DMA_DMASR_ERR_IRQ)
 
+#define XILINX_DMA_DMAXR_DONE_IRQ_MASK	\
+		(XILINX_DMA_DMASR_FRM_CNT_IRQ | \
+		 XILINX_DMA_DMASR_DLY_CNT_IRQ)
+
 #define XILINX_DMA_DMASR_ALL_ERR_MASK	\
 		(XILINX_DMA_DMASR_EOL_LATE_ERR | \
 		 XILINX_DMA_DMASR_SOF_LATE_ERR | \
@@ -202,6 +214,7 @@
 #define XILINX_MCDMA_CHAN_SR_OFFSET(x)		(0x44 + (x) * 0x40)
 #define XILINX_MCDMA_CHAN_CDESC_OFFSET(x)	(0x48 + (x) * 0x40)
 #define XILINX_MCDMA_CHAN_TDESC_OFFSET(x)	(0x50 + (x) * 0x40)
+#define XILINX_MCDMA_TXWEIGHT_OFFSET(x)		(0x18 + ((x) / 8) * 4)
 
 /* AXI MCDMA Specific Masks/Shifts */
 #define XILINX_MCDMA_COALESCE_SHIFT		16
@@ -214,6 +227,9 @@
 #define XILINX_MCDMA_IRQ_ERR_MASK		BIT(7)
 #define XILINX_MCDMA_BD_EOP			BIT(30)
 #define XILINX_MCDMA_BD_SOP			BIT(31)
+#define XILINX_MCDMA_TXWEIGHT_SHIFT(x)		(((x) % 8) * 4)
+#define XILINX_MCDMA_TXWEIGHT_MASK(x)		\
+		(GENMASK(3, 0) << XILINX_MCDMA_TXWEIGHT_SHIFT(x))
 
 /**
  * struct xilinx_vdma_desc_hw - Hardware Descriptor
@@ -323,11 +339,13 @@ struct xilinx_vdma_tx_segment {
  * @hw: Hardware descriptor
  * @node: Node in the descriptor segments list
  * @phys: Physical address of segment
+ * @released: Segment was freed but is not yet behind the ring tail
  */
 struct xilinx_axidma_tx_segment {
 	struct xilinx_axidma_desc_hw hw;
 	struct list_head node;
 	dma_addr_t phys;
+	bool released;
 } __aligned(64);
 
 /**
@@ -335,11 +353,13 @@ struct xilinx_axidma_tx_segment {
  * @hw: Hardware descriptor
  * @node: Node in the descriptor segments list
  * @phys: Physical address of segment
+ * @released: Segment was freed but is not yet behind the ring tail
  */
 struct xilinx_aximcdma_tx_segment {
 	struct xilinx_aximcdma_desc_hw hw;
 	struct list_head node;
 	dma_addr_t phys;
+	bool released;
 } __aligned(64);
 
 /**
@@ -362,6 +382,8 @@ struct xilinx_cdma_tx_segment {
  * @cyclic: Check for cyclic transfers.
  * @err: Whether the descriptor has an error.
  * @residue: Residue of the completed descriptor
+ * @len: Length of the transfer in bytes
+ * @submit_ns: Submission timestamp for the channel statistics
  */
 struct xilinx_dma_tx_descriptor {
 	struct dma_async_tx_descriptor async_tx;
@@ -370,6 +392,8 @@ struct xilinx_dma_tx_descriptor {
 	bool cyclic;
 	bool err;
 	u32 residue;
+	size_t len;
+	u64 submit_ns;
 };
 
 /**
@@ -381,21 +405,23 @@ struct xilinx_dma_tx_descriptor {
  * @pending_list: Descriptors waiting
  * @active_list: Descriptors ready to submit
  * @done_list: Complete descriptors
- * @free_seg_list: Free descriptors
  * @common: DMA common channel
  * @desc_pool: Descriptors pool
  * @dev: The dma device
  * @irq: Channel IRQ
  * @id: Channel ID
  * @direction: Transfer direction
- * @num_frms: Number of frames
+ * @num_frms: Number of frame stores in use
+ * @max_frms: Number of frame stores of the IP
  * @has_sg: Support scatter transfers
  * @cyclic: Check for cyclic transfers.
  * @genlock: Support genlock mode
  * @err: Channel has errors
  * @idle: Check for channel idle
  * @terminating: Check for channel being synchronized by user
- * @tasklet: Cleanup work after irq
+ * @cleanup_running: Completion callbacks are being run
+ * @cleanup_again: Descriptors completed while @cleanup_running was set
+ * @compl: Cleanup work after irq
  * @config: Device configuration info
  * @flush_on_fsync: Flush on Frame sync
  * @desc_pendingcount: Descriptor pending count
@@ -404,12 +430,18 @@ struct xilinx_dma_tx_descriptor {
  * @seg_v: Statically allocated segments base
  * @seg_mv: Statically allocated segments base for MCDMA
  * @seg_p: Physical allocated segments base
+ * @seg_head: Index of the next free segment of the AXI DMA/MCDMA BD ring
+ * @seg_tail: Index of the oldest segment of the BD ring still in use
  * @cyclic_seg_v: Statically allocated segment base for cyclic transfers
  * @cyclic_seg_p: Physical allocated segments base for cyclic dma
  * @start_transfer: Differentiate b/w DMA IP's transfer
  * @stop_transfer: Differentiate b/w DMA IP's quiesce
  * @tdest: TDEST value for mcdma
  * @has_vflip: S2MM vertical flip
+ * @poll_mode: Completion mode of AXI DMA/CDMA channels
+ * @poll_budget_us: Spin time of the hybrid completion mode
+ * @weight: MCDMA MM2S scheduler weight, 0 if left at the hardware default
+ * @stats: Transfer statistics
  */
 struct xilinx_dma_chan {
 	struct xilinx_dma_device *xdev;
@@ -419,7 +451,6 @@ struct xilinx_dma_chan {
 	struct list_head pending_list;
 	struct list_head active_list;
 	struct list_head done_list;
-	struct list_head free_seg_list;
 	struct dma_chan common;
 	struct dma_pool *desc_pool;
 	struct device *dev;
@@ -427,13 +458,16 @@ struct xilinx_dma_chan {
 	int id;
 	enum dma_transfer_direction direction;
 	int num_frms;
+	int max_frms;
 	bool has_sg;
 	bool cyclic;
 	bool genlock;
 	bool err;
 	bool idle;
 	bool terminating;
-	struct tasklet_struct tasklet;
+	bool cleanup_running;
+	bool cleanup_again;
+	struct xdma_compl_item compl;
 	struct xilinx_vdma_config config;
 	bool flush_on_fsync;
 	u32 desc_pendingcount;
@@ -442,12 +476,18 @@ struct xilinx_dma_chan {
 	struct xilinx_axidma_tx_segment *seg_v;
 	struct xilinx_aximcdma_tx_segment *seg_mv;
 	dma_addr_t seg_p;
+	u32 seg_head;
+	u32 seg_tail;
 	struct xilinx_axidma_tx_segment *cyclic_seg_v;
 	dma_addr_t cyclic_seg_p;
 	void (*start_transfer)(struct xilinx_dma_chan *chan);
 	int (*stop_transfer)(struct xilinx_dma_chan *chan);
 	u16 tdest;
 	bool has_vflip;
+	enum xilinx_dma_poll_mode poll_mode;
+	u32 poll_budget_us;
+	u32 weight;
+	struct xdma_stats stats;
 };
 
 /**
@@ -493,6 +533,8 @@ struct xilinx_dma_config {
  * @s2mm_chan_id: DMA s2mm channel identifier
  * @mm2s_chan_id: DMA mm2s channel identifier
  * @max_buffer_len: Max buffer length
+ * @compl: Context the channel cleanup work runs in
+ * @weight_lock: Protects the MCDMA MM2S weight registers
  */
 struct xilinx_dma_device {
 	void __iomem *regs;
@@ -511,6 +553,8 @@ struct xilinx_dma_device {
 	u32 s2mm_chan_id;
 	u32 mm2s_chan_id;
 	u32 max_buffer_len;
+	struct xdma_compl compl;
+	spinlock_t weight_lock; /* Protects the MCDMA MM2S weight registers */
 };
 
 /* Macros */
@@ -669,104 +713,132 @@ xilinx_cdma_alloc_tx_segment(struct xilinx_dma_chan *chan)
 	return segment;
 }
 
+/*
+ * The AXI DMA and MCDMA segments form a ring of XILINX_DMA_NUM_DESCS BDs
+ * whose hardware next pointers are linked once, at channel allocation.
+ * Transactions take runs of consecutive segments from the ring head, so
+ * their BDs are already chained, and freed segments are given back at the
+ * ring tail. One slot is kept unused to tell a full ring from an empty one.
+ */
+
+static inline u32 xilinx_dma_ring_add(u32 idx, u32 n)
+{
+	return (idx + n) % XILINX_DMA_NUM_DESCS;
+}
+
 /**
- * xilinx_axidma_alloc_tx_segment - Allocate transaction segment
+ * xilinx_dma_ring_reserve - Reserve consecutive segments of the BD ring
  * @chan: Driver specific DMA channel
+ * @count: Number of segments
  *
- * Return: The allocated segment on success and NULL on failure.
+ * This does not take the channel lock, so several clients may prepare
+ * transactions concurrently with each other and with the completion path.
+ *
+ * Return: The ring index of the first reserved segment on success and
+ * -ENOMEM if fewer than @count segments are free.
  */
-static struct xilinx_axidma_tx_segment *
-xilinx_axidma_alloc_tx_segment(struct xilinx_dma_chan *chan)
+static int xilinx_dma_ring_reserve(struct xilinx_dma_chan *chan, u32 count)
 {
-	struct xilinx_axidma_tx_segment *segment = NULL;
-	unsigned long flags;
-
-	spin_lock_irqsave(&chan->lock, flags);
-	if (!list_empty(&chan->free_seg_list)) {
-		segment = list_first_entry(&chan->free_seg_list,
-					   struct xilinx_axidma_tx_segment,
-					   node);
-		list_del(&segment->node);
-	}
-	spin_unlock_irqrestore(&chan->lock, flags);
-
-	if (!segment)
-		dev_dbg(chan->dev, "Could not find free tx segment\n");
+	u32 head, tail;
+
+	do {
+		head = READ_ONCE(chan->seg_head);
+		/* Pairs with the release in xilinx_dma_ring_reclaim() */
+		tail = smp_load_acquire(&chan->seg_tail);
+		if ((tail + XILINX_DMA_NUM_DESCS - head - 1) %
+		    XILINX_DMA_NUM_DESCS < count) {
+			dev_dbg(chan->dev, "Could not find %u free tx segments\n",
+				count);
+			return -ENOMEM;
+		}
+	} while (cmpxchg(&chan->seg_head, head,
+			 xilinx_dma_ring_add(head, count)) != head);
 
-	return segment;
+	return head;
 }
 
 /**
- * xilinx_aximcdma_alloc_tx_segment - Allocate transaction segment
+ * xilinx_dma_ring_link - Restore the ring link of a segment
  * @chan: Driver specific DMA channel
+ * @idx: Ring index of the segment
  *
- * Return: The allocated segment on success and NULL on failure.
+ * Cyclic transactions and appending to the pending queue may point a BD
+ * elsewhere, so the link to the next ring entry is restored on free.
  */
-static struct xilinx_aximcdma_tx_segment *
-xilinx_aximcdma_alloc_tx_segment(struct xilinx_dma_chan *chan)
+static void xilinx_dma_ring_link(struct xilinx_dma_chan *chan, u32 idx)
 {
-	struct xilinx_aximcdma_tx_segment *segment = NULL;
-	unsigned long flags;
+	dma_addr_t next;
 
-	spin_lock_irqsave(&chan->lock, flags);
-	if (!list_empty(&chan->free_seg_list)) {
-		segment = list_first_entry(&chan->free_seg_list,
-					   struct xilinx_aximcdma_tx_segment,
-					   node);
-		list_del(&segment->node);
+	if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIMCDMA) {
+		next = chan->seg_p + sizeof(*chan->seg_mv) *
+		       xilinx_dma_ring_add(idx, 1);
+		chan->seg_mv[idx].hw.next_desc = lower_32_bits(next);
+		chan->seg_mv[idx].hw.next_desc_msb = upper_32_bits(next);
+	} else {
+		next = chan->seg_p + sizeof(*chan->seg_v) *
+		       xilinx_dma_ring_add(idx, 1);
+		chan->seg_v[idx].hw.next_desc = lower_32_bits(next);
+		chan->seg_v[idx].hw.next_desc_msb = upper_32_bits(next);
 	}
-	spin_unlock_irqrestore(&chan->lock, flags);
-
-	return segment;
-}
-
-static void xilinx_dma_clean_hw_desc(struct xilinx_axidma_desc_hw *hw)
-{
-	u32 next_desc = hw->next_desc;
-	u32 next_desc_msb = hw->next_desc_msb;
-
-	memset(hw, 0, sizeof(struct xilinx_axidma_desc_hw));
-
-	hw->next_desc = next_desc;
-	hw->next_desc_msb = next_desc_msb;
 }
 
-static void xilinx_mcdma_clean_hw_desc(struct xilinx_aximcdma_desc_hw *hw)
+/**
+ * xilinx_dma_ring_reclaim - Move the ring tail past released segments
+ * @chan: Driver specific DMA channel
+ *
+ * Transactions normally complete in ring order, but one prepared later may
+ * be freed first. Its segments then stay reserved until those before them
+ * are freed as well. Must be called with the channel lock held.
+ */
+static void xilinx_dma_ring_reclaim(struct xilinx_dma_chan *chan)
 {
-	u32 next_desc = hw->next_desc;
-	u32 next_desc_msb = hw->next_desc_msb;
+	u32 head = READ_ONCE(chan->seg_head);
+	u32 tail = chan->seg_tail;
+	bool *released;
 
-	memset(hw, 0, sizeof(struct xilinx_aximcdma_desc_hw));
+	while (tail != head) {
+		if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIMCDMA)
+			released = &chan->seg_mv[tail].released;
+		else
+			released = &chan->seg_v[tail].released;
+		if (!*released)
+			break;
+		*released = false;
+		tail = xilinx_dma_ring_add(tail, 1);
+	}
 
-	hw->next_desc = next_desc;
-	hw->next_desc_msb = next_desc_msb;
+	smp_store_release(&chan->seg_tail, tail);
 }
 
 /**
  * xilinx_dma_free_tx_segment - Free transaction segment
  * @chan: Driver specific DMA channel
  * @segment: DMA transaction segment
+ *
+ * The segment goes back to the ring with xilinx_dma_ring_reclaim().
  */
 static void xilinx_dma_free_tx_segment(struct xilinx_dma_chan *chan,
 				struct xilinx_axidma_tx_segment *segment)
 {
-	xilinx_dma_clean_hw_desc(&segment->hw);
-
-	list_add_tail(&segment->node, &chan->free_seg_list);
+	memset(&segment->hw, 0, sizeof(segment->hw));
+	xilinx_dma_ring_link(chan, segment - chan->seg_v);
+	segment->released = true;
 }
 
 /**
  * xilinx_mcdma_free_tx_segment - Free transaction segment
  * @chan: Driver specific DMA channel
  * @segment: DMA transaction segment
+ *
+ * The segment goes back to the ring with xilinx_dma_ring_reclaim().
  */
 static void xilinx_mcdma_free_tx_segment(struct xilinx_dma_chan *chan,
 					 struct xilinx_aximcdma_tx_segment *
 					 segment)
 {
-	xilinx_mcdma_clean_hw_desc(&segment->hw);
-
-	list_add_tail(&segment->node, &chan->free_seg_list);
+	memset(&segment->hw, 0, sizeof(segment->hw));
+	xilinx_dma_ring_link(chan, segment - chan->seg_mv);
+	segment->released = true;
 }
 
 /**
@@ -840,19 +912,27 @@ xilinx_dma_free_tx_descriptor(struct xilinx_dma_chan *chan,
 			xilinx_cdma_free_tx_segment(chan, cdma_segment);
 		}
 	} else if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIDMA) {
+		/* Nothing was reserved if a prep failed early */
+		if (list_empty(&desc->segments))
+			goto out;
 		list_for_each_entry_safe(axidma_segment, axidma_next,
 					 &desc->segments, node) {
 			list_del(&axidma_segment->node);
 			xilinx_dma_free_tx_segment(chan, axidma_segment);
 		}
+		xilinx_dma_ring_reclaim(chan);
 	} else {
+		if (list_empty(&desc->segments))
+			goto out;
 		list_for_each_entry_safe(aximcdma_segment, aximcdma_next,
 					 &desc->segments, node) {
 			list_del(&aximcdma_segment->node);
 			xilinx_mcdma_free_tx_segment(chan, aximcdma_segment);
 		}
+		xilinx_dma_ring_reclaim(chan);
 	}
 
+out:
 	kfree(desc);
 }
 
@@ -906,7 +986,8 @@ static void xilinx_dma_free_chan_resources(struct dma_chan *dchan)
 
 	if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIDMA) {
 		spin_lock_irqsave(&chan->lock, flags);
-		INIT_LIST_HEAD(&chan->free_seg_list);
+		chan->seg_head = 0;
+		chan->seg_tail = 0;
 		spin_unlock_irqrestore(&chan->lock, flags);
 
 		/* Free memory that is allocated for BD */
@@ -921,7 +1002,8 @@ static void xilinx_dma_free_chan_resources(struct dma_chan *dchan)
 
 	if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIMCDMA) {
 		spin_lock_irqsave(&chan->lock, flags);
-		INIT_LIST_HEAD(&chan->free_seg_list);
+		chan->seg_head = 0;
+		chan->seg_tail = 0;
 		spin_unlock_irqrestore(&chan->lock, flags);
 
 		/* Free memory that is allocated for BD */
@@ -988,6 +1070,45 @@ static u32 xilinx_dma_get_residue(struct xilinx_dma_chan *chan,
 	return residue;
 }
 
+/**
+ * xilinx_dma_get_len - Compute the length of a descriptor
+ * @chan: Driver specific dma channel
+ * @desc: dma transaction descriptor
+ *
+ * Return: The number of bytes the descriptor transfers.
+ */
+static size_t xilinx_dma_get_len(struct xilinx_dma_chan *chan,
+				 struct xilinx_dma_tx_descriptor *desc)
+{
+	struct xilinx_vdma_tx_segment *vdma_seg;
+	struct xilinx_cdma_tx_segment *cdma_seg;
+	struct xilinx_axidma_tx_segment *axidma_seg;
+	struct xilinx_aximcdma_tx_segment *aximcdma_seg;
+	u32 mask = chan->xdev->max_buffer_len;
+	size_t len = 0;
+
+	switch (chan->xdev->dma_config->dmatype) {
+	case XDMA_TYPE_VDMA:
+		list_for_each_entry(vdma_seg, &desc->segments, node)
+			len += (size_t)vdma_seg->hw.hsize * vdma_seg->hw.vsize;
+		break;
+	case XDMA_TYPE_CDMA:
+		list_for_each_entry(cdma_seg, &desc->segments, node)
+			len += cdma_seg->hw.control & mask;
+		break;
+	case XDMA_TYPE_AXIDMA:
+		list_for_each_entry(axidma_seg, &desc->segments, node)
+			len += axidma_seg->hw.control & mask;
+		break;
+	default:
+		list_for_each_entry(aximcdma_seg, &desc->segments, node)
+			len += aximcdma_seg->hw.control & mask;
+		break;
+	}
+
+	return len;
+}
+
 /**
  * xilinx_dma_chan_handle_cyclic - Cyclic dma callback
  * @chan: Driver specific dma channel
@@ -1009,26 +1130,44 @@ static void xilinx_dma_chan_handle_cyclic(struct xilinx_dma_chan *chan,
 }
 
 /**
- * xilinx_dma_chan_desc_cleanup - Clean channel descriptors
+ * xilinx_dma_chan_desc_batch - Run and free the completed descriptors
  * @chan: Driver specific DMA channel
  */
-static void xilinx_dma_chan_desc_cleanup(struct xilinx_dma_chan *chan)
+static void xilinx_dma_chan_desc_batch(struct xilinx_dma_chan *chan)
 {
 	struct xilinx_dma_tx_descriptor *desc, *next;
 	unsigned long flags;
+	LIST_HEAD(done);
 
 	spin_lock_irqsave(&chan->lock, flags);
 
 	list_for_each_entry_safe(desc, next, &chan->done_list, node) {
-		struct dmaengine_result result;
-
 		if (desc->cyclic) {
 			xilinx_dma_chan_handle_cyclic(chan, desc, &flags);
 			break;
 		}
 
 		/* Remove from the list of running transactions */
-		list_del(&desc->node);
+		list_move_tail(&desc->node, &done);
+	}
+
+	if (list_empty(&done)) {
+		spin_unlock_irqrestore(&chan->lock, flags);
+		return;
+	}
+
+	/* Run the callbacks of the whole batch with a single lock drop */
+	spin_unlock_irqrestore(&chan->lock, flags);
+
+	list_for_each_entry(desc, &done, node) {
+		struct dmaengine_result result;
+
+		/*
+		 * While we ran a callback the user called a terminate function,
+		 * so the rest of the batch is only freed
+		 */
+		if (READ_ONCE(chan->terminating))
+			break;
 
 		if (unlikely(desc->err)) {
 			if (chan->direction == DMA_DEV_TO_MEM)
@@ -1042,36 +1181,84 @@ static void xilinx_dma_chan_desc_cleanup(struct xilinx_dma_chan *chan)
 		result.residue = desc->residue;
 
 		/* Run the link descriptor callback function */
-		spin_unlock_irqrestore(&chan->lock, flags);
 		dmaengine_desc_get_callback_invoke(&desc->async_tx, &result);
-		spin_lock_irqsave(&chan->lock, flags);
+	}
+
+	spin_lock_irqsave(&chan->lock, flags);
+
+	list_for_each_entry_safe(desc, next, &done, node) {
+		list_del(&desc->node);
 
 		/* Run any dependencies, then free the descriptor */
 		dma_run_dependencies(&desc->async_tx);
 		xilinx_dma_free_tx_descriptor(chan, desc);
+	}
 
-		/*
-		 * While we ran a callback the user called a terminate function,
-		 * which takes care of cleaning up any remaining descriptors
-		 */
-		if (chan->terminating)
-			break;
+	spin_unlock_irqrestore(&chan->lock, flags);
+}
+
+/**
+ * xilinx_dma_chan_desc_cleanup - Clean channel descriptors
+ * @chan: Driver specific DMA channel
+ *
+ * The completion work and a polling dmaengine_tx_status() caller may both
+ * get here. Only one of them runs the callbacks at a time, so they run in
+ * completion order: a second caller leaves its batch to the running one.
+ */
+static void xilinx_dma_chan_desc_cleanup(struct xilinx_dma_chan *chan)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&chan->lock, flags);
+	if (chan->cleanup_running) {
+		chan->cleanup_again = true;
+		spin_unlock_irqrestore(&chan->lock, flags);
+		return;
 	}
+	chan->cleanup_running = true;
+
+	do {
+		chan->cleanup_again = false;
+		spin_unlock_irqrestore(&chan->lock, flags);
+
+		xilinx_dma_chan_desc_batch(chan);
 
+		spin_lock_irqsave(&chan->lock, flags);
+	} while (chan->cleanup_again);
+
+	chan->cleanup_running = false;
 	spin_unlock_irqrestore(&chan->lock, flags);
+
+	/* Pairs with the wait in xilinx_dma_synchronize() */
+	smp_mb();
+	wake_up_var(&chan->cleanup_running);
 }
 
 /**
- * xilinx_dma_do_tasklet - Schedule completion tasklet
- * @t: Pointer to the Xilinx DMA channel structure
+ * xilinx_dma_do_compl - Deferred completion work
+ * @data: Pointer to the Xilinx DMA channel structure
  */
-static void xilinx_dma_do_tasklet(struct tasklet_struct *t)
+static void xilinx_dma_do_compl(void *data)
 {
-	struct xilinx_dma_chan *chan = from_tasklet(chan, t, tasklet);
+	struct xilinx_dma_chan *chan = data;
 
 	xilinx_dma_chan_desc_cleanup(chan);
 }
 
+/**
+ * xilinx_dma_irq_mask - Interrupts to enable on the channel
+ * @chan: Driver specific DMA channel
+ *
+ * Return: The DMACR interrupt enable bits for the channel completion mode
+ */
+static u32 xilinx_dma_irq_mask(struct xilinx_dma_chan *chan)
+{
+	if (chan->poll_mode == XILINX_DMA_POLL_ALWAYS)
+		return XILINX_DMA_DMASR_ERR_IRQ;
+
+	return XILINX_DMA_DMAXR_ALL_IRQ_MASK;
+}
+
 /**
  * xilinx_dma_alloc_chan_resources - Allocate channel resources
  * @dchan: DMA channel
@@ -1123,17 +1310,12 @@ static int xilinx_dma_alloc_chan_resources(struct dma_chan *dchan)
 		chan->cyclic_seg_v->phys = chan->cyclic_seg_p;
 
 		for (i = 0; i < XILINX_DMA_NUM_DESCS; i++) {
-			chan->seg_v[i].hw.next_desc =
-			lower_32_bits(chan->seg_p + sizeof(*chan->seg_v) *
-				((i + 1) % XILINX_DMA_NUM_DESCS));
-			chan->seg_v[i].hw.next_desc_msb =
-			upper_32_bits(chan->seg_p + sizeof(*chan->seg_v) *
-				((i + 1) % XILINX_DMA_NUM_DESCS));
+			xilinx_dma_ring_link(chan, i);
 			chan->seg_v[i].phys = chan->seg_p +
 				sizeof(*chan->seg_v) * i;
-			list_add_tail(&chan->seg_v[i].node,
-				      &chan->free_seg_list);
 		}
+		chan->seg_head = 0;
+		chan->seg_tail = 0;
 	} else if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIMCDMA) {
 		/* Allocate the buffer descriptors. */
 		chan->seg_mv = dma_alloc_coherent(chan->dev,
@@ -1147,17 +1329,12 @@ static int xilinx_dma_alloc_chan_resources(struct dma_chan *dchan)
 			return -ENOMEM;
 		}
 		for (i = 0; i < XILINX_DMA_NUM_DESCS; i++) {
-			chan->seg_mv[i].hw.next_desc =
-			lower_32_bits(chan->seg_p + sizeof(*chan->seg_mv) *
-				((i + 1) % XILINX_DMA_NUM_DESCS));
-			chan->seg_mv[i].hw.next_desc_msb =
-			upper_32_bits(chan->seg_p + sizeof(*chan->seg_mv) *
-				((i + 1) % XILINX_DMA_NUM_DESCS));
+			xilinx_dma_ring_link(chan, i);
 			chan->seg_mv[i].phys = chan->seg_p +
 				sizeof(*chan->seg_mv) * i;
-			list_add_tail(&chan->seg_mv[i].node,
-				      &chan->free_seg_list);
 		}
+		chan->seg_head = 0;
+		chan->seg_tail = 0;
 	} else if (chan->xdev->dma_config->dmatype == XDMA_TYPE_CDMA) {
 		chan->desc_pool = dma_pool_create("xilinx_cdma_desc_pool",
 				   chan->dev,
@@ -1188,7 +1365,7 @@ static int xilinx_dma_alloc_chan_resources(struct dma_chan *dchan)
 		 * other channel as well so enable the interrupts here.
 		 */
 		dma_ctrl_set(chan, XILINX_DMA_REG_DMACR,
-			      XILINX_DMA_DMAXR_ALL_IRQ_MASK);
+			      xilinx_dma_irq_mask(chan));
 	}
 
 	if ((chan->xdev->dma_config->dmatype == XDMA_TYPE_CDMA) && chan->has_sg)
@@ -1227,43 +1404,23 @@ static int xilinx_dma_calc_copysize(struct xilinx_dma_chan *chan,
 }
 
 /**
- * xilinx_dma_tx_status - Get DMA transaction status
- * @dchan: DMA channel
- * @cookie: Transaction identifier
- * @txstate: Transaction state
+ * xilinx_dma_calc_numsegs - Calculate the number of segments for a buffer
+ * @chan: Driver specific DMA channel
+ * @size: Size of the buffer
  *
- * Return: DMA transaction status
+ * Return: Number of segments xilinx_dma_calc_copysize() splits @size into
  */
-static enum dma_status xilinx_dma_tx_status(struct dma_chan *dchan,
-					dma_cookie_t cookie,
-					struct dma_tx_state *txstate)
+static u32 xilinx_dma_calc_numsegs(struct xilinx_dma_chan *chan, size_t size)
 {
-	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
-	struct xilinx_dma_tx_descriptor *desc;
-	enum dma_status ret;
-	unsigned long flags;
-	u32 residue = 0;
-
-	ret = dma_cookie_status(dchan, cookie, txstate);
-	if (ret == DMA_COMPLETE || !txstate)
-		return ret;
+	size_t done = 0;
+	u32 num = 0;
 
-	spin_lock_irqsave(&chan->lock, flags);
-	if (!list_empty(&chan->active_list)) {
-		desc = list_last_entry(&chan->active_list,
-				       struct xilinx_dma_tx_descriptor, node);
-		/*
-		 * VDMA and simple mode do not support residue reporting, so the
-		 * residue field will always be 0.
-		 */
-		if (chan->has_sg && chan->xdev->dma_config->dmatype != XDMA_TYPE_VDMA)
-			residue = xilinx_dma_get_residue(chan, desc);
+	while (done < size) {
+		done += xilinx_dma_calc_copysize(chan, size, done);
+		num++;
 	}
-	spin_unlock_irqrestore(&chan->lock, flags);
-
-	dma_set_residue(txstate, residue);
 
-	return ret;
+	return num;
 }
 
 /**
@@ -1383,6 +1540,12 @@ static void xilinx_vdma_start_transfer(struct xilinx_dma_chan *chan)
 	}
 	dma_write(chan, XILINX_DMA_REG_PARK_PTR, reg);
 
+	/* A reset brings back the synthesized count of frame stores */
+	if (chan->num_frms != chan->max_frms &&
+	    (dma_ctrl_read(chan, XILINX_DMA_REG_DMASR) &
+	     XILINX_DMA_DMASR_HALTED))
+		dma_ctrl_write(chan, XILINX_DMA_REG_FRMSTORE, chan->num_frms);
+
 	/* Start the hardware */
 	xilinx_dma_start(chan);
 
@@ -1416,6 +1579,8 @@ static void xilinx_vdma_start_transfer(struct xilinx_dma_chan *chan)
 			last->hw.stride);
 	vdma_desc_write(chan, XILINX_DMA_REG_VSIZE, last->hw.vsize);
 
+	xdma_stats_start(&chan->stats, &chan->common, 1);
+
 	chan->desc_submitcount++;
 	chan->desc_pendingcount--;
 	list_move_tail(&desc->node, &chan->active_list);
@@ -1492,6 +1657,8 @@ static void xilinx_cdma_start_transfer(struct xilinx_dma_chan *chan)
 				hw->control & chan->xdev->max_buffer_len);
 	}
 
+	xdma_stats_start(&chan->stats, &chan->common, chan->desc_pendingcount);
+
 	list_splice_tail_init(&chan->pending_list, &chan->active_list);
 	chan->desc_pendingcount = 0;
 	chan->idle = false;
@@ -1566,6 +1733,8 @@ static void xilinx_dma_start_transfer(struct xilinx_dma_chan *chan)
 			       hw->control & chan->xdev->max_buffer_len);
 	}
 
+	xdma_stats_start(&chan->stats, &chan->common, chan->desc_pendingcount);
+
 	list_splice_tail_init(&chan->pending_list, &chan->active_list);
 	chan->desc_pendingcount = 0;
 	chan->idle = false;
@@ -1636,6 +1805,8 @@ static void xilinx_mcdma_start_transfer(struct xilinx_dma_chan *chan)
 	xilinx_write(chan, XILINX_MCDMA_CHAN_TDESC_OFFSET(chan->tdest),
 		     tail_segment->phys);
 
+	xdma_stats_start(&chan->stats, &chan->common, chan->desc_pendingcount);
+
 	list_splice_tail_init(&chan->pending_list, &chan->active_list);
 	chan->desc_pendingcount = 0;
 	chan->idle = false;
@@ -1651,10 +1822,41 @@ static void xilinx_dma_issue_pending(struct dma_chan *dchan)
 	unsigned long flags;
 
 	spin_lock_irqsave(&chan->lock, flags);
+	xdma_stats_issue(&chan->stats, dchan, chan->desc_pendingcount);
 	chan->start_transfer(chan);
 	spin_unlock_irqrestore(&chan->lock, flags);
 }
 
+/**
+ * xilinx_mcdma_write_weights - Program the MCDMA MM2S scheduler weights
+ * @xdev: Driver specific device structure
+ *
+ * Write the weight of every MM2S channel that has one configured. The other
+ * channels keep the weight they have in hardware.
+ */
+static void xilinx_mcdma_write_weights(struct xilinx_dma_device *xdev)
+{
+	struct xilinx_dma_chan *chan;
+	unsigned long flags;
+	u32 reg;
+	int i;
+
+	spin_lock_irqsave(&xdev->weight_lock, flags);
+	for (i = 0; i < xdev->dma_config->max_channels; i++) {
+		chan = xdev->chan[i];
+		if (!chan || chan->direction != DMA_MEM_TO_DEV || !chan->weight)
+			continue;
+
+		reg = dma_ctrl_read(chan,
+				    XILINX_MCDMA_TXWEIGHT_OFFSET(chan->tdest));
+		reg &= ~XILINX_MCDMA_TXWEIGHT_MASK(chan->tdest);
+		reg |= chan->weight << XILINX_MCDMA_TXWEIGHT_SHIFT(chan->tdest);
+		dma_ctrl_write(chan, XILINX_MCDMA_TXWEIGHT_OFFSET(chan->tdest),
+			       reg);
+	}
+	spin_unlock_irqrestore(&xdev->weight_lock, flags);
+}
+
 /**
  * xilinx_dma_device_config - Configure the DMA channel
  * @dchan: DMA channel
@@ -1663,6 +1865,57 @@ static void xilinx_dma_issue_pending(struct dma_chan *dchan)
 static int xilinx_dma_device_config(struct dma_chan *dchan,
 				    struct dma_slave_config *config)
 {
+	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
+	enum xdma_ip_type dmatype = chan->xdev->dma_config->dmatype;
+	struct xilinx_dma_peripheral_config *pconfig;
+	unsigned long flags;
+
+	pconfig = config->peripheral_config;
+	if (!pconfig)
+		return 0;
+
+	if (WARN_ON(config->peripheral_size != sizeof(*pconfig)))
+		return -EINVAL;
+
+	if (pconfig->weight &&
+	    (dmatype != XDMA_TYPE_AXIMCDMA ||
+	     chan->direction != DMA_MEM_TO_DEV ||
+	     pconfig->weight > XILINX_MCDMA_WEIGHT_MAX))
+		return -EINVAL;
+
+	switch (pconfig->poll_mode) {
+	case XILINX_DMA_POLL_NONE:
+		break;
+	case XILINX_DMA_POLL_HYBRID:
+		if (!pconfig->poll_budget_us)
+			return -EINVAL;
+		fallthrough;
+	case XILINX_DMA_POLL_ALWAYS:
+		if (dmatype != XDMA_TYPE_AXIDMA && dmatype != XDMA_TYPE_CDMA)
+			return -EINVAL;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	if (dmatype == XDMA_TYPE_AXIDMA || dmatype == XDMA_TYPE_CDMA) {
+		spin_lock_irqsave(&chan->lock, flags);
+		chan->poll_mode = pconfig->poll_mode;
+		chan->poll_budget_us = pconfig->poll_budget_us;
+		if (chan->poll_mode == XILINX_DMA_POLL_ALWAYS)
+			dma_ctrl_clr(chan, XILINX_DMA_REG_DMACR,
+				     XILINX_DMA_DMAXR_DONE_IRQ_MASK);
+		else
+			dma_ctrl_set(chan, XILINX_DMA_REG_DMACR,
+				     XILINX_DMA_DMAXR_DONE_IRQ_MASK);
+		spin_unlock_irqrestore(&chan->lock, flags);
+	}
+
+	if (pconfig->weight) {
+		WRITE_ONCE(chan->weight, pconfig->weight);
+		xilinx_mcdma_write_weights(chan->xdev);
+	}
+
 	return 0;
 }
 
@@ -1689,8 +1942,13 @@ static void xilinx_dma_complete_descriptor(struct xilinx_dma_chan *chan)
 		desc->err = chan->err;
 
 		list_del(&desc->node);
-		if (!desc->cyclic)
+		if (!desc->cyclic) {
+			xdma_stats_complete(&chan->stats, &chan->common,
+					    desc->async_tx.cookie,
+					    desc->len - desc->residue,
+					    desc->submit_ns);
 			dma_cookie_complete(&desc->async_tx);
+		}
 		list_add_tail(&desc->node, &chan->done_list);
 	}
 }
@@ -1745,7 +2003,12 @@ static int xilinx_dma_chan_reset(struct xilinx_dma_chan *chan)
 
 	/* Enable interrupts */
 	dma_ctrl_set(chan, XILINX_DMA_REG_DMACR,
-		      XILINX_DMA_DMAXR_ALL_IRQ_MASK);
+		      xilinx_dma_irq_mask(chan));
+
+	/* The MM2S reset clears the weights of all the MCDMA channels */
+	if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIMCDMA &&
+	    chan->direction == DMA_MEM_TO_DEV)
+		xilinx_mcdma_write_weights(chan->xdev);
 
 	return 0;
 }
@@ -1814,26 +2077,27 @@ static irqreturn_t xilinx_mcdma_irq_handler(int irq, void *data)
 		spin_unlock(&chan->lock);
 	}
 
-	tasklet_schedule(&chan->tasklet);
+	xdma_compl_schedule(&chan->compl);
 	return IRQ_HANDLED;
 }
 
 /**
- * xilinx_dma_irq_handler - DMA Interrupt handler
- * @irq: IRQ number
- * @data: Pointer to the Xilinx DMA channel structure
+ * xilinx_dma_handle_status - Read, ack and handle the channel status
+ * @chan: Driver specific DMA channel
  *
- * Return: IRQ_HANDLED/IRQ_NONE
+ * Shared by the interrupt handler and the polled completion path, must be
+ * called with the channel lock held.
+ *
+ * Return: The interrupt status bits handled, 0 if none were set
  */
-static irqreturn_t xilinx_dma_irq_handler(int irq, void *data)
+static u32 xilinx_dma_handle_status(struct xilinx_dma_chan *chan)
 {
-	struct xilinx_dma_chan *chan = data;
 	u32 status;
 
 	/* Read the status and ack the interrupts. */
 	status = dma_ctrl_read(chan, XILINX_DMA_REG_DMASR);
 	if (!(status & XILINX_DMA_DMAXR_ALL_IRQ_MASK))
-		return IRQ_NONE;
+		return 0;
 
 	dma_ctrl_write(chan, XILINX_DMA_REG_DMASR,
 			status & XILINX_DMA_DMAXR_ALL_IRQ_MASK);
@@ -1871,46 +2135,171 @@ static irqreturn_t xilinx_dma_irq_handler(int irq, void *data)
 	}
 
 	if (status & XILINX_DMA_DMASR_FRM_CNT_IRQ) {
-		spin_lock(&chan->lock);
 		xilinx_dma_complete_descriptor(chan);
 		chan->idle = true;
 		chan->start_transfer(chan);
-		spin_unlock(&chan->lock);
 	}
 
-	tasklet_schedule(&chan->tasklet);
+	return status & XILINX_DMA_DMAXR_ALL_IRQ_MASK;
+}
+
+/**
+ * xilinx_dma_irq_handler - DMA Interrupt handler
+ * @irq: IRQ number
+ * @data: Pointer to the Xilinx DMA channel structure
+ *
+ * Return: IRQ_HANDLED/IRQ_NONE
+ */
+static irqreturn_t xilinx_dma_irq_handler(int irq, void *data)
+{
+	struct xilinx_dma_chan *chan = data;
+	u32 status;
+
+	spin_lock(&chan->lock);
+	status = xilinx_dma_handle_status(chan);
+	spin_unlock(&chan->lock);
+
+	if (!status)
+		return IRQ_NONE;
+
+	xdma_compl_schedule(&chan->compl);
 	return IRQ_HANDLED;
 }
 
 /**
- * append_desc_queue - Queuing descriptor
- * @chan: Driver specific dma channel
- * @desc: dma transaction descriptor
+ * xilinx_dma_poll_complete - Pick up completions without the interrupt
+ * @chan: Driver specific DMA channel
+ *
+ * Completed descriptors are cleaned up and their callbacks run from the
+ * calling context instead of the deferred completion work.
  */
-static void append_desc_queue(struct xilinx_dma_chan *chan,
-			      struct xilinx_dma_tx_descriptor *desc)
+static void xilinx_dma_poll_complete(struct xilinx_dma_chan *chan)
 {
-	struct xilinx_vdma_tx_segment *tail_segment;
-	struct xilinx_dma_tx_descriptor *tail_desc;
-	struct xilinx_axidma_tx_segment *axidma_tail_segment;
-	struct xilinx_aximcdma_tx_segment *aximcdma_tail_segment;
-	struct xilinx_cdma_tx_segment *cdma_tail_segment;
+	unsigned long flags;
+	u32 status;
 
-	if (list_empty(&chan->pending_list))
-		goto append;
+	spin_lock_irqsave(&chan->lock, flags);
+	status = xilinx_dma_handle_status(chan);
+	spin_unlock_irqrestore(&chan->lock, flags);
 
-	/*
-	 * Add the hardware descriptor to the chain of hardware descriptors
-	 * that already exists in memory.
-	 */
-	tail_desc = list_last_entry(&chan->pending_list,
-				    struct xilinx_dma_tx_descriptor, node);
-	if (chan->xdev->dma_config->dmatype == XDMA_TYPE_VDMA) {
-		tail_segment = list_last_entry(&tail_desc->segments,
-					       struct xilinx_vdma_tx_segment,
-					       node);
-		tail_segment->hw.next_desc = (u32)desc->async_tx.phys;
-	} else if (chan->xdev->dma_config->dmatype == XDMA_TYPE_CDMA) {
+	if (status)
+		xilinx_dma_chan_desc_cleanup(chan);
+}
+
+/**
+ * xilinx_dma_poll - Poll for the completion of a transaction
+ * @chan: Driver specific DMA channel
+ * @cookie: Transaction identifier
+ *
+ * In polled mode the status is checked once, the client is expected to
+ * call dmaengine_tx_status() until the transaction is done. In hybrid mode
+ * the IOC interrupt is masked while spinning for up to the poll budget and
+ * re-armed afterwards. A completion that lands in between is still latched
+ * in DMASR and raises the interrupt as soon as it is unmasked.
+ */
+static void xilinx_dma_poll(struct xilinx_dma_chan *chan, dma_cookie_t cookie)
+{
+	unsigned long flags;
+	ktime_t timeout;
+
+	if (chan->poll_mode == XILINX_DMA_POLL_ALWAYS) {
+		xilinx_dma_poll_complete(chan);
+		return;
+	}
+
+	spin_lock_irqsave(&chan->lock, flags);
+	dma_ctrl_clr(chan, XILINX_DMA_REG_DMACR,
+		     XILINX_DMA_DMAXR_DONE_IRQ_MASK);
+	spin_unlock_irqrestore(&chan->lock, flags);
+
+	timeout = ktime_add_us(ktime_get(), chan->poll_budget_us);
+	do {
+		xilinx_dma_poll_complete(chan);
+		if (dma_cookie_status(&chan->common, cookie, NULL) ==
+		    DMA_COMPLETE)
+			break;
+		cpu_relax();
+	} while (ktime_before(ktime_get(), timeout));
+
+	spin_lock_irqsave(&chan->lock, flags);
+	dma_ctrl_set(chan, XILINX_DMA_REG_DMACR,
+		     XILINX_DMA_DMAXR_DONE_IRQ_MASK);
+	spin_unlock_irqrestore(&chan->lock, flags);
+}
+
+/**
+ * xilinx_dma_tx_status - Get DMA transaction status
+ * @dchan: DMA channel
+ * @cookie: Transaction identifier
+ * @txstate: Transaction state
+ *
+ * Return: DMA transaction status
+ */
+static enum dma_status xilinx_dma_tx_status(struct dma_chan *dchan,
+					dma_cookie_t cookie,
+					struct dma_tx_state *txstate)
+{
+	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
+	struct xilinx_dma_tx_descriptor *desc;
+	enum dma_status ret;
+	unsigned long flags;
+	u32 residue = 0;
+
+	ret = dma_cookie_status(dchan, cookie, txstate);
+	if (ret != DMA_COMPLETE && chan->poll_mode != XILINX_DMA_POLL_NONE) {
+		xilinx_dma_poll(chan, cookie);
+		ret = dma_cookie_status(dchan, cookie, txstate);
+	}
+	if (ret == DMA_COMPLETE || !txstate)
+		return ret;
+
+	spin_lock_irqsave(&chan->lock, flags);
+	if (!list_empty(&chan->active_list)) {
+		desc = list_last_entry(&chan->active_list,
+				       struct xilinx_dma_tx_descriptor, node);
+		/*
+		 * VDMA and simple mode do not support residue reporting, so the
+		 * residue field will always be 0.
+		 */
+		if (chan->has_sg && chan->xdev->dma_config->dmatype != XDMA_TYPE_VDMA)
+			residue = xilinx_dma_get_residue(chan, desc);
+	}
+	spin_unlock_irqrestore(&chan->lock, flags);
+
+	dma_set_residue(txstate, residue);
+
+	return ret;
+}
+
+/**
+ * append_desc_queue - Queuing descriptor
+ * @chan: Driver specific dma channel
+ * @desc: dma transaction descriptor
+ */
+static void append_desc_queue(struct xilinx_dma_chan *chan,
+			      struct xilinx_dma_tx_descriptor *desc)
+{
+	struct xilinx_vdma_tx_segment *tail_segment;
+	struct xilinx_dma_tx_descriptor *tail_desc;
+	struct xilinx_axidma_tx_segment *axidma_tail_segment;
+	struct xilinx_aximcdma_tx_segment *aximcdma_tail_segment;
+	struct xilinx_cdma_tx_segment *cdma_tail_segment;
+
+	if (list_empty(&chan->pending_list))
+		goto append;
+
+	/*
+	 * Add the hardware descriptor to the chain of hardware descriptors
+	 * that already exists in memory.
+	 */
+	tail_desc = list_last_entry(&chan->pending_list,
+				    struct xilinx_dma_tx_descriptor, node);
+	if (chan->xdev->dma_config->dmatype == XDMA_TYPE_VDMA) {
+		tail_segment = list_last_entry(&tail_desc->segments,
+					       struct xilinx_vdma_tx_segment,
+					       node);
+		tail_segment->hw.next_desc = (u32)desc->async_tx.phys;
+	} else if (chan->xdev->dma_config->dmatype == XDMA_TYPE_CDMA) {
 		cdma_tail_segment = list_last_entry(&tail_desc->segments,
 						struct xilinx_cdma_tx_segment,
 						node);
@@ -1958,7 +2347,9 @@ static dma_cookie_t xilinx_dma_tx_submit(struct dma_async_tx_descriptor *tx)
 	int err;
 
 	if (chan->cyclic) {
+		spin_lock_irqsave(&chan->lock, flags);
 		xilinx_dma_free_tx_descriptor(chan, desc);
+		spin_unlock_irqrestore(&chan->lock, flags);
 		return -EBUSY;
 	}
 
@@ -1972,9 +2363,13 @@ static dma_cookie_t xilinx_dma_tx_submit(struct dma_async_tx_descriptor *tx)
 			return err;
 	}
 
+	desc->len = xilinx_dma_get_len(chan, desc);
+
 	spin_lock_irqsave(&chan->lock, flags);
 
 	cookie = dma_cookie_assign(tx);
+	desc->submit_ns = xdma_stats_submit(&chan->stats, tx->chan, cookie,
+					    desc->len);
 
 	/* Put this transaction onto the tail of the pending queue */
 	append_desc_queue(chan, desc);
@@ -2007,6 +2402,9 @@ xilinx_vdma_dma_prep_interleaved(struct dma_chan *dchan,
 	struct xilinx_dma_tx_descriptor *desc;
 	struct xilinx_vdma_tx_segment *segment;
 	struct xilinx_vdma_desc_hw *hw;
+	unsigned int align;
+	dma_addr_t addr;
+	size_t stride;
 
 	if (!is_slave_direction(xt->dir))
 		return NULL;
@@ -2017,6 +2415,37 @@ xilinx_vdma_dma_prep_interleaved(struct dma_chan *dchan,
 	if (xt->frame_size != 1)
 		return NULL;
 
+	/*
+	 * A cropped window of a larger frame is read or written by starting
+	 * at its first pixel and skipping the rest of the lines as the gap.
+	 * The memory side gap is used when given, the common one otherwise.
+	 */
+	stride = xt->sgl[0].size + xt->sgl[0].icg;
+	if (xt->dir == DMA_MEM_TO_DEV) {
+		addr = xt->src_start;
+		if (xt->src_sgl)
+			stride = xt->sgl[0].size +
+				 dmaengine_get_src_icg(xt, &xt->sgl[0]);
+	} else {
+		addr = xt->dst_start;
+		if (xt->dst_sgl)
+			stride = xt->sgl[0].size +
+				 dmaengine_get_dst_icg(xt, &xt->sgl[0]);
+	}
+
+	if (xt->numf > XILINX_DMA_VSIZE_MAX ||
+	    xt->sgl[0].size > XILINX_DMA_HSIZE_MAX ||
+	    stride > XILINX_DMA_FRMDLY_STRIDE_STRIDE_MAX)
+		return NULL;
+
+	/* Without DRE the window must start on a stream word */
+	align = 1 << chan->xdev->common.copy_align;
+	if (!IS_ALIGNED(addr, align) || !IS_ALIGNED(stride, align)) {
+		dev_dbg(chan->dev, "window %pad/%zu not %u bytes aligned\n",
+			&addr, stride, align);
+		return NULL;
+	}
+
 	/* Allocate a transaction descriptor. */
 	desc = xilinx_dma_alloc_tx_descriptor(chan);
 	if (!desc)
@@ -2035,25 +2464,15 @@ xilinx_vdma_dma_prep_interleaved(struct dma_chan *dchan,
 	hw = &segment->hw;
 	hw->vsize = xt->numf;
 	hw->hsize = xt->sgl[0].size;
-	hw->stride = (xt->sgl[0].icg + xt->sgl[0].size) <<
-			XILINX_DMA_FRMDLY_STRIDE_STRIDE_SHIFT;
+	hw->stride = stride << XILINX_DMA_FRMDLY_STRIDE_STRIDE_SHIFT;
 	hw->stride |= chan->config.frm_dly <<
 			XILINX_DMA_FRMDLY_STRIDE_FRMDLY_SHIFT;
 
-	if (xt->dir != DMA_MEM_TO_DEV) {
-		if (chan->ext_addr) {
-			hw->buf_addr = lower_32_bits(xt->dst_start);
-			hw->buf_addr_msb = upper_32_bits(xt->dst_start);
-		} else {
-			hw->buf_addr = xt->dst_start;
-		}
+	if (chan->ext_addr) {
+		hw->buf_addr = lower_32_bits(addr);
+		hw->buf_addr_msb = upper_32_bits(addr);
 	} else {
-		if (chan->ext_addr) {
-			hw->buf_addr = lower_32_bits(xt->src_start);
-			hw->buf_addr_msb = upper_32_bits(xt->src_start);
-		} else {
-			hw->buf_addr = xt->src_start;
-		}
+		hw->buf_addr = addr;
 	}
 
 	/* Insert the segment into the descriptor segments list. */
@@ -2127,6 +2546,187 @@ xilinx_cdma_prep_memcpy(struct dma_chan *dchan, dma_addr_t dma_dst,
 	return NULL;
 }
 
+/**
+ * xilinx_cdma_prep_interleaved - prepare descriptors for a 2D memcpy
+ * @dchan: DMA channel
+ * @xt: Interleaved template pointer
+ * @flags: transfer ack flags
+ *
+ * Every chunk of every frame becomes one or more CDMA segments, chained in
+ * a single transaction. More than one segment needs the SG mode.
+ *
+ * Return: Async transaction descriptor on success and NULL on failure
+ */
+static struct dma_async_tx_descriptor *
+xilinx_cdma_prep_interleaved(struct dma_chan *dchan,
+			     struct dma_interleaved_template *xt,
+			     unsigned long flags)
+{
+	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
+	struct xilinx_cdma_tx_segment *segment, *prev = NULL;
+	struct xilinx_dma_tx_descriptor *desc;
+	dma_addr_t src = xt->src_start, dst = xt->dst_start;
+	struct xilinx_cdma_desc_hw *hw;
+	size_t copy, done;
+	u32 num_segs = 0;
+	unsigned int i;
+	size_t f;
+
+	if (xt->dir != DMA_MEM_TO_MEM || !xt->src_inc || !xt->dst_inc)
+		return NULL;
+
+	if (!xt->numf || !xt->frame_size)
+		return NULL;
+
+	for (i = 0; i < xt->frame_size; i++)
+		num_segs += xilinx_dma_calc_numsegs(chan, xt->sgl[i].size);
+	if (!num_segs || (!chan->has_sg && (num_segs > 1 || xt->numf > 1)))
+		return NULL;
+
+	desc = xilinx_dma_alloc_tx_descriptor(chan);
+	if (!desc)
+		return NULL;
+
+	dma_async_tx_descriptor_init(&desc->async_tx, &chan->common);
+	desc->async_tx.tx_submit = xilinx_dma_tx_submit;
+
+	for (f = 0; f < xt->numf; f++) {
+		for (i = 0; i < xt->frame_size; i++) {
+			struct data_chunk *chunk = &xt->sgl[i];
+
+			for (done = 0; done < chunk->size; done += copy) {
+				segment = xilinx_cdma_alloc_tx_segment(chan);
+				if (!segment)
+					goto error;
+
+				copy = xilinx_dma_calc_copysize(chan,
+								chunk->size,
+								done);
+				hw = &segment->hw;
+				hw->control = copy;
+				hw->src_addr = src + done;
+				hw->dest_addr = dst + done;
+				if (chan->ext_addr) {
+					hw->src_addr_msb =
+						upper_32_bits(src + done);
+					hw->dest_addr_msb =
+						upper_32_bits(dst + done);
+				}
+
+				if (prev) {
+					prev->hw.next_desc =
+						lower_32_bits(segment->phys);
+					prev->hw.next_desc_msb =
+						upper_32_bits(segment->phys);
+				}
+				prev = segment;
+
+				list_add_tail(&segment->node, &desc->segments);
+			}
+
+			src += chunk->size + dmaengine_get_src_icg(xt, chunk);
+			dst += chunk->size + dmaengine_get_dst_icg(xt, chunk);
+		}
+	}
+
+	segment = list_first_entry(&desc->segments,
+				   struct xilinx_cdma_tx_segment, node);
+	desc->async_tx.phys = segment->phys;
+	prev->hw.next_desc = segment->phys;
+
+	return &desc->async_tx;
+
+error:
+	xilinx_dma_free_tx_descriptor(chan, desc);
+	return NULL;
+}
+
+/**
+ * xilinx_cdma_prep_batch - prepare a single transaction for a batch of copies
+ * @dchan: DMA channel
+ * @xfers: copies of the batch
+ * @nr: number of entries in @xfers
+ * @direction: DMA direction, must be DMA_MEM_TO_MEM
+ * @flags: transfer ack flags
+ *
+ * All the copies are chained in one transaction, which needs the SG mode
+ * for more than one segment.
+ *
+ * Return: Async transaction descriptor on success and NULL on failure
+ */
+static struct dma_async_tx_descriptor *
+xilinx_cdma_prep_batch(struct dma_chan *dchan,
+		       const struct dma_batch_xfer *xfers, unsigned int nr,
+		       enum dma_transfer_direction direction,
+		       unsigned long flags)
+{
+	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
+	struct xilinx_cdma_tx_segment *segment, *prev = NULL;
+	struct xilinx_dma_tx_descriptor *desc;
+	struct xilinx_cdma_desc_hw *hw;
+	size_t copy, done;
+	u32 num_segs = 0;
+	unsigned int i;
+
+	if (direction != DMA_MEM_TO_MEM)
+		return NULL;
+
+	for (i = 0; i < nr; i++)
+		num_segs += xilinx_dma_calc_numsegs(chan, xfers[i].len);
+	if (!num_segs || (!chan->has_sg && num_segs > 1))
+		return NULL;
+
+	desc = xilinx_dma_alloc_tx_descriptor(chan);
+	if (!desc)
+		return NULL;
+
+	dma_async_tx_descriptor_init(&desc->async_tx, &chan->common);
+	desc->async_tx.tx_submit = xilinx_dma_tx_submit;
+
+	for (i = 0; i < nr; i++) {
+		const struct dma_batch_xfer *xfer = &xfers[i];
+
+		for (done = 0; done < xfer->len; done += copy) {
+			segment = xilinx_cdma_alloc_tx_segment(chan);
+			if (!segment)
+				goto error;
+
+			copy = xilinx_dma_calc_copysize(chan, xfer->len, done);
+			hw = &segment->hw;
+			hw->control = copy;
+			hw->src_addr = xfer->src + done;
+			hw->dest_addr = xfer->dst + done;
+			if (chan->ext_addr) {
+				hw->src_addr_msb = upper_32_bits(xfer->src +
+								 done);
+				hw->dest_addr_msb = upper_32_bits(xfer->dst +
+								  done);
+			}
+
+			if (prev) {
+				prev->hw.next_desc =
+					lower_32_bits(segment->phys);
+				prev->hw.next_desc_msb =
+					upper_32_bits(segment->phys);
+			}
+			prev = segment;
+
+			list_add_tail(&segment->node, &desc->segments);
+		}
+	}
+
+	segment = list_first_entry(&desc->segments,
+				   struct xilinx_cdma_tx_segment, node);
+	desc->async_tx.phys = segment->phys;
+	prev->hw.next_desc = segment->phys;
+
+	return &desc->async_tx;
+
+error:
+	xilinx_dma_free_tx_descriptor(chan, desc);
+	return NULL;
+}
+
 /**
  * xilinx_dma_prep_slave_sg - prepare descriptors for a DMA_SLAVE transaction
  * @dchan: DMA channel
@@ -2148,13 +2748,20 @@ static struct dma_async_tx_descriptor *xilinx_dma_prep_slave_sg(
 	struct xilinx_axidma_tx_segment *segment = NULL;
 	u32 *app_w = (u32 *)context;
 	struct scatterlist *sg;
+	u32 num_segs = 0;
 	size_t copy;
 	size_t sg_used;
 	unsigned int i;
+	int idx;
 
 	if (!is_slave_direction(direction))
 		return NULL;
 
+	for_each_sg(sgl, sg, sg_len, i)
+		num_segs += xilinx_dma_calc_numsegs(chan, sg_dma_len(sg));
+	if (!num_segs)
+		return NULL;
+
 	/* Allocate a transaction descriptor. */
 	desc = xilinx_dma_alloc_tx_descriptor(chan);
 	if (!desc)
@@ -2163,6 +2770,11 @@ static struct dma_async_tx_descriptor *xilinx_dma_prep_slave_sg(
 	dma_async_tx_descriptor_init(&desc->async_tx, &chan->common);
 	desc->async_tx.tx_submit = xilinx_dma_tx_submit;
 
+	/* Take all the segments at once, they are already chained */
+	idx = xilinx_dma_ring_reserve(chan, num_segs);
+	if (idx < 0)
+		goto error;
+
 	/* Build transactions using information in the scatter gather list */
 	for_each_sg(sgl, sg, sg_len, i) {
 		sg_used = 0;
@@ -2171,10 +2783,8 @@ static struct dma_async_tx_descriptor *xilinx_dma_prep_slave_sg(
 		while (sg_used < sg_dma_len(sg)) {
 			struct xilinx_axidma_desc_hw *hw;
 
-			/* Get a free segment */
-			segment = xilinx_axidma_alloc_tx_segment(chan);
-			if (!segment)
-				goto error;
+			segment = &chan->seg_v[idx];
+			idx = xilinx_dma_ring_add(idx, 1);
 
 			/*
 			 * Calculate the maximum number of bytes to transfer,
@@ -2226,6 +2836,187 @@ static struct dma_async_tx_descriptor *xilinx_dma_prep_slave_sg(
 	return NULL;
 }
 
+/**
+ * xilinx_dma_prep_batch - prepare a single transaction for a batch of
+ *	DMA_SLAVE transfers
+ * @dchan: DMA channel
+ * @xfers: transfers of the batch
+ * @nr: number of entries in @xfers
+ * @direction: DMA direction
+ * @flags: transfer ack flags
+ *
+ * The BDs of all the transfers are taken from the ring at once, so the
+ * batch is started with a single tail pointer write. For DMA_MEM_TO_DEV
+ * every transfer is sent as its own packet.
+ *
+ * Return: Async transaction descriptor on success and NULL on failure
+ */
+static struct dma_async_tx_descriptor *
+xilinx_dma_prep_batch(struct dma_chan *dchan,
+		      const struct dma_batch_xfer *xfers, unsigned int nr,
+		      enum dma_transfer_direction direction,
+		      unsigned long flags)
+{
+	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
+	struct xilinx_axidma_tx_segment *segment = NULL;
+	struct xilinx_dma_tx_descriptor *desc;
+	u32 num_segs = 0;
+	dma_addr_t addr;
+	size_t copy, done;
+	unsigned int i;
+	int idx;
+
+	if (direction != chan->direction)
+		return NULL;
+
+	for (i = 0; i < nr; i++)
+		num_segs += xilinx_dma_calc_numsegs(chan, xfers[i].len);
+	if (!num_segs)
+		return NULL;
+
+	desc = xilinx_dma_alloc_tx_descriptor(chan);
+	if (!desc)
+		return NULL;
+
+	dma_async_tx_descriptor_init(&desc->async_tx, &chan->common);
+	desc->async_tx.tx_submit = xilinx_dma_tx_submit;
+
+	idx = xilinx_dma_ring_reserve(chan, num_segs);
+	if (idx < 0)
+		goto error;
+
+	for (i = 0; i < nr; i++) {
+		addr = direction == DMA_MEM_TO_DEV ? xfers[i].src :
+						     xfers[i].dst;
+
+		for (done = 0; done < xfers[i].len; done += copy) {
+			segment = &chan->seg_v[idx];
+			idx = xilinx_dma_ring_add(idx, 1);
+
+			copy = xilinx_dma_calc_copysize(chan, xfers[i].len,
+							done);
+			xilinx_axidma_buf(chan, &segment->hw, addr, done, 0);
+			segment->hw.control = copy;
+
+			if (direction == DMA_MEM_TO_DEV && !done)
+				segment->hw.control |= XILINX_DMA_BD_SOP;
+
+			list_add_tail(&segment->node, &desc->segments);
+		}
+
+		if (direction == DMA_MEM_TO_DEV && segment)
+			segment->hw.control |= XILINX_DMA_BD_EOP;
+	}
+
+	segment = list_first_entry(&desc->segments,
+				   struct xilinx_axidma_tx_segment, node);
+	desc->async_tx.phys = segment->phys;
+
+	return &desc->async_tx;
+
+error:
+	xilinx_dma_free_tx_descriptor(chan, desc);
+	return NULL;
+}
+
+/**
+ * xilinx_dma_prep_interleaved - prepare descriptors for a 2D DMA_SLAVE
+ *	transaction
+ * @dchan: DMA channel
+ * @xt: Interleaved template pointer
+ * @flags: transfer ack flags
+ *
+ * Build the BD chain straight from the template: every chunk of every frame
+ * takes one or more consecutive BDs of the ring, and the memory address
+ * skips the inter chunk gap of the memory side after each chunk. For
+ * DMA_MEM_TO_DEV the whole template is sent as one packet.
+ *
+ * Return: Async transaction descriptor on success and NULL on failure
+ */
+static struct dma_async_tx_descriptor *
+xilinx_dma_prep_interleaved(struct dma_chan *dchan,
+			    struct dma_interleaved_template *xt,
+			    unsigned long flags)
+{
+	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
+	struct xilinx_axidma_tx_segment *segment;
+	struct xilinx_dma_tx_descriptor *desc;
+	size_t copy, done, icg;
+	dma_addr_t addr;
+	u32 num_segs = 0;
+	unsigned int i;
+	size_t f;
+	int idx;
+
+	if (!is_slave_direction(xt->dir) || xt->dir != chan->direction)
+		return NULL;
+
+	if (!xt->numf || !xt->frame_size)
+		return NULL;
+
+	for (i = 0; i < xt->frame_size; i++)
+		num_segs += xilinx_dma_calc_numsegs(chan, xt->sgl[i].size);
+	if (!num_segs || xt->numf >= XILINX_DMA_NUM_DESCS / num_segs)
+		return NULL;
+	num_segs *= xt->numf;
+
+	desc = xilinx_dma_alloc_tx_descriptor(chan);
+	if (!desc)
+		return NULL;
+
+	dma_async_tx_descriptor_init(&desc->async_tx, &chan->common);
+	desc->async_tx.tx_submit = xilinx_dma_tx_submit;
+
+	idx = xilinx_dma_ring_reserve(chan, num_segs);
+	if (idx < 0)
+		goto error;
+
+	addr = xt->dir == DMA_MEM_TO_DEV ? xt->src_start : xt->dst_start;
+	for (f = 0; f < xt->numf; f++) {
+		for (i = 0; i < xt->frame_size; i++) {
+			struct data_chunk *chunk = &xt->sgl[i];
+
+			for (done = 0; done < chunk->size; done += copy) {
+				segment = &chan->seg_v[idx];
+				idx = xilinx_dma_ring_add(idx, 1);
+
+				copy = xilinx_dma_calc_copysize(chan,
+								chunk->size,
+								done);
+				xilinx_axidma_buf(chan, &segment->hw, addr,
+						  done, 0);
+				segment->hw.control = copy;
+
+				list_add_tail(&segment->node, &desc->segments);
+			}
+
+			if (xt->dir == DMA_MEM_TO_DEV)
+				icg = dmaengine_get_src_icg(xt, chunk);
+			else
+				icg = dmaengine_get_dst_icg(xt, chunk);
+			addr += chunk->size + icg;
+		}
+	}
+
+	segment = list_first_entry(&desc->segments,
+				   struct xilinx_axidma_tx_segment, node);
+	desc->async_tx.phys = segment->phys;
+
+	if (chan->direction == DMA_MEM_TO_DEV) {
+		segment->hw.control |= XILINX_DMA_BD_SOP;
+		segment = list_last_entry(&desc->segments,
+					  struct xilinx_axidma_tx_segment,
+					  node);
+		segment->hw.control |= XILINX_DMA_BD_EOP;
+	}
+
+	return &desc->async_tx;
+
+error:
+	xilinx_dma_free_tx_descriptor(chan, desc);
+	return NULL;
+}
+
 /**
  * xilinx_dma_prep_dma_cyclic - prepare descriptors for a DMA_SLAVE transaction
  * @dchan: DMA channel
@@ -2247,7 +3038,7 @@ static struct dma_async_tx_descriptor *xilinx_dma_prep_dma_cyclic(
 	struct xilinx_axidma_tx_segment *segment, *head_segment, *prev = NULL;
 	size_t copy, sg_used;
 	unsigned int num_periods;
-	int i;
+	int i, idx;
 	u32 reg;
 
 	if (!period_len)
@@ -2270,16 +3061,19 @@ static struct dma_async_tx_descriptor *xilinx_dma_prep_dma_cyclic(
 	dma_async_tx_descriptor_init(&desc->async_tx, &chan->common);
 	desc->async_tx.tx_submit = xilinx_dma_tx_submit;
 
+	idx = xilinx_dma_ring_reserve(chan, num_periods *
+				      xilinx_dma_calc_numsegs(chan, period_len));
+	if (idx < 0)
+		goto error;
+
 	for (i = 0; i < num_periods; ++i) {
 		sg_used = 0;
 
 		while (sg_used < period_len) {
 			struct xilinx_axidma_desc_hw *hw;
 
-			/* Get a free segment */
-			segment = xilinx_axidma_alloc_tx_segment(chan);
-			if (!segment)
-				goto error;
+			segment = &chan->seg_v[idx];
+			idx = xilinx_dma_ring_add(idx, 1);
 
 			/*
 			 * Calculate the maximum number of bytes to transfer,
@@ -2355,13 +3149,21 @@ xilinx_mcdma_prep_slave_sg(struct dma_chan *dchan, struct scatterlist *sgl,
 	struct xilinx_aximcdma_tx_segment *segment = NULL;
 	u32 *app_w = (u32 *)context;
 	struct scatterlist *sg;
+	u32 num_segs = 0;
 	size_t copy;
 	size_t sg_used;
 	unsigned int i;
+	int idx;
 
 	if (!is_slave_direction(direction))
 		return NULL;
 
+	for_each_sg(sgl, sg, sg_len, i)
+		num_segs += DIV_ROUND_UP(sg_dma_len(sg),
+					 chan->xdev->max_buffer_len);
+	if (!num_segs)
+		return NULL;
+
 	/* Allocate a transaction descriptor. */
 	desc = xilinx_dma_alloc_tx_descriptor(chan);
 	if (!desc)
@@ -2370,6 +3172,11 @@ xilinx_mcdma_prep_slave_sg(struct dma_chan *dchan, struct scatterlist *sgl,
 	dma_async_tx_descriptor_init(&desc->async_tx, &chan->common);
 	desc->async_tx.tx_submit = xilinx_dma_tx_submit;
 
+	/* Take all the segments at once, they are already chained */
+	idx = xilinx_dma_ring_reserve(chan, num_segs);
+	if (idx < 0)
+		goto error;
+
 	/* Build transactions using information in the scatter gather list */
 	for_each_sg(sgl, sg, sg_len, i) {
 		sg_used = 0;
@@ -2378,10 +3185,8 @@ xilinx_mcdma_prep_slave_sg(struct dma_chan *dchan, struct scatterlist *sgl,
 		while (sg_used < sg_dma_len(sg)) {
 			struct xilinx_aximcdma_desc_hw *hw;
 
-			/* Get a free segment */
-			segment = xilinx_aximcdma_alloc_tx_segment(chan);
-			if (!segment)
-				goto error;
+			segment = &chan->seg_mv[idx];
+			idx = xilinx_dma_ring_add(idx, 1);
 
 			/*
 			 * Calculate the maximum number of bytes to transfer,
@@ -2477,7 +3282,11 @@ static void xilinx_dma_synchronize(struct dma_chan *dchan)
 {
 	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
 
-	tasklet_kill(&chan->tasklet);
+	xdma_compl_kill(&chan->compl);
+
+	/* A polling tx_status() caller may still be running callbacks */
+	wait_var_event(&chan->cleanup_running,
+		       !READ_ONCE(chan->cleanup_running));
 }
 
 /**
@@ -2487,6 +3296,7 @@ static void xilinx_dma_synchronize(struct dma_chan *dchan)
  * . configure interrupt coalescing and inter-packet delay threshold
  * . start/stop parking
  * . enable genlock
+ * . reduce the number of frame stores in use, while the channel is halted
  *
  * @dchan: DMA channel
  * @cfg: VDMA device configuration pointer
@@ -2497,11 +3307,32 @@ int xilinx_vdma_channel_set_config(struct dma_chan *dchan,
 					struct xilinx_vdma_config *cfg)
 {
 	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
+	unsigned long flags;
 	u32 dmacr;
 
 	if (cfg->reset)
 		return xilinx_dma_chan_reset(chan);
 
+	if (cfg->num_fstores && cfg->num_fstores != chan->num_frms) {
+		if (cfg->num_fstores < 0 || cfg->num_fstores > chan->max_frms)
+			return -EINVAL;
+
+		if (!(dma_ctrl_read(chan, XILINX_DMA_REG_DMASR) &
+		      XILINX_DMA_DMASR_HALTED))
+			return -EBUSY;
+
+		/* The register is only writable if the IP was built so */
+		dma_ctrl_write(chan, XILINX_DMA_REG_FRMSTORE, cfg->num_fstores);
+		if ((dma_ctrl_read(chan, XILINX_DMA_REG_FRMSTORE) &
+		     XILINX_DMA_FRMSTORE_MASK) != cfg->num_fstores)
+			return -EOPNOTSUPP;
+
+		spin_lock_irqsave(&chan->lock, flags);
+		chan->num_frms = cfg->num_fstores;
+		chan->desc_submitcount = 0;
+		spin_unlock_irqrestore(&chan->lock, flags);
+	}
+
 	dmacr = dma_ctrl_read(chan, XILINX_DMA_REG_DMACR);
 
 	chan->config.frm_dly = cfg->frm_dly;
@@ -2568,7 +3399,7 @@ static void xilinx_dma_chan_remove(struct xilinx_dma_chan *chan)
 	if (chan->irq > 0)
 		free_irq(chan->irq, chan);
 
-	tasklet_kill(&chan->tasklet);
+	xdma_compl_kill(&chan->compl);
 
 	list_del(&chan->common.device_node);
 }
@@ -2789,7 +3620,6 @@ static int xilinx_dma_chan_probe(struct xilinx_dma_device *xdev,
 	INIT_LIST_HEAD(&chan->pending_list);
 	INIT_LIST_HEAD(&chan->done_list);
 	INIT_LIST_HEAD(&chan->active_list);
-	INIT_LIST_HEAD(&chan->free_seg_list);
 
 	/* Retrieve the channel properties from the device tree */
 	has_dre = of_property_read_bool(node, "xlnx,include-dre");
@@ -2894,8 +3724,22 @@ static int xilinx_dma_chan_probe(struct xilinx_dma_device *xdev,
 			chan->has_sg ? "enabled" : "disabled");
 	}
 
-	/* Initialize the tasklet */
-	tasklet_setup(&chan->tasklet, xilinx_dma_do_tasklet);
+	/* Polled completion is only wired up for AXI DMA and CDMA */
+	if (xdev->dma_config->dmatype == XDMA_TYPE_AXIDMA ||
+	    xdev->dma_config->dmatype == XDMA_TYPE_CDMA) {
+		if (of_property_read_bool(node, "xlnx,poll-completion")) {
+			chan->poll_mode = XILINX_DMA_POLL_ALWAYS;
+		} else if (!of_property_read_u32(node, "xlnx,poll-budget-us",
+						 &value) && value) {
+			chan->poll_mode = XILINX_DMA_POLL_HYBRID;
+			chan->poll_budget_us = value;
+		}
+	}
+
+	/* Initialize the deferred completion work */
+	xdma_compl_item_init(&chan->compl, &xdev->compl, xilinx_dma_do_compl,
+			     chan);
+	xdma_stats_init(&chan->stats);
 
 	/*
 	 * Initialize the DMA channel and add it to the DMA engine channels
@@ -3023,6 +3867,7 @@ static int xilinx_dma_probe(struct platform_device *pdev)
 		return -ENOMEM;
 
 	xdev->dev = &pdev->dev;
+	spin_lock_init(&xdev->weight_lock);
 	if (np) {
 		const struct of_device_id *match;
 
@@ -3117,15 +3962,23 @@ static int xilinx_dma_probe(struct platform_device *pdev)
 	xdev->common.device_config = xilinx_dma_device_config;
 	if (xdev->dma_config->dmatype == XDMA_TYPE_AXIDMA) {
 		dma_cap_set(DMA_CYCLIC, xdev->common.cap_mask);
+		dma_cap_set(DMA_INTERLEAVE, xdev->common.cap_mask);
 		xdev->common.device_prep_slave_sg = xilinx_dma_prep_slave_sg;
+		xdev->common.device_prep_interleaved_dma =
+					  xilinx_dma_prep_interleaved;
 		xdev->common.device_prep_dma_cyclic =
 					  xilinx_dma_prep_dma_cyclic;
+		xdev->common.device_prep_batch = xilinx_dma_prep_batch;
 		/* Residue calculation is supported by only AXI DMA and CDMA */
 		xdev->common.residue_granularity =
 					  DMA_RESIDUE_GRANULARITY_SEGMENT;
 	} else if (xdev->dma_config->dmatype == XDMA_TYPE_CDMA) {
 		dma_cap_set(DMA_MEMCPY, xdev->common.cap_mask);
+		dma_cap_set(DMA_INTERLEAVE, xdev->common.cap_mask);
 		xdev->common.device_prep_dma_memcpy = xilinx_cdma_prep_memcpy;
+		xdev->common.device_prep_interleaved_dma =
+					  xilinx_cdma_prep_interleaved;
+		xdev->common.device_prep_batch = xilinx_cdma_prep_batch;
 		/* Residue calculation is supported by only AXI DMA and CDMA */
 		xdev->common.residue_granularity =
 					  DMA_RESIDUE_GRANULARITY_SEGMENT;
@@ -3138,6 +3991,10 @@ static int xilinx_dma_probe(struct platform_device *pdev)
 
 	platform_set_drvdata(pdev, xdev);
 
+	err = devm_xdma_compl_init(&pdev->dev, &xdev->compl);
+	if (err)
+		goto disable_clks;
+
 	/* Initialize the channels */
 	for_each_child_of_node(node, child) {
 		err = xilinx_dma_child_probe(xdev, child);
@@ -3146,9 +4003,12 @@ static int xilinx_dma_probe(struct platform_device *pdev)
 	}
 
 	if (xdev->dma_config->dmatype == XDMA_TYPE_VDMA) {
-		for (i = 0; i < xdev->dma_config->max_channels; i++)
-			if (xdev->chan[i])
+		for (i = 0; i < xdev->dma_config->max_channels; i++) {
+			if (xdev->chan[i]) {
 				xdev->chan[i]->num_frms = num_frames;
+				xdev->chan[i]->max_frms = num_frames;
+			}
+		}
 	}
 
 	/* Register the DMA engine with the core */
@@ -3158,6 +4018,15 @@ static int xilinx_dma_probe(struct platform_device *pdev)
 		goto error;
 	}
 
+	for (i = 0; i < xdev->dma_config->max_channels; i++) {
+		struct xilinx_dma_chan *chan = xdev->chan[i];
+
+		if (chan)
+			xdma_stats_debugfs_init(&chan->stats,
+						xdev->common.dbg_dev_root,
+						dma_chan_name(&chan->common));
+	}
+
 	err = of_dma_controller_register(node, of_dma_xilinx_xlate,
 					 xdev);
 	if (err < 0) {
@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Deferred completion handling for the Xilinx DMA engine drivers
+ *
+ * Copyright (C) 2023 Xilinx, Inc. All rights reserved.
+ *
+ * The AXI DMA, ZynqMP DMA and framebuffer DMA drivers run their descriptor
+ * cleanup and client callbacks outside of the interrupt handler. By default
+ * that is a tasklet on the CPU that took the interrupt, which is cheap but
+ * lets a busy device monopolise that CPU. The device node can instead steer
+ * the handlers of all its channels to one CPU with "xlnx,completion-cpu",
+ * and/or move them to a dedicated kthread with "xlnx,completion-thread".
+ */
+
+#include <linux/cpumask.h>
+#include <linux/device.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/sched.h>
+
+#include "xilinx_dma_compl.h"
+
+static void xdma_compl_tasklet_fn(struct tasklet_struct *t)
+{
+	struct xdma_compl_item *item = from_tasklet(item, t, tasklet);
+
+	item->fn(item->data);
+}
+
+static void xdma_compl_work_fn(struct work_struct *work)
+{
+	struct xdma_compl_item *item = container_of(work,
+						    struct xdma_compl_item,
+						    work);
+
+	item->fn(item->data);
+}
+
+static void xdma_compl_kwork_fn(struct kthread_work *kwork)
+{
+	struct xdma_compl_item *item = container_of(kwork,
+						    struct xdma_compl_item,
+						    kwork);
+
+	item->fn(item->data);
+}
+
+static void xdma_compl_destroy(void *data)
+{
+	struct xdma_compl *compl = data;
+
+	if (compl->worker)
+		kthread_destroy_worker(compl->worker);
+}
+
+/**
+ * devm_xdma_compl_init - Set up the completion backend of a DMA device
+ * @dev: DMA device, its OF node selects the backend
+ * @compl: Backend to initialize
+ *
+ * Return: '0' on success and failure value on error
+ */
+int devm_xdma_compl_init(struct device *dev, struct xdma_compl *compl)
+{
+	struct device_node *node = dev->of_node;
+	struct kthread_worker *worker;
+	u32 cpu;
+
+	compl->mode = XDMA_COMPL_TASKLET;
+	compl->cpu = -1;
+	compl->worker = NULL;
+
+	if (!of_property_read_u32(node, "xlnx,completion-cpu", &cpu)) {
+		if (cpu < nr_cpu_ids && cpu_possible(cpu)) {
+			compl->mode = XDMA_COMPL_CPU;
+			compl->cpu = cpu;
+		} else {
+			dev_warn(dev, "invalid completion CPU %u, ignoring\n",
+				 cpu);
+		}
+	}
+
+	if (!of_property_read_bool(node, "xlnx,completion-thread"))
+		return 0;
+
+	if (compl->cpu >= 0)
+		worker = kthread_create_worker_on_cpu(compl->cpu, 0,
+						      "%s/%d", dev_name(dev),
+						      compl->cpu);
+	else
+		worker = kthread_create_worker(0, "%s", dev_name(dev));
+	if (IS_ERR(worker)) {
+		dev_err(dev, "unable to create completion thread\n");
+		return PTR_ERR(worker);
+	}
+
+	/* Keep up with the softirq context the tasklet would run in */
+	sched_set_fifo_low(worker->task);
+
+	compl->mode = XDMA_COMPL_THREAD;
+	compl->worker = worker;
+
+	return devm_add_action_or_reset(dev, xdma_compl_destroy, compl);
+}
+EXPORT_SYMBOL_GPL(devm_xdma_compl_init);
+
+/**
+ * xdma_compl_item_init - Set up the completion handler of a channel
+ * @item: Channel completion handler
+ * @compl: Backend of the device the channel belongs to
+ * @fn: Handler to run from the backend context
+ * @data: Argument of @fn
+ */
+void xdma_compl_item_init(struct xdma_compl_item *item,
+			  struct xdma_compl *compl,
+			  void (*fn)(void *data), void *data)
+{
+	item->compl = compl;
+	item->fn = fn;
+	item->data = data;
+
+	switch (compl->mode) {
+	case XDMA_COMPL_CPU:
+		INIT_WORK(&item->work, xdma_compl_work_fn);
+		break;
+	case XDMA_COMPL_THREAD:
+		kthread_init_work(&item->kwork, xdma_compl_kwork_fn);
+		break;
+	default:
+		tasklet_setup(&item->tasklet, xdma_compl_tasklet_fn);
+		break;
+	}
+}
+EXPORT_SYMBOL_GPL(xdma_compl_item_init);
+
+/**
+ * xdma_compl_kill - Wait for a scheduled completion handler to finish
+ * @item: Channel completion handler
+ */
+void xdma_compl_kill(struct xdma_compl_item *item)
+{
+	switch (item->compl->mode) {
+	case XDMA_COMPL_CPU:
+		flush_work(&item->work);
+		break;
+	case XDMA_COMPL_THREAD:
+		kthread_flush_work(&item->kwork);
+		break;
+	default:
+		tasklet_kill(&item->tasklet);
+		break;
+	}
+}
+EXPORT_SYMBOL_GPL(xdma_compl_kill);
+
+MODULE_AUTHOR("Xilinx, Inc.");
+MODULE_DESCRIPTION("Xilinx DMA deferred completion helpers");
+MODULE_LICENSE("GPL v2");
@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Deferred completion handling for the Xilinx DMA engine drivers
+ *
+ * Copyright (C) 2023 Xilinx, Inc. All rights reserved.
+ */
+
+#ifndef __XILINX_DMA_COMPL_H
+#define __XILINX_DMA_COMPL_H
+
+#include <linux/interrupt.h>
+#include <linux/kthread.h>
+#include <linux/workqueue.h>
+
+struct device;
+
+/**
+ * enum xdma_compl_mode - Context the completion handlers run in
+ * @XDMA_COMPL_TASKLET: Tasklet on the CPU that took the interrupt
+ * @XDMA_COMPL_CPU: High priority work item on a fixed CPU
+ * @XDMA_COMPL_THREAD: Dedicated kthread worker, bound to a CPU if one is set
+ */
+enum xdma_compl_mode {
+	XDMA_COMPL_TASKLET = 0,
+	XDMA_COMPL_CPU,
+	XDMA_COMPL_THREAD,
+};
+
+/**
+ * struct xdma_compl - Completion backend of a DMA device
+ * @mode: Context the handlers run in
+ * @cpu: CPU the handlers are steered to, -1 for none
+ * @worker: Kthread worker for XDMA_COMPL_THREAD
+ */
+struct xdma_compl {
+	enum xdma_compl_mode mode;
+	int cpu;
+	struct kthread_worker *worker;
+};
+
+/**
+ * struct xdma_compl_item - Completion handler of a DMA channel
+ * @compl: Backend of the device the channel belongs to
+ * @fn: Handler, typically the channel descriptor cleanup
+ * @data: Argument of @fn
+ * @tasklet: Deferred context for XDMA_COMPL_TASKLET
+ * @work: Deferred context for XDMA_COMPL_CPU
+ * @kwork: Deferred context for XDMA_COMPL_THREAD
+ */
+struct xdma_compl_item {
+	struct xdma_compl *compl;
+	void (*fn)(void *data);
+	void *data;
+	union {
+		struct tasklet_struct tasklet;
+		struct work_struct work;
+		struct kthread_work kwork;
+	};
+};
+
+int devm_xdma_compl_init(struct device *dev, struct xdma_compl *compl);
+void xdma_compl_item_init(struct xdma_compl_item *item,
+			  struct xdma_compl *compl,
+			  void (*fn)(void *data), void *data);
+void xdma_compl_kill(struct xdma_compl_item *item);
+
+/**
+ * xdma_compl_schedule - Schedule the completion handler of a channel
+ * @item: Channel completion handler
+ *
+ * Safe to call from hard interrupt context.
+ */
+static inline void xdma_compl_schedule(struct xdma_compl_item *item)
+{
+	switch (item->compl->mode) {
+	case XDMA_COMPL_CPU:
+		queue_work_on(item->compl->cpu, system_highpri_wq, &item->work);
+		break;
+	case XDMA_COMPL_THREAD:
+		kthread_queue_work(item->compl->worker, &item->kwork);
+		break;
+	default:
+		tasklet_schedule(&item->tasklet);
+		break;
+	}
+}
+
+#endif /* __XILINX_DMA_COMPL_H */
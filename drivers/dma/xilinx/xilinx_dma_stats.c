@@ -0,0 +1,266 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Per channel transfer statistics for the Xilinx DMA engine drivers
+ *
+ * Copyright (C) 2023 Xilinx, Inc. All rights reserved.
+ *
+ * The AXI DMA, ZynqMP DMA and DPDMA drivers report every descriptor at
+ * tx_submit, issue_pending, hardware start and completion time. Each stage
+ * fires a xilinx_dma tracepoint, and with debugfs enabled the channel also
+ * keeps a submit to complete latency histogram, a histogram of the queue
+ * depth at issue_pending time and the completed bytes/s. They are shown in
+ * <debugfs>/dmaengine/<device>/<channel>/stats, writing to it clears them.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/fs.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/seq_file.h>
+#include <linux/timekeeping.h>
+
+#include "xilinx_dma_stats.h"
+
+#define CREATE_TRACE_POINTS
+#include "xilinx_dma_trace.h"
+
+#define XDMA_STATS_WINDOW_NS	NSEC_PER_SEC
+
+static unsigned int xdma_stats_bucket(u64 val, unsigned int nr_buckets)
+{
+	return min_t(unsigned int, fls64(val), nr_buckets - 1);
+}
+
+static void xdma_stats_reset(struct xdma_stats *stats)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	memset_startat(stats, 0, submitted);
+	stats->win_start_ns = ktime_get_ns();
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
+static void xdma_stats_show_hist(struct seq_file *s, const u64 *hist,
+				 unsigned int nr_buckets)
+{
+	unsigned int i;
+
+	for (i = 0; i < nr_buckets; i++) {
+		if (!hist[i])
+			continue;
+
+		if (!i)
+			seq_puts(s, "  0");
+		else if (i == nr_buckets - 1)
+			seq_printf(s, "  >= %llu", BIT_ULL(i - 1));
+		else if (i == 1)
+			seq_puts(s, "  1");
+		else
+			seq_printf(s, "  %llu - %llu", BIT_ULL(i - 1),
+				   BIT_ULL(i) - 1);
+		seq_printf(s, ": %llu\n", hist[i]);
+	}
+}
+
+static int xdma_stats_show(struct seq_file *s, void *data)
+{
+	struct xdma_stats *stats = s->private, snap;
+	unsigned long flags;
+	u64 elapsed, rate;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	snap = *stats;
+	spin_unlock_irqrestore(&stats->lock, flags);
+
+	/* A stalled channel shows the decaying rate of the open window */
+	rate = snap.rate;
+	elapsed = ktime_get_ns() - snap.win_start_ns;
+	if (elapsed >= 2 * XDMA_STATS_WINDOW_NS)
+		rate = mul_u64_u64_div_u64(snap.win_bytes, NSEC_PER_SEC,
+					   elapsed);
+
+	seq_printf(s, "submitted: %llu\n", snap.submitted);
+	seq_printf(s, "completed: %llu\n", snap.completed);
+	seq_printf(s, "bytes: %llu\n", snap.bytes);
+	seq_printf(s, "throughput: %llu B/s (peak %llu B/s)\n", rate,
+		   snap.peak_rate);
+	seq_printf(s, "latency: avg %llu us, max %llu us\n",
+		   snap.completed ?
+		   div64_u64(snap.lat_sum_ns, snap.completed) / NSEC_PER_USEC :
+		   0, div_u64(snap.lat_max_ns, NSEC_PER_USEC));
+	seq_puts(s, "latency histogram (us):\n");
+	xdma_stats_show_hist(s, snap.lat_hist, XDMA_STATS_LAT_BUCKETS);
+	seq_puts(s, "queue depth histogram:\n");
+	xdma_stats_show_hist(s, snap.depth_hist, XDMA_STATS_DEPTH_BUCKETS);
+
+	return 0;
+}
+
+static int xdma_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, xdma_stats_show, inode->i_private);
+}
+
+static ssize_t xdma_stats_write(struct file *file, const char __user *buf,
+				size_t count, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+
+	xdma_stats_reset(s->private);
+
+	return count;
+}
+
+static const struct file_operations xdma_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = xdma_stats_open,
+	.read = seq_read,
+	.write = xdma_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+/**
+ * xdma_stats_init - Initialise the statistics of a channel
+ * @stats: Channel statistics
+ *
+ * Must be called before the channel is registered with the DMA engine core.
+ */
+void xdma_stats_init(struct xdma_stats *stats)
+{
+	spin_lock_init(&stats->lock);
+	xdma_stats_reset(stats);
+}
+EXPORT_SYMBOL_GPL(xdma_stats_init);
+
+/**
+ * xdma_stats_debugfs_init - Expose the statistics of a channel in debugfs
+ * @stats: Channel statistics
+ * @parent: Debugfs directory of the DMA device, normally dbg_dev_root
+ * @name: Name of the channel directory
+ *
+ * Must be called once the DMA device is registered, as the core creates its
+ * debugfs directory at that point. The files go away with that directory when
+ * the device is unregistered.
+ */
+void xdma_stats_debugfs_init(struct xdma_stats *stats, struct dentry *parent,
+			     const char *name)
+{
+	struct dentry *dir;
+
+	if (!IS_ENABLED(CONFIG_DEBUG_FS))
+		return;
+
+	dir = debugfs_create_dir(name, parent);
+	debugfs_create_file("stats", 0644, dir, stats, &xdma_stats_fops);
+}
+EXPORT_SYMBOL_GPL(xdma_stats_debugfs_init);
+
+/**
+ * xdma_stats_submit - Account a submitted descriptor
+ * @stats: Channel statistics
+ * @chan: DMA channel
+ * @cookie: Cookie of the descriptor
+ * @len: Length of the descriptor in bytes
+ *
+ * Return: The submission timestamp, to be passed to xdma_stats_complete().
+ */
+u64 xdma_stats_submit(struct xdma_stats *stats, struct dma_chan *chan,
+		      dma_cookie_t cookie, size_t len)
+{
+	unsigned long flags;
+
+	trace_xdma_tx_submit(chan, cookie, len);
+
+	if (!IS_ENABLED(CONFIG_DEBUG_FS))
+		return trace_xdma_complete_enabled() ? ktime_get_ns() : 0;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->submitted++;
+	spin_unlock_irqrestore(&stats->lock, flags);
+
+	return ktime_get_ns();
+}
+EXPORT_SYMBOL_GPL(xdma_stats_submit);
+
+/**
+ * xdma_stats_issue - Account an issue_pending call
+ * @stats: Channel statistics
+ * @chan: DMA channel
+ * @depth: Number of descriptors waiting to be started
+ */
+void xdma_stats_issue(struct xdma_stats *stats, struct dma_chan *chan,
+		      unsigned int depth)
+{
+	unsigned long flags;
+
+	trace_xdma_issue_pending(chan, depth);
+
+	if (!IS_ENABLED(CONFIG_DEBUG_FS))
+		return;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->depth_hist[xdma_stats_bucket(depth,
+					    XDMA_STATS_DEPTH_BUCKETS)]++;
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+EXPORT_SYMBOL_GPL(xdma_stats_issue);
+
+/**
+ * xdma_stats_start - Account descriptors handed to the hardware
+ * @stats: Channel statistics
+ * @chan: DMA channel
+ * @count: Number of descriptors started
+ */
+void xdma_stats_start(struct xdma_stats *stats, struct dma_chan *chan,
+		      unsigned int count)
+{
+	trace_xdma_hw_start(chan, count);
+}
+EXPORT_SYMBOL_GPL(xdma_stats_start);
+
+/**
+ * xdma_stats_complete - Account a completed descriptor
+ * @stats: Channel statistics
+ * @chan: DMA channel
+ * @cookie: Cookie of the descriptor
+ * @len: Length of the descriptor in bytes
+ * @submit_ns: Timestamp returned by xdma_stats_submit()
+ */
+void xdma_stats_complete(struct xdma_stats *stats, struct dma_chan *chan,
+			 dma_cookie_t cookie, size_t len, u64 submit_ns)
+{
+	u64 now = ktime_get_ns(), lat = submit_ns ? now - submit_ns : 0;
+	unsigned long flags;
+
+	trace_xdma_complete(chan, cookie, len, lat);
+
+	if (!IS_ENABLED(CONFIG_DEBUG_FS))
+		return;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->completed++;
+	stats->bytes += len;
+	stats->lat_sum_ns += lat;
+	stats->lat_max_ns = max(stats->lat_max_ns, lat);
+	stats->lat_hist[xdma_stats_bucket(div_u64(lat, NSEC_PER_USEC),
+					  XDMA_STATS_LAT_BUCKETS)]++;
+
+	if (now - stats->win_start_ns >= XDMA_STATS_WINDOW_NS) {
+		stats->rate = mul_u64_u64_div_u64(stats->win_bytes,
+						  NSEC_PER_SEC,
+						  now - stats->win_start_ns);
+		stats->peak_rate = max(stats->peak_rate, stats->rate);
+		stats->win_start_ns = now;
+		stats->win_bytes = 0;
+	}
+	stats->win_bytes += len;
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+EXPORT_SYMBOL_GPL(xdma_stats_complete);
+
+MODULE_AUTHOR("Xilinx, Inc.");
+MODULE_DESCRIPTION("Xilinx DMA channel statistics and tracepoints");
+MODULE_LICENSE("GPL v2");
@@ -0,0 +1,63 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Per channel transfer statistics for the Xilinx DMA engine drivers
+ *
+ * Copyright (C) 2023 Xilinx, Inc. All rights reserved.
+ */
+
+#ifndef __XILINX_DMA_STATS_H
+#define __XILINX_DMA_STATS_H
+
+#include <linux/dmaengine.h>
+#include <linux/spinlock.h>
+#include <linux/types.h>
+
+struct dentry;
+
+/* Bucket n counts values in [2^(n-1), 2^n), the last one everything above */
+#define XDMA_STATS_LAT_BUCKETS		20
+#define XDMA_STATS_DEPTH_BUCKETS	10
+
+/**
+ * struct xdma_stats - Transfer statistics of a DMA channel
+ * @lock: Protects the fields below
+ * @submitted: Descriptors submitted
+ * @completed: Descriptors completed
+ * @bytes: Bytes completed
+ * @lat_sum_ns: Sum of the submit to complete latencies
+ * @lat_max_ns: Highest submit to complete latency
+ * @lat_hist: Submit to complete latency histogram, in microseconds
+ * @depth_hist: Histogram of the queue depth at issue_pending time
+ * @win_start_ns: Start of the current throughput window
+ * @win_bytes: Bytes completed in the current throughput window
+ * @rate: Bytes/s over the last complete window
+ * @peak_rate: Highest @rate seen
+ */
+struct xdma_stats {
+	spinlock_t lock;
+	u64 submitted;
+	u64 completed;
+	u64 bytes;
+	u64 lat_sum_ns;
+	u64 lat_max_ns;
+	u64 lat_hist[XDMA_STATS_LAT_BUCKETS];
+	u64 depth_hist[XDMA_STATS_DEPTH_BUCKETS];
+	u64 win_start_ns;
+	u64 win_bytes;
+	u64 rate;
+	u64 peak_rate;
+};
+
+void xdma_stats_init(struct xdma_stats *stats);
+void xdma_stats_debugfs_init(struct xdma_stats *stats, struct dentry *parent,
+			     const char *name);
+u64 xdma_stats_submit(struct xdma_stats *stats, struct dma_chan *chan,
+		      dma_cookie_t cookie, size_t len);
+void xdma_stats_issue(struct xdma_stats *stats, struct dma_chan *chan,
+		      unsigned int depth);
+void xdma_stats_start(struct xdma_stats *stats, struct dma_chan *chan,
+		      unsigned int count);
+void xdma_stats_complete(struct xdma_stats *stats, struct dma_chan *chan,
+			 dma_cookie_t cookie, size_t len, u64 submit_ns);
+
+#endif /* __XILINX_DMA_STATS_H */
@@ -0,0 +1,649 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Xilinx AXI DMA streaming character device
+ *
+ * Copyright (C) 2023 Xilinx, Inc. All rights reserved.
+ *
+ * Moves data between an AXI4-Stream interface and userspace through an AXI
+ * DMA or MCDMA channel without copies. Each device node names one channel,
+ * "rx" for stream to memory or "tx" for memory to stream, and gets a
+ * /dev/axis-<name> character device. The kernel allocates a ring of
+ * buffers that userspace maps, together with a control area carrying the
+ * producer and consumer indices of the ring (see <linux/xlnx-dma-stream.h>).
+ *
+ * In scatter-gather mode every buffer is a separate transfer, queued as soon
+ * as userspace hands it over, and a stream waits for userspace when the ring
+ * is full. With "xlnx,cyclic" the ring is a single cyclic transfer which
+ * never stops, and buffers userspace held on to for too long are counted as
+ * overruns.
+ *
+ * Userspace hands buffers over by updating its index in the control area
+ * and then calling poll() or XLNX_DMA_STREAM_IOCTL_KICK, so a single poll()
+ * both returns buffers and waits for new ones. Wake ups, and the optional
+ * eventfd signal, can be coalesced on a buffer count and a timeout.
+ */
+
+#include <linux/dma-mapping.h>
+#include <linux/dmaengine.h>
+#include <linux/eventfd.h>
+#include <linux/fs.h>
+#include <linux/hrtimer.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/of.h>
+#include <linux/platform_device.h>
+#include <linux/poll.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+#include <linux/wait.h>
+
+#include <linux/xlnx-dma-stream.h>
+
+#define XDMA_STREAM_DEF_BUFS		16
+#define XDMA_STREAM_DEF_BUF_SIZE	SZ_64K
+
+/**
+ * struct xdma_stream - Streaming character device
+ * @chan: DMA channel
+ * @dma_dev: Device doing the DMA, the buffers are allocated for it
+ * @misc: Character device
+ * @name: Name of the character device
+ * @tx: Stream from memory to the AXI4-Stream interface
+ * @cyclic: The ring is run as one cyclic transfer
+ * @dir: DMA direction of the buffers
+ * @num_bufs: Number of buffers in the ring
+ * @buf_size: Size of each buffer
+ * @ring: Ring control area shared with userspace
+ * @ctrl_size: Size of @ring
+ * @data: Ring buffers
+ * @data_dma: DMA address of @data
+ * @data_size: Size of @data
+ * @mutex: Serializes opening, ioctl() and the handing over of buffers
+ * @open: The character device is open
+ * @running: The stream is started
+ * @prod: Kernel copy of the producer index
+ * @cons: Kernel copy of the consumer index
+ * @queued: Buffers handed to the channel or, for a cyclic Tx stream, synced
+ *	    for it
+ * @wait: Waiters on the ring
+ * @timer: Coalescing timeout
+ * @lock: Protects @eventfd and starting @timer
+ * @eventfd: Signalled along with @wait, if set
+ * @coalesce_count: Wake up once that many buffers are owned by userspace
+ * @coalesce_usecs: Coalescing timeout, 0 for none
+ */
+struct xdma_stream {
+	struct dma_chan *chan;
+	struct device *dma_dev;
+	struct miscdevice misc;
+	char name[32];
+	bool tx;
+	bool cyclic;
+	enum dma_data_direction dir;
+	u32 num_bufs;
+	u32 buf_size;
+	struct xlnx_dma_stream_ring *ring;
+	size_t ctrl_size;
+	struct page *data;
+	dma_addr_t data_dma;
+	size_t data_size;
+	struct mutex mutex;
+	bool open;
+	bool running;
+	u32 prod;
+	u32 cons;
+	u32 queued;
+	wait_queue_head_t wait;
+	struct hrtimer timer;
+	spinlock_t lock;
+	struct eventfd_ctx *eventfd;
+	u32 coalesce_count;
+	u32 coalesce_usecs;
+};
+
+static inline dma_addr_t xdma_stream_buf_dma(struct xdma_stream *s, u32 idx)
+{
+	return s->data_dma + (dma_addr_t)(idx % s->num_bufs) * s->buf_size;
+}
+
+/* Buffers currently owned by userspace */
+static u32 xdma_stream_user_bufs(struct xdma_stream *s)
+{
+	if (s->tx)
+		return s->num_bufs - (READ_ONCE(s->ring->prod) -
+				      READ_ONCE(s->cons));
+
+	return READ_ONCE(s->prod) - READ_ONCE(s->ring->cons);
+}
+
+static void xdma_stream_wake(struct xdma_stream *s)
+{
+	unsigned long flags;
+
+	wake_up_interruptible(&s->wait);
+
+	spin_lock_irqsave(&s->lock, flags);
+	if (s->eventfd)
+		eventfd_signal(s->eventfd, 1);
+	spin_unlock_irqrestore(&s->lock, flags);
+}
+
+static enum hrtimer_restart xdma_stream_timer_fn(struct hrtimer *timer)
+{
+	struct xdma_stream *s = container_of(timer, struct xdma_stream, timer);
+
+	xdma_stream_wake(s);
+
+	return HRTIMER_NORESTART;
+}
+
+/* Called after a buffer was handed to userspace */
+static void xdma_stream_notify(struct xdma_stream *s)
+{
+	unsigned long flags;
+	u32 avail = xdma_stream_user_bufs(s);
+
+	if (avail >= s->coalesce_count) {
+		hrtimer_try_to_cancel(&s->timer);
+		xdma_stream_wake(s);
+		return;
+	}
+
+	if (!s->coalesce_usecs)
+		return;
+
+	spin_lock_irqsave(&s->lock, flags);
+	if (!hrtimer_active(&s->timer))
+		hrtimer_start(&s->timer,
+			      ns_to_ktime((u64)s->coalesce_usecs *
+					  NSEC_PER_USEC),
+			      HRTIMER_MODE_REL);
+	spin_unlock_irqrestore(&s->lock, flags);
+}
+
+static void xdma_stream_done(void *param, const struct dmaengine_result *res)
+{
+	struct xdma_stream *s = param;
+	struct xlnx_dma_stream_buf *buf;
+	u32 idx = s->tx ? s->cons : s->prod;
+
+	buf = &s->ring->bufs[idx % s->num_bufs];
+	buf->flags = 0;
+	if (res && res->result != DMA_TRANS_NOERROR) {
+		buf->flags = XLNX_DMA_STREAM_BUF_ERROR;
+		s->ring->errors++;
+	}
+
+	if (s->tx) {
+		if (s->cyclic && (s32)(READ_ONCE(s->ring->prod) - s->cons) <= 0)
+			s->ring->overruns++;
+		/* Pairs with the acquire of userspace */
+		smp_store_release(&s->ring->cons, ++s->cons);
+	} else {
+		if (s->cyclic) {
+			buf->len = s->buf_size;
+			if (s->prod - READ_ONCE(s->ring->cons) >= s->num_bufs)
+				s->ring->overruns++;
+		} else {
+			buf->len = s->buf_size - (res ? res->residue : 0);
+		}
+		dma_sync_single_for_cpu(s->dma_dev, xdma_stream_buf_dma(s, idx),
+					s->buf_size, s->dir);
+		/* Publish the buffer after its contents and length */
+		smp_store_release(&s->ring->prod, ++s->prod);
+	}
+
+	xdma_stream_notify(s);
+}
+
+static int xdma_stream_queue(struct xdma_stream *s, u32 idx, u32 len)
+{
+	struct dma_async_tx_descriptor *desc;
+	dma_addr_t addr = xdma_stream_buf_dma(s, idx);
+
+	dma_sync_single_for_device(s->dma_dev, addr, len, s->dir);
+
+	desc = dmaengine_prep_slave_single(s->chan, addr, len,
+					   s->tx ? DMA_MEM_TO_DEV :
+						   DMA_DEV_TO_MEM,
+					   DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!desc)
+		return -ENOMEM;
+
+	desc->callback_result = xdma_stream_done;
+	desc->callback_param = s;
+
+	return dma_submit_error(dmaengine_submit(desc));
+}
+
+/**
+ * xdma_stream_kick - Take the buffers userspace handed over
+ * @s: Stream
+ *
+ * Buffers handed over since the last call are queued on the channel, or for
+ * a cyclic Tx stream synced for the device. Must be called with the mutex
+ * held.
+ *
+ * Return: '0' on success and failure value on error
+ */
+static int xdma_stream_kick(struct xdma_stream *s)
+{
+	struct xlnx_dma_stream_buf *buf;
+	u32 user, limit, len;
+	bool issue = false;
+	dma_addr_t addr;
+	int ret = 0;
+
+	if (!s->running)
+		return 0;
+
+	/* Pairs with the release of userspace */
+	if (s->tx)
+		user = smp_load_acquire(&s->ring->prod);
+	else
+		user = smp_load_acquire(&s->ring->cons);
+
+	if (s->cyclic) {
+		if (!s->tx)
+			return 0;
+
+		/* A late producer restarts at cons, which may be past it */
+		if ((s32)(s->queued - READ_ONCE(s->cons)) < 0)
+			s->queued = READ_ONCE(s->cons);
+		for (; (s32)(user - s->queued) > 0; s->queued++) {
+			addr = xdma_stream_buf_dma(s, s->queued);
+			dma_sync_single_for_device(s->dma_dev, addr,
+						   s->buf_size, s->dir);
+		}
+		return 0;
+	}
+
+	if (s->tx) {
+		if (user - READ_ONCE(s->cons) > s->num_bufs)
+			return -EINVAL;
+		limit = user;
+	} else {
+		if (READ_ONCE(s->prod) - user > s->num_bufs)
+			return -EINVAL;
+		limit = user + s->num_bufs;
+	}
+
+	while (s->queued != limit) {
+		len = s->buf_size;
+		if (s->tx) {
+			buf = &s->ring->bufs[s->queued % s->num_bufs];
+			len = READ_ONCE(buf->len);
+			if (!len || len > s->buf_size) {
+				ret = -EINVAL;
+				break;
+			}
+		}
+
+		ret = xdma_stream_queue(s, s->queued, len);
+		if (ret)
+			break;
+
+		s->queued++;
+		issue = true;
+	}
+
+	if (issue)
+		dma_async_issue_pending(s->chan);
+
+	return ret;
+}
+
+static int xdma_stream_start(struct xdma_stream *s)
+{
+	struct dma_async_tx_descriptor *desc;
+	int ret;
+
+	if (s->running)
+		return -EBUSY;
+
+	s->prod = 0;
+	s->cons = 0;
+	s->queued = 0;
+	s->ring->prod = 0;
+	s->ring->cons = 0;
+	s->ring->overruns = 0;
+	s->ring->errors = 0;
+
+	if (!s->cyclic) {
+		s->running = true;
+		ret = xdma_stream_kick(s);
+		if (ret) {
+			dmaengine_terminate_sync(s->chan);
+			s->running = false;
+		}
+		return ret;
+	}
+
+	/* A cyclic Tx stream sends what userspace put in the ring so far */
+	dma_sync_single_for_device(s->dma_dev, s->data_dma, s->data_size,
+				   s->dir);
+	if (s->tx)
+		s->ring->prod = s->num_bufs;
+
+	desc = dmaengine_prep_dma_cyclic(s->chan, s->data_dma, s->data_size,
+					 s->buf_size,
+					 s->tx ? DMA_MEM_TO_DEV :
+						 DMA_DEV_TO_MEM,
+					 DMA_PREP_INTERRUPT);
+	if (!desc)
+		return -ENOMEM;
+
+	desc->callback_result = xdma_stream_done;
+	desc->callback_param = s;
+
+	ret = dma_submit_error(dmaengine_submit(desc));
+	if (ret)
+		return ret;
+
+	s->queued = s->ring->prod;
+	s->running = true;
+	dma_async_issue_pending(s->chan);
+
+	return 0;
+}
+
+static void xdma_stream_stop(struct xdma_stream *s)
+{
+	if (!s->running)
+		return;
+
+	dmaengine_terminate_sync(s->chan);
+	hrtimer_cancel(&s->timer);
+	s->running = false;
+	wake_up_interruptible(&s->wait);
+}
+
+static int xdma_stream_set_eventfd(struct xdma_stream *s, int fd)
+{
+	struct eventfd_ctx *ctx = NULL, *old;
+	unsigned long flags;
+
+	if (fd >= 0) {
+		ctx = eventfd_ctx_fdget(fd);
+		if (IS_ERR(ctx))
+			return PTR_ERR(ctx);
+	}
+
+	spin_lock_irqsave(&s->lock, flags);
+	old = s->eventfd;
+	s->eventfd = ctx;
+	spin_unlock_irqrestore(&s->lock, flags);
+
+	if (old)
+		eventfd_ctx_put(old);
+
+	return 0;
+}
+
+static int xdma_stream_fop_open(struct inode *inode, struct file *file)
+{
+	struct xdma_stream *s = container_of(file->private_data,
+					     struct xdma_stream, misc);
+	int ret = 0;
+
+	mutex_lock(&s->mutex);
+	if (s->open)
+		ret = -EBUSY;
+	else
+		s->open = true;
+	mutex_unlock(&s->mutex);
+
+	file->private_data = s;
+
+	return ret;
+}
+
+static int xdma_stream_fop_release(struct inode *inode, struct file *file)
+{
+	struct xdma_stream *s = file->private_data;
+
+	mutex_lock(&s->mutex);
+	xdma_stream_stop(s);
+	xdma_stream_set_eventfd(s, -1);
+	s->coalesce_count = 1;
+	s->coalesce_usecs = 0;
+	s->open = false;
+	mutex_unlock(&s->mutex);
+
+	return 0;
+}
+
+static long xdma_stream_fop_ioctl(struct file *file, unsigned int cmd,
+				  unsigned long arg)
+{
+	struct xdma_stream *s = file->private_data;
+	struct xlnx_dma_stream_coalesce coalesce;
+	struct xlnx_dma_stream_info info;
+	void __user *argp = (void __user *)arg;
+	int fd, ret = 0;
+
+	mutex_lock(&s->mutex);
+	switch (cmd) {
+	case XLNX_DMA_STREAM_IOCTL_INFO:
+		memset(&info, 0, sizeof(info));
+		info.flags = (s->tx ? XLNX_DMA_STREAM_TX : 0) |
+			     (s->cyclic ? XLNX_DMA_STREAM_CYCLIC : 0);
+		info.num_bufs = s->num_bufs;
+		info.buf_size = s->buf_size;
+		info.ctrl_size = s->ctrl_size;
+		info.data_offset = s->ctrl_size;
+		if (copy_to_user(argp, &info, sizeof(info)))
+			ret = -EFAULT;
+		break;
+	case XLNX_DMA_STREAM_IOCTL_START:
+		ret = xdma_stream_start(s);
+		break;
+	case XLNX_DMA_STREAM_IOCTL_STOP:
+		xdma_stream_stop(s);
+		break;
+	case XLNX_DMA_STREAM_IOCTL_KICK:
+		ret = xdma_stream_kick(s);
+		break;
+	case XLNX_DMA_STREAM_IOCTL_EVENTFD:
+		if (get_user(fd, (int __user *)argp))
+			ret = -EFAULT;
+		else
+			ret = xdma_stream_set_eventfd(s, fd);
+		break;
+	case XLNX_DMA_STREAM_IOCTL_COALESCE:
+		if (copy_from_user(&coalesce, argp, sizeof(coalesce))) {
+			ret = -EFAULT;
+		} else if (!coalesce.count || coalesce.count > s->num_bufs) {
+			ret = -EINVAL;
+		} else {
+			s->coalesce_count = coalesce.count;
+			s->coalesce_usecs = coalesce.usecs;
+		}
+		break;
+	default:
+		ret = -ENOTTY;
+		break;
+	}
+	mutex_unlock(&s->mutex);
+
+	return ret;
+}
+
+static __poll_t xdma_stream_fop_poll(struct file *file, poll_table *wait)
+{
+	struct xdma_stream *s = file->private_data;
+	__poll_t mask = 0;
+
+	mutex_lock(&s->mutex);
+	if (xdma_stream_kick(s))
+		mask |= EPOLLERR;
+	mutex_unlock(&s->mutex);
+
+	poll_wait(file, &s->wait, wait);
+
+	if (!READ_ONCE(s->running))
+		return mask | EPOLLHUP;
+
+	if (xdma_stream_user_bufs(s))
+		mask |= s->tx ? EPOLLOUT | EPOLLWRNORM : EPOLLIN | EPOLLRDNORM;
+
+	return mask;
+}
+
+static int xdma_stream_fop_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct xdma_stream *s = file->private_data;
+	unsigned long data_pgoff = s->ctrl_size >> PAGE_SHIFT;
+
+	if (!vma->vm_pgoff) {
+		if (vma->vm_end - vma->vm_start > s->ctrl_size)
+			return -EINVAL;
+		return remap_vmalloc_range(vma, s->ring, 0);
+	}
+
+	if (vma->vm_pgoff < data_pgoff)
+		return -EINVAL;
+
+	vma->vm_pgoff -= data_pgoff;
+
+	return dma_mmap_pages(s->dma_dev, vma, s->data_size, s->data);
+}
+
+static const struct file_operations xdma_stream_fops = {
+	.owner = THIS_MODULE,
+	.open = xdma_stream_fop_open,
+	.release = xdma_stream_fop_release,
+	.unlocked_ioctl = xdma_stream_fop_ioctl,
+	.compat_ioctl = compat_ptr_ioctl,
+	.poll = xdma_stream_fop_poll,
+	.mmap = xdma_stream_fop_mmap,
+	.llseek = noop_llseek,
+};
+
+static int xilinx_dma_stream_probe(struct platform_device *pdev)
+{
+	struct device_node *node = pdev->dev.of_node;
+	struct xdma_stream *s;
+	int ret;
+
+	s = devm_kzalloc(&pdev->dev, sizeof(*s), GFP_KERNEL);
+	if (!s)
+		return -ENOMEM;
+
+	mutex_init(&s->mutex);
+	spin_lock_init(&s->lock);
+	init_waitqueue_head(&s->wait);
+	hrtimer_init(&s->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	s->timer.function = xdma_stream_timer_fn;
+	s->coalesce_count = 1;
+
+	s->chan = dma_request_chan(&pdev->dev, "rx");
+	if (PTR_ERR(s->chan) == -ENODEV) {
+		s->tx = true;
+		s->chan = dma_request_chan(&pdev->dev, "tx");
+	}
+	if (IS_ERR(s->chan))
+		return dev_err_probe(&pdev->dev, PTR_ERR(s->chan),
+				     "unable to get the rx or tx channel\n");
+
+	s->dma_dev = s->chan->device->dev;
+	s->dir = s->tx ? DMA_TO_DEVICE : DMA_FROM_DEVICE;
+	s->cyclic = of_property_read_bool(node, "xlnx,cyclic");
+
+	s->num_bufs = XDMA_STREAM_DEF_BUFS;
+	s->buf_size = XDMA_STREAM_DEF_BUF_SIZE;
+	of_property_read_u32(node, "xlnx,num-buffers", &s->num_bufs);
+	of_property_read_u32(node, "xlnx,buffer-size", &s->buf_size);
+	if (!s->num_bufs || !s->buf_size ||
+	    s->buf_size > SZ_1G / s->num_bufs) {
+		dev_err(&pdev->dev, "invalid ring of %u buffers of %u bytes\n",
+			s->num_bufs, s->buf_size);
+		ret = -EINVAL;
+		goto err_chan;
+	}
+	/* Keep every buffer on its own cache lines */
+	s->buf_size = ALIGN(s->buf_size, dma_get_cache_alignment());
+
+	s->ctrl_size = PAGE_ALIGN(struct_size(s->ring, bufs, s->num_bufs));
+	s->ring = vmalloc_user(s->ctrl_size);
+	if (!s->ring) {
+		ret = -ENOMEM;
+		goto err_chan;
+	}
+	s->ring->num_bufs = s->num_bufs;
+	s->ring->buf_size = s->buf_size;
+
+	s->data_size = PAGE_ALIGN((size_t)s->num_bufs * s->buf_size);
+	s->data = dma_alloc_pages(s->dma_dev, s->data_size, &s->data_dma,
+				  s->dir, GFP_KERNEL);
+	if (!s->data) {
+		dev_err(&pdev->dev, "unable to allocate %zu bytes of buffers\n",
+			s->data_size);
+		ret = -ENOMEM;
+		goto err_ring;
+	}
+
+	snprintf(s->name, sizeof(s->name), "axis-%pOFn", node);
+	s->misc.minor = MISC_DYNAMIC_MINOR;
+	s->misc.name = s->name;
+	s->misc.fops = &xdma_stream_fops;
+	s->misc.parent = &pdev->dev;
+	ret = misc_register(&s->misc);
+	if (ret)
+		goto err_data;
+
+	platform_set_drvdata(pdev, s);
+
+	dev_info(&pdev->dev, "%s: %s %u x %u bytes%s\n", s->name,
+		 s->tx ? "tx" : "rx", s->num_bufs, s->buf_size,
+		 s->cyclic ? ", cyclic" : "");
+
+	return 0;
+
+err_data:
+	dma_free_pages(s->dma_dev, s->data_size, s->data, s->data_dma, s->dir);
+err_ring:
+	vfree(s->ring);
+err_chan:
+	dma_release_channel(s->chan);
+	return ret;
+}
+
+static int xilinx_dma_stream_remove(struct platform_device *pdev)
+{
+	struct xdma_stream *s = platform_get_drvdata(pdev);
+
+	misc_deregister(&s->misc);
+	mutex_lock(&s->mutex);
+	xdma_stream_stop(s);
+	mutex_unlock(&s->mutex);
+	dma_free_pages(s->dma_dev, s->data_size, s->data, s->data_dma, s->dir);
+	vfree(s->ring);
+	dma_release_channel(s->chan);
+
+	return 0;
+}
+
+static const struct of_device_id xilinx_dma_stream_of_ids[] = {
+	{ .compatible = "xlnx,axi-dma-stream-1.00.a",},
+	{}
+};
+MODULE_DEVICE_TABLE(of, xilinx_dma_stream_of_ids);
+
+static struct platform_driver xilinx_dma_stream_driver = {
+	.driver = {
+		.name = "xilinx_dma_stream",
+		.of_match_table = xilinx_dma_stream_of_ids,
+	},
+	.probe = xilinx_dma_stream_probe,
+	.remove = xilinx_dma_stream_remove,
+};
+
+module_platform_driver(xilinx_dma_stream_driver);
+
+MODULE_AUTHOR("Xilinx, Inc.");
+MODULE_DESCRIPTION("Xilinx AXI DMA streaming character device");
+MODULE_LICENSE("GPL v2");
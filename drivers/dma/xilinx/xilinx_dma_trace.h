@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Tracepoints for the Xilinx DMA engine drivers
+ *
+ * Copyright (C) 2023 Xilinx, Inc. All rights reserved.
+ */
+
+#if !defined(__XILINX_DMA_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define __XILINX_DMA_TRACE_H
+
+#include <linux/dmaengine.h>
+#include <linux/tracepoint.h>
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM xilinx_dma
+
+DECLARE_EVENT_CLASS(xdma_queue,
+	TP_PROTO(struct dma_chan *chan, unsigned int count),
+	TP_ARGS(chan, count),
+	TP_STRUCT__entry(
+		__string(chan, dma_chan_name(chan))
+		__field(unsigned int, count)
+	),
+	TP_fast_assign(
+		__assign_str(chan, dma_chan_name(chan));
+		__entry->count = count;
+	),
+	TP_printk("%s count=%u", __get_str(chan), __entry->count)
+);
+
+DEFINE_EVENT(xdma_queue, xdma_issue_pending,
+	TP_PROTO(struct dma_chan *chan, unsigned int count),
+	TP_ARGS(chan, count)
+);
+
+DEFINE_EVENT(xdma_queue, xdma_hw_start,
+	TP_PROTO(struct dma_chan *chan, unsigned int count),
+	TP_ARGS(chan, count)
+);
+
+TRACE_EVENT(xdma_tx_submit,
+	TP_PROTO(struct dma_chan *chan, dma_cookie_t cookie, size_t len),
+	TP_ARGS(chan, cookie, len),
+	TP_STRUCT__entry(
+		__string(chan, dma_chan_name(chan))
+		__field(dma_cookie_t, cookie)
+		__field(size_t, len)
+	),
+	TP_fast_assign(
+		__assign_str(chan, dma_chan_name(chan));
+		__entry->cookie = cookie;
+		__entry->len = len;
+	),
+	TP_printk("%s cookie=%d len=%zu", __get_str(chan), __entry->cookie,
+		  __entry->len)
+);
+
+TRACE_EVENT(xdma_complete,
+	TP_PROTO(struct dma_chan *chan, dma_cookie_t cookie, size_t len,
+		 u64 latency_ns),
+	TP_ARGS(chan, cookie, len, latency_ns),
+	TP_STRUCT__entry(
+		__string(chan, dma_chan_name(chan))
+		__field(dma_cookie_t, cookie)
+		__field(size_t, len)
+		__field(u64, latency_ns)
+	),
+	TP_fast_assign(
+		__assign_str(chan, dma_chan_name(chan));
+		__entry->cookie = cookie;
+		__entry->len = len;
+		__entry->latency_ns = latency_ns;
+	),
+	TP_printk("%s cookie=%d len=%zu latency=%llu ns", __get_str(chan),
+		  __entry->cookie, __entry->len, __entry->latency_ns)
+);
+
+#endif /* __XILINX_DMA_TRACE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE xilinx_dma_trace
+#include <trace/define_trace.h>
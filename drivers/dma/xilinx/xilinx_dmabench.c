@@ -0,0 +1,782 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * XILINX AXI DMA, MCDMA and VDMA Engine benchmark module
+ *
+ * Copyright (C) 2023 Xilinx, Inc. All rights reserved.
+ *
+ * Unlike axidmatest and vdmatest, which check the data of a few transfers,
+ * this client keeps a configurable number of descriptors in flight on each
+ * loopback channel pair and reports the throughput, the number of transfers
+ * per second and the latency percentiles of the run, so that bitstreams and
+ * kernel versions can be compared with the same parameters.
+ *
+ * The device node lists the channel pairs as "tx0", "rx0", "tx1", "rx1"...
+ * Each pair is driven by its own kthread, optionally bound to a CPU, for
+ * duration_ms milliseconds after the driver is bound.
+ *
+ * mode=sg     slave scatter-gather transfers of buf_size bytes split in
+ *             sg_len entries, latency is tx_submit to rx completion
+ * mode=cyclic one cyclic transfer per channel made of queue_depth periods of
+ *             buf_size bytes, latency is the interval between rx periods
+ * mode=vdma   interleaved hsize x vsize frames, latency as for sg
+ */
+#include <linux/cpumask.h>
+#include <linux/delay.h>
+#include <linux/dma-mapping.h>
+#include <linux/dmaengine.h>
+#include <linux/init.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/of_dma.h>
+#include <linux/overflow.h>
+#include <linux/platform_device.h>
+#include <linux/scatterlist.h>
+#include <linux/slab.h>
+#include <linux/wait.h>
+#include <linux/dma/xilinx_dma.h>
+
+static char *mode = "sg";
+module_param(mode, charp, 0444);
+MODULE_PARM_DESC(mode, "Benchmark mode: sg, cyclic or vdma (default: sg)");
+
+static unsigned int buf_size = 65536;
+module_param(buf_size, uint, 0444);
+MODULE_PARM_DESC(buf_size, "Bytes per transfer or cyclic period");
+
+static unsigned int sg_len = 1;
+module_param(sg_len, uint, 0444);
+MODULE_PARM_DESC(sg_len, "Scatterlist entries per sg transfer");
+
+static unsigned int queue_depth = 8;
+module_param(queue_depth, uint, 0444);
+MODULE_PARM_DESC(queue_depth, "Transfers in flight per channel pair");
+
+static unsigned int threads;
+module_param(threads, uint, 0444);
+MODULE_PARM_DESC(threads, "Channel pairs to use (default: all)");
+
+static char *cpus = "";
+module_param(cpus, charp, 0444);
+MODULE_PARM_DESC(cpus, "CPU list the threads are bound to, round robin");
+
+static bool polled;
+module_param(polled, bool, 0444);
+MODULE_PARM_DESC(polled,
+		 "Poll for completion instead of interrupts (sg and vdma)");
+
+static unsigned int duration_ms = 10000;
+module_param(duration_ms, uint, 0444);
+MODULE_PARM_DESC(duration_ms, "Run time of the benchmark in milliseconds");
+
+static unsigned int hsize = 1920 * 4;
+module_param(hsize, uint, 0444);
+MODULE_PARM_DESC(hsize, "VDMA frame line size in bytes");
+
+static unsigned int vsize = 1080;
+module_param(vsize, uint, 0444);
+MODULE_PARM_DESC(vsize, "VDMA frame height in lines");
+
+#define DMABENCH_TIMEOUT_MS	5000
+
+/*
+ * Latencies go to a log-linear histogram: values below 16ns have a bucket
+ * each, above that every power of two is split in 16 buckets. That keeps the
+ * percentiles within 6.25% for any value at a fixed 8KiB per thread.
+ */
+#define DMABENCH_HIST_SUB_BITS	4
+#define DMABENCH_HIST_SUB	BIT(DMABENCH_HIST_SUB_BITS)
+#define DMABENCH_HIST_BUCKETS	((64 - DMABENCH_HIST_SUB_BITS + 1) * \
+				 DMABENCH_HIST_SUB)
+
+enum dmabench_mode {
+	DMABENCH_SG,
+	DMABENCH_CYCLIC,
+	DMABENCH_VDMA,
+};
+
+struct dmabench;
+struct dmabench_thread;
+
+struct dmabench_slot {
+	struct dmabench_thread *thread;
+	void *src;
+	void *dst;
+	dma_addr_t src_dma;
+	dma_addr_t dst_dma;
+	struct scatterlist *tx_sg;
+	struct scatterlist *rx_sg;
+	dma_cookie_t tx_cookie;
+	dma_cookie_t rx_cookie;
+	atomic_t pending;
+	u64 start_ns;
+	u64 end_ns;
+	bool busy;
+};
+
+struct dmabench_thread {
+	struct list_head node;
+	struct dmabench *bench;
+	struct task_struct *task;
+	struct dma_chan *tx_chan;
+	struct dma_chan *rx_chan;
+	struct dmabench_slot *slots;
+	unsigned int nr_slots;
+	size_t len;
+	wait_queue_head_t wait;
+	u64 *hist;
+	u64 count;
+	u64 bytes;
+	u64 lat_max;
+	u64 runtime_ns;
+	u64 last_ns;
+};
+
+struct dmabench {
+	struct list_head threads;
+	enum dmabench_mode mode;
+	atomic_t running;
+};
+
+static unsigned int dmabench_hist_index(u64 val)
+{
+	unsigned int exp;
+
+	if (val < DMABENCH_HIST_SUB)
+		return val;
+
+	exp = fls64(val) - 1;
+	return (exp - DMABENCH_HIST_SUB_BITS + 1) * DMABENCH_HIST_SUB +
+	       ((val >> (exp - DMABENCH_HIST_SUB_BITS)) &
+		(DMABENCH_HIST_SUB - 1));
+}
+
+static u64 dmabench_hist_value(unsigned int idx)
+{
+	unsigned int exp = idx / DMABENCH_HIST_SUB + DMABENCH_HIST_SUB_BITS - 1;
+	u64 sub = idx % DMABENCH_HIST_SUB;
+
+	if (idx < DMABENCH_HIST_SUB)
+		return idx;
+
+	/* Upper bound of the bucket */
+	return ((DMABENCH_HIST_SUB + sub + 1) <<
+		(exp - DMABENCH_HIST_SUB_BITS)) - 1;
+}
+
+static u64 dmabench_percentile(const u64 *hist, u64 count,
+			       unsigned int permille)
+{
+	u64 target = div_u64(count * permille + 999, 1000), seen = 0;
+	unsigned int i;
+
+	for (i = 0; i < DMABENCH_HIST_BUCKETS; i++) {
+		seen += hist[i];
+		if (seen >= target && seen)
+			return dmabench_hist_value(i);
+	}
+
+	return 0;
+}
+
+static void dmabench_record(struct dmabench_thread *thread, u64 lat,
+			    size_t len)
+{
+	thread->hist[dmabench_hist_index(lat)]++;
+	thread->lat_max = max(thread->lat_max, lat);
+	thread->count++;
+	thread->bytes += len;
+}
+
+static void dmabench_report(const char *name, const u64 *hist, u64 count,
+			    u64 bytes, u64 lat_max, u64 runtime_ns)
+{
+	u64 runtime_us = max_t(u64, div_u64(runtime_ns, NSEC_PER_USEC), 1);
+
+	pr_info("dmabench: %s: %llu transfers %llu bytes in %llu us: %llu MB/s %llu IOPS\n",
+		name, count, bytes, runtime_us, div64_u64(bytes, runtime_us),
+		div64_u64(count * USEC_PER_SEC, runtime_us));
+	pr_info("dmabench: %s: latency p50 %llu p99 %llu p999 %llu max %llu ns\n",
+		name, dmabench_percentile(hist, count, 500),
+		dmabench_percentile(hist, count, 990),
+		dmabench_percentile(hist, count, 999), lat_max);
+}
+
+static void dmabench_report_total(struct dmabench *bench)
+{
+	struct dmabench_thread *thread;
+	u64 count = 0, bytes = 0, lat_max = 0, runtime_ns = 0;
+	u64 *hist;
+	int i;
+
+	hist = kcalloc(DMABENCH_HIST_BUCKETS, sizeof(*hist), GFP_KERNEL);
+	if (!hist)
+		return;
+
+	list_for_each_entry(thread, &bench->threads, node) {
+		for (i = 0; i < DMABENCH_HIST_BUCKETS; i++)
+			hist[i] += thread->hist[i];
+		count += thread->count;
+		bytes += thread->bytes;
+		lat_max = max(lat_max, thread->lat_max);
+		runtime_ns = max(runtime_ns, thread->runtime_ns);
+	}
+
+	dmabench_report("total", hist, count, bytes, lat_max, runtime_ns);
+	kfree(hist);
+}
+
+/* Switch xilinx_dma channels to polled completion for the run */
+static void dmabench_set_poll_mode(struct dma_chan *chan,
+				   enum xilinx_dma_poll_mode poll_mode)
+{
+	struct xilinx_dma_peripheral_config pconfig = {
+		.poll_mode = poll_mode,
+	};
+	struct dma_slave_config config = {
+		.peripheral_config = &pconfig,
+		.peripheral_size = sizeof(pconfig),
+	};
+
+	/* Channels without polling support keep using their interrupt */
+	dmaengine_slave_config(chan, &config);
+}
+
+static void dmabench_slot_callback(void *data)
+{
+	struct dmabench_slot *slot = data;
+
+	if (atomic_dec_and_test(&slot->pending)) {
+		slot->end_ns = ktime_get_ns();
+		smp_store_release(&slot->busy, false);
+		wake_up(&slot->thread->wait);
+	}
+}
+
+static void dmabench_cyclic_callback(void *data)
+{
+	struct dmabench_thread *thread = data;
+	u64 now = ktime_get_ns();
+
+	if (thread->last_ns)
+		dmabench_record(thread, now - thread->last_ns, thread->len);
+	thread->last_ns = now;
+}
+
+static struct dma_async_tx_descriptor *
+dmabench_prep(struct dmabench *bench, struct dmabench_thread *thread,
+	      struct dmabench_slot *slot, enum dma_transfer_direction dir,
+	      unsigned long flags)
+{
+	struct dma_chan *chan = dir == DMA_MEM_TO_DEV ? thread->tx_chan :
+							thread->rx_chan;
+	struct dma_interleaved_template *xt;
+	struct dma_async_tx_descriptor *desc;
+
+	if (bench->mode == DMABENCH_SG)
+		return dmaengine_prep_slave_sg(chan, dir == DMA_MEM_TO_DEV ?
+					       slot->tx_sg : slot->rx_sg,
+					       sg_len, dir, flags);
+
+	xt = kzalloc(struct_size(xt, sgl, 1), GFP_KERNEL);
+	if (!xt)
+		return NULL;
+
+	xt->dir = dir;
+	xt->src_start = slot->src_dma;
+	xt->dst_start = slot->dst_dma;
+	xt->numf = vsize;
+	xt->frame_size = 1;
+	xt->sgl[0].size = hsize;
+	desc = dmaengine_prep_interleaved_dma(chan, xt, flags);
+	kfree(xt);
+
+	return desc;
+}
+
+static int dmabench_submit(struct dmabench *bench,
+			   struct dmabench_thread *thread,
+			   struct dmabench_slot *slot)
+{
+	unsigned long flags = DMA_CTRL_ACK | (polled ? 0 : DMA_PREP_INTERRUPT);
+	struct dma_async_tx_descriptor *txd, *rxd;
+
+	rxd = dmabench_prep(bench, thread, slot, DMA_DEV_TO_MEM, flags);
+	txd = dmabench_prep(bench, thread, slot, DMA_MEM_TO_DEV, flags);
+	if (!rxd || !txd)
+		return -ENOMEM;
+
+	atomic_set(&slot->pending, 2);
+	rxd->callback = polled ? NULL : dmabench_slot_callback;
+	rxd->callback_param = slot;
+	txd->callback = rxd->callback;
+	txd->callback_param = slot;
+
+	slot->start_ns = ktime_get_ns();
+	slot->rx_cookie = dmaengine_submit(rxd);
+	slot->tx_cookie = dmaengine_submit(txd);
+	if (dma_submit_error(slot->rx_cookie) ||
+	    dma_submit_error(slot->tx_cookie))
+		return -EIO;
+
+	slot->busy = true;
+
+	return 0;
+}
+
+/* Wait for the oldest transfer in flight, return 0 once it is complete */
+static int dmabench_wait(struct dmabench_thread *thread,
+			 struct dmabench_slot *slot)
+{
+	unsigned long timeout = msecs_to_jiffies(DMABENCH_TIMEOUT_MS);
+	enum dma_status tx_status, rx_status;
+	u64 deadline;
+
+	if (!polled) {
+		if (!wait_event_timeout(thread->wait,
+					!smp_load_acquire(&slot->busy),
+					timeout))
+			return -ETIMEDOUT;
+		return 0;
+	}
+
+	deadline = ktime_get_ns() + (u64)DMABENCH_TIMEOUT_MS * NSEC_PER_MSEC;
+	do {
+		rx_status = dmaengine_tx_status(thread->rx_chan,
+						slot->rx_cookie, NULL);
+		tx_status = dmaengine_tx_status(thread->tx_chan,
+						slot->tx_cookie, NULL);
+		if (rx_status == DMA_ERROR || tx_status == DMA_ERROR)
+			return -EIO;
+		if (rx_status == DMA_COMPLETE && tx_status == DMA_COMPLETE) {
+			slot->end_ns = ktime_get_ns();
+			slot->busy = false;
+			return 0;
+		}
+		cpu_relax();
+	} while (ktime_get_ns() < deadline);
+
+	return -ETIMEDOUT;
+}
+
+static int dmabench_run_queued(struct dmabench *bench,
+			       struct dmabench_thread *thread, u64 end_ns)
+{
+	struct dmabench_slot *slot;
+	unsigned int head = 0, i;
+	int ret;
+
+	for (i = 0; i < thread->nr_slots; i++) {
+		ret = dmabench_submit(bench, thread, &thread->slots[i]);
+		if (ret)
+			return ret;
+	}
+	dma_async_issue_pending(thread->rx_chan);
+	dma_async_issue_pending(thread->tx_chan);
+
+	for (;;) {
+		slot = &thread->slots[head];
+		ret = dmabench_wait(thread, slot);
+		if (ret)
+			return ret;
+
+		dmabench_record(thread, slot->end_ns - slot->start_ns,
+				thread->len);
+
+		if (kthread_should_stop() || ktime_get_ns() >= end_ns)
+			break;
+
+		ret = dmabench_submit(bench, thread, slot);
+		if (ret)
+			return ret;
+		dma_async_issue_pending(thread->rx_chan);
+		dma_async_issue_pending(thread->tx_chan);
+
+		head = (head + 1) % thread->nr_slots;
+	}
+
+	/* Drain the transfers still in flight without accounting them */
+	for (i = 0; i < thread->nr_slots; i++) {
+		slot = &thread->slots[(head + 1 + i) % thread->nr_slots];
+		if (slot->busy && dmabench_wait(thread, slot))
+			break;
+	}
+
+	return 0;
+}
+
+static int dmabench_run_cyclic(struct dmabench_thread *thread, u64 end_ns)
+{
+	struct dmabench_slot *slot = &thread->slots[0];
+	size_t total = (size_t)thread->len * queue_depth;
+	struct dma_async_tx_descriptor *txd, *rxd;
+
+	rxd = dmaengine_prep_dma_cyclic(thread->rx_chan, slot->dst_dma, total,
+					thread->len, DMA_DEV_TO_MEM,
+					DMA_CTRL_ACK | DMA_PREP_INTERRUPT);
+	txd = dmaengine_prep_dma_cyclic(thread->tx_chan, slot->src_dma, total,
+					thread->len, DMA_MEM_TO_DEV,
+					DMA_CTRL_ACK);
+	if (!rxd || !txd)
+		return -ENOMEM;
+
+	rxd->callback = dmabench_cyclic_callback;
+	rxd->callback_param = thread;
+	if (dma_submit_error(dmaengine_submit(rxd)) ||
+	    dma_submit_error(dmaengine_submit(txd)))
+		return -EIO;
+
+	dma_async_issue_pending(thread->rx_chan);
+	dma_async_issue_pending(thread->tx_chan);
+
+	while (!kthread_should_stop() && ktime_get_ns() < end_ns)
+		msleep(20);
+
+	dmaengine_terminate_sync(thread->tx_chan);
+	dmaengine_terminate_sync(thread->rx_chan);
+
+	return 0;
+}
+
+static void dmabench_free_slots(struct dmabench_thread *thread)
+{
+	struct device *tx_dev = thread->tx_chan->device->dev;
+	struct device *rx_dev = thread->rx_chan->device->dev;
+	size_t size = thread->len;
+	unsigned int i;
+
+	if (!thread->slots)
+		return;
+
+	if (thread->bench->mode == DMABENCH_CYCLIC)
+		size *= queue_depth;
+
+	for (i = 0; i < thread->nr_slots; i++) {
+		struct dmabench_slot *slot = &thread->slots[i];
+
+		if (slot->src)
+			dma_free_coherent(tx_dev, size, slot->src,
+					  slot->src_dma);
+		if (slot->dst)
+			dma_free_coherent(rx_dev, size, slot->dst,
+					  slot->dst_dma);
+		kfree(slot->tx_sg);
+		kfree(slot->rx_sg);
+	}
+	kfree(thread->slots);
+}
+
+static int dmabench_alloc_slots(struct dmabench *bench,
+				struct dmabench_thread *thread)
+{
+	struct device *tx_dev = thread->tx_chan->device->dev;
+	struct device *rx_dev = thread->rx_chan->device->dev;
+	size_t size = thread->len, chunk = thread->len / sg_len;
+	unsigned int i, j;
+
+	/* A cyclic transfer is one buffer of queue_depth periods */
+	thread->nr_slots = queue_depth;
+	if (bench->mode == DMABENCH_CYCLIC) {
+		thread->nr_slots = 1;
+		size *= queue_depth;
+	}
+
+	thread->slots = kcalloc(thread->nr_slots, sizeof(*thread->slots),
+				GFP_KERNEL);
+	if (!thread->slots)
+		return -ENOMEM;
+
+	for (i = 0; i < thread->nr_slots; i++) {
+		struct dmabench_slot *slot = &thread->slots[i];
+
+		slot->thread = thread;
+		slot->src = dma_alloc_coherent(tx_dev, size, &slot->src_dma,
+					       GFP_KERNEL);
+		slot->dst = dma_alloc_coherent(rx_dev, size, &slot->dst_dma,
+					       GFP_KERNEL);
+		if (!slot->src || !slot->dst)
+			return -ENOMEM;
+
+		if (bench->mode != DMABENCH_SG)
+			continue;
+
+		slot->tx_sg = kcalloc(sg_len, sizeof(*slot->tx_sg), GFP_KERNEL);
+		slot->rx_sg = kcalloc(sg_len, sizeof(*slot->rx_sg), GFP_KERNEL);
+		if (!slot->tx_sg || !slot->rx_sg)
+			return -ENOMEM;
+
+		sg_init_table(slot->tx_sg, sg_len);
+		sg_init_table(slot->rx_sg, sg_len);
+		for (j = 0; j < sg_len; j++) {
+			sg_dma_address(&slot->tx_sg[j]) = slot->src_dma +
+							  j * chunk;
+			sg_dma_len(&slot->tx_sg[j]) = chunk;
+			sg_dma_address(&slot->rx_sg[j]) = slot->dst_dma +
+							  j * chunk;
+			sg_dma_len(&slot->rx_sg[j]) = chunk;
+		}
+	}
+
+	return 0;
+}
+
+static void dmabench_vdma_config(struct dma_chan *chan)
+{
+	struct xilinx_vdma_config config = {
+		.frm_cnt_en = 1,
+		.coalesc = 1,
+	};
+
+	/* Circular mode, one interrupt per frame */
+	xilinx_vdma_channel_set_config(chan, &config);
+}
+
+static int dmabench_thread_func(void *data)
+{
+	struct dmabench_thread *thread = data;
+	struct dmabench *bench = thread->bench;
+	const char *thread_name = current->comm;
+	u64 start, end_ns;
+	int ret;
+
+	ret = dmabench_alloc_slots(bench, thread);
+	if (ret)
+		goto out;
+
+	if (bench->mode == DMABENCH_VDMA) {
+		dmabench_vdma_config(thread->tx_chan);
+		dmabench_vdma_config(thread->rx_chan);
+	}
+
+	if (polled && bench->mode != DMABENCH_CYCLIC) {
+		dmabench_set_poll_mode(thread->tx_chan, XILINX_DMA_POLL_ALWAYS);
+		dmabench_set_poll_mode(thread->rx_chan, XILINX_DMA_POLL_ALWAYS);
+	}
+
+	start = ktime_get_ns();
+	end_ns = start + (u64)duration_ms * NSEC_PER_MSEC;
+	if (bench->mode == DMABENCH_CYCLIC)
+		ret = dmabench_run_cyclic(thread, end_ns);
+	else
+		ret = dmabench_run_queued(bench, thread, end_ns);
+	thread->runtime_ns = ktime_get_ns() - start;
+
+	if (ret) {
+		pr_warn("dmabench: %s: stopped after %llu transfers (%d)\n",
+			thread_name, thread->count, ret);
+		dmaengine_terminate_sync(thread->tx_chan);
+		dmaengine_terminate_sync(thread->rx_chan);
+	}
+
+	if (polled && bench->mode != DMABENCH_CYCLIC) {
+		dmabench_set_poll_mode(thread->tx_chan, XILINX_DMA_POLL_NONE);
+		dmabench_set_poll_mode(thread->rx_chan, XILINX_DMA_POLL_NONE);
+	}
+
+	dmabench_report(thread_name, thread->hist, thread->count,
+			thread->bytes, thread->lat_max, thread->runtime_ns);
+
+out:
+	dmabench_free_slots(thread);
+
+	if (atomic_dec_and_test(&bench->running))
+		dmabench_report_total(bench);
+
+	/* Stay around until the driver is unbound */
+	set_current_state(TASK_INTERRUPTIBLE);
+	while (!kthread_should_stop()) {
+		schedule();
+		set_current_state(TASK_INTERRUPTIBLE);
+	}
+	__set_current_state(TASK_RUNNING);
+
+	return ret;
+}
+
+static int dmabench_add_thread(struct dmabench *bench,
+			       struct dma_chan *tx_chan,
+			       struct dma_chan *rx_chan, int cpu)
+{
+	struct dmabench_thread *thread;
+
+	thread = kzalloc(sizeof(*thread), GFP_KERNEL);
+	if (!thread)
+		return -ENOMEM;
+
+	thread->hist = kcalloc(DMABENCH_HIST_BUCKETS, sizeof(*thread->hist),
+			       GFP_KERNEL);
+	if (!thread->hist) {
+		kfree(thread);
+		return -ENOMEM;
+	}
+
+	thread->bench = bench;
+	thread->tx_chan = tx_chan;
+	thread->rx_chan = rx_chan;
+	thread->len = bench->mode == DMABENCH_VDMA ? hsize * vsize : buf_size;
+	init_waitqueue_head(&thread->wait);
+
+	thread->task = kthread_create(dmabench_thread_func, thread, "%s-%s",
+				      dma_chan_name(tx_chan),
+				      dma_chan_name(rx_chan));
+	if (IS_ERR(thread->task)) {
+		int ret = PTR_ERR(thread->task);
+
+		kfree(thread->hist);
+		kfree(thread);
+		return ret;
+	}
+
+	if (cpu >= 0)
+		kthread_bind(thread->task, cpu);
+	get_task_struct(thread->task);
+	list_add_tail(&thread->node, &bench->threads);
+
+	return 0;
+}
+
+static void dmabench_cleanup(struct dmabench *bench)
+{
+	struct dmabench_thread *thread, *_thread;
+
+	list_for_each_entry_safe(thread, _thread, &bench->threads, node) {
+		kthread_stop(thread->task);
+		put_task_struct(thread->task);
+		dma_release_channel(thread->tx_chan);
+		dma_release_channel(thread->rx_chan);
+		list_del(&thread->node);
+		kfree(thread->hist);
+		kfree(thread);
+	}
+}
+
+static int xilinx_dmabench_probe(struct platform_device *pdev)
+{
+	struct dma_chan *tx_chan, *rx_chan;
+	struct dmabench_thread *thread;
+	struct dmabench *bench;
+	cpumask_var_t mask;
+	unsigned int i;
+	int cpu = -1;
+	int err = 0;
+
+	bench = devm_kzalloc(&pdev->dev, sizeof(*bench), GFP_KERNEL);
+	if (!bench)
+		return -ENOMEM;
+
+	if (!strcmp(mode, "sg")) {
+		bench->mode = DMABENCH_SG;
+	} else if (!strcmp(mode, "cyclic")) {
+		bench->mode = DMABENCH_CYCLIC;
+	} else if (!strcmp(mode, "vdma")) {
+		bench->mode = DMABENCH_VDMA;
+	} else {
+		pr_err("dmabench: unknown mode %s\n", mode);
+		return -EINVAL;
+	}
+
+	if (!buf_size || !queue_depth || !sg_len || buf_size % sg_len ||
+	    !hsize || !vsize) {
+		pr_err("dmabench: invalid transfer parameters\n");
+		return -EINVAL;
+	}
+
+	if (!zalloc_cpumask_var(&mask, GFP_KERNEL))
+		return -ENOMEM;
+
+	if (*cpus) {
+		err = cpulist_parse(cpus, mask);
+		if (err || !cpumask_intersects(mask, cpu_online_mask)) {
+			pr_err("dmabench: invalid cpu list %s\n", cpus);
+			free_cpumask_var(mask);
+			return -EINVAL;
+		}
+		cpumask_and(mask, mask, cpu_online_mask);
+	}
+
+	INIT_LIST_HEAD(&bench->threads);
+	platform_set_drvdata(pdev, bench);
+
+	for (i = 0; !threads || i < threads; i++) {
+		char name[16];
+
+		snprintf(name, sizeof(name), "tx%u", i);
+		tx_chan = dma_request_chan(&pdev->dev, name);
+		if (IS_ERR(tx_chan)) {
+			err = PTR_ERR(tx_chan);
+			break;
+		}
+
+		snprintf(name, sizeof(name), "rx%u", i);
+		rx_chan = dma_request_chan(&pdev->dev, name);
+		if (IS_ERR(rx_chan)) {
+			err = PTR_ERR(rx_chan);
+			dma_release_channel(tx_chan);
+			break;
+		}
+
+		if (*cpus) {
+			cpu = cpumask_next(cpu, mask);
+			if (cpu >= nr_cpu_ids)
+				cpu = cpumask_first(mask);
+		}
+
+		err = dmabench_add_thread(bench, tx_chan, rx_chan, cpu);
+		if (err) {
+			dma_release_channel(rx_chan);
+			dma_release_channel(tx_chan);
+			break;
+		}
+	}
+	free_cpumask_var(mask);
+
+	/* Running out of channel pairs ends the list */
+	if (err == -ENODEV && i)
+		err = 0;
+	if (!i && !err)
+		err = -ENODEV;
+	if (err) {
+		if (err != -EPROBE_DEFER)
+			pr_err("dmabench: unable to get channel pair %u (%d)\n",
+			       i, err);
+		dmabench_cleanup(bench);
+		return err;
+	}
+
+	atomic_set(&bench->running, i);
+	list_for_each_entry(thread, &bench->threads, node)
+		wake_up_process(thread->task);
+
+	pr_info("dmabench: started %u threads in %s mode\n", i, mode);
+
+	return 0;
+}
+
+static int xilinx_dmabench_remove(struct platform_device *pdev)
+{
+	dmabench_cleanup(platform_get_drvdata(pdev));
+
+	return 0;
+}
+
+static const struct of_device_id xilinx_dmabench_of_ids[] = {
+	{ .compatible = "xlnx,axi-dma-bench-1.00.a",},
+	{}
+};
+MODULE_DEVICE_TABLE(of, xilinx_dmabench_of_ids);
+
+static struct platform_driver xilinx_dmabench_driver = {
+	.driver = {
+		.name = "xilinx_dmabench",
+		.of_match_table = xilinx_dmabench_of_ids,
+	},
+	.probe = xilinx_dmabench_probe,
+	.remove = xilinx_dmabench_remove,
+};
+
+module_platform_driver(xilinx_dmabench_driver);
+
+MODULE_AUTHOR("Xilinx, Inc.");
+MODULE_DESCRIPTION("Xilinx AXI DMA/MCDMA/VDMA Benchmark Client");
+MODULE_LICENSE("GPL v2");
@@ -29,6 +29,7 @@
 
 #include "../dmaengine.h"
 #include "../virt-dma.h"
+#include "xilinx_dma_stats.h"
 
 /* DPDMA registers */
 #define XILINX_DPDMA_ERR_CTRL				0x000
@@ -194,12 +195,16 @@ struct xilinx_dpdma_sw_desc {
  * @chan: DMA channel
  * @descriptors: list of software descriptors
  * @error: an error has been detected with this descriptor
+ * @len: length of the transfer in bytes
+ * @submit_ns: submission timestamp for the channel statistics
  */
 struct xilinx_dpdma_tx_desc {
 	struct virt_dma_desc vdesc;
 	struct xilinx_dpdma_chan *chan;
 	struct list_head descriptors;
 	bool error;
+	size_t len;
+	u64 submit_ns;
 };
 
 #define to_dpdma_tx_desc(_desc) \
@@ -212,6 +217,7 @@ struct xilinx_dpdma_tx_desc {
  * @id: channel ID
  * @wait_to_stop: queue to wait for outstanding transacitons before stopping
  * @running: true if the channel is running
+ * @stopping: true if the channel waits for no outstanding transaction to stop
  * @first_frame: flag for the first frame of stream
  * @video_group: flag if multi-channel operation is needed for video channels
  * @lock: lock to access struct xilinx_dpdma_chan
@@ -221,6 +227,7 @@ struct xilinx_dpdma_tx_desc {
  * @desc.pending: Descriptor schedule to the hardware, pending execution
  * @desc.active: Descriptor being executed by the hardware
  * @xdev: DPDMA device
+ * @stats: transfer statistics
  */
 struct xilinx_dpdma_chan {
 	struct virt_dma_chan vchan;
@@ -229,6 +236,7 @@ struct xilinx_dpdma_chan {
 
 	wait_queue_head_t wait_to_stop;
 	bool running;
+	bool stopping;
 	bool first_frame;
 	bool video_group;
 
@@ -242,6 +250,7 @@ struct xilinx_dpdma_chan {
 	} desc;
 
 	struct xilinx_dpdma_device *xdev;
+	struct xdma_stats stats;
 };
 
 #define to_xilinx_chan(_chan) \
@@ -451,6 +460,7 @@ static const struct file_operations fops_xilinx_dpdma_dbgfs = {
 static void xilinx_dpdma_debugfs_init(struct xilinx_dpdma_device *xdev)
 {
 	struct dentry *dent;
+	unsigned int i;
 
 	dpdma_debugfs.testcase = DPDMA_TC_NONE;
 
@@ -458,6 +468,13 @@ static void xilinx_dpdma_debugfs_init(struct xilinx_dpdma_device *xdev)
 				   NULL, &fops_xilinx_dpdma_dbgfs);
 	if (IS_ERR(dent))
 		dev_err(xdev->dev, "Failed to create debugfs testcase file\n");
+
+	for (i = 0; i < ARRAY_SIZE(xdev->chan); i++) {
+		struct xilinx_dpdma_chan *chan = xdev->chan[i];
+
+		xdma_stats_debugfs_init(&chan->stats, xdev->common.dbg_dev_root,
+					dma_chan_name(&chan->vchan.chan));
+	}
 }
 
 /* -----------------------------------------------------------------------------
@@ -669,6 +686,34 @@ static void xilinx_dpdma_chan_free_tx_desc(struct virt_dma_desc *vdesc)
 	kfree(desc);
 }
 
+/**
+ * xilinx_dpdma_tx_submit - Submit a transaction descriptor
+ * @tx: DMA transaction descriptor
+ *
+ * Submit the descriptor through the virtual DMA channel and account it in the
+ * channel statistics.
+ *
+ * Return: the cookie of the descriptor.
+ */
+static dma_cookie_t xilinx_dpdma_tx_submit(struct dma_async_tx_descriptor *tx)
+{
+	struct xilinx_dpdma_chan *chan = to_xilinx_chan(tx->chan);
+	struct xilinx_dpdma_sw_desc *sw_desc;
+	struct xilinx_dpdma_tx_desc *desc;
+	dma_cookie_t cookie;
+
+	desc = to_dpdma_tx_desc(container_of(tx, struct virt_dma_desc, tx));
+	desc->len = 0;
+	list_for_each_entry(sw_desc, &desc->descriptors, node)
+		desc->len += sw_desc->hw.xfer_size;
+
+	cookie = vchan_tx_submit(tx);
+	desc->submit_ns = xdma_stats_submit(&chan->stats, tx->chan, cookie,
+					    desc->len);
+
+	return cookie;
+}
+
 /**
  * xilinx_dpdma_chan_prep_cyclic - Prepare a cyclic dma descriptor
  * @chan: DPDMA channel
@@ -739,7 +784,10 @@ xilinx_dpdma_chan_prep_cyclic(struct xilinx_dpdma_chan *chan,
 
 	last->hw.control |= XILINX_DPDMA_DESC_CONTROL_LAST_OF_FRAME;
 
-	return vchan_tx_prep(&chan->vchan, &tx_desc->vdesc, flags);
+	vchan_tx_prep(&chan->vchan, &tx_desc->vdesc, flags);
+	tx_desc->vdesc.tx.tx_submit = xilinx_dpdma_tx_submit;
+
+	return &tx_desc->vdesc.tx;
 
 error:
 	xilinx_dpdma_chan_free_tx_desc(&tx_desc->vdesc);
@@ -911,7 +959,8 @@ static void xilinx_dpdma_chan_queue_transfer(struct xilinx_dpdma_chan *chan)
 
 	lockdep_assert_held(&chan->lock);
 
-	if (chan->desc.pending)
+	/* The transfer is queued once the channel has stopped. */
+	if (chan->desc.pending || chan->stopping)
 		return;
 
 	if (!chan->running) {
@@ -929,6 +978,8 @@ static void xilinx_dpdma_chan_queue_transfer(struct xilinx_dpdma_chan *chan)
 	chan->desc.pending = desc;
 	list_del(&desc->vdesc.node);
 
+	xdma_stats_start(&chan->stats, &chan->vchan.chan, 1);
+
 	/*
 	 * Assign the cookie to descriptors in this transaction. Only 16 bit
 	 * will be used, but it should be enough.
@@ -983,22 +1034,55 @@ static u32 xilinx_dpdma_chan_ostand(struct xilinx_dpdma_chan *chan)
 			 dpdma_read(chan->reg, XILINX_DPDMA_CH_STATUS));
 }
 
+/**
+ * xilinx_dpdma_chan_stopped - Complete the stop of the channel
+ * @chan: DPDMA channel
+ *
+ * Disable the channel, release the descriptors the hardware was working on,
+ * and wake up the waiters. If new descriptors have been issued while the
+ * channel was stopping, restart it right away with them.
+ */
+static void xilinx_dpdma_chan_stopped(struct xilinx_dpdma_chan *chan)
+{
+	lockdep_assert_held(&chan->lock);
+
+	xilinx_dpdma_chan_disable(chan);
+	chan->running = false;
+	chan->stopping = false;
+
+	spin_lock(&chan->vchan.lock);
+	if (chan->desc.pending) {
+		vchan_terminate_vdesc(&chan->desc.pending->vdesc);
+		chan->desc.pending = NULL;
+	}
+	if (chan->desc.active) {
+		vchan_terminate_vdesc(&chan->desc.active->vdesc);
+		chan->desc.active = NULL;
+	}
+	if (!list_empty(&chan->vchan.desc_issued))
+		xilinx_dpdma_chan_queue_transfer(chan);
+	spin_unlock(&chan->vchan.lock);
+
+	wake_up(&chan->wait_to_stop);
+}
+
 /**
  * xilinx_dpdma_chan_notify_no_ostand - Notify no outstanding transaction event
  * @chan: DPDMA channel
  *
- * Notify waiters for no outstanding event, so waiters can stop the channel
- * safely. This function is supposed to be called when 'no outstanding'
- * interrupt is generated. The 'no outstanding' interrupt is disabled and
- * should be re-enabled when this event is handled. If the channel status
- * register still shows some number of outstanding transactions, the interrupt
- * remains enabled.
+ * Complete a pending stop of the channel, if any, and notify waiters for no
+ * outstanding event. This function is supposed to be called when 'no
+ * outstanding' interrupt is generated. The 'no outstanding' interrupt is
+ * disabled and is re-enabled when the channel is stopped next time. If the
+ * channel status register still shows some number of outstanding
+ * transactions, the interrupt remains enabled.
  *
  * Return: 0 on success. On failure, -EWOULDBLOCK if there's still outstanding
  * transaction(s).
  */
 static int xilinx_dpdma_chan_notify_no_ostand(struct xilinx_dpdma_chan *chan)
 {
+	unsigned long flags;
 	u32 cnt;
 
 	cnt = xilinx_dpdma_chan_ostand(chan);
@@ -1012,42 +1096,13 @@ static int xilinx_dpdma_chan_notify_no_ostand(struct xilinx_dpdma_chan *chan)
 	/* Disable 'no outstanding' interrupt */
 	dpdma_write(chan->xdev->reg, XILINX_DPDMA_IDS,
 		    XILINX_DPDMA_INTR_NO_OSTAND(chan->id));
-	wake_up(&chan->wait_to_stop);
-
-	return 0;
-}
-
-/**
- * xilinx_dpdma_chan_wait_no_ostand - Wait for the no outstanding irq
- * @chan: DPDMA channel
- *
- * Wait for the no outstanding transaction interrupt. This functions can sleep
- * for 50ms.
- *
- * Return: 0 on success. On failure, -ETIMEOUT for time out, or the error code
- * from wait_event_interruptible_timeout().
- */
-static int xilinx_dpdma_chan_wait_no_ostand(struct xilinx_dpdma_chan *chan)
-{
-	int ret;
-
-	/* Wait for a no outstanding transaction interrupt upto 50msec */
-	ret = wait_event_interruptible_timeout(chan->wait_to_stop,
-					       !xilinx_dpdma_chan_ostand(chan),
-					       msecs_to_jiffies(50));
-	if (ret > 0) {
-		dpdma_write(chan->xdev->reg, XILINX_DPDMA_IEN,
-			    XILINX_DPDMA_INTR_NO_OSTAND(chan->id));
-		return 0;
-	}
 
-	dev_err(chan->xdev->dev, "chan%u: not ready to stop: %d trans\n",
-		chan->id, xilinx_dpdma_chan_ostand(chan));
-
-	if (ret == 0)
-		return -ETIMEDOUT;
+	spin_lock_irqsave(&chan->lock, flags);
+	if (chan->stopping)
+		xilinx_dpdma_chan_stopped(chan);
+	spin_unlock_irqrestore(&chan->lock, flags);
 
-	return ret;
+	return 0;
 }
 
 /**
@@ -1086,26 +1141,26 @@ static int xilinx_dpdma_chan_poll_no_ostand(struct xilinx_dpdma_chan *chan)
  * xilinx_dpdma_chan_stop - Stop the channel
  * @chan: DPDMA channel
  *
- * Stop a previously paused channel by first waiting for completion of all
- * outstanding transaction and then disabling the channel.
- *
- * Return: 0 on success, or -ETIMEDOUT if the channel failed to stop.
+ * Start stopping a previously paused channel. The channel can only be
+ * disabled once all outstanding transactions have completed, which is
+ * signalled by the 'no outstanding' interrupt, so the stop completes from
+ * there without blocking the caller. Descriptors issued in the meantime are
+ * queued when the channel has stopped.
  */
-static int xilinx_dpdma_chan_stop(struct xilinx_dpdma_chan *chan)
+static void xilinx_dpdma_chan_stop(struct xilinx_dpdma_chan *chan)
 {
-	unsigned long flags;
-	int ret;
+	lockdep_assert_held(&chan->lock);
 
-	ret = xilinx_dpdma_chan_wait_no_ostand(chan);
-	if (ret)
-		return ret;
+	if (!chan->running || chan->stopping)
+		return;
 
-	spin_lock_irqsave(&chan->lock, flags);
-	xilinx_dpdma_chan_disable(chan);
-	chan->running = false;
-	spin_unlock_irqrestore(&chan->lock, flags);
+	chan->stopping = true;
+	dpdma_write(chan->xdev->reg, XILINX_DPDMA_IEN,
+		    XILINX_DPDMA_INTR_NO_OSTAND(chan->id));
 
-	return 0;
+	/* Don't wait for the interrupt if nothing is outstanding already. */
+	if (!xilinx_dpdma_chan_ostand(chan))
+		xilinx_dpdma_chan_stopped(chan);
 }
 
 /**
@@ -1155,7 +1210,7 @@ static void xilinx_dpdma_chan_vsync_irq(struct  xilinx_dpdma_chan *chan)
 	spin_lock_irqsave(&chan->lock, flags);
 
 	pending = chan->desc.pending;
-	if (!chan->running || !pending)
+	if (!chan->running || chan->stopping || !pending)
 		goto out;
 
 	desc_id = dpdma_read(chan->reg, XILINX_DPDMA_CH_DESC_ID)
@@ -1175,8 +1230,14 @@ static void xilinx_dpdma_chan_vsync_irq(struct  xilinx_dpdma_chan *chan)
 	 * Complete the active descriptor, if any, promote the pending
 	 * descriptor to active, and queue the next transfer, if any.
 	 */
-	if (chan->desc.active)
-		vchan_cookie_complete(&chan->desc.active->vdesc);
+	if (chan->desc.active) {
+		struct xilinx_dpdma_tx_desc *active = chan->desc.active;
+
+		xdma_stats_complete(&chan->stats, &chan->vchan.chan,
+				    active->vdesc.tx.cookie, active->len,
+				    active->submit_ns);
+		vchan_cookie_complete(&active->vdesc);
+	}
 	chan->desc.active = pending;
 	chan->desc.pending = NULL;
 
@@ -1236,6 +1297,12 @@ static void xilinx_dpdma_chan_handle_err(struct xilinx_dpdma_chan *chan)
 		dpdma_read(chan->reg, XILINX_DPDMA_CH_PYLD_CUR_ADDRE),
 		dpdma_read(chan->reg, XILINX_DPDMA_CH_PYLD_CUR_ADDR));
 
+	/* Nothing to reschedule on a channel being terminated. */
+	if (chan->stopping) {
+		xilinx_dpdma_chan_stopped(chan);
+		goto out_unlock;
+	}
+
 	xilinx_dpdma_chan_disable(chan);
 	chan->running = false;
 
@@ -1308,6 +1375,7 @@ xilinx_dpdma_prep_interleaved_dma(struct dma_chan *dchan,
 		return NULL;
 
 	vchan_tx_prep(&chan->vchan, &desc->vdesc, flags | DMA_CTRL_ACK);
+	desc->vdesc.tx.tx_submit = xilinx_dpdma_tx_submit;
 
 	return &desc->vdesc.tx;
 }
@@ -1356,12 +1424,26 @@ static void xilinx_dpdma_free_chan_resources(struct dma_chan *dchan)
 	chan->desc_pool = NULL;
 }
 
+static unsigned int
+xilinx_dpdma_chan_submitted_count(struct xilinx_dpdma_chan *chan)
+{
+	struct list_head *entry;
+	unsigned int count = 0;
+
+	list_for_each(entry, &chan->vchan.desc_submitted)
+		count++;
+
+	return count;
+}
+
 static void xilinx_dpdma_issue_pending(struct dma_chan *dchan)
 {
 	struct xilinx_dpdma_chan *chan = to_xilinx_chan(dchan);
 	unsigned long flags;
 
 	spin_lock_irqsave(&chan->vchan.lock, flags);
+	xdma_stats_issue(&chan->stats, dchan,
+			 xilinx_dpdma_chan_submitted_count(chan));
 	if (vchan_issue_pending(&chan->vchan))
 		xilinx_dpdma_chan_queue_transfer(chan);
 	spin_unlock_irqrestore(&chan->vchan.lock, flags);
@@ -1416,22 +1498,24 @@ static int xilinx_dpdma_resume(struct dma_chan *dchan)
  * xilinx_dpdma_terminate_all - Terminate the channel and descriptors
  * @dchan: DMA channel
  *
- * Pause the channel without waiting for ongoing transfers to complete. Waiting
- * for completion is performed by xilinx_dpdma_synchronize() that will disable
- * the channel to complete the stop.
+ * Pause the channel without waiting for ongoing transfers to complete, and
+ * start stopping it. The stop completes from the 'no outstanding' interrupt,
+ * so this function never blocks, and new descriptors can be issued right
+ * away: they are queued to the hardware as soon as the channel has stopped.
+ * xilinx_dpdma_synchronize() waits for the stop to complete.
  *
  * All the descriptors associated with the channel that are guaranteed not to
- * be touched by the hardware. The pending and active descriptor are not
- * touched, and will be freed either upon completion, or by
- * xilinx_dpdma_synchronize().
+ * be touched by the hardware are freed. The pending and active descriptor
+ * are released when the channel has stopped.
  *
- * Return: 0 on success, or -ETIMEDOUT if the channel failed to stop.
+ * Return: 0 on success.
  */
 static int xilinx_dpdma_terminate_all(struct dma_chan *dchan)
 {
 	struct xilinx_dpdma_chan *chan = to_xilinx_chan(dchan);
 	struct xilinx_dpdma_device *xdev = chan->xdev;
 	LIST_HEAD(descriptors);
+	unsigned long channels = 0;
 	unsigned long flags;
 	unsigned int i;
 
@@ -1442,11 +1526,13 @@ static int xilinx_dpdma_terminate_all(struct dma_chan *dchan)
 			    xdev->chan[i]->running) {
 				xilinx_dpdma_chan_pause(xdev->chan[i]);
 				xdev->chan[i]->video_group = false;
+				channels |= BIT(i);
 			}
 		}
 	} else {
 		xilinx_dpdma_chan_pause(chan);
 	}
+	channels |= BIT(chan->id);
 
 	/* Gather all the descriptors we can free and free them. */
 	spin_lock_irqsave(&chan->vchan.lock, flags);
@@ -1455,6 +1541,12 @@ static int xilinx_dpdma_terminate_all(struct dma_chan *dchan)
 
 	vchan_dma_desc_free_list(&chan->vchan, &descriptors);
 
+	for_each_set_bit(i, &channels, ARRAY_SIZE(xdev->chan)) {
+		spin_lock_irqsave(&xdev->chan[i]->lock, flags);
+		xilinx_dpdma_chan_stop(xdev->chan[i]);
+		spin_unlock_irqrestore(&xdev->chan[i]->lock, flags);
+	}
+
 	return 0;
 }
 
@@ -1467,27 +1559,27 @@ static int xilinx_dpdma_terminate_all(struct dma_chan *dchan)
  * have returned.
  *
  * This function waits for the DMA channel to stop. It assumes it has been
- * paused by a previous call to dmaengine_terminate_async(), and that no new
- * pending descriptors have been issued with dma_async_issue_pending(). The
- * behaviour is undefined otherwise.
+ * terminated by a previous call to dmaengine_terminate_async(), and that no
+ * new pending descriptors have been issued with dma_async_issue_pending().
+ * The behaviour is undefined otherwise. If the outstanding transactions
+ * don't complete within 50ms, the channel is disabled regardless.
  */
 static void xilinx_dpdma_synchronize(struct dma_chan *dchan)
 {
 	struct xilinx_dpdma_chan *chan = to_xilinx_chan(dchan);
 	unsigned long flags;
+	int ret;
 
-	xilinx_dpdma_chan_stop(chan);
+	ret = wait_event_timeout(chan->wait_to_stop, !READ_ONCE(chan->stopping),
+				 msecs_to_jiffies(50));
 
-	spin_lock_irqsave(&chan->vchan.lock, flags);
-	if (chan->desc.pending) {
-		vchan_terminate_vdesc(&chan->desc.pending->vdesc);
-		chan->desc.pending = NULL;
-	}
-	if (chan->desc.active) {
-		vchan_terminate_vdesc(&chan->desc.active->vdesc);
-		chan->desc.active = NULL;
+	spin_lock_irqsave(&chan->lock, flags);
+	if (!ret && chan->stopping) {
+		dev_err(chan->xdev->dev, "chan%u: not ready to stop: %d trans\n",
+			chan->id, xilinx_dpdma_chan_ostand(chan));
+		xilinx_dpdma_chan_stopped(chan);
 	}
-	spin_unlock_irqrestore(&chan->vchan.lock, flags);
+	spin_unlock_irqrestore(&chan->lock, flags);
 
 	vchan_synchronize(&chan->vchan);
 }
@@ -1667,6 +1759,7 @@ static int xilinx_dpdma_chan_init(struct xilinx_dpdma_device *xdev,
 
 	spin_lock_init(&chan->lock);
 	init_waitqueue_head(&chan->wait_to_stop);
+	xdma_stats_init(&chan->stats);
 
 	tasklet_setup(&chan->err_task, xilinx_dpdma_chan_err_task);
 
@@ -18,25 +18,32 @@
 
 #include <linux/bitops.h>
 #include <linux/clk.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/dma/xilinx_frmbuf.h>
+#include <linux/dma-fence.h>
 #include <linux/dmapool.h>
 #include <linux/gpio/consumer.h>
 #include <linux/init.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/iopoll.h>
+#include <linux/ktime.h>
+#include <linux/mfd/syscon.h>
 #include <linux/module.h>
 #include <linux/of_address.h>
 #include <linux/of_dma.h>
 #include <linux/of_irq.h>
 #include <linux/of_platform.h>
+#include <linux/regmap.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/videodev2.h>
 
 #include <drm/drm_fourcc.h>
 
 #include "../dmaengine.h"
+#include "xilinx_dma_compl.h"
 
 /* Register/Descriptor Offsets */
 #define XILINX_FRMBUF_CTRL_OFFSET		0x00
@@ -124,6 +131,16 @@
 #define XILINX_FRMBUF_MIN_HEIGHT		(64)
 #define XILINX_FRMBUF_MIN_WIDTH			(64)
 
+/* QoS registers of the ZynqMP AFI FM of the port the IP masters */
+#define XILINX_FRMBUF_AFI_RDQOS_OFFSET		0x08
+#define XILINX_FRMBUF_AFI_WRQOS_OFFSET		0x1c
+#define XILINX_FRMBUF_AFI_QOS_MAX		0xf
+
+static unsigned int ddr_budget_mbps;
+module_param(ddr_budget_mbps, uint, 0644);
+MODULE_PARM_DESC(ddr_budget_mbps,
+		 "DDR bandwidth the channels can reserve in MB/s (0 = no limit)");
+
 /**
  * struct xilinx_frmbuf_desc_hw - Hardware Descriptor
  * @luma_plane_addr: Luma or packed plane buffer address
@@ -148,6 +165,10 @@ struct xilinx_frmbuf_desc_hw {
  * @node: Node in the channel descriptors list
  * @fid: Field ID of buffer
  * @earlycb: Whether the callback should be called when in staged state
+ * @seqno: Fence sequence number, assigned in submission order
+ * @fence: Completion fence handed out to the client, if any
+ * @sof_ns: CLOCK_MONOTONIC time the IP started on the frame
+ * @eof_ns: CLOCK_MONOTONIC time the IP reported the frame done
  */
 struct xilinx_frmbuf_tx_descriptor {
 	struct dma_async_tx_descriptor async_tx;
@@ -155,6 +176,20 @@ struct xilinx_frmbuf_tx_descriptor {
 	struct list_head node;
 	u32 fid;
 	u32 earlycb;
+	u64 seqno;
+	struct dma_fence *fence;
+	u64 sof_ns;
+	u64 eof_ns;
+};
+
+/**
+ * struct xilinx_frmbuf_fence - Per frame completion fence
+ * @base: Base dma fence
+ * @chan: Channel the frame was queued on
+ */
+struct xilinx_frmbuf_fence {
+	struct dma_fence base;
+	struct xilinx_frmbuf_chan *chan;
 };
 
 /**
@@ -172,13 +207,28 @@ struct xilinx_frmbuf_tx_descriptor {
  * @irq: Channel IRQ
  * @direction: Transfer direction
  * @idle: Channel idle state
- * @tasklet: Cleanup work after irq
+ * @compl: Cleanup work after irq
  * @vid_fmt: Reference to currently assigned video format description
  * @hw_fid: FID enabled in hardware flag
  * @mode: Select operation mode
  * @fid_err_flag: Field id error detection flag
  * @fid_out_val: Field id out val
  * @fid_mode: Select fid mode
+ * @prefetch: Program the next frame while the current one is in progress
+ * @fence_lock: Lock of the channel fences
+ * @fence_context: Fence context of the channel
+ * @fence_seqno: Last fence sequence number of the channel
+ * @bw_width: Width of the frames the bandwidth is reserved for
+ * @bw_height: Height of the frames the bandwidth is reserved for
+ * @bw_fps: Frame rate the bandwidth is reserved for, 0 if none
+ * @bw_reserved: Reserved DDR bandwidth in bytes per second
+ * @bw_bytes: Bytes transferred by the completed frames
+ * @bw_frames: Number of completed frames
+ * @bw_last_ns: Time of the previous debugfs bandwidth read
+ * @bw_last_bytes: @bw_bytes at the previous debugfs bandwidth read
+ * @qos_regmap: AFI FM registers of the port, NULL if not described
+ * @qos_offset: Offset of the AFI FM in @qos_regmap
+ * @qos: AXI QoS programmed in the AFI FM, -1 if left at its default
  */
 struct xilinx_frmbuf_chan {
 	struct xilinx_frmbuf_device *xdev;
@@ -196,13 +246,29 @@ struct xilinx_frmbuf_chan {
 	int irq;
 	enum dma_transfer_direction direction;
 	bool idle;
-	struct tasklet_struct tasklet;
+	struct xdma_compl_item compl;
 	const struct xilinx_frmbuf_format_desc *vid_fmt;
 	bool hw_fid;
 	enum operation_mode mode;
 	u8 fid_err_flag;
 	u8 fid_out_val;
 	enum fid_modes fid_mode;
+	bool prefetch;
+	/* Fence signalling lock */
+	spinlock_t fence_lock;
+	u64 fence_context;
+	u64 fence_seqno;
+	u32 bw_width;
+	u32 bw_height;
+	u32 bw_fps;
+	u64 bw_reserved;
+	u64 bw_bytes;
+	u64 bw_frames;
+	u64 bw_last_ns;
+	u64 bw_last_bytes;
+	struct regmap *qos_regmap;
+	u32 qos_offset;
+	int qos;
 };
 
 /**
@@ -539,6 +605,7 @@ struct xilinx_frmbuf_feature {
  * @max_height: Maximum number of lines supported in IP.
  * @ppc: Pixels per clock supported in IP.
  * @ap_clk: Video core clock
+ * @compl: Context the channel cleanup work runs in
  */
 struct xilinx_frmbuf_device {
 	void __iomem *regs;
@@ -556,6 +623,7 @@ struct xilinx_frmbuf_device {
 	u32 max_height;
 	u32 ppc;
 	struct clk *ap_clk;
+	struct xdma_compl compl;
 };
 
 static const struct xilinx_frmbuf_feature xlnx_fbwr_cfg_v20 = {
@@ -756,6 +824,30 @@ static int frmbuf_verify_format(struct dma_chan *chan, u32 fourcc, u32 type)
 	return -EINVAL;
 }
 
+/*
+ * Bytes of memory a frame of the format occupies, the chroma planes of
+ * the 4:2:0, 4:2:2 and 4:4:4 planar formats included.
+ */
+static u64 frmbuf_frame_bytes(const struct xilinx_frmbuf_format_desc *fmt,
+			      u32 width, u32 height)
+{
+	u64 luma = (u64)DIV_ROUND_UP(width * fmt->bpw, fmt->ppw * 8) * height;
+
+	switch (fmt->id) {
+	case XILINX_FRMBUF_FMT_Y_UV8_420:
+	case XILINX_FRMBUF_FMT_Y_UV10_420:
+		return luma + luma / 2;
+	case XILINX_FRMBUF_FMT_Y_UV8:
+	case XILINX_FRMBUF_FMT_Y_UV10:
+		return luma * 2;
+	case XILINX_FRMBUF_FMT_Y_U_V8:
+	case XILINX_FRMBUF_FMT_Y_U_V10:
+		return luma * 3;
+	default:
+		return luma;
+	}
+}
+
 static void xilinx_xdma_set_config(struct dma_chan *chan, u32 fourcc, u32 type)
 {
 	struct xilinx_frmbuf_chan *xil_chan;
@@ -999,6 +1091,197 @@ int xilinx_xdma_set_earlycb(struct dma_chan *chan,
 }
 EXPORT_SYMBOL(xilinx_xdma_set_earlycb);
 
+int xilinx_xdma_get_timestamp(struct dma_chan *chan,
+			      struct dma_async_tx_descriptor *async_tx,
+			      u64 *sof_ns, u64 *eof_ns)
+{
+	struct xilinx_frmbuf_device *xdev;
+	struct xilinx_frmbuf_tx_descriptor *desc;
+
+	xdev = frmbuf_find_dev(chan);
+	if (IS_ERR(xdev))
+		return PTR_ERR(xdev);
+
+	if (!async_tx || !sof_ns || !eof_ns)
+		return -EINVAL;
+
+	desc = to_dma_tx_descriptor(async_tx);
+	if (!desc)
+		return -EINVAL;
+
+	*sof_ns = desc->sof_ns;
+	*eof_ns = desc->eof_ns;
+	return 0;
+}
+EXPORT_SYMBOL(xilinx_xdma_get_timestamp);
+
+int xilinx_xdma_set_prefetch(struct dma_chan *chan, bool enable)
+{
+	struct xilinx_frmbuf_chan *xil_chan;
+	unsigned long flags;
+	u32 ie = XILINX_FRMBUF_IE_AP_DONE;
+	int ret = 0;
+
+	xil_chan = frmbuf_find_chan(chan);
+	if (IS_ERR(xil_chan))
+		return PTR_ERR(xil_chan);
+
+	spin_lock_irqsave(&xil_chan->lock, flags);
+	if (!xil_chan->idle) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	/* The AP_READY interrupt tells when the IP latched the registers */
+	xil_chan->prefetch = enable;
+	if (enable)
+		ie |= XILINX_FRMBUF_IE_AP_READY;
+	frmbuf_write(xil_chan, XILINX_FRMBUF_IE_OFFSET, ie);
+out:
+	spin_unlock_irqrestore(&xil_chan->lock, flags);
+	return ret;
+}
+EXPORT_SYMBOL(xilinx_xdma_set_prefetch);
+
+int xilinx_xdma_set_bandwidth(struct dma_chan *chan, u32 width, u32 height,
+			      u32 fps)
+{
+	struct xilinx_frmbuf_chan *xil_chan, *xchan;
+	u64 bw = 0, total = 0;
+	int ret = 0;
+
+	xil_chan = frmbuf_find_chan(chan);
+	if (IS_ERR(xil_chan))
+		return PTR_ERR(xil_chan);
+
+	if (fps) {
+		if (!xil_chan->vid_fmt || !width || !height)
+			return -EINVAL;
+		bw = frmbuf_frame_bytes(xil_chan->vid_fmt, width, height) * fps;
+	}
+
+	mutex_lock(&frmbuf_chan_list_lock);
+	if (ddr_budget_mbps && bw > xil_chan->bw_reserved) {
+		list_for_each_entry(xchan, &frmbuf_chan_list, chan_node)
+			if (xchan != xil_chan)
+				total += xchan->bw_reserved;
+
+		if (total + bw > (u64)ddr_budget_mbps * 1000000) {
+			dev_dbg(xil_chan->dev,
+				"%llu B/s over budget, %llu B/s reserved\n",
+				bw, total);
+			ret = -ENOSPC;
+			goto out;
+		}
+	}
+
+	xil_chan->bw_width = width;
+	xil_chan->bw_height = height;
+	xil_chan->bw_fps = fps;
+	xil_chan->bw_reserved = bw;
+out:
+	mutex_unlock(&frmbuf_chan_list_lock);
+	return ret;
+}
+EXPORT_SYMBOL(xilinx_xdma_set_bandwidth);
+
+int xilinx_xdma_set_qos(struct dma_chan *chan, u32 qos)
+{
+	struct xilinx_frmbuf_chan *xil_chan;
+	u32 reg;
+	int ret;
+
+	xil_chan = frmbuf_find_chan(chan);
+	if (IS_ERR(xil_chan))
+		return PTR_ERR(xil_chan);
+
+	if (!xil_chan->qos_regmap)
+		return -ENODEV;
+
+	if (qos > XILINX_FRMBUF_AFI_QOS_MAX)
+		return -EINVAL;
+
+	if (xil_chan->direction == DMA_MEM_TO_DEV)
+		reg = XILINX_FRMBUF_AFI_RDQOS_OFFSET;
+	else
+		reg = XILINX_FRMBUF_AFI_WRQOS_OFFSET;
+
+	ret = regmap_write(xil_chan->qos_regmap, xil_chan->qos_offset + reg,
+			   qos);
+	if (!ret)
+		xil_chan->qos = qos;
+
+	return ret;
+}
+EXPORT_SYMBOL(xilinx_xdma_set_qos);
+
+static const char *xilinx_frmbuf_fence_get_driver_name(struct dma_fence *fence)
+{
+	return "xilinx-frmbuf";
+}
+
+static const char *
+xilinx_frmbuf_fence_get_timeline_name(struct dma_fence *fence)
+{
+	struct xilinx_frmbuf_fence *xfence;
+
+	xfence = container_of(fence, struct xilinx_frmbuf_fence, base);
+	return dma_chan_name(&xfence->chan->common);
+}
+
+static const struct dma_fence_ops xilinx_frmbuf_fence_ops = {
+	.get_driver_name = xilinx_frmbuf_fence_get_driver_name,
+	.get_timeline_name = xilinx_frmbuf_fence_get_timeline_name,
+};
+
+struct dma_fence *
+xilinx_xdma_get_fence(struct dma_chan *chan,
+		      struct dma_async_tx_descriptor *async_tx)
+{
+	struct xilinx_frmbuf_chan *xil_chan;
+	struct xilinx_frmbuf_tx_descriptor *desc;
+	struct xilinx_frmbuf_fence *xfence;
+	struct dma_fence *fence;
+	unsigned long flags;
+
+	if (!async_tx || async_tx->chan != chan ||
+	    async_tx->cookie < DMA_MIN_COOKIE)
+		return ERR_PTR(-EINVAL);
+
+	xil_chan = frmbuf_find_chan(chan);
+	if (IS_ERR(xil_chan))
+		return ERR_CAST(xil_chan);
+
+	desc = to_dma_tx_descriptor(async_tx);
+
+	/* Allocate up front, the frame may complete before the lock is taken */
+	xfence = kzalloc(sizeof(*xfence), GFP_KERNEL);
+	if (!xfence)
+		return ERR_PTR(-ENOMEM);
+
+	spin_lock_irqsave(&xil_chan->lock, flags);
+	if (dma_cookie_status(chan, async_tx->cookie, NULL) == DMA_COMPLETE) {
+		spin_unlock_irqrestore(&xil_chan->lock, flags);
+		kfree(xfence);
+		return dma_fence_get_stub();
+	}
+
+	if (!desc->fence) {
+		xfence->chan = xil_chan;
+		dma_fence_init(&xfence->base, &xilinx_frmbuf_fence_ops,
+			       &xil_chan->fence_lock, xil_chan->fence_context,
+			       desc->seqno);
+		desc->fence = &xfence->base;
+		xfence = NULL;
+	}
+	fence = dma_fence_get(desc->fence);
+	spin_unlock_irqrestore(&xil_chan->lock, flags);
+
+	kfree(xfence);
+	return fence;
+}
+EXPORT_SYMBOL(xilinx_xdma_get_fence);
+
 /**
  * of_dma_xilinx_xlate - Translation function
  * @dma_spec: Pointer to DMA specifier as found in the device tree
@@ -1036,6 +1319,29 @@ xilinx_frmbuf_alloc_tx_descriptor(struct xilinx_frmbuf_chan *chan)
 	return desc;
 }
 
+/**
+ * xilinx_frmbuf_free_tx_descriptor - Free transaction descriptor
+ * @desc: Transaction descriptor, may be NULL
+ *
+ * A fence still pending at this point belongs to a frame that will never
+ * complete, so signal it with an error to release the waiters.
+ */
+static void
+xilinx_frmbuf_free_tx_descriptor(struct xilinx_frmbuf_tx_descriptor *desc)
+{
+	if (!desc)
+		return;
+
+	if (desc->fence) {
+		if (!dma_fence_is_signaled(desc->fence)) {
+			dma_fence_set_error(desc->fence, -ECANCELED);
+			dma_fence_signal(desc->fence);
+		}
+		dma_fence_put(desc->fence);
+	}
+	kfree(desc);
+}
+
 /**
  * xilinx_frmbuf_free_desc_list - Free descriptors list
  * @chan: Driver specific dma channel
@@ -1048,7 +1354,7 @@ static void xilinx_frmbuf_free_desc_list(struct xilinx_frmbuf_chan *chan,
 
 	list_for_each_entry_safe(desc, next, list, node) {
 		list_del(&desc->node);
-		kfree(desc);
+		xilinx_frmbuf_free_tx_descriptor(desc);
 	}
 }
 
@@ -1064,8 +1370,8 @@ static void xilinx_frmbuf_free_descriptors(struct xilinx_frmbuf_chan *chan)
 
 	xilinx_frmbuf_free_desc_list(chan, &chan->pending_list);
 	xilinx_frmbuf_free_desc_list(chan, &chan->done_list);
-	kfree(chan->active_desc);
-	kfree(chan->staged_desc);
+	xilinx_frmbuf_free_tx_descriptor(chan->active_desc);
+	xilinx_frmbuf_free_tx_descriptor(chan->staged_desc);
 
 	chan->staged_desc = NULL;
 	chan->active_desc = NULL;
@@ -1094,10 +1400,14 @@ static void xilinx_frmbuf_chan_desc_cleanup(struct xilinx_frmbuf_chan *chan)
 {
 	struct xilinx_frmbuf_tx_descriptor *desc, *next;
 	unsigned long flags;
+	LIST_HEAD(done);
 
+	/* Take the whole batch, the lock is not needed to complete it */
 	spin_lock_irqsave(&chan->lock, flags);
+	list_splice_tail_init(&chan->done_list, &done);
+	spin_unlock_irqrestore(&chan->lock, flags);
 
-	list_for_each_entry_safe(desc, next, &chan->done_list, node) {
+	list_for_each_entry_safe(desc, next, &done, node) {
 		dma_async_tx_callback callback;
 		void *callback_param;
 
@@ -1106,27 +1416,22 @@ static void xilinx_frmbuf_chan_desc_cleanup(struct xilinx_frmbuf_chan *chan)
 		/* Run the link descriptor callback function */
 		callback = desc->async_tx.callback;
 		callback_param = desc->async_tx.callback_param;
-		if (callback) {
-			spin_unlock_irqrestore(&chan->lock, flags);
+		if (callback)
 			callback(callback_param);
-			spin_lock_irqsave(&chan->lock, flags);
-		}
 
 		/* Run any dependencies, then free the descriptor */
 		dma_run_dependencies(&desc->async_tx);
-		kfree(desc);
+		xilinx_frmbuf_free_tx_descriptor(desc);
 	}
-
-	spin_unlock_irqrestore(&chan->lock, flags);
 }
 
 /**
- * xilinx_frmbuf_do_tasklet - Schedule completion tasklet
+ * xilinx_frmbuf_do_compl - Deferred completion work
  * @data: Pointer to the Xilinx frmbuf channel structure
  */
-static void xilinx_frmbuf_do_tasklet(unsigned long data)
+static void xilinx_frmbuf_do_compl(void *data)
 {
-	struct xilinx_frmbuf_chan *chan = (struct xilinx_frmbuf_chan *)data;
+	struct xilinx_frmbuf_chan *chan = data;
 
 	xilinx_frmbuf_chan_desc_cleanup(chan);
 }
@@ -1200,50 +1505,72 @@ static void xilinx_frmbuf_complete_descriptor(struct xilinx_frmbuf_chan *chan)
 		desc->fid = frmbuf_read(chan, XILINX_FRMBUF_FID_OFFSET) &
 			    XILINX_FRMBUF_FID_MASK;
 
+	desc->eof_ns = ktime_get_ns();
+	chan->bw_bytes += frmbuf_frame_bytes(chan->vid_fmt, desc->hw.hsize,
+					     desc->hw.vsize);
+	chan->bw_frames++;
 	dma_cookie_complete(&desc->async_tx);
+	if (desc->fence)
+		dma_fence_signal_timestamp(desc->fence,
+					   ns_to_ktime(desc->eof_ns));
 	list_add_tail(&desc->node, &chan->done_list);
 }
 
 /**
- * xilinx_frmbuf_start_transfer - Starts frmbuf transfer
- * @chan: Driver specific channel struct pointer
+ * xilinx_frmbuf_activate - Make a descriptor the one the IP works on
+ * @chan: xilinx frmbuf channel
+ * @desc: Descriptor the IP started on
+ *
+ * The start of frame time is taken here rather than when the callback
+ * runs, so that it does not depend on the completion scheduling.
  */
-static void xilinx_frmbuf_start_transfer(struct xilinx_frmbuf_chan *chan)
+static void xilinx_frmbuf_activate(struct xilinx_frmbuf_chan *chan,
+				   struct xilinx_frmbuf_tx_descriptor *desc)
 {
-	struct xilinx_frmbuf_tx_descriptor *desc;
-	struct xilinx_frmbuf_device *xdev;
-
-	xdev = container_of(chan, struct xilinx_frmbuf_device, chan);
+	chan->active_desc = desc;
+	if (desc)
+		desc->sof_ns = ktime_get_ns();
+}
 
-	if (!chan->idle)
-		return;
+/**
+ * xilinx_frmbuf_early_start_cb - Run a start of descriptor early callback
+ * @desc: Descriptor about to be programmed
+ *
+ * Return: true if the callback of the descriptor has been run
+ */
+static bool
+xilinx_frmbuf_early_start_cb(struct xilinx_frmbuf_tx_descriptor *desc)
+{
+	dma_async_tx_callback callback;
+	void *callback_param;
 
-	if (chan->staged_desc) {
-		chan->active_desc = chan->staged_desc;
-		chan->staged_desc = NULL;
-	}
+	if (desc->earlycb != EARLY_CALLBACK_START_DESC)
+		return false;
 
-	if (list_empty(&chan->pending_list))
-		return;
+	callback = desc->async_tx.callback;
+	callback_param = desc->async_tx.callback_param;
+	if (!callback)
+		return false;
 
-	desc = list_first_entry(&chan->pending_list,
-				struct xilinx_frmbuf_tx_descriptor,
-				node);
+	/* The frame may be started right after, updated when it is */
+	desc->sof_ns = ktime_get_ns();
+	callback(callback_param);
+	desc->async_tx.callback = NULL;
+	return true;
+}
 
-	if (desc->earlycb == EARLY_CALLBACK_START_DESC) {
-		dma_async_tx_callback callback;
-		void *callback_param;
+/**
+ * xilinx_frmbuf_program - Program the frame registers from a descriptor
+ * @chan: Driver specific channel struct pointer
+ * @desc: Descriptor to program
+ */
+static void xilinx_frmbuf_program(struct xilinx_frmbuf_chan *chan,
+				  struct xilinx_frmbuf_tx_descriptor *desc)
+{
+	struct xilinx_frmbuf_device *xdev;
 
-		callback = desc->async_tx.callback;
-		callback_param = desc->async_tx.callback_param;
-		if (callback) {
-			callback(callback_param);
-			desc->async_tx.callback = NULL;
-			chan->active_desc = desc;
-		}
-	}
+	xdev = container_of(chan, struct xilinx_frmbuf_device, chan);
 
-	/* Start the transfer */
 	chan->write_addr(chan, XILINX_FRMBUF_ADDR_OFFSET,
 			 desc->hw.luma_plane_addr);
 	chan->write_addr(chan, XILINX_FRMBUF_ADDR2_OFFSET,
@@ -1266,6 +1593,89 @@ static void xilinx_frmbuf_start_transfer(struct xilinx_frmbuf_chan *chan)
 	/* If it is framebuffer read IP set the FID */
 	if (chan->direction == DMA_MEM_TO_DEV && chan->hw_fid)
 		frmbuf_write(chan, XILINX_FRMBUF_FID_OFFSET, desc->fid);
+}
+
+/**
+ * xilinx_frmbuf_prefetching - Check if the channel programs frames ahead
+ * @chan: Driver specific channel struct pointer
+ *
+ * Return: true if frames are programmed one frame ahead of the hardware
+ */
+static bool xilinx_frmbuf_prefetching(struct xilinx_frmbuf_chan *chan)
+{
+	return chan->prefetch && chan->mode == AUTO_RESTART;
+}
+
+/**
+ * xilinx_frmbuf_prefetch_transfer - Program the next frame ahead of time
+ * @chan: Driver specific channel struct pointer
+ *
+ * The IP latches the frame registers when it starts a frame, which it
+ * reports with AP_READY, so they can be written while the previous frame
+ * is still in progress. staged_desc is the descriptor in the registers
+ * and not yet latched, active_desc the one the IP is working on.
+ */
+static void xilinx_frmbuf_prefetch_transfer(struct xilinx_frmbuf_chan *chan)
+{
+	struct xilinx_frmbuf_tx_descriptor *desc;
+
+	if (chan->staged_desc || list_empty(&chan->pending_list))
+		return;
+
+	/*
+	 * Leave an unhandled latch to the interrupt handler, which could
+	 * otherwise take the registers written here as already consumed.
+	 */
+	if (!chan->idle && (frmbuf_read(chan, XILINX_FRMBUF_ISR_OFFSET) &
+			    XILINX_FRMBUF_ISR_AP_READY_IRQ))
+		return;
+
+	desc = list_first_entry(&chan->pending_list,
+				struct xilinx_frmbuf_tx_descriptor,
+				node);
+
+	xilinx_frmbuf_early_start_cb(desc);
+	xilinx_frmbuf_program(chan, desc);
+	list_del(&desc->node);
+	chan->staged_desc = desc;
+
+	if (chan->idle)
+		xilinx_frmbuf_start(chan);
+}
+
+/**
+ * xilinx_frmbuf_start_transfer - Starts frmbuf transfer
+ * @chan: Driver specific channel struct pointer
+ */
+static void xilinx_frmbuf_start_transfer(struct xilinx_frmbuf_chan *chan)
+{
+	struct xilinx_frmbuf_tx_descriptor *desc;
+
+	if (xilinx_frmbuf_prefetching(chan)) {
+		xilinx_frmbuf_prefetch_transfer(chan);
+		return;
+	}
+
+	if (!chan->idle)
+		return;
+
+	if (chan->staged_desc) {
+		xilinx_frmbuf_activate(chan, chan->staged_desc);
+		chan->staged_desc = NULL;
+	}
+
+	if (list_empty(&chan->pending_list))
+		return;
+
+	desc = list_first_entry(&chan->pending_list,
+				struct xilinx_frmbuf_tx_descriptor,
+				node);
+
+	if (xilinx_frmbuf_early_start_cb(desc))
+		xilinx_frmbuf_activate(chan, desc);
+
+	/* Start the transfer */
+	xilinx_frmbuf_program(chan, desc);
 
 	/* Start the hardware */
 	xilinx_frmbuf_start(chan);
@@ -1275,7 +1685,7 @@ static void xilinx_frmbuf_start_transfer(struct xilinx_frmbuf_chan *chan)
 	if (chan->mode == AUTO_RESTART)
 		chan->staged_desc = desc;
 	else
-		chan->active_desc = desc;
+		xilinx_frmbuf_activate(chan, desc);
 }
 
 /**
@@ -1310,13 +1720,55 @@ static void xilinx_frmbuf_reset(struct xilinx_frmbuf_chan *chan)
  */
 static void xilinx_frmbuf_chan_reset(struct xilinx_frmbuf_chan *chan)
 {
+	u32 ie = XILINX_FRMBUF_IE_AP_DONE;
+
+	if (chan->prefetch)
+		ie |= XILINX_FRMBUF_IE_AP_READY;
+
 	xilinx_frmbuf_reset(chan);
-	frmbuf_write(chan, XILINX_FRMBUF_IE_OFFSET, XILINX_FRMBUF_IE_AP_DONE);
+	frmbuf_write(chan, XILINX_FRMBUF_IE_OFFSET, ie);
 	frmbuf_write(chan, XILINX_FRMBUF_GIE_OFFSET, XILINX_FRMBUF_GIE_EN);
 	chan->fid_err_flag = 0;
 	chan->fid_out_val = 0;
 }
 
+/**
+ * xilinx_frmbuf_prefetch_done - Handle the end of a prefetched frame
+ * @chan: Driver specific frmbuf channel
+ *
+ * The frame is complete as soon as another one is waiting in the
+ * registers. Otherwise the IP restarts on the same buffer, which must then
+ * stay with the driver.
+ *
+ * CONTEXT: hardirq, called with the channel lock held
+ */
+static void xilinx_frmbuf_prefetch_done(struct xilinx_frmbuf_chan *chan)
+{
+	if (chan->active_desc && chan->staged_desc) {
+		xilinx_frmbuf_complete_descriptor(chan);
+		chan->active_desc = NULL;
+	}
+}
+
+/**
+ * xilinx_frmbuf_prefetch_ready - Handle the latch of a prefetched frame
+ * @chan: Driver specific frmbuf channel
+ *
+ * CONTEXT: hardirq, called with the channel lock held
+ */
+static void xilinx_frmbuf_prefetch_ready(struct xilinx_frmbuf_chan *chan)
+{
+	if (chan->staged_desc) {
+		if (chan->active_desc)
+			xilinx_frmbuf_complete_descriptor(chan);
+		xilinx_frmbuf_activate(chan, chan->staged_desc);
+		chan->staged_desc = NULL;
+	}
+
+	/* The registers are free again, program the next frame already */
+	xilinx_frmbuf_prefetch_transfer(chan);
+}
+
 /**
  * xilinx_frmbuf_irq_handler - frmbuf Interrupt handler
  * @irq: IRQ number
@@ -1331,6 +1783,7 @@ static irqreturn_t xilinx_frmbuf_irq_handler(int irq, void *data)
 	dma_async_tx_callback callback = NULL;
 	void *callback_param;
 	struct xilinx_frmbuf_tx_descriptor *desc;
+	bool prefetch;
 
 	status = frmbuf_read(chan, XILINX_FRMBUF_ISR_OFFSET);
 	if (!(status & XILINX_FRMBUF_ISR_ALL_IRQ_MASK))
@@ -1352,15 +1805,20 @@ static irqreturn_t xilinx_frmbuf_irq_handler(int irq, void *data)
 
 	if (status & XILINX_FRMBUF_ISR_AP_DONE_IRQ) {
 		spin_lock(&chan->lock);
-		chan->idle = true;
-		if (chan->active_desc) {
-			xilinx_frmbuf_complete_descriptor(chan);
-			chan->active_desc = NULL;
+		prefetch = xilinx_frmbuf_prefetching(chan);
+		if (prefetch) {
+			xilinx_frmbuf_prefetch_done(chan);
+		} else {
+			chan->idle = true;
+			if (chan->active_desc) {
+				xilinx_frmbuf_complete_descriptor(chan);
+				chan->active_desc = NULL;
+			}
 		}
 
 		/* Update fid err detect flag and out value */
 		if (chan->direction == DMA_MEM_TO_DEV &&
-		    chan->hw_fid && chan->idle &&
+		    chan->hw_fid &&
 		    chan->xdev->cfg->flags & XILINX_FID_ERR_DETECT_PROP) {
 			if (chan->mode == AUTO_RESTART)
 				chan->fid_mode = FID_MODE_2;
@@ -1382,11 +1840,19 @@ static irqreturn_t xilinx_frmbuf_irq_handler(int irq, void *data)
 				frmbuf_read(chan, XILINX_FRMBUF_FID_ERR_OFFSET));
 		}
 
-		xilinx_frmbuf_start_transfer(chan);
+		if (!prefetch)
+			xilinx_frmbuf_start_transfer(chan);
 		spin_unlock(&chan->lock);
 	}
 
-	tasklet_schedule(&chan->tasklet);
+	if (status & XILINX_FRMBUF_ISR_AP_READY_IRQ) {
+		spin_lock(&chan->lock);
+		if (xilinx_frmbuf_prefetching(chan))
+			xilinx_frmbuf_prefetch_ready(chan);
+		spin_unlock(&chan->lock);
+	}
+
+	xdma_compl_schedule(&chan->compl);
 	return IRQ_HANDLED;
 }
 
@@ -1405,6 +1871,7 @@ static dma_cookie_t xilinx_frmbuf_tx_submit(struct dma_async_tx_descriptor *tx)
 
 	spin_lock_irqsave(&chan->lock, flags);
 	cookie = dma_cookie_assign(tx);
+	desc->seqno = ++chan->fence_seqno;
 	list_add_tail(&desc->node, &chan->pending_list);
 	spin_unlock_irqrestore(&chan->lock, flags);
 
@@ -1548,20 +2015,57 @@ static int xilinx_frmbuf_terminate_all(struct dma_chan *dchan)
 }
 
 /**
- * xilinx_frmbuf_synchronize - kill tasklet to stop further descr processing
+ * xilinx_frmbuf_synchronize - flush cleanup work to stop descr processing
  * @dchan: Driver specific dma channel pointer
  */
 static void xilinx_frmbuf_synchronize(struct dma_chan *dchan)
 {
 	struct xilinx_frmbuf_chan *chan = to_xilinx_chan(dchan);
 
-	tasklet_kill(&chan->tasklet);
+	xdma_compl_kill(&chan->compl);
 }
 
 /* -----------------------------------------------------------------------------
  * Probe and remove
  */
 
+/*
+ * The measured bandwidth is averaged over the time since the previous
+ * read, so reading the file periodically gives the current use.
+ */
+static int xilinx_frmbuf_bw_show(struct seq_file *s, void *data)
+{
+	struct xilinx_frmbuf_chan *chan = s->private;
+	u64 now = ktime_get_ns(), bytes, frames, rate = 0;
+	unsigned long flags;
+
+	spin_lock_irqsave(&chan->lock, flags);
+	bytes = chan->bw_bytes;
+	frames = chan->bw_frames;
+	spin_unlock_irqrestore(&chan->lock, flags);
+
+	if (chan->bw_last_ns && now > chan->bw_last_ns)
+		rate = div64_u64((bytes - chan->bw_last_bytes) * NSEC_PER_SEC,
+				 now - chan->bw_last_ns);
+	chan->bw_last_ns = now;
+	chan->bw_last_bytes = bytes;
+
+	mutex_lock(&frmbuf_chan_list_lock);
+	seq_printf(s, "format: %s\n",
+		   chan->vid_fmt ? chan->vid_fmt->dts_name : "none");
+	seq_printf(s, "reserved: %ux%u@%u %llu B/s\n", chan->bw_width,
+		   chan->bw_height, chan->bw_fps, chan->bw_reserved);
+	mutex_unlock(&frmbuf_chan_list_lock);
+	seq_printf(s, "measured: %llu B/s\n", rate);
+	seq_printf(s, "frames: %llu\n", frames);
+	seq_printf(s, "bytes: %llu\n", bytes);
+	seq_printf(s, "qos: %d\n", chan->qos);
+	seq_printf(s, "budget: %llu B/s\n", (u64)ddr_budget_mbps * 1000000);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(xilinx_frmbuf_bw);
+
 /**
  * xilinx_frmbuf_chan_remove - Per Channel remove function
  * @chan: Driver specific dma channel
@@ -1572,7 +2076,7 @@ static void xilinx_frmbuf_chan_remove(struct xilinx_frmbuf_chan *chan)
 	frmbuf_clr(chan, XILINX_FRMBUF_IE_OFFSET,
 		   XILINX_FRMBUF_ISR_ALL_IRQ_MASK);
 
-	tasklet_kill(&chan->tasklet);
+	xdma_compl_kill(&chan->compl);
 	list_del(&chan->common.device_node);
 
 	mutex_lock(&frmbuf_chan_list_lock);
@@ -1621,9 +2125,27 @@ static int xilinx_frmbuf_chan_probe(struct xilinx_frmbuf_device *xdev,
 	if (xdev->cfg->flags & XILINX_FID_PROP)
 		chan->hw_fid = of_property_read_bool(node, "xlnx,fid");
 
+	/* Optional AFI FM of the port, to set the QoS of the transfers */
+	chan->qos = -1;
+	chan->qos_regmap =
+		syscon_regmap_lookup_by_phandle_args(node, "xlnx,afi-qos", 1,
+						     &chan->qos_offset);
+	if (IS_ERR(chan->qos_regmap)) {
+		err = PTR_ERR(chan->qos_regmap);
+		chan->qos_regmap = NULL;
+		if (err != -ENOENT) {
+			dev_err(xdev->dev, "invalid xlnx,afi-qos %d\n", err);
+			return err;
+		}
+	}
+
 	spin_lock_init(&chan->lock);
+	spin_lock_init(&chan->fence_lock);
+	chan->fence_context = dma_fence_context_alloc(1);
 	INIT_LIST_HEAD(&chan->pending_list);
 	INIT_LIST_HEAD(&chan->done_list);
+	xdma_compl_item_init(&chan->compl, &xdev->compl,
+			     xilinx_frmbuf_do_compl, chan);
 
 	chan->irq = irq_of_parse_and_map(node, 0);
 	err = devm_request_irq(xdev->dev, chan->irq, xilinx_frmbuf_irq_handler,
@@ -1634,9 +2156,6 @@ static int xilinx_frmbuf_chan_probe(struct xilinx_frmbuf_device *xdev,
 		return err;
 	}
 
-	tasklet_init(&chan->tasklet, xilinx_frmbuf_do_tasklet,
-		     (unsigned long)chan);
-
 	/*
 	 * Initialize the DMA channel and add it to the DMA engine channels
 	 * list.
@@ -1771,6 +2290,10 @@ static int xilinx_frmbuf_probe(struct platform_device *pdev)
 	xdev->common.copy_align = (enum dmaengine_alignment)(fls(align) - 1);
 	xdev->common.dev = &pdev->dev;
 
+	err = devm_xdma_compl_init(&pdev->dev, &xdev->compl);
+	if (err)
+		return err;
+
 	if (xdev->cfg->flags & XILINX_CLK_PROP) {
 		err = clk_prepare_enable(xdev->ap_clk);
 		if (err) {
@@ -1847,6 +2370,9 @@ static int xilinx_frmbuf_probe(struct platform_device *pdev)
 	/* Register the DMA engine with the core */
 	dma_async_device_register(&xdev->common);
 
+	debugfs_create_file("bandwidth", 0444, xdev->common.dbg_dev_root,
+			    &xdev->chan, &xilinx_frmbuf_bw_fops);
+
 	err = of_dma_controller_register(node, of_dma_xilinx_xlate, xdev);
 	if (err < 0) {
 		dev_err(&pdev->dev, "Unable to register DMA to DT\n");
@@ -0,0 +1,1030 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * DMA driver for the Xilinx DMA/Bridge Subsystem for PCI Express (XDMA)
+ *
+ * Copyright (C) 2023 Xilinx, Inc. All rights reserved.
+ *
+ * The XDMA core has up to four host to card (H2C) and four card to host
+ * (C2H) scatter-gather engines. Each engine walks a chain of 32 byte
+ * descriptors and reports, per run, how many descriptors it has completed.
+ * Submitted transfers are chained in hardware so that one run can complete
+ * several of them, and the channel is only restarted once it has stopped.
+ */
+
+#include <linux/bitfield.h>
+#include <linux/dma-mapping.h>
+#include <linux/dma/xilinx_xdma.h>
+#include <linux/dmapool.h>
+#include <linux/interrupt.h>
+#include <linux/io.h>
+#include <linux/iopoll.h>
+#include <linux/module.h>
+#include <linux/pci.h>
+#include <linux/platform_device.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+
+#include "../dmaengine.h"
+#include "xilinx_dma_compl.h"
+#include "xilinx_dma_stats.h"
+
+/* Channel register blocks */
+#define XDMA_CHAN_H2C_OFFSET		0x0000
+#define XDMA_CHAN_C2H_OFFSET		0x1000
+#define XDMA_SGDMA_H2C_OFFSET		0x4000
+#define XDMA_SGDMA_C2H_OFFSET		0x5000
+#define XDMA_CHAN_STRIDE		0x100
+
+/* Channel registers */
+#define XDMA_CHAN_IDENTIFIER		0x00
+#define XDMA_CHAN_CONTROL		0x04
+#define XDMA_CHAN_CONTROL_W1S		0x08
+#define XDMA_CHAN_CONTROL_W1C		0x0c
+#define XDMA_CHAN_STATUS		0x40
+#define XDMA_CHAN_STATUS_RC		0x44
+#define XDMA_CHAN_COMPLETED_DESC	0x48
+#define XDMA_CHAN_INTR_ENABLE		0x90
+
+/* Channel SGDMA registers */
+#define XDMA_SGDMA_DESC_LO		0x80
+#define XDMA_SGDMA_DESC_HI		0x84
+#define XDMA_SGDMA_DESC_ADJ		0x88
+
+/* IRQ block registers */
+#define XDMA_IRQ_CHAN_INT_EN_W1S	0x2014
+#define XDMA_IRQ_CHAN_INT_EN_W1C	0x2018
+#define XDMA_IRQ_CHAN_VEC_NUM		0x20a0
+#define XDMA_IRQ_VEC_SHIFT		8
+
+/* Identifier register fields */
+#define XDMA_ID_SUBSYSTEM		GENMASK(31, 20)
+#define XDMA_ID_TARGET			GENMASK(19, 16)
+#define XDMA_ID_STREAM			BIT(15)
+#define XDMA_ID_MAGIC			0x1fc
+#define XDMA_ID_TARGET_H2C		0
+#define XDMA_ID_TARGET_C2H		1
+
+/* Control, status and interrupt enable register bits */
+#define XDMA_CHAN_RUN_STOP		BIT(0)
+#define XDMA_CHAN_BUSY			BIT(0)
+#define XDMA_CHAN_DESC_STOPPED		BIT(1)
+#define XDMA_CHAN_DESC_COMPLETED	BIT(2)
+#define XDMA_CHAN_ALIGN_MISMATCH	BIT(3)
+#define XDMA_CHAN_MAGIC_STOPPED		BIT(4)
+#define XDMA_CHAN_INVALID_LEN		BIT(5)
+#define XDMA_CHAN_IDLE_STOPPED		BIT(6)
+#define XDMA_CHAN_READ_ERROR		GENMASK(13, 9)
+#define XDMA_CHAN_WRITE_ERROR		GENMASK(18, 14)
+#define XDMA_CHAN_DESC_ERROR		GENMASK(23, 19)
+
+#define XDMA_CHAN_ERRORS		(XDMA_CHAN_ALIGN_MISMATCH | \
+					 XDMA_CHAN_MAGIC_STOPPED | \
+					 XDMA_CHAN_INVALID_LEN | \
+					 XDMA_CHAN_READ_ERROR | \
+					 XDMA_CHAN_WRITE_ERROR | \
+					 XDMA_CHAN_DESC_ERROR)
+#define XDMA_CHAN_EVENTS		(XDMA_CHAN_DESC_STOPPED | \
+					 XDMA_CHAN_DESC_COMPLETED | \
+					 XDMA_CHAN_ERRORS)
+
+/* Hardware descriptor fields */
+#define XDMA_DESC_MAGIC			0xad4b
+#define XDMA_DESC_MAGIC_MASK		GENMASK(31, 16)
+#define XDMA_DESC_ADJ_MASK		GENMASK(13, 8)
+#define XDMA_DESC_FLAGS_MASK		GENMASK(7, 0)
+#define XDMA_DESC_STOPPED		BIT(0)
+#define XDMA_DESC_COMPLETED		BIT(1)
+#define XDMA_DESC_EOP			BIT(4)
+#define XDMA_DESC_BLEN_MAX		(BIT(28) - PAGE_SIZE)
+
+/*
+ * Descriptors are allocated in 4 KiB blocks, the engine may prefetch up to
+ * XDMA_DESC_ADJ_MAX following descriptors as long as they do not cross one.
+ */
+#define XDMA_DESC_BLOCK_SIZE		SZ_4K
+#define XDMA_DESC_BLOCK_NUM		(XDMA_DESC_BLOCK_SIZE / \
+					 sizeof(struct xilinx_xdma_hw_desc))
+#define XDMA_DESC_ADJ_MAX		31
+
+#define XDMA_MAX_CHANNELS		4
+#define XDMA_STOP_TIMEOUT_US		10000
+
+/**
+ * struct xilinx_xdma_hw_desc - Hardware descriptor
+ * @control: Magic, next adjacent count and flags
+ * @bytes: Transfer length in bytes
+ * @src_addr: Source address
+ * @dst_addr: Destination address
+ * @next_desc: Address of the next descriptor
+ */
+struct xilinx_xdma_hw_desc {
+	__le32 control;
+	__le32 bytes;
+	__le64 src_addr;
+	__le64 dst_addr;
+	__le64 next_desc;
+};
+
+/**
+ * struct xilinx_xdma_desc_block - Block of hardware descriptors
+ * @virt: CPU address of the block
+ * @dma: Bus address of the block
+ */
+struct xilinx_xdma_desc_block {
+	struct xilinx_xdma_hw_desc *virt;
+	dma_addr_t dma;
+};
+
+/**
+ * struct xilinx_xdma_desc - Software descriptor
+ * @async_tx: Async transaction descriptor
+ * @node: Node in the channel descriptor lists
+ * @blocks: Hardware descriptor blocks
+ * @num_blocks: Number of @blocks
+ * @num_hw: Number of hardware descriptors
+ * @len: Transfer length in bytes
+ * @submit_ns: Submission timestamp for the statistics
+ * @result: Transfer result reported to the client
+ */
+struct xilinx_xdma_desc {
+	struct dma_async_tx_descriptor async_tx;
+	struct list_head node;
+	struct xilinx_xdma_desc_block *blocks;
+	unsigned int num_blocks;
+	unsigned int num_hw;
+	size_t len;
+	u64 submit_ns;
+	enum dmaengine_tx_result result;
+};
+
+struct xilinx_xdma_device;
+
+/**
+ * struct xilinx_xdma_chan - Driver specific DMA channel structure
+ * @xdev: Driver specific device structure
+ * @common: DMA common channel
+ * @regs: Channel register block
+ * @sgdma_regs: Channel SGDMA register block
+ * @lock: Descriptor operation lock
+ * @pending_list: Descriptors submitted but not yet issued
+ * @active_list: Descriptors handed to the engine
+ * @done_list: Descriptors completed, waiting for their callbacks
+ * @desc_pool: Pool of hardware descriptor blocks
+ * @dir: Transfer direction
+ * @stream: True for an AXI4-Stream engine
+ * @idle: True when the engine is stopped
+ * @err: True when the engine has stopped on an error
+ * @irq: Channel IRQ, 0 for a polled channel
+ * @irq_bit: Bit of the channel in the IRQ block registers
+ * @run_done: Hardware descriptors completed in the current run
+ * @cfg: Slave configuration
+ * @compl: Completion handler
+ * @stats: Transfer statistics
+ */
+struct xilinx_xdma_chan {
+	struct xilinx_xdma_device *xdev;
+	struct dma_chan common;
+	void __iomem *regs;
+	void __iomem *sgdma_regs;
+	spinlock_t lock;
+	struct list_head pending_list;
+	struct list_head active_list;
+	struct list_head done_list;
+	struct dma_pool *desc_pool;
+	enum dma_transfer_direction dir;
+	bool stream;
+	bool idle;
+	bool err;
+	int irq;
+	u32 irq_bit;
+	u32 run_done;
+	struct dma_slave_config cfg;
+	struct xdma_compl_item compl;
+	struct xdma_stats stats;
+};
+
+/**
+ * struct xilinx_xdma_device - DMA device structure
+ * @dev: Device structure
+ * @dma_dev: Device the descriptors and buffers are mapped for
+ * @common: DMA device structure
+ * @regs: DMA register BAR
+ * @chans: Channels, H2C first
+ * @num_chans: Number of @chans
+ * @compl: Context the channel completion work runs in
+ */
+struct xilinx_xdma_device {
+	struct device *dev;
+	struct device *dma_dev;
+	struct dma_device common;
+	void __iomem *regs;
+	struct xilinx_xdma_chan *chans;
+	unsigned int num_chans;
+	struct xdma_compl compl;
+};
+
+#define to_chan(chan)		container_of(chan, struct xilinx_xdma_chan, \
+					     common)
+#define tx_to_desc(tx)		container_of(tx, struct xilinx_xdma_desc, \
+					     async_tx)
+
+static inline struct xilinx_xdma_hw_desc *
+xilinx_xdma_hw_desc(struct xilinx_xdma_desc *desc, unsigned int i)
+{
+	unsigned int b = i / XDMA_DESC_BLOCK_NUM;
+
+	return &desc->blocks[b].virt[i % XDMA_DESC_BLOCK_NUM];
+}
+
+static inline dma_addr_t xilinx_xdma_hw_addr(struct xilinx_xdma_desc *desc,
+					     unsigned int i)
+{
+	return desc->blocks[i / XDMA_DESC_BLOCK_NUM].dma +
+	       (i % XDMA_DESC_BLOCK_NUM) * sizeof(struct xilinx_xdma_hw_desc);
+}
+
+/**
+ * xilinx_xdma_adjacent - Count the descriptors the engine may prefetch
+ * @desc: Software descriptor
+ * @i: Index of the descriptor about to be fetched
+ *
+ * Return: Number of descriptors contiguous to @i in the same block
+ */
+static u32 xilinx_xdma_adjacent(struct xilinx_xdma_desc *desc, unsigned int i)
+{
+	u32 left = desc->num_hw - i - 1;
+	u32 in_block = XDMA_DESC_BLOCK_NUM - (i % XDMA_DESC_BLOCK_NUM) - 1;
+
+	return min3(left, in_block, (u32)XDMA_DESC_ADJ_MAX);
+}
+
+static inline __le32 xilinx_xdma_control(u32 adjacent, u32 flags)
+{
+	return cpu_to_le32(FIELD_PREP(XDMA_DESC_MAGIC_MASK, XDMA_DESC_MAGIC) |
+			   FIELD_PREP(XDMA_DESC_ADJ_MASK, adjacent) | flags);
+}
+
+/**
+ * xilinx_xdma_free_desc - Free a software descriptor
+ * @chan: XDMA channel
+ * @desc: Software descriptor
+ */
+static void xilinx_xdma_free_desc(struct xilinx_xdma_chan *chan,
+				  struct xilinx_xdma_desc *desc)
+{
+	unsigned int i;
+
+	for (i = 0; i < desc->num_blocks; i++)
+		dma_pool_free(chan->desc_pool, desc->blocks[i].virt,
+			      desc->blocks[i].dma);
+	kfree(desc->blocks);
+	kfree(desc);
+}
+
+static void xilinx_xdma_free_desc_list(struct xilinx_xdma_chan *chan,
+				       struct list_head *list)
+{
+	struct xilinx_xdma_desc *desc, *next;
+
+	list_for_each_entry_safe(desc, next, list, node) {
+		list_del(&desc->node);
+		xilinx_xdma_free_desc(chan, desc);
+	}
+}
+
+static unsigned int xilinx_xdma_pending_count(struct xilinx_xdma_chan *chan)
+{
+	struct list_head *entry;
+	unsigned int count = 0;
+
+	list_for_each(entry, &chan->pending_list)
+		count++;
+
+	return count;
+}
+
+/**
+ * xilinx_xdma_tx_submit - Submit DMA transaction
+ * @tx: Async transaction descriptor pointer
+ *
+ * The new descriptor chain is linked behind the last pending one, so that a
+ * single run of the engine walks all the transfers issued together.
+ *
+ * Return: cookie value
+ */
+static dma_cookie_t xilinx_xdma_tx_submit(struct dma_async_tx_descriptor *tx)
+{
+	struct xilinx_xdma_chan *chan = to_chan(tx->chan);
+	struct xilinx_xdma_desc *new = tx_to_desc(tx), *prev;
+	struct xilinx_xdma_hw_desc *last;
+	unsigned long irqflags;
+	dma_cookie_t cookie;
+	u32 flags, adj;
+
+	spin_lock_irqsave(&chan->lock, irqflags);
+	cookie = dma_cookie_assign(tx);
+	new->submit_ns = xdma_stats_submit(&chan->stats, tx->chan, cookie,
+					   new->len);
+
+	if (!list_empty(&chan->pending_list)) {
+		prev = list_last_entry(&chan->pending_list,
+				       struct xilinx_xdma_desc, node);
+		last = xilinx_xdma_hw_desc(prev, prev->num_hw - 1);
+		last->next_desc = cpu_to_le64(xilinx_xdma_hw_addr(new, 0));
+		flags = le32_to_cpu(last->control) & XDMA_DESC_FLAGS_MASK;
+		flags &= ~XDMA_DESC_STOPPED;
+		adj = xilinx_xdma_adjacent(new, 0);
+		last->control = xilinx_xdma_control(adj, flags);
+	}
+
+	list_add_tail(&new->node, &chan->pending_list);
+	spin_unlock_irqrestore(&chan->lock, irqflags);
+
+	return cookie;
+}
+
+/**
+ * xilinx_xdma_start_transfer - Hand the pending descriptors to the engine
+ * @chan: XDMA channel
+ *
+ * Called with the channel lock held.
+ */
+static void xilinx_xdma_start_transfer(struct xilinx_xdma_chan *chan)
+{
+	struct xilinx_xdma_desc *desc;
+	dma_addr_t addr;
+
+	if (!chan->idle || chan->err || !list_empty(&chan->active_list))
+		return;
+
+	desc = list_first_entry_or_null(&chan->pending_list,
+					struct xilinx_xdma_desc, node);
+	if (!desc)
+		return;
+
+	xdma_stats_start(&chan->stats, &chan->common,
+			 xilinx_xdma_pending_count(chan));
+	list_splice_tail_init(&chan->pending_list, &chan->active_list);
+
+	addr = xilinx_xdma_hw_addr(desc, 0);
+	writel(lower_32_bits(addr), chan->sgdma_regs + XDMA_SGDMA_DESC_LO);
+	writel(upper_32_bits(addr), chan->sgdma_regs + XDMA_SGDMA_DESC_HI);
+	writel(xilinx_xdma_adjacent(desc, 0),
+	       chan->sgdma_regs + XDMA_SGDMA_DESC_ADJ);
+
+	chan->run_done = 0;
+	chan->idle = false;
+	writel(XDMA_CHAN_EVENTS | XDMA_CHAN_RUN_STOP,
+	       chan->regs + XDMA_CHAN_CONTROL);
+}
+
+/**
+ * xilinx_xdma_complete_descriptors - Retire what the engine has completed
+ * @chan: XDMA channel
+ *
+ * Called with the channel lock held.
+ */
+static void xilinx_xdma_complete_descriptors(struct xilinx_xdma_chan *chan)
+{
+	struct xilinx_xdma_desc *desc, *next;
+	u32 completed;
+
+	completed = readl(chan->regs + XDMA_CHAN_COMPLETED_DESC);
+
+	list_for_each_entry_safe(desc, next, &chan->active_list, node) {
+		if (chan->run_done + desc->num_hw > completed)
+			break;
+
+		chan->run_done += desc->num_hw;
+		list_del(&desc->node);
+		xdma_stats_complete(&chan->stats, &chan->common,
+				    desc->async_tx.cookie, desc->len,
+				    desc->submit_ns);
+		dma_cookie_complete(&desc->async_tx);
+		desc->result = DMA_TRANS_NOERROR;
+		list_add_tail(&desc->node, &chan->done_list);
+	}
+}
+
+/**
+ * xilinx_xdma_stop - Clear the run bit and wait for the engine to go idle
+ * @chan: XDMA channel
+ *
+ * Return: '0' on success and failure value on error
+ */
+static int xilinx_xdma_stop(struct xilinx_xdma_chan *chan)
+{
+	u32 status;
+
+	writel(XDMA_CHAN_RUN_STOP, chan->regs + XDMA_CHAN_CONTROL_W1C);
+
+	return readl_poll_timeout_atomic(chan->regs + XDMA_CHAN_STATUS, status,
+					 !(status & XDMA_CHAN_BUSY), 1,
+					 XDMA_STOP_TIMEOUT_US);
+}
+
+/**
+ * xilinx_xdma_abort - Fail the active descriptors after an engine error
+ * @chan: XDMA channel
+ *
+ * Called with the channel lock held.
+ */
+static void xilinx_xdma_abort(struct xilinx_xdma_chan *chan)
+{
+	struct xilinx_xdma_desc *desc, *next;
+
+	if (xilinx_xdma_stop(chan))
+		dev_err(chan->xdev->dev, "%s: engine does not stop\n",
+			dma_chan_name(&chan->common));
+
+	xilinx_xdma_complete_descriptors(chan);
+
+	list_for_each_entry_safe(desc, next, &chan->active_list, node) {
+		list_del(&desc->node);
+		dma_cookie_complete(&desc->async_tx);
+		desc->result = DMA_TRANS_ABORTED;
+		list_add_tail(&desc->node, &chan->done_list);
+	}
+
+	chan->idle = true;
+	chan->err = false;
+}
+
+/**
+ * xilinx_xdma_chan_desc_cleanup - Run the callbacks of completed descriptors
+ * @chan: XDMA channel
+ */
+static void xilinx_xdma_chan_desc_cleanup(struct xilinx_xdma_chan *chan)
+{
+	struct xilinx_xdma_desc *desc, *next;
+	unsigned long irqflags;
+	LIST_HEAD(done);
+
+	spin_lock_irqsave(&chan->lock, irqflags);
+	list_splice_tail_init(&chan->done_list, &done);
+	spin_unlock_irqrestore(&chan->lock, irqflags);
+
+	list_for_each_entry_safe(desc, next, &done, node) {
+		struct dmaengine_result result = { .result = desc->result };
+		struct dmaengine_desc_callback cb;
+
+		dmaengine_desc_get_callback(&desc->async_tx, &cb);
+		dmaengine_desc_callback_invoke(&cb, &result);
+		list_del(&desc->node);
+		xilinx_xdma_free_desc(chan, desc);
+	}
+}
+
+/**
+ * xilinx_xdma_handle_status - Account the events latched by the engine
+ * @chan: XDMA channel
+ * @status: Channel status, as read from XDMA_CHAN_STATUS_RC
+ *
+ * Called with the channel lock held.
+ *
+ * Return: True if there is completion work to do
+ */
+static bool xilinx_xdma_handle_status(struct xilinx_xdma_chan *chan,
+				      u32 status)
+{
+	if (status & XDMA_CHAN_ERRORS) {
+		dev_err(chan->xdev->dev, "%s: engine error, status %#x\n",
+			dma_chan_name(&chan->common), status);
+		chan->err = true;
+	} else if (status & XDMA_CHAN_DESC_STOPPED) {
+		writel(XDMA_CHAN_RUN_STOP, chan->regs + XDMA_CHAN_CONTROL_W1C);
+		chan->idle = true;
+	}
+
+	return status & XDMA_CHAN_EVENTS;
+}
+
+/**
+ * xilinx_xdma_do_compl - Deferred completion work
+ * @data: Pointer to the XDMA channel structure
+ */
+static void xilinx_xdma_do_compl(void *data)
+{
+	struct xilinx_xdma_chan *chan = data;
+	unsigned long irqflags;
+
+	spin_lock_irqsave(&chan->lock, irqflags);
+	if (chan->err)
+		xilinx_xdma_abort(chan);
+	else
+		xilinx_xdma_complete_descriptors(chan);
+	xilinx_xdma_start_transfer(chan);
+	spin_unlock_irqrestore(&chan->lock, irqflags);
+
+	xilinx_xdma_chan_desc_cleanup(chan);
+}
+
+/**
+ * xilinx_xdma_irq_handler - XDMA channel interrupt handler
+ * @irq: IRQ number
+ * @data: Pointer to the XDMA channel structure
+ *
+ * Return: IRQ_HANDLED/IRQ_NONE
+ */
+static irqreturn_t xilinx_xdma_irq_handler(int irq, void *data)
+{
+	struct xilinx_xdma_chan *chan = data;
+	bool work;
+	u32 status;
+
+	spin_lock(&chan->lock);
+	status = readl(chan->regs + XDMA_CHAN_STATUS_RC);
+	work = xilinx_xdma_handle_status(chan, status);
+	spin_unlock(&chan->lock);
+
+	if (!work)
+		return IRQ_NONE;
+
+	xdma_compl_schedule(&chan->compl);
+
+	return IRQ_HANDLED;
+}
+
+/**
+ * xilinx_xdma_tx_status - Get the status of a transaction
+ * @dchan: DMA channel pointer
+ * @cookie: Transaction identifier
+ * @txstate: Transaction state
+ *
+ * A channel without an interrupt vector is driven from here: the engine
+ * status is polled and completed transfers are retired, with their
+ * callbacks, in the caller's context.
+ *
+ * Return: DMA transaction status
+ */
+static enum dma_status xilinx_xdma_tx_status(struct dma_chan *dchan,
+					     dma_cookie_t cookie,
+					     struct dma_tx_state *txstate)
+{
+	struct xilinx_xdma_chan *chan = to_chan(dchan);
+	enum dma_status ret;
+	unsigned long irqflags;
+	bool work;
+
+	ret = dma_cookie_status(dchan, cookie, txstate);
+	if (ret == DMA_COMPLETE || chan->irq)
+		return ret;
+
+	spin_lock_irqsave(&chan->lock, irqflags);
+	work = xilinx_xdma_handle_status(chan,
+					 readl(chan->regs +
+					       XDMA_CHAN_STATUS_RC));
+	spin_unlock_irqrestore(&chan->lock, irqflags);
+
+	if (work)
+		xilinx_xdma_do_compl(chan);
+
+	return dma_cookie_status(dchan, cookie, txstate);
+}
+
+/**
+ * xilinx_xdma_issue_pending - Issue pending transactions
+ * @dchan: DMA channel pointer
+ */
+static void xilinx_xdma_issue_pending(struct dma_chan *dchan)
+{
+	struct xilinx_xdma_chan *chan = to_chan(dchan);
+	unsigned long irqflags;
+
+	spin_lock_irqsave(&chan->lock, irqflags);
+	xdma_stats_issue(&chan->stats, dchan, xilinx_xdma_pending_count(chan));
+	xilinx_xdma_start_transfer(chan);
+	spin_unlock_irqrestore(&chan->lock, irqflags);
+}
+
+/**
+ * xilinx_xdma_prep_slave_sg - Prepare descriptors for a slave transaction
+ * @dchan: DMA channel
+ * @sgl: Scatter list of the host buffer
+ * @sg_len: Number of entries in @sgl
+ * @dir: Transfer direction, must match the channel
+ * @flags: Transfer ack flags
+ * @context: Unused
+ *
+ * The card address comes from the slave configuration and increases along
+ * the scatter list. It is ignored by AXI4-Stream engines.
+ *
+ * Return: Async transaction descriptor on success and NULL on failure
+ */
+static struct dma_async_tx_descriptor *
+xilinx_xdma_prep_slave_sg(struct dma_chan *dchan, struct scatterlist *sgl,
+			  unsigned int sg_len, enum dma_transfer_direction dir,
+			  unsigned long flags, void *context)
+{
+	struct xilinx_xdma_chan *chan = to_chan(dchan);
+	struct xilinx_xdma_hw_desc *hw;
+	struct xilinx_xdma_desc *desc;
+	struct scatterlist *sg;
+	unsigned int i, n = 0;
+	u64 dev_addr;
+	u32 adj;
+
+	if (dir != chan->dir)
+		return NULL;
+
+	for_each_sg(sgl, sg, sg_len, i)
+		n += DIV_ROUND_UP(sg_dma_len(sg), XDMA_DESC_BLEN_MAX);
+	if (!n)
+		return NULL;
+
+	desc = kzalloc(sizeof(*desc), GFP_NOWAIT);
+	if (!desc)
+		return NULL;
+
+	desc->num_hw = n;
+	desc->num_blocks = DIV_ROUND_UP(n, XDMA_DESC_BLOCK_NUM);
+	desc->blocks = kcalloc(desc->num_blocks, sizeof(*desc->blocks),
+			       GFP_NOWAIT);
+	if (!desc->blocks)
+		goto err_free;
+
+	for (i = 0; i < desc->num_blocks; i++) {
+		desc->blocks[i].virt = dma_pool_zalloc(chan->desc_pool,
+						       GFP_NOWAIT,
+						       &desc->blocks[i].dma);
+		if (!desc->blocks[i].virt) {
+			desc->num_blocks = i;
+			goto err_free;
+		}
+	}
+
+	dev_addr = dir == DMA_MEM_TO_DEV ? chan->cfg.dst_addr :
+					   chan->cfg.src_addr;
+	n = 0;
+	for_each_sg(sgl, sg, sg_len, i) {
+		dma_addr_t addr = sg_dma_address(sg);
+		size_t left = sg_dma_len(sg);
+
+		while (left) {
+			u32 len = min_t(size_t, left, XDMA_DESC_BLEN_MAX);
+
+			hw = xilinx_xdma_hw_desc(desc, n++);
+			hw->bytes = cpu_to_le32(len);
+			if (dir == DMA_MEM_TO_DEV) {
+				hw->src_addr = cpu_to_le64(addr);
+				hw->dst_addr = cpu_to_le64(dev_addr);
+			} else {
+				hw->src_addr = cpu_to_le64(dev_addr);
+				hw->dst_addr = cpu_to_le64(addr);
+			}
+
+			if (!chan->stream)
+				dev_addr += len;
+			addr += len;
+			left -= len;
+			desc->len += len;
+		}
+	}
+
+	for (i = 0; i + 1 < n; i++) {
+		hw = xilinx_xdma_hw_desc(desc, i);
+		adj = xilinx_xdma_adjacent(desc, i + 1);
+		hw->next_desc = cpu_to_le64(xilinx_xdma_hw_addr(desc, i + 1));
+		hw->control = xilinx_xdma_control(adj, 0);
+	}
+
+	/* Interrupt and stop on the last one, tx_submit may chain it on */
+	hw = xilinx_xdma_hw_desc(desc, n - 1);
+	hw->control = xilinx_xdma_control(0, XDMA_DESC_COMPLETED |
+					  XDMA_DESC_STOPPED |
+					  (chan->stream ? XDMA_DESC_EOP : 0));
+
+	dma_async_tx_descriptor_init(&desc->async_tx, &chan->common);
+	desc->async_tx.tx_submit = xilinx_xdma_tx_submit;
+	desc->async_tx.flags = flags;
+	INIT_LIST_HEAD(&desc->node);
+
+	return &desc->async_tx;
+
+err_free:
+	xilinx_xdma_free_desc(chan, desc);
+	return NULL;
+}
+
+/**
+ * xilinx_xdma_device_config - Configure the DMA channel
+ * @dchan: DMA channel
+ * @config: Channel configuration
+ *
+ * Return: Always '0'
+ */
+static int xilinx_xdma_device_config(struct dma_chan *dchan,
+				     struct dma_slave_config *config)
+{
+	struct xilinx_xdma_chan *chan = to_chan(dchan);
+
+	memcpy(&chan->cfg, config, sizeof(*config));
+
+	return 0;
+}
+
+/**
+ * xilinx_xdma_terminate_all - Abort all transfers on a channel
+ * @dchan: DMA channel pointer
+ *
+ * Return: '0' on success and failure value on error
+ */
+static int xilinx_xdma_terminate_all(struct dma_chan *dchan)
+{
+	struct xilinx_xdma_chan *chan = to_chan(dchan);
+	unsigned long irqflags;
+	int ret;
+
+	spin_lock_irqsave(&chan->lock, irqflags);
+	ret = xilinx_xdma_stop(chan);
+	readl(chan->regs + XDMA_CHAN_STATUS_RC);
+	chan->idle = true;
+	chan->err = false;
+	xilinx_xdma_free_desc_list(chan, &chan->active_list);
+	xilinx_xdma_free_desc_list(chan, &chan->pending_list);
+	xilinx_xdma_free_desc_list(chan, &chan->done_list);
+	spin_unlock_irqrestore(&chan->lock, irqflags);
+
+	return ret;
+}
+
+/**
+ * xilinx_xdma_synchronize - Wait for the completion work to finish
+ * @dchan: DMA channel pointer
+ */
+static void xilinx_xdma_synchronize(struct dma_chan *dchan)
+{
+	struct xilinx_xdma_chan *chan = to_chan(dchan);
+
+	if (chan->irq)
+		synchronize_irq(chan->irq);
+	xdma_compl_kill(&chan->compl);
+}
+
+/**
+ * xilinx_xdma_alloc_chan_resources - Allocate channel resources
+ * @dchan: DMA channel
+ *
+ * Return: '0' on success and failure value on error
+ */
+static int xilinx_xdma_alloc_chan_resources(struct dma_chan *dchan)
+{
+	struct xilinx_xdma_chan *chan = to_chan(dchan);
+	struct xilinx_xdma_device *xdev = chan->xdev;
+
+	chan->desc_pool = dma_pool_create(dma_chan_name(dchan), xdev->dma_dev,
+					  XDMA_DESC_BLOCK_SIZE,
+					  XDMA_DESC_BLOCK_SIZE, 0);
+	if (!chan->desc_pool)
+		return -ENOMEM;
+
+	dma_cookie_init(dchan);
+
+	return 0;
+}
+
+/**
+ * xilinx_xdma_free_chan_resources - Free channel resources
+ * @dchan: DMA channel
+ */
+static void xilinx_xdma_free_chan_resources(struct dma_chan *dchan)
+{
+	struct xilinx_xdma_chan *chan = to_chan(dchan);
+
+	xilinx_xdma_terminate_all(dchan);
+	xilinx_xdma_synchronize(dchan);
+	dma_pool_destroy(chan->desc_pool);
+	chan->desc_pool = NULL;
+}
+
+static bool xilinx_xdma_filter_fn(struct dma_chan *dchan, void *param)
+{
+	struct xilinx_xdma_chan_info *info = param;
+
+	return to_chan(dchan)->dir == info->dir;
+}
+
+/**
+ * xilinx_xdma_chan_probe - Set up one engine
+ * @xdev: Driver specific device structure
+ * @dir: Direction of the engine
+ * @index: Engine number within its direction
+ * @irq_res: IRQ resource, NULL if there is none
+ *
+ * Return: '0' on success, -ENODEV if the engine is not present and
+ * failure value on other errors
+ */
+static int xilinx_xdma_chan_probe(struct xilinx_xdma_device *xdev,
+				  enum dma_transfer_direction dir,
+				  unsigned int index, struct resource *irq_res)
+{
+	struct xilinx_xdma_chan *chan = &xdev->chans[xdev->num_chans];
+	bool h2c = dir == DMA_MEM_TO_DEV;
+	void __iomem *regs;
+	u32 id;
+	int ret;
+
+	regs = xdev->regs + index * XDMA_CHAN_STRIDE +
+	       (h2c ? XDMA_CHAN_H2C_OFFSET : XDMA_CHAN_C2H_OFFSET);
+	id = readl(regs + XDMA_CHAN_IDENTIFIER);
+	if (FIELD_GET(XDMA_ID_SUBSYSTEM, id) != XDMA_ID_MAGIC ||
+	    FIELD_GET(XDMA_ID_TARGET, id) !=
+	    (h2c ? XDMA_ID_TARGET_H2C : XDMA_ID_TARGET_C2H))
+		return -ENODEV;
+
+	chan->xdev = xdev;
+	chan->regs = regs;
+	chan->sgdma_regs = xdev->regs + index * XDMA_CHAN_STRIDE;
+	chan->sgdma_regs += h2c ? XDMA_SGDMA_H2C_OFFSET : XDMA_SGDMA_C2H_OFFSET;
+	chan->dir = dir;
+	chan->stream = id & XDMA_ID_STREAM;
+	chan->idle = true;
+	chan->irq_bit = xdev->num_chans;
+	spin_lock_init(&chan->lock);
+	INIT_LIST_HEAD(&chan->pending_list);
+	INIT_LIST_HEAD(&chan->active_list);
+	INIT_LIST_HEAD(&chan->done_list);
+	xdma_compl_item_init(&chan->compl, &xdev->compl, xilinx_xdma_do_compl,
+			     chan);
+	xdma_stats_init(&chan->stats);
+
+	writel(0, regs + XDMA_CHAN_CONTROL);
+	writel(XDMA_CHAN_EVENTS, regs + XDMA_CHAN_INTR_ENABLE);
+	readl(regs + XDMA_CHAN_STATUS_RC);
+
+	if (irq_res && irq_res->start + chan->irq_bit <= irq_res->end) {
+		chan->irq = irq_res->start + chan->irq_bit;
+		ret = devm_request_irq(xdev->dev, chan->irq,
+				       xilinx_xdma_irq_handler, 0,
+				       dev_name(xdev->dev), chan);
+		if (ret)
+			return ret;
+	}
+
+	chan->common.device = &xdev->common;
+	list_add_tail(&chan->common.device_node, &xdev->common.channels);
+	xdev->num_chans++;
+
+	return 0;
+}
+
+/**
+ * xilinx_xdma_set_vectors - Route the channel interrupts to their vectors
+ * @xdev: Driver specific device structure
+ *
+ * Each vector register holds the MSI-X vector of four channels.
+ */
+static void xilinx_xdma_set_vectors(struct xilinx_xdma_device *xdev)
+{
+	unsigned int i;
+	u32 val = 0, mask = 0;
+
+	for (i = 0; i < xdev->num_chans; i++) {
+		val |= i << (XDMA_IRQ_VEC_SHIFT * (i % 4));
+		if (i % 4 == 3 || i == xdev->num_chans - 1) {
+			writel(val, xdev->regs + XDMA_IRQ_CHAN_VEC_NUM +
+			       (i / 4) * sizeof(u32));
+			val = 0;
+		}
+
+		if (xdev->chans[i].irq)
+			mask |= BIT(i);
+	}
+
+	writel(mask, xdev->regs + XDMA_IRQ_CHAN_INT_EN_W1S);
+}
+
+static int xilinx_xdma_probe(struct platform_device *pdev)
+{
+	struct xilinx_xdma_platdata *pdata = dev_get_platdata(&pdev->dev);
+	struct xilinx_xdma_device *xdev;
+	struct resource *irq_res;
+	struct dma_device *p;
+	unsigned int max, i;
+	int ret;
+
+	if (!pdata)
+		return -EINVAL;
+
+	max = pdata->max_dma_channels ?: XDMA_MAX_CHANNELS;
+	max = min_t(unsigned int, max, XDMA_MAX_CHANNELS);
+
+	xdev = devm_kzalloc(&pdev->dev, sizeof(*xdev), GFP_KERNEL);
+	if (!xdev)
+		return -ENOMEM;
+
+	xdev->chans = devm_kcalloc(&pdev->dev, 2 * max, sizeof(*xdev->chans),
+				   GFP_KERNEL);
+	if (!xdev->chans)
+		return -ENOMEM;
+
+	xdev->dev = &pdev->dev;
+	xdev->regs = devm_platform_ioremap_resource(pdev, 0);
+	if (IS_ERR(xdev->regs))
+		return PTR_ERR(xdev->regs);
+
+	/* The descriptors and buffers are mapped for the PCI function */
+	xdev->dma_dev = &pdev->dev;
+	while (xdev->dma_dev && !dev_is_pci(xdev->dma_dev))
+		xdev->dma_dev = xdev->dma_dev->parent;
+	if (!xdev->dma_dev)
+		xdev->dma_dev = &pdev->dev;
+
+	ret = devm_xdma_compl_init(&pdev->dev, &xdev->compl);
+	if (ret)
+		return ret;
+
+	p = &xdev->common;
+	INIT_LIST_HEAD(&p->channels);
+	dma_cap_set(DMA_SLAVE, p->cap_mask);
+	dma_cap_set(DMA_PRIVATE, p->cap_mask);
+	p->dev = &pdev->dev;
+	p->directions = BIT(DMA_MEM_TO_DEV) | BIT(DMA_DEV_TO_MEM);
+	p->residue_granularity = DMA_RESIDUE_GRANULARITY_DESCRIPTOR;
+	p->src_addr_widths = BIT(DMA_SLAVE_BUSWIDTH_4_BYTES) |
+			     BIT(DMA_SLAVE_BUSWIDTH_8_BYTES);
+	p->dst_addr_widths = p->src_addr_widths;
+	p->device_alloc_chan_resources = xilinx_xdma_alloc_chan_resources;
+	p->device_free_chan_resources = xilinx_xdma_free_chan_resources;
+	p->device_prep_slave_sg = xilinx_xdma_prep_slave_sg;
+	p->device_config = xilinx_xdma_device_config;
+	p->device_issue_pending = xilinx_xdma_issue_pending;
+	p->device_tx_status = xilinx_xdma_tx_status;
+	p->device_terminate_all = xilinx_xdma_terminate_all;
+	p->device_synchronize = xilinx_xdma_synchronize;
+	p->filter.map = pdata->device_map;
+	p->filter.mapcnt = pdata->device_map_cnt;
+	p->filter.fn = xilinx_xdma_filter_fn;
+
+	irq_res = platform_get_resource(pdev, IORESOURCE_IRQ, 0);
+
+	for (i = 0; i < max; i++) {
+		ret = xilinx_xdma_chan_probe(xdev, DMA_MEM_TO_DEV, i, irq_res);
+		if (ret == -ENODEV)
+			break;
+		if (ret)
+			return ret;
+	}
+
+	for (i = 0; i < max; i++) {
+		ret = xilinx_xdma_chan_probe(xdev, DMA_DEV_TO_MEM, i, irq_res);
+		if (ret == -ENODEV)
+			break;
+		if (ret)
+			return ret;
+	}
+
+	if (!xdev->num_chans) {
+		dev_err(&pdev->dev, "no DMA engine found\n");
+		return -ENODEV;
+	}
+
+	xilinx_xdma_set_vectors(xdev);
+	platform_set_drvdata(pdev, xdev);
+
+	ret = dma_async_device_register(p);
+	if (ret) {
+		dev_err(&pdev->dev, "failed to register the dma device\n");
+		writel(~0, xdev->regs + XDMA_IRQ_CHAN_INT_EN_W1C);
+		return ret;
+	}
+
+	for (i = 0; i < xdev->num_chans; i++)
+		xdma_stats_debugfs_init(&xdev->chans[i].stats,
+					p->dbg_dev_root,
+					dma_chan_name(&xdev->chans[i].common));
+
+	dev_info(&pdev->dev, "%u DMA channels, %s completion\n",
+		 xdev->num_chans, irq_res ? "interrupt" : "polled");
+
+	return 0;
+}
+
+static int xilinx_xdma_remove(struct platform_device *pdev)
+{
+	struct xilinx_xdma_device *xdev = platform_get_drvdata(pdev);
+	unsigned int i;
+
+	dma_async_device_unregister(&xdev->common);
+	writel(~0, xdev->regs + XDMA_IRQ_CHAN_INT_EN_W1C);
+
+	for (i = 0; i < xdev->num_chans; i++)
+		xilinx_xdma_stop(&xdev->chans[i]);
+
+	return 0;
+}
+
+static struct platform_driver xilinx_xdma_driver = {
+	.driver = {
+		.name = "xilinx-xdma",
+	},
+	.probe = xilinx_xdma_probe,
+	.remove = xilinx_xdma_remove,
+};
+
+module_platform_driver(xilinx_xdma_driver);
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Xilinx, Inc.");
+MODULE_DESCRIPTION("Xilinx XDMA PCIe DMA driver");
+MODULE_ALIAS("platform:xilinx-xdma");
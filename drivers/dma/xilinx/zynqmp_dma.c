@@ -19,6 +19,8 @@
 #include <linux/pm_runtime.h>
 
 #include "../dmaengine.h"
+#include "xilinx_dma_compl.h"
+#include "xilinx_dma_stats.h"
 
 /* Register Offsets */
 #define ZYNQMP_DMA_ISR			0x100
@@ -37,6 +39,10 @@
 #define ZYNQMP_DMA_DST_DSCR_WRD1	0x13C
 #define ZYNQMP_DMA_DST_DSCR_WRD2	0x140
 #define ZYNQMP_DMA_DST_DSCR_WRD3	0x144
+#define ZYNQMP_DMA_WR_ONLY_WORD0	0x148
+#define ZYNQMP_DMA_WR_ONLY_WORD1	0x14C
+#define ZYNQMP_DMA_WR_ONLY_WORD2	0x150
+#define ZYNQMP_DMA_WR_ONLY_WORD3	0x154
 #define ZYNQMP_DMA_SRC_START_LSB	0x158
 #define ZYNQMP_DMA_SRC_START_MSB	0x15C
 #define ZYNQMP_DMA_DST_START_LSB	0x160
@@ -62,6 +68,8 @@
 /* Control 0 register bit field definitions */
 #define ZYNQMP_DMA_OVR_FETCH		BIT(7)
 #define ZYNQMP_DMA_POINT_TYPE_SG	BIT(6)
+#define ZYNQMP_DMA_MODE			GENMASK(5, 4)
+#define ZYNQMP_DMA_MODE_WR_ONLY		BIT(4)
 #define ZYNQMP_DMA_RATE_CTRL_EN		BIT(3)
 
 /* Control 1 register bit field definitions */
@@ -164,7 +172,7 @@ struct zynqmp_dma_desc_ll {
  * struct zynqmp_dma_desc_sw - Per Transaction structure
  * @src: Source address for simple mode dma
  * @dst: Destination address for simple mode dma
- * @len: Transfer length for simple mode dma
+ * @len: Transfer length
  * @node: Node in the channel descriptor list
  * @tx_list: List head for the current transfer
  * @async_tx: Async transaction descriptor
@@ -172,6 +180,9 @@ struct zynqmp_dma_desc_ll {
  * @src_p: Physical address of the src descriptor
  * @dst_v: Virtual address of the dst descriptor
  * @dst_p: Physical address of the dst descriptor
+ * @submit_ns: Submission timestamp for the channel statistics
+ * @memset: The transaction writes @fill instead of reading a source
+ * @fill: Word written by a memset transaction
  */
 struct zynqmp_dma_desc_sw {
 	u64 src;
@@ -184,6 +195,9 @@ struct zynqmp_dma_desc_sw {
 	dma_addr_t src_p;
 	struct zynqmp_dma_desc_ll *dst_v;
 	dma_addr_t dst_p;
+	u64 submit_ns;
+	bool memset;
+	u32 fill;
 };
 
 /**
@@ -203,13 +217,14 @@ struct zynqmp_dma_desc_sw {
  * @dev: The dma device
  * @irq: Channel IRQ
  * @is_dmacoherent: Tells whether dma operations are coherent or not
- * @tasklet: Cleanup work after irq
+ * @compl: Cleanup work after irq
  * @idle : Channel status;
  * @desc_size: Size of the low level descriptor
  * @err: Channel has errors
  * @bus_width: Bus width
  * @src_burst_len: Source burst length
  * @dst_burst_len: Dest burst length
+ * @stats: Transfer statistics
  */
 struct zynqmp_dma_chan {
 	struct zynqmp_dma_device *zdev;
@@ -227,13 +242,14 @@ struct zynqmp_dma_chan {
 	struct device *dev;
 	int irq;
 	bool is_dmacoherent;
-	struct tasklet_struct tasklet;
+	struct xdma_compl_item compl;
 	bool idle;
 	size_t desc_size;
 	bool err;
 	u32 bus_width;
 	u32 src_burst_len;
 	u32 dst_burst_len;
+	struct xdma_stats stats;
 };
 
 /**
@@ -243,6 +259,7 @@ struct zynqmp_dma_chan {
  * @chan: Driver specific DMA channel
  * @clk_main: Pointer to main clock
  * @clk_apb: Pointer to apb clock
+ * @compl: Context the channel cleanup work runs in
  */
 struct zynqmp_dma_device {
 	struct device *dev;
@@ -250,6 +267,7 @@ struct zynqmp_dma_device {
 	struct zynqmp_dma_chan *chan;
 	struct clk *clk_main;
 	struct clk *clk_apb;
+	struct xdma_compl compl;
 };
 
 static inline void zynqmp_dma_writeq(struct zynqmp_dma_chan *chan, u32 reg,
@@ -359,6 +377,39 @@ static void zynqmp_dma_init(struct zynqmp_dma_chan *chan)
 	chan->idle = true;
 }
 
+/**
+ * zynqmp_dma_pending_count - Number of transactions waiting to be started
+ * @chan: ZynqMP DMA channel pointer
+ *
+ * Return: number of transactions on the pending list
+ */
+static unsigned int zynqmp_dma_pending_count(struct zynqmp_dma_chan *chan)
+{
+	struct list_head *entry;
+	unsigned int count = 0;
+
+	list_for_each(entry, &chan->pending_list)
+		count++;
+
+	return count;
+}
+
+/**
+ * zynqmp_dma_same_mode - Check if two transactions can run in one chain
+ * @a: Transaction descriptor pointer
+ * @b: Transaction descriptor pointer
+ *
+ * The write only mode and its data are per channel, so a memset can't be
+ * chained with a copy, or with a memset of another value.
+ *
+ * Return: true if @a and @b use the same channel mode
+ */
+static bool zynqmp_dma_same_mode(struct zynqmp_dma_desc_sw *a,
+				 struct zynqmp_dma_desc_sw *b)
+{
+	return a->memset == b->memset && (!a->memset || a->fill == b->fill);
+}
+
 /**
  * zynqmp_dma_tx_submit - Submit DMA transaction
  * @tx: Async transaction descriptor pointer
@@ -373,12 +424,19 @@ static dma_cookie_t zynqmp_dma_tx_submit(struct dma_async_tx_descriptor *tx)
 	unsigned long irqflags;
 
 	new = tx_to_desc(tx);
+	new->len = new->src_v->size;
+	list_for_each_entry(desc, &new->tx_list, node)
+		new->len += desc->src_v->size;
+
 	spin_lock_irqsave(&chan->lock, irqflags);
 	cookie = dma_cookie_assign(tx);
+	new->submit_ns = xdma_stats_submit(&chan->stats, tx->chan, cookie,
+					   new->len);
 
-	if (!list_empty(&chan->pending_list)) {
-		desc = list_last_entry(&chan->pending_list,
-				     struct zynqmp_dma_desc_sw, node);
+	desc = list_empty(&chan->pending_list) ? NULL :
+	       list_last_entry(&chan->pending_list,
+			       struct zynqmp_dma_desc_sw, node);
+	if (desc && zynqmp_dma_same_mode(desc, new)) {
 		if (!list_empty(&desc->tx_list))
 			desc = list_last_entry(&desc->tx_list,
 					       struct zynqmp_dma_desc_sw, node);
@@ -413,6 +471,7 @@ zynqmp_dma_get_descriptor(struct zynqmp_dma_chan *chan)
 	spin_unlock_irqrestore(&chan->lock, irqflags);
 
 	INIT_LIST_HEAD(&desc->tx_list);
+	desc->memset = false;
 	/* Clear the src and dst descriptor memory */
 	memset((void *)desc->src_v, 0, ZYNQMP_DMA_DESC_SIZE(chan));
 	memset((void *)desc->dst_v, 0, ZYNQMP_DMA_DESC_SIZE(chan));
@@ -532,12 +591,21 @@ static void zynqmp_dma_handle_ovfl_int(struct zynqmp_dma_chan *chan, u32 status)
 		readl(chan->regs + ZYNQMP_DMA_IRQ_SRC_ACCT);
 }
 
-static void zynqmp_dma_config(struct zynqmp_dma_chan *chan)
+static void zynqmp_dma_config(struct zynqmp_dma_chan *chan,
+			      struct zynqmp_dma_desc_sw *desc)
 {
 	u32 val, burst_val;
 
 	val = readl(chan->regs + ZYNQMP_DMA_CTRL0);
 	val |= ZYNQMP_DMA_POINT_TYPE_SG;
+	val &= ~ZYNQMP_DMA_MODE;
+	if (desc->memset) {
+		val |= ZYNQMP_DMA_MODE_WR_ONLY;
+		writel(desc->fill, chan->regs + ZYNQMP_DMA_WR_ONLY_WORD0);
+		writel(desc->fill, chan->regs + ZYNQMP_DMA_WR_ONLY_WORD1);
+		writel(desc->fill, chan->regs + ZYNQMP_DMA_WR_ONLY_WORD2);
+		writel(desc->fill, chan->regs + ZYNQMP_DMA_WR_ONLY_WORD3);
+	}
 	writel(val, chan->regs + ZYNQMP_DMA_CTRL0);
 
 	val = readl(chan->regs + ZYNQMP_DMA_DATA_ATTR);
@@ -576,20 +644,30 @@ static int zynqmp_dma_device_config(struct dma_chan *dchan,
  */
 static void zynqmp_dma_start_transfer(struct zynqmp_dma_chan *chan)
 {
-	struct zynqmp_dma_desc_sw *desc;
+	struct zynqmp_dma_desc_sw *desc, *next, *first;
+	unsigned int count = 0;
 
 	if (!chan->idle)
 		return;
 
-	zynqmp_dma_config(chan);
-
-	desc = list_first_entry_or_null(&chan->pending_list,
-					struct zynqmp_dma_desc_sw, node);
-	if (!desc)
+	first = list_first_entry_or_null(&chan->pending_list,
+					 struct zynqmp_dma_desc_sw, node);
+	if (!first)
 		return;
 
-	list_splice_tail_init(&chan->pending_list, &chan->active_list);
-	zynqmp_dma_update_desc_to_ctrlr(chan, desc);
+	zynqmp_dma_config(chan, first);
+
+	/* Only the transactions chained in the same mode start together */
+	list_for_each_entry_safe(desc, next, &chan->pending_list, node) {
+		if (!zynqmp_dma_same_mode(first, desc))
+			break;
+		list_move_tail(&desc->node, &chan->active_list);
+		count++;
+	}
+
+	xdma_stats_start(&chan->stats, &chan->common, count);
+
+	zynqmp_dma_update_desc_to_ctrlr(chan, first);
 	zynqmp_dma_start(chan);
 }
 
@@ -602,23 +680,27 @@ static void zynqmp_dma_chan_desc_cleanup(struct zynqmp_dma_chan *chan)
 {
 	struct zynqmp_dma_desc_sw *desc, *next;
 	unsigned long irqflags;
+	LIST_HEAD(done);
 
 	spin_lock_irqsave(&chan->lock, irqflags);
+	list_splice_tail_init(&chan->done_list, &done);
+	spin_unlock_irqrestore(&chan->lock, irqflags);
+
+	if (list_empty(&done))
+		return;
 
-	list_for_each_entry_safe(desc, next, &chan->done_list, node) {
+	/* Run the callbacks of the whole batch without the lock */
+	list_for_each_entry(desc, &done, node) {
 		struct dmaengine_desc_callback cb;
 
 		dmaengine_desc_get_callback(&desc->async_tx, &cb);
-		if (dmaengine_desc_callback_valid(&cb)) {
-			spin_unlock_irqrestore(&chan->lock, irqflags);
+		if (dmaengine_desc_callback_valid(&cb))
 			dmaengine_desc_callback_invoke(&cb, NULL);
-			spin_lock_irqsave(&chan->lock, irqflags);
-		}
-
-		/* Run any dependencies, then free the descriptor */
-		zynqmp_dma_free_descriptor(chan, desc);
 	}
 
+	spin_lock_irqsave(&chan->lock, irqflags);
+	list_for_each_entry_safe(desc, next, &done, node)
+		zynqmp_dma_free_descriptor(chan, desc);
 	spin_unlock_irqrestore(&chan->lock, irqflags);
 }
 
@@ -635,6 +717,8 @@ static void zynqmp_dma_complete_descriptor(struct zynqmp_dma_chan *chan)
 	if (!desc)
 		return;
 	list_del(&desc->node);
+	xdma_stats_complete(&chan->stats, &chan->common, desc->async_tx.cookie,
+			    desc->len, desc->submit_ns);
 	dma_cookie_complete(&desc->async_tx);
 	list_add_tail(&desc->node, &chan->done_list);
 }
@@ -649,6 +733,7 @@ static void zynqmp_dma_issue_pending(struct dma_chan *dchan)
 	unsigned long irqflags;
 
 	spin_lock_irqsave(&chan->lock, irqflags);
+	xdma_stats_issue(&chan->stats, dchan, zynqmp_dma_pending_count(chan));
 	zynqmp_dma_start_transfer(chan);
 	spin_unlock_irqrestore(&chan->lock, irqflags);
 }
@@ -723,7 +808,7 @@ static irqreturn_t zynqmp_dma_irq_handler(int irq, void *data)
 
 	writel(isr, chan->regs + ZYNQMP_DMA_ISR);
 	if (status & ZYNQMP_DMA_INT_DONE) {
-		tasklet_schedule(&chan->tasklet);
+		xdma_compl_schedule(&chan->compl);
 		ret = IRQ_HANDLED;
 	}
 
@@ -732,7 +817,7 @@ static irqreturn_t zynqmp_dma_irq_handler(int irq, void *data)
 
 	if (status & ZYNQMP_DMA_INT_ERR) {
 		chan->err = true;
-		tasklet_schedule(&chan->tasklet);
+		xdma_compl_schedule(&chan->compl);
 		dev_err(chan->dev, "Channel %p has errors\n", chan);
 		ret = IRQ_HANDLED;
 	}
@@ -747,12 +832,12 @@ static irqreturn_t zynqmp_dma_irq_handler(int irq, void *data)
 }
 
 /**
- * zynqmp_dma_do_tasklet - Schedule completion tasklet
- * @t: Pointer to the ZynqMP DMA channel structure
+ * zynqmp_dma_do_compl - Deferred completion work
+ * @data: Pointer to the ZynqMP DMA channel structure
  */
-static void zynqmp_dma_do_tasklet(struct tasklet_struct *t)
+static void zynqmp_dma_do_compl(void *data)
 {
-	struct zynqmp_dma_chan *chan = from_tasklet(chan, t, tasklet);
+	struct zynqmp_dma_chan *chan = data;
 	u32 count;
 	unsigned long irqflags;
 
@@ -803,7 +888,7 @@ static void zynqmp_dma_synchronize(struct dma_chan *dchan)
 {
 	struct zynqmp_dma_chan *chan = to_chan(dchan);
 
-	tasklet_kill(&chan->tasklet);
+	xdma_compl_kill(&chan->compl);
 }
 
 /**
@@ -864,6 +949,221 @@ static struct dma_async_tx_descriptor *zynqmp_dma_prep_memcpy(
 	return &first->async_tx;
 }
 
+/**
+ * zynqmp_dma_prep_memset - prepare descriptors for a memset transaction
+ * @dchan: DMA channel
+ * @dma_dst: Destination buffer address
+ * @value: Byte value to fill the buffer with
+ * @len: Transfer length
+ * @flags: transfer ack flags
+ *
+ * The channel runs the transaction in write only mode, where the data comes
+ * from the write only registers and nothing is read from memory.
+ *
+ * Return: Async transaction descriptor on success and NULL on failure
+ */
+static struct dma_async_tx_descriptor *zynqmp_dma_prep_memset(
+				struct dma_chan *dchan, dma_addr_t dma_dst,
+				int value, size_t len, ulong flags)
+{
+	struct dma_async_tx_descriptor *tx;
+	struct zynqmp_dma_desc_sw *first;
+
+	/* The source descriptors are not fetched from in write only mode */
+	tx = zynqmp_dma_prep_memcpy(dchan, dma_dst, dma_dst, len, flags);
+	if (!tx)
+		return NULL;
+
+	first = tx_to_desc(tx);
+	first->memset = true;
+	first->fill = (u8)value * 0x01010101U;
+
+	return tx;
+}
+
+/**
+ * zynqmp_dma_prep_memcpy_sg - prepare descriptors for a memcpy_sg transaction
+ * @dchan: DMA channel
+ * @dst_sg: Destination scatter list
+ * @dst_nents: Number of entries in destination scatter list
+ * @src_sg: Source scatter list
+ * @src_nents: Number of entries in source scatter list
+ * @flags: transfer ack flags
+ *
+ * The whole copy is built as a single linked list chain, so it completes
+ * with one interrupt. A chunk ends wherever a source or destination entry
+ * does, and the copy stops at the end of the shorter list.
+ *
+ * Return: Async transaction descriptor on success and NULL on failure
+ */
+static struct dma_async_tx_descriptor *zynqmp_dma_prep_memcpy_sg(
+			struct dma_chan *dchan,
+			struct scatterlist *dst_sg, unsigned int dst_nents,
+			struct scatterlist *src_sg, unsigned int src_nents,
+			unsigned long flags)
+{
+	struct zynqmp_dma_chan *chan = to_chan(dchan);
+	struct zynqmp_dma_desc_sw *new, *first = NULL;
+	void *desc = NULL, *prev = NULL;
+	size_t len, dst_avail, src_avail;
+	dma_addr_t dma_dst, dma_src;
+	u32 desc_cnt = dst_nents, used = 0;
+	unsigned long irqflags;
+	struct scatterlist *sg;
+	unsigned int i;
+
+	if (!dst_sg || !src_sg || !dst_nents || !src_nents)
+		return NULL;
+
+	/* Every chunk ends at a source split or a destination boundary */
+	for_each_sg(src_sg, sg, src_nents, i)
+		desc_cnt += DIV_ROUND_UP(sg_dma_len(sg),
+					 ZYNQMP_DMA_MAX_TRANS_LEN);
+
+	spin_lock_irqsave(&chan->lock, irqflags);
+	if (desc_cnt > chan->desc_free_cnt) {
+		spin_unlock_irqrestore(&chan->lock, irqflags);
+		dev_dbg(chan->dev, "chan %p descs are not available\n", chan);
+		return NULL;
+	}
+	chan->desc_free_cnt = chan->desc_free_cnt - desc_cnt;
+	spin_unlock_irqrestore(&chan->lock, irqflags);
+
+	dst_avail = sg_dma_len(dst_sg);
+	src_avail = sg_dma_len(src_sg);
+
+	/* Run until we are out of scatterlist entries */
+	while (true) {
+		len = min_t(size_t, src_avail, dst_avail);
+		len = min_t(size_t, len, ZYNQMP_DMA_MAX_TRANS_LEN);
+		if (len) {
+			dma_dst = sg_dma_address(dst_sg) + sg_dma_len(dst_sg) -
+				  dst_avail;
+			dma_src = sg_dma_address(src_sg) + sg_dma_len(src_sg) -
+				  src_avail;
+
+			/* Allocate and populate the descriptor */
+			new = zynqmp_dma_get_descriptor(chan);
+			used++;
+
+			desc = (struct zynqmp_dma_desc_ll *)new->src_v;
+			zynqmp_dma_config_sg_ll_desc(chan, desc, dma_src,
+						     dma_dst, len, prev);
+			prev = desc;
+			dst_avail -= len;
+			src_avail -= len;
+
+			if (!first)
+				first = new;
+			else
+				list_add_tail(&new->node, &first->tx_list);
+		}
+
+		/* Fetch the next dst scatterlist entry */
+		if (!dst_avail) {
+			if (!--dst_nents)
+				break;
+			dst_sg = sg_next(dst_sg);
+			dst_avail = sg_dma_len(dst_sg);
+		}
+
+		/* Fetch the next src scatterlist entry */
+		if (!src_avail) {
+			if (!--src_nents)
+				break;
+			src_sg = sg_next(src_sg);
+			src_avail = sg_dma_len(src_sg);
+		}
+	}
+
+	/* Give back what the upper bound reserved on top */
+	spin_lock_irqsave(&chan->lock, irqflags);
+	chan->desc_free_cnt += desc_cnt - used;
+	spin_unlock_irqrestore(&chan->lock, irqflags);
+
+	if (!first)
+		return NULL;
+
+	zynqmp_dma_desc_config_eod(chan, desc);
+	async_tx_ack(&first->async_tx);
+	first->async_tx.flags = (enum dma_ctrl_flags)flags;
+	return &first->async_tx;
+}
+
+/**
+ * zynqmp_dma_prep_batch - prepare a single transaction for a batch of copies
+ * @dchan: DMA channel
+ * @xfers: copies of the batch
+ * @nr: number of entries in @xfers
+ * @direction: DMA direction, must be DMA_MEM_TO_MEM
+ * @flags: transfer ack flags
+ *
+ * Like zynqmp_dma_prep_memcpy_sg, all the copies are built as a single
+ * linked list chain that completes with one interrupt.
+ *
+ * Return: Async transaction descriptor on success and NULL on failure
+ */
+static struct dma_async_tx_descriptor *zynqmp_dma_prep_batch(
+			struct dma_chan *dchan,
+			const struct dma_batch_xfer *xfers, unsigned int nr,
+			enum dma_transfer_direction direction,
+			unsigned long flags)
+{
+	struct zynqmp_dma_chan *chan = to_chan(dchan);
+	struct zynqmp_dma_desc_sw *new, *first = NULL;
+	void *desc = NULL, *prev = NULL;
+	dma_addr_t dma_dst, dma_src;
+	unsigned long irqflags;
+	size_t len, copy;
+	u32 desc_cnt = 0;
+	unsigned int i;
+
+	if (direction != DMA_MEM_TO_MEM)
+		return NULL;
+
+	for (i = 0; i < nr; i++)
+		desc_cnt += DIV_ROUND_UP(xfers[i].len,
+					 ZYNQMP_DMA_MAX_TRANS_LEN);
+	if (!desc_cnt)
+		return NULL;
+
+	spin_lock_irqsave(&chan->lock, irqflags);
+	if (desc_cnt > chan->desc_free_cnt) {
+		spin_unlock_irqrestore(&chan->lock, irqflags);
+		dev_dbg(chan->dev, "chan %p descs are not available\n", chan);
+		return NULL;
+	}
+	chan->desc_free_cnt = chan->desc_free_cnt - desc_cnt;
+	spin_unlock_irqrestore(&chan->lock, irqflags);
+
+	for (i = 0; i < nr; i++) {
+		dma_src = xfers[i].src;
+		dma_dst = xfers[i].dst;
+
+		for (len = xfers[i].len; len; len -= copy) {
+			/* Allocate and populate the descriptor */
+			new = zynqmp_dma_get_descriptor(chan);
+
+			copy = min_t(size_t, len, ZYNQMP_DMA_MAX_TRANS_LEN);
+			desc = (struct zynqmp_dma_desc_ll *)new->src_v;
+			zynqmp_dma_config_sg_ll_desc(chan, desc, dma_src,
+						     dma_dst, copy, prev);
+			prev = desc;
+			dma_src += copy;
+			dma_dst += copy;
+			if (!first)
+				first = new;
+			else
+				list_add_tail(&new->node, &first->tx_list);
+		}
+	}
+
+	zynqmp_dma_desc_config_eod(chan, desc);
+	async_tx_ack(&first->async_tx);
+	first->async_tx.flags = (enum dma_ctrl_flags)flags;
+	return &first->async_tx;
+}
+
 /**
  * zynqmp_dma_chan_remove - Channel remove function
  * @chan: ZynqMP DMA channel pointer
@@ -875,7 +1175,7 @@ static void zynqmp_dma_chan_remove(struct zynqmp_dma_chan *chan)
 
 	if (chan->irq)
 		devm_free_irq(chan->zdev->dev, chan->irq, chan);
-	tasklet_kill(&chan->tasklet);
+	xdma_compl_kill(&chan->compl);
 	list_del(&chan->common.device_node);
 }
 
@@ -922,7 +1222,9 @@ static int zynqmp_dma_chan_probe(struct zynqmp_dma_device *zdev,
 
 	chan->is_dmacoherent =  of_property_read_bool(node, "dma-coherent");
 	zdev->chan = chan;
-	tasklet_setup(&chan->tasklet, zynqmp_dma_do_tasklet);
+	xdma_compl_item_init(&chan->compl, &zdev->compl, zynqmp_dma_do_compl,
+			     chan);
+	xdma_stats_init(&chan->stats);
 	spin_lock_init(&chan->lock);
 	INIT_LIST_HEAD(&chan->active_list);
 	INIT_LIST_HEAD(&chan->pending_list);
@@ -1068,9 +1370,14 @@ static int zynqmp_dma_probe(struct platform_device *pdev)
 		return ret;
 	}
 	dma_cap_set(DMA_MEMCPY, zdev->common.cap_mask);
+	dma_cap_set(DMA_MEMCPY_SG, zdev->common.cap_mask);
+	dma_cap_set(DMA_MEMSET, zdev->common.cap_mask);
 
 	p = &zdev->common;
 	p->device_prep_dma_memcpy = zynqmp_dma_prep_memcpy;
+	p->device_prep_dma_memcpy_sg = zynqmp_dma_prep_memcpy_sg;
+	p->device_prep_dma_memset = zynqmp_dma_prep_memset;
+	p->device_prep_batch = zynqmp_dma_prep_batch;
 	p->device_terminate_all = zynqmp_dma_device_terminate_all;
 	p->device_synchronize = zynqmp_dma_synchronize;
 	p->device_issue_pending = zynqmp_dma_issue_pending;
@@ -1090,6 +1397,10 @@ static int zynqmp_dma_probe(struct platform_device *pdev)
 		return dev_err_probe(&pdev->dev, PTR_ERR(zdev->clk_apb),
 				     "apb clock not found.\n");
 
+	ret = devm_xdma_compl_init(&pdev->dev, &zdev->compl);
+	if (ret)
+		return ret;
+
 	platform_set_drvdata(pdev, zdev);
 	pm_runtime_set_autosuspend_delay(zdev->dev, ZDMA_PM_TIMEOUT);
 	pm_runtime_use_autosuspend(zdev->dev);
@@ -1120,6 +1431,9 @@ static int zynqmp_dma_probe(struct platform_device *pdev)
 		goto free_chan_resources;
 	}
 
+	xdma_stats_debugfs_init(&zdev->chan->stats, zdev->common.dbg_dev_root,
+				dma_chan_name(&zdev->chan->common));
+
 	ret = of_dma_controller_register(pdev->dev.of_node,
 					 of_zynqmp_dma_xlate, zdev);
 	if (ret) {
@@ -0,0 +1,578 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * ZynqMP DMA memory copy offload
+ *
+ * Copyright (C) 2023 Xilinx, Inc. All rights reserved.
+ *
+ * Large copies between CMA buffers keep the A53 cores busy while the
+ * GDMA/ADMA channels sit idle. This module pools the ZynqMP DMA channels
+ * and offers them for offloaded copies:
+ *
+ * - in-kernel users get the least loaded channel with zynqmp_dma_copy_get(),
+ *   which returns NULL for copies below the "threshold" module parameter,
+ *   and queue scatter-gather copies returning a dma_fence with
+ *   zynqmp_dma_copy_submit();
+ * - userspace copies between two dma-bufs through /dev/zynqmp-dma-copy and
+ *   gets back a sync_file for the copy.
+ */
+
+#include <linux/dma-buf.h>
+#include <linux/dma-fence.h>
+#include <linux/dma-resv.h>
+#include <linux/dma/zynqmp_dma_copy.h>
+#include <linux/file.h>
+#include <linux/fs.h>
+#include <linux/miscdevice.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/sync_file.h>
+#include <linux/uaccess.h>
+#include <linux/workqueue.h>
+
+#include <linux/zynqmp-dma-copy.h>
+
+/* 8 GDMA and 8 ADMA channels */
+#define ZDMA_COPY_MAX_CHANS	16
+
+static unsigned int max_chans = 8;
+module_param(max_chans, uint, 0444);
+MODULE_PARM_DESC(max_chans, "Maximum number of DMA channels to pool (default: 8)");
+
+static unsigned int threshold = SZ_64K;
+module_param(threshold, uint, 0644);
+MODULE_PARM_DESC(threshold, "Smallest copy in bytes worth offloading (default: 64K)");
+
+/**
+ * struct zdma_copy_chan - Pooled DMA channel
+ * @chan: DMA channel
+ * @users: Copies currently using the channel
+ * @context: Fence context of the channel
+ * @seqno: Last fence sequence number of the channel
+ * @fence_lock: Lock of the channel fences
+ */
+struct zdma_copy_chan {
+	struct dma_chan *chan;
+	atomic_t users;
+	u64 context;
+	atomic64_t seqno;
+	spinlock_t fence_lock;
+};
+
+/**
+ * struct zdma_copy_job - Queued copy
+ * @base: Fence signalled when the copy is done
+ * @pchan: Channel the copy runs on
+ * @work: Runs @done in process context after completion
+ * @done: Completion callback of the submitter
+ * @data: Argument of @done
+ */
+struct zdma_copy_job {
+	struct dma_fence base;
+	struct zdma_copy_chan *pchan;
+	struct work_struct work;
+	void (*done)(void *data);
+	void *data;
+};
+
+/**
+ * struct zdma_copy_buf - dma-buf mapped for a copy
+ * @dmabuf: dma-buf
+ * @attach: Attachment to the DMA channel device
+ * @sgt: Mapping of the whole dma-buf
+ * @range: Part of @sgt taking part in the copy
+ */
+struct zdma_copy_buf {
+	struct dma_buf *dmabuf;
+	struct dma_buf_attachment *attach;
+	struct sg_table *sgt;
+	struct sg_table range;
+};
+
+/**
+ * struct zdma_copy_xfer - Copy requested by userspace
+ * @chan: DMA channel
+ * @src: Source dma-buf
+ * @dst: Destination dma-buf
+ */
+struct zdma_copy_xfer {
+	struct dma_chan *chan;
+	struct zdma_copy_buf src;
+	struct zdma_copy_buf dst;
+};
+
+static struct zdma_copy_chan zdma_copy_chans[ZDMA_COPY_MAX_CHANS];
+static unsigned int zdma_copy_nchans;
+static DEFINE_MUTEX(zdma_copy_lock);
+
+static bool zdma_copy_filter(struct dma_chan *chan, void *param)
+{
+	return !strcmp(dev_driver_string(chan->device->dev),
+		       "xilinx-zynqmp-dma");
+}
+
+/* Channels are requested on first use, so the DMA drivers had time to probe */
+static void zdma_copy_request_chans(void)
+{
+	struct zdma_copy_chan *pchan;
+	struct dma_chan *chan;
+	dma_cap_mask_t mask;
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_MEMCPY_SG, mask);
+
+	mutex_lock(&zdma_copy_lock);
+	while (zdma_copy_nchans < min_t(unsigned int, max_chans,
+					ZDMA_COPY_MAX_CHANS)) {
+		chan = dma_request_channel(mask, zdma_copy_filter, NULL);
+		if (!chan)
+			break;
+
+		pchan = &zdma_copy_chans[zdma_copy_nchans];
+		pchan->chan = chan;
+		atomic_set(&pchan->users, 0);
+		pchan->context = dma_fence_context_alloc(1);
+		atomic64_set(&pchan->seqno, 0);
+		spin_lock_init(&pchan->fence_lock);
+
+		/* Publish the entry only once it is initialized */
+		smp_store_release(&zdma_copy_nchans, zdma_copy_nchans + 1);
+	}
+	mutex_unlock(&zdma_copy_lock);
+}
+
+static struct zdma_copy_chan *zdma_copy_find(struct dma_chan *chan)
+{
+	unsigned int i, n = smp_load_acquire(&zdma_copy_nchans);
+
+	for (i = 0; i < n; i++)
+		if (zdma_copy_chans[i].chan == chan)
+			return &zdma_copy_chans[i];
+
+	return NULL;
+}
+
+static struct dma_chan *zdma_copy_pick(void)
+{
+	struct zdma_copy_chan *best = NULL;
+	unsigned int i, n;
+
+	n = smp_load_acquire(&zdma_copy_nchans);
+	if (!n) {
+		zdma_copy_request_chans();
+		n = smp_load_acquire(&zdma_copy_nchans);
+		if (!n)
+			return NULL;
+	}
+
+	for (i = 0; i < n; i++)
+		if (!best || atomic_read(&zdma_copy_chans[i].users) <
+			     atomic_read(&best->users))
+			best = &zdma_copy_chans[i];
+
+	atomic_inc(&best->users);
+
+	return best->chan;
+}
+
+/**
+ * zynqmp_dma_copy_get - Get a DMA channel for an offloaded copy
+ * @len: Size of the copy in bytes
+ *
+ * The caller maps its buffers for chan->device->dev, queues the copy with
+ * zynqmp_dma_copy_submit() and gives the channel back with
+ * zynqmp_dma_copy_put() once the copy is done.
+ *
+ * Context: Process context, may sleep.
+ * Return: The least loaded pooled channel, or NULL if the copy is below the
+ * offload threshold or no channel is available and the CPU should copy.
+ */
+struct dma_chan *zynqmp_dma_copy_get(size_t len)
+{
+	if (len < READ_ONCE(threshold))
+		return NULL;
+
+	return zdma_copy_pick();
+}
+EXPORT_SYMBOL_GPL(zynqmp_dma_copy_get);
+
+/**
+ * zynqmp_dma_copy_put - Give back a channel from zynqmp_dma_copy_get()
+ * @chan: DMA channel
+ */
+void zynqmp_dma_copy_put(struct dma_chan *chan)
+{
+	struct zdma_copy_chan *pchan = zdma_copy_find(chan);
+
+	if (!WARN_ON(!pchan))
+		atomic_dec(&pchan->users);
+}
+EXPORT_SYMBOL_GPL(zynqmp_dma_copy_put);
+
+static const char *zdma_copy_fence_get_driver_name(struct dma_fence *fence)
+{
+	return "zynqmp-dma-copy";
+}
+
+static const char *zdma_copy_fence_get_timeline_name(struct dma_fence *fence)
+{
+	struct zdma_copy_job *job = container_of(fence, struct zdma_copy_job,
+						 base);
+
+	return dma_chan_name(job->pchan->chan);
+}
+
+static const struct dma_fence_ops zdma_copy_fence_ops = {
+	.get_driver_name = zdma_copy_fence_get_driver_name,
+	.get_timeline_name = zdma_copy_fence_get_timeline_name,
+};
+
+static void zdma_copy_job_work(struct work_struct *work)
+{
+	struct zdma_copy_job *job = container_of(work, struct zdma_copy_job,
+						 work);
+
+	if (job->done)
+		job->done(job->data);
+
+	dma_fence_put(&job->base);
+}
+
+static void zdma_copy_job_complete(void *param,
+				   const struct dmaengine_result *result)
+{
+	struct zdma_copy_job *job = param;
+
+	if (result && result->result != DMA_TRANS_NOERROR)
+		dma_fence_set_error(&job->base, -EIO);
+
+	dma_fence_signal(&job->base);
+
+	/* Unmapping buffers may sleep, do not run the callback from here */
+	queue_work(system_unbound_wq, &job->work);
+}
+
+/**
+ * zynqmp_dma_copy_submit - Queue an offloaded scatter-gather copy
+ * @chan: DMA channel from zynqmp_dma_copy_get()
+ * @dst_sg: Destination scatter list, mapped for chan->device->dev
+ * @dst_nents: Number of entries in the destination scatter list
+ * @src_sg: Source scatter list, mapped for chan->device->dev
+ * @src_nents: Number of entries in the source scatter list
+ * @done: Optional callback run in process context once the copy is done
+ * @data: Argument of @done
+ *
+ * Return: A fence signalled when the copy is done, the caller owns a
+ * reference to it, or an ERR_PTR() on failure in which case @done is not
+ * called.
+ */
+struct dma_fence *zynqmp_dma_copy_submit(struct dma_chan *chan,
+					 struct scatterlist *dst_sg,
+					 unsigned int dst_nents,
+					 struct scatterlist *src_sg,
+					 unsigned int src_nents,
+					 void (*done)(void *data), void *data)
+{
+	struct dma_async_tx_descriptor *tx;
+	struct zdma_copy_chan *pchan;
+	struct zdma_copy_job *job;
+	dma_cookie_t cookie;
+
+	pchan = zdma_copy_find(chan);
+	if (WARN_ON(!pchan))
+		return ERR_PTR(-EINVAL);
+
+	job = kzalloc(sizeof(*job), GFP_KERNEL);
+	if (!job)
+		return ERR_PTR(-ENOMEM);
+
+	job->pchan = pchan;
+	job->done = done;
+	job->data = data;
+	INIT_WORK(&job->work, zdma_copy_job_work);
+	dma_fence_init(&job->base, &zdma_copy_fence_ops, &pchan->fence_lock,
+		       pchan->context, atomic64_inc_return(&pchan->seqno));
+
+	tx = dmaengine_prep_dma_memcpy_sg(chan, dst_sg, dst_nents, src_sg,
+					  src_nents, DMA_PREP_INTERRUPT);
+	if (!tx) {
+		dma_fence_put(&job->base);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	tx->callback_result = zdma_copy_job_complete;
+	tx->callback_param = job;
+
+	/* Reference dropped by the completion work */
+	dma_fence_get(&job->base);
+
+	cookie = dmaengine_submit(tx);
+	if (dma_submit_error(cookie)) {
+		dma_fence_put(&job->base);
+		dma_fence_put(&job->base);
+		return ERR_PTR(-EIO);
+	}
+
+	dma_async_issue_pending(chan);
+
+	return &job->base;
+}
+EXPORT_SYMBOL_GPL(zynqmp_dma_copy_submit);
+
+/*
+ * Walk the DMA mapped entries of @sgt covering @len bytes from @offset,
+ * filling @out with them if non-NULL.
+ */
+static int zdma_copy_sg_walk(struct sg_table *sgt, u64 offset, u64 len,
+			     struct scatterlist *out)
+{
+	struct scatterlist *sg;
+	unsigned int i;
+	int nents = 0;
+	u64 chunk;
+
+	for_each_sgtable_dma_sg(sgt, sg, i) {
+		if (offset >= sg_dma_len(sg)) {
+			offset -= sg_dma_len(sg);
+			continue;
+		}
+
+		chunk = min_t(u64, sg_dma_len(sg) - offset, len);
+		if (out) {
+			sg_dma_address(out) = sg_dma_address(sg) + offset;
+			sg_dma_len(out) = chunk;
+			out = sg_next(out);
+		}
+
+		nents++;
+		offset = 0;
+		len -= chunk;
+		if (!len)
+			return nents;
+	}
+
+	return -EINVAL;
+}
+
+static void zdma_copy_buf_unmap(struct zdma_copy_buf *buf,
+				enum dma_data_direction dir)
+{
+	sg_free_table(&buf->range);
+	if (buf->sgt)
+		dma_buf_unmap_attachment(buf->attach, buf->sgt, dir);
+	if (buf->attach)
+		dma_buf_detach(buf->dmabuf, buf->attach);
+	if (buf->dmabuf)
+		dma_buf_put(buf->dmabuf);
+}
+
+static int zdma_copy_buf_map(struct zdma_copy_buf *buf, struct device *dev,
+			     int fd, u64 offset, u64 len,
+			     enum dma_data_direction dir)
+{
+	struct dma_buf_attachment *attach;
+	struct dma_buf *dmabuf;
+	struct sg_table *sgt;
+	int nents, ret;
+
+	dmabuf = dma_buf_get(fd);
+	if (IS_ERR(dmabuf))
+		return PTR_ERR(dmabuf);
+	buf->dmabuf = dmabuf;
+
+	if (offset > dmabuf->size || len > dmabuf->size - offset)
+		return -EINVAL;
+
+	attach = dma_buf_attach(dmabuf, dev);
+	if (IS_ERR(attach))
+		return PTR_ERR(attach);
+	buf->attach = attach;
+
+	sgt = dma_buf_map_attachment(attach, dir);
+	if (IS_ERR(sgt))
+		return PTR_ERR(sgt);
+	buf->sgt = sgt;
+
+	nents = zdma_copy_sg_walk(sgt, offset, len, NULL);
+	if (nents < 0)
+		return nents;
+
+	ret = sg_alloc_table(&buf->range, nents, GFP_KERNEL);
+	if (ret)
+		return ret;
+
+	zdma_copy_sg_walk(sgt, offset, len, buf->range.sgl);
+
+	return 0;
+}
+
+static void zdma_copy_xfer_free(void *data)
+{
+	struct zdma_copy_xfer *xfer = data;
+
+	zdma_copy_buf_unmap(&xfer->dst, DMA_FROM_DEVICE);
+	zdma_copy_buf_unmap(&xfer->src, DMA_TO_DEVICE);
+	if (xfer->chan)
+		zynqmp_dma_copy_put(xfer->chan);
+	kfree(xfer);
+}
+
+/*
+ * Best effort: if no fence slot can be reserved, implicitly synchronized
+ * users of the buffer are not ordered after the copy, the sync_file is.
+ */
+static void zdma_copy_add_fence(struct dma_buf *dmabuf,
+				struct dma_fence *fence,
+				enum dma_resv_usage usage)
+{
+	dma_resv_lock(dmabuf->resv, NULL);
+	if (!dma_resv_reserve_fences(dmabuf->resv, 1))
+		dma_resv_add_fence(dmabuf->resv, fence, usage);
+	dma_resv_unlock(dmabuf->resv);
+}
+
+static long zdma_copy_ioctl_copy(struct zynqmp_dma_copy_req __user *arg)
+{
+	struct dma_buf *src_dmabuf, *dst_dmabuf;
+	struct zynqmp_dma_copy_req req;
+	struct zdma_copy_xfer *xfer;
+	struct sync_file *sync_file;
+	struct dma_fence *fence;
+	struct device *dev;
+	long ret;
+	int fd;
+
+	if (copy_from_user(&req, arg, sizeof(req)))
+		return -EFAULT;
+
+	if (req.flags || !req.len)
+		return -EINVAL;
+
+	xfer = kzalloc(sizeof(*xfer), GFP_KERNEL);
+	if (!xfer)
+		return -ENOMEM;
+
+	/* Userspace asked for the offload, the threshold does not apply */
+	xfer->chan = zdma_copy_pick();
+	if (!xfer->chan) {
+		ret = -ENODEV;
+		goto err_free;
+	}
+	dev = xfer->chan->device->dev;
+
+	ret = zdma_copy_buf_map(&xfer->src, dev, req.src_fd, req.src_offset,
+				req.len, DMA_TO_DEVICE);
+	if (ret)
+		goto err_free;
+
+	ret = zdma_copy_buf_map(&xfer->dst, dev, req.dst_fd, req.dst_offset,
+				req.len, DMA_FROM_DEVICE);
+	if (ret)
+		goto err_free;
+
+	src_dmabuf = xfer->src.dmabuf;
+	dst_dmabuf = xfer->dst.dmabuf;
+
+	ret = dma_resv_wait_timeout(src_dmabuf->resv, DMA_RESV_USAGE_WRITE,
+				    true, MAX_SCHEDULE_TIMEOUT);
+	if (ret < 0)
+		goto err_free;
+
+	ret = dma_resv_wait_timeout(dst_dmabuf->resv, DMA_RESV_USAGE_READ,
+				    true, MAX_SCHEDULE_TIMEOUT);
+	if (ret < 0)
+		goto err_free;
+
+	fd = get_unused_fd_flags(O_CLOEXEC);
+	if (fd < 0) {
+		ret = fd;
+		goto err_free;
+	}
+
+	/* The completion work frees xfer, keep the dma-bufs for the fences */
+	get_dma_buf(src_dmabuf);
+	get_dma_buf(dst_dmabuf);
+
+	fence = zynqmp_dma_copy_submit(xfer->chan, xfer->dst.range.sgl,
+				       xfer->dst.range.nents,
+				       xfer->src.range.sgl,
+				       xfer->src.range.nents,
+				       zdma_copy_xfer_free, xfer);
+	if (IS_ERR(fence)) {
+		ret = PTR_ERR(fence);
+		dma_buf_put(dst_dmabuf);
+		dma_buf_put(src_dmabuf);
+		put_unused_fd(fd);
+		goto err_free;
+	}
+
+	zdma_copy_add_fence(dst_dmabuf, fence, DMA_RESV_USAGE_WRITE);
+	zdma_copy_add_fence(src_dmabuf, fence, DMA_RESV_USAGE_READ);
+	dma_buf_put(dst_dmabuf);
+	dma_buf_put(src_dmabuf);
+
+	sync_file = sync_file_create(fence);
+	dma_fence_put(fence);
+	if (!sync_file) {
+		put_unused_fd(fd);
+		return -ENOMEM;
+	}
+
+	if (put_user(fd, &arg->fence_fd)) {
+		fput(sync_file->file);
+		put_unused_fd(fd);
+		return -EFAULT;
+	}
+
+	fd_install(fd, sync_file->file);
+
+	return 0;
+
+err_free:
+	zdma_copy_xfer_free(xfer);
+	return ret;
+}
+
+static long zdma_copy_ioctl(struct file *file, unsigned int cmd,
+			    unsigned long arg)
+{
+	switch (cmd) {
+	case ZYNQMP_DMA_COPY_IOCTL_COPY:
+		return zdma_copy_ioctl_copy((void __user *)arg);
+	default:
+		return -ENOTTY;
+	}
+}
+
+static const struct file_operations zdma_copy_fops = {
+	.owner = THIS_MODULE,
+	.unlocked_ioctl = zdma_copy_ioctl,
+	.compat_ioctl = compat_ptr_ioctl,
+};
+
+static struct miscdevice zdma_copy_misc = {
+	.minor = MISC_DYNAMIC_MINOR,
+	.name = "zynqmp-dma-copy",
+	.fops = &zdma_copy_fops,
+};
+
+static int __init zdma_copy_init(void)
+{
+	return misc_register(&zdma_copy_misc);
+}
+module_init(zdma_copy_init);
+
+static void __exit zdma_copy_exit(void)
+{
+	unsigned int i;
+
+	misc_deregister(&zdma_copy_misc);
+
+	for (i = 0; i < zdma_copy_nchans; i++)
+		dma_release_channel(zdma_copy_chans[i].chan);
+}
+module_exit(zdma_copy_exit);
+
+MODULE_IMPORT_NS(DMA_BUF);
+MODULE_AUTHOR("Xilinx, Inc.");
+MODULE_DESCRIPTION("Xilinx ZynqMP DMA memory copy offload");
+MODULE_LICENSE("GPL");
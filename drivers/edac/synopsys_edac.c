@@ -14,6 +14,7 @@
 #include <linux/of_device.h>
 
 #include "edac_module.h"
+#include "xlnx_edac_stats.h"
 
 /* Number of cs_rows needed per memory controller */
 #define SYNPS_EDAC_NR_CSROWS		1
@@ -305,6 +306,7 @@ struct synps_ecc_status {
  * @p_data:		Platform data.
  * @ce_cnt:		Correctable Error count.
  * @ue_cnt:		Uncorrectable Error count.
+ * @ce_stats:		Correctable error counters.
  * @poison_addr:	Data poison address.
  * @row_shift:		Bit shifts for row bit.
  * @col_shift:		Bit shifts for column bit.
@@ -319,6 +321,7 @@ struct synps_edac_priv {
 	const struct synps_platform_data *p_data;
 	u32 ce_cnt;
 	u32 ue_cnt;
+	struct xedac_stats ce_stats;
 #ifdef CONFIG_EDAC_DEBUG
 	ulong poison_addr;
 	u32 row_shift[18];
@@ -466,15 +469,28 @@ static int zynqmp_get_error_info(struct synps_edac_priv *priv)
  * @mci:	EDAC memory controller instance.
  * @p:		Synopsys ECC status structure.
  *
- * Handles ECC correctable and uncorrectable errors.
+ * Handles ECC correctable and uncorrectable errors. Correctable errors are
+ * accounted in the counters of the controller and reported to the EDAC core
+ * at a limited rate.
  */
 static void handle_error(struct mem_ctl_info *mci, struct synps_ecc_status *p)
 {
 	struct synps_edac_priv *priv = mci->pvt_info;
 	struct ecc_error_info *pinf;
+	struct xedac_ce_loc loc;
+	u32 count = 0;
 
 	if (p->ce_cnt) {
 		pinf = &p->ceinfo;
+		loc = (struct xedac_ce_loc) {
+			.bankgrp = pinf->bankgrpnr,
+			.bank = pinf->bank,
+			.row = pinf->row,
+		};
+		count = xedac_stats_ce(&priv->ce_stats, &loc, p->ce_cnt);
+	}
+
+	if (count) {
 		if (priv->p_data->quirks & DDR_ECC_INTR_SUPPORT) {
 			snprintf(priv->message, SYNPS_EDAC_MSG_SIZE,
 				 "DDR ECC error type:%s Row %d Bank %d BankGroup Number %d Block Number %d Bit Position: %d Data: 0x%08x",
@@ -489,7 +505,7 @@ static void handle_error(struct mem_ctl_info *mci, struct synps_ecc_status *p)
 		}
 
 		edac_mc_handle_error(HW_EVENT_ERR_CORRECTED, mci,
-				     priv->ce_cnt, 0, 0, 0, 0, 0, -1,
+				     count, 0, 0, 0, 0, 0, -1,
 				     priv->message, "");
 	}
 
@@ -940,9 +956,10 @@ static const struct of_device_id synps_edac_match[] = {
 
 MODULE_DEVICE_TABLE(of, synps_edac_match);
 
-#ifdef CONFIG_EDAC_DEBUG
 #define to_mci(k) container_of(k, struct mem_ctl_info, dev)
 
+#ifdef CONFIG_EDAC_DEBUG
+
 /**
  * ddr_poison_setup -	Update poison registers.
  * @priv:		DDR memory controller private instance data.
@@ -1309,6 +1326,45 @@ static void setup_address_map(struct synps_edac_priv *priv)
 }
 #endif /* CONFIG_EDAC_DEBUG */
 
+static ssize_t ce_threshold_show(struct device *dev,
+				 struct device_attribute *mattr, char *data)
+{
+	struct synps_edac_priv *priv = to_mci(dev)->pvt_info;
+
+	return xedac_stats_threshold_show(&priv->ce_stats, data);
+}
+
+static ssize_t ce_threshold_store(struct device *dev,
+				  struct device_attribute *mattr,
+				  const char *data, size_t count)
+{
+	struct synps_edac_priv *priv = to_mci(dev)->pvt_info;
+
+	return xedac_stats_threshold_store(&priv->ce_stats, data, count);
+}
+
+static ssize_t ce_threshold_exceeded_show(struct device *dev,
+					  struct device_attribute *mattr,
+					  char *data)
+{
+	struct synps_edac_priv *priv = to_mci(dev)->pvt_info;
+
+	return xedac_stats_exceeded_show(&priv->ce_stats, data);
+}
+
+static DEVICE_ATTR_RW(ce_threshold);
+static DEVICE_ATTR_RO(ce_threshold_exceeded);
+
+static struct attribute *ce_stats_attrs[] = {
+	&dev_attr_ce_threshold.attr,
+	&dev_attr_ce_threshold_exceeded.attr,
+	NULL
+};
+
+static const struct attribute_group ce_stats_group = {
+	.attrs = ce_stats_attrs,
+};
+
 /**
  * mc_probe - Check controller and bind driver.
  * @pdev:	platform device.
@@ -1360,6 +1416,8 @@ static int mc_probe(struct platform_device *pdev)
 	priv = mci->pvt_info;
 	priv->baseaddr = baseaddr;
 	priv->p_data = p_data;
+	xedac_stats_init(&priv->ce_stats, mci,
+			 p_data->quirks & DDR_ECC_INTR_SUPPORT ? 18 : 16);
 
 	mc_init(mci, pdev);
 
@@ -1376,6 +1434,11 @@ static int mc_probe(struct platform_device *pdev)
 		goto free_edac_mc;
 	}
 
+	xedac_stats_debugfs_init(&priv->ce_stats);
+	if (sysfs_create_group(&mci->dev.kobj, &ce_stats_group))
+		edac_printk(KERN_WARNING, EDAC_MC,
+			    "Failed to create error threshold entries\n");
+
 #ifdef CONFIG_EDAC_DEBUG
 	if (priv->p_data->quirks & DDR_ECC_DATA_POISON_SUPPORT) {
 		rc = edac_create_sysfs_attributes(mci);
@@ -1400,6 +1463,7 @@ static int mc_probe(struct platform_device *pdev)
 	return rc;
 
 free_edac_mc:
+	xedac_stats_exit(&priv->ce_stats);
 	edac_mc_free(mci);
 
 	return rc;
@@ -1424,7 +1488,10 @@ static int mc_remove(struct platform_device *pdev)
 		edac_remove_sysfs_attributes(mci);
 #endif
 
+	sysfs_remove_group(&mci->dev.kobj, &ce_stats_group);
+
 	edac_mc_del_mc(&pdev->dev);
+	xedac_stats_exit(&priv->ce_stats);
 	edac_mc_free(mci);
 
 	return 0;
@@ -15,6 +15,7 @@
 #include <linux/firmware/xlnx-event-manager.h>
 
 #include "edac_module.h"
+#include "xlnx_edac_stats.h"
 
 /* Granularity of reported error in bytes */
 #define XDDR_EDAC_ERR_GRAIN			1
@@ -270,6 +271,7 @@ struct xddr_ecc_status {
  * @mc_id:		Memory controller ID.
  * @ce_cnt:		Correctable error count.
  * @ue_cnt:		UnCorrectable error count.
+ * @ce_stats:		Correctable error counters.
  * @stat:		ECC status information.
  * @lrank_bit:		Bit shifts for lrank bit.
  * @rank_bit:		Bit shifts for rank bit.
@@ -287,6 +289,7 @@ struct xddr_edac_priv {
 	u32 mc_id;
 	u32 ce_cnt;
 	u32 ue_cnt;
+	struct xedac_stats ce_stats;
 	struct xddr_ecc_status stat;
 	u32 lrank_bit[3];
 	u32 rank_bit[2];
@@ -498,24 +501,38 @@ static ulong xddr_convert_to_physical(struct xddr_edac_priv *priv,
  * @mci:	EDAC memory controller instance.
  * @stat:	ECC status structure.
  *
- * Handles ECC correctable and uncorrectable errors.
+ * Handles ECC correctable and uncorrectable errors. Correctable errors are
+ * accounted in the counters of the controller and reported to the EDAC core
+ * at a limited rate.
  */
 static void xddr_handle_error(struct mem_ctl_info *mci,
 			      struct xddr_ecc_status *stat)
 {
 	struct xddr_edac_priv *priv = mci->pvt_info;
 	struct xddr_ecc_error_info pinf;
+	struct xedac_ce_loc loc;
+	u32 count;
 
 	if (stat->error_type == XDDR_ERR_TYPE_CE) {
 		priv->ce_cnt++;
 		pinf = stat->ceinfo[stat->channel];
+		loc = (struct xedac_ce_loc) {
+			.rank = pinf.rank,
+			.bankgrp = pinf.group,
+			.bank = pinf.bank,
+			.row = pinf.row,
+		};
+		count = xedac_stats_ce(&priv->ce_stats, &loc, 1);
+		if (!count)
+			goto out;
+
 		snprintf(priv->message, XDDR_EDAC_MSG_SIZE,
 			 "Error type:%s MC ID: %d Addr at %lx Burst Pos: %d\n",
 			 "CE", priv->mc_id,
 			 xddr_convert_to_physical(priv, pinf), pinf.burstpos);
 
 		edac_mc_handle_error(HW_EVENT_ERR_CORRECTED, mci,
-				     priv->ce_cnt, 0, 0, 0, 0, 0, -1,
+				     count, 0, 0, 0, 0, 0, -1,
 				     priv->message, "");
 	}
 
@@ -532,6 +549,7 @@ static void xddr_handle_error(struct mem_ctl_info *mci,
 				     priv->message, "");
 	}
 
+out:
 	memset(stat, 0, sizeof(*stat));
 }
 
@@ -833,9 +851,10 @@ static int xddr_setup_irq(struct mem_ctl_info *mci,
 	return 0;
 }
 
-#ifdef CONFIG_EDAC_DEBUG
 #define to_mci(k) container_of(k, struct mem_ctl_info, dev)
 
+#ifdef CONFIG_EDAC_DEBUG
+
 /**
  * xddr_poison_setup - Update poison registers.
  * @priv:	DDR memory controller private instance data.
@@ -1103,6 +1122,45 @@ static void xddr_setup_address_map(struct xddr_edac_priv *priv)
 }
 #endif /* CONFIG_EDAC_DEBUG */
 
+static ssize_t ce_threshold_show(struct device *dev,
+				 struct device_attribute *mattr, char *data)
+{
+	struct xddr_edac_priv *priv = to_mci(dev)->pvt_info;
+
+	return xedac_stats_threshold_show(&priv->ce_stats, data);
+}
+
+static ssize_t ce_threshold_store(struct device *dev,
+				  struct device_attribute *mattr,
+				  const char *data, size_t count)
+{
+	struct xddr_edac_priv *priv = to_mci(dev)->pvt_info;
+
+	return xedac_stats_threshold_store(&priv->ce_stats, data, count);
+}
+
+static ssize_t ce_threshold_exceeded_show(struct device *dev,
+					  struct device_attribute *mattr,
+					  char *data)
+{
+	struct xddr_edac_priv *priv = to_mci(dev)->pvt_info;
+
+	return xedac_stats_exceeded_show(&priv->ce_stats, data);
+}
+
+static DEVICE_ATTR_RW(ce_threshold);
+static DEVICE_ATTR_RO(ce_threshold_exceeded);
+
+static struct attribute *xddr_ce_stats_attrs[] = {
+	&dev_attr_ce_threshold.attr,
+	&dev_attr_ce_threshold_exceeded.attr,
+	NULL
+};
+
+static const struct attribute_group xddr_ce_stats_group = {
+	.attrs = xddr_ce_stats_attrs,
+};
+
 /**
  * xddr_mc_probe - Check controller and bind driver.
  * @pdev:	platform device.
@@ -1173,6 +1231,7 @@ static int xddr_mc_probe(struct platform_device *pdev)
 	priv->ddrmc_noc_baseaddr = ddrmc_noc_baseaddr;
 	priv->ce_cnt = 0;
 	priv->ue_cnt = 0;
+	xedac_stats_init(&priv->ce_stats, mci, XDDR_MAX_ROW_CNT);
 
 	xddr_mc_init(mci, pdev);
 
@@ -1183,6 +1242,11 @@ static int xddr_mc_probe(struct platform_device *pdev)
 		goto free_edac_mc;
 	}
 
+	xedac_stats_debugfs_init(&priv->ce_stats);
+	if (sysfs_create_group(&mci->dev.kobj, &xddr_ce_stats_group))
+		edac_printk(KERN_WARNING, EDAC_MC,
+			    "Failed to create error threshold entries\n");
+
 #ifdef CONFIG_EDAC_DEBUG
 	if (edac_create_sysfs_attributes(mci)) {
 		edac_printk(KERN_ERR, EDAC_MC,
@@ -1215,8 +1279,10 @@ static int xddr_mc_probe(struct platform_device *pdev)
 	return rc;
 
 del_edac_mc:
+	sysfs_remove_group(&mci->dev.kobj, &xddr_ce_stats_group);
 	edac_mc_del_mc(&pdev->dev);
 free_edac_mc:
+	xedac_stats_exit(&priv->ce_stats);
 	edac_mc_free(mci);
 
 	return rc;
@@ -1242,7 +1308,9 @@ static int xddr_mc_remove(struct platform_device *pdev)
 	xlnx_unregister_event(PM_NOTIFY_CB, EVENT_ERROR_PMC_ERR1,
 			      XPM_EVENT_ERROR_MASK_DDRMC_CR |
 			      XPM_EVENT_ERROR_MASK_DDRMC_NCR, xddr_err_callback, mci);
+	sysfs_remove_group(&mci->dev.kobj, &xddr_ce_stats_group);
 	edac_mc_del_mc(&pdev->dev);
+	xedac_stats_exit(&priv->ce_stats);
 	edac_mc_free(mci);
 
 	return 0;
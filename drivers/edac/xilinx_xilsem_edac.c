@@ -5,11 +5,14 @@
 
 #include <linux/edac.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
 #include <linux/platform_device.h>
 #include <linux/sizes.h>
+#include <linux/spinlock.h>
 #include <linux/bitfield.h>
+#include <linux/workqueue.h>
 #include <linux/firmware/xlnx-zynqmp.h>
 #include <linux/firmware/xlnx-error-events.h>
 #include <linux/firmware/xlnx-event-manager.h>
@@ -26,6 +29,9 @@
 #define XILSEM_NPI_UE_MASK	BIT(7)
 #define XILSEM_MAX_CE_LOG_CNT	0x07
 
+/* Number of CRAM frames the correctable errors are counted for */
+#define XSEM_FRAME_STATS_MAX	64
+
 /* XilSem_CRAM scan error info registers */
 #define CRAM_STS_INFO_OFFSET	0x34
 #define CRAM_CE_ADDRL0_OFFSET	0x38
@@ -94,9 +100,22 @@ struct xsem_error_status {
 	struct ecc_error_info ueinfo;
 };
 
+/**
+ * struct xsem_frame_stat - Correctable errors of a CRAM frame
+ * @frame_addr:	Frame address
+ * @row_id:	Row number
+ * @ce_cnt:	Number of correctable errors in the frame
+ */
+struct xsem_frame_stat {
+	u32 frame_addr;
+	u32 row_id;
+	u32 ce_cnt;
+};
+
 /**
  * struct xsem_edac_priv - Xilsem private instance data
  * @baseaddr:	Base address of the XilSem PLM RTCA module
+ * @dci:	Pointer to the edac device controller instance
  * @scan_ctrl_status:	Buffer for scan ctrl commands
  * @cram_errinj_status:	Buffer for CRAM error injection
  * @cram_frame_ecc:	Buffer for CRAM frame ECC
@@ -104,9 +123,28 @@ struct xsem_error_status {
  * @xilsem_cfg:	Buffer for CRAM & NPI configuration
  * @ce_cnt:	Correctable Error count
  * @ue_cnt:	Uncorrectable Error count
+ * @stats_lock:	Protects the error statistics and the pending report
+ * @cram_ce_cnt:	CRAM correctable errors since the statistics were cleared
+ * @cram_ue_cnt:	CRAM uncorrectable errors since then
+ * @npi_ue_cnt:	NPI uncorrectable errors since then
+ * @frames_dropped:	Correctable errors of frames @frames had no room for
+ * @nr_frames:	Number of valid entries in @frames
+ * @frames:	Correctable errors per CRAM frame
+ * @report_ms:	Correctable errors are reported at most once per that many
+ *		milliseconds, 0 to report each of them
+ * @pending_ce:	Correctable errors not reported yet
+ * @pending_info:	Last of the correctable errors not reported yet
+ * @report_work:	Reports the pending correctable errors
+ * @sched_lock:	Serializes the changes of the scan schedule
+ * @scan_ms:	Time the scheduled scans run for, 0 if there is no schedule
+ * @idle_ms:	Time the scheduled scans are stopped for
+ * @scan_modules:	CRAM_MOD_ID and NPI_MOD_ID mask of the scheduled scans
+ * @scan_idle:	The schedule has stopped the scans
+ * @scan_work:	Starts and stops the scheduled scans
  */
 struct xsem_edac_priv {
 	void __iomem *baseaddr;
+	struct edac_device_ctl_info *dci;
 	u32 scan_ctrl_status[2];
 	u32 cram_errinj_status[2];
 	u32 cram_frame_ecc[4];
@@ -114,6 +152,23 @@ struct xsem_edac_priv {
 	u32 xilsem_cfg[4];
 	u32 ce_cnt;
 	u32 ue_cnt;
+	spinlock_t stats_lock;
+	u32 cram_ce_cnt;
+	u32 cram_ue_cnt;
+	u32 npi_ue_cnt;
+	u32 frames_dropped;
+	u32 nr_frames;
+	struct xsem_frame_stat frames[XSEM_FRAME_STATS_MAX];
+	u32 report_ms;
+	u32 pending_ce;
+	struct ecc_error_info pending_info;
+	struct delayed_work report_work;
+	struct mutex sched_lock;
+	u32 scan_ms;
+	u32 idle_ms;
+	u32 scan_modules;
+	bool scan_idle;
+	struct delayed_work scan_work;
 };
 
 /**
@@ -481,6 +536,275 @@ static ssize_t xsem_read_config_store(struct edac_device_ctl_info *dci,
 	return count;
 }
 
+/**
+ * xsem_scan_cmd - Start or stop the scheduled scans
+ * @priv:	Pointer to the Xilsem private instance data
+ * @start:	Start the scans if true, stop them otherwise
+ *
+ * Return: 0 if the request succeeds, else error code
+ */
+static int xsem_scan_cmd(struct xsem_edac_priv *priv, bool start)
+{
+	u32 status[2];
+	int ret;
+
+	if (priv->scan_modules & CRAM_MOD_ID) {
+		ret = zynqmp_pm_xilsem_cntrl_ops(start ? CRAM_START_SCAN :
+						 CRAM_STOP_SCAN, status);
+		if (ret)
+			return ret;
+	}
+
+	if (priv->scan_modules & NPI_MOD_ID) {
+		ret = zynqmp_pm_xilsem_cntrl_ops(start ? NPI_START_SCAN :
+						 NPI_STOP_SCAN, status);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/**
+ * xsem_scan_work - Switch the scheduled scans to their next phase
+ * @work:	Pointer to the scan work
+ */
+static void xsem_scan_work(struct work_struct *work)
+{
+	struct xsem_edac_priv *priv = container_of(to_delayed_work(work),
+						   struct xsem_edac_priv,
+						   scan_work);
+	u32 delay = priv->scan_idle ? priv->scan_ms : priv->idle_ms;
+	int ret;
+
+	ret = xsem_scan_cmd(priv, priv->scan_idle);
+	if (ret) {
+		edac_printk(KERN_ERR, EDAC_DEVICE,
+			    "Scan schedule stopped, error %d\n", ret);
+		return;
+	}
+
+	priv->scan_idle = !priv->scan_idle;
+	schedule_delayed_work(&priv->scan_work, msecs_to_jiffies(delay));
+}
+
+/**
+ * xsem_scan_schedule_stop - Cancel the scan schedule
+ * @priv:	Pointer to the Xilsem private instance data
+ *
+ * Leaves the scheduled scans running. Called with sched_lock held.
+ *
+ * Return: 0 if the request succeeds, else error code
+ */
+static int xsem_scan_schedule_stop(struct xsem_edac_priv *priv)
+{
+	int ret = 0;
+
+	cancel_delayed_work_sync(&priv->scan_work);
+	if (priv->scan_idle) {
+		ret = xsem_scan_cmd(priv, true);
+		if (!ret)
+			priv->scan_idle = false;
+	}
+	priv->scan_ms = 0;
+	priv->idle_ms = 0;
+
+	return ret;
+}
+
+/**
+ * xsem_scan_schedule_show - Shows the scan schedule
+ * @dci:	Pointer to the edac device struct
+ * @data:	Pointer to user data
+ *
+ * Shows the scan and idle times in milliseconds and the module mask
+ * Return: Number of bytes copied.
+ */
+static ssize_t xsem_scan_schedule_show(struct edac_device_ctl_info *dci,
+				       char *data)
+{
+	struct xsem_edac_priv *priv = dci->pvt_info;
+
+	return sprintf(data, "[%u][%u][0x%x]\n\r", priv->scan_ms,
+		       priv->idle_ms, priv->scan_modules);
+}
+
+/**
+ * xsem_scan_schedule_store - Set the scan schedule
+ * @dci:	Pointer to the edac device struct
+ * @data:	Pointer to user data
+ * @count:	read the size bytes from buffer
+ *
+ * User-space interface for throttling the background scans. The scans of
+ * the modules in the mask, CRAM only by default, are alternately left
+ * running for <scan_ms> and stopped for <idle_ms>, which bounds the PMC
+ * and NoC bandwidth they take. A time of 0 cancels the schedule and leaves
+ * the scans running. The scans are expected to be running when the
+ * schedule is set.
+ *
+ * To set the schedule
+ * echo <scan_ms> <idle_ms> [<module mask>] > /sys/devices/system/edac/versal_xilsem/xsem_scan_schedule
+ * Usage:
+ * echo 100 900 3 > /sys/devices/system/edac/versal_xilsem/xsem_scan_schedule
+ *
+ * Set the scan schedule
+ * Return: count argument if request succeeds, else error code
+ */
+static ssize_t xsem_scan_schedule_store(struct edac_device_ctl_info *dci,
+					const char *data, size_t count)
+{
+	struct xsem_edac_priv *priv = dci->pvt_info;
+	u32 scan_ms, idle_ms, modules = CRAM_MOD_ID;
+	int ret;
+
+	if (!data)
+		return -EFAULT;
+
+	if (sscanf(data, "%u %u %u", &scan_ms, &idle_ms, &modules) < 2)
+		return -EINVAL;
+
+	if (!modules || modules & ~(CRAM_MOD_ID | NPI_MOD_ID))
+		return -EINVAL;
+
+	mutex_lock(&priv->sched_lock);
+	ret = xsem_scan_schedule_stop(priv);
+	if (!ret && scan_ms && idle_ms) {
+		priv->scan_ms = scan_ms;
+		priv->idle_ms = idle_ms;
+		priv->scan_modules = modules;
+		schedule_delayed_work(&priv->scan_work,
+				      msecs_to_jiffies(scan_ms));
+	}
+	mutex_unlock(&priv->sched_lock);
+
+	if (ret)
+		return ret;
+
+	return count;
+}
+
+/**
+ * xsem_ce_report_ms_show - Shows the correctable error report interval
+ * @dci:	Pointer to the edac device struct
+ * @data:	Pointer to user data
+ *
+ * Return: Number of bytes copied.
+ */
+static ssize_t xsem_ce_report_ms_show(struct edac_device_ctl_info *dci,
+				      char *data)
+{
+	struct xsem_edac_priv *priv = dci->pvt_info;
+
+	return sprintf(data, "%u\n", READ_ONCE(priv->report_ms));
+}
+
+/**
+ * xsem_ce_report_ms_store - Set the correctable error report interval
+ * @dci:	Pointer to the edac device struct
+ * @data:	Pointer to user data
+ * @count:	read the size bytes from buffer
+ *
+ * User-space interface for batching the correctable error reports. The
+ * errors are still counted as they come, but reported to the EDAC core
+ * and the kernel log at most once per interval, with the last of them.
+ * Uncorrectable errors are always reported at once.
+ *
+ * To set the interval
+ * echo <msecs> > /sys/devices/system/edac/versal_xilsem/xsem_ce_report_ms
+ * Usage:
+ * echo 1000 > /sys/devices/system/edac/versal_xilsem/xsem_ce_report_ms
+ *
+ * Return: count argument if request succeeds, else error code
+ */
+static ssize_t xsem_ce_report_ms_store(struct edac_device_ctl_info *dci,
+				       const char *data, size_t count)
+{
+	struct xsem_edac_priv *priv = dci->pvt_info;
+	u32 msecs;
+
+	if (!data)
+		return -EFAULT;
+
+	if (kstrtouint(data, 0, &msecs))
+		return -EINVAL;
+
+	WRITE_ONCE(priv->report_ms, msecs);
+	if (!msecs)
+		mod_delayed_work(system_wq, &priv->report_work, 0);
+
+	return count;
+}
+
+/**
+ * xsem_error_stats_show - Shows the error statistics
+ * @dci:	Pointer to the edac device struct
+ * @data:	Pointer to user data
+ *
+ * Shows the error counts per module and the correctable error count of
+ * each CRAM frame that had one.
+ * Return: Number of bytes copied.
+ */
+static ssize_t xsem_error_stats_show(struct edac_device_ctl_info *dci,
+				     char *data)
+{
+	struct xsem_edac_priv *priv = dci->pvt_info;
+	struct xsem_frame_stat *fs;
+	unsigned long flags;
+	int len;
+	u32 i;
+
+	spin_lock_irqsave(&priv->stats_lock, flags);
+	len = sysfs_emit(data, "CRAM_CE: %u\nCRAM_UE: %u\nNPI_UE: %u\n"
+			 "Frames_dropped: %u\nFrame_Addr Row_num CE_count\n",
+			 priv->cram_ce_cnt, priv->cram_ue_cnt,
+			 priv->npi_ue_cnt, priv->frames_dropped);
+	for (i = 0; i < priv->nr_frames; i++) {
+		fs = &priv->frames[i];
+		len += sysfs_emit_at(data, len, "0x%X 0x%X %u\n",
+				     fs->frame_addr, fs->row_id, fs->ce_cnt);
+	}
+	spin_unlock_irqrestore(&priv->stats_lock, flags);
+
+	return len;
+}
+
+/**
+ * xsem_error_stats_store - Clear the error statistics
+ * @dci:	Pointer to the edac device struct
+ * @data:	Pointer to user data
+ * @count:	read the size bytes from buffer
+ *
+ * The EDAC core counters are left alone.
+ *
+ * To clear the statistics
+ * echo 0 > /sys/devices/system/edac/versal_xilsem/xsem_error_stats
+ *
+ * Return: count argument if request succeeds, else error code
+ */
+static ssize_t xsem_error_stats_store(struct edac_device_ctl_info *dci,
+				      const char *data, size_t count)
+{
+	struct xsem_edac_priv *priv = dci->pvt_info;
+	unsigned long flags;
+	u32 val;
+
+	if (!data)
+		return -EFAULT;
+
+	if (kstrtouint(data, 0, &val) || val)
+		return -EINVAL;
+
+	spin_lock_irqsave(&priv->stats_lock, flags);
+	priv->cram_ce_cnt = 0;
+	priv->cram_ue_cnt = 0;
+	priv->npi_ue_cnt = 0;
+	priv->frames_dropped = 0;
+	priv->nr_frames = 0;
+	spin_unlock_irqrestore(&priv->stats_lock, flags);
+
+	return count;
+}
+
 /**
  * xsem_handle_error - Handle XilSem error types CE and UE
  * @dci:	Pointer to the edac device controller instance
@@ -577,29 +901,123 @@ static void xsem_geterror_info(void __iomem *base, struct xsem_error_status *p,
 	}
 }
 
+/**
+ * xsem_account_error - Update the error statistics
+ * @priv:	Pointer to the Xilsem private instance data
+ * @p:		Pointer to the Xilsem error status structure
+ * @mask:	mask indicates the error type
+ *
+ * Called with stats_lock held.
+ */
+static void xsem_account_error(struct xsem_edac_priv *priv,
+			       struct xsem_error_status *p, int mask)
+{
+	struct xsem_frame_stat *fs;
+	u32 i;
+
+	if (p->ue_cnt) {
+		if (mask & XILSEM_CRAM_UE_MASK)
+			priv->cram_ue_cnt += p->ue_cnt;
+		else
+			priv->npi_ue_cnt += p->ue_cnt;
+	}
+
+	if (!p->ce_cnt)
+		return;
+
+	priv->cram_ce_cnt += p->ce_cnt;
+	for (i = 0; i < priv->nr_frames; i++) {
+		fs = &priv->frames[i];
+		if (fs->frame_addr == p->ceinfo.frame_addr &&
+		    fs->row_id == p->ceinfo.row_id) {
+			fs->ce_cnt += p->ce_cnt;
+			return;
+		}
+	}
+
+	if (priv->nr_frames == XSEM_FRAME_STATS_MAX) {
+		priv->frames_dropped += p->ce_cnt;
+		return;
+	}
+
+	fs = &priv->frames[priv->nr_frames++];
+	fs->frame_addr = p->ceinfo.frame_addr;
+	fs->row_id = p->ceinfo.row_id;
+	fs->ce_cnt = p->ce_cnt;
+}
+
+/**
+ * xsem_report_work - Report the pending correctable errors
+ * @work:	Pointer to the report work
+ */
+static void xsem_report_work(struct work_struct *work)
+{
+	struct xsem_edac_priv *priv = container_of(to_delayed_work(work),
+						   struct xsem_edac_priv,
+						   report_work);
+	char message[VERSAL_XILSEM_EDAC_MSG_SIZE];
+	struct ecc_error_info pinf;
+	unsigned long flags;
+	u32 count;
+
+	spin_lock_irqsave(&priv->stats_lock, flags);
+	count = priv->pending_ce;
+	pinf = priv->pending_info;
+	priv->pending_ce = 0;
+	spin_unlock_irqrestore(&priv->stats_lock, flags);
+
+	if (!count)
+		return;
+
+	snprintf(message, VERSAL_XILSEM_EDAC_MSG_SIZE,
+		 "\n\rXILSEM CRAM error type :%s\n\r"
+		 "\nCount: [%u]\t Last at Frame_Addr: [0x%X]\t Row_num: [0x%X]\t Bit_loc: [0x%X]\t Qword: [0x%X]\n\r",
+		 "CE", count, pinf.frame_addr, pinf.row_id, pinf.bit_loc,
+		 pinf.qword);
+	edac_device_handle_ce_count(priv->dci, count, 0, 0, message);
+}
+
 /**
  * xsem_err_callback - Handle Correctable and Uncorrectable errors.
  * @payload:	payload data.
  * @data:	controller data.
  *
- * Handles ECC correctable and uncorrectable errors.
+ * Handles ECC correctable and uncorrectable errors. Depending on
+ * report_ms, correctable errors are reported from report_work.
  */
 static void xsem_err_callback(const u32 *payload, void *data)
 {
 	struct edac_device_ctl_info *dci = (struct edac_device_ctl_info *)data;
 	struct xsem_error_status stat;
 	struct xsem_edac_priv *priv;
+	unsigned long flags;
+	u32 report_ms;
 	int event;
 
 	priv = dci->pvt_info;
 	memset(&stat, 0, sizeof(stat));
 	/* Read payload to get the event type */
 	event = payload[2];
-	edac_printk(KERN_INFO, EDAC_DEVICE, "Event received %x\n", event);
+	edac_dbg(1, "Event received %x\n", event);
 	xsem_geterror_info(priv->baseaddr, &stat, event);
 
+	report_ms = READ_ONCE(priv->report_ms);
+	spin_lock_irqsave(&priv->stats_lock, flags);
 	priv->ce_cnt += stat.ce_cnt;
 	priv->ue_cnt += stat.ue_cnt;
+	xsem_account_error(priv, &stat, event);
+	if (stat.ce_cnt && report_ms) {
+		priv->pending_ce += stat.ce_cnt;
+		priv->pending_info = stat.ceinfo;
+		stat.ce_cnt = 0;
+	} else {
+		report_ms = 0;
+	}
+	spin_unlock_irqrestore(&priv->stats_lock, flags);
+
+	if (report_ms)
+		schedule_delayed_work(&priv->report_work,
+				      msecs_to_jiffies(report_ms));
 	xsem_handle_error(dci, &stat);
 }
 
@@ -639,6 +1057,27 @@ static struct edac_dev_sysfs_attribute xsem_edac_sysfs_attributes[] = {
 		},
 		.show = xsem_read_config_show,
 		.store = xsem_read_config_store},
+	{
+		.attr = {
+			.name = "xsem_scan_schedule",
+			.mode = (0644)
+		},
+		.show = xsem_scan_schedule_show,
+		.store = xsem_scan_schedule_store},
+	{
+		.attr = {
+			.name = "xsem_ce_report_ms",
+			.mode = (0644)
+		},
+		.show = xsem_ce_report_ms_show,
+		.store = xsem_ce_report_ms_store},
+	{
+		.attr = {
+			.name = "xsem_error_stats",
+			.mode = (0644)
+		},
+		.show = xsem_error_stats_show,
+		.store = xsem_error_stats_store},
 	{
 		.attr = {.name = NULL}
 	}
@@ -676,6 +1115,12 @@ static int xsem_edac_probe(struct platform_device *pdev)
 	platform_set_drvdata(pdev, dci);
 	dci->dev = &pdev->dev;
 	priv->baseaddr = plmrtca_baseaddr;
+	priv->dci = dci;
+	priv->scan_modules = CRAM_MOD_ID;
+	spin_lock_init(&priv->stats_lock);
+	mutex_init(&priv->sched_lock);
+	INIT_DELAYED_WORK(&priv->report_work, xsem_report_work);
+	INIT_DELAYED_WORK(&priv->scan_work, xsem_scan_work);
 	dci->mod_name = pdev->dev.driver->name;
 	dci->ctl_name = VERSAL_XILSEM_EDAC_STRNG;
 	dci->dev_name = dev_name(&pdev->dev);
@@ -717,12 +1162,17 @@ static int xsem_edac_probe(struct platform_device *pdev)
 static int xsem_edac_remove(struct platform_device *pdev)
 {
 	struct edac_device_ctl_info *dci = platform_get_drvdata(pdev);
+	struct xsem_edac_priv *priv = dci->pvt_info;
 
 	xlnx_unregister_event(PM_NOTIFY_CB, XPM_NODETYPE_EVENT_ERROR_SW_ERR,
 			      XPM_EVENT_ERROR_MASK_XSEM_CRAM_CE_5 |
 			      XPM_EVENT_ERROR_MASK_XSEM_CRAM_UE_6 |
 			      XPM_EVENT_ERROR_MASK_XSEM_NPI_UE_7,
 			      xsem_err_callback, dci);
+	mutex_lock(&priv->sched_lock);
+	xsem_scan_schedule_stop(priv);
+	mutex_unlock(&priv->sched_lock);
+	flush_delayed_work(&priv->report_work);
 	edac_device_del_device(&pdev->dev);
 	edac_device_free_ctl_info(dci);
 
@@ -0,0 +1,282 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Correctable error aggregation for the Xilinx DDR EDAC drivers
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ *
+ * An error storm reports every correctable error to the EDAC core, which
+ * logs each of them from interrupt context. The Synopsys and Versal DDRMC
+ * drivers instead account them here per rank, bank and row range and
+ * report them at most once per XEDAC_STATS_REPORT_MS, the errors seen in
+ * between folded into one report. The counters are shown in
+ * <debugfs>/edac/mc<n>/ce_stats, writing to it clears them.
+ *
+ * A rank going over the ce_threshold sysfs attribute of the controller
+ * bumps ce_threshold_exceeded, which can be polled.
+ */
+
+#include <linux/edac.h>
+#include <linux/fs.h>
+#include <linux/jiffies.h>
+#include <linux/module.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sysfs.h>
+
+#include "edac_module.h"
+#include "xlnx_edac_stats.h"
+
+#define XEDAC_STATS_REPORT_MS	1000
+
+/* Copy of the counters, to print them without holding the lock */
+struct xedac_stats_snap {
+	u64 total;
+	u64 rank[XEDAC_STATS_RANKS];
+	u64 bank[XEDAC_STATS_BANKS];
+	u64 row_hist[XEDAC_STATS_ROW_BUCKETS];
+};
+
+static void xedac_stats_report(struct xedac_stats *stats, u32 count)
+{
+	edac_mc_handle_error(HW_EVENT_ERR_CORRECTED, stats->mci, count,
+			     0, 0, 0, 0, 0, -1,
+			     "Correctable errors since the last report", "");
+}
+
+static void xedac_stats_flush(struct work_struct *work)
+{
+	struct xedac_stats *stats = container_of(to_delayed_work(work),
+						 struct xedac_stats,
+						 flush_work);
+	unsigned long flags;
+	u32 count;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	count = stats->pending;
+	stats->pending = 0;
+	stats->last_report = jiffies;
+	spin_unlock_irqrestore(&stats->lock, flags);
+
+	if (count)
+		xedac_stats_report(stats, count);
+}
+
+static void xedac_stats_notify(struct work_struct *work)
+{
+	struct xedac_stats *stats = container_of(work, struct xedac_stats,
+						 notify_work);
+
+	sysfs_notify(&stats->mci->dev.kobj, NULL, "ce_threshold_exceeded");
+}
+
+/**
+ * xedac_stats_init - Initialize the correctable error counters
+ * @stats:	Counters to initialize.
+ * @mci:	EDAC memory controller instance they belong to.
+ * @row_bits:	Width of the row numbers.
+ */
+void xedac_stats_init(struct xedac_stats *stats, struct mem_ctl_info *mci,
+		      unsigned int row_bits)
+{
+	memset(stats, 0, sizeof(*stats));
+	stats->mci = mci;
+	spin_lock_init(&stats->lock);
+	stats->row_shift = max_t(int, row_bits - ilog2(XEDAC_STATS_ROW_BUCKETS),
+				 0);
+	stats->last_report = jiffies - msecs_to_jiffies(XEDAC_STATS_REPORT_MS);
+	INIT_DELAYED_WORK(&stats->flush_work, xedac_stats_flush);
+	INIT_WORK(&stats->notify_work, xedac_stats_notify);
+}
+EXPORT_SYMBOL_GPL(xedac_stats_init);
+
+/**
+ * xedac_stats_exit - Stop the workers
+ * @stats:	Correctable error counters.
+ *
+ * Called once the controller is removed from the EDAC core and no more
+ * errors are accounted. Errors still held back are dropped.
+ */
+void xedac_stats_exit(struct xedac_stats *stats)
+{
+	cancel_work_sync(&stats->notify_work);
+	cancel_delayed_work_sync(&stats->flush_work);
+}
+EXPORT_SYMBOL_GPL(xedac_stats_exit);
+
+/**
+ * xedac_stats_ce - Account correctable errors
+ * @stats:	Correctable error counters.
+ * @loc:	Location of the errors.
+ * @count:	Number of errors.
+ *
+ * Return: The number of errors the caller reports to the EDAC core now,
+ * including the ones held back before. 0 if the report is deferred.
+ */
+u32 xedac_stats_ce(struct xedac_stats *stats, const struct xedac_ce_loc *loc,
+		   u32 count)
+{
+	unsigned long interval = msecs_to_jiffies(XEDAC_STATS_REPORT_MS);
+	unsigned long flags, delay = 0;
+	bool notify = false;
+	unsigned int bucket;
+	u64 *rank;
+	u32 report;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->total += count;
+
+	rank = &stats->rank[loc->rank % XEDAC_STATS_RANKS];
+	if (stats->threshold && *rank < stats->threshold &&
+	    *rank + count >= stats->threshold) {
+		stats->exceeded++;
+		notify = true;
+	}
+	*rank += count;
+
+	stats->bank[(loc->bankgrp * 8 + loc->bank) % XEDAC_STATS_BANKS] +=
+		count;
+	bucket = min_t(unsigned int, loc->row >> stats->row_shift,
+		       XEDAC_STATS_ROW_BUCKETS - 1);
+	stats->row_hist[bucket] += count;
+
+	stats->pending += count;
+	if (time_before(jiffies, stats->last_report + interval)) {
+		delay = stats->last_report + interval - jiffies;
+		report = 0;
+	} else {
+		report = stats->pending;
+		stats->pending = 0;
+		stats->last_report = jiffies;
+	}
+	spin_unlock_irqrestore(&stats->lock, flags);
+
+	if (!report)
+		schedule_delayed_work(&stats->flush_work, delay);
+
+	if (notify) {
+		edac_mc_printk(stats->mci, KERN_WARNING,
+			       "rank %u over %u correctable errors\n",
+			       loc->rank, stats->threshold);
+		schedule_work(&stats->notify_work);
+	}
+
+	return report;
+}
+EXPORT_SYMBOL_GPL(xedac_stats_ce);
+
+ssize_t xedac_stats_threshold_show(struct xedac_stats *stats, char *buf)
+{
+	return sysfs_emit(buf, "%u\n", READ_ONCE(stats->threshold));
+}
+EXPORT_SYMBOL_GPL(xedac_stats_threshold_show);
+
+ssize_t xedac_stats_threshold_store(struct xedac_stats *stats,
+				    const char *buf, size_t count)
+{
+	unsigned long flags;
+	u32 val;
+	int ret;
+
+	ret = kstrtou32(buf, 0, &val);
+	if (ret)
+		return ret;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->threshold = val;
+	spin_unlock_irqrestore(&stats->lock, flags);
+
+	return count;
+}
+EXPORT_SYMBOL_GPL(xedac_stats_threshold_store);
+
+ssize_t xedac_stats_exceeded_show(struct xedac_stats *stats, char *buf)
+{
+	return sysfs_emit(buf, "%u\n", READ_ONCE(stats->exceeded));
+}
+EXPORT_SYMBOL_GPL(xedac_stats_exceeded_show);
+
+static int xedac_stats_show(struct seq_file *s, void *unused)
+{
+	struct xedac_stats *stats = s->private;
+	unsigned int shift = stats->row_shift;
+	struct xedac_stats_snap *snap;
+	unsigned long flags;
+	unsigned int i;
+
+	snap = kmalloc(sizeof(*snap), GFP_KERNEL);
+	if (!snap)
+		return -ENOMEM;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	snap->total = stats->total;
+	memcpy(snap->rank, stats->rank, sizeof(snap->rank));
+	memcpy(snap->bank, stats->bank, sizeof(snap->bank));
+	memcpy(snap->row_hist, stats->row_hist, sizeof(snap->row_hist));
+	spin_unlock_irqrestore(&stats->lock, flags);
+
+	seq_printf(s, "total: %llu\n", snap->total);
+	for (i = 0; i < XEDAC_STATS_RANKS; i++)
+		seq_printf(s, "rank%u: %llu\n", i, snap->rank[i]);
+	for (i = 0; i < XEDAC_STATS_BANKS; i++)
+		if (snap->bank[i])
+			seq_printf(s, "group%u bank%u: %llu\n", i / 8, i % 8,
+				   snap->bank[i]);
+	for (i = 0; i < XEDAC_STATS_ROW_BUCKETS; i++)
+		if (snap->row_hist[i])
+			seq_printf(s, "rows %u-%u: %llu\n",
+				   i << shift, ((i + 1) << shift) - 1,
+				   snap->row_hist[i]);
+
+	kfree(snap);
+
+	return 0;
+}
+
+static int xedac_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, xedac_stats_show, inode->i_private);
+}
+
+static ssize_t xedac_stats_write(struct file *file, const char __user *buf,
+				 size_t count, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct xedac_stats *stats = s->private;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->total = 0;
+	memset(stats->rank, 0, sizeof(stats->rank));
+	memset(stats->bank, 0, sizeof(stats->bank));
+	memset(stats->row_hist, 0, sizeof(stats->row_hist));
+	stats->exceeded = 0;
+	spin_unlock_irqrestore(&stats->lock, flags);
+
+	return count;
+}
+
+static const struct file_operations xedac_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = xedac_stats_open,
+	.read = seq_read,
+	.write = xedac_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+/**
+ * xedac_stats_debugfs_init - Create the ce_stats debugfs file
+ * @stats:	Correctable error counters.
+ *
+ * The file lives in the debugfs directory of the controller, so it has
+ * to be created once the controller is registered with the EDAC core.
+ */
+void xedac_stats_debugfs_init(struct xedac_stats *stats)
+{
+	edac_debugfs_create_file("ce_stats", 0600, stats->mci->debugfs, stats,
+				 &xedac_stats_fops);
+}
+EXPORT_SYMBOL_GPL(xedac_stats_debugfs_init);
+
+MODULE_DESCRIPTION("Xilinx DDR EDAC correctable error statistics");
+MODULE_LICENSE("GPL");
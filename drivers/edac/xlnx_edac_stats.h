@@ -0,0 +1,80 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Correctable error aggregation for the Xilinx DDR EDAC drivers
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ */
+
+#ifndef __XLNX_EDAC_STATS_H
+#define __XLNX_EDAC_STATS_H
+
+#include <linux/spinlock.h>
+#include <linux/types.h>
+#include <linux/workqueue.h>
+
+struct device;
+struct mem_ctl_info;
+
+#define XEDAC_STATS_RANKS		4
+#define XEDAC_STATS_BANKS		32
+#define XEDAC_STATS_ROW_BUCKETS		32
+
+/**
+ * struct xedac_ce_loc - Location of a correctable error
+ * @rank:	Rank number.
+ * @bankgrp:	Bank group number.
+ * @bank:	Bank number.
+ * @row:	Row number.
+ */
+struct xedac_ce_loc {
+	u32 rank;
+	u32 bankgrp;
+	u32 bank;
+	u32 row;
+};
+
+/**
+ * struct xedac_stats - Correctable error counters of a memory controller
+ * @mci:		EDAC memory controller instance.
+ * @lock:		Protects the fields below.
+ * @total:		Correctable errors seen.
+ * @rank:		Correctable errors per rank.
+ * @bank:		Correctable errors per bank, indexed by bank group * 8
+ *			+ bank.
+ * @row_hist:		Correctable errors per range of rows.
+ * @row_shift:		Shift turning a row number into a @row_hist bucket.
+ * @pending:		Correctable errors not reported to the EDAC core yet.
+ * @last_report:	Time of the last report to the EDAC core, in jiffies.
+ * @threshold:		Errors per rank that raise a notification, 0 if off.
+ * @exceeded:		Ranks that went over @threshold.
+ * @flush_work:		Reports @pending once the rate limit allows it.
+ * @notify_work:	Notifies sysfs pollers of a change of @exceeded.
+ */
+struct xedac_stats {
+	struct mem_ctl_info *mci;
+	spinlock_t lock;
+	u64 total;
+	u64 rank[XEDAC_STATS_RANKS];
+	u64 bank[XEDAC_STATS_BANKS];
+	u64 row_hist[XEDAC_STATS_ROW_BUCKETS];
+	unsigned int row_shift;
+	u32 pending;
+	unsigned long last_report;
+	u32 threshold;
+	u32 exceeded;
+	struct delayed_work flush_work;
+	struct work_struct notify_work;
+};
+
+void xedac_stats_init(struct xedac_stats *stats, struct mem_ctl_info *mci,
+		      unsigned int row_bits);
+void xedac_stats_exit(struct xedac_stats *stats);
+void xedac_stats_debugfs_init(struct xedac_stats *stats);
+u32 xedac_stats_ce(struct xedac_stats *stats, const struct xedac_ce_loc *loc,
+		   u32 count);
+ssize_t xedac_stats_threshold_show(struct xedac_stats *stats, char *buf);
+ssize_t xedac_stats_threshold_store(struct xedac_stats *stats,
+				    const char *buf, size_t count);
+ssize_t xedac_stats_exceeded_show(struct xedac_stats *stats, char *buf);
+
+#endif /* __XLNX_EDAC_STATS_H */
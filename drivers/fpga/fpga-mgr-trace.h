@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * FPGA Manager tracepoints
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM fpga_mgr
+
+#if !defined(__FPGA_MGR_TRACE_H__) || defined(TRACE_HEADER_MULTI_READ)
+#define __FPGA_MGR_TRACE_H__
+
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(fpga_mgr_phase,
+	TP_PROTO(const char *name, const char *phase, u64 ns, u64 bytes),
+	TP_ARGS(name, phase, ns, bytes),
+	TP_STRUCT__entry(
+		__string(name, name)
+		__string(phase, phase)
+		__field(u64, ns)
+		__field(u64, bytes)
+	),
+	TP_fast_assign(
+		__assign_str(name, name);
+		__assign_str(phase, phase);
+		__entry->ns = ns;
+		__entry->bytes = bytes;
+	),
+	TP_printk("%s %s ns=%llu bytes=%llu", __get_str(name),
+		  __get_str(phase), __entry->ns, __entry->bytes)
+);
+
+#endif /* __FPGA_MGR_TRACE_H__ */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE fpga-mgr-trace
+#include <trace/define_trace.h>
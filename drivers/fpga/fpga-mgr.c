@@ -20,6 +20,15 @@
 #include <linux/slab.h>
 #include <linux/scatterlist.h>
 #include <linux/highmem.h>
+#include <linux/ktime.h>
+#include <linux/sizes.h>
+#include <linux/vmalloc.h>
+#include <linux/zlib.h>
+#include <linux/zstd.h>
+#include <asm/unaligned.h>
+
+#define CREATE_TRACE_POINTS
+#include "fpga-mgr-trace.h"
 
 static DEFINE_IDA(fpga_mgr_ida);
 static struct class *fpga_mgr_class;
@@ -28,6 +37,18 @@ struct fpga_mgr_devres {
 	struct fpga_manager *mgr;
 };
 
+/**
+ * struct fpga_mgr_image - firmware image kept in memory by a manager
+ * @node: entry in &fpga_manager.image_cache
+ * @fw: the firmware image
+ * @name: name of the image file on the firmware search path
+ */
+struct fpga_mgr_image {
+	struct list_head node;
+	const struct firmware *fw;
+	char name[];
+};
+
 static inline void fpga_mgr_fpga_remove(struct fpga_manager *mgr)
 {
 	if (mgr->mops->fpga_remove)
@@ -48,6 +69,44 @@ static inline u64 fpga_mgr_status(struct fpga_manager *mgr)
 	return 0;
 }
 
+static const char * const fpga_mgr_phase_str[] = {
+	[FPGA_MGR_PHASE_FIRMWARE] =		"firmware",
+	[FPGA_MGR_PHASE_WRITE_INIT] =		"write_init",
+	[FPGA_MGR_PHASE_WRITE] =		"write",
+	[FPGA_MGR_PHASE_WRITE_COMPLETE] =	"write_complete",
+	[FPGA_MGR_PHASE_COPY] =			"copy",
+	[FPGA_MGR_PHASE_CONFIG] =		"config",
+	[FPGA_MGR_PHASE_BRIDGES_DISABLE] =	"bridges_disable",
+	[FPGA_MGR_PHASE_BRIDGES_ENABLE] =	"bridges_enable",
+	[FPGA_MGR_PHASE_READBACK] =		"readback",
+	[FPGA_MGR_PHASE_DECOMPRESS] =		"decompress",
+};
+
+/**
+ * fpga_mgr_record_phase - Record the duration of a reconfiguration phase
+ * @mgr:	fpga manager
+ * @phase:	the phase that completed
+ * @start:	time the phase started at
+ * @bytes:	number of image bytes processed, 0 if not applicable
+ *
+ * Keep the duration for the stats debugfs file and emit the fpga_mgr_phase
+ * tracepoint. Low level drivers use it for the phases of their write op.
+ */
+void fpga_mgr_record_phase(struct fpga_manager *mgr,
+			   enum fpga_mgr_phase phase, ktime_t start, u64 bytes)
+{
+	u64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	if (phase >= FPGA_MGR_PHASE_MAX)
+		return;
+
+	WRITE_ONCE(mgr->stats[phase].ns, ns);
+	WRITE_ONCE(mgr->stats[phase].bytes, bytes);
+	trace_fpga_mgr_phase(dev_name(&mgr->dev), fpga_mgr_phase_str[phase],
+			     ns, bytes);
+}
+EXPORT_SYMBOL_GPL(fpga_mgr_record_phase);
+
 static inline int fpga_mgr_write(struct fpga_manager *mgr, const char *buf, size_t count)
 {
 	if (mgr->mops->write)
@@ -369,16 +428,26 @@ static int fpga_mgr_buf_load_sg(struct fpga_manager *mgr,
 				struct fpga_image_info *info,
 				struct sg_table *sgt)
 {
+	struct scatterlist *sg;
+	ktime_t start;
+	u64 size = 0;
+	unsigned int i;
 	int ret;
 
 	if (info->flags & FPGA_MGR_USERKEY_ENCRYPTED_BITSTREAM)
 		memcpy(info->key, mgr->key, ENCRYPTED_KEY_LEN);
 
+	for_each_sgtable_sg(sgt, sg, i)
+		size += sg->length;
+
+	start = ktime_get();
 	ret = fpga_mgr_prepare_sg(mgr, info, sgt);
 	if (ret)
 		return ret;
+	fpga_mgr_record_phase(mgr, FPGA_MGR_PHASE_WRITE_INIT, start, size);
 
 	/* Write the FPGA image to the FPGA. */
+	start = ktime_get();
 	mgr->err = 0;
 	mgr->state = FPGA_MGR_STATE_WRITE;
 	if (mgr->mops->write_sg) {
@@ -419,14 +488,22 @@ static int fpga_mgr_buf_load_sg(struct fpga_manager *mgr,
 		mgr->err = ret;
 		return ret;
 	}
+	fpga_mgr_record_phase(mgr, FPGA_MGR_PHASE_WRITE, start, size);
 
-	return fpga_mgr_write_complete(mgr, info);
+	start = ktime_get();
+	ret = fpga_mgr_write_complete(mgr, info);
+	if (!ret)
+		fpga_mgr_record_phase(mgr, FPGA_MGR_PHASE_WRITE_COMPLETE,
+				      start, 0);
+
+	return ret;
 }
 
 static int fpga_mgr_buf_load_mapped(struct fpga_manager *mgr,
 				    struct fpga_image_info *info,
 				    const char *buf, size_t count)
 {
+	ktime_t start = ktime_get();
 	int ret;
 
 	ret = fpga_mgr_parse_header_mapped(mgr, info, buf, count);
@@ -436,6 +513,7 @@ static int fpga_mgr_buf_load_mapped(struct fpga_manager *mgr,
 	ret = fpga_mgr_write_init_buf(mgr, info, buf, count);
 	if (ret)
 		return ret;
+	fpga_mgr_record_phase(mgr, FPGA_MGR_PHASE_WRITE_INIT, start, count);
 
 	if (mgr->mops->skip_header) {
 		buf += info->header_size;
@@ -450,6 +528,7 @@ static int fpga_mgr_buf_load_mapped(struct fpga_manager *mgr,
 	 */
 	mgr->err = 0;
 	mgr->state = FPGA_MGR_STATE_WRITE;
+	start = ktime_get();
 	ret = fpga_mgr_write(mgr, buf, count);
 	if (ret) {
 		dev_err(&mgr->dev, "Error while writing image data to FPGA\n");
@@ -457,10 +536,46 @@ static int fpga_mgr_buf_load_mapped(struct fpga_manager *mgr,
 		mgr->err = ret;
 		return ret;
 	}
+	fpga_mgr_record_phase(mgr, FPGA_MGR_PHASE_WRITE, start, count);
 
-	return fpga_mgr_write_complete(mgr, info);
+	start = ktime_get();
+	ret = fpga_mgr_write_complete(mgr, info);
+	if (!ret)
+		fpga_mgr_record_phase(mgr, FPGA_MGR_PHASE_WRITE_COMPLETE,
+				      start, 0);
+
+	return ret;
 }
 
+#ifdef CONFIG_FPGA_MGR_DECOMPRESS
+static int fpga_mgr_decompress_load(struct fpga_manager *mgr,
+				    struct fpga_image_info *info,
+				    const char *buf, size_t count);
+
+static bool fpga_mgr_image_compressed(const char *buf, size_t count)
+{
+	static const u8 gzip_magic[] = { 0x1f, 0x8b, 0x08 };
+	static const u8 zstd_magic[] = { 0x28, 0xb5, 0x2f, 0xfd };
+
+	return (count > sizeof(gzip_magic) &&
+		!memcmp(buf, gzip_magic, sizeof(gzip_magic))) ||
+	       (count > sizeof(zstd_magic) &&
+		!memcmp(buf, zstd_magic, sizeof(zstd_magic)));
+}
+#else
+static inline int fpga_mgr_decompress_load(struct fpga_manager *mgr,
+					   struct fpga_image_info *info,
+					   const char *buf, size_t count)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline bool fpga_mgr_image_compressed(const char *buf, size_t count)
+{
+	return false;
+}
+#endif /* CONFIG_FPGA_MGR_DECOMPRESS */
+
 /**
  * fpga_mgr_buf_load - load fpga from image in buffer
  * @mgr:	fpga manager
@@ -472,6 +587,7 @@ static int fpga_mgr_buf_load_mapped(struct fpga_manager *mgr,
  * an FPGA ready to be configured, writing the image to it, then doing whatever
  * post-configuration steps necessary.  This code assumes the caller got the
  * mgr pointer from of_fpga_mgr_get() and checked that it is not an error code.
+ * gzip and zstd compressed images are decompressed on the way.
  *
  * Return: 0 on success, negative error code otherwise.
  */
@@ -486,6 +602,9 @@ static int fpga_mgr_buf_load(struct fpga_manager *mgr,
 	int index;
 	int rc;
 
+	if (fpga_mgr_image_compressed(buf, count))
+		return fpga_mgr_decompress_load(mgr, info, buf, count);
+
 	/*
 	 * This is just a fast path if the caller has already created a
 	 * contiguous kernel buffer and the driver doesn't require SG, non-SG
@@ -533,6 +652,306 @@ static int fpga_mgr_buf_load(struct fpga_manager *mgr,
 	return rc;
 }
 
+#ifdef CONFIG_FPGA_MGR_DECOMPRESS
+/* Compressed images are decompressed by chunks of this size */
+#define FPGA_MGR_DECOMP_CHUNK	SZ_1M
+
+#define GZIP_FHCRC		BIT(1)
+#define GZIP_FEXTRA		BIT(2)
+#define GZIP_FNAME		BIT(3)
+#define GZIP_FCOMMENT		BIT(4)
+
+/**
+ * struct fpga_mgr_decomp - state of the decompression of an image
+ * @zstd:	the image is zstd compressed, gzip otherwise
+ * @size:	size of the decompressed image
+ * @wksp:	workspace of the decompressor
+ * @zs:		gzip stream
+ * @dstream:	zstd stream
+ * @in:		zstd input
+ */
+struct fpga_mgr_decomp {
+	bool zstd;
+	size_t size;
+	void *wksp;
+	z_stream zs;
+	zstd_dstream *dstream;
+	zstd_in_buffer in;
+};
+
+static int fpga_mgr_gzip_init(struct fpga_mgr_decomp *d, const u8 *buf,
+			      size_t count)
+{
+	u8 flags = buf[3];
+	size_t pos = 10;
+
+	if (count < pos + 8)
+		return -EINVAL;
+	if (flags & GZIP_FEXTRA)
+		pos += 2 + get_unaligned_le16(buf + pos);
+	if (flags & GZIP_FNAME && pos < count)
+		pos += strnlen(buf + pos, count - pos) + 1;
+	if (flags & GZIP_FCOMMENT && pos < count)
+		pos += strnlen(buf + pos, count - pos) + 1;
+	if (flags & GZIP_FHCRC)
+		pos += 2;
+	if (pos + 8 > count)
+		return -EINVAL;
+
+	/* The trailer ends with the size of the data, modulo 2^32 */
+	d->size = get_unaligned_le32(buf + count - 4);
+	d->wksp = kvmalloc(zlib_inflate_workspacesize(), GFP_KERNEL);
+	if (!d->wksp)
+		return -ENOMEM;
+
+	d->zs.workspace = d->wksp;
+	d->zs.next_in = buf + pos;
+	d->zs.avail_in = count - pos - 8;
+	if (zlib_inflateInit2(&d->zs, -MAX_WBITS) != Z_OK) {
+		kvfree(d->wksp);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int fpga_mgr_zstd_init(struct fpga_mgr_decomp *d, const u8 *buf,
+			      size_t count)
+{
+	zstd_frame_header hdr;
+	size_t wksp_size;
+
+	if (zstd_get_frame_header(&hdr, buf, count))
+		return -EINVAL;
+	if (hdr.frameContentSize == ZSTD_CONTENTSIZE_UNKNOWN ||
+	    hdr.frameContentSize > SIZE_MAX)
+		return -EINVAL;
+
+	/* The workspace holds the window, not the whole image */
+	d->zstd = true;
+	d->size = hdr.frameContentSize;
+	wksp_size = zstd_dstream_workspace_bound(hdr.windowSize);
+	d->wksp = kvmalloc(wksp_size, GFP_KERNEL);
+	if (!d->wksp)
+		return -ENOMEM;
+
+	d->dstream = zstd_init_dstream(hdr.windowSize, d->wksp, wksp_size);
+	if (!d->dstream) {
+		kvfree(d->wksp);
+		return -EINVAL;
+	}
+
+	d->in.src = buf;
+	d->in.size = count;
+	d->in.pos = 0;
+
+	return 0;
+}
+
+static int fpga_mgr_decomp_init(struct fpga_mgr_decomp *d, const char *buf,
+				size_t count)
+{
+	int ret;
+
+	if (buf[0] == 0x1f)
+		ret = fpga_mgr_gzip_init(d, buf, count);
+	else
+		ret = fpga_mgr_zstd_init(d, buf, count);
+	if (ret)
+		return ret;
+
+	if (!d->size) {
+		ret = -EINVAL;
+		if (!d->zstd)
+			zlib_inflateEnd(&d->zs);
+		kvfree(d->wksp);
+	}
+
+	return ret;
+}
+
+static void fpga_mgr_decomp_end(struct fpga_mgr_decomp *d)
+{
+	if (!d->zstd)
+		zlib_inflateEnd(&d->zs);
+	kvfree(d->wksp);
+}
+
+/*
+ * Decompress up to @len bytes into @out. Return the number of bytes
+ * written, less than @len only at the end of the image, or a negative
+ * error code for a corrupted or truncated image.
+ */
+static ssize_t fpga_mgr_decomp_read(struct fpga_mgr_decomp *d, void *out,
+				    size_t len)
+{
+	zstd_out_buffer zout = { .dst = out, .size = len };
+	size_t ret;
+	int rc;
+
+	if (d->zstd) {
+		while (zout.pos < zout.size) {
+			ret = zstd_decompress_stream(d->dstream, &zout, &d->in);
+			if (zstd_is_error(ret))
+				return -EINVAL;
+			if (!ret)
+				break;
+			if (d->in.pos == d->in.size && zout.pos < zout.size)
+				return -EINVAL;
+		}
+
+		return zout.pos;
+	}
+
+	d->zs.next_out = out;
+	d->zs.avail_out = len;
+	while (d->zs.avail_out) {
+		rc = zlib_inflate(&d->zs, Z_SYNC_FLUSH);
+		if (rc == Z_STREAM_END)
+			break;
+		if (rc != Z_OK)
+			return -EINVAL;
+	}
+
+	return len - d->zs.avail_out;
+}
+
+/*
+ * A manager that takes the image through successive write calls, without
+ * looking at a header, gets it chunk by chunk as it is decompressed, so
+ * that decompression and configuration overlap and only a chunk is kept.
+ */
+static bool fpga_mgr_decomp_streamable(struct fpga_manager *mgr)
+{
+	const struct fpga_manager_ops *mops = mgr->mops;
+
+	return mops->write && !mops->write_sg && !mops->parse_header &&
+	       !mops->skip_header &&
+	       mops->initial_header_size <= FPGA_MGR_DECOMP_CHUNK;
+}
+
+static int fpga_mgr_decomp_stream(struct fpga_manager *mgr,
+				  struct fpga_image_info *info,
+				  struct fpga_mgr_decomp *d)
+{
+	ktime_t start = ktime_get();
+	size_t total = 0;
+	ssize_t len;
+	char *chunk;
+	int ret;
+
+	chunk = kvmalloc(FPGA_MGR_DECOMP_CHUNK, GFP_KERNEL);
+	if (!chunk)
+		return -ENOMEM;
+
+	len = fpga_mgr_decomp_read(d, chunk, FPGA_MGR_DECOMP_CHUNK);
+	if (len < 0) {
+		ret = len;
+		goto out;
+	}
+
+	ret = fpga_mgr_write_init_buf(mgr, info, chunk, len);
+	if (ret)
+		goto out;
+	fpga_mgr_record_phase(mgr, FPGA_MGR_PHASE_WRITE_INIT, start, len);
+
+	mgr->err = 0;
+	mgr->state = FPGA_MGR_STATE_WRITE;
+	start = ktime_get();
+	while (len > 0) {
+		ret = fpga_mgr_write(mgr, chunk, len);
+		if (ret)
+			break;
+		total += len;
+
+		len = fpga_mgr_decomp_read(d, chunk, FPGA_MGR_DECOMP_CHUNK);
+		if (len < 0)
+			ret = len;
+	}
+	if (!ret && total != d->size)
+		ret = -EINVAL;
+	if (ret) {
+		dev_err(&mgr->dev, "Error while writing image data to FPGA\n");
+		mgr->state = FPGA_MGR_STATE_WRITE_ERR;
+		mgr->err = ret;
+		goto out;
+	}
+	fpga_mgr_record_phase(mgr, FPGA_MGR_PHASE_WRITE, start, total);
+
+	start = ktime_get();
+	ret = fpga_mgr_write_complete(mgr, info);
+	if (!ret)
+		fpga_mgr_record_phase(mgr, FPGA_MGR_PHASE_WRITE_COMPLETE,
+				      start, 0);
+
+out:
+	kvfree(chunk);
+	return ret;
+}
+
+/*
+ * The other managers need the whole image, which is decompressed into one
+ * buffer before the usual load.
+ */
+static int fpga_mgr_decomp_flat(struct fpga_manager *mgr,
+				struct fpga_image_info *info,
+				struct fpga_mgr_decomp *d)
+{
+	ktime_t start = ktime_get();
+	size_t pos;
+	ssize_t len;
+	char *image;
+	int ret;
+
+	image = vmalloc(d->size);
+	if (!image)
+		return -ENOMEM;
+
+	for (pos = 0; pos < d->size; pos += len) {
+		len = fpga_mgr_decomp_read(d, image + pos,
+					   min_t(size_t, d->size - pos,
+						 FPGA_MGR_DECOMP_CHUNK));
+		if (len <= 0) {
+			ret = len ? len : -EINVAL;
+			goto out;
+		}
+		cond_resched();
+	}
+	fpga_mgr_record_phase(mgr, FPGA_MGR_PHASE_DECOMPRESS, start, d->size);
+
+	ret = fpga_mgr_buf_load(mgr, info, image, d->size);
+
+out:
+	vfree(image);
+	return ret;
+}
+
+static int fpga_mgr_decompress_load(struct fpga_manager *mgr,
+				    struct fpga_image_info *info,
+				    const char *buf, size_t count)
+{
+	struct fpga_mgr_decomp d = { };
+	int ret;
+
+	ret = fpga_mgr_decomp_init(&d, buf, count);
+	if (ret) {
+		dev_err(&mgr->dev, "Invalid compressed image\n");
+		return ret;
+	}
+
+	if (fpga_mgr_decomp_streamable(mgr))
+		ret = fpga_mgr_decomp_stream(mgr, info, &d);
+	else
+		ret = fpga_mgr_decomp_flat(mgr, info, &d);
+	if (ret == -EINVAL)
+		dev_err(&mgr->dev, "Corrupted compressed image\n");
+
+	fpga_mgr_decomp_end(&d);
+
+	return ret;
+}
+#endif /* CONFIG_FPGA_MGR_DECOMPRESS */
+
 static int fpga_dmabuf_load(struct fpga_manager *mgr,
 			    struct fpga_image_info *info)
 {
@@ -566,6 +985,69 @@ static int fpga_dmabuf_load(struct fpga_manager *mgr,
 	return ret;
 }
 
+static struct fpga_mgr_image *
+fpga_mgr_image_find(struct fpga_manager *mgr, const char *image_name)
+{
+	struct fpga_mgr_image *image;
+
+	list_for_each_entry(image, &mgr->image_cache, node)
+		if (!strcmp(image->name, image_name))
+			return image;
+
+	return NULL;
+}
+
+/**
+ * fpga_mgr_image_preload - keep a firmware image in memory
+ * @mgr:	fpga manager
+ * @image_name:	name of image file on the firmware search path
+ *
+ * Request the image once and keep it, so that later loads of @image_name,
+ * e.g. repeated partial reconfigurations of a region, skip the firmware
+ * request.
+ *
+ * Return: 0 on success, negative error code otherwise.
+ */
+static int fpga_mgr_image_preload(struct fpga_manager *mgr,
+				  const char *image_name)
+{
+	struct fpga_mgr_image *image;
+	int ret;
+
+	image = kzalloc(struct_size(image, name, strlen(image_name) + 1),
+			GFP_KERNEL);
+	if (!image)
+		return -ENOMEM;
+
+	strcpy(image->name, image_name);
+	ret = request_firmware(&image->fw, image_name, &mgr->dev);
+	if (ret) {
+		dev_err(&mgr->dev, "Error requesting firmware %s\n",
+			image_name);
+		kfree(image);
+		return ret;
+	}
+
+	mutex_lock(&mgr->image_lock);
+	if (fpga_mgr_image_find(mgr, image_name)) {
+		mutex_unlock(&mgr->image_lock);
+		release_firmware(image->fw);
+		kfree(image);
+		return 0;
+	}
+	list_add(&image->node, &mgr->image_cache);
+	mutex_unlock(&mgr->image_lock);
+
+	return 0;
+}
+
+static void fpga_mgr_image_release(struct fpga_mgr_image *image)
+{
+	list_del(&image->node);
+	release_firmware(image->fw);
+	kfree(image);
+}
+
 /**
  * fpga_mgr_firmware_load - request firmware and load to fpga
  * @mgr:	fpga manager
@@ -573,6 +1055,7 @@ static int fpga_dmabuf_load(struct fpga_manager *mgr,
  * @image_name:	name of image file on the firmware search path
  *
  * Request an FPGA image using the firmware class, then write out to the FPGA.
+ * Images preloaded through the preload attribute are used without a request.
  * Update the state before each step to provide info on what step failed if
  * there is a failure.  This code assumes the caller got the mgr pointer
  * from of_fpga_mgr_get() or fpga_mgr_get() and checked that it is not an error
@@ -585,7 +1068,9 @@ static int fpga_mgr_firmware_load(struct fpga_manager *mgr,
 				  const char *image_name)
 {
 	struct device *dev = &mgr->dev;
+	struct fpga_mgr_image *image;
 	const struct firmware *fw;
+	ktime_t start;
 	int ret;
 
 	dev_info(dev, "writing %s to %s\n", image_name, mgr->name);
@@ -597,6 +1082,18 @@ static int fpga_mgr_firmware_load(struct fpga_manager *mgr,
 	info->flags = mgr->flags;
 	memcpy(info->key, mgr->key, ENCRYPTED_KEY_LEN);
 
+	/* The lock keeps a preloaded image from being evicted meanwhile */
+	mutex_lock(&mgr->image_lock);
+	image = fpga_mgr_image_find(mgr, image_name);
+	if (image) {
+		ret = fpga_mgr_buf_load(mgr, info, image->fw->data,
+					image->fw->size);
+		mutex_unlock(&mgr->image_lock);
+		return ret;
+	}
+	mutex_unlock(&mgr->image_lock);
+
+	start = ktime_get();
 	ret = request_firmware(&fw, image_name, dev);
 	if (ret) {
 		mgr->state = FPGA_MGR_STATE_FIRMWARE_REQ_ERR;
@@ -604,6 +1101,7 @@ static int fpga_mgr_firmware_load(struct fpga_manager *mgr,
 		dev_err(dev, "Error requesting firmware %s\n", image_name);
 		return ret;
 	}
+	fpga_mgr_record_phase(mgr, FPGA_MGR_PHASE_FIRMWARE, start, fw->size);
 
 	ret = fpga_mgr_buf_load(mgr, info, fw->data, fw->size);
 
@@ -750,6 +1248,48 @@ static ssize_t firmware_store(struct device *dev,
 	return count;
 }
 
+static ssize_t preload_store(struct device *dev,
+			     struct device_attribute *attr,
+			     const char *buf, size_t count)
+{
+	struct fpga_manager *mgr = to_fpga_manager(dev);
+	char *image_name;
+	int ret;
+
+	image_name = kstrndup(buf, count, GFP_KERNEL);
+	if (!image_name)
+		return -ENOMEM;
+
+	ret = fpga_mgr_image_preload(mgr, strim(image_name));
+	kfree(image_name);
+	if (ret)
+		return ret;
+
+	return count;
+}
+
+static ssize_t evict_store(struct device *dev,
+			   struct device_attribute *attr,
+			   const char *buf, size_t count)
+{
+	struct fpga_manager *mgr = to_fpga_manager(dev);
+	struct fpga_mgr_image *image;
+	char *image_name;
+
+	image_name = kstrndup(buf, count, GFP_KERNEL);
+	if (!image_name)
+		return -ENOMEM;
+
+	mutex_lock(&mgr->image_lock);
+	image = fpga_mgr_image_find(mgr, strim(image_name));
+	if (image)
+		fpga_mgr_image_release(image);
+	mutex_unlock(&mgr->image_lock);
+	kfree(image_name);
+
+	return image ? count : -ENOENT;
+}
+
 static ssize_t key_show(struct device *dev,
 			struct device_attribute *attr, char *buf)
 {
@@ -795,6 +1335,8 @@ static DEVICE_ATTR_RO(name);
 static DEVICE_ATTR_RO(state);
 static DEVICE_ATTR_RO(status);
 static DEVICE_ATTR_WO(firmware);
+static DEVICE_ATTR_WO(preload);
+static DEVICE_ATTR_WO(evict);
 static DEVICE_ATTR_RW(flags);
 static DEVICE_ATTR_RW(key);
 
@@ -803,6 +1345,8 @@ static struct attribute *fpga_mgr_attrs[] = {
 	&dev_attr_state.attr,
 	&dev_attr_status.attr,
 	&dev_attr_firmware.attr,
+	&dev_attr_preload.attr,
+	&dev_attr_evict.attr,
 	&dev_attr_flags.attr,
 	&dev_attr_key.attr,
 	NULL,
@@ -917,6 +1461,29 @@ static const struct file_operations fpga_mgr_ops_image = {
 	.open = fpga_mgr_read_open,
 	.read = seq_read,
 };
+
+static int fpga_mgr_stats_show(struct seq_file *s, void *data)
+{
+	struct fpga_manager *mgr = s->private;
+	u64 ns, bytes;
+	int i;
+
+	seq_printf(s, "%-16s %12s %12s %8s\n", "phase", "ns", "bytes", "MB/s");
+	for (i = 0; i < FPGA_MGR_PHASE_MAX; i++) {
+		ns = READ_ONCE(mgr->stats[i].ns);
+		bytes = READ_ONCE(mgr->stats[i].bytes);
+		if (!ns)
+			continue;
+
+		/* bytes per nanosecond * 1000 is MB/s */
+		seq_printf(s, "%-16s %12llu %12llu %8llu\n",
+			   fpga_mgr_phase_str[i], ns, bytes,
+			   div64_u64(bytes * 1000, ns));
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(fpga_mgr_stats);
 #endif
 
 static int fpga_dmabuf_fd_get(struct file *file, char __user *argp)
@@ -1000,6 +1567,19 @@ int fpga_mgr_lock(struct fpga_manager *mgr)
 }
 EXPORT_SYMBOL_GPL(fpga_mgr_lock);
 
+/**
+ * fpga_mgr_lock_wait - Lock FPGA manager, waiting until it is free
+ * @mgr:	fpga manager
+ *
+ * Like fpga_mgr_lock(), but sleeps until the current user of the manager
+ * is done with it instead of failing.
+ */
+void fpga_mgr_lock_wait(struct fpga_manager *mgr)
+{
+	mutex_lock(&mgr->ref_mutex);
+}
+EXPORT_SYMBOL_GPL(fpga_mgr_lock_wait);
+
 /**
  * fpga_mgr_unlock - Unlock FPGA manager after done programming
  * @mgr:	fpga manager
@@ -1051,6 +1631,8 @@ fpga_mgr_register_full(struct device *parent, const struct fpga_manager_info *in
 	}
 
 	mutex_init(&mgr->ref_mutex);
+	mutex_init(&mgr->image_lock);
+	INIT_LIST_HEAD(&mgr->image_cache);
 
 	mgr->name = info->name;
 	mgr->mops = info->mops;
@@ -1117,6 +1699,8 @@ fpga_mgr_register_full(struct device *parent, const struct fpga_manager_info *in
 		debugfs_remove_recursive(mgr->dir);
 		goto error_device;
 	}
+	debugfs_create_file("stats", 0444, parent_dir, mgr,
+			    &fpga_mgr_stats_fops);
 #endif
 	dev_info(&mgr->dev, "%s registered\n", mgr->name);
 
@@ -1254,7 +1838,10 @@ EXPORT_SYMBOL_GPL(devm_fpga_mgr_register);
 static void fpga_mgr_dev_release(struct device *dev)
 {
 	struct fpga_manager *mgr = to_fpga_manager(dev);
+	struct fpga_mgr_image *image, *tmp;
 
+	list_for_each_entry_safe(image, tmp, &mgr->image_cache, node)
+		fpga_mgr_image_release(image);
 	ida_free(&fpga_mgr_ida, mgr->dev.id);
 	kfree(mgr);
 }
@@ -79,24 +79,12 @@ static void fpga_region_put(struct fpga_region *region)
 	mutex_unlock(&region->mutex);
 }
 
-/**
- * fpga_region_program_fpga - program FPGA
- *
- * @region: FPGA region
- *
- * Program an FPGA using fpga image info (region->info).
- * If the region has a get_bridges function, the exclusive reference for the
- * bridges will be held if programming succeeds.  This is intended to prevent
- * reprogramming the region until the caller considers it safe to do so.
- * The caller will need to call fpga_bridges_put() before attempting to
- * reprogram the region.
- *
- * Return 0 for success or negative error code.
- */
-int fpga_region_program_fpga(struct fpga_region *region)
+static int fpga_region_program(struct fpga_region *region, bool wait)
 {
 	struct device *dev = &region->dev;
 	struct fpga_image_info *info = region->info;
+	bool locked = false;
+	ktime_t start;
 	int ret;
 
 	region = fpga_region_get(region);
@@ -105,10 +93,13 @@ int fpga_region_program_fpga(struct fpga_region *region)
 		return PTR_ERR(region);
 	}
 
-	ret = fpga_mgr_lock(region->mgr);
-	if (ret) {
-		dev_err(dev, "FPGA manager is busy\n");
-		goto err_put_region;
+	if (!wait) {
+		ret = fpga_mgr_lock(region->mgr);
+		if (ret) {
+			dev_err(dev, "FPGA manager is busy\n");
+			goto err_put_region;
+		}
+		locked = true;
 	}
 
 	/*
@@ -123,11 +114,23 @@ int fpga_region_program_fpga(struct fpga_region *region)
 		}
 	}
 
+	start = ktime_get();
 	ret = fpga_bridges_disable(&region->bridge_list);
 	if (ret) {
 		dev_err(dev, "failed to disable bridges\n");
 		goto err_put_br;
 	}
+	fpga_mgr_record_phase(region->mgr, FPGA_MGR_PHASE_BRIDGES_DISABLE,
+			      start, 0);
+
+	/*
+	 * Waiting for the manager only once the bridges are disabled lets a
+	 * queued region quiesce while another region is being loaded.
+	 */
+	if (!locked) {
+		fpga_mgr_lock_wait(region->mgr);
+		locked = true;
+	}
 
 	ret = fpga_mgr_load(region->mgr, info);
 	if (ret) {
@@ -135,11 +138,14 @@ int fpga_region_program_fpga(struct fpga_region *region)
 		goto err_put_br;
 	}
 
+	start = ktime_get();
 	ret = fpga_bridges_enable(&region->bridge_list);
 	if (ret) {
 		dev_err(dev, "failed to enable region bridges\n");
 		goto err_put_br;
 	}
+	fpga_mgr_record_phase(region->mgr, FPGA_MGR_PHASE_BRIDGES_ENABLE,
+			      start, 0);
 
 	fpga_mgr_unlock(region->mgr);
 	fpga_region_put(region);
@@ -150,14 +156,66 @@ int fpga_region_program_fpga(struct fpga_region *region)
 	if (region->get_bridges)
 		fpga_bridges_put(&region->bridge_list);
 err_unlock_mgr:
-	fpga_mgr_unlock(region->mgr);
+	if (locked)
+		fpga_mgr_unlock(region->mgr);
 err_put_region:
 	fpga_region_put(region);
 
 	return ret;
 }
+
+/**
+ * fpga_region_program_fpga - program FPGA
+ *
+ * @region: FPGA region
+ *
+ * Program an FPGA using fpga image info (region->info).
+ * If the region has a get_bridges function, the exclusive reference for the
+ * bridges will be held if programming succeeds.  This is intended to prevent
+ * reprogramming the region until the caller considers it safe to do so.
+ * The caller will need to call fpga_bridges_put() before attempting to
+ * reprogram the region.
+ *
+ * Return 0 for success or negative error code.
+ */
+int fpga_region_program_fpga(struct fpga_region *region)
+{
+	return fpga_region_program(region, false);
+}
 EXPORT_SYMBOL_GPL(fpga_region_program_fpga);
 
+static void fpga_region_program_work(struct work_struct *work)
+{
+	struct fpga_region *region =
+		container_of(work, struct fpga_region, program_work);
+
+	WRITE_ONCE(region->program_status, fpga_region_program(region, true));
+	sysfs_notify(&region->dev.kobj, NULL, "program_status");
+}
+
+/**
+ * fpga_region_program_fpga_async - program FPGA without waiting
+ *
+ * @region: FPGA region
+ *
+ * Queue the programming of the FPGA using region->info and return. Unlike
+ * fpga_region_program_fpga(), a busy FPGA manager is waited for rather than
+ * reported, so the reconfigurations of several regions can be queued at
+ * once. The result is reported in the program_status sysfs attribute of
+ * the region, which can be polled for completion.
+ *
+ * Return 0 if queued, -EBUSY if the region already has programming queued.
+ */
+int fpga_region_program_fpga_async(struct fpga_region *region)
+{
+	WRITE_ONCE(region->program_status, -EINPROGRESS);
+	if (!queue_work(system_unbound_wq, &region->program_work))
+		return -EBUSY;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(fpga_region_program_fpga_async);
+
 static ssize_t compat_id_show(struct device *dev,
 			      struct device_attribute *attr, char *buf)
 {
@@ -173,8 +231,76 @@ static ssize_t compat_id_show(struct device *dev,
 
 static DEVICE_ATTR_RO(compat_id);
 
+static ssize_t firmware_store(struct device *dev,
+			      struct device_attribute *attr,
+			      const char *buf, size_t count)
+{
+	struct fpga_region *region = to_fpga_region(dev);
+	struct fpga_image_info *info;
+	char *image_name;
+	int ret;
+
+	info = fpga_image_info_alloc(dev);
+	if (!info)
+		return -ENOMEM;
+
+	image_name = kstrndup(buf, count, GFP_KERNEL);
+	if (!image_name) {
+		fpga_image_info_free(info);
+		return -ENOMEM;
+	}
+	info->firmware_name = devm_kstrdup(dev, strim(image_name), GFP_KERNEL);
+	kfree(image_name);
+	if (!info->firmware_name) {
+		fpga_image_info_free(info);
+		return -ENOMEM;
+	}
+
+	if (!mutex_trylock(&region->mutex)) {
+		fpga_image_info_free(info);
+		return -EBUSY;
+	}
+
+	/* Don't replace an image applied by an overlay or still queued */
+	if (READ_ONCE(region->program_status) == -EINPROGRESS ||
+	    (region->info && region->info != region->fw_info)) {
+		mutex_unlock(&region->mutex);
+		fpga_image_info_free(info);
+		return -EBUSY;
+	}
+
+	/* Release the bridges kept by the previous image of this attribute */
+	if (region->fw_info) {
+		fpga_bridges_put(&region->bridge_list);
+		fpga_image_info_free(region->fw_info);
+	}
+	region->info = info;
+	region->fw_info = info;
+	mutex_unlock(&region->mutex);
+
+	ret = fpga_region_program_fpga_async(region);
+	if (ret)
+		return ret;
+
+	return count;
+}
+
+static DEVICE_ATTR_WO(firmware);
+
+static ssize_t program_status_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	struct fpga_region *region = to_fpga_region(dev);
+
+	return sprintf(buf, "%d\n", READ_ONCE(region->program_status));
+}
+
+static DEVICE_ATTR_RO(program_status);
+
 static struct attribute *fpga_region_attrs[] = {
 	&dev_attr_compat_id.attr,
+	&dev_attr_firmware.attr,
+	&dev_attr_program_status.attr,
 	NULL,
 };
 ATTRIBUTE_GROUPS(fpga_region);
@@ -215,6 +341,7 @@ fpga_region_register_full(struct device *parent, const struct fpga_region_info *
 
 	mutex_init(&region->mutex);
 	INIT_LIST_HEAD(&region->bridge_list);
+	INIT_WORK(&region->program_work, fpga_region_program_work);
 
 	region->dev.class = fpga_region_class;
 	region->dev.parent = parent;
@@ -275,6 +402,13 @@ EXPORT_SYMBOL_GPL(fpga_region_register);
  */
 void fpga_region_unregister(struct fpga_region *region)
 {
+	cancel_work_sync(&region->program_work);
+	if (region->fw_info) {
+		fpga_bridges_put(&region->bridge_list);
+		fpga_image_info_free(region->fw_info);
+		region->info = NULL;
+		region->fw_info = NULL;
+	}
 	device_unregister(&region->dev);
 }
 EXPORT_SYMBOL_GPL(fpga_region_unregister);
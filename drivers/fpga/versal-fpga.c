@@ -22,10 +22,22 @@ static int versal_fpga_ops_write_init(struct fpga_manager *mgr,
 static int versal_fpga_ops_write_sg(struct fpga_manager *mgr,
 				    struct sg_table *sgt)
 {
-	dma_addr_t dma_addr;
+	dma_addr_t dma_addr, expected;
+	struct scatterlist *s;
+	unsigned int i;
 	int ret;
 
+	/* The PLM reads the PDI from a single DDR address range */
 	dma_addr = sg_dma_address(sgt->sgl);
+	expected = dma_addr;
+	for_each_sgtable_dma_sg(sgt, s, i) {
+		if (sg_dma_address(s) != expected) {
+			dev_err(&mgr->dev, "PDI is not contiguous in memory\n");
+			return -EINVAL;
+		}
+		expected += sg_dma_len(s);
+	}
+
 	ret = zynqmp_pm_load_pdi(PDI_SRC_DDR, dma_addr);
 
 	return ret;
@@ -34,17 +46,24 @@ static int versal_fpga_ops_write_sg(struct fpga_manager *mgr,
 static int versal_fpga_ops_write(struct fpga_manager *mgr,
 				 const char *buf, size_t size)
 {
+	struct device *dev = mgr->dev.parent;
 	dma_addr_t dma_addr = 0;
 	char *kbuf;
 	int ret;
 
-	kbuf = dma_alloc_coherent(mgr->dev.parent, size, &dma_addr, GFP_KERNEL);
+	/*
+	 * Stage the PDI in cached memory, the copy into an uncached coherent
+	 * buffer dominates the load time of large images.
+	 */
+	kbuf = dma_alloc_noncoherent(dev, size, &dma_addr, DMA_TO_DEVICE,
+				     GFP_KERNEL);
 	if (!kbuf)
 		return -ENOMEM;
 
 	memcpy(kbuf, buf, size);
+	dma_sync_single_for_device(dev, dma_addr, size, DMA_TO_DEVICE);
 	ret = zynqmp_pm_load_pdi(PDI_SRC_DDR, dma_addr);
-	dma_free_coherent(mgr->dev.parent, size, kbuf, dma_addr);
+	dma_free_noncoherent(dev, size, kbuf, dma_addr, DMA_TO_DEVICE);
 
 	return ret;
 }
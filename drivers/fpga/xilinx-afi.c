@@ -7,28 +7,231 @@
 #include <linux/err.h>
 #include <linux/firmware/xlnx-zynqmp.h>
 #include <linux/io.h>
+#include <linux/kernel.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
 #include <linux/reset.h>
 #include <linux/slab.h>
+#include <linux/sysfs.h>
+
+/* AFI FM port registers, only reachable when the port is given in "reg" */
+#define AFIFM_RDCTRL		0x00
+#define AFIFM_RDISSUE		0x04
+#define AFIFM_RDQOS		0x08
+#define AFIFM_WRCTRL		0x14
+#define AFIFM_WRISSUE		0x18
+#define AFIFM_WRQOS		0x1c
+
+#define AFIFM_WIDTH_MASK	0x03
+#define AFIFM_ISSUE_MASK	0x07
+#define AFIFM_QOS_MASK		0x0f
+
+/* FM ports: HPC0, HPC1, HP0 to HP3 and LPD, each with a read and a write id */
+#define AFI_NUM_PORTS		7
+
+enum afi_field {
+	AFI_FIELD_WIDTH,
+	AFI_FIELD_ISSUE,
+	AFI_FIELD_QOS,
+};
 
 /**
  * struct afi_fpga - AFI register description
  * @value: value to be written to the register
  * @regid: Register id for the register to be written
  * @resets: Pointer to the reset control for ps-pl resets.
+ * @lock: Serializes the runtime port configuration
+ * @port_base: Registers of each FM port, NULL when not given in "reg"
+ * @width: Last FABRIC_WIDTH written to the read and write channel of each
+ *	   port, the firmware interface cannot read it back
  */
 struct afi_fpga {
 	u32 value;
 	u32 regid;
 	struct reset_control *resets;
+	struct mutex lock;
+	void __iomem *port_base[AFI_NUM_PORTS];
+	u8 width[AFI_NUM_PORTS][2];
+};
+
+/**
+ * struct afi_port_attr - Runtime tunable field of an FM port
+ * @attr: sysfs attribute
+ * @port: FM port index, as used by the "config-afi" register ids
+ * @wr: The field belongs to the write channel
+ * @field: Field of the channel
+ */
+struct afi_port_attr {
+	struct device_attribute attr;
+	u8 port;
+	u8 wr;
+	u8 field;
+};
+
+#define to_afi_port_attr(a)	container_of(a, struct afi_port_attr, attr)
+
+static const char * const afi_port_names[AFI_NUM_PORTS] = {
+	"hpc0", "hpc1", "hp0", "hp1", "hp2", "hp3", "lpd",
+};
+
+static const u32 afi_field_offset[2][3] = {
+	{ AFIFM_RDCTRL, AFIFM_RDISSUE, AFIFM_RDQOS },
+	{ AFIFM_WRCTRL, AFIFM_WRISSUE, AFIFM_WRQOS },
+};
+
+static const u32 afi_field_mask[3] = {
+	AFIFM_WIDTH_MASK, AFIFM_ISSUE_MASK, AFIFM_QOS_MASK,
+};
+
+/*
+ * The width is exposed in bits and set through the firmware, like the
+ * "config-afi" values, FABRIC_WIDTH being 0 for 128, 1 for 64 and 2 for 32
+ * bits. The issuing capability is exposed as the number of outstanding
+ * commands, the register holds that number minus one. The QoS is the static
+ * priority used while the fabric AxQOS signals are not enabled.
+ */
+static ssize_t afi_port_show(struct device *dev,
+			     struct device_attribute *attr, char *buf)
+{
+	struct afi_fpga *afi_fpga = dev_get_drvdata(dev);
+	struct afi_port_attr *pattr = to_afi_port_attr(attr);
+	void __iomem *base = afi_fpga->port_base[pattr->port];
+	u32 val;
+
+	mutex_lock(&afi_fpga->lock);
+	if (base)
+		val = readl(base + afi_field_offset[pattr->wr][pattr->field]) &
+		      afi_field_mask[pattr->field];
+	else
+		val = afi_fpga->width[pattr->port][pattr->wr];
+	mutex_unlock(&afi_fpga->lock);
+
+	if (pattr->field == AFI_FIELD_WIDTH)
+		val = 128 >> val;
+	else if (pattr->field == AFI_FIELD_ISSUE)
+		val++;
+
+	return sysfs_emit(buf, "%u\n", val);
+}
+
+static ssize_t afi_port_store(struct device *dev,
+			      struct device_attribute *attr,
+			      const char *buf, size_t count)
+{
+	struct afi_fpga *afi_fpga = dev_get_drvdata(dev);
+	struct afi_port_attr *pattr = to_afi_port_attr(attr);
+	void __iomem *base = afi_fpga->port_base[pattr->port];
+	u32 mask = afi_field_mask[pattr->field];
+	u32 offset = afi_field_offset[pattr->wr][pattr->field];
+	u32 val, reg_val;
+	int ret;
+
+	ret = kstrtou32(buf, 0, &val);
+	if (ret)
+		return ret;
+
+	switch (pattr->field) {
+	case AFI_FIELD_WIDTH:
+		if (val != 32 && val != 64 && val != 128)
+			return -EINVAL;
+		val = ilog2(128 / val);
+		break;
+	case AFI_FIELD_ISSUE:
+		if (!val || val > mask + 1)
+			return -EINVAL;
+		val--;
+		break;
+	default:
+		if (val > mask)
+			return -EINVAL;
+		break;
+	}
+
+	mutex_lock(&afi_fpga->lock);
+	if (pattr->field == AFI_FIELD_WIDTH) {
+		ret = zynqmp_pm_afi(pattr->port * 2 + pattr->wr, val);
+		if (!ret)
+			afi_fpga->width[pattr->port][pattr->wr] = val;
+	} else {
+		reg_val = readl(base + offset) & ~mask;
+		writel(reg_val | val, base + offset);
+	}
+	mutex_unlock(&afi_fpga->lock);
+
+	return ret < 0 ? ret : count;
+}
+
+static umode_t afi_port_is_visible(struct kobject *kobj,
+				   struct attribute *attr, int n)
+{
+	struct afi_fpga *afi_fpga = dev_get_drvdata(kobj_to_dev(kobj));
+	struct afi_port_attr *pattr;
+
+	pattr = to_afi_port_attr(container_of(attr, struct device_attribute,
+					      attr));
+	if (pattr->field != AFI_FIELD_WIDTH && !afi_fpga->port_base[pattr->port])
+		return 0;
+
+	return attr->mode;
+}
+
+#define AFI_PORT_ATTR(_port, _name, _wr, _field)			\
+	static struct afi_port_attr afi_attr_##_port##_##_name = {	\
+		.attr = __ATTR(_name, 0644, afi_port_show,		\
+			       afi_port_store),				\
+		.port = _port,						\
+		.wr = _wr,						\
+		.field = _field,					\
+	}
+
+#define AFI_PORT_GROUP(_port, _name)					\
+	AFI_PORT_ATTR(_port, rd_width, 0, AFI_FIELD_WIDTH);		\
+	AFI_PORT_ATTR(_port, wr_width, 1, AFI_FIELD_WIDTH);		\
+	AFI_PORT_ATTR(_port, rd_issuing, 0, AFI_FIELD_ISSUE);		\
+	AFI_PORT_ATTR(_port, wr_issuing, 1, AFI_FIELD_ISSUE);		\
+	AFI_PORT_ATTR(_port, rd_qos, 0, AFI_FIELD_QOS);			\
+	AFI_PORT_ATTR(_port, wr_qos, 1, AFI_FIELD_QOS);			\
+	static struct attribute *afi_port##_port##_attrs[] = {		\
+		&afi_attr_##_port##_rd_width.attr.attr,			\
+		&afi_attr_##_port##_wr_width.attr.attr,			\
+		&afi_attr_##_port##_rd_issuing.attr.attr,		\
+		&afi_attr_##_port##_wr_issuing.attr.attr,		\
+		&afi_attr_##_port##_rd_qos.attr.attr,			\
+		&afi_attr_##_port##_wr_qos.attr.attr,			\
+		NULL,							\
+	};								\
+	static const struct attribute_group afi_port##_port##_group = {	\
+		.name = #_name,						\
+		.attrs = afi_port##_port##_attrs,			\
+		.is_visible = afi_port_is_visible,			\
+	}
+
+AFI_PORT_GROUP(0, hpc0);
+AFI_PORT_GROUP(1, hpc1);
+AFI_PORT_GROUP(2, hp0);
+AFI_PORT_GROUP(3, hp1);
+AFI_PORT_GROUP(4, hp2);
+AFI_PORT_GROUP(5, hp3);
+AFI_PORT_GROUP(6, lpd);
+
+static const struct attribute_group *afi_fpga_groups[] = {
+	&afi_port0_group,
+	&afi_port1_group,
+	&afi_port2_group,
+	&afi_port3_group,
+	&afi_port4_group,
+	&afi_port5_group,
+	&afi_port6_group,
+	NULL,
 };
 
 static int afi_fpga_probe(struct platform_device *pdev)
 {
 	struct afi_fpga *afi_fpga;
 	struct device_node *np = pdev->dev.of_node;
+	struct resource *res;
 	int ret;
 	int i, entries, pairs;
 	u32 reg, val;
@@ -36,8 +239,24 @@ static int afi_fpga_probe(struct platform_device *pdev)
 	afi_fpga = devm_kzalloc(&pdev->dev, sizeof(*afi_fpga), GFP_KERNEL);
 	if (!afi_fpga)
 		return -ENOMEM;
+	mutex_init(&afi_fpga->lock);
 	platform_set_drvdata(pdev, afi_fpga);
 
+	/*
+	 * The FM registers may also be mapped by a syscon for the QoS of a
+	 * DMA, so they are not requested.
+	 */
+	for (i = 0; i < AFI_NUM_PORTS; i++) {
+		res = platform_get_resource_byname(pdev, IORESOURCE_MEM,
+						   afi_port_names[i]);
+		if (!res)
+			continue;
+		afi_fpga->port_base[i] = devm_ioremap(&pdev->dev, res->start,
+						      resource_size(res));
+		if (!afi_fpga->port_base[i])
+			return -ENOMEM;
+	}
+
 	/* Reset PL */
 	afi_fpga->resets = devm_reset_control_array_get_optional_exclusive(&pdev->dev);
 	if (IS_ERR(afi_fpga->resets))
@@ -71,6 +290,8 @@ static int afi_fpga_probe(struct platform_device *pdev)
 				ret);
 			return ret;
 		}
+		if (reg < AFI_NUM_PORTS * 2)
+			afi_fpga->width[reg / 2][reg % 2] = val;
 	}
 
 	reset_control_assert(afi_fpga->resets);
@@ -88,6 +309,7 @@ static struct platform_driver afi_fpga_driver = {
 	.driver = {
 		.name = "afi-fpga",
 		.of_match_table = afi_fpga_ids,
+		.dev_groups = afi_fpga_groups,
 	},
 	.probe = afi_fpga_probe,
 };
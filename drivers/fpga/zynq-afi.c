@@ -6,36 +6,157 @@
 
 #include <linux/err.h>
 #include <linux/io.h>
+#include <linux/kernel.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
+#include <linux/sysfs.h>
 
 /* Registers and special values for doing register-based operations */
 #define AFI_RDCHAN_CTRL_OFFSET	0x00
+#define AFI_RDCHAN_ISSUE_OFFSET	0x04
+#define AFI_RDQOS_OFFSET	0x08
 #define AFI_WRCHAN_CTRL_OFFSET	0x14
+#define AFI_WRCHAN_ISSUE_OFFSET	0x18
+#define AFI_WRQOS_OFFSET	0x1c
 
 #define AFI_BUSWIDTH_MASK	0x01
+#define AFI_ISSUE_MASK		0x07
+#define AFI_QOS_MASK		0x0f
 
 /**
  * struct afi_fpga - AFI register description
  * @membase:	pointer to register struct
  * @afi_width:	AFI bus width to be written
+ * @lock:	serializes the read-modify-write of the registers
  */
 struct zynq_afi_fpga {
 	void __iomem	*membase;
 	u32		afi_width;
+	struct mutex	lock;
 };
 
+/**
+ * struct zynq_afi_attr - Runtime tunable field of the AFI port
+ * @attr:	sysfs attribute
+ * @offset:	offset of the register holding the field
+ * @mask:	mask of the field
+ */
+struct zynq_afi_attr {
+	struct device_attribute	attr;
+	u32			offset;
+	u32			mask;
+};
+
+#define to_zynq_afi_attr(a)	container_of(a, struct zynq_afi_attr, attr)
+
+static void zynq_afi_rmw(struct zynq_afi_fpga *afi_fpga, u32 offset,
+			 u32 mask, u32 val)
+{
+	u32 reg_val;
+
+	mutex_lock(&afi_fpga->lock);
+	reg_val = readl(afi_fpga->membase + offset);
+	reg_val &= ~mask;
+	writel(reg_val | (val & mask), afi_fpga->membase + offset);
+	mutex_unlock(&afi_fpga->lock);
+}
+
+/*
+ * The width is exposed in bits, the register only has a 32-bit enable.
+ * The issuing capability is exposed as the number of outstanding commands,
+ * the register holds that number minus one. The QoS is the static priority
+ * used while the fabric AxQOS signals are not enabled.
+ */
+static ssize_t zynq_afi_show(struct device *dev,
+			     struct device_attribute *attr, char *buf)
+{
+	struct zynq_afi_fpga *afi_fpga = dev_get_drvdata(dev);
+	struct zynq_afi_attr *afi_attr = to_zynq_afi_attr(attr);
+	u32 val;
+
+	val = readl(afi_fpga->membase + afi_attr->offset) & afi_attr->mask;
+	if (afi_attr->mask == AFI_BUSWIDTH_MASK)
+		val = val ? 32 : 64;
+	else if (afi_attr->mask == AFI_ISSUE_MASK)
+		val++;
+
+	return sysfs_emit(buf, "%u\n", val);
+}
+
+static ssize_t zynq_afi_store(struct device *dev,
+			      struct device_attribute *attr,
+			      const char *buf, size_t count)
+{
+	struct zynq_afi_fpga *afi_fpga = dev_get_drvdata(dev);
+	struct zynq_afi_attr *afi_attr = to_zynq_afi_attr(attr);
+	u32 val;
+	int ret;
+
+	ret = kstrtou32(buf, 0, &val);
+	if (ret)
+		return ret;
+
+	switch (afi_attr->mask) {
+	case AFI_BUSWIDTH_MASK:
+		if (val != 32 && val != 64)
+			return -EINVAL;
+		val = val == 32;
+		break;
+	case AFI_ISSUE_MASK:
+		if (!val || val > AFI_ISSUE_MASK + 1)
+			return -EINVAL;
+		val--;
+		break;
+	default:
+		if (val > afi_attr->mask)
+			return -EINVAL;
+		break;
+	}
+
+	zynq_afi_rmw(afi_fpga, afi_attr->offset, afi_attr->mask, val);
+
+	return count;
+}
+
+#define ZYNQ_AFI_ATTR(_name, _offset, _mask)				\
+	struct zynq_afi_attr zynq_afi_attr_##_name = {			\
+		.attr = __ATTR(_name, 0644, zynq_afi_show,		\
+			       zynq_afi_store),				\
+		.offset = _offset,					\
+		.mask = _mask,						\
+	}
+
+static ZYNQ_AFI_ATTR(rd_width, AFI_RDCHAN_CTRL_OFFSET, AFI_BUSWIDTH_MASK);
+static ZYNQ_AFI_ATTR(wr_width, AFI_WRCHAN_CTRL_OFFSET, AFI_BUSWIDTH_MASK);
+static ZYNQ_AFI_ATTR(rd_issuing, AFI_RDCHAN_ISSUE_OFFSET, AFI_ISSUE_MASK);
+static ZYNQ_AFI_ATTR(wr_issuing, AFI_WRCHAN_ISSUE_OFFSET, AFI_ISSUE_MASK);
+static ZYNQ_AFI_ATTR(rd_qos, AFI_RDQOS_OFFSET, AFI_QOS_MASK);
+static ZYNQ_AFI_ATTR(wr_qos, AFI_WRQOS_OFFSET, AFI_QOS_MASK);
+
+static struct attribute *zynq_afi_attrs[] = {
+	&zynq_afi_attr_rd_width.attr.attr,
+	&zynq_afi_attr_wr_width.attr.attr,
+	&zynq_afi_attr_rd_issuing.attr.attr,
+	&zynq_afi_attr_wr_issuing.attr.attr,
+	&zynq_afi_attr_rd_qos.attr.attr,
+	&zynq_afi_attr_wr_qos.attr.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(zynq_afi);
+
 static int zynq_afi_fpga_probe(struct platform_device *pdev)
 {
 	struct zynq_afi_fpga *afi_fpga;
 	struct resource *res;
-	u32 reg_val;
 	u32 val;
 
 	afi_fpga = devm_kzalloc(&pdev->dev, sizeof(*afi_fpga), GFP_KERNEL);
 	if (!afi_fpga)
 		return -ENOMEM;
+	mutex_init(&afi_fpga->lock);
+	platform_set_drvdata(pdev, afi_fpga);
 
 	res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
 	afi_fpga->membase = devm_ioremap_resource(&pdev->dev, res);
@@ -49,14 +170,10 @@ static int zynq_afi_fpga_probe(struct platform_device *pdev)
 		return -EINVAL;
 	}
 
-	reg_val = readl(afi_fpga->membase + AFI_RDCHAN_CTRL_OFFSET);
-	reg_val &= ~AFI_BUSWIDTH_MASK;
-	writel(reg_val | afi_fpga->afi_width,
-	       afi_fpga->membase + AFI_RDCHAN_CTRL_OFFSET);
-	reg_val = readl(afi_fpga->membase + AFI_WRCHAN_CTRL_OFFSET);
-	reg_val &= ~AFI_BUSWIDTH_MASK;
-	writel(reg_val | afi_fpga->afi_width,
-	       afi_fpga->membase + AFI_WRCHAN_CTRL_OFFSET);
+	zynq_afi_rmw(afi_fpga, AFI_RDCHAN_CTRL_OFFSET, AFI_BUSWIDTH_MASK,
+		     afi_fpga->afi_width);
+	zynq_afi_rmw(afi_fpga, AFI_WRCHAN_CTRL_OFFSET, AFI_BUSWIDTH_MASK,
+		     afi_fpga->afi_width);
 
 	return 0;
 }
@@ -71,6 +188,7 @@ static struct platform_driver zynq_afi_fpga_driver = {
 	.driver = {
 		.name = "zynq-afi-fpga",
 		.of_match_table = zynq_afi_fpga_ids,
+		.dev_groups = zynq_afi_groups,
 	},
 	.probe = zynq_afi_fpga_probe,
 };
@@ -7,6 +7,7 @@
 #include <linux/fpga/fpga-mgr.h>
 #include <linux/io.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/of_address.h>
 #include <linux/seq_file.h>
@@ -52,6 +53,12 @@ MODULE_PARM_DESC(readback_type,
 		 "readback_type 0-configuration register read "
 		 "1- configuration data read (default: 0)");
 
+static uint readback_bench;
+module_param(readback_bench, uint, 0644);
+MODULE_PARM_DESC(readback_bench,
+		 "number of configuration data readbacks to time instead of "
+		 "dumping the data (default: 0)");
+
 /**
  * struct zynqmp_configreg - Configuration register offsets
  * @reg:	Name of the configuration register.
@@ -140,6 +147,7 @@ static int zynqmp_fpga_ops_write(struct fpga_manager *mgr,
 	dma_addr_t dma_addr = 0;
 	u32 eemi_flags = 0;
 	size_t dma_size;
+	ktime_t start;
 	u32 status;
 	char *kbuf;
 
@@ -156,10 +164,17 @@ static int zynqmp_fpga_ops_write(struct fpga_manager *mgr,
 	else
 		dma_size = size;
 
-	kbuf = dma_alloc_coherent(priv->dev, dma_size, &dma_addr, GFP_KERNEL);
+	/*
+	 * The PMU firmware needs the whole image in one buffer. Stage it in
+	 * cached memory and clean it once, copying tens of megabytes into
+	 * an uncached coherent buffer is several times slower.
+	 */
+	kbuf = dma_alloc_noncoherent(priv->dev, dma_size, &dma_addr,
+				     DMA_TO_DEVICE, GFP_KERNEL);
 	if (!kbuf)
 		return -ENOMEM;
 
+	start = ktime_get();
 	for (index = 0; index < word_align; index++)
 		kbuf[index] = DUMMY_PAD_BYTE;
 
@@ -172,7 +187,9 @@ static int zynqmp_fpga_ops_write(struct fpga_manager *mgr,
 		eemi_flags |= XILINX_ZYNQMP_PM_FPGA_ENCRYPTION_DEVKEY;
 	}
 
-	wmb(); /* ensure all writes are done before initiate FW call */
+	dma_sync_single_for_device(priv->dev, dma_addr, dma_size,
+				   DMA_TO_DEVICE);
+	fpga_mgr_record_phase(mgr, FPGA_MGR_PHASE_COPY, start, dma_size);
 
 	if (priv->flags & FPGA_MGR_DDR_MEM_AUTH_BITSTREAM)
 		eemi_flags |= XILINX_ZYNQMP_PM_FPGA_AUTHENTICATION_DDR;
@@ -182,14 +199,17 @@ static int zynqmp_fpga_ops_write(struct fpga_manager *mgr,
 	if (priv->flags & FPGA_MGR_PARTIAL_RECONFIG)
 		eemi_flags |= XILINX_ZYNQMP_PM_FPGA_PARTIAL;
 
+	start = ktime_get();
 	if (priv->flags & FPGA_MGR_USERKEY_ENCRYPTED_BITSTREAM)
 		ret = zynqmp_pm_fpga_load(dma_addr, dma_addr + size,
 					  eemi_flags, &status);
 	else
 		ret = zynqmp_pm_fpga_load(dma_addr, size,
 					  eemi_flags, &status);
+	fpga_mgr_record_phase(mgr, FPGA_MGR_PHASE_CONFIG, start, size);
 
-	dma_free_coherent(priv->dev, dma_size, kbuf, dma_addr);
+	dma_free_noncoherent(priv->dev, dma_size, kbuf, dma_addr,
+			     DMA_TO_DEVICE);
 
 	if (status)
 		return status;
@@ -348,6 +368,47 @@ static int zynqmp_fpga_read_cfgreg(struct fpga_manager *mgr,
 	return ret;
 }
 
+/*
+ * Time readback_bench readbacks of the configuration data of the loaded
+ * image and report the throughput, to compare bitstream formats and
+ * compression settings.
+ */
+static int zynqmp_fpga_readback_bench(struct fpga_manager *mgr,
+				      struct seq_file *s, dma_addr_t dma_addr)
+{
+	struct zynqmp_fpga_priv *priv = mgr->priv;
+	u64 ns, min_ns = U64_MAX, max_ns = 0, sum_ns = 0;
+	u32 data_offset;
+	ktime_t start = 0;
+	uint i;
+	int ret;
+
+	for (i = 0; i < readback_bench; i++) {
+		start = ktime_get();
+		ret = zynqmp_pm_fpga_read((priv->size + DUMMY_FRAMES_SIZE) / 4,
+					  dma_addr, readback_type,
+					  &data_offset);
+		if (ret)
+			return ret;
+
+		ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+		min_ns = min(min_ns, ns);
+		max_ns = max(max_ns, ns);
+		sum_ns += ns;
+	}
+	fpga_mgr_record_phase(mgr, FPGA_MGR_PHASE_READBACK, start,
+			      priv->size);
+
+	/* bytes per nanosecond * 1000 is MB/s */
+	seq_printf(s, "readback: %u x %u bytes\n", readback_bench, priv->size);
+	seq_printf(s, "ns: min %llu avg %llu max %llu\n", min_ns,
+		   div64_u64(sum_ns, readback_bench), max_ns);
+	seq_printf(s, "MB/s: %llu\n",
+		   div64_u64((u64)priv->size * readback_bench * 1000, sum_ns));
+
+	return 0;
+}
+
 static int zynqmp_fpga_read_cfgdata(struct fpga_manager *mgr,
 				    struct seq_file *s)
 {
@@ -370,6 +431,11 @@ static int zynqmp_fpga_read_cfgdata(struct fpga_manager *mgr,
 	if (!buf)
 		return -ENOMEM;
 
+	if (readback_bench) {
+		ret = zynqmp_fpga_readback_bench(mgr, s, dma_addr);
+		goto free_dmabuf;
+	}
+
 	seq_puts(s, "zynqMP FPGA Configuration data contents are\n");
 	ret = zynqmp_pm_fpga_read((priv->size + DUMMY_FRAMES_SIZE) / 4,
 				  dma_addr, readback_type, &data_offset);
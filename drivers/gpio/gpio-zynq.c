@@ -96,6 +96,12 @@
 /* GPIO upper 16 bit mask */
 #define ZYNQ_GPIO_UPPER_MASK 0xFFFF0000
 
+/* GPIO lower 16 bit mask */
+#define ZYNQ_GPIO_LOWER_MASK 0x0000FFFF
+
+/* Number of times the status of a bank is rescanned within one interrupt */
+#define ZYNQ_GPIO_IRQ_RESCAN	4
+
 /* set to differentiate zynq from zynqmp, 0=zynqmp, 1=zynq */
 #define ZYNQ_GPIO_QUIRK_IS_ZYNQ	BIT(0)
 #define GPIO_QUIRK_DATA_RO_BUG	BIT(1)
@@ -122,6 +128,8 @@ struct gpio_regs {
  * @p_data:	pointer to platform data
  * @context:	context registers
  * @dirlock:	lock used for direction in/out synchronization
+ * @irq_enabled: per bank mirror of the unmasked interrupts, so the interrupt
+ *		handler does not have to read back the INTMASK registers
  */
 struct zynq_gpio {
 	struct gpio_chip chip;
@@ -131,6 +139,7 @@ struct zynq_gpio {
 	const struct zynq_platform_data *p_data;
 	struct gpio_regs context;
 	spinlock_t dirlock; /* lock */
+	unsigned long irq_enabled[ZYNQMP_GPIO_MAX_BANK];
 };
 
 /**
@@ -214,47 +223,97 @@ static inline void zynq_gpio_get_bank_pin(unsigned int pin_num,
 }
 
 /**
- * zynq_gpio_get_value - Get the state of the specified pin of GPIO device
- * @chip:	gpio_chip instance to be worked on
- * @pin:	gpio pin number within the device
- *
- * This function reads the state of the specified pin of the GPIO device.
+ * zynq_gpio_read_bank - Read the pin states of a bank of GPIO device
+ * @gpio:	gpio device data structure
+ * @bank_num:	bank to read
  *
- * Return: 0 if the pin is low, 1 if pin is high.
+ * Return: the pin states of the bank, one bit per pin.
  */
-static int zynq_gpio_get_value(struct gpio_chip *chip, unsigned int pin)
+static u32 zynq_gpio_read_bank(struct zynq_gpio *gpio, unsigned int bank_num)
 {
-	u32 data;
-	unsigned int bank_num, bank_pin_num;
-	struct zynq_gpio *gpio = gpiochip_get_data(chip);
-
-	zynq_gpio_get_bank_pin(pin, &bank_num, &bank_pin_num, gpio);
-
 	if (gpio_data_ro_bug(gpio)) {
 		if (zynq_gpio_is_zynq(gpio)) {
 			if (bank_num <= 1) {
-				data = readl_relaxed(gpio->base_addr +
+				return readl_relaxed(gpio->base_addr +
 					ZYNQ_GPIO_DATA_RO_OFFSET(bank_num));
 			} else {
-				data = readl_relaxed(gpio->base_addr +
+				return readl_relaxed(gpio->base_addr +
 					ZYNQ_GPIO_DATA_OFFSET(bank_num));
 			}
 		} else {
 			if (bank_num <= 2) {
-				data = readl_relaxed(gpio->base_addr +
+				return readl_relaxed(gpio->base_addr +
 					ZYNQ_GPIO_DATA_RO_OFFSET(bank_num));
 			} else {
-				data = readl_relaxed(gpio->base_addr +
+				return readl_relaxed(gpio->base_addr +
 					ZYNQ_GPIO_DATA_OFFSET(bank_num));
 			}
 		}
-	} else {
-		data = readl_relaxed(gpio->base_addr +
-			ZYNQ_GPIO_DATA_RO_OFFSET(bank_num));
 	}
+
+	return readl_relaxed(gpio->base_addr +
+			     ZYNQ_GPIO_DATA_RO_OFFSET(bank_num));
+}
+
+/**
+ * zynq_gpio_get_value - Get the state of the specified pin of GPIO device
+ * @chip:	gpio_chip instance to be worked on
+ * @pin:	gpio pin number within the device
+ *
+ * This function reads the state of the specified pin of the GPIO device.
+ *
+ * Return: 0 if the pin is low, 1 if pin is high.
+ */
+static int zynq_gpio_get_value(struct gpio_chip *chip, unsigned int pin)
+{
+	u32 data;
+	unsigned int bank_num, bank_pin_num;
+	struct zynq_gpio *gpio = gpiochip_get_data(chip);
+
+	zynq_gpio_get_bank_pin(pin, &bank_num, &bank_pin_num, gpio);
+
+	data = zynq_gpio_read_bank(gpio, bank_num);
+
 	return (data >> bank_pin_num) & 1;
 }
 
+/**
+ * zynq_gpio_get_multiple - Get the state of multiple pins of GPIO device
+ * @chip:	gpio_chip instance to be worked on
+ * @mask:	bitmap of the pins to read
+ * @bits:	bitmap the pin states are returned in
+ *
+ * The data register of a bank is read once for all the requested pins of
+ * that bank, banks without a requested pin are not accessed at all.
+ *
+ * Return: 0 always
+ */
+static int zynq_gpio_get_multiple(struct gpio_chip *chip, unsigned long *mask,
+				  unsigned long *bits)
+{
+	struct zynq_gpio *gpio = gpiochip_get_data(chip);
+	unsigned int bank_num, pin, first, last;
+	u32 data;
+
+	for (bank_num = 0; bank_num < gpio->p_data->max_bank; bank_num++) {
+		first = gpio->p_data->bank_min[bank_num];
+		last = gpio->p_data->bank_max[bank_num] + 1;
+
+		pin = find_next_bit(mask, last, first);
+		if (pin < last) {
+			data = zynq_gpio_read_bank(gpio, bank_num);
+			for_each_set_bit_from(pin, mask, last)
+				__assign_bit(pin, bits,
+					     data & BIT(pin - first));
+		}
+
+		if (gpio->p_data->quirks & GPIO_QUIRK_VERSAL)
+			bank_num = bank_num + VERSAL_UNUSED_BANKS;
+	}
+
+	return 0;
+}
+
 /**
  * zynq_gpio_set_value - Modify the state of the pin with specified value
  * @chip:	gpio_chip instance to be worked on
@@ -292,6 +351,58 @@ static void zynq_gpio_set_value(struct gpio_chip *chip, unsigned int pin,
 	writel_relaxed(state, gpio->base_addr + reg_offset);
 }
 
+/**
+ * zynq_gpio_set_multiple - Modify the state of multiple pins of GPIO device
+ * @chip:	gpio_chip instance to be worked on
+ * @mask:	bitmap of the pins to modify
+ * @bits:	bitmap of the values to set the pins to
+ *
+ * The mask/data registers only cover 16 pins each, so the requested pins of
+ * a bank are collected and written with one access per affected half of the
+ * bank. The pins of a half bank therefore change state at the same time.
+ */
+static void zynq_gpio_set_multiple(struct gpio_chip *chip, unsigned long *mask,
+				   unsigned long *bits)
+{
+	struct zynq_gpio *gpio = gpiochip_get_data(chip);
+	unsigned int bank_num, pin, first, last;
+	u32 bank_mask, bank_data;
+
+	for (bank_num = 0; bank_num < gpio->p_data->max_bank; bank_num++) {
+		first = gpio->p_data->bank_min[bank_num];
+		last = gpio->p_data->bank_max[bank_num] + 1;
+		bank_mask = 0;
+		bank_data = 0;
+
+		pin = first;
+		for_each_set_bit_from(pin, mask, last) {
+			bank_mask |= BIT(pin - first);
+			if (test_bit(pin, bits))
+				bank_data |= BIT(pin - first);
+		}
+
+		/*
+		 * the upper 16 bits of a mask/data register are the inverted
+		 * mask of the data bits held in the lower 16 bits
+		 */
+		if (bank_mask & ZYNQ_GPIO_LOWER_MASK)
+			writel_relaxed(~(bank_mask << ZYNQ_GPIO_MID_PIN_NUM) &
+				       ((bank_data & ZYNQ_GPIO_LOWER_MASK) |
+					ZYNQ_GPIO_UPPER_MASK),
+				       gpio->base_addr +
+				       ZYNQ_GPIO_DATA_LSW_OFFSET(bank_num));
+		if (bank_mask & ZYNQ_GPIO_UPPER_MASK)
+			writel_relaxed(~(bank_mask & ZYNQ_GPIO_UPPER_MASK) &
+				       ((bank_data >> ZYNQ_GPIO_MID_PIN_NUM) |
+					ZYNQ_GPIO_UPPER_MASK),
+				       gpio->base_addr +
+				       ZYNQ_GPIO_DATA_MSW_OFFSET(bank_num));
+
+		if (gpio->p_data->quirks & GPIO_QUIRK_VERSAL)
+			bank_num = bank_num + VERSAL_UNUSED_BANKS;
+	}
+}
+
 /**
  * zynq_gpio_dir_in - Set the direction of the specified GPIO pin as input
  * @chip:	gpio_chip instance to be worked on
@@ -409,6 +520,7 @@ static void zynq_gpio_irq_mask(struct irq_data *irq_data)
 
 	device_pin_num = irq_data->hwirq;
 	zynq_gpio_get_bank_pin(device_pin_num, &bank_num, &bank_pin_num, gpio);
+	clear_bit(bank_pin_num, &gpio->irq_enabled[bank_num]);
 	writel_relaxed(BIT(bank_pin_num),
 		       gpio->base_addr + ZYNQ_GPIO_INTDIS_OFFSET(bank_num));
 }
@@ -430,6 +542,7 @@ static void zynq_gpio_irq_unmask(struct irq_data *irq_data)
 
 	device_pin_num = irq_data->hwirq;
 	zynq_gpio_get_bank_pin(device_pin_num, &bank_num, &bank_pin_num, gpio);
+	set_bit(bank_pin_num, &gpio->irq_enabled[bank_num]);
 	writel_relaxed(BIT(bank_pin_num),
 		       gpio->base_addr + ZYNQ_GPIO_INTEN_OFFSET(bank_num));
 }
@@ -640,12 +753,16 @@ static void zynq_gpio_handle_bank_irq(struct zynq_gpio *gpio,
  * gpio pin number which has triggered an interrupt. It then acks the triggered
  * interrupt and calls the pin specific handler set by the higher layer
  * application for that pin.
+ * Only banks with unmasked interrupts are read, using the software copy of
+ * the interrupt mask. A bank is rescanned a few times after its handlers ran
+ * so that a burst of edges is handled without leaving the parent interrupt.
  * Note: A bug is reported if no handler is set for the gpio pin.
  */
 static void zynq_gpio_irqhandler(struct irq_desc *desc)
 {
-	u32 int_sts, int_enb;
-	unsigned int bank_num;
+	unsigned long int_enb;
+	u32 int_sts;
+	unsigned int bank_num, rescan;
 	struct zynq_gpio *gpio =
 		gpiochip_get_data(irq_desc_get_handler_data(desc));
 	struct irq_chip *irqchip = irq_desc_get_chip(desc);
@@ -653,11 +770,17 @@ static void zynq_gpio_irqhandler(struct irq_desc *desc)
 	chained_irq_enter(irqchip, desc);
 
 	for (bank_num = 0; bank_num < gpio->p_data->max_bank; bank_num++) {
-		int_sts = readl_relaxed(gpio->base_addr +
+		for (rescan = 0; rescan < ZYNQ_GPIO_IRQ_RESCAN; rescan++) {
+			int_enb = READ_ONCE(gpio->irq_enabled[bank_num]);
+			if (!int_enb)
+				break;
+			int_sts = readl_relaxed(gpio->base_addr +
 					ZYNQ_GPIO_INTSTS_OFFSET(bank_num));
-		int_enb = readl_relaxed(gpio->base_addr +
-					ZYNQ_GPIO_INTMASK_OFFSET(bank_num));
-		zynq_gpio_handle_bank_irq(gpio, bank_num, int_sts & ~int_enb);
+			if (!(int_sts & int_enb))
+				break;
+			zynq_gpio_handle_bank_irq(gpio, bank_num,
+						  int_sts & int_enb);
+		}
 		if (gpio->p_data->quirks & GPIO_QUIRK_VERSAL)
 			bank_num = bank_num + VERSAL_UNUSED_BANKS;
 	}
@@ -925,6 +1048,8 @@ static int zynq_gpio_probe(struct platform_device *pdev)
 	chip->parent = &pdev->dev;
 	chip->get = zynq_gpio_get_value;
 	chip->set = zynq_gpio_set_value;
+	chip->get_multiple = zynq_gpio_get_multiple;
+	chip->set_multiple = zynq_gpio_set_multiple;
 	chip->request = zynq_gpio_request;
 	chip->free = zynq_gpio_free;
 	chip->direction_input = zynq_gpio_dir_in;
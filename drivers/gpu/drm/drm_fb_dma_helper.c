@@ -105,20 +105,19 @@ dma_addr_t drm_fb_dma_get_gem_addr(struct drm_framebuffer *fb,
 EXPORT_SYMBOL_GPL(drm_fb_dma_get_gem_addr);
 
 /**
- * drm_fb_dma_sync_non_coherent - Sync GEM object to non-coherent backing
- *	memory
- * @drm: DRM device
+ * drm_fb_dma_sync_non_coherent_dev - Sync GEM object to non-coherent backing
+ *	memory through a given device
+ * @dev: Device the GEM objects were allocated for
  * @old_state: Old plane state
  * @state: New plane state
  *
- * This function can be used by drivers that use damage clips and have
- * DMA GEM objects backed by non-coherent memory. Calling this function
- * in a plane's .atomic_update ensures that all the data in the backing
- * memory have been written to RAM.
+ * Same as drm_fb_dma_sync_non_coherent(), for drivers that allocate their
+ * GEM objects with another device than the DRM device, such as the DMA
+ * engine performing the scanout.
  */
-void drm_fb_dma_sync_non_coherent(struct drm_device *drm,
-				  struct drm_plane_state *old_state,
-				  struct drm_plane_state *state)
+void drm_fb_dma_sync_non_coherent_dev(struct device *dev,
+				      struct drm_plane_state *old_state,
+				      struct drm_plane_state *state)
 {
 	const struct drm_format_info *finfo = state->fb->format;
 	struct drm_atomic_helper_damage_iter iter;
@@ -141,9 +140,29 @@ void drm_fb_dma_sync_non_coherent(struct drm_device *drm,
 			offset = clip.y1 * state->fb->pitches[i];
 
 			nb_bytes = (clip.y2 - clip.y1) * state->fb->pitches[i];
-			dma_sync_single_for_device(drm->dev, daddr + offset,
+			dma_sync_single_for_device(dev, daddr + offset,
 						   nb_bytes, DMA_TO_DEVICE);
 		}
 	}
 }
+EXPORT_SYMBOL_GPL(drm_fb_dma_sync_non_coherent_dev);
+
+/**
+ * drm_fb_dma_sync_non_coherent - Sync GEM object to non-coherent backing
+ *	memory
+ * @drm: DRM device
+ * @old_state: Old plane state
+ * @state: New plane state
+ *
+ * This function can be used by drivers that use damage clips and have
+ * DMA GEM objects backed by non-coherent memory. Calling this function
+ * in a plane's .atomic_update ensures that all the data in the backing
+ * memory have been written to RAM.
+ */
+void drm_fb_dma_sync_non_coherent(struct drm_device *drm,
+				  struct drm_plane_state *old_state,
+				  struct drm_plane_state *state)
+{
+	drm_fb_dma_sync_non_coherent_dev(drm->dev, old_state, state);
+}
 EXPORT_SYMBOL_GPL(drm_fb_dma_sync_non_coherent);
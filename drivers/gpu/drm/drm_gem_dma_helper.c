@@ -50,6 +50,8 @@ static const struct drm_gem_object_funcs drm_gem_dma_default_funcs = {
 	.print_info = drm_gem_dma_object_print_info,
 	.get_sg_table = drm_gem_dma_object_get_sg_table,
 	.vmap = drm_gem_dma_object_vmap,
+	.begin_cpu_access = drm_gem_dma_object_begin_cpu_access,
+	.end_cpu_access = drm_gem_dma_object_end_cpu_access,
 	.mmap = drm_gem_dma_object_mmap,
 	.vm_ops = &drm_gem_dma_vm_ops,
 };
@@ -113,26 +115,8 @@ __drm_gem_dma_create(struct drm_device *drm, size_t size, bool private)
 	return ERR_PTR(ret);
 }
 
-/**
- * drm_gem_dma_create - allocate an object with the given size
- * @drm: DRM device
- * @size: size of the object to allocate
- *
- * This function creates a DMA GEM object and allocates memory as backing store.
- * The allocated memory will occupy a contiguous chunk of bus address space.
- *
- * For devices that are directly connected to the memory bus then the allocated
- * memory will be physically contiguous. For devices that access through an
- * IOMMU, then the allocated memory is not expected to be physically contiguous
- * because having contiguous IOVAs is sufficient to meet a devices DMA
- * requirements.
- *
- * Returns:
- * A struct drm_gem_dma_object * on success or an ERR_PTR()-encoded negative
- * error code on failure.
- */
-struct drm_gem_dma_object *drm_gem_dma_create(struct drm_device *drm,
-					      size_t size)
+static struct drm_gem_dma_object *
+__drm_gem_dma_alloc(struct drm_device *drm, size_t size, bool noncoherent)
 {
 	struct drm_gem_dma_object *dma_obj;
 	int ret;
@@ -143,6 +127,9 @@ struct drm_gem_dma_object *drm_gem_dma_create(struct drm_device *drm,
 	if (IS_ERR(dma_obj))
 		return dma_obj;
 
+	if (noncoherent)
+		dma_obj->map_noncoherent = true;
+
 	if (dma_obj->map_noncoherent) {
 		dma_obj->vaddr = dma_alloc_noncoherent(drm->dev, size,
 						       &dma_obj->dma_addr,
@@ -166,8 +153,58 @@ struct drm_gem_dma_object *drm_gem_dma_create(struct drm_device *drm,
 	drm_gem_object_put(&dma_obj->base);
 	return ERR_PTR(ret);
 }
+
+/**
+ * drm_gem_dma_create - allocate an object with the given size
+ * @drm: DRM device
+ * @size: size of the object to allocate
+ *
+ * This function creates a DMA GEM object and allocates memory as backing store.
+ * The allocated memory will occupy a contiguous chunk of bus address space.
+ *
+ * For devices that are directly connected to the memory bus then the allocated
+ * memory will be physically contiguous. For devices that access through an
+ * IOMMU, then the allocated memory is not expected to be physically contiguous
+ * because having contiguous IOVAs is sufficient to meet a devices DMA
+ * requirements.
+ *
+ * Returns:
+ * A struct drm_gem_dma_object * on success or an ERR_PTR()-encoded negative
+ * error code on failure.
+ */
+struct drm_gem_dma_object *drm_gem_dma_create(struct drm_device *drm,
+					      size_t size)
+{
+	return __drm_gem_dma_alloc(drm, size, false);
+}
 EXPORT_SYMBOL_GPL(drm_gem_dma_create);
 
+/**
+ * drm_gem_dma_create_noncoherent - allocate an object backed by cacheable
+ *	memory
+ * @drm: DRM device
+ * @size: size of the object to allocate
+ *
+ * This function is the same as drm_gem_dma_create(), except that the backing
+ * store is always allocated non-coherent, as if the driver had set
+ * &drm_gem_dma_object.map_noncoherent. The CPU mapping of the buffer is then
+ * cached, which is much faster for software rendering and read back, and
+ * the CPU caches must be written back before the device reads the buffer.
+ * For scanout this is done by calling drm_fb_dma_sync_non_coherent() on the
+ * damaged area of the plane, and for other users of the buffer by the
+ * DMA_BUF_IOCTL_SYNC ioctl on its dma-buf.
+ *
+ * Returns:
+ * A struct drm_gem_dma_object * on success or an ERR_PTR()-encoded negative
+ * error code on failure.
+ */
+struct drm_gem_dma_object *
+drm_gem_dma_create_noncoherent(struct drm_device *drm, size_t size)
+{
+	return __drm_gem_dma_alloc(drm, size, true);
+}
+EXPORT_SYMBOL_GPL(drm_gem_dma_create_noncoherent);
+
 /**
  * drm_gem_dma_create_with_handle - allocate an object with the given size and
  *     return a GEM handle to it
@@ -551,6 +588,59 @@ int drm_gem_dma_mmap(struct drm_gem_dma_object *dma_obj, struct vm_area_struct *
 }
 EXPORT_SYMBOL_GPL(drm_gem_dma_mmap);
 
+/**
+ * drm_gem_dma_begin_cpu_access - prepare a DMA GEM object for CPU access
+ * @dma_obj: DMA GEM object
+ * @dir: direction of the access
+ *
+ * Hand a buffer backed by non-coherent memory over to the CPU. The device
+ * only ever reads these buffers, so there is nothing to invalidate, but this
+ * keeps the ownership of the buffer balanced for the DMA API. Drivers using
+ * the DMA GEM helpers should call this through
+ * drm_gem_dma_object_begin_cpu_access().
+ *
+ * Returns:
+ * 0, the sync cannot fail.
+ */
+int drm_gem_dma_begin_cpu_access(struct drm_gem_dma_object *dma_obj,
+				 enum dma_data_direction dir)
+{
+	if (dma_obj->map_noncoherent && !dma_obj->base.import_attach)
+		dma_sync_single_for_cpu(dma_obj->base.dev->dev,
+					dma_obj->dma_addr, dma_obj->base.size,
+					DMA_TO_DEVICE);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(drm_gem_dma_begin_cpu_access);
+
+/**
+ * drm_gem_dma_end_cpu_access - write back the CPU accesses to a DMA GEM object
+ * @dma_obj: DMA GEM object
+ * @dir: direction of the access
+ *
+ * Write the CPU caches back to a buffer backed by non-coherent memory, unless
+ * the CPU only read it. This covers the whole buffer, scanout of buffers
+ * only written through their DRM mmap() is better served by damage clips and
+ * drm_fb_dma_sync_non_coherent(). Drivers using the DMA GEM helpers should
+ * call this through drm_gem_dma_object_end_cpu_access().
+ *
+ * Returns:
+ * 0, the sync cannot fail.
+ */
+int drm_gem_dma_end_cpu_access(struct drm_gem_dma_object *dma_obj,
+			       enum dma_data_direction dir)
+{
+	if (dma_obj->map_noncoherent && !dma_obj->base.import_attach &&
+	    dir != DMA_FROM_DEVICE)
+		dma_sync_single_for_device(dma_obj->base.dev->dev,
+					   dma_obj->dma_addr,
+					   dma_obj->base.size, DMA_TO_DEVICE);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(drm_gem_dma_end_cpu_access);
+
 /**
  * drm_gem_dma_prime_import_sg_table_vmap - PRIME import another driver's
  *	scatter/gather table and get the virtual address of the buffer
@@ -42,6 +42,11 @@
 
 MODULE_IMPORT_NS(DMA_BUF);
 
+static unsigned int drm_prime_import_cache;
+module_param_named(prime_import_cache, drm_prime_import_cache, uint, 0600);
+MODULE_PARM_DESC(prime_import_cache,
+		 "Imported buffers kept attached per file (default: 0 = disabled)");
+
 /**
  * DOC: overview and lifetime rules
  *
@@ -83,6 +88,17 @@ MODULE_IMPORT_NS(DMA_BUF);
  * retain a weak reference, which is cleaned up when the corresponding object is
  * released.
  *
+ * Import cache: Userspace that passes the same dma-buf every frame, such as a
+ * compositor scanning out V4L2 capture buffers, usually closes the handle once
+ * the frame has been displayed, which frees the importing GEM object and
+ * detaches from the exporter. The prime_import_cache module parameter sets how
+ * many imported objects each file keeps a full reference to after their last
+ * handle is gone. Importing one of them again only creates a new handle, the
+ * attachment and its mapping are reused. The cache is per file, so it will
+ * never hand out an object another client imported, and it is emptied when the
+ * file is closed. Cached objects also keep their &dma_buf alive, which is why
+ * the cache is disabled by default.
+ *
  * Self-importing: If userspace is using PRIME as a replacement for flink then
  * it will get a fd->handle request for a GEM object that it created.  Drivers
  * should detect this situation and return back the underlying object from the
@@ -98,6 +114,11 @@ struct drm_prime_member {
 	struct rb_node handle_rb;
 };
 
+struct drm_prime_import {
+	struct drm_gem_object *obj;
+	struct list_head lru;
+};
+
 static int drm_prime_add_buf_handle(struct drm_prime_file_private *prime_fpriv,
 				    struct dma_buf *dma_buf, uint32_t handle)
 {
@@ -224,12 +245,89 @@ void drm_prime_init_file_private(struct drm_prime_file_private *prime_fpriv)
 	mutex_init(&prime_fpriv->lock);
 	prime_fpriv->dmabufs = RB_ROOT;
 	prime_fpriv->handles = RB_ROOT;
+	INIT_LIST_HEAD(&prime_fpriv->imports);
+	prime_fpriv->num_imports = 0;
 }
 
 void drm_prime_destroy_file_private(struct drm_prime_file_private *prime_fpriv)
 {
+	struct drm_prime_import *imp, *tmp;
+
 	/* by now drm_gem_release should've made sure the list is empty */
 	WARN_ON(!RB_EMPTY_ROOT(&prime_fpriv->dmabufs));
+
+	list_for_each_entry_safe(imp, tmp, &prime_fpriv->imports, lru) {
+		drm_gem_object_put(imp->obj);
+		kfree(imp);
+	}
+	INIT_LIST_HEAD(&prime_fpriv->imports);
+	prime_fpriv->num_imports = 0;
+}
+
+/*
+ * Returns a new reference to the object that imported @dma_buf for this file
+ * if it is still in the import cache, moving it to the head of the LRU.
+ */
+static struct drm_gem_object *
+drm_prime_lookup_import(struct drm_prime_file_private *prime_fpriv,
+			struct dma_buf *dma_buf)
+{
+	struct drm_prime_import *imp;
+
+	list_for_each_entry(imp, &prime_fpriv->imports, lru) {
+		if (imp->obj->import_attach->dmabuf != dma_buf)
+			continue;
+
+		list_move(&imp->lru, &prime_fpriv->imports);
+		drm_gem_object_get(imp->obj);
+		return imp->obj;
+	}
+
+	return NULL;
+}
+
+/*
+ * Adds a freshly imported object to the import cache. Returns the entry that
+ * was evicted to make room, which the caller frees with
+ * drm_prime_free_import() once it has dropped the locks.
+ */
+static struct drm_prime_import *
+drm_prime_add_import(struct drm_prime_file_private *prime_fpriv,
+		     struct drm_gem_object *obj)
+{
+	unsigned int max = READ_ONCE(drm_prime_import_cache);
+	struct drm_prime_import *imp, *old = NULL;
+
+	/* self-imports are our own objects, there is nothing to keep */
+	if (!max || !obj->import_attach)
+		return NULL;
+
+	imp = kmalloc(sizeof(*imp), GFP_KERNEL);
+	if (!imp)
+		return NULL;
+
+	if (prime_fpriv->num_imports >= max) {
+		old = list_last_entry(&prime_fpriv->imports,
+				      struct drm_prime_import, lru);
+		list_del(&old->lru);
+		prime_fpriv->num_imports--;
+	}
+
+	drm_gem_object_get(obj);
+	imp->obj = obj;
+	list_add(&imp->lru, &prime_fpriv->imports);
+	prime_fpriv->num_imports++;
+
+	return old;
+}
+
+static void drm_prime_free_import(struct drm_prime_import *imp)
+{
+	if (!imp)
+		return;
+
+	drm_gem_object_put(imp->obj);
+	kfree(imp);
 }
 
 /**
@@ -301,6 +399,7 @@ int drm_gem_prime_fd_to_handle(struct drm_device *dev,
 			       struct drm_file *file_priv, int prime_fd,
 			       uint32_t *handle)
 {
+	struct drm_prime_import *evicted = NULL;
 	struct dma_buf *dma_buf;
 	struct drm_gem_object *obj;
 	int ret;
@@ -316,15 +415,20 @@ int drm_gem_prime_fd_to_handle(struct drm_device *dev,
 	if (ret == 0)
 		goto out_put;
 
-	/* never seen this one, need to import */
 	mutex_lock(&dev->object_name_lock);
-	if (dev->driver->gem_prime_import)
-		obj = dev->driver->gem_prime_import(dev, dma_buf);
-	else
-		obj = drm_gem_prime_import(dev, dma_buf);
-	if (IS_ERR(obj)) {
-		ret = PTR_ERR(obj);
-		goto out_unlock;
+	obj = drm_prime_lookup_import(&file_priv->prime, dma_buf);
+	if (!obj) {
+		/* never seen this one, need to import */
+		if (dev->driver->gem_prime_import)
+			obj = dev->driver->gem_prime_import(dev, dma_buf);
+		else
+			obj = drm_gem_prime_import(dev, dma_buf);
+		if (IS_ERR(obj)) {
+			ret = PTR_ERR(obj);
+			goto out_unlock;
+		}
+
+		evicted = drm_prime_add_import(&file_priv->prime, obj);
 	}
 
 	if (obj->dma_buf) {
@@ -346,6 +450,7 @@ int drm_gem_prime_fd_to_handle(struct drm_device *dev,
 	if (ret)
 		goto fail;
 
+	drm_prime_free_import(evicted);
 	dma_buf_put(dma_buf);
 
 	return 0;
@@ -355,6 +460,7 @@ int drm_gem_prime_fd_to_handle(struct drm_device *dev,
 	 * to detach.. which seems ok..
 	 */
 	drm_gem_handle_delete(file_priv, *handle);
+	drm_prime_free_import(evicted);
 	dma_buf_put(dma_buf);
 	return ret;
 
@@ -362,6 +468,7 @@ int drm_gem_prime_fd_to_handle(struct drm_device *dev,
 	mutex_unlock(&dev->object_name_lock);
 out_put:
 	mutex_unlock(&file_priv->prime.lock);
+	drm_prime_free_import(evicted);
 	dma_buf_put(dma_buf);
 	return ret;
 }
@@ -702,6 +809,52 @@ void drm_gem_dmabuf_vunmap(struct dma_buf *dma_buf, struct iosys_map *map)
 }
 EXPORT_SYMBOL(drm_gem_dmabuf_vunmap);
 
+/**
+ * drm_gem_dmabuf_begin_cpu_access - dma_buf begin_cpu_access implementation
+ *	for GEM
+ * @dma_buf: buffer to be accessed
+ * @dir: direction of the access
+ *
+ * This can be used as the &dma_buf_ops.begin_cpu_access callback. Calls into
+ * &drm_gem_object_funcs.begin_cpu_access for device specific handling.
+ *
+ * Returns 0 on success or a negative errno code otherwise.
+ */
+int drm_gem_dmabuf_begin_cpu_access(struct dma_buf *dma_buf,
+				    enum dma_data_direction dir)
+{
+	struct drm_gem_object *obj = dma_buf->priv;
+
+	if (!obj->funcs->begin_cpu_access)
+		return 0;
+
+	return obj->funcs->begin_cpu_access(obj, dir);
+}
+EXPORT_SYMBOL(drm_gem_dmabuf_begin_cpu_access);
+
+/**
+ * drm_gem_dmabuf_end_cpu_access - dma_buf end_cpu_access implementation for
+ *	GEM
+ * @dma_buf: buffer that was accessed
+ * @dir: direction of the access
+ *
+ * This can be used as the &dma_buf_ops.end_cpu_access callback. Calls into
+ * &drm_gem_object_funcs.end_cpu_access for device specific handling.
+ *
+ * Returns 0 on success or a negative errno code otherwise.
+ */
+int drm_gem_dmabuf_end_cpu_access(struct dma_buf *dma_buf,
+				  enum dma_data_direction dir)
+{
+	struct drm_gem_object *obj = dma_buf->priv;
+
+	if (!obj->funcs->end_cpu_access)
+		return 0;
+
+	return obj->funcs->end_cpu_access(obj, dir);
+}
+EXPORT_SYMBOL(drm_gem_dmabuf_end_cpu_access);
+
 /**
  * drm_gem_prime_mmap - PRIME mmap function for GEM drivers
  * @obj: GEM object
@@ -798,6 +951,8 @@ static const struct dma_buf_ops drm_gem_prime_dmabuf_ops =  {
 	.mmap = drm_gem_dmabuf_mmap,
 	.vmap = drm_gem_dmabuf_vmap,
 	.vunmap = drm_gem_dmabuf_vunmap,
+	.begin_cpu_access = drm_gem_dmabuf_begin_cpu_access,
+	.end_cpu_access = drm_gem_dmabuf_end_cpu_access,
 };
 
 /**
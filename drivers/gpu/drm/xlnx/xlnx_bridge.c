@@ -238,6 +238,34 @@ int xlnx_bridge_set_timing(struct xlnx_bridge *bridge, struct videomode *vm)
 }
 EXPORT_SYMBOL(xlnx_bridge_set_timing);
 
+/**
+ * xlnx_bridge_set_vblank - Change the vertical blanking of the video timing
+ * @bridge: bridge to set
+ * @vm: Videomode
+ *
+ * Update the vertical front porch of the timing programmed by
+ * xlnx_bridge_set_timing() while the timing generator keeps running. The
+ * other fields of @vm are expected to match the current timing, and the new
+ * blanking takes effect at a frame boundary.
+ *
+ * Return: 0 on success. -ENOENT if no callback, -EFAULT if in error state,
+ * or return code from callback.
+ */
+int xlnx_bridge_set_vblank(struct xlnx_bridge *bridge, struct videomode *vm)
+{
+	if (!bridge)
+		return 0;
+
+	if (helper.error)
+		return -EFAULT;
+
+	if (bridge->set_vblank)
+		return bridge->set_vblank(bridge, vm);
+
+	return -ENOENT;
+}
+EXPORT_SYMBOL(xlnx_bridge_set_vblank);
+
 /**
  * of_xlnx_bridge_get - Get the corresponding Xlnx bridge instance
  * @bridge_np: The device node of the bridge device
@@ -35,6 +35,8 @@ struct xlnx_bridge_debugfs_file;
  * @set_output: callback to set the output
  * @get_output_fmts: callback to get supported output formats.
  * @set_timing: callback to set timing in connected video timing controller.
+ * @set_vblank: callback to change the vertical blanking of running timing
+ *		without stopping the video timing controller.
  * @debugfs_file: for debugfs support
  * @extra_name: name to distinguish the bridges which share the same of_node
  */
@@ -53,6 +55,7 @@ struct xlnx_bridge {
 	int (*get_output_fmts)(struct xlnx_bridge *bridge,
 			       const u32 **fmts, u32 *count);
 	int (*set_timing)(struct xlnx_bridge *bridge, struct videomode *vm);
+	int (*set_vblank)(struct xlnx_bridge *bridge, struct videomode *vm);
 	struct xlnx_bridge_debugfs_file *debugfs_file;
 	char *extra_name;
 };
@@ -82,6 +85,7 @@ int xlnx_bridge_set_output(struct xlnx_bridge *bridge,
 int xlnx_bridge_get_output_fmts(struct xlnx_bridge *bridge,
 				const u32 **fmts, u32 *count);
 int xlnx_bridge_set_timing(struct xlnx_bridge *bridge, struct videomode *vm);
+int xlnx_bridge_set_vblank(struct xlnx_bridge *bridge, struct videomode *vm);
 struct xlnx_bridge *of_xlnx_bridge_get(struct device_node *bridge_np);
 void of_xlnx_bridge_put(struct xlnx_bridge *bridge);
 
@@ -156,6 +160,14 @@ static inline int xlnx_bridge_set_timing(struct xlnx_bridge *bridge,
 	return 0;
 }
 
+static inline int xlnx_bridge_set_vblank(struct xlnx_bridge *bridge,
+					 struct videomode *vm)
+{
+	if (bridge)
+		return -ENODEV;
+	return 0;
+}
+
 static inline struct xlnx_bridge *
 of_xlnx_bridge_get(struct device_node *bridge_np)
 {
@@ -16,11 +16,16 @@
  * GNU General Public License for more details.
  */
 
+#include <drm/drm_atomic.h>
 #include <drm/drm_drv.h>
 #include <drm/drm_crtc.h>
+#include <drm/drm_print.h>
+#include <drm/drm_vblank.h>
+#include <drm/drm_vblank_work.h>
 
 #include <linux/list.h>
 #include <linux/dma-mapping.h>
+#include <linux/math64.h>
 
 #include "xlnx_crtc.h"
 #include "xlnx_drv.h"
@@ -37,6 +42,16 @@
  * even though many of them are optional.
  * The CRTC helper simply walks through the registered CRTC device,
  * and call the callbacks.
+ *
+ * CRTC drivers can also expose the PRESENT_VBLANK and PRESENT_TIME
+ * properties, which hold back the hardware programming of a commit until
+ * the vblank before the one it is to be shown at. The target is either an
+ * absolute vblank count, as reported in the sequence of the vblank and flip
+ * events, or a CLOCK_MONOTONIC time in ns that is rounded to the nearest
+ * vblank. A target that already passed is shown as soon as possible, and
+ * the target is consumed by the commit that carries it. Userspace can then
+ * queue a frame for a given presentation time and only be woken up by the
+ * flip event of that frame.
  */
 
 /**
@@ -53,6 +68,9 @@ struct xlnx_crtc_helper {
 
 #define XLNX_CRTC_MAX_HEIGHT_WIDTH	INT_MAX
 
+/* Commits are never held back for longer than that many vblanks */
+#define XLNX_CRTC_PRESENT_MAX_VBLANKS	256
+
 unsigned int xlnx_crtc_helper_get_align(struct xlnx_crtc_helper *helper)
 {
 	struct xlnx_crtc *crtc;
@@ -159,6 +177,26 @@ u32 xlnx_crtc_helper_get_cursor_height(struct xlnx_crtc_helper *helper)
 
 	return height;
 }
+
+/*
+ * GEM buffers are shared by all CRTCs of the device, so a separate DMA
+ * device is only usable when every CRTC scans out through the same one.
+ */
+struct device *xlnx_crtc_helper_get_dma_dev(struct xlnx_crtc_helper *helper)
+{
+	struct xlnx_crtc *crtc;
+	struct device *dev = NULL, *tmp;
+
+	list_for_each_entry(crtc, &helper->xlnx_crtcs, list) {
+		tmp = crtc->get_dma_dev ? crtc->get_dma_dev(crtc) : NULL;
+		if (!tmp || (dev && dev != tmp))
+			return NULL;
+		dev = tmp;
+	}
+
+	return dev;
+}
+
 struct xlnx_crtc_helper *xlnx_crtc_helper_init(struct drm_device *drm)
 {
 	struct xlnx_crtc_helper *helper;
@@ -187,6 +225,169 @@ void xlnx_crtc_helper_fini(struct drm_device *drm,
 	devm_kfree(drm->dev, helper);
 }
 
+static void xlnx_crtc_present_work(struct kthread_work *work)
+{
+	/* The work is only used to wait for the vblank, see below */
+}
+
+/**
+ * xlnx_crtc_wait_for_present - Wait for the scheduled presentation time
+ * @state: atomic state being committed
+ *
+ * Called from the commit tail before the hardware is programmed. For every
+ * active CRTC of @state that has a target vblank, wait for the vblank that
+ * precedes it, so the new configuration latches at the target vblank.
+ */
+void xlnx_crtc_wait_for_present(struct drm_atomic_state *state)
+{
+	struct drm_crtc_state *new_crtc_state;
+	struct drm_vblank_work work;
+	struct drm_crtc *crtc;
+	u64 count;
+	s32 delay;
+	int i;
+
+	for_each_new_crtc_in_state(state, crtc, new_crtc_state, i) {
+		u32 target = new_crtc_state->target_vblank;
+
+		if (!target)
+			continue;
+
+		new_crtc_state->target_vblank = 0;
+		if (!new_crtc_state->active || drm_crtc_vblank_get(crtc))
+			continue;
+
+		count = drm_crtc_vblank_count(crtc);
+		delay = (s32)(target - 1 - (u32)count);
+		if (delay > XLNX_CRTC_PRESENT_MAX_VBLANKS) {
+			drm_dbg_kms(crtc->dev,
+				    "present target %u too far from %llu\n",
+				    target, count);
+			delay = XLNX_CRTC_PRESENT_MAX_VBLANKS;
+		}
+
+		if (delay > 0) {
+			drm_vblank_work_init(&work, crtc,
+					     xlnx_crtc_present_work);
+			if (!drm_vblank_work_schedule(&work, count + delay,
+						      false))
+				drm_vblank_work_flush(&work);
+		}
+
+		drm_crtc_vblank_put(crtc);
+	}
+}
+
+static u32 xlnx_crtc_time_to_vblank(struct drm_crtc *crtc, u64 time)
+{
+	struct drm_vblank_crtc *vblank;
+	ktime_t vblank_time;
+	s64 elapsed;
+	u64 count;
+
+	vblank = &crtc->dev->vblank[drm_crtc_index(crtc)];
+	count = drm_crtc_vblank_count_and_time(crtc, &vblank_time);
+	elapsed = time - ktime_to_ns(vblank_time);
+	if (elapsed <= 0 || vblank->framedur_ns <= 0)
+		return count + 1;
+
+	count += div_u64(elapsed + vblank->framedur_ns / 2,
+			 vblank->framedur_ns);
+
+	return count ? count : 1;
+}
+
+/**
+ * xlnx_crtc_create_present_properties - Create the presentation properties
+ * @crtc: Xilinx CRTC device
+ *
+ * Create and attach the PRESENT_VBLANK and PRESENT_TIME properties to
+ * @crtc. The CRTC driver must pass them to
+ * xlnx_crtc_atomic_set_present_property() and
+ * xlnx_crtc_atomic_get_present_property().
+ *
+ * Return: 0 on success, or -ENOMEM
+ */
+int xlnx_crtc_create_present_properties(struct xlnx_crtc *crtc)
+{
+	struct drm_device *drm = crtc->crtc.dev;
+
+	crtc->present_vblank_prop = drm_property_create_range(drm, 0,
+							      "PRESENT_VBLANK",
+							      0, U32_MAX);
+	crtc->present_time_prop = drm_property_create_range(drm, 0,
+							    "PRESENT_TIME",
+							    0, U64_MAX);
+	if (!crtc->present_vblank_prop || !crtc->present_time_prop)
+		return -ENOMEM;
+
+	drm_object_attach_property(&crtc->crtc.base,
+				   crtc->present_vblank_prop, 0);
+	drm_object_attach_property(&crtc->crtc.base,
+				   crtc->present_time_prop, 0);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(xlnx_crtc_create_present_properties);
+
+/**
+ * xlnx_crtc_atomic_set_present_property - Set a presentation property
+ * @crtc: DRM CRTC
+ * @state: CRTC state to update
+ * @property: property to set
+ * @val: vblank count or time in ns, 0 to present as soon as possible
+ *
+ * Return: 0 if @property is a presentation property, -ENOENT otherwise
+ */
+int xlnx_crtc_atomic_set_present_property(struct drm_crtc *crtc,
+					  struct drm_crtc_state *state,
+					  struct drm_property *property,
+					  u64 val)
+{
+	struct xlnx_crtc *xlnx_crtc = to_xlnx_crtc(crtc);
+
+	if (property == xlnx_crtc->present_vblank_prop)
+		state->target_vblank = val;
+	else if (property == xlnx_crtc->present_time_prop)
+		state->target_vblank = val ?
+				       xlnx_crtc_time_to_vblank(crtc, val) : 0;
+	else
+		return -ENOENT;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(xlnx_crtc_atomic_set_present_property);
+
+/**
+ * xlnx_crtc_atomic_get_present_property - Get a presentation property
+ * @crtc: DRM CRTC
+ * @state: CRTC state to read
+ * @property: property to get
+ * @val: returned value
+ *
+ * PRESENT_VBLANK reads back the pending target vblank, PRESENT_TIME always
+ * reads back 0 as it is converted to a vblank count when set.
+ *
+ * Return: 0 if @property is a presentation property, -ENOENT otherwise
+ */
+int xlnx_crtc_atomic_get_present_property(struct drm_crtc *crtc,
+					  const struct drm_crtc_state *state,
+					  struct drm_property *property,
+					  u64 *val)
+{
+	struct xlnx_crtc *xlnx_crtc = to_xlnx_crtc(crtc);
+
+	if (property == xlnx_crtc->present_vblank_prop)
+		*val = state->target_vblank;
+	else if (property == xlnx_crtc->present_time_prop)
+		*val = 0;
+	else
+		return -ENOENT;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(xlnx_crtc_atomic_get_present_property);
+
 void xlnx_crtc_register(struct drm_device *drm, struct xlnx_crtc *crtc)
 {
 	struct xlnx_crtc_helper *helper = xlnx_get_crtc_helper(drm);
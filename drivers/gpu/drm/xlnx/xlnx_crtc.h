@@ -19,6 +19,21 @@
 #ifndef _XLNX_CRTC_H_
 #define _XLNX_CRTC_H_
 
+struct drm_rect;
+
+/**
+ * struct xlnx_crtc_sink - Display that keeps the last frame in its own memory
+ * @update: Prepare the sink to receive the area @rect of the frame, before
+ *	    the CRTC sends it. The sink may grow @rect to the alignment it
+ *	    needs. Return 0, or an error code to get the whole frame.
+ *
+ * A CRTC with a sink only sends the frames, or the parts of them, that have
+ * changed, instead of refreshing the display continuously.
+ */
+struct xlnx_crtc_sink {
+	int (*update)(struct xlnx_crtc_sink *sink, struct drm_rect *rect);
+};
+
 /**
  * struct xlnx_crtc - Xilinx CRTC device
  * @crtc: DRM CRTC device
@@ -30,6 +45,11 @@
  * @get_format: Get the current format of CRTC device
  * @get_cursor_width: Get the cursor width
  * @get_cursor_height: Get the cursor height
+ * @get_dma_dev: Get the device that performs the scanout DMA, if it is
+ *		 not the CRTC device itself
+ * @present_vblank_prop: vblank count to present the commit at
+ * @present_time_prop: CLOCK_MONOTONIC time in ns to present the commit at
+ * @sink: Display refreshing itself, set by the encoder while it is enabled
  */
 struct xlnx_crtc {
 	struct drm_crtc crtc;
@@ -41,12 +61,17 @@ struct xlnx_crtc {
 	uint32_t (*get_format)(struct xlnx_crtc *crtc);
 	uint32_t (*get_cursor_width)(struct xlnx_crtc *crtc);
 	uint32_t (*get_cursor_height)(struct xlnx_crtc *crtc);
+	struct device *(*get_dma_dev)(struct xlnx_crtc *crtc);
+	struct drm_property *present_vblank_prop;
+	struct drm_property *present_time_prop;
+	struct xlnx_crtc_sink *sink;
 };
 
 /*
  * Helper functions: used within Xlnx DRM
  */
 
+struct drm_atomic_state;
 struct xlnx_crtc_helper;
 
 unsigned int xlnx_crtc_helper_get_align(struct xlnx_crtc_helper *helper);
@@ -56,11 +81,14 @@ int xlnx_crtc_helper_get_max_height(struct xlnx_crtc_helper *helper);
 uint32_t xlnx_crtc_helper_get_format(struct xlnx_crtc_helper *helper);
 u32 xlnx_crtc_helper_get_cursor_width(struct xlnx_crtc_helper *helper);
 u32 xlnx_crtc_helper_get_cursor_height(struct xlnx_crtc_helper *helper);
+struct device *xlnx_crtc_helper_get_dma_dev(struct xlnx_crtc_helper *helper);
 
 struct xlnx_crtc_helper *xlnx_crtc_helper_init(struct drm_device *drm);
 void xlnx_crtc_helper_fini(struct drm_device *drm,
 			   struct xlnx_crtc_helper *helper);
 
+void xlnx_crtc_wait_for_present(struct drm_atomic_state *state);
+
 /*
  * CRTC registration: used by other sub-driver modules
  */
@@ -70,6 +98,16 @@ static inline struct xlnx_crtc *to_xlnx_crtc(struct drm_crtc *crtc)
 	return container_of(crtc, struct xlnx_crtc, crtc);
 }
 
+int xlnx_crtc_create_present_properties(struct xlnx_crtc *crtc);
+int xlnx_crtc_atomic_set_present_property(struct drm_crtc *crtc,
+					  struct drm_crtc_state *state,
+					  struct drm_property *property,
+					  u64 val);
+int xlnx_crtc_atomic_get_present_property(struct drm_crtc *crtc,
+					  const struct drm_crtc_state *state,
+					  struct drm_property *property,
+					  u64 *val);
+
 void xlnx_crtc_register(struct drm_device *drm, struct xlnx_crtc *crtc);
 void xlnx_crtc_unregister(struct drm_device *drm, struct xlnx_crtc *crtc);
 
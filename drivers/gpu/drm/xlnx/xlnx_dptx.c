@@ -11,6 +11,7 @@
 #include <linux/bitfield.h>
 #include <linux/clk.h>
 #include <linux/component.h>
+#include <linux/crc32.h>
 #include <linux/delay.h>
 #include <linux/device.h>
 #include <linux/gpio/consumer.h>
@@ -446,6 +447,22 @@ struct xlnx_dp_tx_link_config {
 	u8 pe_level;
 };
 
+/**
+ * struct xlnx_dp_link_cache - Link parameters of the last trained sink
+ * @sink_id: CRC of the EDID of the sink, or 0 if the cache is empty
+ * @bw_code: link rate the training succeeded at
+ * @lane_cnt: lane count the training succeeded with
+ * @vs_level: voltage swing level the training settled on
+ * @pe_level: pre emphasis level the training settled on
+ */
+struct xlnx_dp_link_cache {
+	u32 sink_id;
+	u8 bw_code;
+	u8 lane_cnt;
+	u8 vs_level;
+	u8 pe_level;
+};
+
 /**
  * struct xlnx_dp_mode - Configured mode of DisplayPort
  * @pclock: pixel clock frequency of current mode
@@ -519,6 +536,7 @@ enum xlnx_dp_train_state {
  * @hpd_work: hot plug detection worker
  * @hpd_pulse_work: hot plug pulse detection worker
  * @hdcp_cp_irq_work: HDCP content protection message indication worker
+ * @hdcp_start_work: HDCP authentication start worker
  * @tx_audio_data: audio data
  * @infoframe : IP infoframe data
  * @vscpkt: VSC extended packet data
@@ -536,6 +554,8 @@ enum xlnx_dp_train_state {
  * @audio_init: flag to indicate audio is initialized
  * @have_edid: flag to indicate if edid is available
  * @colorimetry_through_vsc: colorimetry information through vsc packets
+ * @sink_id: CRC of the EDID of the connected sink, or 0 if unknown
+ * @link_cache: link parameters of the last successful full training
  *
  */
 struct xlnx_dp {
@@ -558,6 +578,7 @@ struct xlnx_dp {
 	struct delayed_work hpd_work;
 	struct delayed_work hpd_pulse_work;
 	struct delayed_work hdcp_cp_irq_work;
+	struct delayed_work hdcp_start_work;
 	struct xlnx_dptx_audio_data *tx_audio_data;
 	struct xlnx_dp_infoframe infoframe;
 	struct xlnx_dp_vscpkt vscpkt;
@@ -575,6 +596,8 @@ struct xlnx_dp {
 	bool audio_init;
 	bool have_edid;
 	unsigned int colorimetry_through_vsc : 1;
+	u32 sink_id;
+	struct xlnx_dp_link_cache link_cache;
 };
 
 /**
@@ -1755,6 +1778,23 @@ static int xlnx_dp_adjust_lanecount(struct xlnx_dp *dp)
 	return XLNX_DP_TRAIN_CR;
 }
 
+/**
+ * xlnx_dp_eq_pattern - Training pattern for channel equalization
+ * @dp: DisplayPort IP core structure
+ *
+ * Return: the highest training pattern supported by the sink
+ */
+static u8 xlnx_dp_eq_pattern(struct xlnx_dp *dp)
+{
+	if (dp->dpcd[DP_DPCD_REV] == XDPTX_V1_4 &&
+	    dp->dpcd[DP_MAX_DOWNSPREAD] & DP_TPS4_SUPPORTED)
+		return DP_TRAINING_PATTERN_4;
+	if (dp->dpcd[DP_MAX_LANE_COUNT] & DP_TPS3_SUPPORTED)
+		return DP_TRAINING_PATTERN_3;
+
+	return DP_TRAINING_PATTERN_2;
+}
+
 /**
  * xlnx_dp_link_train_ce - Train channel equalization
  * @dp: DisplayPort IP core structure
@@ -1773,15 +1813,7 @@ static int xlnx_dp_link_train_ce(struct xlnx_dp *dp)
 	u8 lane_cnt = dp->mode.lane_cnt;
 	bool ce_done, cr_done;
 
-	if (dp->dpcd[DP_DPCD_REV] == XDPTX_V1_4 &&
-	    dp->dpcd[DP_MAX_DOWNSPREAD] & DP_TPS4_SUPPORTED) {
-		pat = DP_TRAINING_PATTERN_4;
-	} else if (dp->dpcd[DP_MAX_LANE_COUNT] & DP_TPS3_SUPPORTED) {
-		pat = DP_TRAINING_PATTERN_3;
-	} else {
-		pat = DP_TRAINING_PATTERN_2;
-	}
-
+	pat = xlnx_dp_eq_pattern(dp);
 	ret = xlnx_dp_set_train_patttern(dp, pat);
 	if (ret < 0)
 		return XLNX_DP_TRAIN_FAILURE;
@@ -1907,6 +1939,88 @@ static int xlnx_dp_run_training(struct xlnx_dp *dp)
 	return -EIO;
 }
 
+/**
+ * xlnx_dp_train_cached - Train the link with the cached link parameters
+ * @dp: DisplayPort core structure
+ *
+ * If the connected sink was trained before, program the link rate, lane
+ * count and drive levels it was trained at, and check that clock recovery
+ * and channel equalization pass in a single pass of each pattern. This
+ * skips the search over drive levels, link rates and lane counts done by
+ * xlnx_dp_run_training(). On failure the link is put back to @dp->mode as
+ * it was on entry, ready for a full training.
+ *
+ * Return: 0 if the link is trained, or error value if a full training is
+ * needed.
+ */
+static int xlnx_dp_train_cached(struct xlnx_dp *dp)
+{
+	struct xlnx_dp_link_cache *cache = &dp->link_cache;
+	u8 bw_code = dp->mode.bw_code, lane_cnt = dp->mode.lane_cnt;
+	u8 link_status[DP_LINK_STATUS_SIZE];
+	int ret;
+
+	if (!cache->sink_id || cache->sink_id != dp->sink_id ||
+	    cache->lane_cnt > dp->link_config.max_lanes ||
+	    drm_dp_bw_code_to_link_rate(cache->bw_code) >
+	    dp->link_config.max_rate)
+		return -ENOENT;
+
+	if (cache->bw_code != bw_code) {
+		ret = xlnx_dp_set_linkrate(dp, cache->bw_code);
+		if (ret < 0)
+			goto err_restore;
+	}
+	if (cache->lane_cnt != lane_cnt) {
+		ret = xlnx_dp_set_lanecount(dp, cache->lane_cnt);
+		if (ret < 0)
+			goto err_restore;
+	}
+
+	dp->tx_link_config.vs_level = cache->vs_level;
+	dp->tx_link_config.pe_level = cache->pe_level;
+	ret = xlnx_dp_set_train_patttern(dp, DP_TRAINING_PATTERN_1);
+	if (ret < 0)
+		goto err_restore;
+
+	drm_dp_link_train_clock_recovery_delay(&dp->aux, dp->dpcd);
+	ret = drm_dp_dpcd_read_link_status(&dp->aux, link_status);
+	if (ret < 0)
+		goto err_restore;
+	if (!drm_dp_clock_recovery_ok(link_status, dp->mode.lane_cnt)) {
+		ret = -EIO;
+		goto err_restore;
+	}
+
+	ret = xlnx_dp_set_train_patttern(dp, xlnx_dp_eq_pattern(dp));
+	if (ret < 0)
+		goto err_restore;
+
+	drm_dp_link_train_channel_eq_delay(&dp->aux, dp->dpcd);
+	ret = drm_dp_dpcd_read_link_status(&dp->aux, link_status);
+	if (ret < 0)
+		goto err_restore;
+	if (!drm_dp_channel_eq_ok(link_status, dp->mode.lane_cnt)) {
+		ret = -EIO;
+		goto err_restore;
+	}
+
+	dev_dbg(dp->dev, "dp cached link training is success !!");
+
+	return 0;
+
+err_restore:
+	dev_dbg(dp->dev, "cached link training failed, retraining\n");
+	cache->sink_id = 0;
+	xlnx_dp_set_train_patttern(dp, DP_TRAINING_PATTERN_DISABLE);
+	if (dp->mode.bw_code != bw_code)
+		xlnx_dp_set_linkrate(dp, bw_code);
+	if (dp->mode.lane_cnt != lane_cnt)
+		xlnx_dp_set_lanecount(dp, lane_cnt);
+
+	return ret < 0 ? ret : -EIO;
+}
+
 static void xlnx_dp_phy_reset(struct xlnx_dp *dp, u32 reset)
 {
 	u32 phy_val, reg_val;
@@ -2415,7 +2529,6 @@ static int xlnx_dp_power_cycle(struct xlnx_dp *dp)
 static void xlnx_dp_start(struct xlnx_dp *dp)
 {
 	struct xlnx_dp_mode *mode = &dp->mode;
-	struct xlnx_hdcptx *dptxhdcp = &dp->tx_hdcp;
 	int link_rate = dp->link_config.link_rate;
 	int ret = 0;
 	u32 val, intr_mask;
@@ -2510,12 +2623,21 @@ static void xlnx_dp_start(struct xlnx_dp *dp)
 	if (ret < 0)
 		return;
 
-	memset(dp->train_set, 0, XDPTX_MAX_LANES);
-
-	ret = xlnx_dp_run_training(dp);
+	ret = xlnx_dp_train_cached(dp);
 	if (ret < 0) {
-		dev_err(dp->dev, "DP Link Training Failed\n");
-		return;
+		memset(dp->train_set, 0, XDPTX_MAX_LANES);
+
+		ret = xlnx_dp_run_training(dp);
+		if (ret < 0) {
+			dev_err(dp->dev, "DP Link Training Failed\n");
+			return;
+		}
+
+		dp->link_cache.sink_id = dp->sink_id;
+		dp->link_cache.bw_code = mode->bw_code;
+		dp->link_cache.lane_cnt = mode->lane_cnt;
+		dp->link_cache.vs_level = dp->tx_link_config.vs_level;
+		dp->link_cache.pe_level = dp->tx_link_config.pe_level;
 	}
 
 	ret = xlnx_dp_post_training(dp);
@@ -2551,11 +2673,12 @@ static void xlnx_dp_start(struct xlnx_dp *dp)
 	if (dp->config.hdcp2x_enable) {
 		xlnx_dp_set(dp->dp_base, XDP_TX_HDCP2x_ENABLE,
 			    XDP_TX_HDCP2x_ENABLE_BYPASS_DISABLE_MASK);
-		ret = xlnx_start_hdcp_engine(dptxhdcp, mode->lane_cnt);
-		if (ret < 0) {
-			dev_err(dp->dev, "Failed to Start HDCP\n");
-			return;
-		}
+		/*
+		 * Authentication takes several DPCD round trips with timeouts
+		 * in the order of hundreds of milliseconds. Run it from a
+		 * worker so it doesn't hold up the commit or hotplug path.
+		 */
+		schedule_delayed_work(&dp->hdcp_start_work, 0);
 	}
 
 	if (dp->colorimetry_through_vsc) {
@@ -2586,6 +2709,7 @@ static int xlnx_dp_hdcp_reset(struct xlnx_dp *dp)
 	struct xlnx_hdcptx *dptxhdcp = &dp->tx_hdcp;
 	int ret;
 
+	cancel_delayed_work_sync(&dp->hdcp_start_work);
 	cancel_delayed_work(&dp->hdcp_cp_irq_work);
 	ret = xlnx_hdcp_tx_reset(dptxhdcp);
 	if (ret < 0) {
@@ -2772,9 +2896,12 @@ static int xlnx_dp_connector_get_modes(struct drm_connector *connector)
 	if (!edid) {
 		drm_connector_update_edid_property(connector, NULL);
 		dp->have_edid = false;
+		dp->sink_id = 0;
 		return 0;
 	}
 
+	dp->sink_id = crc32(0, edid, (edid->extensions + 1) * EDID_LENGTH);
+
 	drm_connector_update_edid_property(connector, edid);
 	ret = drm_add_edid_modes(connector, edid);
 	dp->have_edid = true;
@@ -3235,6 +3362,25 @@ static void xlnx_dp_hdcp_cp_irq_func(struct work_struct *work)
 	xlnx_hdcp_tx_process_cp_irq(dptxhdcp);
 }
 
+/**
+ * xlnx_dp_hdcp_start_func - Start HDCP authentication
+ * @work: work structure
+ *
+ * This function starts the HDCP engine on the trained link, outside of the
+ * atomic commit and hotplug paths that enabled the main link.
+ */
+static void xlnx_dp_hdcp_start_func(struct work_struct *work)
+{
+	struct xlnx_dp *dp;
+	int ret;
+
+	dp = container_of(work, struct xlnx_dp, hdcp_start_work.work);
+
+	ret = xlnx_start_hdcp_engine(&dp->tx_hdcp, dp->mode.lane_cnt);
+	if (ret < 0)
+		dev_err(dp->dev, "Failed to Start HDCP\n");
+}
+
 static struct drm_prop_enum_list xlnx_dp_bpc_enum[] = {
 	{ 6, "6BPC" },
 	{ 8, "8BPC" },
@@ -3714,6 +3860,7 @@ static int xlnx_hdcp_init(struct xlnx_dp *dp,
 	}
 
 	INIT_DELAYED_WORK(&dp->hdcp_cp_irq_work, xlnx_dp_hdcp_cp_irq_func);
+	INIT_DELAYED_WORK(&dp->hdcp_start_work, xlnx_dp_hdcp_start_func);
 
 	return 0;
 }
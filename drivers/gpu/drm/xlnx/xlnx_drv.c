@@ -24,6 +24,7 @@
 #include <drm/drm_crtc_helper.h>
 #include <drm/drm_fb_helper.h>
 #include <drm/drm_gem_dma_helper.h>
+#include <drm/drm_managed.h>
 #include <drm/drm_of.h>
 #include <drm/drm_probe_helper.h>
 
@@ -31,6 +32,7 @@
 #include <linux/device.h>
 #include <linux/dma-buf.h>
 #include <linux/dma-resv.h>
+#include <linux/iommu.h>
 #include <linux/module.h>
 #include <linux/of_graph.h>
 #include <linux/platform_device.h>
@@ -62,6 +64,7 @@ MODULE_PARM_DESC(fbdev_vres,
  * @master: logical master device for pipeline
  * @suspend_state: atomic state for suspend / resume
  * @master_count: Counter to track number of fake master instances
+ * @dma_dev: device used to allocate and map GEM buffers
  */
 struct xlnx_drm {
 	struct drm_device *drm;
@@ -70,6 +73,7 @@ struct xlnx_drm {
 	struct platform_device *master;
 	struct drm_atomic_state *suspend_state;
 	u32 master_count;
+	struct device *dma_dev;
 };
 
 /**
@@ -98,6 +102,22 @@ unsigned int xlnx_get_align(struct drm_device *drm)
 	return xlnx_crtc_helper_get_align(xlnx_drm->crtc);
 }
 
+/**
+ * xlnx_get_dma_dev - Return the device used for GEM buffer allocation
+ * @drm: DRM device
+ *
+ * This is the DRM device itself, unless all CRTCs scan out through a
+ * separate DMA device that is translated by an IOMMU.
+ *
+ * Return: the DMA device
+ */
+struct device *xlnx_get_dma_dev(struct drm_device *drm)
+{
+	struct xlnx_drm *xlnx_drm = drm->dev_private;
+
+	return xlnx_drm->dma_dev;
+}
+
 /**
  * xlnx_get_format - Return the current format of CRTC
  * @drm: DRM device
@@ -119,6 +139,17 @@ static void xlnx_output_poll_changed(struct drm_device *drm)
 		drm_fb_helper_hotplug_event(xlnx_drm->fb);
 }
 
+static void xlnx_atomic_commit_tail(struct drm_atomic_state *state)
+{
+	xlnx_crtc_wait_for_present(state);
+	xlnx_fb_sync_for_scanout(state);
+	drm_atomic_helper_commit_tail(state);
+}
+
+static const struct drm_mode_config_helper_funcs xlnx_mode_config_helpers = {
+	.atomic_commit_tail	= xlnx_atomic_commit_tail,
+};
+
 static const struct drm_mode_config_funcs xlnx_mode_config_funcs = {
 	.fb_create		= xlnx_fb_create,
 	.output_poll_changed	= xlnx_output_poll_changed,
@@ -199,6 +230,7 @@ static struct drm_driver xlnx_drm_driver = {
 	.lastclose			= xlnx_lastclose,
 
 	DRM_GEM_DMA_DRIVER_OPS_VMAP_WITH_DUMB_CREATE(xlnx_gem_cma_dumb_create),
+	.gem_prime_import		= xlnx_gem_prime_import,
 
 	.fops				= &xlnx_fops,
 
@@ -209,6 +241,42 @@ static struct drm_driver xlnx_drm_driver = {
 	.minor				= DRIVER_MINOR,
 };
 
+static void xlnx_put_dma_dev(struct drm_device *drm, void *dma_dev)
+{
+	put_device(dma_dev);
+}
+
+/*
+ * Scanout DMA behind an IOMMU doesn't need physically contiguous memory.
+ * Allocate through the DMA device in that case, so the buffers come from
+ * scattered pages instead of CMA.
+ */
+static void xlnx_init_dma_dev(struct xlnx_drm *xlnx_drm)
+{
+	struct drm_device *drm = xlnx_drm->drm;
+	struct iommu_domain *domain;
+	struct device *dma_dev;
+
+	xlnx_drm->dma_dev = drm->dev;
+
+	dma_dev = xlnx_crtc_helper_get_dma_dev(xlnx_drm->crtc);
+	if (!dma_dev || dma_dev == drm->dev)
+		return;
+
+	domain = iommu_get_domain_for_dev(dma_dev);
+	if (!domain || !iommu_is_dma_domain(domain))
+		return;
+
+	/* Buffers may outlive the binding, so hold it until the DRM release */
+	if (drmm_add_action_or_reset(drm, xlnx_put_dma_dev,
+				     get_device(dma_dev)))
+		return;
+
+	xlnx_drm->dma_dev = dma_dev;
+	dev_info(drm->dev, "using %s for IOMMU backed buffers\n",
+		 dev_name(dma_dev));
+}
+
 static int xlnx_bind(struct device *dev)
 {
 	struct xlnx_drm *xlnx_drm;
@@ -231,6 +299,7 @@ static int xlnx_bind(struct device *dev)
 
 	drm_mode_config_init(drm);
 	drm->mode_config.funcs = &xlnx_mode_config_funcs;
+	drm->mode_config.helper_private = &xlnx_mode_config_helpers;
 
 	ret = drm_vblank_init(drm, MAX_CRTC);
 	if (ret) {
@@ -257,6 +326,7 @@ static int xlnx_bind(struct device *dev)
 	xlnx_mode_config_init(drm);
 	drm_mode_config_reset(drm);
 	dma_set_mask(drm->dev, xlnx_crtc_helper_get_dma_mask(xlnx_drm->crtc));
+	xlnx_init_dma_dev(xlnx_drm);
 
 	format = xlnx_crtc_helper_get_format(xlnx_drm->crtc);
 	info = drm_format_info(format);
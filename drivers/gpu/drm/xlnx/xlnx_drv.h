@@ -19,6 +19,7 @@
 #ifndef _XLNX_DRV_H_
 #define _XLNX_DRV_H_
 
+struct device;
 struct drm_device;
 struct xlnx_crtc_helper;
 
@@ -27,6 +28,7 @@ void xlnx_drm_pipeline_exit(struct platform_device *pipeline);
 
 uint32_t xlnx_get_format(struct drm_device *drm);
 unsigned int xlnx_get_align(struct drm_device *drm);
+struct device *xlnx_get_dma_dev(struct drm_device *drm);
 struct xlnx_crtc_helper *xlnx_get_crtc_helper(struct drm_device *drm);
 struct xlnx_bridge_helper *xlnx_get_bridge_helper(struct drm_device *drm);
 
@@ -16,6 +16,7 @@
 #include <drm/drm_mipi_dsi.h>
 #include <drm/drm_panel.h>
 #include <drm/drm_probe_helper.h>
+#include <drm/drm_rect.h>
 #include <linux/clk.h>
 #include <linux/component.h>
 #include <linux/device.h>
@@ -27,6 +28,7 @@
 #include <video/videomode.h>
 
 #include "xlnx_bridge.h"
+#include "xlnx_crtc.h"
 
 /* DSI Tx IP registers */
 #define XDSI_CCR			0x00
@@ -128,6 +130,9 @@
  * @eotp_prop_val: configurable EoTP DSI parameter value
  * @bllp_mode_prop_val: configurable BLLP mode DSI parameter value
  * @bllp_type_prop_val: configurable BLLP type DSI parameter value
+ * @device: attached DSI peripheral
+ * @sink: frame update interface of a command mode panel
+ * @crtc: CRTC feeding a command mode panel, while enabled
  */
 struct xlnx_dsi {
 	struct drm_encoder encoder;
@@ -166,6 +171,9 @@ struct xlnx_dsi {
 	bool eotp_prop_val;
 	bool bllp_mode_prop_val;
 	bool bllp_type_prop_val;
+	struct mipi_dsi_device *device;
+	struct xlnx_crtc_sink sink;
+	struct xlnx_crtc *crtc;
 };
 
 #define host_to_dsi(host) container_of(host, struct xlnx_dsi, dsi_host)
@@ -501,6 +509,7 @@ static int xlnx_dsi_host_attach(struct mipi_dsi_host *host,
 	panel_lanes = device->lanes;
 	dsi->mode_flags = device->mode_flags;
 	dsi->panel_node = device->dev.of_node;
+	dsi->device = device;
 
 	if (panel_lanes != dsi->lanes) {
 		dev_err(dsi->dev, "Mismatch of lanes. panel = %d, DSI = %d\n",
@@ -532,6 +541,7 @@ static int xlnx_dsi_host_detach(struct mipi_dsi_host *host,
 	struct xlnx_dsi *dsi = host_to_dsi(host);
 
 	dsi->panel = NULL;
+	dsi->device = NULL;
 
 	if (dsi->connector.dev)
 		drm_helper_hpd_irq_event(dsi->connector.dev);
@@ -754,6 +764,51 @@ static int xlnx_dsi_create_connector(struct drm_encoder *encoder)
  * This function derives the DSI IP timing parameters from the timing
  * values given in the attached panel driver.
  */
+static bool xlnx_dsi_is_cmd_panel(struct xlnx_dsi *dsi)
+{
+	return dsi->cmdmode && dsi->device &&
+	       !(dsi->mode_flags & MIPI_DSI_MODE_VIDEO);
+}
+
+/**
+ * xlnx_dsi_sink_update - Set the panel window for the next frame update
+ * @sink: sink of the DSI controller
+ * @rect: area of the frame about to be sent
+ *
+ * The window is widened to the HACT alignment of the controller, then set in
+ * the panel frame memory with the DCS column and page address commands. The
+ * controller passes the pixels of the update on to the panel.
+ *
+ * Return: 0 on success, or an error code from the DCS commands.
+ */
+static int xlnx_dsi_sink_update(struct xlnx_crtc_sink *sink,
+				struct drm_rect *rect)
+{
+	struct xlnx_dsi *dsi = container_of(sink, struct xlnx_dsi, sink);
+	u32 reg;
+	int ret;
+
+	rect->x1 = round_down(rect->x1, XDSI_HACT_MULTIPLIER + 1);
+	rect->x2 = min_t(int, round_up(rect->x2, XDSI_HACT_MULTIPLIER + 1),
+			 dsi->vm.hactive);
+
+	ret = mipi_dsi_dcs_set_column_address(dsi->device, rect->x1,
+					      rect->x2 - 1);
+	if (ret < 0)
+		return ret;
+
+	ret = mipi_dsi_dcs_set_page_address(dsi->device, rect->y1,
+					    rect->y2 - 1);
+	if (ret < 0)
+		return ret;
+
+	reg = XDSI_TIME2_HACT(drm_rect_width(rect) * dsi->mul_factor / 100) |
+	      XDSI_TIME2_VACT(drm_rect_height(rect));
+	xlnx_dsi_writel(dsi->iomem, XDSI_TIME2, reg);
+
+	return 0;
+}
+
 static void
 xlnx_dsi_atomic_mode_set(struct drm_encoder *encoder,
 			 struct drm_crtc_state *crtc_state,
@@ -780,6 +835,14 @@ xlnx_dsi_atomic_mode_set(struct drm_encoder *encoder,
 	vm->hback_porch = m->htotal - m->hsync_end;
 	vm->hsync_len = m->hsync_end - m->hsync_start;
 	xlnx_dsi_set_display_mode(dsi);
+
+	if (xlnx_dsi_is_cmd_panel(dsi)) {
+		/* Frame updates go through the panel window commands */
+		xlnx_dsi_writel(dsi->iomem, XDSI_CCR,
+				XDSI_CCR_CMDMODE | XDSI_CCR_COREENB);
+		dsi->crtc = to_xlnx_crtc(crtc_state->crtc);
+		dsi->crtc->sink = &dsi->sink;
+	}
 }
 
 static void xlnx_dsi_disable(struct drm_encoder *encoder)
@@ -789,6 +852,11 @@ static void xlnx_dsi_disable(struct drm_encoder *encoder)
 	if (dsi->bridge)
 		xlnx_bridge_disable(dsi->bridge);
 
+	if (dsi->crtc) {
+		dsi->crtc->sink = NULL;
+		dsi->crtc = NULL;
+	}
+
 	xlnx_dsi_set_display_disable(dsi);
 }
 
@@ -942,6 +1010,7 @@ static int xlnx_dsi_probe(struct platform_device *pdev)
 	dsi->dsi_host.ops = &xlnx_dsi_ops;
 	dsi->dsi_host.dev = dev;
 	dsi->dev = dev;
+	dsi->sink.update = xlnx_dsi_sink_update;
 
 	ret = xlnx_dsi_parse_dt(dsi);
 	if (ret)
@@ -21,21 +21,27 @@
  */
 
 #include <drm/drm_vblank.h>
+#include <drm/drm_atomic.h>
+#include <drm/drm_damage_helper.h>
 #include <drm/drm_fourcc.h>
 #include <drm/drm_crtc.h>
 #include <drm/drm_crtc_helper.h>
+#include <drm/drm_fb_dma_helper.h>
 #include <drm/drm_fb_helper.h>
 #include <drm/drm_framebuffer.h>
 #include <drm/drm_gem_dma_helper.h>
 #include <drm/drm_gem_framebuffer_helper.h>
+#include <drm/drm_prime.h>
 
 #include "xlnx_crtc.h"
 #include "xlnx_drv.h"
 #include "xlnx_fb.h"
+#include "xlnx_gem.h"
 
 static struct drm_framebuffer_funcs xlnx_fb_funcs = {
 	.destroy	= drm_gem_fb_destroy,
 	.create_handle	= drm_gem_fb_create_handle,
+	.dirty		= drm_atomic_helper_dirtyfb,
 };
 
 /**
@@ -59,6 +65,32 @@ xlnx_fb_create(struct drm_device *drm, struct drm_file *file_priv,
 					    &xlnx_fb_funcs);
 }
 
+/**
+ * xlnx_fb_sync_for_scanout - Write back CPU caches before a commit
+ * @state: atomic state about to be committed
+ *
+ * Write the CPU caches back to the damaged area of the framebuffers that are
+ * backed by cached memory, on every plane of @state. A new framebuffer is
+ * damaged as a whole, so only the dirty rectangles of a framebuffer the CPU
+ * keeps drawing into are written back. This must be called before the planes
+ * are updated.
+ */
+void xlnx_fb_sync_for_scanout(struct drm_atomic_state *state)
+{
+	struct device *dma_dev = xlnx_get_dma_dev(state->dev);
+	struct drm_plane_state *old_state, *new_state;
+	struct drm_plane *plane;
+	unsigned int i;
+
+	for_each_oldnew_plane_in_state(state, plane, old_state, new_state, i) {
+		if (!new_state->fb)
+			continue;
+
+		drm_fb_dma_sync_non_coherent_dev(dma_dev, old_state,
+						 new_state);
+	}
+}
+
 #ifdef CONFIG_DRM_FBDEV_EMULATION
 
 struct xlnx_fbdev {
@@ -100,6 +132,17 @@ xlnx_fb_ioctl(struct fb_info *info, unsigned int cmd, unsigned long arg)
 	return 0;
 }
 
+/*
+ * The buffer may be backed by an IOMMU and not physically contiguous, so
+ * map it through the GEM object instead of relying on smem_start.
+ */
+static int xlnx_fb_mmap(struct fb_info *info, struct vm_area_struct *vma)
+{
+	struct drm_fb_helper *fb_helper = info->par;
+
+	return drm_gem_prime_mmap(fb_helper->fb->obj[0], vma);
+}
+
 static struct fb_ops xlnx_fbdev_ops = {
 	.owner		= THIS_MODULE,
 	.fb_fillrect	= sys_fillrect,
@@ -111,6 +154,7 @@ static struct fb_ops xlnx_fbdev_ops = {
 	.fb_pan_display	= drm_fb_helper_pan_display,
 	.fb_setcmap	= drm_fb_helper_setcmap,
 	.fb_ioctl	= xlnx_fb_ioctl,
+	.fb_mmap	= xlnx_fb_mmap,
 };
 
 static struct drm_framebuffer *
@@ -198,7 +242,7 @@ static int xlnx_fbdev_create(struct drm_fb_helper *fb_helper,
 		      fbdev->align);
 	bytes *= size->surface_height;
 
-	obj = drm_gem_dma_create(drm, bytes);
+	obj = xlnx_gem_create(drm, bytes);
 	if (IS_ERR(obj))
 		return PTR_ERR(obj);
 
@@ -255,7 +299,7 @@ static int xlnx_fbdev_create(struct drm_fb_helper *fb_helper,
 err_framebuffer_release:
 	framebuffer_release(fbi);
 err_drm_gem_cma_free_object:
-	drm_gem_dma_free(obj);
+	drm_gem_object_put(&obj->base);
 	return ret;
 }
 
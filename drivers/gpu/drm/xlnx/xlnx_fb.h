@@ -19,11 +19,13 @@
 #ifndef _XLNX_FB_H_
 #define _XLNX_FB_H_
 
+struct drm_atomic_state;
 struct drm_fb_helper;
 
 struct drm_framebuffer *
 xlnx_fb_create(struct drm_device *drm, struct drm_file *file_priv,
 	       const struct drm_mode_fb_cmd2 *mode_cmd);
+void xlnx_fb_sync_for_scanout(struct drm_atomic_state *state);
 
 #ifdef CONFIG_DRM_FBDEV_EMULATION
 
@@ -18,10 +18,229 @@
 
 #include <drm/drm_drv.h>
 #include <drm/drm_gem_dma_helper.h>
+#include <drm/drm_prime.h>
+#include <uapi/drm/xlnx_drm.h>
+
+#include <linux/dma-mapping.h>
+#include <linux/slab.h>
 
 #include "xlnx_drv.h"
 #include "xlnx_gem.h"
 
+/*
+ * IOMMU backed GEM objects
+ *
+ * When the scanout DMA is translated by an IOMMU, the buffers are allocated
+ * through the DMA device rather than the DRM device. The DMA API then builds
+ * them from scattered pages, trying the largest page sizes supported by the
+ * IOMMU first without retrying hard for them, and maps them contiguously in
+ * the IO virtual address space. The objects are still struct
+ * drm_gem_dma_object, so dma_addr is the IO virtual address seen by the DMA
+ * device and the framebuffer helpers work unchanged. Only the callbacks that
+ * need the allocating device are replaced.
+ */
+
+#define XLNX_GEM_IOMMU_ATTRS	DMA_ATTR_WRITE_COMBINE
+
+static void xlnx_gem_iommu_free(struct drm_gem_object *gem_obj)
+{
+	struct drm_gem_dma_object *obj = to_drm_gem_dma_obj(gem_obj);
+	struct device *dma_dev = xlnx_get_dma_dev(gem_obj->dev);
+
+	if (obj->vaddr && obj->map_noncoherent)
+		dma_free_noncoherent(dma_dev, gem_obj->size, obj->vaddr,
+				     obj->dma_addr, DMA_TO_DEVICE);
+	else if (obj->vaddr)
+		dma_free_attrs(dma_dev, gem_obj->size, obj->vaddr,
+			       obj->dma_addr, XLNX_GEM_IOMMU_ATTRS);
+	drm_gem_object_release(gem_obj);
+	kfree(obj);
+}
+
+static struct sg_table *
+xlnx_gem_iommu_get_sg_table(struct drm_gem_object *gem_obj)
+{
+	struct drm_gem_dma_object *obj = to_drm_gem_dma_obj(gem_obj);
+	struct device *dma_dev = xlnx_get_dma_dev(gem_obj->dev);
+	struct sg_table *sgt;
+	int ret;
+
+	sgt = kzalloc(sizeof(*sgt), GFP_KERNEL);
+	if (!sgt)
+		return ERR_PTR(-ENOMEM);
+
+	ret = dma_get_sgtable_attrs(dma_dev, sgt, obj->vaddr, obj->dma_addr,
+				    gem_obj->size,
+				    obj->map_noncoherent ?
+				    0 : XLNX_GEM_IOMMU_ATTRS);
+	if (ret < 0) {
+		kfree(sgt);
+		return ERR_PTR(ret);
+	}
+
+	return sgt;
+}
+
+static int xlnx_gem_iommu_mmap(struct drm_gem_object *gem_obj,
+			       struct vm_area_struct *vma)
+{
+	struct drm_gem_dma_object *obj = to_drm_gem_dma_obj(gem_obj);
+	struct device *dma_dev = xlnx_get_dma_dev(gem_obj->dev);
+	int ret;
+
+	/* Same as drm_gem_dma_mmap(), but through the allocating device */
+	vma->vm_pgoff -= drm_vma_node_start(&gem_obj->vma_node);
+	vma->vm_flags &= ~VM_PFNMAP;
+	vma->vm_flags |= VM_DONTEXPAND;
+
+	if (obj->map_noncoherent) {
+		vma->vm_page_prot = vm_get_page_prot(vma->vm_flags);
+		ret = dma_mmap_pages(dma_dev, vma, vma->vm_end - vma->vm_start,
+				     virt_to_page(obj->vaddr));
+	} else {
+		ret = dma_mmap_attrs(dma_dev, vma, obj->vaddr, obj->dma_addr,
+				     vma->vm_end - vma->vm_start,
+				     XLNX_GEM_IOMMU_ATTRS);
+	}
+	if (ret)
+		drm_gem_vm_close(vma);
+
+	return ret;
+}
+
+/* Same as drm_gem_dma_begin_cpu_access(), but through the allocating device */
+static int xlnx_gem_iommu_begin_cpu_access(struct drm_gem_object *gem_obj,
+					   enum dma_data_direction dir)
+{
+	struct drm_gem_dma_object *obj = to_drm_gem_dma_obj(gem_obj);
+
+	if (obj->map_noncoherent)
+		dma_sync_single_for_cpu(xlnx_get_dma_dev(gem_obj->dev),
+					obj->dma_addr, gem_obj->size,
+					DMA_TO_DEVICE);
+
+	return 0;
+}
+
+/* Same as drm_gem_dma_end_cpu_access(), but through the allocating device */
+static int xlnx_gem_iommu_end_cpu_access(struct drm_gem_object *gem_obj,
+					 enum dma_data_direction dir)
+{
+	struct drm_gem_dma_object *obj = to_drm_gem_dma_obj(gem_obj);
+
+	if (obj->map_noncoherent && dir != DMA_FROM_DEVICE)
+		dma_sync_single_for_device(xlnx_get_dma_dev(gem_obj->dev),
+					   obj->dma_addr, gem_obj->size,
+					   DMA_TO_DEVICE);
+
+	return 0;
+}
+
+static const struct drm_gem_object_funcs xlnx_gem_iommu_funcs = {
+	.free		= xlnx_gem_iommu_free,
+	.print_info	= drm_gem_dma_object_print_info,
+	.get_sg_table	= xlnx_gem_iommu_get_sg_table,
+	.vmap		= drm_gem_dma_object_vmap,
+	.begin_cpu_access = xlnx_gem_iommu_begin_cpu_access,
+	.end_cpu_access	= xlnx_gem_iommu_end_cpu_access,
+	.mmap		= xlnx_gem_iommu_mmap,
+	.vm_ops		= &drm_gem_dma_vm_ops,
+};
+
+/*
+ * Cached buffers come from dma_alloc_noncoherent(), which needs physically
+ * contiguous memory even behind the IOMMU.
+ */
+static struct drm_gem_dma_object *
+xlnx_gem_iommu_create(struct drm_device *drm, struct device *dma_dev,
+		      size_t size, bool cached)
+{
+	struct drm_gem_dma_object *obj;
+	struct drm_gem_object *gem_obj;
+	int ret;
+
+	obj = kzalloc(sizeof(*obj), GFP_KERNEL);
+	if (!obj)
+		return ERR_PTR(-ENOMEM);
+
+	gem_obj = &obj->base;
+	gem_obj->funcs = &xlnx_gem_iommu_funcs;
+
+	ret = drm_gem_object_init(drm, gem_obj, size);
+	if (ret) {
+		kfree(obj);
+		return ERR_PTR(ret);
+	}
+
+	ret = drm_gem_create_mmap_offset(gem_obj);
+	if (ret)
+		goto err_put;
+
+	obj->map_noncoherent = cached;
+	if (cached)
+		obj->vaddr = dma_alloc_noncoherent(dma_dev, size,
+						   &obj->dma_addr,
+						   DMA_TO_DEVICE,
+						   GFP_KERNEL | __GFP_NOWARN);
+	else
+		obj->vaddr = dma_alloc_attrs(dma_dev, size, &obj->dma_addr,
+					     GFP_KERNEL | __GFP_NOWARN,
+					     XLNX_GEM_IOMMU_ATTRS);
+	if (!obj->vaddr) {
+		dev_dbg(drm->dev, "failed to allocate buffer of size %zu\n",
+			size);
+		ret = -ENOMEM;
+		goto err_put;
+	}
+
+	return obj;
+
+err_put:
+	drm_gem_object_put(gem_obj);
+	return ERR_PTR(ret);
+}
+
+/**
+ * xlnx_gem_create - Allocate a GEM object for scanout
+ * @drm: DRM object
+ * @size: size of the buffer
+ *
+ * This function allocates the buffer through the device returned by
+ * xlnx_get_dma_dev(). If that is the DRM device, this is the same as
+ * drm_gem_dma_create(). Otherwise the buffer is backed by the IOMMU of
+ * the DMA device and doesn't need to be physically contiguous.
+ *
+ * Return: a struct drm_gem_dma_object, or the ERR_PTR on failure
+ */
+struct drm_gem_dma_object *xlnx_gem_create(struct drm_device *drm,
+					   size_t size)
+{
+	struct device *dma_dev = xlnx_get_dma_dev(drm);
+
+	if (dma_dev == drm->dev)
+		return drm_gem_dma_create(drm, size);
+
+	return xlnx_gem_iommu_create(drm, dma_dev, PAGE_ALIGN(size), false);
+}
+
+/**
+ * xlnx_gem_prime_import - (struct drm_driver)->gem_prime_import callback
+ * @drm: DRM object
+ * @dma_buf: dma-buf object to import
+ *
+ * Attach imported buffers to the DMA device, so the scatter/gather table is
+ * mapped in the address space of the device that actually performs the
+ * scanout. Behind an IOMMU this makes any buffer contiguous in the IO
+ * virtual address space.
+ *
+ * Return: the imported GEM object, or the ERR_PTR on failure
+ */
+struct drm_gem_object *xlnx_gem_prime_import(struct drm_device *drm,
+					     struct dma_buf *dma_buf)
+{
+	return drm_gem_prime_import_dev(drm, dma_buf, xlnx_get_dma_dev(drm));
+}
+
 /*
  * xlnx_gem_cma_dumb_create - (struct drm_driver)->dumb_create callback
  * @file_priv: drm_file object
@@ -30,7 +249,9 @@
  *
  * This function is for dumb_create callback of drm_driver struct. Simply
  * it wraps around drm_gem_dma_dumb_create() and sets the pitch value
- * by retrieving the value from the device.
+ * by retrieving the value from the device. Buffers are allocated with
+ * xlnx_gem_create() when the scanout DMA is behind an IOMMU. With the
+ * XLNX_DRM_DUMB_CACHED flag, the buffer is backed by cacheable memory.
  *
  * Return: The return value from drm_gem_dma_dumb_create()
  */
@@ -39,9 +260,31 @@ int xlnx_gem_cma_dumb_create(struct drm_file *file_priv, struct drm_device *drm,
 {
 	int pitch = DIV_ROUND_UP(args->width * args->bpp, 8);
 	unsigned int align = xlnx_get_align(drm);
+	struct device *dma_dev = xlnx_get_dma_dev(drm);
+	bool cached = args->flags & XLNX_DRM_DUMB_CACHED;
+	struct drm_gem_dma_object *obj;
+	int ret;
 
 	if (!args->pitch || !IS_ALIGNED(args->pitch, align))
 		args->pitch = ALIGN(pitch, align);
 
-	return drm_gem_dma_dumb_create_internal(file_priv, drm, args);
+	if (dma_dev == drm->dev && !cached)
+		return drm_gem_dma_dumb_create_internal(file_priv, drm, args);
+
+	if (args->size < (u64)args->pitch * args->height)
+		args->size = (u64)args->pitch * args->height;
+
+	if (dma_dev == drm->dev)
+		obj = drm_gem_dma_create_noncoherent(drm, args->size);
+	else
+		obj = xlnx_gem_iommu_create(drm, dma_dev,
+					    PAGE_ALIGN(args->size), cached);
+	if (IS_ERR(obj))
+		return PTR_ERR(obj);
+
+	ret = drm_gem_handle_create(file_priv, &obj->base, &args->handle);
+	/* drop reference from allocate - handle holds it now */
+	drm_gem_object_put(&obj->base);
+
+	return ret;
 }
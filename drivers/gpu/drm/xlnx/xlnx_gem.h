@@ -19,6 +19,16 @@
 #ifndef _XLNX_GEM_H_
 #define _XLNX_GEM_H_
 
+struct dma_buf;
+struct drm_device;
+struct drm_file;
+struct drm_gem_object;
+struct drm_mode_create_dumb;
+
+struct drm_gem_dma_object *xlnx_gem_create(struct drm_device *drm,
+					   size_t size);
+struct drm_gem_object *xlnx_gem_prime_import(struct drm_device *drm,
+					     struct dma_buf *dma_buf);
 int xlnx_gem_cma_dumb_create(struct drm_file *file_priv,
 			     struct drm_device *drm,
 			     struct drm_mode_create_dumb *args);
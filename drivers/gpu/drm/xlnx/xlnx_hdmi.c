@@ -513,6 +513,8 @@ struct xlnx_hdmi_stream {
  * @in_fmt_prop_val: configurable media bus format value
  * @out_fmt: configurable bridge output media format
  * @out_fmt_prop_val: configurable media bus format value
+ * @edid_valid: flag whether @edid_buf holds the EDID of the last sink
+ * @edid_buf: copy of the EDID read from the last sink
  */
 struct xlnx_hdmi {
 	struct device *dev;
@@ -547,6 +549,8 @@ struct xlnx_hdmi {
 	u32 in_fmt_prop_val;
 	struct drm_property *out_fmt;
 	u32 out_fmt_prop_val;
+	bool edid_valid;
+	u8 edid_buf[HDMI_TX_DDC_EDID_LENGTH];
 };
 
 enum xlnx_hdmitx_clks {
@@ -2431,6 +2435,86 @@ xlnx_hdmi_connector_mode_valid(struct drm_connector *connector,
 	return status;
 }
 
+/**
+ * xlnx_hdmi_ddc_read_edid - read a part of the sink EDID over DDC
+ * @hdmi: pointer to HDMI TX core instance
+ * @offset: EDID offset to start reading from
+ * @buf: buffer to read into
+ * @len: number of bytes to read
+ *
+ * @return: 0 on success, error code otherwise
+ */
+static int xlnx_hdmi_ddc_read_edid(struct xlnx_hdmi *hdmi, u8 offset,
+				   u8 *buf, u16 len)
+{
+	if (xlnx_hdmi_ddcwrite(hdmi, HDMI_TX_DDC_ADDR, 1, &offset, false))
+		return -EIO;
+
+	if (xlnx_hdmi_ddcread(hdmi, HDMI_TX_DDC_ADDR, len, buf, true))
+		return -EIO;
+
+	return 0;
+}
+
+/**
+ * xlnx_hdmi_read_edid - refresh the cached EDID of the connected sink
+ * @hdmi: pointer to HDMI TX core instance
+ *
+ * The base block is always read and compared against the cached one. When
+ * it matches, only the checksum byte of the extension block is read back to
+ * confirm that the sink is unchanged, so reconnecting the same sink costs a
+ * single 128 byte DDC transfer instead of the full 256 byte EDID.
+ *
+ * @return: 0 on success, error code otherwise
+ */
+static int xlnx_hdmi_read_edid(struct xlnx_hdmi *hdmi)
+{
+	u8 base[EDID_LENGTH];
+	u8 *ext = hdmi->edid_buf + EDID_LENGTH;
+	u8 csum;
+	int ret;
+
+	ret = xlnx_hdmi_ddc_read_edid(hdmi, 0, base, EDID_LENGTH);
+	if (ret)
+		goto err;
+
+	if (hdmi->edid_valid && !memcmp(base, hdmi->edid_buf, EDID_LENGTH)) {
+		if (!base[EDID_LENGTH - 2])
+			goto done;
+
+		ret = xlnx_hdmi_ddc_read_edid(hdmi, HDMI_TX_DDC_EDID_LENGTH - 1,
+					      &csum, 1);
+		if (ret)
+			goto err;
+
+		if (csum == ext[EDID_LENGTH - 1])
+			goto done;
+	}
+
+	memcpy(hdmi->edid_buf, base, EDID_LENGTH);
+	if (base[EDID_LENGTH - 2]) {
+		ret = xlnx_hdmi_ddc_read_edid(hdmi, EDID_LENGTH, ext,
+					      EDID_LENGTH);
+		if (ret)
+			goto err;
+	} else {
+		memset(ext, 0, EDID_LENGTH);
+	}
+	hdmi->edid_valid = true;
+
+done:
+	if (hdmi->edid_buf[HDMI_TX_DDC_EDID_SINK_BW] >>
+	    HDMI_TX_DDC_EDID_BW_SHIFT)
+		hdmi->stream.is_frl = 1;
+
+	return 0;
+
+err:
+	hdmi->edid_valid = false;
+	dev_err(hdmi->dev, "failed reading EDID\n");
+	return ret;
+}
+
 /**
  * xlnx_hdmi_get_edid_block - callback function for drm_do_get_edid() used in
  * get_modes through drm_do_get_edid() from drm/drm_edid.c.
@@ -2440,42 +2524,25 @@ xlnx_hdmi_connector_mode_valid(struct drm_connector *connector,
  * @block: edid block
  * @len: length of the data to be read
  *
+ * The blocks are served from the copy refreshed by xlnx_hdmi_read_edid().
+ *
  * @return: 0 on success, error code otherwise
  */
 static int
 xlnx_hdmi_get_edid_block(void *data, u8 *buf, unsigned int block,
 			 size_t len)
 {
-	u8 *buffer;
 	struct xlnx_hdmi *hdmi = data;
-	int ret = 0;
 
 	/* out of bounds? */
 	if (((block * 128) + len) > HDMI_TX_DDC_EDID_LENGTH)
 		return -EINVAL;
 
-	buffer = kzalloc(HDMI_TX_DDC_EDID_LENGTH, GFP_KERNEL);
-	if (!buffer)
-		return -ENOMEM;
-
-	/* first obtain edid in local buffer */
-	*buffer = 0;
-	ret = xlnx_hdmi_ddcwrite(hdmi, HDMI_TX_DDC_ADDR, 1, buffer, false);
-
-	if (!ret) {
-		ret = xlnx_hdmi_ddcread(hdmi, HDMI_TX_DDC_ADDR,
-					HDMI_TX_DDC_EDID_LENGTH, buffer, true);
-	} else {
-		kfree(buffer);
-		dev_err(hdmi->dev, "failed reading EDID\n");
+	if (!hdmi->edid_valid)
 		return -EINVAL;
-	}
 
-	memcpy(buf, buffer + block * 128, len);
-	if (buffer[HDMI_TX_DDC_EDID_SINK_BW] >> HDMI_TX_DDC_EDID_BW_SHIFT)
-		hdmi->stream.is_frl = 1;
+	memcpy(buf, hdmi->edid_buf + block * 128, len);
 
-	kfree(buffer);
 	return 0;
 }
 
@@ -2488,6 +2555,7 @@ static int xlnx_hdmi_connector_get_modes(struct drm_connector *connector)
 
 	hdmi_mutex_lock(&hdmi->hdmi_mutex);
 
+	xlnx_hdmi_read_edid(hdmi);
 	edid = drm_do_get_edid(connector, xlnx_hdmi_get_edid_block, hdmi);
 
 	hdmi_mutex_unlock(&hdmi->hdmi_mutex);
@@ -14,10 +14,14 @@
 #include <drm/drm_atomic_uapi.h>
 #include <drm/drm_crtc.h>
 #include <drm/drm_fb_dma_helper.h>
+#include <drm/drm_edid.h>
 #include <drm/drm_fourcc.h>
+#include <drm/drm_gem_atomic_helper.h>
 #include <drm/drm_gem_dma_helper.h>
 #include <drm/drm_framebuffer.h>
 #include <drm/drm_modeset_helper_vtables.h>
+#include <drm/drm_probe_helper.h>
+#include <drm/drm_writeback.h>
 #include <linux/clk.h>
 #include <linux/delay.h>
 #include <linux/component.h>
@@ -253,6 +257,7 @@ MODULE_PARM_DESC(mixer_primary_enable, "Enable mixer primary plane (default: 1)"
 #define to_xlnx_crtc(x)	container_of(x, struct xlnx_crtc, crtc)
 #define to_xlnx_plane(x)	container_of(x, struct xlnx_mix_plane, base)
 #define to_xlnx_mixer(x)	container_of(x, struct xlnx_mix, crtc)
+#define wb_to_mixer(x)	container_of(x, struct xlnx_mix, wb.connector)
 
 /**
  * enum xlnx_mix_layer_id - Describes the layer by index to be acted upon
@@ -318,6 +323,7 @@ enum xlnx_mix_layer_id {
  * @is_active: Logical flag indicating layer in use.  If false, calls to
  *  enable layer will be ignored.
  * @scale_fact: Current scaling factor applied to layer
+ * @buff_valid: Indicates @buff_addr1 and @buff_addr2 match the hardware
  * @id: The logical layer id identifies which layer this struct describes
  *  (e.g. 0 = master, 1-15 = overlay).
  *
@@ -354,6 +360,7 @@ struct xlnx_mix_layer_data {
 		u32     alpha;
 		bool	is_active;
 		u32	scale_fact;
+		bool	buff_valid;
 	} layer_regs;
 
 	enum xlnx_mix_layer_id id;
@@ -366,6 +373,9 @@ struct xlnx_mix_layer_data {
  * @logo_pixel_alpha_enabled: Indicates that per-pixel alpha supported for logo
  *  layer
  * @csc_enabled: Indicates that colorimetry coefficients are programmable
+ * @csc_valid: Indicates that @csc_enc and @csc_range are programmed
+ * @csc_enc: Colorimetry encoding of the programmed coefficients
+ * @csc_range: Colorimetry range of the programmed coefficients
  * @max_layer_width: Max possible width for any layer on this Mixer
  * @max_layer_height: Max possible height for any layer on this Mixer
  * @max_logo_layer_width: Min possible width for any layer on this Mixer
@@ -397,6 +407,9 @@ struct xlnx_mix_hw {
 	bool                logo_layer_en;
 	bool                logo_pixel_alpha_enabled;
 	u32		    csc_enabled;
+	bool		    csc_valid;
+	enum drm_color_encoding csc_enc;
+	enum drm_color_range csc_range;
 	u32                 max_layer_width;
 	u32                 max_layer_height;
 	u32                 max_logo_layer_width;
@@ -418,6 +431,26 @@ struct xlnx_mix_hw {
 	void *intrpt_data;
 };
 
+/**
+ * struct xlnx_mix_wb - Writeback of the mixer output to memory
+ * @connector: drm writeback connector
+ * @chan: frmbuf write dma channel capturing the mixer output stream
+ * @xt: dma interleaved configuration template
+ * @sgl: data chunk for dma_interleaved_template
+ * @formats: memory formats matching the mixer output stream
+ * @num_formats: number of entries in @formats
+ * @pending: number of queued writeback jobs not yet signalled
+ */
+struct xlnx_mix_wb {
+	struct drm_writeback_connector connector;
+	struct dma_chan *chan;
+	struct dma_interleaved_template xt;
+	struct data_chunk sgl[1];
+	u32 *formats;
+	u32 num_formats;
+	atomic_t pending;
+};
+
 /**
  * struct xlnx_mix - Container for interfacing DRM driver to mixer
  * @mixer_hw: Object representing actual hardware state of mixer
@@ -442,6 +475,7 @@ struct xlnx_mix_hw {
  * @event: vblank pending event
  * @vtc_bridge: vtc_bridge structure
  * @disp_bridge: disp_bridge structure
+ * @wb: optional writeback of the composed output
  *
  * Contains pointers to logical constructions such as the DRM plane manager as
  * well as pointers to distinquish the mixer layer serving as the DRM "primary"
@@ -472,6 +506,7 @@ struct xlnx_mix {
 	struct drm_pending_vblank_event *event;
 	struct xlnx_bridge *vtc_bridge;
 	struct xlnx_bridge *disp_bridge;
+	struct xlnx_mix_wb wb;
 };
 
 /**
@@ -489,6 +524,42 @@ struct xlnx_mix_plane_dma {
 	bool is_active;
 };
 
+/**
+ * struct xlnx_mix_plane_shadow - Plane state last programmed in hardware
+ *
+ * @valid: the remaining fields describe the layer as programmed
+ * @format: pixel format
+ * @pitches: line pitch of each buffer plane
+ * @crtc_x: x position on the crtc
+ * @crtc_y: y position on the crtc
+ * @crtc_w: width on the crtc
+ * @crtc_h: height on the crtc
+ * @src_x: x offset in the framebuffer
+ * @src_y: y offset in the framebuffer
+ * @src_w: width in the framebuffer
+ * @src_h: height in the framebuffer
+ * @color_encoding: colorimetry encoding
+ * @color_range: colorimetry range
+ *
+ * An update that matches the shadow only changes the framebuffer address,
+ * and is applied without reprogramming the layer.
+ */
+struct xlnx_mix_plane_shadow {
+	bool valid;
+	u32 format;
+	u32 pitches[XVMIX_MAX_NUM_SUB_PLANES];
+	int crtc_x;
+	int crtc_y;
+	unsigned int crtc_w;
+	unsigned int crtc_h;
+	u32 src_x;
+	u32 src_y;
+	u32 src_w;
+	u32 src_h;
+	enum drm_color_encoding color_encoding;
+	enum drm_color_range color_range;
+};
+
 /**
  * struct xlnx_mix_plane - Xilinx drm plane object
  *
@@ -499,6 +570,7 @@ struct xlnx_mix_plane_dma {
  * @id: plane id
  * @dpms: current dpms level
  * @format: pixel format
+ * @shadow: plane state last programmed in hardware
  */
 struct xlnx_mix_plane {
 	struct drm_plane base;
@@ -508,6 +580,7 @@ struct xlnx_mix_plane {
 	int id;
 	int dpms;
 	u32 format;
+	struct xlnx_mix_plane_shadow shadow;
 };
 
 static inline void reg_writel(void __iomem *base, int offset, u32 val)
@@ -1447,7 +1520,9 @@ static int xlnx_mix_disp_set_layer_alpha(struct xlnx_mix_plane *plane,
  * @luma_addr: Start address of plane 1 of frame buffer for layer 1
  * @chroma_addr: Start address of plane 2 of frame buffer for layer 1
  *
- * Sets the buffer address of the specified layer
+ * Sets the buffer address of the specified layer. Addresses that are
+ * already programmed are not written again.
+ *
  * Return:
  * Zero on success, -EINVAL on failure
  */
@@ -1472,15 +1547,23 @@ static int xlnx_mix_set_layer_buff_addr(struct xlnx_mix_hw *mixer,
 	reg1 = XVMIX_LAYER1_BUF1_V_DATA + offset;
 	reg2 = XVMIX_LAYER1_BUF2_V_DATA + offset;
 	layer_data = &mixer->layer_data[id];
-	if (mixer->dma_addr_size == 64 && sizeof(dma_addr_t) == 8) {
-		reg_writeq(mixer->base, reg1, luma_addr);
-		reg_writeq(mixer->base, reg2, chroma_addr);
-	} else {
-		reg_writel(mixer->base, reg1, (u32)luma_addr);
-		reg_writel(mixer->base, reg2, (u32)chroma_addr);
+	if (!layer_data->layer_regs.buff_valid ||
+	    layer_data->layer_regs.buff_addr1 != luma_addr) {
+		if (mixer->dma_addr_size == 64 && sizeof(dma_addr_t) == 8)
+			reg_writeq(mixer->base, reg1, luma_addr);
+		else
+			reg_writel(mixer->base, reg1, (u32)luma_addr);
+	}
+	if (!layer_data->layer_regs.buff_valid ||
+	    layer_data->layer_regs.buff_addr2 != chroma_addr) {
+		if (mixer->dma_addr_size == 64 && sizeof(dma_addr_t) == 8)
+			reg_writeq(mixer->base, reg2, chroma_addr);
+		else
+			reg_writel(mixer->base, reg2, (u32)chroma_addr);
 	}
 	layer_data->layer_regs.buff_addr1 = luma_addr;
 	layer_data->layer_regs.buff_addr2 = chroma_addr;
+	layer_data->layer_regs.buff_valid = true;
 
 	return 0;
 }
@@ -1511,6 +1594,9 @@ xlnx_mix_hw_plane_dpms(struct xlnx_mix_plane *plane, int dpms)
 		xlnx_mix_disp_layer_enable(plane);
 		break;
 	default:
+		/* the layer is reprogrammed in full when it is enabled again */
+		plane->shadow.valid = false;
+		plane->mixer_layer->layer_regs.buff_valid = false;
 		xlnx_mix_mark_layer_inactive(plane);
 		xlnx_mix_disp_layer_disable(plane);
 		/* restore to default property values */
@@ -1930,6 +2016,40 @@ static int xlnx_mix_set_plane(struct xlnx_mix_plane *plane,
 	return ret;
 }
 
+/*
+ * Do we have a video format aware dma channel?
+ * If so, modify descriptor accordingly
+ */
+static void xlnx_mix_plane_set_src_icg(struct xlnx_mix_plane *plane,
+				       const struct drm_format_info *info)
+{
+	u32 stride;
+
+	if (plane->dma[0].chan && !plane->dma[1].chan && info->num_planes > 1) {
+		stride = plane->dma[0].sgl[0].size + plane->dma[0].sgl[0].icg;
+		plane->dma[0].sgl[0].src_icg = plane->dma[1].xt.src_start -
+				plane->dma[0].xt.src_start -
+				(plane->dma[0].xt.numf * stride);
+	}
+}
+
+/**
+ * xlnx_mix_csc_changed - Check if the colorimetry coefficients need an update
+ * @mixer: Mixer instance
+ * @state: new plane state
+ *
+ * The coefficient registers are shared by all layers, and only reprogrammed
+ * when the colorimetry changes or they were lost in a reset.
+ *
+ * Return: true if the coefficients have to be programmed
+ */
+static bool xlnx_mix_csc_changed(struct xlnx_mix_hw *mixer,
+				 struct drm_plane_state *state)
+{
+	return !mixer->csc_valid || mixer->csc_enc != state->color_encoding ||
+	       mixer->csc_range != state->color_range;
+}
+
 /* mode set a plane */
 static int xlnx_mix_plane_mode_set(struct drm_plane *base_plane,
 				   struct drm_framebuffer *fb,
@@ -1944,7 +2064,6 @@ static int xlnx_mix_plane_mode_set(struct drm_plane *base_plane,
 	size_t i = 0;
 	dma_addr_t luma_paddr;
 	int ret;
-	u32 stride;
 
 	/* JPM TODO begin start of code to extract into prep-interleaved*/
 	DRM_DEBUG_KMS("plane->id: %d\n", plane->id);
@@ -1976,17 +2095,10 @@ static int xlnx_mix_plane_mode_set(struct drm_plane *base_plane,
 
 	for (; i < XVMIX_MAX_NUM_SUB_PLANES; i++)
 		plane->dma[i].is_active = false;
-	/* Do we have a video format aware dma channel?
-	 * If so, modify descriptor accordingly
-	 */
-	if (plane->dma[0].chan && !plane->dma[1].chan && info->num_planes > 1) {
-		stride = plane->dma[0].sgl[0].size + plane->dma[0].sgl[0].icg;
-		plane->dma[0].sgl[0].src_icg = plane->dma[1].xt.src_start -
-				plane->dma[0].xt.src_start -
-				(plane->dma[0].xt.numf * stride);
-	}
+	xlnx_mix_plane_set_src_icg(plane, info);
 
-	if (mixer_hw->csc_enabled) {
+	if (mixer_hw->csc_enabled &&
+	    xlnx_mix_csc_changed(mixer_hw, base_plane->state)) {
 		/**
 		 * magic numbers of coefficient table for colorimetry
 		 * and range are derived from the following references:
@@ -2003,6 +2115,9 @@ static int xlnx_mix_plane_mode_set(struct drm_plane *base_plane,
 		xlnx_mix_set_rgb2_yuv_coeff(plane,
 					    base_plane->state->color_encoding,
 					    base_plane->state->color_range);
+		mixer_hw->csc_enc = base_plane->state->color_encoding;
+		mixer_hw->csc_range = base_plane->state->color_range;
+		mixer_hw->csc_valid = true;
 	}
 
 	ret = xlnx_mix_set_plane(plane, fb, crtc_x, crtc_y, src_x, src_y,
@@ -2013,7 +2128,8 @@ static int xlnx_mix_plane_mode_set(struct drm_plane *base_plane,
 static int xlnx_mix_plane_prepare_fb(struct drm_plane *plane,
 				     struct drm_plane_state *new_state)
 {
-	return 0;
+	/* Wait for the producer of the buffer, e.g. a low latency capture */
+	return drm_gem_plane_helper_prepare_fb(plane, new_state);
 }
 
 static void xlnx_mix_plane_cleanup_fb(struct drm_plane *plane,
@@ -2053,19 +2169,132 @@ static int xlnx_mix_plane_atomic_check(struct drm_plane *plane,
 	return -EINVAL;
 }
 
+static void xlnx_mix_plane_save_shadow(struct xlnx_mix_plane *plane,
+				       struct drm_plane_state *state)
+{
+	struct xlnx_mix_plane_shadow *shadow = &plane->shadow;
+	unsigned int i;
+
+	shadow->format = state->fb->format->format;
+	for (i = 0; i < XVMIX_MAX_NUM_SUB_PLANES; i++)
+		shadow->pitches[i] = state->fb->pitches[i];
+	shadow->crtc_x = state->crtc_x;
+	shadow->crtc_y = state->crtc_y;
+	shadow->crtc_w = state->crtc_w;
+	shadow->crtc_h = state->crtc_h;
+	shadow->src_x = state->src_x;
+	shadow->src_y = state->src_y;
+	shadow->src_w = state->src_w;
+	shadow->src_h = state->src_h;
+	shadow->color_encoding = state->color_encoding;
+	shadow->color_range = state->color_range;
+	shadow->valid = true;
+}
+
+/**
+ * xlnx_mix_plane_is_flip - Check if an update only changes the buffer
+ * @plane: Xilinx drm plane object
+ * @state: new plane state
+ *
+ * The plane state is compared with the driver's own shadow rather than the
+ * old atomic state, as async updates modify the current state in place.
+ *
+ * Return: true if only the framebuffer address has to be updated
+ */
+static bool xlnx_mix_plane_is_flip(struct xlnx_mix_plane *plane,
+				   struct drm_plane_state *state)
+{
+	struct xlnx_mix_plane_shadow *shadow = &plane->shadow;
+	struct xlnx_mix_hw *mixer_hw = to_mixer_hw(plane);
+	unsigned int i;
+
+	if (!shadow->valid ||
+	    plane->mixer_layer->id == mixer_hw->logo_layer_id)
+		return false;
+
+	for (i = 0; i < XVMIX_MAX_NUM_SUB_PLANES; i++)
+		if (shadow->pitches[i] != state->fb->pitches[i])
+			return false;
+
+	return shadow->format == state->fb->format->format &&
+	       shadow->crtc_x == state->crtc_x &&
+	       shadow->crtc_y == state->crtc_y &&
+	       shadow->crtc_w == state->crtc_w &&
+	       shadow->crtc_h == state->crtc_h &&
+	       shadow->src_x == state->src_x &&
+	       shadow->src_y == state->src_y &&
+	       shadow->src_w == state->src_w &&
+	       shadow->src_h == state->src_h &&
+	       shadow->color_encoding == state->color_encoding &&
+	       shadow->color_range == state->color_range;
+}
+
+/**
+ * xlnx_mix_plane_flip - Switch the layer to a new framebuffer
+ * @plane: Xilinx drm plane object
+ * @fb: new framebuffer, with the same layout as the current one
+ *
+ * Only the buffer addresses are updated, in the DMA descriptors and, for
+ * layers fetched by the mixer, in the layer buffer registers.
+ *
+ * Return: Zero on success, -EINVAL on failure
+ */
+static int xlnx_mix_plane_flip(struct xlnx_mix_plane *plane,
+			       struct drm_framebuffer *fb)
+{
+	struct xlnx_mix_layer_data *layer = plane->mixer_layer;
+	const struct drm_format_info *info = fb->format;
+	dma_addr_t luma_addr, chroma_addr = 0;
+	unsigned int i;
+
+	for (i = 0; i < info->num_planes; i++) {
+		dma_addr_t paddr;
+
+		paddr = drm_fb_dma_get_gem_addr(fb, plane->base.state, i);
+		if (!paddr) {
+			DRM_ERROR("%s failed to get paddr\n", __func__);
+			return -EINVAL;
+		}
+		plane->dma[i].xt.src_start = paddr;
+	}
+	xlnx_mix_plane_set_src_icg(plane, info);
+
+	if (layer->id == XVMIX_LAYER_MASTER || layer->hw_config.is_streaming)
+		return 0;
+
+	luma_addr = plane->dma[0].xt.src_start;
+	if (info->num_planes > 1)
+		chroma_addr = plane->dma[1].xt.src_start;
+
+	return xlnx_mix_set_layer_buff_addr(to_mixer_hw(plane), layer->id,
+					    luma_addr, chroma_addr);
+}
+
 static void xlnx_mix_plane_atomic_update(struct drm_plane *plane,
 					 struct drm_atomic_state *state)
 {
+	struct xlnx_mix_plane *mix_plane = to_xlnx_plane(plane);
 	int ret;
 	struct drm_plane_state *old_state = drm_atomic_get_old_plane_state(state, plane);
 
 	if (!plane->state->crtc || !plane->state->fb)
 		return;
 
+	if (xlnx_mix_plane_is_flip(mix_plane, plane->state)) {
+		ret = xlnx_mix_plane_flip(mix_plane, plane->state->fb);
+		if (ret) {
+			DRM_ERROR("failed to flip a plane\n");
+			return;
+		}
+		xlnx_mix_plane_commit(plane);
+		return;
+	}
+
 	if (old_state->fb &&
 	    old_state->fb->format->format != plane->state->fb->format->format)
 		xlnx_mix_plane_dpms(plane, DRM_MODE_DPMS_OFF);
 
+	mix_plane->shadow.valid = false;
 	ret = xlnx_mix_plane_mode_set(plane, plane->state->fb,
 				      plane->state->crtc_x,
 				      plane->state->crtc_y,
@@ -2083,6 +2312,7 @@ static void xlnx_mix_plane_atomic_update(struct drm_plane *plane,
 	xlnx_mix_plane_commit(plane);
 	/* make sure a plane is on */
 	xlnx_mix_plane_dpms(plane, DRM_MODE_DPMS_ON);
+	xlnx_mix_plane_save_shadow(mix_plane, plane->state);
 }
 
 static void xlnx_mix_plane_atomic_disable(struct drm_plane *plane,
@@ -2179,6 +2409,7 @@ static int xlnx_mix_init_plane(struct xlnx_mix_plane *plane,
 		goto err_init;
 	}
 	drm_plane_helper_add(&plane->base, &xlnx_mix_plane_helper_funcs);
+	drm_plane_enable_fb_damage_clips(&plane->base);
 	of_node_put(layer_node);
 
 	return 0;
@@ -2350,6 +2581,7 @@ static int xlnx_mix_dt_parse(struct device *dev, struct xlnx_mix *mixer)
 	}
 	gpiod_set_raw_value(mixer_hw->reset_gpio, 0);
 	gpiod_set_raw_value(mixer_hw->reset_gpio, 1);
+	mixer_hw->csc_valid = false;
 
 	ret = of_address_to_resource(node, 0, &res);
 	if (ret) {
@@ -2841,6 +3073,8 @@ xlnx_mix_disp_crtc_atomic_set_property(struct drm_crtc *crtc,
 				     struct drm_property *property,
 				     uint64_t val)
 {
+	xlnx_crtc_atomic_set_present_property(crtc, state, property, val);
+
 	return 0;
 }
 
@@ -2850,6 +3084,8 @@ xlnx_mix_disp_crtc_atomic_get_property(struct drm_crtc *crtc,
 				     struct drm_property *property,
 				     uint64_t *val)
 {
+	xlnx_crtc_atomic_get_present_property(crtc, state, property, val);
+
 	return 0;
 }
 
@@ -2866,6 +3102,249 @@ static struct drm_crtc_funcs xlnx_mix_crtc_funcs = {
 	.disable_vblank		= xlnx_mix_crtc_disable_vblank,
 };
 
+static void xlnx_mix_wb_done(void *data)
+{
+	struct xlnx_mix *mixer = data;
+
+	if (atomic_dec_if_positive(&mixer->wb.pending) >= 0)
+		drm_writeback_signal_completion(&mixer->wb.connector, 0);
+}
+
+/**
+ * xlnx_mix_wb_disable - Stop the writeback and cancel the queued jobs
+ * @mixer: Mixer instance
+ *
+ * The frmbuf write channel captures the mixer output stream, which stops
+ * with the crtc. Pending jobs are signalled with an error instead of being
+ * left waiting for a frame that never comes.
+ */
+static void xlnx_mix_wb_disable(struct xlnx_mix *mixer)
+{
+	struct xlnx_mix_wb *wb = &mixer->wb;
+
+	if (!wb->chan)
+		return;
+
+	dmaengine_terminate_sync(wb->chan);
+	while (atomic_dec_if_positive(&wb->pending) >= 0)
+		drm_writeback_signal_completion(&wb->connector, -ECANCELED);
+}
+
+static int xlnx_mix_wb_get_modes(struct drm_connector *connector)
+{
+	struct drm_writeback_connector *wb_conn;
+	struct xlnx_mix *mixer;
+
+	wb_conn = drm_connector_to_writeback(connector);
+	mixer = wb_to_mixer(wb_conn);
+
+	return drm_add_modes_noedid(connector, mixer->max_width,
+				    mixer->max_height);
+}
+
+static void xlnx_mix_wb_atomic_commit(struct drm_connector *connector,
+				      struct drm_atomic_state *state)
+{
+	struct drm_connector_state *conn_state;
+	struct drm_writeback_connector *wb_conn;
+	struct dma_async_tx_descriptor *desc;
+	const struct drm_format_info *info;
+	struct drm_framebuffer *fb;
+	struct xlnx_mix_wb *wb;
+	struct xlnx_mix *mixer;
+	dma_addr_t luma_addr, chroma_addr;
+
+	conn_state = drm_atomic_get_new_connector_state(state, connector);
+	wb_conn = drm_connector_to_writeback(connector);
+	mixer = wb_to_mixer(wb_conn);
+	wb = &mixer->wb;
+	fb = conn_state->writeback_job->fb;
+	info = fb->format;
+
+	luma_addr = drm_fb_dma_get_gem_obj(fb, 0)->dma_addr + fb->offsets[0];
+	wb->xt.dir = DMA_DEV_TO_MEM;
+	wb->xt.src_sgl = false;
+	wb->xt.dst_sgl = true;
+	wb->xt.dst_start = luma_addr;
+	wb->xt.numf = fb->height;
+	wb->xt.frame_size = info->num_planes;
+	wb->sgl[0].size = drm_format_plane_width_bytes(info, 0, fb->width);
+	wb->sgl[0].icg = fb->pitches[0] - wb->sgl[0].size;
+	wb->sgl[0].dst_icg = 0;
+	/* frmbuf derives the chroma address from the luma plane and dst_icg */
+	if (info->num_planes > 1) {
+		chroma_addr = drm_fb_dma_get_gem_obj(fb, 1)->dma_addr +
+			      fb->offsets[1];
+		wb->sgl[0].dst_icg = chroma_addr - luma_addr -
+				     wb->xt.numf * fb->pitches[0];
+	}
+
+	drm_writeback_queue_job(wb_conn, conn_state);
+	atomic_inc(&wb->pending);
+
+	xilinx_xdma_drm_config(wb->chan, info->format);
+	desc = dmaengine_prep_interleaved_dma(wb->chan, &wb->xt,
+					      DMA_CTRL_ACK |
+					      DMA_PREP_INTERRUPT);
+	if (!desc) {
+		DRM_ERROR("failed to prepare writeback DMA descriptor\n");
+		if (atomic_dec_if_positive(&wb->pending) >= 0)
+			drm_writeback_signal_completion(wb_conn, -EIO);
+		return;
+	}
+	desc->callback = xlnx_mix_wb_done;
+	desc->callback_param = mixer;
+	dmaengine_submit(desc);
+	dma_async_issue_pending(wb->chan);
+}
+
+static const struct drm_connector_helper_funcs xlnx_mix_wb_helper_funcs = {
+	.get_modes	= xlnx_mix_wb_get_modes,
+	.atomic_commit	= xlnx_mix_wb_atomic_commit,
+};
+
+static const struct drm_connector_funcs xlnx_mix_wb_connector_funcs = {
+	.reset			= drm_atomic_helper_connector_reset,
+	.fill_modes		= drm_helper_probe_single_connector_modes,
+	.destroy		= drm_connector_cleanup,
+	.atomic_duplicate_state	= drm_atomic_helper_connector_duplicate_state,
+	.atomic_destroy_state	= drm_atomic_helper_connector_destroy_state,
+};
+
+static int xlnx_mix_wb_atomic_check(struct drm_encoder *encoder,
+				    struct drm_crtc_state *crtc_state,
+				    struct drm_connector_state *conn_state)
+{
+	struct drm_writeback_connector *wb_conn;
+	struct drm_framebuffer *fb;
+	struct xlnx_mix *mixer;
+	unsigned int i;
+
+	if (!conn_state->writeback_job || !conn_state->writeback_job->fb)
+		return 0;
+
+	wb_conn = drm_connector_to_writeback(conn_state->connector);
+	mixer = wb_to_mixer(wb_conn);
+	fb = conn_state->writeback_job->fb;
+
+	if (fb->width != crtc_state->mode.hdisplay ||
+	    fb->height != crtc_state->mode.vdisplay) {
+		DRM_DEBUG_KMS("invalid writeback framebuffer size %ux%u\n",
+			      fb->width, fb->height);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < mixer->wb.num_formats; i++)
+		if (fb->format->format == mixer->wb.formats[i])
+			return 0;
+
+	DRM_DEBUG_KMS("invalid writeback pixel format %p4cc\n",
+		      &fb->format->format);
+
+	return -EINVAL;
+}
+
+static const struct drm_encoder_helper_funcs xlnx_mix_wb_encoder_funcs = {
+	.atomic_check	= xlnx_mix_wb_atomic_check,
+};
+
+/**
+ * xlnx_mix_wb_match_fmt - Check a memory format against the output stream
+ * @out: format of the mixer output stream
+ * @fourcc: memory format supported by the frmbuf write channel
+ *
+ * The frmbuf only packs the incoming stream into memory, so the memory
+ * format must carry the same color space and chroma subsampling as the
+ * mixer output.
+ *
+ * Return: true if @fourcc can be written from the @out stream
+ */
+static bool xlnx_mix_wb_match_fmt(const struct drm_format_info *out,
+				  u32 fourcc)
+{
+	const struct drm_format_info *info = drm_format_info(fourcc);
+
+	if (!info || info->is_yuv != out->is_yuv)
+		return false;
+
+	return !out->is_yuv ||
+	       (info->hsub == out->hsub && info->vsub == out->vsub);
+}
+
+/**
+ * xlnx_mix_wb_create - Create the optional writeback connector
+ * @dev: mixer device
+ * @mixer: Mixer instance
+ *
+ * The writeback is available when the mixer node names a frmbuf write
+ * channel "wb0" capturing the mixer output stream.
+ *
+ * Return:
+ * Zero on success or if there is no writeback channel, error on failure
+ */
+static int xlnx_mix_wb_create(struct device *dev, struct xlnx_mix *mixer)
+{
+	struct xlnx_mix_wb *wb = &mixer->wb;
+	struct xlnx_mix_layer_data *master;
+	const struct drm_format_info *out;
+	u32 *fmts, fmt_cnt, i;
+	int ret;
+
+	wb->chan = of_dma_request_slave_channel(dev->of_node, "wb0");
+	if (PTR_ERR(wb->chan) == -ENODEV) {
+		wb->chan = NULL;
+		return 0;
+	}
+	if (IS_ERR(wb->chan)) {
+		DRM_ERROR("failed to request writeback dma channel\n");
+		ret = PTR_ERR(wb->chan);
+		wb->chan = NULL;
+		return ret;
+	}
+
+	ret = xilinx_xdma_get_drm_vid_fmts(wb->chan, &fmt_cnt, &fmts);
+	if (ret)
+		goto err_dma;
+
+	wb->formats = devm_kcalloc(dev, fmt_cnt, sizeof(*wb->formats),
+				   GFP_KERNEL);
+	if (!wb->formats) {
+		ret = -ENOMEM;
+		goto err_dma;
+	}
+
+	master = &mixer->mixer_hw.layer_data[XVMIX_MASTER_LAYER_IDX];
+	out = drm_format_info(master->hw_config.vid_fmt);
+	for (i = 0; i < fmt_cnt; i++)
+		if (out && xlnx_mix_wb_match_fmt(out, fmts[i]))
+			wb->formats[wb->num_formats++] = fmts[i];
+	if (!wb->num_formats) {
+		dev_err(dev, "no writeback format matches the mixer output\n");
+		ret = -EINVAL;
+		goto err_dma;
+	}
+
+	ret = drm_writeback_connector_init(mixer->drm, &wb->connector,
+					   &xlnx_mix_wb_connector_funcs,
+					   &xlnx_mix_wb_encoder_funcs,
+					   wb->formats, wb->num_formats,
+					   drm_crtc_mask(&mixer->crtc.crtc));
+	if (ret) {
+		DRM_ERROR("failed to initialize writeback connector\n");
+		goto err_dma;
+	}
+	drm_connector_helper_add(&wb->connector.base,
+				 &xlnx_mix_wb_helper_funcs);
+	atomic_set(&wb->pending, 0);
+
+	return 0;
+
+err_dma:
+	dma_release_channel(wb->chan);
+	wb->chan = NULL;
+	return ret;
+}
+
 static void
 xlnx_mix_crtc_atomic_enable(struct drm_crtc *crtc,
 			    struct drm_atomic_state *state)
@@ -2898,6 +3377,9 @@ static void
 xlnx_mix_crtc_atomic_disable(struct drm_crtc *crtc,
 			     struct drm_atomic_state *state)
 {
+	struct xlnx_mix *mixer = to_xlnx_mixer(to_xlnx_crtc(crtc));
+
+	xlnx_mix_wb_disable(mixer);
 	xlnx_mix_crtc_dpms(crtc, DRM_MODE_DPMS_OFF);
 	xlnx_mix_clear_event(crtc);
 	drm_crtc_vblank_off(crtc);
@@ -2978,6 +3460,11 @@ static int xlnx_mix_crtc_create(struct xlnx_mix *mixer)
 		goto err_pixel_clk;
 	}
 	drm_crtc_helper_add(&crtc->crtc, &xlnx_mix_crtc_helper_funcs);
+	ret = xlnx_crtc_create_present_properties(crtc);
+	if (ret) {
+		drm_crtc_cleanup(&crtc->crtc);
+		goto err_pixel_clk;
+	}
 	crtc->get_max_width = &xlnx_mix_crtc_get_max_width;
 	crtc->get_max_height = &xlnx_mix_crtc_get_max_height;
 	crtc->get_align = &xlnx_mix_crtc_get_align;
@@ -3056,6 +3543,9 @@ static int xlnx_mix_bind(struct device *dev, struct device *master,
 	if (ret)
 		return ret;
 	ret = xlnx_mix_crtc_create(mixer);
+	if (ret)
+		return ret;
+	ret = xlnx_mix_wb_create(dev, mixer);
 	if (ret)
 		return ret;
 	xlnx_mix_init(&mixer->mixer_hw);
@@ -3075,6 +3565,10 @@ static void xlnx_mix_unbind(struct device *dev, struct device *master,
 				dma_release_channel(mixer->planes[i].dma[j].chan);
 		}
 	}
+	if (mixer->wb.chan) {
+		xlnx_mix_wb_disable(mixer);
+		dma_release_channel(mixer->wb.chan);
+	}
 
 	dev_set_drvdata(dev, NULL);
 	xlnx_mix_intrpt_disable(&mixer->mixer_hw);
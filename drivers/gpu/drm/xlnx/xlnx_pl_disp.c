@@ -12,6 +12,7 @@
 #include <drm/drm_atomic_helper.h>
 #include <drm/drm_crtc.h>
 #include <drm/drm_crtc_helper.h>
+#include <drm/drm_damage_helper.h>
 #include <drm/drm_fb_dma_helper.h>
 #include <drm/drm_fourcc.h>
 #include <drm/drm_framebuffer.h>
@@ -40,6 +41,12 @@
  * driver by initializing DRM crtc and plane objects. The driver makes
  * an assumption that it's single plane pipeline, as multi-plane pipeline
  * would require programing beyond the DMA engine interface.
+ *
+ * When the encoder drives a display with its own frame memory, such as a
+ * DSI command mode panel, it registers as the sink of the CRTC. The DMA
+ * engine then runs one frame per descriptor instead of restarting, and each
+ * commit only sends the damaged rectangle of the plane. Nothing is read from
+ * memory while the display content doesn't change.
  */
 
 /**
@@ -158,6 +165,22 @@ static unsigned int xlnx_pl_disp_get_align(struct xlnx_crtc *xlnx_crtc)
 	return 1 << xlnx_pl_disp->chan->dma_chan->device->copy_align;
 }
 
+/**
+ * xlnx_pl_disp_get_dma_dev - Get the device performing the scanout DMA
+ * @xlnx_crtc: xlnx crtc object
+ *
+ * The frames are read by the DMA engine, so buffers need to be mapped for
+ * its device, not for the display device.
+ *
+ * Return: the DMA engine device
+ */
+static struct device *xlnx_pl_disp_get_dma_dev(struct xlnx_crtc *xlnx_crtc)
+{
+	struct xlnx_pl_disp *xlnx_pl_disp = crtc_to_dma(xlnx_crtc);
+
+	return dmaengine_get_dma_device(xlnx_pl_disp->chan->dma_chan);
+}
+
 /*
  * DRM plane functions
  */
@@ -296,11 +319,70 @@ static int xlnx_pl_disp_plane_mode_set(struct drm_plane *plane,
 	return 0;
 }
 
+/*
+ * Narrow the transfer set up by xlnx_pl_disp_plane_mode_set() down to @rect,
+ * in plane source coordinates. Partial updates are limited to single plane
+ * formats.
+ */
+static void xlnx_pl_disp_plane_set_rect(struct drm_plane *plane,
+					const struct drm_rect *rect)
+{
+	struct xlnx_pl_disp *xlnx_pl_disp = plane_to_dma(plane);
+	struct xlnx_dma_chan *xlnx_dma_chan = xlnx_pl_disp->chan;
+	struct drm_framebuffer *fb = plane->state->fb;
+	unsigned int dx = rect->x1 - (plane->state->src_x >> 16);
+	unsigned int dy = rect->y1 - (plane->state->src_y >> 16);
+
+	xlnx_dma_chan->xt.src_start += dy * fb->pitches[0] +
+		drm_format_plane_width_bytes(fb->format, 0, dx);
+	xlnx_dma_chan->xt.numf = drm_rect_height(rect);
+	xlnx_dma_chan->sgl[0].size =
+		drm_format_plane_width_bytes(fb->format, 0,
+					     drm_rect_width(rect));
+	xlnx_dma_chan->sgl[0].icg = fb->pitches[0] - xlnx_dma_chan->sgl[0].size;
+}
+
+/*
+ * Send the damaged area of the plane to the sink. Returns false if there is
+ * nothing to send.
+ */
+static bool xlnx_pl_disp_plane_update_sink(struct drm_plane *plane,
+					   struct drm_plane_state *old_state)
+{
+	struct xlnx_pl_disp *xlnx_pl_disp = plane_to_dma(plane);
+	struct xlnx_crtc_sink *sink = xlnx_pl_disp->xlnx_crtc.sink;
+	struct drm_plane_state *new_state = plane->state;
+	struct drm_rect rect, full;
+
+	drm_rect_init(&full, new_state->src_x >> 16, new_state->src_y >> 16,
+		      new_state->src_w >> 16, new_state->src_h >> 16);
+
+	if (!drm_atomic_helper_damage_merged(old_state, new_state, &rect))
+		return false;
+
+	if (new_state->fb->format->num_planes > 1)
+		rect = full;
+
+	if (sink->update(sink, &rect)) {
+		rect = full;
+		if (sink->update(sink, &rect))
+			dev_dbg(xlnx_pl_disp->dev, "sink update failed\n");
+	}
+
+	if (!drm_rect_equals(&rect, &full))
+		xlnx_pl_disp_plane_set_rect(plane, &rect);
+
+	return true;
+}
+
 static void xlnx_pl_disp_plane_atomic_update(struct drm_plane *plane,
 					     struct drm_atomic_state *state)
 {
-	int ret;
+	struct drm_plane_state *old_state =
+		drm_atomic_get_old_plane_state(state, plane);
 	struct xlnx_pl_disp *xlnx_pl_disp = plane_to_dma(plane);
+	struct drm_crtc_state *crtc_state;
+	int ret;
 
 	ret = xlnx_pl_disp_plane_mode_set(plane,
 					  plane->state->fb,
@@ -319,6 +401,21 @@ static void xlnx_pl_disp_plane_atomic_update(struct drm_plane *plane,
 	/* in case frame buffer is used set the color format */
 	xilinx_xdma_drm_config(xlnx_pl_disp->chan->dma_chan,
 			       xlnx_pl_disp->plane.state->fb->format->format);
+
+	if (xlnx_pl_disp->xlnx_crtc.sink) {
+		/* The CRTC sends the first frame when it is enabled */
+		crtc_state = drm_atomic_get_new_crtc_state(state,
+							   plane->state->crtc);
+		if (drm_atomic_crtc_needs_modeset(crtc_state))
+			return;
+
+		if (!xlnx_pl_disp_plane_update_sink(plane, old_state)) {
+			/* Complete the commit without a transfer */
+			xlnx_pl_disp_complete(xlnx_pl_disp);
+			return;
+		}
+	}
+
 	/* apply the new fb addr and enable */
 	xlnx_pl_disp_plane_enable(plane);
 }
@@ -398,6 +495,21 @@ static inline struct xlnx_pl_disp *drm_crtc_to_dma(struct drm_crtc *crtc)
 static void xlnx_pl_disp_crtc_atomic_begin(struct drm_crtc *crtc,
 					   struct drm_atomic_state *state)
 {
+	struct drm_crtc_state *old_state =
+		drm_atomic_get_old_crtc_state(state, crtc);
+	struct drm_crtc_state *new_state =
+		drm_atomic_get_new_crtc_state(state, crtc);
+	struct xlnx_pl_disp *xlnx_pl_disp = drm_crtc_to_dma(crtc);
+	struct videomode vm;
+
+	/* Frame rate switch accepted by atomic_check without a mode set */
+	if (!drm_atomic_crtc_needs_modeset(new_state) &&
+	    old_state->adjusted_mode.vtotal !=
+	    new_state->adjusted_mode.vtotal) {
+		drm_display_mode_to_videomode(&new_state->adjusted_mode, &vm);
+		xlnx_bridge_set_vblank(xlnx_pl_disp->vtc_bridge, &vm);
+	}
+
 	drm_crtc_vblank_on(crtc);
 	spin_lock_irq(&crtc->dev->event_lock);
 	if (crtc->state->event) {
@@ -425,7 +537,9 @@ static void xlnx_pl_disp_crtc_atomic_enable(struct drm_crtc *crtc,
 	int vrefresh;
 	struct xlnx_crtc *xlnx_crtc = to_xlnx_crtc(crtc);
 	struct xlnx_pl_disp *xlnx_pl_disp = crtc_to_dma(xlnx_crtc);
+	struct drm_plane_state *plane_state = crtc->primary->state;
 	struct videomode vm;
+	struct drm_rect rect;
 
 	if (xlnx_pl_disp->vtc_bridge) {
 		/* set video timing */
@@ -434,6 +548,17 @@ static void xlnx_pl_disp_crtc_atomic_enable(struct drm_crtc *crtc,
 		xlnx_bridge_enable(xlnx_pl_disp->vtc_bridge);
 	}
 
+	if (xlnx_crtc->sink) {
+		/* One frame per descriptor, starting with the whole frame */
+		xilinx_xdma_set_mode(xlnx_pl_disp->chan->dma_chan, DEFAULT);
+		drm_rect_init(&rect, plane_state->src_x >> 16,
+			      plane_state->src_y >> 16,
+			      plane_state->src_w >> 16,
+			      plane_state->src_h >> 16);
+		if (xlnx_crtc->sink->update(xlnx_crtc->sink, &rect))
+			dev_dbg(xlnx_pl_disp->dev, "sink update failed\n");
+	}
+
 	xlnx_pl_disp_plane_enable(crtc->primary);
 
 	/* Delay of 1 vblank interval for timing gen to be stable */
@@ -449,15 +574,53 @@ static void xlnx_pl_disp_crtc_atomic_disable(struct drm_crtc *crtc,
 	struct xlnx_pl_disp *xlnx_pl_disp = crtc_to_dma(xlnx_crtc);
 
 	xlnx_pl_disp_plane_disable(crtc->primary);
+	xilinx_xdma_set_mode(xlnx_pl_disp->chan->dma_chan, AUTO_RESTART);
 	xlnx_pl_disp_clear_event(crtc);
 	drm_crtc_vblank_off(crtc);
 	if (xlnx_pl_disp->vtc_bridge)
 		xlnx_bridge_disable(xlnx_pl_disp->vtc_bridge);
 }
 
+/*
+ * Modes that only differ by their vertical front porch run at the same pixel
+ * clock and line length, so they can be switched by the timing generator.
+ */
+static bool xlnx_pl_disp_vblank_only(const struct drm_display_mode *a,
+				     const struct drm_display_mode *b)
+{
+	return a->clock == b->clock && a->flags == b->flags &&
+	       a->hdisplay == b->hdisplay &&
+	       a->hsync_start == b->hsync_start &&
+	       a->hsync_end == b->hsync_end && a->htotal == b->htotal &&
+	       a->vdisplay == b->vdisplay &&
+	       a->vsync_end - a->vsync_start == b->vsync_end - b->vsync_start &&
+	       a->vtotal - a->vsync_end == b->vtotal - b->vsync_end;
+}
+
 static int xlnx_pl_disp_crtc_atomic_check(struct drm_crtc *crtc,
 					  struct drm_atomic_state *state)
 {
+	struct drm_crtc_state *old_state =
+		drm_atomic_get_old_crtc_state(state, crtc);
+	struct drm_crtc_state *new_state =
+		drm_atomic_get_new_crtc_state(state, crtc);
+	struct xlnx_pl_disp *xlnx_pl_disp = drm_crtc_to_dma(crtc);
+	struct xlnx_bridge *vtc = xlnx_pl_disp->vtc_bridge;
+
+	/*
+	 * With VRR enabled, change the frame rate by adjusting the vertical
+	 * blanking of the running timing generator instead of a full mode
+	 * set, which would blank the output.
+	 */
+	if (new_state->vrr_enabled && vtc && vtc->set_vblank &&
+	    new_state->mode_changed && old_state->active &&
+	    new_state->active && !new_state->active_changed &&
+	    !new_state->connectors_changed &&
+	    !(new_state->adjusted_mode.flags & DRM_MODE_FLAG_INTERLACE) &&
+	    xlnx_pl_disp_vblank_only(&old_state->adjusted_mode,
+				     &new_state->adjusted_mode))
+		new_state->mode_changed = false;
+
 	return drm_atomic_add_affected_planes(state, crtc);
 }
 
@@ -499,6 +662,34 @@ static void xlnx_pl_disp_crtc_disable_vblank(struct drm_crtc *crtc)
 	xlnx_pl_disp->callback_param = NULL;
 }
 
+static int
+xlnx_pl_disp_crtc_atomic_set_property(struct drm_crtc *crtc,
+				      struct drm_crtc_state *state,
+				      struct drm_property *property,
+				      uint64_t val)
+{
+	int ret;
+
+	ret = xlnx_crtc_atomic_set_present_property(crtc, state, property,
+						    val);
+
+	return ret == -ENOENT ? -EINVAL : ret;
+}
+
+static int
+xlnx_pl_disp_crtc_atomic_get_property(struct drm_crtc *crtc,
+				      const struct drm_crtc_state *state,
+				      struct drm_property *property,
+				      uint64_t *val)
+{
+	int ret;
+
+	ret = xlnx_crtc_atomic_get_present_property(crtc, state, property,
+						    val);
+
+	return ret == -ENOENT ? -EINVAL : ret;
+}
+
 static struct drm_crtc_funcs xlnx_pl_disp_crtc_funcs = {
 	.destroy = xlnx_pl_disp_crtc_destroy,
 	.set_config = drm_atomic_helper_set_config,
@@ -508,6 +699,8 @@ static struct drm_crtc_funcs xlnx_pl_disp_crtc_funcs = {
 	.atomic_destroy_state = drm_atomic_helper_crtc_destroy_state,
 	.enable_vblank = xlnx_pl_disp_crtc_enable_vblank,
 	.disable_vblank = xlnx_pl_disp_crtc_disable_vblank,
+	.atomic_set_property = xlnx_pl_disp_crtc_atomic_set_property,
+	.atomic_get_property = xlnx_pl_disp_crtc_atomic_get_property,
 };
 
 static int xlnx_pl_disp_bind(struct device *dev, struct device *master,
@@ -533,6 +726,7 @@ static int xlnx_pl_disp_bind(struct device *dev, struct device *master,
 
 	drm_plane_helper_add(&xlnx_pl_disp->plane,
 			     &xlnx_pl_disp_plane_helper_funcs);
+	drm_plane_enable_fb_damage_clips(&xlnx_pl_disp->plane);
 
 	ret = drm_crtc_init_with_planes(drm, &xlnx_pl_disp->xlnx_crtc.crtc,
 					&xlnx_pl_disp->plane, NULL,
@@ -546,6 +740,7 @@ static int xlnx_pl_disp_bind(struct device *dev, struct device *master,
 			    &xlnx_pl_disp_crtc_helper_funcs);
 	xlnx_pl_disp->xlnx_crtc.get_format = &xlnx_pl_disp_get_format;
 	xlnx_pl_disp->xlnx_crtc.get_align = &xlnx_pl_disp_get_align;
+	xlnx_pl_disp->xlnx_crtc.get_dma_dev = &xlnx_pl_disp_get_dma_dev;
 	xlnx_pl_disp->drm = drm;
 
 	xlnx_pl_disp->fid_err_prop = drm_property_create_bool(xlnx_pl_disp->drm,
@@ -555,6 +750,13 @@ static int xlnx_pl_disp_bind(struct device *dev, struct device *master,
 	drm_object_attach_property(obj, xlnx_pl_disp->fid_err_prop, 0);
 	drm_object_attach_property(obj, xlnx_pl_disp->fid_out_prop, 0);
 
+	ret = xlnx_crtc_create_present_properties(&xlnx_pl_disp->xlnx_crtc);
+	if (ret) {
+		drm_crtc_cleanup(&xlnx_pl_disp->xlnx_crtc.crtc);
+		drm_plane_cleanup(&xlnx_pl_disp->plane);
+		return ret;
+	}
+
 	xlnx_crtc_register(xlnx_pl_disp->drm, &xlnx_pl_disp->xlnx_crtc);
 
 	return 0;
@@ -326,6 +326,55 @@ static int xlnx_vtc_set_timing(struct xlnx_bridge *bridge,
 	return 0;
 }
 
+/**
+ * xlnx_vtc_set_vblank - Change the vertical blanking of the running VTC
+ * @bridge: xilinx bridge structure pointer
+ * @vm: video mode requested
+ *
+ * Return:
+ * Zero on success, -EINVAL for interlaced modes.
+ *
+ * This function only reprograms the frame height and the vertical sync
+ * position, which move with the front porch. The register update is
+ * latched by the generator at the next frame boundary, so the output
+ * changes frame rate without losing sync.
+ */
+static int xlnx_vtc_set_vblank(struct xlnx_bridge *bridge,
+			       struct videomode *vm)
+{
+	u32 reg;
+	u32 vtotal, vsync_start, vbackporch_start;
+	struct xlnx_vtc *vtc = bridge_to_vtc(bridge);
+
+	if (vm->flags & DISPLAY_FLAGS_INTERLACED)
+		return -EINVAL;
+
+	vtotal = vm->vactive + vm->vfront_porch + vm->vsync_len +
+		 vm->vback_porch;
+	vsync_start = vm->vactive + vm->vfront_porch;
+	vbackporch_start = vsync_start + vm->vsync_len;
+
+	dev_dbg(vtc->dev, "vt: %d, vs: %d, vb: %d\n", vtotal, vsync_start,
+		vbackporch_start);
+
+	reg = xlnx_vtc_readl(vtc->base, XVTC_CTL);
+	xlnx_vtc_writel(vtc->base, XVTC_CTL, reg & ~XVTC_CTL_RU);
+
+	reg = vtotal & XVTC_GVFRAME_HSIZE_F1;
+	reg |= reg << XVTC_GV1_BPSTART_SHIFT;
+	xlnx_vtc_writel(vtc->base, XVTC_GVSIZE, reg);
+
+	reg = vsync_start & XVTC_GV1_SYNCSTART_MASK;
+	reg |= (vbackporch_start << XVTC_GV1_BPSTART_SHIFT) &
+	       XVTC_GV1_BPSTART_MASK;
+	xlnx_vtc_writel(vtc->base, XVTC_GVSYNC_F0, reg);
+
+	reg = xlnx_vtc_readl(vtc->base, XVTC_CTL);
+	xlnx_vtc_writel(vtc->base, XVTC_CTL, reg | XVTC_CTL_RU);
+
+	return 0;
+}
+
 static int xlnx_vtc_probe(struct platform_device *pdev)
 {
 	struct device *dev = &pdev->dev;
@@ -392,6 +441,7 @@ static int xlnx_vtc_probe(struct platform_device *pdev)
 	vtc->bridge.enable = &xlnx_vtc_enable;
 	vtc->bridge.disable = &xlnx_vtc_disable;
 	vtc->bridge.set_timing = &xlnx_vtc_set_timing;
+	vtc->bridge.set_vblank = &xlnx_vtc_set_vblank;
 	vtc->bridge.of_node = dev->of_node;
 	ret = xlnx_bridge_register(&vtc->bridge);
 	if (ret) {
@@ -93,6 +93,8 @@ static const u32 zynqmp_disp_gfx_init_fmts[] = {
 
 #define ZYNQMP_DISP_NUM_LAYERS				2
 #define ZYNQMP_DISP_MAX_NUM_SUB_PLANES			3
+/* Vblanks to wait for the DPDMA to latch a flip before sending the event */
+#define ZYNQMP_DISP_FLIP_TIMEOUT			3
 /*
  * 3840x2160 is advertised max resolution, but almost any resolutions under
  * 300Mhz pixel rate would work. Thus put 4096 as maximum width and height.
@@ -137,12 +139,16 @@ enum zynqmp_disp_layer_mode {
  * @is_active: flag if the DMA is active
  * @xt: Interleaved desc config container
  * @sgl: Data chunk for dma_interleaved_template
+ * @cookie: cookie of the last submitted descriptor
+ * @prev_cookie: cookie of the descriptor replaced by @cookie, if any
  */
 struct zynqmp_disp_layer_dma {
 	struct dma_chan *chan;
 	bool is_active;
 	struct dma_interleaved_template xt;
 	struct data_chunk sgl[1];
+	dma_cookie_t cookie;
+	dma_cookie_t prev_cookie;
 };
 
 /**
@@ -234,7 +240,8 @@ struct zynqmp_disp_aud {
  * @bg_c2: current value of 3rd background color component
  * @tpg_prop: Test Pattern Generation mode property
  * @tpg_on: current TPG mode state
- * @event: pending vblank event request
+ * @event: pending vblank event request, sent once the flip is latched
+ * @event_vblank: vblank count when @event was queued
  * @_ps_pclk: Pixel clock from PS
  * @_pl_pclk: Pixel clock from PL
  * @pclk: Pixel clock
@@ -246,6 +253,10 @@ struct zynqmp_disp_aud {
  * @aclk: APB clock
  * @aclk_en: Flag if the APB clock is enabled
  * @vtc_bridge: vtc_bridge structure
+ * @live_plane: plane for the live video input, if @live_bridge is set
+ * @live_bridge: PL pipeline feeding the live video input
+ * @live_fmts: Array of DRM formats of the live video input
+ * @num_live_fmts: Number of DRM formats of the live video input
  */
 struct zynqmp_disp {
 	struct xlnx_crtc xlnx_crtc;
@@ -272,6 +283,7 @@ struct zynqmp_disp {
 	struct drm_property *tpg_prop;
 	bool tpg_on;
 	struct drm_pending_vblank_event *event;
+	u64 event_vblank;
 	/* Don't operate directly on _ps_ */
 	struct clk *_ps_pclk;
 	struct clk *_pl_pclk;
@@ -284,6 +296,10 @@ struct zynqmp_disp {
 	struct clk *aclk;
 	bool aclk_en;
 	struct xlnx_bridge *vtc_bridge;
+	struct drm_plane live_plane;
+	struct xlnx_bridge *live_bridge;
+	u32 *live_fmts;
+	unsigned int num_live_fmts;
 };
 
 /**
@@ -986,6 +1002,8 @@ static const struct zynqmp_disp_fmt av_buf_gfx_fmts[] = {
  * - BPC: 6, 8, 10, 12
  * - Swap: Cb and Cr swap
  * which can be 32 bus formats. Only list the subset of those for now.
+ * The DRM format, if any, is the one the live plane exposes for the bus
+ * format.
  */
 static const struct zynqmp_disp_fmt av_buf_live_fmts[] = {
 	{
@@ -999,6 +1017,7 @@ static const struct zynqmp_disp_fmt av_buf_live_fmts[] = {
 		.sf[1]		= ZYNQMP_DISP_AV_BUF_6BIT_SF,
 		.sf[2]		= ZYNQMP_DISP_AV_BUF_6BIT_SF,
 	}, {
+		.drm_fmt	= DRM_FORMAT_RGB888,
 		.bus_fmt	= MEDIA_BUS_FMT_RBG888_1X24,
 		.disp_fmt	= ZYNQMP_DISP_AV_BUF_LIVE_CONFIG_BPC_8 |
 				  ZYNQMP_DISP_AV_BUF_LIVE_CONFIG_FMT_RGB,
@@ -1009,6 +1028,7 @@ static const struct zynqmp_disp_fmt av_buf_live_fmts[] = {
 		.sf[1]		= ZYNQMP_DISP_AV_BUF_8BIT_SF,
 		.sf[2]		= ZYNQMP_DISP_AV_BUF_8BIT_SF,
 	}, {
+		.drm_fmt	= DRM_FORMAT_UYVY,
 		.bus_fmt	= MEDIA_BUS_FMT_UYVY8_1X16,
 		.disp_fmt	= ZYNQMP_DISP_AV_BUF_LIVE_CONFIG_BPC_8 |
 				  ZYNQMP_DISP_AV_BUF_LIVE_CONFIG_FMT_YUV422,
@@ -1019,6 +1039,7 @@ static const struct zynqmp_disp_fmt av_buf_live_fmts[] = {
 		.sf[1]		= ZYNQMP_DISP_AV_BUF_8BIT_SF,
 		.sf[2]		= ZYNQMP_DISP_AV_BUF_8BIT_SF,
 	}, {
+		.drm_fmt	= DRM_FORMAT_VUY888,
 		.bus_fmt	= MEDIA_BUS_FMT_VUY8_1X24,
 		.disp_fmt	= ZYNQMP_DISP_AV_BUF_LIVE_CONFIG_BPC_8 |
 				  ZYNQMP_DISP_AV_BUF_LIVE_CONFIG_FMT_YUV444,
@@ -1679,6 +1700,125 @@ static void zynqmp_disp_layer_get_fmts(struct zynqmp_disp *disp,
 	*num_fmts = layer->num_fmts;
 }
 
+/**
+ * zynqmp_disp_flip_latched - Check if the DPDMA has latched all queued flips
+ * @disp: Display subsystem
+ *
+ * The DPDMA replaces its repeating descriptor at the vsync following the
+ * submission, and completes the replaced descriptor at that point. A flip is
+ * latched once the descriptor it replaces is complete.
+ *
+ * Return: true if all layers are scanning out the last submitted descriptors
+ */
+static bool zynqmp_disp_flip_latched(struct zynqmp_disp *disp)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < ZYNQMP_DISP_NUM_LAYERS; i++) {
+		struct zynqmp_disp_layer *layer = &disp->layers[i];
+
+		for (j = 0; j < layer->num_chan; j++) {
+			struct zynqmp_disp_layer_dma *dma = &layer->dma[j];
+
+			if (!dma->chan || !dma->is_active || !dma->prev_cookie)
+				continue;
+
+			if (dma_async_is_tx_complete(dma->chan, dma->prev_cookie,
+						     NULL, NULL) != DMA_COMPLETE)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * zynqmp_disp_finish_flip - Send the pending vblank event if the flip is done
+ * @disp: Display subsystem
+ *
+ * The DP vblank interrupt and the DPDMA vsync interrupt race with each other,
+ * so this is called from both. The event is sent with the timestamp of the
+ * vblank at which the DPDMA latched the new buffers, whichever side runs
+ * last. If the DPDMA doesn't latch the flip in time, the event is sent anyway
+ * so the commit doesn't stall.
+ */
+static void zynqmp_disp_finish_flip(struct zynqmp_disp *disp)
+{
+	struct drm_crtc *crtc = &disp->xlnx_crtc.crtc;
+	struct drm_pending_vblank_event *event;
+	unsigned long flags;
+	u64 count;
+
+	spin_lock_irqsave(&crtc->dev->event_lock, flags);
+	event = disp->event;
+	if (!event)
+		goto out;
+
+	count = drm_crtc_vblank_count(crtc) - disp->event_vblank;
+	if (!count)
+		goto out;
+
+	if (!zynqmp_disp_flip_latched(disp) &&
+	    count < ZYNQMP_DISP_FLIP_TIMEOUT)
+		goto out;
+
+	disp->event = NULL;
+	drm_crtc_send_vblank_event(crtc, event);
+	drm_crtc_vblank_put(crtc);
+out:
+	spin_unlock_irqrestore(&crtc->dev->event_lock, flags);
+}
+
+static void zynqmp_disp_layer_dma_done(void *param)
+{
+	struct zynqmp_disp_layer *layer = param;
+
+	zynqmp_disp_finish_flip(layer->disp);
+}
+
+/**
+ * zynqmp_disp_layer_queue_dma - Queue the layer buffers to the DMA
+ * @disp: Display subsystem
+ * @layer: layer to queue
+ *
+ * Submit a repeating descriptor for each active channel of @layer. The DPDMA
+ * switches to it at the next vsync, so this is also used to flip buffers.
+ *
+ * Return: 0 on success, otherwise error code.
+ */
+static int zynqmp_disp_layer_queue_dma(struct zynqmp_disp *disp,
+				       struct zynqmp_disp_layer *layer)
+{
+	struct dma_async_tx_descriptor *desc;
+	unsigned long flags;
+	unsigned int i;
+
+	flags = DMA_CTRL_ACK | DMA_PREP_INTERRUPT | DMA_PREP_REPEAT |
+		DMA_PREP_LOAD_EOT;
+
+	for (i = 0; i < ZYNQMP_DISP_MAX_NUM_SUB_PLANES; i++) {
+		struct zynqmp_disp_layer_dma *dma = &layer->dma[i];
+
+		if (!dma->chan || !dma->is_active)
+			continue;
+
+		desc = dmaengine_prep_interleaved_dma(dma->chan, &dma->xt,
+						      flags);
+		if (!desc) {
+			dev_err(disp->dev, "failed to prep DMA descriptor\n");
+			return -ENOMEM;
+		}
+
+		desc->callback = zynqmp_disp_layer_dma_done;
+		desc->callback_param = layer;
+		dma->prev_cookie = dma->cookie;
+		dma->cookie = dmaengine_submit(desc);
+		dma_async_issue_pending(dma->chan);
+	}
+
+	return 0;
+}
+
 /**
  * zynqmp_disp_layer_enable - Enable the layer
  * @disp: Display subsystem
@@ -1694,9 +1834,6 @@ static int zynqmp_disp_layer_enable(struct zynqmp_disp *disp,
 				    enum zynqmp_disp_layer_mode mode)
 {
 	struct device *dev = disp->dev;
-	struct dma_async_tx_descriptor *desc;
-	unsigned long flags;
-	unsigned int i;
 
 	if (layer->enabled && layer->mode != mode) {
 		dev_err(dev, "layer is already enabled in different mode\n");
@@ -1712,25 +1849,7 @@ static int zynqmp_disp_layer_enable(struct zynqmp_disp *disp,
 	if (mode == ZYNQMP_DISP_LAYER_LIVE)
 		return 0;
 
-	for (i = 0; i < ZYNQMP_DISP_MAX_NUM_SUB_PLANES; i++) {
-		struct zynqmp_disp_layer_dma *dma = &layer->dma[i];
-
-		if (dma->chan && dma->is_active) {
-			flags = DMA_CTRL_ACK | DMA_PREP_INTERRUPT | DMA_PREP_REPEAT |
-				DMA_PREP_LOAD_EOT;
-			desc = dmaengine_prep_interleaved_dma(dma->chan,
-							      &dma->xt, flags);
-			if (!desc) {
-				dev_err(dev, "failed to prep DMA descriptor\n");
-				return -ENOMEM;
-			}
-
-			dmaengine_submit(desc);
-			dma_async_issue_pending(dma->chan);
-		}
-	}
-
-	return 0;
+	return zynqmp_disp_layer_queue_dma(disp, layer);
 }
 
 /**
@@ -1755,9 +1874,17 @@ static int zynqmp_disp_layer_disable(struct zynqmp_disp *disp,
 		return -EBUSY;
 	}
 
-	for (i = 0; i < ZYNQMP_DISP_MAX_NUM_SUB_PLANES; i++)
+	/*
+	 * Don't wait for the DMA to stop, the channel completes the stop on
+	 * its own and queues the next frame once stopped. The buffers are only
+	 * released after the next vblank, when the channel is idle.
+	 */
+	for (i = 0; i < ZYNQMP_DISP_MAX_NUM_SUB_PLANES; i++) {
 		if (layer->dma[i].chan && layer->dma[i].is_active)
-			dmaengine_terminate_sync(layer->dma[i].chan);
+			dmaengine_terminate_async(layer->dma[i].chan);
+		layer->dma[i].cookie = 0;
+		layer->dma[i].prev_cookie = 0;
+	}
 
 	zynqmp_disp_av_buf_disable_vid(&disp->av_buf, layer);
 	zynqmp_disp_blend_layer_disable(&disp->blend, layer);
@@ -1817,7 +1944,7 @@ static void zynqmp_disp_layer_release_dma(struct zynqmp_disp *disp,
 	for (i = 0; i < layer->num_chan; i++) {
 		if (layer->dma[i].chan) {
 			/* Make sure the channel is terminated before release */
-			dmaengine_terminate_all(layer->dma[i].chan);
+			dmaengine_terminate_sync(layer->dma[i].chan);
 			dma_release_channel(layer->dma[i].chan);
 		}
 	}
@@ -2097,6 +2224,7 @@ void zynqmp_disp_handle_vblank(struct zynqmp_disp *disp)
 	struct drm_crtc *crtc = &disp->xlnx_crtc.crtc;
 
 	drm_crtc_handle_vblank(crtc);
+	zynqmp_disp_finish_flip(disp);
 }
 
 /**
@@ -2357,6 +2485,76 @@ static struct drm_plane_funcs zynqmp_disp_plane_funcs = {
 	.atomic_destroy_state	= drm_atomic_helper_plane_destroy_state,
 };
 
+/**
+ * zynqmp_disp_plane_is_flip - Check if an update only changes the buffer
+ * @plane: DRM plane
+ * @old_state: plane state programmed in the hardware
+ * @new_state: new plane state
+ *
+ * Return: true if @new_state only differs from @old_state by the memory
+ * backing the framebuffer, and the layer can simply be flipped.
+ */
+static bool zynqmp_disp_plane_is_flip(struct drm_plane *plane,
+				      struct drm_plane_state *old_state,
+				      struct drm_plane_state *new_state)
+{
+	struct zynqmp_disp_layer *layer = plane_to_layer(plane);
+	const struct drm_format_info *info;
+	unsigned int i;
+
+	if (!layer->enabled || layer->mode != ZYNQMP_DISP_LAYER_NONLIVE ||
+	    !old_state->fb || !new_state->fb)
+		return false;
+
+	info = new_state->fb->format;
+	if (old_state->fb->format->format != info->format)
+		return false;
+
+	for (i = 0; i < info->num_planes; i++)
+		if (old_state->fb->pitches[i] != new_state->fb->pitches[i])
+			return false;
+
+	return old_state->crtc_x == new_state->crtc_x &&
+	       old_state->crtc_y == new_state->crtc_y &&
+	       old_state->crtc_w == new_state->crtc_w &&
+	       old_state->crtc_h == new_state->crtc_h &&
+	       old_state->src_x == new_state->src_x &&
+	       old_state->src_y == new_state->src_y &&
+	       old_state->src_w == new_state->src_w &&
+	       old_state->src_h == new_state->src_h;
+}
+
+/**
+ * zynqmp_disp_plane_flip - Flip the layer to a new framebuffer
+ * @plane: DRM plane
+ * @state: new plane state
+ *
+ * Only the source addresses of the DPDMA descriptors are updated. The new
+ * descriptors replace the current ones at the next vsync, without touching
+ * the layer format, the blender or the AV buffer manager.
+ *
+ * Return: 0 on success, otherwise error code.
+ */
+static int zynqmp_disp_plane_flip(struct drm_plane *plane,
+				  struct drm_plane_state *state)
+{
+	struct zynqmp_disp_layer *layer = plane_to_layer(plane);
+	const struct drm_format_info *info = state->fb->format;
+	dma_addr_t paddr;
+	unsigned int i;
+
+	for (i = 0; i < info->num_planes; i++) {
+		paddr = drm_fb_dma_get_gem_addr(state->fb, state, i);
+		if (!paddr) {
+			dev_err(layer->disp->dev, "failed to get a paddr\n");
+			return -EINVAL;
+		}
+		layer->dma[i].xt.src_start = paddr;
+	}
+
+	return zynqmp_disp_layer_queue_dma(layer->disp, layer);
+}
+
 static void
 zynqmp_disp_plane_atomic_update(struct drm_plane *plane,
 				struct drm_atomic_state *state)
@@ -2378,6 +2576,11 @@ zynqmp_disp_plane_atomic_update(struct drm_plane *plane,
 	    plane->state->src_h == old_state->src_h)
 		return;
 
+	if (zynqmp_disp_plane_is_flip(plane, old_state, plane->state)) {
+		zynqmp_disp_plane_flip(plane, plane->state);
+		return;
+	}
+
 	if (old_state->fb &&
 	    old_state->fb->format->format != plane->state->fb->format->format)
 		zynqmp_disp_plane_disable(plane);
@@ -2404,6 +2607,53 @@ zynqmp_disp_plane_atomic_disable(struct drm_plane *plane,
 	zynqmp_disp_plane_disable(plane);
 }
 
+/**
+ * zynqmp_disp_check_vid_layer - Check the users of the video layer
+ * @disp: Display subsystem
+ * @state: atomic state
+ *
+ * The memory video plane and the live plane share the video layer, so only
+ * one of them can be enabled at a time.
+ *
+ * Return: 0 on success, -EBUSY if both planes are enabled, or an error code
+ * if a plane state can't be acquired.
+ */
+static int zynqmp_disp_check_vid_layer(struct zynqmp_disp *disp,
+				       struct drm_atomic_state *state)
+{
+	struct drm_plane *plane = &disp->layers[ZYNQMP_DISP_LAYER_VID].plane;
+	struct drm_plane_state *vid_state, *live_state;
+
+	if (!disp->live_bridge)
+		return 0;
+
+	vid_state = drm_atomic_get_plane_state(state, plane);
+	if (IS_ERR(vid_state))
+		return PTR_ERR(vid_state);
+
+	live_state = drm_atomic_get_plane_state(state, &disp->live_plane);
+	if (IS_ERR(live_state))
+		return PTR_ERR(live_state);
+
+	if (vid_state->crtc && live_state->crtc) {
+		dev_dbg(disp->dev, "video layer is used by the live plane\n");
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
+static int zynqmp_disp_plane_atomic_check(struct drm_plane *plane,
+					  struct drm_atomic_state *state)
+{
+	struct zynqmp_disp_layer *layer = plane_to_layer(plane);
+
+	if (layer->id != ZYNQMP_DISP_LAYER_VID)
+		return 0;
+
+	return zynqmp_disp_check_vid_layer(layer->disp, state);
+}
+
 static int zynqmp_disp_plane_atomic_async_check(struct drm_plane *plane,
 						struct drm_atomic_state *state)
 {
@@ -2416,10 +2666,13 @@ zynqmp_disp_plane_atomic_async_update(struct drm_plane *plane,
 {
 	int ret;
 	struct drm_plane_state *new_state = drm_atomic_get_new_plane_state(state, plane);
+	bool flip;
 
 	if (plane->state->fb == new_state->fb)
 		return;
 
+	flip = zynqmp_disp_plane_is_flip(plane, plane->state, new_state);
+
 	if (plane->state->fb &&
 	    plane->state->fb->format->format != new_state->fb->format->format)
 		zynqmp_disp_plane_disable(plane);
@@ -2437,6 +2690,11 @@ zynqmp_disp_plane_atomic_async_update(struct drm_plane *plane,
 	plane->state->src_h = new_state->src_h;
 	plane->state->state = new_state->state;
 
+	if (flip) {
+		zynqmp_disp_plane_flip(plane, plane->state);
+		return;
+	}
+
 	ret = zynqmp_disp_plane_mode_set(plane, plane->state->fb,
 					 plane->state->crtc_x,
 					 plane->state->crtc_y,
@@ -2453,6 +2711,7 @@ zynqmp_disp_plane_atomic_async_update(struct drm_plane *plane,
 }
 
 static const struct drm_plane_helper_funcs zynqmp_disp_plane_helper_funcs = {
+	.atomic_check		= zynqmp_disp_plane_atomic_check,
 	.atomic_update		= zynqmp_disp_plane_atomic_update,
 	.atomic_disable		= zynqmp_disp_plane_atomic_disable,
 	.atomic_async_check	= zynqmp_disp_plane_atomic_async_check,
@@ -2480,6 +2739,7 @@ static int zynqmp_disp_create_plane(struct zynqmp_disp *disp)
 			goto err_plane;
 		drm_plane_helper_add(&layer->plane,
 				     &zynqmp_disp_plane_helper_funcs);
+		drm_plane_enable_fb_damage_clips(&layer->plane);
 		type = DRM_PLANE_TYPE_PRIMARY;
 	}
 
@@ -2636,6 +2896,16 @@ zynqmp_disp_crtc_atomic_disable(struct drm_crtc *crtc,
 	zynqmp_disp_clk_disable(disp->pclk, &disp->pclk_en);
 	zynqmp_disp_plane_disable(crtc->primary);
 	zynqmp_disp_disable(disp, true);
+
+	/* No more vblanks are coming, don't hold the event any longer */
+	spin_lock_irq(&crtc->dev->event_lock);
+	if (disp->event) {
+		drm_crtc_send_vblank_event(crtc, disp->event);
+		drm_crtc_vblank_put(crtc);
+		disp->event = NULL;
+	}
+	spin_unlock_irq(&crtc->dev->event_lock);
+
 	if (!disp->dpsub->external_crtc_attached)
 		drm_crtc_vblank_off(crtc);
 	pm_runtime_put_sync(disp->dev);
@@ -2652,15 +2922,38 @@ zynqmp_disp_crtc_atomic_begin(struct drm_crtc *crtc,
 			      struct drm_atomic_state *state)
 {
 	drm_crtc_vblank_on(crtc);
-	/* Don't rely on vblank when disabling crtc */
-	spin_lock_irq(&crtc->dev->event_lock);
-	if (crtc->state->event) {
-		/* Consume the flip_done event from atomic helper */
-		crtc->state->event->pipe = drm_crtc_index(crtc);
-		WARN_ON(drm_crtc_vblank_get(crtc) != 0);
-		drm_crtc_arm_vblank_event(crtc, crtc->state->event);
-		crtc->state->event = NULL;
+}
+
+static void
+zynqmp_disp_crtc_atomic_flush(struct drm_crtc *crtc,
+			      struct drm_atomic_state *state)
+{
+	struct zynqmp_disp *disp = crtc_to_disp(crtc);
+	struct drm_pending_vblank_event *event = crtc->state->event;
+
+	if (!event)
+		return;
+
+	/*
+	 * Consume the flip_done event from atomic helper. The planes are
+	 * queued to the DPDMA by now, and the event is held until the DPDMA
+	 * latches them, so it carries the timestamp of the vblank at which the
+	 * new buffers are actually scanned out.
+	 */
+	crtc->state->event = NULL;
+	event->pipe = drm_crtc_index(crtc);
+
+	if (!crtc->state->active || drm_crtc_vblank_get(crtc)) {
+		spin_lock_irq(&crtc->dev->event_lock);
+		drm_crtc_send_vblank_event(crtc, event);
+		spin_unlock_irq(&crtc->dev->event_lock);
+		return;
 	}
+
+	spin_lock_irq(&crtc->dev->event_lock);
+	WARN_ON(disp->event);
+	disp->event = event;
+	disp->event_vblank = drm_crtc_vblank_count(crtc);
 	spin_unlock_irq(&crtc->dev->event_lock);
 }
 
@@ -2669,6 +2962,7 @@ static struct drm_crtc_helper_funcs zynqmp_disp_crtc_helper_funcs = {
 	.atomic_disable	= zynqmp_disp_crtc_atomic_disable,
 	.atomic_check	= zynqmp_disp_crtc_atomic_check,
 	.atomic_begin	= zynqmp_disp_crtc_atomic_begin,
+	.atomic_flush	= zynqmp_disp_crtc_atomic_flush,
 };
 
 static void zynqmp_disp_crtc_destroy(struct drm_crtc *crtc)
@@ -2700,6 +2994,12 @@ zynqmp_disp_crtc_atomic_set_property(struct drm_crtc *crtc,
 				     uint64_t val)
 {
 	struct zynqmp_disp *disp = crtc_to_disp(crtc);
+	int ret;
+
+	ret = xlnx_crtc_atomic_set_present_property(crtc, state, property,
+						    val);
+	if (ret != -ENOENT)
+		return ret;
 
 	/*
 	 * CRTC prop values are just stored here and applied when CRTC gets
@@ -2726,6 +3026,12 @@ zynqmp_disp_crtc_atomic_get_property(struct drm_crtc *crtc,
 				     uint64_t *val)
 {
 	struct zynqmp_disp *disp = crtc_to_disp(crtc);
+	int ret;
+
+	ret = xlnx_crtc_atomic_get_present_property(crtc, state, property,
+						    val);
+	if (ret != -ENOENT)
+		return ret;
 
 	if (property == disp->color_prop)
 		*val = disp->color;
@@ -2776,6 +3082,11 @@ static int zynqmp_disp_create_crtc(struct zynqmp_disp *disp)
 	drm_object_attach_property(obj, disp->bg_c0_prop, 0);
 	drm_object_attach_property(obj, disp->bg_c1_prop, 0);
 	drm_object_attach_property(obj, disp->bg_c2_prop, 0);
+	ret = xlnx_crtc_create_present_properties(&disp->xlnx_crtc);
+	if (ret) {
+		drm_crtc_cleanup(&disp->xlnx_crtc.crtc);
+		return ret;
+	}
 
 	disp->xlnx_crtc.get_max_width = &zynqmp_disp_get_max_width;
 	disp->xlnx_crtc.get_max_height = &zynqmp_disp_get_max_height;
@@ -2803,6 +3114,8 @@ static void zynqmp_disp_map_crtc_to_plane(struct zynqmp_disp *disp)
 
 	for (i = 0; i < ZYNQMP_DISP_NUM_LAYERS; i++)
 		disp->layers[i].plane.possible_crtcs = possible_crtcs;
+	if (disp->live_bridge)
+		disp->live_plane.possible_crtcs = possible_crtcs;
 }
 
 /*
@@ -2936,6 +3249,188 @@ static int zynqmp_disp_bridge_set_timing(struct xlnx_bridge *bridge,
 	return 0;
 }
 
+/*
+ * Live video plane functions
+ *
+ * The live plane shows the video stream of the PL pipeline given by the
+ * "xlnx,live-video" DT property. The stream goes into the video layer and is
+ * blended with the graphics layer without going through the memory. The
+ * framebuffer of the plane only describes the size and the format of the
+ * stream, and is never read.
+ */
+
+static inline struct zynqmp_disp *live_plane_to_disp(struct drm_plane *plane)
+{
+	return container_of(plane, struct zynqmp_disp, live_plane);
+}
+
+static const struct zynqmp_disp_fmt *zynqmp_disp_live_plane_fmt(u32 drm_fmt)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(av_buf_live_fmts); i++)
+		if (av_buf_live_fmts[i].drm_fmt &&
+		    av_buf_live_fmts[i].drm_fmt == drm_fmt)
+			return &av_buf_live_fmts[i];
+
+	return NULL;
+}
+
+static int zynqmp_disp_live_plane_enable(struct zynqmp_disp *disp,
+					 struct drm_plane_state *state)
+{
+	struct zynqmp_disp_layer *layer = &disp->layers[ZYNQMP_DISP_LAYER_VID];
+	const struct zynqmp_disp_fmt *fmt;
+	int ret;
+
+	fmt = zynqmp_disp_live_plane_fmt(state->fb->format->format);
+	if (!fmt)
+		return -EINVAL;
+
+	ret = xlnx_bridge_set_output(disp->live_bridge, state->crtc_w,
+				     state->crtc_h, fmt->bus_fmt);
+	if (ret) {
+		dev_err(disp->dev, "failed to set the live source output\n");
+		return ret;
+	}
+
+	ret = zynqmp_disp_bridge_set_input(&layer->bridge, state->crtc_w,
+					   state->crtc_h, fmt->bus_fmt);
+	if (ret)
+		return ret;
+
+	/* Start the stream before the layer switches to it */
+	ret = xlnx_bridge_enable(disp->live_bridge);
+	if (ret) {
+		dev_err(disp->dev, "failed to enable the live source\n");
+		return ret;
+	}
+
+	ret = zynqmp_disp_bridge_enable(&layer->bridge);
+	if (ret)
+		xlnx_bridge_disable(disp->live_bridge);
+
+	return ret;
+}
+
+static void zynqmp_disp_live_plane_disable(struct zynqmp_disp *disp)
+{
+	struct zynqmp_disp_layer *layer = &disp->layers[ZYNQMP_DISP_LAYER_VID];
+
+	if (!layer->enabled || layer->mode != ZYNQMP_DISP_LAYER_LIVE)
+		return;
+
+	zynqmp_disp_bridge_disable(&layer->bridge);
+	xlnx_bridge_disable(disp->live_bridge);
+}
+
+static int zynqmp_disp_live_plane_atomic_check(struct drm_plane *plane,
+					       struct drm_atomic_state *state)
+{
+	struct drm_plane_state *new_state =
+		drm_atomic_get_new_plane_state(state, plane);
+	struct zynqmp_disp *disp = live_plane_to_disp(plane);
+	struct drm_crtc_state *crtc_state;
+	int ret;
+
+	ret = zynqmp_disp_check_vid_layer(disp, state);
+	if (ret)
+		return ret;
+
+	if (!new_state->crtc || !new_state->fb)
+		return 0;
+
+	crtc_state = drm_atomic_get_crtc_state(state, new_state->crtc);
+	if (IS_ERR(crtc_state))
+		return PTR_ERR(crtc_state);
+
+	ret = drm_atomic_helper_check_plane_state(new_state, crtc_state,
+						  DRM_PLANE_NO_SCALING,
+						  DRM_PLANE_NO_SCALING,
+						  false, false);
+	if (ret)
+		return ret;
+
+	/* The live stream carries the timing, it has to fill the screen */
+	if (new_state->crtc_x || new_state->crtc_y ||
+	    new_state->crtc_w != crtc_state->mode.hdisplay ||
+	    new_state->crtc_h != crtc_state->mode.vdisplay) {
+		dev_dbg(disp->dev, "live plane must cover the whole mode\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void
+zynqmp_disp_live_plane_atomic_update(struct drm_plane *plane,
+				     struct drm_atomic_state *state)
+{
+	struct drm_plane_state *old_state =
+		drm_atomic_get_old_plane_state(state, plane);
+	struct drm_plane_state *new_state = plane->state;
+	struct zynqmp_disp *disp = live_plane_to_disp(plane);
+	struct drm_crtc_state *crtc_state;
+
+	if (!new_state->crtc || !new_state->fb)
+		return;
+
+	/* A new framebuffer alone doesn't change the running stream */
+	crtc_state = drm_atomic_get_new_crtc_state(state, new_state->crtc);
+	if (old_state->crtc && old_state->fb &&
+	    !drm_atomic_crtc_needs_modeset(crtc_state) &&
+	    old_state->fb->format == new_state->fb->format &&
+	    old_state->crtc_w == new_state->crtc_w &&
+	    old_state->crtc_h == new_state->crtc_h)
+		return;
+
+	zynqmp_disp_live_plane_disable(disp);
+	if (zynqmp_disp_live_plane_enable(disp, new_state))
+		dev_err(disp->dev, "failed to enable the live plane\n");
+}
+
+static void
+zynqmp_disp_live_plane_atomic_disable(struct drm_plane *plane,
+				      struct drm_atomic_state *state)
+{
+	zynqmp_disp_live_plane_disable(live_plane_to_disp(plane));
+}
+
+static const struct drm_plane_helper_funcs zynqmp_disp_live_helper_funcs = {
+	.atomic_check		= zynqmp_disp_live_plane_atomic_check,
+	.atomic_update		= zynqmp_disp_live_plane_atomic_update,
+	.atomic_disable		= zynqmp_disp_live_plane_atomic_disable,
+};
+
+static const struct drm_plane_funcs zynqmp_disp_live_plane_funcs = {
+	.update_plane		= drm_atomic_helper_update_plane,
+	.disable_plane		= drm_atomic_helper_disable_plane,
+	.destroy		= drm_plane_cleanup,
+	.reset			= drm_atomic_helper_plane_reset,
+	.atomic_duplicate_state	= drm_atomic_helper_plane_duplicate_state,
+	.atomic_destroy_state	= drm_atomic_helper_plane_destroy_state,
+};
+
+static int zynqmp_disp_create_live_plane(struct zynqmp_disp *disp)
+{
+	int ret;
+
+	if (!disp->live_bridge)
+		return 0;
+
+	ret = drm_universal_plane_init(disp->drm, &disp->live_plane, 0,
+				       &zynqmp_disp_live_plane_funcs,
+				       disp->live_fmts, disp->num_live_fmts,
+				       NULL, DRM_PLANE_TYPE_OVERLAY, "live");
+	if (ret)
+		return ret;
+
+	drm_plane_helper_add(&disp->live_plane,
+			     &zynqmp_disp_live_helper_funcs);
+
+	return 0;
+}
+
 /*
  * Component functions
  */
@@ -2967,6 +3462,9 @@ int zynqmp_disp_bind(struct device *dev, struct device *master, void *data)
 	disp->tpg_prop = drm_property_create_bool(drm, 0, "tpg");
 
 	ret = zynqmp_disp_create_plane(disp);
+	if (ret)
+		return ret;
+	ret = zynqmp_disp_create_live_plane(disp);
 	if (ret)
 		return ret;
 	ret = zynqmp_disp_create_crtc(disp);
@@ -2983,6 +3481,8 @@ void zynqmp_disp_unbind(struct device *dev, struct device *master, void *data)
 	struct zynqmp_disp *disp = dpsub->disp;
 
 	zynqmp_disp_destroy_crtc(disp);
+	if (disp->live_bridge)
+		drm_plane_cleanup(&disp->live_plane);
 	zynqmp_disp_destroy_plane(disp);
 	drm_property_destroy(disp->drm, disp->bg_c2_prop);
 	drm_property_destroy(disp->drm, disp->bg_c1_prop);
@@ -3011,6 +3511,15 @@ static int zynqmp_disp_enumerate_fmts(struct zynqmp_disp *disp)
 	for (i = 0; i < num_bus_fmts; i++)
 		bus_fmts[i] = av_buf_live_fmts[i].bus_fmt;
 
+	disp->live_fmts = devm_kcalloc(disp->dev, num_bus_fmts,
+				       sizeof(*disp->live_fmts), GFP_KERNEL);
+	if (!disp->live_fmts)
+		return -ENOMEM;
+	for (i = 0; i < num_bus_fmts; i++)
+		if (av_buf_live_fmts[i].drm_fmt)
+			disp->live_fmts[disp->num_live_fmts++] =
+				av_buf_live_fmts[i].drm_fmt;
+
 	layer = &disp->layers[ZYNQMP_DISP_LAYER_VID];
 	layer->num_bus_fmts = num_bus_fmts;
 	layer->bus_fmts = bus_fmts;
@@ -3055,6 +3564,7 @@ int zynqmp_disp_probe(struct platform_device *pdev)
 	struct zynqmp_disp_layer *layer;
 	unsigned int i, j;
 	struct device_node *vtc_node;
+	struct device_node *live_node;
 
 	disp = devm_kzalloc(&pdev->dev, sizeof(*disp), GFP_KERNEL);
 	if (!disp)
@@ -3174,6 +3684,19 @@ int zynqmp_disp_probe(struct platform_device *pdev)
 		dev_info(disp->dev, "vtc bridge property not present\n");
 	}
 
+	/* PL pipeline feeding the live video plane */
+	live_node = of_parse_phandle(disp->dev->of_node, "xlnx,live-video", 0);
+	if (live_node && !dpsub->external_crtc_attached) {
+		disp->live_bridge = of_xlnx_bridge_get(live_node);
+		of_node_put(live_node);
+		if (!disp->live_bridge) {
+			dev_info(disp->dev, "Didn't get live video bridge\n");
+			return -EPROBE_DEFER;
+		}
+	} else {
+		of_node_put(live_node);
+	}
+
 	ret = zynqmp_disp_layer_create(disp);
 	if (ret)
 		goto error_aclk;
@@ -3220,6 +3743,8 @@ int zynqmp_disp_remove(struct platform_device *pdev)
 		zynqmp_disp_clk_disable(disp->audclk, &disp->audclk_en);
 	if (disp->vtc_bridge)
 		of_xlnx_bridge_put(disp->vtc_bridge);
+	if (disp->live_bridge)
+		of_xlnx_bridge_put(disp->live_bridge);
 	zynqmp_disp_clk_disable(disp->aclk, &disp->aclk_en);
 	zynqmp_disp_clk_disable(disp->pclk, &disp->pclk_en);
 	dpsub->disp = NULL;
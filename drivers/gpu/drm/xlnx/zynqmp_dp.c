@@ -18,6 +18,7 @@
 #include <drm/drm_probe_helper.h>
 #include <drm/drm_edid.h>
 
+#include <linux/crc32.h>
 #include <linux/delay.h>
 #include <linux/device.h>
 #include <linux/module.h>
@@ -294,6 +295,20 @@ struct zynqmp_dp_config {
 	u8 num_colors;
 };
 
+/**
+ * struct zynqmp_dp_link_cache - Link parameters of the last trained sink
+ * @sink_id: CRC of the EDID of the sink, or 0 if the cache is empty
+ * @bw_code: link rate the training succeeded at
+ * @lane_cnt: lane count the training succeeded with
+ * @train_set: voltage swing and pre-emphasis the training settled on
+ */
+struct zynqmp_dp_link_cache {
+	u32 sink_id;
+	u8 bw_code;
+	u8 lane_cnt;
+	u8 train_set[ZYNQMP_DP_MAX_LANES];
+};
+
 /**
  * struct zynqmp_dp - Xilinx DisplayPort core
  * @encoder: the drm encoder structure
@@ -318,6 +333,8 @@ struct zynqmp_dp_config {
  * @link_config: common link configuration between IP core and sink device
  * @mode: current mode between IP core and sink device
  * @train_set: set of training data
+ * @sink_id: CRC of the EDID of the connected sink, or 0 if unknown
+ * @link_cache: link parameters of the last successful full training
  */
 struct zynqmp_dp {
 	struct drm_encoder encoder;
@@ -344,6 +361,8 @@ struct zynqmp_dp {
 	struct zynqmp_dp_link_config link_config;
 	struct zynqmp_dp_mode mode;
 	u8 train_set[ZYNQMP_DP_MAX_LANES];
+	u32 sink_id;
+	struct zynqmp_dp_link_cache link_cache;
 };
 
 static inline struct zynqmp_dp *encoder_to_dp(struct drm_encoder *encoder)
@@ -923,10 +942,11 @@ static int zynqmp_dp_link_train_ce(struct zynqmp_dp *dp)
 /**
  * zynqmp_dp_train - Train the link
  * @dp: DisplayPort IP core structure
+ * @seeded: start from the drive levels in @dp->train_set instead of the lowest
  *
  * Return: 0 if all trains are done successfully, or corresponding error code.
  */
-static int zynqmp_dp_train(struct zynqmp_dp *dp)
+static int zynqmp_dp_train(struct zynqmp_dp *dp, bool seeded)
 {
 	u32 reg;
 	u8 bw_code = dp->mode.bw_code;
@@ -991,7 +1011,8 @@ static int zynqmp_dp_train(struct zynqmp_dp *dp)
 		return ret;
 
 	zynqmp_dp_write(dp->iomem, ZYNQMP_DP_TX_SCRAMBLING_DISABLE, 1);
-	memset(dp->train_set, 0, ARRAY_SIZE(dp->train_set));
+	if (!seeded)
+		memset(dp->train_set, 0, ARRAY_SIZE(dp->train_set));
 	ret = zynqmp_dp_link_train_cr(dp);
 	if (ret)
 		return ret;
@@ -1014,26 +1035,93 @@ static int zynqmp_dp_train(struct zynqmp_dp *dp)
 	return 0;
 }
 
+/**
+ * zynqmp_dp_link_cache_apply - Use the cached link parameters for a mode
+ * @dp: DisplayPort IP core structure
+ * @pclock: pixel clock of the mode
+ *
+ * If the connected sink was trained before, and the link it was trained at
+ * carries @pclock, use the same link rate and lane count instead of the ones
+ * picked by zynqmp_dp_mode_configure(). The link training then starts from
+ * the cached drive levels, which usually passes at the first attempt.
+ */
+static void zynqmp_dp_link_cache_apply(struct zynqmp_dp *dp, int pclock)
+{
+	struct zynqmp_dp_link_cache *cache = &dp->link_cache;
+	int rate;
+
+	if (!cache->sink_id || cache->sink_id != dp->sink_id ||
+	    cache->lane_cnt > dp->link_config.max_lanes)
+		return;
+
+	rate = drm_dp_bw_code_to_link_rate(cache->bw_code);
+	if (rate > dp->link_config.max_rate ||
+	    zynqmp_dp_max_rate(rate, cache->lane_cnt, dp->config.bpp) < pclock)
+		return;
+
+	dp->mode.bw_code = cache->bw_code;
+	dp->mode.lane_cnt = cache->lane_cnt;
+}
+
+/**
+ * zynqmp_dp_train_cached - Train the link with the cached drive levels
+ * @dp: DisplayPort IP core structure
+ *
+ * Return: true if the link is trained, false if a full training is needed.
+ */
+static bool zynqmp_dp_train_cached(struct zynqmp_dp *dp)
+{
+	struct zynqmp_dp_link_cache *cache = &dp->link_cache;
+
+	if (!cache->sink_id || cache->sink_id != dp->sink_id ||
+	    cache->bw_code != dp->mode.bw_code ||
+	    cache->lane_cnt != dp->mode.lane_cnt)
+		return false;
+
+	memcpy(dp->train_set, cache->train_set, sizeof(dp->train_set));
+	if (!zynqmp_dp_train(dp, true))
+		return true;
+
+	dev_dbg(dp->dev, "cached link training failed, retraining\n");
+	cache->sink_id = 0;
+
+	return false;
+}
+
 /**
  * zynqmp_dp_train_loop - Downshift the link rate during training
  * @dp: DisplayPort IP core structure
  *
  * Train the link by downshifting the link rate if training is not successful.
+ * A sink that was trained before is first tried with its cached drive levels.
  */
 static void zynqmp_dp_train_loop(struct zynqmp_dp *dp)
 {
+	struct zynqmp_dp_link_cache *cache = &dp->link_cache;
 	struct zynqmp_dp_mode *mode = &dp->mode;
 	u8 bw = mode->bw_code;
 	int ret;
 
+	if (dp->status == connector_status_disconnected || !dp->enabled)
+		return;
+
+	if (zynqmp_dp_train_cached(dp))
+		return;
+
 	do {
 		if (dp->status == connector_status_disconnected ||
 		    !dp->enabled)
 			return;
 
-		ret = zynqmp_dp_train(dp);
-		if (!ret)
+		ret = zynqmp_dp_train(dp, false);
+		if (!ret) {
+			cache->sink_id = dp->sink_id;
+			cache->bw_code = mode->bw_code;
+			cache->lane_cnt = mode->lane_cnt;
+			memcpy(cache->train_set, dp->train_set,
+			       sizeof(cache->train_set));
 			return;
+		}
 
 		ret = zynqmp_dp_mode_configure(dp, mode->pclock, bw);
 		if (ret < 0)
@@ -1489,9 +1577,12 @@ static int zynqmp_dp_connector_get_modes(struct drm_connector *connector)
 	int ret;
 
 	edid = drm_get_edid(connector, &dp->aux.ddc);
-	if (!edid)
+	if (!edid) {
+		dp->sink_id = 0;
 		return 0;
+	}
 
+	dp->sink_id = crc32(0, edid, (edid->extensions + 1) * EDID_LENGTH);
 	drm_connector_update_edid_property(connector, edid);
 	ret = drm_add_edid_modes(connector, edid);
 	kfree(edid);
@@ -1693,6 +1784,7 @@ zynqmp_dp_encoder_atomic_mode_set(struct drm_encoder *encoder,
 	if (ret < 0)
 		return;
 
+	zynqmp_dp_link_cache_apply(dp, adjusted_mode->clock);
 	zynqmp_dp_encoder_mode_set_transfer_unit(dp, adjusted_mode);
 }
 
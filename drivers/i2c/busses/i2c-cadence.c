@@ -11,6 +11,7 @@
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/iopoll.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
 #include <linux/of.h>
@@ -168,6 +169,7 @@ enum cdns_i2c_slave_state {
  * @membase:		Base address of the I2C device
  * @adap:		I2C adapter instance
  * @p_msg:		Message pointer
+ * @msgs_left:		Messages of the chain still to start after @p_msg
  * @err_status:		Error status in Interrupt Status Register
  * @xfer_done:		Transfer complete status
  * @p_send_buf:		Pointer to transmit buffer
@@ -187,12 +189,19 @@ enum cdns_i2c_slave_state {
  * @slave:		Registered slave instance.
  * @dev_mode:		I2C operating role(master/slave).
  * @slave_state:	I2C Slave state(idle/read/write).
+ * @stats:		Transfer statistics.
+ * @stats.xfers:	Transfers done.
+ * @stats.msgs:		Messages done.
+ * @stats.errors:	Transfers that failed.
+ * @stats.lat_sum_ns:	Sum of the transfer latencies.
+ * @stats.lat_max_ns:	Highest transfer latency.
  */
 struct cdns_i2c {
 	struct device		*dev;
 	void __iomem *membase;
 	struct i2c_adapter adap;
 	struct i2c_msg *p_msg;
+	unsigned int msgs_left;
 	int err_status;
 	struct completion xfer_done;
 	unsigned char *p_send_buf;
@@ -215,6 +224,13 @@ struct cdns_i2c {
 	enum cdns_i2c_mode dev_mode;
 	enum cdns_i2c_slave_state slave_state;
 #endif
+	struct {
+		u64 xfers;
+		u64 msgs;
+		u64 errors;
+		u64 lat_sum_ns;
+		u64 lat_max_ns;
+	} stats;
 };
 
 struct cdns_platform_data {
@@ -243,6 +259,8 @@ static inline bool cdns_is_holdquirk(struct cdns_i2c *id, bool hold_wrkaround)
 		(id->curr_recv_count == CDNS_I2C_FIFO_DEPTH + 1));
 }
 
+static void cdns_i2c_start_msg(struct cdns_i2c *id);
+
 #if IS_ENABLED(CONFIG_I2C_SLAVE)
 static void cdns_i2c_set_mode(enum cdns_i2c_mode mode, struct cdns_i2c *id)
 {
@@ -458,10 +476,18 @@ static irqreturn_t cdns_i2c_master_isr(void *ptr)
 		 * receive operation.
 		 */
 		if (cdns_is_holdquirk(id, updatetx)) {
+			unsigned int xfer_size;
+
 			/* wait while fifo is full */
-			while (cdns_i2c_readreg(CDNS_I2C_XFER_SIZE_OFFSET) !=
-			       (id->curr_recv_count - CDNS_I2C_FIFO_DEPTH))
-				;
+			if (readl_relaxed_poll_timeout_atomic(id->membase +
+					CDNS_I2C_XFER_SIZE_OFFSET, xfer_size,
+					xfer_size == id->curr_recv_count -
+						     CDNS_I2C_FIFO_DEPTH,
+					0, CDNS_I2C_TIMEOUT_US)) {
+				id->err_status |= CDNS_I2C_IXR_TO;
+				complete(&id->xfer_done);
+				return IRQ_HANDLED;
+			}
 
 			/*
 			 * Check number of bytes to be received against maximum
@@ -530,6 +556,19 @@ static irqreturn_t cdns_i2c_master_isr(void *ptr)
 	if (id->err_status)
 		status = IRQ_HANDLED;
 
+	/*
+	 * The bus is still held for a repeated start, so the next message of
+	 * a chain starts right here instead of after a round trip through
+	 * the waiting thread.
+	 */
+	if (done_flag && !id->err_status && id->msgs_left) {
+		id->p_msg++;
+		if (!--id->msgs_left)
+			id->bus_hold_flag = 0;
+		cdns_i2c_start_msg(id);
+		done_flag = 0;
+	}
+
 	if (done_flag)
 		complete(&id->xfer_done);
 
@@ -747,16 +786,15 @@ static void cdns_i2c_master_reset(struct i2c_adapter *adap)
 	cdns_i2c_writereg(regval, CDNS_I2C_SR_OFFSET);
 }
 
-static int cdns_i2c_process_msg(struct cdns_i2c *id, struct i2c_msg *msg,
-		struct i2c_adapter *adap)
+/**
+ * cdns_i2c_start_msg - Set up the address mode and start the current message
+ * @id:		pointer to the i2c device
+ */
+static void cdns_i2c_start_msg(struct cdns_i2c *id)
 {
-	unsigned long time_left, msg_timeout;
+	struct i2c_msg *msg = id->p_msg;
 	u32 reg;
 
-	id->p_msg = msg;
-	id->err_status = 0;
-	reinit_completion(&id->xfer_done);
-
 	/* Check for the TEN Bit mode on each msg */
 	reg = cdns_i2c_readreg(CDNS_I2C_CR_OFFSET);
 	if (msg->flags & I2C_M_TEN) {
@@ -774,9 +812,36 @@ static int cdns_i2c_process_msg(struct cdns_i2c *id, struct i2c_msg *msg,
 		cdns_i2c_mrecv(id);
 	else
 		cdns_i2c_msend(id);
+}
+
+/**
+ * cdns_i2c_process_msg - Run messages and wait for their completion
+ * @id:		pointer to the i2c device
+ * @msg:	pointer to the first message
+ * @num:	number of messages, chained by the interrupt handler
+ * @adap:	pointer to the i2c adapter driver instance
+ *
+ * Return: 0 on success, negative error otherwise
+ */
+static int cdns_i2c_process_msg(struct cdns_i2c *id, struct i2c_msg *msg,
+				int num, struct i2c_adapter *adap)
+{
+	unsigned long time_left, msg_timeout;
+	unsigned int len = 0;
+	int i;
+
+	for (i = 0; i < num; i++)
+		len += msg[i].len;
+
+	id->p_msg = msg;
+	id->msgs_left = num - 1;
+	id->err_status = 0;
+	reinit_completion(&id->xfer_done);
+
+	cdns_i2c_start_msg(id);
 
-	/* Minimal time to execute this message */
-	msg_timeout = msecs_to_jiffies((1000 * msg->len * BITS_PER_BYTE) / id->i2c_clk);
+	/* Minimal time to execute these messages */
+	msg_timeout = msecs_to_jiffies((1000 * len * BITS_PER_BYTE) / id->i2c_clk);
 	/* Plus some wiggle room */
 	msg_timeout += msecs_to_jiffies(500);
 
@@ -787,6 +852,7 @@ static int cdns_i2c_process_msg(struct cdns_i2c *id, struct i2c_msg *msg,
 	time_left = wait_for_completion_timeout(&id->xfer_done, msg_timeout);
 	if (time_left == 0) {
 		cdns_i2c_master_reset(adap);
+		id->msgs_left = 0;
 		dev_err(id->adap.dev.parent,
 				"timeout waiting on completion\n");
 		return -ETIMEDOUT;
@@ -795,6 +861,10 @@ static int cdns_i2c_process_msg(struct cdns_i2c *id, struct i2c_msg *msg,
 	cdns_i2c_writereg(CDNS_I2C_IXR_ALL_INTR_MASK,
 			  CDNS_I2C_IDR_OFFSET);
 
+	/* A failed message stops the chain */
+	id->msgs_left = 0;
+	msg = id->p_msg;
+
 	/* If it is bus arbitration error, try again */
 	if (id->err_status & CDNS_I2C_IXR_ARB_LOST)
 		return -EAGAIN;
@@ -818,10 +888,12 @@ static int cdns_i2c_process_msg(struct cdns_i2c *id, struct i2c_msg *msg,
 static int cdns_i2c_master_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs,
 				int num)
 {
-	int ret, count;
+	int ret, count, chain;
 	u32 reg;
 	struct cdns_i2c *id = adap->algo_data;
 	bool hold_quirk;
+	ktime_t start;
+	u64 lat;
 #if IS_ENABLED(CONFIG_I2C_SLAVE)
 	bool change_role = false;
 #endif
@@ -830,6 +902,8 @@ static int cdns_i2c_master_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs,
 	if (ret < 0)
 		return ret;
 
+	start = ktime_get();
+
 #if IS_ENABLED(CONFIG_I2C_SLAVE)
 	/* Check i2c operating mode and switch if possible */
 	if (id->dev_mode == CDNS_I2C_MODE_SLAVE) {
@@ -886,12 +960,25 @@ static int cdns_i2c_master_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs,
 		id->bus_hold_flag = 0;
 	}
 
-	/* Process the msg one by one */
-	for (count = 0; count < num; count++, msgs++) {
+	/*
+	 * Chain the messages from the interrupt handler. The received length
+	 * of an SMBus block read is only known at its end, so such transfers
+	 * are processed one message at a time.
+	 */
+	chain = num;
+	for (count = 0; count < num; count++) {
+		if (msgs[count].flags & I2C_M_RECV_LEN) {
+			chain = 1;
+			break;
+		}
+	}
+
+	for (count = 0; count < num; count += chain, msgs += chain) {
+		chain = min(chain, num - count);
 		if (count == (num - 1))
 			id->bus_hold_flag = 0;
 
-		ret = cdns_i2c_process_msg(id, msgs, adap);
+		ret = cdns_i2c_process_msg(id, msgs, chain, adap);
 		if (ret)
 			goto out;
 
@@ -911,6 +998,14 @@ static int cdns_i2c_master_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs,
 	ret = num;
 
 out:
+	lat = ktime_to_ns(ktime_sub(ktime_get(), start));
+	id->stats.xfers++;
+	if (ret < 0)
+		id->stats.errors++;
+	else
+		id->stats.msgs += num;
+	id->stats.lat_sum_ns += lat;
+	id->stats.lat_max_ns = max(id->stats.lat_max_ns, lat);
 
 #if IS_ENABLED(CONFIG_I2C_SLAVE)
 	/* Switch i2c mode to slave */
@@ -1379,11 +1474,80 @@ static int cdns_i2c_remove(struct platform_device *pdev)
 	return 0;
 }
 
+static ssize_t xfers_show(struct device *dev, struct device_attribute *attr,
+			  char *buf)
+{
+	struct cdns_i2c *id = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%llu\n", id->stats.xfers);
+}
+static DEVICE_ATTR_RO(xfers);
+
+static ssize_t msgs_show(struct device *dev, struct device_attribute *attr,
+			 char *buf)
+{
+	struct cdns_i2c *id = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%llu\n", id->stats.msgs);
+}
+static DEVICE_ATTR_RO(msgs);
+
+static ssize_t errors_show(struct device *dev, struct device_attribute *attr,
+			   char *buf)
+{
+	struct cdns_i2c *id = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%llu\n", id->stats.errors);
+}
+static DEVICE_ATTR_RO(errors);
+
+static ssize_t latency_avg_us_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	struct cdns_i2c *id = dev_get_drvdata(dev);
+	u64 xfers = id->stats.xfers;
+
+	return sysfs_emit(buf, "%llu\n", xfers ?
+			  div64_u64(id->stats.lat_sum_ns, xfers) /
+			  NSEC_PER_USEC : 0);
+}
+static DEVICE_ATTR_RO(latency_avg_us);
+
+static ssize_t latency_max_us_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	struct cdns_i2c *id = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%llu\n",
+			  div_u64(id->stats.lat_max_ns, NSEC_PER_USEC));
+}
+static DEVICE_ATTR_RO(latency_max_us);
+
+static struct attribute *cdns_i2c_stats_attrs[] = {
+	&dev_attr_xfers.attr,
+	&dev_attr_msgs.attr,
+	&dev_attr_errors.attr,
+	&dev_attr_latency_avg_us.attr,
+	&dev_attr_latency_max_us.attr,
+	NULL
+};
+
+static const struct attribute_group cdns_i2c_stats_group = {
+	.name = "statistics",
+	.attrs = cdns_i2c_stats_attrs,
+};
+
+static const struct attribute_group *cdns_i2c_groups[] = {
+	&cdns_i2c_stats_group,
+	NULL
+};
+
 static struct platform_driver cdns_i2c_drv = {
 	.driver = {
 		.name  = DRIVER_NAME,
 		.of_match_table = cdns_i2c_of_match,
 		.pm = &cdns_i2c_dev_pm_ops,
+		.dev_groups = cdns_i2c_groups,
 	},
 	.probe  = cdns_i2c_probe,
 	.remove = cdns_i2c_remove,
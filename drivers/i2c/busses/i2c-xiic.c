@@ -29,6 +29,7 @@
 #include <linux/slab.h>
 #include <linux/of.h>
 #include <linux/clk.h>
+#include <linux/ktime.h>
 #include <linux/pm_runtime.h>
 
 #define DRIVER_NAME "xiic-i2c"
@@ -1074,6 +1075,37 @@ static void xiic_start_send(struct xiic_i2c *i2c)
 	i2c->prev_msg_tx = true;
 }
 
+/**
+ * xiic_dyn_chain - Queue the next messages of a dynamic mode transfer
+ * @i2c: Pointer to the xiic device structure
+ *
+ * Once a write message is all in the Tx FIFO, the controller issues the
+ * repeated start of the next message by itself. The following messages are
+ * queued right behind it for as long as they fit, instead of taking a FIFO
+ * interrupt per message. A read ends the chain, its data is collected from
+ * the Rx FIFO by the interrupt handler.
+ */
+static void xiic_dyn_chain(struct xiic_i2c *i2c)
+{
+	while (i2c->nmsgs > 1 && !xiic_tx_space(i2c) &&
+	       xiic_tx_fifo_space(i2c) >= 2) {
+		i2c->nmsgs--;
+		i2c->tx_msg++;
+		i2c->tx_pos = 0;
+		i2c->rx_pos = 0;
+
+		dev_dbg(i2c->adap.dev.parent, "%s chain msg: %p, len: %d\n",
+			__func__, i2c->tx_msg, i2c->tx_msg->len);
+
+		if (i2c->tx_msg->flags & I2C_M_RD) {
+			xiic_start_recv(i2c);
+			return;
+		}
+
+		xiic_start_send(i2c);
+	}
+}
+
 static void __xiic_start_xfer(struct xiic_i2c *i2c)
 {
 	int fifo_space = xiic_tx_fifo_space(i2c);
@@ -1092,6 +1124,8 @@ static void __xiic_start_xfer(struct xiic_i2c *i2c)
 		xiic_start_recv(i2c);
 	} else {
 		xiic_start_send(i2c);
+		if (i2c->dynamic)
+			xiic_dyn_chain(i2c);
 	}
 }
 
@@ -1152,6 +1186,7 @@ static int xiic_start_xfer(struct xiic_i2c *i2c, struct i2c_msg *msgs, int num)
 static int xiic_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs, int num)
 {
 	struct xiic_i2c *i2c = i2c_get_adapdata(adap);
+	ktime_t start = ktime_get();
 	int err;
 
 	dev_dbg(adap->dev.parent, "%s entry SR: 0x%x\n", __func__,
@@ -1181,6 +1216,9 @@ static int xiic_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs, int num)
 	} else {
 		err = (i2c->state == STATE_DONE) ? num : -EIO;
 	}
+	dev_dbg(adap->dev.parent, "%d msgs in %s mode: %d, %lld us\n", num,
+		i2c->dynamic ? "dynamic" : "standard", err,
+		ktime_us_delta(ktime_get(), start));
 	mutex_unlock(&i2c->lock);
 	pm_runtime_mark_last_busy(i2c->dev);
 	pm_runtime_put_autosuspend(i2c->dev);
@@ -856,6 +856,70 @@ static int ad9361_spi_writem(struct spi_device *spi,
 	return 0;
 }
 
+/*
+ * Register writes collected into a single SPI message, so that a multi
+ * register update costs one spi_sync() instead of one per register.
+ */
+#define AD9361_SPI_BATCH_MAX	20
+
+struct ad9361_spi_batch {
+	struct spi_transfer xfer[AD9361_SPI_BATCH_MAX];
+	u8 buf[AD9361_SPI_BATCH_MAX][MAX_MBYTE_SPI + 2];
+	unsigned int num;
+};
+
+static int ad9361_spi_batch_writem(struct ad9361_spi_batch *batch,
+				   u32 reg, const u8 *tbuf, u32 num)
+{
+	struct spi_transfer *xfer;
+	u8 *buf;
+	u16 cmd;
+
+	if (num > MAX_MBYTE_SPI || batch->num == AD9361_SPI_BATCH_MAX)
+		return -EINVAL;
+
+	buf = batch->buf[batch->num];
+	cmd = AD_WRITE | AD_CNT(num) | AD_ADDR(reg);
+	buf[0] = cmd >> 8;
+	buf[1] = cmd & 0xFF;
+	memcpy(&buf[2], tbuf, num);
+
+	xfer = &batch->xfer[batch->num++];
+	xfer->tx_buf = buf;
+	xfer->len = num + 2;
+	xfer->cs_change = 1;
+
+	return 0;
+}
+
+static int ad9361_spi_batch_write(struct ad9361_spi_batch *batch,
+				  u32 reg, u8 val)
+{
+	return ad9361_spi_batch_writem(batch, reg, &val, 1);
+}
+
+static int ad9361_spi_batch_sync(struct spi_device *spi,
+				 struct ad9361_spi_batch *batch)
+{
+	struct spi_message msg;
+	int ret;
+
+	if (!batch->num)
+		return 0;
+
+	/* Every command needs its own chip select cycle, except the last */
+	batch->xfer[batch->num - 1].cs_change = 0;
+	spi_message_init_with_transfers(&msg, batch->xfer, batch->num);
+
+	ret = spi_sync(spi, &msg);
+	if (ret < 0)
+		dev_err(&spi->dev, "Write Error %d", ret);
+
+	batch->num = 0;
+
+	return ret;
+}
+
 u32 ad9361_validate_rf_bw(struct ad9361_rf_phy *phy, u32 bw)
 {
 	switch(spi_get_device_id(phy->spi)->driver_data) {
@@ -4512,6 +4576,7 @@ static int ad9361_fastlock_load(struct ad9361_rf_phy *phy, bool tx,
 				u32 profile, u8 *values)
 {
 	struct ad9361_rf_phy_state *st = phy->state;
+	struct ad9361_spi_batch *batch;
 	u32 offs = 0;
 	int i, ret = 0;
 	u8 buf[4];
@@ -4519,24 +4584,40 @@ static int ad9361_fastlock_load(struct ad9361_rf_phy *phy, bool tx,
 	dev_dbg(&phy->spi->dev, "%s: %s Profile %d:",
 		__func__, tx ? "TX" : "RX", profile);
 
+	/* The whole profile goes out as a single SPI message */
+	batch = kzalloc(sizeof(*batch), GFP_KERNEL);
+	if (!batch)
+		return -ENOMEM;
+
 	if (tx)
 		offs = REG_TX_FAST_LOCK_SETUP - REG_RX_FAST_LOCK_SETUP;
 
 	buf[0] = values[0];
 	buf[1] = RX_FAST_LOCK_PROFILE_ADDR(profile) | RX_FAST_LOCK_PROFILE_WORD(0);
-	ad9361_spi_writem(phy->spi, REG_RX_FAST_LOCK_PROGRAM_DATA + offs, buf, 2);
+	ret |= ad9361_spi_batch_writem(batch,
+			REG_RX_FAST_LOCK_PROGRAM_DATA + offs, buf, 2);
 
 	for (i = 1; i < RX_FAST_LOCK_CONFIG_WORD_NUM; i++) {
 		buf[0] = RX_FAST_LOCK_PROGRAM_WRITE | RX_FAST_LOCK_PROGRAM_CLOCK_ENABLE;
 		buf[1] = 0;
 		buf[2] = values[i];
 		buf[3] = RX_FAST_LOCK_PROFILE_ADDR(profile) | RX_FAST_LOCK_PROFILE_WORD(i);
-		ad9361_spi_writem(phy->spi, REG_RX_FAST_LOCK_PROGRAM_CTRL + offs, buf, 4);
+		ret |= ad9361_spi_batch_writem(batch,
+				REG_RX_FAST_LOCK_PROGRAM_CTRL + offs, buf, 4);
 	}
 
-	ad9361_spi_write(phy->spi, REG_RX_FAST_LOCK_PROGRAM_CTRL + offs,
-			 RX_FAST_LOCK_PROGRAM_WRITE | RX_FAST_LOCK_PROGRAM_CLOCK_ENABLE);
-	ad9361_spi_write(phy->spi, REG_RX_FAST_LOCK_PROGRAM_CTRL + offs, 0);
+	ret |= ad9361_spi_batch_write(batch,
+			REG_RX_FAST_LOCK_PROGRAM_CTRL + offs,
+			RX_FAST_LOCK_PROGRAM_WRITE |
+			RX_FAST_LOCK_PROGRAM_CLOCK_ENABLE);
+	ret |= ad9361_spi_batch_write(batch,
+			REG_RX_FAST_LOCK_PROGRAM_CTRL + offs, 0);
+
+	if (!ret)
+		ret = ad9361_spi_batch_sync(phy->spi, batch);
+	kfree(batch);
+	if (ret < 0)
+		return ret;
 
 	st->fastlock.entry[tx][profile].flags = FASTLOOK_INIT;
 	st->fastlock.entry[tx][profile].alc_orig = values[15];
@@ -5706,6 +5787,119 @@ static int ad9361_validate_enable_fir(struct ad9361_rf_phy *phy)
 		(valid && st->filt_tx_bw_Hz) ? st->filt_tx_bw_Hz : st->current_tx_bw_Hz);
 }
 
+/* TX quadrature calibration cache */
+
+static void ad9361_tx_cal_cache_flush(struct ad9361_rf_phy *phy)
+{
+	struct ad9361_tx_cal_cache *cache = &phy->state->tx_cal_cache;
+
+	memset(cache->entry, 0, sizeof(cache->entry));
+	cache->next = 0;
+}
+
+/*
+ * Results are only valid for the bandwidth and TX path clock they were
+ * obtained with, and are reused within the auto calibration threshold.
+ */
+static struct ad9361_tx_cal_entry *
+ad9361_tx_cal_cache_find(struct ad9361_rf_phy *phy, u64 lo_freq)
+{
+	struct ad9361_rf_phy_state *st = phy->state;
+	struct ad9361_tx_cal_entry *e, *best = NULL;
+	unsigned long clktf = clk_get_rate(phy->clks[CLKTF_CLK]);
+	u64 delta, best_delta = 0;
+	int i;
+
+	for (i = 0; i < AD9361_TX_CAL_CACHE_SIZE; i++) {
+		e = &st->tx_cal_cache.entry[i];
+		if (!e->valid || e->bw_Hz != st->current_tx_bw_Hz ||
+		    e->clktf != clktf)
+			continue;
+
+		delta = e->lo_freq > lo_freq ? e->lo_freq - lo_freq :
+			lo_freq - e->lo_freq;
+		if (delta > st->cal_threshold_freq)
+			continue;
+
+		if (!best || delta < best_delta) {
+			best = e;
+			best_delta = delta;
+		}
+	}
+
+	return best;
+}
+
+static int ad9361_tx_cal_cache_store(struct ad9361_rf_phy *phy, u64 lo_freq)
+{
+	struct ad9361_rf_phy_state *st = phy->state;
+	struct ad9361_tx_cal_cache *cache = &st->tx_cal_cache;
+	struct ad9361_tx_cal_entry *e;
+	int ret;
+
+	e = ad9361_tx_cal_cache_find(phy, lo_freq);
+	if (!e || e->lo_freq != lo_freq) {
+		e = &cache->entry[cache->next];
+		cache->next = (cache->next + 1) % AD9361_TX_CAL_CACHE_SIZE;
+	}
+
+	e->valid = false;
+
+	/* Multi byte accesses walk down from the given register */
+	ret = ad9361_spi_readm(phy->spi, REG_TX2_OUT_1_OFFSET_Q, &e->corr[0],
+			       MAX_MBYTE_SPI);
+	if (ret < 0)
+		return ret;
+
+	ret = ad9361_spi_readm(phy->spi, REG_TX2_OUT_2_OFFSET_Q,
+			       &e->corr[MAX_MBYTE_SPI], MAX_MBYTE_SPI);
+	if (ret < 0)
+		return ret;
+
+	e->lo_freq = lo_freq;
+	e->bw_Hz = st->current_tx_bw_Hz;
+	e->clktf = clk_get_rate(phy->clks[CLKTF_CLK]);
+	e->phase = st->last_tx_quad_cal_phase;
+	e->valid = true;
+
+	return 0;
+}
+
+static int ad9361_tx_cal_cache_recall(struct ad9361_rf_phy *phy, u64 lo_freq)
+{
+	struct ad9361_rf_phy_state *st = phy->state;
+	struct ad9361_spi_batch *batch;
+	struct ad9361_tx_cal_entry *e;
+	int ret;
+
+	if (!st->tx_cal_cache.enable)
+		return -ENOENT;
+
+	e = ad9361_tx_cal_cache_find(phy, lo_freq);
+	if (!e)
+		return -ENOENT;
+
+	batch = kzalloc(sizeof(*batch), GFP_KERNEL);
+	if (!batch)
+		return -ENOMEM;
+
+	ad9361_spi_batch_writem(batch, REG_TX2_OUT_1_OFFSET_Q, &e->corr[0],
+				MAX_MBYTE_SPI);
+	ad9361_spi_batch_writem(batch, REG_TX2_OUT_2_OFFSET_Q,
+				&e->corr[MAX_MBYTE_SPI], MAX_MBYTE_SPI);
+	ret = ad9361_spi_batch_sync(phy->spi, batch);
+	kfree(batch);
+	if (ret < 0)
+		return ret;
+
+	st->last_tx_quad_cal_phase = e->phase;
+
+	dev_dbg(&phy->spi->dev, "%s: LO %llu Hz from cached %llu Hz",
+		__func__, lo_freq, e->lo_freq);
+
+	return 0;
+}
+
 static void ad9361_work_func(struct work_struct *work)
 {
 	struct ad9361_rf_phy *phy =
@@ -5719,6 +5913,8 @@ static void ad9361_work_func(struct work_struct *work)
 	if (ret < 0)
 		dev_err(&phy->spi->dev,
 			"%s: TX QUAD cal failed", __func__);
+	else if (st->tx_cal_cache.enable)
+		ad9361_tx_cal_cache_store(phy, st->last_tx_quad_cal_freq);
 
 	complete_all(&phy->complete);
 	clear_bit(0, &st->flags);
@@ -6490,15 +6686,17 @@ static int ad9361_tx_rfpll_rate_change(struct notifier_block *nb,
 		/* For RX LO we typically have the tracking option enabled
 		* so for now do nothing here.
 		*/
-		if (st->auto_cal_en)
-			if (abs(st->last_tx_quad_cal_freq - new_rate) >
-				st->cal_threshold_freq) {
-
+		if (st->auto_cal_en &&
+		    abs(st->last_tx_quad_cal_freq - new_rate) >
+		    st->cal_threshold_freq) {
+			/* A cached result spares the calibration entirely */
+			if (ad9361_tx_cal_cache_recall(phy, new_rate)) {
 				set_bit(0, &st->flags);
 				reinit_completion(&phy->complete);
 				schedule_work(&phy->work);
-				st->last_tx_quad_cal_freq = new_rate;
 			}
+			st->last_tx_quad_cal_freq = new_rate;
+		}
 		ad9361_adjust_tx_ext_band_settings(phy, new_rate);
 	}
 
@@ -6720,6 +6918,7 @@ enum ad9361_iio_dev_attr {
 	AD9361_ENSM_MODE_AVAIL,
 	AD9361_CALIB_MODE,
 	AD9361_CALIB_MODE_AVAIL,
+	AD9361_CALIB_CACHE_EN,
 	AD9361_RSSI_GAIN_STEP_ERROR,
 	AD9361_RX_PATH_FREQ,
 	AD9361_TX_PATH_FREQ,
@@ -6872,6 +7071,15 @@ static ssize_t ad9361_phy_store(struct device *dev,
 		}
 
 
+		break;
+	case AD9361_CALIB_CACHE_EN:
+		ret = strtobool(buf, &res);
+		if (ret < 0)
+			break;
+
+		if (!res)
+			ad9361_tx_cal_cache_flush(phy);
+		st->tx_cal_cache.enable = res;
 		break;
 	case AD9361_CALIB_MODE:
 		val = 0;
@@ -7085,6 +7293,9 @@ static ssize_t ad9361_phy_show(struct device *dev,
 	case AD9361_FIR_TRX_ENABLE:
 		ret = sprintf(buf, "%d\n", !st->bypass_tx_fir && !st->bypass_rx_fir);
 		break;
+	case AD9361_CALIB_CACHE_EN:
+		ret = sprintf(buf, "%d\n", st->tx_cal_cache.enable);
+		break;
 	case AD9361_CALIB_MODE_AVAIL:
 		ret = sprintf(buf, "auto manual manual_tx_quad tx_quad rf_dc_offs rssi_gain_step\n");
 		break;
@@ -7192,6 +7403,11 @@ static IIO_DEVICE_ATTR(calib_mode_available, S_IRUGO,
 			NULL,
 			AD9361_CALIB_MODE_AVAIL);
 
+static IIO_DEVICE_ATTR(calib_cache_en, S_IRUGO | S_IWUSR,
+			ad9361_phy_show,
+			ad9361_phy_store,
+			AD9361_CALIB_CACHE_EN);
+
 static IIO_DEVICE_ATTR(rssi_gain_step_error, S_IRUGO | S_IWUSR,
 			ad9361_phy_show,
 			ad9361_phy_store,
@@ -7292,6 +7508,7 @@ static struct attribute *ad9361_phy_attributes[] = {
 	&iio_dev_attr_ensm_mode_available.dev_attr.attr,
 	&iio_dev_attr_calib_mode.dev_attr.attr,
 	&iio_dev_attr_calib_mode_available.dev_attr.attr,
+	&iio_dev_attr_calib_cache_en.dev_attr.attr,
 	&iio_dev_attr_rssi_gain_step_error.dev_attr.attr,
 	&iio_dev_attr_tx_path_rates.dev_attr.attr,
 	&iio_dev_attr_rx_path_rates.dev_attr.attr,
@@ -438,6 +438,28 @@ struct ad9361_fastlock {
 	struct ad9361_fastlock_entry entry[2][8];
 };
 
+/*
+ * TX quadrature calibration results, i.e. the phase, gain and offset
+ * correction words of both TX outputs, cached per LO frequency.
+ */
+#define AD9361_TX_CAL_CACHE_SIZE	16
+#define AD9361_TX_CAL_CORR_REGS		16
+
+struct ad9361_tx_cal_entry {
+	bool valid;
+	u64 lo_freq;
+	u32 bw_Hz;
+	unsigned long clktf;
+	u32 phase;
+	u8 corr[AD9361_TX_CAL_CORR_REGS];
+};
+
+struct ad9361_tx_cal_cache {
+	bool enable;
+	u8 next;
+	struct ad9361_tx_cal_entry entry[AD9361_TX_CAL_CACHE_SIZE];
+};
+
 struct ad9361_rf_phy_state {
 	u8			prev_ensm_state;
 	u8			curr_ensm_state;
@@ -495,6 +517,7 @@ struct ad9361_rf_phy_state {
 	u32			rf_tx_output_sel;
 
 	struct ad9361_fastlock	fastlock;
+	struct ad9361_tx_cal_cache tx_cal_cache;
 };
 
 #endif
@@ -1855,6 +1855,20 @@ enum lo_ext_info {
 	FHM_HOP,
 };
 
+static bool adrv9009_fhm_can_hop(struct adrv9009_rf_phy *phy,
+				 unsigned int channel, u64 freq)
+{
+	if (channel != 0 || !phy->fhm_mode.fhmEnable ||
+	    phy->fhm_mode.fhmTriggerMode != TAL_FHM_NON_GPIO_MODE)
+		return false;
+
+	if (!(phy->talDevice->devStateInfo.devState & TAL_STATE_RADIOON))
+		return false;
+
+	return freq >= (u64)phy->fhm_config.fhmMinFreq_MHz * 1000000ULL &&
+	       freq <= (u64)phy->fhm_config.fhmMaxFreq_MHz * 1000000ULL;
+}
+
 static ssize_t adrv9009_phy_lo_write(struct iio_dev *indio_dev,
 				     uintptr_t private,
 				     const struct iio_chan_spec *chan,
@@ -1879,6 +1893,18 @@ static ssize_t adrv9009_phy_lo_write(struct iio_dev *indio_dev,
 
 		mutex_lock(&indio_dev->mlock);
 
+		/*
+		 * With frequency hopping mode running, retune through an ARM
+		 * hop, which reuses the calibrations done when FHM was entered
+		 * instead of taking the radio down and relocking the PLL.
+		 */
+		if (adrv9009_fhm_can_hop(phy, chan->channel, readin)) {
+			ret = TALISE_setFhmHop(phy->talDevice, readin);
+			if (ret == TALACT_NO_ACTION)
+				phy->trx_lo_frequency = readin;
+			break;
+		}
+
 		adrv9009_set_radio_state(phy, RADIO_FORCE_OFF);
 
 		if (readin >= 3000000000ULL)
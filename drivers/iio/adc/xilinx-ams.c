@@ -24,8 +24,12 @@
 #include <linux/property.h>
 #include <linux/slab.h>
 
+#include <linux/iio/buffer.h>
 #include <linux/iio/events.h>
 #include <linux/iio/iio.h>
+#include <linux/iio/trigger.h>
+#include <linux/iio/trigger_consumer.h>
+#include <linux/iio/triggered_buffer.h>
 
 /* AMS registers definitions */
 #define AMS_ISR_0			0x010
@@ -55,6 +59,7 @@
 
 #define AMS_REG_CONFIG0			0x100
 #define AMS_REG_CONFIG1			0x104
+#define AMS_REG_CONFIG2			0x108
 #define AMS_REG_CONFIG3			0x10C
 #define AMS_REG_CONFIG4			0x110
 #define AMS_REG_SEQ_CH0			0x120
@@ -95,6 +100,8 @@
 #define AMS_CONF1_SEQ_CONTINUOUS	FIELD_PREP(AMS_CONF1_SEQ_MASK, 2)
 #define AMS_CONF1_SEQ_SINGLE_CHANNEL	FIELD_PREP(AMS_CONF1_SEQ_MASK, 3)
 
+#define AMS_CONF2_DIV_MASK		GENMASK(15, 8)
+
 #define AMS_REG_SEQ0_MASK		GENMASK(15, 0)
 #define AMS_REG_SEQ2_MASK		GENMASK(21, 16)
 #define AMS_REG_SEQ1_MASK		GENMASK_ULL(37, 22)
@@ -129,6 +136,8 @@
 #define AMS_ISR0_ALARM_MASK		GENMASK(31, 0)
 #define AMS_ISR1_ALARM_MASK		(GENMASK(31, 29) | GENMASK(4, 0))
 #define AMS_ISR1_EOC_MASK		BIT(3)
+#define AMS_ISR1_EOS_MASK		BIT(4)
+#define AMS_INTR_EOS_MASK		((u64)AMS_ISR1_EOS_MASK << 32)
 #define AMS_ISR1_INTR_MASK		GENMASK_ULL(63, 32)
 #define AMS_ISR0_ALARM_2_TO_0_MASK	GENMASK(2, 0)
 #define AMS_ISR0_ALARM_6_TO_3_MASK	GENMASK(6, 3)
@@ -150,6 +159,10 @@
 #define AMS_INIT_TIMEOUT_US		10000
 #define AMS_UNMASK_TIMEOUT_MS		500
 
+/* A conversion takes 26 ADC clock cycles, the ADC clock is 5.2 MHz at most */
+#define AMS_CONV_TIME_CYCLES		26
+#define AMS_MAX_SAMPLERATE		200000
+
 /*
  * Following scale and offset value is derived from
  * UG580 (v1.7) December 20, 2016
@@ -222,6 +235,14 @@ enum ams_ps_pl_seq {
 #define PS_SEQ(x)		(x)
 #define PL_SEQ(x)		(AMS_PS_SEQ_MAX + (x))
 #define AMS_CTRL_SEQ_BASE	(AMS_PS_SEQ_MAX * 3)
+#define AMS_TIMESTAMP_SCAN	(AMS_CTRL_SEQ_BASE + AMS_SEQ_INTDDR + 1)
+
+#define AMS_SCAN_TYPE { \
+	.sign = 'u', \
+	.realbits = 16, \
+	.storagebits = 16, \
+	.endianness = IIO_CPU, \
+}
 
 #define AMS_CHAN_TEMP(_scan_index, _addr) { \
 	.type = IIO_TEMP, \
@@ -231,8 +252,10 @@ enum ams_ps_pl_seq {
 		BIT(IIO_CHAN_INFO_PROCESSED) | \
 		BIT(IIO_CHAN_INFO_SCALE) | \
 		BIT(IIO_CHAN_INFO_OFFSET), \
+	.info_mask_shared_by_all = BIT(IIO_CHAN_INFO_SAMP_FREQ), \
 	.event_spec = ams_temp_events, \
 	.scan_index = _scan_index, \
+	.scan_type = AMS_SCAN_TYPE, \
 	.num_event_specs = ARRAY_SIZE(ams_temp_events), \
 }
 
@@ -242,8 +265,10 @@ enum ams_ps_pl_seq {
 	.address = (_addr), \
 	.info_mask_separate = BIT(IIO_CHAN_INFO_RAW) | \
 		BIT(IIO_CHAN_INFO_SCALE), \
+	.info_mask_shared_by_all = BIT(IIO_CHAN_INFO_SAMP_FREQ), \
 	.event_spec = (_alarm) ? ams_voltage_events : NULL, \
 	.scan_index = _scan_index, \
+	.scan_type = AMS_SCAN_TYPE, \
 	.num_event_specs = (_alarm) ? ARRAY_SIZE(ams_voltage_events) : 0, \
 }
 
@@ -274,6 +299,10 @@ enum ams_ps_pl_seq {
  * @current_masked_alarm: currently masked due to alarm
  * @intr_mask: interrupt configuration
  * @ams_unmask_work: re-enables event once the event condition disappears
+ * @trig: end-of-sequence trigger of the PS sysmon
+ * @scan: buffer for one scan of the enabled channels
+ * @scan.channels: channel samples, in scan index order
+ * @scan.timestamp: timestamp of the scan
  *
  */
 struct ams {
@@ -288,6 +317,11 @@ struct ams {
 	unsigned int current_masked_alarm;
 	u64 intr_mask;
 	struct delayed_work ams_unmask_work;
+	struct iio_trigger *trig;
+	struct {
+		u16 channels[AMS_TIMESTAMP_SCAN];
+		s64 timestamp __aligned(8);
+	} scan;
 };
 
 static inline void ams_ps_update_reg(struct ams *ams, unsigned int offset,
@@ -416,8 +450,13 @@ static void ams_enable_channel_sequence(struct iio_dev *indio_dev)
 
 	/* Run calibration of PS & PL as part of the sequence */
 	scan_mask = BIT(0) | BIT(AMS_PS_SEQ_MAX);
-	for (i = 0; i < indio_dev->num_channels; i++)
+	for (i = 0; i < indio_dev->num_channels; i++) {
+		/* control channels and the timestamp are not sequenced */
+		if (indio_dev->channels[i].scan_index >= AMS_CTRL_SEQ_BASE)
+			continue;
+
 		scan_mask |= BIT_ULL(indio_dev->channels[i].scan_index);
+	}
 
 	if (ams->ps_base) {
 		/* put sysmon in a soft reset to change the sequence */
@@ -676,6 +715,55 @@ static int ams_get_ctrl_scale(int address)
 	return val;
 }
 
+static void __iomem *ams_get_sysmon_base(struct ams *ams)
+{
+	return ams->ps_base ? ams->ps_base : ams->pl_base;
+}
+
+static int ams_read_samplerate(struct ams *ams, int *val)
+{
+	unsigned long clk_rate = clk_get_rate(ams->clk);
+	void __iomem *base = ams_get_sysmon_base(ams);
+	unsigned int div;
+
+	if (!base)
+		return -EINVAL;
+
+	div = FIELD_GET(AMS_CONF2_DIV_MASK, readl(base + AMS_REG_CONFIG2));
+	if (div < 2)
+		div = 2;
+
+	*val = clk_rate / div / AMS_CONV_TIME_CYCLES;
+
+	return IIO_VAL_INT;
+}
+
+static int ams_write_samplerate(struct ams *ams, int val)
+{
+	unsigned long clk_rate = clk_get_rate(ams->clk);
+	unsigned int div;
+	u32 regval;
+
+	if (!clk_rate || val <= 0)
+		return -EINVAL;
+
+	val = min(val, AMS_MAX_SAMPLERATE);
+
+	/* Round the divider up so the maximum rate is never exceeded */
+	div = DIV_ROUND_UP(clk_rate, val * AMS_CONV_TIME_CYCLES);
+	div = clamp(div, 2U, 0xffU);
+	regval = FIELD_PREP(AMS_CONF2_DIV_MASK, div);
+
+	if (ams->ps_base)
+		ams_ps_update_reg(ams, AMS_REG_CONFIG2, AMS_CONF2_DIV_MASK,
+				  regval);
+	if (ams->pl_base)
+		ams_pl_update_reg(ams, AMS_REG_CONFIG2, AMS_CONF2_DIV_MASK,
+				  regval);
+
+	return 0;
+}
+
 static int ams_read_raw(struct iio_dev *indio_dev,
 			struct iio_chan_spec const *chan,
 			int *val, int *val2, long mask)
@@ -696,21 +784,30 @@ static int ams_read_raw(struct iio_dev *indio_dev,
 		return IIO_VAL_INT;
 
 	case IIO_CHAN_INFO_RAW:
-		mutex_lock(&ams->lock);
 		if (chan->scan_index >= AMS_CTRL_SEQ_BASE) {
-			ret = ams_read_vcc_reg(ams, chan->address, val);
+			/* single channel mode would stall a running capture */
+			ret = iio_device_claim_direct_mode(indio_dev);
 			if (ret)
-				goto unlock_mutex;
-			ams_enable_channel_sequence(indio_dev);
-		} else if (chan->scan_index >= AMS_PS_SEQ_MAX)
+				return ret;
+
+			mutex_lock(&ams->lock);
+			ret = ams_read_vcc_reg(ams, chan->address, val);
+			if (!ret)
+				ams_enable_channel_sequence(indio_dev);
+			mutex_unlock(&ams->lock);
+			iio_device_release_direct_mode(indio_dev);
+
+			return ret ? ret : IIO_VAL_INT;
+		}
+
+		mutex_lock(&ams->lock);
+		if (chan->scan_index >= AMS_PS_SEQ_MAX)
 			*val = readl(ams->pl_base + chan->address);
 		else
 			*val = readl(ams->ps_base + chan->address);
 
-		ret = IIO_VAL_INT;
-unlock_mutex:
 		mutex_unlock(&ams->lock);
-		return ret;
+		return IIO_VAL_INT;
 	case IIO_CHAN_INFO_SCALE:
 		switch (chan->type) {
 		case IIO_VOLTAGE:
@@ -735,11 +832,30 @@ static int ams_read_raw(struct iio_dev *indio_dev,
 		/* Only the temperature channel has an offset */
 		*val = AMS_TEMP_OFFSET;
 		return IIO_VAL_INT;
+	case IIO_CHAN_INFO_SAMP_FREQ:
+		return ams_read_samplerate(ams, val);
 	default:
 		return -EINVAL;
 	}
 }
 
+static int ams_write_raw(struct iio_dev *indio_dev,
+			 struct iio_chan_spec const *chan,
+			 int val, int val2, long mask)
+{
+	struct ams *ams = iio_priv(indio_dev);
+	int ret;
+
+	if (mask != IIO_CHAN_INFO_SAMP_FREQ)
+		return -EINVAL;
+
+	mutex_lock(&ams->lock);
+	ret = ams_write_samplerate(ams, val);
+	mutex_unlock(&ams->lock);
+
+	return ret;
+}
+
 static int ams_get_alarm_offset(int scan_index, enum iio_event_direction dir)
 {
 	int offset;
@@ -1068,17 +1184,25 @@ static irqreturn_t ams_irq(int irq, void *data)
 {
 	struct iio_dev *indio_dev = data;
 	struct ams *ams = iio_priv(indio_dev);
-	u32 isr0;
+	u32 isr0, isr1;
 
 	spin_lock(&ams->intr_lock);
 
+	isr1 = readl(ams->base + AMS_ISR_1) & AMS_ISR1_EOS_MASK;
+	if (isr1 && !(ams->intr_mask & AMS_INTR_EOS_MASK)) {
+		writel(isr1, ams->base + AMS_ISR_1);
+		iio_trigger_poll(ams->trig);
+	} else {
+		isr1 = 0;
+	}
+
 	isr0 = readl(ams->base + AMS_ISR_0);
 
 	/* Only process alarms that are not masked */
 	isr0 &= ~((ams->intr_mask & AMS_ISR0_ALARM_MASK) | ams->current_masked_alarm);
 	if (!isr0) {
 		spin_unlock(&ams->intr_lock);
-		return IRQ_NONE;
+		return isr1 ? IRQ_HANDLED : IRQ_NONE;
 	}
 
 	/* Clear interrupt */
@@ -1098,6 +1222,119 @@ static irqreturn_t ams_irq(int irq, void *data)
 	return IRQ_HANDLED;
 }
 
+static const struct iio_chan_spec *
+ams_scan_index_to_channel(struct iio_dev *dev, int scan_index)
+{
+	int i;
+
+	for (i = 0; i < dev->num_channels; i++)
+		if (dev->channels[i].scan_index == scan_index)
+			return &dev->channels[i];
+
+	return NULL;
+}
+
+static irqreturn_t ams_trigger_handler(int irq, void *p)
+{
+	struct iio_poll_func *pf = p;
+	struct iio_dev *indio_dev = pf->indio_dev;
+	struct ams *ams = iio_priv(indio_dev);
+	const struct iio_chan_spec *chan;
+	void __iomem *base;
+	int i, j = 0;
+
+	/*
+	 * The sequencer refreshes the result registers on its own, so a scan
+	 * is a plain read of the enabled ones.
+	 */
+	for_each_set_bit(i, indio_dev->active_scan_mask,
+			 indio_dev->masklength) {
+		chan = ams_scan_index_to_channel(indio_dev, i);
+		if (!chan)
+			continue;
+
+		if (chan->scan_index >= AMS_PS_SEQ_MAX)
+			base = ams->pl_base;
+		else
+			base = ams->ps_base;
+
+		ams->scan.channels[j++] = readl(base + chan->address);
+	}
+
+	iio_push_to_buffers_with_timestamp(indio_dev, &ams->scan,
+					   pf->timestamp);
+	iio_trigger_notify_done(indio_dev->trig);
+
+	return IRQ_HANDLED;
+}
+
+static bool ams_validate_scan_mask(struct iio_dev *indio_dev,
+				   const unsigned long *scan_mask)
+{
+	/* control channels need single channel mode, they cannot stream */
+	return find_next_bit(scan_mask, AMS_TIMESTAMP_SCAN,
+			     AMS_CTRL_SEQ_BASE) == AMS_TIMESTAMP_SCAN;
+}
+
+static const struct iio_buffer_setup_ops ams_buffer_ops = {
+	.validate_scan_mask = &ams_validate_scan_mask,
+};
+
+static int ams_trigger_set_state(struct iio_trigger *trig, bool state)
+{
+	struct ams *ams = iio_trigger_get_drvdata(trig);
+	unsigned long flags;
+
+	spin_lock_irqsave(&ams->intr_lock, flags);
+	writel(AMS_ISR1_EOS_MASK, ams->base + AMS_ISR_1);
+	ams_update_intrmask(ams, AMS_INTR_EOS_MASK,
+			    state ? 0 : AMS_INTR_EOS_MASK);
+	spin_unlock_irqrestore(&ams->intr_lock, flags);
+
+	return 0;
+}
+
+static const struct iio_trigger_ops ams_trigger_ops = {
+	.set_trigger_state = &ams_trigger_set_state,
+};
+
+/**
+ * ams_setup_buffer - Set up buffered capture of the sequenced channels
+ * @indio_dev: IIO device
+ *
+ * Any trigger can sample the result registers. The PS sysmon additionally
+ * provides an end-of-sequence trigger, which paces the capture with the
+ * conversion rate set through the sampling_frequency attribute.
+ *
+ * Return: 0 on success, negative error code otherwise
+ */
+static int ams_setup_buffer(struct iio_dev *indio_dev)
+{
+	struct device *dev = indio_dev->dev.parent;
+	struct ams *ams = iio_priv(indio_dev);
+	int ret;
+
+	ret = devm_iio_triggered_buffer_setup(dev, indio_dev,
+					      &iio_pollfunc_store_time,
+					      &ams_trigger_handler,
+					      &ams_buffer_ops);
+	if (ret)
+		return ret;
+
+	if (!ams->ps_base)
+		return 0;
+
+	ams->trig = devm_iio_trigger_alloc(dev, "%s%d-eos", indio_dev->name,
+					   indio_dev->id);
+	if (!ams->trig)
+		return -ENOMEM;
+
+	ams->trig->ops = &ams_trigger_ops;
+	iio_trigger_set_drvdata(ams->trig, ams);
+
+	return devm_iio_trigger_register(dev, ams->trig);
+}
+
 static const struct iio_event_spec ams_temp_events[] = {
 	{
 		.type = IIO_EV_TYPE_THRESH,
@@ -1184,6 +1421,9 @@ static const struct iio_chan_spec ams_ctrl_channels[] = {
 	AMS_CTRL_CHAN_VOLTAGE(AMS_SEQ_INTDDR, AMS_PSINTFPDDR),
 };
 
+static const struct iio_chan_spec ams_timestamp_channel =
+	IIO_CHAN_SOFT_TIMESTAMP(AMS_TIMESTAMP_SCAN);
+
 static int ams_get_ext_chan(struct fwnode_handle *chan_node,
 			    struct iio_chan_spec *channels, int num_channels)
 {
@@ -1283,8 +1523,9 @@ static int ams_parse_firmware(struct iio_dev *indio_dev)
 	int ret, ch_cnt = 0, i, rising_off, falling_off;
 	unsigned int num_channels = 0;
 
+	/* one extra entry for the timestamp */
 	ams_size = ARRAY_SIZE(ams_ps_channels) + ARRAY_SIZE(ams_pl_channels) +
-		ARRAY_SIZE(ams_ctrl_channels);
+		ARRAY_SIZE(ams_ctrl_channels) + 1;
 
 	/* Initialize buffer for channel specification */
 	ams_channels = devm_kcalloc(dev, ams_size, sizeof(*ams_channels), GFP_KERNEL);
@@ -1336,6 +1577,8 @@ static int ams_parse_firmware(struct iio_dev *indio_dev)
 		}
 	}
 
+	ams_channels[num_channels++] = ams_timestamp_channel;
+
 	dev_size = array_size(sizeof(*dev_channels), num_channels);
 	if (dev_size == SIZE_MAX)
 		return -ENOMEM;
@@ -1352,6 +1595,7 @@ static int ams_parse_firmware(struct iio_dev *indio_dev)
 
 static const struct iio_info iio_ams_info = {
 	.read_raw = &ams_read_raw,
+	.write_raw = &ams_write_raw,
 	.read_event_config = &ams_read_event_config,
 	.write_event_config = &ams_write_event_config,
 	.read_event_value = &ams_read_event_value,
@@ -1407,6 +1651,10 @@ static int ams_probe(struct platform_device *pdev)
 
 	ams_enable_channel_sequence(indio_dev);
 
+	ret = ams_setup_buffer(indio_dev);
+	if (ret)
+		return dev_err_probe(&pdev->dev, ret, "failed to set up buffer\n");
+
 	irq = platform_get_irq(pdev, 0);
 	if (irq < 0)
 		return irq;
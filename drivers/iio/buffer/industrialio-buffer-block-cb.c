@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * The industrial I/O block callback buffer
+ *
+ * Hands the blocks of an IIO DMA buffer to an in-kernel consumer by reference.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/err.h>
+#include <linux/export.h>
+#include <linux/iio/iio.h>
+#include <linux/iio/buffer_impl.h>
+#include <linux/iio/buffer-dma.h>
+#include <linux/iio/consumer.h>
+
+struct iio_block_cb_buffer {
+	void (*cb)(struct iio_dma_buffer_block *block, void *private);
+	void *private;
+	struct iio_channel *channels;
+	struct iio_dev *indio_dev;
+	struct iio_buffer *buffer;
+};
+
+static void iio_block_cb_buffer_block_done(struct iio_dma_buffer_block *block,
+	void *private)
+{
+	struct iio_block_cb_buffer *cb_buff = private;
+
+	cb_buff->cb(block, cb_buff->private);
+}
+
+static const struct iio_dma_buffer_consumer_ops iio_block_cb_ops = {
+	.block_done = iio_block_cb_buffer_block_done,
+};
+
+static void iio_block_cb_buffer_disable_channels(
+	struct iio_block_cb_buffer *cb_buff, struct iio_channel *end)
+{
+	struct iio_channel *chan;
+
+	for (chan = cb_buff->channels; chan != end && chan->indio_dev; chan++)
+		iio_buffer_channel_disable(cb_buff->buffer, chan);
+}
+
+struct iio_block_cb_buffer *iio_channel_get_all_block_cb(struct device *dev,
+	unsigned int num_blocks, size_t block_size,
+	void (*cb)(struct iio_dma_buffer_block *block, void *private),
+	void *private)
+{
+	struct iio_block_cb_buffer *cb_buff;
+	struct iio_channel *chan;
+	int ret;
+
+	cb_buff = kzalloc(sizeof(*cb_buff), GFP_KERNEL);
+	if (cb_buff == NULL)
+		return ERR_PTR(-ENOMEM);
+
+	cb_buff->private = private;
+	cb_buff->cb = cb;
+
+	cb_buff->channels = iio_channel_get_all(dev);
+	if (IS_ERR(cb_buff->channels)) {
+		ret = PTR_ERR(cb_buff->channels);
+		goto error_free_cb_buff;
+	}
+
+	cb_buff->indio_dev = cb_buff->channels[0].indio_dev;
+	cb_buff->buffer = cb_buff->indio_dev->buffer;
+	if (!cb_buff->buffer) {
+		ret = -ENODEV;
+		goto error_release_channels;
+	}
+
+	ret = iio_dma_buffer_attach_consumer(cb_buff->buffer, num_blocks,
+		block_size, &iio_block_cb_ops, cb_buff);
+	if (ret < 0)
+		goto error_release_channels;
+
+	chan = &cb_buff->channels[0];
+	while (chan->indio_dev) {
+		if (chan->indio_dev != cb_buff->indio_dev) {
+			ret = -EINVAL;
+			goto error_disable_channels;
+		}
+		iio_buffer_channel_enable(cb_buff->buffer, chan);
+		chan++;
+	}
+
+	return cb_buff;
+
+error_disable_channels:
+	iio_block_cb_buffer_disable_channels(cb_buff, chan);
+	iio_dma_buffer_detach_consumer(cb_buff->buffer);
+error_release_channels:
+	iio_channel_release_all(cb_buff->channels);
+error_free_cb_buff:
+	kfree(cb_buff);
+	return ERR_PTR(ret);
+}
+EXPORT_SYMBOL_GPL(iio_channel_get_all_block_cb);
+
+int iio_channel_start_all_block_cb(struct iio_block_cb_buffer *cb_buff)
+{
+	return iio_update_buffers(cb_buff->indio_dev, cb_buff->buffer, NULL);
+}
+EXPORT_SYMBOL_GPL(iio_channel_start_all_block_cb);
+
+void iio_channel_stop_all_block_cb(struct iio_block_cb_buffer *cb_buff)
+{
+	iio_update_buffers(cb_buff->indio_dev, NULL, cb_buff->buffer);
+}
+EXPORT_SYMBOL_GPL(iio_channel_stop_all_block_cb);
+
+void iio_channel_release_all_block_cb(struct iio_block_cb_buffer *cb_buff)
+{
+	iio_block_cb_buffer_disable_channels(cb_buff, NULL);
+	iio_dma_buffer_detach_consumer(cb_buff->buffer);
+	iio_channel_release_all(cb_buff->channels);
+	kfree(cb_buff);
+}
+EXPORT_SYMBOL_GPL(iio_channel_release_all_block_cb);
+
+struct iio_channel
+*iio_channel_block_cb_get_channels(const struct iio_block_cb_buffer *cb_buffer)
+{
+	return cb_buffer->channels;
+}
+EXPORT_SYMBOL_GPL(iio_channel_block_cb_get_channels);
+
+struct iio_dev
+*iio_channel_block_cb_get_iio_dev(const struct iio_block_cb_buffer *cb_buffer)
+{
+	return cb_buffer->indio_dev;
+}
+EXPORT_SYMBOL_GPL(iio_channel_block_cb_get_iio_dev);
+
+MODULE_DESCRIPTION("Industrial I/O block callback buffer");
+MODULE_LICENSE("GPL");
@@ -15,8 +15,13 @@
 #include <linux/iio/buffer_impl.h>
 #include <linux/iio/iio.h>
 #include <linux/iio/buffer-dma.h>
+#include <linux/dma-buf.h>
+#include <linux/dma-fence.h>
 #include <linux/dma-mapping.h>
+#include <linux/dma-resv.h>
 #include <linux/sizes.h>
+#include <linux/uio.h>
+#include <linux/vmalloc.h>
 
 /*
  * For DMA buffers the storage is sub-divided into so called blocks. Each block
@@ -89,11 +94,66 @@
  * has special requirements that are not handled by the generic functions. If a
  * driver chooses to overload a callback it has to ensure that the generic
  * callback is called from within the custom callback.
+ *
+ * A block can also be exported as a dma-buf so that other devices access its
+ * memory directly. While an exported block is queued, a write fence in the
+ * reservation object of the dma-buf is pending; it is signalled once the block
+ * is done, or with an error if the block is aborted or freed. Consumers such
+ * as a GPU, a network driver or a PL accelerator can then wait on it instead
+ * of the application dequeuing and copying the block.
+ *
+ * For streaming with small blocks, completions can also be read from a ring
+ * of block indices that the application maps, and blocks can be enqueued and
+ * dequeued in batches, so a client needs at most one system call per batch.
+ *
+ * Each completed block is stamped with the CLOCK_TAI times at which its
+ * transfer started and completed and with the stream index of its first
+ * sample. A block that did not follow the previous one back to back, because
+ * the DMA ran out of queued blocks, is flagged as an overflow. This lets
+ * streams of several converters be aligned without looking at the samples.
  */
 
 static unsigned int iio_dma_buffer_max_block_size = SZ_16M;
 module_param_named(max_block_size, iio_dma_buffer_max_block_size, uint, 0644);
 
+static const char *iio_dma_fence_get_driver_name(struct dma_fence *fence)
+{
+	return "iio-dma-buffer";
+}
+
+static const char *iio_dma_fence_get_timeline_name(struct dma_fence *fence)
+{
+	return "iio";
+}
+
+static const struct dma_fence_ops iio_dma_fence_ops = {
+	.get_driver_name = iio_dma_fence_get_driver_name,
+	.get_timeline_name = iio_dma_fence_get_timeline_name,
+};
+
+struct iio_dma_fence {
+	struct dma_fence base;
+	spinlock_t lock;
+};
+
+/*
+ * Signal the fence of a block, if it has one. May be called from atomic
+ * context.
+ */
+static void iio_dma_buffer_block_signal(struct iio_dma_buffer_block *block,
+	int error)
+{
+	struct dma_fence *fence = xchg(&block->fence, NULL);
+
+	if (!fence)
+		return;
+
+	if (error)
+		dma_fence_set_error(fence, error);
+	dma_fence_signal(fence);
+	dma_fence_put(fence);
+}
+
 static void iio_buffer_block_release(struct kref *kref)
 {
 	struct iio_dma_buffer_block *block = container_of(kref,
@@ -101,6 +161,8 @@ static void iio_buffer_block_release(struct kref *kref)
 
 	WARN_ON(block->state != IIO_BLOCK_STATE_DEAD);
 
+	iio_dma_buffer_block_signal(block, -ECANCELED);
+
 	dma_free_coherent(block->queue->dev, PAGE_ALIGN(block->block.size),
 					block->vaddr, block->phys_addr);
 
@@ -193,10 +255,55 @@ static struct iio_dma_buffer_block *iio_dma_buffer_alloc_block(
 	return block;
 }
 
+/* Called with queue->list_lock held */
+static void iio_dma_buffer_ring_push(struct iio_dma_buffer_queue *queue,
+	struct iio_dma_buffer_block *block)
+{
+	struct iio_buffer_block_ring *ring = queue->ring;
+	struct iio_buffer_block_ring_entry *entry;
+	u32 head = queue->ring_head;
+
+	if (head - READ_ONCE(ring->tail) >= IIO_BLOCK_RING_ENTRIES) {
+		WRITE_ONCE(ring->overflow, ring->overflow + 1);
+		return;
+	}
+
+	entry = &ring->entries[head % IIO_BLOCK_RING_ENTRIES];
+	WRITE_ONCE(entry->id, block->block.id);
+	WRITE_ONCE(entry->bytes_used, block->block.bytes_used);
+
+	queue->ring_head = head + 1;
+	smp_store_release(&ring->head, queue->ring_head);
+}
+
+/* Called with queue->list_lock held */
+static void iio_dma_buffer_block_stamp(struct iio_dma_buffer_queue *queue,
+	struct iio_dma_buffer_block *block)
+{
+	size_t bpd = queue->buffer.bytes_per_datum;
+	u64 now = ktime_get_clocktai_ns();
+
+	if (queue->num_active)
+		queue->num_active--;
+
+	if (!block->start_timestamp)
+		block->start_timestamp = queue->last_timestamp;
+	block->block.timestamp = now;
+	block->block.flags |= IIO_BUFFER_BLOCK_FLAG_TIMESTAMP_VALID;
+	queue->last_timestamp = now;
+
+	block->sample_counter = queue->sample_counter;
+	if (bpd)
+		queue->sample_counter += block->block.bytes_used / bpd;
+}
+
 static void _iio_dma_buffer_block_done(struct iio_dma_buffer_block *block)
 {
 	struct iio_dma_buffer_queue *queue = block->queue;
 
+	iio_dma_buffer_block_signal(block, 0);
+	iio_dma_buffer_block_stamp(queue, block);
+
 	/*
 	 * The buffer has already been freed by the application, just drop the
 	 * reference.
@@ -204,6 +311,11 @@ static void _iio_dma_buffer_block_done(struct iio_dma_buffer_block *block)
 	if (block->state != IIO_BLOCK_STATE_DEAD) {
 		block->state = IIO_BLOCK_STATE_DONE;
 		list_add_tail(&block->head, &queue->outgoing);
+		/* The fileio block is not one of the blocks of the ring */
+		if (queue->ring && queue->num_blocks)
+			iio_dma_buffer_ring_push(queue, block);
+		if (queue->consumer_ops)
+			schedule_work(&queue->consumer_work);
 	}
 }
 
@@ -248,6 +360,7 @@ void iio_dma_buffer_block_list_abort(struct iio_dma_buffer_queue *queue,
 	list_for_each_entry_safe(block, _block, list, head) {
 		list_del(&block->head);
 		block->block.bytes_used = 0;
+		iio_dma_buffer_block_signal(block, -ECANCELED);
 		_iio_dma_buffer_block_done(block);
 		iio_buffer_block_put_atomic(block);
 	}
@@ -304,10 +417,31 @@ static void iio_dma_buffer_submit_block(struct iio_dma_buffer_queue *queue,
 	if (!queue->ops)
 		return;
 
+	/*
+	 * A block submitted while the DMA is idle starts now. If samples were
+	 * already transferred, the ones in between were lost.
+	 */
+	block->block.flags &= ~(IIO_BUFFER_BLOCK_FLAG_TIMESTAMP_VALID |
+				IIO_BUFFER_BLOCK_FLAG_OVERFLOW);
+	spin_lock_irq(&queue->list_lock);
+	if (queue->num_active) {
+		block->start_timestamp = 0;
+	} else {
+		block->start_timestamp = ktime_get_clocktai_ns();
+		if (queue->sample_counter)
+			block->block.flags |= IIO_BUFFER_BLOCK_FLAG_OVERFLOW;
+	}
+	queue->num_active++;
+	spin_unlock_irq(&queue->list_lock);
+
 	block->state = IIO_BLOCK_STATE_ACTIVE;
 	iio_buffer_block_get(block);
 	ret = queue->ops->submit(queue, block);
 	if (ret) {
+		spin_lock_irq(&queue->list_lock);
+		queue->num_active--;
+		spin_unlock_irq(&queue->list_lock);
+
 		/*
 		 * This is a bit of a problem and there is not much we can do
 		 * other then wait for the buffer to be disabled and re-enabled
@@ -341,6 +475,11 @@ int iio_dma_buffer_enable(struct iio_buffer *buffer,
 	mutex_lock(&queue->lock);
 	queue->active = true;
 
+	spin_lock_irq(&queue->list_lock);
+	queue->sample_counter = 0;
+	queue->last_timestamp = 0;
+	spin_unlock_irq(&queue->list_lock);
+
 	/**
 	 * If no buffer blocks are allocated when we start streaming go into
 	 * fileio mode.
@@ -417,19 +556,20 @@ static struct iio_dma_buffer_block *iio_dma_buffer_dequeue(
 }
 
 /**
- * iio_dma_buffer_read() - DMA buffer read callback
+ * iio_dma_buffer_read_iter() - DMA buffer read_iter callback
  * @buffer: Buffer to read form
  * @n: Number of bytes to read
- * @user_buffer: Userspace buffer to copy the data to
+ * @to: Iterator to copy the data to
  *
- * Should be used as the read callback for iio_buffer_access_ops
+ * Should be used as the read_iter callback for iio_buffer_access_ops
  * struct for DMA buffers.
  */
-int iio_dma_buffer_read(struct iio_buffer *buffer, size_t n,
-	char __user *user_buffer)
+int iio_dma_buffer_read_iter(struct iio_buffer *buffer, size_t n,
+	struct iov_iter *to)
 {
 	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
 	struct iio_dma_buffer_block *block;
+	size_t copied;
 	int ret;
 
 	if (n < buffer->bytes_per_datum)
@@ -459,9 +599,15 @@ int iio_dma_buffer_read(struct iio_buffer *buffer, size_t n,
 	if (n > block->block.bytes_used - queue->fileio.pos)
 		n = block->block.bytes_used - queue->fileio.pos;
 
-	if (copy_to_user(user_buffer, block->vaddr + queue->fileio.pos, n)) {
-		ret = -EFAULT;
-		goto out_unlock;
+	/* Only consume whole samples if the destination runs out of space */
+	copied = copy_to_iter(block->vaddr + queue->fileio.pos, n, to);
+	if (copied != n) {
+		iov_iter_revert(to, copied % buffer->bytes_per_datum);
+		n = rounddown(copied, buffer->bytes_per_datum);
+		if (!n) {
+			ret = -EFAULT;
+			goto out_unlock;
+		}
 	}
 
 	queue->fileio.pos += n;
@@ -476,6 +622,30 @@ int iio_dma_buffer_read(struct iio_buffer *buffer, size_t n,
 
 	return ret;
 }
+EXPORT_SYMBOL_GPL(iio_dma_buffer_read_iter);
+
+/**
+ * iio_dma_buffer_read() - DMA buffer read callback
+ * @buffer: Buffer to read form
+ * @n: Number of bytes to read
+ * @user_buffer: Userspace buffer to copy the data to
+ *
+ * Should be used as the read callback for iio_buffer_access_ops
+ * struct for DMA buffers.
+ */
+int iio_dma_buffer_read(struct iio_buffer *buffer, size_t n,
+	char __user *user_buffer)
+{
+	struct iov_iter to;
+	struct iovec iov;
+	int ret;
+
+	ret = import_single_range(READ, user_buffer, n, &iov, &to);
+	if (ret)
+		return ret;
+
+	return iio_dma_buffer_read_iter(buffer, n, &to);
+}
 EXPORT_SYMBOL_GPL(iio_dma_buffer_read);
 
 int iio_dma_buffer_write(struct iio_buffer *buf, size_t n,
@@ -586,21 +756,16 @@ bool iio_dma_buffer_space_available(struct iio_buffer *buf)
 }
 EXPORT_SYMBOL_GPL(iio_dma_buffer_space_available);
 
-int iio_dma_buffer_alloc_blocks(struct iio_buffer *buffer,
+/* Called with queue->lock held */
+static int __iio_dma_buffer_alloc_blocks(struct iio_dma_buffer_queue *queue,
 	struct iio_buffer_block_alloc_req *req)
 {
-	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
 	struct iio_dma_buffer_block **blocks;
 	unsigned int num_blocks;
 	unsigned int i;
-	int ret = 0;
 
-	mutex_lock(&queue->lock);
-
-	if (queue->fileio.active_block) {
-		ret = -EBUSY;
-		goto err_unlock;
-	}
+	if (queue->fileio.active_block)
+		return -EBUSY;
 
 	/* 64 blocks ought to be enough for anybody ;) */
 	if (req->count > 64 - queue->num_blocks)
@@ -610,19 +775,15 @@ int iio_dma_buffer_alloc_blocks(struct iio_buffer *buffer,
 
 	req->id = queue->num_blocks;
 
-	if (req->count == 0 || req->size == 0) {
-		ret = 0;
-		goto err_unlock;
-	}
+	if (req->count == 0 || req->size == 0)
+		return 0;
 
 	num_blocks = req->count + queue->num_blocks;
 
 	blocks = krealloc(queue->blocks, sizeof(*blocks) * num_blocks,
 			GFP_KERNEL);
-	if (!blocks) {
-		ret = -ENOMEM;
-		goto err_unlock;
-	}
+	if (!blocks)
+		return -ENOMEM;
 
 	for (i = queue->num_blocks; i < num_blocks; i++) {
 		blocks[i] = iio_dma_buffer_alloc_block(queue, req->size);
@@ -637,7 +798,21 @@ int iio_dma_buffer_alloc_blocks(struct iio_buffer *buffer,
 	queue->num_blocks = i;
 	queue->blocks = blocks;
 
-err_unlock:
+	return 0;
+}
+
+int iio_dma_buffer_alloc_blocks(struct iio_buffer *buffer,
+	struct iio_buffer_block_alloc_req *req)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+	int ret;
+
+	mutex_lock(&queue->lock);
+	/* The blocks belong to the in-kernel consumer */
+	if (queue->consumer_ops)
+		ret = -EBUSY;
+	else
+		ret = __iio_dma_buffer_alloc_blocks(queue, req);
 	mutex_unlock(&queue->lock);
 
 	return ret;
@@ -651,12 +826,22 @@ int iio_dma_buffer_free_blocks(struct iio_buffer *buffer)
 
 	mutex_lock(&queue->lock);
 
+	if (queue->consumer_ops) {
+		mutex_unlock(&queue->lock);
+		return -EBUSY;
+	}
+
 	spin_lock_irq(&queue->list_lock);
 	INIT_LIST_HEAD(&queue->incoming);
 	INIT_LIST_HEAD(&queue->outgoing);
 
-	for (i = 0; i < queue->num_blocks; i++)
+	for (i = 0; i < queue->num_blocks; i++) {
+		/* Active blocks signal their fence when the DMA is done */
+		if (queue->blocks[i]->state != IIO_BLOCK_STATE_ACTIVE)
+			iio_dma_buffer_block_signal(queue->blocks[i],
+						    -ECANCELED);
 		queue->blocks[i]->state = IIO_BLOCK_STATE_DEAD;
+	}
 	spin_unlock_irq(&queue->list_lock);
 
 	for (i = 0; i < queue->num_blocks; i++)
@@ -696,6 +881,45 @@ int iio_dma_buffer_query_block(struct iio_buffer *buffer,
 }
 EXPORT_SYMBOL_GPL(iio_dma_buffer_query_block);
 
+/*
+ * Add a write fence for a block that is about to be queued to the reservation
+ * object of its dma-buf. The block holds its own reference to the fence until
+ * it signals it.
+ */
+static int iio_dma_buffer_block_add_fence(struct iio_dma_buffer_queue *queue,
+	struct iio_dma_buffer_block *block)
+{
+	struct dma_resv *resv = block->dmabuf->resv;
+	struct iio_dma_fence *fence;
+	int ret;
+
+	fence = kmalloc(sizeof(*fence), GFP_KERNEL);
+	if (!fence)
+		return -ENOMEM;
+
+	spin_lock_init(&fence->lock);
+	dma_fence_init(&fence->base, &iio_dma_fence_ops, &fence->lock,
+		queue->fence_context, ++queue->fence_seqno);
+
+	dma_resv_lock(resv, NULL);
+	ret = dma_resv_reserve_fences(resv, 1);
+	if (!ret)
+		dma_resv_add_fence(resv, &fence->base, DMA_RESV_USAGE_WRITE);
+	dma_resv_unlock(resv);
+
+	if (ret) {
+		dma_fence_signal(&fence->base);
+		dma_fence_put(&fence->base);
+		return ret;
+	}
+
+	/* A fence left from an earlier round was never completed */
+	iio_dma_buffer_block_signal(block, -ECANCELED);
+	block->fence = &fence->base;
+
+	return 0;
+}
+
 int iio_dma_buffer_enqueue_block(struct iio_buffer *buffer,
 	struct iio_buffer_block *block)
 {
@@ -705,6 +929,11 @@ int iio_dma_buffer_enqueue_block(struct iio_buffer *buffer,
 
 	mutex_lock(&queue->lock);
 
+	if (queue->consumer_ops) {
+		ret = -EBUSY;
+		goto out_unlock;
+	}
+
 	if (block->id >= queue->num_blocks) {
 		ret = -EINVAL;
 		goto out_unlock;
@@ -716,7 +945,6 @@ int iio_dma_buffer_enqueue_block(struct iio_buffer *buffer,
 
 	switch (dma_block->state) {
 	case IIO_BLOCK_STATE_DONE:
-		list_del_init(&dma_block->head);
 		break;
 	case IIO_BLOCK_STATE_QUEUED:
 		/* Nothing to do */
@@ -728,6 +956,18 @@ int iio_dma_buffer_enqueue_block(struct iio_buffer *buffer,
 		goto out_unlock;
 	}
 
+	if (dma_block->dmabuf) {
+		ret = iio_dma_buffer_block_add_fence(queue, dma_block);
+		if (ret)
+			goto out_unlock;
+	}
+
+	if (dma_block->state == IIO_BLOCK_STATE_DONE) {
+		spin_lock_irq(&queue->list_lock);
+		list_del_init(&dma_block->head);
+		spin_unlock_irq(&queue->list_lock);
+	}
+
 	iio_dma_buffer_enqueue(queue, dma_block);
 
 out_unlock:
@@ -746,6 +986,11 @@ int iio_dma_buffer_dequeue_block(struct iio_buffer *buffer,
 
 	mutex_lock(&queue->lock);
 
+	if (queue->consumer_ops) {
+		ret = -EBUSY;
+		goto out_unlock;
+	}
+
 	dma_block = iio_dma_buffer_dequeue(queue);
 	if (!dma_block) {
 		ret = -EAGAIN;
@@ -761,6 +1006,176 @@ int iio_dma_buffer_dequeue_block(struct iio_buffer *buffer,
 }
 EXPORT_SYMBOL_GPL(iio_dma_buffer_dequeue_block);
 
+/**
+ * iio_dma_buffer_dequeue_block_meta() - Dequeue a block with its metadata
+ * @buffer: Buffer to dequeue the block from
+ * @meta: Returns the block and its capture metadata
+ *
+ * Should be used as the dequeue_block_meta callback for iio_buffer_access_ops
+ * struct for DMA buffers.
+ */
+int iio_dma_buffer_dequeue_block_meta(struct iio_buffer *buffer,
+	struct iio_buffer_block_meta *meta)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+	struct iio_dma_buffer_block *dma_block;
+	int ret = 0;
+
+	mutex_lock(&queue->lock);
+
+	if (queue->consumer_ops) {
+		ret = -EBUSY;
+		goto out_unlock;
+	}
+
+	dma_block = iio_dma_buffer_dequeue(queue);
+	if (!dma_block) {
+		ret = -EAGAIN;
+		goto out_unlock;
+	}
+
+	memset(meta, 0, sizeof(*meta));
+	meta->block = dma_block->block;
+	meta->start_timestamp = dma_block->start_timestamp;
+	meta->sample_counter = dma_block->sample_counter;
+
+out_unlock:
+	mutex_unlock(&queue->lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_dequeue_block_meta);
+
+static void iio_dma_buffer_consumer_work(struct work_struct *work)
+{
+	struct iio_dma_buffer_queue *queue = container_of(work,
+		struct iio_dma_buffer_queue, consumer_work);
+	const struct iio_dma_buffer_consumer_ops *ops;
+	struct iio_dma_buffer_block *block;
+
+	for (;;) {
+		spin_lock_irq(&queue->list_lock);
+		ops = queue->consumer_ops;
+		block = list_first_entry_or_null(&queue->outgoing,
+			struct iio_dma_buffer_block, head);
+		if (ops && block) {
+			list_del(&block->head);
+			block->state = IIO_BLOCK_STATE_DEQUEUED;
+		}
+		spin_unlock_irq(&queue->list_lock);
+
+		if (!ops || !block)
+			break;
+
+		ops->block_done(block, queue->consumer_private);
+	}
+}
+
+/**
+ * iio_dma_buffer_attach_consumer() - Attach an in-kernel consumer
+ * @buffer: DMA buffer to attach the consumer to
+ * @num_blocks: Number of blocks to allocate
+ * @block_size: Size of each block in bytes
+ * @ops: Consumer callbacks
+ * @private: Private data passed to @ops
+ *
+ * Allocates the blocks of the buffer and queues all of them, so that they are
+ * handed to @ops as soon as the buffer is enabled. The blocks are passed by
+ * reference, no data is copied. While a consumer is attached the buffer can
+ * not be used from userspace.
+ *
+ * Returns the number of blocks that were allocated, which may be less than
+ * @num_blocks, or a negative error code.
+ */
+int iio_dma_buffer_attach_consumer(struct iio_buffer *buffer,
+	unsigned int num_blocks, size_t block_size,
+	const struct iio_dma_buffer_consumer_ops *ops, void *private)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+	struct iio_buffer_block_alloc_req req = {
+		.count = num_blocks,
+		.size = block_size,
+	};
+	unsigned int i;
+	int ret;
+
+	if (buffer->access->alloc_blocks != iio_dma_buffer_alloc_blocks)
+		return -EINVAL;
+
+	mutex_lock(&queue->lock);
+
+	if (queue->consumer_ops || queue->active || queue->num_blocks) {
+		ret = -EBUSY;
+		goto out_unlock;
+	}
+
+	ret = __iio_dma_buffer_alloc_blocks(queue, &req);
+	if (ret)
+		goto out_unlock;
+	if (req.count == 0) {
+		ret = -ENOMEM;
+		goto out_unlock;
+	}
+
+	spin_lock_irq(&queue->list_lock);
+	queue->consumer_private = private;
+	queue->consumer_ops = ops;
+	spin_unlock_irq(&queue->list_lock);
+
+	for (i = 0; i < queue->num_blocks; i++)
+		iio_dma_buffer_enqueue(queue, queue->blocks[i]);
+	ret = req.count;
+
+out_unlock:
+	mutex_unlock(&queue->lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_attach_consumer);
+
+/**
+ * iio_dma_buffer_detach_consumer() - Detach the in-kernel consumer
+ * @buffer: DMA buffer to detach the consumer from
+ *
+ * Must be called with the buffer disabled and after the consumer released all
+ * the blocks it was handed. Frees the blocks of the buffer.
+ */
+void iio_dma_buffer_detach_consumer(struct iio_buffer *buffer)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+
+	mutex_lock(&queue->lock);
+	spin_lock_irq(&queue->list_lock);
+	queue->consumer_ops = NULL;
+	queue->consumer_private = NULL;
+	spin_unlock_irq(&queue->list_lock);
+	mutex_unlock(&queue->lock);
+
+	cancel_work_sync(&queue->consumer_work);
+	iio_dma_buffer_free_blocks(buffer);
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_detach_consumer);
+
+/**
+ * iio_dma_buffer_consumer_release_block() - Hand a block back to the buffer
+ * @block: Block that was passed to the consumer's block_done() callback
+ *
+ * Queues the block again for the next transfer. May be called from within the
+ * block_done() callback.
+ */
+void iio_dma_buffer_consumer_release_block(struct iio_dma_buffer_block *block)
+{
+	struct iio_dma_buffer_queue *queue = block->queue;
+
+	mutex_lock(&queue->lock);
+	if (block->state == IIO_BLOCK_STATE_DEQUEUED) {
+		block->block.flags = 0;
+		iio_dma_buffer_enqueue(queue, block);
+	}
+	mutex_unlock(&queue->lock);
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_consumer_release_block);
+
 
 static void iio_dma_buffer_mmap_open(struct vm_area_struct *area)
 {
@@ -779,6 +1194,50 @@ static const struct vm_operations_struct iio_dma_buffer_vm_ops = {
 	.close = iio_dma_buffer_mmap_close,
 };
 
+static void iio_dma_buffer_ring_mmap_open(struct vm_area_struct *area)
+{
+	struct iio_dma_buffer_queue *queue = area->vm_private_data;
+
+	iio_buffer_get(&queue->buffer);
+}
+
+static void iio_dma_buffer_ring_mmap_close(struct vm_area_struct *area)
+{
+	struct iio_dma_buffer_queue *queue = area->vm_private_data;
+
+	iio_buffer_put(&queue->buffer);
+}
+
+static const struct vm_operations_struct iio_dma_buffer_ring_vm_ops = {
+	.open = iio_dma_buffer_ring_mmap_open,
+	.close = iio_dma_buffer_ring_mmap_close,
+};
+
+static int iio_dma_buffer_ring_mmap(struct iio_dma_buffer_queue *queue,
+	struct vm_area_struct *vma)
+{
+	int ret;
+
+	if (!queue->ring)
+		return -EINVAL;
+
+	if (vma->vm_end - vma->vm_start >
+	    PAGE_ALIGN(sizeof(struct iio_buffer_block_ring)))
+		return -EINVAL;
+
+	ret = remap_vmalloc_range(vma, queue->ring, 0);
+	if (ret)
+		return ret;
+
+	vma->vm_flags |= VM_DONTEXPAND | VM_DONTDUMP;
+	vma->vm_ops = &iio_dma_buffer_ring_vm_ops;
+	vma->vm_private_data = queue;
+
+	vma->vm_ops->open(vma);
+
+	return 0;
+}
+
 int iio_dma_buffer_mmap(struct iio_buffer *buffer,
 	struct vm_area_struct *vma)
 {
@@ -789,6 +1248,9 @@ int iio_dma_buffer_mmap(struct iio_buffer *buffer,
 
 	vm_offset = vma->vm_pgoff << PAGE_SHIFT;
 
+	if (vm_offset == IIO_BLOCK_RING_OFFSET)
+		return iio_dma_buffer_ring_mmap(queue, vma);
+
 	for (i = 0; i < queue->num_blocks; i++) {
 		if (queue->blocks[i]->block.data.offset == vm_offset) {
 			block = queue->blocks[i];
@@ -815,6 +1277,191 @@ int iio_dma_buffer_mmap(struct iio_buffer *buffer,
 }
 EXPORT_SYMBOL_GPL(iio_dma_buffer_mmap);
 
+/**
+ * iio_dma_buffer_setup_ring() - Set up the completion ring
+ * @buffer: Buffer to set up the ring for
+ * @info: Returns where and how the ring is to be mapped
+ *
+ * The ring is allocated on the first call and lives as long as the buffer.
+ * Should be used as the setup_ring callback for iio_buffer_access_ops struct
+ * for DMA buffers.
+ */
+int iio_dma_buffer_setup_ring(struct iio_buffer *buffer,
+	struct iio_buffer_block_ring_info *info)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+	struct iio_buffer_block_ring *ring;
+	int ret = 0;
+
+	mutex_lock(&queue->lock);
+
+	if (!queue->ring) {
+		ring = vmalloc_user(sizeof(*ring));
+		if (!ring) {
+			ret = -ENOMEM;
+			goto out_unlock;
+		}
+
+		spin_lock_irq(&queue->list_lock);
+		queue->ring_head = 0;
+		queue->ring = ring;
+		spin_unlock_irq(&queue->list_lock);
+	}
+
+	info->offset = IIO_BLOCK_RING_OFFSET;
+	info->size = PAGE_ALIGN(sizeof(*ring));
+	info->entries = IIO_BLOCK_RING_ENTRIES;
+
+out_unlock:
+	mutex_unlock(&queue->lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_setup_ring);
+
+static struct sg_table *iio_dma_buffer_dmabuf_map(
+	struct dma_buf_attachment *attach, enum dma_data_direction dir)
+{
+	struct iio_dma_buffer_block *block = attach->dmabuf->priv;
+	struct sg_table *sgt;
+	int ret;
+
+	sgt = kzalloc(sizeof(*sgt), GFP_KERNEL);
+	if (!sgt)
+		return ERR_PTR(-ENOMEM);
+
+	ret = dma_get_sgtable(block->queue->dev, sgt, block->vaddr,
+		block->phys_addr, PAGE_ALIGN(block->block.size));
+	if (ret)
+		goto err_free;
+
+	ret = dma_map_sgtable(attach->dev, sgt, dir, 0);
+	if (ret)
+		goto err_free_table;
+
+	return sgt;
+
+err_free_table:
+	sg_free_table(sgt);
+err_free:
+	kfree(sgt);
+	return ERR_PTR(ret);
+}
+
+static void iio_dma_buffer_dmabuf_unmap(struct dma_buf_attachment *attach,
+	struct sg_table *sgt, enum dma_data_direction dir)
+{
+	dma_unmap_sgtable(attach->dev, sgt, dir, 0);
+	sg_free_table(sgt);
+	kfree(sgt);
+}
+
+static int iio_dma_buffer_dmabuf_mmap(struct dma_buf *dmabuf,
+	struct vm_area_struct *vma)
+{
+	struct iio_dma_buffer_block *block = dmabuf->priv;
+
+	if (vma->vm_pgoff ||
+	    PAGE_ALIGN(block->block.size) < vma->vm_end - vma->vm_start)
+		return -EINVAL;
+
+	return dma_mmap_coherent(block->queue->dev, vma, block->vaddr,
+		block->phys_addr, vma->vm_end - vma->vm_start);
+}
+
+static int iio_dma_buffer_dmabuf_vmap(struct dma_buf *dmabuf,
+	struct iosys_map *map)
+{
+	struct iio_dma_buffer_block *block = dmabuf->priv;
+
+	iosys_map_set_vaddr(map, block->vaddr);
+
+	return 0;
+}
+
+static void iio_dma_buffer_dmabuf_release(struct dma_buf *dmabuf)
+{
+	struct iio_dma_buffer_block *block = dmabuf->priv;
+	struct iio_dma_buffer_queue *queue = block->queue;
+
+	mutex_lock(&queue->lock);
+	block->dmabuf = NULL;
+	mutex_unlock(&queue->lock);
+
+	iio_buffer_block_put(block);
+}
+
+static const struct dma_buf_ops iio_dma_buffer_dmabuf_ops = {
+	.map_dma_buf = iio_dma_buffer_dmabuf_map,
+	.unmap_dma_buf = iio_dma_buffer_dmabuf_unmap,
+	.mmap = iio_dma_buffer_dmabuf_mmap,
+	.vmap = iio_dma_buffer_dmabuf_vmap,
+	.release = iio_dma_buffer_dmabuf_release,
+};
+
+/**
+ * iio_dma_buffer_export_block() - Export a block as a dma-buf
+ * @buffer: Buffer the block belongs to
+ * @req: Export request, the file descriptor is returned in req->fd
+ *
+ * All exports of a block share one dma-buf, which holds a reference to the
+ * block. Should be used as the export_block callback for
+ * iio_buffer_access_ops struct for DMA buffers.
+ */
+int iio_dma_buffer_export_block(struct iio_buffer *buffer,
+	struct iio_buffer_block_dmabuf *req)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+	struct iio_dma_buffer_block *block;
+	struct dma_buf *dmabuf;
+	int fd;
+
+	if (req->flags & ~O_CLOEXEC)
+		return -EINVAL;
+
+	mutex_lock(&queue->lock);
+
+	if (req->id >= queue->num_blocks) {
+		mutex_unlock(&queue->lock);
+		return -EINVAL;
+	}
+
+	block = queue->blocks[req->id];
+	dmabuf = block->dmabuf;
+	if (dmabuf) {
+		get_dma_buf(dmabuf);
+	} else {
+		DEFINE_DMA_BUF_EXPORT_INFO(exp_info);
+
+		exp_info.ops = &iio_dma_buffer_dmabuf_ops;
+		exp_info.size = PAGE_ALIGN(block->block.size);
+		exp_info.flags = O_RDWR;
+		exp_info.priv = block;
+
+		dmabuf = dma_buf_export(&exp_info);
+		if (IS_ERR(dmabuf)) {
+			mutex_unlock(&queue->lock);
+			return PTR_ERR(dmabuf);
+		}
+
+		iio_buffer_block_get(block);
+		block->dmabuf = dmabuf;
+	}
+
+	mutex_unlock(&queue->lock);
+
+	fd = dma_buf_fd(dmabuf, req->flags);
+	if (fd < 0) {
+		dma_buf_put(dmabuf);
+		return fd;
+	}
+
+	req->fd = fd;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_export_block);
+
 /**
  * iio_dma_buffer_set_bytes_per_datum() - DMA buffer set_bytes_per_datum callback
  * @buffer: Buffer to set the bytes-per-datum for
@@ -878,6 +1525,9 @@ int iio_dma_buffer_init(struct iio_dma_buffer_queue *queue,
 
 	mutex_init(&queue->lock);
 	spin_lock_init(&queue->list_lock);
+	INIT_WORK(&queue->consumer_work, iio_dma_buffer_consumer_work);
+
+	queue->fence_context = dma_fence_context_alloc(1);
 
 	if (!queue->dev->dma_mask)
 		queue->dev->dma_mask = &dmamask;
@@ -913,6 +1563,7 @@ EXPORT_SYMBOL_GPL(iio_dma_buffer_exit);
  */
 void iio_dma_buffer_release(struct iio_dma_buffer_queue *queue)
 {
+	vfree(queue->ring);
 	mutex_destroy(&queue->lock);
 }
 EXPORT_SYMBOL_GPL(iio_dma_buffer_release);
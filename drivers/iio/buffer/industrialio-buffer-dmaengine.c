@@ -130,6 +130,7 @@ static void iio_dmaengine_buffer_release(struct iio_buffer *buf)
 
 static const struct iio_buffer_access_funcs iio_dmaengine_buffer_ops = {
 	.read = iio_dma_buffer_read,
+	.read_iter = iio_dma_buffer_read_iter,
 	.write = iio_dma_buffer_write,
 	.set_bytes_per_datum = iio_dma_buffer_set_bytes_per_datum,
 	.set_length = iio_dma_buffer_set_length,
@@ -144,7 +145,10 @@ static const struct iio_buffer_access_funcs iio_dmaengine_buffer_ops = {
 	.query_block = iio_dma_buffer_query_block,
 	.enqueue_block = iio_dma_buffer_enqueue_block,
 	.dequeue_block = iio_dma_buffer_dequeue_block,
+	.dequeue_block_meta = iio_dma_buffer_dequeue_block_meta,
 	.mmap = iio_dma_buffer_mmap,
+	.export_block = iio_dma_buffer_export_block,
+	.setup_ring = iio_dma_buffer_setup_ring,
 
 	.modes = INDIO_BUFFER_HARDWARE,
 	.flags = INDIO_BUFFER_FLAG_FIXED_WATERMARK,
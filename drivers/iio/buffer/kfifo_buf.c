@@ -12,6 +12,7 @@
 #include <linux/iio/buffer_impl.h>
 #include <linux/sched.h>
 #include <linux/poll.h>
+#include <linux/uio.h>
 
 struct iio_kfifo {
 	struct iio_buffer buffer;
@@ -98,6 +99,14 @@ static int iio_store_to_kfifo(struct iio_buffer *r,
 	return 0;
 }
 
+static int iio_store_to_kfifo_n(struct iio_buffer *r, const void *data,
+				unsigned int n)
+{
+	struct iio_kfifo *kf = iio_to_kfifo(r);
+
+	return kfifo_in(&kf->kf, data, n);
+}
+
 static int iio_read_kfifo(struct iio_buffer *r, size_t n, char __user *buf)
 {
 	int ret, copied;
@@ -117,6 +126,52 @@ static int iio_read_kfifo(struct iio_buffer *r, size_t n, char __user *buf)
 	return copied;
 }
 
+static int iio_read_iter_kfifo(struct iio_buffer *r, size_t n,
+			       struct iov_iter *to)
+{
+	struct iio_kfifo *kf = iio_to_kfifo(r);
+	struct __kfifo *fifo = &kf->kf.kfifo;
+	unsigned int esize, size, off, want, len, l;
+	size_t copied;
+	int ret;
+
+	if (mutex_lock_interruptible(&kf->user_lock))
+		return -ERESTARTSYS;
+
+	if (!kfifo_initialized(&kf->kf) || n < kfifo_esize(&kf->kf)) {
+		ret = -EINVAL;
+		goto out_unlock;
+	}
+
+	/* Copy straight out of the two halves of the ring, in whole elements */
+	esize = fifo->esize;
+	size = fifo->mask + 1;
+	want = min_t(size_t, n / esize, kfifo_len(&kf->kf));
+	off = fifo->out & fifo->mask;
+	l = min(want, size - off);
+
+	copied = copy_to_iter(fifo->data + off * esize, l * esize, to);
+	if (copied == l * esize && want > l)
+		copied += copy_to_iter(fifo->data, (want - l) * esize, to);
+
+	iov_iter_revert(to, copied % esize);
+	len = copied / esize;
+	if (want && !len) {
+		ret = -EFAULT;
+		goto out_unlock;
+	}
+
+	/* Make sure the data is copied out before the slots are released */
+	smp_mb();
+	fifo->out += len;
+	ret = len * esize;
+
+out_unlock:
+	mutex_unlock(&kf->user_lock);
+
+	return ret;
+}
+
 static size_t iio_kfifo_buf_data_available(struct iio_buffer *r)
 {
 	struct iio_kfifo *kf = iio_to_kfifo(r);
@@ -187,7 +242,9 @@ static int iio_kfifo_write(struct iio_buffer *r, size_t n,
 
 static const struct iio_buffer_access_funcs kfifo_access_funcs = {
 	.store_to = &iio_store_to_kfifo,
+	.store_to_n = &iio_store_to_kfifo_n,
 	.read = &iio_read_kfifo,
+	.read_iter = &iio_read_iter_kfifo,
 	.data_available = iio_kfifo_buf_data_available,
 	.remove_from = &iio_kfifo_remove_from,
 	.write = &iio_kfifo_write,
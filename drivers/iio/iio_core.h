@@ -44,6 +44,7 @@ __poll_t iio_buffer_poll(struct file *filp,
 			     struct poll_table_struct *wait);
 ssize_t iio_buffer_read_outer(struct file *filp, char __user *buf,
 			      size_t n, loff_t *f_ps);
+ssize_t iio_buffer_read_iter(struct kiocb *iocb, struct iov_iter *to);
 ssize_t iio_buffer_chrdev_write(struct file *filp, const char __user *buf,
 				size_t n, loff_t *f_ps);
 
@@ -52,6 +53,8 @@ void iio_buffer_free_sysfs_and_mask(struct iio_dev *indio_dev);
 
 #define iio_buffer_poll_addr (&iio_buffer_poll)
 #define iio_buffer_read_outer_addr (&iio_buffer_read_outer)
+#define iio_buffer_read_iter_addr (&iio_buffer_read_iter)
+#define iio_buffer_splice_read_addr (&generic_file_splice_read)
 
 void iio_disable_all_buffers(struct iio_dev *indio_dev);
 void iio_buffer_wakeup_poll(struct iio_dev *indio_dev);
@@ -65,6 +68,8 @@ void iio_buffer_free_blocks(struct iio_buffer *buffer);
 #define iio_buffer_chrdev_write NULL
 #define iio_buffer_poll_addr NULL
 #define iio_buffer_read_outer_addr NULL
+#define iio_buffer_read_iter_addr NULL
+#define iio_buffer_splice_read_addr NULL
 #define iio_buffer_mmap NULL
 
 static inline int iio_buffer_alloc_sysfs_and_mask(struct iio_dev *indio_dev)
@@ -19,6 +19,7 @@
 #include <linux/sched.h>
 #include <linux/dma-mapping.h>
 #include <linux/sched/signal.h>
+#include <linux/uio.h>
 
 #include <linux/iio/iio.h>
 #include <linux/iio/iio-opaque.h>
@@ -90,21 +91,8 @@ static bool iio_buffer_ready(struct iio_dev *indio_dev, struct iio_buffer *buf,
 	return false;
 }
 
-/**
- * iio_buffer_read_outer() - chrdev read for buffer access
- * @filp:	File structure pointer for the char device
- * @buf:	Destination buffer for iio buffer read
- * @n:		First n bytes to read
- * @f_ps:	Long offset provided by the user as a seek position
- *
- * This function relies on all buffer implementations having an
- * iio_buffer as their first element.
- *
- * Return: negative values corresponding to error codes or ret != 0
- *	   for ending the reading activity
- **/
-ssize_t iio_buffer_read_outer(struct file *filp, char __user *buf,
-			      size_t n, loff_t *f_ps)
+static ssize_t __iio_buffer_read(struct file *filp, char __user *buf,
+				 struct iov_iter *to, size_t n, bool nonblock)
 {
 	struct iio_dev *indio_dev = filp->private_data;
 	struct iio_buffer *rb = indio_dev->buffer;
@@ -116,7 +104,8 @@ ssize_t iio_buffer_read_outer(struct file *filp, char __user *buf,
 	if (!indio_dev->info)
 		return -ENODEV;
 
-	if (!rb || !rb->access->read)
+	if (!rb || (to && !rb->access->read_iter) ||
+	    (!to && !rb->access->read))
 		return -EINVAL;
 
 	datum_size = rb->bytes_per_datum;
@@ -128,11 +117,13 @@ ssize_t iio_buffer_read_outer(struct file *filp, char __user *buf,
 	if (!datum_size)
 		return 0;
 
-	if (filp->f_flags & O_NONBLOCK)
+	if (nonblock)
 		to_wait = 0;
 	else
 		to_wait = min_t(size_t, n / datum_size, rb->watermark);
 
+	/* Let the producer wake us up before the watermark if need be */
+	WRITE_ONCE(rb->read_wait, to_wait);
 	add_wait_queue(&rb->pollq, &wait);
 	do {
 		if (!indio_dev->info) {
@@ -151,15 +142,60 @@ ssize_t iio_buffer_read_outer(struct file *filp, char __user *buf,
 			continue;
 		}
 
-		ret = rb->access->read(rb, n, buf);
-		if (ret == 0 && (filp->f_flags & O_NONBLOCK))
+		if (to)
+			ret = rb->access->read_iter(rb, n, to);
+		else
+			ret = rb->access->read(rb, n, buf);
+		if (ret == 0 && nonblock)
 			ret = -EAGAIN;
 	} while (ret == 0);
 	remove_wait_queue(&rb->pollq, &wait);
+	WRITE_ONCE(rb->read_wait, 0);
 
 	return ret;
 }
 
+/**
+ * iio_buffer_read_outer() - chrdev read for buffer access
+ * @filp:	File structure pointer for the char device
+ * @buf:	Destination buffer for iio buffer read
+ * @n:		First n bytes to read
+ * @f_ps:	Long offset provided by the user as a seek position
+ *
+ * This function relies on all buffer implementations having an
+ * iio_buffer as their first element.
+ *
+ * Return: negative values corresponding to error codes or ret != 0
+ *	   for ending the reading activity
+ **/
+ssize_t iio_buffer_read_outer(struct file *filp, char __user *buf,
+			      size_t n, loff_t *f_ps)
+{
+	return __iio_buffer_read(filp, buf, NULL, n,
+				 filp->f_flags & O_NONBLOCK);
+}
+
+/**
+ * iio_buffer_read_iter() - chrdev read_iter for buffer access
+ * @iocb:	IO control block of the read
+ * @to:		Destination iterator for the iio buffer read
+ *
+ * Used by generic_file_splice_read() to splice the buffer into a pipe. The
+ * samples are copied once, straight into the pipe pages, which are then
+ * handed to the file or socket on the other end by reference.
+ *
+ * Return: negative values corresponding to error codes or the number of
+ *	   bytes read
+ **/
+ssize_t iio_buffer_read_iter(struct kiocb *iocb, struct iov_iter *to)
+{
+	struct file *filp = iocb->ki_filp;
+
+	return __iio_buffer_read(filp, NULL, to, iov_iter_count(to),
+				 (filp->f_flags & O_NONBLOCK) ||
+				 (iocb->ki_flags & IOCB_NOWAIT));
+}
+
 static bool iio_buffer_space_available(struct iio_buffer *buf)
 {
 	if (buf->access->space_available)
@@ -1529,6 +1565,26 @@ static const void *iio_demux(struct iio_buffer *buffer,
 	return buffer->demux_bounce;
 }
 
+/*
+ * Readers only become ready once the watermark is reached, so waking them per
+ * scan is wasted work at high rates. A blocked read() may however ask for less
+ * than the watermark, in which case it publishes its own threshold.
+ */
+static void iio_buffer_wake_readers(struct iio_buffer *buffer, unsigned int n)
+{
+	unsigned int threshold = READ_ONCE(buffer->read_wait);
+
+	if (!threshold || threshold > buffer->watermark)
+		threshold = buffer->watermark;
+
+	buffer->wake_count += n;
+	if (buffer->wake_count < threshold)
+		return;
+
+	buffer->wake_count = 0;
+	wake_up_interruptible_poll(&buffer->pollq, EPOLLIN | EPOLLRDNORM);
+}
+
 static int iio_push_to_buffer(struct iio_buffer *buffer, const void *data)
 {
 	const void *dataout = iio_demux(buffer, data);
@@ -1538,14 +1594,40 @@ static int iio_push_to_buffer(struct iio_buffer *buffer, const void *data)
 	if (ret)
 		return ret;
 
-	/*
-	 * We can't just test for watermark to decide if we wake the poll queue
-	 * because read may request less samples than the watermark.
-	 */
-	wake_up_interruptible_poll(&buffer->pollq, EPOLLIN | EPOLLRDNORM);
+	iio_buffer_wake_readers(buffer, 1);
 	return 0;
 }
 
+static int iio_push_to_buffer_n(struct iio_buffer *buffer, const void *data,
+				unsigned int n, size_t scan_bytes)
+{
+	unsigned int i;
+	int ret;
+
+	/* Without demuxing the scans can go into the buffer as they are */
+	if (list_empty(&buffer->demux_list) && buffer->access->store_to_n) {
+		ret = buffer->access->store_to_n(buffer, data, n);
+		if (ret < 0)
+			return ret;
+		if (ret)
+			iio_buffer_wake_readers(buffer, ret);
+
+		return ret == n ? 0 : -EBUSY;
+	}
+
+	for (i = 0; i < n; i++) {
+		ret = buffer->access->store_to(buffer,
+				iio_demux(buffer, data + i * scan_bytes));
+		if (ret)
+			break;
+	}
+
+	if (i)
+		iio_buffer_wake_readers(buffer, i);
+
+	return ret;
+}
+
 /**
  * iio_push_to_buffers() - push to a registered buffer.
  * @indio_dev:		iio_dev structure for device.
@@ -1567,6 +1649,34 @@ int iio_push_to_buffers(struct iio_dev *indio_dev, const void *data)
 }
 EXPORT_SYMBOL_GPL(iio_push_to_buffers);
 
+/**
+ * iio_push_to_buffers_n() - push a batch of scans to the registered buffers
+ * @indio_dev:		iio_dev structure for device.
+ * @data:		@n consecutive full scans of indio_dev->scan_bytes each.
+ * @n:			Number of scans in @data.
+ *
+ * Lets drivers that read several scans from a hardware FIFO at once hand them
+ * over in one go, which costs a single store and wakeup check per buffer.
+ *
+ * Returns 0 on success, a negative error code otherwise.
+ */
+int iio_push_to_buffers_n(struct iio_dev *indio_dev, const void *data,
+			  unsigned int n)
+{
+	struct iio_dev_opaque *iio_dev_opaque = to_iio_dev_opaque(indio_dev);
+	struct iio_buffer *buf;
+	int ret;
+
+	list_for_each_entry(buf, &iio_dev_opaque->buffer_list, buffer_list) {
+		ret = iio_push_to_buffer_n(buf, data, n, indio_dev->scan_bytes);
+		if (ret < 0)
+			return ret;
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(iio_push_to_buffers_n);
+
 int iio_buffer_remove_sample(struct iio_buffer *buffer, u8 *data)
 {
 	return buffer->access->remove_from(buffer, data);
@@ -1711,6 +1821,191 @@ static int iio_buffer_alloc_blocks(struct iio_buffer *buffer,
 	return 0;
 }
 
+static int iio_buffer_dequeue_block_meta(struct iio_dev *indio_dev,
+	struct iio_buffer_block_meta __user *user_meta, bool non_blocking)
+{
+	struct iio_buffer *buffer = indio_dev->buffer;
+	struct iio_buffer_block_meta meta;
+	int ret;
+
+	if (!buffer->access->dequeue_block_meta)
+		return -ENOSYS;
+
+	do {
+		if (!iio_buffer_data_available(buffer)) {
+			if (non_blocking)
+				return -EAGAIN;
+
+			ret = wait_event_interruptible(buffer->pollq,
+					iio_buffer_data_available(buffer) ||
+					indio_dev->info == NULL);
+			if (ret)
+				return ret;
+			if (indio_dev->info == NULL)
+				return -ENODEV;
+		}
+
+		ret = buffer->access->dequeue_block_meta(buffer, &meta);
+		if (ret == -EAGAIN && non_blocking)
+			return ret;
+	} while (ret == -EAGAIN);
+
+	if (ret)
+		return ret;
+
+	if (copy_to_user(user_meta, &meta, sizeof(meta)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static int iio_buffer_enqueue_blocks(struct iio_buffer *buffer,
+	struct iio_buffer_block_multi __user *user_req)
+{
+	struct iio_buffer_block_multi req;
+	struct iio_buffer_block *blocks;
+	unsigned int i;
+	int ret = 0;
+
+	if (!buffer->access->enqueue_block)
+		return -ENOSYS;
+
+	if (copy_from_user(&req, user_req, sizeof(req)))
+		return -EFAULT;
+
+	if (!req.count)
+		return 0;
+	req.count = min_t(u32, req.count, IIO_BLOCK_MULTI_MAX);
+
+	blocks = memdup_user(u64_to_user_ptr(req.blocks),
+		req.count * sizeof(*blocks));
+	if (IS_ERR(blocks))
+		return PTR_ERR(blocks);
+
+	for (i = 0; i < req.count; i++) {
+		ret = buffer->access->enqueue_block(buffer, &blocks[i]);
+		if (ret)
+			break;
+	}
+
+	kfree(blocks);
+
+	/* Report a partial batch, the error comes with the next call */
+	if (!i)
+		return ret;
+
+	if (put_user(i, &user_req->count))
+		return -EFAULT;
+
+	return 0;
+}
+
+static int iio_buffer_dequeue_blocks(struct iio_dev *indio_dev,
+	struct iio_buffer_block_multi __user *user_req, bool non_blocking)
+{
+	struct iio_buffer *buffer = indio_dev->buffer;
+	struct iio_buffer_block_multi req;
+	struct iio_buffer_block *blocks;
+	unsigned int i = 0;
+	int ret;
+
+	if (!buffer->access->dequeue_block)
+		return -ENOSYS;
+
+	if (copy_from_user(&req, user_req, sizeof(req)))
+		return -EFAULT;
+
+	if (!req.count)
+		return 0;
+	req.count = min_t(u32, req.count, IIO_BLOCK_MULTI_MAX);
+
+	blocks = kmalloc_array(req.count, sizeof(*blocks), GFP_KERNEL);
+	if (!blocks)
+		return -ENOMEM;
+
+	/* Wait for the first block, then take whatever else is done */
+	do {
+		if (!iio_buffer_data_available(buffer)) {
+			ret = -EAGAIN;
+			if (non_blocking)
+				goto out_free;
+
+			ret = wait_event_interruptible(buffer->pollq,
+					iio_buffer_data_available(buffer) ||
+					indio_dev->info == NULL);
+			if (ret)
+				goto out_free;
+			ret = -ENODEV;
+			if (indio_dev->info == NULL)
+				goto out_free;
+		}
+
+		ret = buffer->access->dequeue_block(buffer, &blocks[0]);
+		if (ret != -EAGAIN && ret)
+			goto out_free;
+	} while (ret == -EAGAIN && !non_blocking);
+
+	if (ret)
+		goto out_free;
+
+	for (i = 1; i < req.count; i++) {
+		if (buffer->access->dequeue_block(buffer, &blocks[i]))
+			break;
+	}
+
+	ret = 0;
+	if (copy_to_user(u64_to_user_ptr(req.blocks), blocks,
+			 i * sizeof(*blocks)) ||
+	    put_user(i, &user_req->count))
+		ret = -EFAULT;
+
+out_free:
+	kfree(blocks);
+
+	return ret;
+}
+
+static int iio_buffer_setup_ring(struct iio_buffer *buffer,
+	struct iio_buffer_block_ring_info __user *user_info)
+{
+	struct iio_buffer_block_ring_info info = { };
+	int ret;
+
+	if (!buffer->access->setup_ring)
+		return -ENOSYS;
+
+	ret = buffer->access->setup_ring(buffer, &info);
+	if (ret)
+		return ret;
+
+	if (copy_to_user(user_info, &info, sizeof(info)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static int iio_buffer_export_block(struct iio_buffer *buffer,
+	struct iio_buffer_block_dmabuf __user *user_req)
+{
+	struct iio_buffer_block_dmabuf req;
+	int ret;
+
+	if (!buffer->access->export_block)
+		return -ENOSYS;
+
+	if (copy_from_user(&req, user_req, sizeof(req)))
+		return -EFAULT;
+
+	ret = buffer->access->export_block(buffer, &req);
+	if (ret)
+		return ret;
+
+	if (copy_to_user(user_req, &req, sizeof(req)))
+		return -EFAULT;
+
+	return 0;
+}
+
 void iio_buffer_free_blocks(struct iio_buffer *buffer)
 {
 	if (buffer->access->free_blocks)
@@ -1742,6 +2037,23 @@ long iio_buffer_ioctl(struct iio_dev *indio_dev, struct file *filep,
 	case IIO_BLOCK_DEQUEUE_IOCTL:
 		return iio_buffer_dequeue_block(indio_dev,
 			(struct iio_buffer_block __user *)arg, non_blocking);
+	case IIO_BLOCK_EXPORT_DMABUF_IOCTL:
+		return iio_buffer_export_block(buffer,
+			(struct iio_buffer_block_dmabuf __user *)arg);
+	case IIO_BLOCK_ENQUEUE_MULTI_IOCTL:
+		return iio_buffer_enqueue_blocks(buffer,
+			(struct iio_buffer_block_multi __user *)arg);
+	case IIO_BLOCK_DEQUEUE_MULTI_IOCTL:
+		return iio_buffer_dequeue_blocks(indio_dev,
+			(struct iio_buffer_block_multi __user *)arg,
+			non_blocking);
+	case IIO_BLOCK_RING_IOCTL:
+		return iio_buffer_setup_ring(buffer,
+			(struct iio_buffer_block_ring_info __user *)arg);
+	case IIO_BLOCK_DEQUEUE_META_IOCTL:
+		return iio_buffer_dequeue_block_meta(indio_dev,
+			(struct iio_buffer_block_meta __user *)arg,
+			non_blocking);
 	}
 	return -EINVAL;
 }
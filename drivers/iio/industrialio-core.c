@@ -1758,6 +1758,8 @@ static const struct file_operations iio_buffer_none_fileops = {
 
 static const struct file_operations iio_buffer_in_fileops = {
 	.read = iio_buffer_read_outer_addr,
+	.read_iter = iio_buffer_read_iter_addr,
+	.splice_read = iio_buffer_splice_read_addr,
 	.release = iio_chrdev_release,
 	.open = iio_chrdev_open,
 	.poll = iio_buffer_poll_addr,
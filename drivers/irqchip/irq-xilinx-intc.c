@@ -9,6 +9,7 @@
  * for more details.
  */
 
+#include <linux/debugfs.h>
 #include <linux/irqdomain.h>
 #include <linux/irq.h>
 #include <linux/irqchip.h>
@@ -19,6 +20,10 @@
 #include <linux/bug.h>
 #include <linux/of_irq.h>
 #include <linux/cpuhotplug.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
 #include <linux/smp.h>
 
 /* No one else should require these constants, so define them locally here. */
@@ -34,6 +39,13 @@
 #define MER_ME (1<<0)
 #define MER_HIE (1<<1)
 
+/* Service latency of one input, from the ISR read to the end of its handler */
+struct xintc_irq_stat {
+	u64		count;
+	u64		total_ns;
+	u64		max_ns;
+};
+
 struct xintc_irq_chip {
 	void		__iomem *base;
 	struct		irq_domain *domain;
@@ -41,12 +53,22 @@ struct xintc_irq_chip {
 	struct			irq_chip *intc_dev;
 	u32				nr_irq;
 	u32				sw_irq;
+	/* inputs of the running batch already acknowledged in IAR */
+	u32				batch_acked;
 #ifdef CONFIG_IRQCHIP_XILINX_INTC_MODULE_SUPPORT_EXPERIMENTAL
 	int				irq;
 #endif
+#ifdef CONFIG_DEBUG_FS
+	const char			*name;
+	struct xintc_irq_stat		*stats;
+	u64				batches;
+	struct dentry			*debugfs;
+	struct list_head		list;
+#endif
 };
 
 static DEFINE_STATIC_KEY_FALSE(xintc_is_be);
+static DEFINE_STATIC_KEY_FALSE(xintc_stats_enabled);
 
 static DEFINE_PER_CPU(struct xintc_irq_chip, primary_intc);
 
@@ -114,12 +136,30 @@ static void intc_disable_or_mask(struct irq_data *d)
 	xintc_write(local_intc, CIE, 1 << d->hwirq);
 }
 
+/*
+ * Returns true if the input was already acknowledged by the batched
+ * dispatch, and consumes that acknowledge.
+ */
+static bool intc_batch_acked(struct xintc_irq_chip *local_intc, u32 mask)
+{
+	if (!local_intc)
+		local_intc = this_cpu_ptr(&primary_intc);
+
+	if (!(local_intc->batch_acked & mask))
+		return false;
+
+	local_intc->batch_acked &= ~mask;
+	return true;
+}
+
 static void intc_ack(struct irq_data *d)
 {
 	struct xintc_irq_chip *local_intc = irq_data_get_irq_chip_data(d);
+	u32 mask = 1 << d->hwirq;
 
 	pr_debug("irq-xilinx: ack: %ld\n", d->hwirq);
-	xintc_write(local_intc, IAR, 1 << d->hwirq);
+	if (!intc_batch_acked(local_intc, mask))
+		xintc_write(local_intc, IAR, mask);
 }
 
 static void intc_mask_ack(struct irq_data *d)
@@ -129,7 +169,8 @@ static void intc_mask_ack(struct irq_data *d)
 
 	pr_debug("irq-xilinx: disable_and_ack: %ld\n", d->hwirq);
 	xintc_write(local_intc, CIE, mask);
-	xintc_write(local_intc, IAR, mask);
+	if (!intc_batch_acked(local_intc, mask))
+		xintc_write(local_intc, IAR, mask);
 }
 
 static int xintc_map(struct irq_domain *d, unsigned int irq, irq_hw_number_t hw)
@@ -215,6 +256,84 @@ static void xil_intc_initial_setup(struct xintc_irq_chip *irqc)
 	}
 }
 
+#ifdef CONFIG_DEBUG_FS
+static void xintc_account(struct xintc_irq_chip *irqc, u32 hwirq, u64 start)
+{
+	struct xintc_irq_stat *stat;
+	u64 ns;
+
+	if (!irqc->stats || hwirq >= irqc->nr_irq)
+		return;
+
+	stat = &irqc->stats[hwirq];
+	ns = ktime_get_ns() - start;
+	stat->count++;
+	stat->total_ns += ns;
+	if (ns > stat->max_ns)
+		stat->max_ns = ns;
+}
+#else
+static inline void xintc_account(struct xintc_irq_chip *irqc, u32 hwirq,
+				 u64 start)
+{
+}
+#endif
+
+/*
+ * Handle all the pending inputs of one controller. The status is read once
+ * per round and all of its inputs are acknowledged with a single IAR write,
+ * then they are dispatched in priority order, input 0 first. The flow
+ * handlers skip their own IAR write for an input acknowledged here; a level
+ * input that is still asserted is acknowledged again when it is unmasked.
+ */
+static void xintc_handle_pending(struct xintc_irq_chip *irqc,
+				 struct pt_regs *regs)
+{
+	u32 pending;
+
+	while ((pending = xintc_read(irqc, ISR) & xintc_read(irqc, IER))) {
+		u64 start = 0;
+
+		if (static_branch_unlikely(&xintc_stats_enabled)) {
+			start = ktime_get_ns();
+#ifdef CONFIG_DEBUG_FS
+			irqc->batches++;
+#endif
+		}
+
+		xintc_write(irqc, IAR, pending);
+		irqc->batch_acked = pending;
+
+		do {
+			u32 hwirq = __ffs(pending);
+			int ret;
+
+			pending &= ~BIT(hwirq);
+
+			if (hwirq >= irqc->nr_irq) {
+				irqc->batch_acked &= ~BIT(hwirq);
+#if defined(CONFIG_SMP) && defined(CONFIG_MICROBLAZE)
+				if (regs) {
+					handle_IPI(hwirq - irqc->nr_irq, regs);
+					continue;
+				}
+#endif
+				WARN_ONCE(1, "SW interrupt not handled\n");
+				continue;
+			}
+
+			ret = generic_handle_domain_irq(irqc->domain, hwirq);
+			WARN_ONCE(ret, "cpu %d: Unhandled HWIRQ %d\n",
+				  smp_processor_id(), hwirq);
+
+			if (static_branch_unlikely(&xintc_stats_enabled))
+				xintc_account(irqc, hwirq, start);
+		} while (pending);
+
+		irqc->batch_acked = 0;
+	}
+}
+
 static void xil_intc_irq_handler(struct irq_desc *desc)
 {
 	struct irq_chip *chip = irq_desc_get_chip(desc);
@@ -222,15 +341,7 @@ static void xil_intc_irq_handler(struct irq_desc *desc)
 		irq_data_get_irq_handler_data(&desc->irq_data);
 
 	chained_irq_enter(chip, desc);
-
-	do {
-		u32 hwirq = xintc_read(irqc, IVR);
-
-		if (hwirq == -1U)
-			break;
-
-		generic_handle_domain_irq(irqc->domain, hwirq);
-	} while (true);
+	xintc_handle_pending(irqc, NULL);
 	chained_irq_exit(chip, desc);
 }
 
@@ -254,34 +365,122 @@ static int xil_intc_stop(unsigned int cpu)
 
 static void xil_intc_handle_irq(struct pt_regs *regs)
 {
-	int ret;
-	unsigned int hwirq, cpu_id = smp_processor_id();
-	struct xintc_irq_chip *irqc = per_cpu_ptr(&primary_intc, cpu_id);
+	xintc_handle_pending(this_cpu_ptr(&primary_intc), regs);
+}
 
-	do {
-		hwirq = xintc_read(irqc, IVR);
-		if (hwirq != -1U) {
-			if (hwirq >= irqc->nr_irq) {
-#if defined(CONFIG_SMP) && defined(CONFIG_MICROBLAZE)
-				handle_IPI(hwirq - irqc->nr_irq, regs);
-#else
-				WARN_ONCE(1, "SW interrupt not handled\n");
+#ifdef CONFIG_DEBUG_FS
+static LIST_HEAD(xintc_list);
+static DEFINE_MUTEX(xintc_list_lock);
+static struct dentry *xintc_debugfs_root;
+
+static int xintc_stats_show(struct seq_file *m, void *v)
+{
+	struct xintc_irq_chip *irqc = m->private;
+	u32 i;
+
+	seq_printf(m, "batches: %llu\n", irqc->batches);
+	seq_puts(m, "hwirq      count    avg_ns    max_ns\n");
+	for (i = 0; i < irqc->nr_irq; i++) {
+		struct xintc_irq_stat *stat = &irqc->stats[i];
+
+		if (!stat->count)
+			continue;
+		seq_printf(m, "%5u %10llu %9llu %9llu\n", i, stat->count,
+			   div64_u64(stat->total_ns, stat->count),
+			   stat->max_ns);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(xintc_stats);
+
+static int xintc_stats_enable_get(void *data, u64 *val)
+{
+	*val = static_key_enabled(&xintc_stats_enabled);
+	return 0;
+}
+
+static int xintc_stats_enable_set(void *data, u64 val)
+{
+	if (val)
+		static_branch_enable(&xintc_stats_enabled);
+	else
+		static_branch_disable(&xintc_stats_enabled);
+	return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(xintc_stats_enable_fops, xintc_stats_enable_get,
+			 xintc_stats_enable_set, "%llu\n");
+
+static void xintc_debugfs_add(struct xintc_irq_chip *irqc)
+{
+	if (!xintc_debugfs_root) {
+		xintc_debugfs_root = debugfs_create_dir("xilinx-intc", NULL);
+		debugfs_create_file_unsafe("stats_enable", 0600,
+					   xintc_debugfs_root, NULL,
+					   &xintc_stats_enable_fops);
+	}
+
+	irqc->debugfs = debugfs_create_file(irqc->name, 0400,
+					    xintc_debugfs_root, irqc,
+					    &xintc_stats_fops);
+}
+
+/* Stats are optional, so failing to allocate them is not an error */
+static void xintc_stats_register(struct xintc_irq_chip *irqc,
+				 struct device_node *intc)
+{
+	irqc->name = kbasename(intc->full_name);
+	irqc->stats = kcalloc(irqc->nr_irq, sizeof(*irqc->stats), GFP_KERNEL);
+	if (!irqc->stats)
+		return;
+
+	mutex_lock(&xintc_list_lock);
+	list_add_tail(&irqc->list, &xintc_list);
+	if (debugfs_initialized())
+		xintc_debugfs_add(irqc);
+	mutex_unlock(&xintc_list_lock);
+}
+
+static void __maybe_unused xintc_stats_unregister(struct xintc_irq_chip *irqc)
+{
+	if (!irqc->stats)
+		return;
+
+	mutex_lock(&xintc_list_lock);
+	list_del(&irqc->list);
+	debugfs_remove(irqc->debugfs);
+	mutex_unlock(&xintc_list_lock);
+
+	kfree(irqc->stats);
+	irqc->stats = NULL;
+}
+
+#ifndef MODULE
+/* The root controller is probed before debugfs is up */
+static int __init xintc_debugfs_init(void)
+{
+	struct xintc_irq_chip *irqc;
+
+	mutex_lock(&xintc_list_lock);
+	list_for_each_entry(irqc, &xintc_list, list)
+		if (!irqc->debugfs)
+			xintc_debugfs_add(irqc);
+	mutex_unlock(&xintc_list_lock);
+
+	return 0;
+}
+late_initcall(xintc_debugfs_init);
 #endif
-				/* ACK is necessary */
-				xintc_write(irqc, IAR, 1 << hwirq);
-				continue;
-			} else {
-				ret = generic_handle_domain_irq(irqc->domain,
-								hwirq);
-				WARN_ONCE(ret, "cpu %d: Unhandled HWIRQ %d\n",
-					  cpu_id, hwirq);
-				continue;
-			}
-		}
+#else
+static inline void xintc_stats_register(struct xintc_irq_chip *irqc,
+					struct device_node *intc)
+{
+}
 
-		break;
-	} while (1);
+static inline void xintc_stats_unregister(struct xintc_irq_chip *irqc)
+{
 }
+#endif
 
 #ifndef CONFIG_IRQCHIP_XILINX_INTC_MODULE_SUPPORT_EXPERIMENTAL
 static int __init xilinx_intc_of_init(struct device_node *intc,
@@ -365,6 +564,8 @@ static int xilinx_intc_of_init(struct device_node *intc,
 		goto err_alloc;
 	}
 
+	xintc_stats_register(irqc, intc);
+
 	if (parent) {
 		irq = irq_of_parse_and_map(intc, 0);
 #ifdef CONFIG_IRQCHIP_XILINX_INTC_MODULE_SUPPORT_EXPERIMENTAL
@@ -424,6 +625,7 @@ static int xilinx_intc_of_remove(struct device_node *intc,
 	irq = irqc->irq;
 
 	irq_set_chained_handler_and_data(irq, NULL, NULL);
+	xintc_stats_unregister(irqc);
 
 	if (irqc->domain) {
 		unsigned int tempirq;
@@ -80,6 +80,7 @@ struct dm_crypt_io {
 	atomic_t io_pending;
 	blk_status_t error;
 	sector_t sector;
+	u64 crypt_start;	/* ns, for crypt_account() */
 
 	struct rb_node rb_node;
 } CRYPTO_MINALIGN_ATTR;
@@ -151,6 +152,14 @@ struct crypt_config {
 
 	struct percpu_counter n_allocated_pages;
 
+	/* reported by crypt_status(), indexed by bio_data_dir() */
+	struct {
+		atomic64_t ios;
+		atomic64_t sectors;
+		atomic64_t async_reqs;	/* completed by an async driver */
+		atomic64_t crypt_ns;	/* start of crypt_convert() to done */
+	} stats[2];
+
 	struct workqueue_struct *io_queue;
 	struct workqueue_struct *crypt_queue;
 
@@ -1736,6 +1745,18 @@ static void crypt_inc_pending(struct dm_crypt_io *io)
 	atomic_inc(&io->io_pending);
 }
 
+/* The data of @io is en/decrypted, account it */
+static void crypt_account(struct dm_crypt_io *io)
+{
+	struct crypt_config *cc = io->cc;
+	int dir = bio_data_dir(io->base_bio);
+
+	atomic64_inc(&cc->stats[dir].ios);
+	atomic64_add(bio_sectors(io->base_bio), &cc->stats[dir].sectors);
+	atomic64_add(ktime_get_ns() - io->crypt_start,
+		     &cc->stats[dir].crypt_ns);
+}
+
 static void kcryptd_io_bio_endio(struct work_struct *work)
 {
 	struct dm_crypt_io *io = container_of(work, struct dm_crypt_io, work);
@@ -1954,6 +1975,8 @@ static void kcryptd_crypt_write_io_submit(struct dm_crypt_io *io, int async)
 		return;
 	}
 
+	crypt_account(io);
+
 	/* crypt_convert should have filled the clone bio */
 	BUG_ON(io->ctx.iter_out.bi_size);
 
@@ -2048,6 +2071,7 @@ static void kcryptd_crypt_write_convert(struct dm_crypt_io *io)
 	 * Prevent io from disappearing until this function completes.
 	 */
 	crypt_inc_pending(io);
+	io->crypt_start = ktime_get_ns();
 	crypt_convert_init(cc, ctx, NULL, io->base_bio, sector);
 
 	clone = crypt_alloc_buffer(io, io->base_bio->bi_iter.bi_size);
@@ -2095,6 +2119,8 @@ static void kcryptd_crypt_write_convert(struct dm_crypt_io *io)
 
 static void kcryptd_crypt_read_done(struct dm_crypt_io *io)
 {
+	if (!io->error)
+		crypt_account(io);
 	crypt_dec_pending(io);
 }
 
@@ -2123,6 +2149,7 @@ static void kcryptd_crypt_read_convert(struct dm_crypt_io *io)
 	blk_status_t r;
 
 	crypt_inc_pending(io);
+	io->crypt_start = ktime_get_ns();
 
 	crypt_convert_init(cc, &io->ctx, io->base_bio, io->base_bio,
 			   io->sector);
@@ -2165,6 +2192,8 @@ static void kcryptd_async_done(struct crypto_async_request *async_req,
 		return;
 	}
 
+	atomic64_inc(&cc->stats[bio_data_dir(io->base_bio)].async_reqs);
+
 	if (!error && cc->iv_gen_ops && cc->iv_gen_ops->post)
 		error = cc->iv_gen_ops->post(cc, org_iv_of_dmreq(cc, dmreq), dmreq);
 
@@ -3453,7 +3482,14 @@ static void crypt_status(struct dm_target *ti, status_type_t type,
 
 	switch (type) {
 	case STATUSTYPE_INFO:
-		result[0] = '\0';
+		/* ios, sectors, async requests, crypt usecs; read then write */
+		for (i = READ; i <= WRITE; i++)
+			DMEMIT("%s%llu %llu %llu %llu", i == READ ? "" : " ",
+			       (u64)atomic64_read(&cc->stats[i].ios),
+			       (u64)atomic64_read(&cc->stats[i].sectors),
+			       (u64)atomic64_read(&cc->stats[i].async_reqs),
+			       div_u64(atomic64_read(&cc->stats[i].crypt_ns),
+				       NSEC_PER_USEC));
 		break;
 
 	case STATUSTYPE_TABLE:
@@ -3635,7 +3671,7 @@ static void crypt_io_hints(struct dm_target *ti, struct queue_limits *limits)
 
 static struct target_type crypt_target = {
 	.name   = "crypt",
-	.version = {1, 24, 0},
+	.version = {1, 25, 0},
 	.module = THIS_MODULE,
 	.ctr    = crypt_ctr,
 	.dtr    = crypt_dtr,
@@ -29,6 +29,8 @@
 
 #define DM_VERITY_DEFAULT_PREFETCH_SIZE	262144
 
+#define DM_VERITY_DEFAULT_PARALLEL_BLOCKS	16
+
 #define DM_VERITY_MAX_CORRUPTED_ERRS	100
 
 #define DM_VERITY_OPT_LOGGING		"ignore_corruption"
@@ -45,6 +47,16 @@ static unsigned dm_verity_prefetch_cluster = DM_VERITY_DEFAULT_PREFETCH_SIZE;
 
 module_param_named(prefetch_cluster, dm_verity_prefetch_cluster, uint, S_IRUGO | S_IWUSR);
 
+/*
+ * Number of data blocks verified by one work item. Larger bios are split
+ * into parts of this size that are hashed concurrently on verify_wq, which
+ * keeps several CPUs or the queue of an asynchronous hash engine busy.
+ * Zero verifies every bio serially.
+ */
+static unsigned dm_verity_parallel_blocks = DM_VERITY_DEFAULT_PARALLEL_BLOCKS;
+
+module_param_named(parallel_blocks, dm_verity_parallel_blocks, uint, S_IRUGO | S_IWUSR);
+
 static DEFINE_STATIC_KEY_FALSE(use_tasklet_enabled);
 
 struct dm_verity_prefetch_work {
@@ -54,6 +66,17 @@ struct dm_verity_prefetch_work {
 	unsigned n_blocks;
 };
 
+/*
+ * A range of blocks of a bio verified by its own work item. The io is
+ * followed by the variably-sized fields of ti->per_io_data_size, so it
+ * gets its own hash request and digests.
+ */
+struct dm_verity_part {
+	struct dm_verity_io *parent;
+	struct work_struct work;
+	struct dm_verity_io io;
+};
+
 /*
  * Auxiliary structure appended to each dm-bufio buffer. If the value
  * hash_verified is nonzero, hash of the block has been verified.
@@ -332,6 +355,10 @@ static int verity_verify_level(struct dm_verity *v, struct dm_verity_io *io,
 			 */
 			r = -EAGAIN;
 			goto release_ret_r;
+		} else if (io->in_part) {
+			/* the whole bio is verified again by its parent */
+			r = -EAGAIN;
+			goto release_ret_r;
 		}
 		else if (verity_fec_decode(v, io,
 					   DM_VERITY_BLOCK_TYPE_METADATA,
@@ -399,7 +426,7 @@ static int verity_for_io_block(struct dm_verity *v, struct dm_verity_io *io,
 			       struct bvec_iter *iter, struct crypto_wait *wait)
 {
 	unsigned int todo = 1 << v->data_dev_block_bits;
-	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_io_data_size);
+	struct bio *bio = io->bio;
 	struct scatterlist sg;
 	struct ahash_request *req = verity_io_hash_req(v, io);
 
@@ -446,7 +473,7 @@ int verity_for_bv_block(struct dm_verity *v, struct dm_verity_io *io,
 				       size_t len))
 {
 	unsigned todo = 1 << v->data_dev_block_bits;
-	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_io_data_size);
+	struct bio *bio = io->bio;
 
 	do {
 		int r;
@@ -487,9 +514,7 @@ static inline void verity_bv_skip_block(struct dm_verity *v,
 					struct dm_verity_io *io,
 					struct bvec_iter *iter)
 {
-	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_io_data_size);
-
-	bio_advance_iter(bio, iter, 1 << v->data_dev_block_bits);
+	bio_advance_iter(io->bio, iter, 1 << v->data_dev_block_bits);
 }
 
 /*
@@ -505,7 +530,7 @@ static int verity_verify_io(struct dm_verity_io *io)
 	struct bvec_iter iter_copy;
 	struct bvec_iter *iter;
 	struct crypto_wait wait;
-	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_io_data_size);
+	struct bio *bio = io->bio;
 	unsigned int b;
 
 	if (static_branch_unlikely(&use_tasklet_enabled) && io->in_tasklet) {
@@ -577,6 +602,9 @@ static int verity_verify_io(struct dm_verity_io *io)
 			 * tasklet since it may sleep, so fallback to work-queue.
 			 */
 			return -EAGAIN;
+		} else if (io->in_part) {
+			/* the whole bio is verified again by its parent */
+			return -EAGAIN;
 #if defined(CONFIG_DM_VERITY_FEC)
 		} else if (verity_fec_decode(v, io, DM_VERITY_BLOCK_TYPE_DATA,
 					     cur_block, NULL, &start) == 0) {
@@ -624,6 +652,108 @@ static void verity_finish_io(struct dm_verity_io *io, blk_status_t status)
 	bio_endio(bio);
 }
 
+/*
+ * Called when the last part of a parallel verification is done. A part only
+ * fails without handling the error, so in that case the whole io is verified
+ * again serially: blocks already verified are skipped through the caches and
+ * the corrupted ones go through FEC and the configured error mode.
+ */
+static void verity_parts_done(struct dm_verity_io *io)
+{
+	int r = 0;
+
+	if (READ_ONCE(io->parts_failed))
+		r = verity_verify_io(io);
+
+	verity_finish_io(io, errno_to_blk_status(r));
+}
+
+static void verity_part_work(struct work_struct *w)
+{
+	struct dm_verity_part *part =
+		container_of(w, struct dm_verity_part, work);
+	struct dm_verity_io *io = part->parent;
+
+	if (verity_verify_io(&part->io))
+		WRITE_ONCE(io->parts_failed, true);
+
+	kfree(part);
+
+	if (atomic_dec_and_test(&io->parts_pending))
+		verity_parts_done(io);
+}
+
+/*
+ * Split the verification of a large io into parts run concurrently on
+ * verify_wq. Returns false if the io should be verified serially instead.
+ */
+static bool verity_verify_parallel(struct dm_verity_io *io)
+{
+	struct dm_verity *v = io->v;
+	unsigned int per_part = READ_ONCE(dm_verity_parallel_blocks);
+	struct dm_verity_part **parts;
+	struct bvec_iter iter = io->iter;
+	unsigned int nr_parts, i;
+	sector_t block = io->block;
+	unsigned int n_blocks = io->n_blocks;
+
+	if (!per_part || io->n_blocks <= per_part || num_online_cpus() < 2 ||
+	    io->bio->bi_status)
+		return false;
+
+	nr_parts = DIV_ROUND_UP(io->n_blocks, per_part);
+	parts = kcalloc(nr_parts, sizeof(*parts),
+			GFP_NOIO | __GFP_NORETRY | __GFP_NOWARN);
+	if (!parts)
+		return false;
+
+	for (i = 0; i < nr_parts; i++) {
+		parts[i] = kmalloc(offsetof(struct dm_verity_part, io) +
+				   v->ti->per_io_data_size,
+				   GFP_NOIO | __GFP_NORETRY | __GFP_NOWARN);
+		if (!parts[i])
+			goto free_parts;
+	}
+
+	atomic_set(&io->parts_pending, nr_parts);
+	io->parts_failed = false;
+
+	for (i = 0; i < nr_parts; i++) {
+		struct dm_verity_part *part = parts[i];
+		struct dm_verity_io *pio = &part->io;
+
+		part->parent = io;
+		pio->v = v;
+		pio->bio = io->bio;
+		pio->block = block;
+		pio->n_blocks = min(n_blocks, per_part);
+		pio->in_tasklet = false;
+		pio->in_part = true;
+		pio->iter = iter;
+
+		block += pio->n_blocks;
+		n_blocks -= pio->n_blocks;
+		bio_advance_iter(io->bio, &iter,
+				 pio->n_blocks << v->data_dev_block_bits);
+
+		INIT_WORK(&part->work, verity_part_work);
+	}
+
+	/* the last part runs in this work item, its io may be gone after it */
+	for (i = 0; i < nr_parts - 1; i++)
+		queue_work(v->verify_wq, &parts[i]->work);
+	verity_part_work(&parts[nr_parts - 1]->work);
+
+	kfree(parts);
+	return true;
+
+free_parts:
+	while (i--)
+		kfree(parts[i]);
+	kfree(parts);
+	return false;
+}
+
 static void verity_work(struct work_struct *w)
 {
 	struct dm_verity_io *io = container_of(w, struct dm_verity_io, work);
@@ -631,6 +761,10 @@ static void verity_work(struct work_struct *w)
 	io->in_tasklet = false;
 
 	verity_fec_init_io(io);
+
+	if (verity_verify_parallel(io))
+		return;
+
 	verity_finish_io(io, errno_to_blk_status(verity_verify_io(io)));
 }
 
@@ -770,6 +904,8 @@ static int verity_map(struct dm_target *ti, struct bio *bio)
 
 	io = dm_per_bio_data(bio, ti->per_io_data_size);
 	io->v = v;
+	io->bio = bio;
+	io->in_part = false;
 	io->orig_bi_end_io = bio->bi_end_io;
 	io->block = bio->bi_iter.bi_sector >> (v->data_dev_block_bits - SECTOR_SHIFT);
 	io->n_blocks = bio->bi_iter.bi_size >> v->data_dev_block_bits;
@@ -1489,7 +1625,7 @@ int dm_verity_get_root_digest(struct dm_target *ti, u8 **root_digest, unsigned i
 static struct target_type verity_target = {
 	.name		= "verity",
 	.features	= DM_TARGET_IMMUTABLE,
-	.version	= {1, 9, 0},
+	.version	= {1, 10, 0},
 	.module		= THIS_MODULE,
 	.ctr		= verity_ctr,
 	.dtr		= verity_dtr,
@@ -76,9 +76,17 @@ struct dm_verity_io {
 	/* original value of bio->bi_end_io */
 	bio_end_io_t *orig_bi_end_io;
 
+	/* the bio being verified, also set for a part of it */
+	struct bio *bio;
+
 	sector_t block;
 	unsigned n_blocks;
 	bool in_tasklet;
+	bool in_part;
+
+	/* parts of a parallel verification still running, and their outcome */
+	atomic_t parts_pending;
+	bool parts_failed;
 
 	struct bvec_iter iter;
 
@@ -10,6 +10,7 @@
 #include <linux/clk.h>
 #include <linux/device.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
 
@@ -44,6 +45,8 @@
  * @tdest_routing: Whether TDEST routing is enabled
  * @aclk: Video clock
  * @saxi_ctlclk: AXI-Lite control clock
+ * @lock: Protects @streaming and the routing registers
+ * @streaming: The routing registers follow @routing
  */
 struct xvswitch_device {
 	struct device *dev;
@@ -57,6 +60,8 @@ struct xvswitch_device {
 	bool tdest_routing;
 	struct clk *aclk;
 	struct clk *saxi_ctlclk;
+	struct mutex lock;
+	bool streaming;
 };
 
 static inline struct xvswitch_device *to_xvsw(struct v4l2_subdev *subdev)
@@ -79,6 +84,30 @@ static inline void xvswitch_write(struct xvswitch_device *xvsw, u32 addr,
  * V4L2 Subdevice Video Operations
  */
 
+/*
+ * Write the routing table into the MI mux registers and commit them. The
+ * switch latches all of them at once on the register update, and applies
+ * them once the transfers in progress have ended.
+ */
+static void xvsw_apply_routing(struct xvswitch_device *xvsw)
+{
+	unsigned int i;
+
+	for (i = 0; i < MAX_VSW_SRCS; i++) {
+		u32 val;
+
+		if (xvsw->routing[i] != -1)
+			val = xvsw->routing[i];
+		else
+			val = XVSW_MI_MUX_DISABLE_MASK;
+
+		xvswitch_write(xvsw, XVSW_MI_MUX_REG_BASE + (i * 4),
+			       val);
+	}
+
+	xvswitch_write(xvsw, XVSW_CTRL_REG, XVSW_CTRL_REG_UPDATE_MASK);
+}
+
 static int xvsw_s_stream(struct v4l2_subdev *subdev, int enable)
 {
 	struct xvswitch_device *xvsw = to_xvsw(subdev);
@@ -88,6 +117,9 @@ static int xvsw_s_stream(struct v4l2_subdev *subdev, int enable)
 	if (xvsw->tdest_routing)
 		return 0;
 
+	mutex_lock(&xvsw->lock);
+	xvsw->streaming = enable;
+
 	if (!enable) {
 		/* In control reg routing, disable all master ports */
 		for (i = 0; i < xvsw->nsources; i++) {
@@ -95,6 +127,7 @@ static int xvsw_s_stream(struct v4l2_subdev *subdev, int enable)
 				       XVSW_MI_MUX_DISABLE_MASK);
 		}
 		xvswitch_write(xvsw, XVSW_CTRL_REG, XVSW_CTRL_REG_UPDATE_MASK);
+		mutex_unlock(&xvsw->lock);
 		return 0;
 	}
 
@@ -103,19 +136,8 @@ static int xvsw_s_stream(struct v4l2_subdev *subdev, int enable)
 	 * from routing table write the values into respective reg
 	 * and enable
 	 */
-	for (i = 0; i < MAX_VSW_SRCS; i++) {
-		u32 val;
-
-		if (xvsw->routing[i] != -1)
-			val = xvsw->routing[i];
-		else
-			val = XVSW_MI_MUX_DISABLE_MASK;
-
-		xvswitch_write(xvsw, XVSW_MI_MUX_REG_BASE + (i * 4),
-			       val);
-	}
-
-	xvswitch_write(xvsw, XVSW_CTRL_REG, XVSW_CTRL_REG_UPDATE_MASK);
+	xvsw_apply_routing(xvsw);
+	mutex_unlock(&xvsw->lock);
 
 	return 0;
 }
@@ -284,32 +306,72 @@ static int xvsw_get_routing(struct v4l2_subdev *subdev,
 	return 0;
 }
 
+static bool xvsw_format_match(const struct v4l2_mbus_framefmt *a,
+			      const struct v4l2_mbus_framefmt *b)
+{
+	return a->code == b->code && a->width == b->width &&
+	       a->height == b->height && a->field == b->field;
+}
+
+/*
+ * The routing can be changed while streaming, to switch the input of a
+ * running branch. The pipeline was validated with the formats of the
+ * current routes, so the sink a source pad switches to must carry the same
+ * format. Source pads can always be disconnected, and the ones without a
+ * route can't be part of a running pipeline. The new routes are committed
+ * to the hardware at once, downstream blocks resynchronize on the next
+ * start of frame.
+ */
 static int xvsw_set_routing(struct v4l2_subdev *subdev,
 			    struct v4l2_subdev_routing *route)
 {
 	struct xvswitch_device *xvsw = to_xvsw(subdev);
-	unsigned int i;
+	int routing[MAX_VSW_SRCS];
+	unsigned int i, src;
 	int ret = 0;
 
 	/* In case of tdest routing, we can't set routing */
 	if (xvsw->tdest_routing)
 		return -EINVAL;
 
+	for (i = 0; i < MAX_VSW_SRCS; ++i)
+		routing[i] = -1;
+
+	for (i = 0; i < route->num_routes; ++i) {
+		src = route->routes[i].source;
+		if (src < xvsw->nsinks ||
+		    src >= xvsw->nsinks + xvsw->nsources ||
+		    route->routes[i].sink >= xvsw->nsinks)
+			return -EINVAL;
+
+		routing[src - xvsw->nsinks] = route->routes[i].sink;
+	}
+
 	mutex_lock(&subdev->entity.graph_obj.mdev->graph_mutex);
+	mutex_lock(&xvsw->lock);
 
 	if (media_entity_pipeline(&subdev->entity)) {
-		ret = -EBUSY;
-		goto done;
+		for (i = 0; i < xvsw->nsources; ++i) {
+			int new = routing[i], old = xvsw->routing[i];
+
+			if (new == -1 || old == -1 || new == old)
+				continue;
+
+			if (!xvsw_format_match(&xvsw->formats[new],
+					       &xvsw->formats[old])) {
+				ret = -EBUSY;
+				goto done;
+			}
+		}
 	}
 
-	for (i = 0; i < xvsw->nsources; ++i)
-		xvsw->routing[i] = -1;
+	memcpy(xvsw->routing, routing, sizeof(routing));
 
-	for (i = 0; i < route->num_routes; ++i)
-		xvsw->routing[route->routes[i].source - xvsw->nsinks] =
-			route->routes[i].sink;
+	if (xvsw->streaming)
+		xvsw_apply_routing(xvsw);
 
 done:
+	mutex_unlock(&xvsw->lock);
 	mutex_unlock(&subdev->entity.graph_obj.mdev->graph_mutex);
 	return ret;
 }
@@ -481,6 +543,7 @@ static int xvsw_probe(struct platform_device *pdev)
 		return -ENOMEM;
 
 	xvsw->dev = &pdev->dev;
+	mutex_init(&xvsw->lock);
 
 	ret = xvsw_parse_of(xvsw);
 	if (ret < 0)
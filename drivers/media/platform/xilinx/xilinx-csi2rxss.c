@@ -126,6 +126,16 @@
 /* There are 2 events frame sync and frame level error per VC */
 #define XCSI_VCX_NUM_EVENTS	((XCSI_MAX_VCX - XCSI_MAX_VC) * 2)
 
+/**
+ * struct xcsi2rxss_vc_stats - Per virtual channel error statistics
+ * @frame_level: number of frame level errors
+ * @frame_sync: number of frame sync errors
+ */
+struct xcsi2rxss_vc_stats {
+	u32 frame_level;
+	u32 frame_sync;
+};
+
 /**
  * struct xcsi2rxss_event - Event log structure
  * @mask: Event mask
@@ -205,6 +215,7 @@ static const u32 xcsi2dt_mbus_lut[][2] = {
  * @default_format: Default V4L2 format
  * @events: counter for events
  * @vcx_events: counter for vcx_events
+ * @vc_stats: error counters of each virtual channel
  * @dev: Platform structure
  * @rsubdev: Remote subdev connected to sink pad
  * @rst_gpio: reset to video_aresetn
@@ -226,6 +237,7 @@ struct xcsi2rxss_state {
 	struct v4l2_mbus_framefmt default_format;
 	u32 events[XCSI_NUM_EVENTS];
 	u32 vcx_events[XCSI_VCX_NUM_EVENTS];
+	struct xcsi2rxss_vc_stats vc_stats[XCSI_MAX_VCX];
 	struct device *dev;
 	struct v4l2_subdev *rsubdev;
 	struct gpio_desc *rst_gpio;
@@ -359,6 +371,8 @@ static void xcsi2rxss_reset_event_counters(struct xcsi2rxss_state *state)
 
 	for (i = 0; i < XCSI_VCX_NUM_EVENTS; i++)
 		state->vcx_events[i] = 0;
+
+	memset(state->vc_stats, 0, sizeof(state->vc_stats));
 }
 
 /* Print event counters */
@@ -440,7 +454,7 @@ static int xcsi2rxss_log_status(struct v4l2_subdev *sd)
 
 	/* Virtual Channel Image Information */
 	dev_info(dev, "********** Virtual Channel Info ************\n");
-	dev_info(dev, "VC\tLine Count\tByte Count\tData Type\n");
+	dev_info(dev, "VC\tLine Count\tByte Count\tData Type\tLevel Err\tSync Err\n");
 	if (xcsi2rxss->en_vcx)
 		max_vc = XCSI_MAX_VCX;
 	else
@@ -461,8 +475,10 @@ static int xcsi2rxss_log_status(struct v4l2_subdev *sd)
 		data = xcsi2rxss_read(xcsi2rxss, reg);
 		data_type = data & XCSI_VCXINF2R_DT;
 
-		dev_info(dev, "%d\t%d\t\t%d\t\t0x%x\n", i, line_count,
-			 byte_count, data_type);
+		dev_info(dev, "%d\t%d\t\t%d\t\t0x%x\t\t%u\t\t%u\n", i,
+			 line_count, byte_count, data_type,
+			 xcsi2rxss->vc_stats[i].frame_level,
+			 xcsi2rxss->vc_stats[i].frame_sync);
 
 		/* Move to next pair of VC Info registers */
 		reg += XCSI_NEXTREG_OFFSET;
@@ -629,15 +645,31 @@ static irqreturn_t xcsi2rxss_irq_handler(int irq, void *data)
 					    state->events[i]);
 		}
 
+		/* VC0 to VC3 frame errors are reported in the ISR */
+		for (i = 0; i < XCSI_MAX_VC; i++) {
+			if (status & (XCSI_ISR_VC0FLVLERR << (i * 2)))
+				state->vc_stats[i].frame_level++;
+			if (status & (XCSI_ISR_VC0FSYNCERR << (i * 2)))
+				state->vc_stats[i].frame_sync++;
+		}
+
 		if (status & XCSI_ISR_VCXFE && state->en_vcx) {
 			u32 vcxstatus;
 
 			vcxstatus = xcsi2rxss_read(state, XCSI_VCXR_OFFSET);
 			vcxstatus &= XCSI_VCXR_VCERR;
 			for (i = 0; i < XCSI_VCX_NUM_EVENTS; i++) {
+				struct xcsi2rxss_vc_stats *stats;
+
 				if (!(vcxstatus & BIT(i)))
 					continue;
 				state->vcx_events[i]++;
+
+				stats = &state->vc_stats[i / 2 + XCSI_VCX_START];
+				if (i & 1)
+					stats->frame_sync++;
+				else
+					stats->frame_level++;
 			}
 			xcsi2rxss_write(state, XCSI_VCXR_OFFSET, vcxstatus);
 		}
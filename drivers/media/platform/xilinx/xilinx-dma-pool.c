@@ -0,0 +1,637 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Xilinx Video DMA buffer pool
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ *
+ * MMAP buffers of the video nodes are taken from a per node pool. A buffer
+ * released by vb2 goes back to the pool instead of being freed, so that
+ * restarting a capture, even after a format change, does not go through the
+ * contiguous allocator again. USERPTR and DMABUF buffers are handled by
+ * videobuf2-dma-contig as before.
+ */
+
+#include <linux/dma-buf.h>
+#include <linux/dma-mapping.h>
+#include <linux/kref.h>
+#include <linux/list.h>
+#include <linux/module.h>
+#include <linux/refcount.h>
+#include <linux/scatterlist.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+
+#include <media/videobuf2-dma-contig.h>
+#include <media/videobuf2-memops.h>
+
+#include "xilinx-dma.h"
+
+static unsigned int pool_buffers;
+module_param(pool_buffers, uint, 0444);
+MODULE_PARM_DESC(pool_buffers,
+		 "Buffers kept per video node across sessions (default: 0, disabled)");
+
+static unsigned int pool_frame_size;
+module_param(pool_frame_size, uint, 0444);
+MODULE_PARM_DESC(pool_frame_size,
+		 "Minimum buffer size, preallocated at probe when set (default: 0)");
+
+/**
+ * struct xvip_dma_pool - Buffer pool of a video node
+ * @kref: reference count, one per buffer and one for the video node
+ * @lock: protects @free, @num_free and @closed
+ * @dev: device the buffers are allocated for
+ * @free: buffers not used by vb2, sorted by increasing size
+ * @num_free: number of buffers in @free
+ * @closed: the video node is gone, buffers are freed when released
+ */
+struct xvip_dma_pool {
+	struct kref kref;
+	spinlock_t lock;
+	struct device *dev;
+	struct list_head free;
+	unsigned int num_free;
+	bool closed;
+};
+
+/**
+ * struct xvip_dma_pool_buf - Buffer of a pool
+ * @list: entry in the pool free list
+ * @pool: pool the buffer belongs to
+ * @vaddr: kernel virtual address
+ * @dma_addr: DMA address
+ * @size: allocated size, at least the size requested by vb2
+ * @refcount: users of the buffer: vb2, mappings and exported dma-bufs
+ * @handler: vma refcount handler of the userspace mappings
+ */
+struct xvip_dma_pool_buf {
+	struct list_head list;
+	struct xvip_dma_pool *pool;
+	void *vaddr;
+	dma_addr_t dma_addr;
+	size_t size;
+	refcount_t refcount;
+	struct vb2_vmarea_handler handler;
+};
+
+/**
+ * struct xvip_dma_mem - Memory of a vb2 plane
+ * @buf: pool buffer of a MMAP plane
+ * @priv: videobuf2-dma-contig private data of the other planes
+ */
+struct xvip_dma_mem {
+	struct xvip_dma_pool_buf *buf;
+	void *priv;
+};
+
+static const struct vb2_mem_ops *dc_ops = &vb2_dma_contig_memops;
+
+/* -----------------------------------------------------------------------------
+ * Pool
+ */
+
+static void xvip_dma_pool_release(struct kref *kref)
+{
+	struct xvip_dma_pool *pool = container_of(kref, struct xvip_dma_pool,
+						  kref);
+
+	put_device(pool->dev);
+	kfree(pool);
+}
+
+static void xvip_dma_pool_buf_free(struct xvip_dma_pool_buf *buf)
+{
+	struct xvip_dma_pool *pool = buf->pool;
+
+	dma_free_coherent(pool->dev, buf->size, buf->vaddr, buf->dma_addr);
+	kfree(buf);
+	kref_put(&pool->kref, xvip_dma_pool_release);
+}
+
+static struct xvip_dma_pool_buf *
+xvip_dma_pool_buf_alloc(struct xvip_dma_pool *pool, size_t size)
+{
+	struct xvip_dma_pool_buf *buf;
+
+	buf = kzalloc(sizeof(*buf), GFP_KERNEL);
+	if (!buf)
+		return NULL;
+
+	buf->size = PAGE_ALIGN(max_t(size_t, size, pool_frame_size));
+	buf->vaddr = dma_alloc_coherent(pool->dev, buf->size, &buf->dma_addr,
+					GFP_KERNEL | __GFP_NOWARN);
+	if (!buf->vaddr) {
+		kfree(buf);
+		return NULL;
+	}
+
+	buf->pool = pool;
+	kref_get(&pool->kref);
+
+	return buf;
+}
+
+/* Insert @buf in the free list, which is kept sorted by size */
+static void xvip_dma_pool_add_free(struct xvip_dma_pool *pool,
+				   struct xvip_dma_pool_buf *buf)
+{
+	struct xvip_dma_pool_buf *pos;
+
+	list_for_each_entry(pos, &pool->free, list) {
+		if (pos->size >= buf->size)
+			break;
+	}
+	list_add_tail(&buf->list, &pos->list);
+	pool->num_free++;
+}
+
+/*
+ * Give a released buffer back to the pool. When the pool is full the
+ * smallest buffer is freed, so that the pool follows the largest format
+ * used on the node.
+ */
+static void xvip_dma_pool_buf_put(void *arg)
+{
+	struct xvip_dma_pool_buf *buf = arg, *victim = NULL;
+	struct xvip_dma_pool *pool = buf->pool;
+	unsigned long flags;
+
+	if (!refcount_dec_and_test(&buf->refcount))
+		return;
+
+	spin_lock_irqsave(&pool->lock, flags);
+	if (pool->closed) {
+		victim = buf;
+	} else if (pool->num_free < pool_buffers) {
+		xvip_dma_pool_add_free(pool, buf);
+	} else {
+		victim = list_first_entry_or_null(&pool->free,
+						  struct xvip_dma_pool_buf,
+						  list);
+		if (victim && victim->size < buf->size) {
+			list_del(&victim->list);
+			pool->num_free--;
+			xvip_dma_pool_add_free(pool, buf);
+		} else {
+			victim = buf;
+		}
+	}
+	spin_unlock_irqrestore(&pool->lock, flags);
+
+	if (victim)
+		xvip_dma_pool_buf_free(victim);
+}
+
+/* Take the smallest free buffer of at least @size bytes, or allocate one */
+static struct xvip_dma_pool_buf *
+xvip_dma_pool_buf_get(struct xvip_dma_pool *pool, size_t size)
+{
+	struct xvip_dma_pool_buf *buf, *found = NULL;
+	unsigned long flags;
+
+	spin_lock_irqsave(&pool->lock, flags);
+	list_for_each_entry(buf, &pool->free, list) {
+		if (buf->size >= size) {
+			found = buf;
+			list_del(&found->list);
+			pool->num_free--;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&pool->lock, flags);
+
+	if (!found) {
+		found = xvip_dma_pool_buf_alloc(pool, size);
+		if (!found)
+			return NULL;
+	}
+
+	refcount_set(&found->refcount, 1);
+	found->handler.refcount = &found->refcount;
+	found->handler.put = xvip_dma_pool_buf_put;
+	found->handler.arg = found;
+
+	return found;
+}
+
+/* -----------------------------------------------------------------------------
+ * DMABUF exporter
+ */
+
+struct xvip_dma_pool_attachment {
+	struct sg_table sgt;
+	enum dma_data_direction dma_dir;
+};
+
+static int xvip_dma_pool_dmabuf_attach(struct dma_buf *dbuf,
+				       struct dma_buf_attachment *dbuf_attach)
+{
+	struct xvip_dma_pool_buf *buf = dbuf->priv;
+	struct xvip_dma_pool_attachment *attach;
+	int ret;
+
+	attach = kzalloc(sizeof(*attach), GFP_KERNEL);
+	if (!attach)
+		return -ENOMEM;
+
+	ret = dma_get_sgtable(buf->pool->dev, &attach->sgt, buf->vaddr,
+			      buf->dma_addr, buf->size);
+	if (ret < 0) {
+		kfree(attach);
+		return ret;
+	}
+
+	attach->dma_dir = DMA_NONE;
+	dbuf_attach->priv = attach;
+
+	return 0;
+}
+
+static void xvip_dma_pool_dmabuf_detach(struct dma_buf *dbuf,
+					struct dma_buf_attachment *db_attach)
+{
+	struct xvip_dma_pool_attachment *attach = db_attach->priv;
+
+	if (attach->dma_dir != DMA_NONE)
+		dma_unmap_sgtable(db_attach->dev, &attach->sgt, attach->dma_dir,
+				  DMA_ATTR_SKIP_CPU_SYNC);
+	sg_free_table(&attach->sgt);
+	kfree(attach);
+	db_attach->priv = NULL;
+}
+
+static struct sg_table *
+xvip_dma_pool_dmabuf_map(struct dma_buf_attachment *db_attach,
+			 enum dma_data_direction dma_dir)
+{
+	struct xvip_dma_pool_attachment *attach = db_attach->priv;
+	int ret;
+
+	if (attach->dma_dir == dma_dir)
+		return &attach->sgt;
+
+	if (attach->dma_dir != DMA_NONE) {
+		dma_unmap_sgtable(db_attach->dev, &attach->sgt, attach->dma_dir,
+				  DMA_ATTR_SKIP_CPU_SYNC);
+		attach->dma_dir = DMA_NONE;
+	}
+
+	/* The buffer is coherent, no cache maintenance is needed */
+	ret = dma_map_sgtable(db_attach->dev, &attach->sgt, dma_dir,
+			      DMA_ATTR_SKIP_CPU_SYNC);
+	if (ret)
+		return ERR_PTR(ret);
+
+	attach->dma_dir = dma_dir;
+
+	return &attach->sgt;
+}
+
+static void xvip_dma_pool_dmabuf_unmap(struct dma_buf_attachment *db_attach,
+				       struct sg_table *sgt,
+				       enum dma_data_direction dma_dir)
+{
+	/* The mapping is kept until the attachment is detached */
+}
+
+static void xvip_dma_pool_dmabuf_release(struct dma_buf *dbuf)
+{
+	xvip_dma_pool_buf_put(dbuf->priv);
+}
+
+static int xvip_dma_pool_dmabuf_vmap(struct dma_buf *dbuf,
+				     struct iosys_map *map)
+{
+	struct xvip_dma_pool_buf *buf = dbuf->priv;
+
+	iosys_map_set_vaddr(map, buf->vaddr);
+
+	return 0;
+}
+
+static int xvip_dma_pool_buf_mmap(struct xvip_dma_pool_buf *buf,
+				  struct vm_area_struct *vma)
+{
+	int ret;
+
+	ret = dma_mmap_coherent(buf->pool->dev, vma, buf->vaddr,
+				buf->dma_addr, buf->size);
+	if (ret)
+		return ret;
+
+	vma->vm_flags |= VM_DONTEXPAND | VM_DONTDUMP;
+	vma->vm_private_data = &buf->handler;
+	vma->vm_ops = &vb2_common_vm_ops;
+	vma->vm_ops->open(vma);
+
+	return 0;
+}
+
+static int xvip_dma_pool_dmabuf_mmap(struct dma_buf *dbuf,
+				     struct vm_area_struct *vma)
+{
+	return xvip_dma_pool_buf_mmap(dbuf->priv, vma);
+}
+
+static const struct dma_buf_ops xvip_dma_pool_dmabuf_ops = {
+	.attach = xvip_dma_pool_dmabuf_attach,
+	.detach = xvip_dma_pool_dmabuf_detach,
+	.map_dma_buf = xvip_dma_pool_dmabuf_map,
+	.unmap_dma_buf = xvip_dma_pool_dmabuf_unmap,
+	.vmap = xvip_dma_pool_dmabuf_vmap,
+	.mmap = xvip_dma_pool_dmabuf_mmap,
+	.release = xvip_dma_pool_dmabuf_release,
+};
+
+/* -----------------------------------------------------------------------------
+ * vb2 memory operations
+ */
+
+static void *xvip_dma_mem_alloc(struct vb2_buffer *vb, struct device *dev,
+				unsigned long size)
+{
+	struct xvip_dma *dma = vb2_get_drv_priv(vb->vb2_queue);
+	struct xvip_dma_mem *mem;
+
+	mem = kzalloc(sizeof(*mem), GFP_KERNEL);
+	if (!mem)
+		return ERR_PTR(-ENOMEM);
+
+	if (pool_buffers && dev == dma->pool->dev) {
+		mem->buf = xvip_dma_pool_buf_get(dma->pool, size);
+		if (mem->buf)
+			return mem;
+	} else {
+		mem->priv = dc_ops->alloc(vb, dev, size);
+		if (!IS_ERR_OR_NULL(mem->priv))
+			return mem;
+	}
+
+	kfree(mem);
+	return ERR_PTR(-ENOMEM);
+}
+
+static void xvip_dma_mem_put(void *buf_priv)
+{
+	struct xvip_dma_mem *mem = buf_priv;
+
+	if (mem->buf)
+		xvip_dma_pool_buf_put(mem->buf);
+	else
+		dc_ops->put(mem->priv);
+	kfree(mem);
+}
+
+static struct dma_buf *xvip_dma_mem_get_dmabuf(struct vb2_buffer *vb,
+					       void *buf_priv,
+					       unsigned long flags)
+{
+	struct xvip_dma_mem *mem = buf_priv;
+	DEFINE_DMA_BUF_EXPORT_INFO(exp_info);
+	struct dma_buf *dbuf;
+
+	if (!mem->buf)
+		return dc_ops->get_dmabuf(vb, mem->priv, flags);
+
+	exp_info.ops = &xvip_dma_pool_dmabuf_ops;
+	exp_info.size = mem->buf->size;
+	exp_info.flags = flags;
+	exp_info.priv = mem->buf;
+
+	dbuf = dma_buf_export(&exp_info);
+	if (IS_ERR(dbuf))
+		return NULL;
+
+	refcount_inc(&mem->buf->refcount);
+
+	return dbuf;
+}
+
+static void *xvip_dma_mem_get_userptr(struct vb2_buffer *vb,
+				      struct device *dev, unsigned long vaddr,
+				      unsigned long size)
+{
+	struct xvip_dma_mem *mem;
+	void *priv;
+
+	mem = kzalloc(sizeof(*mem), GFP_KERNEL);
+	if (!mem)
+		return ERR_PTR(-ENOMEM);
+
+	priv = dc_ops->get_userptr(vb, dev, vaddr, size);
+	if (IS_ERR(priv)) {
+		kfree(mem);
+		return priv;
+	}
+
+	mem->priv = priv;
+
+	return mem;
+}
+
+static void xvip_dma_mem_put_userptr(void *buf_priv)
+{
+	struct xvip_dma_mem *mem = buf_priv;
+
+	dc_ops->put_userptr(mem->priv);
+	kfree(mem);
+}
+
+static void xvip_dma_mem_prepare(void *buf_priv)
+{
+	struct xvip_dma_mem *mem = buf_priv;
+
+	/* Pool buffers are coherent */
+	if (!mem->buf && dc_ops->prepare)
+		dc_ops->prepare(mem->priv);
+}
+
+static void xvip_dma_mem_finish(void *buf_priv)
+{
+	struct xvip_dma_mem *mem = buf_priv;
+
+	if (!mem->buf && dc_ops->finish)
+		dc_ops->finish(mem->priv);
+}
+
+static void *xvip_dma_mem_attach_dmabuf(struct vb2_buffer *vb,
+					struct device *dev,
+					struct dma_buf *dbuf,
+					unsigned long size)
+{
+	struct xvip_dma_mem *mem;
+	void *priv;
+
+	mem = kzalloc(sizeof(*mem), GFP_KERNEL);
+	if (!mem)
+		return ERR_PTR(-ENOMEM);
+
+	priv = dc_ops->attach_dmabuf(vb, dev, dbuf, size);
+	if (IS_ERR(priv)) {
+		kfree(mem);
+		return priv;
+	}
+
+	mem->priv = priv;
+
+	return mem;
+}
+
+static void xvip_dma_mem_detach_dmabuf(void *buf_priv)
+{
+	struct xvip_dma_mem *mem = buf_priv;
+
+	dc_ops->detach_dmabuf(mem->priv);
+	kfree(mem);
+}
+
+static int xvip_dma_mem_map_dmabuf(void *buf_priv)
+{
+	struct xvip_dma_mem *mem = buf_priv;
+
+	return dc_ops->map_dmabuf(mem->priv);
+}
+
+static void xvip_dma_mem_unmap_dmabuf(void *buf_priv)
+{
+	struct xvip_dma_mem *mem = buf_priv;
+
+	dc_ops->unmap_dmabuf(mem->priv);
+}
+
+static void *xvip_dma_mem_vaddr(struct vb2_buffer *vb, void *buf_priv)
+{
+	struct xvip_dma_mem *mem = buf_priv;
+
+	if (mem->buf)
+		return mem->buf->vaddr;
+
+	return dc_ops->vaddr(vb, mem->priv);
+}
+
+static void *xvip_dma_mem_cookie(struct vb2_buffer *vb, void *buf_priv)
+{
+	struct xvip_dma_mem *mem = buf_priv;
+
+	/* Same cookie as videobuf2-dma-contig, see plane_dma_addr() */
+	if (mem->buf)
+		return &mem->buf->dma_addr;
+
+	return dc_ops->cookie(vb, mem->priv);
+}
+
+static unsigned int xvip_dma_mem_num_users(void *buf_priv)
+{
+	struct xvip_dma_mem *mem = buf_priv;
+
+	if (mem->buf)
+		return refcount_read(&mem->buf->refcount);
+
+	return dc_ops->num_users(mem->priv);
+}
+
+static int xvip_dma_mem_mmap(void *buf_priv, struct vm_area_struct *vma)
+{
+	struct xvip_dma_mem *mem = buf_priv;
+
+	if (mem->buf)
+		return xvip_dma_pool_buf_mmap(mem->buf, vma);
+
+	return dc_ops->mmap(mem->priv, vma);
+}
+
+const struct vb2_mem_ops xvip_dma_pool_memops = {
+	.alloc		= xvip_dma_mem_alloc,
+	.put		= xvip_dma_mem_put,
+	.get_dmabuf	= xvip_dma_mem_get_dmabuf,
+	.get_userptr	= xvip_dma_mem_get_userptr,
+	.put_userptr	= xvip_dma_mem_put_userptr,
+	.prepare	= xvip_dma_mem_prepare,
+	.finish		= xvip_dma_mem_finish,
+	.attach_dmabuf	= xvip_dma_mem_attach_dmabuf,
+	.detach_dmabuf	= xvip_dma_mem_detach_dmabuf,
+	.map_dmabuf	= xvip_dma_mem_map_dmabuf,
+	.unmap_dmabuf	= xvip_dma_mem_unmap_dmabuf,
+	.vaddr		= xvip_dma_mem_vaddr,
+	.cookie		= xvip_dma_mem_cookie,
+	.num_users	= xvip_dma_mem_num_users,
+	.mmap		= xvip_dma_mem_mmap,
+};
+
+/* -----------------------------------------------------------------------------
+ * Initialization
+ */
+
+/**
+ * xvip_dma_pool_init - Create the buffer pool of a video node
+ * @dma: video DMA channel
+ *
+ * When pool_frame_size is set, pool_buffers buffers of that size are
+ * allocated right away. Otherwise the pool fills up with the buffers of the
+ * first sessions.
+ *
+ * Return: 0 on success or -ENOMEM
+ */
+int xvip_dma_pool_init(struct xvip_dma *dma)
+{
+	struct xvip_dma_pool *pool;
+	struct xvip_dma_pool_buf *buf;
+	unsigned int i;
+
+	pool = kzalloc(sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		return -ENOMEM;
+
+	kref_init(&pool->kref);
+	spin_lock_init(&pool->lock);
+	INIT_LIST_HEAD(&pool->free);
+	pool->dev = get_device(dma->queue.dev);
+	dma->pool = pool;
+
+	if (!pool_frame_size)
+		return 0;
+
+	for (i = 0; i < pool_buffers; i++) {
+		buf = xvip_dma_pool_buf_alloc(pool, pool_frame_size);
+		if (!buf) {
+			dev_warn(pool->dev,
+				 "preallocated %u of %u pool buffers\n", i,
+				 pool_buffers);
+			break;
+		}
+
+		xvip_dma_pool_add_free(pool, buf);
+	}
+
+	return 0;
+}
+
+/**
+ * xvip_dma_pool_cleanup - Release the buffer pool of a video node
+ * @dma: video DMA channel
+ *
+ * Free buffers are released now, the ones still mapped or exported when
+ * their last user goes away.
+ */
+void xvip_dma_pool_cleanup(struct xvip_dma *dma)
+{
+	struct xvip_dma_pool *pool = dma->pool;
+	struct xvip_dma_pool_buf *buf, *next;
+	unsigned long flags;
+	LIST_HEAD(free);
+
+	if (!pool)
+		return;
+
+	spin_lock_irqsave(&pool->lock, flags);
+	pool->closed = true;
+	list_splice_init(&pool->free, &free);
+	pool->num_free = 0;
+	spin_unlock_irqrestore(&pool->lock, flags);
+
+	list_for_each_entry_safe(buf, next, &free, list)
+		xvip_dma_pool_buf_free(buf);
+
+	kref_put(&pool->kref, xvip_dma_pool_release);
+	dma->pool = NULL;
+}
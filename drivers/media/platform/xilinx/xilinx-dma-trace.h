@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Xilinx Video DMA tracepoints
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM xilinx_vip
+
+#if !defined(__XILINX_VIP_DMA_TRACE_H__) || defined(TRACE_HEADER_MULTI_READ)
+#define __XILINX_VIP_DMA_TRACE_H__
+
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(xvip_dma_queue,
+	TP_PROTO(const char *name, u32 index),
+	TP_ARGS(name, index),
+	TP_STRUCT__entry(
+		__string(name, name)
+		__field(u32, index)
+	),
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->index = index;
+	),
+	TP_printk("%s index=%u", __get_str(name), __entry->index)
+);
+
+TRACE_EVENT(xvip_dma_complete,
+	TP_PROTO(const char *name, u32 index, u32 sequence, u64 timestamp,
+		 u64 latency),
+	TP_ARGS(name, index, sequence, timestamp, latency),
+	TP_STRUCT__entry(
+		__string(name, name)
+		__field(u32, index)
+		__field(u32, sequence)
+		__field(u64, timestamp)
+		__field(u64, latency)
+	),
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->index = index;
+		__entry->sequence = sequence;
+		__entry->timestamp = timestamp;
+		__entry->latency = latency;
+	),
+	TP_printk("%s index=%u sequence=%u timestamp=%llu latency=%llu",
+		  __get_str(name), __entry->index, __entry->sequence,
+		  __entry->timestamp, __entry->latency)
+);
+
+#endif /* __XILINX_VIP_DMA_TRACE_H__ */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE xilinx-dma-trace
+#include <trace/define_trace.h>
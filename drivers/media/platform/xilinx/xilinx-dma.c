@@ -9,6 +9,10 @@
  *           Laurent Pinchart <laurent.pinchart@ideasonboard.com>
  */
 
+#include <linux/debugfs.h>
+#include <linux/dma-buf.h>
+#include <linux/dma-fence.h>
+#include <linux/dma-resv.h>
 #include <linux/dma/xilinx_dma.h>
 #include <linux/dma/xilinx_frmbuf.h>
 #include <linux/lcm.h>
@@ -17,8 +21,10 @@
 #include <linux/of.h>
 #include <linux/slab.h>
 #include <linux/xilinx-v4l2-controls.h>
+#include <linux/xilinx-v4l2-events.h>
 
 #include <media/v4l2-dev.h>
+#include <media/v4l2-event.h>
 #include <media/v4l2-fh.h>
 #include <media/v4l2-ioctl.h>
 #include <media/videobuf2-v4l2.h>
@@ -28,6 +34,9 @@
 #include "xilinx-vip.h"
 #include "xilinx-vipp.h"
 
+#define CREATE_TRACE_POINTS
+#include "xilinx-dma-trace.h"
+
 #define XVIP_DMA_DEF_FORMAT		V4L2_PIX_FMT_YUYV
 #define XVIP_DMA_DEF_WIDTH		1920
 #define XVIP_DMA_DEF_HEIGHT		1080
@@ -37,6 +46,7 @@
 #define XVIP_DMA_MAX_WIDTH		65535U
 #define XVIP_DMA_MIN_HEIGHT		1U
 #define XVIP_DMA_MAX_HEIGHT		8191U
+#define XVIP_DMA_MAX_EVENTS		8
 
 /* -----------------------------------------------------------------------------
  * Helper functions
@@ -57,7 +67,8 @@ xvip_dma_remote_subdev(struct media_pad *local, u32 *pad)
 	return media_entity_to_v4l2_subdev(remote->entity);
 }
 
-static int xvip_dma_verify_format(struct xvip_dma *dma)
+static int __xvip_dma_verify_format(struct xvip_dma *dma, u32 code,
+				    u32 width, u32 height)
 {
 	struct v4l2_subdev_format fmt;
 	struct v4l2_subdev *subdev;
@@ -72,20 +83,118 @@ static int xvip_dma_verify_format(struct xvip_dma *dma)
 	if (ret < 0)
 		return ret == -ENOIOCTLCMD ? -EINVAL : ret;
 
-	if (dma->fmtinfo->code != fmt.format.code)
+	if (code != fmt.format.code)
 		return -EINVAL;
 
+	if (width != fmt.format.width || height != fmt.format.height)
+		return -EINVAL;
+
+	return 0;
+}
+
+static int xvip_dma_verify_format(struct xvip_dma *dma)
+{
 	/*
 	 * Crop rectangle contains format resolution by default, and crop
 	 * rectangle if s_selection is executed.
 	 */
-	if (dma->r.width != fmt.format.width ||
-	    dma->r.height != fmt.format.height)
-		return -EINVAL;
+	return __xvip_dma_verify_format(dma, dma->fmtinfo->code, dma->r.width,
+					dma->r.height);
+}
+
+/* -----------------------------------------------------------------------------
+ * Statistics
+ */
+
+static void xvip_dma_stats_reset(struct xvip_dma *dma)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&dma->queued_lock, flags);
+	memset(&dma->stats, 0, sizeof(dma->stats));
+	dma->stats.interval_min = U64_MAX;
+	dma->stats.latency_min = U64_MAX;
+	spin_unlock_irqrestore(&dma->queued_lock, flags);
+}
+
+/* Called with queued_lock held when a buffer is completed */
+static void xvip_dma_stats_update(struct xvip_dma *dma, u64 ts, u64 latency)
+{
+	struct xvip_dma_stats *stats = &dma->stats;
+	u64 interval;
+
+	if (stats->frames++) {
+		interval = ts - stats->last_ts;
+		stats->interval_min = min(stats->interval_min, interval);
+		stats->interval_max = max(stats->interval_max, interval);
+		stats->interval_sum += interval;
+	}
+	stats->last_ts = ts;
+
+	stats->latency_min = min(stats->latency_min, latency);
+	stats->latency_max = max(stats->latency_max, latency);
+	stats->latency_sum += latency;
+
+	/* The DMA has nowhere to write the next frame to */
+	if (list_empty(&dma->queued_bufs))
+		stats->starved++;
+}
+
+static int xvip_dma_stats_show(struct seq_file *s, void *data)
+{
+	struct xvip_dma *dma = s->private;
+	struct xvip_dma_stats stats;
+	unsigned long flags;
+	u64 intervals;
+
+	spin_lock_irqsave(&dma->queued_lock, flags);
+	stats = dma->stats;
+	spin_unlock_irqrestore(&dma->queued_lock, flags);
+
+	seq_printf(s, "frames: %llu\n", stats.frames);
+	seq_printf(s, "errors: %llu\n", stats.errors);
+	seq_printf(s, "starved: %llu\n", stats.starved);
+	if (stats.frames > 1) {
+		intervals = stats.frames - 1;
+		seq_printf(s, "interval_ns: min %llu avg %llu max %llu\n",
+			   stats.interval_min,
+			   div64_u64(stats.interval_sum, intervals),
+			   stats.interval_max);
+	}
+	if (stats.frames)
+		seq_printf(s, "latency_ns: min %llu avg %llu max %llu\n",
+			   stats.latency_min,
+			   div64_u64(stats.latency_sum, stats.frames),
+			   stats.latency_max);
 
 	return 0;
 }
 
+static int xvip_dma_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, xvip_dma_stats_show, inode->i_private);
+}
+
+/* Any write clears the statistics */
+static ssize_t xvip_dma_stats_write(struct file *file, const char __user *buf,
+				    size_t count, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+
+	xvip_dma_stats_reset(s->private);
+
+	return count;
+}
+
+static const struct file_operations xvip_dma_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = xvip_dma_stats_open,
+	.read = seq_read,
+	.write = xvip_dma_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 /* -----------------------------------------------------------------------------
  * Pipeline Stream Management
  */
@@ -266,21 +375,125 @@ struct xvip_dma_buffer {
 
 #define to_xvip_dma_buffer(vb)	container_of(vb, struct xvip_dma_buffer, buf)
 
+/**
+ * struct xvip_dma_frame_cb - Frame done notification of a buffer
+ * @cb: fence callback, run when the DMA completes the frame
+ * @dma: DMA channel the buffer is queued on
+ * @index: vb2 index of the buffer
+ */
+struct xvip_dma_frame_cb {
+	struct dma_fence_cb cb;
+	struct xvip_dma *dma;
+	u32 index;
+};
+
+static void xvip_dma_frame_done(struct dma_fence *fence,
+				struct dma_fence_cb *cb)
+{
+	struct xvip_dma_frame_cb *fcb =
+		container_of(cb, struct xvip_dma_frame_cb, cb);
+	struct xvip_frame_done_event *data;
+	struct v4l2_event event = {};
+
+	/* The frame is cancelled when the DMA is terminated */
+	if (!fence->error) {
+		event.type = V4L2_EVENT_XLNXVIP_FRAME_DONE;
+		data = (struct xvip_frame_done_event *)event.u.data;
+		data->index = fcb->index;
+		data->timestamp = ktime_to_ns(fence->timestamp);
+		v4l2_event_queue(&fcb->dma->video, &event);
+	}
+
+	dma_fence_put(fence);
+	kfree(fcb);
+}
+
+/*
+ * Publish the frame fence as the write fence of imported dma-bufs. An
+ * importer such as a DRM plane then waits on it implicitly, which lets
+ * userspace pass the buffer on as soon as it is dequeued at the start of
+ * the frame instead of waiting for the frame done event.
+ */
+static void xvip_dma_attach_fence(struct xvip_dma_buffer *buf,
+				  struct dma_fence *fence)
+{
+	struct vb2_buffer *vb = &buf->buf.vb2_buf;
+	struct dma_resv *resv;
+	unsigned int i;
+
+	if (vb->memory != VB2_MEMORY_DMABUF)
+		return;
+
+	for (i = 0; i < vb->num_planes; i++) {
+		if (!vb->planes[i].dbuf)
+			continue;
+
+		resv = vb->planes[i].dbuf->resv;
+		dma_resv_lock(resv, NULL);
+		if (!dma_resv_reserve_fences(resv, 1))
+			dma_resv_add_fence(resv, fence, DMA_RESV_USAGE_WRITE);
+		dma_resv_unlock(resv);
+	}
+}
+
+/*
+ * In low latency capture the buffer callback runs at the start of the
+ * frame, use the frame fence of the DMA to report its end.
+ */
+static void xvip_dma_arm_frame_done(struct xvip_dma *dma,
+				    struct xvip_dma_buffer *buf)
+{
+	struct xvip_dma_frame_cb *fcb;
+	struct dma_fence *fence;
+
+	fence = xilinx_xdma_get_fence(dma->dma, buf->desc);
+	if (IS_ERR(fence))
+		return;
+
+	xvip_dma_attach_fence(buf, fence);
+
+	fcb = kzalloc(sizeof(*fcb), GFP_KERNEL);
+	if (!fcb) {
+		dma_fence_put(fence);
+		return;
+	}
+
+	fcb->dma = dma;
+	fcb->index = buf->buf.vb2_buf.index;
+	if (dma_fence_add_callback(fence, &fcb->cb, xvip_dma_frame_done)) {
+		dma_fence_put(fence);
+		kfree(fcb);
+	}
+}
+
 static void xvip_dma_complete(void *param)
 {
 	struct xvip_dma_buffer *buf = param;
 	struct xvip_dma *dma = buf->dma;
+	u64 sof_ns = 0, eof_ns = 0, now;
 	int i, sizeimage;
 	u32 fid = 0;
 	int status;
 
+	/*
+	 * Use the times recorded by the DMA interrupt handler, the callback
+	 * itself runs with the completion scheduling delay.
+	 */
+	now = ktime_get_ns();
+	xilinx_xdma_get_timestamp(dma->dma, buf->desc, &sof_ns, &eof_ns);
+	if (dma->low_latency_cap)
+		eof_ns = sof_ns;
+	if (!eof_ns || eof_ns > now)
+		eof_ns = now;
+
 	spin_lock(&dma->queued_lock);
 	list_del(&buf->queue);
+	xvip_dma_stats_update(dma, eof_ns, now - eof_ns);
 	spin_unlock(&dma->queued_lock);
 
 	buf->buf.field = V4L2_FIELD_NONE;
 	buf->buf.sequence = dma->sequence++;
-	buf->buf.vb2_buf.timestamp = ktime_get_ns();
+	buf->buf.vb2_buf.timestamp = eof_ns;
 
 	status = xilinx_xdma_get_fid(dma->dma, buf->desc, &fid);
 	if (!status) {
@@ -313,6 +526,8 @@ static void xvip_dma_complete(void *param)
 		vb2_set_plane_payload(&buf->buf.vb2_buf, 0, sizeimage);
 	}
 
+	trace_xvip_dma_complete(dma->video.name, buf->buf.vb2_buf.index,
+				buf->buf.sequence, eof_ns, now - eof_ns);
 	vb2_buffer_done(&buf->buf.vb2_buf, VB2_BUF_STATE_DONE);
 }
 
@@ -486,6 +701,9 @@ static void xvip_dma_buffer_queue(struct vb2_buffer *vb)
 	desc = dmaengine_prep_interleaved_dma(dma->dma, &dma->xt, flags);
 	if (!desc) {
 		dev_err(dma->xdev->dev, "Failed to prepare DMA transfer\n");
+		spin_lock_irq(&dma->queued_lock);
+		dma->stats.errors++;
+		spin_unlock_irq(&dma->queued_lock);
 		vb2_buffer_done(&buf->buf.vb2_buf, VB2_BUF_STATE_ERROR);
 		return;
 	}
@@ -513,7 +731,10 @@ static void xvip_dma_buffer_queue(struct vb2_buffer *vb)
 	if (dma->low_latency_cap)
 		xilinx_xdma_set_earlycb(dma->dma, desc,
 					EARLY_CALLBACK_START_DESC);
+	trace_xvip_dma_queue(dma->video.name, vb->index);
 	dmaengine_submit(desc);
+	if (dma->low_latency_cap)
+		xvip_dma_arm_frame_done(dma, buf);
 
 	if (vb2_is_streaming(&dma->queue))
 		dma_async_issue_pending(dma->dma);
@@ -528,6 +749,7 @@ static int xvip_dma_start_streaming(struct vb2_queue *vq, unsigned int count)
 
 	dma->sequence = 0;
 	dma->prev_fid = ~0;
+	xvip_dma_stats_reset(dma);
 
 	/*
 	 * Start streaming on the pipeline. No link touching an entity in the
@@ -976,18 +1198,10 @@ xvip_dma_try_format(struct file *file, void *fh, struct v4l2_format *format)
 	return 0;
 }
 
-static int
-xvip_dma_set_format(struct file *file, void *fh, struct v4l2_format *format)
+static void xvip_dma_apply_format(struct xvip_dma *dma,
+				  struct v4l2_format *format,
+				  const struct xvip_video_format *info)
 {
-	struct v4l2_fh *vfh = file->private_data;
-	struct xvip_dma *dma = to_xvip_dma(vfh->vdev);
-	const struct xvip_video_format *info = NULL;
-
-	__xvip_dma_try_format(dma, format, &info);
-
-	if (vb2_is_busy(&dma->queue))
-		return -EBUSY;
-
 	if (V4L2_TYPE_IS_MULTIPLANAR(dma->format.type)) {
 		dma->format.fmt.pix_mp = format->fmt.pix_mp;
 
@@ -1004,6 +1218,127 @@ xvip_dma_set_format(struct file *file, void *fh, struct v4l2_format *format)
 	}
 
 	dma->fmtinfo = info;
+}
+
+/*
+ * Check that all the allocated buffers can hold a frame in the given format.
+ * Buffers allocated for the largest expected format with VIDIOC_CREATE_BUFS
+ * allow changing the format without reallocating them.
+ */
+static bool xvip_dma_buffers_fit(struct xvip_dma *dma,
+				 struct v4l2_format *format,
+				 const struct xvip_video_format *info)
+{
+	bool mplane = V4L2_TYPE_IS_MULTIPLANAR(dma->format.type);
+	unsigned int num_planes = mplane ? info->buffers : 1;
+	unsigned int i, p;
+
+	for (i = 0; i < dma->queue.num_buffers; i++) {
+		struct vb2_buffer *vb = dma->queue.bufs[i];
+
+		if (vb->num_planes != num_planes)
+			return false;
+
+		for (p = 0; p < num_planes; p++) {
+			u32 sizeimage = mplane ?
+				format->fmt.pix_mp.plane_fmt[p].sizeimage :
+				format->fmt.pix.sizeimage;
+
+			if (vb->planes[p].length < sizeimage)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * xvip_dma_switch_format - Change the format while streaming
+ * @dma: the DMA engine
+ * @format: the new format, already adjusted by __xvip_dma_try_format()
+ * @info: format information for @format
+ *
+ * Stop the pipeline and the DMA engine, program the queued buffers for the new
+ * format and restart. Unlike a STREAMOFF/STREAMON cycle the buffers stay owned
+ * by the driver and are neither freed nor reallocated, so an input resolution
+ * change costs a few frames. The connected subdevs must already output the
+ * new format, and the pipeline must contain this DMA engine only.
+ *
+ * Return: 0 on success, -EBUSY if the format can't be changed in place, -EPIPE
+ * if it doesn't match the connected subdev, or the error returned when
+ * restarting the pipeline
+ */
+static int xvip_dma_switch_format(struct xvip_dma *dma,
+				  struct v4l2_format *format,
+				  const struct xvip_video_format *info)
+{
+	struct xvip_pipeline *pipe = to_xvip_pipeline(&dma->video);
+	struct xvip_dma_buffer *buf, *nbuf;
+	u32 width, height;
+	LIST_HEAD(bufs);
+	int ret;
+
+	if (dma->low_latency_cap || !pipe || pipe->num_dmas != 1)
+		return -EBUSY;
+
+	if (V4L2_TYPE_IS_MULTIPLANAR(dma->format.type)) {
+		width = format->fmt.pix_mp.width;
+		height = format->fmt.pix_mp.height;
+	} else {
+		width = format->fmt.pix.width;
+		height = format->fmt.pix.height;
+	}
+
+	if (__xvip_dma_verify_format(dma, info->code, width, height))
+		return -EPIPE;
+
+	dev_dbg(dma->xdev->dev, "%s: switching to %ux%u %p4cc\n",
+		dma->video.name, width, height, &info->fourcc);
+
+	/* Stop the pipeline and wait for the completion callbacks to finish */
+	xvip_pipeline_set_stream(pipe, false);
+	dmaengine_terminate_sync(dma->dma);
+
+	spin_lock_irq(&dma->queued_lock);
+	list_splice_init(&dma->queued_bufs, &bufs);
+	spin_unlock_irq(&dma->queued_lock);
+
+	xvip_dma_apply_format(dma, format, info);
+	dma->prev_fid = ~0;
+
+	/* Prepare new descriptors for the buffers in their queuing order */
+	list_for_each_entry_safe(buf, nbuf, &bufs, queue) {
+		list_del(&buf->queue);
+		xvip_dma_buffer_queue(&buf->buf.vb2_buf);
+	}
+
+	ret = xvip_pipeline_set_stream(pipe, true);
+	if (ret < 0)
+		dev_err(dma->xdev->dev, "%s: failed to restart the pipeline\n",
+			dma->video.name);
+
+	return ret;
+}
+
+static int
+xvip_dma_set_format(struct file *file, void *fh, struct v4l2_format *format)
+{
+	struct v4l2_fh *vfh = file->private_data;
+	struct xvip_dma *dma = to_xvip_dma(vfh->vdev);
+	const struct xvip_video_format *info = NULL;
+
+	__xvip_dma_try_format(dma, format, &info);
+
+	if (vb2_is_busy(&dma->queue)) {
+		if (!xvip_dma_buffers_fit(dma, format, info))
+			return -EBUSY;
+
+		/* Buffers are in the driver, reprogram them in place */
+		if (vb2_start_streaming_called(&dma->queue))
+			return xvip_dma_switch_format(dma, format, info);
+	}
+
+	xvip_dma_apply_format(dma, format, info);
 
 	return 0;
 }
@@ -1108,6 +1443,17 @@ xvip_dma_s_selection(struct file *file, void *fh, struct v4l2_selection *sel)
 	return 0;
 }
 
+static int xvip_dma_subscribe_event(struct v4l2_fh *fh,
+				    const struct v4l2_event_subscription *sub)
+{
+	switch (sub->type) {
+	case V4L2_EVENT_XLNXVIP_FRAME_DONE:
+		return v4l2_event_subscribe(fh, sub, XVIP_DMA_MAX_EVENTS, NULL);
+	default:
+		return v4l2_ctrl_subscribe_event(fh, sub);
+	}
+}
+
 static const struct v4l2_ioctl_ops xvip_dma_ioctl_ops = {
 	.vidioc_querycap		= xvip_dma_querycap,
 	.vidioc_enum_fmt_vid_cap	= xvip_dma_enum_format,
@@ -1137,6 +1483,8 @@ static const struct v4l2_ioctl_ops xvip_dma_ioctl_ops = {
 	.vidioc_enum_input	= &xvip_dma_enum_input,
 	.vidioc_g_input		= &xvip_dma_get_input,
 	.vidioc_s_input		= &xvip_dma_set_input,
+	.vidioc_subscribe_event		= xvip_dma_subscribe_event,
+	.vidioc_unsubscribe_event	= v4l2_event_unsubscribe,
 };
 
 /* -----------------------------------------------------------------------------
@@ -1159,6 +1507,11 @@ static int xvip_dma_s_ctrl(struct v4l2_ctrl *ctl)
 				return -EBUSY;
 
 			dma->low_latency_cap = true;
+			/* Buffers are returned when the frame starts */
+			dma->queue.timestamp_flags &=
+				~V4L2_BUF_FLAG_TSTAMP_SRC_MASK;
+			dma->queue.timestamp_flags |=
+				V4L2_BUF_FLAG_TSTAMP_SRC_SOE;
 			/*
 			 * Don't use auto-restart for low latency
 			 * to avoid extra one frame delay between
@@ -1170,6 +1523,10 @@ static int xvip_dma_s_ctrl(struct v4l2_ctrl *ctl)
 				return -EBUSY;
 
 			dma->low_latency_cap = false;
+			dma->queue.timestamp_flags &=
+				~V4L2_BUF_FLAG_TSTAMP_SRC_MASK;
+			dma->queue.timestamp_flags |=
+				V4L2_BUF_FLAG_TSTAMP_SRC_EOF;
 			xilinx_xdma_set_mode(dma->dma, AUTO_RESTART);
 		} else if (ctl->val == XVIP_START_DMA) {
 			if (dma->low_latency_cap &&
@@ -1227,6 +1584,8 @@ static int xvip_dma_open(struct file *file)
 
 		mutex_lock(&dma->lock);
 		dma->low_latency_cap = false;
+		dma->queue.timestamp_flags &= ~V4L2_BUF_FLAG_TSTAMP_SRC_MASK;
+		dma->queue.timestamp_flags |= V4L2_BUF_FLAG_TSTAMP_SRC_EOF;
 		xilinx_xdma_set_mode(dma->dma, AUTO_RESTART);
 		mutex_unlock(&dma->lock);
 	}
@@ -1425,7 +1784,7 @@ int xvip_dma_init(struct xvip_composite_device *xdev, struct xvip_dma *dma,
 	dma->queue.drv_priv = dma;
 	dma->queue.buf_struct_size = sizeof(struct xvip_dma_buffer);
 	dma->queue.ops = &xvip_dma_queue_qops;
-	dma->queue.mem_ops = &vb2_dma_contig_memops;
+	dma->queue.mem_ops = &xvip_dma_pool_memops;
 	dma->queue.timestamp_flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC
 				   | V4L2_BUF_FLAG_TSTAMP_SRC_EOF;
 	dma->queue.dev = dma->xdev->dev;
@@ -1435,6 +1794,10 @@ int xvip_dma_init(struct xvip_composite_device *xdev, struct xvip_dma *dma,
 		goto error;
 	}
 
+	ret = xvip_dma_pool_init(dma);
+	if (ret < 0)
+		goto error;
+
 	/* ... and the DMA channel. */
 	snprintf(name, sizeof(name), "port%u", port);
 	dma->dma = dma_request_chan(dma->xdev->dev, name);
@@ -1460,6 +1823,10 @@ int xvip_dma_init(struct xvip_composite_device *xdev, struct xvip_dma *dma,
 		goto error;
 	}
 
+	xvip_dma_stats_reset(dma);
+	dma->debugfs = debugfs_create_file(name, 0600, xdev->debugfs, dma,
+					   &xvip_dma_stats_fops);
+
 	return 0;
 
 error:
@@ -1469,12 +1836,16 @@ int xvip_dma_init(struct xvip_composite_device *xdev, struct xvip_dma *dma,
 
 void xvip_dma_cleanup(struct xvip_dma *dma)
 {
+	debugfs_remove(dma->debugfs);
+
 	if (video_is_registered(&dma->video))
 		video_unregister_device(&dma->video);
 
 	if (!IS_ERR_OR_NULL(dma->dma))
 		dma_release_channel(dma->dma);
 
+	xvip_dma_pool_cleanup(dma);
+
 	v4l2_ctrl_handler_free(&dma->ctrl_handler);
 	media_entity_cleanup(&dma->video.entity);
 
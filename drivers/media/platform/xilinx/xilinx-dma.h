@@ -22,8 +22,10 @@
 #include <media/v4l2-dev.h>
 #include <media/videobuf2-v4l2.h>
 
+struct dentry;
 struct dma_chan;
 struct xvip_composite_device;
+struct xvip_dma_pool;
 struct xvip_video_format;
 
 /**
@@ -56,6 +58,32 @@ static inline struct xvip_pipeline *to_xvip_pipeline(struct video_device *vdev)
 	return container_of(pipe, struct xvip_pipeline, pipe);
 }
 
+/**
+ * struct xvip_dma_stats - Video DMA channel statistics
+ * @frames: number of frames completed
+ * @errors: number of buffers returned with an error
+ * @starved: number of frames completed with no other buffer queued
+ * @last_ts: timestamp of the last frame, in ns
+ * @interval_min: minimum interval between two frames, in ns
+ * @interval_max: maximum interval between two frames, in ns
+ * @interval_sum: sum of the intervals between frames, in ns
+ * @latency_min: minimum delay from frame end to buffer completion, in ns
+ * @latency_max: maximum delay from frame end to buffer completion, in ns
+ * @latency_sum: sum of the delays from frame end to buffer completion
+ */
+struct xvip_dma_stats {
+	u64 frames;
+	u64 errors;
+	u64 starved;
+	u64 last_ts;
+	u64 interval_min;
+	u64 interval_max;
+	u64 interval_sum;
+	u64 latency_min;
+	u64 latency_max;
+	u64 latency_sum;
+};
+
 /**
  * struct xvip_dma - Video DMA channel
  * @list: list entry in a composite device dmas list
@@ -83,6 +111,9 @@ static inline struct xvip_pipeline *to_xvip_pipeline(struct video_device *vdev)
  * @sgl: data chunk structure for dma_interleaved_template
  * @prev_fid: Previous Field ID
  * @low_latency_cap: Low latency capture mode
+ * @stats: channel statistics, protected by @queued_lock
+ * @debugfs: debugfs file reporting @stats
+ * @pool: pool of the MMAP buffers, kept across sessions
  */
 struct xvip_dma {
 	struct list_head list;
@@ -117,6 +148,11 @@ struct xvip_dma {
 
 	u32 prev_fid;
 	u32 low_latency_cap;
+
+	struct xvip_dma_stats stats;
+	struct dentry *debugfs;
+
+	struct xvip_dma_pool *pool;
 };
 
 #define to_xvip_dma(vdev)	container_of(vdev, struct xvip_dma, video)
@@ -125,4 +161,8 @@ int xvip_dma_init(struct xvip_composite_device *xdev, struct xvip_dma *dma,
 		  enum v4l2_buf_type type, unsigned int port);
 void xvip_dma_cleanup(struct xvip_dma *dma);
 
+extern const struct vb2_mem_ops xvip_dma_pool_memops;
+int xvip_dma_pool_init(struct xvip_dma *dma);
+void xvip_dma_pool_cleanup(struct xvip_dma *dma);
+
 #endif /* __XILINX_VIP_DMA_H__ */
@@ -20,6 +20,7 @@
 #include <media/v4l2-subdev.h>
 
 #include "xilinx-gamma-coeff.h"
+#include "xilinx-hls-common.h"
 #include "xilinx-vip.h"
 
 #define XGAMMA_MIN_HEIGHT	(64)
@@ -39,6 +40,10 @@
 #define XGAMMA_GAMMA_LUT_0_BASE		(0x0800)
 #define XGAMMA_GAMMA_LUT_1_BASE		(0x1000)
 #define XGAMMA_GAMMA_LUT_2_BASE		(0x1800)
+#define XGAMMA_GAMMA_LUT_SIZE		(0x0800)
+#define XGAMMA_REG_SPACE_SIZE		(XGAMMA_GAMMA_LUT_2_BASE + \
+					 XGAMMA_GAMMA_LUT_SIZE)
+#define XGAMMA_LUT_MAX_WORDS		BIT(GAMMA_BPC_10 - 1)
 
 #define XGAMMA_RESET_DEASSERT	(0)
 #define XGAMMA_RESET_ASSERT	(1)
@@ -65,6 +70,8 @@ enum xgamma_video_format {
  * @rst_gpio: GPIO reset line to bring VPSS Scaler out of reset
  * @max_width: Maximum width supported by this instance.
  * @max_height: Maximum height supported by this instance.
+ * @shadow: Shadow of the register space, used to skip unchanged words
+ * @lut_buf: Scratch buffer holding a LUT packed in register format
  */
 struct xgamma_dev {
 	struct xvip_device xvip;
@@ -81,6 +88,8 @@ struct xgamma_dev {
 	struct gpio_desc *rst_gpio;
 	u32 max_width;
 	u32 max_height;
+	struct xhls_shadow shadow;
+	u32 lut_buf[XGAMMA_LUT_MAX_WORDS];
 };
 
 static inline u32 xg_read(struct xgamma_dev *xg, u32 reg)
@@ -136,16 +145,18 @@ __xg_get_pad_format(struct xgamma_dev *xg,
 static void xg_set_lut_entries(struct xgamma_dev *xg,
 			       const u16 *lut, const u32 lut_base)
 {
+	unsigned int num_words = BIT(xg->color_depth - 1);
+	unsigned int written;
 	int itr;
-	u32 lut_offset, lut_data;
-
-	lut_offset = lut_base;
-	/* Write LUT Entries */
-	for (itr = 0; itr < BIT(xg->color_depth - 1); itr++) {
-		lut_data = (lut[2 * itr + 1] << 16) | lut[2 * itr];
-		xg_write(xg, lut_offset, lut_data);
-		lut_offset += 4;
-	}
+
+	/* Pack two entries per word and only write the words that change */
+	for (itr = 0; itr < num_words; itr++)
+		xg->lut_buf[itr] = (lut[2 * itr + 1] << 16) | lut[2 * itr];
+
+	written = xhls_shadow_write_block(&xg->shadow, lut_base, xg->lut_buf,
+					  num_words);
+	dev_dbg(xg->xvip.dev, "LUT at 0x%x: %u of %u words written",
+		lut_base, written, num_words);
 }
 
 static int xg_s_stream(struct v4l2_subdev *subdev, int enable)
@@ -156,6 +167,9 @@ static int xg_s_stream(struct v4l2_subdev *subdev, int enable)
 		dev_dbg(xg->xvip.dev, "%s : Off", __func__);
 		gpiod_set_value_cansleep(xg->rst_gpio, XGAMMA_RESET_ASSERT);
 		gpiod_set_value_cansleep(xg->rst_gpio, XGAMMA_RESET_DEASSERT);
+		/* The reset clears the registers but not the LUT memories */
+		xhls_shadow_invalidate_range(&xg->shadow, 0,
+					     XGAMMA_GAMMA_LUT_0_BASE);
 		return 0;
 	}
 	dev_dbg(xg->xvip.dev, "%s : Started", __func__);
@@ -163,9 +177,11 @@ static int xg_s_stream(struct v4l2_subdev *subdev, int enable)
 	dev_dbg(xg->xvip.dev, "%s : Setting width %d and height %d",
 		__func__, xg->formats[XVIP_PAD_SINK].width,
 		xg->formats[XVIP_PAD_SINK].height);
-	xg_write(xg, XGAMMA_WIDTH, xg->formats[XVIP_PAD_SINK].width);
-	xg_write(xg, XGAMMA_HEIGHT, xg->formats[XVIP_PAD_SINK].height);
-	xg_write(xg, XGAMMA_VIDEO_FORMAT, XGAMMA_RGB);
+	xhls_shadow_write(&xg->shadow, XGAMMA_WIDTH,
+			  xg->formats[XVIP_PAD_SINK].width);
+	xhls_shadow_write(&xg->shadow, XGAMMA_HEIGHT,
+			  xg->formats[XVIP_PAD_SINK].height);
+	xhls_shadow_write(&xg->shadow, XGAMMA_VIDEO_FORMAT, XGAMMA_RGB);
 	xg_set_lut_entries(xg, xg->red_lut, XGAMMA_GAMMA_LUT_0_BASE);
 	xg_set_lut_entries(xg, xg->green_lut, XGAMMA_GAMMA_LUT_1_BASE);
 	xg_set_lut_entries(xg, xg->blue_lut, XGAMMA_GAMMA_LUT_2_BASE);
@@ -462,6 +478,11 @@ static int xg_probe(struct platform_device *pdev)
 	if (rval)
 		return -EIO;
 
+	rval = xhls_shadow_init(&pdev->dev, &xg->shadow, xg->xvip.iomem,
+				XGAMMA_REG_SPACE_SIZE);
+	if (rval < 0)
+		goto media_error;
+
 	dev_dbg(xg->xvip.dev, "Reset Xilinx Video Gamma Corrrection");
 	gpiod_set_value_cansleep(xg->rst_gpio, XGAMMA_RESET_DEASSERT);
 
@@ -346,6 +346,8 @@ struct xhdmi_aux {
  * @max_frl_rate: Maximum FRL rate supported from IP configuration
  * @hdmi_stream_up: hdmi stream is up or not
  * @isstreamup: flag whether stream is up
+ * @locked_timing: timing of the last stream that locked, kept across
+ *		   stream drops to lock again faster on the same source
  */
 struct xhdmirx_state {
 	struct device *dev;
@@ -374,6 +376,7 @@ struct xhdmirx_state {
 	u8 max_frl_rate;
 	u8 hdmi_stream_up;
 	bool isstreamup;
+	struct xtiming locked_timing;
 };
 
 static const char * const xhdmirx_clks[] = {
@@ -1073,6 +1076,26 @@ static int xhdmirx1_get_video_properties(struct xhdmirx_state *xhdmi)
 	return -1;
 }
 
+/**
+ * xhdmirx1_timing_equal - Compare two video timings, ignoring polarities
+ *
+ * @a: first timing
+ * @b: second timing
+ *
+ * Returns: true if both timings describe the same video format
+ */
+static bool xhdmirx1_timing_equal(const struct xtiming *a,
+				  const struct xtiming *b)
+{
+	return a->hact == b->hact && a->htot == b->htot &&
+	       a->hfp == b->hfp && a->hbp == b->hbp && a->hsw == b->hsw &&
+	       a->vact == b->vact &&
+	       !memcmp(a->vtot, b->vtot, sizeof(a->vtot)) &&
+	       !memcmp(a->vfp, b->vfp, sizeof(a->vfp)) &&
+	       !memcmp(a->vbp, b->vbp, sizeof(a->vbp)) &&
+	       !memcmp(a->vsw, b->vsw, sizeof(a->vsw));
+}
+
 /**
  * xhdmirx1_get_vid_timing - Get the video timings of incoming stream
  *
@@ -1082,14 +1105,18 @@ static int xhdmirx1_get_video_properties(struct xhdmirx_state *xhdmi)
  * against the older value. If mismatch, it updates the video timing
  * structure in the driver state.
  *
+ * The timing is accepted once it has been read twice in a row, or at the
+ * first read when it matches the timing of the last stream that locked.
+ * A source reconnecting with the same format then locks one video timing
+ * detector period earlier.
+ *
  * Returns: 0 on success or -1 on fail
  */
 static int xhdmirx1_get_vid_timing(struct xhdmirx_state *xhdmi)
 {
+	struct xtiming *timing = &xhdmi->stream.video.timing;
+	struct xtiming cur = { 0 };
 	u32 data;
-	u16 hact, hfp, hsw, hbp, htot;
-	u16 vact, vfp[MAX_FIELDS], vsw[MAX_FIELDS], vbp[MAX_FIELDS];
-	u16 vtot[MAX_FIELDS];
 	u8 match, yuv420_correction, isinterlaced;
 
 	if (xhdmi->stream.video.colorspace == XCS_YUV420)
@@ -1097,29 +1124,31 @@ static int xhdmirx1_get_vid_timing(struct xhdmirx_state *xhdmi)
 	else
 		yuv420_correction = 1;
 
-	htot = xhdmi_read(xhdmi, HDMIRX_VTD_TOT_PIX_OFFSET) * yuv420_correction;
-	hact = xhdmi_read(xhdmi, HDMIRX_VTD_ACT_PIX_OFFSET) * yuv420_correction;
-	hsw = xhdmi_read(xhdmi, HDMIRX_VTD_HSW_OFFSET) * yuv420_correction;
-	hfp = xhdmi_read(xhdmi, HDMIRX_VTD_HFP_OFFSET) * yuv420_correction;
-	hbp = xhdmi_read(xhdmi, HDMIRX_VTD_HBP_OFFSET) * yuv420_correction;
+	cur.htot = xhdmi_read(xhdmi, HDMIRX_VTD_TOT_PIX_OFFSET) *
+		   yuv420_correction;
+	cur.hact = xhdmi_read(xhdmi, HDMIRX_VTD_ACT_PIX_OFFSET) *
+		   yuv420_correction;
+	cur.hsw = xhdmi_read(xhdmi, HDMIRX_VTD_HSW_OFFSET) * yuv420_correction;
+	cur.hfp = xhdmi_read(xhdmi, HDMIRX_VTD_HFP_OFFSET) * yuv420_correction;
+	cur.hbp = xhdmi_read(xhdmi, HDMIRX_VTD_HBP_OFFSET) * yuv420_correction;
 
 	data = xhdmi_read(xhdmi, HDMIRX_VTD_TOT_LIN_OFFSET);
-	vtot[0] = FIELD_GET(HDMIRX_VTD_VF0_MASK, data);
-	vtot[1] = FIELD_GET(HDMIRX_VTD_VF1_MASK, data);
+	cur.vtot[0] = FIELD_GET(HDMIRX_VTD_VF0_MASK, data);
+	cur.vtot[1] = FIELD_GET(HDMIRX_VTD_VF1_MASK, data);
 
-	vact = xhdmi_read(xhdmi, HDMIRX_VTD_ACT_LIN_OFFSET);
+	cur.vact = xhdmi_read(xhdmi, HDMIRX_VTD_ACT_LIN_OFFSET);
 
 	data = xhdmi_read(xhdmi, HDMIRX_VTD_VFP_OFFSET);
-	vfp[0] = FIELD_GET(HDMIRX_VTD_VF0_MASK, data);
-	vfp[1] = FIELD_GET(HDMIRX_VTD_VF1_MASK, data);
+	cur.vfp[0] = FIELD_GET(HDMIRX_VTD_VF0_MASK, data);
+	cur.vfp[1] = FIELD_GET(HDMIRX_VTD_VF1_MASK, data);
 
 	data = xhdmi_read(xhdmi, HDMIRX_VTD_VSW_OFFSET);
-	vsw[0] = FIELD_GET(HDMIRX_VTD_VF0_MASK, data);
-	vsw[1] = FIELD_GET(HDMIRX_VTD_VF1_MASK, data);
+	cur.vsw[0] = FIELD_GET(HDMIRX_VTD_VF0_MASK, data);
+	cur.vsw[1] = FIELD_GET(HDMIRX_VTD_VF1_MASK, data);
 
 	data = xhdmi_read(xhdmi, HDMIRX_VTD_VBP_OFFSET);
-	vbp[0] = FIELD_GET(HDMIRX_VTD_VF0_MASK, data);
-	vbp[1] = FIELD_GET(HDMIRX_VTD_VF1_MASK, data);
+	cur.vbp[0] = FIELD_GET(HDMIRX_VTD_VF0_MASK, data);
+	cur.vbp[1] = FIELD_GET(HDMIRX_VTD_VF1_MASK, data);
 
 	data = xhdmi_read(xhdmi, HDMIRX_VTD_STA_OFFSET);
 	if (data & HDMIRX_VTD_STA_FMT_MASK)
@@ -1129,57 +1158,35 @@ static int xhdmirx1_get_vid_timing(struct xhdmirx_state *xhdmi)
 
 	match = 1;
 
-	if (!hact || !hfp || !hsw || !hbp || !htot || !vact ||
-	    !vtot[0] || !vfp[0] || !vbp[0] || !vsw[0])
+	if (!cur.hact || !cur.hfp || !cur.hsw || !cur.hbp || !cur.htot ||
+	    !cur.vact || !cur.vtot[0] || !cur.vfp[0] || !cur.vbp[0] ||
+	    !cur.vsw[0])
 		match = 0;
 
-	if (isinterlaced && (!vfp[1] || !vsw[1] || !vbp[1] || !vtot[1]))
+	if (isinterlaced && (!cur.vfp[1] || !cur.vsw[1] || !cur.vbp[1] ||
+			     !cur.vtot[1]))
 		match = 0;
 
-	if (hact != xhdmi->stream.video.timing.hact ||
-	    htot != xhdmi->stream.video.timing.htot ||
-	    hfp != xhdmi->stream.video.timing.hfp ||
-	    hbp != xhdmi->stream.video.timing.hbp ||
-	    hsw != xhdmi->stream.video.timing.hsw ||
-	    vact != xhdmi->stream.video.timing.vact ||
-	    vtot[0] != xhdmi->stream.video.timing.vtot[0] ||
-	    vtot[1] != xhdmi->stream.video.timing.vtot[1] ||
-	    vfp[0] != xhdmi->stream.video.timing.vfp[0] ||
-	    vfp[1] != xhdmi->stream.video.timing.vfp[1] ||
-	    vbp[0] != xhdmi->stream.video.timing.vbp[0] ||
-	    vbp[1] != xhdmi->stream.video.timing.vbp[1] ||
-	    vsw[0] != xhdmi->stream.video.timing.vsw[0] ||
-	    vsw[1] != xhdmi->stream.video.timing.vsw[1])
+	if (!xhdmirx1_timing_equal(&cur, timing) &&
+	    !xhdmirx1_timing_equal(&cur, &xhdmi->locked_timing))
 		match = 0;
 
-	if (vtot[0] != (vact + vfp[0] + vsw[0] + vbp[0]))
+	if (cur.vtot[0] != (cur.vact + cur.vfp[0] + cur.vsw[0] + cur.vbp[0]))
 		match = 0;
 
 	if (isinterlaced) {
-		if (vtot[1] != (vact + vfp[1] + vsw[1] + vbp[1]))
+		if (cur.vtot[1] != (cur.vact + cur.vfp[1] + cur.vsw[1] +
+				    cur.vbp[1]))
 			match = 0;
 	} else {
 		/* if field 1 is populated for progessive video */
-		if (vfp[1] | vbp[1] | vsw[1])
+		if (cur.vfp[1] | cur.vbp[1] | cur.vsw[1])
 			match = 0;
 	}
 
-	xhdmi->stream.video.timing.hact = hact;
-	xhdmi->stream.video.timing.htot = htot;
-	xhdmi->stream.video.timing.hfp = hfp;
-	xhdmi->stream.video.timing.hsw = hsw;
-	xhdmi->stream.video.timing.hbp = hbp;
-
-	xhdmi->stream.video.timing.vtot[0] = vtot[0];
-	xhdmi->stream.video.timing.vtot[1] = vtot[1];
-
-	xhdmi->stream.video.timing.vact = vact;
-	xhdmi->stream.video.timing.vfp[0] = vfp[0];
-	xhdmi->stream.video.timing.vfp[1] = vfp[1];
-	xhdmi->stream.video.timing.vsw[0] = vsw[0];
-	xhdmi->stream.video.timing.vsw[1] = vsw[1];
-	xhdmi->stream.video.timing.vbp[0] = vbp[0];
-	xhdmi->stream.video.timing.vbp[1] = vbp[1];
+	cur.vsyncpol = timing->vsyncpol;
+	cur.hsyncpol = timing->hsyncpol;
+	*timing = cur;
 
 	if (match) {
 		data = xhdmi_read(xhdmi, HDMIRX_VTD_STA_OFFSET);
@@ -1190,14 +1197,16 @@ static int xhdmirx1_get_vid_timing(struct xhdmirx_state *xhdmi)
 			xhdmi->stream.video.isinterlaced = false;
 
 		if (data & HDMIRX_VTD_STA_VS_POL_MASK)
-			xhdmi->stream.video.timing.vsyncpol = 1;
+			timing->vsyncpol = 1;
 		else
-			xhdmi->stream.video.timing.vsyncpol = 0;
+			timing->vsyncpol = 0;
 
 		if (data & HDMIRX_VTD_STA_HS_POL_MASK)
-			xhdmi->stream.video.timing.hsyncpol = 1;
+			timing->hsyncpol = 1;
 		else
-			xhdmi->stream.video.timing.hsyncpol = 0;
+			timing->hsyncpol = 0;
+
+		xhdmi->locked_timing = *timing;
 
 		return 0;
 	}
@@ -13,7 +13,11 @@
 #ifndef __XILINX_HLS_COMMON_H__
 #define __XILINX_HLS_COMMON_H__
 
+#include <linux/bitmap.h>
 #include <linux/bitops.h>
+#include <linux/device.h>
+#include <linux/io.h>
+#include <linux/types.h>
 
 #define XHLS_DEF_WIDTH                          1920
 #define XHLS_DEF_HEIGHT                         1080
@@ -33,4 +37,160 @@
 #define XHLS_REG_ROWS                           0x10
 #define XHLS_REG_COLS                           0x18
 
+/**
+ * struct xhls_shadow - Shadow copy of an HLS core register space
+ * @iomem: base address of the shadowed register space
+ * @regs: last value written to each 32-bit word
+ * @valid: bitmap of the words in @regs known to match the hardware
+ * @num_words: size of the shadowed register space in 32-bit words
+ *
+ * HLS cores don't change their parameter registers and LUT memories on their
+ * own, so the value last written is also the value in the hardware. Writes
+ * through the shadow skip words that already hold the requested value.
+ * Offsets beyond the shadowed space are always written.
+ */
+struct xhls_shadow {
+	void __iomem *iomem;
+	u32 *regs;
+	unsigned long *valid;
+	unsigned int num_words;
+};
+
+/**
+ * xhls_shadow_init - Allocate the shadow of an HLS core register space
+ * @dev: device the memory is allocated for
+ * @shadow: the shadow
+ * @iomem: base address of the register space
+ * @size: size of the register space in bytes
+ *
+ * Return: 0 on success or -ENOMEM
+ */
+static inline int xhls_shadow_init(struct device *dev,
+				   struct xhls_shadow *shadow,
+				   void __iomem *iomem, size_t size)
+{
+	shadow->iomem = iomem;
+	shadow->num_words = size / 4;
+	shadow->regs = devm_kcalloc(dev, shadow->num_words,
+				    sizeof(*shadow->regs), GFP_KERNEL);
+	shadow->valid = devm_bitmap_zalloc(dev, shadow->num_words,
+					   GFP_KERNEL);
+	if (!shadow->regs || !shadow->valid)
+		return -ENOMEM;
+
+	return 0;
+}
+
+/**
+ * xhls_shadow_invalidate - Forget the content of the hardware registers
+ * @shadow: the shadow
+ *
+ * Must be called when the core is reset, so the next writes reach the
+ * hardware.
+ */
+static inline void xhls_shadow_invalidate(struct xhls_shadow *shadow)
+{
+	bitmap_zero(shadow->valid, shadow->num_words);
+}
+
+/**
+ * xhls_shadow_invalidate_range - Forget the content of some registers
+ * @shadow: the shadow
+ * @reg: offset of the first register in bytes
+ * @size: size of the range in bytes
+ *
+ * Used on reset when only part of the register space is cleared by the core,
+ * typically the control registers while the LUT memories keep their content.
+ */
+static inline void xhls_shadow_invalidate_range(struct xhls_shadow *shadow,
+						u32 reg, size_t size)
+{
+	unsigned int first = reg / 4;
+
+	if (first >= shadow->num_words)
+		return;
+
+	bitmap_clear(shadow->valid, first,
+		     min_t(unsigned int, size / 4, shadow->num_words - first));
+}
+
+static inline bool xhls_shadow_clean(struct xhls_shadow *shadow,
+				     unsigned int word, u32 value)
+{
+	return word < shadow->num_words && test_bit(word, shadow->valid) &&
+	       shadow->regs[word] == value;
+}
+
+static inline void xhls_shadow_update(struct xhls_shadow *shadow,
+				      unsigned int word, u32 value)
+{
+	if (word >= shadow->num_words)
+		return;
+
+	shadow->regs[word] = value;
+	set_bit(word, shadow->valid);
+}
+
+/**
+ * xhls_shadow_write - Write a register if its value changes
+ * @shadow: the shadow
+ * @reg: register offset in bytes
+ * @value: value to write
+ */
+static inline void xhls_shadow_write(struct xhls_shadow *shadow, u32 reg,
+				     u32 value)
+{
+	unsigned int word = reg / 4;
+
+	if (xhls_shadow_clean(shadow, word, value))
+		return;
+
+	iowrite32(value, shadow->iomem + reg);
+	xhls_shadow_update(shadow, word, value);
+}
+
+/**
+ * xhls_shadow_write_block - Write the words of a block that change
+ * @shadow: the shadow
+ * @reg: offset of the first register in bytes
+ * @data: values to write
+ * @count: number of 32-bit words in @data
+ *
+ * Consecutive dirty words are written in a single __iowrite32_copy() burst.
+ * The copy is made with 32-bit accesses, as required by the AXI4-Lite
+ * interface of HLS cores, unlike memcpy_toio() which may use wider ones.
+ *
+ * Return: the number of words written to the hardware
+ */
+static inline unsigned int
+xhls_shadow_write_block(struct xhls_shadow *shadow, u32 reg, const u32 *data,
+			unsigned int count)
+{
+	unsigned int first = reg / 4;
+	unsigned int written = 0;
+	unsigned int i = 0;
+
+	while (i < count) {
+		unsigned int start;
+
+		if (xhls_shadow_clean(shadow, first + i, data[i])) {
+			i++;
+			continue;
+		}
+
+		start = i;
+		while (i < count &&
+		       !xhls_shadow_clean(shadow, first + i, data[i])) {
+			xhls_shadow_update(shadow, first + i, data[i]);
+			i++;
+		}
+
+		__iowrite32_copy(shadow->iomem + reg + start * 4,
+				 &data[start], i - start);
+		written += i - start;
+	}
+
+	return written;
+}
+
 #endif /* __XILINX_HLS_COMMON_H__ */
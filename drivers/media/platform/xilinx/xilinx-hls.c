@@ -38,6 +38,7 @@
  * @ctrl_handler: control handler
  * @user_mem: user portion of the register space
  * @user_mem_size: size of the user portion of the register space
+ * @shadow: shadow of the control registers
  */
 struct xhls_device {
 	struct xvip_device xvip;
@@ -54,6 +55,8 @@ struct xhls_device {
 
 	void __iomem *user_mem;
 	size_t user_mem_size;
+
+	struct xhls_shadow shadow;
 };
 
 static inline struct xhls_device *to_hls(struct v4l2_subdev *subdev)
@@ -185,8 +188,8 @@ static int xhls_s_stream(struct v4l2_subdev *subdev, int enable)
 		return 0;
 	}
 
-	xvip_write(&xhls->xvip, XHLS_REG_COLS, format->width);
-	xvip_write(&xhls->xvip, XHLS_REG_ROWS, format->height);
+	xhls_shadow_write(&xhls->shadow, XHLS_REG_COLS, format->width);
+	xhls_shadow_write(&xhls->shadow, XHLS_REG_ROWS, format->height);
 
 	xvip_write(&xhls->xvip, XVIP_CTRL_CONTROL,
 		   XHLS_REG_CTRL_AUTO_RESTART | XVIP_CTRL_CONTROL_SW_ENABLE);
@@ -425,6 +428,11 @@ static int xhls_probe(struct platform_device *pdev)
 		return PTR_ERR(xhls->user_mem);
 	xhls->user_mem_size = resource_size(mem);
 
+	ret = xhls_shadow_init(&pdev->dev, &xhls->shadow, xhls->xvip.iomem,
+			       XHLS_REG_COLS + 4);
+	if (ret < 0)
+		return ret;
+
 	/* Reset and initialize the core */
 	xvip_reset(&xhls->xvip);
 
@@ -6,9 +6,11 @@
 #include <linux/delay.h>
 #include <linux/device.h>
 #include <linux/gpio/consumer.h>
+#include <linux/interrupt.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
+#include <linux/spinlock.h>
 #include <linux/xilinx-v4l2-controls.h>
 
 #include <media/v4l2-async.h>
@@ -19,6 +21,9 @@
 #include "xilinx-vip.h"
 
 #define XISP_AP_CTRL_REG		(0x0)
+#define XISP_GIE_REG			(0x4)
+#define XISP_IER_REG			(0x8)
+#define XISP_ISR_REG			(0xC)
 #define XISP_WIDTH_REG			(0x10)
 #define XISP_HEIGHT_REG			(0x18)
 #define XISP_MODE_REG			(0x20)
@@ -42,6 +47,9 @@
 #define XISP_START			BIT(0)
 #define XISP_AUTO_RESTART		BIT(7)
 #define XISP_STREAM_ON			(XISP_AUTO_RESTART | XISP_START)
+#define XISP_GIE_EN			BIT(0)
+#define XISP_IRQ_AP_DONE		BIT(0)
+#define XISP_NUM_CTRLS			(7)
 
 enum xisp_bayer_format {
 	XISP_RGGB = 0,
@@ -50,6 +58,28 @@ enum xisp_bayer_format {
 	XISP_BGGR,
 };
 
+/*
+ * struct xisp_shadow - Parameters last written to the ISP pipeline
+ * @valid: The registers hold the values below
+ * @rgain: Red gain register
+ * @bgain: Blue gain register
+ * @mode_reg: AWB mode register
+ * @pawb: AWB threshold register
+ * @red_lut: Red gamma LUT
+ * @green_lut: Green gamma LUT
+ * @blue_lut: Blue gamma LUT
+ */
+struct xisp_shadow {
+	bool valid;
+	u16 rgain;
+	u16 bgain;
+	bool mode_reg;
+	u16 pawb;
+	const u32 *red_lut;
+	const u32 *green_lut;
+	const u32 *blue_lut;
+};
+
 /*
  * struct xisp_dev - Xilinx ISP pipeline device structure
  * @xvip: Xilinx Video IP device
@@ -69,6 +99,12 @@ enum xisp_bayer_format {
  * @green_lut: Pointer to the gamma coefficient as per the Green Gamma control
  * @blue_lut: Pointer to the gamma coefficient as per the Blue Gamma control
  * @gamma_table: Pointer to the table containing various gamma values
+ * @ctrls: V4L2 controls, all part of a single cluster
+ * @lock: Protects the parameters above, @hw, @streaming and @pending
+ * @hw: Shadow copy of the parameter registers
+ * @irq: Frame done interrupt, or negative if not wired
+ * @streaming: The ISP pipeline is running
+ * @pending: Parameters are staged and wait for the next frame done interrupt
  */
 struct xisp_dev {
 	struct xvip_device xvip;
@@ -88,6 +124,13 @@ struct xisp_dev {
 	const u32 *green_lut;
 	const u32 *blue_lut;
 	const u32 **gamma_table;
+	struct v4l2_ctrl *ctrls[XISP_NUM_CTRLS];
+	/* Protects the parameters against the frame done interrupt */
+	spinlock_t lock;
+	struct xisp_shadow hw;
+	int irq;
+	bool streaming;
+	bool pending;
 };
 
 static inline struct xisp_dev *to_xisp(struct v4l2_subdev *subdev)
@@ -123,58 +166,140 @@ static void select_gamma(u32 value, const u32 **coeff, const u32 **xgamma_curves
 	*coeff = *(xgamma_curves + value - 1);
 }
 
-static int xisp_s_ctrl(struct v4l2_ctrl *ctrl)
+/*
+ * xisp_commit_params - Write the staged parameters to the ISP pipeline
+ * @xisp: The xisp_dev
+ *
+ * Only the registers and LUTs whose value differs from the shadow copy are
+ * written. Must be called with the lock held.
+ */
+static void xisp_commit_params(struct xisp_dev *xisp)
+{
+	struct xisp_shadow *hw = &xisp->hw;
+
+	lockdep_assert_held(&xisp->lock);
+
+	if (!hw->valid || hw->rgain != xisp->rgain)
+		xvip_write(&xisp->xvip, XISP_RGAIN_REG, xisp->rgain);
+	if (!hw->valid || hw->bgain != xisp->bgain)
+		xvip_write(&xisp->xvip, XISP_BGAIN_REG, xisp->bgain);
+	if (!hw->valid || hw->mode_reg != xisp->mode_reg)
+		xvip_write(&xisp->xvip, XISP_MODE_REG, xisp->mode_reg);
+	if (!hw->valid || hw->pawb != xisp->pawb)
+		xvip_write(&xisp->xvip, XISP_PAWB_REG, xisp->pawb);
+	if (!hw->valid || hw->red_lut != xisp->red_lut)
+		xisp_set_lut_entries(xisp, xisp->red_lut, XISP_GAMMA_RED_REG);
+	if (!hw->valid || hw->green_lut != xisp->green_lut)
+		xisp_set_lut_entries(xisp, xisp->green_lut,
+				     XISP_GAMMA_GREEN_REG);
+	if (!hw->valid || hw->blue_lut != xisp->blue_lut)
+		xisp_set_lut_entries(xisp, xisp->blue_lut, XISP_GAMMA_BLUE_REG);
+
+	hw->rgain = xisp->rgain;
+	hw->bgain = xisp->bgain;
+	hw->mode_reg = xisp->mode_reg;
+	hw->pawb = xisp->pawb;
+	hw->red_lut = xisp->red_lut;
+	hw->green_lut = xisp->green_lut;
+	hw->blue_lut = xisp->blue_lut;
+	hw->valid = true;
+
+	xisp->pending = false;
+}
+
+static void xisp_stage_ctrl(struct xisp_dev *xisp, struct v4l2_ctrl *ctrl)
 {
-	struct xisp_dev *xisp =
-		container_of(ctrl->handler,
-			     struct xisp_dev, ctrl_handler);
 	switch (ctrl->id) {
 	case V4L2_CID_XILINX_ISP_RED_GAIN:
 		xisp->rgain = ctrl->val;
-		xvip_write(&xisp->xvip, XISP_RGAIN_REG, xisp->rgain);
 		break;
 	case V4L2_CID_XILINX_ISP_BLUE_GAIN:
 		xisp->bgain = ctrl->val;
-		xvip_write(&xisp->xvip, XISP_BGAIN_REG, xisp->bgain);
 		break;
 	case V4L2_CID_XILINX_ISP_AWB:
 		xisp->mode_reg = ctrl->val;
-		xvip_write(&xisp->xvip, XISP_MODE_REG, xisp->mode_reg);
 		break;
 	case V4L2_CID_XILINX_ISP_THRESHOLD:
 		xisp->pawb = ctrl->val;
-		xvip_write(&xisp->xvip, XISP_PAWB_REG, xisp->pawb);
 		break;
 	case V4L2_CID_XILINX_ISP_RED_GAMMA:
 		select_gamma(ctrl->val, &xisp->red_lut, xisp->gamma_table);
-		dev_dbg(xisp->xvip.dev, "Setting Red Gamma to %d.%d",
-			ctrl->val / 10, ctrl->val % 10);
-		xisp_set_lut_entries(xisp, xisp->red_lut, XISP_GAMMA_RED_REG);
 		break;
 	case V4L2_CID_XILINX_ISP_GREEN_GAMMA:
 		select_gamma(ctrl->val, &xisp->green_lut, xisp->gamma_table);
-		dev_dbg(xisp->xvip.dev, "Setting Green Gamma to %d.%d",
-			ctrl->val / 10, ctrl->val % 10);
-		xisp_set_lut_entries(xisp, xisp->green_lut, XISP_GAMMA_GREEN_REG);
 		break;
 	case V4L2_CID_XILINX_ISP_BLUE_GAMMA:
 		select_gamma(ctrl->val, &xisp->blue_lut, xisp->gamma_table);
-		dev_dbg(xisp->xvip.dev, "Setting Blue Gamma to %d.%d",
-			ctrl->val / 10, ctrl->val % 10);
-		xisp_set_lut_entries(xisp, xisp->blue_lut, XISP_GAMMA_BLUE_REG);
 		break;
-	default:
-		return -EINVAL;
 	}
+}
+
+/*
+ * All the controls form a single cluster, so a VIDIOC_S_EXT_CTRLS call
+ * setting several of them results in a single call here. The new values are
+ * staged and, while streaming, committed together at the next frame done
+ * interrupt so that a frame is never processed with half of an update.
+ */
+static int xisp_s_ctrl(struct v4l2_ctrl *ctrl)
+{
+	struct xisp_dev *xisp =
+		container_of(ctrl->handler,
+			     struct xisp_dev, ctrl_handler);
+	unsigned long flags;
+	unsigned int i;
+
+	spin_lock_irqsave(&xisp->lock, flags);
+
+	for (i = 0; i < ctrl->ncontrols; i++) {
+		struct v4l2_ctrl *c = ctrl->cluster[i];
+
+		if (!c || !c->is_new)
+			continue;
+
+		dev_dbg(xisp->xvip.dev, "Setting %s to %d", c->name, c->val);
+		xisp_stage_ctrl(xisp, c);
+	}
+
+	/*
+	 * Without a frame done interrupt the parameters are written right
+	 * away. When stopped they are written at stream on.
+	 */
+	if (xisp->streaming) {
+		if (xisp->irq > 0)
+			xisp->pending = true;
+		else
+			xisp_commit_params(xisp);
+	}
+
+	spin_unlock_irqrestore(&xisp->lock, flags);
 
 	return 0;
 }
 
+static irqreturn_t xisp_irq_handler(int irq, void *data)
+{
+	struct xisp_dev *xisp = data;
+	u32 status;
+
+	status = xvip_read(&xisp->xvip, XISP_ISR_REG);
+	if (!(status & XISP_IRQ_AP_DONE))
+		return IRQ_NONE;
+
+	xvip_write(&xisp->xvip, XISP_ISR_REG, status & XISP_IRQ_AP_DONE);
+
+	spin_lock(&xisp->lock);
+	if (xisp->streaming && xisp->pending)
+		xisp_commit_params(xisp);
+	spin_unlock(&xisp->lock);
+
+	return IRQ_HANDLED;
+}
+
 static const struct v4l2_ctrl_ops xisp_ctrl_ops = {
 	.s_ctrl = xisp_s_ctrl,
 };
 
-static struct v4l2_ctrl_config xisp_ctrls[] = {
+static struct v4l2_ctrl_config xisp_ctrls[XISP_NUM_CTRLS] = {
 	/* Red Gain*/
 	{
 		.ops = &xisp_ctrl_ops,
@@ -301,20 +426,36 @@ static int xisp_s_stream(struct v4l2_subdev *subdev, int enable)
 
 	if (!enable) {
 		dev_dbg(xisp->xvip.dev, "%s : Off", __func__);
+		spin_lock_irq(&xisp->lock);
+		xisp->streaming = false;
+		xisp->pending = false;
+		spin_unlock_irq(&xisp->lock);
+
+		if (xisp->irq > 0) {
+			xvip_write(&xisp->xvip, XISP_GIE_REG, 0);
+			synchronize_irq(xisp->irq);
+		}
+
 		xisp_reset(xisp);
+		xisp->hw.valid = false;
 		return 0;
 	}
 
 	xvip_write(&xisp->xvip, XISP_WIDTH_REG, xisp->formats[XVIP_PAD_SINK].width);
 	xvip_write(&xisp->xvip, XISP_HEIGHT_REG, xisp->formats[XVIP_PAD_SINK].height);
 	xvip_write(&xisp->xvip, XISP_INPUT_BAYER_FORMAT_REG, xisp->bayer_fmt);
-	xvip_write(&xisp->xvip, XISP_RGAIN_REG, xisp->rgain);
-	xvip_write(&xisp->xvip, XISP_BGAIN_REG, xisp->bgain);
-	xvip_write(&xisp->xvip, XISP_MODE_REG, xisp->mode_reg);
-	xvip_write(&xisp->xvip, XISP_PAWB_REG, xisp->pawb);
-	xisp_set_lut_entries(xisp, xisp->red_lut, XISP_GAMMA_RED_REG);
-	xisp_set_lut_entries(xisp, xisp->green_lut, XISP_GAMMA_GREEN_REG);
-	xisp_set_lut_entries(xisp, xisp->blue_lut, XISP_GAMMA_BLUE_REG);
+
+	spin_lock_irq(&xisp->lock);
+	xisp->hw.valid = false;
+	xisp_commit_params(xisp);
+	xisp->streaming = true;
+	spin_unlock_irq(&xisp->lock);
+
+	if (xisp->irq > 0) {
+		xvip_write(&xisp->xvip, XISP_ISR_REG, XISP_IRQ_AP_DONE);
+		xvip_write(&xisp->xvip, XISP_IER_REG, XISP_IRQ_AP_DONE);
+		xvip_write(&xisp->xvip, XISP_GIE_REG, XISP_GIE_EN);
+	}
 
 	/* Start ISP pipeline IP */
 	xvip_write(&xisp->xvip, XISP_AP_CTRL_REG, XISP_STREAM_ON);
@@ -553,11 +694,17 @@ static int xisp_probe(struct platform_device *pdev)
 		return -ENOMEM;
 
 	xisp->xvip.dev = &pdev->dev;
+	spin_lock_init(&xisp->lock);
 
 	rval = xisp_parse_of(xisp);
 	if (rval < 0)
 		return rval;
 
+	/* The frame done interrupt is optional */
+	xisp->irq = platform_get_irq_optional(pdev, 0);
+	if (xisp->irq == -EPROBE_DEFER)
+		return xisp->irq;
+
 	rval = xvip_init_resources(&xisp->xvip);
 	if (rval)
 		return -EIO;
@@ -565,6 +712,16 @@ static int xisp_probe(struct platform_device *pdev)
 	/* Reset ISP pipeline IP */
 	xisp_reset(xisp);
 
+	if (xisp->irq > 0) {
+		rval = devm_request_irq(&pdev->dev, xisp->irq,
+					xisp_irq_handler, IRQF_SHARED,
+					dev_name(&pdev->dev), xisp);
+		if (rval) {
+			dev_err(&pdev->dev, "Failed to request IRQ");
+			goto media_error;
+		}
+	}
+
 	/* Init V4L2 subdev */
 	subdev = &xisp->xvip.subdev;
 	v4l2_subdev_init(subdev, &xisp_ops);
@@ -602,8 +759,8 @@ static int xisp_probe(struct platform_device *pdev)
 	/* V4L2 Controls */
 	v4l2_ctrl_handler_init(&xisp->ctrl_handler, ARRAY_SIZE(xisp_ctrls));
 	for (itr = 0; itr < ARRAY_SIZE(xisp_ctrls); itr++) {
-		v4l2_ctrl_new_custom(&xisp->ctrl_handler,
-				     &xisp_ctrls[itr], NULL);
+		xisp->ctrls[itr] = v4l2_ctrl_new_custom(&xisp->ctrl_handler,
+							&xisp_ctrls[itr], NULL);
 	}
 
 	if (xisp->ctrl_handler.error) {
@@ -612,6 +769,8 @@ static int xisp_probe(struct platform_device *pdev)
 		goto ctrl_error;
 	}
 
+	v4l2_ctrl_cluster(ARRAY_SIZE(xisp->ctrls), xisp->ctrls);
+
 	subdev->ctrl_handler = &xisp->ctrl_handler;
 	rval = v4l2_ctrl_handler_setup(&xisp->ctrl_handler);
 	if (rval < 0) {
@@ -9,6 +9,9 @@
 
 #include <drm/drm_fourcc.h>
 #include <linux/delay.h>
+#include <linux/dma-buf.h>
+#include <linux/dma-fence.h>
+#include <linux/dma-resv.h>
 #include <linux/dma/xilinx_frmbuf.h>
 #include <linux/lcm.h>
 #include <linux/list.h>
@@ -17,6 +20,7 @@
 #include <linux/of_graph.h>
 #include <linux/platform_device.h>
 #include <linux/slab.h>
+#include <linux/workqueue.h>
 
 #include <media/v4l2-async.h>
 #include <media/v4l2-common.h>
@@ -165,12 +169,18 @@ struct xvip_m2m_dma {
  * @xdev: composite mem2mem device the DMA channels belongs to
  * @xt: dma interleaved template for dma configuration
  * @sgl: data chunk structure for dma_interleaved_template
+ * @fence: write fence of the next OUTPUT buffer being waited for
+ * @fence_cb: callback run when @fence is signalled
+ * @fence_work: reschedules the context once @fence is signalled
  */
 struct xvip_m2m_ctx {
 	struct v4l2_fh fh;
 	struct xvip_m2m_dev *xdev;
 	struct dma_interleaved_template xt;
 	struct data_chunk sgl[1];
+	struct dma_fence *fence;
+	struct dma_fence_cb fence_cb;
+	struct work_struct fence_work;
 };
 
 static inline struct xvip_m2m_ctx *file2ctx(struct file *file)
@@ -541,6 +551,122 @@ static int xvip_pipeline_prepare(struct xvip_pipeline *pipe,
 	return ret;
 }
 
+/*
+ * Implicit synchronization
+ *
+ * The frame written by the CAPTURE DMA is announced with its completion
+ * fence in the reservation of the dma-buf. A buffer queued on the OUTPUT
+ * queue of another mem2mem node, or of the same one, is then only read
+ * once that fence is signalled. This lets userspace queue a whole chain of
+ * nodes sharing dma-bufs at once, without waiting for each node to be done.
+ */
+
+static void xvip_m2m_fence_work(struct work_struct *work)
+{
+	struct xvip_m2m_ctx *ctx = container_of(work, struct xvip_m2m_ctx,
+						fence_work);
+
+	dma_fence_put(xchg(&ctx->fence, NULL));
+	v4l2_m2m_try_schedule(ctx->fh.m2m_ctx);
+}
+
+static void xvip_m2m_fence_signalled(struct dma_fence *fence,
+				     struct dma_fence_cb *cb)
+{
+	struct xvip_m2m_ctx *ctx = container_of(cb, struct xvip_m2m_ctx,
+						fence_cb);
+
+	schedule_work(&ctx->fence_work);
+}
+
+/*
+ * Check that nothing is still writing to the next OUTPUT buffer, and wait
+ * for the first pending writer otherwise. Called from job_ready(), with
+ * the job lock of the mem2mem core held.
+ */
+static bool xvip_m2m_src_idle(struct xvip_m2m_ctx *ctx)
+{
+	struct vb2_v4l2_buffer *src_buf;
+	struct dma_resv_iter cursor;
+	struct dma_fence *fence;
+	struct dma_buf *dbuf;
+	unsigned int i;
+
+	if (ctx->fence)
+		return false;
+
+	src_buf = v4l2_m2m_next_src_buf(ctx->fh.m2m_ctx);
+	if (!src_buf || src_buf->vb2_buf.memory != VB2_MEMORY_DMABUF)
+		return true;
+
+	for (i = 0; i < src_buf->vb2_buf.num_planes; i++) {
+		dbuf = src_buf->vb2_buf.planes[i].dbuf;
+		if (!dbuf)
+			continue;
+retry:
+		fence = NULL;
+		dma_resv_iter_begin(&cursor, dbuf->resv, DMA_RESV_USAGE_WRITE);
+		dma_resv_for_each_fence_unlocked(&cursor, fence) {
+			dma_fence_get(fence);
+			break;
+		}
+		dma_resv_iter_end(&cursor);
+		if (!fence)
+			continue;
+
+		ctx->fence = fence;
+		if (!dma_fence_add_callback(fence, &ctx->fence_cb,
+					    xvip_m2m_fence_signalled))
+			return false;
+
+		/* Signalled meanwhile, look for another writer */
+		ctx->fence = NULL;
+		dma_fence_put(fence);
+		goto retry;
+	}
+
+	return true;
+}
+
+static void xvip_m2m_fence_cancel(struct xvip_m2m_ctx *ctx)
+{
+	if (ctx->fence && dma_fence_remove_callback(ctx->fence, &ctx->fence_cb))
+		dma_fence_put(xchg(&ctx->fence, NULL));
+	cancel_work_sync(&ctx->fence_work);
+	dma_fence_put(xchg(&ctx->fence, NULL));
+}
+
+/* Publish the completion of the frame in the CAPTURE buffer */
+static void xvip_m2m_add_write_fence(struct xvip_m2m_ctx *ctx,
+				     struct vb2_v4l2_buffer *dst_buf,
+				     struct dma_async_tx_descriptor *desc)
+{
+	struct xvip_m2m_dma *dma = ctx->xdev->dma;
+	struct dma_fence *fence;
+	struct dma_resv *resv;
+	unsigned int i;
+
+	if (dst_buf->vb2_buf.memory != VB2_MEMORY_DMABUF)
+		return;
+
+	fence = xilinx_xdma_get_fence(dma->chan_rx, desc);
+	if (IS_ERR(fence))
+		return;
+
+	for (i = 0; i < dst_buf->vb2_buf.num_planes; i++) {
+		if (!dst_buf->vb2_buf.planes[i].dbuf)
+			continue;
+
+		resv = dst_buf->vb2_buf.planes[i].dbuf->resv;
+		dma_resv_lock(resv, NULL);
+		if (!dma_resv_reserve_fences(resv, 1))
+			dma_resv_add_fence(resv, fence, DMA_RESV_USAGE_WRITE);
+		dma_resv_unlock(resv);
+	}
+
+	dma_fence_put(fence);
+}
+
 static void xvip_m2m_dma_callback_mem2dev(void *data)
 {
 }
@@ -1148,6 +1274,7 @@ static int xvip_m2m_open(struct file *file)
 	v4l2_fh_init(&ctx->fh, video_devdata(file));
 	file->private_data = &ctx->fh;
 	ctx->xdev = xdev;
+	INIT_WORK(&ctx->fence_work, xvip_m2m_fence_work);
 
 	ctx->fh.m2m_ctx = v4l2_m2m_ctx_init(xdev->m2m_dev, ctx,
 					    &xvip_m2m_queue_init);
@@ -1167,6 +1294,7 @@ static int xvip_m2m_release(struct file *file)
 {
 	struct xvip_m2m_ctx *ctx = file->private_data;
 
+	xvip_m2m_fence_cancel(ctx);
 	v4l2_m2m_ctx_release(ctx->fh.m2m_ctx);
 	return 0;
 }
@@ -1201,7 +1329,7 @@ static int xvip_m2m_job_ready(void *priv)
 
 	if ((v4l2_m2m_num_src_bufs_ready(ctx->fh.m2m_ctx) > 0) &&
 	    (v4l2_m2m_num_dst_bufs_ready(ctx->fh.m2m_ctx) > 0))
-		return 1;
+		return xvip_m2m_src_idle(ctx);
 
 	return 0;
 }
@@ -1301,6 +1429,7 @@ static void xvip_m2m_prep_submit_dev2mem_desc(struct xvip_m2m_ctx *ctx,
 	desc->callback = xvip_m2m_dma_callback;
 	desc->callback_param = ctx;
 	dmaengine_submit(desc);
+	xvip_m2m_add_write_fence(ctx, dst_buf, desc);
 	dma_async_issue_pending(dma->chan_rx);
 }
 
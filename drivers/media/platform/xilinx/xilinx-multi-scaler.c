@@ -24,14 +24,13 @@
 #include <linux/platform_device.h>
 #include <linux/sched.h>
 #include <linux/slab.h>
+#include <linux/xlnx/xlnx_scaler_coeff.h>
 
 #include <media/v4l2-device.h>
 #include <media/v4l2-ioctl.h>
 #include <media/v4l2-mem2mem.h>
 #include <media/videobuf2-dma-contig.h>
 
-#include "xilinx-multi-scaler-coeff.h"
-
 /* 0x0000 : Control signals */
 #define XM2MSC_AP_CTRL			0x0000
 #define XM2MSC_AP_CTRL_START		BIT(0)
@@ -66,6 +65,8 @@
 #define XM2MSC_SRCIMGBUF1		0x070
 #define XM2MSC_DSTIMGBUF0		0x090
 #define XM2MSC_DSTIMGBUF1		0x0100
+/* Parameter registers, XM2MSC_WIDTHIN to XM2MSC_OUTSTRIDE, 64 bits apart */
+#define XM2MSC_CHAN_PARAM_REGS		(XM2MSC_OUTSTRIDE / 8 + 1)
 
 #define XM2MVSC_VFLTCOEFF_L	0x2000
 #define XM2MVSC_VFLTCOEFF(x)	(XM2MVSC_VFLTCOEFF_L + 0x2000 * (x))
@@ -92,9 +93,6 @@
 #define XM2MSC_MIN_WIDTH	(64)
 #define XM2MSC_MIN_HEIGHT	(64)
 #define XM2MSC_STEP_PRECISION	(65536)
-/* Mask definitions for Low 16 bits in a 32 bit number */
-#define XM2MSC_MASK_LOW_16BITS	GENMASK(15, 0)
-#define XM2MSC_BITSHIFT_16	(16)
 
 #define XM2MSC_DRIVER_NAME	"xm2msc"
 
@@ -339,6 +337,10 @@ struct xm2msc_q_data {
  * @m2m_dev: m2m device
  * @m2m_ctx: memory to memory context structure
  * @q_data: src & dst queue data
+ * @params: last values written to the channel parameter registers
+ * @params_valid: bitmap of the @params entries matching the hardware
+ * @hcoeff: horizontal filter table loaded in the channel coefficient bank
+ * @vcoeff: vertical filter table loaded in the channel coefficient bank
  */
 struct xm2msc_chan_ctx {
 	void __iomem *regs;
@@ -358,6 +360,11 @@ struct xm2msc_chan_ctx {
 	struct v4l2_m2m_ctx *m2m_ctx;
 
 	struct xm2msc_q_data q_data[2];
+
+	u32 params[XM2MSC_CHAN_PARAM_REGS];
+	u32 params_valid;
+	struct xlnx_scaler_coeff_cache hcoeff;
+	struct xlnx_scaler_coeff_cache vcoeff;
 };
 
 /**
@@ -386,8 +393,6 @@ struct xm2msc_chan_ctx {
  * @mutex: lock for channel ctx
  * @lock: lock used in IRQ
  * @xm2msc_chan: arrey of channel context
- * @hscaler_coeff: Array of filter coefficients for the Horizontal Scaler
- * @vscaler_coeff: Array of filter coefficients for the Vertical Scaler
  */
 struct xm2m_msc_dev {
 	struct device *dev;
@@ -418,8 +423,6 @@ struct xm2m_msc_dev {
 	spinlock_t lock; /*IRQ lock*/
 
 	struct xm2msc_chan_ctx xm2msc_chan[XM2MSC_MAX_CHAN];
-	short hscaler_coeff[XSCALER_MAX_PHASES][XSCALER_MAX_TAPS];
-	short vscaler_coeff[XSCALER_MAX_PHASES][XSCALER_MAX_TAPS];
 };
 
 #define fh_to_chanctx(__fh) container_of(__fh, struct xm2msc_chan_ctx, fh)
@@ -440,6 +443,24 @@ static inline void xm2msc_writereg(void __iomem *addr, u32 value)
 	iowrite32(value, addr);
 }
 
+/*
+ * Write a channel parameter register, unless it already holds the value.
+ * Most streams keep their resolution, so this spares the reprogramming of
+ * all channels when the number of outputs changes.
+ */
+static void xm2msc_chan_writereg(struct xm2msc_chan_ctx *chan_ctx, u32 reg,
+				 u32 value)
+{
+	u32 i = reg / 8;
+
+	if ((chan_ctx->params_valid & BIT(i)) && chan_ctx->params[i] == value)
+		return;
+
+	xm2msc_writereg(chan_ctx->regs + reg, value);
+	chan_ctx->params[i] = value;
+	chan_ctx->params_valid |= BIT(i);
+}
+
 static bool xm2msc_is_yuv_singlebuff(u32 fourcc)
 {
 	if (fourcc == V4L2_PIX_FMT_NV12 || fourcc == V4L2_PIX_FMT_XV15 ||
@@ -503,244 +524,34 @@ static const struct xm2msc_fmt *find_format(struct v4l2_format *f)
 	return &formats[i];
 }
 
-static void
-xm2msc_hscaler_load_ext_coeff(struct xm2m_msc_dev *xm2msc,
-			      const short *coeff, u32 ntaps)
-{
-	unsigned int i, j, pad, offset;
-	const u32 nphases = XSCALER_MAX_PHASES;
-
-	/* Determine if coefficient needs padding (effective vs. max taps) */
-	pad = XSCALER_MAX_TAPS - ntaps;
-	offset = pad >> 1;
-
-	memset(xm2msc->hscaler_coeff, 0, sizeof(xm2msc->hscaler_coeff));
-
-	/* Load coefficients into scaler coefficient table */
-	for (i = 0; i < nphases; i++) {
-		for (j = 0; j < ntaps; ++j)
-			xm2msc->hscaler_coeff[i][j + offset] =
-						coeff[i * ntaps + j];
-	}
-}
-
-static void xm2msc_hscaler_set_coeff(struct xm2msc_chan_ctx *chan_ctx,
-				     const u32 base_addr)
-{
-	struct xm2m_msc_dev *xm2msc = chan_ctx->xm2msc_dev;
-	int val, offset, rd_indx;
-	unsigned int i, j;
-	u32 ntaps = chan_ctx->xm2msc_dev->taps;
-	const u32 nphases = XSCALER_MAX_PHASES;
-
-	offset = (XSCALER_MAX_TAPS - ntaps) / 2;
-	for (i = 0; i < nphases; i++) {
-		for (j = 0; j < ntaps / 2; j++) {
-			rd_indx = j * 2 + offset;
-			val = (xm2msc->hscaler_coeff[i][rd_indx + 1] <<
-			       XM2MSC_BITSHIFT_16) |
-			       (xm2msc->hscaler_coeff[i][rd_indx] &
-			       XM2MSC_MASK_LOW_16BITS);
-			 xm2msc_writereg((xm2msc->regs + base_addr) +
-				    ((i * ntaps / 2 + j) * 4), val);
-		}
-	}
-}
-
-static void
-xm2msc_vscaler_load_ext_coeff(struct xm2m_msc_dev *xm2msc,
-			      const short *coeff, const u32 ntaps)
-{
-	unsigned int i, j;
-	int pad, offset;
-	const u32 nphases = XSCALER_MAX_PHASES;
-
-	/* Determine if coefficient needs padding (effective vs. max taps) */
-	pad = XSCALER_MAX_TAPS - ntaps;
-	offset = pad ? (pad >> 1) : 0;
-
-	/* Zero Entire Array */
-	memset(xm2msc->vscaler_coeff, 0, sizeof(xm2msc->vscaler_coeff));
-
-	/* Load User defined coefficients into scaler coefficient table */
-	for (i = 0; i < nphases; i++) {
-		for (j = 0; j < ntaps; ++j)
-			xm2msc->vscaler_coeff[i][j + offset] =
-						coeff[i * ntaps + j];
-	}
-}
-
-static void
-xm2msc_vscaler_set_coeff(struct xm2msc_chan_ctx *chan_ctx,
-			 const u32 base_addr)
-{
-	struct xm2m_msc_dev *xm2msc = chan_ctx->xm2msc_dev;
-	u32 val, i, j, offset, rd_indx;
-	u32 ntaps = chan_ctx->xm2msc_dev->taps;
-	const u32 nphases = XSCALER_MAX_PHASES;
-
-	offset = (XSCALER_MAX_TAPS - ntaps) / 2;
-
-	for (i = 0; i < nphases; i++) {
-		for (j = 0; j < ntaps / 2; j++) {
-			rd_indx = j * 2 + offset;
-			val = (xm2msc->vscaler_coeff[i][rd_indx + 1] <<
-			       XM2MSC_BITSHIFT_16) |
-			       (xm2msc->vscaler_coeff[i][rd_indx] &
-			       XM2MSC_MASK_LOW_16BITS);
-			xm2msc_writereg((xm2msc->regs +
-				   base_addr) + ((i * ntaps / 2 + j) * 4), val);
-		}
-	}
-}
-
-static u32
-xm2msc_select_hcoeff(struct xm2msc_chan_ctx *chan_ctx, const short **coeff)
-{
-	u16 hscale_ratio;
-	u32 width_in = chan_ctx->q_data[XM2MSC_CHAN_OUT].width;
-	u32 width_out = chan_ctx->q_data[XM2MSC_CHAN_CAP].width;
-	u32 ntaps;
-
-	if (width_out < width_in) {
-		hscale_ratio = (width_in * 10) / width_out;
-
-		switch (chan_ctx->xm2msc_dev->taps) {
-		case XSCALER_TAPS_12:
-			if (hscale_ratio > 35) {
-				*coeff = &xhsc_coeff_taps12[0][0];
-				ntaps = XSCALER_TAPS_12;
-			} else if (hscale_ratio > 25) {
-				*coeff = &xhsc_coeff_taps10[0][0];
-				ntaps = XSCALER_TAPS_10;
-			} else if (hscale_ratio > 15) {
-				*coeff = &xhsc_coeff_taps8[0][0];
-				ntaps = XSCALER_TAPS_8;
-			} else {
-				*coeff = &xhsc_coeff_taps6[0][0];
-				ntaps = XSCALER_TAPS_6;
-			}
-		break;
-		case XSCALER_TAPS_10:
-			if (hscale_ratio > 25) {
-				*coeff = &xhsc_coeff_taps10[0][0];
-				ntaps = XSCALER_TAPS_10;
-			} else if (hscale_ratio > 15) {
-				*coeff = &xhsc_coeff_taps8[0][0];
-				ntaps = XSCALER_TAPS_8;
-			} else {
-				*coeff = &xhsc_coeff_taps6[0][0];
-				ntaps = XSCALER_TAPS_6;
-			}
-		break;
-		case XSCALER_TAPS_8:
-			if (hscale_ratio > 15) {
-				*coeff = &xhsc_coeff_taps8[0][0];
-				ntaps = XSCALER_TAPS_8;
-			} else {
-				*coeff = &xhsc_coeff_taps6[0][0];
-				ntaps = XSCALER_TAPS_6;
-			}
-		break;
-		default: /* or XSCALER_TAPS_6 */
-			*coeff = &xhsc_coeff_taps6[0][0];
-			ntaps = XSCALER_TAPS_6;
-		}
-	} else {
-		/*
-		 * Scale Up Mode will always use 6 tap filter
-		 * This also includes 1:1
-		 */
-		*coeff = &xhsc_coeff_taps6[0][0];
-		ntaps = XSCALER_TAPS_6;
-	}
-
-	return ntaps;
-}
-
-static u32
-xm2msc_select_vcoeff(struct xm2msc_chan_ctx *chan_ctx, const short **coeff)
-{
-	u16 vscale_ratio;
-	u32 height_in = chan_ctx->q_data[XM2MSC_CHAN_OUT].height;
-	u32 height_out = chan_ctx->q_data[XM2MSC_CHAN_CAP].height;
-	u32 ntaps;
-
-	if (height_out < height_in) {
-		vscale_ratio = (height_in * 10) / height_out;
-
-		switch (chan_ctx->xm2msc_dev->taps) {
-		case XSCALER_TAPS_12:
-			if (vscale_ratio > 35) {
-				*coeff = &xvsc_coeff_taps12[0][0];
-				ntaps = XSCALER_TAPS_12;
-			} else if (vscale_ratio > 25) {
-				*coeff = &xvsc_coeff_taps10[0][0];
-				ntaps = XSCALER_TAPS_10;
-			} else if (vscale_ratio > 15) {
-				*coeff = &xvsc_coeff_taps8[0][0];
-				ntaps = XSCALER_TAPS_8;
-			} else {
-				*coeff = &xvsc_coeff_taps6[0][0];
-				ntaps = XSCALER_TAPS_6;
-			}
-		break;
-		case XSCALER_TAPS_10:
-			if (vscale_ratio > 25) {
-				*coeff = &xvsc_coeff_taps10[0][0];
-				ntaps = XSCALER_TAPS_10;
-			} else if (vscale_ratio > 15) {
-				*coeff = &xvsc_coeff_taps8[0][0];
-				ntaps = XSCALER_TAPS_8;
-			} else {
-				*coeff = &xvsc_coeff_taps6[0][0];
-				ntaps = XSCALER_TAPS_6;
-			}
-		break;
-		case XSCALER_TAPS_8:
-			if (vscale_ratio > 15) {
-				*coeff = &xvsc_coeff_taps8[0][0];
-				ntaps = XSCALER_TAPS_8;
-			} else {
-				*coeff = &xvsc_coeff_taps6[0][0];
-				ntaps = XSCALER_TAPS_6;
-			}
-		break;
-		default: /* or XSCALER_TAPS_6 */
-			*coeff = &xvsc_coeff_taps6[0][0];
-			ntaps = XSCALER_TAPS_6;
-		}
-	} else {
-		/*
-		 * Scale Up Mode will always use 6 tap filter
-		 * This also includes 1:1
-		 */
-		*coeff = &xvsc_coeff_taps6[0][0];
-		ntaps = XSCALER_TAPS_6;
-	}
-
-	return ntaps;
-}
-
 static void xm2mvsc_initialize_coeff_banks(struct xm2msc_chan_ctx *chan_ctx)
 {
-	const short *coeff = NULL;
-	u32 ntaps;
 	struct xm2m_msc_dev *xm2msc = chan_ctx->xm2msc_dev;
-
-	ntaps = xm2msc_select_hcoeff(chan_ctx, &coeff);
-	xm2msc_hscaler_load_ext_coeff(xm2msc, coeff, ntaps);
-	xm2msc_hscaler_set_coeff(chan_ctx, XM2MVSC_HFLTCOEFF(chan_ctx->num));
-
-	dev_dbg(xm2msc->dev, "htaps %d selected for chan %d\n",
-		ntaps, chan_ctx->num);
-
-	ntaps = xm2msc_select_vcoeff(chan_ctx, &coeff);
-	xm2msc_vscaler_load_ext_coeff(xm2msc, coeff, ntaps);
-	xm2msc_vscaler_set_coeff(chan_ctx, XM2MVSC_VFLTCOEFF(chan_ctx->num));
-
-	dev_dbg(xm2msc->dev, "vtaps %d selected for chan %d\n",
-		ntaps, chan_ctx->num);
+	struct xm2msc_q_data *out_q_data = &chan_ctx->q_data[XM2MSC_CHAN_OUT];
+	struct xm2msc_q_data *cap_q_data = &chan_ctx->q_data[XM2MSC_CHAN_CAP];
+	u32 nwords = xlnx_scaler_coeff_nwords(xm2msc->taps,
+					      XLNX_SCALER_COEFF_PHASES);
+	enum xlnx_scaler_coeff_bank bank;
+	const u32 *words;
+
+	/* The banks are only rewritten when the selected filter changes */
+	bank = xlnx_scaler_coeff_bank(out_q_data->width, cap_q_data->width);
+	words = xlnx_scaler_coeff_get(XLNX_SCALER_COEFF_MSC_H, xm2msc->taps,
+				      bank);
+	if (xlnx_scaler_coeff_load(&chan_ctx->hcoeff, xm2msc->regs +
+				   XM2MVSC_HFLTCOEFF(chan_ctx->num),
+				   words, nwords))
+		dev_dbg(xm2msc->dev, "hbank %d selected for chan %d\n",
+			bank, chan_ctx->num);
+
+	bank = xlnx_scaler_coeff_bank(out_q_data->height, cap_q_data->height);
+	words = xlnx_scaler_coeff_get(XLNX_SCALER_COEFF_MSC_V, xm2msc->taps,
+				      bank);
+	if (xlnx_scaler_coeff_load(&chan_ctx->vcoeff, xm2msc->regs +
+				   XM2MVSC_VFLTCOEFF(chan_ctx->num),
+				   words, nwords))
+		dev_dbg(xm2msc->dev, "vbank %d selected for chan %d\n",
+			bank, chan_ctx->num);
 }
 
 static int xm2msc_set_chan_params(struct xm2msc_chan_ctx *chan_ctx,
@@ -748,7 +559,6 @@ static int xm2msc_set_chan_params(struct xm2msc_chan_ctx *chan_ctx,
 {
 	struct xm2msc_q_data *q_data = get_q_data(chan_ctx, type);
 	const struct xm2msc_fmt *fmt;
-	void __iomem *base = chan_ctx->regs;
 
 	if (!q_data)
 		return -EINVAL;
@@ -756,15 +566,19 @@ static int xm2msc_set_chan_params(struct xm2msc_chan_ctx *chan_ctx,
 	fmt = q_data->fmt;
 
 	if (type == V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE) {
-		xm2msc_writereg(base + XM2MSC_WIDTHIN, q_data->width);
-		xm2msc_writereg(base + XM2MSC_HEIGHTIN, q_data->height);
-		xm2msc_writereg(base + XM2MSC_INPIXELFMT, fmt->xm2msc_fmt);
-		xm2msc_writereg(base + XM2MSC_INSTRIDE, q_data->stride);
+		xm2msc_chan_writereg(chan_ctx, XM2MSC_WIDTHIN, q_data->width);
+		xm2msc_chan_writereg(chan_ctx, XM2MSC_HEIGHTIN, q_data->height);
+		xm2msc_chan_writereg(chan_ctx, XM2MSC_INPIXELFMT,
+				     fmt->xm2msc_fmt);
+		xm2msc_chan_writereg(chan_ctx, XM2MSC_INSTRIDE, q_data->stride);
 	} else {
-		xm2msc_writereg(base + XM2MSC_WIDTHOUT, q_data->width);
-		xm2msc_writereg(base + XM2MSC_HEIGHTOUT, q_data->height);
-		xm2msc_writereg(base + XM2MSC_OUTPIXELFMT, fmt->xm2msc_fmt);
-		xm2msc_writereg(base + XM2MSC_OUTSTRIDE, q_data->stride);
+		xm2msc_chan_writereg(chan_ctx, XM2MSC_WIDTHOUT, q_data->width);
+		xm2msc_chan_writereg(chan_ctx, XM2MSC_HEIGHTOUT,
+				     q_data->height);
+		xm2msc_chan_writereg(chan_ctx, XM2MSC_OUTPIXELFMT,
+				     fmt->xm2msc_fmt);
+		xm2msc_chan_writereg(chan_ctx, XM2MSC_OUTSTRIDE,
+				     q_data->stride);
 	}
 
 	return 0;
@@ -772,7 +586,6 @@ static int xm2msc_set_chan_params(struct xm2msc_chan_ctx *chan_ctx,
 
 static void xm2msc_set_chan_com_params(struct xm2msc_chan_ctx *chan_ctx)
 {
-	void __iomem *base = chan_ctx->regs;
 	struct xm2msc_q_data *out_q_data = &chan_ctx->q_data[XM2MSC_CHAN_OUT];
 	struct xm2msc_q_data *cap_q_data = &chan_ctx->q_data[XM2MSC_CHAN_CAP];
 	u32 pixel_rate;
@@ -785,8 +598,8 @@ static void xm2msc_set_chan_com_params(struct xm2msc_chan_ctx *chan_ctx)
 	line_rate = (out_q_data->height * XM2MSC_STEP_PRECISION) /
 		cap_q_data->height;
 
-	xm2msc_writereg(base + XM2MSC_PIXELRATE, pixel_rate);
-	xm2msc_writereg(base + XM2MSC_LINERATE, line_rate);
+	xm2msc_chan_writereg(chan_ctx, XM2MSC_PIXELRATE, pixel_rate);
+	xm2msc_chan_writereg(chan_ctx, XM2MSC_LINERATE, line_rate);
 }
 
 static int xm2msc_program_allchan(struct xm2m_msc_dev *xm2msc)
@@ -1041,8 +854,17 @@ static int xm2msc_chk_fmt(struct xm2m_msc_dev *xm2msc, u32 index)
 
 static void xm2msc_reset(struct xm2m_msc_dev *xm2msc)
 {
+	unsigned int chan;
+
 	gpiod_set_value_cansleep(xm2msc->rst_gpio, XM2MSC_RESET_ASSERT);
 	gpiod_set_value_cansleep(xm2msc->rst_gpio, XM2MSC_RESET_DEASSERT);
+
+	/*
+	 * The reset clears the parameter registers, the coefficient banks
+	 * are memories and keep their content.
+	 */
+	for (chan = 0; chan < XM2MSC_MAX_CHAN; chan++)
+		xm2msc->xm2msc_chan[chan].params_valid = 0;
 }
 
 /*
@@ -1297,20 +1119,30 @@ static void xm2msc_device_run(void *priv)
 	xm2msc_writereg(base + XM2MSC_GIE, XM2MSC_GIE_EN);
 	xm2msc_writereg(base + XM2MSC_IER, XM2MSC_ISR_DONE);
 
-	xm2msc_pr_status(xm2msc, __func__);
-	xm2msc_pr_screg(xm2msc->dev, base);
-	xm2msc_pr_allchanreg(xm2msc);
+	/*
+	 * Keep running as long as every channel has a frame queued, so the
+	 * frames queued meanwhile on any channel go out in the next run
+	 * without going back through the mem2mem scheduler of each channel.
+	 */
+	do {
+		xm2msc_pr_status(xm2msc, __func__);
+		xm2msc_pr_screg(xm2msc->dev, base);
+		xm2msc_pr_allchanreg(xm2msc);
 
-	xm2msc_start(xm2msc);
+		xm2msc_start(xm2msc);
 
-	xm2msc->isr_wait = true;
-	wait_event(xm2msc->isr_finished, !xm2msc->isr_wait);
+		xm2msc->isr_wait = true;
+		wait_event(xm2msc->isr_finished, !xm2msc->isr_wait);
 
-	xm2msc_job_done(xm2msc);
+		xm2msc_job_done(xm2msc);
+	} while (xm2msc->running_chan == NUM_STREAM(xm2msc) &&
+		 !xm2msc_set_bufaddr(xm2msc));
 
 	xm2msc->device_busy = false;
 
-	if (xm2msc_alljob_ready(xm2msc))
+	/* The number of streams changed, reprogram the IP for it */
+	if (xm2msc->running_chan != NUM_STREAM(xm2msc) &&
+	    xm2msc_alljob_ready(xm2msc))
 		xm2msc_device_run(xm2msc->xm2msc_chan);
 
 	xm2msc_job_finish(xm2msc);
@@ -2273,10 +2105,8 @@ static int xm2msc_parse_of(struct platform_device *pdev,
 
 	ret = of_property_read_u32(node, "xlnx,num-taps",
 				   &xm2msc->taps);
-	if (ret || (xm2msc->taps != XSCALER_TAPS_6 &&
-		    xm2msc->taps != XSCALER_TAPS_8 &&
-		    xm2msc->taps != XSCALER_TAPS_10 &&
-		    xm2msc->taps != XSCALER_TAPS_12)) {
+	if (ret || !xlnx_scaler_coeff_get(XLNX_SCALER_COEFF_MSC_H, xm2msc->taps,
+					  XLNX_SCALER_COEFF_BANK_UP)) {
 		dev_err(dev, "missing/invalid taps in dts prop\n");
 		return -EINVAL;
 	}
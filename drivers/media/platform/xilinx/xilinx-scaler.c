@@ -18,11 +18,12 @@
  */
 
 #include <linux/device.h>
-#include <linux/fixp-arith.h>
+#include <linux/io.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
 #include <linux/slab.h>
+#include <linux/xlnx/xlnx_scaler_coeff.h>
 
 #include <media/v4l2-async.h>
 #include <media/v4l2-subdev.h>
@@ -50,19 +51,6 @@
 #define XSCALER_COEF_DATA_IN			0x0134
 #define XSCALER_COEF_DATA_IN_SHIFT		16
 
-/* Fixed point operations */
-#define FRAC_N	8
-
-static inline s16 fixp_new(s16 a)
-{
-	return a << FRAC_N;
-}
-
-static inline s16 fixp_mult(s16 a, s16 b)
-{
-	return ((s32)(a * b)) >> FRAC_N;
-}
-
 /**
  * struct xscaler_device - Xilinx Scaler device structure
  * @xvip: Xilinx Video IP device
@@ -104,106 +92,47 @@ static inline struct xscaler_device *to_scaler(struct v4l2_subdev *subdev)
  */
 
 /**
- * lanczos - Lanczos 2D FIR kernel convolution
- * @x: phase
- * @a: Lanczos kernel size
- *
- * Return: the coefficient value in fixed point format.
- */
-static s16 lanczos(s16 x, s16 a)
-{
-	s16 pi;
-	s16 numerator;
-	s16 denominator;
-	s16 temp;
-
-	if (x < -a || x > a)
-		return 0;
-	else if (x == 0)
-		return fixp_new(1);
-
-	/* a * sin(pi * x) * sin(pi * x / a) / (pi * pi * x * x) */
-
-	pi = (fixp_new(157) << FRAC_N) / fixp_new(50);
-
-	if (x < 0)
-		x = -x;
-
-	/* sin(pi * x) */
-	temp = fixp_mult(fixp_new(180), x);
-	temp = fixp_sin16(temp >> FRAC_N);
-
-	/* a * sin(pi * x) */
-	numerator = fixp_mult(temp, a);
-
-	/* sin(pi * x / a) */
-	temp = (fixp_mult(fixp_new(180), x) << FRAC_N) / a;
-	temp = fixp_sin16(temp >> FRAC_N);
-
-	/* a * sin(pi * x) * sin(pi * x / a) */
-	numerator = fixp_mult(temp, numerator);
-
-	/* pi * pi * x * x */
-	denominator = fixp_mult(pi, pi);
-	temp = fixp_mult(x, x);
-	denominator = fixp_mult(temp, denominator);
-
-	return (numerator << FRAC_N) / denominator;
-}
-
-/**
- * xscaler_set_coefs - generate and program the coefficient table
+ * xscaler_set_coefs - generate and program the coefficient tables
  * @xscaler: scaler device
- * @taps: maximum coefficient tap index
  *
- * Generate the coefficient table using Lanczos resampling, and program
- * generated coefficients to the scaler. The generated coefficients are
- * supposed to work regardless of resolutions.
+ * Generate the coefficient tables using Lanczos resampling, and program
+ * them to the scaler, horizontal then vertical, luma then chroma, as
+ * configured. Each table is generated once however many times it is
+ * programmed.
  *
- * Return: 0 if the coefficient table is programmed, and -ENOMEM if memory
- * allocation for the table fails.
+ * Return: 0 if the coefficient tables are programmed, and -ENOMEM if memory
+ * allocation for the tables fails.
  */
-static int xscaler_set_coefs(struct xscaler_device *xscaler, s16 taps)
+static int xscaler_set_coefs(struct xscaler_device *xscaler)
 {
-	s16 *coef;
-	s16 dy;
-	u32 coef_val;
-	u16 phases = xscaler->max_num_phases;
-	u16 i;
-	u16 j;
-
-	coef = kcalloc(phases, sizeof(*coef), GFP_KERNEL);
-	if (!coef)
+	void __iomem *fifo = xscaler->xvip.iomem + XSCALER_COEF_DATA_IN;
+	unsigned int nhcoef, nvcoef = 0;
+	u32 *hcoef, *vcoef = NULL;
+	unsigned int i;
+
+	hcoef = xlnx_scaler_coeff_lanczos(xscaler->num_hori_taps,
+					  xscaler->max_num_phases, &nhcoef);
+	if (!hcoef)
 		return -ENOMEM;
 
-	for (i = 0; i < phases; i++) {
-		s16 sum = 0;
-
-		dy = ((fixp_new(i) << FRAC_N) / fixp_new(phases));
-
-		/* Generate Lanczos coefficients */
-		for (j = 0; j < taps; j++) {
-			coef[j] = lanczos(fixp_new(j - (taps >> 1)) + dy,
-					  fixp_new(taps >> 1));
-			sum += coef[j];
+	if (xscaler->separate_hv_coef) {
+		vcoef = xlnx_scaler_coeff_lanczos(xscaler->num_vert_taps,
+						  xscaler->max_num_phases,
+						  &nvcoef);
+		if (!vcoef) {
+			kfree(hcoef);
+			return -ENOMEM;
 		}
+	}
 
-		/* Program coefficients */
-		for (j = 0; j < taps; j += 2) {
-			/* Normalize and multiply coefficients */
-			coef_val = (((coef[j] << FRAC_N) << (FRAC_N - 2)) /
-				    sum) & 0xffff;
-			if (j + 1 < taps)
-				coef_val |= ((((coef[j + 1] << FRAC_N) <<
-					      (FRAC_N - 2)) / sum) & 0xffff) <<
-					    16;
-
-			xvip_write(&xscaler->xvip, XSCALER_COEF_DATA_IN,
-				   coef_val);
-		}
+	for (i = 0; i < (xscaler->separate_yc_coef ? 2 : 1); i++) {
+		iowrite32_rep(fifo, hcoef, nhcoef);
+		if (vcoef)
+			iowrite32_rep(fifo, vcoef, nvcoef);
 	}
 
-	kfree(coef);
+	kfree(vcoef);
+	kfree(hcoef);
 
 	return 0;
 }
@@ -677,29 +606,10 @@ static int xscaler_probe(struct platform_device *pdev)
 
 	xvip_print_version(&xscaler->xvip);
 
-	ret = xscaler_set_coefs(xscaler, (s16)xscaler->num_hori_taps);
+	ret = xscaler_set_coefs(xscaler);
 	if (ret < 0)
 		goto error;
 
-	if (xscaler->separate_hv_coef) {
-		ret = xscaler_set_coefs(xscaler, (s16)xscaler->num_vert_taps);
-		if (ret < 0)
-			goto error;
-	}
-
-	if (xscaler->separate_yc_coef) {
-		ret = xscaler_set_coefs(xscaler, (s16)xscaler->num_hori_taps);
-		if (ret < 0)
-			goto error;
-
-		if (xscaler->separate_hv_coef) {
-			ret = xscaler_set_coefs(xscaler,
-						(s16)xscaler->num_vert_taps);
-			if (ret < 0)
-				goto error;
-		}
-	}
-
 	ret = v4l2_async_register_subdev(subdev);
 	if (ret < 0) {
 		dev_err(&pdev->dev, "failed to register subdev\n");
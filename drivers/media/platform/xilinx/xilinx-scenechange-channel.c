@@ -33,6 +33,9 @@
 #define XSCD_SCENE_CHANGE		1
 #define XSCD_NO_SCENE_CHANGE		0
 
+/* Number of batch events kept per file handle before the oldest is dropped */
+#define XSCD_BATCH_EVENTS		16
+
 /* -----------------------------------------------------------------------------
  * V4L2 Subdevice Pad Operations
  */
@@ -241,6 +244,14 @@ static int xscd_subscribe_event(struct v4l2_subdev *sd,
 	case V4L2_EVENT_XLNXSCD:
 		ret = v4l2_event_subscribe(fh, sub, 1, NULL);
 		break;
+	case V4L2_EVENT_XLNXSCD_BATCH:
+		if (!chan->xscd->batch) {
+			ret = -EINVAL;
+			break;
+		}
+
+		ret = v4l2_event_subscribe(fh, sub, XSCD_BATCH_EVENTS, NULL);
+		break;
 	default:
 		ret = -EINVAL;
 	}
@@ -326,14 +337,19 @@ static const struct media_entity_operations xscd_media_ops = {
 	.link_validate = v4l2_subdev_link_validate,
 };
 
-void xscd_chan_event_notify(struct xscd_chan *chan)
+static u32 xscd_chan_get_sad(struct xscd_chan *chan)
 {
-	u32 *eventdata;
 	u32 sad;
 
 	sad = xscd_read(chan->iomem, XSCD_SAD_OFFSET);
-	sad = (sad * XSCD_V_SUBSAMPLING * MULTIPLICATION_FACTOR) /
+	return (sad * XSCD_V_SUBSAMPLING * MULTIPLICATION_FACTOR) /
 	       (chan->format.width * chan->format.height);
+}
+
+static bool __xscd_chan_event_notify(struct xscd_chan *chan, u32 sad)
+{
+	u32 *eventdata;
+
 	eventdata = (u32 *)&chan->event.u.data;
 
 	if (sad > chan->threshold)
@@ -343,6 +359,54 @@ void xscd_chan_event_notify(struct xscd_chan *chan)
 
 	chan->event.type = V4L2_EVENT_XLNXSCD;
 	v4l2_subdev_notify_event(&chan->subdev, &chan->event);
+
+	return eventdata[0] == XSCD_SCENE_CHANGE;
+}
+
+void xscd_chan_event_notify(struct xscd_chan *chan)
+{
+	__xscd_chan_event_notify(chan, xscd_chan_get_sad(chan));
+}
+
+/**
+ * xscd_chan_batch_notify - Report the results of a run for all channels
+ * @xscd: Pointer to the SCD device structure
+ * @channels: Bitmask of the channels that took part in the run
+ *
+ * Queue the per-channel V4L2_EVENT_XLNXSCD events, and a single
+ * V4L2_EVENT_XLNXSCD_BATCH event carrying the SAD and scene change results
+ * of all the channels in @channels. The batch event is queued on the subdev
+ * of every channel in the run, so userspace can collect the results of all
+ * streams from any one of them.
+ */
+void xscd_chan_batch_notify(struct xscd_device *xscd, unsigned int channels)
+{
+	struct xscd_batch_event *batch;
+	unsigned int i;
+
+	batch = (struct xscd_batch_event *)&xscd->batch_event.u.data;
+	memset(batch, 0, sizeof(*batch));
+	batch->sequence = xscd->sequence++;
+	batch->channels = channels;
+
+	for (i = 0; i < xscd->num_streams; i++) {
+		struct xscd_chan *chan = &xscd->chans[i];
+
+		if (!(channels & BIT(i)))
+			continue;
+
+		batch->sad[i] = xscd_chan_get_sad(chan);
+		if (__xscd_chan_event_notify(chan, batch->sad[i]))
+			batch->scene_change |= BIT(i);
+	}
+
+	xscd->batch_event.type = V4L2_EVENT_XLNXSCD_BATCH;
+
+	for (i = 0; i < xscd->num_streams; i++) {
+		if (channels & BIT(i))
+			v4l2_subdev_notify_event(&xscd->chans[i].subdev,
+						 &xscd->batch_event);
+	}
 }
 
 /**
@@ -77,6 +77,32 @@ static int xscd_dma_setup_channel(struct xscd_dma_chan *chan)
 	return 1;
 }
 
+/**
+ * xscd_dma_batch_ready - Check if all enabled channels have buffers queued
+ * @xscd: The SCD device
+ *
+ * Return: true if no enabled channel is waiting for a buffer
+ */
+static bool xscd_dma_batch_ready(struct xscd_device *xscd)
+{
+	unsigned int i;
+
+	for (i = 0; i < xscd->num_streams; i++) {
+		struct xscd_dma_chan *chan = xscd->channels[i];
+		unsigned long flags;
+		bool waiting;
+
+		spin_lock_irqsave(&chan->lock, flags);
+		waiting = chan->enabled && list_empty(&chan->pending_list);
+		spin_unlock_irqrestore(&chan->lock, flags);
+
+		if (waiting)
+			return false;
+	}
+
+	return true;
+}
+
 /**
  * xscd_dma_kick - Start a run of the SCD core if channels are ready
  * @xscd: The SCD device
@@ -86,6 +112,7 @@ static int xscd_dma_setup_channel(struct xscd_dma_chan *chan)
  *
  * - The SCD is not currently running
  * - At least one channel is enabled and has buffers available
+ * - In batch mode, all enabled channels have buffers available
  *
  * It can be used to start the SCD when a buffer is queued, when a channel
  * starts streaming, or to start the next run. Calling this function is only
@@ -100,12 +127,15 @@ static void xscd_dma_kick(struct xscd_device *xscd)
 {
 	unsigned int channels = 0;
 	unsigned int i;
+	bool ready;
 
 	lockdep_assert_held(&xscd->lock);
 
 	if (xscd->running)
 		return;
 
+	ready = !xscd->batch || xscd_dma_batch_ready(xscd);
+
 	for (i = 0; i < xscd->num_streams; i++) {
 		struct xscd_dma_chan *chan = xscd->channels[i];
 		unsigned long flags;
@@ -113,7 +143,7 @@ static void xscd_dma_kick(struct xscd_device *xscd)
 		bool stopped;
 
 		spin_lock_irqsave(&chan->lock, flags);
-		running = xscd_dma_setup_channel(chan);
+		running = ready ? xscd_dma_setup_channel(chan) : 0;
 		stopped = chan->running && !running;
 		chan->running = running;
 		spin_unlock_irqrestore(&chan->lock, flags);
@@ -182,6 +212,7 @@ void xscd_dma_enable_channel(struct xscd_dma_chan *chan, bool enable)
  */
 void xscd_dma_irq_handler(struct xscd_device *xscd)
 {
+	unsigned int channels = 0;
 	unsigned int i;
 
 	/*
@@ -196,7 +227,10 @@ void xscd_dma_irq_handler(struct xscd_device *xscd)
 			continue;
 
 		dma_cookie_complete(&desc->async_tx);
-		xscd_chan_event_notify(&xscd->chans[i]);
+		if (xscd->batch)
+			channels |= BIT(i);
+		else
+			xscd_chan_event_notify(&xscd->chans[i]);
 
 		spin_lock(&chan->lock);
 		list_add_tail(&desc->node, &chan->done_list);
@@ -206,6 +240,9 @@ void xscd_dma_irq_handler(struct xscd_device *xscd)
 		tasklet_schedule(&chan->tasklet);
 	}
 
+	if (channels)
+		xscd_chan_batch_notify(xscd, channels);
+
 	/* Start the next run, if any. */
 	spin_lock(&xscd->lock);
 	xscd->running = false;
@@ -362,12 +399,23 @@ static bool xscd_dma_is_running(struct xscd_dma_chan *chan)
 static int xscd_dma_terminate_all(struct dma_chan *dchan)
 {
 	struct xscd_dma_chan *chan = to_xscd_dma_chan(dchan);
+	struct xscd_device *xscd = chan->xscd;
 	int ret;
 
 	spin_lock_irq(&chan->lock);
 	chan->enabled = false;
 	spin_unlock_irq(&chan->lock);
 
+	/*
+	 * In batch mode the other channels may be held back waiting for a
+	 * buffer on this one, restart them.
+	 */
+	if (xscd->batch) {
+		spin_lock_irq(&xscd->lock);
+		xscd_dma_kick(xscd);
+		spin_unlock_irq(&xscd->lock);
+	}
+
 	/* Wait for any on-going transfer to complete. */
 	ret = wait_event_timeout(chan->wait, !xscd_dma_is_running(chan),
 				 msecs_to_jiffies(100));
@@ -17,6 +17,11 @@
 
 #include "xilinx-scenechange.h"
 
+static bool batch;
+module_param(batch, bool, 0444);
+MODULE_PARM_DESC(batch,
+		 "Run all enabled streams together in memory-based mode");
+
 static irqreturn_t xscd_irq_handler(int irq, void *data)
 {
 	struct xscd_device *xscd = (struct xscd_device *)data;
@@ -85,6 +90,14 @@ static int xscd_parse_of(struct xscd_device *xscd)
 		return -EINVAL;
 	}
 
+	if (xscd->num_streams > XSCD_MAX_CHANNELS) {
+		dev_err(dev, "Too many streams, up to %u supported\n",
+			XSCD_MAX_CHANNELS);
+		return -EINVAL;
+	}
+
+	xscd->batch = batch && xscd->memory_based;
+
 	return 0;
 }
 
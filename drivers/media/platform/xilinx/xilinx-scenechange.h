@@ -182,12 +182,15 @@ static inline struct xscd_chan *to_xscd_chan(struct v4l2_subdev *subdev)
  * @clk: video core clock
  * @irq: Device IRQ
  * @memory_based: Flag to identify memory based mode
+ * @batch: Start runs only when all enabled channels have a buffer queued
  * @num_streams: Number of streams in the design
  * @chans: video stream instances
  * @dma_device: DMA device structure
  * @channels: DMA channels
  * @lock: Protects the running field
  * @running: True when the SCD core is running
+ * @sequence: Number of runs completed, reported in batch events
+ * @batch_event: batch scene change event
  */
 struct xscd_device {
 	struct device *dev;
@@ -197,6 +200,7 @@ struct xscd_device {
 	int irq;
 
 	u8 memory_based;
+	u8 batch;
 	int num_streams;
 
 	struct xscd_chan *chans;
@@ -207,6 +211,9 @@ struct xscd_device {
 	/* This lock is to protect the running field */
 	spinlock_t lock;
 	u8 running;
+
+	u32 sequence;
+	struct v4l2_event batch_event;
 };
 
 /*
@@ -238,6 +245,7 @@ int xscd_dma_init(struct xscd_device *xscd);
 void xscd_dma_cleanup(struct xscd_device *xscd);
 
 void xscd_chan_event_notify(struct xscd_chan *chan);
+void xscd_chan_batch_notify(struct xscd_device *xscd, unsigned int channels);
 int xscd_chan_init(struct xscd_device *xscd, unsigned int chan_id,
 		   struct device_node *node);
 void xscd_chan_cleanup(struct xscd_device *xscd, unsigned int chan_id,
@@ -9,6 +9,7 @@
  *           Laurent Pinchart <laurent.pinchart@ideasonboard.com>
  */
 
+#include <linux/debugfs.h>
 #include <linux/list.h>
 #include <linux/module.h>
 #include <linux/of.h>
@@ -803,6 +804,31 @@ static int xvip_composite_v4l2_init(struct xvip_composite_device *xdev)
  * Platform Device Driver
  */
 
+/*
+ * Writing to log_status makes every sub-device of the pipeline log its
+ * status, as VIDIOC_LOG_STATUS does, including the error and overflow
+ * counters kept by the receivers.
+ */
+static ssize_t xvip_log_status_write(struct file *file,
+				     const char __user *buf, size_t count,
+				     loff_t *ppos)
+{
+	struct xvip_composite_device *xdev = file->private_data;
+
+	v4l2_info(&xdev->v4l2_dev, "=================  START STATUS  =================\n");
+	v4l2_device_call_all(&xdev->v4l2_dev, 0, core, log_status);
+	v4l2_info(&xdev->v4l2_dev, "==================  END STATUS  ==================\n");
+
+	return count;
+}
+
+static const struct file_operations xvip_log_status_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.write = xvip_log_status_write,
+	.llseek = noop_llseek,
+};
+
 static int xvip_composite_probe(struct platform_device *pdev)
 {
 	struct xvip_composite_device *xdev;
@@ -817,9 +843,15 @@ static int xvip_composite_probe(struct platform_device *pdev)
 	INIT_LIST_HEAD(&xdev->dmas);
 	v4l2_async_nf_init(&xdev->notifier);
 
+	xdev->debugfs = debugfs_create_dir(dev_name(xdev->dev), NULL);
+	debugfs_create_file("log_status", 0200, xdev->debugfs, xdev,
+			    &xvip_log_status_fops);
+
 	ret = xvip_composite_v4l2_init(xdev);
-	if (ret < 0)
+	if (ret < 0) {
+		debugfs_remove_recursive(xdev->debugfs);
 		return ret;
+	}
 
 	ret = xvip_graph_init(xdev);
 	if (ret < 0)
@@ -845,6 +877,7 @@ static int xvip_composite_probe(struct platform_device *pdev)
 
 error:
 	xvip_composite_v4l2_cleanup(xdev);
+	debugfs_remove_recursive(xdev->debugfs);
 	return ret;
 }
 
@@ -855,6 +888,7 @@ static int xvip_composite_remove(struct platform_device *pdev)
 	mutex_destroy(&xdev->lock);
 	xvip_graph_cleanup(xdev);
 	xvip_composite_v4l2_cleanup(xdev);
+	debugfs_remove_recursive(xdev->debugfs);
 
 	return 0;
 }
@@ -30,6 +30,7 @@
  * @lock: This is to ensure all dma path entities acquire same pipeline object
  * @atomic_streamon: Indicates that multi dma media pipe will get enabled
  *  with single dma start
+ * @debugfs: debugfs directory of the pipeline statistics
  */
 struct xvip_composite_device {
 	struct v4l2_device v4l2_dev;
@@ -42,6 +43,7 @@ struct xvip_composite_device {
 	u32 v4l2_caps;
 	struct mutex lock; /* lock to protect xvip pipeline instance */
 	bool atomic_streamon;
+	struct dentry *debugfs;
 };
 
 int xvip_graph_pipeline_start_stop(struct xvip_composite_device *xdev,
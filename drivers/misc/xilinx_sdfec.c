@@ -20,7 +20,10 @@
 #include <linux/slab.h>
 #include <linux/clk.h>
 #include <linux/compat.h>
-#include <linux/highmem.h>
+#include <linux/dma-buf.h>
+#include <linux/dmaengine.h>
+#include <linux/mutex.h>
+#include <linux/xarray.h>
 
 #include <uapi/misc/xilinx_sdfec.h>
 
@@ -161,8 +164,10 @@ static DEFINE_IDA(dev_nrs);
 #define XSDFEC_LDPC_REG_JUMP (0x10)
 #define XSDFEC_REG_WIDTH_JUMP (4)
 
-/* The maximum number of pinned pages */
-#define MAX_NUM_PAGES ((XSDFEC_QC_TABLE_DEPTH / PAGE_SIZE) + 1)
+/* Number of LDPC code register slots */
+#define XSDFEC_LDPC_CODES_MAX                                                  \
+	((XSDFEC_LDPC_CODE_REG0_ADDR_HIGH - XSDFEC_LDPC_CODE_REG0_ADDR_BASE) / \
+	 XSDFEC_LDPC_REG_JUMP + 1)
 
 /**
  * struct xsdfec_clks - For managing SD-FEC clocks
@@ -186,6 +191,105 @@ struct xsdfec_clks {
 	struct clk *status_clk;
 };
 
+/**
+ * struct xsdfec_table - Shadow of an LDPC table memory in the SD-FEC core
+ * @base: Register offset of the table
+ * @depth: Number of 32-bit words in the table
+ * @shadow: Last value written to each word
+ * @valid: Words of @shadow known to match the core
+ */
+struct xsdfec_table {
+	u32 base;
+	u32 depth;
+	u32 *shadow;
+	unsigned long *valid;
+};
+
+/**
+ * struct xsdfec_ldpc_code - Cached LDPC code
+ * @params: Code parameters, with the user table pointers cleared
+ * @sc_table: Kernel copy of the SC table
+ * @la_table: Kernel copy of the LA table
+ * @qc_table: Kernel copy of the QC table
+ * @sc_len: Number of words in @sc_table
+ * @la_len: Number of words in @la_table
+ * @qc_len: Number of words in @qc_table
+ * @loaded: Code registers have been written to the core
+ */
+struct xsdfec_ldpc_code {
+	struct xsdfec_ldpc_params params;
+	u32 *sc_table;
+	u32 *la_table;
+	u32 *qc_table;
+	u32 sc_len;
+	u32 la_len;
+	u32 qc_len;
+	bool loaded;
+};
+
+/* Number of jobs that can be queued or waiting to be collected */
+#define XSDFEC_JOBS_MAX (256)
+
+/**
+ * enum xsdfec_dma_chan - DMA channels attached to the SD-FEC streams
+ * @XSDFEC_DMA_DIN: DIN AXI4-Stream
+ * @XSDFEC_DMA_DOUT: DOUT AXI4-Stream
+ * @XSDFEC_DMA_CTRL: CTRL AXI4-Stream
+ * @XSDFEC_DMA_STATUS: STATUS AXI4-Stream
+ * @XSDFEC_DMA_NR: Number of channels
+ */
+enum xsdfec_dma_chan {
+	XSDFEC_DMA_DIN,
+	XSDFEC_DMA_DOUT,
+	XSDFEC_DMA_CTRL,
+	XSDFEC_DMA_STATUS,
+	XSDFEC_DMA_NR,
+};
+
+/**
+ * struct xsdfec_dmabuf - dma-buf mapped for one of the data channels
+ * @ref: Reference count, shared by the jobs using the mapping
+ * @dmabuf: The dma-buf
+ * @attach: Attachment to the DMA channel device
+ * @sgt: Mapped scatterlist
+ * @dir: Mapping direction
+ */
+struct xsdfec_dmabuf {
+	struct kref ref;
+	struct dma_buf *dmabuf;
+	struct dma_buf_attachment *attach;
+	struct sg_table *sgt;
+	enum dma_data_direction dir;
+};
+
+struct xsdfec_dev;
+
+/**
+ * struct xsdfec_job_entry - Queued code block
+ * @node: Entry in the device job list
+ * @xsdfec: Owning device
+ * @user_data: Value returned to userspace on completion
+ * @slot: Index of the control and status words
+ * @pending: Transfers that have not completed yet
+ * @result: 0 or the first error seen on the transfers
+ * @din: Input dma-buf mapping
+ * @dout: Output dma-buf mapping
+ * @din_sgt: Input range of @din
+ * @dout_sgt: Output range of @dout
+ */
+struct xsdfec_job_entry {
+	struct list_head node;
+	struct xsdfec_dev *xsdfec;
+	u64 user_data;
+	u32 slot;
+	int pending;
+	int result;
+	struct xsdfec_dmabuf *din;
+	struct xsdfec_dmabuf *dout;
+	struct sg_table din_sgt;
+	struct sg_table dout_sgt;
+};
+
 /**
  * struct xsdfec_dev - Driver data for SDFEC
  * @miscdev: Misc device handle
@@ -206,6 +310,22 @@ struct xsdfec_clks {
  * @state_updated: indicates State updated by interrupt handler
  * @stats_updated: indicates Stats updated by interrupt handler
  * @intr_enabled: indicates IRQ enabled
+ * @code_lock: Serializes access to the LDPC code cache and tables
+ * @codes: LDPC code cache, indexed by code_id
+ * @sc: Shadow of the SC table
+ * @la: Shadow of the LA table
+ * @qc: Shadow of the QC table
+ * @active_code: code_id of the last added or selected LDPC code
+ * @chans: DMA channels for the job queue, NULL when not described
+ * @ctrl_words: Control words of the queued jobs
+ * @ctrl_dma: DMA address of @ctrl_words
+ * @status_words: Status words of the queued jobs
+ * @status_dma: DMA address of @status_words
+ * @job_mutex: Serializes job submission, collection and cancellation
+ * @job_lock: Protects @jobs and the job completion state
+ * @jobs: Queued and completed jobs in submission order
+ * @job_head: Number of jobs submitted
+ * @job_tail: Number of jobs collected
  *
  * This structure contains necessary state for SDFEC driver to operate
  */
@@ -229,6 +349,25 @@ struct xsdfec_dev {
 	bool state_updated;
 	bool stats_updated;
 	bool intr_enabled;
+	/* Mutex to protect the LDPC code cache and table shadows */
+	struct mutex code_lock;
+	struct xarray codes;
+	struct xsdfec_table sc;
+	struct xsdfec_table la;
+	struct xsdfec_table qc;
+	u32 active_code;
+	struct dma_chan *chans[XSDFEC_DMA_NR];
+	u32 *ctrl_words;
+	dma_addr_t ctrl_dma;
+	u32 *status_words;
+	dma_addr_t status_dma;
+	/* Mutex to serialize job submission and collection */
+	struct mutex job_mutex;
+	/* Spinlock to protect the job list against DMA callbacks */
+	spinlock_t job_lock;
+	struct list_head jobs;
+	u32 job_head;
+	u32 job_tail;
 };
 
 static inline void xsdfec_regwrite(struct xsdfec_dev *xsdfec, u32 addr,
@@ -597,96 +736,211 @@ static int xsdfec_reg3_write(struct xsdfec_dev *xsdfec, u8 sc_off, u8 la_off,
 	return 0;
 }
 
-static int xsdfec_table_write(struct xsdfec_dev *xsdfec, u32 offset,
-			      u32 *src_ptr, u32 len, const u32 base_addr,
-			      const u32 depth)
+static int xsdfec_table_check(struct xsdfec_dev *xsdfec,
+			      struct xsdfec_table *table, u32 offset, u32 len)
 {
-	u32 reg = 0;
-	int res, i, nr_pages;
-	u32 n;
-	u32 *addr = NULL;
-	struct page *pages[MAX_NUM_PAGES];
-
 	/*
 	 * Writes that go beyond the length of
-	 * Shared Scale(SC) table should fail
+	 * the table should fail
 	 */
-	if (offset > depth / XSDFEC_REG_WIDTH_JUMP ||
-	    len > depth / XSDFEC_REG_WIDTH_JUMP ||
-	    offset + len > depth / XSDFEC_REG_WIDTH_JUMP) {
-		dev_dbg(xsdfec->dev, "Write exceeds SC table length");
+	if (offset > table->depth || len > table->depth ||
+	    offset + len > table->depth) {
+		dev_dbg(xsdfec->dev, "Write exceeds table length");
 		return -EINVAL;
 	}
+	return 0;
+}
 
-	n = (len * XSDFEC_REG_WIDTH_JUMP) / PAGE_SIZE;
-	if ((len * XSDFEC_REG_WIDTH_JUMP) % PAGE_SIZE)
-		n += 1;
-
-	if (WARN_ON_ONCE(n > INT_MAX))
-		return -EINVAL;
-
-	nr_pages = n;
-
-	res = pin_user_pages_fast((unsigned long)src_ptr, nr_pages, 0, pages);
-	if (res < nr_pages) {
-		if (res > 0)
-			unpin_user_pages(pages, res);
+static bool xsdfec_table_match(struct xsdfec_table *table, u32 offset,
+			       const u32 *src, u32 len)
+{
+	u32 i;
 
-		return -EINVAL;
+	for (i = 0; i < len; i++) {
+		if (!test_bit(offset + i, table->valid) ||
+		    table->shadow[offset + i] != src[i])
+			return false;
 	}
+	return true;
+}
 
-	for (i = 0; i < nr_pages; i++) {
-		addr = kmap_local_page(pages[i]);
-		do {
-			xsdfec_regwrite(xsdfec,
-					base_addr + ((offset + reg) *
-						     XSDFEC_REG_WIDTH_JUMP),
-					addr[reg]);
-			reg++;
-		} while ((reg < len) &&
-			 ((reg * XSDFEC_REG_WIDTH_JUMP) % PAGE_SIZE));
-		kunmap_local(addr);
-		unpin_user_page(pages[i]);
+static void xsdfec_table_write(struct xsdfec_dev *xsdfec,
+			       struct xsdfec_table *table, u32 offset,
+			       const u32 *src, u32 len)
+{
+	u32 i, reg;
+
+	/* Only touch the words that differ from what the core holds */
+	for (i = 0; i < len; i++) {
+		reg = offset + i;
+		if (test_bit(reg, table->valid) && table->shadow[reg] == src[i])
+			continue;
+		xsdfec_regwrite(xsdfec,
+				table->base + reg * XSDFEC_REG_WIDTH_JUMP,
+				src[i]);
+		table->shadow[reg] = src[i];
+		set_bit(reg, table->valid);
 	}
-	return 0;
 }
 
-static int xsdfec_add_ldpc(struct xsdfec_dev *xsdfec, void __user *arg)
+static int xsdfec_table_init(struct xsdfec_dev *xsdfec,
+			     struct xsdfec_table *table, u32 base, u32 depth)
 {
-	struct xsdfec_ldpc_params *ldpc;
-	int ret, n;
+	table->base = base;
+	table->depth = depth / XSDFEC_REG_WIDTH_JUMP;
+	table->shadow = devm_kcalloc(xsdfec->dev, table->depth,
+				     sizeof(*table->shadow), GFP_KERNEL);
+	table->valid = devm_bitmap_zalloc(xsdfec->dev, table->depth,
+					  GFP_KERNEL);
+	if (!table->shadow || !table->valid)
+		return -ENOMEM;
+	return 0;
+}
 
-	ldpc = memdup_user(arg, sizeof(*ldpc));
-	if (IS_ERR(ldpc))
-		return PTR_ERR(ldpc);
+static void xsdfec_ldpc_code_free(struct xsdfec_ldpc_code *code)
+{
+	if (code) {
+		kvfree(code->sc_table);
+		kfree(code);
+	}
+}
 
-	if (xsdfec->config.code == XSDFEC_TURBO_CODE) {
-		ret = -EIO;
-		goto err_out;
+static struct xsdfec_ldpc_code *
+xsdfec_ldpc_code_create(struct xsdfec_dev *xsdfec,
+			const struct xsdfec_ldpc_params *ldpc)
+{
+	struct xsdfec_ldpc_code *code;
+	u32 sc_len, la_len, qc_len;
+	int ret;
+
+	if (ldpc->code_id >= XSDFEC_LDPC_CODES_MAX) {
+		dev_dbg(xsdfec->dev, "LDPC code_id %u out of range",
+			ldpc->code_id);
+		return ERR_PTR(-EINVAL);
 	}
 
-	/* Verify Device has not started */
-	if (xsdfec->state == XSDFEC_STARTED) {
-		ret = -EIO;
+	sc_len = DIV_ROUND_UP(ldpc->nlayers, 4);
+	la_len = ldpc->nlayers;
+	qc_len = ldpc->nqc;
+
+	ret = xsdfec_table_check(xsdfec, &xsdfec->sc, ldpc->sc_off, sc_len);
+	if (!ret)
+		ret = xsdfec_table_check(xsdfec, &xsdfec->la,
+					 4 * ldpc->la_off, la_len);
+	if (!ret)
+		ret = xsdfec_table_check(xsdfec, &xsdfec->qc,
+					 4 * ldpc->qc_off, qc_len);
+	if (ret)
+		return ERR_PTR(ret);
+
+	code = kzalloc(sizeof(*code), GFP_KERNEL);
+	if (!code)
+		return ERR_PTR(-ENOMEM);
+
+	code->params = *ldpc;
+	code->params.sc_table = NULL;
+	code->params.la_table = NULL;
+	code->params.qc_table = NULL;
+	code->sc_len = sc_len;
+	code->la_len = la_len;
+	code->qc_len = qc_len;
+
+	/* All three tables share one allocation */
+	code->sc_table = kvmalloc_array(sc_len + la_len + qc_len,
+					sizeof(u32), GFP_KERNEL);
+	if (!code->sc_table) {
+		ret = -ENOMEM;
 		goto err_out;
 	}
-
-	if (xsdfec->config.code_wr_protect) {
-		ret = -EIO;
+	code->la_table = code->sc_table + sc_len;
+	code->qc_table = code->la_table + la_len;
+
+	if (copy_from_user(code->sc_table, (void __user *)ldpc->sc_table,
+			   sc_len * sizeof(u32)) ||
+	    copy_from_user(code->la_table, (void __user *)ldpc->la_table,
+			   la_len * sizeof(u32)) ||
+	    copy_from_user(code->qc_table, (void __user *)ldpc->qc_table,
+			   qc_len * sizeof(u32))) {
+		ret = -EFAULT;
 		goto err_out;
 	}
 
+	return code;
+
+err_out:
+	xsdfec_ldpc_code_free(code);
+	return ERR_PTR(ret);
+}
+
+static bool xsdfec_ldpc_code_equal(const struct xsdfec_ldpc_code *a,
+				   const struct xsdfec_ldpc_code *b)
+{
+	/* The u32 parameters come first and carry no padding */
+	return !memcmp(&a->params, &b->params,
+		       offsetof(struct xsdfec_ldpc_params, sc_table)) &&
+	       a->sc_len == b->sc_len && a->la_len == b->la_len &&
+	       a->qc_len == b->qc_len &&
+	       !memcmp(a->sc_table, b->sc_table,
+		       (a->sc_len + a->la_len + a->qc_len) * sizeof(u32));
+}
+
+static bool xsdfec_ldpc_code_resident(struct xsdfec_dev *xsdfec,
+				      struct xsdfec_ldpc_code *code)
+{
+	const struct xsdfec_ldpc_params *ldpc = &code->params;
+
+	/*
+	 * The tables are shared between codes, so a code stays resident
+	 * only as long as nobody has written different words over its
+	 * table ranges since it was loaded.
+	 */
+	return code->loaded &&
+	       xsdfec_table_match(&xsdfec->sc, ldpc->sc_off, code->sc_table,
+				  code->sc_len) &&
+	       xsdfec_table_match(&xsdfec->la, 4 * ldpc->la_off,
+				  code->la_table, code->la_len) &&
+	       xsdfec_table_match(&xsdfec->qc, 4 * ldpc->qc_off,
+				  code->qc_table, code->qc_len);
+}
+
+static int xsdfec_ldpc_writable(struct xsdfec_dev *xsdfec)
+{
+	if (xsdfec->config.code == XSDFEC_TURBO_CODE)
+		return -EIO;
+
+	/* Verify Device has not started */
+	if (xsdfec->state == XSDFEC_STARTED)
+		return -EIO;
+
+	if (xsdfec->config.code_wr_protect)
+		return -EIO;
+
+	return 0;
+}
+
+static int xsdfec_ldpc_code_load(struct xsdfec_dev *xsdfec,
+				 struct xsdfec_ldpc_code *code)
+{
+	const struct xsdfec_ldpc_params *ldpc = &code->params;
+	int ret;
+
+	ret = xsdfec_ldpc_writable(xsdfec);
+	if (ret)
+		return ret;
+
+	code->loaded = false;
+
 	/* Write Reg 0 */
 	ret = xsdfec_reg0_write(xsdfec, ldpc->n, ldpc->k, ldpc->psize,
 				ldpc->code_id);
 	if (ret)
-		goto err_out;
+		return ret;
 
 	/* Write Reg 1 */
 	ret = xsdfec_reg1_write(xsdfec, ldpc->psize, ldpc->no_packing, ldpc->nm,
 				ldpc->code_id);
 	if (ret)
-		goto err_out;
+		return ret;
 
 	/* Write Reg 2 */
 	ret = xsdfec_reg2_write(xsdfec, ldpc->nlayers, ldpc->nmqc,
@@ -694,39 +948,170 @@ static int xsdfec_add_ldpc(struct xsdfec_dev *xsdfec, void __user *arg)
 				ldpc->no_final_parity, ldpc->max_schedule,
 				ldpc->code_id);
 	if (ret)
-		goto err_out;
+		return ret;
 
 	/* Write Reg 3 */
 	ret = xsdfec_reg3_write(xsdfec, ldpc->sc_off, ldpc->la_off,
 				ldpc->qc_off, ldpc->code_id);
 	if (ret)
-		goto err_out;
+		return ret;
 
 	/* Write Shared Codes */
-	n = ldpc->nlayers / 4;
-	if (ldpc->nlayers % 4)
-		n++;
-
-	ret = xsdfec_table_write(xsdfec, ldpc->sc_off, ldpc->sc_table, n,
-				 XSDFEC_LDPC_SC_TABLE_ADDR_BASE,
-				 XSDFEC_SC_TABLE_DEPTH);
-	if (ret < 0)
-		goto err_out;
+	xsdfec_table_write(xsdfec, &xsdfec->sc, ldpc->sc_off, code->sc_table,
+			   code->sc_len);
+	xsdfec_table_write(xsdfec, &xsdfec->la, 4 * ldpc->la_off,
+			   code->la_table, code->la_len);
+	xsdfec_table_write(xsdfec, &xsdfec->qc, 4 * ldpc->qc_off,
+			   code->qc_table, code->qc_len);
+
+	code->loaded = true;
+	return 0;
+}
 
-	ret = xsdfec_table_write(xsdfec, 4 * ldpc->la_off, ldpc->la_table,
-				 ldpc->nlayers, XSDFEC_LDPC_LA_TABLE_ADDR_BASE,
-				 XSDFEC_LA_TABLE_DEPTH);
-	if (ret < 0)
-		goto err_out;
+static int xsdfec_ldpc_code_add(struct xsdfec_dev *xsdfec,
+				const struct xsdfec_ldpc_params *ldpc)
+{
+	struct xsdfec_ldpc_code *code, *old;
+	int ret;
+
+	lockdep_assert_held(&xsdfec->code_lock);
+
+	ret = xsdfec_ldpc_writable(xsdfec);
+	if (ret)
+		return ret;
+
+	code = xsdfec_ldpc_code_create(xsdfec, ldpc);
+	if (IS_ERR(code))
+		return PTR_ERR(code);
+
+	old = xa_load(&xsdfec->codes, ldpc->code_id);
+	if (old && xsdfec_ldpc_code_equal(old, code)) {
+		/* Same code again, keep the cached copy */
+		xsdfec_ldpc_code_free(code);
+		code = old;
+	} else {
+		old = xa_store(&xsdfec->codes, ldpc->code_id, code, GFP_KERNEL);
+		if (xa_is_err(old)) {
+			xsdfec_ldpc_code_free(code);
+			return xa_err(old);
+		}
+		xsdfec_ldpc_code_free(old);
+	}
+
+	if (!xsdfec_ldpc_code_resident(xsdfec, code)) {
+		ret = xsdfec_ldpc_code_load(xsdfec, code);
+		if (ret)
+			return ret;
+	}
+
+	xsdfec->active_code = ldpc->code_id;
+	return 0;
+}
+
+static void xsdfec_ldpc_codes_flush(struct xsdfec_dev *xsdfec)
+{
+	struct xsdfec_ldpc_code *code;
+	unsigned long code_id;
+
+	xa_for_each(&xsdfec->codes, code_id, code) {
+		xa_erase(&xsdfec->codes, code_id);
+		xsdfec_ldpc_code_free(code);
+	}
+	xa_destroy(&xsdfec->codes);
+}
+
+static void xsdfec_ldpc_codes_invalidate(struct xsdfec_dev *xsdfec)
+{
+	struct xsdfec_ldpc_code *code;
+	unsigned long code_id;
+
+	mutex_lock(&xsdfec->code_lock);
+	xa_for_each(&xsdfec->codes, code_id, code)
+		code->loaded = false;
+	bitmap_zero(xsdfec->sc.valid, xsdfec->sc.depth);
+	bitmap_zero(xsdfec->la.valid, xsdfec->la.depth);
+	bitmap_zero(xsdfec->qc.valid, xsdfec->qc.depth);
+	mutex_unlock(&xsdfec->code_lock);
+}
+
+static int xsdfec_add_ldpc(struct xsdfec_dev *xsdfec, void __user *arg)
+{
+	struct xsdfec_ldpc_params *ldpc;
+	int ret;
+
+	ldpc = memdup_user(arg, sizeof(*ldpc));
+	if (IS_ERR(ldpc))
+		return PTR_ERR(ldpc);
+
+	mutex_lock(&xsdfec->code_lock);
+	ret = xsdfec_ldpc_code_add(xsdfec, ldpc);
+	mutex_unlock(&xsdfec->code_lock);
 
-	ret = xsdfec_table_write(xsdfec, 4 * ldpc->qc_off, ldpc->qc_table,
-				 ldpc->nqc, XSDFEC_LDPC_QC_TABLE_ADDR_BASE,
-				 XSDFEC_QC_TABLE_DEPTH);
-err_out:
 	kfree(ldpc);
 	return ret;
 }
 
+static int xsdfec_add_ldpc_batch(struct xsdfec_dev *xsdfec, void __user *arg)
+{
+	struct xsdfec_ldpc_batch batch;
+	struct xsdfec_ldpc_params __user *uparams;
+	struct xsdfec_ldpc_params ldpc;
+	int ret = 0;
+
+	if (copy_from_user(&batch, arg, sizeof(batch)))
+		return -EFAULT;
+
+	uparams = u64_to_user_ptr(batch.params);
+
+	mutex_lock(&xsdfec->code_lock);
+	for (batch.done = 0; batch.done < batch.count; batch.done++) {
+		if (copy_from_user(&ldpc, &uparams[batch.done], sizeof(ldpc))) {
+			ret = -EFAULT;
+			break;
+		}
+		ret = xsdfec_ldpc_code_add(xsdfec, &ldpc);
+		if (ret)
+			break;
+	}
+	mutex_unlock(&xsdfec->code_lock);
+
+	if (copy_to_user(arg, &batch, sizeof(batch)))
+		return -EFAULT;
+
+	return ret;
+}
+
+static int xsdfec_select_ldpc(struct xsdfec_dev *xsdfec, void __user *arg)
+{
+	struct xsdfec_ldpc_code *code;
+	u32 code_id;
+	int ret = 0;
+
+	if (get_user(code_id, (u32 __user *)arg))
+		return -EFAULT;
+
+	if (xsdfec->config.code == XSDFEC_TURBO_CODE)
+		return -EIO;
+
+	mutex_lock(&xsdfec->code_lock);
+	code = xa_load(&xsdfec->codes, code_id);
+	if (!code) {
+		ret = -ENOENT;
+		goto out_unlock;
+	}
+
+	if (!xsdfec_ldpc_code_resident(xsdfec, code)) {
+		ret = xsdfec_ldpc_code_load(xsdfec, code);
+		if (ret)
+			goto out_unlock;
+	}
+
+	xsdfec->active_code = code_id;
+out_unlock:
+	mutex_unlock(&xsdfec->code_lock);
+	return ret;
+}
+
 static int xsdfec_set_order(struct xsdfec_dev *xsdfec, void __user *arg)
 {
 	bool order_invalid;
@@ -931,12 +1316,526 @@ static int xsdfec_get_stats(struct xsdfec_dev *xsdfec, void __user *arg)
 	return err;
 }
 
+static void xsdfec_dmabuf_release(struct kref *ref)
+{
+	struct xsdfec_dmabuf *buf = container_of(ref, struct xsdfec_dmabuf,
+						 ref);
+
+	dma_buf_unmap_attachment(buf->attach, buf->sgt, buf->dir);
+	dma_buf_detach(buf->dmabuf, buf->attach);
+	dma_buf_put(buf->dmabuf);
+	kfree(buf);
+}
+
+static void xsdfec_dmabuf_put(struct xsdfec_dmabuf *buf)
+{
+	if (buf)
+		kref_put(&buf->ref, xsdfec_dmabuf_release);
+}
+
+/*
+ * Map the dma-buf behind @fd for @chan, reusing @last when consecutive
+ * jobs point into the same buffer, as they do when a whole TTI is packed
+ * into one dma-buf.
+ */
+static struct xsdfec_dmabuf *xsdfec_dmabuf_get(struct dma_chan *chan, int fd,
+					       enum dma_data_direction dir,
+					       struct xsdfec_dmabuf *last)
+{
+	struct xsdfec_dmabuf *buf;
+	struct dma_buf *dmabuf;
+	int ret;
+
+	dmabuf = dma_buf_get(fd);
+	if (IS_ERR(dmabuf))
+		return ERR_CAST(dmabuf);
+
+	if (last && last->dmabuf == dmabuf) {
+		dma_buf_put(dmabuf);
+		kref_get(&last->ref);
+		return last;
+	}
+
+	buf = kzalloc(sizeof(*buf), GFP_KERNEL);
+	if (!buf) {
+		ret = -ENOMEM;
+		goto err_put;
+	}
+	kref_init(&buf->ref);
+	buf->dmabuf = dmabuf;
+	buf->dir = dir;
+
+	buf->attach = dma_buf_attach(dmabuf, chan->device->dev);
+	if (IS_ERR(buf->attach)) {
+		ret = PTR_ERR(buf->attach);
+		goto err_free;
+	}
+
+	buf->sgt = dma_buf_map_attachment(buf->attach, dir);
+	if (IS_ERR(buf->sgt)) {
+		ret = PTR_ERR(buf->sgt);
+		goto err_detach;
+	}
+
+	return buf;
+
+err_detach:
+	dma_buf_detach(dmabuf, buf->attach);
+err_free:
+	kfree(buf);
+err_put:
+	dma_buf_put(dmabuf);
+	return ERR_PTR(ret);
+}
+
+/* Build a DMA-only scatterlist covering @len bytes at @offset of @buf */
+static int xsdfec_dmabuf_slice(struct xsdfec_dmabuf *buf, u32 offset, u32 len,
+			       struct sg_table *sgt)
+{
+	struct scatterlist *sg, *dst;
+	unsigned int i, nents = 0;
+	u64 pos, start, end;
+	int ret;
+
+	if (!len || (u64)offset + len > buf->dmabuf->size)
+		return -EINVAL;
+
+	pos = 0;
+	for_each_sgtable_dma_sg(buf->sgt, sg, i) {
+		if (pos + sg_dma_len(sg) > offset && pos < (u64)offset + len)
+			nents++;
+		pos += sg_dma_len(sg);
+	}
+	if (!nents)
+		return -EINVAL;
+
+	ret = sg_alloc_table(sgt, nents, GFP_KERNEL);
+	if (ret)
+		return ret;
+
+	pos = 0;
+	dst = sgt->sgl;
+	for_each_sgtable_dma_sg(buf->sgt, sg, i) {
+		start = max_t(u64, pos, offset);
+		end = min_t(u64, pos + sg_dma_len(sg), (u64)offset + len);
+		if (start < end) {
+			sg_dma_address(dst) = sg_dma_address(sg) + start - pos;
+			sg_dma_len(dst) = end - start;
+			dst = sg_next(dst);
+		}
+		pos += sg_dma_len(sg);
+	}
+	return 0;
+}
+
+static void xsdfec_job_free(struct xsdfec_job_entry *job)
+{
+	sg_free_table(&job->din_sgt);
+	sg_free_table(&job->dout_sgt);
+	xsdfec_dmabuf_put(job->din);
+	xsdfec_dmabuf_put(job->dout);
+	kfree(job);
+}
+
+static void xsdfec_job_callback(void *param,
+				const struct dmaengine_result *result)
+{
+	struct xsdfec_job_entry *job = param;
+	struct xsdfec_dev *xsdfec = job->xsdfec;
+	unsigned long flags;
+	bool done;
+
+	spin_lock_irqsave(&xsdfec->job_lock, flags);
+	if (result && result->result != DMA_TRANS_NOERROR && !job->result)
+		job->result = -EIO;
+	done = !--job->pending;
+	spin_unlock_irqrestore(&xsdfec->job_lock, flags);
+
+	if (done)
+		wake_up_interruptible(&xsdfec->waitq);
+}
+
+static int xsdfec_job_prep(struct xsdfec_job_entry *job,
+			   enum xsdfec_dma_chan idx, struct scatterlist *sgl,
+			   unsigned int nents, dma_addr_t addr,
+			   enum dma_transfer_direction dir)
+{
+	struct dma_chan *chan = job->xsdfec->chans[idx];
+	struct dma_async_tx_descriptor *desc;
+	unsigned long flags = DMA_PREP_INTERRUPT | DMA_CTRL_ACK;
+
+	if (sgl)
+		desc = dmaengine_prep_slave_sg(chan, sgl, nents, dir, flags);
+	else
+		desc = dmaengine_prep_slave_single(chan, addr, sizeof(u32),
+						   dir, flags);
+	if (!desc)
+		return -ENOMEM;
+
+	desc->callback_result = xsdfec_job_callback;
+	desc->callback_param = job;
+
+	/* Count the transfer before it can complete */
+	spin_lock_irq(&job->xsdfec->job_lock);
+	job->pending++;
+	spin_unlock_irq(&job->xsdfec->job_lock);
+
+	if (dma_submit_error(dmaengine_submit(desc))) {
+		spin_lock_irq(&job->xsdfec->job_lock);
+		job->pending--;
+		spin_unlock_irq(&job->xsdfec->job_lock);
+		return -EIO;
+	}
+	return 0;
+}
+
+static void xsdfec_jobs_cancel(struct xsdfec_dev *xsdfec)
+{
+	struct xsdfec_job_entry *job;
+	int i;
+
+	lockdep_assert_held(&xsdfec->job_mutex);
+
+	if (!xsdfec->chans[XSDFEC_DMA_DIN])
+		return;
+
+	for (i = 0; i < XSDFEC_DMA_NR; i++)
+		dmaengine_terminate_sync(xsdfec->chans[i]);
+
+	/* No callback can run any more, fail what did not complete */
+	spin_lock_irq(&xsdfec->job_lock);
+	list_for_each_entry(job, &xsdfec->jobs, node) {
+		if (job->pending) {
+			job->pending = 0;
+			job->result = -ECANCELED;
+		}
+	}
+	spin_unlock_irq(&xsdfec->job_lock);
+
+	wake_up_interruptible(&xsdfec->waitq);
+}
+
+static int xsdfec_job_queue(struct xsdfec_dev *xsdfec,
+			    const struct xsdfec_job *ujob,
+			    struct xsdfec_dmabuf **last_din,
+			    struct xsdfec_dmabuf **last_dout)
+{
+	struct xsdfec_job_entry *job;
+	u32 slot;
+	int ret;
+
+	if (ujob->reserved)
+		return -EINVAL;
+
+	job = kzalloc(sizeof(*job), GFP_KERNEL);
+	if (!job)
+		return -ENOMEM;
+
+	job->xsdfec = xsdfec;
+	job->user_data = ujob->user_data;
+	/* Held until all transfers are submitted */
+	job->pending = 1;
+
+	job->din = xsdfec_dmabuf_get(xsdfec->chans[XSDFEC_DMA_DIN],
+				     ujob->din_fd, DMA_TO_DEVICE, *last_din);
+	if (IS_ERR(job->din)) {
+		ret = PTR_ERR(job->din);
+		job->din = NULL;
+		goto err_free;
+	}
+
+	job->dout = xsdfec_dmabuf_get(xsdfec->chans[XSDFEC_DMA_DOUT],
+				      ujob->dout_fd, DMA_FROM_DEVICE,
+				      *last_dout);
+	if (IS_ERR(job->dout)) {
+		ret = PTR_ERR(job->dout);
+		job->dout = NULL;
+		goto err_free;
+	}
+
+	ret = xsdfec_dmabuf_slice(job->din, ujob->din_offset, ujob->din_len,
+				  &job->din_sgt);
+	if (ret)
+		goto err_free;
+
+	ret = xsdfec_dmabuf_slice(job->dout, ujob->dout_offset,
+				  ujob->dout_len, &job->dout_sgt);
+	if (ret)
+		goto err_free;
+
+	slot = xsdfec->job_head % XSDFEC_JOBS_MAX;
+	job->slot = slot;
+	xsdfec->ctrl_words[slot] = ujob->ctrl;
+	xsdfec->status_words[slot] = 0;
+
+	spin_lock_irq(&xsdfec->job_lock);
+	list_add_tail(&job->node, &xsdfec->jobs);
+	spin_unlock_irq(&xsdfec->job_lock);
+	xsdfec->job_head++;
+	*last_din = job->din;
+	*last_dout = job->dout;
+
+	/*
+	 * Queue the receive side first so the core never stalls on a full
+	 * output stream. Once anything is submitted the job is owned by the
+	 * list, a failure from here on can only be undone by cancelling.
+	 */
+	ret = xsdfec_job_prep(job, XSDFEC_DMA_STATUS, NULL, 0,
+			      xsdfec->status_dma + slot * sizeof(u32),
+			      DMA_DEV_TO_MEM);
+	if (!ret)
+		ret = xsdfec_job_prep(job, XSDFEC_DMA_DOUT, job->dout_sgt.sgl,
+				      job->dout_sgt.nents, 0, DMA_DEV_TO_MEM);
+	if (!ret)
+		ret = xsdfec_job_prep(job, XSDFEC_DMA_CTRL, NULL, 0,
+				      xsdfec->ctrl_dma + slot * sizeof(u32),
+				      DMA_MEM_TO_DEV);
+	if (!ret)
+		ret = xsdfec_job_prep(job, XSDFEC_DMA_DIN, job->din_sgt.sgl,
+				      job->din_sgt.nents, 0, DMA_MEM_TO_DEV);
+	if (ret) {
+		dev_err(xsdfec->dev, "failed to queue job, cancelling");
+		xsdfec_jobs_cancel(xsdfec);
+		return ret;
+	}
+
+	xsdfec_job_callback(job, NULL);
+	return 0;
+
+err_free:
+	xsdfec_job_free(job);
+	return ret;
+}
+
+static int xsdfec_submit_jobs(struct xsdfec_dev *xsdfec, void __user *arg)
+{
+	struct xsdfec_dmabuf *last_din = NULL, *last_dout = NULL;
+	struct xsdfec_job __user *ujobs;
+	struct xsdfec_job_batch batch;
+	struct xsdfec_job ujob;
+	int i, ret = 0;
+
+	if (!xsdfec->chans[XSDFEC_DMA_DIN])
+		return -EOPNOTSUPP;
+
+	if (xsdfec->state != XSDFEC_STARTED)
+		return -EIO;
+
+	/* Jobs are matched to their output by order */
+	if (xsdfec->config.order != XSDFEC_MAINTAIN_ORDER)
+		return -EINVAL;
+
+	if (copy_from_user(&batch, arg, sizeof(batch)))
+		return -EFAULT;
+
+	ujobs = u64_to_user_ptr(batch.jobs);
+
+	mutex_lock(&xsdfec->job_mutex);
+	for (batch.done = 0; batch.done < batch.count; batch.done++) {
+		if (xsdfec->job_head - xsdfec->job_tail >= XSDFEC_JOBS_MAX) {
+			ret = batch.done ? 0 : -EAGAIN;
+			break;
+		}
+		if (copy_from_user(&ujob, &ujobs[batch.done], sizeof(ujob))) {
+			ret = -EFAULT;
+			break;
+		}
+		ret = xsdfec_job_queue(xsdfec, &ujob, &last_din, &last_dout);
+		if (ret)
+			break;
+	}
+
+	/* Start the whole batch at once */
+	if (batch.done)
+		for (i = 0; i < XSDFEC_DMA_NR; i++)
+			dma_async_issue_pending(xsdfec->chans[i]);
+	mutex_unlock(&xsdfec->job_mutex);
+
+	if (copy_to_user(arg, &batch, sizeof(batch)))
+		return -EFAULT;
+
+	return ret;
+}
+
+static struct xsdfec_job_entry *xsdfec_job_peek(struct xsdfec_dev *xsdfec)
+{
+	struct xsdfec_job_entry *job;
+
+	spin_lock_irq(&xsdfec->job_lock);
+	job = list_first_entry_or_null(&xsdfec->jobs, struct xsdfec_job_entry,
+				       node);
+	if (job && job->pending)
+		job = NULL;
+	spin_unlock_irq(&xsdfec->job_lock);
+
+	return job;
+}
+
+static void xsdfec_job_retire(struct xsdfec_dev *xsdfec,
+			      struct xsdfec_job_entry *job)
+{
+	spin_lock_irq(&xsdfec->job_lock);
+	list_del(&job->node);
+	spin_unlock_irq(&xsdfec->job_lock);
+	xsdfec->job_tail++;
+	xsdfec_job_free(job);
+}
+
+static int xsdfec_get_done_jobs(struct xsdfec_dev *xsdfec, void __user *arg)
+{
+	struct xsdfec_job_done __user *udone;
+	struct xsdfec_job_batch batch;
+	struct xsdfec_job_entry *job;
+	struct xsdfec_job_done done;
+	int ret = 0;
+
+	if (!xsdfec->chans[XSDFEC_DMA_DIN])
+		return -EOPNOTSUPP;
+
+	if (copy_from_user(&batch, arg, sizeof(batch)))
+		return -EFAULT;
+
+	udone = u64_to_user_ptr(batch.jobs);
+
+	mutex_lock(&xsdfec->job_mutex);
+	for (batch.done = 0; batch.done < batch.count; batch.done++) {
+		job = xsdfec_job_peek(xsdfec);
+		if (!job)
+			break;
+
+		done.user_data = job->user_data;
+		done.result = job->result;
+		done.status = job->result ? 0 :
+			      READ_ONCE(xsdfec->status_words[job->slot]);
+		if (copy_to_user(&udone[batch.done], &done, sizeof(done))) {
+			ret = -EFAULT;
+			break;
+		}
+		xsdfec_job_retire(xsdfec, job);
+	}
+	mutex_unlock(&xsdfec->job_mutex);
+
+	if (copy_to_user(arg, &batch, sizeof(batch)))
+		return -EFAULT;
+
+	return ret;
+}
+
+static void xsdfec_jobs_flush(struct xsdfec_dev *xsdfec)
+{
+	struct xsdfec_job_entry *job;
+
+	mutex_lock(&xsdfec->job_mutex);
+	xsdfec_jobs_cancel(xsdfec);
+	while ((job = xsdfec_job_peek(xsdfec)))
+		xsdfec_job_retire(xsdfec, job);
+	xsdfec->job_head = 0;
+	xsdfec->job_tail = 0;
+	mutex_unlock(&xsdfec->job_mutex);
+}
+
+static __poll_t xsdfec_jobs_poll(struct xsdfec_dev *xsdfec)
+{
+	__poll_t mask = 0;
+
+	if (!xsdfec->chans[XSDFEC_DMA_DIN])
+		return 0;
+
+	if (xsdfec_job_peek(xsdfec))
+		mask |= EPOLLIN | EPOLLRDBAND;
+
+	if (READ_ONCE(xsdfec->job_head) - READ_ONCE(xsdfec->job_tail) <
+	    XSDFEC_JOBS_MAX)
+		mask |= EPOLLOUT | EPOLLWRNORM;
+
+	return mask;
+}
+
+static void xsdfec_dma_release(struct xsdfec_dev *xsdfec)
+{
+	struct dma_chan **chans = xsdfec->chans;
+	int i;
+
+	if (xsdfec->status_words)
+		dma_free_coherent(chans[XSDFEC_DMA_STATUS]->device->dev,
+				  XSDFEC_JOBS_MAX * sizeof(u32),
+				  xsdfec->status_words, xsdfec->status_dma);
+	if (xsdfec->ctrl_words)
+		dma_free_coherent(chans[XSDFEC_DMA_CTRL]->device->dev,
+				  XSDFEC_JOBS_MAX * sizeof(u32),
+				  xsdfec->ctrl_words, xsdfec->ctrl_dma);
+	xsdfec->status_words = NULL;
+	xsdfec->ctrl_words = NULL;
+
+	for (i = 0; i < XSDFEC_DMA_NR; i++) {
+		if (chans[i])
+			dma_release_channel(chans[i]);
+		chans[i] = NULL;
+	}
+}
+
+static int xsdfec_dma_init(struct xsdfec_dev *xsdfec)
+{
+	static const char * const names[XSDFEC_DMA_NR] = {
+		[XSDFEC_DMA_DIN] = "din",
+		[XSDFEC_DMA_DOUT] = "dout",
+		[XSDFEC_DMA_CTRL] = "ctrl",
+		[XSDFEC_DMA_STATUS] = "status",
+	};
+	struct dma_chan **chans = xsdfec->chans;
+	struct dma_chan *chan;
+	int i, err;
+
+	mutex_init(&xsdfec->job_mutex);
+	spin_lock_init(&xsdfec->job_lock);
+	INIT_LIST_HEAD(&xsdfec->jobs);
+
+	for (i = 0; i < XSDFEC_DMA_NR; i++) {
+		chan = dma_request_chan(xsdfec->dev, names[i]);
+		if (IS_ERR(chan)) {
+			err = PTR_ERR(chan);
+			xsdfec_dma_release(xsdfec);
+			/* The job interface is optional */
+			if (err == -ENODEV) {
+				dev_dbg(xsdfec->dev, "no %s DMA channel",
+					names[i]);
+				return 0;
+			}
+			return dev_err_probe(xsdfec->dev, err,
+					     "unable to get %s DMA channel",
+					     names[i]);
+		}
+		chans[i] = chan;
+	}
+
+	xsdfec->ctrl_words =
+		dma_alloc_coherent(chans[XSDFEC_DMA_CTRL]->device->dev,
+				   XSDFEC_JOBS_MAX * sizeof(u32),
+				   &xsdfec->ctrl_dma, GFP_KERNEL);
+	xsdfec->status_words =
+		dma_alloc_coherent(chans[XSDFEC_DMA_STATUS]->device->dev,
+				   XSDFEC_JOBS_MAX * sizeof(u32),
+				   &xsdfec->status_dma, GFP_KERNEL);
+	if (!xsdfec->ctrl_words || !xsdfec->status_words) {
+		xsdfec_dma_release(xsdfec);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
 static int xsdfec_set_default_config(struct xsdfec_dev *xsdfec)
 {
 	/* Ensure registers are aligned with core configuration */
 	xsdfec_regwrite(xsdfec, XSDFEC_FEC_CODE_ADDR, xsdfec->config.code);
 	xsdfec_cfg_axi_streams(xsdfec);
 	update_config_from_hw(xsdfec);
+	/* The core may have been reset, forget what it holds */
+	xsdfec_ldpc_codes_invalidate(xsdfec);
+	/* Jobs in flight across a reset will never complete */
+	mutex_lock(&xsdfec->job_mutex);
+	xsdfec_jobs_cancel(xsdfec);
+	mutex_unlock(&xsdfec->job_mutex);
 
 	return 0;
 }
@@ -953,7 +1852,8 @@ static long xsdfec_dev_ioctl(struct file *fptr, unsigned int cmd,
 	/* In failed state allow only reset and get status IOCTLs */
 	if (xsdfec->state == XSDFEC_NEEDS_RESET &&
 	    (cmd != XSDFEC_SET_DEFAULT_CONFIG && cmd != XSDFEC_GET_STATUS &&
-	     cmd != XSDFEC_GET_STATS && cmd != XSDFEC_CLEAR_STATS)) {
+	     cmd != XSDFEC_GET_STATS && cmd != XSDFEC_CLEAR_STATS &&
+	     cmd != XSDFEC_GET_DONE_JOBS)) {
 		return -EPERM;
 	}
 
@@ -991,6 +1891,18 @@ static long xsdfec_dev_ioctl(struct file *fptr, unsigned int cmd,
 	case XSDFEC_ADD_LDPC_CODE_PARAMS:
 		rval = xsdfec_add_ldpc(xsdfec, arg);
 		break;
+	case XSDFEC_ADD_LDPC_CODES:
+		rval = xsdfec_add_ldpc_batch(xsdfec, arg);
+		break;
+	case XSDFEC_SELECT_LDPC_CODE:
+		rval = xsdfec_select_ldpc(xsdfec, arg);
+		break;
+	case XSDFEC_SUBMIT_JOBS:
+		rval = xsdfec_submit_jobs(xsdfec, arg);
+		break;
+	case XSDFEC_GET_DONE_JOBS:
+		rval = xsdfec_get_done_jobs(xsdfec, arg);
+		break;
 	case XSDFEC_SET_ORDER:
 		rval = xsdfec_set_order(xsdfec, arg);
 		break;
@@ -1025,6 +1937,8 @@ static __poll_t xsdfec_poll(struct file *file, poll_table *wait)
 		mask |= EPOLLIN | EPOLLRDNORM;
 	spin_unlock_irqrestore(&xsdfec->error_data_lock, xsdfec->flags);
 
+	mask |= xsdfec_jobs_poll(xsdfec);
+
 	return mask;
 }
 
@@ -1369,6 +2283,22 @@ static int xsdfec_probe(struct platform_device *pdev)
 
 	xsdfec->dev = &pdev->dev;
 	spin_lock_init(&xsdfec->error_data_lock);
+	mutex_init(&xsdfec->code_lock);
+	xa_init(&xsdfec->codes);
+
+	err = xsdfec_table_init(xsdfec, &xsdfec->sc,
+				XSDFEC_LDPC_SC_TABLE_ADDR_BASE,
+				XSDFEC_SC_TABLE_DEPTH);
+	if (!err)
+		err = xsdfec_table_init(xsdfec, &xsdfec->la,
+					XSDFEC_LDPC_LA_TABLE_ADDR_BASE,
+					XSDFEC_LA_TABLE_DEPTH);
+	if (!err)
+		err = xsdfec_table_init(xsdfec, &xsdfec->qc,
+					XSDFEC_LDPC_QC_TABLE_ADDR_BASE,
+					XSDFEC_QC_TABLE_DEPTH);
+	if (err)
+		return err;
 
 	err = xsdfec_clk_init(pdev, &xsdfec->clks);
 	if (err)
@@ -1394,24 +2324,30 @@ static int xsdfec_probe(struct platform_device *pdev)
 
 	update_config_from_hw(xsdfec);
 
+	err = xsdfec_dma_init(xsdfec);
+	if (err)
+		goto err_xsdfec_dev;
+
 	/* Save driver private data */
 	platform_set_drvdata(pdev, xsdfec);
 
+	/* Also used by the job queue when there is no IRQ */
+	init_waitqueue_head(&xsdfec->waitq);
+
 	if (irq_enabled) {
-		init_waitqueue_head(&xsdfec->waitq);
 		/* Register IRQ thread */
 		err = devm_request_threaded_irq(dev, xsdfec->irq, NULL,
 						xsdfec_irq_thread, IRQF_ONESHOT,
 						"xilinx-sdfec16", xsdfec);
 		if (err < 0) {
 			dev_err(dev, "unable to request IRQ%d", xsdfec->irq);
-			goto err_xsdfec_dev;
+			goto err_xsdfec_dma;
 		}
 	}
 
 	err = ida_alloc(&dev_nrs, GFP_KERNEL);
 	if (err < 0)
-		goto err_xsdfec_dev;
+		goto err_xsdfec_dma;
 	xsdfec->dev_id = err;
 
 	snprintf(xsdfec->dev_name, DEV_NAME_LEN, "xsdfec%d", xsdfec->dev_id);
@@ -1428,6 +2364,8 @@ static int xsdfec_probe(struct platform_device *pdev)
 
 err_xsdfec_ida:
 	ida_free(&dev_nrs, xsdfec->dev_id);
+err_xsdfec_dma:
+	xsdfec_dma_release(xsdfec);
 err_xsdfec_dev:
 	xsdfec_disable_all_clks(&xsdfec->clks);
 	return err;
@@ -1440,6 +2378,9 @@ static int xsdfec_remove(struct platform_device *pdev)
 	xsdfec = platform_get_drvdata(pdev);
 	misc_deregister(&xsdfec->miscdev);
 	ida_free(&dev_nrs, xsdfec->dev_id);
+	xsdfec_jobs_flush(xsdfec);
+	xsdfec_dma_release(xsdfec);
+	xsdfec_ldpc_codes_flush(xsdfec);
 	xsdfec_disable_all_clks(&xsdfec->clks);
 	return 0;
 }
@@ -1466,3 +2407,4 @@ module_platform_driver(xsdfec_driver);
 MODULE_AUTHOR("Xilinx, Inc");
 MODULE_DESCRIPTION("Xilinx SD-FEC16 Driver");
 MODULE_LICENSE("GPL");
+MODULE_IMPORT_NS(DMA_BUF);
@@ -9,11 +9,18 @@
  * Inject provides fault injection.
  * Fault injection and detection features are provided through sysfs entries
  * which allow the user to generate a fault.
+ * A campaign mode repeats the injection from an hrtimer at a fixed rate and
+ * collects the recovery latency of every injection in a histogram.
  */
 
 #include <asm/xilinx_mb_manager.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
 #include <linux/module.h>
 #include <linux/of_device.h>
+#include <linux/spinlock.h>
 
 /* TMR Inject Register offsets */
 #define XTMR_INJECT_CR_OFFSET		0x0
@@ -27,6 +34,38 @@
 #define XTMR_INJECT_CR_IE_SHIFT		10
 #define XTMR_INJECT_IIR_ADDR_MASK	GENMASK(31, 16)
 
+/* Campaign defaults and limits */
+#define XTMR_INJECT_PERIOD_US_DEF	1000
+#define XTMR_INJECT_PERIOD_US_MIN	100
+#define XTMR_INJECT_HIST_BUCKETS	16
+
+/**
+ * struct xtmr_inject_campaign - Repeated fault injection state
+ * @timer: timer triggering the injections
+ * @lock: protects the fields below
+ * @period: time between two injections
+ * @count: number of injections to do, 0 to run until stopped
+ * @done: number of injections done
+ * @lat_min: shortest recovery latency in ns
+ * @lat_max: longest recovery latency in ns
+ * @lat_total: sum of the recovery latencies in ns
+ * @hist: recovery latency histogram, bucket n >= 1 counts latencies
+ *	  of [2^n, 2^(n+1)) us and bucket 0 the ones below 2us
+ * @running: true while the campaign is active
+ */
+struct xtmr_inject_campaign {
+	struct hrtimer timer;
+	spinlock_t lock; /* campaign state */
+	ktime_t period;
+	u64 count;
+	u64 done;
+	u64 lat_min;
+	u64 lat_max;
+	u64 lat_total;
+	u64 hist[XTMR_INJECT_HIST_BUCKETS];
+	bool running;
+};
+
 /**
  * struct xtmr_inject_dev - Driver data for TMR Inject
  * @regs: device physical base address
@@ -34,6 +73,7 @@
  * @cr_val: control register value
  * @magic: Magic hardware configuration value
  * @err_cnt: error statistics count
+ * @campaign: fault injection campaign state
  */
 struct xtmr_inject_dev {
 	void __iomem *regs;
@@ -41,6 +81,7 @@ struct xtmr_inject_dev {
 	u32 cr_val;
 	u32 magic;
 	u32 err_cnt;
+	struct xtmr_inject_campaign campaign;
 };
 
 /* IO accessors */
@@ -98,9 +139,215 @@ static ssize_t inject_cpuid_store(struct device *dev,
 }
 static DEVICE_ATTR_WO(inject_cpuid);
 
+/**
+ * xtmr_inject_campaign_fn - Campaign timer callback
+ * @timer: Pointer to the campaign timer
+ *
+ * Injects one fault and accounts the time the processor needed to detect it
+ * and to recover through the break handler. xmb_inject_err() only returns
+ * once the recovery is complete. Running from the timer keeps the processor
+ * from being interrupted while the fault is being handled.
+ *
+ * Return: HRTIMER_RESTART while the campaign goes on, else HRTIMER_NORESTART
+ */
+static enum hrtimer_restart xtmr_inject_campaign_fn(struct hrtimer *timer)
+{
+	struct xtmr_inject_campaign *campaign =
+		container_of(timer, struct xtmr_inject_campaign, timer);
+	unsigned int bucket;
+	ktime_t start;
+	u64 lat, lat_us;
+	bool stop;
+
+	start = ktime_get();
+	xmb_inject_err();
+	lat = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	lat_us = div_u64(lat, NSEC_PER_USEC);
+	bucket = lat_us < 2 ? 0 : min_t(unsigned int, ilog2(lat_us),
+					XTMR_INJECT_HIST_BUCKETS - 1);
+
+	spin_lock(&campaign->lock);
+	if (!campaign->done || lat < campaign->lat_min)
+		campaign->lat_min = lat;
+	if (lat > campaign->lat_max)
+		campaign->lat_max = lat;
+	campaign->lat_total += lat;
+	campaign->hist[bucket]++;
+	campaign->done++;
+	if (campaign->count && campaign->done >= campaign->count)
+		campaign->running = false;
+	stop = !campaign->running;
+	spin_unlock(&campaign->lock);
+
+	if (stop)
+		return HRTIMER_NORESTART;
+
+	hrtimer_forward_now(timer, campaign->period);
+
+	return HRTIMER_RESTART;
+}
+
+static ssize_t campaign_period_us_show(struct device *dev,
+				       struct device_attribute *attr,
+				       char *buf)
+{
+	struct xtmr_inject_dev *xtmr_inject = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%lld\n",
+		       ktime_to_us(xtmr_inject->campaign.period));
+}
+
+static ssize_t campaign_period_us_store(struct device *dev,
+					struct device_attribute *attr,
+					const char *buf, size_t size)
+{
+	struct xtmr_inject_dev *xtmr_inject = dev_get_drvdata(dev);
+	struct xtmr_inject_campaign *campaign = &xtmr_inject->campaign;
+	unsigned long flags;
+	int ret;
+	u32 value;
+
+	ret = kstrtou32(buf, 0, &value);
+	if (ret)
+		return ret;
+
+	if (value < XTMR_INJECT_PERIOD_US_MIN)
+		return -EINVAL;
+
+	spin_lock_irqsave(&campaign->lock, flags);
+	if (campaign->running)
+		ret = -EBUSY;
+	else
+		campaign->period = ns_to_ktime((u64)value * NSEC_PER_USEC);
+	spin_unlock_irqrestore(&campaign->lock, flags);
+
+	return ret ? ret : size;
+}
+static DEVICE_ATTR_RW(campaign_period_us);
+
+static ssize_t campaign_count_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	struct xtmr_inject_dev *xtmr_inject = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%llu\n", xtmr_inject->campaign.count);
+}
+
+static ssize_t campaign_count_store(struct device *dev,
+				    struct device_attribute *attr,
+				    const char *buf, size_t size)
+{
+	struct xtmr_inject_dev *xtmr_inject = dev_get_drvdata(dev);
+	struct xtmr_inject_campaign *campaign = &xtmr_inject->campaign;
+	unsigned long flags;
+	int ret;
+	u64 value;
+
+	ret = kstrtou64(buf, 0, &value);
+	if (ret)
+		return ret;
+
+	spin_lock_irqsave(&campaign->lock, flags);
+	if (campaign->running)
+		ret = -EBUSY;
+	else
+		campaign->count = value;
+	spin_unlock_irqrestore(&campaign->lock, flags);
+
+	return ret ? ret : size;
+}
+static DEVICE_ATTR_RW(campaign_count);
+
+static ssize_t campaign_run_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct xtmr_inject_dev *xtmr_inject = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%d\n", READ_ONCE(xtmr_inject->campaign.running));
+}
+
+static ssize_t campaign_run_store(struct device *dev,
+				  struct device_attribute *attr,
+				  const char *buf, size_t size)
+{
+	struct xtmr_inject_dev *xtmr_inject = dev_get_drvdata(dev);
+	struct xtmr_inject_campaign *campaign = &xtmr_inject->campaign;
+	unsigned long flags;
+	bool value;
+	int ret;
+
+	ret = kstrtobool(buf, &value);
+	if (ret)
+		return ret;
+
+	if (!value) {
+		spin_lock_irqsave(&campaign->lock, flags);
+		campaign->running = false;
+		spin_unlock_irqrestore(&campaign->lock, flags);
+		hrtimer_cancel(&campaign->timer);
+		return size;
+	}
+
+	spin_lock_irqsave(&campaign->lock, flags);
+	if (campaign->running) {
+		spin_unlock_irqrestore(&campaign->lock, flags);
+		return -EBUSY;
+	}
+	/* A new campaign starts with fresh statistics */
+	campaign->done = 0;
+	campaign->lat_min = 0;
+	campaign->lat_max = 0;
+	campaign->lat_total = 0;
+	memset(campaign->hist, 0, sizeof(campaign->hist));
+	campaign->running = true;
+	spin_unlock_irqrestore(&campaign->lock, flags);
+
+	hrtimer_start(&campaign->timer, campaign->period, HRTIMER_MODE_REL);
+
+	return size;
+}
+static DEVICE_ATTR_RW(campaign_run);
+
+static ssize_t campaign_stats_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	struct xtmr_inject_dev *xtmr_inject = dev_get_drvdata(dev);
+	struct xtmr_inject_campaign *campaign = &xtmr_inject->campaign;
+	u64 hist[XTMR_INJECT_HIST_BUCKETS];
+	u64 done, lat_min, lat_max, lat_avg;
+	unsigned long flags;
+	unsigned int i;
+	int len;
+
+	spin_lock_irqsave(&campaign->lock, flags);
+	done = campaign->done;
+	lat_min = campaign->lat_min;
+	lat_max = campaign->lat_max;
+	lat_avg = done ? div64_u64(campaign->lat_total, done) : 0;
+	memcpy(hist, campaign->hist, sizeof(hist));
+	spin_unlock_irqrestore(&campaign->lock, flags);
+
+	len = sysfs_emit(buf, "injections: %llu\n", done);
+	len += sysfs_emit_at(buf, len, "latency_min_ns: %llu\n", lat_min);
+	len += sysfs_emit_at(buf, len, "latency_avg_ns: %llu\n", lat_avg);
+	len += sysfs_emit_at(buf, len, "latency_max_ns: %llu\n", lat_max);
+	for (i = 0; i < XTMR_INJECT_HIST_BUCKETS - 1; i++)
+		len += sysfs_emit_at(buf, len, "%u-%u us: %llu\n",
+				     i ? 1U << i : 0, 2U << i, hist[i]);
+	len += sysfs_emit_at(buf, len, ">=%u us: %llu\n", 1U << i, hist[i]);
+
+	return len;
+}
+static DEVICE_ATTR_RO(campaign_stats);
+
 static struct attribute *xtmr_inject_attrs[] = {
 	&dev_attr_inject_err.attr,
 	&dev_attr_inject_cpuid.attr,
+	&dev_attr_campaign_period_us.attr,
+	&dev_attr_campaign_count.attr,
+	&dev_attr_campaign_run.attr,
+	&dev_attr_campaign_stats.attr,
 	NULL,
 };
 ATTRIBUTE_GROUPS(xtmr_inject);
@@ -156,6 +403,13 @@ static int xtmr_inject_probe(struct platform_device *pdev)
 	/* Initialize TMR Inject */
 	xtmr_inject_init(xtmr_inject);
 
+	spin_lock_init(&xtmr_inject->campaign.lock);
+	hrtimer_init(&xtmr_inject->campaign.timer, CLOCK_MONOTONIC,
+		     HRTIMER_MODE_REL);
+	xtmr_inject->campaign.timer.function = xtmr_inject_campaign_fn;
+	xtmr_inject->campaign.period =
+		ns_to_ktime(XTMR_INJECT_PERIOD_US_DEF * NSEC_PER_USEC);
+
 	err = sysfs_create_groups(&xtmr_inject->dev->kobj, xtmr_inject_groups);
 	if (err < 0) {
 		dev_err(&pdev->dev, "unable to create sysfs entries\n");
@@ -169,7 +423,10 @@ static int xtmr_inject_probe(struct platform_device *pdev)
 
 static int xtmr_inject_remove(struct platform_device *pdev)
 {
+	struct xtmr_inject_dev *xtmr_inject = platform_get_drvdata(pdev);
+
 	sysfs_remove_groups(&pdev->dev.kobj, xtmr_inject_groups);
+	hrtimer_cancel(&xtmr_inject->campaign.timer);
 
 	return 0;
 }
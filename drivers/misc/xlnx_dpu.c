@@ -19,10 +19,17 @@
 #include <linux/io-64-nonatomic-lo-hi.h>
 #include <linux/iopoll.h>
 #include <linux/clk.h>
+#include <linux/dma-buf.h>
 #include <linux/dma-mapping.h>
+#include <linux/dma-fence.h>
+#include <linux/file.h>
+#include <linux/kref.h>
 #include <linux/nospec.h>
+#include <linux/poll.h>
 #include <linux/slab.h>
+#include <linux/sync_file.h>
 #include <linux/iommu.h>
+#include <linux/xarray.h>
 #ifdef CONFIG_DEBUG_FS
 #include <linux/debugfs.h>
 #endif
@@ -53,16 +60,48 @@ static bool force_contig;
 module_param(force_contig, bool, 0444);
 MODULE_PARM_DESC(force_contig, "buffer is forced to be contiguous, default 0");
 
+/* maximum number of asynchronous jobs of a client not yet retrieved */
+#define DPU_MAX_JOBS		256
+
+struct dpu_job;
+struct xdpu_dev;
+
 /**
  * struct cu - Computer Unit (cu) structure
  * @mutex: protects from simultaneous access
  * @done: completion of cu
  * @irq: indicates cu IRQ number
+ * @busy: cu is running a job, protected by the device job_lock
+ * @job: asynchronous job running on the cu, if any
+ * @timer: timeout of the asynchronous job
+ * @deadline: expiry of the asynchronous job in jiffies
+ * @xdpu: dpu structure the cu belongs to
+ * @id: cu index
+ * @jobs: number of runs completed on the cu
+ * @errors: number of runs which timed out
+ * @cycles: total dpu cycles of the runs
+ * @busy_ns: total run time in nanoseconds
+ * @wait_ns: total time the asynchronous jobs waited for the cu
+ * @wait_max_ns: longest time an asynchronous job waited for the cu
+ *
+ * The profiling counters are protected by the device job_lock.
  */
 struct cu {
 	struct mutex	mutex; /* protects from simultaneous accesses */
 	struct completion	done;
 	int	irq;
+	bool	busy;
+	struct dpu_job	*job;
+	struct timer_list	timer;
+	unsigned long	deadline;
+	struct xdpu_dev	*xdpu;
+	int	id;
+	u64	jobs;
+	u64	errors;
+	u64	cycles;
+	u64	busy_ns;
+	u64	wait_ns;
+	u64	wait_max_ns;
 };
 
 /**
@@ -79,6 +118,11 @@ struct cu {
  * @client_list: indicates how many dpu clients link to xdpu
  * @dpu_cnt: indicates how many dpu core/cu enabled in IP, up to 4
  * @sfm_cnt: indicates softmax core enabled or not
+ * @job_lock: protects the job queue and the cu job state
+ * @job_queue: asynchronous jobs waiting for an idle cu
+ * @sfm_queue: asynchronous jobs waiting for the softmax core
+ * @cu_wq: wait queue for a cu to become idle
+ * @fence_lock: lock of the job fences
  */
 struct xdpu_dev {
 	struct device	*dev;
@@ -95,6 +139,11 @@ struct xdpu_dev {
 #endif
 	u8	dpu_cnt;
 	u8	sfm_cnt;
+	spinlock_t	job_lock; /* guards job_queue and cu jobs */
+	struct list_head	job_queue;
+	struct list_head	sfm_queue;
+	wait_queue_head_t	cu_wq;
+	spinlock_t	fence_lock; /* guards job fences */
 };
 
 /**
@@ -102,11 +151,51 @@ struct xdpu_dev {
  * @dev: pointer to dpu device struct
  * @head: indicates dma memory pool list head
  * @node: client node
+ * @done_list: completed asynchronous jobs not yet retrieved
+ * @done_wq: wait queue for asynchronous job completion
+ * @jobs: asynchronous jobs of the client not yet retrieved
+ * @seqno: last asynchronous job sequence number
+ * @bos: buffer blocks of the client indexed by handle
  */
 struct xdpu_client {
 	struct xdpu_dev	*dev;
 	struct list_head	head;
 	struct list_head	node;
+	struct list_head	done_list;
+	wait_queue_head_t	done_wq;
+	unsigned int	jobs;
+	u64	seqno;
+	struct xarray	bos;
+};
+
+/**
+ * struct dpu_job - DPU asynchronous job
+ * @node: node in the device queue or the client done list
+ * @client: client which submitted the job
+ * @run: job description and results
+ * @user_data: opaque value handed back to the client
+ * @seqno: sequence number of the job for the client
+ * @status: completion status of the job
+ * @fence: completion fence, if requested
+ * @flags: DPU_SUBMIT_* flags of the job
+ * @softmax: softmax chained to the run, if DPU_SUBMIT_SOFTMAX
+ * @time_submit: submission timestamp
+ * @sfm_start: softmax start timestamp
+ * @sfm_end: softmax end timestamp
+ */
+struct dpu_job {
+	struct list_head	node;
+	struct xdpu_client	*client;
+	struct ioc_kernel_run_t	run;
+	u64	user_data;
+	u64	seqno;
+	int	status;
+	struct dma_fence	*fence;
+	u32	flags;
+	struct ioc_softmax_t	softmax;
+	ktime_t	time_submit;
+	ktime_t	sfm_start;
+	ktime_t	sfm_end;
 };
 
 /**
@@ -117,6 +206,12 @@ struct xdpu_client {
  * @phy_addr: physical address of the blocks memory
  * @size: total size of the block in bytes
  * @attrs: dma buffer attributes
+ * @ref: references of the client and of the exported dma-bufs
+ * @xdpu: dpu structure the block belongs to
+ * @handle: handle of the block in the client
+ * @dmabuf: imported dma-buf, NULL for allocated blocks
+ * @attach: attachment of the imported dma-buf to the dpu
+ * @sgt: dpu mapping of the imported dma-buf
  */
 struct dpu_buffer_block {
 	struct list_head	head;
@@ -125,6 +220,12 @@ struct dpu_buffer_block {
 	phys_addr_t	phy_addr;
 	size_t	size;
 	unsigned long	attrs;
+	struct kref	ref;
+	struct xdpu_dev	*xdpu;
+	u32	handle;
+	struct dma_buf	*dmabuf;
+	struct dma_buf_attachment	*attach;
+	struct sg_table	*sgt;
 };
 
 #ifdef CONFIG_DEBUG_FS
@@ -261,17 +362,12 @@ static void xlnx_sfm_int_clear(struct xdpu_dev *xdpu)
 }
 
 /**
- * xlnx_dpu_softmax - softmax calculation acceleration using softmax IP
+ * xlnx_sfm_start - program and start the softmax core
  * @xdpu:	dpu structure
  * @p :	softmax pmeter structure
- *
- * Return:	0 if successful; otherwise -errno
  */
-static int xlnx_dpu_softmax(struct xdpu_dev *xdpu, struct ioc_softmax_t *p)
+static void xlnx_sfm_start(struct xdpu_dev *xdpu, struct ioc_softmax_t *p)
 {
-	int ret = -ETIMEDOUT;
-	int val;
-
 	iowrite32(p->width, xdpu->regs + DPU_SFM_CMD_XLEN);
 	iowrite32(p->height, xdpu->regs + DPU_SFM_CMD_YLEN);
 
@@ -288,6 +384,21 @@ static int xlnx_dpu_softmax(struct xdpu_dev *xdpu, struct ioc_softmax_t *p)
 
 	iowrite32(1, xdpu->regs + DPU_SFM_START);
 	iowrite32(0, xdpu->regs + DPU_SFM_START);
+}
+
+/**
+ * xlnx_dpu_softmax - softmax calculation acceleration using softmax IP
+ * @xdpu:	dpu structure
+ * @p :	softmax pmeter structure
+ *
+ * Return:	0 if successful; otherwise -errno
+ */
+static int xlnx_dpu_softmax(struct xdpu_dev *xdpu, struct ioc_softmax_t *p)
+{
+	int ret = -ETIMEDOUT;
+	int val;
+
+	xlnx_sfm_start(xdpu, p);
 
 	if (!force_poll) {
 		if (!wait_for_completion_timeout(&xdpu->cu[xdpu->dpu_cnt].done,
@@ -319,18 +430,14 @@ static int xlnx_dpu_softmax(struct xdpu_dev *xdpu, struct ioc_softmax_t *p)
 }
 
 /**
- * xlnx_dpu_run - run dpu
+ * xlnx_dpu_start - program and start a cu
  * @xdpu:	dpu structure
  * @p:	dpu run struct, contains the necessary address info
- * @id:	indicates which cu is running
- *
- * Return:	0 if successful; otherwise -errno
+ * @id:	indicates which cu is started
  */
-static inline int xlnx_dpu_run(struct xdpu_dev *xdpu,
-			       struct ioc_kernel_run_t *p, int id)
+static void xlnx_dpu_start(struct xdpu_dev *xdpu,
+			   struct ioc_kernel_run_t *p, int id)
 {
-	int val, ret;
-
 	iowrite32(p->addr_code >> DPU_INSTR_OFFSET,
 		  xdpu->regs + DPU_INSADDR(id));
 
@@ -358,6 +465,69 @@ static inline int xlnx_dpu_run(struct xdpu_dev *xdpu,
 	iowrite32(1, xdpu->regs + DPU_IPSTART(id));
 
 	p->time_start = ktime_get();
+}
+
+/**
+ * xlnx_dpu_get_result - read back the counters of a finished cu
+ * @xdpu:	dpu structure
+ * @p:	dpu run struct to fill in
+ * @id:	indicates which cu finished
+ */
+static void xlnx_dpu_get_result(struct xdpu_dev *xdpu,
+				struct ioc_kernel_run_t *p, int id)
+{
+	p->time_end = ktime_get();
+	p->core_id = id;
+	p->pend_cnt = ioread32(xdpu->regs + DPU_P_END_C(id));
+	p->cend_cnt = ioread32(xdpu->regs + DPU_C_END_C(id));
+	p->send_cnt = ioread32(xdpu->regs + DPU_S_END_C(id));
+	p->lend_cnt = ioread32(xdpu->regs + DPU_L_END_C(id));
+	p->pstart_cnt = ioread32(xdpu->regs + DPU_P_STA_C(id));
+	p->cstart_cnt = ioread32(xdpu->regs + DPU_C_STA_C(id));
+	p->sstart_cnt = ioread32(xdpu->regs + DPU_S_STA_C(id));
+	p->lstart_cnt = ioread32(xdpu->regs + DPU_L_STA_C(id));
+	p->counter = lo_hi_readq(xdpu->regs + DPU_CYCLE_L(id));
+}
+
+/**
+ * xlnx_dpu_account - update the profiling counters of a cu
+ * @cu:	cu which ran the job
+ * @busy_ns:	run time of the job
+ * @wait_ns:	time the job waited for the cu
+ * @cycles:	dpu cycles of the job
+ * @status:	0 or -errno
+ */
+static void xlnx_dpu_account(struct cu *cu, s64 busy_ns, s64 wait_ns,
+			     u64 cycles, int status)
+{
+	lockdep_assert_held(&cu->xdpu->job_lock);
+
+	if (status) {
+		cu->errors++;
+		return;
+	}
+
+	cu->jobs++;
+	cu->cycles += cycles;
+	cu->busy_ns += busy_ns;
+	cu->wait_ns += wait_ns;
+	cu->wait_max_ns = max_t(u64, cu->wait_max_ns, wait_ns);
+}
+
+/**
+ * xlnx_dpu_run - run dpu
+ * @xdpu:	dpu structure
+ * @p:	dpu run struct, contains the necessary address info
+ * @id:	indicates which cu is running
+ *
+ * Return:	0 if successful; otherwise -errno
+ */
+static inline int xlnx_dpu_run(struct xdpu_dev *xdpu,
+			       struct ioc_kernel_run_t *p, int id)
+{
+	int val, ret;
+
+	xlnx_dpu_start(xdpu, p, id);
 
 	if (!force_poll) {
 		if (!wait_for_completion_timeout(&xdpu->cu[id].done,
@@ -376,17 +546,7 @@ static inline int xlnx_dpu_run(struct xdpu_dev *xdpu,
 		xlnx_dpu_int_clear(xdpu, id);
 	}
 
-	p->time_end = ktime_get();
-	p->core_id = id;
-	p->pend_cnt = ioread32(xdpu->regs + DPU_P_END_C(id));
-	p->cend_cnt = ioread32(xdpu->regs + DPU_C_END_C(id));
-	p->send_cnt = ioread32(xdpu->regs + DPU_S_END_C(id));
-	p->lend_cnt = ioread32(xdpu->regs + DPU_L_END_C(id));
-	p->pstart_cnt = ioread32(xdpu->regs + DPU_P_STA_C(id));
-	p->cstart_cnt = ioread32(xdpu->regs + DPU_C_STA_C(id));
-	p->sstart_cnt = ioread32(xdpu->regs + DPU_S_STA_C(id));
-	p->lstart_cnt = ioread32(xdpu->regs + DPU_L_STA_C(id));
-	p->counter = lo_hi_readq(xdpu->regs + DPU_CYCLE_L(id));
+	xlnx_dpu_get_result(xdpu, p, id);
 
 	dev_dbg(xdpu->dev,
 		"%s: PID=%d DPU=%d CPU=%d TIME=%lldus complete!\n",
@@ -395,19 +555,651 @@ static inline int xlnx_dpu_run(struct xdpu_dev *xdpu,
 
 	return 0;
 
-err_out:
-	dev_warn(xdpu->dev, "cu[%d] timeout", id);
-	xlnx_dpu_dump_regs(xdpu);
+err_out:
+	dev_warn(xdpu->dev, "cu[%d] timeout", id);
+	xlnx_dpu_dump_regs(xdpu);
+
+	return -ETIMEDOUT;
+}
+
+/*
+ * Asynchronous jobs: the jobs of all clients are queued on the device and
+ * dispatched from the interrupt handler to whichever cu becomes idle, so
+ * that back-to-back jobs keep all the cu busy without a round trip to
+ * userspace in between.
+ */
+
+static const char *xlnx_dpu_fence_get_driver_name(struct dma_fence *fence)
+{
+	return DRV_NAME;
+}
+
+static const char *xlnx_dpu_fence_get_timeline_name(struct dma_fence *fence)
+{
+	return DEVICE_NAME;
+}
+
+static const struct dma_fence_ops xlnx_dpu_fence_ops = {
+	.get_driver_name = xlnx_dpu_fence_get_driver_name,
+	.get_timeline_name = xlnx_dpu_fence_get_timeline_name,
+};
+
+/**
+ * xlnx_dpu_job_free - free an asynchronous job
+ * @job:	job to free
+ *
+ * A fence not signalled yet belongs to a job that never ran, signal it
+ * with an error to release the waiters.
+ */
+static void xlnx_dpu_job_free(struct dpu_job *job)
+{
+	if (job->fence) {
+		if (!dma_fence_is_signaled(job->fence)) {
+			dma_fence_set_error(job->fence, -ECANCELED);
+			dma_fence_signal(job->fence);
+		}
+		dma_fence_put(job->fence);
+	}
+	kfree(job);
+}
+
+/**
+ * xlnx_dpu_idle_cu - find an idle cu for a job
+ * @xdpu:	dpu structure
+ * @core_id:	cu requested by the job, or DPU_CORE_ANY
+ *
+ * Return:	index of an idle cu, or -EBUSY if none
+ */
+static int xlnx_dpu_idle_cu(struct xdpu_dev *xdpu, int core_id)
+{
+	int i;
+
+	lockdep_assert_held(&xdpu->job_lock);
+
+	if (core_id != DPU_CORE_ANY)
+		return xdpu->cu[core_id].busy ? -EBUSY : core_id;
+
+	for (i = 0; i < xdpu->dpu_cnt; i++)
+		if (!xdpu->cu[i].busy)
+			return i;
+
+	return -EBUSY;
+}
+
+/**
+ * xlnx_dpu_dispatch - start queued jobs on the idle cu
+ * @xdpu:	dpu structure
+ *
+ * Jobs are started in submission order, a job bound to a busy cu doesn't
+ * hold back the jobs that can run on another one. The softmax core runs
+ * the chained softmax of the jobs in their run completion order.
+ */
+static void xlnx_dpu_dispatch(struct xdpu_dev *xdpu)
+{
+	struct dpu_job *job, *next;
+	struct cu *cu;
+	int id;
+
+	lockdep_assert_held(&xdpu->job_lock);
+
+	list_for_each_entry_safe(job, next, &xdpu->job_queue, node) {
+		if (xlnx_dpu_idle_cu(xdpu, DPU_CORE_ANY) < 0)
+			break;
+
+		id = xlnx_dpu_idle_cu(xdpu, job->run.core_id);
+		if (id < 0)
+			continue;
+
+		list_del(&job->node);
+		cu = &xdpu->cu[id];
+		cu->busy = true;
+		cu->job = job;
+		cu->deadline = jiffies + TIMEOUT;
+		xlnx_dpu_start(xdpu, &job->run, id);
+		mod_timer(&cu->timer, cu->deadline);
+	}
+
+	cu = &xdpu->cu[xdpu->dpu_cnt];
+	if (!xdpu->sfm_cnt || cu->busy || list_empty(&xdpu->sfm_queue))
+		return;
+
+	job = list_first_entry(&xdpu->sfm_queue, struct dpu_job, node);
+	list_del(&job->node);
+	cu->busy = true;
+	cu->job = job;
+	cu->deadline = jiffies + TIMEOUT;
+	xlnx_sfm_start(xdpu, &job->softmax);
+	job->sfm_start = ktime_get();
+	mod_timer(&cu->timer, cu->deadline);
+}
+
+/**
+ * xlnx_dpu_job_done - complete the asynchronous job of a cu
+ * @xdpu:	dpu structure
+ * @cu:	cu or softmax core which ran the job
+ * @status:	0 or -errno
+ *
+ * A successful run with a chained softmax is queued for the softmax core
+ * instead of being completed.
+ */
+static void xlnx_dpu_job_done(struct xdpu_dev *xdpu, struct cu *cu,
+			      int status)
+{
+	struct dpu_job *job = cu->job;
+	struct ioc_kernel_run_t *run = &job->run;
+
+	lockdep_assert_held(&xdpu->job_lock);
+
+	cu->job = NULL;
+	cu->busy = false;
+
+	job->status = status;
+	if (cu->id == xdpu->dpu_cnt) {
+		job->sfm_end = ktime_get();
+		xlnx_dpu_account(cu, job->sfm_end - job->sfm_start,
+				 job->sfm_start - run->time_end, 0, status);
+	} else if (!status) {
+		xlnx_dpu_get_result(xdpu, run, cu->id);
+		xlnx_dpu_account(cu, run->time_end - run->time_start,
+				 run->time_start - job->time_submit,
+				 run->counter, 0);
+		if (job->flags & DPU_SUBMIT_SOFTMAX) {
+			list_add_tail(&job->node, &xdpu->sfm_queue);
+			wake_up(&xdpu->cu_wq);
+			return;
+		}
+	} else {
+		xlnx_dpu_account(cu, 0, 0, 0, status);
+	}
+
+	if (job->fence) {
+		if (status)
+			dma_fence_set_error(job->fence, status);
+		dma_fence_signal(job->fence);
+	}
+
+	list_add_tail(&job->node, &job->client->done_list);
+	wake_up_interruptible(&job->client->done_wq);
+	wake_up(&xdpu->cu_wq);
+}
+
+/**
+ * xlnx_dpu_job_timeout - fail an asynchronous job which timed out
+ * @t:	timer of the cu
+ */
+static void xlnx_dpu_job_timeout(struct timer_list *t)
+{
+	struct cu *cu = from_timer(cu, t, timer);
+	struct xdpu_dev *xdpu = cu->xdpu;
+	unsigned long flags;
+
+	spin_lock_irqsave(&xdpu->job_lock, flags);
+	/* The job may have completed and another one started meanwhile */
+	if (cu->job && time_after_eq(jiffies, cu->deadline)) {
+		dev_warn(xdpu->dev, "cu[%d] timeout", cu->id);
+		xlnx_dpu_dump_regs(xdpu);
+		if (cu->id == xdpu->dpu_cnt)
+			xlnx_sfm_int_clear(xdpu);
+		else
+			xlnx_dpu_int_clear(xdpu, cu->id);
+		xlnx_dpu_job_done(xdpu, cu, -ETIMEDOUT);
+		xlnx_dpu_dispatch(xdpu);
+	}
+	spin_unlock_irqrestore(&xdpu->job_lock, flags);
+}
+
+/**
+ * xlnx_dpu_claim_cu - reserve a cu for a synchronous run
+ * @xdpu:	dpu structure
+ * @id:	cu to reserve
+ *
+ * Return:	true if the cu has been reserved
+ */
+static bool xlnx_dpu_claim_cu(struct xdpu_dev *xdpu, int id)
+{
+	unsigned long flags;
+	bool claimed = false;
+
+	spin_lock_irqsave(&xdpu->job_lock, flags);
+	if (!xdpu->cu[id].busy) {
+		xdpu->cu[id].busy = true;
+		claimed = true;
+	}
+	spin_unlock_irqrestore(&xdpu->job_lock, flags);
+
+	return claimed;
+}
+
+/**
+ * xlnx_dpu_release_cu - release a cu after a synchronous run
+ * @xdpu:	dpu structure
+ * @id:	cu to release
+ */
+static void xlnx_dpu_release_cu(struct xdpu_dev *xdpu, int id)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&xdpu->job_lock, flags);
+	xdpu->cu[id].busy = false;
+	xlnx_dpu_dispatch(xdpu);
+	spin_unlock_irqrestore(&xdpu->job_lock, flags);
+
+	wake_up(&xdpu->cu_wq);
+}
+
+/**
+ * xlnx_dpu_submit - queue an asynchronous job
+ * @client:	dpu client
+ * @arg:	ioc_submit_t struct, contains the job
+ *
+ * Return:	0 if successful; otherwise -errno
+ */
+static long xlnx_dpu_submit(struct xdpu_client *client,
+			    struct ioc_submit_t __user *arg)
+{
+	struct xdpu_dev *xdpu = client->dev;
+	struct sync_file *sync_file = NULL;
+	struct ioc_submit_t req;
+	struct dpu_job *job;
+	unsigned long flags;
+	int fd = -1;
+	long ret;
+
+	/* Jobs are completed from the cu interrupts */
+	if (force_poll)
+		return -EOPNOTSUPP;
+
+	if (copy_from_user(&req, arg, sizeof(req)))
+		return -EFAULT;
+
+	if (req.flags & ~(DPU_SUBMIT_FENCE_OUT | DPU_SUBMIT_SOFTMAX))
+		return -EINVAL;
+
+	if ((req.flags & DPU_SUBMIT_SOFTMAX) && !xdpu->sfm_cnt)
+		return -EOPNOTSUPP;
+
+	if (req.run.core_id != DPU_CORE_ANY) {
+		if (req.run.core_id < 0 || req.run.core_id >= xdpu->dpu_cnt)
+			return -EINVAL;
+		req.run.core_id = array_index_nospec(req.run.core_id,
+						     xdpu->dpu_cnt);
+	}
+
+	job = kzalloc(sizeof(*job), GFP_KERNEL);
+	if (!job)
+		return -ENOMEM;
+
+	job->client = client;
+	job->run = req.run;
+	job->user_data = req.user_data;
+	job->flags = req.flags;
+	job->softmax = req.softmax;
+
+	if (req.flags & DPU_SUBMIT_FENCE_OUT) {
+		job->fence = kzalloc(sizeof(*job->fence), GFP_KERNEL);
+		if (!job->fence) {
+			ret = -ENOMEM;
+			goto err_free;
+		}
+		/* Jobs complete out of order, give each its own context */
+		dma_fence_init(job->fence, &xlnx_dpu_fence_ops,
+			       &xdpu->fence_lock,
+			       dma_fence_context_alloc(1), 1);
+
+		fd = get_unused_fd_flags(O_CLOEXEC);
+		if (fd < 0) {
+			ret = fd;
+			goto err_free;
+		}
+
+		sync_file = sync_file_create(job->fence);
+		if (!sync_file) {
+			ret = -ENOMEM;
+			goto err_free;
+		}
+	}
+
+	spin_lock_irqsave(&xdpu->job_lock, flags);
+	if (client->jobs >= DPU_MAX_JOBS) {
+		spin_unlock_irqrestore(&xdpu->job_lock, flags);
+		ret = -EBUSY;
+		goto err_free;
+	}
+	client->jobs++;
+	job->seqno = ++client->seqno;
+	spin_unlock_irqrestore(&xdpu->job_lock, flags);
+
+	req.seqno = job->seqno;
+	req.fence_fd = fd;
+	if (copy_to_user(arg, &req, sizeof(req))) {
+		spin_lock_irqsave(&xdpu->job_lock, flags);
+		client->jobs--;
+		spin_unlock_irqrestore(&xdpu->job_lock, flags);
+		ret = -EFAULT;
+		goto err_free;
+	}
+
+	if (sync_file)
+		fd_install(fd, sync_file->file);
+
+	spin_lock_irqsave(&xdpu->job_lock, flags);
+	job->time_submit = ktime_get();
+	list_add_tail(&job->node, &xdpu->job_queue);
+	xlnx_dpu_dispatch(xdpu);
+	spin_unlock_irqrestore(&xdpu->job_lock, flags);
+
+	return 0;
+
+err_free:
+	if (sync_file)
+		fput(sync_file->file);
+	if (fd >= 0)
+		put_unused_fd(fd);
+	xlnx_dpu_job_free(job);
+
+	return ret;
+}
+
+/**
+ * xlnx_dpu_get_done - retrieve the result of a completed job
+ * @file:	file handle of the DPU device
+ * @client:	dpu client
+ * @arg:	ioc_job_done_t struct to fill in
+ *
+ * Block until a job completes, unless the file is non-blocking.
+ *
+ * Return:	0 if successful; -EAGAIN if no job is complete in non-blocking
+ *		mode, -ENOENT if there is no job at all; otherwise -errno
+ */
+static long xlnx_dpu_get_done(struct file *file, struct xdpu_client *client,
+			      struct ioc_job_done_t __user *arg)
+{
+	struct xdpu_dev *xdpu = client->dev;
+	struct ioc_job_done_t res = { };
+	struct list_head *done;
+	struct dpu_job *job;
+	unsigned long flags;
+	int ret;
+
+	spin_lock_irqsave(&xdpu->job_lock, flags);
+	while (list_empty(&client->done_list)) {
+		bool none = !client->jobs;
+
+		spin_unlock_irqrestore(&xdpu->job_lock, flags);
+
+		if (none)
+			return -ENOENT;
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+
+		done = &client->done_list;
+		ret = wait_event_interruptible(client->done_wq,
+					       !list_empty_careful(done));
+		if (ret)
+			return ret;
+
+		spin_lock_irqsave(&xdpu->job_lock, flags);
+	}
+	job = list_first_entry(&client->done_list, struct dpu_job, node);
+	list_del(&job->node);
+	client->jobs--;
+	spin_unlock_irqrestore(&xdpu->job_lock, flags);
+
+	res.run = job->run;
+	res.user_data = job->user_data;
+	res.seqno = job->seqno;
+	res.status = job->status;
+	res.time_submit = job->time_submit;
+	res.sfm_start = job->sfm_start;
+	res.sfm_end = job->sfm_end;
+	xlnx_dpu_job_free(job);
+
+	if (copy_to_user(arg, &res, sizeof(res)))
+		return -EFAULT;
+
+	return 0;
+}
+
+/**
+ * xlnx_dpu_client_running - check if a client has a job on a cu
+ * @xdpu:	dpu structure
+ * @client:	dpu client
+ *
+ * Return:	true if a job of @client is running
+ */
+static bool __xlnx_dpu_client_running(struct xdpu_dev *xdpu,
+				      struct xdpu_client *client)
+{
+	int i;
+
+	lockdep_assert_held(&xdpu->job_lock);
+
+	for (i = 0; i < xdpu->dpu_cnt + xdpu->sfm_cnt; i++)
+		if (xdpu->cu[i].job && xdpu->cu[i].job->client == client)
+			return true;
+
+	return false;
+}
+
+static bool xlnx_dpu_client_running(struct xdpu_dev *xdpu,
+				    struct xdpu_client *client)
+{
+	unsigned long flags;
+	bool running;
+
+	spin_lock_irqsave(&xdpu->job_lock, flags);
+	running = __xlnx_dpu_client_running(xdpu, client);
+	spin_unlock_irqrestore(&xdpu->job_lock, flags);
+
+	return running;
+}
+
+/**
+ * xlnx_dpu_cancel_jobs - drop all the asynchronous jobs of a client
+ * @xdpu:	dpu structure
+ * @client:	dpu client
+ *
+ * Queued jobs are cancelled, running ones are waited for as the cu may
+ * still access the client buffers.
+ */
+static void xlnx_dpu_cancel_jobs(struct xdpu_dev *xdpu,
+				 struct xdpu_client *client)
+{
+	struct dpu_job *job, *next;
+	unsigned long flags;
+	bool running;
+	LIST_HEAD(jobs);
+
+	spin_lock_irqsave(&xdpu->job_lock, flags);
+	list_for_each_entry_safe(job, next, &xdpu->job_queue, node)
+		if (job->client == client)
+			list_move_tail(&job->node, &jobs);
+	spin_unlock_irqrestore(&xdpu->job_lock, flags);
+
+	/* Completed runs may queue their softmax, which may start meanwhile */
+	do {
+		wait_event(xdpu->cu_wq,
+			   !xlnx_dpu_client_running(xdpu, client));
+
+		spin_lock_irqsave(&xdpu->job_lock, flags);
+		list_for_each_entry_safe(job, next, &xdpu->sfm_queue, node)
+			if (job->client == client)
+				list_move_tail(&job->node, &jobs);
+		running = __xlnx_dpu_client_running(xdpu, client);
+		spin_unlock_irqrestore(&xdpu->job_lock, flags);
+	} while (running);
+
+	spin_lock_irqsave(&xdpu->job_lock, flags);
+	list_splice_tail_init(&client->done_list, &jobs);
+	client->jobs = 0;
+	spin_unlock_irqrestore(&xdpu->job_lock, flags);
+
+	list_for_each_entry_safe(job, next, &jobs, node) {
+		list_del(&job->node);
+		xlnx_dpu_job_free(job);
+	}
+}
+
+static inline phys_addr_t get_pa(void *addr)
+{
+	if (likely(is_vmalloc_addr(addr)))
+		return page_to_phys(vmalloc_to_page(addr)) +
+			offset_in_page(addr);
+	return __pa(addr);
+}
+
+/**
+ * xlnx_dpu_bo_release - free a buffer block once it is unused
+ * @ref:	reference count of the block
+ */
+static void xlnx_dpu_bo_release(struct kref *ref)
+{
+	struct dpu_buffer_block *pb = container_of(ref, struct dpu_buffer_block,
+						   ref);
+
+	if (pb->dmabuf) {
+		dma_buf_unmap_attachment(pb->attach, pb->sgt,
+					 DMA_BIDIRECTIONAL);
+		dma_buf_detach(pb->dmabuf, pb->attach);
+		dma_buf_put(pb->dmabuf);
+	} else {
+		dma_free_attrs(pb->xdpu->dev, pb->size, pb->cpu_addr,
+			       pb->dma_addr, pb->attrs);
+	}
+	kfree(pb);
+}
+
+/**
+ * xlnx_dpu_bo_create - alloc a contiguous buffer block for dpu
+ * @xdpu:	dpu structure
+ * @size:	size of the block in bytes
+ *
+ * Return:	the block, or an error pointer
+ */
+static struct dpu_buffer_block *xlnx_dpu_bo_create(struct xdpu_dev *xdpu,
+						   size_t size)
+{
+	struct dpu_buffer_block *pb;
+
+	pb = kzalloc(sizeof(*pb), GFP_KERNEL);
+	if (!pb)
+		return ERR_PTR(-ENOMEM);
+
+	kref_init(&pb->ref);
+	pb->xdpu = xdpu;
+	pb->size = size;
+
+	if (iommu_present(xdpu->dev->bus) && force_contig)
+		pb->attrs = DMA_ATTR_FORCE_CONTIGUOUS;
+
+	pb->cpu_addr = dma_alloc_attrs(xdpu->dev, pb->size, &pb->dma_addr,
+				       GFP_KERNEL | __GFP_ZERO, pb->attrs);
+	if (!pb->cpu_addr) {
+		kfree(pb);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	if (!(iommu_present(xdpu->dev->bus)))
+		pb->phy_addr = pb->dma_addr;
+	else
+		pb->phy_addr = get_pa(pb->cpu_addr);
+
+	return pb;
+}
+
+/**
+ * xlnx_dpu_bo_add - hand a buffer block over to a client
+ * @client:	dpu client
+ * @pb:	buffer block, the reference of the caller is transferred
+ *
+ * Return:	0 if successful; otherwise -errno
+ */
+static int xlnx_dpu_bo_add(struct xdpu_client *client,
+			   struct dpu_buffer_block *pb)
+{
+	struct xdpu_dev *xdpu = client->dev;
+	int ret;
+
+	ret = xa_alloc(&client->bos, &pb->handle, pb, xa_limit_32b,
+		       GFP_KERNEL);
+	if (ret)
+		return ret;
+
+	mutex_lock(&xdpu->mutex);
+	list_add(&pb->head, &client->head);
+	mutex_unlock(&xdpu->mutex);
+
+	return 0;
+}
+
+/**
+ * xlnx_dpu_bo_remove - drop the reference of a client on a buffer block
+ * @client:	dpu client
+ * @pb:	buffer block
+ *
+ * The block is freed once the dma-bufs exported from it are released too.
+ * Called with the device mutex held.
+ */
+static void xlnx_dpu_bo_remove(struct xdpu_client *client,
+			       struct dpu_buffer_block *pb)
+{
+	lockdep_assert_held(&client->dev->mutex);
+
+	xa_erase(&client->bos, pb->handle);
+	list_del(&pb->head);
+	kref_put(&pb->ref, xlnx_dpu_bo_release);
+}
+
+/**
+ * xlnx_dpu_bo_get - look up a buffer block from its handle
+ * @client:	dpu client
+ * @handle:	handle of the block
+ *
+ * Return:	the block with a reference taken, or NULL
+ */
+static struct dpu_buffer_block *xlnx_dpu_bo_get(struct xdpu_client *client,
+						u32 handle)
+{
+	struct dpu_buffer_block *pb;
+
+	xa_lock(&client->bos);
+	pb = xa_load(&client->bos, handle);
+	if (pb)
+		kref_get(&pb->ref);
+	xa_unlock(&client->bos);
 
-	return -ETIMEDOUT;
+	return pb;
 }
 
-static inline phys_addr_t get_pa(void *addr)
+/**
+ * xlnx_dpu_bo_sync - flush/invalidate cache for a buffer block range
+ * @xdpu:	dpu structure
+ * @pb:	buffer block
+ * @offset:	offset of the range in the block
+ * @size:	size of the range
+ * @dir:	CPU_TO_DPU or DPU_TO_CPU
+ */
+static void xlnx_dpu_bo_sync(struct xdpu_dev *xdpu,
+			     struct dpu_buffer_block *pb, size_t offset,
+			     size_t size, int dir)
 {
-	if (likely(is_vmalloc_addr(addr)))
-		return page_to_phys(vmalloc_to_page(addr)) +
-			offset_in_page(addr);
-	return __pa(addr);
+	/* Imported buffers are synced as a whole */
+	if (pb->dmabuf) {
+		if (dir == DPU_TO_CPU)
+			dma_sync_sgtable_for_cpu(xdpu->dev, pb->sgt,
+						 DMA_FROM_DEVICE);
+		else
+			dma_sync_sgtable_for_device(xdpu->dev, pb->sgt,
+						    DMA_TO_DEVICE);
+		return;
+	}
+
+	if (dir == DPU_TO_CPU)
+		dma_sync_single_for_cpu(xdpu->dev, pb->phy_addr + offset,
+					size, DMA_FROM_DEVICE);
+	else
+		dma_sync_single_for_device(xdpu->dev, pb->phy_addr + offset,
+					   size, DMA_TO_DEVICE);
 }
 
 /**
@@ -424,48 +1216,26 @@ static long xlnx_dpu_alloc_bo(struct xdpu_client *client,
 	size_t size;
 	struct xdpu_dev *xdpu = client->dev;
 
-	pb = kzalloc(sizeof(*pb), GFP_KERNEL);
-	if (!pb)
-		return -ENOMEM;
-
 	if (get_user(size, &req->size))
-		goto err_pb;
+		return -EFAULT;
 
 	if (size > SIZE_MAX - PAGE_SIZE)
-		goto err_pb;
-
-	pb->size = size;
-
-	if (put_user(pb->size, &req->capacity))
-		goto err_pb;
-
-	if (iommu_present(xdpu->dev->bus) && force_contig)
-		pb->attrs = DMA_ATTR_FORCE_CONTIGUOUS;
-
-	pb->cpu_addr = dma_alloc_attrs(xdpu->dev, pb->size, &pb->dma_addr,
-				       GFP_KERNEL | __GFP_ZERO, pb->attrs);
-	if (!pb->cpu_addr)
-		goto err_pb;
+		return -EFAULT;
 
-	if (put_user(pb->dma_addr, &req->dma_addr))
-		goto err_out;
+	if (put_user(size, &req->capacity))
+		return -EFAULT;
 
-	if (!(iommu_present(xdpu->dev->bus)))
-		pb->phy_addr = pb->dma_addr;
-	else
-		pb->phy_addr = get_pa(pb->cpu_addr);
+	pb = xlnx_dpu_bo_create(xdpu, size);
+	if (IS_ERR(pb))
+		return -EFAULT;
 
-	mutex_lock(&xdpu->mutex);
-	list_add(&pb->head, &client->head);
-	mutex_unlock(&xdpu->mutex);
+	if (put_user(pb->dma_addr, &req->dma_addr) ||
+	    xlnx_dpu_bo_add(client, pb)) {
+		kref_put(&pb->ref, xlnx_dpu_bo_release);
+		return -EFAULT;
+	}
 
 	return 0;
-err_out:
-	dma_free_attrs(xdpu->dev, pb->size, pb->cpu_addr, pb->dma_addr,
-		       pb->attrs);
-err_pb:
-	kfree(pb);
-	return -EFAULT;
 }
 
 /**
@@ -487,12 +1257,8 @@ static long xlnx_dpu_free_bo(struct xdpu_client *client,
 
 	mutex_lock(&xdpu->mutex);
 	list_for_each_entry_safe(h, n, &client->head, head) {
-		if (in_range(dma_addr, h->dma_addr, h->size)) {
-			dma_free_attrs(xdpu->dev, h->size, h->cpu_addr,
-				       h->dma_addr, h->attrs);
-			list_del(&h->head);
-			kfree(h);
-		}
+		if (in_range(dma_addr, h->dma_addr, h->size))
+			xlnx_dpu_bo_remove(client, h);
 	}
 	mutex_unlock(&xdpu->mutex);
 
@@ -527,16 +1293,7 @@ static inline long xlnx_dpu_sync_bo(struct xdpu_client *client,
 	mutex_lock(&xdpu->mutex);
 	list_for_each_entry_safe(h, n, &client->head, head) {
 		if (in_range(dma_addr, h->dma_addr, h->size)) {
-			if (dir == DPU_TO_CPU)
-				dma_sync_single_for_cpu(xdpu->dev,
-							h->phy_addr,
-							size,
-							DMA_FROM_DEVICE);
-			else
-				dma_sync_single_for_device(xdpu->dev,
-							   h->phy_addr,
-							   size,
-							   DMA_TO_DEVICE);
+			xlnx_dpu_bo_sync(xdpu, h, 0, size, dir);
 			break;
 		}
 	}
@@ -545,6 +1302,371 @@ static inline long xlnx_dpu_sync_bo(struct xdpu_client *client,
 	return 0;
 }
 
+/*
+ * Handle based buffer objects: the blocks of a client are also indexed by
+ * handle, which makes the lookup O(1), and can be shared with other
+ * devices as dma-bufs in both directions.
+ */
+
+static int xlnx_dpu_dmabuf_attach(struct dma_buf *dmabuf,
+				  struct dma_buf_attachment *attach)
+{
+	struct dpu_buffer_block *pb = dmabuf->priv;
+	struct sg_table *sgt;
+	int ret;
+
+	sgt = kzalloc(sizeof(*sgt), GFP_KERNEL);
+	if (!sgt)
+		return -ENOMEM;
+
+	ret = dma_get_sgtable_attrs(pb->xdpu->dev, sgt, pb->cpu_addr,
+				    pb->dma_addr, pb->size, pb->attrs);
+	if (ret < 0) {
+		kfree(sgt);
+		return ret;
+	}
+
+	attach->priv = sgt;
+
+	return 0;
+}
+
+static void xlnx_dpu_dmabuf_detach(struct dma_buf *dmabuf,
+				   struct dma_buf_attachment *attach)
+{
+	struct sg_table *sgt = attach->priv;
+
+	sg_free_table(sgt);
+	kfree(sgt);
+}
+
+static struct sg_table *
+xlnx_dpu_dmabuf_map(struct dma_buf_attachment *attach,
+		    enum dma_data_direction dir)
+{
+	struct sg_table *sgt = attach->priv;
+	int ret;
+
+	ret = dma_map_sgtable(attach->dev, sgt, dir, 0);
+	if (ret)
+		return ERR_PTR(ret);
+
+	return sgt;
+}
+
+static void xlnx_dpu_dmabuf_unmap(struct dma_buf_attachment *attach,
+				  struct sg_table *sgt,
+				  enum dma_data_direction dir)
+{
+	dma_unmap_sgtable(attach->dev, sgt, dir, 0);
+}
+
+static int xlnx_dpu_dmabuf_mmap(struct dma_buf *dmabuf,
+				struct vm_area_struct *vma)
+{
+	struct dpu_buffer_block *pb = dmabuf->priv;
+
+	return dma_mmap_attrs(pb->xdpu->dev, vma, pb->cpu_addr, pb->dma_addr,
+			      pb->size, pb->attrs);
+}
+
+static int xlnx_dpu_dmabuf_vmap(struct dma_buf *dmabuf, struct iosys_map *map)
+{
+	struct dpu_buffer_block *pb = dmabuf->priv;
+
+	iosys_map_set_vaddr(map, pb->cpu_addr);
+
+	return 0;
+}
+
+static void xlnx_dpu_dmabuf_release(struct dma_buf *dmabuf)
+{
+	struct dpu_buffer_block *pb = dmabuf->priv;
+
+	kref_put(&pb->ref, xlnx_dpu_bo_release);
+}
+
+static const struct dma_buf_ops xlnx_dpu_dmabuf_ops = {
+	.attach = xlnx_dpu_dmabuf_attach,
+	.detach = xlnx_dpu_dmabuf_detach,
+	.map_dma_buf = xlnx_dpu_dmabuf_map,
+	.unmap_dma_buf = xlnx_dpu_dmabuf_unmap,
+	.mmap = xlnx_dpu_dmabuf_mmap,
+	.vmap = xlnx_dpu_dmabuf_vmap,
+	.release = xlnx_dpu_dmabuf_release,
+};
+
+/**
+ * xlnx_dpu_create_bo_handle - alloc a buffer block returning a handle
+ * @client:	dpu client
+ * @arg:	dpu_req_bo struct, contains the request info
+ *
+ * Return:	0 if successful; otherwise -errno
+ */
+static long xlnx_dpu_create_bo_handle(struct xdpu_client *client,
+				      struct dpu_req_bo __user *arg)
+{
+	struct xdpu_dev *xdpu = client->dev;
+	struct dpu_buffer_block *pb;
+	struct dpu_req_bo req;
+	int ret;
+
+	if (copy_from_user(&req, arg, sizeof(req)))
+		return -EFAULT;
+
+	if (!req.size || req.size > SIZE_MAX - PAGE_SIZE)
+		return -EINVAL;
+
+	pb = xlnx_dpu_bo_create(xdpu, req.size);
+	if (IS_ERR(pb))
+		return PTR_ERR(pb);
+
+	ret = xlnx_dpu_bo_add(client, pb);
+	if (ret) {
+		kref_put(&pb->ref, xlnx_dpu_bo_release);
+		return ret;
+	}
+
+	req.handle = pb->handle;
+	req.dma_addr = pb->dma_addr;
+	if (copy_to_user(arg, &req, sizeof(req))) {
+		mutex_lock(&xdpu->mutex);
+		xlnx_dpu_bo_remove(client, pb);
+		mutex_unlock(&xdpu->mutex);
+		return -EFAULT;
+	}
+
+	return 0;
+}
+
+/**
+ * xlnx_dpu_sgt_contiguous - check if a mapping is contiguous for the dpu
+ * @sgt:	mapped scatter-gather table
+ *
+ * Return:	true if the whole table is a single range of device addresses
+ */
+static bool xlnx_dpu_sgt_contiguous(struct sg_table *sgt)
+{
+	dma_addr_t next = sg_dma_address(sgt->sgl);
+	struct scatterlist *sg;
+	unsigned int i;
+
+	for_each_sgtable_dma_sg(sgt, sg, i) {
+		if (sg_dma_address(sg) != next)
+			return false;
+		next += sg_dma_len(sg);
+	}
+
+	return true;
+}
+
+/**
+ * xlnx_dpu_import_bo - import a dma-buf as a buffer block
+ * @client:	dpu client
+ * @arg:	dpu_req_bo struct, contains the request info
+ *
+ * The dma-buf is mapped once for the dpu, it must be contiguous in the dpu
+ * address space, which any buffer is when the dpu is behind an IOMMU.
+ *
+ * Return:	0 if successful; otherwise -errno
+ */
+static long xlnx_dpu_import_bo(struct xdpu_client *client,
+			       struct dpu_req_bo __user *arg)
+{
+	struct xdpu_dev *xdpu = client->dev;
+	struct dpu_buffer_block *pb;
+	struct dpu_req_bo req;
+	int ret;
+
+	if (copy_from_user(&req, arg, sizeof(req)))
+		return -EFAULT;
+
+	pb = kzalloc(sizeof(*pb), GFP_KERNEL);
+	if (!pb)
+		return -ENOMEM;
+
+	kref_init(&pb->ref);
+	pb->xdpu = xdpu;
+
+	pb->dmabuf = dma_buf_get(req.fd);
+	if (IS_ERR(pb->dmabuf)) {
+		ret = PTR_ERR(pb->dmabuf);
+		goto err_free;
+	}
+
+	pb->attach = dma_buf_attach(pb->dmabuf, xdpu->dev);
+	if (IS_ERR(pb->attach)) {
+		ret = PTR_ERR(pb->attach);
+		goto err_put;
+	}
+
+	pb->sgt = dma_buf_map_attachment(pb->attach, DMA_BIDIRECTIONAL);
+	if (IS_ERR(pb->sgt)) {
+		ret = PTR_ERR(pb->sgt);
+		goto err_detach;
+	}
+
+	if (!xlnx_dpu_sgt_contiguous(pb->sgt)) {
+		dev_dbg(xdpu->dev, "imported dma-buf isn't contiguous\n");
+		ret = -EINVAL;
+		goto err_unmap;
+	}
+
+	pb->size = pb->dmabuf->size;
+	pb->dma_addr = sg_dma_address(pb->sgt->sgl);
+	pb->phy_addr = pb->dma_addr;
+
+	/* From now on the block release undoes the import */
+	ret = xlnx_dpu_bo_add(client, pb);
+	if (ret) {
+		kref_put(&pb->ref, xlnx_dpu_bo_release);
+		return ret;
+	}
+
+	req.handle = pb->handle;
+	req.size = pb->size;
+	req.dma_addr = pb->dma_addr;
+	if (copy_to_user(arg, &req, sizeof(req))) {
+		mutex_lock(&xdpu->mutex);
+		xlnx_dpu_bo_remove(client, pb);
+		mutex_unlock(&xdpu->mutex);
+		return -EFAULT;
+	}
+
+	return 0;
+
+err_unmap:
+	dma_buf_unmap_attachment(pb->attach, pb->sgt, DMA_BIDIRECTIONAL);
+err_detach:
+	dma_buf_detach(pb->dmabuf, pb->attach);
+err_put:
+	dma_buf_put(pb->dmabuf);
+err_free:
+	kfree(pb);
+
+	return ret;
+}
+
+/**
+ * xlnx_dpu_export_bo - export a buffer block as a dma-buf
+ * @client:	dpu client
+ * @arg:	dpu_req_bo struct, contains the request info
+ *
+ * The dma-buf keeps the memory alive after the block is closed.
+ *
+ * Return:	0 if successful; otherwise -errno
+ */
+static long xlnx_dpu_export_bo(struct xdpu_client *client,
+			       struct dpu_req_bo __user *arg)
+{
+	DEFINE_DMA_BUF_EXPORT_INFO(exp_info);
+	struct dpu_buffer_block *pb;
+	struct dma_buf *dmabuf;
+	struct dpu_req_bo req;
+	int fd;
+
+	if (copy_from_user(&req, arg, sizeof(req)))
+		return -EFAULT;
+
+	if (req.flags & ~(O_CLOEXEC | O_ACCMODE))
+		return -EINVAL;
+
+	pb = xlnx_dpu_bo_get(client, req.handle);
+	if (!pb)
+		return -ENOENT;
+
+	/* Imported blocks are shared through their original dma-buf */
+	if (pb->dmabuf) {
+		kref_put(&pb->ref, xlnx_dpu_bo_release);
+		return -EINVAL;
+	}
+
+	exp_info.ops = &xlnx_dpu_dmabuf_ops;
+	exp_info.size = pb->size;
+	exp_info.flags = req.flags;
+	exp_info.priv = pb;
+
+	/* The reference taken by the lookup now belongs to the dma-buf */
+	dmabuf = dma_buf_export(&exp_info);
+	if (IS_ERR(dmabuf)) {
+		kref_put(&pb->ref, xlnx_dpu_bo_release);
+		return PTR_ERR(dmabuf);
+	}
+
+	fd = dma_buf_fd(dmabuf, req.flags & O_CLOEXEC);
+	if (fd < 0) {
+		dma_buf_put(dmabuf);
+		return fd;
+	}
+
+	if (put_user(fd, &arg->fd))
+		return -EFAULT;
+
+	return 0;
+}
+
+/**
+ * xlnx_dpu_close_bo - close the handle of a buffer block
+ * @client:	dpu client
+ * @arg:	dpu_req_bo struct, contains the handle
+ *
+ * Return:	0 if successful; otherwise -errno
+ */
+static long xlnx_dpu_close_bo(struct xdpu_client *client,
+			      struct dpu_req_bo __user *arg)
+{
+	struct xdpu_dev *xdpu = client->dev;
+	struct dpu_buffer_block *pb;
+	u32 handle;
+
+	if (get_user(handle, &arg->handle))
+		return -EFAULT;
+
+	mutex_lock(&xdpu->mutex);
+	pb = xa_load(&client->bos, handle);
+	if (pb)
+		xlnx_dpu_bo_remove(client, pb);
+	mutex_unlock(&xdpu->mutex);
+
+	return pb ? 0 : -ENOENT;
+}
+
+/**
+ * xlnx_dpu_sync_bo_handle - flush/invalidate cache for a buffer block
+ * @client:	dpu client
+ * @arg:	dpu_req_sync_bo struct, contains the request info
+ *
+ * Return:	0 if successful; otherwise -errno
+ */
+static long xlnx_dpu_sync_bo_handle(struct xdpu_client *client,
+				    struct dpu_req_sync_bo __user *arg)
+{
+	struct xdpu_dev *xdpu = client->dev;
+	struct dpu_buffer_block *pb;
+	struct dpu_req_sync_bo req;
+	long ret = 0;
+
+	if (copy_from_user(&req, arg, sizeof(req)))
+		return -EFAULT;
+
+	if (req.direction != DPU_TO_CPU && req.direction != CPU_TO_DPU)
+		return -EINVAL;
+
+	pb = xlnx_dpu_bo_get(client, req.handle);
+	if (!pb)
+		return -ENOENT;
+
+	if (req.size > pb->size || req.offset > pb->size - req.size)
+		ret = -EINVAL;
+	else
+		xlnx_dpu_bo_sync(xdpu, pb, req.offset, req.size,
+				 req.direction);
+
+	kref_put(&pb->ref, xlnx_dpu_bo_release);
+
+	return ret;
+}
+
 /**
  * xlnx_dpu_ioctl - control ioctls for the DPU
  * @file:	file handle of the DPU device
@@ -575,6 +1697,7 @@ static long xlnx_dpu_ioctl(struct file *file, unsigned int cmd,
 	case DPUIOC_RUN:
 	{
 		struct ioc_kernel_run_t t;
+		unsigned long flags;
 		int id;
 
 		if (copy_from_user(&t, data,
@@ -594,9 +1717,17 @@ static long xlnx_dpu_ioctl(struct file *file, unsigned int cmd,
 		id = array_index_nospec(id, xdpu->dpu_cnt);
 		/* Allows one process to run the cu by using a mutex */
 		mutex_lock(&xdpu->cu[id].mutex);
+		/* Wait for the asynchronous job running on the cu, if any */
+		wait_event(xdpu->cu_wq, xlnx_dpu_claim_cu(xdpu, id));
 
 		ret = xlnx_dpu_run(xdpu, &t, id);
 
+		spin_lock_irqsave(&xdpu->job_lock, flags);
+		xlnx_dpu_account(&xdpu->cu[id], t.time_end - t.time_start, 0,
+				 t.counter, ret);
+		spin_unlock_irqrestore(&xdpu->job_lock, flags);
+
+		xlnx_dpu_release_cu(xdpu, id);
 		mutex_unlock(&xdpu->cu[id].mutex);
 
 		if (copy_to_user(data, &t, sizeof(struct ioc_kernel_run_t)))
@@ -604,6 +1735,27 @@ static long xlnx_dpu_ioctl(struct file *file, unsigned int cmd,
 
 		break;
 	}
+	case DPUIOC_SUBMIT:
+		return xlnx_dpu_submit(client,
+				       (struct ioc_submit_t __user *)arg);
+	case DPUIOC_GET_DONE:
+		return xlnx_dpu_get_done(file, client,
+					 (struct ioc_job_done_t __user *)arg);
+	case DPUIOC_CREATE_BO_HANDLE:
+		return xlnx_dpu_create_bo_handle(client,
+				(struct dpu_req_bo __user *)arg);
+	case DPUIOC_IMPORT_BO:
+		return xlnx_dpu_import_bo(client,
+					  (struct dpu_req_bo __user *)arg);
+	case DPUIOC_EXPORT_BO:
+		return xlnx_dpu_export_bo(client,
+					  (struct dpu_req_bo __user *)arg);
+	case DPUIOC_CLOSE_BO:
+		return xlnx_dpu_close_bo(client,
+					 (struct dpu_req_bo __user *)arg);
+	case DPUIOC_SYNC_BO_HANDLE:
+		return xlnx_dpu_sync_bo_handle(client,
+				(struct dpu_req_sync_bo __user *)arg);
 	case DPUIOC_CREATE_BO:
 		return xlnx_dpu_alloc_bo(client,
 					 (struct dpcma_req_alloc __user *)arg);
@@ -639,9 +1791,13 @@ static long xlnx_dpu_ioctl(struct file *file, unsigned int cmd,
 		}
 
 		mutex_lock(&xdpu->cu[xdpu->dpu_cnt].mutex);
+		/* Wait for the chained softmax of a job, if any */
+		wait_event(xdpu->cu_wq,
+			   xlnx_dpu_claim_cu(xdpu, xdpu->dpu_cnt));
 
 		ret = xlnx_dpu_softmax(xdpu, &t);
 
+		xlnx_dpu_release_cu(xdpu, xdpu->dpu_cnt);
 		mutex_unlock(&xdpu->cu[xdpu->dpu_cnt].mutex);
 
 		break;
@@ -682,18 +1838,45 @@ static irqreturn_t xlnx_dpu_isr(int irq, void *data)
 	int i;
 
 	for (i = 0; i < xdpu->dpu_cnt; i++) {
-		if (irq == xdpu->cu[i].irq) {
+		struct cu *cu = &xdpu->cu[i];
+
+		if (irq == cu->irq) {
 			xlnx_dpu_int_clear(xdpu, i);
 			dev_dbg(xdpu->dev, "%s: DPU=%d IRQ=%d",
 				__func__, i, irq);
-			complete(&xdpu->cu[i].done);
+
+			spin_lock(&xdpu->job_lock);
+			if (cu->job) {
+				/* Complete and start the next job right away */
+				del_timer(&cu->timer);
+				xlnx_dpu_job_done(xdpu, cu, 0);
+				xlnx_dpu_dispatch(xdpu);
+				spin_unlock(&xdpu->job_lock);
+				continue;
+			}
+			spin_unlock(&xdpu->job_lock);
+
+			complete(&cu->done);
 		}
 	}
 
 	if (irq == xdpu->cu[xdpu->dpu_cnt].irq) {
+		struct cu *cu = &xdpu->cu[xdpu->dpu_cnt];
+
 		xlnx_sfm_int_clear(xdpu);
 		dev_dbg(xdpu->dev, "%s: softmax IRQ=%d", __func__, irq);
-		complete(&xdpu->cu[xdpu->dpu_cnt].done);
+
+		spin_lock(&xdpu->job_lock);
+		if (cu->job) {
+			del_timer(&cu->timer);
+			xlnx_dpu_job_done(xdpu, cu, 0);
+			xlnx_dpu_dispatch(xdpu);
+			spin_unlock(&xdpu->job_lock);
+			return IRQ_HANDLED;
+		}
+		spin_unlock(&xdpu->job_lock);
+
+		complete(&cu->done);
 	}
 
 	return IRQ_HANDLED;
@@ -726,7 +1909,8 @@ static int xlnx_dpu_mmap(struct file *file, struct vm_area_struct *vma)
 
 	mutex_lock(&xdpu->mutex);
 	list_for_each_entry_safe(h, n, &client->head, head) {
-		if (in_range(offset, h->dma_addr, h->size)) {
+		/* Imported buffers are mapped through their dma-buf */
+		if (!h->dmabuf && in_range(offset, h->dma_addr, h->size)) {
 			found = 1;
 			break;
 		}
@@ -743,6 +1927,25 @@ static int xlnx_dpu_mmap(struct file *file, struct vm_area_struct *vma)
 			size, 0);
 }
 
+/**
+ * xlnx_dpu_poll - wait for asynchronous job completion
+ * @file:	file structure for the device
+ * @wait:	poll table
+ *
+ * Return:	EPOLLIN if DPUIOC_GET_DONE can retrieve a completed job
+ */
+static __poll_t xlnx_dpu_poll(struct file *file, poll_table *wait)
+{
+	struct xdpu_client *client = file->private_data;
+
+	poll_wait(file, &client->done_wq, wait);
+
+	if (!list_empty_careful(&client->done_list))
+		return EPOLLIN | EPOLLRDNORM;
+
+	return 0;
+}
+
 /**
  * xlnx_dpu_open - open dpu device
  * @inode:	inode object
@@ -761,6 +1964,9 @@ static int xlnx_dpu_open(struct inode *inode, struct file *filp)
 	xdpu = container_of(filp->private_data, struct xdpu_dev, miscdev);
 	client->dev = xdpu;
 	INIT_LIST_HEAD(&client->head);
+	INIT_LIST_HEAD(&client->done_list);
+	init_waitqueue_head(&client->done_wq);
+	xa_init_flags(&client->bos, XA_FLAGS_ALLOC1);
 
 	filp->private_data = client;
 
@@ -788,19 +1994,16 @@ static int xlnx_dpu_release(struct inode *inode, struct file *filp)
 	struct xdpu_client *p = NULL, *t = NULL;
 #endif
 
+	/* The buffers may only be freed once the cu are done with them */
+	xlnx_dpu_cancel_jobs(xdpu, client);
+
 	mutex_lock(&xdpu->mutex);
 	/* Drain the remaining buffer entries when abnormal close */
 	if (!list_empty(&client->head)) {
-		list_for_each_entry_safe(h, n, &client->head, head) {
-			dma_free_attrs(xdpu->dev,
-				       h->size,
-				       h->cpu_addr,
-				       h->dma_addr,
-				       h->attrs);
-			list_del(&h->head);
-			kfree(h);
-		};
+		list_for_each_entry_safe(h, n, &client->head, head)
+			xlnx_dpu_bo_remove(client, h);
 	}
+	xa_destroy(&client->bos);
 
 #ifdef CONFIG_DEBUG_FS
 	list_for_each_entry_safe(p, t, &xdpu->client_list, node) {
@@ -821,6 +2024,7 @@ static const struct file_operations dev_fops = {
 	.open = xlnx_dpu_open,
 	.mmap = xlnx_dpu_mmap,
 	.unlocked_ioctl = xlnx_dpu_ioctl,
+	.poll = xlnx_dpu_poll,
 	.release = xlnx_dpu_release,
 };
 
@@ -980,10 +2184,18 @@ static int xlnx_dpu_probe(struct platform_device *pdev)
 			goto err_out;
 
 	mutex_init(&xdpu->mutex);
+	spin_lock_init(&xdpu->job_lock);
+	spin_lock_init(&xdpu->fence_lock);
+	INIT_LIST_HEAD(&xdpu->job_queue);
+	INIT_LIST_HEAD(&xdpu->sfm_queue);
+	init_waitqueue_head(&xdpu->cu_wq);
 
 	for (i = 0; i < xdpu->dpu_cnt + xdpu->sfm_cnt; i++) {
 		init_completion(&xdpu->cu[i].done);
 		mutex_init(&xdpu->cu[i].mutex);
+		xdpu->cu[i].xdpu = xdpu;
+		xdpu->cu[i].id = i;
+		timer_setup(&xdpu->cu[i].timer, xlnx_dpu_job_timeout, 0);
 	}
 
 	xdpu->miscdev.minor = MISC_DYNAMIC_MINOR;
@@ -1037,6 +2249,9 @@ static int xlnx_dpu_remove(struct platform_device *pdev)
 	struct xdpu_dev *xdpu = platform_get_drvdata(pdev);
 	int i;
 
+	for (i = 0; i < xdpu->dpu_cnt + xdpu->sfm_cnt; i++)
+		del_timer_sync(&xdpu->cu[i].timer);
+
 	/* clean all regs */
 	for (i = 0; i < DPU_REG_END; i += 4)
 		iowrite32(0, xdpu->regs + i);
@@ -1309,6 +2524,41 @@ static int dump_show(struct seq_file *seq, void *v)
 }
 DEFINE_SHOW_ATTRIBUTE(dump);
 
+static int stats_show(struct seq_file *seq, void *v)
+{
+	struct cu *cu = seq->private;
+	struct xdpu_dev *xdpu = cu->xdpu;
+	u64 jobs, errors, cycles, busy_ns, wait_ns, wait_max_ns;
+	unsigned long flags;
+
+	spin_lock_irqsave(&xdpu->job_lock, flags);
+	jobs = cu->jobs;
+	errors = cu->errors;
+	cycles = cu->cycles;
+	busy_ns = cu->busy_ns;
+	wait_ns = cu->wait_ns;
+	wait_max_ns = cu->wait_max_ns;
+	spin_unlock_irqrestore(&xdpu->job_lock, flags);
+
+	seq_printf(seq, "jobs:\t\t%llu\n", jobs);
+	seq_printf(seq, "timeouts:\t%llu\n", errors);
+	if (cu->id < xdpu->dpu_cnt)
+		seq_printf(seq, "cycles:\t\t%llu\n", cycles);
+	seq_printf(seq, "busy_us:\t%llu\n", div_u64(busy_ns, NSEC_PER_USEC));
+	seq_printf(seq, "wait_us:\t%llu\n", div_u64(wait_ns, NSEC_PER_USEC));
+	seq_printf(seq, "wait_max_us:\t%llu\n",
+		   div_u64(wait_max_ns, NSEC_PER_USEC));
+	if (jobs) {
+		seq_printf(seq, "avg_busy_us:\t%llu\n",
+			   div64_u64(busy_ns, jobs * NSEC_PER_USEC));
+		seq_printf(seq, "avg_wait_us:\t%llu\n",
+			   div64_u64(wait_ns, jobs * NSEC_PER_USEC));
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(stats);
+
 /**
  * dpu_debugfs_init - create DPU debugfs directory.
  * @xdpu:	dpu structure
@@ -1346,6 +2596,8 @@ static int dpu_debugfs_init(struct xdpu_dev *xdpu)
 		regset->nregs = ARRAY_SIZE(cu_regs[i]);
 		regset->base = xdpu->regs;
 		debugfs_create_regset32("registers", 0444, dentry, regset);
+		debugfs_create_file("stats", 0444, dentry, &xdpu->cu[i],
+				    &stats_fops);
 	}
 
 	if (xdpu->sfm_cnt) {
@@ -1358,6 +2610,8 @@ static int dpu_debugfs_init(struct xdpu_dev *xdpu)
 		regset->nregs = ARRAY_SIZE(sfm_regs);
 		regset->base = xdpu->regs;
 		debugfs_create_regset32("registers", 0444, dentry, regset);
+		debugfs_create_file("stats", 0444, dentry,
+				    &xdpu->cu[xdpu->dpu_cnt], &stats_fops);
 	}
 	return 0;
 }
@@ -1366,3 +2620,4 @@ static int dpu_debugfs_init(struct xdpu_dev *xdpu)
 MODULE_DESCRIPTION(DRIVER_DESC);
 MODULE_AUTHOR("Ye Yang <ye.yang@xilinx.com>");
 MODULE_LICENSE("GPL v2");
+MODULE_IMPORT_NS(DMA_BUF);
@@ -121,6 +121,38 @@ struct dpcma_req_sync {
 	int direction;
 };
 
+/**
+ * struct  dpu_req_bo - describe structure for each handle based bo ioctl
+ * @handle:	bo handle, output of create and import, input otherwise
+ * @fd:	dma-buf fd, input of import, output of export
+ * @size:	bo size, input of create, output otherwise
+ * @dma_addr:	output, device address of the bo
+ * @flags:	O_CLOEXEC and access mode of the exported dma-buf
+ * @reserved:	reserved, zero
+ */
+struct dpu_req_bo {
+	u32 handle;
+	s32 fd;
+	u64 size;
+	u64 dma_addr;
+	u32 flags;
+	u32 reserved;
+};
+
+/**
+ * struct  dpu_req_sync_bo - describe structure for each handle based sync
+ * @handle:	bo handle
+ * @direction:	CPU_TO_DPU or DPU_TO_CPU
+ * @offset:	offset of the range to sync in the bo
+ * @size:	size of the range to sync
+ */
+struct dpu_req_sync_bo {
+	u32 handle;
+	s32 direction;
+	u64 offset;
+	u64 size;
+};
+
 /**
  * struct  ioc_kernel_run_t - describe structure for each dpu ioctl
  * @addr_code:	the address for DPU code
@@ -187,6 +219,55 @@ struct ioc_softmax_t {
 	u32 offset;
 };
 
+/* core_id of an asynchronous job to run it on the first idle cu */
+#define DPU_CORE_ANY		(-1)
+
+/* return a sync_file fd signalled when the job completes */
+#define DPU_SUBMIT_FENCE_OUT	BIT(0)
+/* run the softmax core once the job completes, before signalling it */
+#define DPU_SUBMIT_SOFTMAX	BIT(1)
+
+/**
+ * struct  ioc_submit_t - describe structure for each dpu submission
+ * @run:	the job to run, core_id is a cu index or DPU_CORE_ANY
+ * @user_data:	value handed back with the job result
+ * @seqno:	output, sequence number of the job for the client
+ * @flags:	DPU_SUBMIT_* flags
+ * @fence_fd:	output, sync_file fd if DPU_SUBMIT_FENCE_OUT, -1 otherwise
+ * @softmax:	the softmax to run if DPU_SUBMIT_SOFTMAX
+ */
+struct ioc_submit_t {
+	struct ioc_kernel_run_t run;
+	u64 user_data;
+	u64 seqno;
+	u32 flags;
+	s32 fence_fd;
+	struct ioc_softmax_t softmax;
+};
+
+/**
+ * struct  ioc_job_done_t - describe structure for each completed job
+ * @run:	the job, with the results filled in as for DPUIOC_RUN
+ * @user_data:	user_data value of the submission
+ * @seqno:	sequence number of the job
+ * @status:	0 on success, -ETIMEDOUT if the cu or the softmax timed out
+ * @reserved:	reserved, zero
+ * @time_submit:	the submission timestamp, run.time_start - time_submit
+ *		is the time the job waited for a cu
+ * @sfm_start:	the softmax start timestamp, 0 without DPU_SUBMIT_SOFTMAX
+ * @sfm_end:	the softmax end timestamp, 0 without DPU_SUBMIT_SOFTMAX
+ */
+struct ioc_job_done_t {
+	struct ioc_kernel_run_t run;
+	u64 user_data;
+	u64 seqno;
+	s32 status;
+	u32 reserved;
+	u64 time_submit;
+	u64 sfm_start;
+	u64 sfm_end;
+};
+
 #define DPU_IOC_MAGIC 'D'
 
 #define DPUIOC_CREATE_BO _IOWR(DPU_IOC_MAGIC, 1, struct dpcma_req_alloc*)
@@ -197,5 +278,12 @@ struct ioc_softmax_t {
 #define DPUIOC_RUN _IOWR(DPU_IOC_MAGIC, 6, struct ioc_kernel_run_t*)
 #define DPUIOC_RUN_SOFTMAX _IOWR(DPU_IOC_MAGIC, 7, struct ioc_softmax_t*)
 #define DPUIOC_REG_READ _IOR(DPU_IOC_MAGIC, 8, u32)
+#define DPUIOC_SUBMIT _IOWR(DPU_IOC_MAGIC, 9, struct ioc_submit_t*)
+#define DPUIOC_GET_DONE _IOR(DPU_IOC_MAGIC, 10, struct ioc_job_done_t*)
+#define DPUIOC_CREATE_BO_HANDLE _IOWR(DPU_IOC_MAGIC, 11, struct dpu_req_bo*)
+#define DPUIOC_IMPORT_BO _IOWR(DPU_IOC_MAGIC, 12, struct dpu_req_bo*)
+#define DPUIOC_EXPORT_BO _IOWR(DPU_IOC_MAGIC, 13, struct dpu_req_bo*)
+#define DPUIOC_CLOSE_BO _IOW(DPU_IOC_MAGIC, 14, struct dpu_req_bo*)
+#define DPUIOC_SYNC_BO_HANDLE _IOW(DPU_IOC_MAGIC, 15, struct dpu_req_sync_bo*)
 
 #endif /* _DPU_UAPI_H_ */
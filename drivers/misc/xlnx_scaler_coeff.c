@@ -0,0 +1,388 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Xilinx polyphase scaler coefficient library
+ *
+ * Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+ *
+ * The VPSS scaler, the multi-scaler and the legacy video scaler all program
+ * polyphase filter coefficients into a memory of the IP. The fixed filters
+ * only depend on the number of taps of the IP and on the range the scaling
+ * ratio falls in, so every combination is packed into register words once
+ * at boot. Drivers then only copy the selected table to the hardware, and
+ * skip even that when the table is already loaded.
+ */
+
+#include <linux/bug.h>
+#include <linux/export.h>
+#include <linux/fixp-arith.h>
+#include <linux/init.h>
+#include <linux/io.h>
+#include <linux/kernel.h>
+#include <linux/minmax.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/xlnx/xlnx_scaler_coeff.h>
+
+#define XSCALER_PHASES		XLNX_SCALER_COEFF_PHASES
+#define XSCALER_MAX_TAPS	XLNX_SCALER_COEFF_MAX_TAPS
+#define XSCALER_TAPS_6		6
+#define XSCALER_TAPS_8		8
+#define XSCALER_TAPS_10		10
+#define XSCALER_TAPS_12		12
+#define XSCALER_NUM_TAPS	4
+
+#define XSCALER_TAPS_IDX(t)	(((t) - XSCALER_TAPS_6) / 2)
+
+#include "xlnx_scaler_coeff_msc.h"
+#include "xlnx_scaler_coeff_vpss.h"
+
+/*
+ * Filters by effective number of taps and bank. The effective number of
+ * taps of a bank is the lower of the taps of the IP and the taps of the
+ * bank, the remaining taps being zero-padded. This selection gives optimal
+ * video output determined by repeated testing of the IPs.
+ */
+static const unsigned int xscaler_bank_taps[XLNX_SCALER_COEFF_NUM_BANKS] = {
+	[XLNX_SCALER_COEFF_BANK_UP] = XSCALER_TAPS_6,
+	[XLNX_SCALER_COEFF_BANK_SR1P2] = XSCALER_TAPS_6,
+	[XLNX_SCALER_COEFF_BANK_SR2] = XSCALER_TAPS_8,
+	[XLNX_SCALER_COEFF_BANK_SR3] = XSCALER_TAPS_10,
+	[XLNX_SCALER_COEFF_BANK_SR4] = XSCALER_TAPS_12,
+};
+
+static const s16 *const
+xscaler_filters[XLNX_SCALER_COEFF_NUM_SETS][XSCALER_NUM_TAPS]
+	       [XLNX_SCALER_COEFF_NUM_BANKS] = {
+	[XLNX_SCALER_COEFF_VPSS] = {
+		[XSCALER_TAPS_IDX(XSCALER_TAPS_6)] = {
+			&XV_lanczos2_taps6[0][0],
+			&XV_fixedcoeff_taps6_SR1p2[0][0],
+			&XV_fixedcoeff_taps6_SR2[0][0],
+			&XV_fixedcoeff_taps6_SR3[0][0],
+			&XV_fixedcoeff_taps6_SR4[0][0],
+		},
+		[XSCALER_TAPS_IDX(XSCALER_TAPS_8)] = {
+			[XLNX_SCALER_COEFF_BANK_SR2] =
+				&XV_fixedcoeff_taps8_SR2[0][0],
+			[XLNX_SCALER_COEFF_BANK_SR3] =
+				&XV_fixedcoeff_taps8_SR3[0][0],
+			[XLNX_SCALER_COEFF_BANK_SR4] =
+				&XV_fixedcoeff_taps8_SR4[0][0],
+		},
+		[XSCALER_TAPS_IDX(XSCALER_TAPS_10)] = {
+			[XLNX_SCALER_COEFF_BANK_SR3] =
+				&XV_fixedcoeff_taps10_SR3[0][0],
+			[XLNX_SCALER_COEFF_BANK_SR4] =
+				&XV_fixedcoeff_taps10_SR4[0][0],
+		},
+		[XSCALER_TAPS_IDX(XSCALER_TAPS_12)] = {
+			[XLNX_SCALER_COEFF_BANK_SR4] =
+				&XV_fixedcoeff_taps12_SR4[0][0],
+		},
+	},
+	[XLNX_SCALER_COEFF_MSC_H] = {
+		[XSCALER_TAPS_IDX(XSCALER_TAPS_6)] = {
+			&xhsc_coeff_taps6[0][0], &xhsc_coeff_taps6[0][0],
+			&xhsc_coeff_taps6[0][0], &xhsc_coeff_taps6[0][0],
+			&xhsc_coeff_taps6[0][0],
+		},
+		[XSCALER_TAPS_IDX(XSCALER_TAPS_8)] = {
+			[XLNX_SCALER_COEFF_BANK_SR2] = &xhsc_coeff_taps8[0][0],
+			[XLNX_SCALER_COEFF_BANK_SR3] = &xhsc_coeff_taps8[0][0],
+			[XLNX_SCALER_COEFF_BANK_SR4] = &xhsc_coeff_taps8[0][0],
+		},
+		[XSCALER_TAPS_IDX(XSCALER_TAPS_10)] = {
+			[XLNX_SCALER_COEFF_BANK_SR3] = &xhsc_coeff_taps10[0][0],
+			[XLNX_SCALER_COEFF_BANK_SR4] = &xhsc_coeff_taps10[0][0],
+		},
+		[XSCALER_TAPS_IDX(XSCALER_TAPS_12)] = {
+			[XLNX_SCALER_COEFF_BANK_SR4] = &xhsc_coeff_taps12[0][0],
+		},
+	},
+	[XLNX_SCALER_COEFF_MSC_V] = {
+		[XSCALER_TAPS_IDX(XSCALER_TAPS_6)] = {
+			&xvsc_coeff_taps6[0][0], &xvsc_coeff_taps6[0][0],
+			&xvsc_coeff_taps6[0][0], &xvsc_coeff_taps6[0][0],
+			&xvsc_coeff_taps6[0][0],
+		},
+		[XSCALER_TAPS_IDX(XSCALER_TAPS_8)] = {
+			[XLNX_SCALER_COEFF_BANK_SR2] = &xvsc_coeff_taps8[0][0],
+			[XLNX_SCALER_COEFF_BANK_SR3] = &xvsc_coeff_taps8[0][0],
+			[XLNX_SCALER_COEFF_BANK_SR4] = &xvsc_coeff_taps8[0][0],
+		},
+		[XSCALER_TAPS_IDX(XSCALER_TAPS_10)] = {
+			[XLNX_SCALER_COEFF_BANK_SR3] = &xvsc_coeff_taps10[0][0],
+			[XLNX_SCALER_COEFF_BANK_SR4] = &xvsc_coeff_taps10[0][0],
+		},
+		[XSCALER_TAPS_IDX(XSCALER_TAPS_12)] = {
+			[XLNX_SCALER_COEFF_BANK_SR4] = &xvsc_coeff_taps12[0][0],
+		},
+	},
+};
+
+/* Packed tables by set, taps of the IP and bank, built at boot */
+static const u32 *
+xscaler_words[XLNX_SCALER_COEFF_NUM_SETS][XSCALER_NUM_TAPS]
+	     [XLNX_SCALER_COEFF_NUM_BANKS];
+
+/**
+ * xlnx_scaler_coeff_bank - Select the coefficient bank for a scaling ratio
+ * @in: input size
+ * @out: output size
+ *
+ * Return: the bank used to scale from @in to @out
+ */
+enum xlnx_scaler_coeff_bank xlnx_scaler_coeff_bank(u32 in, u32 out)
+{
+	u16 scale_ratio;
+
+	if (out >= in)
+		return XLNX_SCALER_COEFF_BANK_UP;
+
+	scale_ratio = (in * 10) / out;
+	if (scale_ratio > 35)
+		return XLNX_SCALER_COEFF_BANK_SR4;
+	if (scale_ratio > 25)
+		return XLNX_SCALER_COEFF_BANK_SR3;
+	if (scale_ratio > 15)
+		return XLNX_SCALER_COEFF_BANK_SR2;
+
+	return XLNX_SCALER_COEFF_BANK_SR1P2;
+}
+EXPORT_SYMBOL_GPL(xlnx_scaler_coeff_bank);
+
+/**
+ * xlnx_scaler_coeff_get - Get a precomputed coefficient table
+ * @set: family of filter coefficients
+ * @taps: number of taps of the scaler (6, 8, 10 or 12)
+ * @bank: range of scaling ratio
+ *
+ * The table holds xlnx_scaler_coeff_nwords(@taps, XLNX_SCALER_COEFF_PHASES)
+ * words laid out phase after phase, so a scaler with fewer phases uses the
+ * head of the table. Banks with equal content share the same table.
+ *
+ * Return: the packed table, or NULL on an unsupported number of taps
+ */
+const u32 *xlnx_scaler_coeff_get(enum xlnx_scaler_coeff_set set,
+				 unsigned int taps,
+				 enum xlnx_scaler_coeff_bank bank)
+{
+	if (set >= XLNX_SCALER_COEFF_NUM_SETS ||
+	    bank >= XLNX_SCALER_COEFF_NUM_BANKS ||
+	    taps < XSCALER_TAPS_6 || taps > XSCALER_TAPS_12 || taps % 2)
+		return NULL;
+
+	return xscaler_words[set][XSCALER_TAPS_IDX(taps)][bank];
+}
+EXPORT_SYMBOL_GPL(xlnx_scaler_coeff_get);
+
+/**
+ * xlnx_scaler_coeff_load - Program a coefficient table unless loaded
+ * @cache: coefficient memory tracking of the scaler
+ * @addr: base of the coefficient memory
+ * @words: packed table from xlnx_scaler_coeff_get()
+ * @nwords: number of words to program
+ *
+ * Return: true if the table was written, or false if it was already loaded
+ */
+bool xlnx_scaler_coeff_load(struct xlnx_scaler_coeff_cache *cache,
+			    void __iomem *addr, const u32 *words,
+			    unsigned int nwords)
+{
+	if (cache->words == words)
+		return false;
+
+	__iowrite32_copy(addr, words, nwords);
+	cache->words = words;
+
+	return true;
+}
+EXPORT_SYMBOL_GPL(xlnx_scaler_coeff_load);
+
+/* Fixed point operations */
+#define FRAC_N	8
+
+static inline s16 fixp_new(s16 a)
+{
+	return a << FRAC_N;
+}
+
+static inline s16 fixp_mult(s16 a, s16 b)
+{
+	return ((s32)(a * b)) >> FRAC_N;
+}
+
+/**
+ * lanczos - Lanczos 2D FIR kernel convolution
+ * @x: phase
+ * @a: Lanczos kernel size
+ *
+ * Return: the coefficient value in fixed point format.
+ */
+static s16 lanczos(s16 x, s16 a)
+{
+	s16 pi;
+	s16 numerator;
+	s16 denominator;
+	s16 temp;
+
+	if (x < -a || x > a)
+		return 0;
+	else if (x == 0)
+		return fixp_new(1);
+
+	/* a * sin(pi * x) * sin(pi * x / a) / (pi * pi * x * x) */
+
+	pi = (fixp_new(157) << FRAC_N) / fixp_new(50);
+
+	if (x < 0)
+		x = -x;
+
+	/* sin(pi * x) */
+	temp = fixp_mult(fixp_new(180), x);
+	temp = fixp_sin16(temp >> FRAC_N);
+
+	/* a * sin(pi * x) */
+	numerator = fixp_mult(temp, a);
+
+	/* sin(pi * x / a) */
+	temp = (fixp_mult(fixp_new(180), x) << FRAC_N) / a;
+	temp = fixp_sin16(temp >> FRAC_N);
+
+	/* a * sin(pi * x) * sin(pi * x / a) */
+	numerator = fixp_mult(temp, numerator);
+
+	/* pi * pi * x * x */
+	denominator = fixp_mult(pi, pi);
+	temp = fixp_mult(x, x);
+	denominator = fixp_mult(temp, denominator);
+
+	return (numerator << FRAC_N) / denominator;
+}
+
+/**
+ * xlnx_scaler_coeff_lanczos - Generate a Lanczos coefficient table
+ * @taps: number of taps
+ * @phases: number of phases
+ * @nwords: number of words of the returned table
+ *
+ * Generate the coefficient table using Lanczos resampling, packed two
+ * coefficients per word. The generated coefficients are supposed to work
+ * regardless of resolutions. The caller frees the table with kfree().
+ *
+ * Return: the packed table, or NULL if memory allocation fails.
+ */
+u32 *xlnx_scaler_coeff_lanczos(unsigned int taps, unsigned int phases,
+			       unsigned int *nwords)
+{
+	s16 *coef;
+	s16 dy;
+	u32 *words, *val;
+	unsigned int i, j;
+
+	*nwords = phases * DIV_ROUND_UP(taps, 2);
+	words = kcalloc(*nwords, sizeof(*words), GFP_KERNEL);
+	coef = kcalloc(taps, sizeof(*coef), GFP_KERNEL);
+	if (!words || !coef) {
+		kfree(coef);
+		kfree(words);
+		return NULL;
+	}
+
+	val = words;
+	for (i = 0; i < phases; i++) {
+		s16 sum = 0;
+
+		dy = ((fixp_new(i) << FRAC_N) / fixp_new(phases));
+
+		/* Generate Lanczos coefficients */
+		for (j = 0; j < taps; j++) {
+			coef[j] = lanczos(fixp_new(j - (taps >> 1)) + dy,
+					  fixp_new(taps >> 1));
+			sum += coef[j];
+		}
+
+		/* Normalize and multiply coefficients */
+		for (j = 0; j < taps; j += 2) {
+			*val = (((coef[j] << FRAC_N) << (FRAC_N - 2)) /
+				sum) & 0xffff;
+			if (j + 1 < taps)
+				*val |= ((((coef[j + 1] << FRAC_N) <<
+					   (FRAC_N - 2)) / sum) & 0xffff) << 16;
+			val++;
+		}
+	}
+
+	kfree(coef);
+
+	return words;
+}
+EXPORT_SYMBOL_GPL(xlnx_scaler_coeff_lanczos);
+
+/*
+ * Pack a filter of @ntaps effective taps for a scaler of @taps taps, two
+ * coefficients per word, zero-padding both sides of every phase.
+ */
+static void xscaler_pack(u32 *words, const s16 *coeff, unsigned int ntaps,
+			 unsigned int taps)
+{
+	unsigned int offset = (taps - ntaps) / 2;
+	s16 row[XSCALER_MAX_TAPS];
+	unsigned int i, j;
+
+	for (i = 0; i < XSCALER_PHASES; i++) {
+		memset(row, 0, sizeof(row));
+		memcpy(&row[offset], &coeff[i * ntaps], ntaps * sizeof(*coeff));
+		for (j = 0; j < taps; j += 2)
+			*words++ = ((u32)(u16)row[j + 1] << 16) | (u16)row[j];
+	}
+}
+
+static int __init xscaler_build_tables(unsigned int set, unsigned int taps)
+{
+	unsigned int idx = XSCALER_TAPS_IDX(taps);
+	unsigned int nwords = xlnx_scaler_coeff_nwords(taps, XSCALER_PHASES);
+	const s16 *coeff, *prev = NULL;
+	unsigned int bank, ntaps;
+	u32 *words;
+
+	for (bank = 0; bank < XLNX_SCALER_COEFF_NUM_BANKS; bank++) {
+		ntaps = min(taps, xscaler_bank_taps[bank]);
+		coeff = xscaler_filters[set][XSCALER_TAPS_IDX(ntaps)][bank];
+
+		/* Consecutive banks using the same filter share a table */
+		if (coeff == prev) {
+			xscaler_words[set][idx][bank] =
+				xscaler_words[set][idx][bank - 1];
+			continue;
+		}
+
+		words = kcalloc(nwords, sizeof(*words), GFP_KERNEL);
+		if (!words)
+			return -ENOMEM;
+
+		xscaler_pack(words, coeff, ntaps, taps);
+		xscaler_words[set][idx][bank] = words;
+		prev = coeff;
+	}
+
+	return 0;
+}
+
+static int __init xlnx_scaler_coeff_init(void)
+{
+	unsigned int set, taps;
+	int ret;
+
+	for (set = 0; set < XLNX_SCALER_COEFF_NUM_SETS; set++) {
+		for (taps = XSCALER_TAPS_6; taps <= XSCALER_TAPS_12;
+		     taps += 2) {
+			ret = xscaler_build_tables(set, taps);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+subsys_initcall(xlnx_scaler_coeff_init);
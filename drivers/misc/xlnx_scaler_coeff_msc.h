@@ -8,28 +8,11 @@
  *
  * The file contains the coefficients used by the Xilinx
  * Video Multi Scaler Controller driver (xm2msc)
- *
  */
 
-#define XSCALER_MAX_PHASES	(64)
-#define XSCALER_MAX_TAPS	(12)
-
-#define XSCALER_TAPS_6		(6)
-#define XSCALER_TAPS_8		(8)
-#define XSCALER_TAPS_10		(10)
-#define XSCALER_TAPS_12		(12)
-
-/* Filter bank ID for various filter tap configurations */
-enum xm2mvsc_filter_bank_id {
-	FILTER_BANK_TAPS_6 = 0,
-	FILTER_BANK_TAPS_8,
-	FILTER_BANK_TAPS_10,
-	FILTER_BANK_TAPS_12,
-};
-
 /* H-scaler coefficients for 6, 8, 10 and 12 tap filters */
 static const short
-xhsc_coeff_taps6[XSCALER_MAX_PHASES][XSCALER_TAPS_6] = {
+xhsc_coeff_taps6[XSCALER_PHASES][XSCALER_TAPS_6] = {
 	{  -132,   236,  3824,   236,  -132,    64, },
 	{  -116,   184,  3816,   292,  -144,    64, },
 	{  -100,   132,  3812,   348,  -160,    64, },
@@ -97,7 +80,7 @@ xhsc_coeff_taps6[XSCALER_MAX_PHASES][XSCALER_TAPS_6] = {
 };
 
 static const short
-xhsc_coeff_taps8[XSCALER_MAX_PHASES][XSCALER_TAPS_8] = {
+xhsc_coeff_taps8[XSCALER_PHASES][XSCALER_TAPS_8] = {
 	{-5, 309, 1023, 1445, 1034, 317, -3, -24, },
 	{-6, 300, 1011, 1445, 1045, 326, -1, -24, },
 	{-7, 291, 1000, 1444, 1056, 336, 0, -24, },
@@ -165,7 +148,7 @@ xhsc_coeff_taps8[XSCALER_MAX_PHASES][XSCALER_TAPS_8] = {
 };
 
 static const short
-xhsc_coeff_taps10[XSCALER_MAX_PHASES][XSCALER_TAPS_10] = {
+xhsc_coeff_taps10[XSCALER_PHASES][XSCALER_TAPS_10] = {
 	{59, 224, 507, 790, 911, 793, 512, 227, 61, 13, },
 	{58, 220, 502, 786, 911, 797, 516, 231, 62, 13, },
 	{56, 216, 497, 783, 911, 800, 521, 235, 64, 13, },
@@ -233,7 +216,7 @@ xhsc_coeff_taps10[XSCALER_MAX_PHASES][XSCALER_TAPS_10] = {
 };
 
 static const short
-xhsc_coeff_taps12[XSCALER_MAX_PHASES][XSCALER_TAPS_12] = {
+xhsc_coeff_taps12[XSCALER_PHASES][XSCALER_TAPS_12] = {
 	{48, 143, 307, 504, 667, 730, 669, 507, 310, 145, 49, 18, },
 	{47, 141, 304, 501, 665, 730, 670, 510, 313, 147, 50, 18, },
 	{46, 138, 301, 498, 663, 730, 672, 513, 316, 149, 51, 18, },
@@ -302,7 +285,7 @@ xhsc_coeff_taps12[XSCALER_MAX_PHASES][XSCALER_TAPS_12] = {
 
 /* V-scaler coefficients for 6, 8, 10 and 12 tap filters */
 static const short
-xvsc_coeff_taps6[XSCALER_MAX_PHASES][XSCALER_TAPS_6] = {
+xvsc_coeff_taps6[XSCALER_PHASES][XSCALER_TAPS_6] = {
 	{-132, 236, 3824, 236, -132, 64, },
 	{-116, 184, 3816, 292, -144, 64, },
 	{-100, 132, 3812, 348, -160, 64, },
@@ -370,7 +353,7 @@ xvsc_coeff_taps6[XSCALER_MAX_PHASES][XSCALER_TAPS_6] = {
 };
 
 static const short
-xvsc_coeff_taps8[XSCALER_MAX_PHASES][XSCALER_TAPS_8] = {
+xvsc_coeff_taps8[XSCALER_PHASES][XSCALER_TAPS_8] = {
 	{-5, 309, 1023, 1445, 1034, 317, -3, -24, },
 	{-6, 300, 1011, 1445, 1045, 326, -1, -24, },
 	{-7, 291, 1000, 1444, 1056, 336, 0, -24, },
@@ -438,7 +421,7 @@ xvsc_coeff_taps8[XSCALER_MAX_PHASES][XSCALER_TAPS_8] = {
 };
 
 static const short
-xvsc_coeff_taps10[XSCALER_MAX_PHASES][XSCALER_TAPS_10] = {
+xvsc_coeff_taps10[XSCALER_PHASES][XSCALER_TAPS_10] = {
 	{59, 224, 507, 790, 911, 793, 512, 227, 61, 13, },
 	{58, 220, 502, 786, 911, 797, 516, 231, 62, 13, },
 	{56, 216, 497, 783, 911, 800, 521, 235, 64, 13, },
@@ -506,7 +489,7 @@ xvsc_coeff_taps10[XSCALER_MAX_PHASES][XSCALER_TAPS_10] = {
 };
 
 static const short
-xvsc_coeff_taps12[XSCALER_MAX_PHASES][XSCALER_TAPS_12] = {
+xvsc_coeff_taps12[XSCALER_PHASES][XSCALER_TAPS_12] = {
 	{48, 143, 307, 504, 667, 730, 669, 507, 310, 145, 49, 18, },
 	{47, 141, 304, 501, 665, 730, 670, 510, 313, 147, 50, 18, },
 	{46, 138, 301, 498, 663, 730, 672, 513, 316, 149, 51, 18, },
@@ -20,6 +20,7 @@
 #include <linux/module.h>
 #include <linux/of_device.h>
 #include <linux/phy/phy.h>
+#include <linux/pm_runtime.h>
 #include <linux/regmap.h>
 #include <linux/reset.h>
 #include <linux/of.h>
@@ -41,6 +42,7 @@
 #define VENDOR_ENHANCED_STROBE		BIT(0)
 
 #define PHY_CLK_TOO_SLOW_HZ		400000
+#define SDHCI_ARASAN_AUTOSUSPEND_MS	50
 #define MIN_PHY_CLK_HZ			50000000
 
 #define SDHCI_ITAPDLY_CHGWIN		0x200
@@ -153,6 +155,10 @@ struct sdhci_arasan_clk_ops {
  * @clk_phase_out:	Array of Output Clock Phase Delays for all speed modes
  * @set_clk_delays:	Function pointer for setting Clock Delays
  * @clk_of_data:	Platform specific runtime clock data storage pointer
+ * @delays_valid:	True if @delays_in/@delays_out are programmed in hardware
+ * @delays_timing:	Timing mode the programmed delays belong to
+ * @delays_in:		Input Clock Phase Delay last programmed
+ * @delays_out:		Output Clock Phase Delay last programmed
  */
 struct sdhci_arasan_clk_data {
 	struct clk_hw	sdcardclk_hw;
@@ -163,6 +169,10 @@ struct sdhci_arasan_clk_data {
 	int		clk_phase_out[MMC_TIMING_MMC_HS400 + 1];
 	void		(*set_clk_delays)(struct sdhci_host *host);
 	void		*clk_of_data;
+	bool		delays_valid;
+	unsigned char	delays_timing;
+	int		delays_in;
+	int		delays_out;
 };
 
 /**
@@ -484,6 +494,10 @@ static void sdhci_arasan_reset(struct sdhci_host *host, u8 mask)
 
 	sdhci_and_cqhci_reset(host, mask);
 
+	/* A full reset may drop the tap delays of an internal PHY */
+	if (mask & SDHCI_RESET_ALL)
+		sdhci_arasan->clk_data.delays_valid = false;
+
 	if (sdhci_arasan->quirks & SDHCI_ARASAN_QUIRK_FORCE_CDTEST) {
 		ctrl = sdhci_readb(host, SDHCI_HOST_CONTROL);
 		ctrl |= SDHCI_CTRL_CDTEST_INS | SDHCI_CTRL_CDTEST_EN;
@@ -604,6 +618,9 @@ static int sdhci_arasan_suspend(struct device *dev)
 	struct sdhci_arasan_data *sdhci_arasan = sdhci_pltfm_priv(pltfm_host);
 	int ret;
 
+	/* Make sure the clocks are running before touching the controller */
+	pm_runtime_resume(dev);
+
 	if (host->tuning_mode != SDHCI_TUNING_MODE_3)
 		mmc_retune_needed(host->mmc);
 
@@ -650,6 +667,9 @@ static int sdhci_arasan_resume(struct device *dev)
 	struct sdhci_arasan_data *sdhci_arasan = sdhci_pltfm_priv(pltfm_host);
 	int ret;
 
+	/* The firmware may have reset the tap delays while we were away */
+	sdhci_arasan->clk_data.delays_valid = false;
+
 	ret = clk_enable(sdhci_arasan->clk_ahb);
 	if (ret) {
 		dev_err(dev, "Cannot enable AHB clock.\n");
@@ -684,8 +704,84 @@ static int sdhci_arasan_resume(struct device *dev)
 }
 #endif /* ! CONFIG_PM_SLEEP */
 
-static SIMPLE_DEV_PM_OPS(sdhci_arasan_dev_pm_ops, sdhci_arasan_suspend,
-			 sdhci_arasan_resume);
+#ifdef CONFIG_PM
+/**
+ * sdhci_arasan_runtime_suspend - Runtime suspend method for the driver
+ * @dev:	Address of the device structure
+ *
+ * Gate the controller clocks while the host is idle. The tuning result and
+ * the tap delays are kept, so no retuning is needed on runtime resume.
+ *
+ * Return: 0 on success and error value on error
+ */
+static int sdhci_arasan_runtime_suspend(struct device *dev)
+{
+	struct sdhci_host *host = dev_get_drvdata(dev);
+	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
+	struct sdhci_arasan_data *sdhci_arasan = sdhci_pltfm_priv(pltfm_host);
+	int ret;
+
+	if (sdhci_arasan->has_cqe) {
+		ret = cqhci_suspend(host->mmc);
+		if (ret)
+			return ret;
+	}
+
+	ret = sdhci_runtime_suspend_host(host);
+	if (ret)
+		return ret;
+
+	clk_disable(pltfm_host->clk);
+	clk_disable(sdhci_arasan->clk_ahb);
+
+	return 0;
+}
+
+/**
+ * sdhci_arasan_runtime_resume - Runtime resume method for the driver
+ * @dev:	Address of the device structure
+ *
+ * Ungate the controller clocks and restore the host state with a soft
+ * reset, which leaves the tuned sampling point in place.
+ *
+ * Return: 0 on success and error value on error
+ */
+static int sdhci_arasan_runtime_resume(struct device *dev)
+{
+	struct sdhci_host *host = dev_get_drvdata(dev);
+	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
+	struct sdhci_arasan_data *sdhci_arasan = sdhci_pltfm_priv(pltfm_host);
+	int ret;
+
+	ret = clk_enable(sdhci_arasan->clk_ahb);
+	if (ret) {
+		dev_err(dev, "Cannot enable AHB clock.\n");
+		return ret;
+	}
+
+	ret = clk_enable(pltfm_host->clk);
+	if (ret) {
+		dev_err(dev, "Cannot enable SD clock.\n");
+		clk_disable(sdhci_arasan->clk_ahb);
+		return ret;
+	}
+
+	ret = sdhci_runtime_resume_host(host, 1);
+	if (ret)
+		return ret;
+
+	if (sdhci_arasan->has_cqe)
+		return cqhci_resume(host->mmc);
+
+	return 0;
+}
+#endif /* ! CONFIG_PM */
+
+static const struct dev_pm_ops sdhci_arasan_dev_pm_ops = {
+	SET_SYSTEM_SLEEP_PM_OPS(sdhci_arasan_suspend, sdhci_arasan_resume)
+	SET_RUNTIME_PM_OPS(sdhci_arasan_runtime_suspend,
+			   sdhci_arasan_runtime_resume, NULL)
+};
 
 /**
  * sdhci_arasan_sdcardclk_recalc_rate - Return the card clock rate
@@ -1230,11 +1326,24 @@ static void sdhci_arasan_set_clk_delays(struct sdhci_host *host)
 	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
 	struct sdhci_arasan_data *sdhci_arasan = sdhci_pltfm_priv(pltfm_host);
 	struct sdhci_arasan_clk_data *clk_data = &sdhci_arasan->clk_data;
+	int phase_in = clk_data->clk_phase_in[host->timing];
+	int phase_out = clk_data->clk_phase_out[host->timing];
 
-	clk_set_phase(clk_data->sampleclk,
-		      clk_data->clk_phase_in[host->timing]);
-	clk_set_phase(clk_data->sdcardclk,
-		      clk_data->clk_phase_out[host->timing]);
+	/*
+	 * Every clock change lands here. On ZynqMP and Versal each phase is
+	 * a firmware call, so skip them when nothing would change.
+	 */
+	if (clk_data->delays_valid && clk_data->delays_timing == host->timing &&
+	    clk_data->delays_in == phase_in && clk_data->delays_out == phase_out)
+		return;
+
+	clk_set_phase(clk_data->sampleclk, phase_in);
+	clk_set_phase(clk_data->sdcardclk, phase_out);
+
+	clk_data->delays_valid = true;
+	clk_data->delays_timing = host->timing;
+	clk_data->delays_in = phase_in;
+	clk_data->delays_out = phase_out;
 }
 
 static void arasan_dt_read_clk_phase(struct device *dev,
@@ -1443,7 +1552,7 @@ static const struct sdhci_pltfm_data sdhci_arasan_zynqmp_pdata = {
 };
 
 static const struct sdhci_pltfm_data sdhci_arasan_versal_net_pdata = {
-	.ops = &sdhci_arasan_ops,
+	.ops = &sdhci_arasan_cqe_ops,
 	.quirks2 = SDHCI_QUIRK2_PRESET_VALUE_BROKEN |
 			SDHCI_QUIRK2_CLOCK_DIV_ZERO_BROKEN |
 			SDHCI_QUIRK2_STOP_WITH_TC |
@@ -2022,19 +2131,38 @@ static int sdhci_arasan_probe(struct platform_device *pdev)
 		host->mmc_host_ops.start_signal_voltage_switch =
 					sdhci_arasan_voltage_switch;
 		sdhci_arasan->has_cqe = true;
+	}
+
+	if (of_device_is_compatible(np, "xlnx,versal-net-5.1-emmc")) {
+		sdhci_arasan->internal_phy_reg = true;
+		host->mmc_host_ops.hs400_enhanced_strobe =
+					sdhci_arasan_hs400_enhanced_strobe;
+		sdhci_arasan->has_cqe = true;
+	}
+
+	if (sdhci_arasan->has_cqe) {
 		host->mmc->caps2 |= MMC_CAP2_CQE;
 
 		if (!of_property_read_bool(np, "disable-cqe-dcmd"))
 			host->mmc->caps2 |= MMC_CAP2_CQE_DCMD;
 	}
 
-	if (of_device_is_compatible(np, "xlnx,versal-net-5.1-emmc"))
-		sdhci_arasan->internal_phy_reg = true;
-
 	ret = sdhci_arasan_add_host(sdhci_arasan);
 	if (ret)
 		goto err_add_host;
 
+	/*
+	 * Only a soldered-down device can gate its clocks at runtime; a
+	 * removable slot has to keep card detection running.
+	 */
+	if (!mmc_card_is_removable(host->mmc)) {
+		pm_runtime_set_active(dev);
+		pm_runtime_set_autosuspend_delay(dev,
+						 SDHCI_ARASAN_AUTOSUSPEND_MS);
+		pm_runtime_use_autosuspend(dev);
+		pm_runtime_enable(dev);
+	}
+
 	return 0;
 
 err_add_host:
@@ -2058,6 +2186,10 @@ static int sdhci_arasan_remove(struct platform_device *pdev)
 	struct sdhci_arasan_data *sdhci_arasan = sdhci_pltfm_priv(pltfm_host);
 	struct clk *clk_ahb = sdhci_arasan->clk_ahb;
 
+	pm_runtime_get_sync(&pdev->dev);
+	pm_runtime_disable(&pdev->dev);
+	pm_runtime_put_noidle(&pdev->dev);
+
 	if (!IS_ERR(sdhci_arasan->phy)) {
 		if (sdhci_arasan->is_phy_on)
 			phy_power_off(sdhci_arasan->phy);
@@ -13,11 +13,13 @@
 #include <linux/bch.h>
 #include <linux/bitfield.h>
 #include <linux/clk.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/dma-mapping.h>
 #include <linux/gpio/consumer.h>
 #include <linux/interrupt.h>
 #include <linux/iopoll.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/mtd/mtd.h>
 #include <linux/mtd/partitions.h>
@@ -167,6 +169,10 @@ struct anfc_op {
  * @cs_idx:		Array of chip-select for this device, values are indexes
  *			of the controller structure @gpio_cs array
  * @ncs_idx:		Size of the @cs_idx array
+ * @rd_pkt_reg:		Packet register value reading a page and its OOB area
+ *			in a single transfer, 0 if the size does not fit
+ * @rd_pages:		Number of pages read with the hardware ECC path
+ * @rd_ns:		Time spent reading and correcting those pages
  */
 struct anand {
 	struct list_head node;
@@ -187,6 +193,9 @@ struct anand {
 	struct bch_control *bch;
 	int *cs_idx;
 	int ncs_idx;
+	u32 rd_pkt_reg;
+	u64 rd_pages;
+	u64 rd_ns;
 };
 
 /**
@@ -388,6 +397,10 @@ static int anfc_select_target(struct nand_chip *chip, int target)
  * The hardware BCH ECC engine is known to be inconstent in BCH mode and never
  * reports uncorrectable errors. Because of this bug, we have to use the
  * software BCH implementation in the read path.
+ *
+ * As the engine is not used, the page and its OOB area are fetched with a
+ * single DMA transfer into the page buffer whenever the packet configuration
+ * allows it, instead of a second change read column operation per page.
  */
 static int anfc_read_page_hw_ecc(struct nand_chip *chip, u8 *buf,
 				 int oob_required, int page)
@@ -397,6 +410,8 @@ static int anfc_read_page_hw_ecc(struct nand_chip *chip, u8 *buf,
 	struct anand *anand = to_anand(chip);
 	unsigned int len = mtd->writesize + (oob_required ? mtd->oobsize : 0);
 	unsigned int max_bitflips = 0;
+	u64 start = ktime_get_ns();
+	u8 *dma_buf = buf;
 	dma_addr_t dma_addr;
 	int step, ret;
 	struct anfc_op nfc_op = {
@@ -420,7 +435,13 @@ static int anfc_read_page_hw_ecc(struct nand_chip *chip, u8 *buf,
 		.prog_reg = PROG_PGRD,
 	};
 
-	dma_addr = dma_map_single(nfc->dev, (void *)buf, len, DMA_FROM_DEVICE);
+	if (anand->rd_pkt_reg) {
+		nfc_op.pkt_reg = anand->rd_pkt_reg;
+		dma_buf = chip->data_buf;
+		len = mtd->writesize + mtd->oobsize;
+	}
+
+	dma_addr = dma_map_single(nfc->dev, dma_buf, len, DMA_FROM_DEVICE);
 	if (dma_mapping_error(nfc->dev, dma_addr)) {
 		dev_err(nfc->dev, "Buffer mapping error");
 		return -EIO;
@@ -438,11 +459,20 @@ static int anfc_read_page_hw_ecc(struct nand_chip *chip, u8 *buf,
 		return ret;
 	}
 
-	/* Store the raw OOB bytes as well */
-	ret = nand_change_read_column_op(chip, mtd->writesize, chip->oob_poi,
-					 mtd->oobsize, 0);
-	if (ret)
-		return ret;
+	if (anand->rd_pkt_reg) {
+		/* The OOB bytes already are in chip->oob_poi */
+		if (buf != chip->data_buf) {
+			memcpy(buf, chip->data_buf, mtd->writesize);
+			chip->pagecache.page = -1;
+		}
+	} else {
+		/* Store the raw OOB bytes as well */
+		ret = nand_change_read_column_op(chip, mtd->writesize,
+						 chip->oob_poi, mtd->oobsize,
+						 0);
+		if (ret)
+			return ret;
+	}
 
 	/*
 	 * For each step, compute by softare the BCH syndrome over the raw data.
@@ -492,6 +522,9 @@ static int anfc_read_page_hw_ecc(struct nand_chip *chip, u8 *buf,
 		}
 	}
 
+	anand->rd_pages++;
+	anand->rd_ns += ktime_get_ns() - start;
+
 	return 0;
 }
 
@@ -1201,6 +1234,7 @@ static int anfc_attach_chip(struct nand_chip *chip)
 	struct anand *anand = to_anand(chip);
 	struct arasan_nfc *nfc = to_anfc(chip->controller);
 	struct mtd_info *mtd = nand_to_mtd(chip);
+	unsigned int steps, pktsize;
 	int ret = 0;
 
 	if (mtd->writesize <= SZ_512)
@@ -1236,6 +1270,10 @@ static int anfc_attach_chip(struct nand_chip *chip)
 		return -EINVAL;
 	}
 
+	if (!anfc_pkt_len_config(mtd->writesize + mtd->oobsize, &steps,
+				 &pktsize))
+		anand->rd_pkt_reg = PKT_SIZE(pktsize) | PKT_STEPS(steps);
+
 	/* These hooks are valid for all ECC providers */
 	chip->ecc.read_page_raw = nand_monolithic_read_page_raw;
 	chip->ecc.write_page_raw = nand_monolithic_write_page_raw;
@@ -1265,6 +1303,21 @@ static void anfc_detach_chip(struct nand_chip *chip)
 		bch_free(anand->bch);
 }
 
+static int anfc_read_stats_show(struct seq_file *s, void *data)
+{
+	struct anand *anand = s->private;
+	struct mtd_info *mtd = nand_to_mtd(&anand->chip);
+	u64 bytes = anand->rd_pages * mtd->writesize;
+
+	seq_printf(s, "pages:        %llu\n", anand->rd_pages);
+	seq_printf(s, "time (us):    %llu\n", div_u64(anand->rd_ns, 1000));
+	seq_printf(s, "rate (KiB/s): %llu\n", anand->rd_ns ?
+		   div64_u64(bytes * (NSEC_PER_SEC / SZ_1K), anand->rd_ns) : 0);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(anfc_read_stats);
+
 static const struct nand_controller_ops anfc_ops = {
 	.exec_op = anfc_exec_op,
 	.setup_interface = anfc_setup_interface,
@@ -1341,6 +1394,11 @@ static int anfc_chip_init(struct arasan_nfc *nfc, struct device_node *np)
 		return ret;
 	}
 
+	/* Removed along with the MTD debugfs directory */
+	if (!IS_ERR_OR_NULL(mtd->dbg.dfs_dir))
+		debugfs_create_file("read_stats", 0400, mtd->dbg.dfs_dir,
+				    anand, &anfc_read_stats_fops);
+
 	list_add_tail(&anand->node, &nfc->chips);
 
 	return 0;
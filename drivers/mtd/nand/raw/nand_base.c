@@ -3394,6 +3394,30 @@ static void nand_wait_readrdy(struct nand_chip *chip)
  *
  * Internal function. Called with chip held.
  */
+/*
+ * Let the controller stream the pages of a read spanning several pages with
+ * sequential cache reads, the NAND then loads the next page while the current
+ * one is transferred and checked.
+ */
+static void rawnand_enable_cont_reads(struct nand_chip *chip, unsigned int page,
+				      u32 readlen, int col)
+{
+	struct mtd_info *mtd = nand_to_mtd(chip);
+
+	chip->cont_read.ongoing = false;
+
+	if (!chip->controller->supported_op.cont_read ||
+	    !chip->parameters.supports_read_cache)
+		return;
+
+	if (col + readlen <= mtd->writesize)
+		return;
+
+	chip->cont_read.ongoing = true;
+	chip->cont_read.first_page = page;
+	chip->cont_read.last_page = page + (col + readlen - 1) / mtd->writesize;
+}
+
 static int nand_do_read_ops(struct nand_chip *chip, loff_t from,
 			    struct mtd_oob_ops *ops)
 {
@@ -3426,6 +3450,9 @@ static int nand_do_read_ops(struct nand_chip *chip, loff_t from,
 	oob = ops->oobbuf;
 	oob_required = oob ? 1 : 0;
 
+	if (likely(ops->mode != MTD_OPS_RAW))
+		rawnand_enable_cont_reads(chip, page, readlen, col);
+
 	while (1) {
 		struct mtd_ecc_stats ecc_stats = mtd->ecc_stats;
 
@@ -3553,6 +3580,7 @@ static int nand_do_read_ops(struct nand_chip *chip, loff_t from,
 			nand_select_target(chip, chipnr);
 		}
 	}
+	chip->cont_read.ongoing = false;
 	nand_deselect_target(chip);
 
 	ops->retlen = ops->len - (size_t) readlen;
@@ -11,6 +11,7 @@
  */
 
 #include <linux/amba/bus.h>
+#include <linux/debugfs.h>
 #include <linux/err.h>
 #include <linux/delay.h>
 #include <linux/interrupt.h>
@@ -18,6 +19,7 @@
 #include <linux/ioport.h>
 #include <linux/iopoll.h>
 #include <linux/irq.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/moduleparam.h>
 #include <linux/mtd/mtd.h>
@@ -115,6 +117,20 @@ struct pl35x_nand_timings {
 	unsigned int rsvd:8;
 };
 
+/**
+ * struct pl35x_nand - NAND chip related information
+ * @node: Used to store NAND chips into a list
+ * @chip: NAND chip information structure
+ * @cs: Chip select of the NAND chip
+ * @addr_cycles: Number of column and row address cycles
+ * @ecc_cfg: ECC configuration register value
+ * @timings: SMC cycles register value
+ * @cache_page: Page the NAND is loading ahead in a sequential cache read,
+ *		-1 if none
+ * @rd_pages: Number of pages read with the hardware ECC engine
+ * @rd_cached: Number of those pages streamed from the cache register
+ * @rd_ns: Time spent reading those pages
+ */
 struct pl35x_nand {
 	struct list_head node;
 	struct nand_chip chip;
@@ -122,6 +138,10 @@ struct pl35x_nand {
 	unsigned int addr_cycles;
 	u32 ecc_cfg;
 	u32 timings;
+	int cache_page;
+	u64 rd_pages;
+	u64 rd_cached;
+	u64 rd_ns;
 };
 
 /**
@@ -330,6 +350,51 @@ static void pl35x_nand_select_target(struct nand_chip *chip,
 	nfc->selected_chip = chip;
 }
 
+/*
+ * Issue a sequential cache read command: the NAND moves the page of its data
+ * register to the cache register, from where it is read out.
+ */
+static int pl35x_nand_cache_read_cmd(struct nand_chip *chip, u8 opcode)
+{
+	const struct nand_sdr_timings *sdr =
+		nand_get_sdr_timings(nand_get_interface_config(chip));
+	struct pl35x_nandc *nfc = to_pl35x_nandc(chip->controller);
+
+	writel(0, nfc->io_regs + (PL35X_SMC_CMD_PHASE |
+				  PL35X_SMC_CMD_PHASE_CMD0(opcode)));
+	ndelay(PSEC_TO_NSEC(sdr->tRR_min));
+
+	return pl35x_smc_wait_for_irq(nfc);
+}
+
+/* Leave the sequential cache read mode before any other operation */
+static int pl35x_nand_end_cache_read(struct nand_chip *chip)
+{
+	struct pl35x_nand *plnand = to_pl35x_nand(chip);
+
+	if (plnand->cache_page < 0)
+		return 0;
+
+	plnand->cache_page = -1;
+
+	return pl35x_nand_cache_read_cmd(chip, NAND_CMD_READCACHEEND);
+}
+
+/*
+ * Whether the read of @page should also start loading the next page. The
+ * sequences are kept within a block, hence never cross a LUN or a target.
+ */
+static bool pl35x_nand_cont_read(struct nand_chip *chip, int page)
+{
+	struct mtd_info *mtd = nand_to_mtd(chip);
+	unsigned int pages_per_block = mtd->erasesize / mtd->writesize;
+
+	return chip->cont_read.ongoing &&
+	       page >= chip->cont_read.first_page &&
+	       page < chip->cont_read.last_page &&
+	       (page + 1) % pages_per_block;
+}
+
 static void pl35x_nand_read_data_op(struct nand_chip *chip, u8 *in,
 				    unsigned int len, bool force_8bit,
 				    unsigned int flags, unsigned int last_flags)
@@ -514,6 +579,10 @@ static int pl35x_nand_write_page_hwecc(struct nand_chip *chip,
 	u32 cmd_addr;
 	int i, ret;
 
+	ret = pl35x_nand_end_cache_read(chip);
+	if (ret)
+		return ret;
+
 	ret = pl35x_smc_set_ecc_mode(nfc, chip, PL35X_SMC_ECC_CFG_MODE_APB);
 	if (ret)
 		return ret;
@@ -581,6 +650,11 @@ static int pl35x_nand_write_page_hwecc(struct nand_chip *chip,
  * and doing a last 4-byte transfer with the additional bit set. The last block
  * should be aligned with the end of an ECC block. Because of this limitation,
  * it is not possible to use the core routines.
+ *
+ * Within a continuous read, the NAND loads the next page with a sequential
+ * cache read while the current one is transferred and corrected. Each page of
+ * the cache register is read from column 0 after a change read column, which
+ * the ECC engine knows as the start of a read.
  */
 static int pl35x_nand_read_page_hwecc(struct nand_chip *chip,
 				      u8 *buf, int oob_required, int page)
@@ -593,38 +667,70 @@ static int pl35x_nand_read_page_hwecc(struct nand_chip *chip,
 	unsigned int first_row = (mtd->writesize <= 512) ? 1 : 2;
 	unsigned int nrows = plnand->addr_cycles;
 	unsigned int addr1 = 0, addr2 = 0, row;
+	bool cached = plnand->cache_page == page;
+	bool next = pl35x_nand_cont_read(chip, page);
+	u64 start = ktime_get_ns();
 	u32 cmd_addr;
 	int i, ret;
 
+	if (!cached) {
+		ret = pl35x_nand_end_cache_read(chip);
+		if (ret)
+			return ret;
+	}
+
 	ret = pl35x_smc_set_ecc_mode(nfc, chip, PL35X_SMC_ECC_CFG_MODE_APB);
 	if (ret)
 		return ret;
 
-	cmd_addr = PL35X_SMC_CMD_PHASE |
-		   PL35X_SMC_CMD_PHASE_NADDRS(plnand->addr_cycles) |
-		   PL35X_SMC_CMD_PHASE_CMD0(NAND_CMD_READ0) |
-		   PL35X_SMC_CMD_PHASE_CMD1(NAND_CMD_READSTART) |
-		   PL35X_SMC_CMD_PHASE_CMD1_VALID;
+	if (!cached) {
+		cmd_addr = PL35X_SMC_CMD_PHASE |
+			   PL35X_SMC_CMD_PHASE_NADDRS(plnand->addr_cycles) |
+			   PL35X_SMC_CMD_PHASE_CMD0(NAND_CMD_READ0) |
+			   PL35X_SMC_CMD_PHASE_CMD1(NAND_CMD_READSTART) |
+			   PL35X_SMC_CMD_PHASE_CMD1_VALID;
+
+		for (i = 0, row = first_row; row < nrows; i++, row++) {
+			u8 addr = page >> ((i * 8) & 0xFF);
+
+			if (row < 4)
+				addr1 |= PL35X_SMC_CMD_PHASE_ADDR(row, addr);
+			else
+				addr2 |= PL35X_SMC_CMD_PHASE_ADDR(row - 4,
+								  addr);
+		}
 
-	for (i = 0, row = first_row; row < nrows; i++, row++) {
-		u8 addr = page >> ((i * 8) & 0xFF);
+		/* Send the command and address cycles */
+		writel(addr1, nfc->io_regs + cmd_addr);
+		if (plnand->addr_cycles > 4)
+			writel(addr2, nfc->io_regs + cmd_addr);
 
-		if (row < 4)
-			addr1 |= PL35X_SMC_CMD_PHASE_ADDR(row, addr);
-		else
-			addr2 |= PL35X_SMC_CMD_PHASE_ADDR(row - 4, addr);
+		/* Wait the data to be available in the NAND cache */
+		ndelay(PSEC_TO_NSEC(sdr->tRR_min));
+		ret = pl35x_smc_wait_for_irq(nfc);
+		if (ret)
+			goto disable_ecc_engine;
 	}
 
-	/* Send the command and address cycles */
-	writel(addr1, nfc->io_regs + cmd_addr);
-	if (plnand->addr_cycles > 4)
-		writel(addr2, nfc->io_regs + cmd_addr);
-
-	/* Wait the data to be available in the NAND cache */
-	ndelay(PSEC_TO_NSEC(sdr->tRR_min));
-	ret = pl35x_smc_wait_for_irq(nfc);
-	if (ret)
-		goto disable_ecc_engine;
+	if (cached || next) {
+		/* Move the page to the cache register, maybe load the next */
+		plnand->cache_page = -1;
+		ret = pl35x_nand_cache_read_cmd(chip, next ?
+						NAND_CMD_READCACHESEQ :
+						NAND_CMD_READCACHEEND);
+		if (ret)
+			goto disable_ecc_engine;
+		if (next)
+			plnand->cache_page = page + 1;
+
+		writel(0, nfc->io_regs +
+		       (PL35X_SMC_CMD_PHASE |
+			PL35X_SMC_CMD_PHASE_NADDRS(first_row) |
+			PL35X_SMC_CMD_PHASE_CMD0(NAND_CMD_RNDOUT) |
+			PL35X_SMC_CMD_PHASE_CMD1(NAND_CMD_RNDOUTSTART) |
+			PL35X_SMC_CMD_PHASE_CMD1_VALID));
+		ndelay(PSEC_TO_NSEC(sdr->tCCS_min));
+	}
 
 	/* Retrieve the raw data with the engine enabled */
 	pl35x_nand_read_data_op(chip, buf, mtd->writesize, false,
@@ -644,7 +750,14 @@ static int pl35x_nand_read_page_hwecc(struct nand_chip *chip,
 	pl35x_smc_set_ecc_mode(nfc, chip, PL35X_SMC_ECC_CFG_MODE_BYPASS);
 
 	/* Correct the data and report failures */
-	return pl35x_nand_recover_data_hwecc(nfc, chip, buf, nfc->ecc_buf);
+	ret = pl35x_nand_recover_data_hwecc(nfc, chip, buf, nfc->ecc_buf);
+
+	plnand->rd_pages++;
+	if (cached)
+		plnand->rd_cached++;
+	plnand->rd_ns += ktime_get_ns() - start;
+
+	return ret;
 
 disable_ecc_engine:
 	pl35x_smc_set_ecc_mode(nfc, chip, PL35X_SMC_ECC_CFG_MODE_BYPASS);
@@ -767,8 +880,14 @@ static int pl35x_nfc_exec_op(struct nand_chip *chip,
 			     const struct nand_operation *op,
 			     bool check_only)
 {
-	if (!check_only)
+	int ret;
+
+	if (!check_only) {
 		pl35x_nand_select_target(chip, op->cs);
+		ret = pl35x_nand_end_cache_read(chip);
+		if (ret)
+			return ret;
+	}
 
 	return nand_op_parser_exec_op(chip, &pl35x_nandc_op_parser,
 				      op, check_only);
@@ -974,6 +1093,10 @@ static int pl35x_nand_attach_chip(struct nand_chip *chip)
 		ret = pl35x_nand_init_hw_ecc_controller(nfc, chip);
 		if (ret)
 			return ret;
+
+		/* The change read column needs large page column cycles */
+		if (mtd->writesize > SZ_512)
+			nfc->controller.supported_op.cont_read = 1;
 		break;
 	default:
 		dev_err(nfc->dev, "Unsupported ECC mode: %d\n",
@@ -984,6 +1107,22 @@ static int pl35x_nand_attach_chip(struct nand_chip *chip)
 	return 0;
 }
 
+static int pl35x_nand_read_stats_show(struct seq_file *s, void *data)
+{
+	struct pl35x_nand *plnand = s->private;
+	struct mtd_info *mtd = nand_to_mtd(&plnand->chip);
+	u64 bytes = plnand->rd_pages * mtd->writesize;
+
+	seq_printf(s, "pages:        %llu\n", plnand->rd_pages);
+	seq_printf(s, "cached pages: %llu\n", plnand->rd_cached);
+	seq_printf(s, "time (us):    %llu\n", div_u64(plnand->rd_ns, 1000));
+	seq_printf(s, "rate (KiB/s): %llu\n", plnand->rd_ns ?
+		   div64_u64(bytes * (NSEC_PER_SEC / SZ_1K), plnand->rd_ns) : 0);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(pl35x_nand_read_stats);
+
 static const struct nand_controller_ops pl35x_nandc_ops = {
 	.attach_chip = pl35x_nand_attach_chip,
 	.exec_op = pl35x_nfc_exec_op,
@@ -1055,6 +1194,7 @@ static int pl35x_nand_chip_init(struct pl35x_nandc *nfc,
 	}
 
 	plnand->cs = cs;
+	plnand->cache_page = -1;
 
 	chip = &plnand->chip;
 	chip->options = NAND_BUSWIDTH_AUTO | NAND_USES_DMA | NAND_NO_SUBPAGE_WRITE;
@@ -1082,6 +1222,11 @@ static int pl35x_nand_chip_init(struct pl35x_nandc *nfc,
 		return ret;
 	}
 
+	/* Removed along with the MTD debugfs directory */
+	if (!IS_ERR_OR_NULL(mtd->dbg.dfs_dir))
+		debugfs_create_file("read_stats", 0400, mtd->dbg.dfs_dir,
+				    plnand, &pl35x_nand_read_stats_fops);
+
 	list_add_tail(&plnand->node, &nfc->chips);
 
 	return ret;
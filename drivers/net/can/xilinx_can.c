@@ -13,11 +13,13 @@
 #include <linux/clk.h>
 #include <linux/errno.h>
 #include <linux/ethtool.h>
+#include <linux/hrtimer.h>
 #include <linux/init.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/kernel.h>
 #include <linux/module.h>
+#include <linux/net_tstamp.h>
 #include <linux/netdevice.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
@@ -51,6 +53,7 @@ enum xcan_reg {
 	XCAN_AFR_OFFSET		= 0x60, /* Acceptance Filter */
 
 	/* only on CAN FD cores */
+	XCAN_TSR_OFFSET		= 0x028, /* Timestamp */
 	XCAN_F_BRPR_OFFSET	= 0x088, /* Data Phase Baud Rate
 					  * Prescaler
 					  */
@@ -58,6 +61,7 @@ enum xcan_reg {
 	XCAN_TRR_OFFSET		= 0x0090, /* TX Buffer Ready Request */
 	XCAN_AFR_EXT_OFFSET	= 0x00E0, /* Acceptance Filter */
 	XCAN_FSR_OFFSET		= 0x00E8, /* RX FIFO Status */
+	XCAN_WIR_OFFSET		= 0x00EC, /* Watermark Interrupt */
 	XCAN_TXMSG_BASE_OFFSET	= 0x0100, /* TX Message Space */
 	XCAN_RXMSG_BASE_OFFSET	= 0x1100, /* RX Message Space */
 	XCAN_RXMSG_2_BASE_OFFSET	= 0x2100, /* RX Message Space */
@@ -80,7 +84,7 @@ enum xcan_reg {
 					 XCAN_CANFD_FRAME_SIZE * (n))
 
 /* the single TX mailbox used by this driver on CAN FD HW */
-#define XCAN_TX_MAILBOX_IDX		0
+#define XCAN_TX_MAILBOX_MAX		32
 
 /* CAN register bit masks - XCAN_<REG>_<BIT>_MASK */
 #define XCAN_SRR_CEN_MASK		0x00000002 /* CAN enable */
@@ -111,6 +115,7 @@ enum xcan_reg {
 #define XCAN_SR_LBACK_MASK		0x00000002 /* Loop back mode */
 #define XCAN_SR_CONFIG_MASK		0x00000001 /* Configuration mode */
 #define XCAN_IXR_RXMNF_MASK		0x00020000 /* RX match not finished */
+#define XCAN_IXR_RXFWMFLL_MASK		0x00008000 /* RX FIFO Watermark Full */
 #define XCAN_IXR_TXFEMP_MASK		0x00004000 /* TX FIFO Empty */
 #define XCAN_IXR_WKUP_MASK		0x00000800 /* Wake up interrupt */
 #define XCAN_IXR_SLP_MASK		0x00000400 /* Sleep interrupt */
@@ -135,6 +140,10 @@ enum xcan_reg {
 #define XCAN_2_FSR_RI_MASK		0x0000003F /* RX Read Index */
 #define XCAN_DLCR_EDL_MASK		0x08000000 /* EDL Mask in DLC */
 #define XCAN_DLCR_BRS_MASK		0x04000000 /* BRS Mask in DLC */
+#define XCAN_DLCR_TS_MASK		0x0000FFFF /* RX timestamp in DLC */
+#define XCAN_TSR_CNT_MASK		0xFFFF0000 /* Timestamp counter */
+#define XCAN_WIR_FW_MASK		0x0000001F /* RX FIFO Full watermark */
+#define XCAN_2_WIR_FW_MASK		0x0000003F /* RX FIFO Full watermark */
 
 /* CAN register bit shift - XCAN_<REG>_<BIT>_SHIFT */
 #define XCAN_BRPR_TDC_ENABLE		BIT(16) /* Transmitter Delay Compensation (TDC) Enable */
@@ -189,6 +198,14 @@ struct xcan_devtype_data {
  * @tx_head:			Tx CAN packets ready to send on the queue
  * @tx_tail:			Tx CAN packets successfully sended on the queue
  * @tx_max:			Maximum number packets the driver can send
+ * @tx_idr:			ID register value queued in each TX mailbox
+ * @rx_fifo_depth:		Number of buffers in the RX FIFO
+ * @rx_coalesce_usecs_irq:	RX IRQ coalescing timeout, 0 if disabled
+ * @rx_max_coalesced_frames_irq: RX FIFO watermark used for coalescing
+ * @rx_irq_timer:		Timer flushing frames below the watermark
+ * @ts_ref_cnt:			Timestamp counter sampled with @ts_ref_ns
+ * @ts_ref_ns:			Wall time of the last timestamp sample
+ * @ts_tq_ps:			Timestamp counter tick in picoseconds
  * @napi:			NAPI structure
  * @read_reg:			For reading data from CAN registers
  * @write_reg:			For writing data to CAN registers
@@ -205,6 +222,14 @@ struct xcan_priv {
 	unsigned int tx_head;
 	unsigned int tx_tail;
 	unsigned int tx_max;
+	u32 tx_idr[XCAN_TX_MAILBOX_MAX];
+	unsigned int rx_fifo_depth;
+	u32 rx_coalesce_usecs_irq;
+	u32 rx_max_coalesced_frames_irq;
+	struct hrtimer rx_irq_timer;
+	u16 ts_ref_cnt;
+	u64 ts_ref_ns;
+	u32 ts_tq_ps;
 	struct napi_struct napi;
 	u32 (*read_reg)(const struct xcan_priv *priv, enum xcan_reg reg);
 	void (*write_reg)(const struct xcan_priv *priv, enum xcan_reg reg,
@@ -367,10 +392,13 @@ static u32 xcan_rx_int_mask(const struct xcan_priv *priv)
 	/* RXNEMP is better suited for our use case as it cannot be cleared
 	 * while the FIFO is non-empty, but CAN FD HW does not have it
 	 */
-	if (priv->devtype.flags & XCAN_FLAG_RX_FIFO_MULTI)
+	if (priv->devtype.flags & XCAN_FLAG_RX_FIFO_MULTI) {
+		if (priv->rx_coalesce_usecs_irq)
+			return XCAN_IXR_RXOK_MASK | XCAN_IXR_RXFWMFLL_MASK;
 		return XCAN_IXR_RXOK_MASK;
-	else
+	} else {
 		return XCAN_IXR_RXNEMP_MASK;
+	}
 }
 
 /**
@@ -505,6 +533,20 @@ static int xcan_chip_start(struct net_device *ndev)
 	if (err < 0)
 		return err;
 
+	if (priv->devtype.flags & XCAN_FLAG_RX_FIFO_MULTI) {
+		u32 fw_mask = priv->devtype.flags & XCAN_FLAG_CANFD_2 ?
+			      XCAN_2_WIR_FW_MASK : XCAN_WIR_FW_MASK;
+
+		/* The RX timestamp counter ticks once per time quantum */
+		priv->ts_tq_ps = div_u64((u64)priv->can.bittiming.brp *
+					 PSEC_PER_SEC, priv->can.clock.freq);
+
+		if (priv->rx_coalesce_usecs_irq)
+			priv->write_reg(priv, XCAN_WIR_OFFSET,
+					priv->rx_max_coalesced_frames_irq &
+					fw_mask);
+	}
+
 	/* Enable interrupts
 	 *
 	 * We enable the ERROR interrupt even with
@@ -580,20 +622,25 @@ static int xcan_do_set_mode(struct net_device *ndev, enum can_mode mode)
  * @skb:		sk_buff pointer that contains data to be Txed
  * @frame_offset:	Register offset to write the frame to
  */
-static void xcan_write_frame(struct net_device *ndev, struct sk_buff *skb,
-			     int frame_offset)
+/**
+ * xcan_can_id_to_idr - Convert a socketCAN ID to the Xilinx ID register
+ * @can_id:	socketCAN ID of the frame
+ *
+ * The register layout follows the order of the arbitration field on the
+ * bus, so a numerically lower value wins arbitration.
+ *
+ * Return: Value for the ID register of a TX buffer
+ */
+static u32 xcan_can_id_to_idr(canid_t can_id)
 {
-	u32 id, dlc, data[2] = {0, 0};
-	struct canfd_frame *cf = (struct canfd_frame *)skb->data;
-	u32 ramoff, dwindex = 0, i;
-	struct xcan_priv *priv = netdev_priv(ndev);
+	u32 id;
 
 	/* Watch carefully on the bit sequence */
-	if (cf->can_id & CAN_EFF_FLAG) {
+	if (can_id & CAN_EFF_FLAG) {
 		/* Extended CAN ID format */
-		id = ((cf->can_id & CAN_EFF_MASK) << XCAN_IDR_ID2_SHIFT) &
+		id = ((can_id & CAN_EFF_MASK) << XCAN_IDR_ID2_SHIFT) &
 			XCAN_IDR_ID2_MASK;
-		id |= (((cf->can_id & CAN_EFF_MASK) >>
+		id |= (((can_id & CAN_EFF_MASK) >>
 			(CAN_EFF_ID_BITS - CAN_SFF_ID_BITS)) <<
 			XCAN_IDR_ID1_SHIFT) & XCAN_IDR_ID1_MASK;
 
@@ -602,19 +649,32 @@ static void xcan_write_frame(struct net_device *ndev, struct sk_buff *skb,
 		 */
 		id |= XCAN_IDR_IDE_MASK | XCAN_IDR_SRR_MASK;
 
-		if (cf->can_id & CAN_RTR_FLAG)
+		if (can_id & CAN_RTR_FLAG)
 			/* Extended frames remote TX request */
 			id |= XCAN_IDR_RTR_MASK;
 	} else {
 		/* Standard CAN ID format */
-		id = ((cf->can_id & CAN_SFF_MASK) << XCAN_IDR_ID1_SHIFT) &
+		id = ((can_id & CAN_SFF_MASK) << XCAN_IDR_ID1_SHIFT) &
 			XCAN_IDR_ID1_MASK;
 
-		if (cf->can_id & CAN_RTR_FLAG)
+		if (can_id & CAN_RTR_FLAG)
 			/* Standard frames remote TX request */
 			id |= XCAN_IDR_SRR_MASK;
 	}
 
+	return id;
+}
+
+static void xcan_write_frame(struct net_device *ndev, struct sk_buff *skb,
+			     int frame_offset)
+{
+	u32 id, dlc, data[2] = {0, 0};
+	struct canfd_frame *cf = (struct canfd_frame *)skb->data;
+	u32 ramoff, dwindex = 0, i;
+	struct xcan_priv *priv = netdev_priv(ndev);
+
+	id = xcan_can_id_to_idr(cf->can_id);
+
 	dlc = can_fd_len2dlc(cf->len) << XCAN_DLCR_DLC_SHIFT;
 	if (can_is_canfd_skb(skb)) {
 		if (cf->flags & CANFD_BRS)
@@ -622,11 +682,7 @@ static void xcan_write_frame(struct net_device *ndev, struct sk_buff *skb,
 		dlc |= XCAN_DLCR_EDL_MASK;
 	}
 
-	if (!(priv->devtype.flags & XCAN_FLAG_TX_MAILBOXES) &&
-	    (priv->devtype.flags & XCAN_FLAG_TXFEMP))
-		can_put_echo_skb(skb, ndev, priv->tx_head % priv->tx_max, 0);
-	else
-		can_put_echo_skb(skb, ndev, 0, 0);
+	can_put_echo_skb(skb, ndev, priv->tx_head % priv->tx_max, 0);
 
 	priv->tx_head++;
 
@@ -698,31 +754,73 @@ static int xcan_start_xmit_fifo(struct sk_buff *skb, struct net_device *ndev)
 	return 0;
 }
 
+/**
+ * xcan_tx_mailbox_in_order - Check that a frame cannot overtake queued ones
+ * @priv:	Driver private data structure
+ * @idr:	ID register value of the new frame
+ * @idx:	Mailbox the new frame would be queued in
+ *
+ * HW sends the ready mailboxes in arbitration order, and equal IDs in
+ * mailbox order. A frame may only join the in-flight ones if that
+ * still sends it last, so the netdev queue order is preserved.
+ *
+ * Return: true if the frame can be queued now
+ */
+static bool xcan_tx_mailbox_in_order(const struct xcan_priv *priv, u32 idr,
+				     unsigned int idx)
+{
+	unsigned int i, mb;
+
+	for (i = priv->tx_tail; i != priv->tx_head; i++) {
+		mb = i % priv->tx_max;
+		if (priv->tx_idr[mb] > idr ||
+		    (priv->tx_idr[mb] == idr && mb > idx))
+			return false;
+	}
+
+	return true;
+}
+
 /**
  * xcan_start_xmit_mailbox - Starts the transmission (mailbox mode)
  * @skb:	sk_buff pointer that contains data to be Txed
  * @ndev:	Pointer to net_device structure
  *
- * Return: 0 on success, -ENOSPC if there is no space
+ * Return: 0 on success, -ENOSPC if there is no space, -EBUSY if the frame
+ * has to wait for the frames in flight to be sent first
  */
 static int xcan_start_xmit_mailbox(struct sk_buff *skb, struct net_device *ndev)
 {
+	struct canfd_frame *cf = (struct canfd_frame *)skb->data;
 	struct xcan_priv *priv = netdev_priv(ndev);
+	unsigned int idx;
 	unsigned long flags;
+	u32 idr;
+
+	spin_lock_irqsave(&priv->tx_lock, flags);
 
-	if (unlikely(priv->read_reg(priv, XCAN_TRR_OFFSET) &
-		     BIT(XCAN_TX_MAILBOX_IDX)))
+	idx = priv->tx_head % priv->tx_max;
+	if (unlikely(priv->read_reg(priv, XCAN_TRR_OFFSET) & BIT(idx))) {
+		spin_unlock_irqrestore(&priv->tx_lock, flags);
 		return -ENOSPC;
+	}
 
-	spin_lock_irqsave(&priv->tx_lock, flags);
+	idr = xcan_can_id_to_idr(cf->can_id);
+	if (!xcan_tx_mailbox_in_order(priv, idr, idx)) {
+		/* woken up again by xcan_tx_interrupt() */
+		netif_stop_queue(ndev);
+		spin_unlock_irqrestore(&priv->tx_lock, flags);
+		return -EBUSY;
+	}
 
-	xcan_write_frame(ndev, skb,
-			 XCAN_TXMSG_FRAME_OFFSET(XCAN_TX_MAILBOX_IDX));
+	priv->tx_idr[idx] = idr;
+	xcan_write_frame(ndev, skb, XCAN_TXMSG_FRAME_OFFSET(idx));
 
 	/* Mark buffer as ready for transmit */
-	priv->write_reg(priv, XCAN_TRR_OFFSET, BIT(XCAN_TX_MAILBOX_IDX));
+	priv->write_reg(priv, XCAN_TRR_OFFSET, BIT(idx));
 
-	netif_stop_queue(ndev);
+	if ((priv->tx_head - priv->tx_tail) == priv->tx_max)
+		netif_stop_queue(ndev);
 
 	spin_unlock_irqrestore(&priv->tx_lock, flags);
 
@@ -751,6 +849,9 @@ static netdev_tx_t xcan_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 	else
 		ret = xcan_start_xmit_fifo(skb, ndev);
 
+	if (ret == -EBUSY)
+		return NETDEV_TX_BUSY;
+
 	if (ret < 0) {
 		netdev_err(ndev, "BUG!, TX full when queue awake!\n");
 		netif_stop_queue(ndev);
@@ -830,6 +931,38 @@ static int xcan_rx(struct net_device *ndev, int frame_base)
 	return 1;
 }
 
+/**
+ * xcan_rx_ts_sync - Sample the timestamp counter against the wall clock
+ * @priv:	Driver private data structure
+ *
+ * Done once per batch of received frames, which are then stamped from
+ * their age relative to this sample.
+ */
+static void xcan_rx_ts_sync(struct xcan_priv *priv)
+{
+	priv->ts_ref_cnt = FIELD_GET(XCAN_TSR_CNT_MASK,
+				     priv->read_reg(priv, XCAN_TSR_OFFSET));
+	priv->ts_ref_ns = ktime_get_real_ns();
+}
+
+/**
+ * xcan_rx_ts - Set the hardware timestamp of a received frame
+ * @priv:	Driver private data structure
+ * @skb:	Received frame
+ * @dlc:	DLC register value of the frame, holding its timestamp
+ *
+ * The 16-bit counter wraps quickly, frames older than one wrap at the
+ * time of the last xcan_rx_ts_sync() get an aliased timestamp.
+ */
+static void xcan_rx_ts(const struct xcan_priv *priv, struct sk_buff *skb,
+		       u32 dlc)
+{
+	u16 age = priv->ts_ref_cnt - FIELD_GET(XCAN_DLCR_TS_MASK, dlc);
+	u64 age_ns = div_u64((u64)age * priv->ts_tq_ps, 1000);
+
+	skb_hwtstamps(skb)->hwtstamp = ns_to_ktime(priv->ts_ref_ns - age_ns);
+}
+
 /**
  * xcanfd_rx -  Is called from CAN isr to complete the received
  *		frame  processing
@@ -910,6 +1043,7 @@ static int xcanfd_rx(struct net_device *ndev, int frame_base)
 		stats->rx_bytes += cf->len;
 	stats->rx_packets++;
 
+	xcan_rx_ts(priv, skb, dlc);
 	netif_receive_skb(skb);
 
 	return 1;
@@ -1165,45 +1299,66 @@ static void xcan_state_interrupt(struct net_device *ndev, u32 isr)
  */
 static int xcan_rx_fifo_get_next_frame(struct xcan_priv *priv)
 {
-	int offset;
+	/* check if RX FIFO is empty */
+	if (!(priv->read_reg(priv, XCAN_ISR_OFFSET) & XCAN_IXR_RXNEMP_MASK))
+		return -ENOENT;
 
-	if (priv->devtype.flags & XCAN_FLAG_RX_FIFO_MULTI) {
-		u32 fsr, mask;
+	/* frames are read from a static offset */
+	return XCAN_RXFIFO_OFFSET;
+}
+
+/**
+ * xcan_rx_fifo_multi_drain - Drain the RX FIFO of the CAN FD cores
+ * @ndev:	Pointer to net_device structure
+ * @quota:	Max number of frames to process
+ *
+ * The fill level is read once per batch and all frames it covers are
+ * read back to back, instead of re-checking the FIFO for each frame.
+ *
+ * Return: number of frames received
+ */
+static int xcan_rx_fifo_multi_drain(struct net_device *ndev, int quota)
+{
+	struct xcan_priv *priv = netdev_priv(ndev);
+	bool canfd_2 = priv->devtype.flags & XCAN_FLAG_CANFD_2;
+	u32 fl_mask = canfd_2 ? XCAN_2_FSR_FL_MASK : XCAN_FSR_FL_MASK;
+	u32 ri_mask = canfd_2 ? XCAN_2_FSR_RI_MASK : XCAN_FSR_RI_MASK;
+	u32 fsr, fill, ri;
+	int work_done = 0;
+	int offset;
 
+	while (work_done < quota) {
 		/* clear RXOK before the is-empty check so that any newly
 		 * received frame will reassert it without a race
 		 */
-		priv->write_reg(priv, XCAN_ICR_OFFSET, XCAN_IXR_RXOK_MASK);
+		priv->write_reg(priv, XCAN_ICR_OFFSET,
+				XCAN_IXR_RXOK_MASK | XCAN_IXR_RXFWMFLL_MASK);
 
 		fsr = priv->read_reg(priv, XCAN_FSR_OFFSET);
+		fill = FIELD_GET(fl_mask, fsr);
+		if (!fill)
+			break;
 
-		/* check if RX FIFO is empty */
-		if (priv->devtype.flags & XCAN_FLAG_CANFD_2)
-			mask = XCAN_2_FSR_FL_MASK;
-		else
-			mask = XCAN_FSR_FL_MASK;
+		fill = min_t(u32, fill, quota - work_done);
+		ri = fsr & ri_mask;
+		xcan_rx_ts_sync(priv);
 
-		if (!(fsr & mask))
-			return -ENOENT;
-
-		if (priv->devtype.flags & XCAN_FLAG_CANFD_2)
-			offset =
-			  XCAN_RXMSG_2_FRAME_OFFSET(fsr & XCAN_2_FSR_RI_MASK);
-		else
-			offset =
-			  XCAN_RXMSG_FRAME_OFFSET(fsr & XCAN_FSR_RI_MASK);
+		while (fill--) {
+			if (canfd_2)
+				offset = XCAN_RXMSG_2_FRAME_OFFSET(ri);
+			else
+				offset = XCAN_RXMSG_FRAME_OFFSET(ri);
 
-	} else {
-		/* check if RX FIFO is empty */
-		if (!(priv->read_reg(priv, XCAN_ISR_OFFSET) &
-		      XCAN_IXR_RXNEMP_MASK))
-			return -ENOENT;
+			work_done += xcanfd_rx(ndev, offset);
 
-		/* frames are read from a static offset */
-		offset = XCAN_RXFIFO_OFFSET;
+			/* increment read index */
+			priv->write_reg(priv, XCAN_FSR_OFFSET,
+					XCAN_FSR_IRI_MASK);
+			ri = (ri + 1) % priv->rx_fifo_depth;
+		}
 	}
 
-	return offset;
+	return work_done;
 }
 
 /**
@@ -1224,23 +1379,19 @@ static int xcan_rx_poll(struct napi_struct *napi, int quota)
 	int work_done = 0;
 	int frame_offset;
 
-	while ((frame_offset = xcan_rx_fifo_get_next_frame(priv)) >= 0 &&
-	       (work_done < quota)) {
-		if (xcan_rx_int_mask(priv) & XCAN_IXR_RXOK_MASK)
-			work_done += xcanfd_rx(ndev, frame_offset);
-		else
+	if (priv->devtype.flags & XCAN_FLAG_RX_FIFO_MULTI) {
+		work_done = xcan_rx_fifo_multi_drain(ndev, quota);
+	} else {
+		while ((frame_offset = xcan_rx_fifo_get_next_frame(priv)) >= 0 &&
+		       (work_done < quota)) {
 			work_done += xcan_rx(ndev, frame_offset);
 
-		if (priv->devtype.flags & XCAN_FLAG_RX_FIFO_MULTI)
-			/* increment read index */
-			priv->write_reg(priv, XCAN_FSR_OFFSET,
-					XCAN_FSR_IRI_MASK);
-		else
 			/* clear rx-not-empty (will actually clear only if
 			 * empty)
 			 */
 			priv->write_reg(priv, XCAN_ICR_OFFSET,
 					XCAN_IXR_RXNEMP_MASK);
+		}
 	}
 
 	if (work_done)
@@ -1256,6 +1407,47 @@ static int xcan_rx_poll(struct napi_struct *napi, int quota)
 	return work_done;
 }
 
+/**
+ * xcan_tx_mailbox_interrupt - Tx Done Isr (mailbox mode)
+ * @ndev:	net_device pointer
+ *
+ * Mailboxes complete in the order they were queued, see
+ * xcan_tx_mailbox_in_order(), so walk them from the tail until the first
+ * one still pending transmission.
+ */
+static void xcan_tx_mailbox_interrupt(struct net_device *ndev)
+{
+	struct xcan_priv *priv = netdev_priv(ndev);
+	struct net_device_stats *stats = &ndev->stats;
+	unsigned long flags;
+	unsigned int idx;
+	u32 trr;
+
+	spin_lock_irqsave(&priv->tx_lock, flags);
+
+	/* clear TXOK before sampling TRR so that a mailbox completing
+	 * afterwards reasserts it
+	 */
+	priv->write_reg(priv, XCAN_ICR_OFFSET, XCAN_IXR_TXOK_MASK);
+	trr = priv->read_reg(priv, XCAN_TRR_OFFSET);
+
+	while (priv->tx_tail != priv->tx_head) {
+		idx = priv->tx_tail % priv->tx_max;
+		if (trr & BIT(idx))
+			break;
+
+		stats->tx_bytes += can_get_echo_skb(ndev, idx, NULL);
+		priv->tx_tail++;
+		stats->tx_packets++;
+	}
+
+	netif_wake_queue(ndev);
+
+	spin_unlock_irqrestore(&priv->tx_lock, flags);
+
+	xcan_update_error_state_after_rxtx(ndev);
+}
+
 /**
  * xcan_tx_interrupt - Tx Done Isr
  * @ndev:	net_device pointer
@@ -1270,6 +1462,11 @@ static void xcan_tx_interrupt(struct net_device *ndev, u32 isr)
 	unsigned long flags;
 	int retries = 0;
 
+	if (priv->devtype.flags & XCAN_FLAG_TX_MAILBOXES) {
+		xcan_tx_mailbox_interrupt(ndev);
+		return;
+	}
+
 	/* Synchronize with xmit as we need to know the exact number
 	 * of frames in the FIFO to stay in sync due to the TXFEMP
 	 * handling.
@@ -1380,13 +1577,44 @@ static irqreturn_t xcan_interrupt(int irq, void *dev_id)
 	/* Check for the type of receive interrupt and Processing it */
 	if (isr & rx_int_mask) {
 		ier = priv->read_reg(priv, XCAN_IER_OFFSET);
-		ier &= ~rx_int_mask;
-		priv->write_reg(priv, XCAN_IER_OFFSET, ier);
-		napi_schedule(&priv->napi);
+		if (priv->rx_coalesce_usecs_irq &&
+		    !(isr & XCAN_IXR_RXFWMFLL_MASK)) {
+			/* First frame below the watermark: let more frames
+			 * pile up until the watermark or the timer fires
+			 */
+			if (ier & XCAN_IXR_RXOK_MASK) {
+				ier &= ~XCAN_IXR_RXOK_MASK;
+				priv->write_reg(priv, XCAN_IER_OFFSET, ier);
+				hrtimer_start(&priv->rx_irq_timer,
+					      ns_to_ktime((u64)NSEC_PER_USEC *
+						priv->rx_coalesce_usecs_irq),
+					      HRTIMER_MODE_REL);
+			}
+		} else {
+			ier &= ~rx_int_mask;
+			priv->write_reg(priv, XCAN_IER_OFFSET, ier);
+			napi_schedule(&priv->napi);
+		}
 	}
 	return IRQ_HANDLED;
 }
 
+/**
+ * xcan_rx_irq_timer - RX coalescing timeout
+ * @timer:	RX coalescing timer
+ *
+ * Return: HRTIMER_NORESTART always
+ */
+static enum hrtimer_restart xcan_rx_irq_timer(struct hrtimer *timer)
+{
+	struct xcan_priv *priv = container_of(timer, struct xcan_priv,
+					      rx_irq_timer);
+
+	napi_schedule(&priv->napi);
+
+	return HRTIMER_NORESTART;
+}
+
 /**
  * xcan_chip_stop - Driver stop routine
  * @ndev:	Pointer to net_device structure
@@ -1480,6 +1708,7 @@ static int xcan_close(struct net_device *ndev)
 	napi_disable(&priv->napi);
 	xcan_chip_stop(ndev);
 	free_irq(ndev->irq, ndev);
+	hrtimer_cancel(&priv->rx_irq_timer);
 	close_candev(ndev);
 
 	pm_runtime_put(priv->dev);
@@ -1534,15 +1763,122 @@ static int xcan_get_auto_tdcv(const struct net_device *ndev, u32 *tdcv)
 	return 0;
 }
 
+/**
+ * xcan_eth_ioctl - Hardware timestamping configuration
+ * @ndev:	Pointer to net_device structure
+ * @ifr:	Interface request
+ * @cmd:	ioctl command
+ *
+ * The CAN FD cores stamp every received frame, TX is not stamped.
+ *
+ * Return: 0 on success and failure value on error
+ */
+static int xcan_eth_ioctl(struct net_device *ndev, struct ifreq *ifr, int cmd)
+{
+	struct xcan_priv *priv = netdev_priv(ndev);
+	struct hwtstamp_config cfg = { 0 };
+
+	if (!(priv->devtype.flags & XCAN_FLAG_RX_FIFO_MULTI))
+		return -EOPNOTSUPP;
+
+	switch (cmd) {
+	case SIOCSHWTSTAMP:
+		if (copy_from_user(&cfg, ifr->ifr_data, sizeof(cfg)))
+			return -EFAULT;
+		if (cfg.tx_type == HWTSTAMP_TX_OFF &&
+		    cfg.rx_filter == HWTSTAMP_FILTER_ALL)
+			return 0;
+		return -ERANGE;
+	case SIOCGHWTSTAMP:
+		cfg.tx_type = HWTSTAMP_TX_OFF;
+		cfg.rx_filter = HWTSTAMP_FILTER_ALL;
+		if (copy_to_user(ifr->ifr_data, &cfg, sizeof(cfg)))
+			return -EFAULT;
+		return 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
 static const struct net_device_ops xcan_netdev_ops = {
 	.ndo_open	= xcan_open,
 	.ndo_stop	= xcan_close,
 	.ndo_start_xmit	= xcan_start_xmit,
+	.ndo_eth_ioctl	= xcan_eth_ioctl,
 	.ndo_change_mtu	= can_change_mtu,
 };
 
+static int xcan_get_ts_info(struct net_device *ndev,
+			    struct ethtool_ts_info *info)
+{
+	struct xcan_priv *priv = netdev_priv(ndev);
+
+	if (!(priv->devtype.flags & XCAN_FLAG_RX_FIFO_MULTI))
+		return ethtool_op_get_ts_info(ndev, info);
+
+	info->so_timestamping = SOF_TIMESTAMPING_TX_SOFTWARE |
+				SOF_TIMESTAMPING_RX_SOFTWARE |
+				SOF_TIMESTAMPING_SOFTWARE |
+				SOF_TIMESTAMPING_RX_HARDWARE |
+				SOF_TIMESTAMPING_RAW_HARDWARE;
+	info->phc_index = -1;
+	info->tx_types = BIT(HWTSTAMP_TX_OFF);
+	info->rx_filters = BIT(HWTSTAMP_FILTER_ALL);
+
+	return 0;
+}
+
+static int xcan_get_coalesce(struct net_device *ndev,
+			     struct ethtool_coalesce *ec,
+			     struct kernel_ethtool_coalesce *kec,
+			     struct netlink_ext_ack *extack)
+{
+	struct xcan_priv *priv = netdev_priv(ndev);
+
+	if (!(priv->devtype.flags & XCAN_FLAG_RX_FIFO_MULTI))
+		return -EOPNOTSUPP;
+
+	ec->rx_coalesce_usecs_irq = priv->rx_coalesce_usecs_irq;
+	ec->rx_max_coalesced_frames_irq = priv->rx_max_coalesced_frames_irq;
+
+	return 0;
+}
+
+static int xcan_set_coalesce(struct net_device *ndev,
+			     struct ethtool_coalesce *ec,
+			     struct kernel_ethtool_coalesce *kec,
+			     struct netlink_ext_ack *extack)
+{
+	struct xcan_priv *priv = netdev_priv(ndev);
+	u32 fw_max;
+
+	if (!(priv->devtype.flags & XCAN_FLAG_RX_FIFO_MULTI))
+		return -EOPNOTSUPP;
+
+	if (netif_running(ndev))
+		return -EBUSY;
+
+	/* both set to enable coalescing, or both zero to disable it */
+	if (!ec->rx_coalesce_usecs_irq != !ec->rx_max_coalesced_frames_irq)
+		return -EINVAL;
+
+	fw_max = priv->devtype.flags & XCAN_FLAG_CANFD_2 ?
+		 XCAN_2_WIR_FW_MASK : XCAN_WIR_FW_MASK;
+	if (ec->rx_max_coalesced_frames_irq > min(fw_max, priv->rx_fifo_depth))
+		return -EINVAL;
+
+	priv->rx_coalesce_usecs_irq = ec->rx_coalesce_usecs_irq;
+	priv->rx_max_coalesced_frames_irq = ec->rx_max_coalesced_frames_irq;
+
+	return 0;
+}
+
 static const struct ethtool_ops xcan_ethtool_ops = {
-	.get_ts_info = ethtool_op_get_ts_info,
+	.supported_coalesce_params = ETHTOOL_COALESCE_RX_USECS_IRQ |
+				     ETHTOOL_COALESCE_RX_MAX_FRAMES_IRQ,
+	.get_coalesce = xcan_get_coalesce,
+	.set_coalesce = xcan_set_coalesce,
+	.get_ts_info = xcan_get_ts_info,
 };
 
 /**
@@ -1767,10 +2103,14 @@ static int xcan_probe(struct platform_device *pdev)
 	 * With TX mailboxes:
 	 *
 	 * HW sends frames in CAN ID priority order. To preserve FIFO ordering
-	 * we submit frames one at a time.
+	 * a frame only joins the ones in flight if it cannot overtake them,
+	 * see xcan_tx_mailbox_in_order(). Keep a power of two so that the
+	 * head/tail counters wrap cleanly.
 	 */
-	if (!(devtype->flags & XCAN_FLAG_TX_MAILBOXES) &&
-	    (devtype->flags & XCAN_FLAG_TXFEMP))
+	if (devtype->flags & XCAN_FLAG_TX_MAILBOXES && hw_tx_max)
+		tx_max = rounddown_pow_of_two(min_t(u32, hw_tx_max,
+						    XCAN_TX_MAILBOX_MAX));
+	else if (devtype->flags & XCAN_FLAG_TXFEMP)
 		tx_max = min(hw_tx_max, 2U);
 	else
 		tx_max = 1;
@@ -1811,8 +2151,11 @@ static int xcan_probe(struct platform_device *pdev)
 
 	priv->reg_base = addr;
 	priv->tx_max = tx_max;
+	priv->rx_fifo_depth = rx_max;
 	priv->devtype = *devtype;
 	spin_lock_init(&priv->tx_lock);
+	hrtimer_init(&priv->rx_irq_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	priv->rx_irq_timer.function = xcan_rx_irq_timer;
 
 	/* Get IRQ for the device */
 	ret = platform_get_irq(pdev, 0);
@@ -7,17 +7,29 @@
 #ifndef _MACB_H
 #define _MACB_H
 
+#include <linux/bpf.h>
 #include <linux/clk.h>
 #include <linux/phylink.h>
 #include <linux/ptp_clock_kernel.h>
 #include <linux/net_tstamp.h>
 #include <linux/interrupt.h>
 #include <linux/phy/phy.h>
+#include <net/page_pool.h>
+#include <net/xdp.h>
 
 #if defined(CONFIG_ARCH_DMA_ADDR_T_64BIT) || defined(CONFIG_MACB_USE_HWSTAMP)
 #define MACB_EXT_DESC
 #endif
 
+/* Headroom left in front of GEM Rx frames for XDP programs */
+#define MACB_RX_HEADROOM	XDP_PACKET_HEADROOM
+
+/* XDP verdicts as seen by the GEM Rx path */
+#define MACB_XDP_PASS		0
+#define MACB_XDP_CONSUMED	BIT(0)
+#define MACB_XDP_TX		BIT(1)
+#define MACB_XDP_REDIRECT	BIT(2)
+
 #define MACB_GREGS_NBR 16
 #define MACB_GREGS_VERSION 2
 #define MACB_MAX_QUEUES 8
@@ -207,6 +219,11 @@
 #define GEM_IP4DST_CMP(idx)		(idx * 3 + 1)
 #define GEM_PORT_CMP(idx)		(idx * 3 + 2)
 
+/* RSS buckets, each one uses a type 2 screener and a compare register
+ * taken from the top of the range so they never overlap ntuple rules
+ */
+#define MACB_RSS_INDIR_SIZE		8
+
 /* Which screening type 2 EtherType register will be used (0 - 7) */
 #define SCRT2_ETHT		0
 
@@ -944,6 +961,8 @@ struct gem_tx_ts {
  */
 struct macb_tx_skb {
 	struct sk_buff		*skb;
+	/* XDP frame sent from the last buffer, instead of an skb */
+	struct xdp_frame	*xdpf;
 	dma_addr_t		mapping;
 	size_t			size;
 	bool			mapped_as_page;
@@ -1236,7 +1255,9 @@ struct macb_queue {
 	unsigned int		rx_tail;
 	unsigned int		rx_prepared_head;
 	struct macb_dma_desc	*rx_ring;
-	struct sk_buff		**rx_skbuff;
+	struct page		**rx_page;
+	struct page_pool	*page_pool;
+	struct xdp_rxq_info	xdp_rxq;
 	void			*rx_buffers;
 	struct napi_struct	napi_rx;
 	struct queue_stats stats;
@@ -1268,6 +1289,8 @@ struct macb {
 
 	struct macb_dma_desc	*rx_ring_tieoff;
 	size_t			rx_buffer_size;
+	/* XDP program run on GEM Rx, NULL if none */
+	struct bpf_prog		*xdp_prog;
 
 	unsigned int		rx_ring_size;
 	unsigned int		tx_ring_size;
@@ -1337,6 +1360,13 @@ struct macb {
 	spinlock_t rx_fs_lock;
 	unsigned int max_tuples;
 
+	/* RX flow distribution over the priority queues */
+	unsigned int rss_size;
+	unsigned int rss_scr_base;
+	unsigned int rss_cmp_base;
+	bool rss_l4_dst;
+	u8 rss_indir[MACB_RSS_INDIR_SIZE];
+
 	struct tasklet_struct	hresp_err_tasklet;
 
 	int	rx_bd_rd_prefetch;
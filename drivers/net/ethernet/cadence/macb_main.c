@@ -6,6 +6,7 @@
  */
 
 #define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+#include <linux/bpf_trace.h>
 #include <linux/clk.h>
 #include <linux/clk-provider.h>
 #include <linux/crc32.h>
@@ -23,6 +24,7 @@
 #include <linux/netdevice.h>
 #include <linux/etherdevice.h>
 #include <linux/dma-mapping.h>
+#include <linux/filter.h>
 #include <linux/platform_device.h>
 #include <linux/phylink.h>
 #include <linux/of.h>
@@ -1024,6 +1026,11 @@ static void macb_tx_unmap(struct macb *bp, struct macb_tx_skb *tx_skb, int budge
 		napi_consume_skb(tx_skb->skb, budget);
 		tx_skb->skb = NULL;
 	}
+
+	if (tx_skb->xdpf) {
+		xdp_return_frame(tx_skb->xdpf);
+		tx_skb->xdpf = NULL;
+	}
 }
 
 static void macb_set_addr(struct macb *bp, struct macb_dma_desc *desc, dma_addr_t addr)
@@ -1109,8 +1116,8 @@ static void macb_tx_error_task(struct work_struct *work)
 		skb = tx_skb->skb;
 
 		if (ctrl & MACB_BIT(TX_USED)) {
-			/* skb is set for the last buffer of the frame */
-			while (!skb) {
+			/* skb or xdpf is set for the last buffer of the frame */
+			while (!skb && !tx_skb->xdpf) {
 				macb_tx_unmap(bp, tx_skb, 0);
 				tail++;
 				tx_skb = macb_tx_skb(queue, tail);
@@ -1121,13 +1128,15 @@ static void macb_tx_error_task(struct work_struct *work)
 			 * since it's the only one written back by the hardware
 			 */
 			if (!(ctrl & MACB_BIT(TX_BUF_EXHAUSTED))) {
-				netdev_vdbg(bp->dev, "txerr skb %u (data %p) TX complete\n",
-					    macb_tx_ring_wrap(bp, tail),
-					    skb->data);
+				unsigned int len = skb ? skb->len :
+						   tx_skb->xdpf->len;
+
+				netdev_vdbg(bp->dev, "txerr %u (len %u) TX complete\n",
+					    macb_tx_ring_wrap(bp, tail), len);
 				bp->dev->stats.tx_packets++;
 				queue->stats.tx_packets++;
-				bp->dev->stats.tx_bytes += skb->len;
-				queue->stats.tx_bytes += skb->len;
+				bp->dev->stats.tx_bytes += len;
+				queue->stats.tx_bytes += len;
 			}
 		} else {
 			/* "Buffers exhausted mid-frame" errors may only happen
@@ -1238,11 +1247,20 @@ static int macb_tx_complete(struct macb_queue *queue, int budget)
 
 		/* Process all buffers of the current transmitted frame */
 		for (;; tail++) {
+			bool last;
+
 			tx_skb = macb_tx_skb(queue, tail);
 			skb = tx_skb->skb;
+			last = skb || tx_skb->xdpf;
 
 			/* First, update TX stats if needed */
-			if (skb) {
+			if (tx_skb->xdpf) {
+				bp->dev->stats.tx_packets++;
+				queue->stats.tx_packets++;
+				bp->dev->stats.tx_bytes += tx_skb->xdpf->len;
+				queue->stats.tx_bytes += tx_skb->xdpf->len;
+				packets++;
+			} else if (skb) {
 				if (unlikely(skb_shinfo(skb)->tx_flags & SKBTX_HW_TSTAMP) &&
 				    !ptp_one_step_sync(skb) &&
 				    gem_ptp_do_txstamp(queue, skb, desc) == 0) {
@@ -1264,11 +1282,12 @@ static int macb_tx_complete(struct macb_queue *queue, int budget)
 			/* Now we can safely release resources */
 			macb_tx_unmap(bp, tx_skb, budget);
 
-			/* skb is set only for the last buffer of the frame.
+			/* skb or xdpf is set only for the last buffer of the
+			 * frame.
 			 * WARNING: at this point skb has been freed by
 			 * macb_tx_unmap().
 			 */
-			if (skb)
+			if (last)
 				break;
 		}
 	}
@@ -1283,10 +1302,123 @@ static int macb_tx_complete(struct macb_queue *queue, int budget)
 	return packets;
 }
 
+/* Queue an XDP frame on a Tx ring, with tx_ptr_lock held. The frame is
+ * either mapped here (ndo_xdp_xmit) or still sits in a page of the Rx page
+ * pool of the queue (XDP_TX), which is mapped bidirectionally.
+ */
+static int macb_xdp_xmit_frame(struct macb *bp, struct macb_queue *queue,
+			       struct xdp_frame *xdpf, bool dma_map)
+{
+	struct macb_tx_skb *tx_skb;
+	struct macb_dma_desc *desc;
+	unsigned int entry;
+	dma_addr_t mapping;
+	u32 ctrl;
+
+	if (unlikely(xdpf->len > bp->max_tx_length))
+		return -EINVAL;
+
+	if (CIRC_SPACE(queue->tx_head, queue->tx_tail, bp->tx_ring_size) < 1)
+		return -EBUSY;
+
+	if (dma_map) {
+		mapping = dma_map_single(&bp->pdev->dev, xdpf->data,
+					 xdpf->len, DMA_TO_DEVICE);
+		if (dma_mapping_error(&bp->pdev->dev, mapping))
+			return -ENOMEM;
+	} else {
+		struct page *page = virt_to_head_page(xdpf->data);
+
+		mapping = page_pool_get_dma_addr(page) +
+			  (xdpf->data - page_address(page));
+		dma_sync_single_for_device(&bp->pdev->dev, mapping, xdpf->len,
+					   DMA_BIDIRECTIONAL);
+	}
+
+	entry = macb_tx_ring_wrap(bp, queue->tx_head);
+	tx_skb = &queue->tx_skb[entry];
+	tx_skb->skb = NULL;
+	tx_skb->xdpf = xdpf;
+	/* Page pool mappings are released with the page */
+	tx_skb->mapping = dma_map ? mapping : 0;
+	tx_skb->size = xdpf->len;
+	tx_skb->mapped_as_page = false;
+
+	/* Set end of TX queue before handing the frame to hardware */
+	desc = macb_tx_desc(queue, queue->tx_head + 1);
+	desc->ctrl = MACB_BIT(TX_USED);
+
+	ctrl = (u32)xdpf->len | MACB_BIT(TX_LAST);
+	if (unlikely(entry == (bp->tx_ring_size - 1)))
+		ctrl |= MACB_BIT(TX_WRAP);
+
+	desc = macb_tx_desc(queue, entry);
+	macb_set_addr(bp, desc, mapping);
+	/* desc->addr must be visible to hardware before clearing
+	 * 'TX_USED' bit in desc->ctrl.
+	 */
+	wmb();
+	desc->ctrl = ctrl;
+
+	queue->tx_head++;
+
+	return 0;
+}
+
+static void macb_xdp_tx_start(struct macb *bp)
+{
+	unsigned long flags;
+
+	/* Make newly initialized descriptors visible to hardware */
+	wmb();
+
+	spin_lock_irqsave(&bp->lock, flags);
+	macb_writel(bp, NCR, macb_readl(bp, NCR) | MACB_BIT(TSTART));
+	spin_unlock_irqrestore(&bp->lock, flags);
+}
+
+static int macb_xdp_xmit(struct net_device *dev, int num_frames,
+			 struct xdp_frame **frames, u32 flags)
+{
+	struct macb *bp = netdev_priv(dev);
+	struct macb_queue *queue;
+	int i, nxmit = 0;
+
+	if (unlikely(flags & ~XDP_XMIT_FLAGS_MASK))
+		return -EINVAL;
+
+	if (unlikely(!netif_running(dev)))
+		return -ENETDOWN;
+
+	queue = &bp->queues[smp_processor_id() % bp->num_queues];
+
+	spin_lock(&queue->tx_ptr_lock);
+	for (i = 0; i < num_frames; i++) {
+		if (macb_xdp_xmit_frame(bp, queue, frames[i], true))
+			break;
+		nxmit++;
+	}
+	spin_unlock(&queue->tx_ptr_lock);
+
+	if (nxmit)
+		macb_xdp_tx_start(bp);
+
+	return nxmit;
+}
+
+/* Size a GEM Rx page must have for the headroom, a frame of rx_buffer_size
+ * and the skb_shared_info built around it by napi_build_skb().
+ */
+static unsigned int gem_rx_buf_order(struct macb *bp)
+{
+	return get_order(MACB_RX_HEADROOM + bp->rx_buffer_size +
+			 SKB_DATA_ALIGN(sizeof(struct skb_shared_info)));
+}
+
 static void gem_rx_refill(struct macb_queue *queue)
 {
 	unsigned int		entry;
-	struct sk_buff		*skb;
+	struct page		*page;
 	dma_addr_t		paddr;
 	struct macb *bp = queue->bp;
 	struct macb_dma_desc *desc;
@@ -1300,25 +1432,18 @@ static void gem_rx_refill(struct macb_queue *queue)
 
 		desc = macb_rx_desc(queue, entry);
 
-		if (!queue->rx_skbuff[entry]) {
-			/* allocate sk_buff for this free entry in ring */
-			skb = netdev_alloc_skb(bp->dev, bp->rx_buffer_size);
-			if (unlikely(!skb)) {
+		if (!queue->rx_page[entry]) {
+			/* get a mapped page for this free entry in ring */
+			page = page_pool_dev_alloc_pages(queue->page_pool);
+			if (unlikely(!page)) {
 				netdev_err(bp->dev,
-					   "Unable to allocate sk_buff\n");
+					   "Unable to allocate RX page\n");
 				break;
 			}
 
 			/* now fill corresponding descriptor entry */
-			paddr = dma_map_single(&bp->pdev->dev, skb->data,
-					       bp->rx_buffer_size,
-					       DMA_FROM_DEVICE);
-			if (dma_mapping_error(&bp->pdev->dev, paddr)) {
-				dev_kfree_skb(skb);
-				break;
-			}
-
-			queue->rx_skbuff[entry] = skb;
+			paddr = page_pool_get_dma_addr(page) + MACB_RX_HEADROOM;
+			queue->rx_page[entry] = page;
 
 			if (entry == bp->rx_ring_size - 1)
 				paddr |= MACB_BIT(RX_WRAP);
@@ -1328,9 +1453,6 @@ static void gem_rx_refill(struct macb_queue *queue)
 			 */
 			dma_wmb();
 			macb_set_addr(bp, desc, paddr);
-
-			/* properly align Ethernet header */
-			skb_reserve(skb, NET_IP_ALIGN);
 		} else {
 			desc->ctrl = 0;
 			dma_wmb();
@@ -1376,20 +1498,70 @@ static int macb_validate_hw_csum(struct sk_buff *skb)
 	return (pkt_csum != csum);
 }
 
+/* Returns MACB_XDP_PASS or MACB_XDP_CONSUMED if the caller still owns the
+ * Rx page, MACB_XDP_TX or MACB_XDP_REDIRECT if it was handed over.
+ */
+static u32 gem_run_xdp(struct macb *bp, struct macb_queue *queue,
+		       struct bpf_prog *prog, struct xdp_buff *xdp)
+{
+	struct xdp_frame *xdpf;
+	u32 act;
+	int err;
+
+	act = bpf_prog_run_xdp(prog, xdp);
+	switch (act) {
+	case XDP_PASS:
+		return MACB_XDP_PASS;
+	case XDP_TX:
+		xdpf = xdp_convert_buff_to_frame(xdp);
+		if (unlikely(!xdpf))
+			goto out_failure;
+
+		spin_lock(&queue->tx_ptr_lock);
+		err = macb_xdp_xmit_frame(bp, queue, xdpf, false);
+		spin_unlock(&queue->tx_ptr_lock);
+		if (err)
+			goto out_failure;
+		return MACB_XDP_TX;
+	case XDP_REDIRECT:
+		err = xdp_do_redirect(bp->dev, xdp, prog);
+		if (err)
+			goto out_failure;
+		return MACB_XDP_REDIRECT;
+	default:
+		bpf_warn_invalid_xdp_action(bp->dev, prog, act);
+		fallthrough;
+	case XDP_ABORTED:
+out_failure:
+		trace_xdp_exception(bp->dev, prog, act);
+		fallthrough;
+	case XDP_DROP:
+		return MACB_XDP_CONSUMED;
+	}
+}
+
 static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 		  int budget)
 {
 	struct macb *bp = queue->bp;
+	struct bpf_prog *xdp_prog = READ_ONCE(bp->xdp_prog);
+	unsigned int frame_sz = PAGE_SIZE << gem_rx_buf_order(bp);
 	unsigned int		len;
 	unsigned int		entry;
 	struct sk_buff		*skb;
 	struct macb_dma_desc	*desc;
+	struct xdp_buff		xdp;
+	u32			xdp_res = 0;
 	int			count = 0;
 
+	xdp_init_buff(&xdp, frame_sz, &queue->xdp_rxq);
+
 	while (count < budget) {
-		u32 ctrl;
+		u32 ctrl, act;
 		dma_addr_t addr;
 		bool rxused;
+		struct page *page;
+		void *va, *data;
 
 		entry = macb_rx_ring_wrap(bp, queue->rx_tail);
 		desc = macb_rx_desc(queue, entry);
@@ -1418,8 +1590,8 @@ static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 			queue->stats.rx_dropped++;
 			break;
 		}
-		skb = queue->rx_skbuff[entry];
-		if (unlikely(!skb)) {
+		page = queue->rx_page[entry];
+		if (unlikely(!page)) {
 			netdev_err(bp->dev,
 				   "inconsistent Rx descriptor chain\n");
 			bp->dev->stats.rx_dropped++;
@@ -1427,14 +1599,52 @@ static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 			break;
 		}
 		/* now everything is ready for receiving packet */
-		queue->rx_skbuff[entry] = NULL;
+		queue->rx_page[entry] = NULL;
 		len = ctrl & bp->rx_frm_len_mask;
 
 		netdev_vdbg(bp->dev, "gem_rx %u (len %u)\n", entry, len);
 
+		dma_sync_single_for_cpu(&bp->pdev->dev, addr, NET_IP_ALIGN + len,
+					page_pool_get_dma_dir(queue->page_pool));
+
+		/* The hardware writes the frame NET_IP_ALIGN into the buffer */
+		va = page_address(page);
+		data = va + MACB_RX_HEADROOM + NET_IP_ALIGN;
+
+		if (xdp_prog) {
+			xdp_prepare_buff(&xdp, va, data - va, len, false);
+			act = gem_run_xdp(bp, queue, xdp_prog, &xdp);
+			xdp_res |= act;
+			if (act == MACB_XDP_CONSUMED) {
+				page_pool_recycle_direct(queue->page_pool,
+							 page);
+				bp->dev->stats.rx_dropped++;
+				queue->stats.rx_dropped++;
+				continue;
+			}
+			if (act != MACB_XDP_PASS) {
+				bp->dev->stats.rx_packets++;
+				queue->stats.rx_packets++;
+				bp->dev->stats.rx_bytes += len;
+				queue->stats.rx_bytes += len;
+				continue;
+			}
+
+			/* The program may have moved the frame boundaries */
+			data = xdp.data;
+			len = xdp.data_end - xdp.data;
+		}
+
+		skb = napi_build_skb(va, frame_sz);
+		if (unlikely(!skb)) {
+			page_pool_recycle_direct(queue->page_pool, page);
+			bp->dev->stats.rx_dropped++;
+			queue->stats.rx_dropped++;
+			continue;
+		}
+		skb_mark_for_recycle(skb);
+		skb_reserve(skb, data - va);
 		skb_put(skb, len);
-		dma_unmap_single(&bp->pdev->dev, addr,
-				 bp->rx_buffer_size, DMA_FROM_DEVICE);
 
 		skb->protocol = eth_type_trans(skb, bp->dev);
 
@@ -1443,6 +1653,7 @@ static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 			if (macb_validate_hw_csum(skb)) {
 				netdev_err(bp->dev, "incorrect FCS\n");
 				bp->dev->stats.rx_dropped++;
+				napi_consume_skb(skb, budget);
 				break;
 			}
 		}
@@ -1472,6 +1683,12 @@ static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 		napi_gro_receive(napi, skb);
 	}
 
+	if (xdp_res & MACB_XDP_REDIRECT)
+		xdp_do_flush();
+
+	if (xdp_res & MACB_XDP_TX)
+		macb_xdp_tx_start(bp);
+
 	gem_rx_refill(queue);
 
 	return count;
@@ -2394,34 +2611,31 @@ static void macb_init_rx_buffer_size(struct macb *bp, size_t size)
 
 static void gem_free_rx_buffers(struct macb *bp)
 {
-	struct sk_buff		*skb;
-	struct macb_dma_desc	*desc;
 	struct macb_queue *queue;
-	dma_addr_t		addr;
+	struct page *page;
 	unsigned int q;
 	int i;
 
 	for (q = 0, queue = bp->queues; q < bp->num_queues; ++q, ++queue) {
-		if (!queue->rx_skbuff)
-			continue;
-
-		for (i = 0; i < bp->rx_ring_size; i++) {
-			skb = queue->rx_skbuff[i];
+		if (queue->rx_page) {
+			for (i = 0; i < bp->rx_ring_size; i++) {
+				page = queue->rx_page[i];
+				if (page)
+					page_pool_put_full_page(queue->page_pool,
+								page, false);
+			}
 
-			if (!skb)
-				continue;
+			kfree(queue->rx_page);
+			queue->rx_page = NULL;
+		}
 
-			desc = macb_rx_desc(queue, i);
-			addr = macb_get_addr(bp, desc);
+		if (xdp_rxq_info_is_reg(&queue->xdp_rxq))
+			xdp_rxq_info_unreg(&queue->xdp_rxq);
 
-			dma_unmap_single(&bp->pdev->dev, addr, bp->rx_buffer_size,
-					DMA_FROM_DEVICE);
-			dev_kfree_skb_any(skb);
-			skb = NULL;
+		if (queue->page_pool) {
+			page_pool_destroy(queue->page_pool);
+			queue->page_pool = NULL;
 		}
-
-		kfree(queue->rx_skbuff);
-		queue->rx_skbuff = NULL;
 	}
 }
 
@@ -2469,21 +2683,54 @@ static void macb_free_consistent(struct macb *bp)
 	}
 }
 
+/* Each queue takes its Rx buffers from a page pool that keeps them DMA
+ * mapped, so that received frames are turned into skbs with
+ * napi_build_skb() and the pages recycled without remapping. Pages are
+ * mapped bidirectionally while an XDP program is attached, for XDP_TX.
+ */
 static int gem_alloc_rx_buffers(struct macb *bp)
 {
+	struct page_pool_params pp_params = {
+		.order = gem_rx_buf_order(bp),
+		.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV,
+		.pool_size = bp->rx_ring_size,
+		.nid = dev_to_node(&bp->pdev->dev),
+		.dev = &bp->pdev->dev,
+		.dma_dir = bp->xdp_prog ? DMA_BIDIRECTIONAL : DMA_FROM_DEVICE,
+		.offset = MACB_RX_HEADROOM,
+		.max_len = bp->rx_buffer_size,
+	};
 	struct macb_queue *queue;
 	unsigned int q;
-	int size;
+	int size, err;
 
 	for (q = 0, queue = bp->queues; q < bp->num_queues; ++q, ++queue) {
-		size = bp->rx_ring_size * sizeof(struct sk_buff *);
-		queue->rx_skbuff = kzalloc(size, GFP_KERNEL);
-		if (!queue->rx_skbuff)
+		size = bp->rx_ring_size * sizeof(struct page *);
+		queue->rx_page = kzalloc(size, GFP_KERNEL);
+		if (!queue->rx_page)
 			return -ENOMEM;
 		else
 			netdev_dbg(bp->dev,
-				   "Allocated %d RX struct sk_buff entries at %p\n",
-				   bp->rx_ring_size, queue->rx_skbuff);
+				   "Allocated %d RX page entries at %p\n",
+				   bp->rx_ring_size, queue->rx_page);
+
+		queue->page_pool = page_pool_create(&pp_params);
+		if (IS_ERR(queue->page_pool)) {
+			err = PTR_ERR(queue->page_pool);
+			queue->page_pool = NULL;
+			return err;
+		}
+
+		err = xdp_rxq_info_reg(&queue->xdp_rxq, bp->dev, q,
+				       queue->napi_rx.napi_id);
+		if (err)
+			return err;
+
+		err = xdp_rxq_info_reg_mem_model(&queue->xdp_rxq,
+						 MEM_TYPE_PAGE_POOL,
+						 queue->page_pool);
+		if (err)
+			return err;
 	}
 	return 0;
 }
@@ -2765,6 +3012,44 @@ static void macb_configure_dma(struct macb *bp)
 	}
 }
 
+/* Program the RSS screeners. GEM has no hash engine, so each bucket of
+ * the indirection table is a type 2 screener doing a masked 16-bit
+ * compare on the low bits of the TCP/UDP source (or destination) port.
+ * Lower numbered screeners take precedence, so ntuple rules still win.
+ */
+static void gem_rss_program(struct macb *bp)
+{
+	u16 mask = (__force u16)cpu_to_be16(bp->rss_size - 1);
+	unsigned int i, cmp;
+	u32 w0, w1, t2_scr;
+
+	if (!macb_is_gem(bp) || !bp->rss_size)
+		return;
+
+	for (i = 0; i < bp->rss_size; i++) {
+		cmp = bp->rss_cmp_base + i;
+
+		w0 = 0;
+		w0 = GEM_BFINS(T2MASK, mask, w0);
+		w0 = GEM_BFINS(T2CMP, (__force u16)cpu_to_be16(i), w0);
+		w1 = 0;
+		w1 = GEM_BFINS(T2DISMSK, 0, w1); /* 16-bit compare */
+		w1 = GEM_BFINS(T2CMPOFST, GEM_T2COMPOFST_IPHDR, w1);
+		w1 = GEM_BFINS(T2OFST, bp->rss_l4_dst ? IPHDR_DSTPORT_OFFSET :
+			       IPHDR_SRCPORT_OFFSET, w1);
+		gem_writel_n(bp, T2CMPW0, T2CMP_OFST(cmp), w0);
+		gem_writel_n(bp, T2CMPW1, T2CMP_OFST(cmp), w1);
+
+		t2_scr = 0;
+		t2_scr = GEM_BFINS(QUEUE, bp->rss_indir[i], t2_scr);
+		t2_scr = GEM_BFINS(ETHT2IDX, SCRT2_ETHT, t2_scr);
+		t2_scr = GEM_BFINS(ETHTEN, 1, t2_scr);
+		t2_scr = GEM_BFINS(CMPA, cmp, t2_scr);
+		t2_scr = GEM_BFINS(CMPAEN, 1, t2_scr);
+		gem_writel_n(bp, SCRT2, bp->rss_scr_base + i, t2_scr);
+	}
+}
+
 static void macb_init_hw(struct macb *bp)
 {
 	u32 config;
@@ -2807,6 +3092,7 @@ static void macb_init_hw(struct macb *bp)
 			   GEM_BIT(ENCUTTHRU));
 	}
 
+	gem_rss_program(bp);
 }
 
 /* The hash address register is 64 bits long and takes up two
@@ -2928,6 +3214,28 @@ static void macb_set_rx_mode(struct net_device *dev)
 	macb_writel(bp, NCFGR, cfg);
 }
 
+/* Spread the queue interrupts over the CPUs so that RX processing of
+ * the flows steered by the RSS screeners scales. Nothing to do when
+ * the queues share a single interrupt line.
+ */
+static void macb_set_queue_affinity(struct macb *bp, bool set)
+{
+	int node = dev_to_node(&bp->pdev->dev);
+	const struct cpumask *mask = NULL;
+	struct macb_queue *queue;
+	unsigned int q;
+
+	for (q = 1, queue = bp->queues + 1; q < bp->num_queues; ++q, ++queue)
+		if (queue->irq == bp->queues[0].irq)
+			return;
+
+	for (q = 0, queue = bp->queues; q < bp->num_queues; ++q, ++queue) {
+		if (set)
+			mask = cpumask_of(cpumask_local_spread(q, node));
+		irq_set_affinity_and_hint(queue->irq, mask);
+	}
+}
+
 static int macb_open(struct net_device *dev)
 {
 	size_t bufsz = dev->mtu + ETH_HLEN + ETH_FCS_LEN + NET_IP_ALIGN;
@@ -2959,6 +3267,9 @@ static int macb_open(struct net_device *dev)
 
 	macb_init_hw(bp);
 
+	if (bp->num_queues > 1)
+		macb_set_queue_affinity(bp, true);
+
 	err = phy_power_on(bp->sgmii_phy);
 	if (err)
 		goto reset_hw;
@@ -2979,6 +3290,8 @@ static int macb_open(struct net_device *dev)
 
 reset_hw:
 	macb_reset_hw(bp);
+	if (bp->num_queues > 1)
+		macb_set_queue_affinity(bp, false);
 	for (q = 0, queue = bp->queues; q < bp->num_queues; ++q, ++queue) {
 		napi_disable(&queue->napi_rx);
 		napi_disable(&queue->napi_tx);
@@ -3013,6 +3326,9 @@ static int macb_close(struct net_device *dev)
 	netif_carrier_off(dev);
 	spin_unlock_irqrestore(&bp->lock, flags);
 
+	if (bp->num_queues > 1)
+		macb_set_queue_affinity(bp, false);
+
 	macb_free_consistent(bp);
 
 	if (bp->ptp_info)
@@ -3033,6 +3349,47 @@ static int macb_change_mtu(struct net_device *dev, int new_mtu)
 	return 0;
 }
 
+static int gem_xdp_setup(struct net_device *dev, struct bpf_prog *prog,
+			 struct netlink_ext_ack *extack)
+{
+	struct macb *bp = netdev_priv(dev);
+	struct bpf_prog *old_prog;
+	bool need_reset;
+	int err;
+
+	if (!macb_is_gem(bp)) {
+		NL_SET_ERR_MSG_MOD(extack, "XDP is only supported on GEM");
+		return -EOPNOTSUPP;
+	}
+
+	/* The Rx page pools are remapped when XDP_TX becomes possible */
+	need_reset = netif_running(dev) && !!bp->xdp_prog != !!prog;
+	if (need_reset)
+		macb_close(dev);
+
+	old_prog = xchg(&bp->xdp_prog, prog);
+	if (old_prog)
+		bpf_prog_put(old_prog);
+
+	if (need_reset) {
+		err = macb_open(dev);
+		if (err)
+			return err;
+	}
+
+	return 0;
+}
+
+static int macb_bpf(struct net_device *dev, struct netdev_bpf *bpf)
+{
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		return gem_xdp_setup(dev, bpf->prog, bpf->extack);
+	default:
+		return -EINVAL;
+	}
+}
+
 static void gem_update_stats(struct macb *bp)
 {
 	struct macb_queue *queue;
@@ -3667,6 +4024,51 @@ static int gem_get_all_flow_entries(struct net_device *netdev,
 	return 0;
 }
 
+/* Only one port can be compared, and the screeners do not tell TCP from
+ * UDP, so both flow types always share the same setting.
+ */
+static int gem_get_rss_hash_opts(struct macb *bp, struct ethtool_rxnfc *cmd)
+{
+	if (!bp->rss_size)
+		return -EOPNOTSUPP;
+
+	switch (cmd->flow_type) {
+	case TCP_V4_FLOW:
+	case UDP_V4_FLOW:
+		cmd->data = bp->rss_l4_dst ? RXH_L4_B_2_3 : RXH_L4_B_0_1;
+		break;
+	default:
+		cmd->data = 0;
+	}
+
+	return 0;
+}
+
+static int gem_set_rss_hash_opts(struct macb *bp, struct ethtool_rxnfc *cmd)
+{
+	if (!bp->rss_size)
+		return -EOPNOTSUPP;
+
+	if (cmd->flow_type != TCP_V4_FLOW && cmd->flow_type != UDP_V4_FLOW)
+		return -EINVAL;
+
+	switch (cmd->data) {
+	case RXH_L4_B_0_1:
+		bp->rss_l4_dst = false;
+		break;
+	case RXH_L4_B_2_3:
+		bp->rss_l4_dst = true;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	if (netif_running(bp->dev))
+		gem_rss_program(bp);
+
+	return 0;
+}
+
 static int gem_get_rxnfc(struct net_device *netdev, struct ethtool_rxnfc *cmd,
 		u32 *rule_locs)
 {
@@ -3686,6 +4088,9 @@ static int gem_get_rxnfc(struct net_device *netdev, struct ethtool_rxnfc *cmd,
 	case ETHTOOL_GRXCLSRLALL:
 		ret = gem_get_all_flow_entries(netdev, cmd, rule_locs);
 		break;
+	case ETHTOOL_GRXFH:
+		ret = gem_get_rss_hash_opts(bp, cmd);
+		break;
 	default:
 		netdev_err(netdev,
 			  "Command parameter %d is not supported\n", cmd->cmd);
@@ -3712,6 +4117,9 @@ static int gem_set_rxnfc(struct net_device *netdev, struct ethtool_rxnfc *cmd)
 	case ETHTOOL_SRXCLSRLDEL:
 		ret = gem_del_flow_filter(netdev, cmd);
 		break;
+	case ETHTOOL_SRXFH:
+		ret = gem_set_rss_hash_opts(bp, cmd);
+		break;
 	default:
 		netdev_err(netdev,
 			  "Command parameter %d is not supported\n", cmd->cmd);
@@ -3721,6 +4129,47 @@ static int gem_set_rxnfc(struct net_device *netdev, struct ethtool_rxnfc *cmd)
 	return ret;
 }
 
+static u32 gem_get_rxfh_indir_size(struct net_device *netdev)
+{
+	struct macb *bp = netdev_priv(netdev);
+
+	return bp->rss_size;
+}
+
+static int gem_get_rxfh(struct net_device *netdev, u32 *indir, u8 *key,
+			u8 *hfunc)
+{
+	struct macb *bp = netdev_priv(netdev);
+	unsigned int i;
+
+	if (indir)
+		for (i = 0; i < bp->rss_size; i++)
+			indir[i] = bp->rss_indir[i];
+
+	return 0;
+}
+
+static int gem_set_rxfh(struct net_device *netdev, const u32 *indir,
+			const u8 *key, const u8 hfunc)
+{
+	struct macb *bp = netdev_priv(netdev);
+	unsigned int i;
+
+	if (key || (hfunc != ETH_RSS_HASH_NO_CHANGE))
+		return -EOPNOTSUPP;
+
+	if (!indir)
+		return 0;
+
+	for (i = 0; i < bp->rss_size; i++)
+		bp->rss_indir[i] = indir[i];
+
+	if (netif_running(netdev))
+		gem_rss_program(bp);
+
+	return 0;
+}
+
 static const struct ethtool_ops macb_ethtool_ops = {
 	.get_regs_len		= macb_get_regs_len,
 	.get_regs		= macb_get_regs,
@@ -3746,6 +4195,9 @@ static const struct ethtool_ops gem_ethtool_ops = {
 	.set_ringparam		= macb_set_ringparam,
 	.get_rxnfc			= gem_get_rxnfc,
 	.set_rxnfc			= gem_set_rxnfc,
+	.get_rxfh_indir_size	= gem_get_rxfh_indir_size,
+	.get_rxfh		= gem_get_rxfh,
+	.set_rxfh		= gem_set_rxfh,
 	.get_wol		= macb_get_wol,
 	.set_wol		= macb_set_wol,
 };
@@ -3868,6 +4320,8 @@ static const struct net_device_ops macb_netdev_ops = {
 #endif
 	.ndo_set_features	= macb_set_features,
 	.ndo_features_check	= macb_features_check,
+	.ndo_bpf		= macb_bpf,
+	.ndo_xdp_xmit		= macb_xdp_xmit,
 };
 
 /* Configure peripheral capabilities according to device tree
@@ -4056,6 +4510,7 @@ static int macb_init(struct platform_device *pdev)
 	struct net_device *dev = platform_get_drvdata(pdev);
 	unsigned int hw_q, q;
 	struct macb *bp = netdev_priv(dev);
+	unsigned int num_t2_scr, num_t2_cmp;
 	struct macb_queue *queue;
 	int err;
 	u32 val, reg;
@@ -4163,10 +4618,25 @@ static int macb_init(struct platform_device *pdev)
 	/* Check RX Flow Filters support.
 	 * Max Rx flows set by availability of screeners & compare regs:
 	 * each 4-tuple define requires 1 T2 screener reg + 3 compare regs
+	 * once the RSS buckets have taken their screener + compare reg each.
 	 */
 	reg = gem_readl(bp, DCFG8);
-	bp->max_tuples = min((GEM_BFEXT(SCR2CMP, reg) / 3),
-			GEM_BFEXT(T2SCR, reg));
+	num_t2_scr = GEM_BFEXT(T2SCR, reg);
+	num_t2_cmp = GEM_BFEXT(SCR2CMP, reg);
+	bp->rss_size = 0;
+	if (bp->num_queues > 1 && GEM_BFEXT(SCR2ETH, reg) > 0 &&
+	    num_t2_scr > MACB_RSS_INDIR_SIZE &&
+	    num_t2_cmp >= MACB_RSS_INDIR_SIZE + 3) {
+		bp->rss_size = MACB_RSS_INDIR_SIZE;
+		num_t2_scr -= MACB_RSS_INDIR_SIZE;
+		num_t2_cmp -= MACB_RSS_INDIR_SIZE;
+		bp->rss_scr_base = num_t2_scr;
+		bp->rss_cmp_base = num_t2_cmp;
+		for (q = 0; q < bp->rss_size; q++)
+			bp->rss_indir[q] = ethtool_rxfh_indir_default(q,
+							bp->num_queues);
+	}
+	bp->max_tuples = min(num_t2_cmp / 3, num_t2_scr);
 	INIT_LIST_HEAD(&bp->rx_fs_list.list);
 	if (bp->max_tuples > 0) {
 		/* also needs one ethtype match to check IPv4 */
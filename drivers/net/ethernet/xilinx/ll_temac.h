@@ -366,7 +366,7 @@ struct temac_local {
 	int emac_num;
 
 	struct sk_buff **rx_skb;
-	spinlock_t rx_lock;
+	struct napi_struct napi;
 	/* For synchronization of indirect register access.  Must be
 	 * shared mutex between interfaces in same TEMAC block.
 	 */
@@ -392,6 +392,8 @@ struct temac_local {
 	u8 coalesce_delay_tx;
 	u8 coalesce_count_rx;
 	u8 coalesce_delay_rx;
+	u32 tx_chnl_ctrl;
+	u32 rx_chnl_ctrl;
 
 	struct delayed_work restart_work;
 };
@@ -378,16 +378,18 @@ static int temac_dma_bd_init(struct net_device *ndev)
 	}
 
 	/* Configure DMA channel (irq setup) */
-	lp->dma_out(lp, TX_CHNL_CTRL,
-		    lp->coalesce_delay_tx << 24 | lp->coalesce_count_tx << 16 |
-		    0x00000400 | // Use 1 Bit Wide Counters. Currently Not Used!
-		    CHNL_CTRL_IRQ_EN | CHNL_CTRL_IRQ_ERR_EN |
-		    CHNL_CTRL_IRQ_DLY_EN | CHNL_CTRL_IRQ_COAL_EN);
-	lp->dma_out(lp, RX_CHNL_CTRL,
-		    lp->coalesce_delay_rx << 24 | lp->coalesce_count_rx << 16 |
-		    CHNL_CTRL_IRQ_IOE |
-		    CHNL_CTRL_IRQ_EN | CHNL_CTRL_IRQ_ERR_EN |
-		    CHNL_CTRL_IRQ_DLY_EN | CHNL_CTRL_IRQ_COAL_EN);
+	lp->tx_chnl_ctrl =
+		lp->coalesce_delay_tx << 24 | lp->coalesce_count_tx << 16 |
+		0x00000400 | // Use 1 Bit Wide Counters. Currently Not Used!
+		CHNL_CTRL_IRQ_EN | CHNL_CTRL_IRQ_ERR_EN |
+		CHNL_CTRL_IRQ_DLY_EN | CHNL_CTRL_IRQ_COAL_EN;
+	lp->rx_chnl_ctrl =
+		lp->coalesce_delay_rx << 24 | lp->coalesce_count_rx << 16 |
+		CHNL_CTRL_IRQ_IOE |
+		CHNL_CTRL_IRQ_EN | CHNL_CTRL_IRQ_ERR_EN |
+		CHNL_CTRL_IRQ_DLY_EN | CHNL_CTRL_IRQ_COAL_EN;
+	lp->dma_out(lp, TX_CHNL_CTRL, lp->tx_chnl_ctrl);
+	lp->dma_out(lp, RX_CHNL_CTRL, lp->rx_chnl_ctrl);
 
 	/* Init descriptor indexes */
 	lp->tx_bd_ci = 0;
@@ -770,7 +772,7 @@ static void *ptr_from_txbd(struct cdmac_bd *bd)
 
 #endif
 
-static void temac_start_xmit_done(struct net_device *ndev)
+static void temac_start_xmit_done(struct net_device *ndev, int budget)
 {
 	struct temac_local *lp = netdev_priv(ndev);
 	struct cdmac_bd *cur_p;
@@ -789,7 +791,7 @@ static void temac_start_xmit_done(struct net_device *ndev)
 				 be32_to_cpu(cur_p->len), DMA_TO_DEVICE);
 		skb = (struct sk_buff *)ptr_from_txbd(cur_p);
 		if (skb)
-			dev_consume_skb_irq(skb);
+			napi_consume_skb(skb, budget);
 		cur_p->app1 = 0;
 		cur_p->app2 = 0;
 		cur_p->app3 = 0;
@@ -967,21 +969,19 @@ static int ll_temac_recv_buffers_available(struct temac_local *lp)
 	return available;
 }
 
-static void ll_temac_recv(struct net_device *ndev)
+static int ll_temac_recv(struct net_device *ndev, int budget)
 {
 	struct temac_local *lp = netdev_priv(ndev);
-	unsigned long flags;
 	int rx_bd;
+	int done = 0;
 	bool update_tail = false;
 
-	spin_lock_irqsave(&lp->rx_lock, flags);
-
-	/* Process all received buffers, passing them on network
-	 * stack.  After this, the buffer descriptors will be in an
-	 * un-allocated stage, where no skb is allocated for it, and
-	 * they are therefore not available for TEMAC/DMA.
+	/* Process up to budget received buffers, passing them on
+	 * network stack.  After this, the buffer descriptors will be
+	 * in an un-allocated stage, where no skb is allocated for it,
+	 * and they are therefore not available for TEMAC/DMA.
 	 */
-	do {
+	while (done < budget) {
 		struct cdmac_bd *bd = &lp->rx_bd_v[lp->rx_bd_ci];
 		struct sk_buff *skb = lp->rx_skb[lp->rx_bd_ci];
 		unsigned int bdstat = be32_to_cpu(bd->app0);
@@ -1023,17 +1023,20 @@ static void ll_temac_recv(struct net_device *ndev)
 		}
 
 		if (!skb_defer_rx_timestamp(skb))
-			netif_rx(skb);
+			napi_gro_receive(&lp->napi, skb);
 		/* The skb buffer is now owned by network stack above */
 		lp->rx_skb[lp->rx_bd_ci] = NULL;
 
 		ndev->stats.rx_packets++;
 		ndev->stats.rx_bytes += length;
+		done++;
 
 		rx_bd = lp->rx_bd_ci;
 		if (++lp->rx_bd_ci >= lp->rx_bd_num)
 			lp->rx_bd_ci = 0;
-	} while (rx_bd != lp->rx_bd_tail);
+		if (rx_bd == lp->rx_bd_tail)
+			break;
+	}
 
 	/* DMA operations will halt when the last buffer descriptor is
 	 * processed (ie. the one pointed to by RX_TAILDESC_PTR).
@@ -1041,7 +1044,7 @@ static void ll_temac_recv(struct net_device *ndev)
 	 * generated.  No IRQ_COAL or IRQ_DLY, and not even an
 	 * IRQ_ERR.  To avoid stalling, we schedule a delayed work
 	 * when there is a potential risk of that happening.  The work
-	 * will call this function, and thus re-schedule itself until
+	 * will schedule NAPI, and thus re-schedule itself until
 	 * enough buffers are available again.
 	 */
 	if (ll_temac_recv_buffers_available(lp) < lp->coalesce_count_rx)
@@ -1051,7 +1054,7 @@ static void ll_temac_recv(struct net_device *ndev)
 	 * passed to network stack.  Note that GFP_ATOMIC allocations
 	 * can fail (e.g. when a larger burst of GFP_ATOMIC
 	 * allocations occurs), so while we try to allocate all
-	 * buffers in the same interrupt where they were processed, we
+	 * buffers in the same poll where they were processed, we
 	 * continue with what we could get in case of allocation
 	 * failure.  Allocation of remaining buffers will be retried
 	 * in following calls.
@@ -1069,7 +1072,7 @@ static void ll_temac_recv(struct net_device *ndev)
 		if (bd->phys)
 			break;	/* All skb's allocated */
 
-		skb = netdev_alloc_skb_ip_align(ndev, XTE_MAX_JUMBO_FRAME_SIZE);
+		skb = napi_alloc_skb(&lp->napi, XTE_MAX_JUMBO_FRAME_SIZE);
 		if (!skb) {
 			dev_warn(&ndev->dev, "skb alloc failed\n");
 			break;
@@ -1099,7 +1102,7 @@ static void ll_temac_recv(struct net_device *ndev)
 			lp->rx_bd_p + sizeof(*lp->rx_bd_v) * lp->rx_bd_tail);
 	}
 
-	spin_unlock_irqrestore(&lp->rx_lock, flags);
+	return done;
 }
 
 /* Function scheduled to ensure a restart in case of DMA halt
@@ -1109,9 +1112,37 @@ static void ll_temac_restart_work_func(struct work_struct *work)
 {
 	struct temac_local *lp = container_of(work, struct temac_local,
 					      restart_work.work);
-	struct net_device *ndev = lp->ndev;
 
-	ll_temac_recv(ndev);
+	local_bh_disable();
+	napi_schedule(&lp->napi);
+	local_bh_enable();
+}
+
+/* While NAPI polls, the DMA channels only raise error interrupts.
+ * Completions that happen in the meantime stay latched in the IRQ
+ * registers and fire once the coalesce and delay interrupts are
+ * enabled again.
+ */
+static void ll_temac_dma_irq_mask(struct temac_local *lp, int reg, u32 ctrl)
+{
+	lp->dma_out(lp, reg,
+		    ctrl & ~(CHNL_CTRL_IRQ_DLY_EN | CHNL_CTRL_IRQ_COAL_EN));
+}
+
+static int ll_temac_poll(struct napi_struct *napi, int budget)
+{
+	struct temac_local *lp = container_of(napi, struct temac_local, napi);
+	int work_done;
+
+	temac_start_xmit_done(lp->ndev, budget);
+	work_done = ll_temac_recv(lp->ndev, budget);
+
+	if (work_done < budget && napi_complete_done(napi, work_done)) {
+		lp->dma_out(lp, TX_CHNL_CTRL, lp->tx_chnl_ctrl);
+		lp->dma_out(lp, RX_CHNL_CTRL, lp->rx_chnl_ctrl);
+	}
+
+	return work_done;
 }
 
 static irqreturn_t ll_temac_tx_irq(int irq, void *_ndev)
@@ -1123,8 +1154,10 @@ static irqreturn_t ll_temac_tx_irq(int irq, void *_ndev)
 	status = lp->dma_in(lp, TX_IRQ_REG);
 	lp->dma_out(lp, TX_IRQ_REG, status);
 
-	if (status & (IRQ_COAL | IRQ_DLY))
-		temac_start_xmit_done(lp->ndev);
+	if (status & (IRQ_COAL | IRQ_DLY)) {
+		ll_temac_dma_irq_mask(lp, TX_CHNL_CTRL, lp->tx_chnl_ctrl);
+		napi_schedule(&lp->napi);
+	}
 	if (status & (IRQ_ERR | IRQ_DMAERR))
 		dev_err_ratelimited(&ndev->dev,
 				    "TX error 0x%x TX_CHNL_STS=0x%08x\n",
@@ -1143,8 +1176,10 @@ static irqreturn_t ll_temac_rx_irq(int irq, void *_ndev)
 	status = lp->dma_in(lp, RX_IRQ_REG);
 	lp->dma_out(lp, RX_IRQ_REG, status);
 
-	if (status & (IRQ_COAL | IRQ_DLY))
-		ll_temac_recv(lp->ndev);
+	if (status & (IRQ_COAL | IRQ_DLY)) {
+		ll_temac_dma_irq_mask(lp, RX_CHNL_CTRL, lp->rx_chnl_ctrl);
+		napi_schedule(&lp->napi);
+	}
 	if (status & (IRQ_ERR | IRQ_DMAERR))
 		dev_err_ratelimited(&ndev->dev,
 				    "RX error 0x%x RX_CHNL_STS=0x%08x\n",
@@ -1181,6 +1216,8 @@ static int temac_open(struct net_device *ndev)
 
 	temac_device_reset(ndev);
 
+	napi_enable(&lp->napi);
+
 	rc = request_irq(lp->tx_irq, ll_temac_tx_irq, 0, ndev->name, ndev);
 	if (rc)
 		goto err_tx_irq;
@@ -1193,6 +1230,7 @@ static int temac_open(struct net_device *ndev)
  err_rx_irq:
 	free_irq(lp->tx_irq, ndev);
  err_tx_irq:
+	napi_disable(&lp->napi);
 	if (phydev)
 		phy_disconnect(phydev);
 	dev_err(lp->dev, "request_irq() failed\n");
@@ -1211,6 +1249,8 @@ static int temac_stop(struct net_device *ndev)
 	free_irq(lp->tx_irq, ndev);
 	free_irq(lp->rx_irq, ndev);
 
+	napi_disable(&lp->napi);
+
 	if (phydev)
 		phy_disconnect(phydev);
 
@@ -1424,7 +1464,7 @@ static int temac_probe(struct platform_device *pdev)
 	lp->options = XTE_OPTION_DEFAULTS;
 	lp->rx_bd_num = RX_BD_NUM_DEFAULT;
 	lp->tx_bd_num = TX_BD_NUM_DEFAULT;
-	spin_lock_init(&lp->rx_lock);
+	netif_napi_add(ndev, &lp->napi, ll_temac_poll);
 	INIT_DELAYED_WORK(&lp->restart_work, ll_temac_restart_work_func);
 
 	/* Setup mutex for synchronization of indirect register access */
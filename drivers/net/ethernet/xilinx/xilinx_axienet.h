@@ -14,10 +14,18 @@
 #include <linux/netdevice.h>
 #include <linux/spinlock.h>
 #include <linux/interrupt.h>
+#include <linux/kthread.h>
 #include <linux/if_vlan.h>
 #include <linux/phylink.h>
 #include <linux/net_tstamp.h>
 #include <linux/of_platform.h>
+#include <linux/bpf.h>
+#include <linux/dim.h>
+#include <linux/u64_stats_sync.h>
+#include <net/page_pool.h>
+#include <net/xdp.h>
+#include <net/xdp_sock_drv.h>
+#include <net/tso.h>
 
 /* Packet size info */
 #define XAE_HDR_SIZE			14 /* Size of Ethernet header */
@@ -173,6 +181,13 @@
 #define XAXIFIFO_TXTS_TAG_SHIFT		16
 #define XAXIFIFO_TXTS_TAG_MAX		0xFFFE
 
+/* Tx skbs waiting for their timestamp, per queue. Power of two. */
+#define AXIENET_TXTS_RING	32
+/* Time a Tx skb waits for its timestamp before being dropped */
+#define AXIENET_TXTS_TIMEOUT	msecs_to_jiffies(100)
+/* Time the last word of a timestamp takes to reach the FIFO, in usecs */
+#define AXIENET_TXTS_WAIT_US	100
+
 /* Axi Ethernet registers definition */
 #define XAE_RAF_OFFSET		0x00000000 /* Reset and Address filter */
 #define XAE_TPF_OFFSET		0x00000004 /* Tx Pause Frame */
@@ -340,12 +355,22 @@
 /* Total number of entries in the hardware multicast table. */
 #define XAE_MULTICAST_CAM_TABLE_NUM	4
 
+/* The extended multicast table has one word per entry, bit 0 passes the
+ * 01:00:5e IPv4 groups whose low address bits index the entry.
+ */
+#define XAE_MCAST_TABLE_ENTRIES		0x8000
+#define XAE_MCAST_TABLE_PASS		BIT(0)
+
+/* Buckets of the software multicast filter, by last address byte */
+#define XAE_MC_FILTER_HASH_SIZE		256
+
 /* Axi Ethernet Synthesis features */
 #define XAE_FEATURE_PARTIAL_RX_CSUM	BIT(0)
 #define XAE_FEATURE_PARTIAL_TX_CSUM	BIT(1)
 #define XAE_FEATURE_FULL_RX_CSUM	BIT(2)
 #define XAE_FEATURE_FULL_TX_CSUM	BIT(3)
 #define XAE_FEATURE_DMA_64BIT		BIT(4)
+#define XAE_FEATURE_EXT_MCAST		BIT(5)
 
 #define XAE_NO_CSUM_OFFLOAD		0
 
@@ -487,14 +512,26 @@
 #define XMCDMA_TXWEIGHT_CH_MASK(chan_id)	GENMASK(((chan_id) * 4 + 3), \
 							(chan_id) * 4)
 #define XMCDMA_TXWEIGHT_CH_SHIFT(chan_id)	((chan_id) * 4)
+#define XMCDMA_TXWEIGHT_MAX			0xF
 
 /* PTP Packet length */
 #define XAE_TX_PTP_LEN		16
 #define XXV_TX_PTP_LEN		12
 
+/* Headroom reserved in front of every Rx frame in a page pool buffer,
+ * large enough for XDP programs to push headers.
+ */
+#define XAE_RX_HEADROOM		XDP_PACKET_HEADROOM
+
+/* XDP verdicts as seen by the Rx path */
+#define AXIENET_XDP_PASS	0
+#define AXIENET_XDP_CONSUMED	BIT(0)
+#define AXIENET_XDP_TX		BIT(1)
+#define AXIENET_XDP_REDIRECT	BIT(2)
+
 /* Macros used when AXI DMA h/w is configured without DRE */
-#define XAE_TX_BUFFERS		64
 #define XAE_MAX_PKT_LEN		8192
+#define XAE_TX_DMA_ALIGN	4	/* Tx buffer alignment without DRE */
 
 /* MRMAC Register Definitions */
 /* Configuration Registers */
@@ -590,11 +627,9 @@
  * @app3:         MM2S/S2MM User Application Field 3.
  * @app4:         MM2S/S2MM User Application Field 4.
  * @sw_id_offset: MM2S/S2MM Sw ID
- * @ptp_tx_skb:   If timestamping is enabled used for timestamping skb
- *		  Otherwise reserved.
  * @ptp_tx_ts_tag: Tag value of 2 step timestamping if timestamping is enabled
  *		   Otherwise reserved.
- * @tx_skb:	  Transmit skb address
+ * @tx_skb:	  Transmit skb or xdp_frame address
  * @tx_desc_mapping: Tx Descriptor DMA mapping type.
  */
 struct axidma_bd {
@@ -616,7 +651,6 @@ struct axidma_bd {
 	u32 app3;
 	u32 app4;
 	phys_addr_t sw_id_offset; /* first unused field by h/w */
-	phys_addr_t ptp_tx_skb;
 	u32 ptp_tx_ts_tag;
 	phys_addr_t tx_skb;
 	u32 tx_desc_mapping;
@@ -638,11 +672,9 @@ struct axidma_bd {
  * @app3:         MM2S/S2MM User Application Field 3.
  * @app4:         MM2S/S2MM User Application Field 4.
  * @sw_id_offset: MM2S/S2MM Sw ID
- * @ptp_tx_skb:   If timestamping is enabled used for timestamping skb
- *		  Otherwise reserved.
  * @ptp_tx_ts_tag: Tag value of 2 step timestamping if timestamping is enabled
  *		   Otherwise reserved.
- * @tx_skb:	  Transmit skb address
+ * @tx_skb:	  Transmit skb or xdp_frame address
  * @tx_desc_mapping: Tx Descriptor DMA mapping type.
  */
 struct aximcdma_bd {
@@ -664,7 +696,6 @@ struct aximcdma_bd {
 	u32 app3;
 	u32 app4;
 	phys_addr_t sw_id_offset; /* first unused field by h/w */
-	phys_addr_t ptp_tx_skb;
 	u32 ptp_tx_ts_tag;
 	phys_addr_t tx_skb;
 	u32 tx_desc_mapping;
@@ -673,6 +704,16 @@ struct aximcdma_bd {
 #define XAE_NUM_MISC_CLOCKS 3
 #define DESC_DMA_MAP_SINGLE 0
 #define DESC_DMA_MAP_PAGE 1
+/* xdp_frame not mapped by the driver (page pool or bounce area) */
+#define DESC_DMA_MAP_XDP 2
+/* xdp_frame mapped with dma_map_single() by ndo_xdp_xmit */
+#define DESC_DMA_MAP_XDP_SINGLE 3
+/* AF_XDP Tx descriptor, UMEM mapped by the xsk buffer pool */
+#define DESC_DMA_MAP_XSK 4
+/* Unaligned head of an skb buffer copied into the tx_bufs bounce area */
+#define DESC_DMA_MAP_BOUNCE 5
+/* Segment header built by the driver TSO in the tso_hdrs area */
+#define DESC_DMA_MAP_TSO_HDR 6
 
 #if defined(CONFIG_AXIENET_HAS_MCDMA)
 #define XAE_MAX_QUEUES		16
@@ -718,13 +759,17 @@ struct aximcdma_bd {
  * @coalesce_usec_rx:	IRQ coalesce delay for RX
  * @coalesce_count_tx:	Store the irq coalesce on TX side.
  * @coalesce_usec_tx:	IRQ coalesce delay for TX
+ * @rx_dim_enabled:	Adapt the RX coalesce settings with net DIM.
+ * @tx_dim_enabled:	Adapt the TX coalesce settings with net DIM.
  * @eth_hasnobuf: Ethernet is configured in Non buf mode.
  * @eth_hasptp: Ethernet is configured for ptp.
  * @axienet_config: Ethernet config structure
  * @tx_ts_regs:	  Base address for the axififo device address space.
  * @rx_ts_regs:	  Base address for the rx axififo device address space.
  * @tstamp_config: Hardware timestamp config structure.
- * @tx_ptpheader: Stores the tx ptp header.
+ * @ptp_txts_worker: Worker reading the Tx timestamp FIFO, while the
+ *		interface is up.
+ * @ptp_txts_work: Drains the Tx timestamp FIFO, see axienet_txts_work().
  * @aclk: AXI4-Lite clock for ethernet and dma.
  * @eth_sclk: AXI4-Stream interface clock.
  * @eth_refclk: Stable clock used by signal delay primitives and transceivers.
@@ -745,6 +790,10 @@ struct aximcdma_bd {
  * @gt_lane: MRMAC GT lane index used.
  * @ptp_os_cf: CF TS of PTP PDelay req for one step usage.
  * @xxv_ip_version: XXV IP version
+ * @xdp_prog: XDP program attached to the interface, NULL if none.
+ * @mc_filter: Multicast groups the Rx path filters on in software, NULL
+ *	       when the MAC does all the filtering.
+ * @mcast_table: Entries set in the extended multicast table, if any.
  */
 struct axienet_local {
 	struct net_device *ndev;
@@ -795,6 +844,8 @@ struct axienet_local {
 	u32 coalesce_usec_rx;
 	u32 coalesce_count_tx;
 	u32 coalesce_usec_tx;
+	bool rx_dim_enabled;
+	bool tx_dim_enabled;
 	bool eth_hasnobuf;
 	bool eth_hasptp;
 	const struct axienet_config *axienet_config;
@@ -803,7 +854,8 @@ struct axienet_local {
 	void __iomem *tx_ts_regs;
 	void __iomem *rx_ts_regs;
 	struct hwtstamp_config tstamp_config;
-	u8 *tx_ptpheader;
+	struct kthread_worker *ptp_txts_worker;
+	struct kthread_delayed_work ptp_txts_work;
 #endif
 	struct clk *aclk;
 	struct clk *eth_sclk;
@@ -830,6 +882,83 @@ struct axienet_local {
 	u32 gt_lane;		/* MRMAC GT lane index used */
 	u64 ptp_os_cf;		/* CF TS of PTP PDelay req for one step usage */
 	u32 xxv_ip_version;
+	struct bpf_prog *xdp_prog;
+	struct axienet_mc_filter __rcu *mc_filter;
+	unsigned long *mcast_table;
+};
+
+/**
+ * struct axienet_mc_filter - Software multicast filter
+ * @rcu:	Frees the filter after the Rx path stopped using it
+ * @hash:	Buckets of @addrs by last address byte, most unwanted frames
+ *		are rejected on it alone
+ * @promisc:	The MAC is promiscuous, also drop unicast frames that are
+ *		not for the interface
+ * @count:	Number of entries in @addrs
+ * @addrs:	Multicast addresses the interface listens to
+ */
+struct axienet_mc_filter {
+	struct rcu_head rcu;
+	DECLARE_BITMAP(hash, XAE_MC_FILTER_HASH_SIZE);
+	bool promisc;
+	unsigned int count;
+	u8 addrs[][ETH_ALEN];
+};
+
+/**
+ * struct axienet_rx_stats - Rx statistics of a DMA queue
+ * @packets:	Number of frames received, including those consumed by XDP
+ * @bytes:	Number of bytes received
+ * @dropped:	Frames dropped because no skb could be built for them
+ * @alloc_failed: Times a completed Rx BD was left on the ring because no
+ *		replacement buffer could be allocated
+ * @syncp:	Synchronizes 64-bit reads, updated from the NAPI poll only
+ */
+struct axienet_rx_stats {
+	u64 packets;
+	u64 bytes;
+	u64 dropped;
+	u64 alloc_failed;
+	struct u64_stats_sync syncp;
+};
+
+/**
+ * struct axienet_tx_stats - Tx completion statistics of a DMA queue
+ * @packets:	Number of Tx BD chains completed
+ * @bytes:	Number of bytes transmitted
+ * @syncp:	Synchronizes 64-bit reads, updated from the NAPI poll only
+ */
+struct axienet_tx_stats {
+	u64 packets;
+	u64 bytes;
+	struct u64_stats_sync syncp;
+};
+
+/**
+ * struct axienet_xmit_stats - Tx submission statistics of a DMA queue
+ * @dropped:	Frames dropped by the driver before reaching the ring
+ * @ring_full:	Frames that found no room on the Tx BD ring
+ * @bounced_bytes: Number of bytes copied into the bounce area because they
+ *		were not aligned for a DMA without DRE
+ * @syncp:	Synchronizes 64-bit reads, updated under the tx_lock only
+ */
+struct axienet_xmit_stats {
+	u64 dropped;
+	u64 ring_full;
+	u64 bounced_bytes;
+	struct u64_stats_sync syncp;
+};
+
+/**
+ * struct axienet_txts - Tx skb waiting for its hardware timestamp
+ * @skb:	Clone of the transmitted skb, owned by the ring
+ * @expires:	jiffies after which the timestamp is given up on
+ * @tag:	Tag the timestamp is reported with by the FIFO
+ */
+struct axienet_txts {
+	struct sk_buff *skb;
+	unsigned long expires;
+	u32 tag;
 };
 
 /**
@@ -840,15 +969,18 @@ struct axienet_local {
  * @rx_irq:	Axidma RX IRQ number
  * @tx_lock:	Spin lock for tx path
  * @rx_lock:	Spin lock for tx path
+ * @qidx:	Index of this queue in the dq[] and napi[] arrays
  * @tx_bd_v:	Virtual address of the TX buffer descriptor ring
  * @tx_bd_p:	Physical address(start address) of the TX buffer descr. ring
  * @rx_bd_v:	Virtual address of the RX buffer descriptor ring
  * @rx_bd_p:	Physical address(start address) of the RX buffer descr. ring
- * @tx_buf:	Virtual address of the Tx buffer pool used by the driver when
- *		DMA h/w is configured without DRE.
- * @tx_bufs:	Virutal address of the Tx buffer address.
- * @tx_bufs_dma: Physical address of the Tx buffer address used by the driver
- *		 when DMA h/w is configured without DRE.
+ * @tx_bufs:	Virtual address of the Tx bounce area used by the driver when
+ *		DMA h/w is configured without DRE, one XAE_MAX_PKT_LEN buffer
+ *		per Tx BD. See axienet_tx_buf().
+ * @tx_bufs_dma: Physical address of the Tx bounce area.
+ * @tso_hdrs:	Virtual address of the TSO header area, one TSO_HEADER_SIZE
+ *		header per Tx BD. See axienet_tso_hdr().
+ * @tso_hdrs_dma: Physical address of the TSO header area.
  * @eth_hasdre: Tells whether DMA h/w is configured with dre or not.
  * @tx_bd_ci:	Stores the index of the Tx buffer descriptor in the ring being
  *		accessed currently. Used while alloc. BDs before a TX starts
@@ -861,10 +993,33 @@ struct axienet_local {
  * @rx_offset:	MCDMA S2MM channel starting offset.
  * @txq_bd_v:	Virtual address of the MCDMA TX buffer descriptor ring
  * @rxq_bd_v:	Virtual address of the MCDMA RX buffer descriptor ring
- * @tx_packets: Number of transmit packets processed by the dma queue.
- * @tx_bytes:   Number of transmit bytes processed by the dma queue.
- * @rx_packets: Number of receive packets processed by the dma queue.
- * @rx_bytes:	Number of receive bytes processed by the dma queue.
+ * @cbs_enabled: A CBS qdisc is offloaded to the MCDMA Tx channel
+ * @cbs_weight:	WRR weight of the Tx channel programmed for CBS
+ * @tx_weight:	WRR weight of the Tx channel before CBS was offloaded
+ * @page_pool:	Page pool providing the DMA-mapped Rx buffers of this queue
+ * @xdp_rxq:	XDP Rx queue information registered for this queue
+ * @xsk_pool:	AF_XDP buffer pool bound to this queue for zero-copy, if any
+ * @rx_bd_fill: Index of the next Rx BD to give an AF_XDP buffer to
+ * @rx_skb:	Frame being assembled from page sized buffers, until the BD
+ *		carrying its end of frame is seen. See axienet_recv_sg().
+ * @rx_dim:	net DIM state of the Rx channel
+ * @tx_dim:	net DIM state of the Tx channel
+ * @dim_events:	Number of NAPI completions, sampled by net DIM
+ * @rx_dim_cr:	Coalesce and delay fields of the Rx channel CR chosen by DIM
+ * @tx_dim_cr:	Coalesce and delay fields of the Tx channel CR chosen by DIM
+ * @rx_dim_pending: @rx_dim_cr is to be written at the next NAPI completion
+ * @tx_dim_pending: @tx_dim_cr is to be written at the next NAPI completion
+ * @tx_kick_pending: Tx BDs were queued under xmit_more without moving the
+ *		tail descriptor yet. See axienet_tx_kick().
+ * @rx_stats:	Rx statistics of the queue
+ * @tx_stats:	Tx completion statistics of the queue
+ * @xmit_stats:	Tx submission statistics of the queue
+ * @ptp_txts:	Two step Tx skbs waiting for their timestamp, in transmit
+ *		order
+ * @ptp_txts_head: Free running index of the oldest @ptp_txts entry, only
+ *		advanced by the timestamp worker
+ * @ptp_txts_tail: Free running index of the next free @ptp_txts entry, only
+ *		advanced under @tx_lock
  */
 struct axienet_dma_q {
 	struct axienet_local	*lp; /* parent */
@@ -875,6 +1030,7 @@ struct axienet_dma_q {
 
 	spinlock_t tx_lock;		/* tx lock */
 	spinlock_t rx_lock;		/* rx lock */
+	u16 qidx;
 
 	/* Buffer descriptors */
 	struct axidma_bd *tx_bd_v;
@@ -882,9 +1038,10 @@ struct axienet_dma_q {
 	dma_addr_t rx_bd_p;
 	dma_addr_t tx_bd_p;
 
-	unsigned char *tx_buf[XAE_TX_BUFFERS];
 	unsigned char *tx_bufs;
 	dma_addr_t tx_bufs_dma;
+	char *tso_hdrs;
+	dma_addr_t tso_hdrs_dma;
 	bool eth_hasdre;
 
 	u32 tx_bd_ci;
@@ -896,16 +1053,89 @@ struct axienet_dma_q {
 	u32 rx_offset;
 	struct aximcdma_bd *txq_bd_v;
 	struct aximcdma_bd *rxq_bd_v;
+	bool cbs_enabled;
+	u8 cbs_weight;
+	u8 tx_weight;
+
+	struct page_pool *page_pool;
+	struct xdp_rxq_info xdp_rxq;
+	struct xsk_buff_pool *xsk_pool;
+	u32 rx_bd_fill;
+	struct sk_buff *rx_skb;
+
+	struct dim rx_dim;
+	struct dim tx_dim;
+	u16 dim_events;
+	u32 rx_dim_cr;
+	u32 tx_dim_cr;
+	bool rx_dim_pending;
+	bool tx_dim_pending;
+	bool tx_kick_pending;
+
+	struct axienet_rx_stats rx_stats;
+	struct axienet_tx_stats tx_stats;
+	struct axienet_xmit_stats xmit_stats;
 
-	unsigned long tx_packets;
-	unsigned long tx_bytes;
-	unsigned long rx_packets;
-	unsigned long rx_bytes;
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+	struct axienet_txts ptp_txts[AXIENET_TXTS_RING];
+	u32 ptp_txts_head;
+	u32 ptp_txts_tail;
+#endif
 };
 
 #define AXIENET_ETHTOOLS_SSTATS_LEN 6
 #define AXIENET_TX_SSTATS_LEN(lp) ((lp)->num_tx_queues * 2)
 #define AXIENET_RX_SSTATS_LEN(lp) ((lp)->num_rx_queues * 2)
+/* txqN_dropped, txqN_ring_full, txqN_bounced_bytes, rxqN_dropped and
+ * rxqN_alloc_failed
+ */
+#define AXIENET_Q_SSTATS_LEN(lp) ((lp)->num_tx_queues * 3 + \
+				  (lp)->num_rx_queues * 2)
+
+/**
+ * axienet_read_rx_stats - Take a consistent snapshot of the Rx statistics
+ * @q:		Pointer to DMA queue structure
+ * @s:		Snapshot, its syncp is not used
+ */
+static inline void axienet_read_rx_stats(struct axienet_dma_q *q,
+					 struct axienet_rx_stats *s)
+{
+	unsigned int start;
+
+	do {
+		start = u64_stats_fetch_begin_irq(&q->rx_stats.syncp);
+		s->packets = q->rx_stats.packets;
+		s->bytes = q->rx_stats.bytes;
+		s->dropped = q->rx_stats.dropped;
+		s->alloc_failed = q->rx_stats.alloc_failed;
+	} while (u64_stats_fetch_retry_irq(&q->rx_stats.syncp, start));
+}
+
+/**
+ * axienet_read_tx_stats - Take a consistent snapshot of the Tx statistics
+ * @q:		Pointer to DMA queue structure
+ * @s:		Snapshot of the completion statistics, its syncp is not used
+ * @x:		Snapshot of the submission statistics, its syncp is not used
+ */
+static inline void axienet_read_tx_stats(struct axienet_dma_q *q,
+					 struct axienet_tx_stats *s,
+					 struct axienet_xmit_stats *x)
+{
+	unsigned int start;
+
+	do {
+		start = u64_stats_fetch_begin_irq(&q->tx_stats.syncp);
+		s->packets = q->tx_stats.packets;
+		s->bytes = q->tx_stats.bytes;
+	} while (u64_stats_fetch_retry_irq(&q->tx_stats.syncp, start));
+
+	do {
+		start = u64_stats_fetch_begin_irq(&q->xmit_stats.syncp);
+		x->dropped = q->xmit_stats.dropped;
+		x->ring_full = q->xmit_stats.ring_full;
+		x->bounced_bytes = q->xmit_stats.bounced_bytes;
+	} while (u64_stats_fetch_retry_irq(&q->xmit_stats.syncp, start));
+}
 
 /**
  * enum axienet_ip_type - AXIENET IP/MAC type.
@@ -1136,6 +1366,110 @@ static inline void axienet_dma_bdout(struct axienet_dma_q *q,
 #endif
 }
 
+/**
+ * axienet_tx_buf - Bounce buffer of a Tx BD
+ * @q:		Pointer to DMA queue structure
+ * @idx:	Index of the Tx BD
+ *
+ * Return: Virtual address of the bounce buffer, only valid without DRE.
+ */
+static inline unsigned char *axienet_tx_buf(struct axienet_dma_q *q, u32 idx)
+{
+	return q->tx_bufs + idx * XAE_MAX_PKT_LEN;
+}
+
+/**
+ * axienet_tx_buf_dma - Bus address of the bounce buffer of a Tx BD
+ * @q:		Pointer to DMA queue structure
+ * @idx:	Index of the Tx BD
+ *
+ * Return: Bus address of the bounce buffer, only valid without DRE.
+ */
+static inline dma_addr_t axienet_tx_buf_dma(struct axienet_dma_q *q, u32 idx)
+{
+	return q->tx_bufs_dma + idx * XAE_MAX_PKT_LEN;
+}
+
+/**
+ * axienet_tso_hdr - TSO segment header buffer of a Tx BD
+ * @q:		Pointer to DMA queue structure
+ * @idx:	Index of the Tx BD
+ *
+ * Return: Virtual address of the header buffer, only valid with TSO.
+ */
+static inline char *axienet_tso_hdr(struct axienet_dma_q *q, u32 idx)
+{
+	return q->tso_hdrs + idx * TSO_HEADER_SIZE;
+}
+
+/**
+ * axienet_tso_hdr_dma - Bus address of the TSO header buffer of a Tx BD
+ * @q:		Pointer to DMA queue structure
+ * @idx:	Index of the Tx BD
+ *
+ * Return: Bus address of the header buffer, only valid with TSO.
+ */
+static inline dma_addr_t axienet_tso_hdr_dma(struct axienet_dma_q *q, u32 idx)
+{
+	return q->tso_hdrs_dma + idx * TSO_HEADER_SIZE;
+}
+
+/**
+ * axienet_rx_frame_order - Page order of a buffer holding a whole frame
+ * @lp:		Pointer to axienet local structure
+ *
+ * Return: The page order needed to hold the Rx headroom, a max_frm_size
+ *	   frame and the trailing skb_shared_info used by build_skb().
+ */
+static inline unsigned int axienet_rx_frame_order(struct axienet_local *lp)
+{
+	return get_order(SKB_DATA_ALIGN(XAE_RX_HEADROOM + lp->max_frm_size) +
+			 SKB_DATA_ALIGN(sizeof(struct skb_shared_info)));
+}
+
+/**
+ * axienet_rx_scatter - Tell whether frames are received into several buffers
+ * @lp:		Pointer to axienet local structure
+ *
+ * High order pages are hard to come by on a fragmented system, so a frame
+ * that does not fit a single page is spread over several order-0 buffers,
+ * one BD each. XDP programs need the whole frame in one buffer, hence the
+ * ring is only set up this way while no program is attached. Queues bound
+ * to an AF_XDP socket always use single buffers from the socket's umem.
+ *
+ * Return: true if the Rx rings are filled with order-0 pages.
+ */
+static inline bool axienet_rx_scatter(struct axienet_local *lp)
+{
+	return !READ_ONCE(lp->xdp_prog) && axienet_rx_frame_order(lp);
+}
+
+/**
+ * axienet_rx_buf_order - Page order of a Rx buffer
+ * @lp:		Pointer to axienet local structure
+ *
+ * Return: The page order of the buffers of the page pool backed Rx rings.
+ */
+static inline unsigned int axienet_rx_buf_order(struct axienet_local *lp)
+{
+	return axienet_rx_scatter(lp) ? 0 : axienet_rx_frame_order(lp);
+}
+
+/**
+ * axienet_rx_buf_len - Length programmed in the BDs of a Rx ring
+ * @lp:		Pointer to axienet local structure
+ *
+ * Return: The part of a page pool buffer left to the hardware after the
+ *	   headroom and, in scatter mode, the skb_shared_info trailer.
+ */
+static inline u32 axienet_rx_buf_len(struct axienet_local *lp)
+{
+	if (axienet_rx_scatter(lp))
+		return SKB_WITH_OVERHEAD(PAGE_SIZE) - XAE_RX_HEADROOM;
+
+	return lp->max_frm_size;
+}
+
 /* Function prototypes visible in xilinx_axienet_mdio.c for other files */
 int axienet_mdio_enable(struct axienet_local *lp);
 void axienet_mdio_disable(struct axienet_local *lp);
@@ -1145,6 +1479,16 @@ void __maybe_unused axienet_bd_free(struct net_device *ndev,
 				    struct axienet_dma_q *q);
 int __maybe_unused axienet_dma_q_init(struct net_device *ndev,
 				      struct axienet_dma_q *q);
+int axienet_rx_page_pool_create(struct net_device *ndev,
+				struct axienet_dma_q *q);
+void axienet_rx_page_pool_destroy(struct axienet_dma_q *q);
+struct page *axienet_rx_page_alloc(struct axienet_dma_q *q,
+				   dma_addr_t *mapping);
+void axienet_rx_page_free(struct axienet_dma_q *q, struct page *page);
+void *axienet_rx_buf_alloc(struct axienet_dma_q *q, dma_addr_t *mapping);
+void axienet_rx_buf_free(struct axienet_dma_q *q, void *buf);
+void axienet_rx_zc_refill(struct axienet_dma_q *q);
+void axienet_tx_bd_clean(struct net_device *ndev, struct axienet_dma_q *q);
 void axienet_dma_err_handler(unsigned long data);
 irqreturn_t __maybe_unused axienet_tx_irq(int irq, void *_ndev);
 irqreturn_t __maybe_unused axienet_rx_irq(int irq, void *_ndev);
@@ -1153,6 +1497,12 @@ void axienet_dma_bd_release(struct net_device *ndev);
 void __axienet_device_reset(struct axienet_dma_q *q);
 void axienet_set_mac_address(struct net_device *ndev, const void *address);
 void axienet_set_multicast_list(struct net_device *ndev);
+
+/* Function prototypes visible in xilinx_axienet_selftest.c for other files */
+int axienet_selftest_count(struct axienet_local *lp);
+void axienet_selftest_strings(struct axienet_local *lp, u8 *data);
+void axienet_self_test(struct net_device *ndev, struct ethtool_test *etest,
+		       u64 *data);
 int xaxienet_rx_poll(struct napi_struct *napi, int quota);
 
 #if defined(CONFIG_AXIENET_HAS_MCDMA)
@@ -1168,10 +1518,11 @@ irqreturn_t __maybe_unused axienet_mcdma_tx_irq(int irq, void *_ndev);
 irqreturn_t __maybe_unused axienet_mcdma_rx_irq(int irq, void *_ndev);
 void __maybe_unused axienet_mcdma_err_handler(unsigned long data);
 void axienet_strings(struct net_device *ndev, u32 sset, u8 *data);
-int axienet_sset_count(struct net_device *ndev, int sset);
 void axienet_get_stats(struct net_device *ndev,
 		       struct ethtool_stats *stats,
 		       u64 *data);
+int axienet_mcdma_setup_tc(struct net_device *ndev, enum tc_setup_type type,
+			   void *type_data);
 int axeinet_mcdma_create_sysfs(struct kobject *kobj);
 void axeinet_mcdma_remove_sysfs(struct kobject *kobj);
 int __maybe_unused axienet_mcdma_tx_probe(struct platform_device *pdev,
@@ -1182,13 +1533,6 @@ int __maybe_unused axienet_mcdma_rx_probe(struct platform_device *pdev,
 					  struct net_device *ndev);
 #endif
 
-#ifdef CONFIG_AXIENET_HAS_MCDMA
-void axienet_tx_hwtstamp(struct axienet_local *lp,
-			 struct aximcdma_bd *cur_p);
-#else
-void axienet_tx_hwtstamp(struct axienet_local *lp,
-			 struct axidma_bd *cur_p);
-#endif
 u32 axienet_usec_to_timer(struct axienet_local *lp, u32 coalesce_usec);
 
 #endif /* XILINX_AXI_ENET_H */
@@ -30,20 +30,21 @@ void __maybe_unused axienet_bd_free(struct net_device *ndev,
 	int i;
 	struct axienet_local *lp = netdev_priv(ndev);
 
-	for (i = 0; i < lp->rx_bd_num; i++) {
-		if (q->rx_bd_v[i].phys)
-			dma_unmap_single(ndev->dev.parent, q->rx_bd_v[i].phys,
-					 lp->max_frm_size, DMA_FROM_DEVICE);
-		dev_kfree_skb((struct sk_buff *)
-			      (q->rx_bd_v[i].sw_id_offset));
-	}
-
 	if (q->rx_bd_v) {
+		for (i = 0; i < lp->rx_bd_num; i++)
+			axienet_rx_buf_free(q, (void *)
+					    (q->rx_bd_v[i].sw_id_offset));
+
 		dma_free_coherent(ndev->dev.parent,
 				  sizeof(*q->rx_bd_v) * lp->rx_bd_num,
 				  q->rx_bd_v,
 				  q->rx_bd_p);
+		q->rx_bd_v = NULL;
 	}
+	dev_kfree_skb(q->rx_skb);
+	q->rx_skb = NULL;
+	axienet_rx_page_pool_destroy(q);
+
 	if (q->tx_bd_v) {
 		dma_free_coherent(ndev->dev.parent,
 				  sizeof(*q->tx_bd_v) * lp->tx_bd_num,
@@ -56,6 +57,189 @@ void __maybe_unused axienet_bd_free(struct net_device *ndev,
 				  q->tx_bufs,
 				  q->tx_bufs_dma);
 	}
+	if (q->tso_hdrs) {
+		dma_free_coherent(ndev->dev.parent,
+				  TSO_HEADER_SIZE * lp->tx_bd_num,
+				  q->tso_hdrs,
+				  q->tso_hdrs_dma);
+		q->tso_hdrs = NULL;
+	}
+}
+
+/**
+ * axienet_rx_page_pool_create - Create the page pool backing a Rx queue
+ * @ndev:	Pointer to the net_device structure
+ * @q:		Pointer to DMA queue structure
+ *
+ * The pool hands out DMA-mapped pages large enough for XAE_RX_HEADROOM, a
+ * max_frm_size frame and the skb_shared_info trailer, so that received
+ * frames can be turned into skbs with napi_build_skb() and the pages
+ * recycled without any further mapping or slab allocation. Order-0 pages
+ * are used instead when such a frame would need more than one page, see
+ * axienet_rx_scatter(). The pool is also
+ * registered as the memory model of the queue's XDP Rx queue info. Pages are
+ * mapped bidirectionally while an XDP program is attached so that XDP_TX
+ * can send them back out without remapping.
+ *
+ * A queue bound to an AF_XDP socket in zero-copy mode takes its buffers from
+ * the xsk buffer pool instead, and no page pool is created for it.
+ *
+ * Return: 0, on success. Negative error value on failure.
+ */
+int axienet_rx_page_pool_create(struct net_device *ndev,
+				struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct page_pool_params pp_params = {
+		.order = axienet_rx_buf_order(lp),
+		.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV,
+		.pool_size = lp->rx_bd_num,
+		.nid = dev_to_node(ndev->dev.parent),
+		.dev = ndev->dev.parent,
+		.dma_dir = lp->xdp_prog ? DMA_BIDIRECTIONAL : DMA_FROM_DEVICE,
+		.offset = XAE_RX_HEADROOM,
+		.max_len = axienet_rx_buf_len(lp),
+	};
+	int ret;
+
+	if (q->xsk_pool) {
+		ret = xdp_rxq_info_reg(&q->xdp_rxq, ndev, q->qidx,
+				       lp->napi[q->qidx].napi_id);
+		if (ret)
+			goto err_out;
+
+		ret = xdp_rxq_info_reg_mem_model(&q->xdp_rxq,
+						 MEM_TYPE_XSK_BUFF_POOL, NULL);
+		if (ret) {
+			xdp_rxq_info_unreg(&q->xdp_rxq);
+			goto err_out;
+		}
+		xsk_pool_set_rxq_info(q->xsk_pool, &q->xdp_rxq);
+
+		return 0;
+	}
+
+	q->page_pool = page_pool_create(&pp_params);
+	if (IS_ERR(q->page_pool)) {
+		ret = PTR_ERR(q->page_pool);
+		q->page_pool = NULL;
+		netdev_err(ndev, "%s: page pool creation failed %d\n",
+			   __func__, ret);
+		return ret;
+	}
+
+	ret = xdp_rxq_info_reg(&q->xdp_rxq, ndev, q->qidx,
+			       lp->napi[q->qidx].napi_id);
+	if (ret)
+		goto err_pool;
+
+	ret = xdp_rxq_info_reg_mem_model(&q->xdp_rxq, MEM_TYPE_PAGE_POOL,
+					 q->page_pool);
+	if (ret)
+		goto err_rxq;
+
+	return 0;
+
+err_rxq:
+	xdp_rxq_info_unreg(&q->xdp_rxq);
+err_pool:
+	page_pool_destroy(q->page_pool);
+	q->page_pool = NULL;
+err_out:
+	netdev_err(ndev, "%s: xdp rxq registration failed %d\n",
+		   __func__, ret);
+	return ret;
+}
+
+/**
+ * axienet_rx_page_pool_destroy - Release the page pool of a Rx queue
+ * @q:		Pointer to DMA queue structure
+ *
+ * All pages owned by the Rx ring must have been returned to the pool with
+ * axienet_rx_page_free() before this is called.
+ */
+void axienet_rx_page_pool_destroy(struct axienet_dma_q *q)
+{
+	if (xdp_rxq_info_is_reg(&q->xdp_rxq))
+		xdp_rxq_info_unreg(&q->xdp_rxq);
+
+	if (!q->page_pool)
+		return;
+
+	page_pool_destroy(q->page_pool);
+	q->page_pool = NULL;
+}
+
+/**
+ * axienet_rx_page_alloc - Get a DMA-mapped Rx buffer from the queue pool
+ * @q:		Pointer to DMA queue structure
+ * @mapping:	Returns the bus address the DMA engine should write to
+ *
+ * Return: The page backing the buffer, NULL if the pool is exhausted.
+ */
+struct page *axienet_rx_page_alloc(struct axienet_dma_q *q,
+				   dma_addr_t *mapping)
+{
+	struct page *page;
+
+	page = page_pool_dev_alloc_pages(q->page_pool);
+	if (unlikely(!page))
+		return NULL;
+
+	*mapping = page_pool_get_dma_addr(page) + XAE_RX_HEADROOM;
+
+	return page;
+}
+
+/**
+ * axienet_rx_page_free - Return a Rx buffer owned by the ring to its pool
+ * @q:		Pointer to DMA queue structure
+ * @page:	Page to be released, may be NULL
+ */
+void axienet_rx_page_free(struct axienet_dma_q *q, struct page *page)
+{
+	if (page)
+		page_pool_put_full_page(q->page_pool, page, false);
+}
+
+/**
+ * axienet_rx_buf_alloc - Get a Rx buffer for a BD of the queue
+ * @q:		Pointer to DMA queue structure
+ * @mapping:	Returns the bus address the DMA engine should write to
+ *
+ * Return: The page, or the xdp_buff of a zero-copy AF_XDP queue, to be kept
+ *	   in the BD sw_id_offset. NULL if no buffer is available.
+ */
+void *axienet_rx_buf_alloc(struct axienet_dma_q *q, dma_addr_t *mapping)
+{
+	struct xdp_buff *xdp;
+
+	if (!q->xsk_pool)
+		return axienet_rx_page_alloc(q, mapping);
+
+	xdp = xsk_buff_alloc(q->xsk_pool);
+	if (unlikely(!xdp))
+		return NULL;
+
+	*mapping = xsk_buff_xdp_get_dma(xdp);
+
+	return xdp;
+}
+
+/**
+ * axienet_rx_buf_free - Release a Rx buffer owned by the ring
+ * @q:		Pointer to DMA queue structure
+ * @buf:	Buffer returned by axienet_rx_buf_alloc(), may be NULL
+ */
+void axienet_rx_buf_free(struct axienet_dma_q *q, void *buf)
+{
+	if (!buf)
+		return;
+
+	if (q->xsk_pool)
+		xsk_buff_free(buf);
+	else
+		axienet_rx_page_free(q, buf);
 }
 
 /**
@@ -95,9 +279,15 @@ static int __dma_txq_init(struct net_device *ndev, struct axienet_dma_q *q)
 						GFP_KERNEL);
 		if (!q->tx_bufs)
 			goto out;
+	}
 
-		for (i = 0; i < lp->tx_bd_num; i++)
-			q->tx_buf[i] = &q->tx_bufs[i * XAE_MAX_PKT_LEN];
+	if (ndev->hw_features & (NETIF_F_TSO | NETIF_F_GSO_UDP_L4)) {
+		q->tso_hdrs = dma_alloc_coherent(ndev->dev.parent,
+						 TSO_HEADER_SIZE * lp->tx_bd_num,
+						 &q->tso_hdrs_dma,
+						 GFP_KERNEL);
+		if (!q->tso_hdrs)
+			goto out;
 	}
 
 	/* Start updating the Tx channel control register */
@@ -143,11 +333,15 @@ static int __dma_rxq_init(struct net_device *ndev,
 {
 	int i;
 	u32 cr;
-	struct sk_buff *skb;
+	struct page *page;
+	dma_addr_t mapping;
 	struct axienet_local *lp = netdev_priv(ndev);
 	/* Reset the indexes which are used for accessing the BDs */
 	q->rx_bd_ci = 0;
 
+	if (axienet_rx_page_pool_create(ndev, q))
+		goto out;
+
 	/* Allocate the Rx buffer descriptors. */
 	q->rx_bd_v = dma_alloc_coherent(ndev->dev.parent,
 					sizeof(*q->rx_bd_v) * lp->rx_bd_num,
@@ -160,26 +354,19 @@ static int __dma_rxq_init(struct net_device *ndev,
 				     sizeof(*q->rx_bd_v) *
 				     ((i + 1) % lp->rx_bd_num);
 
-		skb = netdev_alloc_skb(ndev, lp->max_frm_size);
-		if (!skb)
-			goto out;
+		/* AF_XDP buffers are handed out by axienet_rx_zc_refill() */
+		if (q->xsk_pool)
+			continue;
 
-		/* Ensure that the skb is completely updated
-		 * prio to mapping the DMA
-		 */
-		wmb();
-
-		q->rx_bd_v[i].sw_id_offset = (phys_addr_t)skb;
-		q->rx_bd_v[i].phys = dma_map_single(ndev->dev.parent,
-						    skb->data,
-						    lp->max_frm_size,
-						    DMA_FROM_DEVICE);
-		if (unlikely(dma_mapping_error(ndev->dev.parent, q->rx_bd_v[i].phys))) {
-			q->rx_bd_v[i].phys = 0;
-			dev_err(&ndev->dev, "axidma map error\n");
+		page = axienet_rx_page_alloc(q, &mapping);
+		if (!page) {
+			dev_err(&ndev->dev, "axidma rx buffer alloc error\n");
 			goto out;
 		}
-		q->rx_bd_v[i].cntrl = lp->max_frm_size;
+
+		q->rx_bd_v[i].sw_id_offset = (phys_addr_t)page;
+		q->rx_bd_v[i].phys = mapping;
+		q->rx_bd_v[i].cntrl = axienet_rx_buf_len(lp);
 	}
 
 	/* Start updating the Rx channel control register */
@@ -205,8 +392,13 @@ static int __dma_rxq_init(struct net_device *ndev,
 	cr = axienet_dma_in32(q, XAXIDMA_RX_CR_OFFSET);
 	axienet_dma_out32(q, XAXIDMA_RX_CR_OFFSET,
 			  cr | XAXIDMA_CR_RUNSTOP_MASK);
-	axienet_dma_bdout(q, XAXIDMA_RX_TDESC_OFFSET, q->rx_bd_p +
-			  (sizeof(*q->rx_bd_v) * (lp->rx_bd_num - 1)));
+	if (q->xsk_pool) {
+		q->rx_bd_fill = 0;
+		axienet_rx_zc_refill(q);
+	} else {
+		axienet_dma_bdout(q, XAXIDMA_RX_TDESC_OFFSET, q->rx_bd_p +
+				  (sizeof(*q->rx_bd_v) * (lp->rx_bd_num - 1)));
+	}
 
 	return 0;
 out:
@@ -265,8 +457,9 @@ static int map_dma_q_irq(int irq, struct axienet_local *lp)
  *
  * Return: IRQ_HANDLED if device generated a TX interrupt, IRQ_NONE otherwise.
  *
- * This is the Axi DMA Tx done Isr. It invokes "axienet_start_xmit_done"
- * to complete the BD processing.
+ * This is the Axi DMA Tx done Isr. It masks the Tx completion interrupts
+ * and schedules NAPI, where "axienet_start_xmit_done" completes the BD
+ * processing.
  */
 irqreturn_t __maybe_unused axienet_tx_irq(int irq, void *_ndev)
 {
@@ -285,7 +478,10 @@ irqreturn_t __maybe_unused axienet_tx_irq(int irq, void *_ndev)
 	status = axienet_dma_in32(q, XAXIDMA_TX_SR_OFFSET);
 	if (status & (XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_DELAY_MASK)) {
 		axienet_dma_out32(q, XAXIDMA_TX_SR_OFFSET, status);
-		axienet_start_xmit_done(lp->ndev, q);
+		cr = axienet_dma_in32(q, XAXIDMA_TX_CR_OFFSET);
+		cr &= ~(XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_DELAY_MASK);
+		axienet_dma_out32(q, XAXIDMA_TX_CR_OFFSET, cr);
+		napi_schedule(&lp->napi[i]);
 		goto out;
 	}
 
@@ -401,15 +597,10 @@ void __maybe_unused axienet_dma_err_handler(unsigned long data)
 	__axienet_device_reset(q);
 	axienet_unlock_mii(lp);
 
+	axienet_tx_bd_clean(ndev, q);
+
 	for (i = 0; i < lp->tx_bd_num; i++) {
 		cur_p = &q->tx_bd_v[i];
-		if (cur_p->phys)
-			dma_unmap_single(ndev->dev.parent, cur_p->phys,
-					 (cur_p->cntrl &
-					  XAXIDMA_BD_CTRL_LENGTH_MASK),
-					 DMA_TO_DEVICE);
-		if (cur_p->tx_skb)
-			dev_kfree_skb_irq((struct sk_buff *)cur_p->tx_skb);
 		cur_p->phys = 0;
 		cur_p->cntrl = 0;
 		cur_p->status = 0;
@@ -430,6 +621,11 @@ void __maybe_unused axienet_dma_err_handler(unsigned long data)
 		cur_p->app2 = 0;
 		cur_p->app3 = 0;
 		cur_p->app4 = 0;
+		/* AF_XDP buffers are handed out again from the fill ring */
+		if (q->xsk_pool) {
+			axienet_rx_buf_free(q, (void *)cur_p->sw_id_offset);
+			cur_p->sw_id_offset = 0;
+		}
 	}
 
 	q->tx_bd_ci = 0;
@@ -475,8 +671,13 @@ void __maybe_unused axienet_dma_err_handler(unsigned long data)
 	cr = axienet_dma_in32(q, XAXIDMA_RX_CR_OFFSET);
 	axienet_dma_out32(q, XAXIDMA_RX_CR_OFFSET,
 			  cr | XAXIDMA_CR_RUNSTOP_MASK);
-	axienet_dma_bdout(q, XAXIDMA_RX_TDESC_OFFSET, q->rx_bd_p +
-			  (sizeof(*q->rx_bd_v) * (lp->rx_bd_num - 1)));
+	if (q->xsk_pool) {
+		q->rx_bd_fill = 0;
+		axienet_rx_zc_refill(q);
+	} else {
+		axienet_dma_bdout(q, XAXIDMA_RX_TDESC_OFFSET, q->rx_bd_p +
+				  (sizeof(*q->rx_bd_v) * (lp->rx_bd_num - 1)));
+	}
 
 	/* Write to the RS (Run-stop) bit in the Tx channel control register.
 	 * Tx channel is now ready to run. But only after we write to the
@@ -43,8 +43,11 @@
 #include <linux/ptp_classify.h>
 #include <linux/net_tstamp.h>
 #include <linux/random.h>
+#include <linux/bpf_trace.h>
+#include <linux/filter.h>
 #include <net/sock.h>
 #include <linux/xilinx_phy.h>
+#include <asm/unaligned.h>
 #include <linux/clk.h>
 
 #include "xilinx_axienet.h"
@@ -54,6 +57,8 @@
 #define RX_BD_NUM_DEFAULT		128
 #define TX_BD_NUM_MIN			(MAX_SKB_FRAGS + 1)
 #define TX_BD_NUM_MAX			4096
+/* Keeps a worst case GSO frame within the default Tx BD ring */
+#define XAE_TSO_MAX_SEGS		24
 #define RX_BD_NUM_MAX			4096
 
 /* Must be shorter than length of ethtool_drvinfo.driver field to fit */
@@ -345,6 +350,44 @@ static int netdev_set_mac_address(struct net_device *ndev, void *p)
 	return 0;
 }
 
+static void axienet_set_cam_entry(struct axienet_local *lp, int i,
+				  const u8 *addr)
+{
+	u32 reg, af0reg = 0, af1reg = 0;
+
+	if (addr) {
+		af0reg = (addr[0]);
+		af0reg |= (addr[1] << 8);
+		af0reg |= (addr[2] << 16);
+		af0reg |= (addr[3] << 24);
+
+		af1reg = (addr[4]);
+		af1reg |= (addr[5] << 8);
+	}
+
+	reg = axienet_ior(lp, XAE_FMC_OFFSET) & 0xFFFFFF00;
+	reg |= i;
+
+	axienet_iow(lp, XAE_FMC_OFFSET, reg);
+	axienet_iow(lp, XAE_AF0_OFFSET, af0reg);
+	axienet_iow(lp, XAE_AF1_OFFSET, af1reg);
+}
+
+/* Only the IPv4 groups, 01:00:5e:00:00:00 to 01:00:5e:7f:ff:ff, go in the
+ * extended multicast table. Different groups can share an entry, the Rx
+ * path tells them apart.
+ */
+static bool axienet_mcast_table_addr(const u8 *addr)
+{
+	return addr[0] == 0x01 && addr[1] == 0x00 && addr[2] == 0x5e &&
+	       !(addr[3] & 0x80);
+}
+
+static u32 axienet_mcast_table_index(const u8 *addr)
+{
+	return ((addr[4] << 8) | addr[5]) & (XAE_MCAST_TABLE_ENTRIES - 1);
+}
+
 /**
  * axienet_set_multicast_list - Prepare the multicast table
  * @ndev:	Pointer to the net_device structure
@@ -355,68 +398,125 @@ static int netdev_set_mac_address(struct net_device *ndev, void *p)
  * goes into the net_device_ops structure entry ndo_set_multicast_list. This
  * means whenever the multicast table entries need to be updated this
  * function gets called.
+ *
+ * When the IP has the extended multicast table, the IPv4 groups go there
+ * and the four-entry table is left to the other groups. Groups that fit in
+ * neither make the MAC promiscuous. Whenever the MAC passes frames of other
+ * groups, the Rx path drops them against a software copy of the list before
+ * any skb is built for them.
  */
 void axienet_set_multicast_list(struct net_device *ndev)
 {
-	int i;
-	u32 reg, af0reg, af1reg;
 	struct axienet_local *lp = netdev_priv(ndev);
+	struct axienet_mc_filter *filter = NULL, *old;
+	bool promisc, ext_used = false;
+	struct netdev_hw_addr *ha;
+	unsigned int i, cam = 0;
+	u32 reg, idx;
 
 	if (lp->axienet_config->mactype != XAXIENET_1G || lp->eth_hasnobuf)
 		return;
 
-	if (ndev->flags & (IFF_ALLMULTI | IFF_PROMISC) ||
-	    netdev_mc_count(ndev) > XAE_MULTICAST_CAM_TABLE_NUM) {
-		/* We must make the kernel realize we had to move into
-		 * promiscuous mode. If it was a promiscuous mode request
-		 * the flag is already set. If not we set it.
-		 */
-		ndev->flags |= IFF_PROMISC;
-		reg = axienet_ior(lp, XAE_FMC_OFFSET);
-		reg |= XAE_FMC_PM_MASK;
-		axienet_iow(lp, XAE_FMC_OFFSET, reg);
-		dev_info(&ndev->dev, "Promiscuous mode enabled.\n");
-	} else if (!netdev_mc_empty(ndev)) {
-		struct netdev_hw_addr *ha;
+	promisc = ndev->flags & (IFF_ALLMULTI | IFF_PROMISC);
+
+	if (lp->mcast_table) {
+		for_each_set_bit(idx, lp->mcast_table, XAE_MCAST_TABLE_ENTRIES)
+			axienet_iow(lp, XAE_MCAST_TABLE_OFFSET + idx * 4, 0);
+		bitmap_zero(lp->mcast_table, XAE_MCAST_TABLE_ENTRIES);
+	}
 
-		i = 0;
+	if (!promisc) {
 		netdev_for_each_mc_addr(ha, ndev) {
-			if (i >= XAE_MULTICAST_CAM_TABLE_NUM)
-				break;
+			if (lp->mcast_table &&
+			    axienet_mcast_table_addr(ha->addr)) {
+				idx = axienet_mcast_table_index(ha->addr);
+				__set_bit(idx, lp->mcast_table);
+				axienet_iow(lp, XAE_MCAST_TABLE_OFFSET + idx * 4,
+					    XAE_MCAST_TABLE_PASS);
+				ext_used = true;
+			} else if (cam < XAE_MULTICAST_CAM_TABLE_NUM) {
+				axienet_set_cam_entry(lp, cam++, ha->addr);
+			} else {
+				promisc = true;
+			}
+		}
 
-			af0reg = (ha->addr[0]);
-			af0reg |= (ha->addr[1] << 8);
-			af0reg |= (ha->addr[2] << 16);
-			af0reg |= (ha->addr[3] << 24);
+		if (promisc || ext_used) {
+			filter = kzalloc(struct_size(filter, addrs,
+						     netdev_mc_count(ndev)),
+					 GFP_ATOMIC);
+			/* Better let unwanted frames through than lose some */
+			if (filter) {
+				netdev_for_each_mc_addr(ha, ndev) {
+					i = filter->count++;
+					ether_addr_copy(filter->addrs[i],
+							ha->addr);
+					__set_bit(ha->addr[5], filter->hash);
+				}
+				filter->promisc = promisc;
+			}
+		}
+	}
 
-			af1reg = (ha->addr[4]);
-			af1reg |= (ha->addr[5] << 8);
+	for (i = cam; i < XAE_MULTICAST_CAM_TABLE_NUM; i++)
+		axienet_set_cam_entry(lp, i, NULL);
 
-			reg = axienet_ior(lp, XAE_FMC_OFFSET) & 0xFFFFFF00;
-			reg |= i;
+	if (lp->mcast_table) {
+		reg = axienet_ior(lp, XAE_RAF_OFFSET);
+		if (ext_used)
+			reg |= XAE_RAF_NEWFNCENBL_MASK |
+			       XAE_RAF_EMULTIFLTRENBL_MASK;
+		else
+			reg &= ~XAE_RAF_EMULTIFLTRENBL_MASK;
+		axienet_iow(lp, XAE_RAF_OFFSET, reg);
+	}
 
-			axienet_iow(lp, XAE_FMC_OFFSET, reg);
-			axienet_iow(lp, XAE_AF0_OFFSET, af0reg);
-			axienet_iow(lp, XAE_AF1_OFFSET, af1reg);
-			i++;
-		}
-	} else {
-		reg = axienet_ior(lp, XAE_FMC_OFFSET);
+	reg = axienet_ior(lp, XAE_FMC_OFFSET);
+	if (promisc != !!(reg & XAE_FMC_PM_MASK))
+		dev_info(&ndev->dev, "Promiscuous mode %s.\n",
+			 promisc ? "enabled" : "disabled");
+	if (promisc)
+		reg |= XAE_FMC_PM_MASK;
+	else
 		reg &= ~XAE_FMC_PM_MASK;
+	axienet_iow(lp, XAE_FMC_OFFSET, reg);
+
+	old = rcu_replace_pointer(lp->mc_filter, filter, true);
+	if (old)
+		kfree_rcu(old, rcu);
+}
+
+/**
+ * axienet_rx_filtered - Check a received frame against the software filter
+ * @lp:		Pointer to axienet local structure
+ * @da:		Destination address of the frame
+ *
+ * Return: true if the MAC only passed the frame for lack of filter entries,
+ * and it must be dropped.
+ */
+static bool axienet_rx_filtered(struct axienet_local *lp, const u8 *da)
+{
+	struct axienet_mc_filter *filter = rcu_dereference(lp->mc_filter);
+	unsigned int i;
 
-		axienet_iow(lp, XAE_FMC_OFFSET, reg);
+	if (likely(!filter))
+		return false;
 
-		for (i = 0; i < XAE_MULTICAST_CAM_TABLE_NUM; i++) {
-			reg = axienet_ior(lp, XAE_FMC_OFFSET) & 0xFFFFFF00;
-			reg |= i;
+	if (!is_multicast_ether_addr(da))
+		return filter->promisc &&
+		       !ether_addr_equal(da, lp->ndev->dev_addr);
 
-			axienet_iow(lp, XAE_FMC_OFFSET, reg);
-			axienet_iow(lp, XAE_AF0_OFFSET, 0);
-			axienet_iow(lp, XAE_AF1_OFFSET, 0);
-		}
+	if (is_broadcast_ether_addr(da))
+		return false;
 
-		dev_info(&ndev->dev, "Promiscuous mode disabled.\n");
-	}
+	if (!test_bit(da[5], filter->hash))
+		return true;
+
+	for (i = 0; i < filter->count; i++)
+		if (ether_addr_equal(da, filter->addrs[i]))
+			return false;
+
+	return true;
 }
 
 /**
@@ -735,96 +835,257 @@ static int axienet_device_reset(struct net_device *ndev)
 }
 
 #ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+static inline bool axienet_is_10g_ts(struct axienet_local *lp)
+{
+	return lp->axienet_config->mactype == XAXIENET_10G_25G ||
+	       lp->axienet_config->mactype == XAXIENET_MRMAC;
+}
+
+/**
+ * axienet_txts_full - Check for room on the Tx timestamp ring of a queue
+ * @q:		Pointer to DMA queue structure, with its tx_lock held
+ *
+ * Return: true if no more two step skb can be queued on @q
+ */
+static inline bool axienet_txts_full(struct axienet_dma_q *q)
+{
+	/* Pairs with the release of ptp_txts_head by the worker */
+	return q->ptp_txts_tail - smp_load_acquire(&q->ptp_txts_head) >=
+	       AXIENET_TXTS_RING;
+}
+
+/**
+ * axienet_txts_queue - Queue a Tx skb to wait for its hardware timestamp
+ * @q:		Pointer to DMA queue structure, with its tx_lock held
+ * @skb:	skb being transmitted
+ * @tag:	Tag the timestamp of @skb is reported with
+ *
+ * A clone of @skb is kept on the ring, so that the transmitted skb is freed
+ * on Tx completion like any other and the timestamp worker only ever deals
+ * with the clones.
+ *
+ * Return: true if @skb was queued, false if the ring is full or no clone
+ *	   could be allocated
+ */
+static bool axienet_txts_queue(struct axienet_dma_q *q, struct sk_buff *skb,
+			       u32 tag)
+{
+	u32 tail = q->ptp_txts_tail;
+	struct axienet_txts *ts = &q->ptp_txts[tail % AXIENET_TXTS_RING];
+	struct sk_buff *clone;
+
+	if (axienet_txts_full(q))
+		return false;
+
+	clone = skb_clone_sk(skb);
+	if (!clone)
+		return false;
+
+	skb_shinfo(skb)->tx_flags |= SKBTX_IN_PROGRESS;
+	ts->skb = clone;
+	ts->tag = tag & (XAXIFIFO_TXTS_TAG_MASK >> XAXIFIFO_TXTS_TAG_SHIFT);
+	ts->expires = jiffies + AXIENET_TXTS_TIMEOUT;
+	/* Publish the entry to the worker */
+	smp_store_release(&q->ptp_txts_tail, tail + 1);
+
+	return true;
+}
+
 /**
- * axienet_tx_hwtstamp - Read tx timestamp from hw and update it to the skbuff
+ * axienet_txts_complete - Hand a Tx timestamp to the skb it belongs to
  * @lp:		Pointer to axienet local structure
- * @cur_p:	Pointer to the axi_dma/axi_mcdma current bd
+ * @tag:	Tag read from the Tx timestamp FIFO
+ * @ns:		Timestamp in nanoseconds
  *
- * Return:	None.
+ * The FIFO returns the timestamps of a queue in transmit order, so the
+ * entries ahead of the matching one lost their timestamp and are dropped.
+ *
+ * Return: true if a waiting skb matched @tag
  */
-#ifdef CONFIG_AXIENET_HAS_MCDMA
-void axienet_tx_hwtstamp(struct axienet_local *lp,
-			 struct aximcdma_bd *cur_p)
-#else
-void axienet_tx_hwtstamp(struct axienet_local *lp,
-			 struct axidma_bd *cur_p)
-#endif
+static bool axienet_txts_complete(struct axienet_local *lp, u32 tag, u64 ns)
 {
-	u32 sec = 0, nsec = 0, val;
-	u64 time64;
-	int err = 0;
-	u32 count, len = lp->axienet_config->tx_ptplen;
-	struct skb_shared_hwtstamps *shhwtstamps =
-		skb_hwtstamps((struct sk_buff *)cur_p->ptp_tx_skb);
+	struct skb_shared_hwtstamps hwts = { .hwtstamp = ns_to_ktime(ns) };
+	struct axienet_dma_q *q;
+	struct axienet_txts *ts;
+	u32 head, tail, i;
+	int j;
+
+	for_each_tx_dma_queue(lp, j) {
+		q = lp->dq[j];
+		head = q->ptp_txts_head;
+		tail = smp_load_acquire(&q->ptp_txts_tail);
+		for (i = head; i != tail; i++)
+			if (q->ptp_txts[i % AXIENET_TXTS_RING].tag == tag)
+				break;
+		if (i == tail)
+			continue;
+
+		for (; head != i; head++) {
+			ts = &q->ptp_txts[head % AXIENET_TXTS_RING];
+			netdev_dbg(lp->ndev, "Tx timestamp of tag %x lost\n",
+				   ts->tag);
+			dev_kfree_skb_any(ts->skb);
+			ts->skb = NULL;
+		}
+
+		ts = &q->ptp_txts[i % AXIENET_TXTS_RING];
+		if (!axienet_is_10g_ts(lp))
+			skb_pull(ts->skb, AXIENET_TS_HEADER_LEN);
+		skb_complete_tx_timestamp(ts->skb, &hwts);
+		ts->skb = NULL;
+		/* Hand the slots back to axienet_txts_queue() */
+		smp_store_release(&q->ptp_txts_head, i + 1);
+		return true;
+	}
 
-	val = axienet_txts_ior(lp, XAXIFIFO_TXTS_ISR);
-	if (unlikely(!(val & XAXIFIFO_TXTS_INT_RC_MASK)))
-		dev_info(lp->dev, "Did't get FIFO tx interrupt %d\n", val);
+	return false;
+}
+
+/**
+ * axienet_txts_drain - Read all the timestamps held by the Tx timestamp FIFO
+ * @lp:		Pointer to axienet local structure
+ *
+ * All the timestamps completed since the last run are read in one go,
+ * instead of one busy wait per Tx BD from the Tx completion path.
+ */
+static void axienet_txts_drain(struct axienet_local *lp)
+{
+	u32 len = lp->axienet_config->tx_ptplen;
+	u32 sec, nsec, val;
+	int err;
+	u64 ns;
 
 	/* Ensure to read Occupany register before accessing Length register */
-	if (!axienet_txts_ior(lp, XAXIFIFO_TXTS_RFO)) {
-		netdev_err(lp->ndev, "%s: TX Timestamp FIFO is empty", __func__);
-		goto skb_exit;
+	while (axienet_txts_ior(lp, XAXIFIFO_TXTS_RFO)) {
+		/* If FIFO is configured in cut through Mode we will get Rx
+		 * complete interrupt even one byte is there in the fifo wait
+		 * for the full packet
+		 */
+		err = readl_poll_timeout(lp->tx_ts_regs + XAXIFIFO_TXTS_RLR,
+					 val,
+					 (val & XAXIFIFO_TXTS_RXFD_MASK) >= len,
+					 1, AXIENET_TXTS_WAIT_US);
+		if (err) {
+			netdev_err(lp->ndev, "%s: Didn't get the full timestamp packet",
+				   __func__);
+			return;
+		}
+
+		nsec = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
+		sec  = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
+		val = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
+		val = (val & XAXIFIFO_TXTS_TAG_MASK) >> XAXIFIFO_TXTS_TAG_SHIFT;
+		if (!axienet_is_10g_ts(lp))
+			axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
+
+		dev_dbg(lp->dev, "tx_stamp:%04x %u %9u\n", val, sec, nsec);
+		ns = (u64)sec * NS_PER_SEC + nsec;
+		if (!axienet_txts_complete(lp, val, ns))
+			dev_dbg(lp->dev, "No Tx skb waits for tag %x\n", val);
 	}
+}
 
-	/* If FIFO is configured in cut through Mode we will get Rx complete
-	 * interrupt even one byte is there in the fifo wait for the full packet
-	 */
-	err = readl_poll_timeout_atomic(lp->tx_ts_regs + XAXIFIFO_TXTS_RLR, val,
-					((val & XAXIFIFO_TXTS_RXFD_MASK) >=
-					len), 0, 1000000);
-	if (err) {
-		netdev_err(lp->ndev, "%s: Didn't get the full timestamp packet",
-			   __func__);
-		goto skb_exit;
-	}
-
-	nsec = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
-	sec  = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
-	val = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
-	val = ((val & XAXIFIFO_TXTS_TAG_MASK) >> XAXIFIFO_TXTS_TAG_SHIFT);
-	dev_dbg(lp->dev, "tx_stamp:[%04x] %04x %u %9u\n",
-		cur_p->ptp_tx_ts_tag, val, sec, nsec);
-
-	if (val != cur_p->ptp_tx_ts_tag) {
-		count = axienet_txts_ior(lp, XAXIFIFO_TXTS_RFO);
-		while (count) {
-			nsec = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
-			sec  = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
-			val = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
-			val = ((val & XAXIFIFO_TXTS_TAG_MASK) >>
-				XAXIFIFO_TXTS_TAG_SHIFT);
-
-			dev_dbg(lp->dev, "tx_stamp:[%04x] %04x %u %9u\n",
-				cur_p->ptp_tx_ts_tag, val, sec, nsec);
-			if (val == cur_p->ptp_tx_ts_tag)
+/**
+ * axienet_txts_expire - Drop the Tx skbs whose timestamp did not come in time
+ * @lp:		Pointer to axienet local structure
+ *
+ * Return: true if skbs are still waiting for their timestamp
+ */
+static bool axienet_txts_expire(struct axienet_local *lp)
+{
+	struct axienet_dma_q *q;
+	struct axienet_txts *ts;
+	bool pending = false;
+	u32 head, tail;
+	int i;
+
+	for_each_tx_dma_queue(lp, i) {
+		q = lp->dq[i];
+		head = q->ptp_txts_head;
+		tail = smp_load_acquire(&q->ptp_txts_tail);
+		for (; head != tail; head++) {
+			ts = &q->ptp_txts[head % AXIENET_TXTS_RING];
+			if (time_before(jiffies, ts->expires))
 				break;
-			count = axienet_txts_ior(lp, XAXIFIFO_TXTS_RFO);
-		}
-		if (val != cur_p->ptp_tx_ts_tag) {
-			dev_info(lp->dev, "Mismatching 2-step tag. Got %x",
-				 val);
-			dev_info(lp->dev, "Expected %x\n",
-				 cur_p->ptp_tx_ts_tag);
+			netdev_dbg(lp->ndev, "Tx timestamp of tag %x timed out\n",
+				   ts->tag);
+			dev_kfree_skb_any(ts->skb);
+			ts->skb = NULL;
 		}
+		smp_store_release(&q->ptp_txts_head, head);
+		if (head != tail)
+			pending = true;
 	}
 
-	if (lp->axienet_config->mactype != XAXIENET_10G_25G &&
-	    lp->axienet_config->mactype != XAXIENET_MRMAC)
-		val = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
+	return pending;
+}
 
-skb_exit:
-	time64 = sec * NS_PER_SEC + nsec;
-	memset(shhwtstamps, 0, sizeof(struct skb_shared_hwtstamps));
-	shhwtstamps->hwtstamp = ns_to_ktime(time64);
-	if (lp->axienet_config->mactype != XAXIENET_10G_25G &&
-	    lp->axienet_config->mactype != XAXIENET_MRMAC)
-		skb_pull((struct sk_buff *)cur_p->ptp_tx_skb,
-			 AXIENET_TS_HEADER_LEN);
+/**
+ * axienet_txts_work - Deliver the Tx timestamps read from the FIFO
+ * @work:	Pointer to the ptp_txts_work of the axienet local structure
+ *
+ * Kicked from the Tx completion path, the work then polls every jiffy
+ * while skbs wait for their timestamp.
+ */
+static void axienet_txts_work(struct kthread_work *work)
+{
+	struct axienet_local *lp = container_of(work, struct axienet_local,
+						ptp_txts_work.work);
+
+	axienet_txts_drain(lp);
+	if (axienet_txts_expire(lp))
+		kthread_queue_delayed_work(lp->ptp_txts_worker,
+					   &lp->ptp_txts_work, 1);
+}
+
+/**
+ * axienet_txts_start - Start the Tx timestamp worker
+ * @lp:		Pointer to axienet local structure
+ *
+ * Return: 0 on success, negative errno otherwise
+ */
+static int axienet_txts_start(struct axienet_local *lp)
+{
+	struct kthread_worker *worker;
+
+	worker = kthread_create_worker(0, "%s-txts", lp->ndev->name);
+	if (IS_ERR(worker))
+		return PTR_ERR(worker);
+
+	kthread_init_delayed_work(&lp->ptp_txts_work, axienet_txts_work);
+	lp->ptp_txts_worker = worker;
+
+	return 0;
+}
+
+/**
+ * axienet_txts_stop - Stop the Tx timestamp worker
+ * @lp:		Pointer to axienet local structure
+ *
+ * Called once the Tx channels are stopped. The skbs still waiting for their
+ * timestamp are dropped.
+ */
+static void axienet_txts_stop(struct axienet_local *lp)
+{
+	struct axienet_txts *ts;
+	struct axienet_dma_q *q;
+	u32 head;
+	int i;
+
+	kthread_cancel_delayed_work_sync(&lp->ptp_txts_work);
+	kthread_destroy_worker(lp->ptp_txts_worker);
+	lp->ptp_txts_worker = NULL;
 
-	skb_tstamp_tx((struct sk_buff *)cur_p->ptp_tx_skb, shhwtstamps);
-	dev_kfree_skb_any((struct sk_buff *)cur_p->ptp_tx_skb);
-	cur_p->ptp_tx_skb = 0;
+	for_each_tx_dma_queue(lp, i) {
+		q = lp->dq[i];
+		for (head = q->ptp_txts_head; head != q->ptp_txts_tail; head++) {
+			ts = &q->ptp_txts[head % AXIENET_TXTS_RING];
+			dev_kfree_skb_any(ts->skb);
+			ts->skb = NULL;
+		}
+		q->ptp_txts_head = 0;
+		q->ptp_txts_tail = 0;
+	}
 }
 
 static inline bool is_ptp_os_pdelay_req(struct sk_buff *skb,
@@ -840,7 +1101,8 @@ static inline bool is_ptp_os_pdelay_req(struct sk_buff *skb,
 /**
  * axienet_rx_hwtstamp - Read rx timestamp from hw and update it to the skbuff
  * @lp:		Pointer to axienet local structure
- * @skb:	Pointer to the sk_buff structure
+ * @skb:	Pointer to the sk_buff structure, NULL to just discard the
+ *		timestamp of a frame that never became an skb
  *
  * Return:	None.
  */
@@ -850,7 +1112,7 @@ static void axienet_rx_hwtstamp(struct axienet_local *lp,
 	u32 sec = 0, nsec = 0, val;
 	u64 time64;
 	int err = 0;
-	struct skb_shared_hwtstamps *shhwtstamps = skb_hwtstamps(skb);
+	struct skb_shared_hwtstamps *shhwtstamps;
 
 	val = axienet_rxts_ior(lp, XAXIFIFO_TXTS_ISR);
 	if (unlikely(!(val & XAXIFIFO_TXTS_INT_RC_MASK))) {
@@ -878,6 +1140,9 @@ static void axienet_rx_hwtstamp(struct axienet_local *lp,
 	sec  = axienet_rxts_ior(lp, XAXIFIFO_TXTS_RXFD);
 	val = axienet_rxts_ior(lp, XAXIFIFO_TXTS_RXFD);
 
+	if (!skb)
+		return;
+
 	if (is_ptp_os_pdelay_req(skb, lp)) {
 		/* Need to save PDelay resp RX time for HW 1 step
 		 * timestamping on PDelay Response.
@@ -889,10 +1154,103 @@ static void axienet_rx_hwtstamp(struct axienet_local *lp,
 
 	if (lp->tstamp_config.rx_filter == HWTSTAMP_FILTER_ALL) {
 		time64 = sec * NS_PER_SEC + nsec;
+		shhwtstamps = skb_hwtstamps(skb);
 		shhwtstamps->hwtstamp = ns_to_ktime(time64);
 	}
 }
+
+/**
+ * axienet_rx_inband_ts - Check whether Rx frames carry an in-band timestamp
+ * @lp:		Pointer to axienet local structure
+ *
+ * Return: true if the MAC prepends an 8 byte timestamp to every Rx frame.
+ */
+static inline bool axienet_rx_inband_ts(struct axienet_local *lp)
+{
+	return (lp->tstamp_config.rx_filter == HWTSTAMP_FILTER_ALL ||
+		lp->eth_hasptp) &&
+	       lp->axienet_config->mactype != XAXIENET_10G_25G &&
+	       lp->axienet_config->mactype != XAXIENET_MRMAC;
+}
+
+/**
+ * axienet_rx_inband_tstamp - Decode the in-band timestamp of a Rx frame
+ * @lp:		Pointer to axienet local structure
+ * @buf:	Start of the received frame
+ *
+ * Return: The timestamp in nanoseconds.
+ */
+static u64 axienet_rx_inband_tstamp(struct axienet_local *lp, const u8 *buf)
+{
+	u32 sec, nsec;
+
+	if (lp->axienet_config->mactype == XAXIENET_1G ||
+	    lp->axienet_config->mactype == XAXIENET_2_5G) {
+		/* The first 8 bytes will be the timestamp */
+		memcpy(&sec, &buf[0], 4);
+		memcpy(&nsec, &buf[4], 4);
+
+		sec = cpu_to_be32(sec);
+		nsec = cpu_to_be32(nsec);
+	} else {
+		/* The first 8 bytes will be the timestamp */
+		memcpy(&nsec, &buf[0], 4);
+		memcpy(&sec, &buf[4], 4);
+	}
+
+	return sec * NS_PER_SEC + nsec;
+}
+#endif
+
+/**
+ * axienet_tx_bd_release_buf - Unmap and free the buffer attached to a Tx BD
+ * @ndev:	Pointer to the net_device structure
+ * @cur_p:	Pointer to the axi_dma/axi_mcdma Tx bd
+ *
+ * The BD may carry either an skb or an xdp_frame. XDP frames can only be
+ * returned from softirq context, so this must not be called from hard IRQ.
+ */
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+static void axienet_tx_bd_release_buf(struct net_device *ndev,
+				      struct aximcdma_bd *cur_p)
+#else
+static void axienet_tx_bd_release_buf(struct net_device *ndev,
+				      struct axidma_bd *cur_p)
 #endif
+{
+	u32 len = cur_p->cntrl & XAXIDMA_BD_CTRL_LENGTH_MASK;
+
+	switch (cur_p->tx_desc_mapping) {
+	case DESC_DMA_MAP_PAGE:
+		dma_unmap_page(ndev->dev.parent, cur_p->phys, len,
+			       DMA_TO_DEVICE);
+		break;
+	case DESC_DMA_MAP_XDP:
+		/* Owned by a page pool or copied into the bounce area */
+		break;
+	case DESC_DMA_MAP_XSK:
+		/* Mapped by the AF_XDP pool, or copied into the bounce area */
+		break;
+	case DESC_DMA_MAP_BOUNCE:
+	case DESC_DMA_MAP_TSO_HDR:
+		/* Driver owned coherent buffers */
+		break;
+	default:
+		dma_unmap_single(ndev->dev.parent, cur_p->phys, len,
+				 DMA_TO_DEVICE);
+		break;
+	}
+
+	if (cur_p->tx_skb) {
+		if (cur_p->tx_desc_mapping == DESC_DMA_MAP_XDP ||
+		    cur_p->tx_desc_mapping == DESC_DMA_MAP_XDP_SINGLE)
+			xdp_return_frame((struct xdp_frame *)cur_p->tx_skb);
+		else
+			dev_consume_skb_any((struct sk_buff *)cur_p->tx_skb);
+	}
+	cur_p->tx_skb = 0;
+	cur_p->tx_desc_mapping = DESC_DMA_MAP_SINGLE;
+}
 
 /**
  * axienet_start_xmit_done - Invoked once a transmit is completed by the
@@ -900,16 +1258,21 @@ static void axienet_rx_hwtstamp(struct axienet_local *lp,
  * @ndev:	Pointer to the net_device structure
  * @q:		Pointer to DMA queue structure
  *
- * This function is invoked from the Axi DMA Tx isr to notify the completion
- * of transmit operation. It clears fields in the corresponding Tx BDs and
- * unmaps the corresponding buffer so that CPU can regain ownership of the
- * buffer. It finally invokes "netif_wake_queue" to restart transmission if
- * required.
+ * This function is invoked from the NAPI poll of the queue, scheduled by the
+ * Axi DMA Tx isr, to notify the completion of transmit operation. It clears
+ * fields in the corresponding Tx BDs and unmaps the corresponding buffer so
+ * that CPU can regain ownership of the buffer. It finally invokes
+ * "netif_wake_queue" to restart transmission if required. The skbs are
+ * reported to BQL, XDP and AF_XDP frames sharing the ring are not.
  */
 void axienet_start_xmit_done(struct net_device *ndev,
 			     struct axienet_dma_q *q)
 {
+	struct netdev_queue *txq = netdev_get_tx_queue(ndev, q->qidx);
 	struct axienet_local *lp = netdev_priv(ndev);
+	unsigned int bql_bytes = 0;
+	unsigned int bql_pkts = 0;
+	u32 xsk_frames = 0;
 	u32 packets = 0;
 	u32 size = 0;
 
@@ -928,29 +1291,21 @@ void axienet_start_xmit_done(struct net_device *ndev,
 	status = cur_p->status;
 #endif
 	while (status & XAXIDMA_BD_STS_COMPLETE_MASK) {
-#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
-		if (cur_p->ptp_tx_skb)
-			axienet_tx_hwtstamp(lp, cur_p);
-#endif
-		if (cur_p->tx_desc_mapping == DESC_DMA_MAP_PAGE)
-			dma_unmap_page(ndev->dev.parent, cur_p->phys,
-				       cur_p->cntrl &
-				       XAXIDMA_BD_CTRL_LENGTH_MASK,
-				       DMA_TO_DEVICE);
-		else
-			dma_unmap_single(ndev->dev.parent, cur_p->phys,
-					 cur_p->cntrl &
-					 XAXIDMA_BD_CTRL_LENGTH_MASK,
-					 DMA_TO_DEVICE);
-		if (cur_p->tx_skb)
-			dev_kfree_skb_irq((struct sk_buff *)cur_p->tx_skb);
+		if (cur_p->tx_desc_mapping == DESC_DMA_MAP_XSK) {
+			xsk_frames++;
+		} else if (cur_p->tx_skb &&
+			   cur_p->tx_desc_mapping != DESC_DMA_MAP_XDP &&
+			   cur_p->tx_desc_mapping != DESC_DMA_MAP_XDP_SINGLE) {
+			bql_bytes += ((struct sk_buff *)cur_p->tx_skb)->len;
+			bql_pkts++;
+		}
+		axienet_tx_bd_release_buf(ndev, cur_p);
 		/*cur_p->phys = 0;*/
 		cur_p->app0 = 0;
 		cur_p->app1 = 0;
 		cur_p->app2 = 0;
 		cur_p->app4 = 0;
 		cur_p->status = 0;
-		cur_p->tx_skb = 0;
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 		cur_p->sband_stats = 0;
 #endif
@@ -969,20 +1324,74 @@ void axienet_start_xmit_done(struct net_device *ndev,
 #endif
 	}
 
-	ndev->stats.tx_packets += packets;
-	ndev->stats.tx_bytes += size;
-	q->tx_packets += packets;
-	q->tx_bytes += size;
+	u64_stats_update_begin(&q->tx_stats.syncp);
+	q->tx_stats.packets += packets;
+	q->tx_stats.bytes += size;
+	u64_stats_update_end(&q->tx_stats.syncp);
+
+	if (xsk_frames)
+		xsk_tx_completed(q->xsk_pool, xsk_frames);
+
+	/* Called on every NAPI poll, nothing to wake if no BD completed */
+	if (!packets)
+		return;
+
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+	/* Timestamps of the completed skbs are read by the worker */
+	if (READ_ONCE(q->ptp_txts_tail) != READ_ONCE(q->ptp_txts_head))
+		kthread_mod_delayed_work(lp->ptp_txts_worker,
+					 &lp->ptp_txts_work, 0);
+#endif
+
+	netdev_tx_completed_queue(txq, bql_pkts, bql_bytes);
 
-	/* Matches barrier in axienet_start_xmit */
+	/* Matches barrier in axienet_queue_xmit */
 	smp_mb();
 
-	/* Fixme: With the existing multiqueue implementation
-	 * in the driver it is difficult to get the exact queue info.
-	 * We should wake only the particular queue
-	 * instead of waking all ndev queues.
-	 */
-	netif_tx_wake_all_queues(ndev);
+	/* Netdev Tx queue i is always carried by the Tx channel of dq[i] */
+	if (netif_tx_queue_stopped(txq))
+		netif_tx_wake_queue(txq);
+}
+
+/**
+ * axienet_tx_bd_clean - Release the buffers of Tx BDs that never completed
+ * @ndev:	Pointer to the net_device structure
+ * @q:		Pointer to DMA queue structure
+ *
+ * This is called once the DMA engine has been stopped, so that neither skbs
+ * nor XDP frames still queued on the Tx BD ring are leaked when the rings
+ * are released or reset. AF_XDP descriptors are reported as completed and
+ * the BQL state of the queue is reset.
+ */
+void axienet_tx_bd_clean(struct net_device *ndev, struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	u32 xsk_frames = 0;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	struct aximcdma_bd *cur_p;
+#else
+	struct axidma_bd *cur_p;
+#endif
+
+	while (q->tx_bd_ci != q->tx_bd_tail) {
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur_p = &q->txq_bd_v[q->tx_bd_ci];
+#else
+		cur_p = &q->tx_bd_v[q->tx_bd_ci];
+#endif
+		if (cur_p->tx_desc_mapping == DESC_DMA_MAP_XSK)
+			xsk_frames++;
+		axienet_tx_bd_release_buf(ndev, cur_p);
+
+		if (++q->tx_bd_ci >= lp->tx_bd_num)
+			q->tx_bd_ci = 0;
+	}
+
+	if (xsk_frames)
+		xsk_tx_completed(q->xsk_pool, xsk_frames);
+
+	q->tx_kick_pending = false;
+	netdev_tx_reset_queue(netdev_get_tx_queue(ndev, q->qidx));
 }
 
 /**
@@ -1024,34 +1433,106 @@ static inline int axienet_check_tx_bd_space(struct axienet_dma_q *q,
 	return 0;
 }
 
-#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+/* Bump a Tx submission counter of @q, whose tx_lock must be held */
+#define axienet_xmit_stats_inc(q, field)			\
+	do {							\
+		u64_stats_update_begin(&(q)->xmit_stats.syncp);	\
+		(q)->xmit_stats.field++;			\
+		u64_stats_update_end(&(q)->xmit_stats.syncp);	\
+	} while (0)
+
 /**
- * axienet_create_tsheader - Create timestamp header for tx
- * @q:		Pointer to DMA queue structure
- * @buf:	Pointer to the buf to copy timestamp header
- * @msg_type:	PTP message type
+ * axienet_tx_kick - Hand the queued Tx BDs over to the DMA engine
+ * @q:		Pointer to DMA queue structure, q->tx_lock must be held
  *
- * Return: 0, on success
- *	    NETDEV_TX_BUSY, if timestamp FIFO has no vacancy
+ * Moves the tail descriptor to the BD before q->tx_bd_tail, which starts the
+ * transfer of all BDs queued since the previous kick.
  */
-static int axienet_create_tsheader(u8 *buf, u8 msg_type,
-				   struct axienet_dma_q *q)
+static void axienet_tx_kick(struct axienet_dma_q *q)
 {
-	struct axienet_local *lp = q->lp;
+	u32 tail = q->tx_bd_tail ? q->tx_bd_tail - 1 : q->lp->tx_bd_num - 1;
+	dma_addr_t tail_p;
+
 #ifdef CONFIG_AXIENET_HAS_MCDMA
-	struct aximcdma_bd *cur_p;
+	tail_p = q->tx_bd_p + sizeof(*q->txq_bd_v) * tail;
 #else
-	struct axidma_bd *cur_p;
+	tail_p = q->tx_bd_p + sizeof(*q->tx_bd_v) * tail;
 #endif
-	u64 val;
-	u32 tmp[MRMAC_TS_HEADER_WORDS];
-	int i;
-	unsigned long flags;
+	/* Ensure BD write before starting transfer */
+	wmb();
 
+	/* Start the transfer */
 #ifdef CONFIG_AXIENET_HAS_MCDMA
-	cur_p = &q->txq_bd_v[q->tx_bd_tail];
+	axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id),
+			  tail_p);
 #else
-	cur_p = &q->tx_bd_v[q->tx_bd_tail];
+	axienet_dma_bdout(q, XAXIDMA_TX_TDESC_OFFSET, tail_p);
+#endif
+	q->tx_kick_pending = false;
+}
+
+/**
+ * axienet_tx_flush - Start the BDs held back by xmit_more, if any
+ * @q:		Pointer to DMA queue structure, q->tx_lock must be held
+ *
+ * Must be called whenever a frame is not queued, since the stack will not
+ * follow up with another one to close the batch.
+ */
+static inline void axienet_tx_flush(struct axienet_dma_q *q)
+{
+	if (q->tx_kick_pending)
+		axienet_tx_kick(q);
+}
+
+/**
+ * axienet_tx_sent - Account a queued skb to BQL and start the DMA
+ * @txq:	Netdev Tx queue @skb was queued on
+ * @q:		Pointer to DMA queue structure, q->tx_lock must be held
+ * @skb:	The skb whose BDs were just queued
+ *
+ * The DMA is only kicked once the stack stops batching frames, or when BQL
+ * stops the queue.
+ */
+static void axienet_tx_sent(struct netdev_queue *txq, struct axienet_dma_q *q,
+			    struct sk_buff *skb)
+{
+	if (__netdev_tx_sent_queue(txq, skb->len, netdev_xmit_more()))
+		axienet_tx_kick(q);
+	else
+		q->tx_kick_pending = true;
+}
+
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+/**
+ * axienet_create_tsheader - Create timestamp header for tx
+ * @q:		Pointer to DMA queue structure
+ * @buf:	Pointer to the buf to copy timestamp header
+ * @msg_type:	PTP message type
+ *
+ * For 1G/2.5G MACs @buf is the header pushed in front of the frame. For
+ * 10G/25G and MRMAC it is a zeroed, word aligned buffer of ts_header_len
+ * bytes that is written to the Tx command FIFO as is.
+ *
+ * Return: 0, on success
+ *	    NETDEV_TX_BUSY, if timestamp FIFO has no vacancy
+ */
+static int axienet_create_tsheader(u8 *buf, u8 msg_type,
+				   struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = q->lp;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	struct aximcdma_bd *cur_p;
+#else
+	struct axidma_bd *cur_p;
+#endif
+	const u32 *words = (const u32 *)buf;
+	unsigned long flags;
+	int i;
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	cur_p = &q->txq_bd_v[q->tx_bd_tail];
+#else
+	cur_p = &q->tx_bd_v[q->tx_bd_tail];
 #endif
 
 	if ((msg_type & 0xF) == TX_TS_OP_NOOP) {
@@ -1092,12 +1573,8 @@ static int axienet_create_tsheader(u8 *buf, u8 msg_type,
 
 	if (lp->axienet_config->mactype == XAXIENET_1G ||
 	    lp->axienet_config->mactype == XAXIENET_2_5G) {
-		memcpy(&val, buf, AXIENET_TS_HEADER_LEN);
-		swab64s(&val);
-		memcpy(buf, &val, AXIENET_TS_HEADER_LEN);
-	} else if (lp->axienet_config->mactype == XAXIENET_10G_25G ||
-		   lp->axienet_config->mactype == XAXIENET_MRMAC) {
-		memcpy(&tmp[0], buf, lp->axienet_config->ts_header_len);
+		put_unaligned(swab64(get_unaligned((u64 *)buf)), (u64 *)buf);
+	} else if (axienet_is_10g_ts(lp)) {
 		/* Check for Transmit Data FIFO Vacancy */
 		spin_lock_irqsave(&lp->ptp_tx_lock, flags);
 		if (!axienet_txts_ior(lp, XAXIFIFO_TXTS_TDFV)) {
@@ -1105,7 +1582,7 @@ static int axienet_create_tsheader(u8 *buf, u8 msg_type,
 			return NETDEV_TX_BUSY;
 		}
 		for (i = 0; i < lp->axienet_config->ts_header_len / 4; i++)
-			axienet_txts_iow(lp, XAXIFIFO_TXTS_TXFD, tmp[i]);
+			axienet_txts_iow(lp, XAXIFIFO_TXTS_TXFD, words[i]);
 
 		axienet_txts_iow(lp, XAXIFIFO_TXTS_TLR, lp->axienet_config->ts_header_len);
 		spin_unlock_irqrestore(&lp->ptp_tx_lock, flags);
@@ -1141,6 +1618,7 @@ static int axienet_skb_tstsmp(struct sk_buff **__skb, struct axienet_dma_q *q,
 	struct axidma_bd *cur_p;
 #endif
 	struct axienet_local *lp = netdev_priv(ndev);
+	u32 tsheader[MRMAC_TS_HEADER_WORDS] = { };
 	struct sk_buff *old_skb = *__skb;
 	struct sk_buff *skb = *__skb;
 
@@ -1182,86 +1660,344 @@ static int axienet_skb_tstsmp(struct sk_buff **__skb, struct axienet_dma_q *q,
 		memset(tmp, 0, AXIENET_TS_HEADER_LEN);
 		cur_p->ptp_tx_ts_tag++;
 
+		/* Without room to wait for the timestamp, the frame goes out
+		 * with a NOOP header
+		 */
 		if (skb_shinfo(skb)->tx_flags & SKBTX_HW_TSTAMP) {
 			if (lp->tstamp_config.tx_type ==
-				HWTSTAMP_TX_ONESTEP_SYNC) {
-				axienet_create_tsheader(tmp,
-							TX_TS_OP_ONESTEP
-							, q);
-			} else {
-				axienet_create_tsheader(tmp,
-							TX_TS_OP_TWOSTEP, q);
-				skb_shinfo(skb)->tx_flags |=
-						SKBTX_IN_PROGRESS;
-				cur_p->ptp_tx_skb =
-					(unsigned long)skb_get(skb);
-			}
+				HWTSTAMP_TX_ONESTEP_SYNC)
+				axienet_create_tsheader(tmp, TX_TS_OP_ONESTEP,
+							q);
+			else if (axienet_txts_queue(q, skb,
+						    cur_p->ptp_tx_ts_tag))
+				axienet_create_tsheader(tmp, TX_TS_OP_TWOSTEP,
+							q);
 		}
 	} else if ((skb_shinfo(skb)->tx_flags & SKBTX_HW_TSTAMP) &&
-		   (lp->axienet_config->mactype == XAXIENET_10G_25G ||
-		   lp->axienet_config->mactype == XAXIENET_MRMAC)) {
+		   axienet_is_10g_ts(lp)) {
+		u8 packet_flags = TX_TS_OP_TWOSTEP;
+
 		cur_p->ptp_tx_ts_tag = prandom_u32_max(XAXIFIFO_TXTS_TAG_MAX) + 1;
-			dev_dbg(lp->dev, "tx_tag:[%04x]\n",
-				cur_p->ptp_tx_ts_tag);
-			if (lp->tstamp_config.tx_type == HWTSTAMP_TX_ONESTEP_SYNC ||
-			    lp->tstamp_config.tx_type == HWTSTAMP_TX_ONESTEP_P2P) {
-				u8 packet_flags = ptp_os(skb, lp);
-
-				/* Pass one step flag with packet type (sync/pdelay resp)
-				 * to command FIFO helper only when one step TS is required.
-				 * Pass the default two step flag for other PTP events.
-				 */
-				if (!packet_flags)
-					packet_flags = TX_TS_OP_TWOSTEP;
-				else
-					packet_flags |= TX_TS_OP_ONESTEP;
-
-				if (axienet_create_tsheader(lp->tx_ptpheader,
-							    packet_flags,
-							    q))
-					return NETDEV_TX_BUSY;
-
-				/* skb TS passing is required for non one step TS packets */
-				if (packet_flags == TX_TS_OP_TWOSTEP) {
-					skb_shinfo(skb)->tx_flags |= SKBTX_IN_PROGRESS;
-					cur_p->ptp_tx_skb = (phys_addr_t)skb_get(skb);
-				}
-			} else {
-				if (axienet_create_tsheader(lp->tx_ptpheader,
-							    TX_TS_OP_TWOSTEP,
-							    q))
-					return NETDEV_TX_BUSY;
-				skb_shinfo(skb)->tx_flags |= SKBTX_IN_PROGRESS;
-				cur_p->ptp_tx_skb = (phys_addr_t)skb_get(skb);
-			}
-	} else if (lp->axienet_config->mactype == XAXIENET_10G_25G ||
-		   lp->axienet_config->mactype == XAXIENET_MRMAC) {
+		dev_dbg(lp->dev, "tx_tag:[%04x]\n", cur_p->ptp_tx_ts_tag);
+		if (lp->tstamp_config.tx_type == HWTSTAMP_TX_ONESTEP_SYNC ||
+		    lp->tstamp_config.tx_type == HWTSTAMP_TX_ONESTEP_P2P) {
+			u8 os_flags = ptp_os(skb, lp);
+
+			/* Pass one step flag with packet type (sync/pdelay resp)
+			 * to command FIFO helper only when one step TS is required.
+			 * Pass the default two step flag for other PTP events.
+			 */
+			if (os_flags)
+				packet_flags = os_flags | TX_TS_OP_ONESTEP;
+		}
+
+		/* Without room to wait for the timestamp, the frame goes out
+		 * with a NOOP command
+		 */
+		if (packet_flags == TX_TS_OP_TWOSTEP && axienet_txts_full(q))
+			packet_flags = TX_TS_OP_NOOP;
+
+		if (axienet_create_tsheader((u8 *)tsheader, packet_flags, q))
+			return NETDEV_TX_BUSY;
+
+		/* skb TS passing is required for non one step TS packets */
+		if (packet_flags == TX_TS_OP_TWOSTEP)
+			axienet_txts_queue(q, skb, cur_p->ptp_tx_ts_tag);
+	} else if (axienet_is_10g_ts(lp)) {
 		dev_dbg(lp->dev, "tx_tag:NOOP\n");
-			if (axienet_create_tsheader(lp->tx_ptpheader,
-						    TX_TS_OP_NOOP, q))
-				return NETDEV_TX_BUSY;
+		if (axienet_create_tsheader((u8 *)tsheader, TX_TS_OP_NOOP, q))
+			return NETDEV_TX_BUSY;
 	}
 
 	return NETDEV_TX_OK;
 }
 #endif
 
+/**
+ * axienet_tx_bounce_head - Bounce the unaligned head of a Tx buffer
+ * @q:		Pointer to DMA queue structure
+ * @cur_p:	Pointer to the Tx BD at q->tx_bd_tail
+ * @page:	Page the buffer starts in
+ * @off:	Offset of the buffer from the start of @page
+ * @len:	Length of the buffer
+ *
+ * Without DRE the DMA can only fetch from XAE_TX_DMA_ALIGN aligned
+ * addresses. The bytes up to the next aligned address are copied into the
+ * bounce buffer of @cur_p, so that the rest of the buffer can be handed to
+ * the DMA in place in the next BD.
+ *
+ * Return: Number of bytes bounced into @cur_p, 0 if the buffer is aligned.
+ */
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+static u32 axienet_tx_bounce_head(struct axienet_dma_q *q,
+				  struct aximcdma_bd *cur_p,
+				  struct page *page, u32 off, u32 len)
+#else
+static u32 axienet_tx_bounce_head(struct axienet_dma_q *q,
+				  struct axidma_bd *cur_p,
+				  struct page *page, u32 off, u32 len)
+#endif
+{
+	u32 head;
+
+	page += off >> PAGE_SHIFT;
+	off = offset_in_page(off);
+
+	/* An aligned boundary never lies past the end of the page */
+	head = min(ALIGN(off, XAE_TX_DMA_ALIGN) - off, len);
+	if (!head)
+		return 0;
+
+	memcpy_from_page(axienet_tx_buf(q, q->tx_bd_tail), page, off, head);
+	cur_p->phys = axienet_tx_buf_dma(q, q->tx_bd_tail);
+	cur_p->cntrl = head;
+	cur_p->tx_desc_mapping = DESC_DMA_MAP_BOUNCE;
+	u64_stats_update_begin(&q->xmit_stats.syncp);
+	q->xmit_stats.bounced_bytes += head;
+	u64_stats_update_end(&q->xmit_stats.syncp);
+
+	return head;
+}
+
+/**
+ * axienet_tx_csum - Set up the Tx checksum offload of a frame
+ * @lp:		Pointer to axienet local structure
+ * @skb:	Frame to transmit
+ * @cur_p:	Pointer to the first axi_dma/axi_mcdma Tx bd of the frame
+ */
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+static void axienet_tx_csum(struct axienet_local *lp, struct sk_buff *skb,
+			    struct aximcdma_bd *cur_p)
+#else
+static void axienet_tx_csum(struct axienet_local *lp, struct sk_buff *skb,
+			    struct axidma_bd *cur_p)
+#endif
+{
+	u32 csum_start_off;
+	u32 csum_index_off;
+
+	if (skb->ip_summed == CHECKSUM_PARTIAL && !lp->eth_hasnobuf &&
+	    lp->axienet_config->mactype == XAXIENET_1G) {
+		if (lp->features & XAE_FEATURE_FULL_TX_CSUM) {
+			/* Tx Full Checksum Offload Enabled */
+			cur_p->app0 |= 2;
+		} else if (lp->features & XAE_FEATURE_PARTIAL_TX_CSUM) {
+			csum_start_off = skb_transport_offset(skb);
+			csum_index_off = csum_start_off + skb->csum_offset;
+			/* Tx Partial Checksum Offload Enabled */
+			cur_p->app0 |= 1;
+			cur_p->app1 = (csum_start_off << 16) | csum_index_off;
+		}
+	} else if (skb->ip_summed == CHECKSUM_UNNECESSARY &&
+		   !lp->eth_hasnobuf &&
+		   (lp->axienet_config->mactype == XAXIENET_1G)) {
+		cur_p->app0 |= 2; /* Tx Full Checksum Offload Enabled */
+	}
+}
+
+/**
+ * axienet_tso_num_bd - Number of Tx BDs needed to segment a GSO frame
+ * @skb:	GSO frame
+ * @hasdre:	Whether the DMA has a Data Realignment Engine
+ *
+ * Every segment takes a header BD. Its payload is split at the end of each
+ * buffer of @skb, and without DRE each payload piece may take a bounce BD.
+ *
+ * Return: Upper bound of the number of BDs, minus the first one.
+ */
+static u32 axienet_tso_num_bd(struct sk_buff *skb, bool hasdre)
+{
+	u32 segs = skb_shinfo(skb)->gso_segs;
+	u32 pieces = segs + skb_shinfo(skb)->nr_frags;
+
+	return segs + (hasdre ? pieces : 2 * pieces) - 1;
+}
+
+/**
+ * axienet_tso_fix_hdr - Update the checksums of a TSO segment header
+ * @skb:	GSO frame the segment is cut from
+ * @hdr:	Header built by tso_build_hdr()
+ * @tso:	TSO state of @skb
+ * @size:	Payload length of the segment
+ *
+ * The MAC offload fills in the TCP/UDP checksum from the pseudo header sum
+ * of the segment. Only IPv4 is segmented, see axienet_features_check().
+ */
+static void axienet_tso_fix_hdr(struct sk_buff *skb, char *hdr,
+				struct tso_t *tso, int size)
+{
+	struct iphdr *iph = (struct iphdr *)(hdr + skb_network_offset(skb));
+	char *th = hdr + skb_transport_offset(skb);
+	__sum16 *check;
+	u8 proto;
+
+	if (tso->tlen == sizeof(struct udphdr)) {
+		check = &((struct udphdr *)th)->check;
+		proto = IPPROTO_UDP;
+	} else {
+		check = &((struct tcphdr *)th)->check;
+		proto = IPPROTO_TCP;
+	}
+	*check = ~csum_tcpudp_magic(iph->saddr, iph->daddr, tso->tlen + size,
+				    proto, 0);
+
+	iph->check = 0;
+	iph->check = ip_fast_csum(iph, iph->ihl);
+}
+
+/**
+ * axienet_tso_xmit - Segment a GSO frame onto the Tx BD ring
+ * @skb:	GSO frame to transmit
+ * @ndev:	Pointer to net_device structure
+ * @q:		Pointer to DMA queue structure, q->tx_lock must be held
+ *
+ * The headers of all segments are built in the tso_hdrs area of the queue,
+ * while the payload BDs point into the buffers of @skb. The DMA is started
+ * once for the whole frame.
+ *
+ * Return: NETDEV_TX_OK, the frame is dropped if it can not be mapped.
+ */
+static int axienet_tso_xmit(struct sk_buff *skb, struct net_device *ndev,
+			    struct axienet_dma_q *q)
+{
+	struct netdev_queue *txq = netdev_get_tx_queue(ndev, q->qidx);
+	struct axienet_local *lp = netdev_priv(ndev);
+	int hdr_len, total_len, data_left, size;
+	u32 first_bd = q->tx_bd_tail;
+	struct tso_t tso;
+	u32 bounced;
+	char *hdr;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	struct aximcdma_bd *cur_p;
+#else
+	struct axidma_bd *cur_p;
+#endif
+
+	hdr_len = tso_start(skb, &tso);
+	total_len = skb->len - hdr_len;
+
+	while (total_len > 0) {
+		data_left = min_t(int, skb_shinfo(skb)->gso_size, total_len);
+		total_len -= data_left;
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur_p = &q->txq_bd_v[q->tx_bd_tail];
+#else
+		cur_p = &q->tx_bd_v[q->tx_bd_tail];
+#endif
+		hdr = axienet_tso_hdr(q, q->tx_bd_tail);
+		tso_build_hdr(skb, hdr, &tso, data_left, total_len == 0);
+		axienet_tso_fix_hdr(skb, hdr, &tso, data_left);
+
+		cur_p->phys = axienet_tso_hdr_dma(q, q->tx_bd_tail);
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur_p->cntrl = hdr_len | XMCDMA_BD_CTRL_TXSOF_MASK;
+#else
+		cur_p->cntrl = hdr_len | XAXIDMA_BD_CTRL_TXSOF_MASK;
+#endif
+		cur_p->tx_desc_mapping = DESC_DMA_MAP_TSO_HDR;
+		axienet_tx_csum(lp, skb, cur_p);
+
+		while (data_left > 0) {
+			size = min_t(int, tso.size, data_left);
+
+			if (++q->tx_bd_tail >= lp->tx_bd_num)
+				q->tx_bd_tail = 0;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+			cur_p = &q->txq_bd_v[q->tx_bd_tail];
+#else
+			cur_p = &q->tx_bd_v[q->tx_bd_tail];
+#endif
+			bounced = 0;
+			if (!q->eth_hasdre) {
+				bounced = axienet_tx_bounce_head(q, cur_p,
+								 virt_to_page(tso.data),
+								 offset_in_page(tso.data),
+								 size);
+				if (bounced && bounced < size) {
+					if (++q->tx_bd_tail >= lp->tx_bd_num)
+						q->tx_bd_tail = 0;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+					cur_p = &q->txq_bd_v[q->tx_bd_tail];
+#else
+					cur_p = &q->tx_bd_v[q->tx_bd_tail];
+#endif
+				}
+			}
+
+			if (bounced < size) {
+				cur_p->phys = dma_map_single(ndev->dev.parent,
+							     tso.data + bounced,
+							     size - bounced,
+							     DMA_TO_DEVICE);
+				if (unlikely(dma_mapping_error(ndev->dev.parent,
+							       cur_p->phys)))
+					goto err_unmap;
+				cur_p->cntrl = size - bounced;
+				cur_p->tx_desc_mapping = DESC_DMA_MAP_SINGLE;
+			}
+
+			data_left -= size;
+			tso_build_data(skb, &tso, size);
+		}
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur_p->cntrl |= XMCDMA_BD_CTRL_TXEOF_MASK;
+#else
+		cur_p->cntrl |= XAXIDMA_BD_CTRL_TXEOF_MASK;
+#endif
+		if (total_len && ++q->tx_bd_tail >= lp->tx_bd_num)
+			q->tx_bd_tail = 0;
+	}
+	cur_p->tx_skb = (phys_addr_t)skb;
+
+	if (++q->tx_bd_tail >= lp->tx_bd_num)
+		q->tx_bd_tail = 0;
+	axienet_tx_sent(txq, q, skb);
+
+	return NETDEV_TX_OK;
+
+err_unmap:
+	/* Release what was queued so far, the failed BD holds nothing */
+	cur_p->phys = 0;
+	while (first_bd != q->tx_bd_tail) {
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur_p = &q->txq_bd_v[first_bd];
+#else
+		cur_p = &q->tx_bd_v[first_bd];
+#endif
+		axienet_tx_bd_release_buf(ndev, cur_p);
+		cur_p->app0 = 0;
+		if (++first_bd >= lp->tx_bd_num)
+			first_bd = 0;
+	}
+	axienet_tx_flush(q);
+	netdev_err(ndev, "TSO buffer map failed\n");
+	axienet_xmit_stats_inc(q, dropped);
+	dev_kfree_skb_any(skb);
+
+	return NETDEV_TX_OK;
+}
+
 static int axienet_queue_xmit(struct sk_buff *skb,
 			      struct net_device *ndev, u16 map)
 {
 	u32 ii;
 	u32 num_frag;
-	u32 csum_start_off;
-	u32 csum_index_off;
-	dma_addr_t tail_p;
+	u32 num_bd;
+	u32 first_bd;
+	u32 bounced;
+	u32 len;
+	int ret;
 	struct axienet_local *lp = netdev_priv(ndev);
+	struct netdev_queue *txq = netdev_get_tx_queue(ndev, map);
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 	struct aximcdma_bd *cur_p;
 #else
 	struct axidma_bd *cur_p;
 #endif
 	unsigned long flags;
-	struct axienet_dma_q *q;
+	struct axienet_dma_q *q = lp->dq[map];
 
 	if (lp->axienet_config->mactype == XAXIENET_10G_25G ||
 	    lp->axienet_config->mactype == XAXIENET_MRMAC) {
@@ -1272,14 +2008,27 @@ static int axienet_queue_xmit(struct sk_buff *skb,
 		 * to the packet the minimum packet length is 60 bytes.
 		 */
 		if (eth_skb_pad(skb)) {
-			ndev->stats.tx_dropped++;
 			ndev->stats.tx_errors++;
-			return NETDEV_TX_OK;
+			goto drop;
 		}
 	}
 	num_frag = skb_shinfo(skb)->nr_frags;
 
-	q = lp->dq[map];
+	/* Without DRE every buffer may be split in a bounce BD for its
+	 * unaligned head followed by a BD for the aligned remainder.
+	 */
+	num_bd = q->eth_hasdre ? num_frag : 2 * num_frag + 1;
+	if (skb_is_gso(skb)) {
+		num_bd = axienet_tso_num_bd(skb, q->eth_hasdre);
+	} else if (num_bd + 2 > lp->tx_bd_num) {
+		/* Can never fit a ring this short, send it from one buffer */
+		if (skb_linearize(skb)) {
+			dev_kfree_skb_any(skb);
+			goto drop;
+		}
+		num_frag = 0;
+		num_bd = 1;
+	}
 
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 	cur_p = &q->txq_bd_v[q->tx_bd_tail];
@@ -1288,84 +2037,87 @@ static int axienet_queue_xmit(struct sk_buff *skb,
 #endif
 
 	spin_lock_irqsave(&q->tx_lock, flags);
-	if (axienet_check_tx_bd_space(q, num_frag)) {
-		if (netif_queue_stopped(ndev)) {
-			spin_unlock_irqrestore(&q->tx_lock, flags);
-			return NETDEV_TX_BUSY;
-		}
+	if (axienet_check_tx_bd_space(q, num_bd)) {
+		axienet_xmit_stats_inc(q, ring_full);
+		if (netif_tx_queue_stopped(txq))
+			goto busy;
 
-		netif_stop_queue(ndev);
+		netif_tx_stop_queue(txq);
 
 		/* Matches barrier in axienet_start_xmit_done */
 		smp_mb();
 
 		/* Space might have just been freed - check again */
-		if (axienet_check_tx_bd_space(q, num_frag)) {
-			spin_unlock_irqrestore(&q->tx_lock, flags);
-			return NETDEV_TX_BUSY;
-		}
+		if (axienet_check_tx_bd_space(q, num_bd))
+			goto busy;
 
-		netif_wake_queue(ndev);
+		netif_tx_wake_queue(txq);
 	}
 
 #ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
-	if (axienet_skb_tstsmp(&skb, q, ndev)) {
-		spin_unlock_irqrestore(&q->tx_lock, flags);
-		return NETDEV_TX_BUSY;
-	}
+	if (axienet_skb_tstsmp(&skb, q, ndev))
+		goto busy;
 #endif
 
-	if (skb->ip_summed == CHECKSUM_PARTIAL && !lp->eth_hasnobuf &&
-	    lp->axienet_config->mactype == XAXIENET_1G) {
-		if (lp->features & XAE_FEATURE_FULL_TX_CSUM) {
-			/* Tx Full Checksum Offload Enabled */
-			cur_p->app0 |= 2;
-		} else if (lp->features & XAE_FEATURE_PARTIAL_RX_CSUM) {
-			csum_start_off = skb_transport_offset(skb);
-			csum_index_off = csum_start_off + skb->csum_offset;
-			/* Tx Partial Checksum Offload Enabled */
-			cur_p->app0 |= 1;
-			cur_p->app1 = (csum_start_off << 16) | csum_index_off;
-		}
-	} else if (skb->ip_summed == CHECKSUM_UNNECESSARY &&
-		   !lp->eth_hasnobuf &&
-		   (lp->axienet_config->mactype == XAXIENET_1G)) {
-		cur_p->app0 |= 2; /* Tx Full Checksum Offload Enabled */
+	if (skb_is_gso(skb)) {
+		ret = axienet_tso_xmit(skb, ndev, q);
+		spin_unlock_irqrestore(&q->tx_lock, flags);
+		return ret;
 	}
 
+	axienet_tx_csum(lp, skb, cur_p);
+
+	first_bd = q->tx_bd_tail;
+	len = skb_headlen(skb);
+	bounced = 0;
+	if (!q->eth_hasdre) {
+		bounced = axienet_tx_bounce_head(q, cur_p,
+						 virt_to_page(skb->data),
+						 offset_in_page(skb->data),
+						 len);
+		len -= bounced;
+		if (bounced && len) {
 #ifdef CONFIG_AXIENET_HAS_MCDMA
-	cur_p->cntrl = (skb_headlen(skb) | XMCDMA_BD_CTRL_TXSOF_MASK);
+			cur_p->cntrl |= XMCDMA_BD_CTRL_TXSOF_MASK;
 #else
-	cur_p->cntrl = (skb_headlen(skb) | XAXIDMA_BD_CTRL_TXSOF_MASK);
+			cur_p->cntrl |= XAXIDMA_BD_CTRL_TXSOF_MASK;
 #endif
-
-	if (!q->eth_hasdre &&
-	    (((phys_addr_t)skb->data & 0x3) || num_frag > 0)) {
-		skb_copy_and_csum_dev(skb, q->tx_buf[q->tx_bd_tail]);
-
-		cur_p->phys = q->tx_bufs_dma +
-			      (q->tx_buf[q->tx_bd_tail] - q->tx_bufs);
-
+			if (++q->tx_bd_tail >= lp->tx_bd_num)
+				q->tx_bd_tail = 0;
 #ifdef CONFIG_AXIENET_HAS_MCDMA
-		cur_p->cntrl = skb_pagelen(skb) | XMCDMA_BD_CTRL_TXSOF_MASK;
+			cur_p = &q->txq_bd_v[q->tx_bd_tail];
 #else
-		cur_p->cntrl = skb_pagelen(skb) | XAXIDMA_BD_CTRL_TXSOF_MASK;
+			cur_p = &q->tx_bd_v[q->tx_bd_tail];
 #endif
-		goto out;
-	} else {
-		cur_p->phys = dma_map_single(ndev->dev.parent, skb->data,
-					     skb_headlen(skb), DMA_TO_DEVICE);
+		}
+	}
+
+	if (len || !bounced) {
+		cur_p->phys = dma_map_single(ndev->dev.parent,
+					     skb->data + bounced, len,
+					     DMA_TO_DEVICE);
 		if (unlikely(dma_mapping_error(ndev->dev.parent, cur_p->phys))) {
 			cur_p->phys = 0;
-			spin_unlock_irqrestore(&q->tx_lock, flags);
+			q->tx_bd_tail = first_bd;
 			dev_err(&ndev->dev, "TX buffer map failed\n");
-			return NETDEV_TX_BUSY;
+			goto busy;
 		}
+		cur_p->tx_desc_mapping = DESC_DMA_MAP_SINGLE;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur_p->cntrl = len | (bounced ? 0 : XMCDMA_BD_CTRL_TXSOF_MASK);
+#else
+		cur_p->cntrl = len | (bounced ? 0 : XAXIDMA_BD_CTRL_TXSOF_MASK);
+#endif
+	} else {
+		/* The whole linear part went into the bounce BD */
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur_p->cntrl |= XMCDMA_BD_CTRL_TXSOF_MASK;
+#else
+		cur_p->cntrl |= XAXIDMA_BD_CTRL_TXSOF_MASK;
+#endif
 	}
-	cur_p->tx_desc_mapping = DESC_DMA_MAP_SINGLE;
 
 	for (ii = 0; ii < num_frag; ii++) {
-		u32 len;
 		skb_frag_t *frag;
 
 		if (++q->tx_bd_tail >= lp->tx_bd_num)
@@ -1378,39 +2130,57 @@ static int axienet_queue_xmit(struct sk_buff *skb,
 #endif
 		frag = &skb_shinfo(skb)->frags[ii];
 		len = skb_frag_size(frag);
-		cur_p->phys = skb_frag_dma_map(ndev->dev.parent, frag, 0, len,
-					       DMA_TO_DEVICE);
+		bounced = 0;
+		if (!q->eth_hasdre) {
+			bounced = axienet_tx_bounce_head(q, cur_p,
+							 skb_frag_page(frag),
+							 skb_frag_off(frag),
+							 len);
+			len -= bounced;
+			if (!len)
+				continue;
+			if (bounced) {
+				if (++q->tx_bd_tail >= lp->tx_bd_num)
+					q->tx_bd_tail = 0;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+				cur_p = &q->txq_bd_v[q->tx_bd_tail];
+#else
+				cur_p = &q->tx_bd_v[q->tx_bd_tail];
+#endif
+			}
+		}
+		cur_p->phys = skb_frag_dma_map(ndev->dev.parent, frag, bounced,
+					       len, DMA_TO_DEVICE);
 		cur_p->cntrl = len;
 		cur_p->tx_desc_mapping = DESC_DMA_MAP_PAGE;
 	}
 
-out:
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 	cur_p->cntrl |= XMCDMA_BD_CTRL_TXEOF_MASK;
-	tail_p = q->tx_bd_p + sizeof(*q->txq_bd_v) * q->tx_bd_tail;
 #else
 	cur_p->cntrl |= XAXIDMA_BD_CTRL_TXEOF_MASK;
-	tail_p = q->tx_bd_p + sizeof(*q->tx_bd_v) * q->tx_bd_tail;
 #endif
 	cur_p->tx_skb = (phys_addr_t)skb;
-	cur_p->tx_skb = (phys_addr_t)skb;
-
-	tail_p = q->tx_bd_p + sizeof(*q->tx_bd_v) * q->tx_bd_tail;
-	/* Ensure BD write before starting transfer */
-	wmb();
 
-	/* Start the transfer */
-#ifdef CONFIG_AXIENET_HAS_MCDMA
-	axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id),
-			  tail_p);
-#else
-	axienet_dma_bdout(q, XAXIDMA_TX_TDESC_OFFSET, tail_p);
-#endif
 	if (++q->tx_bd_tail >= lp->tx_bd_num)
 		q->tx_bd_tail = 0;
+	axienet_tx_sent(txq, q, skb);
+
+	spin_unlock_irqrestore(&q->tx_lock, flags);
+
+	return NETDEV_TX_OK;
 
+busy:
+	axienet_tx_flush(q);
 	spin_unlock_irqrestore(&q->tx_lock, flags);
+	return NETDEV_TX_BUSY;
 
+drop:
+	/* Frames held back by xmit_more still have to be started */
+	spin_lock_irqsave(&q->tx_lock, flags);
+	axienet_xmit_stats_inc(q, dropped);
+	axienet_tx_flush(q);
+	spin_unlock_irqrestore(&q->tx_lock, flags);
 	return NETDEV_TX_OK;
 }
 
@@ -1435,27 +2205,298 @@ static int axienet_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 }
 
 /**
- * axienet_recv - Is called from Axi DMA Rx Isr to complete the received
- *		  BD processing.
- * @ndev:	Pointer to net_device structure.
- * @budget:	NAPI budget
- * @q:		Pointer to axienet DMA queue structure
+ * axienet_features_check - Driver ndo_features_check routine
+ * @skb:	sk_buff pointer that is to be transmitted
+ * @ndev:	Pointer to net_device structure
+ * @features:	Features the stack would use for @skb
+ *
+ * The driver only segments IPv4 frames, and only those whose segments all
+ * fit in the Tx BD ring at once. Others are segmented by the stack.
+ *
+ * Return: The features that can be used for @skb.
+ */
+static netdev_features_t axienet_features_check(struct sk_buff *skb,
+						struct net_device *ndev,
+						netdev_features_t features)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	if (skb_is_gso(skb) &&
+	    (vlan_get_protocol(skb) != htons(ETH_P_IP) ||
+	     axienet_tso_num_bd(skb, false) + 2 > lp->tx_bd_num))
+		features &= ~NETIF_F_GSO_MASK;
+
+	return vlan_features_check(skb, features);
+}
+
+/**
+ * axienet_xdp_txq - Tx queue used to send XDP frames
+ * @lp:		Pointer to axienet local structure
+ * @qidx:	Index of the Rx queue or CPU the frames originate from
+ *
+ * Return: The DMA queue whose Tx BD ring carries the frames.
+ */
+static inline struct axienet_dma_q *axienet_xdp_txq(struct axienet_local *lp,
+						    int qidx)
+{
+	return lp->dq[qidx % lp->num_tx_queues];
+}
+
+/**
+ * axienet_xdp_xmit_frame - Queue an XDP frame on a Tx BD ring
+ * @lp:		Pointer to axienet local structure
+ * @q:		Pointer to DMA queue structure, q->tx_lock must be held
+ * @xdpf:	Frame to transmit
+ * @dma_map:	Map the frame (ndo_xdp_xmit) instead of reusing the mapping
+ *		of the Rx page pool it was received into (XDP_TX)
+ *
+ * Return: 0, on success. Negative error value if the frame was not queued.
+ */
+static int axienet_xdp_xmit_frame(struct axienet_local *lp,
+				  struct axienet_dma_q *q,
+				  struct xdp_frame *xdpf, bool dma_map)
+{
+	struct device *dev = lp->ndev->dev.parent;
+	u32 len = xdpf->len;
+	struct page *page;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	struct aximcdma_bd *cur_p;
+#else
+	struct axidma_bd *cur_p;
+#endif
+
+	if (axienet_check_tx_bd_space(q, 0)) {
+		axienet_xmit_stats_inc(q, ring_full);
+		return -EBUSY;
+	}
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	cur_p = &q->txq_bd_v[q->tx_bd_tail];
+#else
+	cur_p = &q->tx_bd_v[q->tx_bd_tail];
+#endif
+
+	/* XXV MAC and MRMAC do not pad small frames, see axienet_queue_xmit.
+	 * XDP frames always have enough tailroom for the padding.
+	 */
+	if ((lp->axienet_config->mactype == XAXIENET_10G_25G ||
+	     lp->axienet_config->mactype == XAXIENET_MRMAC) &&
+	    len < ETH_ZLEN) {
+		memset(xdpf->data + len, 0, ETH_ZLEN - len);
+		len = ETH_ZLEN;
+	}
+
+	if (!q->eth_hasdre && ((phys_addr_t)xdpf->data & 0x3)) {
+		if (len > XAE_MAX_PKT_LEN)
+			return -EINVAL;
+
+		memcpy(axienet_tx_buf(q, q->tx_bd_tail), xdpf->data, len);
+		cur_p->phys = axienet_tx_buf_dma(q, q->tx_bd_tail);
+		cur_p->tx_desc_mapping = DESC_DMA_MAP_XDP;
+	} else if (dma_map) {
+		cur_p->phys = dma_map_single(dev, xdpf->data, len,
+					     DMA_TO_DEVICE);
+		if (unlikely(dma_mapping_error(dev, cur_p->phys))) {
+			cur_p->phys = 0;
+			return -ENOMEM;
+		}
+		cur_p->tx_desc_mapping = DESC_DMA_MAP_XDP_SINGLE;
+	} else {
+		page = virt_to_head_page(xdpf->data);
+		cur_p->phys = page_pool_get_dma_addr(page) +
+			      (xdpf->data - page_address(page));
+		dma_sync_single_for_device(dev, cur_p->phys, len,
+					   DMA_BIDIRECTIONAL);
+		cur_p->tx_desc_mapping = DESC_DMA_MAP_XDP;
+	}
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	cur_p->cntrl = len | XMCDMA_BD_CTRL_TXSOF_MASK |
+		       XMCDMA_BD_CTRL_TXEOF_MASK;
+#else
+	cur_p->cntrl = len | XAXIDMA_BD_CTRL_TXSOF_MASK |
+		       XAXIDMA_BD_CTRL_TXEOF_MASK;
+#endif
+	cur_p->tx_skb = (phys_addr_t)xdpf;
+
+	if (++q->tx_bd_tail >= lp->tx_bd_num)
+		q->tx_bd_tail = 0;
+	axienet_tx_kick(q);
+
+	return 0;
+}
+
+/**
+ * axienet_xdp_xmit - Transmit XDP frames redirected to the interface
+ * @ndev:	Pointer to net_device structure
+ * @num_frames:	Number of frames in @frames
+ * @frames:	XDP frames to transmit
+ * @flags:	XDP_XMIT_* flags
+ *
+ * Return: Number of frames queued for transmission, negative error value
+ *	   if the request is invalid.
+ */
+static int axienet_xdp_xmit(struct net_device *ndev, int num_frames,
+			    struct xdp_frame **frames, u32 flags)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct axienet_dma_q *q;
+	unsigned long irqflags;
+	int i;
+
+	if (unlikely(flags & ~XDP_XMIT_FLAGS_MASK))
+		return -EINVAL;
+
+	if (unlikely(!netif_running(ndev)))
+		return -ENETDOWN;
+
+	q = axienet_xdp_txq(lp, smp_processor_id());
+
+	spin_lock_irqsave(&q->tx_lock, irqflags);
+	for (i = 0; i < num_frames; i++) {
+		if (axienet_xdp_xmit_frame(lp, q, frames[i], true))
+			break;
+	}
+	spin_unlock_irqrestore(&q->tx_lock, irqflags);
+
+	return i;
+}
+
+/**
+ * axienet_run_xdp - Run the XDP program on a received frame
+ * @lp:		Pointer to axienet local structure
+ * @q:		Pointer to the DMA queue the frame was received on
+ * @prog:	XDP program to run
+ * @xdp:	Frame to run the program on
+ *
+ * Return: AXIENET_XDP_PASS if the frame is to be passed up the stack,
+ *	   AXIENET_XDP_TX or AXIENET_XDP_REDIRECT if it was handed over and
+ *	   AXIENET_XDP_CONSUMED if it is to be dropped. The caller still owns
+ *	   the buffer for AXIENET_XDP_PASS and AXIENET_XDP_CONSUMED only.
+ */
+static u32 axienet_run_xdp(struct axienet_local *lp, struct axienet_dma_q *q,
+			   struct bpf_prog *prog, struct xdp_buff *xdp)
+{
+	struct axienet_dma_q *txq;
+	struct xdp_frame *xdpf;
+	unsigned long flags;
+	bool zc;
+	u32 act;
+	int err;
+
+	act = bpf_prog_run_xdp(prog, xdp);
+	switch (act) {
+	case XDP_PASS:
+		return AXIENET_XDP_PASS;
+	case XDP_TX:
+		zc = xdp->rxq->mem.type == MEM_TYPE_XSK_BUFF_POOL;
+		/* On an AF_XDP queue this copies the frame out of the umem */
+		xdpf = xdp_convert_buff_to_frame(xdp);
+		if (unlikely(!xdpf))
+			goto out_failure;
+
+		txq = axienet_xdp_txq(lp, q->qidx);
+		spin_lock_irqsave(&txq->tx_lock, flags);
+		err = axienet_xdp_xmit_frame(lp, txq, xdpf, zc);
+		spin_unlock_irqrestore(&txq->tx_lock, flags);
+		if (unlikely(err)) {
+			if (!zc)
+				goto out_failure;
+			/* The AF_XDP buffer was already released by the copy */
+			xdp_return_frame(xdpf);
+			trace_xdp_exception(lp->ndev, prog, act);
+		}
+		return AXIENET_XDP_TX;
+	case XDP_REDIRECT:
+		err = xdp_do_redirect(lp->ndev, xdp, prog);
+		if (unlikely(err))
+			goto out_failure;
+		return AXIENET_XDP_REDIRECT;
+	default:
+		bpf_warn_invalid_xdp_action(lp->ndev, prog, act);
+		fallthrough;
+	case XDP_ABORTED:
+out_failure:
+		trace_xdp_exception(lp->ndev, prog, act);
+		fallthrough;
+	case XDP_DROP:
+		return AXIENET_XDP_CONSUMED;
+	}
+}
+
+/**
+ * axienet_rx_csum - Set the checksum state of a received skb
+ * @lp:		Pointer to axienet local structure
+ * @skb:	Received frame, skb->protocol already set
+ * @cur_p:	Pointer to the axi_dma/axi_mcdma Rx bd the frame came from
+ */
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+static void axienet_rx_csum(struct axienet_local *lp, struct sk_buff *skb,
+			    struct aximcdma_bd *cur_p)
+#else
+static void axienet_rx_csum(struct axienet_local *lp, struct sk_buff *skb,
+			    struct axidma_bd *cur_p)
+#endif
+{
+	u32 csumstatus;
+
+	/*skb_checksum_none_assert(skb);*/
+	skb->ip_summed = CHECKSUM_NONE;
+
+	/* if we're doing Rx csum offload, set it up */
+	if (lp->features & XAE_FEATURE_FULL_RX_CSUM &&
+	    lp->axienet_config->mactype == XAXIENET_1G &&
+	    !lp->eth_hasnobuf) {
+		csumstatus = (cur_p->app2 &
+			      XAE_FULL_CSUM_STATUS_MASK) >> 3;
+		if (csumstatus == XAE_IP_TCP_CSUM_VALIDATED ||
+		    csumstatus == XAE_IP_UDP_CSUM_VALIDATED) {
+			skb->ip_summed = CHECKSUM_UNNECESSARY;
+		}
+	} else if ((lp->features & XAE_FEATURE_PARTIAL_RX_CSUM) != 0 &&
+		   skb->protocol == htons(ETH_P_IP) &&
+		   skb->len > 64 && !lp->eth_hasnobuf &&
+		   lp->axienet_config->mactype == XAXIENET_1G) {
+		skb->csum = be32_to_cpu(cur_p->app3 & 0xFFFF);
+		skb->ip_summed = CHECKSUM_COMPLETE;
+	}
+}
+
+/**
+ * axienet_recv - Is called from Axi DMA Rx Isr to complete the received
+ *		  BD processing.
+ * @ndev:	Pointer to net_device structure.
+ * @budget:	NAPI budget
+ * @q:		Pointer to axienet DMA queue structure
  *
  * This function is invoked from the Axi DMA Rx isr(poll) to process the Rx BDs
- * It does minimal processing and invokes "netif_receive_skb" to complete
- * further processing.
+ * It runs the attached XDP program, if any, on every frame and invokes
+ * "netif_receive_skb" for the ones it passes to complete further processing.
  * Return: Number of BD's processed.
  */
 static int axienet_recv(struct net_device *ndev, int budget,
 			struct axienet_dma_q *q)
 {
 	u32 length;
-	u32 csumstatus;
 	u32 size = 0;
 	u32 packets = 0;
+	u32 dropped = 0;
+	u32 alloc_failed = 0;
+	u32 act, xdp_res = 0;
 	dma_addr_t tail_p = 0;
+	dma_addr_t new_phys;
 	struct axienet_local *lp = netdev_priv(ndev);
-	struct sk_buff *skb, *new_skb;
+	struct bpf_prog *xdp_prog = READ_ONCE(lp->xdp_prog);
+	struct page *page, *new_page;
+	struct sk_buff *skb;
+	struct xdp_buff xdp;
+	void *va, *data;
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+	bool inband_ts = axienet_rx_inband_ts(lp);
+	bool fifo_ts = lp->axienet_config->mactype == XAXIENET_10G_25G ||
+		       lp->axienet_config->mactype == XAXIENET_MRMAC;
+	u64 rx_tstamp = 0;
+#endif
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 	struct aximcdma_bd *cur_p;
 #else
@@ -1463,6 +2504,9 @@ static int axienet_recv(struct net_device *ndev, int budget,
 #endif
 	unsigned int numbdfree = 0;
 
+	xdp_init_buff(&xdp, PAGE_SIZE << axienet_rx_buf_order(lp),
+		      &q->xdp_rxq);
+
 	/* Get relevat BD status value */
 	rmb();
 #ifdef CONFIG_AXIENET_HAS_MCDMA
@@ -1473,9 +2517,11 @@ static int axienet_recv(struct net_device *ndev, int budget,
 
 	while ((numbdfree < budget) &&
 	       (cur_p->status & XAXIDMA_BD_STS_COMPLETE_MASK)) {
-		new_skb = netdev_alloc_skb(ndev, lp->max_frm_size);
-		if (!new_skb)
+		new_page = axienet_rx_page_alloc(q, &new_phys);
+		if (!new_page) {
+			alloc_failed++;
 			break;
+		}
 
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 		tail_p = q->rx_bd_p + sizeof(*q->rxq_bd_v) * q->rx_bd_ci;
@@ -1483,133 +2529,698 @@ static int axienet_recv(struct net_device *ndev, int budget,
 		tail_p = q->rx_bd_p + sizeof(*q->rx_bd_v) * q->rx_bd_ci;
 #endif
 
-		dma_unmap_single(ndev->dev.parent, cur_p->phys,
-				 lp->max_frm_size,
-				 DMA_FROM_DEVICE);
+		/* A slot is only handed back to the hardware once its
+		 * replacement buffer has been allocated, so the page is
+		 * always valid here.
+		 */
+		page = (struct page *)(cur_p->sw_id_offset);
 
-		skb = (struct sk_buff *)(cur_p->sw_id_offset);
+		if (lp->eth_hasnobuf ||
+		    lp->axienet_config->mactype != XAXIENET_1G)
+			length = cur_p->status & XAXIDMA_BD_STS_ACTUAL_LEN_MASK;
+		else
+			length = cur_p->app4 & 0x0000FFFF;
 
-		/* skb could be NULL if a previous pass already received the
-		 * packet for this slot in the ring, but failed to refill it
-		 * with a newly allocated buffer. In this case, don't try to
-		 * receive it again.
-		 */
-		if (likely(skb)) {
-			if (lp->eth_hasnobuf ||
-			    lp->axienet_config->mactype != XAXIENET_1G)
-				length = cur_p->status & XAXIDMA_BD_STS_ACTUAL_LEN_MASK;
-			else
-				length = cur_p->app4 & 0x0000FFFF;
+		dma_sync_single_for_cpu(ndev->dev.parent, cur_p->phys, length,
+					page_pool_get_dma_dir(q->page_pool));
 
-			skb_put(skb, length);
+		va = page_address(page);
+		data = va + XAE_RX_HEADROOM;
 
 #ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
-			if ((lp->tstamp_config.rx_filter == HWTSTAMP_FILTER_ALL ||
-			     lp->eth_hasptp) &&
-			    lp->axienet_config->mactype != XAXIENET_10G_25G &&
-			    lp->axienet_config->mactype != XAXIENET_MRMAC) {
-				u32 sec, nsec;
-				u64 time64;
-				struct skb_shared_hwtstamps *shhwtstamps;
-
-				if (lp->axienet_config->mactype == XAXIENET_1G ||
-				    lp->axienet_config->mactype == XAXIENET_2_5G) {
-					/* The first 8 bytes will be the timestamp */
-					memcpy(&sec, &skb->data[0], 4);
-					memcpy(&nsec, &skb->data[4], 4);
-
-					sec = cpu_to_be32(sec);
-					nsec = cpu_to_be32(nsec);
-				} else {
-					/* The first 8 bytes will be the timestamp */
-					memcpy(&nsec, &skb->data[0], 4);
-					memcpy(&sec, &skb->data[4], 4);
-				}
+		if (inband_ts) {
+			/* Remove the timestamp the MAC puts in front */
+			rx_tstamp = axienet_rx_inband_tstamp(lp, data);
+			data += AXIENET_TS_HEADER_LEN;
+			length -= AXIENET_TS_HEADER_LEN;
+		}
+#endif
 
-				/* Remove these 8 bytes from the buffer */
-				skb_pull(skb, 8);
-				time64 = sec * NS_PER_SEC + nsec;
-				shhwtstamps = skb_hwtstamps(skb);
-				shhwtstamps->hwtstamp = ns_to_ktime(time64);
-			} else if (lp->axienet_config->mactype == XAXIENET_10G_25G ||
-				   lp->axienet_config->mactype == XAXIENET_MRMAC) {
-				axienet_rx_hwtstamp(lp, skb);
+		if (unlikely(axienet_rx_filtered(lp, data))) {
+			page_pool_recycle_direct(q->page_pool, page);
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+			if (fifo_ts)
+				axienet_rx_hwtstamp(lp, NULL);
+#endif
+			goto refill;
+		}
+
+		if (xdp_prog) {
+			xdp_prepare_buff(&xdp, va, data - va, length, false);
+			act = axienet_run_xdp(lp, q, xdp_prog, &xdp);
+			if (act != AXIENET_XDP_PASS) {
+				if (act == AXIENET_XDP_CONSUMED)
+					page_pool_recycle_direct(q->page_pool,
+								 page);
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+				if (fifo_ts)
+					axienet_rx_hwtstamp(lp, NULL);
+#endif
+				xdp_res |= act;
+				size += length;
+				packets++;
+				goto refill;
 			}
+
+			/* The program may have moved the frame boundaries */
+			data = xdp.data;
+			length = xdp.data_end - xdp.data;
+		}
+
+		skb = napi_build_skb(va, PAGE_SIZE << axienet_rx_buf_order(lp));
+		if (unlikely(!skb)) {
+			/* Drop the frame, its buffer goes back to the pool */
+			page_pool_recycle_direct(q->page_pool, page);
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+			if (fifo_ts)
+				axienet_rx_hwtstamp(lp, NULL);
+#endif
+			dropped++;
+		} else {
+			skb_mark_for_recycle(skb);
+			skb_reserve(skb, data - va);
+			skb_put(skb, length);
+
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+			if (inband_ts)
+				skb_hwtstamps(skb)->hwtstamp =
+					ns_to_ktime(rx_tstamp);
+			else if (fifo_ts)
+				axienet_rx_hwtstamp(lp, skb);
 #endif
 			skb->protocol = eth_type_trans(skb, ndev);
-			/*skb_checksum_none_assert(skb);*/
-			skb->ip_summed = CHECKSUM_NONE;
-
-			/* if we're doing Rx csum offload, set it up */
-			if (lp->features & XAE_FEATURE_FULL_RX_CSUM &&
-			    lp->axienet_config->mactype == XAXIENET_1G &&
-			    !lp->eth_hasnobuf) {
-				csumstatus = (cur_p->app2 &
-					      XAE_FULL_CSUM_STATUS_MASK) >> 3;
-				if (csumstatus == XAE_IP_TCP_CSUM_VALIDATED ||
-				    csumstatus == XAE_IP_UDP_CSUM_VALIDATED) {
-					skb->ip_summed = CHECKSUM_UNNECESSARY;
-				}
-			} else if ((lp->features & XAE_FEATURE_PARTIAL_RX_CSUM) != 0 &&
-				   skb->protocol == htons(ETH_P_IP) &&
-				   skb->len > 64 && !lp->eth_hasnobuf &&
-				   lp->axienet_config->mactype == XAXIENET_1G) {
-				skb->csum = be32_to_cpu(cur_p->app3 & 0xFFFF);
-				skb->ip_summed = CHECKSUM_COMPLETE;
+			axienet_rx_csum(lp, skb, cur_p);
+
+		netif_receive_skb(skb);
+
+			size += length;
+			packets++;
+		}
+
+refill:
+		cur_p->phys = new_phys;
+		cur_p->cntrl = lp->max_frm_size;
+		cur_p->status = 0;
+		cur_p->sw_id_offset = (phys_addr_t)new_page;
+
+		if (++q->rx_bd_ci >= lp->rx_bd_num)
+			q->rx_bd_ci = 0;
+
+		/* Get relevat BD status value */
+		rmb();
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur_p = &q->rxq_bd_v[q->rx_bd_ci];
+#else
+		cur_p = &q->rx_bd_v[q->rx_bd_ci];
+#endif
+		numbdfree++;
+	}
+
+	u64_stats_update_begin(&q->rx_stats.syncp);
+	q->rx_stats.packets += packets;
+	q->rx_stats.bytes += size;
+	q->rx_stats.dropped += dropped;
+	q->rx_stats.alloc_failed += alloc_failed;
+	u64_stats_update_end(&q->rx_stats.syncp);
+
+	if (xdp_res & AXIENET_XDP_REDIRECT)
+		xdp_do_flush();
+
+	if (tail_p) {
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
+				  q->rx_offset, tail_p);
+#else
+		axienet_dma_bdout(q, XAXIDMA_RX_TDESC_OFFSET, tail_p);
+#endif
+	}
+
+	return numbdfree;
+}
+
+/**
+ * axienet_recv_sg - Rx BD processing of a queue in scatter mode
+ * @ndev:	Pointer to net_device structure.
+ * @budget:	NAPI budget
+ * @q:		Pointer to axienet DMA queue structure
+ *
+ * Every BD holds an order-0 page, see axienet_rx_scatter(). The skb is built
+ * around the buffer flagged with start of frame and the following buffers
+ * are attached to it as page fragments. A frame still incomplete at the end
+ * of the budget is kept in q->rx_skb for the next poll. Frames that lack
+ * their start, are cut short by the next one or need more than
+ * MAX_SKB_FRAGS fragments are dropped.
+ *
+ * Return: Number of BD's processed.
+ */
+static int axienet_recv_sg(struct net_device *ndev, int budget,
+			   struct axienet_dma_q *q)
+{
+	u32 length, status;
+	u32 size = 0;
+	u32 packets = 0;
+	u32 dropped = 0;
+	u32 alloc_failed = 0;
+	dma_addr_t tail_p = 0;
+	dma_addr_t new_phys;
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct sk_buff *skb = q->rx_skb;
+	struct page *page, *new_page;
+	void *va, *data;
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+	bool inband_ts = axienet_rx_inband_ts(lp);
+	bool fifo_ts = lp->axienet_config->mactype == XAXIENET_10G_25G ||
+		       lp->axienet_config->mactype == XAXIENET_MRMAC;
+	u64 rx_tstamp;
+#endif
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	struct aximcdma_bd *cur_p;
+#else
+	struct axidma_bd *cur_p;
+#endif
+	unsigned int numbdfree = 0;
+
+	/* Get relevat BD status value */
+	rmb();
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	cur_p = &q->rxq_bd_v[q->rx_bd_ci];
+#else
+	cur_p = &q->rx_bd_v[q->rx_bd_ci];
+#endif
+
+	while ((numbdfree < budget) &&
+	       (cur_p->status & XAXIDMA_BD_STS_COMPLETE_MASK)) {
+		new_page = axienet_rx_page_alloc(q, &new_phys);
+		if (!new_page) {
+			alloc_failed++;
+			break;
+		}
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		tail_p = q->rx_bd_p + sizeof(*q->rxq_bd_v) * q->rx_bd_ci;
+#else
+		tail_p = q->rx_bd_p + sizeof(*q->rx_bd_v) * q->rx_bd_ci;
+#endif
+
+		page = (struct page *)(cur_p->sw_id_offset);
+		status = cur_p->status;
+		length = status & XAXIDMA_BD_STS_ACTUAL_LEN_MASK;
+
+		dma_sync_single_for_cpu(ndev->dev.parent, cur_p->phys, length,
+					page_pool_get_dma_dir(q->page_pool));
+
+		if (status & XAXIDMA_BD_STS_RXSOF_MASK) {
+			if (skb) {
+				/* The previous frame never saw its end */
+				dev_kfree_skb(skb);
+				dropped++;
 			}
 
-		netif_receive_skb(skb);
+			va = page_address(page);
+			data = va + XAE_RX_HEADROOM;
+
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+			if (inband_ts) {
+				/* Remove the timestamp the MAC puts in front */
+				rx_tstamp = axienet_rx_inband_tstamp(lp, data);
+				data += AXIENET_TS_HEADER_LEN;
+				length -= AXIENET_TS_HEADER_LEN;
+			}
+#endif
+
+			skb = napi_build_skb(va, PAGE_SIZE);
+			if (unlikely(!skb)) {
+				page_pool_recycle_direct(q->page_pool, page);
+				dropped++;
+			} else {
+				skb_mark_for_recycle(skb);
+				skb_reserve(skb, data - va);
+				skb_put(skb, length);
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+				if (inband_ts)
+					skb_hwtstamps(skb)->hwtstamp =
+						ns_to_ktime(rx_tstamp);
+#endif
+			}
+		} else if (!skb) {
+			/* The start of this frame has already been dropped */
+			page_pool_recycle_direct(q->page_pool, page);
+		} else if (skb_shinfo(skb)->nr_frags >= MAX_SKB_FRAGS) {
+			page_pool_recycle_direct(q->page_pool, page);
+			dev_kfree_skb(skb);
+			skb = NULL;
+			dropped++;
+		} else {
+			skb_add_rx_frag(skb, skb_shinfo(skb)->nr_frags, page,
+					XAE_RX_HEADROOM, length, PAGE_SIZE);
+		}
+
+		if (status & XAXIDMA_BD_STS_RXEOF_MASK) {
+			if (skb) {
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+				if (fifo_ts)
+					axienet_rx_hwtstamp(lp, skb);
+#endif
+				size += skb->len;
+				packets++;
+
+				skb->protocol = eth_type_trans(skb, ndev);
+				axienet_rx_csum(lp, skb, cur_p);
+				netif_receive_skb(skb);
+				skb = NULL;
+			} else {
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+				if (fifo_ts)
+					axienet_rx_hwtstamp(lp, NULL);
+#endif
+			}
+		}
+
+		cur_p->phys = new_phys;
+		cur_p->cntrl = axienet_rx_buf_len(lp);
+		cur_p->status = 0;
+		cur_p->sw_id_offset = (phys_addr_t)new_page;
+
+		if (++q->rx_bd_ci >= lp->rx_bd_num)
+			q->rx_bd_ci = 0;
+
+		/* Get relevat BD status value */
+		rmb();
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur_p = &q->rxq_bd_v[q->rx_bd_ci];
+#else
+		cur_p = &q->rx_bd_v[q->rx_bd_ci];
+#endif
+		numbdfree++;
+	}
+
+	q->rx_skb = skb;
+
+	u64_stats_update_begin(&q->rx_stats.syncp);
+	q->rx_stats.packets += packets;
+	q->rx_stats.bytes += size;
+	q->rx_stats.dropped += dropped;
+	q->rx_stats.alloc_failed += alloc_failed;
+	u64_stats_update_end(&q->rx_stats.syncp);
+
+	if (tail_p) {
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
+				  q->rx_offset, tail_p);
+#else
+		axienet_dma_bdout(q, XAXIDMA_RX_TDESC_OFFSET, tail_p);
+#endif
+	}
+
+	return numbdfree;
+}
+
+/**
+ * axienet_rx_zc_refill - Give AF_XDP buffers to the empty Rx BDs of a queue
+ * @q:		Pointer to DMA queue structure bound to an xsk pool
+ *
+ * BDs are filled in ring order from q->rx_bd_fill until the fill ring of the
+ * socket runs dry or the BD still holding the oldest buffer is reached, and
+ * the tail pointer is moved past the last filled BD.
+ */
+void axienet_rx_zc_refill(struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = q->lp;
+	struct xsk_buff_pool *pool = q->xsk_pool;
+	dma_addr_t tail_p = 0;
+	struct xdp_buff *xdp;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	struct aximcdma_bd *cur_p = &q->rxq_bd_v[q->rx_bd_fill];
+#else
+	struct axidma_bd *cur_p = &q->rx_bd_v[q->rx_bd_fill];
+#endif
+
+	while (!cur_p->sw_id_offset) {
+		xdp = xsk_buff_alloc(pool);
+		if (!xdp)
+			break;
+
+		cur_p->phys = xsk_buff_xdp_get_dma(xdp);
+		cur_p->cntrl = lp->max_frm_size;
+		cur_p->status = 0;
+		cur_p->sw_id_offset = (phys_addr_t)xdp;
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		tail_p = q->rx_bd_p + sizeof(*q->rxq_bd_v) * q->rx_bd_fill;
+		if (++q->rx_bd_fill >= lp->rx_bd_num)
+			q->rx_bd_fill = 0;
+		cur_p = &q->rxq_bd_v[q->rx_bd_fill];
+#else
+		tail_p = q->rx_bd_p + sizeof(*q->rx_bd_v) * q->rx_bd_fill;
+		if (++q->rx_bd_fill >= lp->rx_bd_num)
+			q->rx_bd_fill = 0;
+		cur_p = &q->rx_bd_v[q->rx_bd_fill];
+#endif
+	}
+
+	if (xsk_uses_need_wakeup(pool)) {
+		if (!cur_p->sw_id_offset)
+			xsk_set_rx_need_wakeup(pool);
+		else
+			xsk_clear_rx_need_wakeup(pool);
+	}
+
+	if (!tail_p)
+		return;
+
+	/* Ensure BD write before handing the BDs to the hardware */
+	wmb();
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
+			  q->rx_offset, tail_p);
+#else
+	axienet_dma_bdout(q, XAXIDMA_RX_TDESC_OFFSET, tail_p);
+#endif
+}
+
+/**
+ * axienet_recv_zc - Process the Rx BDs of a queue bound to an AF_XDP socket
+ * @ndev:	Pointer to net_device structure.
+ * @budget:	NAPI budget
+ * @q:		Pointer to axienet DMA queue structure
+ *
+ * Frames are received straight into the umem of the socket. Those the XDP
+ * program passes are copied into an skb, as the umem can not be handed to
+ * the stack.
+ *
+ * Return: Number of BD's processed.
+ */
+static int axienet_recv_zc(struct net_device *ndev, int budget,
+			   struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct bpf_prog *xdp_prog = READ_ONCE(lp->xdp_prog);
+	u32 act = AXIENET_XDP_PASS, xdp_res = 0;
+	unsigned int numbdfree = 0;
+	struct xdp_buff *xdp;
+	struct sk_buff *skb;
+	u32 dropped = 0;
+	u32 packets = 0;
+	u32 size = 0;
+	u32 length;
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+	bool inband_ts = axienet_rx_inband_ts(lp);
+	bool fifo_ts = lp->axienet_config->mactype == XAXIENET_10G_25G ||
+		       lp->axienet_config->mactype == XAXIENET_MRMAC;
+	u64 rx_tstamp = 0;
+#endif
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	struct aximcdma_bd *cur_p;
+#else
+	struct axidma_bd *cur_p;
+#endif
+
+	/* Get relevat BD status value */
+	rmb();
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	cur_p = &q->rxq_bd_v[q->rx_bd_ci];
+#else
+	cur_p = &q->rx_bd_v[q->rx_bd_ci];
+#endif
+
+	while ((numbdfree < budget) &&
+	       (cur_p->status & XAXIDMA_BD_STS_COMPLETE_MASK)) {
+		xdp = (struct xdp_buff *)(cur_p->sw_id_offset);
+
+		if (lp->eth_hasnobuf ||
+		    lp->axienet_config->mactype != XAXIENET_1G)
+			length = cur_p->status & XAXIDMA_BD_STS_ACTUAL_LEN_MASK;
+		else
+			length = cur_p->app4 & 0x0000FFFF;
+
+		xsk_buff_set_size(xdp, length);
+		xsk_buff_dma_sync_for_cpu(xdp, q->xsk_pool);
+
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+		if (inband_ts) {
+			/* Remove the timestamp the MAC puts in front */
+			rx_tstamp = axienet_rx_inband_tstamp(lp, xdp->data);
+			xdp->data += AXIENET_TS_HEADER_LEN;
+			xdp->data_meta = xdp->data;
+		}
+#endif
+		length = xdp->data_end - xdp->data;
+
+		if (xdp_prog)
+			act = axienet_run_xdp(lp, q, xdp_prog, xdp);
+
+		if (act == AXIENET_XDP_PASS) {
+			length = xdp->data_end - xdp->data;
+			skb = napi_alloc_skb(&lp->napi[q->qidx], length);
+			if (likely(skb))
+				skb_put_data(skb, xdp->data, length);
+			xsk_buff_free(xdp);
+		} else {
+			skb = NULL;
+			if (act == AXIENET_XDP_CONSUMED)
+				xsk_buff_free(xdp);
+			xdp_res |= act;
+		}
+
+		if (skb) {
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+			if (inband_ts)
+				skb_hwtstamps(skb)->hwtstamp =
+					ns_to_ktime(rx_tstamp);
+			else if (fifo_ts)
+				axienet_rx_hwtstamp(lp, skb);
+#endif
+			skb->protocol = eth_type_trans(skb, ndev);
+			axienet_rx_csum(lp, skb, cur_p);
+			netif_receive_skb(skb);
+		} else {
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+			if (fifo_ts)
+				axienet_rx_hwtstamp(lp, NULL);
+#endif
+			if (act == AXIENET_XDP_PASS)
+				dropped++;
+		}
+
+		if (skb || act != AXIENET_XDP_PASS) {
+			size += length;
+			packets++;
+		}
+
+		cur_p->sw_id_offset = 0;
+		cur_p->status = 0;
+
+		if (++q->rx_bd_ci >= lp->rx_bd_num)
+			q->rx_bd_ci = 0;
+
+		/* Get relevat BD status value */
+		rmb();
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur_p = &q->rxq_bd_v[q->rx_bd_ci];
+#else
+		cur_p = &q->rx_bd_v[q->rx_bd_ci];
+#endif
+		numbdfree++;
+	}
+
+	u64_stats_update_begin(&q->rx_stats.syncp);
+	q->rx_stats.packets += packets;
+	q->rx_stats.bytes += size;
+	q->rx_stats.dropped += dropped;
+	u64_stats_update_end(&q->rx_stats.syncp);
+
+	if (xdp_res & AXIENET_XDP_REDIRECT)
+		xdp_do_flush();
+
+	axienet_rx_zc_refill(q);
+
+	return numbdfree;
+}
+
+/**
+ * axienet_xsk_xmit - Queue the frames of an AF_XDP Tx ring on a Tx BD ring
+ * @q:		Pointer to DMA queue structure bound to an xsk pool
+ * @budget:	Maximum number of frames to queue
+ *
+ * Return: true if the Tx ring of the socket was drained, false if it may
+ *	   still hold frames.
+ */
+static bool axienet_xsk_xmit(struct axienet_dma_q *q, int budget)
+{
+	struct axienet_local *lp = q->lp;
+	struct xsk_buff_pool *pool = q->xsk_pool;
+	struct xdp_desc desc;
+	unsigned long flags;
+	dma_addr_t dma;
+	int sent = 0;
+	u32 len;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	struct aximcdma_bd *cur_p;
+#else
+	struct axidma_bd *cur_p;
+#endif
+
+	spin_lock_irqsave(&q->tx_lock, flags);
+	while (sent < budget) {
+		if (axienet_check_tx_bd_space(q, 0))
+			break;
+		if (!xsk_tx_peek_desc(pool, &desc))
+			break;
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur_p = &q->txq_bd_v[q->tx_bd_tail];
+#else
+		cur_p = &q->tx_bd_v[q->tx_bd_tail];
+#endif
+		len = desc.len;
+		/* XXV MAC and MRMAC do not pad small frames. The padding is
+		 * taken from the umem chunk the frame sits in.
+		 */
+		if ((lp->axienet_config->mactype == XAXIENET_10G_25G ||
+		     lp->axienet_config->mactype == XAXIENET_MRMAC) &&
+		    len < ETH_ZLEN)
+			len = ETH_ZLEN;
+
+		dma = xsk_buff_raw_get_dma(pool, desc.addr);
+		if (!q->eth_hasdre && (dma & 0x3) && len <= XAE_MAX_PKT_LEN) {
+			memcpy(axienet_tx_buf(q, q->tx_bd_tail),
+			       xsk_buff_raw_get_data(pool, desc.addr), len);
+			dma = axienet_tx_buf_dma(q, q->tx_bd_tail);
+		} else {
+			xsk_buff_raw_dma_sync_for_device(pool, dma, len);
+		}
+
+		cur_p->phys = dma;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur_p->cntrl = len | XMCDMA_BD_CTRL_TXSOF_MASK |
+			       XMCDMA_BD_CTRL_TXEOF_MASK;
+#else
+		cur_p->cntrl = len | XAXIDMA_BD_CTRL_TXSOF_MASK |
+			       XAXIDMA_BD_CTRL_TXEOF_MASK;
+#endif
+		cur_p->tx_desc_mapping = DESC_DMA_MAP_XSK;
+		cur_p->tx_skb = 0;
+
+		if (++q->tx_bd_tail >= lp->tx_bd_num)
+			q->tx_bd_tail = 0;
+		sent++;
+	}
+
+	if (sent) {
+		axienet_tx_kick(q);
+		xsk_tx_release(pool);
+	}
+	spin_unlock_irqrestore(&q->tx_lock, flags);
+
+	if (xsk_uses_need_wakeup(pool))
+		xsk_set_tx_need_wakeup(pool);
+
+	return sent < budget;
+}
+
+/**
+ * axienet_coalesce_cr - Coalesce and delay fields of a DMA channel CR
+ * @lp:		Pointer to axienet local structure
+ * @count:	Number of frames per interrupt
+ * @usec:	Delay timeout in microseconds, used if @count is above 1
+ *
+ * The fields are at the same place in the AXI DMA and MCDMA channel CRs.
+ *
+ * Return: The CR bits within XAXIDMA_COALESCE_MASK | XAXIDMA_DELAY_MASK.
+ */
+static u32 axienet_coalesce_cr(struct axienet_local *lp, u32 count, u32 usec)
+{
+	u32 cr;
+
+	count = clamp_t(u32, count, 1, XAXIDMA_COALESCE_MASK >>
+				       XAXIDMA_COALESCE_SHIFT);
+	cr = count << XAXIDMA_COALESCE_SHIFT;
+	if (count > 1)
+		cr |= axienet_usec_to_timer(lp, usec) << XAXIDMA_DELAY_SHIFT;
+
+	return cr;
+}
+
+/**
+ * axienet_rx_dim_work - Apply the Rx moderation chosen by net DIM
+ * @work:	Work item of the Rx DIM state of a queue
+ *
+ * The CR is only written from the NAPI poll of the queue, which owns it
+ * while the channel interrupts are masked.
+ */
+static void axienet_rx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct axienet_dma_q *q = container_of(dim, struct axienet_dma_q,
+					       rx_dim);
+	struct dim_cq_moder moder;
+
+	moder = net_dim_get_rx_moderation(dim->mode, dim->profile_ix);
+	q->rx_dim_cr = axienet_coalesce_cr(q->lp, moder.pkts, moder.usec);
+	smp_store_release(&q->rx_dim_pending, true);
+
+	dim->state = DIM_START_MEASURE;
+}
+
+/**
+ * axienet_tx_dim_work - Apply the Tx moderation chosen by net DIM
+ * @work:	Work item of the Tx DIM state of a queue
+ */
+static void axienet_tx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct axienet_dma_q *q = container_of(dim, struct axienet_dma_q,
+					       tx_dim);
+	struct dim_cq_moder moder;
+
+	moder = net_dim_get_tx_moderation(dim->mode, dim->profile_ix);
+	q->tx_dim_cr = axienet_coalesce_cr(q->lp, moder.pkts, moder.usec);
+	smp_store_release(&q->tx_dim_pending, true);
 
-			size += length;
-			packets++;
-		}
+	dim->state = DIM_START_MEASURE;
+}
 
-		/* Ensure that the skb is completely updated
-		 * prio to mapping the DMA
-		 */
-		wmb();
+/**
+ * axienet_dim_update - Feed the traffic of a queue to net DIM
+ * @q:		Pointer to DMA queue structure
+ * @has_tx:	Whether the queue has a Tx channel
+ */
+static void axienet_dim_update(struct axienet_dma_q *q, bool has_tx)
+{
+	struct axienet_local *lp = q->lp;
+	struct dim_sample sample;
 
-		cur_p->phys = dma_map_single(ndev->dev.parent, new_skb->data,
-					     lp->max_frm_size,
-					     DMA_FROM_DEVICE);
-		if (unlikely(dma_mapping_error(ndev->dev.parent, cur_p->phys))) {
-			cur_p->phys = 0;
-			dev_kfree_skb(new_skb);
-			dev_err(lp->dev, "RX buffer map failed\n");
-			break;
-		}
-		cur_p->cntrl = lp->max_frm_size;
-		cur_p->status = 0;
-		cur_p->sw_id_offset = (phys_addr_t)new_skb;
+	q->dim_events++;
 
-		if (++q->rx_bd_ci >= lp->rx_bd_num)
-			q->rx_bd_ci = 0;
+	if (lp->rx_dim_enabled) {
+		dim_update_sample(q->dim_events, q->rx_stats.packets,
+				  q->rx_stats.bytes, &sample);
+		net_dim(&q->rx_dim, sample);
+	}
 
-		/* Get relevat BD status value */
-		rmb();
-#ifdef CONFIG_AXIENET_HAS_MCDMA
-		cur_p = &q->rxq_bd_v[q->rx_bd_ci];
-#else
-		cur_p = &q->rx_bd_v[q->rx_bd_ci];
-#endif
-		numbdfree++;
+	if (has_tx && lp->tx_dim_enabled) {
+		dim_update_sample(q->dim_events, q->tx_stats.packets,
+				  q->tx_stats.bytes, &sample);
+		net_dim(&q->tx_dim, sample);
 	}
+}
 
-	ndev->stats.rx_packets += packets;
-	ndev->stats.rx_bytes += size;
-	q->rx_packets += packets;
-	q->rx_bytes += size;
+/**
+ * axienet_dim_cr - Apply a pending DIM moderation to a channel CR value
+ * @cr:		Current value of the channel CR
+ * @dim_cr:	Fields chosen by net DIM
+ * @pending:	Pending flag of @dim_cr, cleared here
+ *
+ * Return: The value to write back to the channel CR.
+ */
+static u32 axienet_dim_cr(u32 cr, u32 dim_cr, bool *pending)
+{
+	if (!smp_load_acquire(pending))
+		return cr;
 
-	if (tail_p) {
-#ifdef CONFIG_AXIENET_HAS_MCDMA
-		axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
-				  q->rx_offset, tail_p);
-#else
-		axienet_dma_bdout(q, XAXIDMA_RX_TDESC_OFFSET, tail_p);
-#endif
-	}
+	*pending = false;
 
-	return numbdfree;
+	return (cr & ~(XAXIDMA_COALESCE_MASK | XAXIDMA_DELAY_MASK)) | dim_cr;
 }
 
 /**
@@ -1618,7 +3229,9 @@ static int axienet_recv(struct net_device *ndev, int budget,
  * @quota:	Max number of rx packets to be processed.
  *
  * This is the poll routine for rx part.
- * It will process the packets maximux quota value.
+ * It will process the packets maximux quota value. Completed Tx BDs of the
+ * queue are reclaimed here as well, outside of the quota, and the Tx ring of
+ * an AF_XDP socket bound to the queue is serviced.
  *
  * Return: number of packets received
  */
@@ -1631,6 +3244,10 @@ int xaxienet_rx_poll(struct napi_struct *napi, int quota)
 	int map = napi - lp->napi;
 
 	struct axienet_dma_q *q = lp->dq[map];
+	bool has_tx = map < lp->num_tx_queues;
+
+	if (has_tx)
+		axienet_start_xmit_done(ndev, q);
 
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 	spin_lock(&q->rx_lock);
@@ -1644,7 +3261,15 @@ int xaxienet_rx_poll(struct napi_struct *napi, int quota)
 			dev_err(lp->dev, "Rx error 0x%x\n\r", status);
 			break;
 		}
-		work_done += axienet_recv(lp->ndev, quota - work_done, q);
+		if (q->xsk_pool)
+			work_done += axienet_recv_zc(lp->ndev,
+						     quota - work_done, q);
+		else if (axienet_rx_scatter(lp))
+			work_done += axienet_recv_sg(lp->ndev,
+						     quota - work_done, q);
+		else
+			work_done += axienet_recv(lp->ndev,
+						  quota - work_done, q);
 		status = axienet_dma_in32(q, XMCDMA_CHAN_SR_OFFSET(q->chan_id) +
 					  q->rx_offset);
 	}
@@ -1660,26 +3285,54 @@ int xaxienet_rx_poll(struct napi_struct *napi, int quota)
 			dev_err(lp->dev, "Rx error 0x%x\n\r", status);
 			break;
 		}
-		work_done += axienet_recv(lp->ndev, quota - work_done, q);
+		if (q->xsk_pool)
+			work_done += axienet_recv_zc(lp->ndev,
+						     quota - work_done, q);
+		else if (axienet_rx_scatter(lp))
+			work_done += axienet_recv_sg(lp->ndev,
+						     quota - work_done, q);
+		else
+			work_done += axienet_recv(lp->ndev,
+						  quota - work_done, q);
 		status = axienet_dma_in32(q, XAXIDMA_RX_SR_OFFSET);
 	}
 	spin_unlock(&q->rx_lock);
 #endif
 
+	/* Keep polling while the socket has frames the Tx ring could not take */
+	if (has_tx && q->xsk_pool && !axienet_xsk_xmit(q, quota))
+		work_done = quota;
+
 	if (work_done < quota) {
 		napi_complete(napi);
+		axienet_dim_update(q, has_tx);
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 		/* Enable the interrupts again */
 		cr = axienet_dma_in32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id) +
 				      XMCDMA_RX_OFFSET);
+		cr = axienet_dim_cr(cr, q->rx_dim_cr, &q->rx_dim_pending);
 		cr |= (XMCDMA_IRQ_IOC_MASK | XMCDMA_IRQ_DELAY_MASK);
 		axienet_dma_out32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id) +
 				  XMCDMA_RX_OFFSET, cr);
+		if (has_tx) {
+			cr = axienet_dma_in32(q,
+					      XMCDMA_CHAN_CR_OFFSET(q->chan_id));
+			cr = axienet_dim_cr(cr, q->tx_dim_cr,
+					    &q->tx_dim_pending);
+			cr |= (XMCDMA_IRQ_IOC_MASK | XMCDMA_IRQ_DELAY_MASK);
+			axienet_dma_out32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id),
+					  cr);
+		}
 #else
 		/* Enable the interrupts again */
 		cr = axienet_dma_in32(q, XAXIDMA_RX_CR_OFFSET);
+		cr = axienet_dim_cr(cr, q->rx_dim_cr, &q->rx_dim_pending);
 		cr |= (XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_DELAY_MASK);
 		axienet_dma_out32(q, XAXIDMA_RX_CR_OFFSET, cr);
+		cr = axienet_dma_in32(q, XAXIDMA_TX_CR_OFFSET);
+		cr = axienet_dim_cr(cr, q->tx_dim_cr, &q->tx_dim_pending);
+		cr |= (XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_DELAY_MASK);
+		axienet_dma_out32(q, XAXIDMA_TX_CR_OFFSET, cr);
 #endif
 	}
 
@@ -1715,6 +3368,53 @@ static irqreturn_t axienet_eth_irq(int irq, void *_ndev)
 	return IRQ_HANDLED;
 }
 
+/**
+ * axienet_queue_cpu - CPU servicing a DMA queue
+ * @lp:		Pointer to axienet local structure
+ * @i:		Index of the queue
+ *
+ * Queues are spread over the online CPUs, those local to the device first.
+ *
+ * Return: The CPU the interrupts and Tx traffic of queue @i are steered to.
+ */
+static inline unsigned int axienet_queue_cpu(struct axienet_local *lp, int i)
+{
+	return cpumask_local_spread(i, dev_to_node(lp->dev));
+}
+
+/**
+ * axienet_set_queue_affinity - Steer the DMA queues to their CPUs
+ * @lp:		Pointer to axienet local structure
+ * @set:	Set the affinity hints and XPS maps, or clear the hints
+ *
+ * The Rx and Tx interrupts of a queue share its NAPI context, so both are
+ * hinted to the same CPU, and that CPU transmits on the queue with XPS.
+ * The hints must be cleared before the interrupts are freed.
+ */
+static void axienet_set_queue_affinity(struct axienet_local *lp, bool set)
+{
+	struct axienet_dma_q *q;
+	const struct cpumask *mask;
+	int i, ret;
+
+	for_each_rx_dma_queue(lp, i) {
+		q = lp->dq[i];
+		mask = set ? cpumask_of(axienet_queue_cpu(lp, i)) : NULL;
+
+		irq_set_affinity_hint(q->rx_irq, mask);
+		if (i >= lp->num_tx_queues)
+			continue;
+		irq_set_affinity_hint(q->tx_irq, mask);
+		if (!set)
+			continue;
+
+		ret = netif_set_xps_queue(lp->ndev, mask, i);
+		if (ret)
+			netdev_warn(lp->ndev, "Failed to set XPS map of txq%d: %d\n",
+				    i, ret);
+	}
+}
+
 /**
  * axienet_open - Driver open routine.
  * @ndev:	Pointer to net_device structure
@@ -1749,11 +3449,19 @@ static int axienet_open(struct net_device *ndev)
 		return ret;
 	}
 
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+	ret = axienet_txts_start(lp);
+	if (ret) {
+		dev_err(lp->dev, "Tx timestamp worker failed: %d\n", ret);
+		return ret;
+	}
+#endif
+
 	if (lp->phylink) {
 		ret = phylink_of_phy_connect(lp->phylink, lp->dev->of_node, 0);
 		if (ret) {
 			dev_err(lp->dev, "phylink_of_phy_connect() failed: %d\n", ret);
-			return ret;
+			goto err_phy;
 		}
 
 		phylink_start(lp->phylink);
@@ -1771,6 +3479,13 @@ static int axienet_open(struct net_device *ndev)
 			     (unsigned long)lp->dq[i]);
 #endif
 
+		INIT_WORK(&lp->dq[i]->rx_dim.work, axienet_rx_dim_work);
+		INIT_WORK(&lp->dq[i]->tx_dim.work, axienet_tx_dim_work);
+		lp->dq[i]->rx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
+		lp->dq[i]->tx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
+		lp->dq[i]->rx_dim_pending = false;
+		lp->dq[i]->tx_dim_pending = false;
+
 		/* Enable NAPI scheduling before enabling Axi DMA Rx IRQ, or you
 		 * might run into a race condition; the RX ISR disables IRQ processing
 		 * before scheduling the NAPI function to complete the processing.
@@ -1930,6 +3645,8 @@ static int axienet_open(struct net_device *ndev)
 			goto err_eth_irq;
 	}
 
+	axienet_set_queue_affinity(lp, true);
+
 	netif_tx_start_all_queues(ndev);
 	return 0;
 
@@ -1954,6 +3671,10 @@ static int axienet_open(struct net_device *ndev)
 	for_each_rx_dma_queue(lp, i)
 		tasklet_kill(&lp->dma_err_tasklet[i]);
 	dev_err(lp->dev, "request_irq() failed\n");
+err_phy:
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+	axienet_txts_stop(lp);
+#endif
 	return ret;
 }
 
@@ -1985,6 +3706,8 @@ static int axienet_stop(struct net_device *ndev)
 	lp->axienet_config->setoptions(ndev, lp->options &
 			   ~(XAE_OPTION_TXEN | XAE_OPTION_RXEN));
 
+	axienet_set_queue_affinity(lp, false);
+
 	for_each_tx_dma_queue(lp, i) {
 		q = lp->dq[i];
 		cr = axienet_dma_in32(q, XAXIDMA_RX_CR_OFFSET);
@@ -2021,6 +3744,8 @@ static int axienet_stop(struct net_device *ndev)
 		q = lp->dq[i];
 		netif_stop_queue(ndev);
 		napi_disable(&lp->napi[i]);
+		cancel_work_sync(&q->rx_dim.work);
+		cancel_work_sync(&q->tx_dim.work);
 		tasklet_kill(&lp->dma_err_tasklet[i]);
 		free_irq(q->rx_irq, ndev);
 	}
@@ -2028,6 +3753,12 @@ static int axienet_stop(struct net_device *ndev)
 	if (lp->axienet_config->mactype == XAXIENET_1G && !lp->eth_hasnobuf)
 		free_irq(lp->eth_irq, ndev);
 
+	for_each_tx_dma_queue(lp, i)
+		axienet_tx_bd_clean(ndev, lp->dq[i]);
+
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+	axienet_txts_stop(lp);
+#endif
 	axienet_dma_bd_release(ndev);
 	return 0;
 }
@@ -2244,16 +3975,184 @@ static int axienet_ioctl(struct net_device *dev, struct ifreq *rq, int cmd)
 	}
 }
 
+/**
+ * axienet_xdp_setup - Attach or detach an XDP program
+ * @ndev:	Pointer to net_device structure
+ * @bpf:	XDP command data
+ *
+ * The Rx page pools are only mapped bidirectionally while a program is
+ * attached, so a running interface is restarted when the first program is
+ * attached or the last one removed.
+ *
+ * Return: Always returns 0 (success).
+ */
+static int axienet_xdp_setup(struct net_device *ndev, struct netdev_bpf *bpf)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct bpf_prog *old_prog;
+	bool need_reset;
+
+	need_reset = netif_running(ndev) && !!lp->xdp_prog != !!bpf->prog;
+	if (need_reset)
+		axienet_stop(ndev);
+
+	old_prog = xchg(&lp->xdp_prog, bpf->prog);
+	if (old_prog)
+		bpf_prog_put(old_prog);
+
+	if (need_reset && axienet_open(ndev))
+		netdev_err(ndev, "failed to restart after XDP change\n");
+
+	return 0;
+}
+
+/**
+ * axienet_xsk_pool_setup - Bind or unbind an AF_XDP buffer pool to a queue
+ * @ndev:	Pointer to net_device structure
+ * @pool:	Pool to bind, NULL to unbind the current one
+ * @qid:	Index of the queue, which must have both an Rx and a Tx ring
+ *
+ * The Rx ring of the queue is refilled from a different source once the pool
+ * changes, so a running interface is restarted.
+ *
+ * Return: 0 on success, Negative value on errors
+ */
+static int axienet_xsk_pool_setup(struct net_device *ndev,
+				  struct xsk_buff_pool *pool, u16 qid)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	bool running = netif_running(ndev);
+	struct xsk_buff_pool *old_pool;
+	int ret;
+
+	if (qid >= lp->num_rx_queues || qid >= lp->num_tx_queues)
+		return -EINVAL;
+
+	if (pool) {
+		/* Every frame must fit in a single BD */
+		if (xsk_pool_get_rx_frame_size(pool) < lp->max_frm_size)
+			return -EINVAL;
+
+		ret = xsk_pool_dma_map(pool, ndev->dev.parent, 0);
+		if (ret)
+			return ret;
+	} else if (!lp->dq[qid]->xsk_pool) {
+		return -EINVAL;
+	}
+
+	if (running)
+		axienet_stop(ndev);
+
+	old_pool = lp->dq[qid]->xsk_pool;
+	lp->dq[qid]->xsk_pool = pool;
+	if (old_pool)
+		xsk_pool_dma_unmap(old_pool, 0);
+
+	if (running && axienet_open(ndev))
+		netdev_err(ndev, "failed to restart after AF_XDP change\n");
+
+	return 0;
+}
+
+/**
+ * axienet_xsk_wakeup - Driver ndo_xsk_wakeup routine
+ * @ndev:	Pointer to net_device structure
+ * @qid:	Index of the queue the socket is bound to
+ * @flags:	XDP_WAKEUP_* flags
+ *
+ * Both rings of the socket are serviced from the NAPI poll of the queue.
+ *
+ * Return: 0 on success, Negative value on errors
+ */
+static int axienet_xsk_wakeup(struct net_device *ndev, u32 qid, u32 flags)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	if (!netif_running(ndev))
+		return -ENETDOWN;
+
+	if (qid >= lp->num_rx_queues || qid >= lp->num_tx_queues ||
+	    !lp->dq[qid]->xsk_pool)
+		return -EINVAL;
+
+	if (!napi_if_scheduled_mark_missed(&lp->napi[qid]))
+		napi_schedule(&lp->napi[qid]);
+
+	return 0;
+}
+
+/**
+ * axienet_get_stats64 - Driver ndo_get_stats64 routine
+ * @ndev:	Pointer to net_device structure
+ * @stats:	Statistics to fill
+ *
+ * The traffic and drop counters are kept per DMA queue, the error counters
+ * updated by the interrupt handlers in ndev->stats.
+ */
+static void axienet_get_stats64(struct net_device *ndev,
+				struct rtnl_link_stats64 *stats)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct axienet_xmit_stats xmit_stats;
+	struct axienet_tx_stats tx_stats;
+	struct axienet_rx_stats rx_stats;
+	int i;
+
+	netdev_stats_to_stats64(stats, &ndev->stats);
+
+	for_each_rx_dma_queue(lp, i) {
+		axienet_read_rx_stats(lp->dq[i], &rx_stats);
+		stats->rx_packets += rx_stats.packets;
+		stats->rx_bytes += rx_stats.bytes;
+		stats->rx_dropped += rx_stats.dropped;
+	}
+
+	for_each_tx_dma_queue(lp, i) {
+		axienet_read_tx_stats(lp->dq[i], &tx_stats, &xmit_stats);
+		stats->tx_packets += tx_stats.packets;
+		stats->tx_bytes += tx_stats.bytes;
+		stats->tx_dropped += xmit_stats.dropped;
+	}
+}
+
+/**
+ * axienet_bpf - Driver ndo_bpf routine
+ * @ndev:	Pointer to net_device structure
+ * @bpf:	BPF command data
+ *
+ * Return: 0 on success, Negative value on errors
+ */
+static int axienet_bpf(struct net_device *ndev, struct netdev_bpf *bpf)
+{
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		return axienet_xdp_setup(ndev, bpf);
+	case XDP_SETUP_XSK_POOL:
+		return axienet_xsk_pool_setup(ndev, bpf->xsk.pool,
+					      bpf->xsk.queue_id);
+	default:
+		return -EINVAL;
+	}
+}
+
 static const struct net_device_ops axienet_netdev_ops = {
 	.ndo_open = axienet_open,
 	.ndo_stop = axienet_stop,
 	.ndo_start_xmit = axienet_start_xmit,
+	.ndo_features_check = axienet_features_check,
+	.ndo_get_stats64 = axienet_get_stats64,
 	.ndo_change_mtu	= axienet_change_mtu,
 	.ndo_set_mac_address = netdev_set_mac_address,
 	.ndo_validate_addr = eth_validate_addr,
 	.ndo_eth_ioctl = axienet_ioctl,
 	.ndo_set_rx_mode = axienet_set_multicast_list,
 	.ndo_do_ioctl = axienet_ioctl,
+	.ndo_bpf = axienet_bpf,
+	.ndo_xdp_xmit = axienet_xdp_xmit,
+	.ndo_xsk_wakeup = axienet_xsk_wakeup,
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	.ndo_setup_tc = axienet_mcdma_setup_tc,
+#endif
 #ifdef CONFIG_NET_POLL_CONTROLLER
 	.ndo_poll_controller = axienet_poll_controller,
 #endif
@@ -2478,6 +4377,8 @@ axienet_ethtools_get_coalesce(struct net_device *ndev,
 						     >> XAXIDMA_COALESCE_SHIFT;
 		ecoalesce->tx_coalesce_usecs = lp->coalesce_usec_tx;
 	}
+	ecoalesce->use_adaptive_rx_coalesce = lp->rx_dim_enabled;
+	ecoalesce->use_adaptive_tx_coalesce = lp->tx_dim_enabled;
 	return 0;
 }
 
@@ -2516,6 +4417,8 @@ axienet_ethtools_set_coalesce(struct net_device *ndev,
 		lp->coalesce_count_tx = ecoalesce->tx_max_coalesced_frames;
 	if (ecoalesce->tx_coalesce_usecs)
 		lp->coalesce_usec_tx = ecoalesce->tx_coalesce_usecs;
+	lp->rx_dim_enabled = !!ecoalesce->use_adaptive_rx_coalesce;
+	lp->tx_dim_enabled = !!ecoalesce->use_adaptive_tx_coalesce;
 
 	return 0;
 }
@@ -2578,6 +4481,25 @@ static int axienet_ethtools_get_ts_info(struct net_device *ndev,
 }
 #endif
 
+/**
+ * axienet_q_stats_base - Index of the first per queue driver statistic
+ * @lp:		Pointer to axienet local structure
+ *
+ * The per queue drop, ring full and bounce counters follow the counters of
+ * the device and, with MCDMA, the per queue packet and byte counters.
+ *
+ * Return: Index of the "txq0_dropped" statistic.
+ */
+static unsigned int axienet_q_stats_base(struct axienet_local *lp)
+{
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	return AXIENET_ETHTOOLS_SSTATS_LEN + AXIENET_TX_SSTATS_LEN(lp) +
+	       AXIENET_RX_SSTATS_LEN(lp);
+#else
+	return AXIENET_ETHTOOLS_SSTATS_LEN;
+#endif
+}
+
 /**
  * axienet_ethtools_sset_count - Get number of strings that
  *				 get_strings will write.
@@ -2589,13 +4511,13 @@ static int axienet_ethtools_get_ts_info(struct net_device *ndev,
  */
 int axienet_ethtools_sset_count(struct net_device *ndev, int sset)
 {
+	struct axienet_local *lp = netdev_priv(ndev);
+
 	switch (sset) {
 	case ETH_SS_STATS:
-#ifdef CONFIG_AXIENET_HAS_MCDMA
-		return axienet_sset_count(ndev, sset);
-#else
-		return AXIENET_ETHTOOLS_SSTATS_LEN;
-#endif
+		return axienet_q_stats_base(lp) + AXIENET_Q_SSTATS_LEN(lp);
+	case ETH_SS_TEST:
+		return axienet_selftest_count(lp);
 	default:
 		return -EOPNOTSUPP;
 	}
@@ -2614,18 +4536,37 @@ void axienet_ethtools_get_stats(struct net_device *ndev,
 				struct ethtool_stats *stats,
 				u64 *data)
 {
-	unsigned int i = 0;
-
-	data[i++] = ndev->stats.tx_packets;
-	data[i++] = ndev->stats.rx_packets;
-	data[i++] = ndev->stats.tx_bytes;
-	data[i++] = ndev->stats.rx_bytes;
-	data[i++] = ndev->stats.tx_errors;
-	data[i++] = ndev->stats.rx_missed_errors + ndev->stats.rx_frame_errors;
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct axienet_xmit_stats xmit_stats;
+	struct axienet_tx_stats tx_stats;
+	struct axienet_rx_stats rx_stats;
+	struct rtnl_link_stats64 s64;
+	unsigned int i = 0, j;
+
+	axienet_get_stats64(ndev, &s64);
+	data[i++] = s64.tx_packets;
+	data[i++] = s64.rx_packets;
+	data[i++] = s64.tx_bytes;
+	data[i++] = s64.rx_bytes;
+	data[i++] = s64.tx_errors;
+	data[i++] = s64.rx_missed_errors + s64.rx_frame_errors;
 
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 	axienet_get_stats(ndev, stats, data);
 #endif
+
+	i = axienet_q_stats_base(lp);
+	for_each_tx_dma_queue(lp, j) {
+		axienet_read_tx_stats(lp->dq[j], &tx_stats, &xmit_stats);
+		data[i++] = xmit_stats.dropped;
+		data[i++] = xmit_stats.ring_full;
+		data[i++] = xmit_stats.bounced_bytes;
+	}
+	for_each_rx_dma_queue(lp, j) {
+		axienet_read_rx_stats(lp->dq[j], &rx_stats);
+		data[i++] = rx_stats.dropped;
+		data[i++] = rx_stats.alloc_failed;
+	}
 }
 
 /**
@@ -2639,7 +4580,13 @@ void axienet_ethtools_get_stats(struct net_device *ndev,
  */
 void axienet_ethtools_strings(struct net_device *ndev, u32 sset, u8 *data)
 {
-	int i;
+	struct axienet_local *lp = netdev_priv(ndev);
+	int i, j;
+
+	if (sset == ETH_SS_TEST) {
+		axienet_selftest_strings(lp, data);
+		return;
+	}
 
 	for (i = 0; i < AXIENET_ETHTOOLS_SSTATS_LEN; i++) {
 		if (sset == ETH_SS_STATS)
@@ -2650,11 +4597,115 @@ void axienet_ethtools_strings(struct net_device *ndev, u32 sset, u8 *data)
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 	axienet_strings(ndev, sset, data);
 #endif
+
+	if (sset != ETH_SS_STATS)
+		return;
+
+	i = axienet_q_stats_base(lp);
+	for_each_tx_dma_queue(lp, j) {
+		snprintf(data + i++ * ETH_GSTRING_LEN, ETH_GSTRING_LEN,
+			 "txq%d_dropped", j);
+		snprintf(data + i++ * ETH_GSTRING_LEN, ETH_GSTRING_LEN,
+			 "txq%d_ring_full", j);
+		snprintf(data + i++ * ETH_GSTRING_LEN, ETH_GSTRING_LEN,
+			 "txq%d_bounced_bytes", j);
+	}
+	for_each_rx_dma_queue(lp, j) {
+		snprintf(data + i++ * ETH_GSTRING_LEN, ETH_GSTRING_LEN,
+			 "rxq%d_dropped", j);
+		snprintf(data + i++ * ETH_GSTRING_LEN, ETH_GSTRING_LEN,
+			 "rxq%d_alloc_failed", j);
+	}
+}
+
+/**
+ * axienet_ethtools_get_channels - Get the number of DMA queues
+ * @ndev:	Pointer to net_device structure
+ * @ch:		Pointer to ethtool_channels structure
+ *
+ * Each Tx queue shares its DMA queue, NAPI context and CPU with an Rx queue.
+ * Issue "ethtool -l ethX" under linux prompt to execute this function.
+ */
+static void axienet_ethtools_get_channels(struct net_device *ndev,
+					  struct ethtool_channels *ch)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	ch->max_combined = lp->num_tx_queues;
+	ch->max_rx = lp->num_rx_queues - lp->num_tx_queues;
+	ch->combined_count = lp->num_tx_queues;
+	ch->rx_count = lp->num_rx_queues - lp->num_tx_queues;
+}
+
+/**
+ * axienet_ethtools_get_rxnfc - Get Rx flow classification information
+ * @ndev:	Pointer to net_device structure
+ * @cmd:	Pointer to ethtool_rxnfc structure
+ * @rule_locs:	Unused, no classification rules can be inserted
+ *
+ * Rx frames are not hashed by the MAC; the MCDMA picks the channel from the
+ * TDEST of the stream. So no header field contributes to the Rx flow hash.
+ *
+ * Return: 0, on success. -EOPNOTSUPP for other commands.
+ */
+static int axienet_ethtools_get_rxnfc(struct net_device *ndev,
+				      struct ethtool_rxnfc *cmd,
+				      u32 *rule_locs)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	switch (cmd->cmd) {
+	case ETHTOOL_GRXRINGS:
+		cmd->data = lp->num_rx_queues;
+		return 0;
+	case ETHTOOL_GRXFH:
+		cmd->data = 0;
+		return 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+static u32 axienet_ethtools_get_rxfh_indir_size(struct net_device *ndev)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	return lp->num_rx_queues;
+}
+
+/**
+ * axienet_ethtools_get_rxfh - Get the Rx flow indirection table
+ * @ndev:	Pointer to net_device structure
+ * @indir:	Indirection table to fill, if not NULL
+ * @key:	Unused, there is no hash key
+ * @hfunc:	Hash function, if not NULL
+ *
+ * Entry i is the Rx queue fed by TDEST i, which the MCDMA maps one to one on
+ * its S2MM channels. Issue "ethtool -x ethX" under linux prompt to execute
+ * this function.
+ *
+ * Return: 0 always.
+ */
+static int axienet_ethtools_get_rxfh(struct net_device *ndev, u32 *indir,
+				     u8 *key, u8 *hfunc)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	int i;
+
+	if (hfunc)
+		*hfunc = ETH_RSS_HASH_UNKNOWN;
+	if (indir) {
+		for_each_rx_dma_queue(lp, i)
+			indir[i] = i;
+	}
+
+	return 0;
 }
 
 static const struct ethtool_ops axienet_ethtool_ops = {
 	.supported_coalesce_params = ETHTOOL_COALESCE_MAX_FRAMES |
-				     ETHTOOL_COALESCE_USECS,
+				     ETHTOOL_COALESCE_USECS |
+				     ETHTOOL_COALESCE_USE_ADAPTIVE,
 	.get_drvinfo    = axienet_ethtools_get_drvinfo,
 	.get_regs_len   = axienet_ethtools_get_regs_len,
 	.get_regs       = axienet_ethtools_get_regs,
@@ -2671,6 +4722,11 @@ static const struct ethtool_ops axienet_ethtool_ops = {
 	.get_sset_count	= axienet_ethtools_sset_count,
 	.get_ethtool_stats = axienet_ethtools_get_stats,
 	.get_strings = axienet_ethtools_strings,
+	.self_test	= axienet_self_test,
+	.get_channels	= axienet_ethtools_get_channels,
+	.get_rxnfc	= axienet_ethtools_get_rxnfc,
+	.get_rxfh_indir_size = axienet_ethtools_get_rxfh_indir_size,
+	.get_rxfh	= axienet_ethtools_get_rxfh,
 	.get_link_ksettings = axienet_ethtools_get_link_ksettings,
 	.set_link_ksettings = axienet_ethtools_set_link_ksettings,
 	.nway_reset	= axienet_ethtools_nway_reset,
@@ -2696,6 +4752,7 @@ static int __maybe_unused axienet_mcdma_probe(struct platform_device *pdev,
 
 		/* parent */
 		q->lp = lp;
+		q->qidx = i;
 		lp->dq[i] = q;
 		ret = of_property_read_string_index(pdev->dev.of_node,
 						    "xlnx,channel-ids", i,
@@ -2755,6 +4812,7 @@ static int __maybe_unused axienet_dma_probe(struct platform_device *pdev,
 
 		/* parent */
 		q->lp = lp;
+		q->qidx = i;
 
 		lp->dq[i] = q;
 	}
@@ -2801,6 +4859,9 @@ static int __maybe_unused axienet_dma_probe(struct platform_device *pdev,
 
 		spin_lock_init(&q->tx_lock);
 		spin_lock_init(&q->rx_lock);
+		u64_stats_init(&q->rx_stats.syncp);
+		u64_stats_init(&q->tx_stats.syncp);
+		u64_stats_init(&q->xmit_stats.syncp);
 	}
 
 	for_each_rx_dma_queue(lp, i) {
@@ -3472,6 +5533,32 @@ static int axienet_probe(struct platform_device *pdev)
 
 	lp->eth_hasnobuf = of_property_read_bool(pdev->dev.of_node,
 						 "xlnx,eth-hasnobuf");
+
+	ret = of_property_read_u32(pdev->dev.of_node, "xlnx,mcast-extend",
+				   &value);
+	if (!ret && value && lp->axienet_config->mactype == XAXIENET_1G &&
+	    !lp->eth_hasnobuf) {
+		lp->mcast_table = devm_bitmap_zalloc(&pdev->dev,
+						     XAE_MCAST_TABLE_ENTRIES,
+						     GFP_KERNEL);
+		if (!lp->mcast_table) {
+			ret = -ENOMEM;
+			goto cleanup_clk;
+		}
+		lp->features |= XAE_FEATURE_EXT_MCAST;
+	}
+
+	/* Segmentation is done by the driver, it relies on the MAC computing
+	 * the TCP/UDP checksum of every segment.
+	 */
+	if (lp->axienet_config->mactype == XAXIENET_1G && !lp->eth_hasnobuf &&
+	    (lp->features & (XAE_FEATURE_PARTIAL_TX_CSUM |
+			     XAE_FEATURE_FULL_TX_CSUM))) {
+		ndev->hw_features |= NETIF_F_SG | NETIF_F_IP_CSUM |
+				     NETIF_F_TSO | NETIF_F_GSO_UDP_L4;
+		ndev->features |= NETIF_F_TSO | NETIF_F_GSO_UDP_L4;
+		netif_set_tso_max_segs(ndev, XAE_TSO_MAX_SEGS);
+	}
 	lp->eth_hasptp = of_property_read_bool(pdev->dev.of_node,
 					       "xlnx,eth-hasptp");
 
@@ -3602,9 +5689,6 @@ static int axienet_probe(struct platform_device *pdev)
 				ret = PTR_ERR(lp->rx_ts_regs);
 				goto cleanup_clk;
 			}
-			lp->tx_ptpheader = devm_kzalloc(&pdev->dev,
-							lp->axienet_config->ts_header_len,
-							GFP_KERNEL);
 			spin_lock_init(&lp->ptp_tx_lock);
 	}
 
@@ -3790,6 +5874,7 @@ static int axienet_remove(struct platform_device *pdev)
 	axeinet_mcdma_remove_sysfs(&lp->dev->kobj);
 #endif
 
+	kfree(rcu_access_pointer(lp->mc_filter));
 	free_netdev(ndev);
 
 	return 0;
@@ -14,12 +14,15 @@
  * This file contains helper functions for AXI MCDMA TX and RX programming.
  */
 
+#include <linux/ethtool.h>
 #include <linux/module.h>
 #include <linux/of_mdio.h>
 #include <linux/of_platform.h>
 #include <linux/of_irq.h>
 #include <linux/of_address.h>
 #include <linux/of_net.h>
+#include <net/pkt_cls.h>
+#include <net/pkt_sched.h>
 
 #include "xilinx_axienet.h"
 
@@ -122,6 +125,13 @@ void __maybe_unused axienet_mcdma_tx_bd_free(struct net_device *ndev,
 				  q->tx_bufs,
 				  q->tx_bufs_dma);
 	}
+	if (q->tso_hdrs) {
+		dma_free_coherent(ndev->dev.parent,
+				  TSO_HEADER_SIZE * lp->tx_bd_num,
+				  q->tso_hdrs,
+				  q->tso_hdrs_dma);
+		q->tso_hdrs = NULL;
+	}
 }
 
 /**
@@ -138,22 +148,47 @@ void __maybe_unused axienet_mcdma_rx_bd_free(struct net_device *ndev,
 	int i;
 	struct axienet_local *lp = netdev_priv(ndev);
 
-	if (!q->rxq_bd_v)
-		return;
+	if (q->rxq_bd_v) {
+		for (i = 0; i < lp->rx_bd_num; i++)
+			axienet_rx_buf_free(q, (void *)
+					    (q->rxq_bd_v[i].sw_id_offset));
 
-	for (i = 0; i < lp->rx_bd_num; i++) {
-		if (q->rxq_bd_v[i].phys)
-			dma_unmap_single(ndev->dev.parent, q->rxq_bd_v[i].phys,
-					 lp->max_frm_size, DMA_FROM_DEVICE);
-		dev_kfree_skb((struct sk_buff *)
-			      (q->rxq_bd_v[i].sw_id_offset));
+		dma_free_coherent(ndev->dev.parent,
+				  sizeof(*q->rxq_bd_v) * lp->rx_bd_num,
+				  q->rxq_bd_v,
+				  q->rx_bd_p);
+		q->rxq_bd_v = NULL;
 	}
+	dev_kfree_skb(q->rx_skb);
+	q->rx_skb = NULL;
+	axienet_rx_page_pool_destroy(q);
+}
+
+/**
+ * axienet_mcdma_set_tx_weight - Set the WRR weight of an MCDMA Tx channel
+ * @q:		Pointer to a DMA queue structure, for the register access
+ * @slot:	Weight slot of the channel, its channel id minus one
+ * @weight:	Weight of the channel, up to XMCDMA_TXWEIGHT_MAX
+ *
+ * Return: The previous weight of the channel
+ */
+static u8 axienet_mcdma_set_tx_weight(struct axienet_dma_q *q, u16 slot,
+				      u8 weight)
+{
+	u32 offset = slot < 8 ? XMCDMA_TXWEIGHT0_OFFSET :
+				XMCDMA_TXWEIGHT1_OFFSET;
+	u32 val;
+	u8 old;
 
-	dma_free_coherent(ndev->dev.parent,
-			  sizeof(*q->rxq_bd_v) * lp->rx_bd_num,
-			  q->rxq_bd_v,
-			  q->rx_bd_p);
-	q->rxq_bd_v = NULL;
+	slot %= 8;
+	val = axienet_dma_in32(q, offset);
+	old = (val & XMCDMA_TXWEIGHT_CH_MASK(slot)) >>
+	      XMCDMA_TXWEIGHT_CH_SHIFT(slot);
+	val &= ~XMCDMA_TXWEIGHT_CH_MASK(slot);
+	val |= weight << XMCDMA_TXWEIGHT_CH_SHIFT(slot);
+	axienet_dma_out32(q, offset, val);
+
+	return old;
 }
 
 /**
@@ -189,9 +224,15 @@ int __maybe_unused axienet_mcdma_tx_q_init(struct net_device *ndev,
 						GFP_KERNEL);
 		if (!q->tx_bufs)
 			goto out;
+	}
 
-		for (i = 0; i < lp->tx_bd_num; i++)
-			q->tx_buf[i] = &q->tx_bufs[i * XAE_MAX_PKT_LEN];
+	if (ndev->hw_features & (NETIF_F_TSO | NETIF_F_GSO_UDP_L4)) {
+		q->tso_hdrs = dma_alloc_coherent(ndev->dev.parent,
+						 TSO_HEADER_SIZE * lp->tx_bd_num,
+						 &q->tso_hdrs_dma,
+						 GFP_KERNEL);
+		if (!q->tso_hdrs)
+			goto out;
 	}
 
 	for (i = 0; i < lp->tx_bd_num; i++) {
@@ -232,6 +273,10 @@ int __maybe_unused axienet_mcdma_tx_q_init(struct net_device *ndev,
 	chan_en |= (1 << (q->chan_id - 1));
 	axienet_dma_out32(q, XMCDMA_CHEN_OFFSET, chan_en);
 
+	/* The DMA reset brought the weight back to its default */
+	if (q->cbs_enabled)
+		axienet_mcdma_set_tx_weight(q, q->chan_id - 1, q->cbs_weight);
+
 	return 0;
 out:
 	for_each_tx_dma_queue(lp, i) {
@@ -255,13 +300,16 @@ int __maybe_unused axienet_mcdma_rx_q_init(struct net_device *ndev,
 {
 	u32 cr, chan_en;
 	int i;
-	struct sk_buff *skb;
+	struct page *page;
 	struct axienet_local *lp = netdev_priv(ndev);
 	dma_addr_t mapping;
 
 	q->rx_bd_ci = 0;
 	q->rx_offset = XMCDMA_CHAN_RX_OFFSET;
 
+	if (axienet_rx_page_pool_create(ndev, q))
+		goto out;
+
 	q->rxq_bd_v = dma_alloc_coherent(ndev->dev.parent,
 					 sizeof(*q->rxq_bd_v) * lp->rx_bd_num,
 					 &q->rx_bd_p, GFP_KERNEL);
@@ -273,27 +321,19 @@ int __maybe_unused axienet_mcdma_rx_q_init(struct net_device *ndev,
 				      sizeof(*q->rxq_bd_v) *
 				      ((i + 1) % lp->rx_bd_num);
 
-		skb = netdev_alloc_skb(ndev, lp->max_frm_size);
-		if (!skb)
-			goto out;
+		/* AF_XDP buffers are handed out by axienet_rx_zc_refill() */
+		if (q->xsk_pool)
+			continue;
 
-		/* Ensure that the skb is completely updated
-		 * prio to mapping the DMA
-		 */
-		wmb();
-
-		q->rxq_bd_v[i].sw_id_offset = (phys_addr_t)skb;
-		mapping = dma_map_single(ndev->dev.parent,
-					 skb->data,
-					 lp->max_frm_size,
-					 DMA_FROM_DEVICE);
-		if (unlikely(dma_mapping_error(ndev->dev.parent, mapping))) {
-			dev_err(&ndev->dev, "mcdma map error\n");
+		page = axienet_rx_page_alloc(q, &mapping);
+		if (!page) {
+			dev_err(&ndev->dev, "mcdma rx buffer alloc error\n");
 			goto out;
 		}
 
+		q->rxq_bd_v[i].sw_id_offset = (phys_addr_t)page;
 		q->rxq_bd_v[i].phys = mapping;
-		q->rxq_bd_v[i].cntrl = lp->max_frm_size;
+		q->rxq_bd_v[i].cntrl = axienet_rx_buf_len(lp);
 	}
 
 	/* Start updating the Rx channel control register */
@@ -326,9 +366,14 @@ int __maybe_unused axienet_mcdma_rx_q_init(struct net_device *ndev,
 				q->rx_offset);
 	axienet_dma_out32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id) + q->rx_offset,
 			  cr | XMCDMA_CR_RUNSTOP_MASK);
-	axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
-			    q->rx_offset, q->rx_bd_p + (sizeof(*q->rxq_bd_v) *
-			    (lp->rx_bd_num - 1)));
+	if (q->xsk_pool) {
+		q->rx_bd_fill = 0;
+		axienet_rx_zc_refill(q);
+	} else {
+		axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
+				  q->rx_offset, q->rx_bd_p +
+				  (sizeof(*q->rxq_bd_v) * (lp->rx_bd_num - 1)));
+	}
 	chan_en = axienet_dma_in32(q, XMCDMA_CHEN_OFFSET + q->rx_offset);
 	chan_en |= (1 << (q->chan_id - 1));
 	axienet_dma_out32(q, XMCDMA_CHEN_OFFSET + q->rx_offset, chan_en);
@@ -401,7 +446,10 @@ irqreturn_t __maybe_unused axienet_mcdma_tx_irq(int irq, void *_ndev)
 	status = axienet_dma_in32(q, XMCDMA_CHAN_SR_OFFSET(q->chan_id));
 	if (status & (XMCDMA_IRQ_IOC_MASK | XMCDMA_IRQ_DELAY_MASK)) {
 		axienet_dma_out32(q, XMCDMA_CHAN_SR_OFFSET(q->chan_id), status);
-		axienet_start_xmit_done(lp->ndev, q);
+		cr = axienet_dma_in32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id));
+		cr &= ~(XMCDMA_IRQ_IOC_MASK | XMCDMA_IRQ_DELAY_MASK);
+		axienet_dma_out32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id), cr);
+		napi_schedule(&lp->napi[i]);
 		goto out;
 	}
 	if (!(status & XMCDMA_IRQ_ALL_MASK))
@@ -547,24 +595,14 @@ void axienet_strings(struct net_device *ndev, u32 sset, u8 *data)
 	}
 }
 
-int axienet_sset_count(struct net_device *ndev, int sset)
-{
-	struct axienet_local *lp = netdev_priv(ndev);
-
-	switch (sset) {
-	case ETH_SS_STATS:
-		return (AXIENET_TX_SSTATS_LEN(lp) + AXIENET_RX_SSTATS_LEN(lp) +
-			AXIENET_ETHTOOLS_SSTATS_LEN);
-	default:
-		return -EOPNOTSUPP;
-	}
-}
-
 void axienet_get_stats(struct net_device *ndev,
 		       struct ethtool_stats *stats,
 		       u64 *data)
 {
 	struct axienet_local *lp = netdev_priv(ndev);
+	struct axienet_xmit_stats xmit_stats;
+	struct axienet_tx_stats tx_stats;
+	struct axienet_rx_stats rx_stats;
 	struct axienet_dma_q *q;
 	unsigned int i = AXIENET_ETHTOOLS_SSTATS_LEN, j;
 
@@ -573,8 +611,9 @@ void axienet_get_stats(struct net_device *ndev,
 			break;
 
 		q = lp->dq[j];
-		data[i++] = q->tx_packets;
-		data[i++] = q->tx_bytes;
+		axienet_read_tx_stats(q, &tx_stats, &xmit_stats);
+		data[i++] = tx_stats.packets;
+		data[i++] = tx_stats.bytes;
 		++j;
 	}
 	for (j = 0; i < AXIENET_TX_SSTATS_LEN(lp) + AXIENET_RX_SSTATS_LEN(lp) +
@@ -583,8 +622,9 @@ void axienet_get_stats(struct net_device *ndev,
 			break;
 
 		q = lp->dq[j];
-		data[i++] = q->rx_packets;
-		data[i++] = q->rx_bytes;
+		axienet_read_rx_stats(q, &rx_stats);
+		data[i++] = rx_stats.packets;
+		data[i++] = rx_stats.bytes;
 		++j;
 	}
 }
@@ -615,15 +655,10 @@ void __maybe_unused axienet_mcdma_err_handler(unsigned long data)
 	__axienet_device_reset(q);
 	axienet_unlock_mii(lp);
 
+	axienet_tx_bd_clean(ndev, q);
+
 	for (i = 0; i < lp->tx_bd_num; i++) {
 		cur_p = &q->txq_bd_v[i];
-		if (cur_p->phys)
-			dma_unmap_single(ndev->dev.parent, cur_p->phys,
-					 (cur_p->cntrl &
-					  XAXIDMA_BD_CTRL_LENGTH_MASK),
-					 DMA_TO_DEVICE);
-		if (cur_p->tx_skb)
-			dev_kfree_skb_irq((struct sk_buff *)cur_p->tx_skb);
 		cur_p->phys = 0;
 		cur_p->cntrl = 0;
 		cur_p->status = 0;
@@ -644,6 +679,11 @@ void __maybe_unused axienet_mcdma_err_handler(unsigned long data)
 		cur_p->app2 = 0;
 		cur_p->app3 = 0;
 		cur_p->app4 = 0;
+		/* AF_XDP buffers are handed out again from the fill ring */
+		if (q->xsk_pool) {
+			axienet_rx_buf_free(q, (void *)cur_p->sw_id_offset);
+			cur_p->sw_id_offset = 0;
+		}
 	}
 
 	q->tx_bd_ci = 0;
@@ -696,9 +736,14 @@ void __maybe_unused axienet_mcdma_err_handler(unsigned long data)
 				q->rx_offset);
 	axienet_dma_out32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id) + q->rx_offset,
 			  cr | XMCDMA_CR_RUNSTOP_MASK);
-	axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
-			    q->rx_offset, q->rx_bd_p + (sizeof(*q->rxq_bd_v) *
-			    (lp->rx_bd_num - 1)));
+	if (q->xsk_pool) {
+		q->rx_bd_fill = 0;
+		axienet_rx_zc_refill(q);
+	} else {
+		axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
+				  q->rx_offset, q->rx_bd_p +
+				  (sizeof(*q->rxq_bd_v) * (lp->rx_bd_num - 1)));
+	}
 	chan_en = axienet_dma_in32(q, XMCDMA_CHEN_OFFSET + q->rx_offset);
 	chan_en |= (1 << (q->chan_id - 1));
 	axienet_dma_out32(q, XMCDMA_CHEN_OFFSET + q->rx_offset, chan_en);
@@ -776,6 +821,8 @@ int __maybe_unused axienet_mcdma_tx_probe(struct platform_device *pdev,
 		q->eth_hasdre = of_property_read_bool(np,
 						      "xlnx,include-dre");
 		spin_lock_init(&q->tx_lock);
+		u64_stats_init(&q->tx_stats.syncp);
+		u64_stats_init(&q->xmit_stats.syncp);
 	}
 	of_node_put(np);
 
@@ -800,6 +847,7 @@ int __maybe_unused axienet_mcdma_rx_probe(struct platform_device *pdev,
 		q->rx_irq = platform_get_irq_byname(pdev, dma_name);
 
 		spin_lock_init(&q->rx_lock);
+		u64_stats_init(&q->rx_stats.syncp);
 
 		netif_napi_add(ndev, &lp->napi[i], xaxienet_rx_poll);
 	}
@@ -807,6 +855,138 @@ int __maybe_unused axienet_mcdma_rx_probe(struct platform_device *pdev,
 	return 0;
 }
 
+/**
+ * axienet_mcdma_setup_mqprio - Map traffic classes onto MCDMA Tx channels
+ * @ndev:	Pointer to the net_device structure
+ * @mqprio:	mqprio offload parameters
+ *
+ * Each netdev Tx queue is carried by its own MCDMA Tx channel, so the
+ * queue ranges of the traffic classes are taken as they are. Per class
+ * rate limits are not supported.
+ *
+ * Return: 0 on success, negative errno otherwise
+ */
+static int axienet_mcdma_setup_mqprio(struct net_device *ndev,
+				      struct tc_mqprio_qopt_offload *mqprio)
+{
+	struct tc_mqprio_qopt *qopt = &mqprio->qopt;
+	int i, ret;
+
+	if (mqprio->flags & (TC_MQPRIO_F_MIN_RATE | TC_MQPRIO_F_MAX_RATE))
+		return -EOPNOTSUPP;
+
+	if (!qopt->num_tc) {
+		netdev_reset_tc(ndev);
+		return 0;
+	}
+
+	ret = netdev_set_num_tc(ndev, qopt->num_tc);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < qopt->num_tc; i++) {
+		ret = netdev_set_tc_queue(ndev, i, qopt->count[i],
+					  qopt->offset[i]);
+		if (ret)
+			goto err;
+	}
+
+	for (i = 0; i <= TC_BITMASK; i++) {
+		ret = netdev_set_prio_tc_map(ndev, i, qopt->prio_tc_map[i]);
+		if (ret)
+			goto err;
+	}
+
+	qopt->hw = TC_MQPRIO_HW_OFFLOAD_TCS;
+	return 0;
+
+err:
+	netdev_reset_tc(ndev);
+	return ret;
+}
+
+/**
+ * axienet_mcdma_setup_cbs - Offload a CBS qdisc to an MCDMA Tx channel
+ * @ndev:	Pointer to the net_device structure
+ * @cbs:	CBS offload parameters
+ *
+ * The MCDMA arbitrates its Tx channels by weighted round robin. The
+ * idleslope is approximated by giving the channel a weight proportional to
+ * its share of the link speed at the time the qdisc is installed. The
+ * credit limits are not enforced by the hardware.
+ *
+ * Return: 0 on success, negative errno otherwise
+ */
+static int axienet_mcdma_setup_cbs(struct net_device *ndev,
+				   struct tc_cbs_qopt_offload *cbs)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct ethtool_link_ksettings ks;
+	struct axienet_dma_q *q;
+	u64 rate = SPEED_1000;
+	u8 weight, old;
+
+	if (cbs->queue < 0 || cbs->queue >= lp->num_tx_queues)
+		return -EINVAL;
+	q = lp->dq[cbs->queue];
+
+	if (!cbs->enable) {
+		if (q->cbs_enabled)
+			axienet_mcdma_set_tx_weight(q, q->chan_id - 1,
+						    q->tx_weight);
+		q->cbs_enabled = false;
+		return 0;
+	}
+
+	if (cbs->idleslope <= 0)
+		return -EINVAL;
+
+	if (!__ethtool_get_link_ksettings(ndev, &ks) &&
+	    ks.base.speed != SPEED_UNKNOWN)
+		rate = ks.base.speed;
+	else if (lp->axienet_config->mactype == XAXIENET_10G_25G)
+		rate = SPEED_10000;
+
+	/* idleslope is in kbit/s, the speed in Mbit/s */
+	weight = clamp_t(u64, DIV64_U64_ROUND_UP((u64)cbs->idleslope *
+						 XMCDMA_TXWEIGHT_MAX,
+						 rate * 1000),
+			 1, XMCDMA_TXWEIGHT_MAX);
+
+	old = axienet_mcdma_set_tx_weight(q, q->chan_id - 1, weight);
+	if (!q->cbs_enabled)
+		q->tx_weight = old;
+	q->cbs_weight = weight;
+	q->cbs_enabled = true;
+	netdev_dbg(ndev, "txq%d: CBS weight %u\n", cbs->queue, weight);
+
+	return 0;
+}
+
+/**
+ * axienet_mcdma_setup_tc - Driver ndo_setup_tc routine
+ * @ndev:	Pointer to the net_device structure
+ * @type:	Type of the offload
+ * @type_data:	Offload parameters
+ *
+ * The MCDMA has no time aware gates, TAPRIO schedules are left to the
+ * software implementation, which can run over the mqprio queue mapping.
+ *
+ * Return: 0 on success, negative errno otherwise
+ */
+int axienet_mcdma_setup_tc(struct net_device *ndev, enum tc_setup_type type,
+			   void *type_data)
+{
+	switch (type) {
+	case TC_SETUP_QDISC_MQPRIO:
+		return axienet_mcdma_setup_mqprio(ndev, type_data);
+	case TC_SETUP_QDISC_CBS:
+		return axienet_mcdma_setup_cbs(ndev, type_data);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
 static ssize_t rxch_obs1_show(struct device *dev,
 			      struct device_attribute *attr, char *buf)
 {
@@ -993,8 +1173,7 @@ static ssize_t chan_weight_store(struct device *dev,
 	struct axienet_local *lp = netdev_priv(ndev);
 	struct axienet_dma_q *q = lp->dq[0];
 	int ret;
-	u16 flags, chan_id;
-	u32 val;
+	u16 flags;
 
 	ret = kstrtou16(buf, 16, &flags);
 	if (ret)
@@ -1003,23 +1182,7 @@ static ssize_t chan_weight_store(struct device *dev,
 	lp->chan_id = (flags & 0xF0) >> 4;
 	lp->weight = flags & 0x0F;
 
-	if (lp->chan_id < 8)
-		val = axienet_dma_in32(q, XMCDMA_TXWEIGHT0_OFFSET);
-	else
-		val = axienet_dma_in32(q, XMCDMA_TXWEIGHT1_OFFSET);
-
-	if (lp->chan_id > 7)
-		chan_id = lp->chan_id - 8;
-	else
-		chan_id = lp->chan_id;
-
-	val &= ~XMCDMA_TXWEIGHT_CH_MASK(chan_id);
-	val |= lp->weight << XMCDMA_TXWEIGHT_CH_SHIFT(chan_id);
-
-	if (lp->chan_id < 8)
-		axienet_dma_out32(q, XMCDMA_TXWEIGHT0_OFFSET, val);
-	else
-		axienet_dma_out32(q, XMCDMA_TXWEIGHT1_OFFSET, val);
+	axienet_mcdma_set_tx_weight(q, lp->chan_id, lp->weight);
 
 	return count;
 }
@@ -0,0 +1,388 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/* Xilinx AXI Ethernet (loopback self-test)
+ *
+ * Copyright (c) 2023 Advanced Micro Devices, Inc.
+ *
+ * This file implements ethtool -t. The PCS/PMA, or else the PHY, is put in
+ * loopback and frames of several sizes are sent through the real DMA rings
+ * of every Tx queue, to measure the frame rate and the round trip latency
+ * of the port independently of the network.
+ */
+
+#include <linux/etherdevice.h>
+#include <linux/ethtool.h>
+#include <linux/mdio.h>
+#include <linux/phy.h>
+
+#include "xilinx_axienet.h"
+
+#define AXIENET_TEST_MAGIC	0x41584945	/* "AXIE" */
+#define AXIENET_TEST_FRAMES	4096		/* Frames per rate run */
+#define AXIENET_TEST_PINGS	64		/* Frames per latency run */
+#define AXIENET_TEST_TIMEOUT	msecs_to_jiffies(2000)
+#define AXIENET_TEST_PING_TIMEOUT msecs_to_jiffies(100)
+#define AXIENET_TEST_PROBES	10
+
+/* Frame sizes, FCS included, the last one is the MTU if above 1500 */
+static const unsigned int axienet_test_sizes[] = { 64, 512, 1518, 0 };
+static const char * const axienet_test_size_names[] = {
+	"64B", "512B", "1518B", "jumbo",
+};
+
+#define AXIENET_TEST_NSIZES	ARRAY_SIZE(axienet_test_sizes)
+/* Results of each size: rate and lost frames per Tx queue, then latency */
+#define AXIENET_TEST_SIZE_LEN(lp)	((lp)->num_tx_queues * 2 + 3)
+
+/**
+ * struct axienet_test_hdr - Payload header of a test frame
+ * @magic:	AXIENET_TEST_MAGIC
+ * @run:	Run the frame belongs to, late frames of an earlier run are
+ *		ignored
+ * @sent_ns:	Time the frame was handed to the driver
+ */
+struct axienet_test_hdr {
+	__be32 magic;
+	__be32 run;
+	__be64 sent_ns;
+} __packed;
+
+/**
+ * struct axienet_test - State of a self-test
+ * @pt:		Receives the looped back frames
+ * @done:	Completed when all the frames of the run came back
+ * @lock:	Protects the fields below, frames may come back on several
+ *		Rx queues at once
+ * @run:	Current run
+ * @expected:	Number of frames sent in the run
+ * @received:	Number of frames of the run that came back
+ * @last_ns:	Time the last frame came back
+ * @rtt_min:	Shortest round trip of the run
+ * @rtt_max:	Longest round trip of the run
+ * @rtt_sum:	Sum of the round trips of the run
+ */
+struct axienet_test {
+	struct packet_type pt;
+	struct completion done;
+	spinlock_t lock; /* lock for the run state */
+	u32 run;
+	u32 expected;
+	u32 received;
+	u64 last_ns;
+	u64 rtt_min;
+	u64 rtt_max;
+	u64 rtt_sum;
+};
+
+static int axienet_test_rcv(struct sk_buff *skb, struct net_device *ndev,
+			    struct packet_type *pt,
+			    struct net_device *orig_ndev)
+{
+	struct axienet_test *t = container_of(pt, struct axienet_test, pt);
+	struct axienet_test_hdr *hdr;
+	u64 now = ktime_get_ns();
+	u64 rtt;
+
+	skb = skb_unshare(skb, GFP_ATOMIC);
+	if (!skb)
+		return 0;
+
+	if (!pskb_may_pull(skb, sizeof(*hdr)))
+		goto out;
+
+	hdr = (struct axienet_test_hdr *)skb->data;
+	if (hdr->magic != htonl(AXIENET_TEST_MAGIC))
+		goto out;
+
+	spin_lock(&t->lock);
+	if (ntohl(hdr->run) == t->run && t->received < t->expected) {
+		rtt = now - be64_to_cpu(hdr->sent_ns);
+		t->rtt_min = min(t->rtt_min, rtt);
+		t->rtt_max = max(t->rtt_max, rtt);
+		t->rtt_sum += rtt;
+		t->last_ns = now;
+		if (++t->received == t->expected)
+			complete(&t->done);
+	}
+	spin_unlock(&t->lock);
+
+out:
+	kfree_skb(skb);
+	return 0;
+}
+
+static void axienet_test_start(struct axienet_test *t, u32 expected)
+{
+	spin_lock_bh(&t->lock);
+	t->run++;
+	t->expected = expected;
+	t->received = 0;
+	t->rtt_min = U64_MAX;
+	t->rtt_max = 0;
+	t->rtt_sum = 0;
+	reinit_completion(&t->done);
+	spin_unlock_bh(&t->lock);
+}
+
+/* Queue one frame of @len bytes, FCS excluded, on Tx queue @qidx. The
+ * driver is called directly, as pktgen does, so the test is not limited
+ * by the qdisc nor disturbed by the link state.
+ */
+static int axienet_test_xmit(struct net_device *ndev, struct axienet_test *t,
+			     u16 qidx, unsigned int len)
+{
+	struct netdev_queue *txq = netdev_get_tx_queue(ndev, qidx);
+	unsigned long timeout = jiffies + AXIENET_TEST_TIMEOUT;
+	struct axienet_test_hdr *hdr;
+	struct sk_buff *skb;
+	struct ethhdr *eth;
+	int ret;
+
+	skb = netdev_alloc_skb(ndev, len);
+	if (!skb)
+		return -ENOMEM;
+
+	eth = skb_put(skb, ETH_HLEN);
+	ether_addr_copy(eth->h_dest, ndev->dev_addr);
+	ether_addr_copy(eth->h_source, ndev->dev_addr);
+	eth->h_proto = htons(ETH_P_LOOPBACK);
+	hdr = skb_put(skb, sizeof(*hdr));
+	hdr->magic = htonl(AXIENET_TEST_MAGIC);
+	hdr->run = htonl(t->run);
+	skb_put_zero(skb, len - ETH_HLEN - sizeof(*hdr));
+	skb_reset_mac_header(skb);
+	skb->protocol = eth->h_proto;
+	skb_set_queue_mapping(skb, qidx);
+
+	for (;;) {
+		hdr->sent_ns = cpu_to_be64(ktime_get_ns());
+
+		local_bh_disable();
+		HARD_TX_LOCK(ndev, txq, smp_processor_id());
+		if (netif_xmit_frozen_or_drv_stopped(txq))
+			ret = NETDEV_TX_BUSY;
+		else
+			ret = netdev_start_xmit(skb, ndev, txq, false);
+		HARD_TX_UNLOCK(ndev, txq);
+		local_bh_enable();
+
+		if (ret != NETDEV_TX_BUSY)
+			return ret == NETDEV_TX_OK ? 0 : -EIO;
+
+		if (time_after(jiffies, timeout)) {
+			kfree_skb(skb);
+			return -ETIMEDOUT;
+		}
+		cond_resched();
+	}
+}
+
+static int axienet_test_loopback(struct axienet_local *lp, bool enable)
+{
+	if (lp->pcs_phy)
+		return mdiodev_modify(lp->pcs_phy, MII_BMCR, BMCR_LOOPBACK,
+				      enable ? BMCR_LOOPBACK : 0);
+
+	if (lp->ndev->phydev)
+		return phy_loopback(lp->ndev->phydev, enable);
+
+	return -EOPNOTSUPP;
+}
+
+/* Wait for the loopback to come up, the PCS or PHY may need to resync */
+static int axienet_test_probe(struct net_device *ndev, struct axienet_test *t)
+{
+	int i, ret;
+
+	for (i = 0; i < AXIENET_TEST_PROBES; i++) {
+		axienet_test_start(t, 1);
+		ret = axienet_test_xmit(ndev, t, 0, ETH_ZLEN);
+		if (ret)
+			return ret;
+		if (wait_for_completion_timeout(&t->done,
+						AXIENET_TEST_PING_TIMEOUT))
+			return 0;
+	}
+
+	return -ETIMEDOUT;
+}
+
+/* Send AXIENET_TEST_FRAMES frames back to back and return the frame rate
+ * at which they came back, the lost frames are returned in @lost.
+ */
+static u64 axienet_test_rate(struct net_device *ndev, struct axienet_test *t,
+			     u16 qidx, unsigned int len, u64 *lost)
+{
+	u64 start, last;
+	u32 i, received;
+
+	axienet_test_start(t, AXIENET_TEST_FRAMES);
+	start = ktime_get_ns();
+	for (i = 0; i < AXIENET_TEST_FRAMES; i++)
+		if (axienet_test_xmit(ndev, t, qidx, len))
+			break;
+
+	wait_for_completion_timeout(&t->done, AXIENET_TEST_TIMEOUT);
+
+	spin_lock_bh(&t->lock);
+	received = t->received;
+	last = t->last_ns;
+	/* Frames still in flight must not count in the next run */
+	t->run++;
+	spin_unlock_bh(&t->lock);
+
+	*lost = AXIENET_TEST_FRAMES - received;
+	if (!received || last <= start)
+		return 0;
+
+	return div64_u64((u64)received * NSEC_PER_SEC, last - start);
+}
+
+/* Send AXIENET_TEST_PINGS frames one at a time and return the round trip
+ * latencies in ns, minimum, average and maximum. Return false if a frame
+ * did not come back.
+ */
+static bool axienet_test_latency(struct net_device *ndev,
+				 struct axienet_test *t, unsigned int len,
+				 u64 *data)
+{
+	u64 rtt_min = U64_MAX, rtt_max = 0, sum = 0;
+	int i;
+
+	for (i = 0; i < AXIENET_TEST_PINGS; i++) {
+		axienet_test_start(t, 1);
+		if (axienet_test_xmit(ndev, t, 0, len) ||
+		    !wait_for_completion_timeout(&t->done,
+						 AXIENET_TEST_PING_TIMEOUT))
+			return false;
+
+		spin_lock_bh(&t->lock);
+		rtt_min = min(rtt_min, t->rtt_min);
+		rtt_max = max(rtt_max, t->rtt_max);
+		sum += t->rtt_sum;
+		spin_unlock_bh(&t->lock);
+	}
+
+	data[0] = rtt_min;
+	data[1] = div_u64(sum, AXIENET_TEST_PINGS);
+	data[2] = rtt_max;
+
+	return true;
+}
+
+/**
+ * axienet_selftest_count - Number of self-test results
+ * @lp:		Pointer to axienet local structure
+ *
+ * Return: number of u64 results, and strings, of axienet_self_test()
+ */
+int axienet_selftest_count(struct axienet_local *lp)
+{
+	return 1 + AXIENET_TEST_NSIZES * AXIENET_TEST_SIZE_LEN(lp);
+}
+
+/**
+ * axienet_selftest_strings - Names of the self-test results
+ * @lp:		Pointer to axienet local structure
+ * @data:	Returned strings, ETH_GSTRING_LEN bytes each
+ */
+void axienet_selftest_strings(struct axienet_local *lp, u8 *data)
+{
+	unsigned int i, q;
+
+	ethtool_sprintf(&data, "loopback (errno)");
+	for (i = 0; i < AXIENET_TEST_NSIZES; i++) {
+		const char *name = axienet_test_size_names[i];
+
+		for_each_tx_dma_queue(lp, q) {
+			ethtool_sprintf(&data, "txq%u %s frames/s", q, name);
+			ethtool_sprintf(&data, "txq%u %s lost", q, name);
+		}
+		ethtool_sprintf(&data, "%s rtt min ns", name);
+		ethtool_sprintf(&data, "%s rtt avg ns", name);
+		ethtool_sprintf(&data, "%s rtt max ns", name);
+	}
+}
+
+/**
+ * axienet_self_test - Run the loopback self-test
+ * @ndev:	Pointer to net_device structure
+ * @etest:	Test flags, ETH_TEST_FL_FAILED is set if frames were lost
+ * @data:	Results, see axienet_selftest_strings()
+ *
+ * The test is only run offline, on a running interface, as the port does
+ * not reach the network while it is in loopback. The first result is 0 if
+ * the loopback could be set up, a positive errno otherwise. The frame sizes
+ * above the MTU are skipped and read 0.
+ */
+void axienet_self_test(struct net_device *ndev, struct ethtool_test *etest,
+		       u64 *data)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	unsigned int i, len;
+	struct axienet_test *t;
+	u64 *res;
+	u16 q;
+	int ret;
+
+	memset(data, 0, axienet_selftest_count(lp) * sizeof(*data));
+	if (!(etest->flags & ETH_TEST_FL_OFFLINE))
+		return;
+
+	if (!netif_running(ndev)) {
+		ret = -ENETDOWN;
+		goto fail;
+	}
+
+	t = kzalloc(sizeof(*t), GFP_KERNEL);
+	if (!t) {
+		ret = -ENOMEM;
+		goto fail;
+	}
+
+	init_completion(&t->done);
+	spin_lock_init(&t->lock);
+	t->pt.type = htons(ETH_P_LOOPBACK);
+	t->pt.func = axienet_test_rcv;
+	t->pt.dev = ndev;
+
+	ret = axienet_test_loopback(lp, true);
+	if (ret)
+		goto free;
+
+	dev_add_pack(&t->pt);
+	ret = axienet_test_probe(ndev, t);
+	if (ret)
+		goto remove;
+
+	for (i = 0; i < AXIENET_TEST_NSIZES; i++) {
+		res = &data[1 + i * AXIENET_TEST_SIZE_LEN(lp)];
+		len = axienet_test_sizes[i];
+		if (!len) {
+			if (ndev->mtu <= ETH_DATA_LEN)
+				continue;
+			len = ndev->mtu + ETH_HLEN + ETH_FCS_LEN;
+		}
+		len -= ETH_FCS_LEN;
+
+		for_each_tx_dma_queue(lp, q) {
+			res[0] = axienet_test_rate(ndev, t, q, len, &res[1]);
+			if (res[1])
+				etest->flags |= ETH_TEST_FL_FAILED;
+			res += 2;
+		}
+		if (!axienet_test_latency(ndev, t, len, res))
+			etest->flags |= ETH_TEST_FL_FAILED;
+	}
+
+remove:
+	dev_remove_pack(&t->pt);
+	axienet_test_loopback(lp, false);
+free:
+	kfree(t);
+	if (!ret)
+		return;
+fail:
+	data[0] = -ret;
+	etest->flags |= ETH_TEST_FL_FAILED;
+}
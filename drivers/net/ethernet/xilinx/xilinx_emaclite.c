@@ -115,6 +115,7 @@
  * @phy_node:		pointer to the PHY device node
  * @mii_bus:		pointer to the MII bus
  * @last_link:		last link status
+ * @napi:		NAPI context for the Rx path
  */
 struct net_local {
 	struct net_device *ndev;
@@ -134,6 +135,8 @@ struct net_local {
 	struct mii_bus *mii_bus;
 
 	int last_link;
+
+	struct napi_struct napi;
 };
 
 /*************************/
@@ -195,55 +198,48 @@ static void xemaclite_disable_interrupts(struct net_local *drvdata)
  * @length:	Number bytes to write from source to destination
  *
  * This function writes data from a 16-bit aligned buffer to a 32-bit aligned
- * address in the EmacLite device.
+ * address in the EmacLite device. A 32-bit aligned source is written with a
+ * single burst of word accesses.
  */
-static void xemaclite_aligned_write(const void *src_ptr, u32 *dest_ptr,
+static void xemaclite_aligned_write(const void *src_ptr,
+				    void __iomem *dest_ptr,
 				    unsigned int length)
 {
 	const u16 *from_u16_ptr;
 	u32 align_buffer;
-	u32 *to_u32_ptr;
 	u16 *to_u16_ptr;
 
-	to_u32_ptr = dest_ptr;
 	from_u16_ptr = src_ptr;
-	align_buffer = 0;
+
+	if (IS_ALIGNED((uintptr_t)src_ptr, 4)) {
+		iowrite32_rep(dest_ptr, src_ptr, length / 4);
+		from_u16_ptr += (length & ~3) / 2;
+		dest_ptr += length & ~3;
+		length &= 3;
+	}
 
 	for (; length > 3; length -= 4) {
 		to_u16_ptr = (u16 *)&align_buffer;
 		*to_u16_ptr++ = *from_u16_ptr++;
 		*to_u16_ptr++ = *from_u16_ptr++;
 
-		/* This barrier resolves occasional issues seen around
-		 * cases where the data is not properly flushed out
-		 * from the processor store buffers to the destination
-		 * memory locations.
-		 */
-		wmb();
-
 		/* Output a word */
-		*to_u32_ptr++ = align_buffer;
+		__raw_writel(align_buffer, dest_ptr);
+		dest_ptr += 4;
 	}
 	if (length) {
-		u8 *from_u8_ptr, *to_u8_ptr;
-
-		/* Set up to output the remaining data */
-		align_buffer = 0;
-		to_u8_ptr = (u8 *)&align_buffer;
-		from_u8_ptr = (u8 *)from_u16_ptr;
-
 		/* Output the remaining data */
-		for (; length > 0; length--)
-			*to_u8_ptr++ = *from_u8_ptr++;
-
-		/* This barrier resolves occasional issues seen around
-		 * cases where the data is not properly flushed out
-		 * from the processor store buffers to the destination
-		 * memory locations.
-		 */
-		wmb();
-		*to_u32_ptr = align_buffer;
+		align_buffer = 0;
+		memcpy(&align_buffer, from_u16_ptr, length);
+		__raw_writel(align_buffer, dest_ptr);
 	}
+
+	/* This barrier resolves occasional issues seen around cases where
+	 * the data is not properly flushed out from the processor store
+	 * buffers to the destination memory locations. It is only needed
+	 * once, before the buffer is handed over to the hardware.
+	 */
+	wmb();
 }
 
 /**
@@ -253,21 +249,28 @@ static void xemaclite_aligned_write(const void *src_ptr, u32 *dest_ptr,
  * @length:	Number bytes to read from source to destination
  *
  * This function reads data from a 32-bit aligned address in the EmacLite device
- * to a 16-bit aligned buffer.
+ * to a 16-bit aligned buffer. A 32-bit aligned destination is read with a
+ * single burst of word accesses.
  */
-static void xemaclite_aligned_read(u32 *src_ptr, u8 *dest_ptr,
+static void xemaclite_aligned_read(void __iomem *src_ptr, u8 *dest_ptr,
 				   unsigned int length)
 {
 	u16 *to_u16_ptr, *from_u16_ptr;
-	u32 *from_u32_ptr;
 	u32 align_buffer;
 
-	from_u32_ptr = src_ptr;
+	if (IS_ALIGNED((uintptr_t)dest_ptr, 4)) {
+		ioread32_rep(src_ptr, dest_ptr, length / 4);
+		src_ptr += length & ~3;
+		dest_ptr += length & ~3;
+		length &= 3;
+	}
+
 	to_u16_ptr = (u16 *)dest_ptr;
 
 	for (; length > 3; length -= 4) {
 		/* Copy each word into the temporary buffer */
-		align_buffer = *from_u32_ptr++;
+		align_buffer = __raw_readl(src_ptr);
+		src_ptr += 4;
 		from_u16_ptr = (u16 *)&align_buffer;
 
 		/* Read data from source */
@@ -276,16 +279,9 @@ static void xemaclite_aligned_read(u32 *src_ptr, u8 *dest_ptr,
 	}
 
 	if (length) {
-		u8 *to_u8_ptr, *from_u8_ptr;
-
-		/* Set up to read the remaining data */
-		to_u8_ptr = (u8 *)to_u16_ptr;
-		align_buffer = *from_u32_ptr++;
-		from_u8_ptr = (u8 *)&align_buffer;
-
 		/* Read the remaining data */
-		for (; length > 0; length--)
-			*to_u8_ptr = *from_u8_ptr;
+		align_buffer = __raw_readl(src_ptr);
+		memcpy(to_u16_ptr, &align_buffer, length);
 	}
 }
 
@@ -341,7 +337,7 @@ static int xemaclite_send_data(struct net_local *drvdata, u8 *data,
 	}
 
 	/* Write the frame to the buffer */
-	xemaclite_aligned_write(data, (u32 __force *)addr, byte_count);
+	xemaclite_aligned_write(data, addr, byte_count);
 
 	xemaclite_writel((byte_count & XEL_TPLR_LENGTH_MASK),
 			 addr + XEL_TPLR_OFFSET);
@@ -364,7 +360,7 @@ static int xemaclite_send_data(struct net_local *drvdata, u8 *data,
  * @data:	Address where the data is to be received
  * @maxlen:    Maximum supported ethernet packet length
  *
- * This function is intended to be called from the interrupt context or
+ * This function is intended to be called from the NAPI poll routine or
  * with a wrapper which waits for the receive frame to be available.
  *
  * Return:	Total number of bytes received
@@ -440,8 +436,7 @@ static u16 xemaclite_recv_data(struct net_local *drvdata, u8 *data, int maxlen)
 		length = maxlen;
 
 	/* Read from the EmacLite device */
-	xemaclite_aligned_read((u32 __force *)(addr + XEL_RXBUFF_OFFSET),
-			       data, length);
+	xemaclite_aligned_read(addr + XEL_RXBUFF_OFFSET, data, length);
 
 	/* Acknowledge the frame */
 	reg_data = xemaclite_readl(addr + XEL_RSR_OFFSET);
@@ -471,7 +466,7 @@ static void xemaclite_update_address(struct net_local *drvdata,
 	/* Determine the expected Tx buffer address */
 	addr = drvdata->base_addr + drvdata->next_tx_buf_to_use;
 
-	xemaclite_aligned_write(address_ptr, (u32 __force *)addr, ETH_ALEN);
+	xemaclite_aligned_write(address_ptr, addr, ETH_ALEN);
 
 	xemaclite_writel(ETH_ALEN, addr + XEL_TPLR_OFFSET);
 
@@ -581,7 +576,7 @@ static void xemaclite_tx_handler(struct net_device *dev)
 }
 
 /**
- * xemaclite_rx_handler- Interrupt handler for frames received
+ * xemaclite_rx_handler- Handler for frames received
  * @dev:	Pointer to the network device
  *
  * This function allocates memory for a socket buffer, fills it with data
@@ -594,21 +589,20 @@ static void xemaclite_rx_handler(struct net_device *dev)
 	u32 len;
 
 	len = ETH_FRAME_LEN + ETH_FCS_LEN;
-	skb = netdev_alloc_skb(dev, len + NET_IP_ALIGN);
+	skb = napi_alloc_skb(&lp->napi, len);
 	if (!skb) {
 		/* Couldn't get memory. */
 		dev->stats.rx_dropped++;
-		dev_err(&lp->ndev->dev, "Could not allocate receive buffer\n");
+		dev_err_ratelimited(&lp->ndev->dev,
+				    "Could not allocate receive buffer\n");
 		return;
 	}
 
-	skb_reserve(skb, NET_IP_ALIGN);
-
 	len = xemaclite_recv_data(lp, (u8 *)skb->data, len);
 
 	if (!len) {
 		dev->stats.rx_errors++;
-		dev_kfree_skb_irq(skb);
+		dev_kfree_skb(skb);
 		return;
 	}
 
@@ -621,7 +615,80 @@ static void xemaclite_rx_handler(struct net_device *dev)
 	dev->stats.rx_bytes += len;
 
 	if (!skb_defer_rx_timestamp(skb))
-		netif_rx(skb);	/* Send the packet upstream */
+		napi_gro_receive(&lp->napi, skb); /* Send the packet upstream */
+}
+
+/**
+ * xemaclite_rx_pending - Check for a received frame
+ * @lp:		Pointer to the Emaclite device private data
+ *
+ * Return:	true if the Rx ping or, when configured, pong buffer holds a
+ *		frame
+ */
+static bool xemaclite_rx_pending(struct net_local *lp)
+{
+	void __iomem *base_addr = lp->base_addr;
+
+	if (xemaclite_readl(base_addr + XEL_RSR_OFFSET) &
+	    XEL_RSR_RECV_DONE_MASK)
+		return true;
+
+	return lp->rx_ping_pong &&
+	       (xemaclite_readl(base_addr + XEL_BUFFER_OFFSET +
+				XEL_RSR_OFFSET) & XEL_RSR_RECV_DONE_MASK);
+}
+
+/**
+ * xemaclite_rx_irq - Enable or disable the Rx interrupt
+ * @lp:		Pointer to the Emaclite device private data
+ * @enable:	true to enable the interrupt, false to disable it
+ */
+static void xemaclite_rx_irq(struct net_local *lp, bool enable)
+{
+	u32 reg_data;
+
+	reg_data = xemaclite_readl(lp->base_addr + XEL_RSR_OFFSET);
+	if (enable)
+		reg_data |= XEL_RSR_RECV_IE_MASK;
+	else
+		reg_data &= ~XEL_RSR_RECV_IE_MASK;
+	xemaclite_writel(reg_data, lp->base_addr + XEL_RSR_OFFSET);
+}
+
+/**
+ * xemaclite_rx_poll - NAPI poll routine for frames received
+ * @napi:	Pointer to the NAPI context
+ * @budget:	Maximum number of frames to process
+ *
+ * This function drains the ping and pong Rx buffers, so that the hardware
+ * can receive into one buffer while the other is being copied out. The Rx
+ * interrupt stays disabled until both buffers are empty.
+ *
+ * Return:	Number of frames processed
+ */
+static int xemaclite_rx_poll(struct napi_struct *napi, int budget)
+{
+	struct net_local *lp = container_of(napi, struct net_local, napi);
+	int work_done = 0;
+
+	while (work_done < budget && xemaclite_rx_pending(lp)) {
+		xemaclite_rx_handler(lp->ndev);
+		work_done++;
+	}
+
+	if (work_done < budget && napi_complete_done(napi, work_done)) {
+		xemaclite_rx_irq(lp, true);
+
+		/* A frame that completed while the interrupt was disabled
+		 * did not raise one, pick it up now.
+		 */
+		if (xemaclite_rx_pending(lp) && napi_schedule_prep(napi)) {
+			xemaclite_rx_irq(lp, false);
+			__napi_schedule(napi);
+		}
+	}
+
+	return work_done;
 }
 
 /**
@@ -642,13 +709,11 @@ static irqreturn_t xemaclite_interrupt(int irq, void *dev_id)
 	void __iomem *base_addr = lp->base_addr;
 	u32 tx_status;
 
-	/* Check if there is Rx Data available */
-	if ((xemaclite_readl(base_addr + XEL_RSR_OFFSET) &
-			 XEL_RSR_RECV_DONE_MASK) ||
-	    (xemaclite_readl(base_addr + XEL_BUFFER_OFFSET + XEL_RSR_OFFSET)
-			 & XEL_RSR_RECV_DONE_MASK))
-
-		xemaclite_rx_handler(dev);
+	/* Check if there is Rx Data available, and leave it to NAPI */
+	if (xemaclite_rx_pending(lp) && napi_schedule_prep(&lp->napi)) {
+		xemaclite_rx_irq(lp, false);
+		__napi_schedule(&lp->napi);
+	}
 
 	/* Check if the Transmission for the first buffer is completed */
 	tx_status = xemaclite_readl(base_addr + XEL_TSR_OFFSET);
@@ -944,6 +1009,8 @@ static int xemaclite_open(struct net_device *dev)
 		return retval;
 	}
 
+	napi_enable(&lp->napi);
+
 	/* Enable Interrupts */
 	xemaclite_enable_interrupts(lp);
 
@@ -970,6 +1037,7 @@ static int xemaclite_close(struct net_device *dev)
 	netif_stop_queue(dev);
 	xemaclite_disable_interrupts(lp);
 	free_irq(dev->irq, dev);
+	napi_disable(&lp->napi);
 
 	if (lp->phy_dev)
 		phy_disconnect(lp->phy_dev);
@@ -1152,6 +1220,7 @@ static int xemaclite_of_probe(struct platform_device *ofdev)
 	ndev->ethtool_ops = &xemaclite_ethtool_ops;
 	ndev->flags &= ~IFF_MULTICAST;
 	ndev->watchdog_timeo = TX_TIMEOUT;
+	netif_napi_add(ndev, &lp->napi, xemaclite_rx_poll);
 
 	/* Finally, register the device */
 	rc = register_netdev(ndev);
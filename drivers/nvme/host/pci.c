@@ -100,6 +100,12 @@ static unsigned int poll_queues;
 module_param_cb(poll_queues, &io_queue_count_ops, &poll_queues, 0644);
 MODULE_PARM_DESC(poll_queues, "Number of queues to use for polled IO.");
 
+static bool auto_poll_queues = true;
+module_param(auto_poll_queues, bool, 0444);
+MODULE_PARM_DESC(auto_poll_queues,
+	"Use a poll queue per CPU with hybrid polling when poll_queues is not "
+	"set and the host bridge cannot steer MSIs one by one.");
+
 static bool noacpi;
 module_param(noacpi, bool, 0444);
 MODULE_PARM_DESC(noacpi, "disable acpi bios quirks");
@@ -158,6 +164,7 @@ struct nvme_dev {
 	unsigned int nr_allocated_queues;
 	unsigned int nr_write_queues;
 	unsigned int nr_poll_queues;
+	bool auto_poll;
 
 	bool attrs_added;
 };
@@ -2326,6 +2333,25 @@ static void nvme_disable_io_queues(struct nvme_dev *dev)
 		__nvme_disable_io_queues(dev, nvme_admin_delete_cq);
 }
 
+/*
+ * Behind a host bridge whose MSIs all land on one or two CPUs, completion
+ * work piles up there. Polled queues complete on the submitting CPU instead.
+ */
+static bool nvme_pci_auto_poll(struct pci_dev *pdev)
+{
+	struct pci_host_bridge *bridge = pci_find_host_bridge(pdev->bus);
+
+	return auto_poll_queues && bridge->msi_no_affinity &&
+		num_possible_cpus() > 1;
+}
+
+static unsigned int nvme_nr_poll_queues(struct nvme_dev *dev)
+{
+	if (dev->auto_poll && !poll_queues)
+		return num_possible_cpus();
+	return poll_queues;
+}
+
 static unsigned int nvme_max_io_queues(struct nvme_dev *dev)
 {
 	/*
@@ -2350,7 +2376,7 @@ static int nvme_setup_io_queues(struct nvme_dev *dev)
 	 * stable values to work with.
 	 */
 	dev->nr_write_queues = write_queues;
-	dev->nr_poll_queues = poll_queues;
+	dev->nr_poll_queues = nvme_nr_poll_queues(dev);
 
 	nr_io_queues = dev->nr_allocated_queues - 1;
 	result = nvme_set_queue_count(&dev->ctrl, &nr_io_queues);
@@ -2541,6 +2567,8 @@ static void nvme_pci_alloc_tag_set(struct nvme_dev *dev)
 	set->queue_depth = min_t(unsigned, dev->q_depth, BLK_MQ_MAX_DEPTH) - 1;
 	set->cmd_size = sizeof(struct nvme_iod);
 	set->flags = BLK_MQ_F_SHOULD_MERGE;
+	if (dev->auto_poll && !poll_queues && dev->io_queues[HCTX_TYPE_POLL])
+		set->flags |= BLK_MQ_F_HYBRID_POLL;
 	set->driver_data = dev;
 
 	/*
@@ -3104,8 +3132,9 @@ static int nvme_probe(struct pci_dev *pdev, const struct pci_device_id *id)
 	if (!dev)
 		return -ENOMEM;
 
+	dev->auto_poll = nvme_pci_auto_poll(pdev);
 	dev->nr_write_queues = write_queues;
-	dev->nr_poll_queues = poll_queues;
+	dev->nr_poll_queues = nvme_nr_poll_queues(dev);
 	dev->nr_allocated_queues = nvme_max_io_queues(dev) + 1;
 	dev->queues = kcalloc_node(dev->nr_allocated_queues,
 			sizeof(struct nvme_queue), GFP_KERNEL, node);
@@ -3,8 +3,10 @@
  * Copyright (C) 2017 - 2021 Xilinx, Inc.
  */
 
+#include <linux/bitmap.h>
 #include <linux/dma-mapping.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/nvmem-provider.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
@@ -28,6 +30,7 @@
 #define EFUSE_NOT_ENABLED	(29)
 #define EFUSE_READ		(0)
 #define EFUSE_WRITE		(1)
+#define EFUSE_CACHE_WORDS	((EFUSE_PUF_END_OFFSET + 1) / WORD_INBYTES)
 
 /**
  * struct xilinx_efuse - the basic structure
@@ -49,6 +52,30 @@ struct xilinx_efuse {
 	u32 pufuserfuse;
 };
 
+/**
+ * struct zynqmp_nvmem_data - driver data
+ * @dev:	device of the nvmem provider
+ * @lock:	protects the cache
+ * @soc_version: cached silicon revision
+ * @soc_version_valid: @soc_version holds the revision
+ * @bulk_done:	the bulk read of the eFuse rows was attempted
+ * @cache:	eFuse words, indexed by nvmem offset / 4
+ * @valid:	words of @cache that hold the fuse value
+ *
+ * The eFuses only change when they are programmed through this driver, so
+ * the words read once are served from @cache instead of a firmware call.
+ * Consumers tend to read the same cells again and again.
+ */
+struct zynqmp_nvmem_data {
+	struct device *dev;
+	struct mutex lock;
+	u32 soc_version;
+	bool soc_version_valid;
+	bool bulk_done;
+	u32 cache[EFUSE_CACHE_WORDS];
+	DECLARE_BITMAP(valid, EFUSE_CACHE_WORDS);
+};
+
 static int zynqmp_efuse_access(void *context, unsigned int offset,
 			       void *val, size_t bytes, unsigned int flag,
 			       unsigned int pufflag)
@@ -91,8 +118,7 @@ static int zynqmp_efuse_access(void *context, unsigned int offset,
 	if (!efuse)
 		return -ENOMEM;
 
-	data = dma_alloc_coherent(dev, sizeof(bytes),
-				  &dma_buf, GFP_KERNEL);
+	data = dma_alloc_coherent(dev, bytes, &dma_buf, GFP_KERNEL);
 	if (!data) {
 		dma_free_coherent(dev, sizeof(struct xilinx_efuse),
 				  efuse, dma_addr);
@@ -129,14 +155,70 @@ static int zynqmp_efuse_access(void *context, unsigned int offset,
 
 	dma_free_coherent(dev, sizeof(struct xilinx_efuse),
 			  efuse, dma_addr);
-	dma_free_coherent(dev, sizeof(bytes),
-			  data, dma_buf);
+	dma_free_coherent(dev, bytes, data, dma_buf);
+
+	return ret;
+}
+
+/*
+ * Read all non-PUF eFuse words in one firmware call. A failure is not an
+ * error, reads then go to the firmware one request at a time.
+ */
+static void zynqmp_efuse_bulk_read(struct zynqmp_nvmem_data *priv)
+{
+	unsigned int start = EFUSE_START_OFFSET / WORD_INBYTES;
+	unsigned int words = EFUSE_PUF_START_OFFSET / WORD_INBYTES - start;
+
+	priv->bulk_done = true;
+
+	if (zynqmp_efuse_access(priv->dev, EFUSE_START_OFFSET,
+				&priv->cache[start], words * WORD_INBYTES,
+				EFUSE_READ, 0))
+		return;
+
+	bitmap_set(priv->valid, start, words);
+}
+
+static int zynqmp_efuse_read(struct zynqmp_nvmem_data *priv,
+			     unsigned int offset, void *val, size_t bytes,
+			     unsigned int pufflag)
+{
+	unsigned int first = offset / WORD_INBYTES;
+	size_t words = bytes / WORD_INBYTES;
+	int ret;
+
+	/* Unaligned requests are rejected by zynqmp_efuse_access() */
+	if (offset % WORD_INBYTES || bytes % WORD_INBYTES ||
+	    first + words > EFUSE_CACHE_WORDS)
+		return zynqmp_efuse_access(priv->dev, offset, val, bytes,
+					   EFUSE_READ, pufflag);
+
+	mutex_lock(&priv->lock);
+
+	if (!priv->bulk_done)
+		zynqmp_efuse_bulk_read(priv);
+
+	if (find_next_zero_bit(priv->valid, first + words, first) ==
+	    first + words) {
+		memcpy(val, &priv->cache[first], bytes);
+		ret = 0;
+	} else {
+		ret = zynqmp_efuse_access(priv->dev, offset, val, bytes,
+					  EFUSE_READ, pufflag);
+		if (!ret) {
+			memcpy(&priv->cache[first], val, bytes);
+			bitmap_set(priv->valid, first, words);
+		}
+	}
+
+	mutex_unlock(&priv->lock);
 
 	return ret;
 }
 
 static int zynqmp_nvmem_read(void *context, unsigned int offset, void *val, size_t bytes)
 {
+	struct zynqmp_nvmem_data *priv = context;
 	int ret, pufflag = 0;
 	int idcode, version;
 
@@ -149,18 +231,27 @@ static int zynqmp_nvmem_read(void *context, unsigned int offset, void *val, size
 		if (bytes != SOC_VER_SIZE)
 			return -EOPNOTSUPP;
 
-		ret = zynqmp_pm_get_chipid((u32 *)&idcode, (u32 *)&version);
-		if (ret < 0)
-			return ret;
-
-		pr_debug("Read chipid val %x %x\n", idcode, version);
-		*(int *)val = version & SILICON_REVISION_MASK;
+		mutex_lock(&priv->lock);
+		if (!priv->soc_version_valid) {
+			ret = zynqmp_pm_get_chipid((u32 *)&idcode,
+						   (u32 *)&version);
+			if (ret < 0) {
+				mutex_unlock(&priv->lock);
+				return ret;
+			}
+
+			pr_debug("Read chipid val %x %x\n", idcode, version);
+			priv->soc_version = version & SILICON_REVISION_MASK;
+			priv->soc_version_valid = true;
+		}
+		*(int *)val = priv->soc_version;
+		mutex_unlock(&priv->lock);
+		ret = 0;
 		break;
 	/* Efuse offset starts from 0xc */
 	case EFUSE_START_OFFSET ... EFUSE_END_OFFSET:
 	case EFUSE_PUF_START_OFFSET ... EFUSE_PUF_END_OFFSET:
-		ret = zynqmp_efuse_access(context, offset, val,
-					  bytes, EFUSE_READ, pufflag);
+		ret = zynqmp_efuse_read(priv, offset, val, bytes, pufflag);
 		break;
 	default:
 		*(u32 *)val = 0xDEADBEEF;
@@ -174,7 +265,10 @@ static int zynqmp_nvmem_read(void *context, unsigned int offset, void *val, size
 static int zynqmp_nvmem_write(void *context,
 			      unsigned int offset, void *val, size_t bytes)
 {
+	struct zynqmp_nvmem_data *priv = context;
+	unsigned int first, last;
 	int pufflag = 0;
+	int ret;
 
 	if (offset < EFUSE_START_OFFSET || offset > EFUSE_PUF_END_OFFSET)
 		return -EOPNOTSUPP;
@@ -182,8 +276,21 @@ static int zynqmp_nvmem_write(void *context,
 	if (offset >= EFUSE_PUF_START_OFFSET && offset <= EFUSE_PUF_END_OFFSET)
 		pufflag = 1;
 
-	return zynqmp_efuse_access(context, offset,
-				   val, bytes, EFUSE_WRITE, pufflag);
+	mutex_lock(&priv->lock);
+
+	ret = zynqmp_efuse_access(priv->dev, offset,
+				  val, bytes, EFUSE_WRITE, pufflag);
+
+	/* Programmed words are read back from the fuses next time */
+	first = offset / WORD_INBYTES;
+	last = min_t(unsigned int, DIV_ROUND_UP(offset + bytes, WORD_INBYTES),
+		     EFUSE_CACHE_WORDS);
+	if (first < last)
+		bitmap_clear(priv->valid, first, last - first);
+
+	mutex_unlock(&priv->lock);
+
+	return ret;
 }
 
 static struct nvmem_config econfig = {
@@ -201,10 +308,18 @@ MODULE_DEVICE_TABLE(of, zynqmp_nvmem_match);
 
 static int zynqmp_nvmem_probe(struct platform_device *pdev)
 {
+	struct zynqmp_nvmem_data *priv;
 	struct nvmem_device *nvmem;
 
+	priv = devm_kzalloc(&pdev->dev, sizeof(*priv), GFP_KERNEL);
+	if (!priv)
+		return -ENOMEM;
+
+	priv->dev = &pdev->dev;
+	mutex_init(&priv->lock);
+
 	econfig.dev = &pdev->dev;
-	econfig.priv = &pdev->dev;
+	econfig.priv = priv;
 	econfig.reg_read = zynqmp_nvmem_read;
 	econfig.reg_write = zynqmp_nvmem_write;
 
@@ -17,6 +17,7 @@
 #include <linux/of_irq.h>
 #include <linux/pci.h>
 #include <linux/platform_device.h>
+#include <linux/workqueue.h>
 #include <linux/irqchip/chained_irq.h>
 
 #include "../pci.h"
@@ -96,6 +97,8 @@
 
 /* Number of MSI IRQs */
 #define XILINX_NUM_MSI_IRQS		64
+#define XILINX_MSI_GROUP_SIZE		32
+#define XILINX_MSI_GROUPS		2
 #define INTX_NUM                        4
 
 #define DMA_BRIDGE_BASE_OFF		0xCD8
@@ -118,6 +121,9 @@ struct xilinx_msi {
 	unsigned long msi_pages;
 	int irq_msi0;
 	int irq_msi1;
+	/* CPU requested for the msi0/msi1 parent lines, -1 if none */
+	int group_cpu[XILINX_MSI_GROUPS];
+	struct work_struct affinity_work;
 };
 
 /**
@@ -443,7 +449,7 @@ static struct irq_chip xilinx_msi_irq_chip = {
 
 static struct msi_domain_info xilinx_msi_domain_info = {
 	.flags = (MSI_FLAG_USE_DEF_DOM_OPS | MSI_FLAG_USE_DEF_CHIP_OPS |
-		MSI_FLAG_MULTI_PCI_MSI),
+		MSI_FLAG_MULTI_PCI_MSI | MSI_FLAG_PCI_MSIX),
 	.chip = &xilinx_msi_irq_chip,
 };
 
@@ -459,10 +465,51 @@ static void xilinx_compose_msi_msg(struct irq_data *data, struct msi_msg *msg)
 	msg->data = data->hwirq;
 }
 
+static void xilinx_msi_affinity_work(struct work_struct *work)
+{
+	struct xilinx_msi *msi = container_of(work, struct xilinx_msi,
+					      affinity_work);
+	int irqs[XILINX_MSI_GROUPS] = { msi->irq_msi0, msi->irq_msi1 };
+	int i, cpu;
+
+	for (i = 0; i < XILINX_MSI_GROUPS; i++) {
+		cpu = READ_ONCE(msi->group_cpu[i]);
+		if (cpu >= 0 && irqs[i] > 0)
+			irq_set_affinity(irqs[i], cpumask_of(cpu));
+	}
+}
+
+/*
+ * In decode mode each 32-vector half of the MSI space is raised on its own
+ * parent line, so a vector follows the line it is decoded on. Steer that
+ * line instead; every vector of the group moves with it. The parent is
+ * another descriptor whose lock cannot be taken here, so it is moved from
+ * a work item. FIFO mode funnels everything through the misc interrupt
+ * and cannot be steered per vector.
+ */
 static int xilinx_msi_set_affinity(struct irq_data *irq_data,
 				   const struct cpumask *mask, bool force)
 {
-	return -EINVAL;
+	struct xilinx_pcie_port *pcie = irq_data_get_irq_chip_data(irq_data);
+	struct xilinx_msi *msi = &pcie->msi;
+	unsigned int cpu;
+
+	if (pcie->msi_mode != MSI_DECD_MODE)
+		return -EINVAL;
+
+	if (force)
+		cpu = cpumask_first(mask);
+	else
+		cpu = cpumask_any_and(mask, cpu_online_mask);
+	if (cpu >= nr_cpu_ids)
+		return -EINVAL;
+
+	WRITE_ONCE(msi->group_cpu[irq_data->hwirq / XILINX_MSI_GROUP_SIZE],
+		   cpu);
+	schedule_work(&msi->affinity_work);
+	irq_data_update_effective_affinity(irq_data, cpumask_of(cpu));
+
+	return IRQ_SET_MASK_OK_DONE;
 }
 
 static struct irq_chip xilinx_irq_chip = {
@@ -471,6 +518,36 @@ static struct irq_chip xilinx_irq_chip = {
 	.irq_set_affinity = xilinx_msi_set_affinity,
 };
 
+/*
+ * Single vectors (MSI-X, or MSI with one message) go to the less loaded
+ * half, so the queues of a multi-queue endpoint land on both parent lines
+ * and can be steered to different CPUs.
+ */
+static int xilinx_msi_alloc_bits(struct xilinx_msi *msi, unsigned int nr_irqs)
+{
+	unsigned int lo, start, bit;
+
+	if (nr_irqs > 1)
+		return bitmap_find_free_region(msi->bitmap,
+					       XILINX_NUM_MSI_IRQS,
+					       get_count_order(nr_irqs));
+
+	lo = bitmap_weight(msi->bitmap, XILINX_MSI_GROUP_SIZE);
+	start = 0;
+	if (lo > bitmap_weight(msi->bitmap, XILINX_NUM_MSI_IRQS) - lo)
+		start = XILINX_MSI_GROUP_SIZE;
+
+	bit = find_next_zero_bit(msi->bitmap, XILINX_NUM_MSI_IRQS, start);
+	if (bit >= XILINX_NUM_MSI_IRQS)
+		bit = find_first_zero_bit(msi->bitmap, XILINX_NUM_MSI_IRQS);
+	if (bit >= XILINX_NUM_MSI_IRQS)
+		return -ENOSPC;
+
+	__set_bit(bit, msi->bitmap);
+
+	return bit;
+}
+
 static int xilinx_irq_domain_alloc(struct irq_domain *domain, unsigned int virq,
 				   unsigned int nr_irqs, void *args)
 {
@@ -480,8 +557,7 @@ static int xilinx_irq_domain_alloc(struct irq_domain *domain, unsigned int virq,
 	int i;
 
 	mutex_lock(&msi->lock);
-	bit = bitmap_find_free_region(msi->bitmap, XILINX_NUM_MSI_IRQS,
-				      get_count_order(nr_irqs));
+	bit = xilinx_msi_alloc_bits(msi, nr_irqs);
 	if (bit < 0) {
 		mutex_unlock(&msi->lock);
 		return -ENOSPC;
@@ -519,6 +595,11 @@ static int xilinx_pcie_init_msi_irq_domain(struct xilinx_pcie_port *port)
 	struct fwnode_handle *fwnode = of_node_to_fwnode(port->dev->of_node);
 	struct xilinx_msi *msi = &port->msi;
 	int size = BITS_TO_LONGS(XILINX_NUM_MSI_IRQS) * sizeof(long);
+	int i;
+
+	for (i = 0; i < XILINX_MSI_GROUPS; i++)
+		msi->group_cpu[i] = -1;
+	INIT_WORK(&msi->affinity_work, xilinx_msi_affinity_work);
 
 	msi->dev_domain = irq_domain_add_linear(NULL, XILINX_NUM_MSI_IRQS,
 						&dev_msi_domain_ops, port);
@@ -794,6 +875,8 @@ static int xilinx_pcie_probe(struct platform_device *pdev)
 	bridge->sysdata = port;
 	bridge->busnr = port->root_busno;
 	bridge->ops = &xilinx_pcie_ops;
+	/* Vectors only follow the parent line of their group */
+	bridge->msi_no_affinity = 1;
 	bridge->map_irq = of_irq_parse_and_map_pci;
 	bridge->swizzle_irq = pci_common_swizzle;
 
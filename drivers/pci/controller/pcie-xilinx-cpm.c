@@ -18,6 +18,7 @@
 #include <linux/of_platform.h>
 #include <linux/of_irq.h>
 #include <linux/pci.h>
+#include <linux/perf_event.h>
 #include <linux/platform_device.h>
 #include <linux/pci-ecam.h>
 
@@ -127,6 +128,9 @@ struct xilinx_cpm_variant {
  * @irq: Error interrupt number
  * @lock: lock protecting shared register access
  * @variant: CPM version check pointer
+ * @event_count: Number of times each bridge event was raised
+ * @pmu: perf PMU exposing @event_count
+ * @pmu_cpu: CPU the PMU events are bound to
  */
 struct xilinx_cpm_pcie {
 	struct device			*dev;
@@ -139,6 +143,9 @@ struct xilinx_cpm_pcie {
 	int				irq;
 	raw_spinlock_t			lock;
 	const struct xilinx_cpm_variant   *variant;
+	atomic64_t			event_count[32];
+	struct pmu			pmu;
+	unsigned int			pmu_cpu;
 };
 
 static u32 pcie_read(struct xilinx_cpm_pcie *port, u32 reg)
@@ -300,8 +307,10 @@ static void xilinx_cpm_pcie_event_flow(struct irq_desc *desc)
 	chained_irq_enter(chip, desc);
 	val =  pcie_read(port, XILINX_CPM_PCIE_REG_IDR);
 	val &= pcie_read(port, XILINX_CPM_PCIE_REG_IMR);
-	for_each_set_bit(i, &val, 32)
+	for_each_set_bit(i, &val, 32) {
+		atomic64_inc(&port->event_count[i]);
 		generic_handle_domain_irq(port->cpm_domain, i);
+	}
 	pcie_write(port, val, XILINX_CPM_PCIE_REG_IDR);
 
 	if (port->variant->version == CPM5) {
@@ -376,6 +385,220 @@ static irqreturn_t xilinx_cpm_pcie_intr_handler(int irq, void *dev_id)
 	return IRQ_HANDLED;
 }
 
+#ifdef CONFIG_PERF_EVENTS
+#define to_cpm_pcie(p) container_of(p, struct xilinx_cpm_pcie, pmu)
+
+static u64 xilinx_cpm_pmu_count(struct perf_event *event)
+{
+	struct xilinx_cpm_pcie *port = to_cpm_pcie(event->pmu);
+
+	return atomic64_read(&port->event_count[event->attr.config]);
+}
+
+static void xilinx_cpm_pmu_read(struct perf_event *event)
+{
+	struct hw_perf_event *hwc = &event->hw;
+	u64 prev, now;
+
+	now = xilinx_cpm_pmu_count(event);
+	prev = local64_xchg(&hwc->prev_count, now);
+	local64_add(now - prev, &event->count);
+}
+
+static int xilinx_cpm_pmu_event_init(struct perf_event *event)
+{
+	struct xilinx_cpm_pcie *port = to_cpm_pcie(event->pmu);
+	u64 config = event->attr.config;
+
+	if (event->attr.type != event->pmu->type)
+		return -ENOENT;
+
+	/* The counters belong to the bridge, not to a task */
+	if (is_sampling_event(event) || event->attach_state & PERF_ATTACH_TASK)
+		return -EOPNOTSUPP;
+
+	if (event->cpu < 0)
+		return -EINVAL;
+
+	if (config >= ARRAY_SIZE(intr_cause) || !intr_cause[config].sym)
+		return -EINVAL;
+
+	event->cpu = port->pmu_cpu;
+
+	return 0;
+}
+
+static void xilinx_cpm_pmu_start(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	local64_set(&hwc->prev_count, xilinx_cpm_pmu_count(event));
+	hwc->state = 0;
+}
+
+static void xilinx_cpm_pmu_stop(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	if (!(hwc->state & PERF_HES_UPTODATE))
+		xilinx_cpm_pmu_read(event);
+
+	hwc->state |= PERF_HES_STOPPED | PERF_HES_UPTODATE;
+}
+
+static int xilinx_cpm_pmu_add(struct perf_event *event, int flags)
+{
+	event->hw.state = PERF_HES_STOPPED | PERF_HES_UPTODATE;
+
+	if (flags & PERF_EF_START)
+		xilinx_cpm_pmu_start(event, flags);
+
+	return 0;
+}
+
+static void xilinx_cpm_pmu_del(struct perf_event *event, int flags)
+{
+	xilinx_cpm_pmu_stop(event, PERF_EF_UPDATE);
+}
+
+static ssize_t cpumask_show(struct device *dev, struct device_attribute *attr,
+			    char *buf)
+{
+	struct xilinx_cpm_pcie *port = to_cpm_pcie(dev_get_drvdata(dev));
+
+	return cpumap_print_to_pagebuf(true, buf, cpumask_of(port->pmu_cpu));
+}
+static DEVICE_ATTR_RO(cpumask);
+
+static struct attribute *xilinx_cpm_pmu_cpumask_attrs[] = {
+	&dev_attr_cpumask.attr,
+	NULL
+};
+
+static const struct attribute_group xilinx_cpm_pmu_cpumask_group = {
+	.attrs = xilinx_cpm_pmu_cpumask_attrs,
+};
+
+PMU_FORMAT_ATTR(event, "config:0-4");
+
+static struct attribute *xilinx_cpm_pmu_format_attrs[] = {
+	&format_attr_event.attr,
+	NULL
+};
+
+static const struct attribute_group xilinx_cpm_pmu_format_group = {
+	.name = "format",
+	.attrs = xilinx_cpm_pmu_format_attrs,
+};
+
+#define XILINX_CPM_PMU_EVENT(n, x)					\
+	PMU_EVENT_ATTR_STRING(n, event_attr_##n,			\
+			      "event=" __stringify(XILINX_CPM_PCIE_INTR_##x))
+
+XILINX_CPM_PMU_EVENT(link_down, LINK_DOWN);
+XILINX_CPM_PMU_EVENT(hot_reset, HOT_RESET);
+XILINX_CPM_PMU_EVENT(cfg_pcie_timeout, CFG_PCIE_TIMEOUT);
+XILINX_CPM_PMU_EVENT(cfg_timeout, CFG_TIMEOUT);
+XILINX_CPM_PMU_EVENT(correctable, CORRECTABLE);
+XILINX_CPM_PMU_EVENT(nonfatal, NONFATAL);
+XILINX_CPM_PMU_EVENT(fatal, FATAL);
+XILINX_CPM_PMU_EVENT(cfg_err_poison, CFG_ERR_POISON);
+XILINX_CPM_PMU_EVENT(pme_to_ack_rcvd, PME_TO_ACK_RCVD);
+XILINX_CPM_PMU_EVENT(intx, INTX);
+XILINX_CPM_PMU_EVENT(pm_pme_rcvd, PM_PME_RCVD);
+XILINX_CPM_PMU_EVENT(slv_unsupp, SLV_UNSUPP);
+XILINX_CPM_PMU_EVENT(slv_unexp, SLV_UNEXP);
+XILINX_CPM_PMU_EVENT(slv_compl, SLV_COMPL);
+XILINX_CPM_PMU_EVENT(slv_errp, SLV_ERRP);
+XILINX_CPM_PMU_EVENT(slv_cmpabt, SLV_CMPABT);
+XILINX_CPM_PMU_EVENT(slv_illbur, SLV_ILLBUR);
+XILINX_CPM_PMU_EVENT(mst_decerr, MST_DECERR);
+XILINX_CPM_PMU_EVENT(mst_slverr, MST_SLVERR);
+XILINX_CPM_PMU_EVENT(slv_pcie_timeout, SLV_PCIE_TIMEOUT);
+
+static struct attribute *xilinx_cpm_pmu_event_attrs[] = {
+	&event_attr_link_down.attr.attr,
+	&event_attr_hot_reset.attr.attr,
+	&event_attr_cfg_pcie_timeout.attr.attr,
+	&event_attr_cfg_timeout.attr.attr,
+	&event_attr_correctable.attr.attr,
+	&event_attr_nonfatal.attr.attr,
+	&event_attr_fatal.attr.attr,
+	&event_attr_cfg_err_poison.attr.attr,
+	&event_attr_pme_to_ack_rcvd.attr.attr,
+	&event_attr_intx.attr.attr,
+	&event_attr_pm_pme_rcvd.attr.attr,
+	&event_attr_slv_unsupp.attr.attr,
+	&event_attr_slv_unexp.attr.attr,
+	&event_attr_slv_compl.attr.attr,
+	&event_attr_slv_errp.attr.attr,
+	&event_attr_slv_cmpabt.attr.attr,
+	&event_attr_slv_illbur.attr.attr,
+	&event_attr_mst_decerr.attr.attr,
+	&event_attr_mst_slverr.attr.attr,
+	&event_attr_slv_pcie_timeout.attr.attr,
+	NULL
+};
+
+static const struct attribute_group xilinx_cpm_pmu_events_group = {
+	.name = "events",
+	.attrs = xilinx_cpm_pmu_event_attrs,
+};
+
+static const struct attribute_group *xilinx_cpm_pmu_attr_groups[] = {
+	&xilinx_cpm_pmu_cpumask_group,
+	&xilinx_cpm_pmu_format_group,
+	&xilinx_cpm_pmu_events_group,
+	NULL
+};
+
+/**
+ * xilinx_cpm_pmu_register - Expose the bridge event counters to perf
+ * @port: PCIe port information
+ * @bridge: Host bridge the port was probed with
+ *
+ * The bridge has no traffic counters of its own, but every event it
+ * raises goes through xilinx_cpm_pcie_event_flow(). Those counts are
+ * offered as a system-wide PMU, e.g. "perf stat -a -e
+ * xilinx_cpm_pcie0/correctable/". A failure here is not fatal.
+ */
+static void xilinx_cpm_pmu_register(struct xilinx_cpm_pcie *port,
+				    struct pci_host_bridge *bridge)
+{
+	struct device *dev = port->dev;
+	char *name;
+	int err;
+
+	name = devm_kasprintf(dev, GFP_KERNEL, "xilinx_cpm_pcie%d",
+			      pci_domain_nr(bridge->bus));
+	if (!name)
+		return;
+
+	port->pmu_cpu = raw_smp_processor_id();
+	port->pmu = (struct pmu) {
+		.module		= THIS_MODULE,
+		.task_ctx_nr	= perf_invalid_context,
+		.capabilities	= PERF_PMU_CAP_NO_EXCLUDE,
+		.attr_groups	= xilinx_cpm_pmu_attr_groups,
+		.event_init	= xilinx_cpm_pmu_event_init,
+		.add		= xilinx_cpm_pmu_add,
+		.del		= xilinx_cpm_pmu_del,
+		.start		= xilinx_cpm_pmu_start,
+		.stop		= xilinx_cpm_pmu_stop,
+		.read		= xilinx_cpm_pmu_read,
+	};
+
+	err = perf_pmu_register(&port->pmu, name, -1);
+	if (err)
+		dev_warn(dev, "Failed to register PMU: %d\n", err);
+}
+#else
+static inline void xilinx_cpm_pmu_register(struct xilinx_cpm_pcie *port,
+					   struct pci_host_bridge *bridge)
+{
+}
+#endif /* CONFIG_PERF_EVENTS */
+
 static void xilinx_cpm_free_irq_domains(struct xilinx_cpm_pcie *port)
 {
 	if (port->intx_domain) {
@@ -621,6 +844,8 @@ static int xilinx_cpm_pcie_probe(struct platform_device *pdev)
 	if (err < 0)
 		goto err_host_bridge;
 
+	xilinx_cpm_pmu_register(port, bridge);
+
 	return 0;
 
 err_host_bridge:
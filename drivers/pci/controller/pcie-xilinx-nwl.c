@@ -21,6 +21,7 @@
 #include <linux/pci.h>
 #include <linux/pci-ecam.h>
 #include <linux/platform_device.h>
+#include <linux/workqueue.h>
 #include <linux/irqchip/chained_irq.h>
 
 #include "../pci.h"
@@ -133,6 +134,8 @@
 #define CFG_PCIE_CACHE			GENMASK(7, 0)
 
 #define INT_PCI_MSI_NR			(2 * 32)
+#define NWL_MSI_GROUP_SIZE		32
+#define NWL_MSI_GROUPS			(INT_PCI_MSI_NR / NWL_MSI_GROUP_SIZE)
 
 /* Readin the PS_LINKUP */
 #define PS_LINKUP_OFFSET		0x00000238
@@ -151,6 +154,9 @@ struct nwl_msi {			/* MSI information */
 	struct mutex lock;		/* protect bitmap variable */
 	int irq_msi0;
 	int irq_msi1;
+	/* CPU requested for the msi0/msi1 parent lines, -1 if none */
+	int group_cpu[NWL_MSI_GROUPS];
+	struct work_struct affinity_work;
 };
 
 struct nwl_pcie {
@@ -339,10 +345,12 @@ static void nwl_pcie_handle_msi_irq(struct nwl_pcie *pcie, u32 status_reg)
 	unsigned long status;
 	u32 bit;
 
+	u32 base = status_reg == MSGF_MSI_STATUS_HI ? NWL_MSI_GROUP_SIZE : 0;
+
 	while ((status = nwl_bridge_readl(pcie, status_reg)) != 0) {
 		for_each_set_bit(bit, &status, 32) {
 			nwl_bridge_writel(pcie, 1 << bit, status_reg);
-			generic_handle_domain_irq(msi->dev_domain, bit);
+			generic_handle_domain_irq(msi->dev_domain, base + bit);
 		}
 	}
 }
@@ -429,7 +437,7 @@ static struct irq_chip nwl_msi_irq_chip = {
 
 static struct msi_domain_info nwl_msi_domain_info = {
 	.flags = (MSI_FLAG_USE_DEF_DOM_OPS | MSI_FLAG_USE_DEF_CHIP_OPS |
-		  MSI_FLAG_MULTI_PCI_MSI),
+		  MSI_FLAG_MULTI_PCI_MSI | MSI_FLAG_PCI_MSIX),
 	.chip = &nwl_msi_irq_chip,
 };
 #endif
@@ -444,10 +452,46 @@ static void nwl_compose_msi_msg(struct irq_data *data, struct msi_msg *msg)
 	msg->data = data->hwirq;
 }
 
+static void nwl_msi_affinity_work(struct work_struct *work)
+{
+	struct nwl_msi *msi = container_of(work, struct nwl_msi,
+					   affinity_work);
+	int irqs[NWL_MSI_GROUPS] = { msi->irq_msi0, msi->irq_msi1 };
+	int i, cpu;
+
+	for (i = 0; i < NWL_MSI_GROUPS; i++) {
+		cpu = READ_ONCE(msi->group_cpu[i]);
+		if (cpu >= 0 && irqs[i] > 0)
+			irq_set_affinity(irqs[i], cpumask_of(cpu));
+	}
+}
+
+/*
+ * The bridge raises each 32-vector half of the MSI space on its own parent
+ * line, so a vector follows the line it is decoded on. Steer that line
+ * instead; every vector of the group moves with it. The parent is another
+ * descriptor whose lock cannot be taken here, so it is moved from a work
+ * item.
+ */
 static int nwl_msi_set_affinity(struct irq_data *irq_data,
 				const struct cpumask *mask, bool force)
 {
-	return -EINVAL;
+	struct nwl_pcie *pcie = irq_data_get_irq_chip_data(irq_data);
+	struct nwl_msi *msi = &pcie->msi;
+	unsigned int cpu;
+
+	if (force)
+		cpu = cpumask_first(mask);
+	else
+		cpu = cpumask_any_and(mask, cpu_online_mask);
+	if (cpu >= nr_cpu_ids)
+		return -EINVAL;
+
+	WRITE_ONCE(msi->group_cpu[irq_data->hwirq / NWL_MSI_GROUP_SIZE], cpu);
+	schedule_work(&msi->affinity_work);
+	irq_data_update_effective_affinity(irq_data, cpumask_of(cpu));
+
+	return IRQ_SET_MASK_OK_DONE;
 }
 
 static struct irq_chip nwl_irq_chip = {
@@ -456,6 +500,35 @@ static struct irq_chip nwl_irq_chip = {
 	.irq_set_affinity = nwl_msi_set_affinity,
 };
 
+/*
+ * Single vectors (MSI-X, or MSI with one message) go to the less loaded
+ * half, so the queues of a multi-queue endpoint land on both parent lines
+ * and can be steered to different CPUs.
+ */
+static int nwl_msi_alloc_bits(struct nwl_msi *msi, unsigned int nr_irqs)
+{
+	unsigned int lo, start, bit;
+
+	if (nr_irqs > 1)
+		return bitmap_find_free_region(msi->bitmap, INT_PCI_MSI_NR,
+					       get_count_order(nr_irqs));
+
+	lo = bitmap_weight(msi->bitmap, NWL_MSI_GROUP_SIZE);
+	start = 0;
+	if (lo > bitmap_weight(msi->bitmap, INT_PCI_MSI_NR) - lo)
+		start = NWL_MSI_GROUP_SIZE;
+
+	bit = find_next_zero_bit(msi->bitmap, INT_PCI_MSI_NR, start);
+	if (bit >= INT_PCI_MSI_NR)
+		bit = find_first_zero_bit(msi->bitmap, INT_PCI_MSI_NR);
+	if (bit >= INT_PCI_MSI_NR)
+		return -ENOSPC;
+
+	__set_bit(bit, msi->bitmap);
+
+	return bit;
+}
+
 static int nwl_irq_domain_alloc(struct irq_domain *domain, unsigned int virq,
 				unsigned int nr_irqs, void *args)
 {
@@ -465,8 +538,7 @@ static int nwl_irq_domain_alloc(struct irq_domain *domain, unsigned int virq,
 	int i;
 
 	mutex_lock(&msi->lock);
-	bit = bitmap_find_free_region(msi->bitmap, INT_PCI_MSI_NR,
-				      get_count_order(nr_irqs));
+	bit = nwl_msi_alloc_bits(msi, nr_irqs);
 	if (bit < 0) {
 		mutex_unlock(&msi->lock);
 		return -ENOSPC;
@@ -505,6 +577,11 @@ static int nwl_pcie_init_msi_irq_domain(struct nwl_pcie *pcie)
 	struct device *dev = pcie->dev;
 	struct fwnode_handle *fwnode = of_node_to_fwnode(dev->of_node);
 	struct nwl_msi *msi = &pcie->msi;
+	int i;
+
+	for (i = 0; i < NWL_MSI_GROUPS; i++)
+		msi->group_cpu[i] = -1;
+	INIT_WORK(&msi->affinity_work, nwl_msi_affinity_work);
 
 	msi->dev_domain = irq_domain_add_linear(NULL, INT_PCI_MSI_NR,
 						&dev_msi_domain_ops, pcie);
@@ -825,6 +902,8 @@ static int nwl_pcie_probe(struct platform_device *pdev)
 
 	bridge->sysdata = pcie;
 	bridge->ops = &nwl_pcie_ops;
+	/* Vectors only follow the parent line of their group */
+	bridge->msi_no_affinity = 1;
 
 	if (IS_ENABLED(CONFIG_PCI_MSI)) {
 		err = nwl_pcie_enable_msi(pcie);
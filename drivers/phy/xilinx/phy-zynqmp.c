@@ -16,6 +16,8 @@
 #include <linux/clk.h>
 #include <linux/delay.h>
 #include <linux/io.h>
+#include <linux/iopoll.h>
+#include <linux/ktime.h>
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/of.h>
@@ -164,6 +166,7 @@
 
 /* Timeout values */
 #define TIMEOUT_US			1000
+#define PLL_LOCK_POLL_US		10
 
 struct xpsgtr_dev;
 
@@ -190,6 +193,11 @@ struct xpsgtr_ssc {
  * @skip_phy_init: skip phy_init() if true
  * @dev: pointer to the xpsgtr_dev instance
  * @refclk: reference clock index
+ * @configured: the lane has been configured for @cfg_protocol and @cfg_refclk
+ * @cfg_protocol: protocol the lane was last configured for
+ * @cfg_refclk: reference clock the lane was last configured for
+ * @reused: the last phy_init() found the lane configured and locked
+ * @init_start: time at which the last phy_init() started
  */
 struct xpsgtr_phy {
 	struct phy *phy;
@@ -199,6 +207,11 @@ struct xpsgtr_phy {
 	bool skip_phy_init;
 	struct xpsgtr_dev *dev;
 	unsigned int refclk;
+	bool configured;
+	u8 cfg_protocol;
+	unsigned int cfg_refclk;
+	bool reused;
+	ktime_t init_start;
 };
 
 /**
@@ -302,31 +315,28 @@ static inline void xpsgtr_clr_set_phy(struct xpsgtr_phy *gtr_phy,
  * Hardware Configuration
  */
 
-/* Wait for the PLL to lock (with a timeout). */
+static bool xpsgtr_pll_locked(struct xpsgtr_phy *gtr_phy)
+{
+	u32 reg = xpsgtr_read_phy(gtr_phy, L0_PLL_STATUS_READ_1);
+
+	return (reg & PLL_STATUS_LOCKED) == PLL_STATUS_LOCKED;
+}
+
+/*
+ * Wait for the PLL to lock (with a timeout). The wait sleeps, so that lanes
+ * brought up by different controllers at the same time lock in parallel.
+ */
 static int xpsgtr_wait_pll_lock(struct phy *phy)
 {
 	struct xpsgtr_phy *gtr_phy = phy_get_drvdata(phy);
 	struct xpsgtr_dev *gtr_dev = gtr_phy->dev;
-	unsigned int timeout = TIMEOUT_US;
+	bool locked;
 	int ret;
 
 	dev_dbg(gtr_dev->dev, "Waiting for PLL lock\n");
 
-	while (1) {
-		u32 reg = xpsgtr_read_phy(gtr_phy, L0_PLL_STATUS_READ_1);
-
-		if ((reg & PLL_STATUS_LOCKED) == PLL_STATUS_LOCKED) {
-			ret = 0;
-			break;
-		}
-
-		if (--timeout == 0) {
-			ret = -ETIMEDOUT;
-			break;
-		}
-
-		udelay(1);
-	}
+	ret = read_poll_timeout(xpsgtr_pll_locked, locked, locked,
+				PLL_LOCK_POLL_US, TIMEOUT_US, false, gtr_phy);
 
 	if (ret == -ETIMEDOUT)
 		dev_err(gtr_dev->dev,
@@ -412,6 +422,35 @@ static void xpsgtr_lane_set_protocol(struct xpsgtr_phy *gtr_phy)
 	}
 }
 
+/*
+ * Check whether the lane still runs with the protocol, reference clock and
+ * PLL settings of its last configuration, with the PLL locked. This is the
+ * case when a controller re-initializes its PHY, e.g. on hotplug or when
+ * the FPD stayed powered over a suspend.
+ */
+static bool xpsgtr_lane_configured(struct xpsgtr_phy *gtr_phy)
+{
+	struct xpsgtr_dev *gtr_dev = gtr_phy->dev;
+	const struct xpsgtr_ssc *ssc = gtr_dev->refclk_sscs[gtr_phy->refclk];
+	u32 icm;
+
+	if (!gtr_phy->configured || gtr_phy->cfg_protocol != gtr_phy->protocol ||
+	    gtr_phy->cfg_refclk != gtr_phy->refclk)
+		return false;
+
+	icm = xpsgtr_read(gtr_dev, gtr_phy->lane < 2 ? ICM_CFG0 : ICM_CFG1);
+	if (gtr_phy->lane & 1)
+		icm >>= ICM_CFG_SHIFT;
+	if ((icm & ICM_CFG0_L0_MASK) != gtr_phy->protocol)
+		return false;
+
+	if ((xpsgtr_read(gtr_dev, PLL_REF_SEL(gtr_phy->lane)) & PLL_FREQ_MASK) !=
+	    ssc->pll_ref_clk)
+		return false;
+
+	return xpsgtr_pll_locked(gtr_phy);
+}
+
 /* Bypass (de)scrambler and 8b/10b decoder and encoder. */
 static void xpsgtr_bypass_scrambler_8b10b(struct xpsgtr_phy *gtr_phy)
 {
@@ -580,6 +619,13 @@ static int xpsgtr_phy_init(struct phy *phy)
 	if (!xpsgtr_phy_init_required(gtr_phy))
 		goto out;
 
+	gtr_phy->init_start = ktime_get();
+
+	/* Nothing to do if the lane is still set up the same way. */
+	gtr_phy->reused = xpsgtr_lane_configured(gtr_phy);
+	if (gtr_phy->reused)
+		goto out;
+
 	if (gtr_dev->tx_term_fix) {
 		ret = xpsgtr_phy_tx_term_fix(gtr_phy);
 		if (ret < 0)
@@ -612,6 +658,10 @@ static int xpsgtr_phy_init(struct phy *phy)
 		break;
 	}
 
+	gtr_phy->configured = true;
+	gtr_phy->cfg_protocol = gtr_phy->protocol;
+	gtr_phy->cfg_refclk = gtr_phy->refclk;
+
 out:
 	mutex_unlock(&gtr_dev->gtr_mutex);
 	return ret;
@@ -643,10 +693,16 @@ static int xpsgtr_phy_power_on(struct phy *phy)
 	 * cumulating waits for both lanes. The user is expected to initialize
 	 * lane 0 last.
 	 */
-	if (gtr_phy->protocol != ICM_PROTOCOL_DP ||
-	    gtr_phy->type == XPSGTR_TYPE_DP_0)
+	if (!gtr_phy->reused && (gtr_phy->protocol != ICM_PROTOCOL_DP ||
+				 gtr_phy->type == XPSGTR_TYPE_DP_0))
 		ret = xpsgtr_wait_pll_lock(phy);
 
+	if (!ret)
+		dev_dbg(gtr_phy->dev->dev, "lane %u: ready after %lld us%s\n",
+			gtr_phy->lane,
+			ktime_us_delta(ktime_get(), gtr_phy->init_start),
+			gtr_phy->reused ? " (configuration kept)" : "");
+
 	return ret;
 }
 
@@ -943,6 +943,44 @@ struct xhdmiphy_mmcm {
 	u16 clkout2_div;
 };
 
+#define XHDMIPHY_MMCM_CACHE_SIZE	8
+
+/**
+ * struct xhdmiphy_mmcm_cache_entry - one solved MMCM search
+ * @linerate:	line rate the MMCM was solved for
+ * @refclk:	reference clock of the direction at that time
+ * @samplerate:	TX oversampling rate (always 1 for RX)
+ * @tmdsclock_ratio: RX TMDS clock ratio (always 0 for TX)
+ * @ppc:	pixels per clock
+ * @bpc:	bits per color component
+ * @valid:	entry holds a result
+ * @mmcm:	the resulting MMCM settings
+ */
+struct xhdmiphy_mmcm_cache_entry {
+	u64 linerate;
+	u32 refclk;
+	u8 samplerate;
+	u8 tmdsclock_ratio;
+	u8 ppc;
+	u8 bpc;
+	u8 valid;
+	struct xhdmiphy_mmcm mmcm;
+};
+
+/**
+ * struct xhdmiphy_mmcm_cache - per direction MMCM settings cache
+ * @entry:	solved MMCM searches, replaced round robin
+ * @next:	next entry to replace
+ * @programmed:	settings last written to the MMCM over DRP
+ * @programmed_valid: @programmed reflects the hardware
+ */
+struct xhdmiphy_mmcm_cache {
+	struct xhdmiphy_mmcm_cache_entry entry[XHDMIPHY_MMCM_CACHE_SIZE];
+	u8 next;
+	struct xhdmiphy_mmcm programmed;
+	bool programmed_valid;
+};
+
 struct quad {
 	union {
 		struct {
@@ -1036,6 +1074,7 @@ struct xhdmiphy_dev {
 	struct hdmi21_cfg tx_hdmi21_cfg;
 	struct hdmi21_cfg rx_hdmi21_cfg;
 	struct quad quad;
+	struct xhdmiphy_mmcm_cache mmcm_cache[2];	/* indexed by enum dir */
 	struct gpio_desc *rxch4_gpio;
 	u32 rx_refclk_hz;
 	u32 tx_refclk_hz;
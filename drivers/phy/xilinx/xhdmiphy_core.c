@@ -668,9 +668,12 @@ static unsigned int xhdmiphy_drp_access(struct xhdmiphy_dev *inst,
 			(4 * (XHDMIPHY_CH2IDX(chid)));
 	}
 
-	err = readl_poll_timeout(inst->phy_base + reg_off_sts, reg_val,
-				 !(reg_val & XHDMIPHY_DRP_STATUS_DRPBUSY_MASK),
-				 1, 100);
+	/*
+	 * A DRP transaction completes within a few DRP clock cycles, so spin
+	 * rather than sleep: a rate change issues dozens of them.
+	 */
+	err = readl_poll_timeout_atomic(inst->phy_base + reg_off_sts, reg_val,
+			!(reg_val & XHDMIPHY_DRP_STATUS_DRPBUSY_MASK), 1, 100);
 	if (err == -ETIMEDOUT) {
 		dev_err(inst->dev, "drp busy timeout\n");
 		return err;
@@ -686,9 +689,8 @@ static unsigned int xhdmiphy_drp_access(struct xhdmiphy_dev *inst,
 	}
 	xhdmiphy_write(inst, reg_off_ctrl, reg_val);
 
-	err = readl_poll_timeout(inst->phy_base + reg_off_sts, reg_val,
-				 (reg_val & XHDMIPHY_DRP_STATUS_DRPRDY_MASK),
-				 1, 100);
+	err = readl_poll_timeout_atomic(inst->phy_base + reg_off_sts, reg_val,
+			(reg_val & XHDMIPHY_DRP_STATUS_DRPRDY_MASK), 1, 100);
 	if (err == -ETIMEDOUT) {
 		dev_err(inst->dev, "drp ready timeout\n");
 		return err;
@@ -927,9 +927,21 @@ static bool xhdmiphy_wr_mmcm4_params(struct xhdmiphy_dev *inst, enum dir dir)
 	return 0;
 }
 
+static bool xhdmiphy_mmcm_equal(const struct xhdmiphy_mmcm *a,
+				const struct xhdmiphy_mmcm *b)
+{
+	return a->clkfbout_mult == b->clkfbout_mult &&
+	       a->divclk_divide == b->divclk_divide &&
+	       a->clkout0_div == b->clkout0_div &&
+	       a->clkout1_div == b->clkout1_div &&
+	       a->clkout2_div == b->clkout2_div;
+}
+
 void xhdmiphy_mmcm_start(struct xhdmiphy_dev *inst, enum dir dir)
 {
+	struct xhdmiphy_mmcm_cache *cache;
 	struct xhdmiphy_mmcm *mmcm_ptr;
+	bool err;
 
 	if (dir == XHDMIPHY_DIR_RX)
 		mmcm_ptr = &inst->quad.rx_mmcm;
@@ -956,13 +968,22 @@ void xhdmiphy_mmcm_start(struct xhdmiphy_dev *inst, enum dir dir)
 			return;
 	}
 
+	cache = &inst->mmcm_cache[dir];
+
 	xhdmiphy_mmcm_reset(inst, dir, true);
 
-	if (inst->conf.gt_type != XHDMIPHY_GTYE5 &&
-	    inst->conf.gt_type != XHDMIPHY_GTYP)
-		xhdmiphy_wr_mmcm4_params(inst, dir);
-	else
-		xhdmiphy_wr_mmcm5_params(inst, dir);
+	/* DRP settings survive the MMCM reset, only rewrite them on change */
+	if (!cache->programmed_valid ||
+	    !xhdmiphy_mmcm_equal(&cache->programmed, mmcm_ptr)) {
+		if (inst->conf.gt_type != XHDMIPHY_GTYE5 &&
+		    inst->conf.gt_type != XHDMIPHY_GTYP)
+			err = xhdmiphy_wr_mmcm4_params(inst, dir);
+		else
+			err = xhdmiphy_wr_mmcm5_params(inst, dir);
+
+		cache->programmed = *mmcm_ptr;
+		cache->programmed_valid = !err;
+	}
 
 	xhdmiphy_mmcm_reset(inst, dir, false);
 	xhdmiphy_mmcm_lock_en(inst, dir, false);
@@ -1128,58 +1149,15 @@ static void xhdmiphy_set_clkout2_div(struct xhdmiphy_dev *inst, enum dir dir,
 	}
 }
 
-/**
- * xhdmiphy_cal_mmcm_param - This function calculates the HDMI mmcm parameters.
- *
- * @inst:	inst is a pointer to the Hdmiphy core instance
- * @chid:	chid is the channel ID to operate on
- * @dir:	dir is an indicator for RX or TX
- * @ppc:	ppc specifies the total number of pixels per clock
- *		- 1 = XVIDC_PPC_1
- *		- 2 = XVIDC_PPC_2
- *		- 4 = XVIDC_PPC_4
- * @bpc:	bpc specifies the color depth/bits per color component
- *		- 6 = XVIDC_BPC_6
- *		- 8 = XVIDC_BPC_8
- *		- 10 = XVIDC_BPC_10
- *		- 12 = XVIDC_BPC_12
- *		- 16 = XVIDC_BPC_16
- *
- * @return:	- 0 if calculated PLL parameters updated successfully
- *		- 1 if parameters not updated
- */
-u32 xhdmiphy_cal_mmcm_param(struct xhdmiphy_dev *inst, enum chid chid,
-			    enum dir dir, enum ppc ppc, enum color_depth bpc)
+static u32 xhdmiphy_search_mmcm_param(struct xhdmiphy_dev *inst,
+				      enum dir dir, enum ppc ppc,
+				      enum color_depth bpc, u64 linerate)
 {
 	struct xhdmiphy_mmcm *mmcm_ptr;
-	enum pll_type pll_type;
-	u64 linerate = 0;
 	u32 refclk, div, mult;
 	u16 mult_div;
 	u8 valid;
 
-	pll_type = xhdmiphy_get_pll_type(inst, dir, XHDMIPHY_CHID_CH1);
-
-	switch (pll_type) {
-	case XHDMIPHY_PLL_QPLL:
-	case XHDMIPHY_PLL_QPLL0:
-	case XHDMIPHY_PLL_LCPLL:
-		linerate = inst->quad.cmn0.linerate;
-		break;
-	case XHDMIPHY_PLL_QPLL1:
-	case XHDMIPHY_PLL_RPLL:
-		linerate = inst->quad.cmn1.linerate;
-		break;
-	default:
-		linerate = inst->quad.ch1.linerate;
-		break;
-	}
-
-	if (((linerate / 1000000) > 2970) && ppc == XVIDC_PPC_1) {
-		dev_err(inst->dev, "ppc not supported\n");
-		return 1;
-	}
-
 	div = 1;
 	do {
 		if (dir == XHDMIPHY_DIR_RX) {
@@ -1413,6 +1391,105 @@ u32 xhdmiphy_cal_mmcm_param(struct xhdmiphy_dev *inst, enum chid chid,
 	return 1;
 }
 
+/**
+ * xhdmiphy_cal_mmcm_param - This function calculates the HDMI mmcm parameters.
+ *
+ * @inst:	inst is a pointer to the Hdmiphy core instance
+ * @chid:	chid is the channel ID to operate on
+ * @dir:	dir is an indicator for RX or TX
+ * @ppc:	ppc specifies the total number of pixels per clock
+ *		- 1 = XVIDC_PPC_1
+ *		- 2 = XVIDC_PPC_2
+ *		- 4 = XVIDC_PPC_4
+ * @bpc:	bpc specifies the color depth/bits per color component
+ *		- 6 = XVIDC_BPC_6
+ *		- 8 = XVIDC_BPC_8
+ *		- 10 = XVIDC_BPC_10
+ *		- 12 = XVIDC_BPC_12
+ *		- 16 = XVIDC_BPC_16
+ *
+ * @return:	- 0 if calculated PLL parameters updated successfully
+ *		- 1 if parameters not updated
+ */
+u32 xhdmiphy_cal_mmcm_param(struct xhdmiphy_dev *inst, enum chid chid,
+			    enum dir dir, enum ppc ppc, enum color_depth bpc)
+{
+	struct xhdmiphy_mmcm_cache *cache = &inst->mmcm_cache[dir];
+	struct xhdmiphy_mmcm_cache_entry *entry;
+	struct xhdmiphy_mmcm *mmcm_ptr;
+	enum pll_type pll_type;
+	u64 linerate = 0;
+	u8 samplerate, ratio;
+	u32 refclk;
+	int i;
+
+	pll_type = xhdmiphy_get_pll_type(inst, dir, XHDMIPHY_CHID_CH1);
+
+	switch (pll_type) {
+	case XHDMIPHY_PLL_QPLL:
+	case XHDMIPHY_PLL_QPLL0:
+	case XHDMIPHY_PLL_LCPLL:
+		linerate = inst->quad.cmn0.linerate;
+		break;
+	case XHDMIPHY_PLL_QPLL1:
+	case XHDMIPHY_PLL_RPLL:
+		linerate = inst->quad.cmn1.linerate;
+		break;
+	default:
+		linerate = inst->quad.ch1.linerate;
+		break;
+	}
+
+	if (((linerate / 1000000) > 2970) && ppc == XVIDC_PPC_1) {
+		dev_err(inst->dev, "ppc not supported\n");
+		return 1;
+	}
+
+	if (dir == XHDMIPHY_DIR_RX) {
+		mmcm_ptr = &inst->quad.rx_mmcm;
+		refclk = inst->rx_refclk_hz;
+		samplerate = 1;
+		ratio = inst->rx_tmdsclock_ratio;
+	} else {
+		mmcm_ptr = &inst->quad.tx_mmcm;
+		refclk = inst->tx_refclk_hz;
+		samplerate = inst->tx_samplerate;
+		ratio = 0;
+	}
+
+	/*
+	 * The search below walks up to a few thousand divider pairs. Sources
+	 * flip between a handful of rates, so keep the recent solutions.
+	 */
+	for (i = 0; i < XHDMIPHY_MMCM_CACHE_SIZE; i++) {
+		entry = &cache->entry[i];
+		if (entry->valid && entry->linerate == linerate &&
+		    entry->refclk == refclk &&
+		    entry->samplerate == samplerate &&
+		    entry->tmdsclock_ratio == ratio &&
+		    entry->ppc == ppc && entry->bpc == bpc) {
+			*mmcm_ptr = entry->mmcm;
+			return 0;
+		}
+	}
+
+	if (xhdmiphy_search_mmcm_param(inst, dir, ppc, bpc, linerate))
+		return 1;
+
+	entry = &cache->entry[cache->next];
+	cache->next = (cache->next + 1) % XHDMIPHY_MMCM_CACHE_SIZE;
+	entry->linerate = linerate;
+	entry->refclk = refclk;
+	entry->samplerate = samplerate;
+	entry->tmdsclock_ratio = ratio;
+	entry->ppc = ppc;
+	entry->bpc = bpc;
+	entry->mmcm = *mmcm_ptr;
+	entry->valid = 1;
+
+	return 0;
+}
+
 /**
  * xhdmiphy_clk_cal_params - This function will try to find the necessary PLL
  * divisor values to produce the configured line rate given the specified PLL
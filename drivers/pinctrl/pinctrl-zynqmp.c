@@ -62,6 +62,26 @@ struct zynqmp_pmux_function {
 	unsigned int ngroups;
 };
 
+/* Bit in &zynqmp_pin_shadow.valid for the mux function */
+#define ZYNQMP_SHADOW_FUNC		PM_PINCTRL_CONFIG_MAX
+
+/**
+ * struct zynqmp_pin_shadow - last known firmware state of a pin
+ * @func:	Mux function of the pin
+ * @config:	Config values, indexed by PM_PINCTRL_CONFIG_*
+ * @valid:	Bitmap of the @config entries and of @func (ZYNQMP_SHADOW_FUNC)
+ *		that hold the firmware state
+ *
+ * Every firmware call is an SMC into the PMU firmware. Pin control states
+ * are applied on each runtime PM transition of their device and mostly
+ * program the values the pins already have, so such writes are skipped.
+ */
+struct zynqmp_pin_shadow {
+	u32 func;
+	u32 config[PM_PINCTRL_CONFIG_MAX];
+	unsigned long valid;
+};
+
 /**
  * struct zynqmp_pinctrl - driver data
  * @pctrl:	Pin control device
@@ -69,6 +89,8 @@ struct zynqmp_pmux_function {
  * @ngroups:	Number of @groups
  * @funcs:	Pin mux functions
  * @nfuncs:	Number of @funcs
+ * @shadow:	Firmware state of the pins
+ * @npins:	Number of @shadow entries
  *
  * This struct is stored as driver data and used to retrieve
  * information regarding pin control functions, groups and
@@ -80,6 +102,8 @@ struct zynqmp_pinctrl {
 	unsigned int ngroups;
 	const struct zynqmp_pmux_function *funcs;
 	unsigned int nfuncs;
+	struct zynqmp_pin_shadow *shadow;
+	unsigned int npins;
 };
 
 /**
@@ -96,6 +120,69 @@ struct zynqmp_pctrl_group {
 
 static struct pinctrl_desc zynqmp_desc;
 
+static struct zynqmp_pin_shadow *zynqmp_pin_shadow(struct zynqmp_pinctrl *pctrl,
+						   unsigned int pin)
+{
+	unsigned int index = pin;
+
+	/* Versal pins are numbered by their firmware node IDs */
+	if (pin >= VERSAL_PMC_MIO_BASE_ID)
+		index = pin - VERSAL_PMC_MIO_BASE_ID +
+			VERSAL_LPD_MIO_END_PIN + 1;
+	else if (pin >= VERSAL_LPD_MIO_BASE_ID)
+		index = pin - VERSAL_LPD_MIO_BASE_ID;
+
+	if (!pctrl->shadow || index >= pctrl->npins)
+		return NULL;
+
+	return &pctrl->shadow[index];
+}
+
+static int zynqmp_pinctrl_set_config(struct zynqmp_pinctrl *pctrl,
+				     unsigned int pin, u32 param, u32 value)
+{
+	struct zynqmp_pin_shadow *shadow = zynqmp_pin_shadow(pctrl, pin);
+	int ret;
+
+	if (shadow && param < PM_PINCTRL_CONFIG_MAX &&
+	    test_bit(param, &shadow->valid) && shadow->config[param] == value)
+		return 0;
+
+	ret = zynqmp_pm_pinctrl_set_config(pin, param, value);
+	if (!shadow || param >= PM_PINCTRL_CONFIG_MAX)
+		return ret;
+
+	if (ret) {
+		clear_bit(param, &shadow->valid);
+	} else {
+		shadow->config[param] = value;
+		set_bit(param, &shadow->valid);
+	}
+
+	return ret;
+}
+
+static int zynqmp_pinctrl_get_config(struct zynqmp_pinctrl *pctrl,
+				     unsigned int pin, u32 param, u32 *value)
+{
+	struct zynqmp_pin_shadow *shadow = zynqmp_pin_shadow(pctrl, pin);
+	int ret;
+
+	if (shadow && param < PM_PINCTRL_CONFIG_MAX &&
+	    test_bit(param, &shadow->valid)) {
+		*value = shadow->config[param];
+		return 0;
+	}
+
+	ret = zynqmp_pm_pinctrl_get_config(pin, param, value);
+	if (!ret && shadow && param < PM_PINCTRL_CONFIG_MAX) {
+		shadow->config[param] = *value;
+		set_bit(param, &shadow->valid);
+	}
+
+	return ret;
+}
+
 static int zynqmp_pctrl_get_groups_count(struct pinctrl_dev *pctldev)
 {
 	struct zynqmp_pinctrl *pctrl = pinctrl_dev_get_drvdata(pctldev);
@@ -206,13 +293,26 @@ static int zynqmp_pinmux_set_mux(struct pinctrl_dev *pctldev,
 
 	for (i = 0; i < pgrp->npins; i++) {
 		unsigned int pin = pgrp->pins[i];
+		struct zynqmp_pin_shadow *shadow;
+
+		shadow = zynqmp_pin_shadow(pctrl, pin);
+		if (shadow && test_bit(ZYNQMP_SHADOW_FUNC, &shadow->valid) &&
+		    shadow->func == function)
+			continue;
 
 		ret = zynqmp_pm_pinctrl_set_function(pin, function);
 		if (ret) {
+			if (shadow)
+				clear_bit(ZYNQMP_SHADOW_FUNC, &shadow->valid);
 			dev_err(pctldev->dev, "set mux failed for pin %u\n",
 				pin);
 			return ret;
 		}
+
+		if (shadow) {
+			shadow->func = function;
+			set_bit(ZYNQMP_SHADOW_FUNC, &shadow->valid);
+		}
 	}
 
 	return 0;
@@ -257,17 +357,18 @@ static int zynqmp_pinconf_cfg_get(struct pinctrl_dev *pctldev,
 				  unsigned int pin,
 				  unsigned long *config)
 {
+	struct zynqmp_pinctrl *pctrl = pinctrl_dev_get_drvdata(pctldev);
 	unsigned int arg, param = pinconf_to_config_param(*config);
 	int ret;
 
 	switch (param) {
 	case PIN_CONFIG_SLEW_RATE:
 		param = PM_PINCTRL_CONFIG_SLEW_RATE;
-		ret = zynqmp_pm_pinctrl_get_config(pin, param, &arg);
+		ret = zynqmp_pinctrl_get_config(pctrl, pin, param, &arg);
 		break;
 	case PIN_CONFIG_BIAS_PULL_UP:
 		param = PM_PINCTRL_CONFIG_PULL_CTRL;
-		ret = zynqmp_pm_pinctrl_get_config(pin, param, &arg);
+		ret = zynqmp_pinctrl_get_config(pctrl, pin, param, &arg);
 		if (arg != PM_PINCTRL_BIAS_PULL_UP)
 			return -EINVAL;
 
@@ -275,7 +376,7 @@ static int zynqmp_pinconf_cfg_get(struct pinctrl_dev *pctldev,
 		break;
 	case PIN_CONFIG_BIAS_PULL_DOWN:
 		param = PM_PINCTRL_CONFIG_PULL_CTRL;
-		ret = zynqmp_pm_pinctrl_get_config(pin, param, &arg);
+		ret = zynqmp_pinctrl_get_config(pctrl, pin, param, &arg);
 		if (arg != PM_PINCTRL_BIAS_PULL_DOWN)
 			return -EINVAL;
 
@@ -283,7 +384,7 @@ static int zynqmp_pinconf_cfg_get(struct pinctrl_dev *pctldev,
 		break;
 	case PIN_CONFIG_BIAS_DISABLE:
 		param = PM_PINCTRL_CONFIG_BIAS_STATUS;
-		ret = zynqmp_pm_pinctrl_get_config(pin, param, &arg);
+		ret = zynqmp_pinctrl_get_config(pctrl, pin, param, &arg);
 		if (arg != PM_PINCTRL_BIAS_DISABLE)
 			return -EINVAL;
 
@@ -291,15 +392,15 @@ static int zynqmp_pinconf_cfg_get(struct pinctrl_dev *pctldev,
 		break;
 	case PIN_CONFIG_POWER_SOURCE:
 		param = PM_PINCTRL_CONFIG_VOLTAGE_STATUS;
-		ret = zynqmp_pm_pinctrl_get_config(pin, param, &arg);
+		ret = zynqmp_pinctrl_get_config(pctrl, pin, param, &arg);
 		break;
 	case PIN_CONFIG_INPUT_SCHMITT_ENABLE:
 		param = PM_PINCTRL_CONFIG_SCHMITT_CMOS;
-		ret = zynqmp_pm_pinctrl_get_config(pin, param, &arg);
+		ret = zynqmp_pinctrl_get_config(pctrl, pin, param, &arg);
 		break;
 	case PIN_CONFIG_DRIVE_STRENGTH:
 		param = PM_PINCTRL_CONFIG_DRIVE_STRENGTH;
-		ret = zynqmp_pm_pinctrl_get_config(pin, param, &arg);
+		ret = zynqmp_pinctrl_get_config(pctrl, pin, param, &arg);
 		switch (arg) {
 		case PM_PINCTRL_DRIVE_STRENGTH_2MA:
 			arg = DRIVE_STRENGTH_2MA;
@@ -351,6 +452,7 @@ static int zynqmp_pinconf_cfg_set(struct pinctrl_dev *pctldev,
 				  unsigned int pin, unsigned long *configs,
 				  unsigned int num_configs)
 {
+	struct zynqmp_pinctrl *pctrl = pinctrl_dev_get_drvdata(pctldev);
 	int i, ret;
 
 	for (i = 0; i < num_configs; i++) {
@@ -361,26 +463,26 @@ static int zynqmp_pinconf_cfg_set(struct pinctrl_dev *pctldev,
 		switch (param) {
 		case PIN_CONFIG_SLEW_RATE:
 			param = PM_PINCTRL_CONFIG_SLEW_RATE;
-			ret = zynqmp_pm_pinctrl_set_config(pin, param, arg);
+			ret = zynqmp_pinctrl_set_config(pctrl, pin, param, arg);
 			break;
 		case PIN_CONFIG_BIAS_PULL_UP:
 			param = PM_PINCTRL_CONFIG_PULL_CTRL;
 			arg = PM_PINCTRL_BIAS_PULL_UP;
-			ret = zynqmp_pm_pinctrl_set_config(pin, param, arg);
+			ret = zynqmp_pinctrl_set_config(pctrl, pin, param, arg);
 			break;
 		case PIN_CONFIG_BIAS_PULL_DOWN:
 			param = PM_PINCTRL_CONFIG_PULL_CTRL;
 			arg = PM_PINCTRL_BIAS_PULL_DOWN;
-			ret = zynqmp_pm_pinctrl_set_config(pin, param, arg);
+			ret = zynqmp_pinctrl_set_config(pctrl, pin, param, arg);
 			break;
 		case PIN_CONFIG_BIAS_DISABLE:
 			param = PM_PINCTRL_CONFIG_BIAS_STATUS;
 			arg = PM_PINCTRL_BIAS_DISABLE;
-			ret = zynqmp_pm_pinctrl_set_config(pin, param, arg);
+			ret = zynqmp_pinctrl_set_config(pctrl, pin, param, arg);
 			break;
 		case PIN_CONFIG_INPUT_SCHMITT_ENABLE:
 			param = PM_PINCTRL_CONFIG_SCHMITT_CMOS;
-			ret = zynqmp_pm_pinctrl_set_config(pin, param, arg);
+			ret = zynqmp_pinctrl_set_config(pctrl, pin, param, arg);
 			break;
 		case PIN_CONFIG_DRIVE_STRENGTH:
 			switch (arg) {
@@ -405,11 +507,13 @@ static int zynqmp_pinconf_cfg_set(struct pinctrl_dev *pctldev,
 			}
 
 			param = PM_PINCTRL_CONFIG_DRIVE_STRENGTH;
-			ret = zynqmp_pm_pinctrl_set_config(pin, param, value);
+			ret = zynqmp_pinctrl_set_config(pctrl, pin, param,
+							value);
 			break;
 		case PIN_CONFIG_POWER_SOURCE:
 			param = PM_PINCTRL_CONFIG_VOLTAGE_STATUS;
-			ret = zynqmp_pm_pinctrl_get_config(pin, param, &value);
+			ret = zynqmp_pinctrl_get_config(pctrl, pin, param,
+							&value);
 
 			if (arg != value)
 				dev_warn(pctldev->dev,
@@ -905,6 +1009,12 @@ static int zynqmp_pinctrl_probe(struct platform_device *pdev)
 		return ret;
 	}
 
+	pctrl->npins = zynqmp_desc.npins;
+	pctrl->shadow = devm_kcalloc(&pdev->dev, pctrl->npins,
+				     sizeof(*pctrl->shadow), GFP_KERNEL);
+	if (!pctrl->shadow)
+		return -ENOMEM;
+
 	ret = zynqmp_pinctrl_prepare_function_info(&pdev->dev, pctrl);
 	if (ret) {
 		dev_err(&pdev->dev, "function info prepare fail with %d\n", ret);
@@ -1788,12 +1788,91 @@ static int rproc_attach_recovery(struct rproc *rproc)
 	return __rproc_attach(rproc);
 }
 
-static int rproc_boot_recovery(struct rproc *rproc)
+/*
+ * Get the firmware image to boot from the cache, or with request_firmware().
+ * Must be called with rproc->lock held.
+ */
+static int rproc_request_firmware(struct rproc *rproc,
+				  const struct firmware **fw)
 {
 	const struct firmware *firmware_p;
+	int ret;
+
+	if (rproc->cached_fw) {
+		*fw = rproc->cached_fw;
+		return 0;
+	}
+
+	ret = request_firmware(&firmware_p, rproc->firmware, &rproc->dev);
+	if (ret < 0) {
+		dev_err(&rproc->dev, "request_firmware failed: %d\n", ret);
+		return ret;
+	}
+
+	if (rproc->fw_cache)
+		rproc->cached_fw = firmware_p;
+
+	*fw = firmware_p;
+
+	return 0;
+}
+
+static void rproc_release_firmware(struct rproc *rproc,
+				   const struct firmware *fw)
+{
+	if (fw != rproc->cached_fw)
+		release_firmware(fw);
+}
+
+/* Must be called with rproc->lock held */
+static void rproc_evict_firmware(struct rproc *rproc)
+{
+	release_firmware(rproc->cached_fw);
+	rproc->cached_fw = NULL;
+}
+
+/**
+ * rproc_set_firmware_cache() - configure the firmware image cache
+ * @rproc: the remote processor
+ * @enable: keep the firmware image in memory for the following boots
+ * @preload: load the firmware image right away instead of on the next boot
+ *
+ * A cached image saves the filesystem read and the allocation of the image
+ * on every restart or recovery of the remote processor. The image is evicted
+ * when the cache is disabled or the firmware name changes.
+ *
+ * Return: 0 on success or a negative value upon failure
+ */
+int rproc_set_firmware_cache(struct rproc *rproc, bool enable, bool preload)
+{
 	struct device *dev = &rproc->dev;
 	int ret;
 
+	ret = mutex_lock_interruptible(&rproc->lock);
+	if (ret) {
+		dev_err(dev, "can't lock rproc %s: %d\n", rproc->name, ret);
+		return ret;
+	}
+
+	rproc->fw_cache = enable;
+	if (!enable) {
+		rproc_evict_firmware(rproc);
+	} else if (preload && !rproc->cached_fw) {
+		ret = request_firmware(&rproc->cached_fw, rproc->firmware, dev);
+		if (ret < 0)
+			dev_err(dev, "request_firmware failed: %d\n", ret);
+	}
+
+	mutex_unlock(&rproc->lock);
+
+	return ret;
+}
+
+static int rproc_boot_recovery(struct rproc *rproc)
+{
+	const struct firmware *firmware_p;
+	int ret;
+
 	ret = rproc_stop(rproc, true);
 	if (ret)
 		return ret;
@@ -1802,16 +1881,14 @@ static int rproc_boot_recovery(struct rproc *rproc)
 	rproc->ops->coredump(rproc);
 
 	/* load firmware */
-	ret = request_firmware(&firmware_p, rproc->firmware, dev);
-	if (ret < 0) {
-		dev_err(dev, "request_firmware failed: %d\n", ret);
+	ret = rproc_request_firmware(rproc, &firmware_p);
+	if (ret < 0)
 		return ret;
-	}
 
 	/* boot the remote processor up again */
 	ret = rproc_start(rproc, firmware_p);
 
-	release_firmware(firmware_p);
+	rproc_release_firmware(rproc, firmware_p);
 
 	return ret;
 }
@@ -1944,15 +2021,13 @@ int rproc_boot(struct rproc *rproc)
 		dev_info(dev, "powering up %s\n", rproc->name);
 
 		/* load firmware */
-		ret = request_firmware(&firmware_p, rproc->firmware, dev);
-		if (ret < 0) {
-			dev_err(dev, "request_firmware failed: %d\n", ret);
+		ret = rproc_request_firmware(rproc, &firmware_p);
+		if (ret < 0)
 			goto downref_rproc;
-		}
 
 		ret = rproc_fw_boot(rproc, firmware_p);
 
-		release_firmware(firmware_p);
+		rproc_release_firmware(rproc, firmware_p);
 	}
 
 downref_rproc:
@@ -2227,6 +2302,7 @@ int rproc_set_firmware(struct rproc *rproc, const char *fw_name)
 
 	kfree_const(rproc->firmware);
 	rproc->firmware = p;
+	rproc_evict_firmware(rproc);
 
 out:
 	mutex_unlock(&rproc->lock);
@@ -2386,6 +2462,7 @@ static void rproc_type_release(struct device *dev)
 	if (rproc->index >= 0)
 		ida_free(&rproc_dev_index, rproc->index);
 
+	release_firmware(rproc->cached_fw);
 	kfree_const(rproc->firmware);
 	kfree_const(rproc->name);
 	kfree(rproc->ops);
@@ -18,8 +18,15 @@
 #define pr_fmt(fmt)    "%s: " fmt, __func__
 
 #include <linux/module.h>
+#include <linux/completion.h>
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
 #include <linux/firmware.h>
 #include <linux/remoteproc.h>
+#include <linux/scatterlist.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
 #include <linux/elf.h>
 
 #include "remoteproc_internal.h"
@@ -131,6 +138,206 @@ u64 rproc_elf_get_boot_addr(struct rproc *rproc, const struct firmware *fw)
 }
 EXPORT_SYMBOL(rproc_elf_get_boot_addr);
 
+/* Segments smaller than this are loaded faster by the CPU */
+#define RPROC_DMA_LOAD_MIN_SIZE		SZ_64K
+#define RPROC_DMA_LOAD_TIMEOUT_MS	5000
+
+static struct rproc_mem_entry *
+rproc_find_carveout_by_da(struct rproc *rproc, u64 da, size_t len)
+{
+	struct rproc_mem_entry *carveout;
+
+	list_for_each_entry(carveout, &rproc->carveouts, node) {
+		if (!carveout->dma || da < carveout->da ||
+		    len > carveout->len ||
+		    da - carveout->da > carveout->len - len)
+			continue;
+
+		return carveout;
+	}
+
+	return NULL;
+}
+
+/*
+ * Describe @len bytes at @src with a scatterlist. The firmware image is
+ * usually vmalloc()ed, so it is only contiguous page by page.
+ */
+static int rproc_dma_map_src(struct device *dma_dev, const void *src,
+			     size_t len, struct sg_table *sgt)
+{
+	unsigned int offset = offset_in_page(src);
+	unsigned int n = DIV_ROUND_UP(offset + len, PAGE_SIZE);
+	const void *addr = src - offset;
+	struct page **pages;
+	unsigned int i;
+	int ret;
+
+	pages = kmalloc_array(n, sizeof(*pages), GFP_KERNEL);
+	if (!pages)
+		return -ENOMEM;
+
+	for (i = 0; i < n; i++, addr += PAGE_SIZE) {
+		if (is_vmalloc_addr(addr))
+			pages[i] = vmalloc_to_page(addr);
+		else
+			pages[i] = virt_to_page(addr);
+	}
+
+	ret = sg_alloc_table_from_pages(sgt, pages, n, offset, len,
+					GFP_KERNEL);
+	kfree(pages);
+	if (ret)
+		return ret;
+
+	ret = dma_map_sgtable(dma_dev, sgt, DMA_TO_DEVICE, 0);
+	if (ret)
+		sg_free_table(sgt);
+
+	return ret;
+}
+
+static void rproc_dma_load_done(void *arg)
+{
+	complete(arg);
+}
+
+/*
+ * Copy @filesz bytes from @src to the carveout at @da and zero the following
+ * @zero bytes with rproc->load_chan. Returns 0 once the transfer is complete.
+ */
+static int rproc_dma_load_segment(struct rproc *rproc, u64 da,
+				  const void *src, size_t filesz, size_t zero)
+{
+	struct dma_chan *chan = rproc->load_chan;
+	struct device *dma_dev = dmaengine_get_dma_device(chan);
+	struct dma_async_tx_descriptor *tx = NULL;
+	DECLARE_COMPLETION_ONSTACK(done);
+	size_t len = filesz + zero;
+	struct rproc_mem_entry *mem;
+	struct sg_table sgt = {};
+	struct scatterlist *sg;
+	dma_addr_t dst, addr;
+	unsigned int i;
+	bool last;
+	int ret;
+
+	mem = rproc_find_carveout_by_da(rproc, da, len);
+	if (!mem)
+		return -EINVAL;
+
+	dst = dma_map_resource(dma_dev, mem->dma + (da - mem->da), len,
+			       DMA_FROM_DEVICE, 0);
+	if (dma_mapping_error(dma_dev, dst))
+		return -ENOMEM;
+
+	if (filesz) {
+		ret = rproc_dma_map_src(dma_dev, src, filesz, &sgt);
+		if (ret)
+			goto unmap_dst;
+	}
+
+	/* Descriptors complete in order, only the last one interrupts */
+	addr = dst;
+	for_each_sgtable_dma_sg(&sgt, sg, i) {
+		last = !zero && i == sgt.nents - 1;
+		tx = dmaengine_prep_dma_memcpy(chan, addr, sg_dma_address(sg),
+				sg_dma_len(sg), last ? DMA_PREP_INTERRUPT : 0);
+		if (!tx)
+			goto terminate;
+		if (last) {
+			tx->callback = rproc_dma_load_done;
+			tx->callback_param = &done;
+		}
+		if (dma_submit_error(dmaengine_submit(tx)))
+			goto terminate;
+		addr += sg_dma_len(sg);
+	}
+
+	if (zero) {
+		tx = dmaengine_prep_dma_memset(chan, addr, 0, zero,
+					       DMA_PREP_INTERRUPT);
+		if (!tx)
+			goto terminate;
+		tx->callback = rproc_dma_load_done;
+		tx->callback_param = &done;
+		if (dma_submit_error(dmaengine_submit(tx)))
+			goto terminate;
+	}
+
+	dma_async_issue_pending(chan);
+
+	if (!wait_for_completion_timeout(&done,
+			msecs_to_jiffies(RPROC_DMA_LOAD_TIMEOUT_MS))) {
+		dev_warn(&rproc->dev, "DMA load of da 0x%llx timed out\n", da);
+		goto terminate;
+	}
+
+	ret = 0;
+	goto unmap_src;
+
+terminate:
+	dmaengine_terminate_sync(chan);
+	ret = -EIO;
+unmap_src:
+	if (filesz) {
+		dma_unmap_sgtable(dma_dev, &sgt, DMA_TO_DEVICE, 0);
+		sg_free_table(&sgt);
+	}
+unmap_dst:
+	dma_unmap_resource(dma_dev, dst, len, DMA_FROM_DEVICE, 0);
+
+	return ret;
+}
+
+/**
+ * rproc_load_segment() - copy a firmware segment to memory
+ * @rproc: remote processor which will be booted using these fw segments
+ * @ptr: kernel address of the segment
+ * @da: device address of the segment
+ * @is_iomem: whether @ptr is an __iomem address
+ * @src: segment data in the firmware image
+ * @filesz: number of bytes to copy from @src
+ * @memsz: size of the segment, the bytes after @filesz are zeroed
+ *
+ * Large segments are copied with rproc->load_chan if the driver set one up
+ * and the segment lies in a carveout. The CPU does the copy otherwise, and
+ * also if the DMA transfer fails.
+ */
+void rproc_load_segment(struct rproc *rproc, void *ptr, u64 da, bool is_iomem,
+			const void *src, size_t filesz, size_t memsz)
+{
+	struct dma_chan *chan = rproc->load_chan;
+	size_t zero = memsz - filesz;
+	size_t dma_zero = 0;
+
+	if (chan && memsz >= RPROC_DMA_LOAD_MIN_SIZE) {
+		if (dma_has_cap(DMA_MEMSET, chan->device->cap_mask))
+			dma_zero = zero;
+		if ((filesz || dma_zero) &&
+		    !rproc_dma_load_segment(rproc, da, src, filesz, dma_zero)) {
+			filesz = 0;
+			zero -= dma_zero;
+		}
+	}
+
+	if (filesz) {
+		if (is_iomem)
+			memcpy_toio((void __iomem *)ptr, src, filesz);
+		else
+			memcpy(ptr, src, filesz);
+	}
+
+	/* The CPU zeroes whatever the DMA did not */
+	if (zero) {
+		if (is_iomem)
+			memset_io((void __iomem *)(ptr + memsz - zero), 0, zero);
+		else
+			memset(ptr + memsz - zero, 0, zero);
+	}
+}
+EXPORT_SYMBOL(rproc_load_segment);
+
 /**
  * rproc_elf_load_segments() - load firmware segments to memory
  * @rproc: remote processor which will be booted using these fw segments
@@ -217,27 +424,16 @@ int rproc_elf_load_segments(struct rproc *rproc, const struct firmware *fw)
 			break;
 		}
 
-		/* put the segment where the remote processor expects it */
-		if (filesz) {
-			if (is_iomem)
-				memcpy_toio((void __iomem *)ptr, elf_data + offset, filesz);
-			else
-				memcpy(ptr, elf_data + offset, filesz);
-		}
-
 		/*
-		 * Zero out remaining memory for this segment.
+		 * Put the segment where the remote processor expects it and
+		 * zero out the remaining memory for this segment.
 		 *
-		 * This isn't strictly required since dma_alloc_coherent already
-		 * did this for us. albeit harmless, we may consider removing
-		 * this.
+		 * The zeroing isn't strictly required since dma_alloc_coherent
+		 * already did this for us. albeit harmless, we may consider
+		 * removing this.
 		 */
-		if (memsz > filesz) {
-			if (is_iomem)
-				memset_io((void __iomem *)(ptr + filesz), 0, memsz - filesz);
-			else
-				memset(ptr + filesz, 0, memsz - filesz);
-		}
+		rproc_load_segment(rproc, ptr, da, is_iomem, elf_data + offset,
+				   filesz, memsz);
 	}
 
 	return ret;
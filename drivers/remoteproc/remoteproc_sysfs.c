@@ -159,6 +159,52 @@ static ssize_t firmware_store(struct device *dev,
 }
 static DEVICE_ATTR_RW(firmware);
 
+static ssize_t firmware_cache_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	struct rproc *rproc = to_rproc(dev);
+
+	return sysfs_emit(buf, "%s\n",
+			  rproc->fw_cache ? "enabled" : "disabled");
+}
+
+/*
+ * By writing to the 'firmware_cache' sysfs entry, we control whether the
+ * firmware image is kept in memory between boots. The default value of this
+ * entry is "disabled".
+ *
+ * The 'firmware_cache' sysfs entry supports these commands:
+ *
+ * enabled:	The image loaded by the next boot is kept, and restarts and
+ *		recoveries boot from it without reading the filesystem.
+ *
+ * disabled:	The cached image, if any, is released.
+ *
+ * preload:	Like enabled, but the image is loaded right away, so that
+ *		the next boot doesn't wait for the filesystem either.
+ *
+ * Changing the firmware name releases the cached image.
+ */
+static ssize_t firmware_cache_store(struct device *dev,
+				    struct device_attribute *attr,
+				    const char *buf, size_t count)
+{
+	struct rproc *rproc = to_rproc(dev);
+	int err;
+
+	if (sysfs_streq(buf, "enabled"))
+		err = rproc_set_firmware_cache(rproc, true, false);
+	else if (sysfs_streq(buf, "disabled"))
+		err = rproc_set_firmware_cache(rproc, false, false);
+	else if (sysfs_streq(buf, "preload"))
+		err = rproc_set_firmware_cache(rproc, true, true);
+	else
+		return -EINVAL;
+
+	return err ? err : count;
+}
+static DEVICE_ATTR_RW(firmware_cache);
+
 /*
  * A state-to-string lookup table, for exposing a human readable state
  * via sysfs. Always keep in sync with enum rproc_state
@@ -307,6 +353,7 @@ static umode_t rproc_is_visible(struct kobject *kobj, struct attribute *attr,
 
 	if (rproc->sysfs_read_only && (attr == &dev_attr_recovery.attr ||
 				       attr == &dev_attr_firmware.attr ||
+				       attr == &dev_attr_firmware_cache.attr ||
 				       attr == &dev_attr_state.attr ||
 				       attr == &dev_attr_coredump.attr))
 		mode = 0444;
@@ -318,6 +365,7 @@ static struct attribute *rproc_attrs[] = {
 	&dev_attr_coredump.attr,
 	&dev_attr_recovery.attr,
 	&dev_attr_firmware.attr,
+	&dev_attr_firmware_cache.attr,
 	&dev_attr_state.attr,
 	&dev_attr_name.attr,
 	NULL
@@ -12,10 +12,15 @@
 #include <linux/dma-direct.h>
 #include <linux/dma-map-ops.h>
 #include <linux/dma-mapping.h>
+#include <linux/delay.h>
 #include <linux/export.h>
+#include <linux/kthread.h>
+#include <linux/module.h>
 #include <linux/of_reserved_mem.h>
 #include <linux/platform_device.h>
 #include <linux/remoteproc.h>
+#include <linux/sched.h>
+#include <linux/sched/task.h>
 #include <linux/virtio.h>
 #include <linux/virtio_config.h>
 #include <linux/virtio_ids.h>
@@ -26,6 +31,22 @@
 
 #include "remoteproc_internal.h"
 
+/*
+ * With a non-zero poll interval, a notification from the remote processor
+ * makes a kthread poll the vrings of its vdev every poll_usecs. Kicks are
+ * then coalesced into one per vring and poll, until poll_idle polls in a
+ * row found no work and the vdev goes back to being notification driven.
+ */
+static unsigned int poll_usecs;
+module_param(poll_usecs, uint, 0444);
+MODULE_PARM_DESC(poll_usecs,
+		 "Vring poll interval in microseconds under load (0 = off)");
+
+static unsigned int poll_idle = 16;
+module_param(poll_idle, uint, 0644);
+MODULE_PARM_DESC(poll_idle,
+		 "Number of idle polls before waiting for notifications again");
+
 static int copy_dma_range_map(struct device *to, struct device *from)
 {
 	const struct bus_dma_region *map = from->dma_range_map, *new_map, *r;
@@ -65,8 +86,19 @@ static  struct rproc *vdev_to_rproc(struct virtio_device *vdev)
 static bool rproc_virtio_notify(struct virtqueue *vq)
 {
 	struct rproc_vring *rvring = vq->priv;
-	struct rproc *rproc = rvring->rvdev->rproc;
+	struct rproc_vdev *rvdev = rvring->rvdev;
+	struct rproc *rproc = rvdev->rproc;
 	int notifyid = rvring->notifyid;
+	int id = rvring - rvdev->vring;
+
+	/* While polling, the next poll sends the kick */
+	if (READ_ONCE(rvdev->polling)) {
+		set_bit(id, &rvdev->kick_pending);
+		smp_mb__after_atomic();
+		if (READ_ONCE(rvdev->polling) ||
+		    !test_and_clear_bit(id, &rvdev->kick_pending))
+			return true;
+	}
 
 	dev_dbg(&rproc->dev, "kicking vq index: %d\n", notifyid);
 
@@ -88,7 +120,9 @@ static bool rproc_virtio_notify(struct virtqueue *vq)
  */
 irqreturn_t rproc_vq_interrupt(struct rproc *rproc, int notifyid)
 {
+	struct task_struct *task;
 	struct rproc_vring *rvring;
+	struct rproc_vdev *rvdev;
 
 	dev_dbg(&rproc->dev, "vq index %d is interrupted\n", notifyid);
 
@@ -96,10 +130,81 @@ irqreturn_t rproc_vq_interrupt(struct rproc *rproc, int notifyid)
 	if (!rvring || !rvring->vq)
 		return IRQ_NONE;
 
+	rvdev = rvring->rvdev;
+	task = READ_ONCE(rvdev->poll_task);
+	if (task) {
+		if (!READ_ONCE(rvdev->polling)) {
+			WRITE_ONCE(rvdev->polling, true);
+			wake_up_process(task);
+		}
+		return IRQ_HANDLED;
+	}
+
 	return vring_interrupt(0, rvring->vq);
 }
 EXPORT_SYMBOL(rproc_vq_interrupt);
 
+/* Process the used buffers and send the deferred kicks of all vrings */
+static bool rproc_vdev_poll(struct rproc_vdev *rvdev)
+{
+	struct rproc *rproc = rvdev->rproc;
+	bool busy = false;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(rvdev->vring); i++) {
+		struct rproc_vring *rvring = &rvdev->vring[i];
+
+		if (!rvring->vq)
+			continue;
+
+		if (vring_interrupt(0, rvring->vq) == IRQ_HANDLED)
+			busy = true;
+
+		if (test_and_clear_bit(i, &rvdev->kick_pending)) {
+			rproc->ops->kick(rproc, rvring->notifyid);
+			busy = true;
+		}
+	}
+
+	return busy;
+}
+
+static int rproc_vdev_poll_thread(void *data)
+{
+	struct rproc_vdev *rvdev = data;
+	unsigned int idle = 0;
+
+	sched_set_fifo(current);
+
+	for (;;) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (kthread_should_stop())
+			break;
+		if (!READ_ONCE(rvdev->polling)) {
+			schedule();
+			continue;
+		}
+		__set_current_state(TASK_RUNNING);
+
+		if (rproc_vdev_poll(rvdev)) {
+			idle = 0;
+		} else if (++idle >= READ_ONCE(poll_idle)) {
+			idle = 0;
+			WRITE_ONCE(rvdev->polling, false);
+			smp_mb();
+			/* Kicks queued before the mode switch was seen */
+			rproc_vdev_poll(rvdev);
+			continue;
+		}
+
+		usleep_range(poll_usecs, poll_usecs + poll_usecs / 4 + 1);
+	}
+	__set_current_state(TASK_RUNNING);
+
+	return 0;
+}
+
+
 static struct virtqueue *rp_find_vq(struct virtio_device *vdev,
 				    unsigned int id,
 				    void (*callback)(struct virtqueue *vq),
@@ -177,7 +282,24 @@ static void __rproc_virtio_del_vqs(struct virtio_device *vdev)
 
 static void rproc_virtio_del_vqs(struct virtio_device *vdev)
 {
+	struct rproc_vdev *rvdev = vdev_to_rvdev(vdev);
+	struct task_struct *task = rvdev->poll_task;
+
+	/*
+	 * Notifications may still come in until the vrings are gone, so keep
+	 * the task around for rproc_vq_interrupt() until then.
+	 */
+	if (task)
+		kthread_stop(task);
+
 	__rproc_virtio_del_vqs(vdev);
+
+	if (task) {
+		WRITE_ONCE(rvdev->poll_task, NULL);
+		WRITE_ONCE(rvdev->polling, false);
+		rvdev->kick_pending = 0;
+		put_task_struct(task);
+	}
 }
 
 static int rproc_virtio_find_vqs(struct virtio_device *vdev, unsigned int nvqs,
@@ -203,6 +325,20 @@ static int rproc_virtio_find_vqs(struct virtio_device *vdev, unsigned int nvqs,
 		}
 	}
 
+	if (poll_usecs) {
+		struct rproc_vdev *rvdev = vdev_to_rvdev(vdev);
+		struct task_struct *task;
+
+		task = kthread_run(rproc_vdev_poll_thread, rvdev, "%s-vdev%u",
+				   dev_name(&rvdev->rproc->dev), rvdev->index);
+		if (IS_ERR(task)) {
+			ret = PTR_ERR(task);
+			goto error;
+		}
+		get_task_struct(task);
+		WRITE_ONCE(rvdev->poll_task, task);
+	}
+
 	return 0;
 
 error:
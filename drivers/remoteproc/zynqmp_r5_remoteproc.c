@@ -6,6 +6,8 @@
  *
  */
 
+#include <linux/crc32.h>
+#include <linux/dmaengine.h>
 #include <linux/firmware/xlnx-zynqmp.h>
 #include <linux/interrupt.h>
 #include <linux/kernel.h>
@@ -18,10 +20,10 @@
 #include <linux/of_reserved_mem.h>
 #include <linux/platform_device.h>
 #include <linux/remoteproc.h>
-#include <linux/skbuff.h>
 #include <linux/sysfs.h>
 
 #include "remoteproc_internal.h"
+#include "remoteproc_elf_helpers.h"
 
 #define MAX_RPROCS	2 /* Support up to 2 RPU */
 #define BANK_LIST_PROP	"sram"
@@ -34,8 +36,23 @@
 /* RX mailbox client buffer max length */
 #define RX_MBOX_CLIENT_BUF_MAX	(IPI_BUF_LEN_MAX + \
 				 sizeof(struct zynqmp_ipi_message))
+/* TX mailbox client buffer length: a kick carries the virtqueue ID */
+#define TX_MBOX_CLIENT_BUF_MAX	(sizeof(struct zynqmp_ipi_message) + \
+				 sizeof(int))
+/* Bit in kick_flags set while a kick has not been acknowledged */
+#define RPU_KICK_PENDING	0
 #define MAX_BANKS 4U
 #define MAX_BANKS_PER_CORE	3U
+/* Entries of the sram property of a core, lockstep lists both cores */
+#define MAX_SRAM_NODES		(2U * MAX_BANKS_PER_CORE)
+/* Read-only firmware segments remembered for fast reload */
+#define MAX_CACHED_SEGS		8U
+/*
+ * In lockstep the ZynqMP and Versal TCM banks of core 1 move from
+ * 0xffe90000 and 0xffeb0000 to right after the 64 KB banks of core 0.
+ */
+#define LOCKSTEP_TCM_SHIFT	0x80000U
+#define SPLIT_TCM_BANK_LEN	0x10000U
 
 /*
  * NOTE: The resource table size is currently hard-coded to a maximum
@@ -50,6 +67,17 @@ enum soc_type_t {
 	SOC_VERSAL_NET	= 2,
 };
 
+/*
+ * With fast_reload, TCM banks stay powered while the core is stopped and
+ * read-only segments that match the previously loaded image are not
+ * written again. This relies on the firmware never writing to its own
+ * read-only segments.
+ */
+static bool fast_reload;
+module_param(fast_reload, bool, 0644);
+MODULE_PARM_DESC(fast_reload,
+		 "Keep TCM powered and skip unchanged segments (default: N)");
+
 /**
  * struct xlnx_rpu_soc_data - match data to handle SoC variations
  * @soc_type:	enum to denote which SOC this is running. on. Some EEMI calls
@@ -70,6 +98,21 @@ struct xlnx_rpu_soc_data {
  */
 struct sram_addr_data {
 	enum pm_node_id ids[MAX_BANKS];
+	bool held;
+};
+
+/**
+ * struct xlnx_rpu_seg - read-only segment loaded in RPU memory
+ * @da: device address of the segment
+ * @memsz: size of the segment in memory
+ * @filesz: size of the segment in the ELF image
+ * @crc: crc32 of the segment data from the ELF image
+ */
+struct xlnx_rpu_seg {
+	u64 da;
+	u64 memsz;
+	u64 filesz;
+	u32 crc;
 };
 
 /**
@@ -78,8 +121,9 @@ struct sram_addr_data {
  * @rx_mc_buf: rx mailbox client buffer to save the rx message
  * @tx_mc: tx mailbox client
  * @rx_mc: rx mailbox client
+ * @tx_mc_buf: tx mailbox client buffer holding the in-flight kick
  * @mbox_work: mbox_work for the RPU remoteproc
- * @tx_mc_skbs: socket buffers for tx mailbox client
+ * @kick_flags: RPU_KICK_PENDING while the last kick is not yet acknowledged
  * @dev: device of RPU instance
  * @rproc: rproc handle
  * @tx_chan: tx mailbox channel
@@ -90,13 +134,19 @@ struct sram_addr_data {
  * @elem: linked list item
  * @versal: flag that if on, denotes this driver is for Versal SoC.
  * @soc_data: SoC-specific feature data for a RPU core.
+ * @sram_banks: power domains of each entry of the sram property
+ * @segs: read-only segments currently in RPU memory
+ * @num_segs: number of valid entries in @segs
+ * @removing: driver is being removed, release TCM banks on stop
+ * @cluster: cluster the core belongs to
  */
 struct xlnx_rpu_rproc {
 	unsigned char rx_mc_buf[RX_MBOX_CLIENT_BUF_MAX];
 	struct mbox_client tx_mc;
 	struct mbox_client rx_mc;
+	unsigned char tx_mc_buf[TX_MBOX_CLIENT_BUF_MAX];
 	struct work_struct mbox_work;
-	struct sk_buff_head tx_mc_skbs;
+	unsigned long kick_flags;
 	struct device *dev;
 	struct rproc *rproc;
 	struct mbox_chan *tx_chan;
@@ -106,8 +156,51 @@ struct xlnx_rpu_rproc {
 	u32 pnode_id;
 	struct list_head elem;
 	const struct xlnx_rpu_soc_data *soc_data;
+	struct sram_addr_data sram_banks[MAX_SRAM_NODES];
+	struct xlnx_rpu_seg segs[MAX_CACHED_SEGS];
+	unsigned int num_segs;
+	bool removing;
+	struct xlnx_rpu_cluster *cluster;
+};
+
+/**
+ * struct xlnx_rpu_cluster - RPU cluster structure
+ *
+ * @cores: xlnx_rpu_rproc of each core, in device tree order
+ * @num_cores: number of entries in @cores
+ * @mode: current RPU operation mode, only changed with all cores offline
+ * @soc_data: SoC-specific feature data for the cluster
+ */
+struct xlnx_rpu_cluster {
+	struct list_head cores;
+	unsigned int num_cores;
+	enum rpu_oper_mode mode;
+	const struct xlnx_rpu_soc_data *soc_data;
 };
 
+/*
+ * xlnx_rpu_lockstep_peer
+ * @z_rproc: Remote processor private data
+ *
+ * In lockstep mode with both cores described, core 0 runs from the TCM
+ * of the pair and core 1 cannot be started.
+ *
+ * Return: core 1 when @z_rproc is core 0 of such a pair, NULL otherwise
+ */
+static struct xlnx_rpu_rproc *
+xlnx_rpu_lockstep_peer(struct xlnx_rpu_rproc *z_rproc)
+{
+	struct xlnx_rpu_cluster *cluster = z_rproc->cluster;
+
+	if (!cluster || cluster->mode != PM_RPU_MODE_LOCKSTEP ||
+	    cluster->num_cores != MAX_RPROCS ||
+	    z_rproc != list_first_entry(&cluster->cores,
+					struct xlnx_rpu_rproc, elem))
+		return NULL;
+
+	return list_last_entry(&cluster->cores, struct xlnx_rpu_rproc, elem);
+}
+
 /*
  * rpu_set_mode - set RPU operation mode
  * @z_rproc: Remote processor private data
@@ -146,24 +239,26 @@ static int rpu_set_mode(struct xlnx_rpu_rproc *z_rproc,
 }
 
 /*
- * xlnx_rpu_rproc_mem_release
- * @rproc: single RPU core's corresponding rproc instance
- * @mem: mem entry to unmap
+ * xlnx_rpu_pm_release_sram
+ * @z_rproc: Remote processor private data
+ * @sram_banks: power domains of the SRAM bank to release
  *
- * Unmap SRAM banks when powering down RPU core.
+ * Power off SRAM bank of the RPU core.
  *
  * return 0 on success, otherwise non-zero value on failure
  */
-static int sram_mem_release(struct rproc *rproc, struct rproc_mem_entry *mem)
+static int xlnx_rpu_pm_release_sram(struct xlnx_rpu_rproc *z_rproc,
+				    struct sram_addr_data *sram_banks)
 {
-	struct xlnx_rpu_rproc *z_rproc = rproc->priv;
-	struct device *dev = &rproc->dev;
+	struct device *dev = &z_rproc->rproc->dev;
 	unsigned int i;
 	int ret = 0;
-	struct sram_addr_data *sram_banks = (struct sram_addr_data *)mem->priv;
 	u32 pnode_id, status, usage = 0;
 
-	iounmap(mem->va);
+	/* Contents of TCM are lost, nothing is known to be loaded */
+	z_rproc->num_segs = 0;
+	sram_banks->held = false;
+
 	/*
 	 * This loop is to go over each bank in sram property.
 	 *
@@ -204,6 +299,49 @@ static int sram_mem_release(struct rproc *rproc, struct rproc_mem_entry *mem)
 	return ret;
 }
 
+/*
+ * xlnx_rpu_release_held_sram
+ * @z_rproc: Remote processor private data
+ *
+ * Power off the SRAM banks kept powered by fast_reload while the core is off.
+ */
+static void xlnx_rpu_release_held_sram(struct xlnx_rpu_rproc *z_rproc)
+{
+	struct sram_addr_data *sram_banks;
+	unsigned int i;
+
+	for (i = 0; i < MAX_SRAM_NODES; i++) {
+		sram_banks = &z_rproc->sram_banks[i];
+		if (sram_banks->held)
+			xlnx_rpu_pm_release_sram(z_rproc, sram_banks);
+	}
+}
+
+/*
+ * xlnx_rpu_rproc_mem_release
+ * @rproc: single RPU core's corresponding rproc instance
+ * @mem: mem entry to unmap
+ *
+ * Unmap SRAM banks when powering down RPU core.
+ *
+ * return 0 on success, otherwise non-zero value on failure
+ */
+static int sram_mem_release(struct rproc *rproc, struct rproc_mem_entry *mem)
+{
+	struct xlnx_rpu_rproc *z_rproc = rproc->priv;
+	struct sram_addr_data *sram_banks = (struct sram_addr_data *)mem->priv;
+
+	iounmap(mem->va);
+
+	/* Keep the bank powered so its contents survive until next start */
+	if (READ_ONCE(fast_reload) && !z_rproc->removing) {
+		sram_banks->held = true;
+		return 0;
+	}
+
+	return xlnx_rpu_pm_release_sram(z_rproc, sram_banks);
+}
+
 /*
  * xlnx_rpu_rproc_start
  * @rproc: single RPU core's corresponding rproc instance
@@ -501,9 +639,10 @@ static int sram_mem_alloc(struct rproc *rproc, struct rproc_mem_entry *mem)
 	 */
 	unsigned int versal_net[4] = { 0xEBA00000, 0x3FFFF, 0xEBAE0000, 0x8000 };
 	unsigned int versal[4] = { 0xFFE00000, 0xFFFFF, 0xFFEB0000, 0x10000 };
-	unsigned int base, mask, high, len, bank, *sram_tbl;
+	unsigned int base, mask, high, len, bank, tcm_base, *sram_tbl;
 	struct xlnx_rpu_rproc *z_rproc = rproc->priv;
 	struct device *dev = rproc->dev.parent;
+	bool peer;
 	void *va;
 
 	sram_tbl = z_rproc->soc_data->soc_type == SOC_VERSAL_NET ? versal_net : versal;
@@ -519,9 +658,6 @@ static int sram_mem_alloc(struct rproc *rproc, struct rproc_mem_entry *mem)
 	/* Update memory entry va */
 	mem->va = va;
 
-	va = devm_ioremap_wc(dev, mem->da, mem->len);
-	if (!va)
-		return -ENOMEM;
 	/*
 	 * Handle TCM translation for R-series relative addresses. Check from
 	 * start to end of TCM banks in mapping.
@@ -549,10 +685,14 @@ static int sram_mem_alloc(struct rproc *rproc, struct rproc_mem_entry *mem)
 			mem->da -= 0x90000;
 		/*
 		 * Check if one of the valid bank base addresses. If not
-		 * report error.
+		 * report error. In lockstep the banks of core 1 follow
+		 * those of core 0.
 		 */
+		peer = xlnx_rpu_lockstep_peer(z_rproc) != NULL;
 		for (bank = 0; bank < z_rproc->soc_data->num_tcms; bank++) {
-			if (mem->da == z_rproc->soc_data->tcm_bases[bank])
+			tcm_base = z_rproc->soc_data->tcm_bases[bank];
+			if (mem->da == tcm_base ||
+			    (peer && mem->da == tcm_base + SPLIT_TCM_BANK_LEN))
 				break;
 		}
 
@@ -567,21 +707,24 @@ static int sram_mem_alloc(struct rproc *rproc, struct rproc_mem_entry *mem)
 }
 
 /*
- * parse_tcm_banks()
+ * xlnx_rpu_add_tcm_banks()
  * @rproc: single RPU core's corresponding rproc instance
+ * @r5_node: RPU node whose sram property lists the TCM banks
+ * @first: first entry of sram_banks used for these banks
+ * @shift: offset subtracted from the address of each bank
  *
- * Given RPU node in remoteproc instance
- * allocate remoteproc carveout for TCM memory
- * needed for firmware to be loaded
+ * allocate remoteproc carveout for each TCM bank of @r5_node
  *
- * return 0 on success, otherwise non-zero value on failure
+ * return next free entry of sram_banks on success, otherwise negative
+ * value on failure
  */
-static int parse_tcm_banks(struct rproc *rproc)
+static int xlnx_rpu_add_tcm_banks(struct rproc *rproc,
+				  struct device_node *r5_node,
+				  unsigned int first, resource_size_t shift)
 {
 	int i, num_banks, ret;
 	struct xlnx_rpu_rproc *z_rproc = rproc->priv;
 	struct device *dev = &rproc->dev;
-	struct device_node *r5_node = z_rproc->dev->of_node;
 	struct sram_addr_data *sram_banks;
 
 	/* go through TCM banks for RPU node */
@@ -595,6 +738,7 @@ static int parse_tcm_banks(struct rproc *rproc)
 		resource_size_t size;
 		struct device_node *dt_node;
 		struct rproc_mem_entry *mem;
+		bool powered;
 
 		dt_node = of_parse_phandle(r5_node, BANK_LIST_PROP, i);
 		if (!dt_node)
@@ -606,19 +750,26 @@ static int parse_tcm_banks(struct rproc *rproc)
 				return ret;
 
 			size = resource_size(&rsc);
+			rsc.start -= shift;
+
+			if (first + i >= MAX_SRAM_NODES) {
+				dev_err(dev, "too many TCM banks\n");
+				of_node_put(dt_node);
+				return -EINVAL;
+			}
 
 			/*
 			 * This is used later to power off the banks when
-			 * stopping rpu core.
-			 *
-			 * This will be managed as a result of 'devm' so does
-			 * not need a free.
+			 * stopping rpu core. A bank still held from the last
+			 * run is already powered on.
 			 */
-			sram_banks = devm_kzalloc(dev, sizeof(struct sram_addr_data),
-						  GFP_KERNEL);
-			if (!sram_banks) {
-				of_node_put(dt_node);
-				return -ENOMEM;
+			sram_banks = &z_rproc->sram_banks[first + i];
+			powered = sram_banks->held;
+			sram_banks->held = false;
+			if (!powered) {
+				memset(sram_banks->ids, 0,
+				       sizeof(sram_banks->ids));
+				z_rproc->num_segs = 0;
 			}
 
 			/*
@@ -627,7 +778,7 @@ static int parse_tcm_banks(struct rproc *rproc)
 			 * remote processor is already up and running so
 			 * this is not needed.
 			 */
-			if (rproc->state == RPROC_OFFLINE) {
+			if (rproc->state == RPROC_OFFLINE && !powered) {
 				ret = xlnx_rpu_pm_request_sram(dev, dt_node,
 							       z_rproc->soc_data->soc_type,
 							       sram_banks);
@@ -651,11 +802,46 @@ static int parse_tcm_banks(struct rproc *rproc)
 		}
 		of_node_put(dt_node);
 	}
-	return 0;
+	return first + num_banks;
 error:
 	return ret;
 }
 
+/*
+ * parse_tcm_banks()
+ * @rproc: single RPU core's corresponding rproc instance
+ *
+ * Given RPU node in remoteproc instance
+ * allocate remoteproc carveout for TCM memory
+ * needed for firmware to be loaded
+ *
+ * return 0 on success, otherwise non-zero value on failure
+ */
+static int parse_tcm_banks(struct rproc *rproc)
+{
+	struct xlnx_rpu_rproc *z_rproc = rproc->priv;
+	struct xlnx_rpu_rproc *peer;
+	int ret;
+
+	ret = xlnx_rpu_add_tcm_banks(rproc, z_rproc->dev->of_node, 0, 0);
+	if (ret < 0)
+		return ret;
+
+	/*
+	 * A lockstep pair switched from split mode at runtime runs from the
+	 * combined TCM: 256 KB with the 2 x 128 KB of both cores.
+	 */
+	peer = xlnx_rpu_lockstep_peer(z_rproc);
+	if (peer) {
+		ret = xlnx_rpu_add_tcm_banks(rproc, peer->dev->of_node, ret,
+					     LOCKSTEP_TCM_SHIFT);
+		if (ret < 0)
+			return ret;
+	}
+
+	return 0;
+}
+
 /*
  * xlnx_rpu_parse_fw()
  * @rproc: single RPU core's corresponding rproc instance
@@ -683,12 +869,134 @@ static int xlnx_rpu_parse_fw(struct rproc *rproc, const struct firmware *fw)
 	return ret;
 }
 
+/*
+ * xlnx_rpu_seg_loaded()
+ * @z_rproc: Remote processor private data
+ * @seg: read-only segment about to be loaded
+ *
+ * return true if the segment is already in RPU memory
+ */
+static bool xlnx_rpu_seg_loaded(struct xlnx_rpu_rproc *z_rproc,
+				const struct xlnx_rpu_seg *seg)
+{
+	unsigned int i;
+
+	for (i = 0; i < z_rproc->num_segs; i++) {
+		const struct xlnx_rpu_seg *cur = &z_rproc->segs[i];
+
+		if (cur->da == seg->da && cur->memsz == seg->memsz &&
+		    cur->filesz == seg->filesz && cur->crc == seg->crc)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * xlnx_rpu_rproc_load()
+ * @rproc: single RPU core's corresponding rproc instance
+ * @fw: ptr to firmware to be loaded onto RPU core
+ *
+ * Load the firmware segments like rproc_elf_load_segments(). With
+ * fast_reload, read-only segments still in RPU memory from the previous
+ * load of the same image are not copied again.
+ *
+ * return 0 on success, otherwise non-zero value on failure
+ */
+static int xlnx_rpu_rproc_load(struct rproc *rproc, const struct firmware *fw)
+{
+	struct xlnx_rpu_rproc *z_rproc = rproc->priv;
+	struct device *dev = &rproc->dev;
+	struct xlnx_rpu_seg segs[MAX_CACHED_SEGS];
+	unsigned int num_segs = 0;
+	const u8 *elf_data = fw->data;
+	u8 class = fw_elf_get_class(fw);
+	u32 phdr_size = elf_size_of_phdr(class);
+	const void *phdr;
+	int i, ret;
+	u16 phnum;
+
+	if (!READ_ONCE(fast_reload)) {
+		z_rproc->num_segs = 0;
+		return rproc_elf_load_segments(rproc, fw);
+	}
+
+	phnum = elf_hdr_get_e_phnum(class, elf_data);
+	phdr = elf_data + elf_hdr_get_e_phoff(class, elf_data);
+
+	for (i = 0; i < phnum; i++, phdr += phdr_size) {
+		struct xlnx_rpu_seg seg;
+		u64 offset = elf_phdr_get_p_offset(class, phdr);
+		bool is_iomem = false;
+		void *ptr;
+
+		seg.da = elf_phdr_get_p_paddr(class, phdr);
+		seg.memsz = elf_phdr_get_p_memsz(class, phdr);
+		seg.filesz = elf_phdr_get_p_filesz(class, phdr);
+
+		if (elf_phdr_get_p_type(class, phdr) != PT_LOAD || !seg.memsz)
+			continue;
+
+		if (seg.filesz > seg.memsz || offset + seg.filesz > fw->size ||
+		    !rproc_u64_fit_in_size_t(seg.memsz)) {
+			dev_err(dev, "bad phdr filesz 0x%llx memsz 0x%llx\n",
+				seg.filesz, seg.memsz);
+			ret = -EINVAL;
+			goto out;
+		}
+
+		ptr = rproc_da_to_va(rproc, seg.da, seg.memsz, &is_iomem);
+		if (!ptr) {
+			dev_err(dev, "bad phdr da 0x%llx mem 0x%llx\n", seg.da,
+				seg.memsz);
+			ret = -EINVAL;
+			goto out;
+		}
+
+		/* Writable segments are dirtied by the firmware, always load */
+		if (!(elf_phdr_get_p_flags(class, phdr) & PF_W)) {
+			seg.crc = crc32(~0U, elf_data + offset, seg.filesz);
+			if (num_segs < MAX_CACHED_SEGS &&
+			    xlnx_rpu_seg_loaded(z_rproc, &seg)) {
+				dev_dbg(dev, "segment da 0x%llx unchanged\n",
+					seg.da);
+				segs[num_segs++] = seg;
+				continue;
+			}
+		}
+
+		rproc_load_segment(rproc, ptr, seg.da, is_iomem,
+				   elf_data + offset, seg.filesz, seg.memsz);
+
+		if (!(elf_phdr_get_p_flags(class, phdr) & PF_W) &&
+		    num_segs < MAX_CACHED_SEGS)
+			segs[num_segs++] = seg;
+	}
+
+	memcpy(z_rproc->segs, segs, num_segs * sizeof(segs[0]));
+	z_rproc->num_segs = num_segs;
+
+	return 0;
+out:
+	z_rproc->num_segs = 0;
+	return ret;
+}
+
 static int xlnx_rpu_prepare(struct rproc *rproc)
 {
 	struct xlnx_rpu_rproc *z_rproc = rproc->priv;
+	struct xlnx_rpu_cluster *cluster = z_rproc->cluster;
 	struct device *dev = rproc->dev.parent;
 	int ret;
 
+	/* The second core of a lockstep pair only checks the first one */
+	if (cluster->mode == PM_RPU_MODE_LOCKSTEP &&
+	    z_rproc != list_first_entry(&cluster->cores,
+					struct xlnx_rpu_rproc, elem)) {
+		dev_err(dev, "RPU core is in lockstep, switch to split mode\n");
+		return -EBUSY;
+	}
+
 	/*
 	 * In Versal SoC, the Xilinx platform management firmware will power
 	 * off the RPU cores if they are not requested. In this case, this call
@@ -756,47 +1064,40 @@ static int xlnx_rpu_rproc_detach(struct rproc *rproc)
  * xlnx_rpu_rproc_kick() - kick a firmware if mbox is provided
  * @rproc: RPU core's corresponding rproc structure
  * @vqid: virtqueue ID
+ *
+ * The remote scans all of its virtqueues on each IPI, so while a kick is
+ * still waiting to be acknowledged a further one carries no information
+ * and is dropped. This keeps at most one kick in flight and lets it use
+ * a preallocated message.
  */
 static void xlnx_rpu_rproc_kick(struct rproc *rproc, int vqid)
 {
-	struct zynqmp_ipi_message *mb_msg = NULL;
-	struct sk_buff *skb = NULL;
-	unsigned int skb_len = 0;
-	int ret;
-
 	struct device *dev = rproc->dev.parent;
 	struct xlnx_rpu_rproc *z_rproc = rproc->priv;
+	struct zynqmp_ipi_message *mb_msg;
+	int ret;
 
-	if (of_property_read_bool(dev->of_node, "mboxes")) {
-		skb_len = (unsigned int)(sizeof(vqid) + sizeof(mb_msg));
-		skb = alloc_skb(skb_len, GFP_ATOMIC);
-		if (!skb)
-			return;
+	if (!z_rproc->tx_chan)
+		return;
 
-		mb_msg = (struct zynqmp_ipi_message *)skb_put(skb, skb_len);
-		mb_msg->len = sizeof(vqid);
-		memcpy(mb_msg->data, &vqid, sizeof(vqid));
+	if (test_and_set_bit(RPU_KICK_PENDING, &z_rproc->kick_flags))
+		return;
 
-		skb_queue_tail(&z_rproc->tx_mc_skbs, skb);
-		ret = mbox_send_message(z_rproc->tx_chan, mb_msg);
-		if (ret < 0) {
-			dev_warn(dev, "Failed to kick remote.\n");
-			skb_dequeue_tail(&z_rproc->tx_mc_skbs);
-			kfree_skb(skb);
-		}
-	} else {
-		(void)skb;
-		(void)skb_len;
-		(void)mb_msg;
-		(void)ret;
-		(void)vqid;
+	mb_msg = (struct zynqmp_ipi_message *)z_rproc->tx_mc_buf;
+	mb_msg->len = sizeof(vqid);
+	memcpy(mb_msg->data, &vqid, sizeof(vqid));
+
+	ret = mbox_send_message(z_rproc->tx_chan, mb_msg);
+	if (ret < 0) {
+		dev_warn(dev, "Failed to kick remote.\n");
+		clear_bit(RPU_KICK_PENDING, &z_rproc->kick_flags);
 	}
 }
 
 static struct rproc_ops xlnx_rpu_rproc_ops = {
 	.start		= xlnx_rpu_rproc_start,
 	.stop		= xlnx_rpu_rproc_stop,
-	.load		= rproc_elf_load_segments,
+	.load		= xlnx_rpu_rproc_load,
 	.parse_fw	= xlnx_rpu_parse_fw,
 	.prepare	= xlnx_rpu_prepare,
 	.find_loaded_rsc_table = rproc_elf_find_loaded_rsc_table,
@@ -872,7 +1173,8 @@ static void xlnx_rpu_mb_rx_cb(struct mbox_client *cl, void *msg)
 		buf_msg->len = len;
 		memcpy(buf_msg->data, ipi_msg->data, len);
 	}
-	schedule_work(&z_rproc->mbox_work);
+	/* Virtqueue callbacks may sleep; use the high priority workers */
+	queue_work(system_highpri_wq, &z_rproc->mbox_work);
 }
 
 /**
@@ -886,13 +1188,11 @@ static void xlnx_rpu_mb_rx_cb(struct mbox_client *cl, void *msg)
 static void xlnx_rpu_mb_tx_done(struct mbox_client *cl, void *msg, int r)
 {
 	struct xlnx_rpu_rproc *z_rproc;
-	struct sk_buff *skb;
 
 	if (!msg)
 		return;
 	z_rproc = container_of(cl, struct xlnx_rpu_rproc, tx_mc);
-	skb = skb_dequeue(&z_rproc->tx_mc_skbs);
-	kfree_skb(skb);
+	clear_bit(RPU_KICK_PENDING, &z_rproc->kick_flags);
 }
 
 /**
@@ -942,7 +1242,7 @@ static int xlnx_rpu_setup_mbox(struct xlnx_rpu_rproc *z_rproc,
 		z_rproc->rx_chan = NULL;
 		return -EINVAL;
 	}
-	skb_queue_head_init(&z_rproc->tx_mc_skbs);
+	z_rproc->kick_flags = 0;
 
 	return 0;
 }
@@ -962,10 +1262,40 @@ static int xlnx_rpu_setup_mbox(struct xlnx_rpu_rproc *z_rproc,
  *
  * Return: 0 for success, negative value for failure.
  */
+static void xlnx_rpu_release_load_chan(void *chan)
+{
+	dma_release_channel(chan);
+}
+
+/*
+ * xlnx_rpu_setup_load_chan()
+ * @rproc: single RPU core's corresponding rproc instance
+ *
+ * Request the optional "load" DMA channel, e.g. a GDMA channel, that
+ * rproc_load_segment() copies large firmware segments with.
+ *
+ * return 0 on success or if there is no channel, otherwise negative errno
+ */
+static int xlnx_rpu_setup_load_chan(struct rproc *rproc)
+{
+	struct device *dev = rproc->dev.parent;
+	struct dma_chan *chan;
+
+	chan = dma_request_chan(dev, "load");
+	if (IS_ERR(chan)) {
+		if (PTR_ERR(chan) == -EPROBE_DEFER)
+			return -EPROBE_DEFER;
+		return 0;
+	}
+
+	rproc->load_chan = chan;
+
+	return devm_add_action_or_reset(dev, xlnx_rpu_release_load_chan, chan);
+}
+
 static int xlnx_rpu_probe(struct platform_device *pdev,
 			  struct device_node *node,
-			  enum rpu_oper_mode rpu_mode,
-			  const struct xlnx_rpu_soc_data *data,
+			  struct xlnx_rpu_cluster *cluster,
 			  struct xlnx_rpu_rproc **z_rproc)
 {
 	struct device *dev = &pdev->dev;
@@ -1013,7 +1343,8 @@ static int xlnx_rpu_probe(struct platform_device *pdev,
 	of_property_read_u32_index(node, PD_PROP, 1U, &pnode_id);
 	(*z_rproc)->pnode_id = pnode_id;
 
-	(*z_rproc)->soc_data = data;
+	(*z_rproc)->soc_data = cluster->soc_data;
+	(*z_rproc)->cluster = cluster;
 
 	if (of_property_read_bool(node, "mboxes")) {
 		ret = xlnx_rpu_setup_mbox(*z_rproc, node);
@@ -1021,6 +1352,10 @@ static int xlnx_rpu_probe(struct platform_device *pdev,
 			goto error;
 	}
 
+	ret = xlnx_rpu_setup_load_chan(rproc);
+	if (ret)
+		goto error;
+
 	/* Add RPU remoteproc */
 	ret = devm_rproc_add(dev, rproc);
 	if (ret)
@@ -1076,7 +1411,7 @@ static int xlnx_rpu_probe(struct platform_device *pdev,
 		 * If we are here then we are using the rproc state that is
 		 * set by rproc_alloc (OFFLINE).
 		 */
-		ret = rpu_set_mode(*z_rproc, rpu_mode);
+		ret = rpu_set_mode(*z_rproc, cluster->mode);
 		if (ret)
 			goto error;
 
@@ -1090,6 +1425,96 @@ static int xlnx_rpu_probe(struct platform_device *pdev,
 	return ret;
 }
 
+static ssize_t cluster_mode_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct xlnx_rpu_cluster *cluster = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%s\n",
+			  cluster->mode == PM_RPU_MODE_LOCKSTEP ?
+			  "lockstep" : "split");
+}
+
+/*
+ * cluster_mode_store()
+ *
+ * Switch the cluster between lockstep and split mode. Both cores must be
+ * described in the device tree and be offline, the TCM banks are regrouped
+ * the next time core 0, and in split mode core 1, is started.
+ */
+static ssize_t cluster_mode_store(struct device *dev,
+				  struct device_attribute *attr,
+				  const char *buf, size_t count)
+{
+	struct xlnx_rpu_cluster *cluster = dev_get_drvdata(dev);
+	struct xlnx_rpu_rproc *z_rproc, *core0, *core1;
+	enum rpu_oper_mode mode;
+	int ret;
+
+	if (sysfs_streq(buf, "lockstep"))
+		mode = PM_RPU_MODE_LOCKSTEP;
+	else if (sysfs_streq(buf, "split"))
+		mode = PM_RPU_MODE_SPLIT;
+	else
+		return -EINVAL;
+
+	/* Versal-Net does not have the TCM combining register. */
+	if (cluster->num_cores != MAX_RPROCS ||
+	    cluster->soc_data->soc_type == SOC_VERSAL_NET)
+		return -EOPNOTSUPP;
+
+	core0 = list_first_entry(&cluster->cores, struct xlnx_rpu_rproc, elem);
+	core1 = list_last_entry(&cluster->cores, struct xlnx_rpu_rproc, elem);
+
+	/* Keep both cores from being started while the mode changes */
+	ret = mutex_lock_interruptible(&core0->rproc->lock);
+	if (ret)
+		return ret;
+	mutex_lock_nested(&core1->rproc->lock, SINGLE_DEPTH_NESTING);
+
+	if (mode == cluster->mode)
+		goto out;
+
+	if (core0->rproc->state != RPROC_OFFLINE ||
+	    core1->rproc->state != RPROC_OFFLINE) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	/* The TCM banks are regrouped, drop what fast_reload kept */
+	xlnx_rpu_release_held_sram(core0);
+	xlnx_rpu_release_held_sram(core1);
+
+	list_for_each_entry(z_rproc, &cluster->cores, elem) {
+		ret = rpu_set_mode(z_rproc, mode);
+		if (ret)
+			break;
+	}
+
+	if (ret) {
+		dev_err(dev, "failed to set RPU mode, ret = %d\n", ret);
+		list_for_each_entry(z_rproc, &cluster->cores, elem)
+			rpu_set_mode(z_rproc, cluster->mode);
+		goto out;
+	}
+
+	cluster->mode = mode;
+	dev_dbg(dev, "RPU configuration: %s\n",
+		mode == PM_RPU_MODE_LOCKSTEP ? "lockstep" : "split");
+out:
+	mutex_unlock(&core1->rproc->lock);
+	mutex_unlock(&core0->rproc->lock);
+
+	return ret ? ret : count;
+}
+static DEVICE_ATTR_RW(cluster_mode);
+
+static struct attribute *xlnx_rpu_attrs[] = {
+	&dev_attr_cluster_mode.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(xlnx_rpu);
+
 /*
  * xlnx_rpu_remoteproc_probe()
  *
@@ -1106,7 +1531,7 @@ static int xlnx_rpu_remoteproc_probe(struct platform_device *pdev)
 	struct device *dev = &pdev->dev;
 	struct device_node *nc;
 	enum rpu_oper_mode rpu_mode = PM_RPU_MODE_LOCKSTEP;
-	struct list_head *cluster; /* list to track each core's rproc */
+	struct xlnx_rpu_cluster *cluster;
 	struct xlnx_rpu_rproc *z_rproc = NULL;
 	struct platform_device *child_pdev;
 	struct list_head *pos;
@@ -1123,20 +1548,15 @@ static int xlnx_rpu_remoteproc_probe(struct platform_device *pdev)
 	dev_dbg(dev, "RPU configuration: %s\n",
 		rpu_mode == PM_RPU_MODE_LOCKSTEP ? "lockstep" : "split");
 
-	/*
-	 * if 2 RPUs provided but one is lockstep, then we have an
-	 * invalid configuration.
-	 */
-
 	core_count = of_get_available_child_count(dev->of_node);
-	if ((rpu_mode == PM_RPU_MODE_LOCKSTEP && core_count != 1) ||
-	    core_count > MAX_RPROCS)
+	if (!core_count || core_count > MAX_RPROCS)
 		return -EINVAL;
 
 	cluster = devm_kzalloc(dev, sizeof(*cluster), GFP_KERNEL);
 	if (!cluster)
 		return -ENOMEM;
-	INIT_LIST_HEAD(cluster);
+	INIT_LIST_HEAD(&cluster->cores);
+	cluster->mode = rpu_mode;
 
 	ret = devm_of_platform_populate(dev);
 	if (ret) {
@@ -1154,6 +1574,15 @@ static int xlnx_rpu_remoteproc_probe(struct platform_device *pdev)
 		dev_err(dev, "SoC-specific data is not defined\n");
 		return -ENODEV;
 	}
+	cluster->soc_data = data;
+
+	/*
+	 * Lockstep with both cores described lets the cluster be switched
+	 * to split mode later on, which Versal-Net does not support.
+	 */
+	if (rpu_mode == PM_RPU_MODE_LOCKSTEP && core_count != 1 &&
+	    data->soc_type == SOC_VERSAL_NET)
+		return -EINVAL;
 
 	/* probe each individual RPU core's remoteproc-related info */
 	for_each_available_child_of_node(dev->of_node, nc) {
@@ -1163,8 +1592,7 @@ static int xlnx_rpu_remoteproc_probe(struct platform_device *pdev)
 			ret = -ENODEV;
 			goto out;
 		}
-		ret = xlnx_rpu_probe(child_pdev, nc, rpu_mode, data,
-				     &z_rproc);
+		ret = xlnx_rpu_probe(child_pdev, nc, cluster, &z_rproc);
 		dev_dbg(dev, "%s to probe rpu %pOF\n",
 			ret ? "Failed" : "Able",
 			nc);
@@ -1175,7 +1603,8 @@ static int xlnx_rpu_remoteproc_probe(struct platform_device *pdev)
 			goto out;
 		}
 
-		list_add_tail(&z_rproc->elem, cluster);
+		list_add_tail(&z_rproc->elem, &cluster->cores);
+		cluster->num_cores++;
 		put_device(&child_pdev->dev);
 	}
 	/* wire in so each core can be cleaned up at driver remove */
@@ -1183,14 +1612,13 @@ static int xlnx_rpu_remoteproc_probe(struct platform_device *pdev)
 	return 0;
 out:
 	/*
-	 * undo core0 upon any failures on core1 in split-mode
+	 * undo core0 upon any failures on core1
 	 *
 	 * in xlnx_rpu_probe z_rproc is set to null
 	 * and ret to non-zero value if error
 	 */
-	if (ret && !z_rproc && rpu_mode == PM_RPU_MODE_SPLIT &&
-	    !list_empty(cluster)) {
-		list_for_each(pos, cluster) {
+	if (ret && !z_rproc && !list_empty(&cluster->cores)) {
+		list_for_each(pos, &cluster->cores) {
 			z_rproc = list_entry(pos, struct xlnx_rpu_rproc, elem);
 			if (of_property_read_bool(z_rproc->dev->of_node, "mboxes")) {
 				mbox_free_channel(z_rproc->tx_chan);
@@ -1211,13 +1639,17 @@ static int xlnx_rpu_remoteproc_probe(struct platform_device *pdev)
  */
 static int xlnx_rpu_remoteproc_remove(struct platform_device *pdev)
 {
-	struct list_head *pos, *temp, *cluster = (struct list_head *)
-						 platform_get_drvdata(pdev);
+	struct xlnx_rpu_cluster *cluster = platform_get_drvdata(pdev);
+	struct list_head *pos, *temp;
 	struct xlnx_rpu_rproc *z_rproc = NULL;
 
-	list_for_each_safe(pos, temp, cluster) {
+	list_for_each_safe(pos, temp, &cluster->cores) {
 		z_rproc = list_entry(pos, struct xlnx_rpu_rproc, elem);
 
+		/* Banks kept powered by fast_reload while the core is off */
+		z_rproc->removing = true;
+		xlnx_rpu_release_held_sram(z_rproc);
+
 		/*
 		 * For Versal platform, the Xilinx platform management
 		 * firmware needs to have a release call to match the
@@ -1231,6 +1663,7 @@ static int xlnx_rpu_remoteproc_remove(struct platform_device *pdev)
 		if (of_property_read_bool(z_rproc->dev->of_node, "mboxes")) {
 			mbox_free_channel(z_rproc->tx_chan);
 			mbox_free_channel(z_rproc->rx_chan);
+			cancel_work_sync(&z_rproc->mbox_work);
 		}
 		list_del(pos);
 	}
@@ -1270,6 +1703,7 @@ static struct platform_driver zynqmp_r5_remoteproc_driver = {
 	.driver = {
 		.name = "zynqmp_r5_remoteproc",
 		.of_match_table = xilinx_r5_of_match,
+		.dev_groups = xlnx_rpu_groups,
 	},
 };
 module_platform_driver(zynqmp_r5_remoteproc_driver);
@@ -14,10 +14,14 @@
 #include <linux/interrupt.h>
 #include <linux/irq.h>
 #include <linux/irqdomain.h>
+#include <linux/kfifo.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of_irq.h>
 #include <linux/platform_device.h>
+#include <linux/rculist.h>
 #include <linux/slab.h>
+#include <linux/workqueue.h>
 
 static DEFINE_PER_CPU_READ_MOSTLY(int, cpu_number1);
 
@@ -37,21 +41,57 @@ static int event_manager_availability = -EACCES;
 
 #define REGISTER_NOTIFIER_FIRMWARE_VERSION	(2U)
 
+/* Notify events buffered per CPU for deferred delivery (power of 2) */
+#define XLNX_EVENT_FIFO_SIZE	(16U)
+
+/*
+ * The SGI handler looks entries up under RCU only; registration and removal
+ * are serialized by reg_driver_lock.
+ */
 static DEFINE_HASHTABLE(reg_driver_map, REGISTERED_DRIVER_MAX_ORDER);
+static DEFINE_MUTEX(reg_driver_lock);
 static int sgi_num = XLNX_EVENT_SGI_NUM;
 
 static bool is_need_to_unregister;
 
+/*
+ * Deliver PM_NOTIFY_CB events (error, EDAC, XilSEM) from the xlnx_event
+ * workqueue rather than from the SGI handler. The CPUs it runs on can be
+ * set through /sys/devices/virtual/workqueue/xlnx_event/cpumask.
+ */
+static bool defer_notify = true;
+module_param(defer_notify, bool, 0644);
+MODULE_PARM_DESC(defer_notify,
+		 "Deliver notify events from a workqueue (default: Y)");
+
+struct xlnx_event_payload {
+	u32 payload[CB_MAX_PAYLOAD_SIZE];
+};
+
+/* Filled by the SGI handler of one CPU, drained by notify_work only */
+struct xlnx_event_fifo {
+	DECLARE_KFIFO(fifo, struct xlnx_event_payload, XLNX_EVENT_FIFO_SIZE);
+};
+
+static DEFINE_PER_CPU(struct xlnx_event_fifo, notify_fifo);
+static struct workqueue_struct *event_wq;
+static void xlnx_event_notify_work(struct work_struct *work);
+static DECLARE_WORK(notify_work, xlnx_event_notify_work);
+static void xlnx_event_reap_work(struct work_struct *work);
+static DECLARE_WORK(reap_work, xlnx_event_reap_work);
+
 /**
  * struct agent_cb - Registered callback function and private data.
  * @agent_data:		Data passed back to handler function.
  * @eve_cb:		Function pointer to store the callback function.
  * @list:		member to create list.
+ * @rcu:		RCU head used to free the callback.
  */
 struct agent_cb {
 	void *agent_data;
 	event_cb_func_t eve_cb;
 	struct list_head list;
+	struct rcu_head rcu;
 };
 
 /**
@@ -65,6 +105,9 @@ struct agent_cb {
  * @cb_list_head:	Head of call back data list which contain the information
  *			about registered handler and private data.
  * @hentry:		hlist_node that hooks this entry into hashtable.
+ * @stale:		Re-registration with the firmware failed; the entry is
+ *			skipped by dispatch and removed by reap_work.
+ * @rcu:		RCU head used to free the entry.
  */
 struct registered_event_data {
 	u64 key;
@@ -72,6 +115,8 @@ struct registered_event_data {
 	bool wake;
 	struct list_head cb_list_head;
 	struct hlist_node hentry;
+	bool stale;
+	struct rcu_head rcu;
 };
 
 static bool xlnx_is_error_event(const u32 node_id)
@@ -112,6 +157,7 @@ static int xlnx_add_cb_for_notify_event(const u32 node_id, const u32 event, cons
 		eve_data->key = key;
 		eve_data->cb_type = PM_NOTIFY_CB;
 		eve_data->wake = wake;
+		eve_data->stale = false;
 		INIT_LIST_HEAD(&eve_data->cb_list_head);
 
 		cb_data = kmalloc(sizeof(*cb_data), GFP_KERNEL);
@@ -126,7 +172,7 @@ static int xlnx_add_cb_for_notify_event(const u32 node_id, const u32 event, cons
 		list_add(&cb_data->list, &eve_data->cb_list_head);
 
 		/* Add into HASH table */
-		hash_add(reg_driver_map, &eve_data->hentry, key);
+		hash_add_rcu(reg_driver_map, &eve_data->hentry, key);
 	} else {
 		/* Search for callback function and private data in list */
 		list_for_each_entry_safe(cb_pos, cb_next, &eve_data->cb_list_head, list) {
@@ -143,7 +189,7 @@ static int xlnx_add_cb_for_notify_event(const u32 node_id, const u32 event, cons
 		cb_data->eve_cb = cb_fun;
 		cb_data->agent_data = data;
 
-		list_add(&cb_data->list, &eve_data->cb_list_head);
+		list_add_rcu(&cb_data->list, &eve_data->cb_list_head);
 	}
 
 	return 0;
@@ -169,18 +215,21 @@ static int xlnx_add_cb_for_suspend(event_cb_func_t cb_fun, void *data)
 
 	eve_data->key = 0;
 	eve_data->cb_type = PM_INIT_SUSPEND_CB;
+	eve_data->stale = false;
 	INIT_LIST_HEAD(&eve_data->cb_list_head);
 
 	cb_data = kmalloc(sizeof(*cb_data), GFP_KERNEL);
-	if (!cb_data)
+	if (!cb_data) {
+		kfree(eve_data);
 		return -ENOMEM;
+	}
 	cb_data->eve_cb = cb_fun;
 	cb_data->agent_data = data;
 
 	/* Add into callback list */
 	list_add(&cb_data->list, &eve_data->cb_list_head);
 
-	hash_add(reg_driver_map, &eve_data->hentry, PM_INIT_SUSPEND_CB);
+	hash_add_rcu(reg_driver_map, &eve_data->hentry, PM_INIT_SUSPEND_CB);
 
 	return 0;
 }
@@ -201,13 +250,13 @@ static int xlnx_remove_cb_for_suspend(event_cb_func_t cb_fun)
 			list_for_each_entry_safe(cb_pos, cb_next, &eve_data->cb_list_head, list) {
 				if (cb_pos->eve_cb == cb_fun) {
 					is_callback_found = true;
-					list_del_init(&cb_pos->list);
-					kfree(cb_pos);
+					list_del_rcu(&cb_pos->list);
+					kfree_rcu(cb_pos, rcu);
 				}
 			}
 			/* remove an object from a hashtable */
-			hash_del(&eve_data->hentry);
-			kfree(eve_data);
+			hash_del_rcu(&eve_data->hentry);
+			kfree_rcu(eve_data, rcu);
 			is_need_to_unregister = true;
 		}
 	}
@@ -238,16 +287,16 @@ static int xlnx_remove_cb_for_notify_event(const u32 node_id, const u32 event,
 				if (cb_pos->eve_cb == cb_fun &&
 				    cb_pos->agent_data == data) {
 					is_callback_found = true;
-					list_del_init(&cb_pos->list);
-					kfree(cb_pos);
+					list_del_rcu(&cb_pos->list);
+					kfree_rcu(cb_pos, rcu);
 				}
 			}
 
 			/* Remove HASH table if callback list is empty */
 			if (list_empty(&eve_data->cb_list_head)) {
 				/* remove an object from a HASH table */
-				hash_del(&eve_data->hentry);
-				kfree(eve_data);
+				hash_del_rcu(&eve_data->hentry);
+				kfree_rcu(eve_data, rcu);
 				is_need_to_unregister = true;
 			}
 		}
@@ -261,38 +310,15 @@ static int xlnx_remove_cb_for_notify_event(const u32 node_id, const u32 event,
 	return 0;
 }
 
-/**
- * xlnx_register_event() - Register for the event.
- * @cb_type:	Type of callback from pm_api_cb_id,
- *			PM_NOTIFY_CB - for Error Events,
- *			PM_INIT_SUSPEND_CB - for suspend callback.
- * @node_id:	Node-Id related to event.
- * @event:	Event Mask for the Error Event.
- * @wake:	Flag specifying whether the subsystem should be woken upon
- *		event notification.
- * @cb_fun:	Function pointer to store the callback function.
- * @data:	Pointer for the driver instance.
- *
- * Return:	Returns 0 on successful registration else error code.
- */
-int xlnx_register_event(const enum pm_api_cb_id cb_type, const u32 node_id, const u32 event,
-			const bool wake, event_cb_func_t cb_fun, void *data)
+static int __xlnx_register_event(const enum pm_api_cb_id cb_type,
+				 const u32 node_id, const u32 event,
+				 const bool wake, event_cb_func_t cb_fun,
+				 void *data)
 {
 	int ret = 0;
 	u32 eve;
 	int pos;
 
-	if (event_manager_availability)
-		return event_manager_availability;
-
-	if (cb_type != PM_NOTIFY_CB && cb_type != PM_INIT_SUSPEND_CB) {
-		pr_err("%s() Unsupported Callback 0x%x\n", __func__, cb_type);
-		return -EINVAL;
-	}
-
-	if (!cb_fun)
-		return -EFAULT;
-
 	if (cb_type == PM_INIT_SUSPEND_CB) {
 		ret = xlnx_add_cb_for_suspend(cb_fun, data);
 	} else {
@@ -354,27 +380,25 @@ int xlnx_register_event(const enum pm_api_cb_id cb_type, const u32 node_id, cons
 
 	return ret;
 }
-EXPORT_SYMBOL_GPL(xlnx_register_event);
 
 /**
- * xlnx_unregister_event() - Unregister for the event.
+ * xlnx_register_event() - Register for the event.
  * @cb_type:	Type of callback from pm_api_cb_id,
  *			PM_NOTIFY_CB - for Error Events,
  *			PM_INIT_SUSPEND_CB - for suspend callback.
  * @node_id:	Node-Id related to event.
  * @event:	Event Mask for the Error Event.
- * @cb_fun:	Function pointer of callback function.
- * @data:	Pointer of agent's private data.
+ * @wake:	Flag specifying whether the subsystem should be woken upon
+ *		event notification.
+ * @cb_fun:	Function pointer to store the callback function.
+ * @data:	Pointer for the driver instance.
  *
- * Return:	Returns 0 on successful unregistration else error code.
+ * Return:	Returns 0 on successful registration else error code.
  */
-int xlnx_unregister_event(const enum pm_api_cb_id cb_type, const u32 node_id, const u32 event,
-			  event_cb_func_t cb_fun, void *data)
+int xlnx_register_event(const enum pm_api_cb_id cb_type, const u32 node_id, const u32 event,
+			const bool wake, event_cb_func_t cb_fun, void *data)
 {
-	int ret = 0;
-	u32 eve, pos;
-
-	is_need_to_unregister = false;
+	int ret;
 
 	if (event_manager_availability)
 		return event_manager_availability;
@@ -387,6 +411,24 @@ int xlnx_unregister_event(const enum pm_api_cb_id cb_type, const u32 node_id, co
 	if (!cb_fun)
 		return -EFAULT;
 
+	mutex_lock(&reg_driver_lock);
+	ret = __xlnx_register_event(cb_type, node_id, event, wake, cb_fun,
+				    data);
+	mutex_unlock(&reg_driver_lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(xlnx_register_event);
+
+static int __xlnx_unregister_event(const enum pm_api_cb_id cb_type,
+				   const u32 node_id, const u32 event,
+				   event_cb_func_t cb_fun, void *data)
+{
+	int ret = 0;
+	u32 eve, pos;
+
+	is_need_to_unregister = false;
+
 	if (cb_type == PM_INIT_SUSPEND_CB) {
 		ret = xlnx_remove_cb_for_suspend(cb_fun);
 	} else {
@@ -417,6 +459,41 @@ int xlnx_unregister_event(const enum pm_api_cb_id cb_type, const u32 node_id, co
 
 	return ret;
 }
+
+/**
+ * xlnx_unregister_event() - Unregister for the event.
+ * @cb_type:	Type of callback from pm_api_cb_id,
+ *			PM_NOTIFY_CB - for Error Events,
+ *			PM_INIT_SUSPEND_CB - for suspend callback.
+ * @node_id:	Node-Id related to event.
+ * @event:	Event Mask for the Error Event.
+ * @cb_fun:	Function pointer of callback function.
+ * @data:	Pointer of agent's private data.
+ *
+ * Return:	Returns 0 on successful unregistration else error code.
+ */
+int xlnx_unregister_event(const enum pm_api_cb_id cb_type, const u32 node_id, const u32 event,
+			  event_cb_func_t cb_fun, void *data)
+{
+	int ret;
+
+	if (event_manager_availability)
+		return event_manager_availability;
+
+	if (cb_type != PM_NOTIFY_CB && cb_type != PM_INIT_SUSPEND_CB) {
+		pr_err("%s() Unsupported Callback 0x%x\n", __func__, cb_type);
+		return -EINVAL;
+	}
+
+	if (!cb_fun)
+		return -EFAULT;
+
+	mutex_lock(&reg_driver_lock);
+	ret = __xlnx_unregister_event(cb_type, node_id, event, cb_fun, data);
+	mutex_unlock(&reg_driver_lock);
+
+	return ret;
+}
 EXPORT_SYMBOL_GPL(xlnx_unregister_event);
 
 static void xlnx_call_suspend_cb_handler(const u32 *payload)
@@ -425,17 +502,18 @@ static void xlnx_call_suspend_cb_handler(const u32 *payload)
 	struct registered_event_data *eve_data;
 	u32 cb_type = payload[0];
 	struct agent_cb *cb_pos;
-	struct agent_cb *cb_next;
 
+	rcu_read_lock();
 	/* Check for existing entry in hash table for given cb_type */
-	hash_for_each_possible(reg_driver_map, eve_data, hentry, cb_type) {
+	hash_for_each_possible_rcu(reg_driver_map, eve_data, hentry, cb_type) {
 		if (eve_data->cb_type == cb_type) {
-			list_for_each_entry_safe(cb_pos, cb_next, &eve_data->cb_list_head, list) {
+			list_for_each_entry_rcu(cb_pos, &eve_data->cb_list_head, list) {
 				cb_pos->eve_cb(&payload[0], cb_pos->agent_data);
 				is_callback_found = true;
 			}
 		}
 	}
+	rcu_read_unlock();
 	if (!is_callback_found)
 		pr_warn("Didn't find any registered callback for suspend event\n");
 }
@@ -447,12 +525,12 @@ static void xlnx_call_notify_cb_handler(const u32 *payload)
 	u64 key = ((u64)payload[1] << 32U) | (u64)payload[2];
 	int ret;
 	struct agent_cb *cb_pos;
-	struct agent_cb *cb_next;
 
+	rcu_read_lock();
 	/* Check for existing entry in hash table for given key id */
-	hash_for_each_possible(reg_driver_map, eve_data, hentry, key) {
-		if (eve_data->key == key) {
-			list_for_each_entry_safe(cb_pos, cb_next, &eve_data->cb_list_head, list) {
+	hash_for_each_possible_rcu(reg_driver_map, eve_data, hentry, key) {
+		if (eve_data->key == key && !READ_ONCE(eve_data->stale)) {
+			list_for_each_entry_rcu(cb_pos, &eve_data->cb_list_head, list) {
 				cb_pos->eve_cb(&payload[0], cb_pos->agent_data);
 				is_callback_found = true;
 			}
@@ -463,21 +541,87 @@ static void xlnx_call_notify_cb_handler(const u32 *payload)
 			if (ret) {
 				pr_err("%s() failed for 0x%x and 0x%x: %d\r\n", __func__,
 				       payload[1], payload[2], ret);
-				list_for_each_entry_safe(cb_pos, cb_next, &eve_data->cb_list_head,
-							 list) {
-					/* Remove already registered event from hash table */
-					xlnx_remove_cb_for_notify_event(payload[1], payload[2],
-									cb_pos->eve_cb,
-									cb_pos->agent_data);
-				}
+				/* Removal needs reg_driver_lock */
+				WRITE_ONCE(eve_data->stale, true);
+				schedule_work(&reap_work);
 			}
 		}
 	}
+	rcu_read_unlock();
 	if (!is_callback_found)
 		pr_warn("Unhandled SGI node 0x%x event 0x%x. Expected with Xen hypervisor\n",
 			payload[1], payload[2]);
 }
 
+static void xlnx_dispatch_notify_event(const u32 *payload)
+{
+	u32 event_data[CB_MAX_PAYLOAD_SIZE] = {0};
+	u32 node_id = payload[1];
+	u32 event = payload[2];
+	u32 pos;
+
+	if (!xlnx_is_error_event(node_id)) {
+		xlnx_call_notify_cb_handler(payload);
+		return;
+	}
+
+	/*
+	 * Each call back function expecting payload as an input arguments.
+	 * We can get multiple error events as in one call back through error
+	 * mask. So payload[2] may can contain multiple error events.
+	 * In reg_driver_map database we store data in the combination of single
+	 * node_id-error combination.
+	 * So coping the payload message into event_data and update the
+	 * event_data[2] with Error Mask for single error event and use
+	 * event_data as input argument for registered call back function.
+	 *
+	 */
+	memcpy(event_data, payload, (4 * CB_MAX_PAYLOAD_SIZE));
+	/* Support Multiple Error Event */
+	for (pos = 0; pos < MAX_BITS; pos++) {
+		if ((0 == (event & (1 << pos))))
+			continue;
+		event_data[2] = (event & (1 << pos));
+		xlnx_call_notify_cb_handler(event_data);
+	}
+}
+
+static void xlnx_event_notify_work(struct work_struct *work)
+{
+	struct xlnx_event_payload ev;
+	struct xlnx_event_fifo *f;
+	int cpu;
+
+	/* A work item never runs concurrently with itself: single consumer */
+	for_each_possible_cpu(cpu) {
+		f = per_cpu_ptr(&notify_fifo, cpu);
+		while (kfifo_get(&f->fifo, &ev))
+			xlnx_dispatch_notify_event(ev.payload);
+	}
+}
+
+static void xlnx_event_reap_work(struct work_struct *work)
+{
+	struct registered_event_data *eve_data;
+	struct agent_cb *cb_pos, *cb_next;
+	struct hlist_node *tmp;
+	int i;
+
+	mutex_lock(&reg_driver_lock);
+	hash_for_each_safe(reg_driver_map, i, tmp, eve_data, hentry) {
+		if (!eve_data->stale)
+			continue;
+
+		list_for_each_entry_safe(cb_pos, cb_next, &eve_data->cb_list_head, list) {
+			list_del_rcu(&cb_pos->list);
+			kfree_rcu(cb_pos, rcu);
+		}
+		hash_del_rcu(&eve_data->hentry);
+		kfree_rcu(eve_data, rcu);
+	}
+	mutex_unlock(&reg_driver_lock);
+}
+
 static void xlnx_get_event_callback_data(u32 *buf)
 {
 	zynqmp_pm_invoke_fn(GET_CALLBACK_DATA, 0, 0, 0, 0, 0, buf);
@@ -485,9 +629,9 @@ static void xlnx_get_event_callback_data(u32 *buf)
 
 static irqreturn_t xlnx_event_handler(int irq, void *dev_id)
 {
-	u32 cb_type, node_id, event, pos;
-	u32 payload[CB_MAX_PAYLOAD_SIZE] = {0};
-	u32 event_data[CB_MAX_PAYLOAD_SIZE] = {0};
+	struct xlnx_event_payload ev = {0};
+	u32 *payload = ev.payload;
+	u32 cb_type;
 
 	/* Get event data */
 	xlnx_get_event_callback_data(payload);
@@ -496,31 +640,16 @@ static irqreturn_t xlnx_event_handler(int irq, void *dev_id)
 	cb_type = payload[0];
 
 	if (cb_type == PM_NOTIFY_CB) {
-		node_id = payload[1];
-		event = payload[2];
-		if (!xlnx_is_error_event(node_id)) {
-			xlnx_call_notify_cb_handler(payload);
-		} else {
-			/*
-			 * Each call back function expecting payload as an input arguments.
-			 * We can get multiple error events as in one call back through error
-			 * mask. So payload[2] may can contain multiple error events.
-			 * In reg_driver_map database we store data in the combination of single
-			 * node_id-error combination.
-			 * So coping the payload message into event_data and update the
-			 * event_data[2] with Error Mask for single error event and use
-			 * event_data as input argument for registered call back function.
-			 *
-			 */
-			memcpy(event_data, payload, (4 * CB_MAX_PAYLOAD_SIZE));
-			/* Support Multiple Error Event */
-			for (pos = 0; pos < MAX_BITS; pos++) {
-				if ((0 == (event & (1 << pos))))
-					continue;
-				event_data[2] = (event & (1 << pos));
-				xlnx_call_notify_cb_handler(event_data);
-			}
+		/*
+		 * The FIFO of this CPU has a single producer, so no lock is
+		 * needed; fall back to delivering here if it is full.
+		 */
+		if (READ_ONCE(defer_notify) && event_wq &&
+		    kfifo_put(&this_cpu_ptr(&notify_fifo)->fifo, ev)) {
+			queue_work(event_wq, &notify_work);
+			return IRQ_HANDLED;
 		}
+		xlnx_dispatch_notify_event(payload);
 	} else if (cb_type == PM_INIT_SUSPEND_CB) {
 		xlnx_call_suspend_cb_handler(payload);
 	} else {
@@ -625,6 +754,7 @@ static void xlnx_event_cleanup_sgi(struct platform_device *pdev)
 static int xlnx_event_manager_probe(struct platform_device *pdev)
 {
 	int ret;
+	int cpu;
 
 	ret = zynqmp_pm_feature(PM_REGISTER_NOTIFIER);
 	if (ret < 0) {
@@ -640,11 +770,19 @@ static int xlnx_event_manager_probe(struct platform_device *pdev)
 		return -EOPNOTSUPP;
 	}
 
+	for_each_possible_cpu(cpu)
+		INIT_KFIFO(per_cpu_ptr(&notify_fifo, cpu)->fifo);
+
+	event_wq = alloc_workqueue("xlnx_event", WQ_UNBOUND | WQ_HIGHPRI |
+				   WQ_SYSFS, 1);
+	if (!event_wq)
+		dev_warn(&pdev->dev, "Notify events will be delivered from the SGI handler\n");
+
 	/* Initialize the SGI */
 	ret = xlnx_event_init_sgi(pdev);
 	if (ret) {
 		dev_err(&pdev->dev, "SGI Init has been failed with %d\n", ret);
-		return ret;
+		goto err_wq;
 	}
 
 	/* Setup function for the CPU hot-plug cases */
@@ -660,7 +798,7 @@ static int xlnx_event_manager_probe(struct platform_device *pdev)
 				sgi_num, ret);
 
 		xlnx_event_cleanup_sgi(pdev);
-		return ret;
+		goto err_wq;
 	}
 
 	event_manager_availability = 0;
@@ -669,6 +807,13 @@ static int xlnx_event_manager_probe(struct platform_device *pdev)
 	dev_info(&pdev->dev, "Xilinx Event Management driver probed\n");
 
 	return ret;
+
+err_wq:
+	if (event_wq) {
+		destroy_workqueue(event_wq);
+		event_wq = NULL;
+	}
+	return ret;
 }
 
 static int xlnx_event_manager_remove(struct platform_device *pdev)
@@ -680,21 +825,30 @@ static int xlnx_event_manager_remove(struct platform_device *pdev)
 	struct agent_cb *cb_pos;
 	struct agent_cb *cb_next;
 
-	hash_for_each_safe(reg_driver_map, i, tmp, eve_data, hentry) {
-		list_for_each_entry_safe(cb_pos, cb_next, &eve_data->cb_list_head, list) {
-			list_del_init(&cb_pos->list);
-			kfree(cb_pos);
-		}
-		hash_del(&eve_data->hentry);
-		kfree(eve_data);
-	}
-
 	ret = zynqmp_pm_register_sgi(0, 1);
 	if (ret)
 		dev_err(&pdev->dev, "SGI unregistration over TF-A failed with %d\n", ret);
 
 	xlnx_event_cleanup_sgi(pdev);
 
+	/* No more events can arrive; drain the deferred ones */
+	if (event_wq) {
+		destroy_workqueue(event_wq);
+		event_wq = NULL;
+	}
+	cancel_work_sync(&reap_work);
+
+	mutex_lock(&reg_driver_lock);
+	hash_for_each_safe(reg_driver_map, i, tmp, eve_data, hentry) {
+		list_for_each_entry_safe(cb_pos, cb_next, &eve_data->cb_list_head, list) {
+			list_del_rcu(&cb_pos->list);
+			kfree_rcu(cb_pos, rcu);
+		}
+		hash_del_rcu(&eve_data->hentry);
+		kfree_rcu(eve_data, rcu);
+	}
+	mutex_unlock(&reg_driver_lock);
+
 	event_manager_availability = -EACCES;
 
 	return ret;
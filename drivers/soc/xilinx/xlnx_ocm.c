@@ -0,0 +1,464 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Xilinx on-chip memory manager
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ *
+ * Hands out the on-chip memory (OCM), and the RPU TCM banks when the RPU is
+ * not used, to in-kernel users such as DMA descriptor rings, RPMsg vrings or
+ * IPI buffers. The memory is always resident and isn't behind the DDR
+ * controller, so the accesses don't compete with the DDR traffic.
+ *
+ * Every "reg" region of the node goes into one genalloc pool. In-kernel
+ * users name the pool with an "xlnx,ocm" phandle and allocate through
+ * xlnx_ocm_alloc(). The memory can also be mapped from userspace through
+ * /dev/xlnx-ocm, each mmap() allocating the mapped size from the pool.
+ * The usage of each user is reported in debugfs.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/device.h>
+#include <linux/fs.h>
+#include <linux/genalloc.h>
+#include <linux/io.h>
+#include <linux/kref.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/of.h>
+#include <linux/of_platform.h>
+#include <linux/platform_device.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/soc/xilinx/xlnx_ocm.h>
+
+/* Allocation granularity of the pool, fits a DMA descriptor */
+#define XLNX_OCM_MIN_ALLOC_ORDER	6
+
+static unsigned long user_limit = SZ_64K;
+module_param(user_limit, ulong, 0644);
+MODULE_PARM_DESC(user_limit,
+		 "Max bytes mapped per open file, 0 = no limit (default: 64K)");
+
+/**
+ * struct xlnx_ocm - On-chip memory manager
+ * @dev: Device structure
+ * @pool: Pool of all the memory regions
+ * @misc: Misc device for the userspace mappings
+ * @lock: Protects @clients and the usage of all the clients
+ * @clients: List of the clients
+ * @debugfs: debugfs directory of the device
+ */
+struct xlnx_ocm {
+	struct device *dev;
+	struct gen_pool *pool;
+	struct miscdevice misc;
+	struct mutex lock;
+	struct list_head clients;
+	struct dentry *debugfs;
+};
+
+/**
+ * struct xlnx_ocm_client - User of the on-chip memory
+ * @node: Entry in the client list
+ * @ocm: On-chip memory manager
+ * @ref: Reference count, each userspace mapping holds one
+ * @name: Name reported in debugfs
+ * @used: Bytes currently allocated
+ * @peak: Most bytes ever allocated at once
+ */
+struct xlnx_ocm_client {
+	struct list_head node;
+	struct xlnx_ocm *ocm;
+	struct kref ref;
+	char name[32];
+	size_t used;
+	size_t peak;
+};
+
+/**
+ * struct xlnx_ocm_mapping - Memory of a userspace mapping
+ * @client: Client owning the memory
+ * @addr: Virtual address of the memory in the pool
+ * @size: Size of the memory
+ */
+struct xlnx_ocm_mapping {
+	struct xlnx_ocm_client *client;
+	unsigned long addr;
+	size_t size;
+};
+
+static struct xlnx_ocm_client *xlnx_ocm_client_create(struct xlnx_ocm *ocm,
+						      const char *name)
+{
+	struct xlnx_ocm_client *client;
+
+	client = kzalloc(sizeof(*client), GFP_KERNEL);
+	if (!client)
+		return NULL;
+
+	client->ocm = ocm;
+	kref_init(&client->ref);
+	strscpy(client->name, name, sizeof(client->name));
+
+	mutex_lock(&ocm->lock);
+	list_add_tail(&client->node, &ocm->clients);
+	mutex_unlock(&ocm->lock);
+
+	return client;
+}
+
+static void xlnx_ocm_client_release(struct kref *ref)
+{
+	struct xlnx_ocm_client *client =
+		container_of(ref, struct xlnx_ocm_client, ref);
+	struct xlnx_ocm *ocm = client->ocm;
+
+	mutex_lock(&ocm->lock);
+	WARN_ON(client->used);
+	list_del(&client->node);
+	mutex_unlock(&ocm->lock);
+
+	put_device(ocm->dev);
+	kfree(client);
+}
+
+/*
+ * Account @size more bytes to @client, or less if @size is negative. Fails
+ * with -ENOMEM if @limit would be exceeded, unless @limit is 0.
+ */
+static int xlnx_ocm_client_charge(struct xlnx_ocm_client *client,
+				  ssize_t size, size_t limit)
+{
+	struct xlnx_ocm *ocm = client->ocm;
+	int ret = 0;
+
+	mutex_lock(&ocm->lock);
+	if (limit && size > 0 && client->used + size > limit) {
+		ret = -ENOMEM;
+	} else {
+		client->used += size;
+		client->peak = max(client->peak, client->used);
+	}
+	mutex_unlock(&ocm->lock);
+
+	return ret;
+}
+
+/**
+ * xlnx_ocm_get - Get an on-chip memory client for a device
+ * @dev: Device using the memory
+ *
+ * The memory manager is given by the "xlnx,ocm" phandle of @dev. The client
+ * is named after @dev in debugfs.
+ *
+ * Return: the client on success, ERR_PTR(-ENODEV) if @dev has no memory
+ * manager, ERR_PTR(-EPROBE_DEFER) if it isn't probed yet, or
+ * ERR_PTR(-ENOMEM).
+ */
+struct xlnx_ocm_client *xlnx_ocm_get(struct device *dev)
+{
+	struct xlnx_ocm_client *client;
+	struct platform_device *pdev;
+	struct device_node *np;
+	struct xlnx_ocm *ocm;
+
+	np = of_parse_phandle(dev->of_node, "xlnx,ocm", 0);
+	if (!np)
+		return ERR_PTR(-ENODEV);
+
+	pdev = of_find_device_by_node(np);
+	of_node_put(np);
+	if (!pdev)
+		return ERR_PTR(-EPROBE_DEFER);
+
+	ocm = platform_get_drvdata(pdev);
+	if (!ocm) {
+		put_device(&pdev->dev);
+		return ERR_PTR(-EPROBE_DEFER);
+	}
+
+	client = xlnx_ocm_client_create(ocm, dev_name(dev));
+	if (!client) {
+		put_device(&pdev->dev);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	return client;
+}
+EXPORT_SYMBOL_GPL(xlnx_ocm_get);
+
+/**
+ * xlnx_ocm_put - Release an on-chip memory client
+ * @client: Client from xlnx_ocm_get()
+ *
+ * All the memory of @client must have been freed.
+ */
+void xlnx_ocm_put(struct xlnx_ocm_client *client)
+{
+	if (!IS_ERR_OR_NULL(client))
+		kref_put(&client->ref, xlnx_ocm_client_release);
+}
+EXPORT_SYMBOL_GPL(xlnx_ocm_put);
+
+/**
+ * xlnx_ocm_alloc - Allocate on-chip memory
+ * @client: Client from xlnx_ocm_get()
+ * @size: Size to allocate
+ * @dma: Returns the bus address of the memory
+ *
+ * The memory is mapped write combined, so the writes have to be ordered with
+ * the usual barriers before a device reads them. The bus address is the
+ * physical address, for devices that aren't behind an IOMMU.
+ *
+ * Return: the virtual address of the memory, or NULL if the pool is full.
+ */
+void *xlnx_ocm_alloc(struct xlnx_ocm_client *client, size_t size,
+		     dma_addr_t *dma)
+{
+	void *vaddr;
+
+	vaddr = gen_pool_dma_alloc(client->ocm->pool, size, dma);
+	if (vaddr)
+		xlnx_ocm_client_charge(client, size, 0);
+
+	return vaddr;
+}
+EXPORT_SYMBOL_GPL(xlnx_ocm_alloc);
+
+/**
+ * xlnx_ocm_free - Free on-chip memory
+ * @client: Client the memory was allocated for
+ * @vaddr: Virtual address from xlnx_ocm_alloc()
+ * @size: Size given to xlnx_ocm_alloc()
+ */
+void xlnx_ocm_free(struct xlnx_ocm_client *client, void *vaddr, size_t size)
+{
+	if (!vaddr)
+		return;
+
+	gen_pool_free(client->ocm->pool, (unsigned long)vaddr, size);
+	xlnx_ocm_client_charge(client, -(ssize_t)size, 0);
+}
+EXPORT_SYMBOL_GPL(xlnx_ocm_free);
+
+/*
+ * Userspace mappings
+ */
+
+static void xlnx_ocm_vm_close(struct vm_area_struct *vma)
+{
+	struct xlnx_ocm_mapping *map = vma->vm_private_data;
+	struct xlnx_ocm_client *client = map->client;
+
+	gen_pool_free(client->ocm->pool, map->addr, map->size);
+	xlnx_ocm_client_charge(client, -(ssize_t)map->size, 0);
+	kref_put(&client->ref, xlnx_ocm_client_release);
+	kfree(map);
+}
+
+/* The memory is freed as a whole when the mapping goes away */
+static int xlnx_ocm_vm_may_split(struct vm_area_struct *vma,
+				 unsigned long addr)
+{
+	return -EINVAL;
+}
+
+static const struct vm_operations_struct xlnx_ocm_vm_ops = {
+	.close = xlnx_ocm_vm_close,
+	.may_split = xlnx_ocm_vm_may_split,
+};
+
+static int xlnx_ocm_open(struct inode *inode, struct file *file)
+{
+	struct xlnx_ocm *ocm = container_of(file->private_data,
+					    struct xlnx_ocm, misc);
+	struct xlnx_ocm_client *client;
+	char name[32];
+
+	snprintf(name, sizeof(name), "%d:%s", task_tgid_nr(current),
+		 current->comm);
+	get_device(ocm->dev);
+	client = xlnx_ocm_client_create(ocm, name);
+	if (!client) {
+		put_device(ocm->dev);
+		return -ENOMEM;
+	}
+
+	file->private_data = client;
+
+	return 0;
+}
+
+static int xlnx_ocm_release(struct inode *inode, struct file *file)
+{
+	xlnx_ocm_put(file->private_data);
+
+	return 0;
+}
+
+static int xlnx_ocm_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct xlnx_ocm_client *client = file->private_data;
+	struct gen_pool *pool = client->ocm->pool;
+	struct genpool_data_align align = { .align = PAGE_SIZE };
+	size_t size = vma->vm_end - vma->vm_start;
+	struct xlnx_ocm_mapping *map;
+	phys_addr_t phys;
+	int ret;
+
+	if (vma->vm_pgoff)
+		return -EINVAL;
+
+	ret = xlnx_ocm_client_charge(client, size, user_limit);
+	if (ret)
+		return ret;
+
+	map = kzalloc(sizeof(*map), GFP_KERNEL);
+	if (!map) {
+		ret = -ENOMEM;
+		goto err_charge;
+	}
+
+	map->addr = gen_pool_alloc_algo(pool, size, gen_pool_first_fit_align,
+					&align);
+	if (!map->addr) {
+		ret = -ENOMEM;
+		goto err_map;
+	}
+	map->size = size;
+	map->client = client;
+
+	phys = gen_pool_virt_to_phys(pool, map->addr);
+	vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+	vma->vm_flags |= VM_DONTCOPY | VM_DONTEXPAND | VM_DONTDUMP;
+	ret = remap_pfn_range(vma, vma->vm_start, PHYS_PFN(phys), size,
+			      vma->vm_page_prot);
+	if (ret)
+		goto err_alloc;
+
+	kref_get(&client->ref);
+	vma->vm_private_data = map;
+	vma->vm_ops = &xlnx_ocm_vm_ops;
+
+	return 0;
+
+err_alloc:
+	gen_pool_free(pool, map->addr, size);
+err_map:
+	kfree(map);
+err_charge:
+	xlnx_ocm_client_charge(client, -(ssize_t)size, 0);
+	return ret;
+}
+
+static const struct file_operations xlnx_ocm_fops = {
+	.owner = THIS_MODULE,
+	.open = xlnx_ocm_open,
+	.release = xlnx_ocm_release,
+	.mmap = xlnx_ocm_mmap,
+};
+
+/*
+ * debugfs
+ */
+
+static int xlnx_ocm_clients_show(struct seq_file *s, void *data)
+{
+	struct xlnx_ocm *ocm = s->private;
+	struct xlnx_ocm_client *client;
+
+	seq_printf(s, "size %zu avail %zu\n", gen_pool_size(ocm->pool),
+		   gen_pool_avail(ocm->pool));
+
+	mutex_lock(&ocm->lock);
+	list_for_each_entry(client, &ocm->clients, node)
+		seq_printf(s, "%-32s used %zu peak %zu\n", client->name,
+			   client->used, client->peak);
+	mutex_unlock(&ocm->lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(xlnx_ocm_clients);
+
+/*
+ * Platform driver
+ */
+
+static int xlnx_ocm_probe(struct platform_device *pdev)
+{
+	struct device *dev = &pdev->dev;
+	struct xlnx_ocm *ocm;
+	struct resource *res;
+	void __iomem *virt;
+	unsigned int i;
+	int ret;
+
+	ocm = devm_kzalloc(dev, sizeof(*ocm), GFP_KERNEL);
+	if (!ocm)
+		return -ENOMEM;
+
+	ocm->dev = dev;
+	mutex_init(&ocm->lock);
+	INIT_LIST_HEAD(&ocm->clients);
+
+	ocm->pool = devm_gen_pool_create(dev, XLNX_OCM_MIN_ALLOC_ORDER,
+					 NUMA_NO_NODE, NULL);
+	if (IS_ERR(ocm->pool))
+		return PTR_ERR(ocm->pool);
+
+	for (i = 0; (res = platform_get_resource(pdev, IORESOURCE_MEM, i));
+	     i++) {
+		virt = devm_ioremap_resource_wc(dev, res);
+		if (IS_ERR(virt))
+			return PTR_ERR(virt);
+
+		ret = gen_pool_add_virt(ocm->pool, (unsigned long)virt,
+					res->start, resource_size(res),
+					NUMA_NO_NODE);
+		if (ret)
+			return ret;
+	}
+
+	if (!i) {
+		dev_err(dev, "no memory region\n");
+		return -EINVAL;
+	}
+
+	ocm->misc.minor = MISC_DYNAMIC_MINOR;
+	ocm->misc.name = "xlnx-ocm";
+	ocm->misc.fops = &xlnx_ocm_fops;
+	ocm->misc.parent = dev;
+	ret = misc_register(&ocm->misc);
+	if (ret)
+		return ret;
+
+	ocm->debugfs = debugfs_create_dir(dev_name(dev), NULL);
+	debugfs_create_file("clients", 0444, ocm->debugfs, ocm,
+			    &xlnx_ocm_clients_fops);
+
+	platform_set_drvdata(pdev, ocm);
+
+	dev_info(dev, "%zu bytes of on-chip memory\n",
+		 gen_pool_size(ocm->pool));
+
+	return 0;
+}
+
+static const struct of_device_id xlnx_ocm_of_match[] = {
+	{ .compatible = "xlnx,ocm-pool", },
+	{ /* end of table */ }
+};
+
+/* Userspace mappings and clients may outlive the device, don't unbind it */
+static struct platform_driver xlnx_ocm_driver = {
+	.probe = xlnx_ocm_probe,
+	.driver = {
+		.name = "xlnx_ocm",
+		.of_match_table = xlnx_ocm_of_match,
+		.suppress_bind_attrs = true,
+	},
+};
+builtin_platform_driver(xlnx_ocm_driver);
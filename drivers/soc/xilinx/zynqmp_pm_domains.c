@@ -23,6 +23,11 @@
 
 static int min_capability;
 
+static bool async_suspend = true;
+module_param(async_suspend, bool, 0444);
+MODULE_PARM_DESC(async_suspend,
+		 "Suspend/resume domain devices asynchronously (default: Y)");
+
 /**
  * struct zynqmp_pm_domain - Wrapper around struct generic_pm_domain
  * @gpd:		Generic power domain
@@ -161,6 +166,15 @@ static int zynqmp_gpd_attach_dev(struct generic_pm_domain *domain,
 		dev_dbg(&domain->dev, "failed to create device link for %s\n",
 			dev_name(dev));
 
+	/*
+	 * Every domain is a separate firmware PM node. Let the PM core suspend
+	 * and resume devices in parallel, honouring parent and device link
+	 * ordering, so that power_on requests for independent domains are
+	 * issued concurrently instead of one device at a time.
+	 */
+	if (async_suspend)
+		device_enable_async_suspend(dev);
+
 	/* If this is not the first device to attach there is nothing to do */
 	if (domain->device_count)
 		return 0;
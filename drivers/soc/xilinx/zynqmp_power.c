@@ -7,18 +7,36 @@
  *  Davorin Mista <davorin.mista@aggios.com>
  *  Jolly Shah <jollys@xilinx.com>
  *  Rajan Vaja <rajan.vaja@xilinx.com>
+ *
+ * A suspend to RAM round trip is split in phases: from the firmware request
+ * to the start of the suspend (queue), the Linux suspend down to the syscore
+ * level (suspend), the firmware and DDR self-refresh, including the time
+ * spent asleep (firmware), and the Linux resume (resume). Each phase fires a
+ * zynqmp_power tracepoint, complementing the per device callback events of
+ * the PM core, and is accounted in <debugfs>/zynqmp_power/suspend_phases.
+ * Writing to that file clears it.
  */
 
+#include <linux/debugfs.h>
+#include <linux/fs.h>
 #include <linux/mailbox_client.h>
+#include <linux/math64.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
 #include <linux/reboot.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
 #include <linux/suspend.h>
+#include <linux/syscore_ops.h>
+#include <linux/timekeeping.h>
 
 #include <linux/firmware/xlnx-zynqmp.h>
 #include <linux/firmware/xlnx-event-manager.h>
 #include <linux/mailbox/zynqmp-ipi-message.h>
 
+#define CREATE_TRACE_POINTS
+#include "zynqmp_power_trace.h"
+
 /**
  * struct zynqmp_pm_work_struct - Wrapper for struct work_struct
  * @callback_work:	Work structure
@@ -48,6 +66,201 @@ static const char *const suspend_modes[] = {
 
 static enum pm_suspend_mode suspend_mode = PM_SUSPEND_MODE_STD;
 
+enum zynqmp_pm_phase {
+	ZYNQMP_PM_PHASE_QUEUE,
+	ZYNQMP_PM_PHASE_SUSPEND,
+	ZYNQMP_PM_PHASE_FIRMWARE,
+	ZYNQMP_PM_PHASE_RESUME,
+	ZYNQMP_PM_NUM_PHASES,
+};
+
+static const char *const zynqmp_pm_phase_names[] = {
+	[ZYNQMP_PM_PHASE_QUEUE] = "queue",
+	[ZYNQMP_PM_PHASE_SUSPEND] = "suspend",
+	[ZYNQMP_PM_PHASE_FIRMWARE] = "firmware",
+	[ZYNQMP_PM_PHASE_RESUME] = "resume",
+};
+
+/**
+ * struct zynqmp_pm_phase_stats - Duration statistics of a suspend phase
+ * @count:	Number of completed phases
+ * @last_ns:	Duration of the last phase
+ * @total_ns:	Cumulated duration of the phases
+ * @max_ns:	Longest phase
+ */
+struct zynqmp_pm_phase_stats {
+	u64 count;
+	u64 last_ns;
+	u64 total_ns;
+	u64 max_ns;
+};
+
+static struct zynqmp_pm_phase_stats zynqmp_pm_stats[ZYNQMP_PM_NUM_PHASES];
+static DEFINE_SPINLOCK(zynqmp_pm_stats_lock);
+static u64 zynqmp_pm_request_ns;
+static u64 zynqmp_pm_mark_ns;
+static bool zynqmp_pm_resumed;
+static struct dentry *zynqmp_pm_debugfs;
+
+/*
+ * The timestamps use the boot time clock, which keeps running while the
+ * system is asleep and is valid in the syscore callbacks.
+ */
+static void zynqmp_pm_phase_end(enum zynqmp_pm_phase phase, u64 now)
+{
+	struct zynqmp_pm_phase_stats *stats = &zynqmp_pm_stats[phase];
+	u64 start = phase == ZYNQMP_PM_PHASE_QUEUE ? zynqmp_pm_request_ns :
+						     zynqmp_pm_mark_ns;
+	u64 delta = now - start;
+	unsigned long flags;
+
+	trace_zynqmp_pm_phase(zynqmp_pm_phase_names[phase], delta);
+
+	spin_lock_irqsave(&zynqmp_pm_stats_lock, flags);
+	stats->count++;
+	stats->last_ns = delta;
+	stats->total_ns += delta;
+	stats->max_ns = max(stats->max_ns, delta);
+	spin_unlock_irqrestore(&zynqmp_pm_stats_lock, flags);
+}
+
+static void zynqmp_pm_suspend_requested(u32 reason)
+{
+	trace_zynqmp_pm_suspend_request(reason);
+	if (reason == SUSPEND_POWER_REQUEST)
+		WRITE_ONCE(zynqmp_pm_request_ns, ktime_get_boottime_ns());
+}
+
+static int zynqmp_pm_notify(struct notifier_block *nb, unsigned long action,
+			    void *data)
+{
+	u64 now = ktime_get_boottime_ns();
+
+	switch (action) {
+	case PM_SUSPEND_PREPARE:
+		if (READ_ONCE(zynqmp_pm_request_ns)) {
+			zynqmp_pm_phase_end(ZYNQMP_PM_PHASE_QUEUE, now);
+			WRITE_ONCE(zynqmp_pm_request_ns, 0);
+		}
+		zynqmp_pm_mark_ns = now;
+		zynqmp_pm_resumed = false;
+		break;
+	case PM_POST_SUSPEND:
+		/* Aborted suspends never reached the firmware */
+		if (zynqmp_pm_resumed)
+			zynqmp_pm_phase_end(ZYNQMP_PM_PHASE_RESUME, now);
+		zynqmp_pm_mark_ns = 0;
+		zynqmp_pm_resumed = false;
+		break;
+	}
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block zynqmp_pm_nb = {
+	.notifier_call = zynqmp_pm_notify,
+};
+
+/*
+ * Syscore callbacks run last before and first after the firmware call, on
+ * one CPU with interrupts disabled. Hibernation also runs them, without the
+ * suspend notification seeding the mark.
+ */
+static int zynqmp_pm_syscore_suspend(void)
+{
+	u64 now = ktime_get_boottime_ns();
+
+	if (zynqmp_pm_mark_ns) {
+		zynqmp_pm_phase_end(ZYNQMP_PM_PHASE_SUSPEND, now);
+		zynqmp_pm_mark_ns = now;
+	}
+
+	return 0;
+}
+
+static void zynqmp_pm_syscore_resume(void)
+{
+	u64 now = ktime_get_boottime_ns();
+
+	if (zynqmp_pm_mark_ns) {
+		zynqmp_pm_phase_end(ZYNQMP_PM_PHASE_FIRMWARE, now);
+		zynqmp_pm_mark_ns = now;
+		zynqmp_pm_resumed = true;
+	}
+}
+
+static struct syscore_ops zynqmp_pm_syscore_ops = {
+	.suspend = zynqmp_pm_syscore_suspend,
+	.resume = zynqmp_pm_syscore_resume,
+};
+
+static u64 zynqmp_pm_avg_us(const struct zynqmp_pm_phase_stats *stats)
+{
+	if (!stats->count)
+		return 0;
+
+	return div64_u64(stats->total_ns, stats->count * NSEC_PER_USEC);
+}
+
+static int zynqmp_pm_phases_show(struct seq_file *s, void *data)
+{
+	struct zynqmp_pm_phase_stats snap[ZYNQMP_PM_NUM_PHASES];
+	const struct zynqmp_pm_phase_stats *stats;
+	u64 linux_us = 0;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&zynqmp_pm_stats_lock, flags);
+	memcpy(snap, zynqmp_pm_stats, sizeof(snap));
+	spin_unlock_irqrestore(&zynqmp_pm_stats_lock, flags);
+
+	seq_printf(s, "%-10s %10s %12s %12s %12s\n", "phase", "count",
+		   "last_us", "avg_us", "max_us");
+	for (i = 0; i < ZYNQMP_PM_NUM_PHASES; i++) {
+		stats = &snap[i];
+		seq_printf(s, "%-10s %10llu %12llu %12llu %12llu\n",
+			   zynqmp_pm_phase_names[i], stats->count,
+			   div_u64(stats->last_ns, NSEC_PER_USEC),
+			   zynqmp_pm_avg_us(stats),
+			   div_u64(stats->max_ns, NSEC_PER_USEC));
+		if (i != ZYNQMP_PM_PHASE_FIRMWARE)
+			linux_us += zynqmp_pm_avg_us(stats);
+	}
+
+	seq_printf(s, "linux avg_us: %llu\n", linux_us);
+	seq_printf(s, "firmware avg_us: %llu\n",
+		   zynqmp_pm_avg_us(&snap[ZYNQMP_PM_PHASE_FIRMWARE]));
+
+	return 0;
+}
+
+static int zynqmp_pm_phases_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, zynqmp_pm_phases_show, inode->i_private);
+}
+
+static ssize_t zynqmp_pm_phases_write(struct file *file,
+				      const char __user *buf, size_t count,
+				      loff_t *ppos)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&zynqmp_pm_stats_lock, flags);
+	memset(zynqmp_pm_stats, 0, sizeof(zynqmp_pm_stats));
+	spin_unlock_irqrestore(&zynqmp_pm_stats_lock, flags);
+
+	return count;
+}
+
+static const struct file_operations zynqmp_pm_phases_fops = {
+	.owner = THIS_MODULE,
+	.open = zynqmp_pm_phases_open,
+	.read = seq_read,
+	.write = zynqmp_pm_phases_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static void zynqmp_pm_get_callback_data(u32 *buf)
 {
 	zynqmp_pm_invoke_fn(GET_CALLBACK_DATA, 0, 0, 0, 0, 0, buf);
@@ -63,6 +276,7 @@ static void suspend_event_callback(const u32 *payload, void *data)
 	memcpy(zynqmp_pm_init_suspend_work->args, &payload[1],
 	       sizeof(zynqmp_pm_init_suspend_work->args));
 
+	zynqmp_pm_suspend_requested(payload[1]);
 	queue_work(system_unbound_wq, &zynqmp_pm_init_suspend_work->callback_work);
 }
 
@@ -74,6 +288,7 @@ static irqreturn_t zynqmp_pm_isr(int irq, void *data)
 
 	/* First element is callback API ID, others are callback arguments */
 	if (payload[0] == PM_INIT_SUSPEND_CB) {
+		zynqmp_pm_suspend_requested(payload[1]);
 		switch (payload[1]) {
 		case SUSPEND_SYSTEM_SHUTDOWN:
 			orderly_poweroff(true);
@@ -108,6 +323,7 @@ static void ipi_receive_callback(struct mbox_client *cl, void *data)
 		memcpy(zynqmp_pm_init_suspend_work->args, &payload[1],
 		       sizeof(zynqmp_pm_init_suspend_work->args));
 
+		zynqmp_pm_suspend_requested(payload[1]);
 		queue_work(system_unbound_wq,
 			   &zynqmp_pm_init_suspend_work->callback_work);
 
@@ -273,11 +489,20 @@ static int zynqmp_pm_probe(struct platform_device *pdev)
 		return ret;
 	}
 
+	register_pm_notifier(&zynqmp_pm_nb);
+	register_syscore_ops(&zynqmp_pm_syscore_ops);
+	zynqmp_pm_debugfs = debugfs_create_dir("zynqmp_power", NULL);
+	debugfs_create_file("suspend_phases", 0644, zynqmp_pm_debugfs, NULL,
+			    &zynqmp_pm_phases_fops);
+
 	return 0;
 }
 
 static int zynqmp_pm_remove(struct platform_device *pdev)
 {
+	debugfs_remove_recursive(zynqmp_pm_debugfs);
+	unregister_syscore_ops(&zynqmp_pm_syscore_ops);
+	unregister_pm_notifier(&zynqmp_pm_nb);
 	sysfs_remove_file(&pdev->dev.kobj, &dev_attr_suspend_mode.attr);
 	if (event_registered)
 		xlnx_unregister_event(PM_INIT_SUSPEND_CB, 0, 0, suspend_event_callback, NULL);
@@ -0,0 +1,49 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Tracepoints for the Xilinx Zynq MPSoC Power Management
+ *
+ * Copyright (C) 2023 Xilinx, Inc. All rights reserved.
+ */
+
+#if !defined(__ZYNQMP_POWER_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define __ZYNQMP_POWER_TRACE_H
+
+#include <linux/tracepoint.h>
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM zynqmp_power
+
+TRACE_EVENT(zynqmp_pm_suspend_request,
+	TP_PROTO(u32 reason),
+	TP_ARGS(reason),
+	TP_STRUCT__entry(
+		__field(u32, reason)
+	),
+	TP_fast_assign(
+		__entry->reason = reason;
+	),
+	TP_printk("reason=%u", __entry->reason)
+);
+
+TRACE_EVENT(zynqmp_pm_phase,
+	TP_PROTO(const char *phase, u64 duration_ns),
+	TP_ARGS(phase, duration_ns),
+	TP_STRUCT__entry(
+		__string(phase, phase)
+		__field(u64, duration_ns)
+	),
+	TP_fast_assign(
+		__assign_str(phase, phase);
+		__entry->duration_ns = duration_ns;
+	),
+	TP_printk("%s duration_ns=%llu", __get_str(phase),
+		  __entry->duration_ns)
+);
+
+#endif /* __ZYNQMP_POWER_TRACE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE zynqmp_power_trace
+#include <trace/define_trace.h>
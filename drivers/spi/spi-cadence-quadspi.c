@@ -28,6 +28,7 @@
 #include <linux/pm_runtime.h>
 #include <linux/reset.h>
 #include <linux/sched.h>
+#include <linux/sizes.h>
 #include <linux/spi/spi.h>
 #include <linux/spi/spi-mem.h>
 #include <linux/timer.h>
@@ -42,6 +43,7 @@
 #define CQSPI_SUPPORT_EXTERNAL_DMA	BIT(2)
 #define CQSPI_NO_SUPPORT_WR_COMPLETION	BIT(3)
 #define CQSPI_SLOW_SRAM		BIT(4)
+#define CQSPI_DAC_READ_DMA		BIT(5)
 
 /* Capabilities */
 #define CQSPI_SUPPORTS_OCTAL		BIT(0)
@@ -87,6 +89,7 @@ struct cqspi_st {
 	u32			trigger_address;
 	u32			wr_delay;
 	bool			use_direct_mode;
+	bool			use_direct_read;
 	struct cqspi_flash_pdata f_pdata[CQSPI_MAX_CHIPSELECT];
 	bool			use_dma_read;
 	u32			pd_dev_id;
@@ -98,6 +101,11 @@ struct cqspi_st {
 	struct spi_mem_op	tuning_op;
 	int			gpio;
 	bool			tuning_scheduled;
+	/* Last PHY calibration, restored instead of retuning */
+	bool			phy_cached;
+	bool			phy_extra_dummy;
+	u8			phy_rx_tap;
+	u32			phy_hz;
 };
 
 struct cqspi_driver_platdata {
@@ -310,6 +318,8 @@ struct cqspi_driver_platdata {
 #define CQSPI_VERSAL_MIO_NODE_ID_12	0x14108027
 #define CQSPI_RESET_TYPE_HWPIN		0
 #define CQSPI_READ_ID_LEN		6
+/* Smaller reads do not amortize the DMA setup of a direct read */
+#define CQSPI_DAC_READ_MIN		SZ_16K
 #define VERSAL_OSPI_RESET		0xc10402e
 #define SILICON_VER_MASK		0xFF
 #define SILICON_VER_1			0x10
@@ -750,6 +760,61 @@ static int cqspi_setdlldelay(struct spi_mem *mem, const struct spi_mem_op *op)
 	if (ret)
 		return ret;
 
+	cqspi->clk_tuned = true;
+	cqspi->phy_cached = true;
+	cqspi->phy_rx_tap = avg_rxtap;
+	cqspi->phy_extra_dummy = cqspi->extra_dummy;
+	cqspi->phy_hz = mem->spi->max_speed_hz;
+
+	return 0;
+}
+
+/*
+ * Program the RX tap found by the last cqspi_setdlldelay() and check it
+ * still reads the device ID correctly, saving the full tap sweep after
+ * resume or a switch back from SDR mode.
+ */
+static int cqspi_phy_restore(struct spi_mem *mem)
+{
+	struct cqspi_st *cqspi = spi_master_get_devdata(mem->spi->master);
+	struct cqspi_flash_pdata *f_pdata;
+	u8 *id = cqspi->tuning_op.data.buf.in;
+	u32 reg;
+	int ret;
+
+	if (cqspi->phy_hz != mem->spi->max_speed_hz)
+		return -EINVAL;
+
+	f_pdata = &cqspi->f_pdata[spi_get_chipselect(mem->spi, 0)];
+
+	/* Same DLL reset and lock sequence as cqspi_setdlldelay() */
+	writel(0, cqspi->iobase + CQSPI_REG_PHY_CONFIG);
+	writel(0x4, cqspi->iobase + CQSPI_REG_PHY_MASTER_CTRL);
+	writel(CQSPI_REG_PHY_CONFIG_RESET_FLD_MASK,
+	       cqspi->iobase + CQSPI_REG_PHY_CONFIG);
+	ret = cqspi_wait_for_bit(cqspi->iobase + CQSPI_REG_DLL_LOWER,
+				 CQSPI_REG_DLL_LOWER_LPBK_LOCK_MASK, 0);
+	if (ret)
+		return ret;
+
+	reg = (CQSPI_TX_TAP_MASTER << CQSPI_REG_PHY_CONFIG_TX_DLL_DLY_LSB) |
+	      cqspi->phy_rx_tap | CQSPI_REG_PHY_CONFIG_RESET_FLD_MASK;
+	writel(reg, cqspi->iobase + CQSPI_REG_PHY_CONFIG);
+	writel(reg | CQSPI_REG_PHY_CONFIG_RESYNC_FLD_MASK,
+	       cqspi->iobase + CQSPI_REG_PHY_CONFIG);
+	ret = cqspi_wait_for_bit(cqspi->iobase + CQSPI_REG_DLL_LOWER,
+				 CQSPI_REG_DLL_LOWER_DLL_LOCK_MASK, 0);
+	if (ret)
+		return ret;
+
+	cqspi->extra_dummy = cqspi->phy_extra_dummy;
+	ret = cqspi_command_read(f_pdata, &cqspi->tuning_op);
+	if (ret)
+		return ret;
+
+	if (memcmp(id, mem->device_id, cqspi->tuning_op.data.nbytes))
+		return -EIO;
+
 	cqspi->clk_tuned = true;
 
 	return 0;
@@ -847,17 +912,27 @@ static int cqspi_setup_edgemode(struct spi_mem *mem,
 				const struct spi_mem_op *op)
 {
 	struct cqspi_st *cqspi = spi_master_get_devdata(mem->spi->master);
+	u8 buf[CQSPI_READ_ID_LEN];
 	int ret;
 
 	if (cqspi->clk_tuned)
 		return 0;
-	memcpy(&cqspi->tuning_op, op, sizeof(struct spi_mem_op));
 
 	cqspi_setup_ddrmode(cqspi);
 
 	cqspi->f_pdata[spi_get_chipselect(mem->spi, 0)].dtr = true;
 
-	ret = cqspi_setdlldelay(mem, op);
+	if (cqspi->phy_cached) {
+		/* Retune with the saved ID read, not the op at hand */
+		cqspi->tuning_op.data.buf.in = buf;
+		cqspi->tuning_op.data.nbytes = CQSPI_READ_ID_LEN;
+		ret = cqspi_phy_restore(mem);
+		if (ret)
+			ret = cqspi_setdlldelay(mem, &cqspi->tuning_op);
+	} else {
+		memcpy(&cqspi->tuning_op, op, sizeof(struct spi_mem_op));
+		ret = cqspi_setdlldelay(mem, op);
+	}
 	if (ret)
 		return ret;
 
@@ -1748,6 +1823,16 @@ static ssize_t cqspi_read(struct cqspi_flash_pdata *f_pdata,
 	if (cqspi->use_direct_mode && ((from + len) <= cqspi->ahb_size))
 		return cqspi_direct_read_execute(f_pdata, buf, from, len);
 
+	/*
+	 * Large reads through the linear window are streamed by the memcpy
+	 * DMA engine without the per-transfer indirect setup. DTR reads
+	 * must start and end on a 16-bit boundary.
+	 */
+	if (cqspi->use_direct_read && cqspi->rx_chan &&
+	    len >= CQSPI_DAC_READ_MIN && (from + len) <= cqspi->ahb_size &&
+	    virt_addr_valid(buf) && !(f_pdata->dtr && ((from | len) & 1)))
+		return cqspi_direct_read_execute(f_pdata, buf, from, len);
+
 	if (cqspi->use_dma_read && ddata && ddata->indirect_read_dma &&
 	    virt_addr_valid(buf) && ((dma_align & CQSPI_DMA_UNALIGN) == 0))
 		return ddata->indirect_read_dma(f_pdata, buf, from, len);
@@ -1951,7 +2036,7 @@ static void cqspi_controller_init(struct cqspi_st *cqspi)
 	       cqspi->iobase + CQSPI_REG_INDIRECTWRWATERMARK);
 
 	/* Disable direct access controller */
-	if (!cqspi->use_direct_mode) {
+	if (!cqspi->use_direct_mode && !cqspi->use_direct_read) {
 		reg = readl(cqspi->iobase + CQSPI_REG_CONFIG);
 		reg &= ~CQSPI_REG_CONFIG_ENB_DIR_ACC_CTRL;
 		writel(reg, cqspi->iobase + CQSPI_REG_CONFIG);
@@ -1995,10 +2080,36 @@ static const char *cqspi_get_name(struct spi_mem *mem)
 			      spi_get_chipselect(mem->spi, 0));
 }
 
+static int cqspi_dirmap_create(struct spi_mem_dirmap_desc *desc)
+{
+	/* Writes are page programs, the spi-mem fallback loses nothing */
+	if (desc->info.op_tmpl.data.dir != SPI_MEM_DATA_IN)
+		return -EOPNOTSUPP;
+
+	return 0;
+}
+
+static ssize_t cqspi_dirmap_read(struct spi_mem_dirmap_desc *desc,
+				 u64 offs, size_t len, void *buf)
+{
+	struct spi_mem_op op = desc->info.op_tmpl;
+	int ret;
+
+	op.addr.val = desc->info.offset + offs;
+	op.data.nbytes = len;
+	op.data.buf.in = buf;
+
+	ret = cqspi_exec_mem_op(desc->mem, &op);
+
+	return ret ? ret : len;
+}
+
 static const struct spi_controller_mem_ops cqspi_mem_ops = {
 	.exec_op = cqspi_exec_mem_op,
 	.get_name = cqspi_get_name,
 	.supports_op = cqspi_supports_mem_op,
+	.dirmap_create = cqspi_dirmap_create,
+	.dirmap_read = cqspi_dirmap_read,
 };
 
 static const struct spi_controller_mem_caps cqspi_mem_caps = {
@@ -2167,6 +2278,8 @@ static int cqspi_probe(struct platform_device *pdev)
 			cqspi->wr_completion = false;
 		if (ddata->quirks & CQSPI_SLOW_SRAM)
 			cqspi->slow_sram = true;
+		if (ddata->quirks & CQSPI_DAC_READ_DMA)
+			cqspi->use_direct_read = true;
 
 		if (of_device_is_compatible(pdev->dev.of_node,
 					    "xlnx,versal-ospi-1.0")) {
@@ -2204,7 +2317,7 @@ static int cqspi_probe(struct platform_device *pdev)
 			goto probe_setup_failed;
 	}
 
-	if (cqspi->use_direct_mode) {
+	if (cqspi->use_direct_mode || cqspi->use_direct_read) {
 		ret = cqspi_request_mmap_dma(cqspi);
 		if (ret == -EPROBE_DEFER)
 			goto probe_setup_failed;
@@ -2333,7 +2446,8 @@ static const struct cqspi_driver_platdata socfpga_qspi = {
 
 static const struct cqspi_driver_platdata versal_ospi = {
 	.hwcaps_mask = CQSPI_SUPPORTS_OCTAL,
-	.quirks = CQSPI_DISABLE_DAC_MODE | CQSPI_SUPPORT_EXTERNAL_DMA,
+	.quirks = CQSPI_DISABLE_DAC_MODE | CQSPI_SUPPORT_EXTERNAL_DMA |
+		  CQSPI_DAC_READ_DMA,
 	.indirect_read_dma = cqspi_versal_indirect_read_dma,
 	.get_dma_status = cqspi_get_versal_dma_status,
 	.device_reset = cqspi_versal_device_reset,
@@ -18,6 +18,7 @@
 #include <linux/spi/spi.h>
 #include <linux/spi/xilinx_spi.h>
 #include <linux/io.h>
+#include <linux/iopoll.h>
 #include <linux/delay.h>
 #include <linux/pm_runtime.h>
 #include <linux/clk.h>
@@ -92,6 +93,9 @@
 /* Command used for Dummy read Id */
 #define SPI_READ_ID		0x9F
 
+/* Time a polled FIFO round takes at most, in microseconds */
+#define XSPI_POLL_TIMEOUT_US	USEC_PER_SEC
+
 /**
  * struct xilinx_spi - This definition define spi driver instance
  * @regs:		virt. address of the control registers
@@ -112,6 +116,8 @@
  * @rx_bus_width:	Number of wires used to receive data
  * @tx_fifo:		For writing data to fifo
  * @rx_fifo:		For reading data from fifo
+ * @fifo_burst:		FIFO data is in CPU byte order, aligned 32 bit
+ *			words are moved with the string accessors
  */
 struct xilinx_spi {
 	void __iomem	*regs;	/* virt. address of the control registers */
@@ -134,6 +140,7 @@ struct xilinx_spi {
 	u32 rx_bus_width;
 	void (*tx_fifo)(struct xilinx_spi *xqspi);
 	void (*rx_fifo)(struct xilinx_spi *xqspi);
+	bool fifo_burst;
 };
 
 /**
@@ -142,7 +149,8 @@ struct xilinx_spi {
  * @type: C type of value argument
  *
  * Generates xspi_read_rx_fifo_* functions used to write
- * data into RX FIFO for different transaction widths.
+ * data into RX FIFO for different transaction widths. Aligned
+ * 32 bit words are drained in a single ioread32_rep() burst.
  */
 #define XSPI_FIFO_READ(size, type)					\
 static void xspi_read_rx_fifo_##size(struct xilinx_spi *xqspi)		\
@@ -151,11 +159,17 @@ static void xspi_read_rx_fifo_##size(struct xilinx_spi *xqspi)		\
 	int count = (xqspi->bytes_to_receive > xqspi->buffer_size) ?	\
 			xqspi->buffer_size : xqspi->bytes_to_receive;	\
 	u32 data;							\
-	for (i = 0; i < count; i += (size / 8)) {			\
-		data = readl_relaxed(xqspi->regs + XSPI_RXD_OFFSET);	\
-		if (xqspi->rx_ptr)					\
-			((type *)xqspi->rx_ptr)[i] = (type)data;	\
-	}								\
+	if (size == 32 && xqspi->fifo_burst && xqspi->rx_ptr &&	\
+	    IS_ALIGNED((unsigned long)xqspi->rx_ptr, 4))		\
+		ioread32_rep(xqspi->regs + XSPI_RXD_OFFSET,		\
+			     xqspi->rx_ptr, count / 4);			\
+	else								\
+		for (i = 0; i < count; i += (size / 8)) {		\
+			data = readl_relaxed(xqspi->regs +		\
+					     XSPI_RXD_OFFSET);		\
+			if (xqspi->rx_ptr)				\
+				*(type *)&xqspi->rx_ptr[i] = (type)data; \
+		}							\
 	xqspi->bytes_to_receive -= count;				\
 	if (xqspi->rx_ptr)						\
 		xqspi->rx_ptr += count;					\
@@ -167,7 +181,8 @@ static void xspi_read_rx_fifo_##size(struct xilinx_spi *xqspi)		\
  * @type: C type of value argument
  *
  * Generates xspi_fill_tx_fifo_* functions used to write
- * data into TX FIFO for different transaction widths.
+ * data into TX FIFO for different transaction widths. Aligned
+ * 32 bit words are written in a single iowrite32_rep() burst.
  */
 #define XSPI_FIFO_WRITE(size, type)					\
 static void xspi_fill_tx_fifo_##size(struct xilinx_spi *xqspi)		\
@@ -176,11 +191,17 @@ static void xspi_fill_tx_fifo_##size(struct xilinx_spi *xqspi)		\
 	int count = (xqspi->bytes_to_transfer > xqspi->buffer_size) ?	\
 			xqspi->buffer_size : xqspi->bytes_to_transfer;	\
 	u32 data = 0;							\
-	for (i = 0; i < count; i += (size / 8)) {			\
-		if (xqspi->tx_ptr)					\
-			data = *(type *)&xqspi->tx_ptr[i];		\
-		writel_relaxed(data, (xqspi->regs + XSPI_TXD_OFFSET));	\
-	}								\
+	if (size == 32 && xqspi->fifo_burst && xqspi->tx_ptr &&	\
+	    IS_ALIGNED((unsigned long)xqspi->tx_ptr, 4))		\
+		iowrite32_rep(xqspi->regs + XSPI_TXD_OFFSET,		\
+			      xqspi->tx_ptr, count / 4);		\
+	else								\
+		for (i = 0; i < count; i += (size / 8)) {		\
+			if (xqspi->tx_ptr)				\
+				data = *(type *)&xqspi->tx_ptr[i];	\
+			writel_relaxed(data,				\
+				       xqspi->regs + XSPI_TXD_OFFSET);	\
+		}							\
 	xqspi->bytes_to_transfer -= count;				\
 	if (xqspi->tx_ptr)						\
 		xqspi->tx_ptr += count;					\
@@ -380,6 +401,42 @@ static int xspi_setup(struct spi_device *qspi)
 	return ret;
 }
 
+/**
+ * xspi_poll_transfer - Complete a SPI transfer by polling the status
+ * @xqspi:	Pointer to the xilinx_spi structure
+ *
+ * Used for the transfers that fit in the FIFO, where waiting for the Tx
+ * empty interrupt costs more than the transfer itself, and when the
+ * controller has no interrupt.
+ *
+ * Return:	0 on success, -ETIMEDOUT if the FIFO did not drain
+ */
+static int xspi_poll_transfer(struct xilinx_spi *xqspi)
+{
+	u32 sr;
+	int ret;
+
+	while (xqspi->bytes_to_receive) {
+		ret = read_poll_timeout(xqspi->read_fn, sr,
+					sr & XSPI_SR_TX_EMPTY_MASK, 0,
+					XSPI_POLL_TIMEOUT_US, false,
+					xqspi->regs + XSPI_SR_OFFSET);
+		if (ret)
+			return ret;
+
+		xqspi->rx_fifo(xqspi);
+		if (xqspi->bytes_to_transfer)
+			xqspi->tx_fifo(xqspi);
+	}
+
+	/* Ack the latched Tx empty event, the register is toggle on write */
+	sr = xqspi->read_fn(xqspi->regs + XIPIF_V123B_IISR_OFFSET);
+	xqspi->write_fn(sr & XSPI_INTR_TX_EMPTY,
+			xqspi->regs + XIPIF_V123B_IISR_OFFSET);
+
+	return 0;
+}
+
 /**
  * xspi_start_transfer - Initiates the SPI transfer
  * @master:	Pointer to the spi_master structure which provides
@@ -391,7 +448,9 @@ static int xspi_setup(struct spi_device *qspi)
  * This function fills the TX FIFO, starts the SPI transfer, and waits for the
  * transfer to be completed.
  *
- * Return:	Number of bytes transferred in the last transfer
+ * Return:	0 if the transfer was completed by polling, negative errno on
+ *		failure, otherwise the number of bytes of the transfer left to
+ *		the interrupt handler
  */
 
 static int xspi_start_transfer(struct spi_master *master,
@@ -425,6 +484,10 @@ static int xspi_start_transfer(struct spi_master *master,
 	/* Disable master transaction inhibit */
 	cr &= ~XSPI_CR_TRANS_INHIBIT;
 	xqspi->write_fn(cr, xqspi->regs + XSPI_CR_OFFSET);
+
+	if (!xqspi->bytes_to_transfer || xqspi->irq < 0)
+		return xspi_poll_transfer(xqspi);
+
 	xqspi->write_fn(XIPIF_V123B_GINTR_ENABLE,
 			xqspi->regs + XIPIF_V123B_DGIER_OFFSET);
 
@@ -790,6 +853,10 @@ static int xilinx_spi_probe(struct platform_device *pdev)
 		xspi->read_fn = xspi_read32_be;
 		xspi->write_fn = xspi_write32_be;
 	}
+#ifdef __LITTLE_ENDIAN
+	/* The string accessors do not swap the FIFO data */
+	xspi->fifo_burst = xspi->read_fn == xspi_read32;
+#endif
 
 	xspi->buffer_size = fifo_size;
 	xspi->irq = platform_get_irq(pdev, 0);
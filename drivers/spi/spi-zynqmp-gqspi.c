@@ -136,6 +136,11 @@
 #define GQSPI_SELECT_MODE_DUALSPI	0x2
 #define GQSPI_SELECT_MODE_QUADSPI	0x4
 #define GQSPI_DMA_UNALIGN		0x3
+#define GQSPI_BOUNCE_SIZE		SZ_64K
+#define GQSPI_DIRMAP_READ_MAX		SZ_1M
+#define GQSPI_READAHEAD_SIZE		SZ_64K
+/* Reads must not cross a die, whatever the flash, see spi_nor_read() */
+#define GQSPI_READAHEAD_BOUNDARY	SZ_16M
 #define GQSPI_DEFAULT_NUM_CS	1	/* Default number of chip selects */
 
 #define GQSPI_MAX_NUM_CS	2	/* Maximum number of chip selects */
@@ -163,6 +168,24 @@
 #define SPI_AUTOSUSPEND_TIMEOUT		3000
 enum mode_type {GQSPI_MODE_IO, GQSPI_MODE_DMA};
 
+/**
+ * struct zynqmp_qspi_readahead - Read-ahead window of the direct mappings
+ * @buf:	GQSPI_READAHEAD_SIZE bytes of read data
+ * @desc:	Direct mapping the window and @next belong to
+ * @cs:		Chip select mask the window was read with
+ * @addr:	Flash address of the start of the window
+ * @len:	Number of bytes in @buf, 0 if the window is empty
+ * @next:	Flash address right after the last dirmap read of @desc
+ */
+struct zynqmp_qspi_readahead {
+	u8 *buf;
+	struct spi_mem_dirmap_desc *desc;
+	u32 cs;
+	u64 addr;
+	u32 len;
+	u64 next;
+};
+
 /**
  * struct qspi_platform_data - zynqmp qspi platform data structure
  * @quirks:    Flags is used to identify the platform
@@ -187,6 +210,11 @@ struct qspi_platform_data {
  * @genfifobus:		Used to select the upper or lower bus
  * @dma_rx_bytes:	Remaining bytes to receive by DMA mode
  * @dma_addr:		DMA address after mapping the kernel buffer
+ * @bounce:		DMA bounce buffer for reads into vmalloc'ed or
+ *			unaligned buffers
+ * @bounce_dma:		DMA address of @bounce, mapped while the driver is
+ *			bound
+ * @dma_bounce:		A read is in progress through @bounce
  * @genfifoentry:	Used for storing the genfifoentry instruction.
  * @mode:		Defines the mode in which QSPI is operating
 * @io_mode:		Defines the operating mode, either IO or dma
@@ -195,6 +223,7 @@ struct qspi_platform_data {
  * @speed_hz:          Current SPI bus clock speed in hz
  * @has_tapdelay:	Used for tapdelay register available in qspi
  * @is_parallel:		Used for multi CS support
+ * @ra:			Read-ahead window of the direct mappings
  */
 struct zynqmp_qspi {
 	struct spi_controller *ctlr;
@@ -211,6 +240,9 @@ struct zynqmp_qspi {
 	u32 genfifobus;
 	u32 dma_rx_bytes;
 	dma_addr_t dma_addr;
+	void *bounce;
+	dma_addr_t bounce_dma;
+	bool dma_bounce;
 	u32 genfifoentry;
 	enum mode_type mode;
 	struct completion data_completion;
@@ -219,6 +251,7 @@ struct zynqmp_qspi {
 	bool io_mode;
 	bool has_tapdelay;
 	bool is_parallel;
+	struct zynqmp_qspi_readahead ra;
 };
 
 /**
@@ -885,6 +918,14 @@ static irqreturn_t zynqmp_qspi_irq(int irq, void *dev_id)
 		zynqmp_gqspi_write(xqspi, GQSPI_QSPIDMA_DST_I_STS_OFST,
 				   dma_status);
 	}
+	if ((dma_status & GQSPI_QSPIDMA_DST_I_STS_DONE_MASK) &&
+	    xqspi->dma_bounce) {
+		/* zynqmp_qspi_read_bounce() re-arms the DMA */
+		zynqmp_gqspi_write(xqspi, GQSPI_QSPIDMA_DST_I_DIS_OFST,
+				   GQSPI_QSPIDMA_DST_I_EN_DONE_MASK);
+		complete(&xqspi->data_completion);
+		return IRQ_HANDLED;
+	}
 	if (dma_status & GQSPI_QSPIDMA_DST_I_STS_DONE_MASK) {
 		zynqmp_process_dma_irq(xqspi);
 		ret = IRQ_HANDLED;
@@ -972,6 +1013,127 @@ static int zynqmp_qspi_setuprxdma(struct zynqmp_qspi *xqspi)
 	return 0;
 }
 
+/**
+ * zynqmp_qspi_need_bounce - Check whether a read goes through the bounce buffer
+ * @xqspi:	xqspi is a pointer to the GQSPI instance.
+ * @buf:	Destination of the read
+ * @len:	Number of bytes to read
+ *
+ * Return:	true for reads zynqmp_qspi_setuprxdma() would do in IO mode only
+ *		because of the destination buffer.
+ */
+static bool zynqmp_qspi_need_bounce(struct zynqmp_qspi *xqspi, void *buf,
+				    u32 len)
+{
+	if (!xqspi->bounce || xqspi->io_mode || len < 8)
+		return false;
+
+	return ((uintptr_t)buf & GQSPI_DMA_UNALIGN) || is_vmalloc_addr(buf);
+}
+
+/**
+ * zynqmp_qspi_bounce_arm - Start the DMA of the next chunk into the bounce
+ *				buffer
+ * @xqspi:	xqspi is a pointer to the GQSPI instance.
+ * @len:	Number of bytes of the chunk, a multiple of 4
+ */
+static void zynqmp_qspi_bounce_arm(struct zynqmp_qspi *xqspi, u32 len)
+{
+	u64 addr = xqspi->bounce_dma;
+
+	reinit_completion(&xqspi->data_completion);
+	dma_sync_single_for_device(xqspi->dev, xqspi->bounce_dma, len,
+				   DMA_FROM_DEVICE);
+
+	zynqmp_gqspi_write(xqspi, GQSPI_QSPIDMA_DST_ADDR_OFST,
+			   lower_32_bits(addr));
+	zynqmp_gqspi_write(xqspi, GQSPI_QSPIDMA_DST_ADDR_MSB_OFST,
+			   upper_32_bits(addr) & 0xfff);
+	zynqmp_gqspi_write(xqspi, GQSPI_QSPIDMA_DST_SIZE_OFST, len);
+	zynqmp_gqspi_write(xqspi, GQSPI_QSPIDMA_DST_I_EN_OFST,
+			   GQSPI_QSPIDMA_DST_I_EN_DONE_MASK);
+}
+
+/**
+ * zynqmp_qspi_read_bounce - Receive the data phase through the bounce buffer
+ * @xqspi:	xqspi is a pointer to the GQSPI instance.
+ * @rx_nbits:	Receive buswidth.
+ * @genfifoentry:	GENFIFO mask of the operation
+ * @buf:	Destination of the read
+ * @len:	Number of bytes to read
+ *
+ * The GENFIFO entries of the whole data phase, rounded up to a multiple of
+ * 4 bytes, are queued at once so the flash keeps streaming while the DMA
+ * is re-armed on the bounce buffer for each chunk; the RX FIFO holds the
+ * data meanwhile. This keeps vmalloc'ed and unaligned buffers, including
+ * their unaligned tail, out of IO mode.
+ *
+ * Return:	0 on success; error value otherwise.
+ */
+static int zynqmp_qspi_read_bounce(struct zynqmp_qspi *xqspi, u8 rx_nbits,
+				   u32 genfifoentry, u8 *buf, u32 len)
+{
+	u32 total = round_up(len, 4);
+	u32 speed_hz = xqspi->speed_hz ? : 100000;
+	u32 chunk, copy, config_reg;
+	unsigned long long ms;
+	int err = 0;
+
+	/* 8 SPI clock cycles per byte of a chunk, twice, plus tolerance */
+	ms = 8LL * MSEC_PER_SEC * min_t(u32, total, GQSPI_BOUNCE_SIZE);
+	do_div(ms, speed_hz);
+	ms += ms + 10000;
+
+	xqspi->txbuf = NULL;
+	xqspi->rxbuf = xqspi->bounce;
+	xqspi->bytes_to_transfer = 0;
+	xqspi->bytes_to_receive = total;
+	xqspi->dma_rx_bytes = total;
+	xqspi->mode = GQSPI_MODE_DMA;
+	xqspi->dma_bounce = true;
+
+	config_reg = zynqmp_gqspi_read(xqspi, GQSPI_CONFIG_OFST);
+	config_reg &= ~GQSPI_CFG_MODE_EN_MASK;
+	config_reg |= GQSPI_CFG_MODE_EN_DMA_MASK;
+	zynqmp_gqspi_write(xqspi, GQSPI_CONFIG_OFST, config_reg);
+
+	chunk = min_t(u32, total, GQSPI_BOUNCE_SIZE);
+	zynqmp_qspi_bounce_arm(xqspi, chunk);
+	zynqmp_qspi_fillgenfifo(xqspi, rx_nbits, genfifoentry);
+	zynqmp_gqspi_write(xqspi, GQSPI_CONFIG_OFST,
+			   zynqmp_gqspi_read(xqspi, GQSPI_CONFIG_OFST) |
+			   GQSPI_CFG_START_GEN_FIFO_MASK);
+
+	while (total) {
+		if (!wait_for_completion_timeout(&xqspi->data_completion,
+						 msecs_to_jiffies(ms))) {
+			err = -ETIMEDOUT;
+			break;
+		}
+
+		dma_sync_single_for_cpu(xqspi->dev, xqspi->bounce_dma, chunk,
+					DMA_FROM_DEVICE);
+		copy = min(len, chunk);
+		memcpy(buf, xqspi->bounce, copy);
+		buf += copy;
+		len -= copy;
+		total -= chunk;
+
+		if (total) {
+			chunk = min_t(u32, total, GQSPI_BOUNCE_SIZE);
+			zynqmp_qspi_bounce_arm(xqspi, chunk);
+		}
+	}
+
+	zynqmp_gqspi_write(xqspi, GQSPI_QSPIDMA_DST_I_DIS_OFST,
+			   GQSPI_QSPIDMA_DST_I_EN_DONE_MASK);
+	xqspi->dma_bounce = false;
+	xqspi->bytes_to_receive = 0;
+	xqspi->dma_rx_bytes = 0;
+
+	return err;
+}
+
 /**
  * zynqmp_qspi_write_op - This function sets up the GENFIFO entries,
  *			TX FIFO, and fills the TX FIFO with as many
@@ -1128,18 +1290,21 @@ static int __maybe_unused zynqmp_runtime_resume(struct device *dev)
 }
 
 /**
- * zynqmp_qspi_exec_op() - Initiates the QSPI transfer
+ * __zynqmp_qspi_exec_op() - Initiates the QSPI transfer
  * @mem: The SPI memory
  * @op: The memory operation to execute
  *
- * Executes a memory operation.
+ * Executes a memory operation with op_lock held.
  *
  * This function first selects the chip and starts the memory operation.
+ * The command and address phases of a read are only queued, they fit in
+ * the TX FIFO and the GENFIFO runs them ahead of the data phase, so a read
+ * costs a single completion instead of three.
  *
  * Return: 0 in case of success, a negative error code otherwise.
  */
-static int zynqmp_qspi_exec_op(struct spi_mem *mem,
-			       const struct spi_mem_op *op)
+static int __zynqmp_qspi_exec_op(struct spi_mem *mem,
+				 const struct spi_mem_op *op)
 {
 	struct zynqmp_qspi *xqspi = spi_controller_get_devdata
 				    (mem->spi->master);
@@ -1150,12 +1315,12 @@ static int zynqmp_qspi_exec_op(struct spi_mem *mem,
 	unsigned long long ms;
 	u64 opaddr;
 	u8 addrbuswidth = zynqmp_get_addr_buswidth(op);
+	bool pipelined = op->data.nbytes && op->data.dir == SPI_MEM_DATA_IN;
 
 	dev_dbg(xqspi->dev, "cmd:%#x mode:%d.%d.%d.%d\n",
 		op->cmd.opcode, op->cmd.buswidth, op->addr.buswidth,
 		op->dummy.buswidth, op->data.buswidth);
 
-	mutex_lock(&xqspi->op_lock);
 	zynqmp_qspi_config_op(xqspi, mem->spi);
 	zynqmp_qspi_chipselect(mem->spi, false);
 	genfifoentry |= xqspi->genfifocs;
@@ -1172,6 +1337,9 @@ static int zynqmp_qspi_exec_op(struct spi_mem *mem,
 		zynqmp_gqspi_write(xqspi, GQSPI_CONFIG_OFST,
 				   zynqmp_gqspi_read(xqspi, GQSPI_CONFIG_OFST) |
 				   GQSPI_CFG_START_GEN_FIFO_MASK);
+	}
+
+	if (op->cmd.opcode && !pipelined) {
 		zynqmp_gqspi_write(xqspi, GQSPI_IER_OFST,
 				   GQSPI_IER_GENFIFOEMPTY_MASK |
 				   GQSPI_IER_TXNOT_FULL_MASK);
@@ -1198,6 +1366,9 @@ static int zynqmp_qspi_exec_op(struct spi_mem *mem,
 				   zynqmp_gqspi_read(xqspi,
 						     GQSPI_CONFIG_OFST) |
 				   GQSPI_CFG_START_GEN_FIFO_MASK);
+	}
+
+	if (op->addr.nbytes && !pipelined) {
 		zynqmp_gqspi_write(xqspi, GQSPI_IER_OFST,
 				   GQSPI_IER_TXEMPTY_MASK |
 				   GQSPI_IER_GENFIFOEMPTY_MASK |
@@ -1249,6 +1420,16 @@ static int zynqmp_qspi_exec_op(struct spi_mem *mem,
 					   GQSPI_IER_GENFIFOEMPTY_MASK |
 					   GQSPI_IER_TXNOT_FULL_MASK);
 		} else {
+			if (zynqmp_qspi_need_bounce(xqspi, op->data.buf.in,
+						    op->data.nbytes)) {
+				err = zynqmp_qspi_read_bounce(xqspi,
+							      op->data.buswidth,
+							      genfifoentry,
+							      op->data.buf.in,
+							      op->data.nbytes);
+				goto return_err;
+			}
+
 			xqspi->txbuf = NULL;
 			xqspi->rxbuf = (u8 *)op->data.buf.in;
 			xqspi->bytes_to_receive = op->data.nbytes;
@@ -1303,6 +1484,31 @@ static int zynqmp_qspi_exec_op(struct spi_mem *mem,
 return_err:
 
 	zynqmp_qspi_chipselect(mem->spi, true);
+
+	return err;
+}
+
+/**
+ * zynqmp_qspi_exec_op() - Initiates the QSPI transfer
+ * @mem: The SPI memory
+ * @op: The memory operation to execute
+ *
+ * Anything but a read may change what the flash returns, so it also drops
+ * the read-ahead window.
+ *
+ * Return: 0 in case of success, a negative error code otherwise.
+ */
+static int zynqmp_qspi_exec_op(struct spi_mem *mem,
+			       const struct spi_mem_op *op)
+{
+	struct zynqmp_qspi *xqspi = spi_controller_get_devdata
+				    (mem->spi->master);
+	int err;
+
+	mutex_lock(&xqspi->op_lock);
+	if (op->data.dir != SPI_MEM_DATA_IN)
+		xqspi->ra.len = 0;
+	err = __zynqmp_qspi_exec_op(mem, op);
 	mutex_unlock(&xqspi->op_lock);
 
 	return err;
@@ -1335,8 +1541,169 @@ static const struct of_device_id zynqmp_qspi_of_match[] = {
 	{ /* End of table */ }
 };
 
+/**
+ * zynqmp_qspi_dirmap_create() - Check a direct mapping
+ * @desc: The direct mapping descriptor
+ *
+ * Only reads are mapped, page program sized writes gain nothing over
+ * zynqmp_qspi_exec_op() and are left to the spi-mem fallback.
+ *
+ * Return: 0 if the mapping is supported, -EOPNOTSUPP otherwise.
+ */
+static int zynqmp_qspi_dirmap_create(struct spi_mem_dirmap_desc *desc)
+{
+	if (desc->info.op_tmpl.data.dir != SPI_MEM_DATA_IN)
+		return -EOPNOTSUPP;
+
+	return 0;
+}
+
+/**
+ * zynqmp_qspi_dirmap_destroy() - Forget a direct mapping
+ * @desc: The direct mapping descriptor
+ */
+static void zynqmp_qspi_dirmap_destroy(struct spi_mem_dirmap_desc *desc)
+{
+	struct zynqmp_qspi *xqspi = spi_controller_get_devdata
+				    (desc->mem->spi->master);
+
+	mutex_lock(&xqspi->op_lock);
+	if (xqspi->ra.desc == desc) {
+		xqspi->ra.desc = NULL;
+		xqspi->ra.len = 0;
+	}
+	mutex_unlock(&xqspi->op_lock);
+}
+
+/**
+ * zynqmp_qspi_readahead() - Serve a small dirmap read from the read-ahead
+ *			     window
+ * @xqspi: Pointer to the zynqmp_qspi structure
+ * @desc: The direct mapping descriptor
+ * @addr: Flash address to read from
+ * @len: Number of bytes to read
+ * @buf: Destination buffer
+ *
+ * mtdblock and the spi-nor fallbacks read a sequential image, a bitstream
+ * or a kernel, a sector at a time, and each of those reads pays for the
+ * command, address and dummy phases. Once a read continues where the
+ * previous one of the mapping stopped, GQSPI_READAHEAD_SIZE bytes are read
+ * at once and the following reads are copied from them.
+ *
+ * With both flashes of a dual parallel pair selected the data is striped,
+ * and each flash address holds two bytes of it.
+ *
+ * Return: Number of bytes read, 0 if the read must go to the flash, a
+ *	   negative error code otherwise.
+ */
+static ssize_t zynqmp_qspi_readahead(struct zynqmp_qspi *xqspi,
+				     struct spi_mem_dirmap_desc *desc,
+				     u64 addr, size_t len, void *buf)
+{
+	struct zynqmp_qspi_readahead *ra = &xqspi->ra;
+	u32 cs = desc->mem->spi->cs_index_mask;
+	unsigned int shift = (cs & GQSPI_SELECT_LOWER_CS) &&
+			     (cs & GQSPI_SELECT_UPPER_CS);
+	struct spi_mem_op op = desc->info.op_tmpl;
+	u64 skip, end;
+	u32 window;
+	size_t n;
+	int err;
+
+	if (!ra->buf || len >= GQSPI_READAHEAD_SIZE)
+		return 0;
+
+	if (ra->len && ra->desc == desc && ra->cs == cs && addr >= ra->addr) {
+		skip = (addr - ra->addr) << shift;
+		if (skip < ra->len) {
+			n = min_t(size_t, len, ra->len - skip);
+			/* Stay on an even byte of the stripe */
+			if (n < len)
+				n &= ~(size_t)shift;
+			if (n) {
+				memcpy(buf, ra->buf + skip, n);
+				ra->next = addr + (n >> shift);
+				return n;
+			}
+		}
+	}
+
+	if (ra->desc != desc || ra->cs != cs || addr != ra->next) {
+		ra->desc = desc;
+		ra->cs = cs;
+		ra->len = 0;
+		ra->next = addr + (len >> shift);
+		return 0;
+	}
+
+	end = min(desc->info.offset + desc->info.length,
+		  round_up(addr + 1, GQSPI_READAHEAD_BOUNDARY));
+	window = min_t(u64, GQSPI_READAHEAD_SIZE, (end - addr) << shift);
+	window &= ~shift;
+	if (window <= len) {
+		ra->next = addr + (len >> shift);
+		return 0;
+	}
+
+	op.addr.val = addr;
+	op.data.nbytes = window;
+	op.data.buf.in = ra->buf;
+
+	ra->len = 0;
+	err = __zynqmp_qspi_exec_op(desc->mem, &op);
+	if (err)
+		return err;
+
+	ra->addr = addr;
+	ra->len = window;
+	memcpy(buf, ra->buf, len);
+	ra->next = addr + (len >> shift);
+
+	return len;
+}
+
+/**
+ * zynqmp_qspi_dirmap_read() - Read through a direct mapping
+ * @desc: The direct mapping descriptor
+ * @offs: Offset in the mapping to read from
+ * @len: Number of bytes to read
+ * @buf: Destination buffer
+ *
+ * Issues a single read operation for up to GQSPI_DIRMAP_READ_MAX bytes,
+ * instead of the spi-mem fallback splitting it at the message size. Small
+ * sequential reads go through zynqmp_qspi_readahead().
+ *
+ * Return: Number of bytes read, a negative error code otherwise.
+ */
+static ssize_t zynqmp_qspi_dirmap_read(struct spi_mem_dirmap_desc *desc,
+				       u64 offs, size_t len, void *buf)
+{
+	struct zynqmp_qspi *xqspi = spi_controller_get_devdata
+				    (desc->mem->spi->master);
+	struct spi_mem_op op = desc->info.op_tmpl;
+	ssize_t ret;
+	int err;
+
+	op.addr.val = desc->info.offset + offs;
+	op.data.nbytes = min_t(size_t, len, GQSPI_DIRMAP_READ_MAX);
+	op.data.buf.in = buf;
+
+	mutex_lock(&xqspi->op_lock);
+	ret = zynqmp_qspi_readahead(xqspi, desc, op.addr.val, len, buf);
+	if (!ret) {
+		err = __zynqmp_qspi_exec_op(desc->mem, &op);
+		ret = err ? err : op.data.nbytes;
+	}
+	mutex_unlock(&xqspi->op_lock);
+
+	return ret;
+}
+
 static const struct spi_controller_mem_ops zynqmp_qspi_mem_ops = {
 	.exec_op = zynqmp_qspi_exec_op,
+	.dirmap_create = zynqmp_qspi_dirmap_create,
+	.dirmap_destroy = zynqmp_qspi_dirmap_destroy,
+	.dirmap_read = zynqmp_qspi_dirmap_read,
 };
 
 /**
@@ -1464,9 +1831,26 @@ static int zynqmp_qspi_probe(struct platform_device *pdev)
 	ctlr->auto_runtime_pm = true;
 	ctlr->multi_cs_cap = true;
 
+	/* Optional, reads into such buffers use IO mode without it */
+	xqspi->bounce = devm_kmalloc(&pdev->dev, GQSPI_BOUNCE_SIZE, GFP_KERNEL);
+	if (xqspi->bounce) {
+		xqspi->bounce_dma = dma_map_single(&pdev->dev, xqspi->bounce,
+						   GQSPI_BOUNCE_SIZE,
+						   DMA_FROM_DEVICE);
+		if (dma_mapping_error(&pdev->dev, xqspi->bounce_dma))
+			xqspi->bounce = NULL;
+	}
+
+	/* Optional as well, small dirmap reads are not read ahead without it */
+	xqspi->ra.buf = devm_kmalloc(&pdev->dev, GQSPI_READAHEAD_SIZE,
+				     GFP_KERNEL);
+
 	ret = devm_spi_register_controller(&pdev->dev, ctlr);
 	if (ret) {
 		dev_err(&pdev->dev, "spi_register_controller failed\n");
+		if (xqspi->bounce)
+			dma_unmap_single(&pdev->dev, xqspi->bounce_dma,
+					 GQSPI_BOUNCE_SIZE, DMA_FROM_DEVICE);
 		goto clk_dis_all;
 	}
 
@@ -1503,6 +1887,9 @@ static int zynqmp_qspi_remove(struct platform_device *pdev)
 	struct zynqmp_qspi *xqspi = platform_get_drvdata(pdev);
 
 	zynqmp_gqspi_write(xqspi, GQSPI_EN_OFST, 0x0);
+	if (xqspi->bounce)
+		dma_unmap_single(&pdev->dev, xqspi->bounce_dma,
+				 GQSPI_BOUNCE_SIZE, DMA_FROM_DEVICE);
 	clk_disable_unprepare(xqspi->refclk);
 	clk_disable_unprepare(xqspi->pclk);
 	pm_runtime_set_suspended(&pdev->dev);
@@ -31,6 +31,10 @@
 #include <linux/uaccess.h>
 #include <linux/jiffies.h>
 #include <linux/miscdevice.h>
+#include <linux/mm.h>
+#include <linux/poll.h>
+#include <linux/uio.h>
+#include <linux/vmalloc.h>
 
 #include <linux/of_address.h>
 #include <linux/of_device.h>
@@ -105,6 +109,7 @@
  */
 static int read_timeout = 1000; /* ms to wait before read() times out */
 static int write_timeout = 1000; /* ms to wait before write() times out */
+static unsigned int rx_ring_size; /* bytes of the mmap() receive ring */
 
 /* ----------------------------
  * module command-line arguments
@@ -115,6 +120,8 @@ module_param(read_timeout, int, 0444);
 MODULE_PARM_DESC(read_timeout, "ms to wait before blocking read() timing out; set to -1 for no timeout");
 module_param(write_timeout, int, 0444);
 MODULE_PARM_DESC(write_timeout, "ms to wait before blocking write() timing out; set to -1 for no timeout");
+module_param(rx_ring_size, uint, 0444);
+MODULE_PARM_DESC(rx_ring_size, "size in bytes of the receive ring drained from the interrupt and mappable with mmap(); 0 (default) to read from the fifo directly");
 
 /* ----------------------------
  *            types
@@ -133,10 +140,17 @@ struct axis_fifo {
 	wait_queue_head_t read_queue; /* wait queue for asynchronos read */
 	struct mutex read_lock; /* lock for reading */
 	wait_queue_head_t write_queue; /* wait queue for asynchronos write */
+	wait_queue_head_t poll_queue; /* wait queue for poll() thresholds */
+	unsigned int rx_threshold; /* words received before poll() wakes */
+	unsigned int tx_threshold; /* words free before poll() wakes */
 	struct mutex write_lock; /* lock for writing */
 	unsigned int write_flags; /* write file flags */
 	unsigned int read_flags; /* read file flags */
 
+	void *ring; /* receive ring, control page then data, or NULL */
+	unsigned int ring_size; /* receive ring data size in bytes */
+	u32 ring_head; /* receive ring head, as userspace may overwrite it */
+
 	struct device *dt_device; /* device created from the device tree */
 	struct miscdevice miscdev;
 };
@@ -315,8 +329,83 @@ static const struct attribute_group axis_fifo_attrs_group = {
 	.attrs = axis_fifo_attrs,
 };
 
+static ssize_t threshold_store(struct device *dev, const char *buf,
+			       size_t count, unsigned int *threshold,
+			       unsigned int max)
+{
+	unsigned int tmp;
+	int rc;
+
+	rc = kstrtouint(buf, 0, &tmp);
+	if (rc < 0)
+		return rc;
+
+	if (!tmp || tmp > max)
+		return -EINVAL;
+
+	WRITE_ONCE(*threshold, tmp);
+
+	return count;
+}
+
+static ssize_t rx_threshold_store(struct device *dev,
+				  struct device_attribute *attr,
+				  const char *buf, size_t count)
+{
+	struct axis_fifo *fifo = dev_get_drvdata(dev);
+	unsigned int max = fifo->rx_fifo_depth;
+
+	/* the ring holds more than the fifo, with a length word per packet */
+	if (fifo->ring)
+		max = fifo->ring_size / sizeof(u32);
+
+	return threshold_store(dev, buf, count, &fifo->rx_threshold, max);
+}
+
+static ssize_t rx_threshold_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct axis_fifo *fifo = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%u\n", READ_ONCE(fifo->rx_threshold));
+}
+
+static DEVICE_ATTR_RW(rx_threshold);
+
+static ssize_t tx_threshold_store(struct device *dev,
+				  struct device_attribute *attr,
+				  const char *buf, size_t count)
+{
+	struct axis_fifo *fifo = dev_get_drvdata(dev);
+
+	return threshold_store(dev, buf, count, &fifo->tx_threshold,
+			       fifo->tx_fifo_depth);
+}
+
+static ssize_t tx_threshold_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct axis_fifo *fifo = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%u\n", READ_ONCE(fifo->tx_threshold));
+}
+
+static DEVICE_ATTR_RW(tx_threshold);
+
+static struct attribute *axis_fifo_poll_attrs[] = {
+	&dev_attr_rx_threshold.attr,
+	&dev_attr_tx_threshold.attr,
+	NULL,
+};
+
+static const struct attribute_group axis_fifo_poll_attrs_group = {
+	.name = "poll",
+	.attrs = axis_fifo_poll_attrs,
+};
+
 static const struct attribute_group *axis_fifo_attrs_groups[] = {
 	&axis_fifo_attrs_group,
+	&axis_fifo_poll_attrs_group,
 	NULL,
 };
 
@@ -337,12 +426,190 @@ static void reset_ip_core(struct axis_fifo *fifo)
 	iowrite32(XLLF_INT_ALL_MASK, fifo->base_addr + XLLF_ISR_OFFSET);
 }
 
+/* ----------------------------
+ *       receive ring
+ * ----------------------------
+ */
+
+/*
+ * With rx_ring_size set, the driver drains received packets from the IRQ
+ * thread into a ring which userspace can mmap() to consume packets without
+ * a system call each. The first page of the mapping holds struct
+ * axis_fifo_ring_ctrl, the ring data follows. Each packet is stored as a
+ * u32 length in bytes followed by the packet words. A length of 0 marks
+ * the end of the data before the ring wraps, packets never wrap.
+ *
+ * head and tail are free running byte counters, the consumer reads the
+ * packets between tail and head and then advances tail. read() and readv()
+ * consume from the ring the same way.
+ */
+
 /**
- * axis_fifo_read() - Read a packet from AXIS-FIFO character device.
- * @f: Open file.
+ * struct axis_fifo_ring_ctrl - receive ring control page
+ * @head: end of the packets written by the driver
+ * @tail: end of the packets consumed, written by the consumer
+ * @size: size of the ring data in bytes, a power of 2
+ * @dropped: number of packets dropped because the ring was full
+ */
+struct axis_fifo_ring_ctrl {
+	u32 head;
+	u32 tail;
+	u32 size;
+	u32 dropped;
+};
+
+static inline bool axis_fifo_ring_empty(struct axis_fifo *fifo)
+{
+	struct axis_fifo_ring_ctrl *ctrl = fifo->ring;
+
+	return READ_ONCE(ctrl->tail) == smp_load_acquire(&ctrl->head);
+}
+
+static inline u32 *axis_fifo_ring_word(struct axis_fifo *fifo, u32 off)
+{
+	return fifo->ring + PAGE_SIZE + (off & (fifo->ring_size - 1));
+}
+
+/* read out and discard a packet which doesn't fit in the ring */
+static void axis_fifo_drop_packet(struct axis_fifo *fifo, unsigned int words)
+{
+	u32 tmp_buf[READ_BUF_SIZE];
+	unsigned int copy;
+
+	while (words) {
+		copy = min(words, READ_BUF_SIZE);
+		ioread32_rep(fifo->base_addr + XLLF_RDFD_OFFSET, tmp_buf, copy);
+		words -= copy;
+	}
+}
+
+/* drain the receive fifo into the ring, called from the IRQ thread only */
+static void axis_fifo_ring_fill(struct axis_fifo *fifo)
+{
+	struct axis_fifo_ring_ctrl *ctrl = fifo->ring;
+	u32 head = fifo->ring_head;
+	u32 bytes, pad, used;
+
+	while (ioread32(fifo->base_addr + XLLF_RDFO_OFFSET)) {
+		bytes = ioread32(fifo->base_addr + XLLF_RLR_OFFSET);
+		if (!bytes || bytes % sizeof(u32)) {
+			dev_err(fifo->dt_device, "received an invalid packet of length %u - fifo core will be reset\n",
+				bytes);
+			reset_ip_core(fifo);
+			break;
+		}
+
+		/* skip the end of the ring if the packet doesn't fit there */
+		pad = fifo->ring_size - (head & (fifo->ring_size - 1));
+		if (pad >= bytes + sizeof(u32))
+			pad = 0;
+
+		/* the consumer may write anything, in doubt the ring is full */
+		used = head - smp_load_acquire(&ctrl->tail);
+		if (used > fifo->ring_size ||
+		    fifo->ring_size - used < pad + bytes + sizeof(u32)) {
+			axis_fifo_drop_packet(fifo, bytes / sizeof(u32));
+			ctrl->dropped++;
+			continue;
+		}
+
+		if (pad) {
+			*axis_fifo_ring_word(fifo, head) = 0;
+			head += pad;
+		}
+
+		*axis_fifo_ring_word(fifo, head) = bytes;
+		ioread32_rep(fifo->base_addr + XLLF_RDFD_OFFSET,
+			     axis_fifo_ring_word(fifo, head + sizeof(u32)),
+			     bytes / sizeof(u32));
+		head += bytes + sizeof(u32);
+
+		/* publish the packet once its data is written */
+		fifo->ring_head = head;
+		smp_store_release(&ctrl->head, head);
+	}
+}
+
+/* copy the packet at the ring tail to userspace, with read_lock held */
+static ssize_t axis_fifo_ring_read(struct axis_fifo *fifo, char __user *buf,
+				   size_t len)
+{
+	struct axis_fifo_ring_ctrl *ctrl = fifo->ring;
+	u32 head = smp_load_acquire(&ctrl->head);
+	u32 tail = READ_ONCE(ctrl->tail);
+	u32 bytes, room;
+
+	bytes = *axis_fifo_ring_word(fifo, tail);
+	if (!bytes && head != tail) {
+		/* wrap marker */
+		tail += fifo->ring_size - (tail & (fifo->ring_size - 1));
+		bytes = *axis_fifo_ring_word(fifo, tail);
+	}
+
+	/* the ring is writable from userspace, don't trust it */
+	room = fifo->ring_size - (tail & (fifo->ring_size - 1));
+	if (head - tail > fifo->ring_size || head == tail || !bytes ||
+	    bytes % sizeof(u32) || bytes + sizeof(u32) > room ||
+	    bytes + sizeof(u32) > head - tail) {
+		dev_err(fifo->dt_device, "receive ring corrupted - ring will be flushed\n");
+		WRITE_ONCE(ctrl->tail, head);
+		return -EIO;
+	}
+
+	if (bytes > len) {
+		dev_err(fifo->dt_device, "user read buffer too small (available bytes=%u user buffer bytes=%zu)\n",
+			bytes, len);
+		return -EINVAL;
+	}
+
+	if (copy_to_user(buf, axis_fifo_ring_word(fifo, tail + sizeof(u32)),
+			 bytes))
+		return -EFAULT;
+
+	smp_store_release(&ctrl->tail, tail + bytes + sizeof(u32));
+
+	return bytes;
+}
+
+/**
+ * axis_fifo_rx_level() - Get the amount of received data
+ * @fifo: The fifo.
+ *
+ * Returns the number of words waiting in the receive fifo or ring.
+ */
+static unsigned int axis_fifo_rx_level(struct axis_fifo *fifo)
+{
+	struct axis_fifo_ring_ctrl *ctrl = fifo->ring;
+	u32 used;
+
+	if (!fifo->ring)
+		return ioread32(fifo->base_addr + XLLF_RDFO_OFFSET);
+
+	used = smp_load_acquire(&ctrl->head) - READ_ONCE(ctrl->tail);
+
+	return min(used, fifo->ring_size) / sizeof(u32);
+}
+
+/**
+ * axis_fifo_rx_avail() - Check if a packet can be read
+ * @fifo: The fifo.
+ *
+ * Returns true if a packet is waiting in the receive fifo or ring.
+ */
+static bool axis_fifo_rx_avail(struct axis_fifo *fifo)
+{
+	if (fifo->ring)
+		return !axis_fifo_ring_empty(fifo);
+
+	return ioread32(fifo->base_addr + XLLF_RDFO_OFFSET);
+}
+
+/**
+ * axis_fifo_rx_packet() - Read a packet with the read lock held.
+ * @fifo: The fifo.
  * @buf: User space buffer to read to.
  * @len: User space buffer length.
- * @off: Buffer offset.
+ * @wait: Wait for a packet, as configured, if none is available.
  *
  * As defined by the device's documentation, we need to check the device's
  * occupancy before reading the length register and then the data. All these
@@ -352,38 +619,25 @@ static void reset_ip_core(struct axis_fifo *fifo)
  * Returns the number of bytes read from the device or negative error code
  *	on failure.
  */
-static ssize_t axis_fifo_read(struct file *f, char __user *buf,
-			      size_t len, loff_t *off)
+static ssize_t axis_fifo_rx_packet(struct axis_fifo *fifo, char __user *buf,
+				   size_t len, bool wait)
 {
-	struct axis_fifo *fifo = (struct axis_fifo *)f->private_data;
 	size_t bytes_available;
 	unsigned int words_available;
 	unsigned int copied;
 	unsigned int copy;
-	unsigned int i;
 	int ret;
 	u32 tmp_buf[READ_BUF_SIZE];
 
-	if (fifo->read_flags & O_NONBLOCK) {
-		/*
-		 * Device opened in non-blocking mode. Try to lock it and then
-		 * check if any packet is available.
-		 */
-		if (!mutex_trylock(&fifo->read_lock))
+	if (!wait) {
+		if (!axis_fifo_rx_avail(fifo))
 			return -EAGAIN;
-
-		if (!ioread32(fifo->base_addr + XLLF_RDFO_OFFSET)) {
-			ret = -EAGAIN;
-			goto end_unlock;
-		}
 	} else {
-		/* opened in blocking mode
-		 * wait for a packet available interrupt (or timeout)
+		/* wait for a packet available interrupt (or timeout)
 		 * if nothing is currently available
 		 */
-		mutex_lock(&fifo->read_lock);
 		ret = wait_event_interruptible_timeout(fifo->read_queue,
-			ioread32(fifo->base_addr + XLLF_RDFO_OFFSET),
+			axis_fifo_rx_avail(fifo),
 				 (read_timeout >= 0) ?
 				  msecs_to_jiffies(read_timeout) :
 				  MAX_SCHEDULE_TIMEOUT);
@@ -396,24 +650,25 @@ static ssize_t axis_fifo_read(struct file *f, char __user *buf,
 					ret);
 			}
 
-			goto end_unlock;
+			return ret;
 		}
 	}
 
+	if (fifo->ring)
+		return axis_fifo_ring_read(fifo, buf, len);
+
 	bytes_available = ioread32(fifo->base_addr + XLLF_RLR_OFFSET);
 	if (!bytes_available) {
 		dev_err(fifo->dt_device, "received a packet of length 0 - fifo core will be reset\n");
 		reset_ip_core(fifo);
-		ret = -EIO;
-		goto end_unlock;
+		return -EIO;
 	}
 
 	if (bytes_available > len) {
 		dev_err(fifo->dt_device, "user read buffer too small (available bytes=%zu user buffer bytes=%zu) - fifo core will be reset\n",
 			bytes_available, len);
 		reset_ip_core(fifo);
-		ret = -EINVAL;
-		goto end_unlock;
+		return -EINVAL;
 	}
 
 	if (bytes_available % sizeof(u32)) {
@@ -422,8 +677,7 @@ static ssize_t axis_fifo_read(struct file *f, char __user *buf,
 		 */
 		dev_err(fifo->dt_device, "received a packet that isn't word-aligned - fifo core will be reset\n");
 		reset_ip_core(fifo);
-		ret = -EIO;
-		goto end_unlock;
+		return -EIO;
 	}
 
 	words_available = bytes_available / sizeof(u32);
@@ -435,36 +689,138 @@ static ssize_t axis_fifo_read(struct file *f, char __user *buf,
 	while (words_available > 0) {
 		copy = min(words_available, READ_BUF_SIZE);
 
-		for (i = 0; i < copy; i++) {
-			tmp_buf[i] = ioread32(fifo->base_addr +
-					      XLLF_RDFD_OFFSET);
-		}
+		ioread32_rep(fifo->base_addr + XLLF_RDFD_OFFSET, tmp_buf,
+			     copy);
 
 		if (copy_to_user(buf + copied * sizeof(u32), tmp_buf,
 				 copy * sizeof(u32))) {
 			reset_ip_core(fifo);
-			ret = -EFAULT;
-			goto end_unlock;
+			return -EFAULT;
 		}
 
 		copied += copy;
 		words_available -= copy;
 	}
 
-	ret = bytes_available;
+	return bytes_available;
+}
+
+/**
+ * axis_fifo_read_lock() - Take the read lock as the file mode allows.
+ * @fifo: The fifo.
+ *
+ * Returns 0 once locked or -EAGAIN in non-blocking mode.
+ */
+static int axis_fifo_read_lock(struct axis_fifo *fifo)
+{
+	if (fifo->read_flags & O_NONBLOCK) {
+		if (!mutex_trylock(&fifo->read_lock))
+			return -EAGAIN;
+	} else {
+		mutex_lock(&fifo->read_lock);
+	}
+
+	return 0;
+}
+
+/**
+ * axis_fifo_read() - Read a packet from AXIS-FIFO character device.
+ * @f: Open file.
+ * @buf: User space buffer to read to.
+ * @len: User space buffer length.
+ * @off: Buffer offset.
+ *
+ * Returns the number of bytes read from the device or negative error code
+ *	on failure.
+ */
+static ssize_t axis_fifo_read(struct file *f, char __user *buf,
+			      size_t len, loff_t *off)
+{
+	struct axis_fifo *fifo = (struct axis_fifo *)f->private_data;
+	ssize_t ret;
+
+	ret = axis_fifo_read_lock(fifo);
+	if (ret)
+		return ret;
+
+	ret = axis_fifo_rx_packet(fifo, buf, len,
+				  !(fifo->read_flags & O_NONBLOCK));
 
-end_unlock:
 	mutex_unlock(&fifo->read_lock);
 
 	return ret;
 }
 
+/* current segment of an iovec or ubuf iterator */
+static struct iovec axis_fifo_iter_seg(const struct iov_iter *iter)
+{
+	if (iter_is_ubuf(iter))
+		return (struct iovec) {
+			.iov_base = iter->ubuf + iter->iov_offset,
+			.iov_len = iter->count,
+		};
+
+	return iov_iter_iovec(iter);
+}
+
 /**
- * axis_fifo_write() - Write buffer to AXIS-FIFO character device.
- * @f: Open file.
+ * axis_fifo_read_iter() - Read packets from AXIS-FIFO character device.
+ * @iocb: The I/O control block.
+ * @to: The user space buffers to read to.
+ *
+ * Each buffer receives one packet. Only the first packet is waited for, as
+ * read() would, and reading stops when no more packets are available or
+ * after a packet shorter than its buffer, so that the length of each packet
+ * can be told from the returned length.
+ *
+ * Returns the number of bytes read from the device or negative error code
+ *	on failure.
+ */
+static ssize_t axis_fifo_read_iter(struct kiocb *iocb, struct iov_iter *to)
+{
+	struct axis_fifo *fifo = iocb->ki_filp->private_data;
+	bool wait = !(fifo->read_flags & O_NONBLOCK);
+	size_t total = 0;
+	struct iovec iov;
+	ssize_t ret;
+
+	if (!iter_is_iovec(to) && !iter_is_ubuf(to))
+		return -EINVAL;
+
+	ret = axis_fifo_read_lock(fifo);
+	if (ret)
+		return ret;
+
+	while (iov_iter_count(to)) {
+		iov = axis_fifo_iter_seg(to);
+		if (!iov.iov_len) {
+			iov_iter_advance(to, 0);
+			continue;
+		}
+
+		ret = axis_fifo_rx_packet(fifo, iov.iov_base, iov.iov_len,
+					  wait);
+		if (ret < 0)
+			break;
+
+		total += ret;
+		wait = false;
+		if (ret < iov.iov_len)
+			break;
+		iov_iter_advance(to, ret);
+	}
+
+	mutex_unlock(&fifo->read_lock);
+
+	return total ? total : ret;
+}
+
+/**
+ * axis_fifo_tx_packet() - Write a packet with the write lock held.
+ * @fifo: The fifo.
  * @buf: User space buffer to write to the device.
  * @len: User space buffer length.
- * @off: Buffer offset.
+ * @wait: Wait for room, as configured, if there isn't enough.
  *
  * As defined by the device's documentation, we need to write to the device's
  * data buffer then to the device's packet length register atomically. Also,
@@ -474,14 +830,13 @@ static ssize_t axis_fifo_read(struct file *f, char __user *buf,
  * Returns the number of bytes written to the device or negative error code
  *	on failure.
  */
-static ssize_t axis_fifo_write(struct file *f, const char __user *buf,
-			       size_t len, loff_t *off)
+static ssize_t axis_fifo_tx_packet(struct axis_fifo *fifo,
+				   const char __user *buf, size_t len,
+				   bool wait)
 {
-	struct axis_fifo *fifo = (struct axis_fifo *)f->private_data;
 	unsigned int words_to_write;
 	unsigned int copied;
 	unsigned int copy;
-	unsigned int i;
 	int ret;
 	u32 tmp_buf[WRITE_BUF_SIZE];
 
@@ -505,26 +860,14 @@ static ssize_t axis_fifo_write(struct file *f, const char __user *buf,
 		return -EINVAL;
 	}
 
-	if (fifo->write_flags & O_NONBLOCK) {
-		/*
-		 * Device opened in non-blocking mode. Try to lock it and then
-		 * check if there is any room to write the given buffer.
-		 */
-		if (!mutex_trylock(&fifo->write_lock))
-			return -EAGAIN;
-
+	if (!wait) {
 		if (words_to_write > ioread32(fifo->base_addr +
-					      XLLF_TDFV_OFFSET)) {
-			ret = -EAGAIN;
-			goto end_unlock;
-		}
+					      XLLF_TDFV_OFFSET))
+			return -EAGAIN;
 	} else {
-		/* opened in blocking mode */
-
 		/* wait for an interrupt (or timeout) if there isn't
 		 * currently enough room in the fifo
 		 */
-		mutex_lock(&fifo->write_lock);
 		ret = wait_event_interruptible_timeout(fifo->write_queue,
 			ioread32(fifo->base_addr + XLLF_TDFV_OFFSET)
 				 >= words_to_write,
@@ -540,7 +883,7 @@ static ssize_t axis_fifo_write(struct file *f, const char __user *buf,
 					ret);
 			}
 
-			goto end_unlock;
+			return ret;
 		}
 	}
 
@@ -554,13 +897,11 @@ static ssize_t axis_fifo_write(struct file *f, const char __user *buf,
 		if (copy_from_user(tmp_buf, buf + copied * sizeof(u32),
 				   copy * sizeof(u32))) {
 			reset_ip_core(fifo);
-			ret = -EFAULT;
-			goto end_unlock;
+			return -EFAULT;
 		}
 
-		for (i = 0; i < copy; i++)
-			iowrite32(tmp_buf[i], fifo->base_addr +
-				  XLLF_TDFD_OFFSET);
+		iowrite32_rep(fifo->base_addr + XLLF_TDFD_OFFSET, tmp_buf,
+			      copy);
 
 		copied += copy;
 		words_to_write -= copy;
@@ -571,16 +912,167 @@ static ssize_t axis_fifo_write(struct file *f, const char __user *buf,
 	/* write packet size to fifo */
 	iowrite32(ret, fifo->base_addr + XLLF_TLR_OFFSET);
 
-end_unlock:
+	return ret;
+}
+
+/**
+ * axis_fifo_write_lock() - Take the write lock as the file mode allows.
+ * @fifo: The fifo.
+ *
+ * Returns 0 once locked or -EAGAIN in non-blocking mode.
+ */
+static int axis_fifo_write_lock(struct axis_fifo *fifo)
+{
+	if (fifo->write_flags & O_NONBLOCK) {
+		if (!mutex_trylock(&fifo->write_lock))
+			return -EAGAIN;
+	} else {
+		mutex_lock(&fifo->write_lock);
+	}
+
+	return 0;
+}
+
+/**
+ * axis_fifo_write() - Write buffer to AXIS-FIFO character device.
+ * @f: Open file.
+ * @buf: User space buffer to write to the device.
+ * @len: User space buffer length.
+ * @off: Buffer offset.
+ *
+ * Returns the number of bytes written to the device or negative error code
+ *	on failure.
+ */
+static ssize_t axis_fifo_write(struct file *f, const char __user *buf,
+			       size_t len, loff_t *off)
+{
+	struct axis_fifo *fifo = (struct axis_fifo *)f->private_data;
+	ssize_t ret;
+
+	ret = axis_fifo_write_lock(fifo);
+	if (ret)
+		return ret;
+
+	ret = axis_fifo_tx_packet(fifo, buf, len,
+				  !(fifo->write_flags & O_NONBLOCK));
+
 	mutex_unlock(&fifo->write_lock);
 
 	return ret;
 }
 
+/**
+ * axis_fifo_write_iter() - Write packets to AXIS-FIFO character device.
+ * @iocb: The I/O control block.
+ * @from: The user space buffers to write to the device.
+ *
+ * Each buffer is sent as one packet, writing stops at the first packet
+ * which can't be sent.
+ *
+ * Returns the number of bytes written to the device or negative error code
+ *	on failure.
+ */
+static ssize_t axis_fifo_write_iter(struct kiocb *iocb, struct iov_iter *from)
+{
+	struct axis_fifo *fifo = iocb->ki_filp->private_data;
+	bool wait = !(fifo->write_flags & O_NONBLOCK);
+	size_t total = 0;
+	struct iovec iov;
+	ssize_t ret;
+
+	if (!iter_is_iovec(from) && !iter_is_ubuf(from))
+		return -EINVAL;
+
+	ret = axis_fifo_write_lock(fifo);
+	if (ret)
+		return ret;
+
+	while (iov_iter_count(from)) {
+		iov = axis_fifo_iter_seg(from);
+		if (!iov.iov_len) {
+			iov_iter_advance(from, 0);
+			continue;
+		}
+
+		ret = axis_fifo_tx_packet(fifo, iov.iov_base, iov.iov_len,
+					  wait);
+		if (ret < 0)
+			break;
+
+		total += ret;
+		iov_iter_advance(from, ret);
+	}
+
+	mutex_unlock(&fifo->write_lock);
+
+	return total ? total : ret;
+}
+
+/*
+ * poll() reports the fifo readable once rx_threshold words have been
+ * received and writable once tx_threshold words are free, and pollers are
+ * woken up only then, so that an event loop isn't woken for every packet.
+ */
+static __poll_t axis_fifo_poll(struct file *f, poll_table *wait)
+{
+	struct axis_fifo *fifo = (struct axis_fifo *)f->private_data;
+	__poll_t mask = 0;
+
+	poll_wait(f, &fifo->poll_queue, wait);
+
+	if ((f->f_mode & FMODE_READ) &&
+	    axis_fifo_rx_level(fifo) >= READ_ONCE(fifo->rx_threshold))
+		mask |= EPOLLIN | EPOLLRDNORM;
+
+	if ((f->f_mode & FMODE_WRITE) &&
+	    ioread32(fifo->base_addr + XLLF_TDFV_OFFSET) >=
+	    READ_ONCE(fifo->tx_threshold))
+		mask |= EPOLLOUT | EPOLLWRNORM;
+
+	return mask;
+}
+
+static int axis_fifo_mmap(struct file *f, struct vm_area_struct *vma)
+{
+	struct axis_fifo *fifo = (struct axis_fifo *)f->private_data;
+
+	if (!fifo->ring || !(f->f_mode & FMODE_READ))
+		return -ENODEV;
+
+	if (vma->vm_pgoff ||
+	    vma->vm_end - vma->vm_start != PAGE_SIZE + fifo->ring_size)
+		return -EINVAL;
+
+	return remap_vmalloc_range(vma, fifo->ring, 0);
+}
+
+static void axis_fifo_wake_pollers(struct axis_fifo *fifo)
+{
+	if (!wq_has_sleeper(&fifo->poll_queue))
+		return;
+
+	if (axis_fifo_rx_level(fifo) >= READ_ONCE(fifo->rx_threshold) ||
+	    ioread32(fifo->base_addr + XLLF_TDFV_OFFSET) >=
+	    READ_ONCE(fifo->tx_threshold))
+		wake_up(&fifo->poll_queue);
+}
+
+static irqreturn_t axis_fifo_irq_thread(int irq, void *dw)
+{
+	struct axis_fifo *fifo = (struct axis_fifo *)dw;
+
+	axis_fifo_ring_fill(fifo);
+	wake_up(&fifo->read_queue);
+	axis_fifo_wake_pollers(fifo);
+
+	return IRQ_HANDLED;
+}
+
 static irqreturn_t axis_fifo_irq(int irq, void *dw)
 {
 	struct axis_fifo *fifo = (struct axis_fifo *)dw;
 	unsigned int pending_interrupts;
+	irqreturn_t ret = IRQ_HANDLED;
 
 	do {
 		pending_interrupts = ioread32(fifo->base_addr +
@@ -590,8 +1082,15 @@ static irqreturn_t axis_fifo_irq(int irq, void *dw)
 		if (pending_interrupts & XLLF_INT_RC_MASK) {
 			/* packet received */
 
-			/* wake the reader process if it is waiting */
-			wake_up(&fifo->read_queue);
+			/* drain it into the ring, or wake the reader process
+			 * if it is waiting
+			 */
+			if (fifo->ring) {
+				ret = IRQ_WAKE_THREAD;
+			} else {
+				wake_up(&fifo->read_queue);
+				axis_fifo_wake_pollers(fifo);
+			}
 
 			/* clear interrupt */
 			iowrite32(XLLF_INT_RC_MASK & XLLF_INT_ALL_MASK,
@@ -601,6 +1100,7 @@ static irqreturn_t axis_fifo_irq(int irq, void *dw)
 
 			/* wake the writer process if it is waiting */
 			wake_up(&fifo->write_queue);
+			axis_fifo_wake_pollers(fifo);
 
 			iowrite32(XLLF_INT_TC_MASK & XLLF_INT_ALL_MASK,
 				  fifo->base_addr + XLLF_ISR_OFFSET);
@@ -680,7 +1180,7 @@ static irqreturn_t axis_fifo_irq(int irq, void *dw)
 		}
 	} while (pending_interrupts);
 
-	return IRQ_HANDLED;
+	return ret;
 }
 
 static int axis_fifo_open(struct inode *inod, struct file *f)
@@ -724,7 +1224,11 @@ static const struct file_operations fops = {
 	.open = axis_fifo_open,
 	.release = axis_fifo_close,
 	.read = axis_fifo_read,
-	.write = axis_fifo_write
+	.write = axis_fifo_write,
+	.read_iter = axis_fifo_read_iter,
+	.write_iter = axis_fifo_write_iter,
+	.poll = axis_fifo_poll,
+	.mmap = axis_fifo_mmap,
 };
 
 /* read named property from the device tree */
@@ -807,6 +1311,37 @@ static int axis_fifo_parse_dt(struct axis_fifo *fifo)
 	return ret;
 }
 
+static void axis_fifo_ring_free(void *ring)
+{
+	vfree(ring);
+}
+
+/* allocate the receive ring if enabled, freed after the interrupt */
+static int axis_fifo_ring_init(struct axis_fifo *fifo)
+{
+	struct axis_fifo_ring_ctrl *ctrl;
+	unsigned int size;
+
+	if (!rx_ring_size || !fifo->has_rx_fifo)
+		return 0;
+
+	/* make room for at least two full fifos */
+	size = max_t(unsigned int, rx_ring_size,
+		     2 * (fifo->rx_fifo_depth + 1) * sizeof(u32));
+	size = roundup_pow_of_two(PAGE_ALIGN(size));
+
+	fifo->ring = vmalloc_user(PAGE_SIZE + size);
+	if (!fifo->ring)
+		return -ENOMEM;
+	fifo->ring_size = size;
+
+	ctrl = fifo->ring;
+	ctrl->size = size;
+
+	return devm_add_action_or_reset(fifo->dt_device, axis_fifo_ring_free,
+					fifo->ring);
+}
+
 static int axis_fifo_probe(struct platform_device *pdev)
 {
 	struct resource *r_mem; /* IO mem resources */
@@ -834,6 +1369,9 @@ static int axis_fifo_probe(struct platform_device *pdev)
 
 	init_waitqueue_head(&fifo->read_queue);
 	init_waitqueue_head(&fifo->write_queue);
+	init_waitqueue_head(&fifo->poll_queue);
+	fifo->rx_threshold = 1;
+	fifo->tx_threshold = 1;
 
 	mutex_init(&fifo->read_lock);
 	mutex_init(&fifo->write_lock);
@@ -875,6 +1413,10 @@ static int axis_fifo_probe(struct platform_device *pdev)
 
 	reset_ip_core(fifo);
 
+	rc = axis_fifo_ring_init(fifo);
+	if (rc)
+		goto err_initial;
+
 	/* ----------------------------
 	 *    init device interrupts
 	 * ----------------------------
@@ -887,8 +1429,10 @@ static int axis_fifo_probe(struct platform_device *pdev)
 
 	/* request IRQ */
 	fifo->irq = rc;
-	rc = devm_request_irq(fifo->dt_device, fifo->irq, &axis_fifo_irq, 0,
-			      DRIVER_NAME, fifo);
+	rc = devm_request_threaded_irq(fifo->dt_device, fifo->irq,
+				       &axis_fifo_irq,
+				       fifo->ring ? &axis_fifo_irq_thread : NULL,
+				       0, DRIVER_NAME, fifo);
 	if (rc) {
 		dev_err(fifo->dt_device, "couldn't allocate interrupt %i\n",
 			fifo->irq);
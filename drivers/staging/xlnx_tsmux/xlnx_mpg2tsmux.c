@@ -55,6 +55,10 @@
 #define XTSMUX_POOL_ALIGN		256
 #define XTSMUX_STRMBL_FREE		0
 #define XTSMUX_STRMBL_BUSY		1
+/* Number of dma-bufs kept imported for MPG2MUX_DMABUF_IMPORT */
+#define XTSMUX_DMABUF_CACHE_MAX		32
+/* dmabuf_id of a stream context using an imported dma-buf */
+#define XTSMUX_DMABUF_IMPORTED		0xffff
 
 /**
  * struct stream_context - struct to enqueue a stream context descriptor
@@ -209,6 +213,28 @@ struct xlnx_tsmux_dmabufintl {
 	u16 buf_id;
 };
 
+/**
+ * struct xlnx_tsmux_dmabuf_import - dma buf imported by the driver
+ * @dbuf: reference to a buffer's dmabuf struct, NULL for a free entry
+ * @attach: attachment to the buffer's dmabuf
+ * @sgt: scatterlist info for the buffer's dmabuf
+ * @dmabuf_addr: buffer physical address
+ * @size: buffer size in bytes
+ * @dir: mapping direction
+ * @users: number of queued contexts using the buffer
+ * @last_use: import sequence number of the last use, for eviction
+ */
+struct xlnx_tsmux_dmabuf_import {
+	struct dma_buf *dbuf;
+	struct dma_buf_attachment *attach;
+	struct sg_table *sgt;
+	dma_addr_t dmabuf_addr;
+	size_t size;
+	enum dma_data_direction dir;
+	u32 users;
+	u64 last_use;
+};
+
 /**
  * struct xlnx_tsmux - xilinx mpeg2 TS muxer device
  * @dev: pointer to struct device instance used by the driver
@@ -244,6 +270,9 @@ struct xlnx_tsmux_dmabufintl {
  * @dst_dmabufintl: array of src DMA buf allocated by user
  * @outbuf_written: size in bytes written in output buffer
  * @stream_count: stream count
+ * @import_lock: mutex to serialize dma buf import and eviction
+ * @imports: dma bufs imported for MPG2MUX_DMABUF_IMPORT
+ * @import_seq: sequence number of the last import
  */
 struct xlnx_tsmux {
 	struct device *dev;
@@ -280,6 +309,10 @@ struct xlnx_tsmux {
 	struct xlnx_tsmux_dmabufintl dst_dmabufintl[XTSMUX_MAXOUT_STRM];
 	s32 outbuf_written;
 	atomic_t stream_count;
+	/* import_lock is used to serialize changes to imports */
+	struct mutex import_lock;
+	struct xlnx_tsmux_dmabuf_import imports[XTSMUX_DMABUF_CACHE_MAX];
+	u64 import_seq;
 };
 
 static inline u32 xlnx_tsmux_read(const struct xlnx_tsmux *mpgmuxts,
@@ -365,6 +398,170 @@ static enum xlnx_tsmux_status xlnx_tsmux_get_status(const struct
 	return MPG2MUX_READY;
 }
 
+static void xlnx_tsmux_dmabuf_evict(struct xlnx_tsmux *mpgmuxts,
+				    struct xlnx_tsmux_dmabuf_import *imp)
+{
+	struct xlnx_tsmux_dmabuf_import old;
+	unsigned long flags;
+
+	spin_lock_irqsave(&mpgmuxts->lock, flags);
+	old = *imp;
+	imp->dbuf = NULL;
+	spin_unlock_irqrestore(&mpgmuxts->lock, flags);
+
+	dma_buf_unmap_attachment(old.attach, old.sgt, old.dir);
+	dma_buf_detach(old.dbuf, old.attach);
+	dma_buf_put(old.dbuf);
+}
+
+/**
+ * xlnx_tsmux_dmabuf_import - get the address of a dma-buf for a context
+ * @mpgmuxts: pointer to the device structure
+ * @fd: dma-buf file descriptor
+ * @dir: direction of the transfer
+ * @addr: returns the buffer physical address
+ * @size: returns the buffer size
+ *
+ * Buffers stay attached and mapped after their context completes, so the
+ * buffers cycling between the encoder and the muxer are only imported the
+ * first time they are seen. The least recently used idle buffer is
+ * evicted when all entries are taken.
+ *
+ * Return: 0 on success and error value on failure.
+ */
+static int xlnx_tsmux_dmabuf_import(struct xlnx_tsmux *mpgmuxts, int fd,
+				    enum dma_data_direction dir,
+				    dma_addr_t *addr, size_t *size)
+{
+	struct xlnx_tsmux_dmabuf_import *imp, *free = NULL, *victim = NULL;
+	struct dma_buf_attachment *attach;
+	struct sg_table *sgt;
+	struct dma_buf *dbuf;
+	unsigned long flags;
+	int ret = 0;
+	u32 i;
+
+	dbuf = dma_buf_get(fd);
+	if (IS_ERR(dbuf)) {
+		dev_dbg(mpgmuxts->dev, "dma_buf_get fail fd %d", fd);
+		return PTR_ERR(dbuf);
+	}
+
+	mutex_lock(&mpgmuxts->import_lock);
+	for (i = 0; i < XTSMUX_DMABUF_CACHE_MAX; i++) {
+		imp = &mpgmuxts->imports[i];
+		if (!imp->dbuf) {
+			if (!free)
+				free = imp;
+			continue;
+		}
+		if (imp->dbuf == dbuf && imp->dir == dir) {
+			dma_buf_put(dbuf);
+			goto found;
+		}
+		/* users only drops outside of import_lock */
+		if (!READ_ONCE(imp->users) &&
+		    (!victim || imp->last_use < victim->last_use))
+			victim = imp;
+	}
+
+	if (!free) {
+		if (!victim) {
+			dev_dbg(mpgmuxts->dev, "all %d dma bufs are in use",
+				XTSMUX_DMABUF_CACHE_MAX);
+			ret = -EBUSY;
+			goto err_put;
+		}
+		xlnx_tsmux_dmabuf_evict(mpgmuxts, victim);
+		free = victim;
+	}
+
+	attach = dma_buf_attach(dbuf, mpgmuxts->dev);
+	if (IS_ERR(attach)) {
+		dev_err(mpgmuxts->dev, "dma_buf_attach fail fd %d", fd);
+		ret = PTR_ERR(attach);
+		goto err_put;
+	}
+
+	sgt = dma_buf_map_attachment(attach, dir);
+	if (IS_ERR(sgt)) {
+		dev_err(mpgmuxts->dev, "dma_buf_map_attach fail fd %d", fd);
+		ret = PTR_ERR(sgt);
+		goto err_detach;
+	}
+
+	if (sgt->nents > 1) {
+		dev_dbg(mpgmuxts->dev, "Not contig nents %d fd %d",
+			sgt->nents, fd);
+		ret = -EIO;
+		goto err_unmap;
+	}
+
+	imp = free;
+	spin_lock_irqsave(&mpgmuxts->lock, flags);
+	imp->attach = attach;
+	imp->sgt = sgt;
+	imp->dmabuf_addr = sg_dma_address(sgt->sgl);
+	imp->size = dbuf->size;
+	imp->dir = dir;
+	imp->users = 0;
+	imp->dbuf = dbuf;
+	spin_unlock_irqrestore(&mpgmuxts->lock, flags);
+
+found:
+	spin_lock_irqsave(&mpgmuxts->lock, flags);
+	imp->users++;
+	spin_unlock_irqrestore(&mpgmuxts->lock, flags);
+	imp->last_use = ++mpgmuxts->import_seq;
+	*addr = imp->dmabuf_addr;
+	*size = imp->size;
+	mutex_unlock(&mpgmuxts->import_lock);
+
+	return 0;
+
+err_unmap:
+	dma_buf_unmap_attachment(attach, sgt, dir);
+err_detach:
+	dma_buf_detach(dbuf, attach);
+err_put:
+	mutex_unlock(&mpgmuxts->import_lock);
+	dma_buf_put(dbuf);
+
+	return ret;
+}
+
+/* Called with lock held when a context using an imported buf is done */
+static void xlnx_tsmux_dmabuf_unuse(struct xlnx_tsmux *mpgmuxts, u64 addr,
+				    enum dma_data_direction dir)
+{
+	struct xlnx_tsmux_dmabuf_import *imp;
+	u32 i;
+
+	for (i = 0; i < XTSMUX_DMABUF_CACHE_MAX; i++) {
+		imp = &mpgmuxts->imports[i];
+		if (imp->dbuf && imp->users && imp->dir == dir &&
+		    addr >= imp->dmabuf_addr &&
+		    addr < imp->dmabuf_addr + imp->size) {
+			imp->users--;
+			return;
+		}
+	}
+}
+
+static void xlnx_tsmux_dmabuf_flush(struct xlnx_tsmux *mpgmuxts)
+{
+	struct xlnx_tsmux_dmabuf_import *imp;
+	u32 i;
+
+	mutex_lock(&mpgmuxts->import_lock);
+	for (i = 0; i < XTSMUX_DMABUF_CACHE_MAX; i++) {
+		imp = &mpgmuxts->imports[i];
+		if (imp->dbuf && !READ_ONCE(imp->users))
+			xlnx_tsmux_dmabuf_evict(mpgmuxts, imp);
+	}
+	mutex_unlock(&mpgmuxts->import_lock);
+}
+
 static struct class *xlnx_tsmux_class;
 static dev_t xlnx_tsmux_devt;
 static atomic_t xlnx_tsmux_ndevs = ATOMIC_INIT(0);
@@ -390,6 +587,9 @@ static int xlnx_tsmux_release(struct inode *pin, struct file *fptr)
 	if (!mpgtsmux)
 		return -EIO;
 
+	if (atomic_dec_and_test(&mpgtsmux->user_count))
+		xlnx_tsmux_dmabuf_flush(mpgtsmux);
+
 	return 0;
 }
 
@@ -681,8 +881,10 @@ static int xlnx_tsmux_enqueue_stream_context(struct xlnx_tsmux *mpgmuxts,
 {
 	struct stream_context_node *new_strm_node, *prev_strm_node;
 	void *kaddr_strm_node;
-	dma_addr_t strm_phy_addr;
+	dma_addr_t strm_phy_addr, dmabuf_addr;
 	unsigned long flags;
+	size_t dmabuf_size;
+	int ret;
 	u32 i;
 
 	kaddr_strm_node = dma_pool_alloc(mpgmuxts->strm_ctx_pool,
@@ -713,6 +915,26 @@ static int xlnx_tsmux_enqueue_stream_context(struct xlnx_tsmux *mpgmuxts,
 		new_strm_node->element.in_buf_pointer =
 			mpgmuxts->srcbuf_addrs[stream_data->srcbuf_id];
 		new_strm_node->element.dmabuf_id = 0;
+	} else if (stream_data->is_dmabuf == MPG2MUX_DMABUF_IMPORT) {
+		ret = xlnx_tsmux_dmabuf_import(mpgmuxts, stream_data->srcbuf_id,
+					       DMA_TO_DEVICE, &dmabuf_addr,
+					       &dmabuf_size);
+		if (ret) {
+			dma_pool_free(mpgmuxts->strm_ctx_pool, new_strm_node,
+				      strm_phy_addr);
+			return ret;
+		}
+		if (stream_data->size_data_in > dmabuf_size) {
+			spin_lock_irqsave(&mpgmuxts->lock, flags);
+			xlnx_tsmux_dmabuf_unuse(mpgmuxts, dmabuf_addr,
+						DMA_TO_DEVICE);
+			spin_unlock_irqrestore(&mpgmuxts->lock, flags);
+			dma_pool_free(mpgmuxts->strm_ctx_pool, new_strm_node,
+				      strm_phy_addr);
+			return -EINVAL;
+		}
+		new_strm_node->element.in_buf_pointer = dmabuf_addr;
+		new_strm_node->element.dmabuf_id = XTSMUX_DMABUF_IMPORTED;
 	} else {
 		for (i = 0; i < XTSMUX_MAXIN_STRM; i++) {
 			/* Serching dma buf info based on srcbuf_id */
@@ -858,6 +1080,7 @@ static int xlnx_tsmux_ioctl_stop(struct xlnx_tsmux *mpgmuxts)
 {
 	enum xlnx_tsmux_status ip_stat;
 	unsigned long flags;
+	u32 i;
 
 	ip_stat = xlnx_tsmux_get_device_status(mpgmuxts);
 	if (ip_stat != MPG2MUX_READY) {
@@ -872,8 +1095,12 @@ static int xlnx_tsmux_ioctl_stop(struct xlnx_tsmux *mpgmuxts)
 	spin_lock_irqsave(&mpgmuxts->lock, flags);
 	INIT_LIST_HEAD(&mpgmuxts->strm_node);
 	INIT_LIST_HEAD(&mpgmuxts->mux_node);
+	/* Queued contexts are dropped, so are their buffer uses */
+	for (i = 0; i < XTSMUX_DMABUF_CACHE_MAX; i++)
+		mpgmuxts->imports[i].users = 0;
 	spin_unlock_irqrestore(&mpgmuxts->lock, flags);
 	xlnx_tsmux_stop_muxer(mpgmuxts);
+	xlnx_tsmux_dmabuf_flush(mpgmuxts);
 
 	return 0;
 }
@@ -927,8 +1154,10 @@ static int xlnx_tsmux_enqueue_mux_context(struct xlnx_tsmux *mpgmuxts,
 	struct muxer_context *new_mux_node;
 	u32 out_index;
 	void *kaddr_mux_node;
-	dma_addr_t mux_phy_addr;
+	dma_addr_t mux_phy_addr, dmabuf_addr;
 	unsigned long flags;
+	size_t dmabuf_size;
+	int ret;
 	s32 i;
 
 	kaddr_mux_node = dma_pool_alloc(mpgmuxts->mux_ctx_pool,
@@ -952,6 +1181,21 @@ static int xlnx_tsmux_enqueue_mux_context(struct xlnx_tsmux *mpgmuxts,
 			atomic_set(&mpgmuxts->outbuf_idx, 0);
 		else
 			atomic_set(&mpgmuxts->outbuf_idx, 1);
+	} else if (mux_data->is_dmabuf == MPG2MUX_DMABUF_IMPORT) {
+		ret = xlnx_tsmux_dmabuf_import(mpgmuxts, mux_data->dstbuf_id,
+					       DMA_FROM_DEVICE, &dmabuf_addr,
+					       &dmabuf_size);
+		if (ret) {
+			dma_pool_free(mpgmuxts->mux_ctx_pool, new_mux_node,
+				      mux_phy_addr);
+			return ret;
+		}
+		new_mux_node->dst_buf_start_addr = dmabuf_addr;
+		/* Zero size uses the whole buffer */
+		if (mux_data->dmabuf_size && mux_data->dmabuf_size < dmabuf_size)
+			new_mux_node->dst_buf_size = mux_data->dmabuf_size;
+		else
+			new_mux_node->dst_buf_size = dmabuf_size;
 	} else {
 		for (i = 0; i < XTSMUX_MAXOUT_STRM; i++) {
 			if (mux_data->dstbuf_id ==
@@ -1014,6 +1258,51 @@ static int xlnx_tsmux_ioctl_set_mux_context(struct xlnx_tsmux *mpgmuxts,
 	return ret;
 }
 
+static int xlnx_tsmux_ioctl_set_contexts(struct xlnx_tsmux *mpgmuxts,
+					 void __user *arg)
+{
+	struct stream_context_in __user *ustrm;
+	struct muxer_context_in __user *umux;
+	struct mpg2mux_ctx_batch batch;
+	struct stream_context_in strm;
+	struct muxer_context_in mux;
+	int ret = 0;
+
+	if (copy_from_user(&batch, arg, sizeof(batch)))
+		return -EFAULT;
+
+	ustrm = u64_to_user_ptr(batch.strm_ctx);
+	umux = u64_to_user_ptr(batch.mux_ctx);
+
+	for (batch.done_strm = 0; batch.done_strm < batch.num_strm;
+	     batch.done_strm++) {
+		if (copy_from_user(&strm, &ustrm[batch.done_strm],
+				   sizeof(strm))) {
+			ret = -EFAULT;
+			break;
+		}
+		ret = xlnx_tsmux_enqueue_stream_context(mpgmuxts, &strm);
+		if (ret < 0)
+			break;
+	}
+
+	batch.done_mux = 0;
+	for (; !ret && batch.done_mux < batch.num_mux; batch.done_mux++) {
+		if (copy_from_user(&mux, &umux[batch.done_mux], sizeof(mux))) {
+			ret = -EFAULT;
+			break;
+		}
+		ret = xlnx_tsmux_enqueue_mux_context(mpgmuxts, &mux);
+		if (ret < 0)
+			break;
+	}
+
+	if (copy_to_user(arg, &batch, sizeof(batch)))
+		return -EFAULT;
+
+	return ret;
+}
+
 static int xlnx_tsmux_ioctl_verify_dmabuf(struct xlnx_tsmux *mpgmuxts,
 					  void __user *arg)
 {
@@ -1201,6 +1490,9 @@ static long xlnx_tsmux_ioctl(struct file *fptr,
 	case MPG2MUX_VDBUF:
 		ret = xlnx_tsmux_ioctl_verify_dmabuf(mpgmuxts, arg);
 		break;
+	case MPG2MUX_SETCTXS:
+		ret = xlnx_tsmux_ioctl_set_contexts(mpgmuxts, arg);
+		break;
 	default:
 		return -EINVAL;
 	}
@@ -1317,7 +1609,11 @@ static int xlnx_tsmux_update_complete(struct xlnx_tsmux *mpgmuxts)
 					 struct stream_context_node, node);
 		list_del(&tstrm_node->node);
 		atomic_dec(&mpgmuxts->stream_count);
-		if (tstrm_node->element.dmabuf_id)
+		if (tstrm_node->element.dmabuf_id == XTSMUX_DMABUF_IMPORTED)
+			xlnx_tsmux_dmabuf_unuse
+				(mpgmuxts, tstrm_node->element.in_buf_pointer,
+				 DMA_TO_DEVICE);
+		else if (tstrm_node->element.dmabuf_id)
 			xlnx_tsmux_free_dmabufintl
 				(mpgmuxts->src_dmabufintl,
 				 tstrm_node->element.dmabuf_id,
@@ -1333,6 +1629,8 @@ static int xlnx_tsmux_update_complete(struct xlnx_tsmux *mpgmuxts)
 	temp_mux = list_first_entry(&mpgmuxts->mux_node, struct muxer_context,
 				    node);
 	mpgmuxts->outbuf_written = temp_mux->dst_buf_written;
+	xlnx_tsmux_dmabuf_unuse(mpgmuxts, temp_mux->dst_buf_start_addr,
+				DMA_FROM_DEVICE);
 
 	list_del(&temp_mux->node);
 	spin_unlock_irqrestore(&mpgmuxts->lock, flags);
@@ -1411,6 +1709,7 @@ static int xlnx_tsmux_probe(struct platform_device *pdev)
 	INIT_LIST_HEAD(&mpgmuxts->strm_node);
 	INIT_LIST_HEAD(&mpgmuxts->mux_node);
 	spin_unlock_irqrestore(&mpgmuxts->lock, flags);
+	mutex_init(&mpgmuxts->import_lock);
 	mpgmuxts->strm_ctx_pool = dma_pool_create("strcxt_pool", mpgmuxts->dev,
 						  XTSMUX_POOL_SIZE,
 						  XTSMUX_POOL_ALIGN,
@@ -1468,6 +1767,7 @@ static int xlnx_tsmux_probe(struct platform_device *pdev)
 		 "Xilinx mpeg2 TS muxer device probe completed");
 
 	atomic_inc(&xlnx_tsmux_ndevs);
+	platform_set_drvdata(pdev, mpgmuxts);
 
 	return 0;
 
@@ -1492,6 +1792,7 @@ static int xlnx_tsmux_remove(struct platform_device *pdev)
 	mpgmuxts = platform_get_drvdata(pdev);
 	if (!mpgmuxts || !xlnx_tsmux_class)
 		return -EIO;
+	xlnx_tsmux_dmabuf_flush(mpgmuxts);
 	dma_pool_destroy(mpgmuxts->mux_ctx_pool);
 	dma_pool_destroy(mpgmuxts->strm_ctx_pool);
 
@@ -1566,3 +1867,4 @@ module_exit(xlnx_tsmux_mod_exit);
 MODULE_AUTHOR("Xilinx Inc.");
 MODULE_DESCRIPTION("Xilinx mpeg2 transport stream muxer IP driver");
 MODULE_LICENSE("GPL v2");
+MODULE_IMPORT_NS(DMA_BUF);
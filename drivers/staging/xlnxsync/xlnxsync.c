@@ -16,6 +16,8 @@
 #include <linux/delay.h>
 #include <linux/device.h>
 #include <linux/dma-buf.h>
+#include <linux/dma-fence.h>
+#include <linux/file.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/ioctl.h>
@@ -24,6 +26,7 @@
 #include <linux/of_irq.h>
 #include <linux/platform_device.h>
 #include <linux/poll.h>
+#include <linux/sync_file.h>
 #include <linux/uaccess.h>
 #include <linux/xlnxsync.h>
 
@@ -128,6 +131,9 @@
 
 #define XLNXSYNC_DEV_MAX		256
 
+/* Number of resolved dma-bufs kept mapped per channel */
+#define XLNXSYNC_DBUF_CACHE_MAX		16
+
 /* Module Parameters */
 static struct class *xlnxsync_class;
 static dev_t xlnxsync_devt;
@@ -193,6 +199,12 @@ struct xlnxsync_device {
  * @cdiff_err: Chroma buffer diff > 1
  * @err_event: Error event per channel
  * @framedone_event: Framebuffer done event per channel
+ * @dbufs: Cache of mapped dma-bufs, most recently used first
+ * @nr_dbufs: Number of entries in @dbufs
+ * @fence_context: First of the fence contexts, one per slot and direction
+ * @fence_seqno: Last fence sequence number per slot and direction
+ * @fences: Fence signalled when the slot completes
+ * @mono: Slot is luma only, so its fence does not wait for chroma
  *
  * This structure contains the syncip channel specific parameters
  */
@@ -215,6 +227,28 @@ struct xlnxsync_channel {
 	u8 cdiff_err : 1;
 	u8 err_event : 1;
 	u8 framedone_event : 1;
+	struct list_head dbufs;
+	u32 nr_dbufs;
+	u64 fence_context;
+	u64 fence_seqno[XLNXSYNC_BUF_PER_CHAN][XLNXSYNC_IO];
+	struct dma_fence *fences[XLNXSYNC_BUF_PER_CHAN][XLNXSYNC_IO];
+	bool mono[XLNXSYNC_BUF_PER_CHAN][XLNXSYNC_IO];
+};
+
+/**
+ * struct xlnxsync_dbuf - dma-buf mapped for a channel
+ * @node: Entry in the channel dma-buf cache
+ * @dbuf: The dma-buf
+ * @attach: Attachment to the synchronizer device
+ * @sgt: Mapped scatterlist
+ * @phy_addr: DMA address of the start of the buffer
+ */
+struct xlnxsync_dbuf {
+	struct list_head node;
+	struct dma_buf *dbuf;
+	struct dma_buf_attachment *attach;
+	struct sg_table *sgt;
+	dma_addr_t phy_addr;
 };
 
 static inline u32 xlnxsync_read(struct xlnxsync_device *dev, u32 chan, u32 reg)
@@ -299,48 +333,170 @@ static void xlnxsync_reset(struct xlnxsync_device *dev)
 		xlnxsync_reset_chan(dev, i);
 }
 
-static dma_addr_t xlnxsync_get_phy_addr(struct xlnxsync_device *dev,
+static void xlnxsync_dbuf_free(struct xlnxsync_dbuf *entry)
+{
+	list_del(&entry->node);
+	dma_buf_unmap_attachment(entry->attach, entry->sgt, DMA_BIDIRECTIONAL);
+	dma_buf_detach(entry->dbuf, entry->attach);
+	dma_buf_put(entry->dbuf);
+	kfree(entry);
+}
+
+static void xlnxsync_dbuf_flush(struct xlnxsync_channel *channel)
+{
+	struct xlnxsync_dbuf *entry, *tmp;
+
+	list_for_each_entry_safe(entry, tmp, &channel->dbufs, node)
+		xlnxsync_dbuf_free(entry);
+	channel->nr_dbufs = 0;
+}
+
+/*
+ * Resolve a dma-buf fd to its DMA address. The mapping is kept in a small
+ * per channel cache so the buffers cycling through a pipeline are only
+ * attached and mapped the first time they are seen.
+ */
+static dma_addr_t xlnxsync_get_phy_addr(struct xlnxsync_channel *channel,
 					u32 fd)
 {
+	struct xlnxsync_device *dev = channel->dev;
+	struct xlnxsync_dbuf *entry;
 	struct dma_buf *dbuf;
-	struct dma_buf_attachment *attach;
-	struct sg_table *sgt;
-	dma_addr_t phy_addr = 0;
 
 	dbuf = dma_buf_get(fd);
 	if (IS_ERR(dbuf)) {
 		dev_err(dev->dev, "%s : Failed to get dma buf\n", __func__);
-		goto get_phy_addr_err;
+		return 0;
 	}
 
-	attach = dma_buf_attach(dbuf, dev->dev);
-	if (IS_ERR(attach)) {
+	list_for_each_entry(entry, &channel->dbufs, node) {
+		if (entry->dbuf == dbuf) {
+			dma_buf_put(dbuf);
+			list_move(&entry->node, &channel->dbufs);
+			return entry->phy_addr;
+		}
+	}
+
+	entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+	if (!entry)
+		goto fail_alloc;
+
+	entry->attach = dma_buf_attach(dbuf, dev->dev);
+	if (IS_ERR(entry->attach)) {
 		dev_err(dev->dev, "%s : Failed to attach buf\n", __func__);
 		goto fail_attach;
 	}
 
-	sgt = dma_buf_map_attachment(attach, DMA_BIDIRECTIONAL);
-	if (IS_ERR(sgt)) {
+	entry->sgt = dma_buf_map_attachment(entry->attach, DMA_BIDIRECTIONAL);
+	if (IS_ERR(entry->sgt)) {
 		dev_err(dev->dev, "%s : Failed to attach map\n", __func__);
 		goto fail_map;
 	}
 
-	phy_addr = sg_dma_address(sgt->sgl);
-	dma_buf_unmap_attachment(attach, sgt, DMA_BIDIRECTIONAL);
+	entry->dbuf = dbuf;
+	entry->phy_addr = sg_dma_address(entry->sgt->sgl);
+
+	if (channel->nr_dbufs == XLNXSYNC_DBUF_CACHE_MAX)
+		xlnxsync_dbuf_free(list_last_entry(&channel->dbufs,
+						   struct xlnxsync_dbuf, node));
+	else
+		channel->nr_dbufs++;
+	list_add(&entry->node, &channel->dbufs);
+
+	return entry->phy_addr;
 
 fail_map:
-	dma_buf_detach(dbuf, attach);
+	dma_buf_detach(dbuf, entry->attach);
 fail_attach:
+	kfree(entry);
+fail_alloc:
 	dma_buf_put(dbuf);
-get_phy_addr_err:
-	return phy_addr;
+	return 0;
 }
 
-static int xlnxsync_chan_config(struct xlnxsync_channel *channel,
-				void __user *arg)
+static const char *xlnxsync_fence_get_driver_name(struct dma_fence *fence)
 {
-	struct xlnxsync_chan_config cfg;
-	int ret, i = 0, j;
+	return XLNXSYNC_DRIVER_NAME;
+}
+
+static const char *xlnxsync_fence_get_timeline_name(struct dma_fence *fence)
+{
+	return "slot";
+}
+
+static const struct dma_fence_ops xlnxsync_fence_ops = {
+	.get_driver_name = xlnxsync_fence_get_driver_name,
+	.get_timeline_name = xlnxsync_fence_get_timeline_name,
+};
+
+/* Must be called with irq_lock held */
+static void xlnxsync_fence_signal(struct xlnxsync_channel *channel,
+				  u32 buf, u32 io, int error)
+{
+	struct dma_fence *fence = channel->fences[buf][io];
+
+	if (!fence)
+		return;
+
+	if (error)
+		dma_fence_set_error(fence, error);
+	dma_fence_signal_locked(fence);
+	dma_fence_put(fence);
+	channel->fences[buf][io] = NULL;
+}
+
+static void xlnxsync_chan_cancel_fences(struct xlnxsync_channel *channel)
+{
+	struct xlnxsync_device *dev = channel->dev;
+	unsigned long flags;
+	u32 i, j;
+
+	spin_lock_irqsave(&dev->irq_lock, flags);
+	for (i = 0; i < XLNXSYNC_BUF_PER_CHAN; i++)
+		for (j = 0; j < XLNXSYNC_IO; j++)
+			xlnxsync_fence_signal(channel, i, j, -ECANCELED);
+	spin_unlock_irqrestore(&dev->irq_lock, flags);
+}
+
+/*
+ * Arm a fence for a slot about to be programmed. The done state of the
+ * slot is cleared so the fence only signals on the new completion.
+ */
+static struct dma_fence *xlnxsync_fence_arm(struct xlnxsync_channel *channel,
+					    u32 buf, u32 io, bool mono)
+{
+	struct xlnxsync_device *dev = channel->dev;
+	struct dma_fence *fence;
+	unsigned long flags;
+
+	fence = kzalloc(sizeof(*fence), GFP_KERNEL);
+	if (!fence)
+		return NULL;
+
+	spin_lock_irqsave(&dev->irq_lock, flags);
+	xlnxsync_fence_signal(channel, buf, io, -ECANCELED);
+	dma_fence_init(fence, &xlnxsync_fence_ops, &dev->irq_lock,
+		       channel->fence_context + buf * XLNXSYNC_IO + io,
+		       ++channel->fence_seqno[buf][io]);
+	channel->fences[buf][io] = dma_fence_get(fence);
+	channel->mono[buf][io] = mono;
+	channel->l_done[buf][io] = false;
+	channel->c_done[buf][io] = false;
+	spin_unlock_irqrestore(&dev->irq_lock, flags);
+
+	return fence;
+}
+
+/*
+ * Program one framebuffer for the producer and the consumer. When @fences
+ * is set, a fence is armed for each programmed slot and returned there.
+ */
+static int xlnxsync_chan_program(struct xlnxsync_channel *channel,
+				 const struct xlnxsync_chan_config *cfg_in,
+				 struct dma_fence **fences)
+{
+	struct xlnxsync_chan_config cfg = *cfg_in;
+	int i = 0, j;
 	dma_addr_t phy_start_address;
 	u64 luma_start_address[XLNXSYNC_IO];
 	u64 chroma_start_address[XLNXSYNC_IO];
@@ -348,12 +504,6 @@ static int xlnxsync_chan_config(struct xlnxsync_channel *channel,
 	u64 chroma_end_address[XLNXSYNC_IO];
 	struct xlnxsync_device *dev = channel->dev;
 
-	ret = copy_from_user(&cfg, arg, sizeof(cfg));
-	if (ret) {
-		dev_err(dev->dev, "%s : Failed to copy from user\n", __func__);
-		return ret;
-	}
-
 	if (cfg.hdr_ver != XLNXSYNC_IOCTL_HDR_VER) {
 		dev_err(dev->dev, "%s : ioctl version mismatch\n", __func__);
 		dev_err(dev->dev,
@@ -363,7 +513,7 @@ static int xlnxsync_chan_config(struct xlnxsync_channel *channel,
 	}
 
 	/* Calculate luma/chroma physical addresses */
-	phy_start_address = xlnxsync_get_phy_addr(dev, cfg.dma_fd);
+	phy_start_address = xlnxsync_get_phy_addr(channel, cfg.dma_fd);
 	if (!phy_start_address) {
 		dev_err(dev->dev, "%s : Failed to obtain physical address\n",
 			__func__);
@@ -473,6 +623,14 @@ static int xlnxsync_chan_config(struct xlnxsync_channel *channel,
 			return -EINVAL;
 		}
 
+		/* Armed before the valid bits give the slot to the IP */
+		if (fences) {
+			fences[j] = xlnxsync_fence_arm(channel, i, j,
+						       cfg.ismono[j]);
+			if (!fences[j])
+				return -ENOMEM;
+		}
+
 		if (j == XLNXSYNC_PROD) {
 			l_start_reg = XLNXSYNC_PL_START_LO_REG;
 			l_end_reg = XLNXSYNC_PL_END_LO_REG;
@@ -557,6 +715,100 @@ static int xlnxsync_chan_config(struct xlnxsync_channel *channel,
 	return 0;
 }
 
+static int xlnxsync_chan_config(struct xlnxsync_channel *channel,
+				void __user *arg)
+{
+	struct xlnxsync_chan_config cfg;
+	struct xlnxsync_device *dev = channel->dev;
+	int ret;
+
+	ret = copy_from_user(&cfg, arg, sizeof(cfg));
+	if (ret) {
+		dev_err(dev->dev, "%s : Failed to copy from user\n", __func__);
+		return ret;
+	}
+
+	return xlnxsync_chan_program(channel, &cfg, NULL);
+}
+
+static int xlnxsync_chan_config_batch(struct xlnxsync_channel *channel,
+				      void __user *arg)
+{
+	struct xlnxsync_device *dev = channel->dev;
+	struct xlnxsync_chan_config_batch batch;
+	struct xlnxsync_chan_config __user *ucfgs;
+	struct xlnxsync_chan_config cfg;
+	struct dma_fence *fences[XLNXSYNC_IO] = { };
+	struct sync_file *sync_file;
+	s32 fds[XLNXSYNC_IO];
+	s32 __user *ufds;
+	int ret = 0, j;
+
+	if (copy_from_user(&batch, arg, sizeof(batch)))
+		return -EFAULT;
+
+	if (batch.hdr_ver != XLNXSYNC_IOCTL_HDR_VER) {
+		dev_err(dev->dev, "%s : ioctl version mismatch\n", __func__);
+		return -EINVAL;
+	}
+
+	if ((batch.flags & ~XLNXSYNC_CONFIG_FENCE_OUT) || batch.reserved)
+		return -EINVAL;
+
+	ucfgs = u64_to_user_ptr(batch.configs);
+	ufds = u64_to_user_ptr(batch.fence_fds);
+
+	for (batch.done = 0; batch.done < batch.count; batch.done++) {
+		bool want_fences = batch.flags & XLNXSYNC_CONFIG_FENCE_OUT;
+
+		if (copy_from_user(&cfg, &ucfgs[batch.done], sizeof(cfg))) {
+			ret = -EFAULT;
+			break;
+		}
+
+		ret = xlnxsync_chan_program(channel, &cfg,
+					    want_fences ? fences : NULL);
+		if (ret || !want_fences)
+			goto next;
+
+		for (j = 0; j < XLNXSYNC_IO; j++) {
+			fds[j] = -1;
+			if (ret)
+				continue;
+			sync_file = sync_file_create(fences[j]);
+			if (!sync_file) {
+				ret = -ENOMEM;
+				continue;
+			}
+			fds[j] = get_unused_fd_flags(O_CLOEXEC);
+			if (fds[j] < 0) {
+				ret = fds[j];
+				fput(sync_file->file);
+				continue;
+			}
+			fd_install(fds[j], sync_file->file);
+		}
+
+		if (!ret && copy_to_user(&ufds[batch.done * XLNXSYNC_IO], fds,
+					 sizeof(fds)))
+			ret = -EFAULT;
+next:
+		/* The fd owns the fence now, drop our reference */
+		for (j = 0; j < XLNXSYNC_IO; j++) {
+			if (fences[j])
+				dma_fence_put(fences[j]);
+			fences[j] = NULL;
+		}
+		if (ret)
+			break;
+	}
+
+	if (copy_to_user(arg, &batch, sizeof(batch)))
+		return -EFAULT;
+
+	return ret;
+}
+
 static int xlnxsync_chan_get_status(struct xlnxsync_channel *channel,
 				    void __user *arg)
 {
@@ -683,6 +935,7 @@ static int xlnxsync_chan_enable(struct xlnxsync_channel *channel, bool enable)
 				channel->c_done[i][j] = false;
 			}
 		}
+		xlnxsync_chan_cancel_fences(channel);
 	}
 
 	return 0;
@@ -970,6 +1223,12 @@ static long xlnxsync_ioctl(struct file *fptr, unsigned int cmd,
 		ret = xlnxsync_reset_slot(channel);
 		mutex_unlock(&channel->mutex);
 		break;
+	case XLNXSYNC_CHAN_SET_CONFIGS:
+		if (mutex_lock_interruptible(&channel->mutex))
+			return -ERESTARTSYS;
+		ret = xlnxsync_chan_config_batch(channel, arg);
+		mutex_unlock(&channel->mutex);
+		break;
 	}
 
 	return ret;
@@ -1057,6 +1316,9 @@ static int xlnxsync_open(struct inode *iptr, struct file *fptr)
 	mutex_init(&chan->mutex);
 	init_waitqueue_head(&chan->wq_fbdone);
 	init_waitqueue_head(&chan->wq_error);
+	INIT_LIST_HEAD(&chan->dbufs);
+	chan->fence_context = dma_fence_context_alloc(XLNXSYNC_BUF_PER_CHAN *
+						      XLNXSYNC_IO);
 	dev->chan_count++;
 	atomic_inc(&dev->user_count);
 	dev_dbg(dev->dev, "%s: tid=%d Opened with user count = %d\n",
@@ -1090,6 +1352,9 @@ static int xlnxsync_release(struct inode *iptr, struct file *fptr)
 			     XLNXSYNC_CTRL_INTR_EN_MASK);
 	}
 
+	xlnxsync_chan_cancel_fences(channel);
+	xlnxsync_dbuf_flush(channel);
+
 	if (mutex_lock_interruptible(&dev->sync_mutex))
 		return -ERESTARTSYS;
 	clear_bit(channel->id, &dev->reserved);
@@ -1194,6 +1459,10 @@ static irqreturn_t xlnxsync_irq_handler(int irq, void *data)
 				if (chan->l_done[i][j] &&
 				    chan->c_done[i][j])
 					chan->framedone_event = true;
+
+				if (chan->l_done[i][j] &&
+				    (chan->c_done[i][j] || chan->mono[i][j]))
+					xlnxsync_fence_signal(chan, i, j, 0);
 			}
 		}
 
@@ -1491,4 +1760,5 @@ module_exit(xlnxsync_cleanup_mod);
 MODULE_AUTHOR("Vishal Sagar");
 MODULE_DESCRIPTION("Xilinx Synchronizer IP Driver");
 MODULE_LICENSE("GPL v2");
+MODULE_IMPORT_NS(DMA_BUF);
 MODULE_VERSION(XLNXSYNC_DRIVER_VERSION);
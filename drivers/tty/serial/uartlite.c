@@ -44,6 +44,7 @@
 #define ULITE_CONTROL		0x0c
 
 #define ULITE_REGION		16
+#define ULITE_FIFO_SIZE		16
 
 #define ULITE_STATUS_RXVALID	0x01
 #define ULITE_STATUS_RXFULL	0x02
@@ -188,6 +189,7 @@ static int ulite_receive(struct uart_port *port, int stat)
 static int ulite_transmit(struct uart_port *port, int stat)
 {
 	struct circ_buf *xmit  = &port->state->xmit;
+	unsigned int room = 1;
 
 	if (stat & ULITE_STATUS_TXFULL)
 		return 0;
@@ -202,9 +204,15 @@ static int ulite_transmit(struct uart_port *port, int stat)
 	if (uart_circ_empty(xmit) || uart_tx_stopped(port))
 		return 0;
 
-	uart_out32(xmit->buf[xmit->tail], ULITE_TX, port);
-	xmit->tail = (xmit->tail + 1) & (UART_XMIT_SIZE-1);
-	port->icount.tx++;
+	/* An empty FIFO takes a whole burst without polling the status */
+	if (stat & ULITE_STATUS_TXEMPTY)
+		room = ULITE_FIFO_SIZE;
+
+	do {
+		uart_out32(xmit->buf[xmit->tail], ULITE_TX, port);
+		xmit->tail = (xmit->tail + 1) & (UART_XMIT_SIZE-1);
+		port->icount.tx++;
+	} while (--room && !uart_circ_empty(xmit));
 
 	/* wake up */
 	if (uart_circ_chars_pending(xmit) < WAKEUP_CHARS)
@@ -216,25 +224,28 @@ static int ulite_transmit(struct uart_port *port, int stat)
 static irqreturn_t ulite_isr(int irq, void *dev_id)
 {
 	struct uart_port *port = dev_id;
-	int stat, busy, n = 0;
+	int stat, rx, busy, n = 0, nrx = 0;
 	unsigned long flags;
 
+	/* Drain the Rx FIFO and fill the Tx FIFO under a single hold of the
+	 * lock, the tty layer is then pushed once for all the received
+	 * characters.
+	 */
+	spin_lock_irqsave(&port->lock, flags);
 	do {
-		spin_lock_irqsave(&port->lock, flags);
 		stat = uart_in32(ULITE_STATUS, port);
-		busy  = ulite_receive(port, stat);
-		busy |= ulite_transmit(port, stat);
-		spin_unlock_irqrestore(&port->lock, flags);
+		rx = ulite_receive(port, stat);
+		busy = rx | ulite_transmit(port, stat);
+		nrx += rx;
 		n++;
 	} while (busy);
+	spin_unlock_irqrestore(&port->lock, flags);
 
-	/* work done? */
-	if (n > 1) {
+	if (nrx)
 		tty_flip_buffer_push(&port->state->port);
-		return IRQ_HANDLED;
-	} else {
-		return IRQ_NONE;
-	}
+
+	/* work done? */
+	return n > 1 ? IRQ_HANDLED : IRQ_NONE;
 }
 
 static unsigned int ulite_tx_empty(struct uart_port *port)
@@ -654,7 +665,7 @@ static int ulite_assign(struct device *dev, int id, phys_addr_t base, int irq,
 	port = &ulite_ports[id];
 
 	spin_lock_init(&port->lock);
-	port->fifosize = 16;
+	port->fifosize = ULITE_FIFO_SIZE;
 	port->regshift = 2;
 	port->iotype = UPIO_MEM;
 	port->iobase = 1; /* mark port in use */
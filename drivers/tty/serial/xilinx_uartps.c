@@ -312,6 +312,54 @@ static void cdns_uart_handle_rx(void *dev_id, unsigned int isrstatus)
 	tty_flip_buffer_push(&port->state->port);
 }
 
+/**
+ * cdns_uart_rx_burst_ok - Check whether the RX FIFO can be read in a burst
+ * @port: Handle to the uart port structure
+ * @isrstatus: The interrupt status register value as read
+ * @rxstatus: The interrupt status filtered by the port status masks
+ *
+ * On an RX trigger interrupt without any error flagged, the first
+ * rx_trigger_level bytes of the FIFO were all received without errors.
+ * A pending break or sysrq still needs the per-byte handling.
+ *
+ * Return: true if these bytes can skip the per-byte status checks
+ */
+static bool cdns_uart_rx_burst_ok(struct uart_port *port,
+				  unsigned int isrstatus,
+				  unsigned int rxstatus)
+{
+	if (!(rxstatus & CDNS_UART_IXR_RXTRIG))
+		return false;
+
+	if (isrstatus & (CDNS_UART_IXR_PARITY | CDNS_UART_IXR_FRAMING |
+			 CDNS_UART_IXR_OVERRUN))
+		return false;
+
+	return !(port->read_status_mask & CDNS_UART_IXR_BRK) && !port->sysrq;
+}
+
+/**
+ * cdns_uart_handle_rx_burst - Read a batch of error free received bytes
+ * @port: Handle to the uart port structure
+ *
+ * Reads rx_trigger_level bytes back to back without polling the status
+ * and byte status registers, and hands them to the tty layer in one go.
+ * The remaining bytes are left to cdns_uart_handle_rx().
+ */
+static void cdns_uart_handle_rx_burst(struct uart_port *port)
+{
+	unsigned int count = min_t(uint, rx_trigger_level,
+				   CDNS_UART_FIFO_SIZE - 1);
+	unsigned char buf[CDNS_UART_FIFO_SIZE];
+	unsigned int i;
+
+	for (i = 0; i < count; i++)
+		buf[i] = readl(port->membase + CDNS_UART_FIFO);
+
+	port->icount.rx += count;
+	tty_insert_flip_string(&port->state->port, buf, count);
+}
+
 /**
  * cdns_uart_handle_tx - Handle the bytes to be Txed.
  * @dev_id: Id of the UART port
@@ -322,15 +370,20 @@ static void cdns_uart_handle_tx(void *dev_id)
 	struct uart_port *port = (struct uart_port *)dev_id;
 	struct circ_buf *xmit = &port->state->xmit;
 	unsigned int numbytes;
+	bool fifo_empty;
 
 	if (uart_circ_empty(xmit)) {
 		writel(CDNS_UART_IXR_TXEMPTY, port->membase + CDNS_UART_IDR);
 		return;
 	}
 
+	/* An empty FIFO takes fifosize bytes without checking for TXFULL */
+	fifo_empty = readl(port->membase + CDNS_UART_SR) & CDNS_UART_SR_TXEMPTY;
+
 	numbytes = port->fifosize;
 	while (numbytes && !uart_circ_empty(xmit) &&
-	       !(readl(port->membase + CDNS_UART_SR) & CDNS_UART_SR_TXFULL)) {
+	       (fifo_empty ||
+		!(readl(port->membase + CDNS_UART_SR) & CDNS_UART_SR_TXFULL))) {
 
 		writel(xmit->buf[xmit->tail], port->membase + CDNS_UART_FIFO);
 
@@ -353,7 +406,7 @@ static void cdns_uart_handle_tx(void *dev_id)
 static irqreturn_t cdns_uart_isr(int irq, void *dev_id)
 {
 	struct uart_port *port = (struct uart_port *)dev_id;
-	unsigned int isrstatus;
+	unsigned int isrstatus, rxstatus;
 
 	spin_lock(&port->lock);
 
@@ -368,15 +421,18 @@ static irqreturn_t cdns_uart_isr(int irq, void *dev_id)
 		isrstatus &= ~CDNS_UART_IXR_TXEMPTY;
 	}
 
-	isrstatus &= port->read_status_mask;
-	isrstatus &= ~port->ignore_status_mask;
+	rxstatus = isrstatus & port->read_status_mask;
+	rxstatus &= ~port->ignore_status_mask;
 	/*
 	 * Skip RX processing if RX is disabled as RXEMPTY will never be set
 	 * as read bytes will not be removed from the FIFO.
 	 */
-	if (isrstatus & CDNS_UART_IXR_RXMASK &&
-	    !(readl(port->membase + CDNS_UART_CR) & CDNS_UART_CR_RX_DIS))
-		cdns_uart_handle_rx(dev_id, isrstatus);
+	if (rxstatus & CDNS_UART_IXR_RXMASK &&
+	    !(readl(port->membase + CDNS_UART_CR) & CDNS_UART_CR_RX_DIS)) {
+		if (cdns_uart_rx_burst_ok(port, isrstatus, rxstatus))
+			cdns_uart_handle_rx_burst(port);
+		cdns_uart_handle_rx(dev_id, rxstatus);
+	}
 
 	spin_unlock(&port->lock);
 	return IRQ_HANDLED;
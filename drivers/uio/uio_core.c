@@ -26,6 +26,7 @@
 #include <linux/uio_driver.h>
 #include <linux/list.h>
 #include <linux/mutex.h>
+#include <linux/eventfd.h>
 
 #include <uapi/linux/uio/uio.h>
 
@@ -428,17 +429,88 @@ static void uio_free_minor(unsigned long minor)
 	mutex_unlock(&minor_lock);
 }
 
+struct uio_listener {
+	struct uio_device *dev;
+	s32 event_count;
+	struct uio_dmabuf_cache dbufs;
+	struct eventfd_ctx *eventfd;
+	struct list_head node;
+};
+
+/* Wake up the listeners of the @count events just counted */
+static void uio_event_deliver(struct uio_device *idev, u32 count)
+{
+	struct uio_listener *listener;
+	unsigned long flags;
+
+	atomic_add(count, &idev->event);
+	wake_up_interruptible(&idev->wait);
+	kill_fasync(&idev->async_queue, SIGIO, POLL_IN);
+
+	spin_lock_irqsave(&idev->irq_lock, flags);
+	list_for_each_entry(listener, &idev->eventfds, node)
+		eventfd_signal(listener->eventfd, count);
+	spin_unlock_irqrestore(&idev->irq_lock, flags);
+}
+
+static enum hrtimer_restart uio_coalesce_timer_fn(struct hrtimer *timer)
+{
+	struct uio_device *idev = container_of(timer, struct uio_device,
+					       coalesce_timer);
+	unsigned long flags;
+	u32 count;
+
+	spin_lock_irqsave(&idev->irq_lock, flags);
+	count = idev->pending;
+	idev->pending = 0;
+	spin_unlock_irqrestore(&idev->irq_lock, flags);
+
+	if (count)
+		uio_event_deliver(idev, count);
+
+	return HRTIMER_NORESTART;
+}
+
+static void uio_reenable_work_fn(struct work_struct *work)
+{
+	struct uio_device *idev = container_of(work, struct uio_device,
+					       reenable_work);
+
+	mutex_lock(&idev->info_lock);
+	if (idev->info && idev->info->irqcontrol)
+		idev->info->irqcontrol(idev->info, 1);
+	mutex_unlock(&idev->info_lock);
+}
+
 /**
  * uio_event_notify - trigger an interrupt event
  * @info: UIO device capabilities
+ *
+ * Listeners are woken up at once unless the interrupt policy of the device
+ * coalesces events, see UIO_IOC_SET_IRQ_POLICY.
  */
 void uio_event_notify(struct uio_info *info)
 {
 	struct uio_device *idev = info->uio_dev;
+	unsigned long flags;
+	u32 count = 0;
+
+	spin_lock_irqsave(&idev->irq_lock, flags);
+	if (++idev->pending >= idev->coalesce_count) {
+		count = idev->pending;
+		idev->pending = 0;
+		hrtimer_try_to_cancel(&idev->coalesce_timer);
+	} else if (idev->coalesce_usecs &&
+		   !hrtimer_active(&idev->coalesce_timer)) {
+		hrtimer_start(&idev->coalesce_timer,
+			      ns_to_ktime((u64)idev->coalesce_usecs *
+					  NSEC_PER_USEC),
+			      HRTIMER_MODE_REL);
+	}
+	spin_unlock_irqrestore(&idev->irq_lock, flags);
 
-	atomic_inc(&idev->event);
-	wake_up_interruptible(&idev->wait);
-	kill_fasync(&idev->async_queue, SIGIO, POLL_IN);
+	if (count)
+		uio_event_deliver(idev, count);
 }
 EXPORT_SYMBOL_GPL(uio_event_notify);
 
@@ -453,18 +525,96 @@ static irqreturn_t uio_interrupt(int irq, void *dev_id)
 	irqreturn_t ret;
 
 	ret = idev->info->handler(irq, idev->info);
-	if (ret == IRQ_HANDLED)
+	if (ret == IRQ_HANDLED) {
 		uio_event_notify(idev->info);
+		if (READ_ONCE(idev->irq_policy) & UIO_IRQ_POLICY_AUTO_REENABLE)
+			schedule_work(&idev->reenable_work);
+	}
 
 	return ret;
 }
 
-struct uio_listener {
-	struct uio_device *dev;
-	s32 event_count;
-	struct list_head dbufs;
-	struct mutex dbufs_lock; /* protect @dbufs */
-};
+static int uio_set_eventfd(struct uio_listener *listener, int __user *argp)
+{
+	struct uio_device *idev = listener->dev;
+	struct eventfd_ctx *ctx = NULL, *old;
+	unsigned long flags;
+	int fd;
+
+	if (get_user(fd, argp))
+		return -EFAULT;
+
+	if (fd >= 0) {
+		ctx = eventfd_ctx_fdget(fd);
+		if (IS_ERR(ctx))
+			return PTR_ERR(ctx);
+	}
+
+	spin_lock_irqsave(&idev->irq_lock, flags);
+	old = listener->eventfd;
+	listener->eventfd = ctx;
+	if (ctx && !old)
+		list_add_tail(&listener->node, &idev->eventfds);
+	else if (!ctx && old)
+		list_del(&listener->node);
+	spin_unlock_irqrestore(&idev->irq_lock, flags);
+
+	if (old)
+		eventfd_ctx_put(old);
+
+	return 0;
+}
+
+static int uio_set_irq_policy(struct uio_device *idev,
+			      struct uio_irq_policy __user *argp)
+{
+	struct uio_irq_policy policy;
+	unsigned long flags;
+	u32 count = 0;
+	int ret = 0;
+
+	if (copy_from_user(&policy, argp, sizeof(policy)))
+		return -EFAULT;
+
+	if (policy.flags & ~(UIO_IRQ_POLICY_AUTO_REENABLE |
+			     UIO_IRQ_POLICY_REENABLE_ON_READ) ||
+	    !policy.coalesce_count || policy.reserved)
+		return -EINVAL;
+
+	mutex_lock(&idev->info_lock);
+	if (!idev->info || !idev->info->irq) {
+		ret = -EIO;
+		goto out;
+	}
+
+	if (policy.flags && !idev->info->irqcontrol) {
+		ret = -ENOSYS;
+		goto out;
+	}
+
+	spin_lock_irqsave(&idev->irq_lock, flags);
+	WRITE_ONCE(idev->irq_policy, policy.flags);
+	idev->coalesce_count = policy.coalesce_count;
+	idev->coalesce_usecs = policy.coalesce_usecs;
+	/* Do not keep events pending under a policy that no longer does */
+	if (idev->pending >= idev->coalesce_count || !idev->coalesce_usecs) {
+		count = idev->pending;
+		idev->pending = 0;
+		hrtimer_try_to_cancel(&idev->coalesce_timer);
+	} else if (idev->pending && !hrtimer_active(&idev->coalesce_timer)) {
+		hrtimer_start(&idev->coalesce_timer,
+			      ns_to_ktime((u64)idev->coalesce_usecs *
+					  NSEC_PER_USEC),
+			      HRTIMER_MODE_REL);
+	}
+	spin_unlock_irqrestore(&idev->irq_lock, flags);
+
+	if (count)
+		uio_event_deliver(idev, count);
+out:
+	mutex_unlock(&idev->info_lock);
+	return ret;
+}
 
 static int uio_open(struct inode *inode, struct file *filep)
 {
@@ -495,6 +645,7 @@ static int uio_open(struct inode *inode, struct file *filep)
 
 	listener->dev = idev;
 	listener->event_count = atomic_read(&idev->event);
+	listener->eventfd = NULL;
 	filep->private_data = listener;
 
 	mutex_lock(&idev->info_lock);
@@ -510,8 +661,7 @@ static int uio_open(struct inode *inode, struct file *filep)
 	if (ret)
 		goto err_infoopen;
 
-	INIT_LIST_HEAD(&listener->dbufs);
-	mutex_init(&listener->dbufs_lock);
+	uio_dmabuf_init(&listener->dbufs);
 
 	return 0;
 
@@ -542,10 +692,17 @@ static int uio_release(struct inode *inode, struct file *filep)
 	struct uio_listener *listener = filep->private_data;
 	struct uio_device *idev = listener->dev;
 
-	ret = uio_dmabuf_cleanup(idev, &listener->dbufs, &listener->dbufs_lock);
+	ret = uio_dmabuf_cleanup(idev, &listener->dbufs);
 	if (ret)
 		dev_err(&idev->dev, "failed to clean up the dma bufs\n");
 
+	if (listener->eventfd) {
+		spin_lock_irq(&idev->irq_lock);
+		list_del(&listener->node);
+		spin_unlock_irq(&idev->irq_lock);
+		eventfd_ctx_put(listener->eventfd);
+	}
+
 	mutex_lock(&idev->info_lock);
 	if (idev->info && idev->info->release)
 		ret = idev->info->release(idev->info, inode);
@@ -611,6 +768,13 @@ static ssize_t uio_read(struct file *filep, char __user *buf,
 				listener->event_count = event_count;
 				retval = count;
 			}
+			if (retval > 0 && (READ_ONCE(idev->irq_policy) &
+					   UIO_IRQ_POLICY_REENABLE_ON_READ)) {
+				mutex_lock(&idev->info_lock);
+				if (idev->info && idev->info->irqcontrol)
+					idev->info->irqcontrol(idev->info, 1);
+				mutex_unlock(&idev->info_lock);
+			}
 			break;
 		}
 
@@ -681,15 +845,31 @@ static long uio_ioctl(struct file *filep, unsigned int cmd, unsigned long arg)
 	switch (cmd) {
 	case UIO_IOC_MAP_DMABUF:
 		ret = uio_dmabuf_map(idev, &listener->dbufs,
-				     &listener->dbufs_lock, (void __user *)arg);
+				     (void __user *)arg);
 		break;
 	case UIO_IOC_UNMAP_DMABUF:
 		ret = uio_dmabuf_unmap(idev, &listener->dbufs,
-				       &listener->dbufs_lock,
 				       (void __user *)arg);
 		break;
+	case UIO_IOC_MAP_DMABUFS:
+		ret = uio_dmabuf_batch(idev, &listener->dbufs,
+				       (void __user *)arg, true);
+		break;
+	case UIO_IOC_UNMAP_DMABUFS:
+		ret = uio_dmabuf_batch(idev, &listener->dbufs,
+				       (void __user *)arg, false);
+		break;
+	case UIO_IOC_SET_EVENTFD:
+		ret = uio_set_eventfd(listener, (int __user *)arg);
+		break;
+	case UIO_IOC_SET_IRQ_POLICY:
+		ret = uio_set_irq_policy(idev, (void __user *)arg);
+		break;
 	default:
-		ret = -EINVAL;
+		if (idev->info->ioctl)
+			ret = idev->info->ioctl(idev->info, cmd, arg);
+		else
+			ret = -EINVAL;
 		break;
 	}
 
@@ -983,6 +1163,12 @@ int __uio_register_device(struct module *owner,
 	mutex_init(&idev->info_lock);
 	init_waitqueue_head(&idev->wait);
 	atomic_set(&idev->event, 0);
+	spin_lock_init(&idev->irq_lock);
+	INIT_LIST_HEAD(&idev->eventfds);
+	idev->coalesce_count = 1;
+	hrtimer_init(&idev->coalesce_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	idev->coalesce_timer.function = uio_coalesce_timer_fn;
+	INIT_WORK(&idev->reenable_work, uio_reenable_work_fn);
 
 	ret = uio_get_minor(idev);
 	if (ret) {
@@ -1104,6 +1290,9 @@ void uio_unregister_device(struct uio_info *info)
 	idev->info = NULL;
 	mutex_unlock(&idev->info_lock);
 
+	hrtimer_cancel(&idev->coalesce_timer);
+	cancel_work_sync(&idev->reenable_work);
+
 	wake_up_interruptible(&idev->wait);
 	kill_fasync(&idev->async_queue, SIGIO, POLL_HUP);
 
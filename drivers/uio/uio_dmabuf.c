@@ -9,77 +9,95 @@
  */
 
 #include <linux/dma-buf.h>
+#include <linux/dma-mapping.h>
+#include <linux/fs.h>
 #include <linux/list.h>
+#include <linux/module.h>
 #include <linux/mutex.h>
 #include <linux/uaccess.h>
 #include <linux/uio_driver.h>
 #include <linux/slab.h>
+#include <linux/xarray.h>
 
 #include <uapi/linux/uio/uio.h>
 
 #include "uio_dmabuf.h"
 
+static unsigned int dmabuf_cache_max = 256;
+module_param(dmabuf_cache_max, uint, 0644);
+MODULE_PARM_DESC(dmabuf_cache_max,
+		 "Maximum number of unmapped dmabufs kept mapped per file");
+
+/**
+ * struct uio_dmabuf_mem - dmabuf mapped for the uio device
+ * @dbuf: the dmabuf
+ * @dbuf_attach: attachment of @dbuf to the uio device
+ * @sgt: mapping of @dbuf
+ * @dir: direction of the mapping
+ * @users: number of maps not unmapped yet
+ * @key: index of the mapping in the cache
+ * @list: entry in the cache idle list, when @users is 0
+ *
+ * The mapping is kept when @users drops to 0 so that mapping the same dmabuf
+ * again only costs a cache sync.
+ */
 struct uio_dmabuf_mem {
-	int dbuf_fd;
 	struct dma_buf *dbuf;
 	struct dma_buf_attachment *dbuf_attach;
 	struct sg_table *sgt;
 	enum dma_data_direction dir;
+	unsigned int users;
+	unsigned long key;
 	struct list_head list;
 };
 
-long uio_dmabuf_map(struct uio_device *dev, struct list_head *dbufs,
-		    struct mutex *dbufs_lock, void __user *user_args)
+void uio_dmabuf_init(struct uio_dmabuf_cache *cache)
 {
-	struct uio_dmabuf_args args;
-	struct uio_dmabuf_mem *dbuf_mem;
-	struct dma_buf *dbuf;
-	struct dma_buf_attachment *dbuf_attach;
-	enum dma_data_direction dir;
-	struct sg_table *sgt;
-	long ret;
-
-	if (copy_from_user(&args, user_args, sizeof(args))) {
-		ret = -EFAULT;
-		dev_err(dev->dev.parent, "failed to copy from user\n");
-		goto err;
-	}
-
-	dbuf = dma_buf_get(args.dbuf_fd);
-	if (IS_ERR(dbuf)) {
-		dev_err(dev->dev.parent, "failed to get dmabuf\n");
-		return PTR_ERR(dbuf);
-	}
+	xa_init(&cache->mems);
+	INIT_LIST_HEAD(&cache->idle);
+	cache->nr_idle = 0;
+	mutex_init(&cache->lock);
+}
 
-	dbuf_attach = dma_buf_attach(dbuf, dev->dev.parent);
-	if (IS_ERR(dbuf_attach)) {
-		dev_err(dev->dev.parent, "failed to attach dmabuf\n");
-		ret = PTR_ERR(dbuf_attach);
-		goto err_put;
-	}
+/*
+ * The dmabuf inode number is unique and stays the same for all the fds of
+ * a dmabuf, unlike the fd or the struct dma_buf address it is a compact
+ * index.
+ */
+static unsigned long uio_dmabuf_key(struct dma_buf *dbuf)
+{
+	return file_inode(dbuf->file)->i_ino;
+}
 
-	switch (args.dir) {
+static int uio_dmabuf_dir(u8 dir, enum dma_data_direction *dma_dir)
+{
+	switch (dir) {
 	case UIO_DMABUF_DIR_BIDIR:
-		dir = DMA_BIDIRECTIONAL;
+		*dma_dir = DMA_BIDIRECTIONAL;
 		break;
 	case UIO_DMABUF_DIR_TO_DEV:
-		dir = DMA_TO_DEVICE;
+		*dma_dir = DMA_TO_DEVICE;
 		break;
 	case UIO_DMABUF_DIR_FROM_DEV:
-		dir = DMA_FROM_DEVICE;
+		*dma_dir = DMA_FROM_DEVICE;
 		break;
 	default:
-		/* Not needed with check. Just here for any future change  */
-		dev_err(dev->dev.parent, "invalid direction\n");
-		ret = -EINVAL;
-		goto err_detach;
+		return -EINVAL;
 	}
 
-	sgt = dma_buf_map_attachment(dbuf_attach, dir);
+	return 0;
+}
+
+static struct sg_table *uio_dmabuf_map_attachment(struct uio_device *dev,
+						  struct dma_buf_attachment *a,
+						  enum dma_data_direction dir)
+{
+	struct sg_table *sgt;
+
+	sgt = dma_buf_map_attachment(a, dir);
 	if (IS_ERR(sgt)) {
 		dev_err(dev->dev.parent, "failed to get dmabuf scatterlist\n");
-		ret = PTR_ERR(sgt);
-		goto err_detach;
+		return sgt;
 	}
 
 	/* Accept only contiguous one */
@@ -95,37 +113,116 @@ long uio_dmabuf_map(struct uio_device *dev, struct list_head *dbufs,
 			if (sg_dma_address(s) != next_addr) {
 				dev_err(dev->dev.parent,
 					"dmabuf not contiguous\n");
-				ret = -EINVAL;
-				goto err_unmap;
+				dma_buf_unmap_attachment(a, sgt, dir);
+				return ERR_PTR(-EINVAL);
 			}
 
 			next_addr = sg_dma_address(s) + sg_dma_len(s);
 		}
 	}
 
+	return sgt;
+}
+
+static void uio_dmabuf_evict(struct uio_dmabuf_cache *cache,
+			     struct uio_dmabuf_mem *dbuf_mem)
+{
+	xa_erase(&cache->mems, dbuf_mem->key);
+	if (!dbuf_mem->users) {
+		list_del(&dbuf_mem->list);
+		cache->nr_idle--;
+	}
+
+	dma_buf_unmap_attachment(dbuf_mem->dbuf_attach, dbuf_mem->sgt,
+				 dbuf_mem->dir);
+	dma_buf_detach(dbuf_mem->dbuf, dbuf_mem->dbuf_attach);
+	dma_buf_put(dbuf_mem->dbuf);
+	kfree(dbuf_mem);
+}
+
+static int uio_dmabuf_map_one(struct uio_device *dev,
+			      struct uio_dmabuf_cache *cache,
+			      struct uio_dmabuf_args *args)
+{
+	struct uio_dmabuf_mem *dbuf_mem;
+	struct dma_buf *dbuf;
+	struct dma_buf_attachment *dbuf_attach;
+	enum dma_data_direction dir;
+	struct sg_table *sgt;
+	int ret;
+
+	lockdep_assert_held(&cache->lock);
+
+	if (uio_dmabuf_dir(args->dir, &dir)) {
+		dev_err(dev->dev.parent, "invalid direction\n");
+		return -EINVAL;
+	}
+
+	dbuf = dma_buf_get(args->dbuf_fd);
+	if (IS_ERR(dbuf)) {
+		dev_err(dev->dev.parent, "failed to get dmabuf\n");
+		return PTR_ERR(dbuf);
+	}
+
+	dbuf_mem = xa_load(&cache->mems, uio_dmabuf_key(dbuf));
+	if (dbuf_mem && dbuf_mem->dir != dir && !dbuf_mem->users) {
+		uio_dmabuf_evict(cache, dbuf_mem);
+		dbuf_mem = NULL;
+	}
+
+	if (dbuf_mem) {
+		/* The cached mapping holds its own reference */
+		dma_buf_put(dbuf);
+
+		if (dbuf_mem->dir != dir) {
+			dev_err(dev->dev.parent,
+				"dmabuf mapped in another direction\n");
+			return -EBUSY;
+		}
+
+		if (!dbuf_mem->users++) {
+			/* The map of the attachment is skipped, sync only */
+			list_del(&dbuf_mem->list);
+			cache->nr_idle--;
+			dma_sync_sgtable_for_device(dev->dev.parent,
+						    dbuf_mem->sgt, dir);
+		}
+		goto out;
+	}
+
+	dbuf_attach = dma_buf_attach(dbuf, dev->dev.parent);
+	if (IS_ERR(dbuf_attach)) {
+		dev_err(dev->dev.parent, "failed to attach dmabuf\n");
+		ret = PTR_ERR(dbuf_attach);
+		goto err_put;
+	}
+
+	sgt = uio_dmabuf_map_attachment(dev, dbuf_attach, dir);
+	if (IS_ERR(sgt)) {
+		ret = PTR_ERR(sgt);
+		goto err_detach;
+	}
+
 	dbuf_mem = kzalloc(sizeof(*dbuf_mem), GFP_KERNEL);
 	if (!dbuf_mem) {
 		ret = -ENOMEM;
 		goto err_unmap;
 	}
 
-	dbuf_mem->dbuf_fd = args.dbuf_fd;
 	dbuf_mem->dbuf = dbuf;
 	dbuf_mem->dbuf_attach = dbuf_attach;
 	dbuf_mem->sgt = sgt;
 	dbuf_mem->dir = dir;
-	args.dma_addr = sg_dma_address(sgt->sgl);
-	args.size = dbuf->size;
+	dbuf_mem->users = 1;
+	dbuf_mem->key = uio_dmabuf_key(dbuf);
 
-	if (copy_to_user(user_args, &args, sizeof(args))) {
-		ret = -EFAULT;
-		dev_err(dev->dev.parent, "failed to copy to user\n");
+	ret = xa_insert(&cache->mems, dbuf_mem->key, dbuf_mem, GFP_KERNEL);
+	if (ret)
 		goto err_free;
-	}
 
-	mutex_lock(dbufs_lock);
-	list_add(&dbuf_mem->list, dbufs);
-	mutex_unlock(dbufs_lock);
+out:
+	args->dma_addr = sg_dma_address(dbuf_mem->sgt->sgl);
+	args->size = dbuf_mem->dbuf->size;
 
 	return 0;
 
@@ -137,74 +234,168 @@ long uio_dmabuf_map(struct uio_device *dev, struct list_head *dbufs,
 	dma_buf_detach(dbuf, dbuf_attach);
 err_put:
 	dma_buf_put(dbuf);
-err:
 	return ret;
 }
 
-long uio_dmabuf_unmap(struct uio_device *dev, struct list_head *dbufs,
-		      struct mutex *dbufs_lock, void __user *user_args)
+static int uio_dmabuf_unmap_one(struct uio_device *dev,
+				struct uio_dmabuf_cache *cache,
+				struct uio_dmabuf_args *args)
+{
+	struct uio_dmabuf_mem *dbuf_mem = NULL;
+	struct dma_buf *dbuf;
 
+	lockdep_assert_held(&cache->lock);
+
+	dbuf = dma_buf_get(args->dbuf_fd);
+	if (!IS_ERR(dbuf)) {
+		dbuf_mem = xa_load(&cache->mems, uio_dmabuf_key(dbuf));
+		dma_buf_put(dbuf);
+	}
+
+	if (!dbuf_mem || !dbuf_mem->users) {
+		dev_err(dev->dev.parent, "failed to find the dmabuf (%d)\n",
+			args->dbuf_fd);
+		return -EINVAL;
+	}
+
+	if (--dbuf_mem->users)
+		return 0;
+
+	/* Keep the mapping, evicting the least recently used one if needed */
+	dma_sync_sgtable_for_cpu(dev->dev.parent, dbuf_mem->sgt, dbuf_mem->dir);
+	list_add_tail(&dbuf_mem->list, &cache->idle);
+	cache->nr_idle++;
+
+	while (cache->nr_idle > READ_ONCE(dmabuf_cache_max)) {
+		dbuf_mem = list_first_entry(&cache->idle,
+					    struct uio_dmabuf_mem, list);
+		uio_dmabuf_evict(cache, dbuf_mem);
+	}
+
+	return 0;
+}
+
+long uio_dmabuf_map(struct uio_device *dev, struct uio_dmabuf_cache *cache,
+		    void __user *user_args)
 {
 	struct uio_dmabuf_args args;
-	struct uio_dmabuf_mem *dbuf_mem;
 	long ret;
 
 	if (copy_from_user(&args, user_args, sizeof(args))) {
-		ret = -EFAULT;
-		goto err;
+		dev_err(dev->dev.parent, "failed to copy from user\n");
+		return -EFAULT;
 	}
 
-	mutex_lock(dbufs_lock);
-	list_for_each_entry(dbuf_mem, dbufs, list) {
-		if (dbuf_mem->dbuf_fd == args.dbuf_fd)
-			break;
+	mutex_lock(&cache->lock);
+	ret = uio_dmabuf_map_one(dev, cache, &args);
+	if (!ret && copy_to_user(user_args, &args, sizeof(args))) {
+		dev_err(dev->dev.parent, "failed to copy to user\n");
+		uio_dmabuf_unmap_one(dev, cache, &args);
+		ret = -EFAULT;
 	}
+	mutex_unlock(&cache->lock);
 
-	if (dbuf_mem->dbuf_fd != args.dbuf_fd) {
-		dev_err(dev->dev.parent, "failed to find the dmabuf (%d)\n",
-			args.dbuf_fd);
-		ret = -EINVAL;
-		goto err_unlock;
-	}
-	list_del(&dbuf_mem->list);
-	mutex_unlock(dbufs_lock);
+	return ret;
+}
 
-	dma_buf_unmap_attachment(dbuf_mem->dbuf_attach, dbuf_mem->sgt,
-				 dbuf_mem->dir);
-	dma_buf_detach(dbuf_mem->dbuf, dbuf_mem->dbuf_attach);
-	dma_buf_put(dbuf_mem->dbuf);
-	kfree(dbuf_mem);
+long uio_dmabuf_unmap(struct uio_device *dev, struct uio_dmabuf_cache *cache,
+		      void __user *user_args)
+{
+	struct uio_dmabuf_args args;
+	long ret;
+
+	if (copy_from_user(&args, user_args, sizeof(args)))
+		return -EFAULT;
+
+	mutex_lock(&cache->lock);
+	ret = uio_dmabuf_unmap_one(dev, cache, &args);
+	mutex_unlock(&cache->lock);
+	if (ret)
+		return ret;
 
 	memset(&args, 0x0, sizeof(args));
 
-	if (copy_to_user(user_args, &args, sizeof(args))) {
-		ret = -EFAULT;
-		goto err;
-	}
+	if (copy_to_user(user_args, &args, sizeof(args)))
+		return -EFAULT;
 
 	return 0;
+}
+
+/**
+ * uio_dmabuf_batch - map or unmap an array of dmabufs
+ * @dev: the uio device
+ * @cache: the dmabuf mappings of the file
+ * @user_args: the uio_dmabuf_batch from userspace
+ * @map: true to map, false to unmap
+ *
+ * The entries are processed in order under a single lock until one
+ * fails, the number of processed entries is reported back in
+ * uio_dmabuf_batch.done. Processed entries are not rolled back on error.
+ *
+ * Return: 0 if all the entries have been processed; otherwise -errno
+ */
+long uio_dmabuf_batch(struct uio_device *dev, struct uio_dmabuf_cache *cache,
+		      void __user *user_args, bool map)
+{
+	struct uio_dmabuf_batch __user *ubatch = user_args;
+	struct uio_dmabuf_args __user *uargs;
+	struct uio_dmabuf_batch batch;
+	struct uio_dmabuf_args args;
+	long ret = 0;
+	u32 i;
+
+	if (copy_from_user(&batch, ubatch, sizeof(batch)))
+		return -EFAULT;
+
+	uargs = u64_to_user_ptr(batch.args);
+
+	mutex_lock(&cache->lock);
+	for (i = 0; i < batch.count; i++) {
+		if (copy_from_user(&args, &uargs[i], sizeof(args))) {
+			ret = -EFAULT;
+			break;
+		}
+
+		if (map) {
+			ret = uio_dmabuf_map_one(dev, cache, &args);
+			if (ret)
+				break;
+		} else {
+			ret = uio_dmabuf_unmap_one(dev, cache, &args);
+			if (ret)
+				break;
+			memset(&args, 0x0, sizeof(args));
+		}
+
+		if (copy_to_user(&uargs[i], &args, sizeof(args))) {
+			if (map)
+				uio_dmabuf_unmap_one(dev, cache, &args);
+			ret = -EFAULT;
+			break;
+		}
+	}
+	mutex_unlock(&cache->lock);
+
+	if (put_user(i, &ubatch->done))
+		return -EFAULT;
 
-err_unlock:
-	mutex_unlock(dbufs_lock);
-err:
 	return ret;
 }
 
-int uio_dmabuf_cleanup(struct uio_device *dev, struct list_head *dbufs,
-		       struct mutex *dbufs_lock)
+int uio_dmabuf_cleanup(struct uio_device *dev, struct uio_dmabuf_cache *cache)
 {
-	struct uio_dmabuf_mem *dbuf_mem, *next;
+	struct uio_dmabuf_mem *dbuf_mem;
+	unsigned long key;
 
-	mutex_lock(dbufs_lock);
-	list_for_each_entry_safe(dbuf_mem, next, dbufs, list) {
-		list_del(&dbuf_mem->list);
-		dma_buf_unmap_attachment(dbuf_mem->dbuf_attach, dbuf_mem->sgt,
-					 dbuf_mem->dir);
-		dma_buf_detach(dbuf_mem->dbuf, dbuf_mem->dbuf_attach);
-		dma_buf_put(dbuf_mem->dbuf);
-		kfree(dbuf_mem);
-	}
-	mutex_unlock(dbufs_lock);
+	mutex_lock(&cache->lock);
+	xa_for_each(&cache->mems, key, dbuf_mem)
+		uio_dmabuf_evict(cache, dbuf_mem);
+	mutex_unlock(&cache->lock);
+
+	xa_destroy(&cache->mems);
+	mutex_destroy(&cache->lock);
 
 	return 0;
 }
+
+MODULE_IMPORT_NS(DMA_BUF);
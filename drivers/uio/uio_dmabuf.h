@@ -11,16 +11,34 @@
 #ifndef _UIO_DMABUF_H_
 #define _UIO_DMABUF_H_
 
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/xarray.h>
+
 struct uio_device;
-struct list_head;
-struct mutex;
 
-long uio_dmabuf_map(struct uio_device *dev, struct list_head *dbufs,
-		    struct mutex *dbufs_lock, void __user *user_args);
-long uio_dmabuf_unmap(struct uio_device *dev, struct list_head *dbufs,
-		      struct mutex *dbufs_lock, void __user *user_args);
+/**
+ * struct uio_dmabuf_cache - dmabufs mapped through a uio file
+ * @mems: the mappings, indexed by dmabuf
+ * @idle: the mappings not mapped by userspace, least recently used first
+ * @nr_idle: number of mappings in @idle
+ * @lock: protects the cache
+ */
+struct uio_dmabuf_cache {
+	struct xarray mems;
+	struct list_head idle;
+	unsigned int nr_idle;
+	struct mutex lock; /* protects the cache */
+};
+
+void uio_dmabuf_init(struct uio_dmabuf_cache *cache);
+long uio_dmabuf_map(struct uio_device *dev, struct uio_dmabuf_cache *cache,
+		    void __user *user_args);
+long uio_dmabuf_unmap(struct uio_device *dev, struct uio_dmabuf_cache *cache,
+		      void __user *user_args);
+long uio_dmabuf_batch(struct uio_device *dev, struct uio_dmabuf_cache *cache,
+		      void __user *user_args, bool map);
 
-int uio_dmabuf_cleanup(struct uio_device *dev, struct list_head *dbufs,
-		       struct mutex *dbufs_lock);
+int uio_dmabuf_cleanup(struct uio_device *dev, struct uio_dmabuf_cache *cache);
 
 #endif
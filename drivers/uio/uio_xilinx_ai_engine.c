@@ -8,18 +8,56 @@
  */
 
 #include <linux/debugfs.h>
+#include <linux/eventfd.h>
+#include <linux/interrupt.h>
 #include <linux/irq_sim.h>
 #include <linux/mm.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/nospec.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
 #include <linux/platform_data/uio_dmem_genirq.h>
 #include <linux/platform_device.h>
+#include <linux/spinlock.h>
+#include <linux/uaccess.h>
 #include <linux/uio_driver.h>
 
+#include <uapi/linux/uio/xilinx_ai_engine.h>
+
 #define DRIVER_NAME "xilinx-aiengine"
 #define XILINX_AI_ENGINE_MAX_IRQ	4
 
+struct xilinx_ai_engine;
+
+/**
+ * struct xilinx_ai_engine_irq - AI engine interrupt signalled to an eventfd
+ * @xaie: the AI engine
+ * @irq: the interrupt number, negative if absent or used by the uio device
+ * @masked: the interrupt is disabled, protected by the AI engine lock
+ * @trigger: the eventfd to signal, protected by the AI engine lock
+ */
+struct xilinx_ai_engine_irq {
+	struct xilinx_ai_engine *xaie;
+	int irq;
+	bool masked;
+	struct eventfd_ctx *trigger;
+};
+
+/**
+ * struct xilinx_ai_engine - AI engine UIO driver data
+ * @uio: the uio_dmem_genirq platform device
+ * @irqs: the interrupts which are not used by the uio device
+ * @lock: protects the interrupt state against the interrupt handler
+ * @mutex: serializes the interrupt ioctls
+ */
+struct xilinx_ai_engine {
+	struct platform_device *uio;
+	struct xilinx_ai_engine_irq irqs[XILINX_AI_ENGINE_MAX_IRQ];
+	spinlock_t lock; /* protects the interrupt state */
+	struct mutex mutex; /* serializes the interrupt ioctls */
+};
+
 static uint xilinx_ai_engine_mem_cnt = 1;
 module_param_named(mem_cnt, xilinx_ai_engine_mem_cnt, uint, 0444);
 MODULE_PARM_DESC(mem_cnt, "Dynamic memory allocation count (default: 1)");
@@ -185,17 +223,190 @@ static int xilinx_ai_engine_mmap(struct uio_info *info,
 			       vma->vm_page_prot);
 }
 
-static int xilinx_ai_engine_probe(struct platform_device *pdev)
+static irqreturn_t xilinx_ai_engine_irq_handler(int irq, void *data)
+{
+	struct xilinx_ai_engine_irq *xirq = data;
+	struct xilinx_ai_engine *xaie = xirq->xaie;
+
+	/* The interrupt is level, leave it masked until userspace acks it */
+	spin_lock(&xaie->lock);
+	if (!xirq->masked) {
+		disable_irq_nosync(irq);
+		xirq->masked = true;
+	}
+	if (xirq->trigger)
+		eventfd_signal(xirq->trigger, 1);
+	spin_unlock(&xaie->lock);
+
+	return IRQ_HANDLED;
+}
+
+static int xilinx_ai_engine_set_eventfd(struct xilinx_ai_engine *xaie,
+					struct xilinx_ai_engine_irq *xirq,
+					int fd)
+{
+	struct eventfd_ctx *trigger = NULL, *old;
+	unsigned long flags;
+	bool masked;
+
+	if (fd >= 0) {
+		trigger = eventfd_ctx_fdget(fd);
+		if (IS_ERR(trigger))
+			return PTR_ERR(trigger);
+	}
+
+	spin_lock_irqsave(&xaie->lock, flags);
+	old = xirq->trigger;
+	xirq->trigger = trigger;
+	masked = xirq->masked;
+	xirq->masked = !trigger;
+	spin_unlock_irqrestore(&xaie->lock, flags);
+
+	if (!trigger && !masked)
+		disable_irq(xirq->irq);
+	else if (trigger && masked)
+		enable_irq(xirq->irq);
+
+	if (old)
+		eventfd_ctx_put(old);
+
+	return 0;
+}
+
+static int xilinx_ai_engine_unmask(struct xilinx_ai_engine *xaie,
+				   struct xilinx_ai_engine_irq *xirq)
+{
+	unsigned long flags;
+	int ret = 0;
+
+	spin_lock_irqsave(&xaie->lock, flags);
+	if (!xirq->trigger) {
+		ret = -EINVAL;
+	} else if (xirq->masked) {
+		xirq->masked = false;
+		enable_irq(xirq->irq);
+	}
+	spin_unlock_irqrestore(&xaie->lock, flags);
+
+	return ret;
+}
+
+static struct xilinx_ai_engine_irq *
+xilinx_ai_engine_get_irq(struct xilinx_ai_engine *xaie, u32 index)
+{
+	if (index >= XILINX_AI_ENGINE_MAX_IRQ)
+		return NULL;
+
+	index = array_index_nospec(index, XILINX_AI_ENGINE_MAX_IRQ);
+	if (xaie->irqs[index].irq < 0)
+		return NULL;
+
+	return &xaie->irqs[index];
+}
+
+static long xilinx_ai_engine_ioctl(struct uio_info *info, unsigned int cmd,
+				   unsigned long arg)
+{
+	/* The uio device belongs to the uio_dmem_genirq child device */
+	struct device *dev = info->uio_dev->dev.parent->parent;
+	struct xilinx_ai_engine *xaie = dev_get_drvdata(dev);
+	struct xilinx_ai_engine_irq_args args;
+	struct xilinx_ai_engine_irq *xirq;
+	u32 index;
+	long ret;
+
+	switch (cmd) {
+	case XILINX_AI_ENGINE_IOC_SET_IRQ_EVENTFD:
+		if (copy_from_user(&args, (void __user *)arg, sizeof(args)))
+			return -EFAULT;
+
+		xirq = xilinx_ai_engine_get_irq(xaie, args.index);
+		if (!xirq)
+			return -EINVAL;
+
+		mutex_lock(&xaie->mutex);
+		ret = xilinx_ai_engine_set_eventfd(xaie, xirq, args.fd);
+		mutex_unlock(&xaie->mutex);
+		return ret;
+	case XILINX_AI_ENGINE_IOC_UNMASK_IRQ:
+		if (get_user(index, (u32 __user *)arg))
+			return -EFAULT;
+
+		xirq = xilinx_ai_engine_get_irq(xaie, index);
+		if (!xirq)
+			return -EINVAL;
+
+		return xilinx_ai_engine_unmask(xaie, xirq);
+	default:
+		return -EINVAL;
+	}
+}
+
+/**
+ * xilinx_ai_engine_request_irqs - Request the AI engine interrupts
+ * @pdev: the AI engine platform device
+ * @xaie: the AI engine
+ *
+ * The first interrupt found is handed over to the uio device as before. The
+ * other ones are requested here, disabled until an eventfd is bound to them.
+ *
+ * Return: the uio device interrupt, or a negative error code if none.
+ */
+static int xilinx_ai_engine_request_irqs(struct platform_device *pdev,
+					 struct xilinx_ai_engine *xaie)
 {
-	struct platform_device *uio;
-	struct uio_dmem_genirq_pdata *pdata;
-	unsigned int i;
 	static const char * const interrupt_names[] = { "interrupt0",
 							"interrupt1",
 							"interrupt2",
 							"interrupt3" };
+	int uio_irq = -ENXIO;
+	unsigned int i;
+	int irq, ret;
+
+	for (i = 0; i < XILINX_AI_ENGINE_MAX_IRQ; i++) {
+		struct xilinx_ai_engine_irq *xirq = &xaie->irqs[i];
+
+		xirq->xaie = xaie;
+		xirq->irq = -ENXIO;
+		xirq->masked = true;
+
+		irq = platform_get_irq_byname_optional(pdev,
+						       interrupt_names[i]);
+		if (irq < 0)
+			continue;
+
+		if (uio_irq < 0) {
+			dev_info(&pdev->dev, "%s is used", interrupt_names[i]);
+			uio_irq = irq;
+			continue;
+		}
+
+		ret = devm_request_irq(&pdev->dev, irq,
+				       xilinx_ai_engine_irq_handler,
+				       IRQF_NO_AUTOEN, interrupt_names[i],
+				       xirq);
+		if (ret)
+			return ret;
+		xirq->irq = irq;
+	}
+
+	return uio_irq;
+}
+
+static int xilinx_ai_engine_probe(struct platform_device *pdev)
+{
+	struct xilinx_ai_engine *xaie;
+	struct platform_device *uio;
+	struct uio_dmem_genirq_pdata *pdata;
+	unsigned int i;
 	int ret;
 
+	xaie = devm_kzalloc(&pdev->dev, sizeof(*xaie), GFP_KERNEL);
+	if (!xaie)
+		return -ENOMEM;
+	spin_lock_init(&xaie->lock);
+	mutex_init(&xaie->mutex);
+
 	uio = platform_device_alloc(DRIVER_NAME, PLATFORM_DEVID_NONE);
 	if (!uio)
 		return -ENOMEM;
@@ -213,18 +424,15 @@ static int xilinx_ai_engine_probe(struct platform_device *pdev)
 	pdata->uioinfo.name = DRIVER_NAME;
 	pdata->uioinfo.version = "devicetree";
 	pdata->uioinfo.mmap = xilinx_ai_engine_mmap;
+	pdata->uioinfo.ioctl = xilinx_ai_engine_ioctl;
 	/* Set the offset value as it's map index for each memory */
 	for (i = 0; i < MAX_UIO_MAPS; i++)
 		pdata->uioinfo.mem[i].offs = i << PAGE_SHIFT;
 
-	/* TODO: Only one interrupt is supported out of 4 */
-	for (i  = 0; i < XILINX_AI_ENGINE_MAX_IRQ; i++) {
-		ret = platform_get_irq_byname(pdev, interrupt_names[i]);
-		if (ret >= 0) {
-			dev_info(&pdev->dev, "%s is used", interrupt_names[i]);
-			break;
-		}
-	}
+	/* Only one interrupt goes to the uio device, others to eventfds */
+	ret = xilinx_ai_engine_request_irqs(pdev, xaie);
+	if (ret == -EPROBE_DEFER)
+		goto err_out;
 
 	/* Interrupt is optional */
 	if (ret < 0) {
@@ -255,7 +463,8 @@ static int xilinx_ai_engine_probe(struct platform_device *pdev)
 	if (ret)
 		goto err_out;
 	platform_set_drvdata(uio, pdata);
-	platform_set_drvdata(pdev, uio);
+	xaie->uio = uio;
+	platform_set_drvdata(pdev, xaie);
 
 	dev_info(&pdev->dev, "Xilinx AI Engine UIO driver probed");
 	return 0;
@@ -269,9 +478,15 @@ static int xilinx_ai_engine_probe(struct platform_device *pdev)
 
 static int xilinx_ai_engine_remove(struct platform_device *pdev)
 {
-	struct platform_device *uio = platform_get_drvdata(pdev);
+	struct xilinx_ai_engine *xaie = platform_get_drvdata(pdev);
+	unsigned int i;
+
+	platform_device_unregister(xaie->uio);
+
+	for (i = 0; i < XILINX_AI_ENGINE_MAX_IRQ; i++)
+		if (xaie->irqs[i].irq >= 0)
+			xilinx_ai_engine_set_eventfd(xaie, &xaie->irqs[i], -1);
 
-	platform_device_unregister(uio);
 	of_node_put(pdev->dev.of_node);
 
 	return 0;
@@ -10,24 +10,54 @@
  * of AXI bus in the system. Driver maps HW registers and parameters
  * to userspace. Userspace need not clear the interrupt of IP since
  * driver clears the interrupt.
+ *
+ * In advanced mode the metric counters are also offered to perf as a
+ * system-wide PMU. perf and UIO users must not program the monitor at
+ * the same time. Two counters can also be set aside for a devfreq-event
+ * device, reporting the utilisation of the first monitor slot.
  */
 
 #include <linux/clk.h>
+#include <linux/devfreq-event.h>
 #include <linux/io.h>
 #include <linux/module.h>
 #include <linux/of.h>
+#include <linux/perf_event.h>
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
 #include <linux/slab.h>
 #include <linux/uio_driver.h>
-
+#include <asm/irq_regs.h>
+
+#define XAPM_GCC_LOW_OFFSET	0x0004  /* Global Clock Counter low */
+#define XAPM_SI_HIGH_OFFSET	0x0020  /* Sample Interval Register high */
+#define XAPM_SI_LOW_OFFSET	0x0024  /* Sample Interval Register low */
+#define XAPM_SICR_OFFSET	0x0028  /* Sample Interval Control Register */
+#define XAPM_GIE_OFFSET		0x0030  /* Global Interrupt Enable */
+#define XAPM_IE_OFFSET		0x0034  /* Interrupt Enable Register */
 #define XAPM_IS_OFFSET		0x0038  /* Interrupt Status Register */
+#define XAPM_MSR_OFFSET(n)	(0x0044 + ((n) / 4) * 4) /* Metric Selector */
+#define XAPM_MC_OFFSET(n)	(0x0100 + (n) * 0x10) /* Metric Counter */
+#define XAPM_CTL_OFFSET		0x0300  /* Control Register */
+
+#define XAPM_MSR_SHIFT(n)	(((n) % 4) * 8)
+#define XAPM_MSR_MASK		0xff
+#define XAPM_SICR_ENABLE	BIT(0)
+#define XAPM_SICR_LOAD		BIT(1)
+#define XAPM_CR_MCNTR_ENABLE	BIT(0)
+#define XAPM_CR_GCC_ENABLE	BIT(16)
+#define XAPM_IXR_SIC_OVF	BIT(1)
+#define XAPM_IXR_MC_OVF(n)	BIT((n) + 2)
+#define XAPM_MAX_COUNTERS	10
+#define XAPM_SAMPLE_HZ		1000
 #define DRV_NAME		"xilinxapm_uio"
 #define DRV_VERSION		"1.0"
 #define UIO_DUMMY_MEMSIZE	4096
 #define XAPM_MODE_ADVANCED	1
 #define XAPM_MODE_PROFILE	2
 #define XAPM_MODE_TRACE		3
+#define XAPM_METRIC_WR_BYTES	2
+#define XAPM_METRIC_RD_BYTES	3
 
 /**
  * struct xapm_param - HW parameters structure
@@ -71,8 +101,32 @@ struct xapm_dev {
 	struct uio_info info;
 	struct xapm_param param;
 	void __iomem *regs;
+#ifdef CONFIG_PERF_EVENTS
+	struct pmu pmu;
+	unsigned int pmu_cpu;
+	raw_spinlock_t pmu_lock;
+	struct perf_event *events[XAPM_MAX_COUNTERS];
+	unsigned int num_active;
+	unsigned int num_sampling;
+#endif
+#if IS_ENABLED(CONFIG_PM_DEVFREQ_EVENT)
+	struct devfreq_event_desc edesc;
+	unsigned int edev_idx;
+	u32 edev_width;
+	u32 edev_gcc;
+	u32 edev_wr;
+	u32 edev_rd;
+#endif
 };
 
+#ifdef CONFIG_PERF_EVENTS
+static void xapm_pmu_handle_irq(struct xapm_dev *xapm, u32 isr);
+#else
+static inline void xapm_pmu_handle_irq(struct xapm_dev *xapm, u32 isr)
+{
+}
+#endif
+
 /**
  * xapm_handler - Interrupt handler for APM
  * @irq: IRQ number
@@ -89,11 +143,481 @@ static irqreturn_t xapm_handler(int irq, struct uio_info *info)
 	/* Clear the interrupt and copy the ISR value to userspace */
 	xapm->param.isr = readl(xapm->regs + XAPM_IS_OFFSET);
 	writel(xapm->param.isr, xapm->regs + XAPM_IS_OFFSET);
+	xapm_pmu_handle_irq(xapm, xapm->param.isr);
 	memcpy(ptr, &xapm->param, sizeof(struct xapm_param));
 
 	return IRQ_HANDLED;
 }
 
+#ifdef CONFIG_PERF_EVENTS
+/*
+ * An event selects one metric of one monitor slot (AXI port), the same
+ * encoding the Metric Selector Registers use.
+ */
+#define XAPM_EVENT_METRIC(config)	((config) & 0x1f)
+#define XAPM_EVENT_SLOT(config)		(((config) >> 5) & 0x7)
+
+#define to_xapm(p) container_of(p, struct xapm_dev, pmu)
+
+/**
+ * xapm_pmu_update - Fold the counter progress into the event count
+ * @event: perf event
+ *
+ * The metric counters are 32 bit and cannot be written, so progress is
+ * tracked as a delta. An overflow interrupt per counter makes sure it is
+ * sampled at least once per wrap.
+ *
+ * Return: The number of new counts
+ */
+static u64 xapm_pmu_update(struct perf_event *event)
+{
+	struct xapm_dev *xapm = to_xapm(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	u64 prev, now, delta;
+
+	do {
+		prev = local64_read(&hwc->prev_count);
+		now = readl(xapm->regs + XAPM_MC_OFFSET(hwc->idx));
+	} while (local64_cmpxchg(&hwc->prev_count, prev, now) != prev);
+
+	delta = (now - prev) & GENMASK_ULL(31, 0);
+	local64_add(delta, &event->count);
+
+	return delta;
+}
+
+static void xapm_pmu_sample(struct perf_event *event, u64 delta)
+{
+	struct hw_perf_event *hwc = &event->hw;
+	struct perf_sample_data data;
+	struct pt_regs *regs = get_irq_regs();
+
+	if (local64_sub_return(delta, &hwc->period_left) > 0)
+		return;
+
+	local64_add(hwc->sample_period, &hwc->period_left);
+	hwc->last_period = hwc->sample_period;
+	perf_sample_data_init(&data, 0, hwc->last_period);
+
+	if (regs && perf_event_overflow(event, &data, regs))
+		event->pmu->stop(event, 0);
+}
+
+/**
+ * xapm_pmu_handle_irq - Account counter overflows and sample intervals
+ * @xapm: Driver structure
+ * @isr: Interrupt status, already cleared in the hardware
+ *
+ * Sampling events are checked against their period on every sample
+ * interval tick and report the context the tick interrupted.
+ */
+static void xapm_pmu_handle_irq(struct xapm_dev *xapm, u32 isr)
+{
+	struct perf_event *event;
+	unsigned long flags;
+	u64 delta;
+	int i;
+
+	raw_spin_lock_irqsave(&xapm->pmu_lock, flags);
+	for (i = 0; i < XAPM_MAX_COUNTERS; i++) {
+		event = xapm->events[i];
+		if (!event || event->hw.state & PERF_HES_STOPPED)
+			continue;
+
+		if (!(isr & (XAPM_IXR_MC_OVF(i) | XAPM_IXR_SIC_OVF)))
+			continue;
+
+		delta = xapm_pmu_update(event);
+		if (isr & XAPM_IXR_SIC_OVF && is_sampling_event(event))
+			xapm_pmu_sample(event, delta);
+	}
+	raw_spin_unlock_irqrestore(&xapm->pmu_lock, flags);
+}
+
+static int xapm_pmu_event_init(struct perf_event *event)
+{
+	struct xapm_dev *xapm = to_xapm(event->pmu);
+	struct perf_event *sibling;
+	u64 config = event->attr.config;
+	unsigned int n = 1;
+
+	if (event->attr.type != event->pmu->type)
+		return -ENOENT;
+
+	/* The counters measure the interconnect, not a task */
+	if (event->attach_state & PERF_ATTACH_TASK)
+		return -EOPNOTSUPP;
+
+	if (event->cpu < 0)
+		return -EINVAL;
+
+	if (config & ~GENMASK_ULL(7, 0) ||
+	    XAPM_EVENT_SLOT(config) >= xapm->param.maxslots)
+		return -EINVAL;
+
+	if (event->group_leader != event &&
+	    event->group_leader->pmu == event->pmu)
+		n++;
+	for_each_sibling_event(sibling, event->group_leader)
+		if (sibling->pmu == event->pmu)
+			n++;
+	if (n > xapm->param.numcounters)
+		return -EINVAL;
+
+	event->cpu = xapm->pmu_cpu;
+
+	return 0;
+}
+
+static void xapm_pmu_start(struct perf_event *event, int flags)
+{
+	struct xapm_dev *xapm = to_xapm(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+
+	local64_set(&hwc->prev_count,
+		    readl(xapm->regs + XAPM_MC_OFFSET(hwc->idx)));
+	if (is_sampling_event(event))
+		local64_set(&hwc->period_left, hwc->sample_period);
+	hwc->state = 0;
+}
+
+static void xapm_pmu_stop(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	if (!(hwc->state & PERF_HES_UPTODATE))
+		xapm_pmu_update(event);
+
+	hwc->state |= PERF_HES_STOPPED | PERF_HES_UPTODATE;
+}
+
+static int xapm_pmu_add(struct perf_event *event, int flags)
+{
+	struct xapm_dev *xapm = to_xapm(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	u64 config = event->attr.config;
+	unsigned long irqflags;
+	u32 reg;
+	int idx;
+
+	raw_spin_lock_irqsave(&xapm->pmu_lock, irqflags);
+	for (idx = 0; idx < xapm->param.numcounters; idx++)
+		if (!xapm->events[idx])
+			break;
+	if (idx == xapm->param.numcounters) {
+		raw_spin_unlock_irqrestore(&xapm->pmu_lock, irqflags);
+		return -EAGAIN;
+	}
+
+	xapm->events[idx] = event;
+	hwc->idx = idx;
+	hwc->state = PERF_HES_STOPPED | PERF_HES_UPTODATE;
+
+	reg = readl(xapm->regs + XAPM_MSR_OFFSET(idx));
+	reg &= ~(XAPM_MSR_MASK << XAPM_MSR_SHIFT(idx));
+	reg |= (config & XAPM_MSR_MASK) << XAPM_MSR_SHIFT(idx);
+	writel(reg, xapm->regs + XAPM_MSR_OFFSET(idx));
+
+	reg = readl(xapm->regs + XAPM_IE_OFFSET) | XAPM_IXR_MC_OVF(idx);
+	if (is_sampling_event(event) && !xapm->num_sampling++)
+		reg |= XAPM_IXR_SIC_OVF;
+	writel(reg, xapm->regs + XAPM_IE_OFFSET);
+
+	if (!xapm->num_active++)
+		writel(readl(xapm->regs + XAPM_CTL_OFFSET) |
+		       XAPM_CR_MCNTR_ENABLE, xapm->regs + XAPM_CTL_OFFSET);
+	raw_spin_unlock_irqrestore(&xapm->pmu_lock, irqflags);
+
+	if (flags & PERF_EF_START)
+		xapm_pmu_start(event, flags);
+
+	return 0;
+}
+
+static void xapm_pmu_del(struct perf_event *event, int flags)
+{
+	struct xapm_dev *xapm = to_xapm(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	unsigned long irqflags;
+	u32 reg;
+
+	xapm_pmu_stop(event, PERF_EF_UPDATE);
+
+	raw_spin_lock_irqsave(&xapm->pmu_lock, irqflags);
+	xapm->events[hwc->idx] = NULL;
+
+	reg = readl(xapm->regs + XAPM_IE_OFFSET) & ~XAPM_IXR_MC_OVF(hwc->idx);
+	if (is_sampling_event(event) && !--xapm->num_sampling)
+		reg &= ~XAPM_IXR_SIC_OVF;
+	writel(reg, xapm->regs + XAPM_IE_OFFSET);
+
+	if (!--xapm->num_active)
+		writel(readl(xapm->regs + XAPM_CTL_OFFSET) &
+		       ~XAPM_CR_MCNTR_ENABLE, xapm->regs + XAPM_CTL_OFFSET);
+	raw_spin_unlock_irqrestore(&xapm->pmu_lock, irqflags);
+}
+
+static void xapm_pmu_read(struct perf_event *event)
+{
+	xapm_pmu_update(event);
+}
+
+static ssize_t cpumask_show(struct device *dev, struct device_attribute *attr,
+			    char *buf)
+{
+	struct xapm_dev *xapm = to_xapm(dev_get_drvdata(dev));
+
+	return cpumap_print_to_pagebuf(true, buf, cpumask_of(xapm->pmu_cpu));
+}
+static DEVICE_ATTR_RO(cpumask);
+
+static struct attribute *xapm_pmu_cpumask_attrs[] = {
+	&dev_attr_cpumask.attr,
+	NULL
+};
+
+static const struct attribute_group xapm_pmu_cpumask_group = {
+	.attrs = xapm_pmu_cpumask_attrs,
+};
+
+PMU_FORMAT_ATTR(metric, "config:0-4");
+PMU_FORMAT_ATTR(slot, "config:5-7");
+
+static struct attribute *xapm_pmu_format_attrs[] = {
+	&format_attr_metric.attr,
+	&format_attr_slot.attr,
+	NULL
+};
+
+static const struct attribute_group xapm_pmu_format_group = {
+	.name = "format",
+	.attrs = xapm_pmu_format_attrs,
+};
+
+PMU_EVENT_ATTR_STRING(write_transactions, event_attr_wr_trans, "metric=0");
+PMU_EVENT_ATTR_STRING(read_transactions, event_attr_rd_trans, "metric=1");
+PMU_EVENT_ATTR_STRING(write_bytes, event_attr_wr_bytes, "metric=2");
+PMU_EVENT_ATTR_STRING(read_bytes, event_attr_rd_bytes, "metric=3");
+PMU_EVENT_ATTR_STRING(write_beats, event_attr_wr_beats, "metric=4");
+PMU_EVENT_ATTR_STRING(read_latency, event_attr_rd_lat, "metric=5");
+PMU_EVENT_ATTR_STRING(write_latency, event_attr_wr_lat, "metric=6");
+PMU_EVENT_ATTR_STRING(slave_write_idle, event_attr_slv_wr_idle, "metric=7");
+PMU_EVENT_ATTR_STRING(master_read_idle, event_attr_mst_rd_idle, "metric=8");
+PMU_EVENT_ATTR_STRING(bvalids, event_attr_bvalids, "metric=9");
+PMU_EVENT_ATTR_STRING(wlasts, event_attr_wlasts, "metric=10");
+PMU_EVENT_ATTR_STRING(rlasts, event_attr_rlasts, "metric=11");
+
+static struct attribute *xapm_pmu_event_attrs[] = {
+	&event_attr_wr_trans.attr.attr,
+	&event_attr_rd_trans.attr.attr,
+	&event_attr_wr_bytes.attr.attr,
+	&event_attr_rd_bytes.attr.attr,
+	&event_attr_wr_beats.attr.attr,
+	&event_attr_rd_lat.attr.attr,
+	&event_attr_wr_lat.attr.attr,
+	&event_attr_slv_wr_idle.attr.attr,
+	&event_attr_mst_rd_idle.attr.attr,
+	&event_attr_bvalids.attr.attr,
+	&event_attr_wlasts.attr.attr,
+	&event_attr_rlasts.attr.attr,
+	NULL
+};
+
+static const struct attribute_group xapm_pmu_events_group = {
+	.name = "events",
+	.attrs = xapm_pmu_event_attrs,
+};
+
+static const struct attribute_group *xapm_pmu_attr_groups[] = {
+	&xapm_pmu_cpumask_group,
+	&xapm_pmu_format_group,
+	&xapm_pmu_events_group,
+	NULL
+};
+
+/**
+ * xapm_pmu_register - Register the metric counters with perf
+ * @pdev: Pointer to platform device
+ * @xapm: Driver structure
+ *
+ * Only the advanced mode has metric counters. A failure here leaves the
+ * UIO interface working.
+ */
+static void xapm_pmu_register(struct platform_device *pdev,
+			      struct xapm_dev *xapm)
+{
+	unsigned long rate = clk_get_rate(xapm->param.clk);
+	char *name;
+	int ret;
+
+	if (xapm->param.mode != XAPM_MODE_ADVANCED)
+		return;
+
+	xapm->param.numcounters = min_t(u32, xapm->param.numcounters,
+					XAPM_MAX_COUNTERS);
+	if (!xapm->param.numcounters)
+		return;
+
+	name = devm_kasprintf(&pdev->dev, GFP_KERNEL, "xilinx_apm_%llx",
+			      (unsigned long long)xapm->info.mem[0].addr);
+	if (!name)
+		return;
+
+	raw_spin_lock_init(&xapm->pmu_lock);
+	xapm->pmu_cpu = raw_smp_processor_id();
+	if (irq_set_affinity(xapm->info.irq, cpumask_of(xapm->pmu_cpu)))
+		dev_warn(&pdev->dev, "cannot bind the APM interrupt\n");
+
+	/* Sample interval tick, it reloads itself when it expires */
+	writel(0, xapm->regs + XAPM_SI_HIGH_OFFSET);
+	writel(rate ? rate / XAPM_SAMPLE_HZ : 100000,
+	       xapm->regs + XAPM_SI_LOW_OFFSET);
+	writel(XAPM_SICR_LOAD, xapm->regs + XAPM_SICR_OFFSET);
+	writel(XAPM_SICR_ENABLE, xapm->regs + XAPM_SICR_OFFSET);
+	writel(1, xapm->regs + XAPM_GIE_OFFSET);
+
+	xapm->pmu = (struct pmu) {
+		.module		= THIS_MODULE,
+		.task_ctx_nr	= perf_invalid_context,
+		.capabilities	= PERF_PMU_CAP_NO_EXCLUDE,
+		.attr_groups	= xapm_pmu_attr_groups,
+		.event_init	= xapm_pmu_event_init,
+		.add		= xapm_pmu_add,
+		.del		= xapm_pmu_del,
+		.start		= xapm_pmu_start,
+		.stop		= xapm_pmu_stop,
+		.read		= xapm_pmu_read,
+	};
+
+	ret = perf_pmu_register(&xapm->pmu, name, -1);
+	if (ret) {
+		dev_warn(&pdev->dev, "Failed to register PMU: %d\n", ret);
+		xapm->pmu.name = NULL;
+	}
+}
+
+static void xapm_pmu_unregister(struct xapm_dev *xapm)
+{
+	if (xapm->pmu.name)
+		perf_pmu_unregister(&xapm->pmu);
+}
+#else
+static inline void xapm_pmu_register(struct platform_device *pdev,
+				     struct xapm_dev *xapm)
+{
+}
+
+static inline void xapm_pmu_unregister(struct xapm_dev *xapm)
+{
+}
+#endif /* CONFIG_PERF_EVENTS */
+
+#if IS_ENABLED(CONFIG_PM_DEVFREQ_EVENT)
+static int xapm_edev_set_event(struct devfreq_event_dev *edev)
+{
+	struct xapm_dev *xapm = devfreq_event_get_drvdata(edev);
+
+	xapm->edev_gcc = readl(xapm->regs + XAPM_GCC_LOW_OFFSET);
+	xapm->edev_wr = readl(xapm->regs + XAPM_MC_OFFSET(xapm->edev_idx));
+	xapm->edev_rd = readl(xapm->regs + XAPM_MC_OFFSET(xapm->edev_idx + 1));
+
+	return 0;
+}
+
+/*
+ * The read and write channels run in parallel, the busier one is the load.
+ * It is counted in data beats against the clock cycles of the monitor, all
+ * the counters are 32 bit so the event must be read back at least once per
+ * wrap of the byte counters.
+ */
+static int xapm_edev_get_event(struct devfreq_event_dev *edev,
+			       struct devfreq_event_data *edata)
+{
+	struct xapm_dev *xapm = devfreq_event_get_drvdata(edev);
+	u32 gcc, wr, rd;
+
+	gcc = readl(xapm->regs + XAPM_GCC_LOW_OFFSET) - xapm->edev_gcc;
+	wr = readl(xapm->regs + XAPM_MC_OFFSET(xapm->edev_idx)) -
+	     xapm->edev_wr;
+	rd = readl(xapm->regs + XAPM_MC_OFFSET(xapm->edev_idx + 1)) -
+	     xapm->edev_rd;
+
+	edata->load_count = (unsigned long)max(wr, rd) *
+			    max_t(u32, xapm->param.scalefactor, 1) /
+			    (xapm->edev_width / 8);
+	edata->total_count = gcc;
+
+	return 0;
+}
+
+static const struct devfreq_event_ops xapm_edev_ops = {
+	.set_event = xapm_edev_set_event,
+	.get_event = xapm_edev_get_event,
+};
+
+/**
+ * xapm_edev_register - Register the utilisation of slot 0 with devfreq
+ * @pdev: Pointer to platform device
+ * @xapm: Driver structure
+ *
+ * Only done when the data width of the slot is given in
+ * "xlnx,devfreq-data-width". The last two metric counters then count the
+ * bytes written and read through the slot and are no longer offered to
+ * perf. A failure here leaves the other interfaces working.
+ */
+static void xapm_edev_register(struct platform_device *pdev,
+			       struct xapm_dev *xapm)
+{
+	struct devfreq_event_dev *edev;
+	u32 reg;
+	int i;
+
+	if (xapm->param.mode != XAPM_MODE_ADVANCED ||
+	    of_property_read_u32(pdev->dev.of_node, "xlnx,devfreq-data-width",
+				 &xapm->edev_width))
+		return;
+
+	xapm->param.numcounters = min_t(u32, xapm->param.numcounters,
+					XAPM_MAX_COUNTERS);
+	if (xapm->param.numcounters < 2 || xapm->edev_width < 8) {
+		dev_warn(&pdev->dev, "cannot count the slot utilisation\n");
+		return;
+	}
+
+	xapm->edev_idx = xapm->param.numcounters - 2;
+	for (i = 0; i < 2; i++) {
+		reg = readl(xapm->regs + XAPM_MSR_OFFSET(xapm->edev_idx + i));
+		reg &= ~(XAPM_MSR_MASK << XAPM_MSR_SHIFT(xapm->edev_idx + i));
+		reg |= (i ? XAPM_METRIC_RD_BYTES : XAPM_METRIC_WR_BYTES) <<
+		       XAPM_MSR_SHIFT(xapm->edev_idx + i);
+		writel(reg, xapm->regs + XAPM_MSR_OFFSET(xapm->edev_idx + i));
+	}
+
+	xapm->edesc.name = dev_name(&pdev->dev);
+	xapm->edesc.driver_data = xapm;
+	xapm->edesc.ops = &xapm_edev_ops;
+	edev = devm_devfreq_event_add_edev(&pdev->dev, &xapm->edesc);
+	if (IS_ERR(edev)) {
+		dev_warn(&pdev->dev, "Failed to add devfreq-event: %ld\n",
+			 PTR_ERR(edev));
+		return;
+	}
+
+	xapm->param.numcounters -= 2;
+#ifdef CONFIG_PERF_EVENTS
+	/* The counters keep running when the last perf event goes away */
+	xapm->num_active++;
+#endif
+	writel(readl(xapm->regs + XAPM_CTL_OFFSET) | XAPM_CR_MCNTR_ENABLE |
+	       XAPM_CR_GCC_ENABLE, xapm->regs + XAPM_CTL_OFFSET);
+}
+#else
+static inline void xapm_edev_register(struct platform_device *pdev,
+				      struct xapm_dev *xapm)
+{
+}
+#endif /* CONFIG_PM_DEVFREQ_EVENT */
+
 /**
  * xapm_getprop - Retrieves dts properties to param structure
  * @pdev: Pointer to platform device
@@ -275,6 +799,8 @@ static int xapm_probe(struct platform_device *pdev)
 	}
 
 	platform_set_drvdata(pdev, xapm);
+	xapm_edev_register(pdev, xapm);
+	xapm_pmu_register(pdev, xapm);
 
 	dev_info(&pdev->dev, "Probed Xilinx APM\n");
 
@@ -297,6 +823,7 @@ static int xapm_remove(struct platform_device *pdev)
 {
 	struct xapm_dev *xapm = platform_get_drvdata(pdev);
 
+	xapm_pmu_unregister(xapm);
 	uio_unregister_device(&xapm->info);
 	clk_disable_unprepare(xapm->param.clk);
 	pm_runtime_disable(&pdev->dev);
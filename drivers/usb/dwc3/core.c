@@ -1548,6 +1548,8 @@ static void dwc3_get_properties(struct dwc3 *dwc)
 	u8			tx_thr_num_pkt_prd = 0;
 	u8			tx_max_burst_prd = 0;
 	u8			tx_fifo_resize_max_num;
+	u32			imod_interval_ns = 0;
+	u16			num_trbs = DWC3_TRB_NUM;
 	const char		*usb_psy_name;
 	int			ret;
 
@@ -1613,6 +1615,17 @@ static void dwc3_get_properties(struct dwc3 *dwc)
 				&tx_thr_num_pkt_prd);
 	device_property_read_u8(dev, "snps,tx-max-burst-prd",
 				&tx_max_burst_prd);
+	device_property_read_u8(dev, "snps,rx-thr-num-pkt",
+				&dwc->rx_thr_num_pkt);
+	device_property_read_u8(dev, "snps,rx-max-burst",
+				&dwc->rx_max_burst);
+	device_property_read_u8(dev, "snps,tx-thr-num-pkt",
+				&dwc->tx_thr_num_pkt);
+	device_property_read_u8(dev, "snps,tx-max-burst",
+				&dwc->tx_max_burst);
+	device_property_read_u32(dev, "snps,imod-interval-ns",
+				 &imod_interval_ns);
+	device_property_read_u16(dev, "snps,num-trbs", &num_trbs);
 	dwc->do_fifo_resize = device_property_read_bool(dev,
 							"tx-fifo-resize");
 	if (dwc->do_fifo_resize)
@@ -1692,7 +1705,10 @@ static void dwc3_get_properties(struct dwc3 *dwc)
 	dwc->tx_thr_num_pkt_prd = tx_thr_num_pkt_prd;
 	dwc->tx_max_burst_prd = tx_max_burst_prd;
 
-	dwc->imod_interval = 0;
+	/* IMOD counts in 250ns increments */
+	dwc->imod_interval = min_t(u32, DIV_ROUND_UP(imod_interval_ns, 250),
+				   DWC3_DEV_IMOD_INTERVAL_MASK);
+	dwc->num_trbs = num_trbs;
 
 	dwc->tx_fifo_resize_max_num = tx_fifo_resize_max_num;
 }
@@ -1728,6 +1744,41 @@ static void dwc3_check_params(struct dwc3 *dwc)
 	    DWC3_VER_IS(DWC3, 300A))
 		dwc->imod_interval = 1;
 
+	/* The TRB ring indexes wrap with a mask, keep it a power of two */
+	if (!is_power_of_2(dwc->num_trbs) || dwc->num_trbs < DWC3_TRB_NUM ||
+	    dwc->num_trbs > DWC3_TRB_NUM_MAX) {
+		dev_warn(dev, "invalid number of TRBs %u, using %u\n",
+			 dwc->num_trbs, DWC3_TRB_NUM);
+		dwc->num_trbs = DWC3_TRB_NUM;
+	}
+
+	/*
+	 * The device mode thresholds only exist on DWC_usb3. A threshold needs
+	 * both a packet count and a burst size, and the packet count may not
+	 * exceed the burst size.
+	 */
+	if (dwc->rx_thr_num_pkt || dwc->rx_max_burst) {
+		if (!DWC3_IP_IS(DWC3) || !dwc->rx_thr_num_pkt ||
+		    dwc->rx_thr_num_pkt > 15 || !dwc->rx_max_burst ||
+		    dwc->rx_max_burst > 16 ||
+		    dwc->rx_thr_num_pkt > dwc->rx_max_burst) {
+			dev_warn(dev, "invalid RX threshold, disabling\n");
+			dwc->rx_thr_num_pkt = 0;
+			dwc->rx_max_burst = 0;
+		}
+	}
+
+	if (dwc->tx_thr_num_pkt || dwc->tx_max_burst) {
+		if (!DWC3_IP_IS(DWC3) || !dwc->tx_thr_num_pkt ||
+		    dwc->tx_thr_num_pkt > 15 || !dwc->tx_max_burst ||
+		    dwc->tx_max_burst > 16 ||
+		    dwc->tx_thr_num_pkt > dwc->tx_max_burst) {
+			dev_warn(dev, "invalid TX threshold, disabling\n");
+			dwc->tx_thr_num_pkt = 0;
+			dwc->tx_max_burst = 0;
+		}
+	}
+
 	/* Check the maximum_speed parameter */
 	switch (dwc->maximum_speed) {
 	case USB_SPEED_FULL:
@@ -849,7 +849,7 @@ static int dwc3_trb_ring_show(struct seq_file *s, void *unused)
 
 	seq_puts(s, "buffer_addr,size,type,ioc,isp_imi,csp,chn,lst,hwo\n");
 
-	for (i = 0; i < DWC3_TRB_NUM; i++) {
+	for (i = 0; i < dwc->num_trbs; i++) {
 		struct dwc3_trb *trb = &dep->trb_pool[i];
 		unsigned int type = DWC3_TRBCTL_TYPE(trb->ctrl);
 
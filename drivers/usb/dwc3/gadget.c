@@ -141,16 +141,17 @@ int dwc3_gadget_set_link_state(struct dwc3 *dwc, enum dwc3_link_state state)
 
 /**
  * dwc3_ep_inc_trb - increment a trb index.
+ * @dep: The endpoint owning the TRB ring
  * @index: Pointer to the TRB index to increment.
  *
  * The index should never point to the link TRB. After incrementing,
  * if it is point to the link TRB, wrap around to the beginning. The
  * link TRB is always at the last TRB entry.
  */
-static void dwc3_ep_inc_trb(u8 *index)
+static void dwc3_ep_inc_trb(struct dwc3_ep *dep, u16 *index)
 {
 	(*index)++;
-	if (*index == (DWC3_TRB_NUM - 1))
+	if (*index == (dep->dwc->num_trbs - 1))
 		*index = 0;
 }
 
@@ -160,7 +161,7 @@ static void dwc3_ep_inc_trb(u8 *index)
  */
 static void dwc3_ep_inc_enq(struct dwc3_ep *dep)
 {
-	dwc3_ep_inc_trb(&dep->trb_enqueue);
+	dwc3_ep_inc_trb(dep, &dep->trb_enqueue);
 }
 
 /**
@@ -169,7 +170,7 @@ static void dwc3_ep_inc_enq(struct dwc3_ep *dep)
  */
 static void dwc3_ep_inc_deq(struct dwc3_ep *dep)
 {
-	dwc3_ep_inc_trb(&dep->trb_dequeue);
+	dwc3_ep_inc_trb(dep, &dep->trb_dequeue);
 }
 
 static void dwc3_gadget_del_and_unmap_request(struct dwc3_ep *dep,
@@ -475,7 +476,7 @@ static int dwc3_alloc_trb_pool(struct dwc3_ep *dep)
 		return 0;
 
 	dep->trb_pool = dma_alloc_coherent(dwc->sysdev,
-			sizeof(struct dwc3_trb) * DWC3_TRB_NUM,
+			sizeof(struct dwc3_trb) * dwc->num_trbs,
 			&dep->trb_pool_dma, GFP_KERNEL);
 	if (!dep->trb_pool) {
 		dev_err(dep->dwc->dev, "failed to allocate trb pool for %s\n",
@@ -490,7 +491,7 @@ static void dwc3_free_trb_pool(struct dwc3_ep *dep)
 {
 	struct dwc3		*dwc = dep->dwc;
 
-	dma_free_coherent(dwc->sysdev, sizeof(struct dwc3_trb) * DWC3_TRB_NUM,
+	dma_free_coherent(dwc->sysdev, sizeof(struct dwc3_trb) * dwc->num_trbs,
 			dep->trb_pool, dep->trb_pool_dma);
 
 	dep->trb_pool = NULL;
@@ -897,20 +898,20 @@ int __dwc3_gadget_ep_enable(struct dwc3_ep *dep, unsigned int action)
 
 		/* Initialize the TRB ring */
 		memset(dep->trb_pool, 0,
-		       sizeof(struct dwc3_trb) * DWC3_TRB_NUM);
+		       sizeof(struct dwc3_trb) * dwc->num_trbs);
 
 		if (!dwc->is_hibernated) {
 			/* Initialize the TRB ring */
 			dep->trb_dequeue = 0;
 			dep->trb_enqueue = 0;
 			memset(dep->trb_pool, 0,
-			       sizeof(struct dwc3_trb) * DWC3_TRB_NUM);
+			       sizeof(struct dwc3_trb) * dwc->num_trbs);
 		}
 
 		/* Link TRB. The HWO bit is never reset */
 		trb_st_hw = &dep->trb_pool[0];
 
-		trb_link = &dep->trb_pool[DWC3_TRB_NUM - 1];
+		trb_link = &dep->trb_pool[dwc->num_trbs - 1];
 		trb_link->bpl = lower_32_bits(dwc3_trb_dma_offset(dep, trb_st_hw));
 		trb_link->bph = upper_32_bits(dwc3_trb_dma_offset(dep, trb_st_hw));
 		trb_link->ctrl |= DWC3_TRBCTL_LINK_TRB;
@@ -1171,23 +1172,23 @@ static void dwc3_gadget_ep_free_request(struct usb_ep *ep,
  * index is 0, we will wrap backwards, skip the link TRB, and return
  * the one just before that.
  */
-static struct dwc3_trb *dwc3_ep_prev_trb(struct dwc3_ep *dep, u8 index)
+static struct dwc3_trb *dwc3_ep_prev_trb(struct dwc3_ep *dep, u16 index)
 {
-	u8 tmp = index;
+	u16 tmp = index;
 
 	if (!tmp)
-		tmp = DWC3_TRB_NUM - 1;
+		tmp = dep->dwc->num_trbs - 1;
 
 	return &dep->trb_pool[tmp - 1];
 }
 
 static u32 dwc3_calc_trbs_left(struct dwc3_ep *dep)
 {
-	u8			trbs_left;
+	u16			trbs_left;
 
 	/*
 	 * If the enqueue & dequeue are equal then the TRB ring is either full
-	 * or empty. It's considered full when there are DWC3_TRB_NUM-1 of TRBs
+	 * or empty. It's considered full when there are num_trbs - 1 of TRBs
 	 * pending to be processed by the driver.
 	 */
 	if (dep->trb_enqueue == dep->trb_dequeue) {
@@ -1198,11 +1199,11 @@ static u32 dwc3_calc_trbs_left(struct dwc3_ep *dep)
 		if (!list_empty(&dep->started_list))
 			return 0;
 
-		return DWC3_TRB_NUM - 1;
+		return dep->dwc->num_trbs - 1;
 	}
 
 	trbs_left = dep->trb_dequeue - dep->trb_enqueue;
-	trbs_left &= (DWC3_TRB_NUM - 1);
+	trbs_left &= (dep->dwc->num_trbs - 1);
 
 	if (dep->trb_dequeue < dep->trb_enqueue)
 		trbs_left--;
@@ -2754,8 +2755,31 @@ static int __dwc3_gadget_start(struct dwc3 *dwc)
 	else
 		reg &= ~DWC31_GRXTHRCFG_PKTCNTSEL;
 
+	/*
+	 * An explicitly configured threshold wins over the NUMP based
+	 * throttling above: the FIFO is only drained to (or filled from)
+	 * memory once the given number of packets is available.
+	 */
+	if (dwc->rx_thr_num_pkt) {
+		reg &= ~(DWC3_GRXTHRCFG_RXPKTCNT(~0) |
+			 DWC3_GRXTHRCFG_MAXRXBURSTSIZE(~0));
+		reg |= DWC3_GRXTHRCFG_PKTCNTSEL |
+		       DWC3_GRXTHRCFG_RXPKTCNT(dwc->rx_thr_num_pkt) |
+		       DWC3_GRXTHRCFG_MAXRXBURSTSIZE(dwc->rx_max_burst);
+	}
+
 	dwc3_writel(dwc->regs, DWC3_GRXTHRCFG, reg);
 
+	if (dwc->tx_thr_num_pkt) {
+		reg = dwc3_readl(dwc->regs, DWC3_GTXTHRCFG);
+		reg &= ~(DWC3_GTXTHRCFG_TXPKTCNT(~0) |
+			 DWC3_GTXTHRCFG_MAXTXBURSTSIZE(~0));
+		reg |= DWC3_GTXTHRCFG_PKTCNTSEL |
+		       DWC3_GTXTHRCFG_TXPKTCNT(dwc->tx_thr_num_pkt) |
+		       DWC3_GTXTHRCFG_MAXTXBURSTSIZE(dwc->tx_max_burst);
+		dwc3_writel(dwc->regs, DWC3_GTXTHRCFG, reg);
+	}
+
 	dwc3_gadget_setup_nump(dwc);
 
 	/*
@@ -157,7 +157,7 @@ static int restore_eps(struct dwc3 *dwc)
 			u32 cmd;
 			struct dwc3_gadget_ep_cmd_params params;
 			struct dwc3_trb *trb;
-			u8 trb_dequeue = dep->trb_dequeue;
+			u16 trb_dequeue = dep->trb_dequeue;
 
 			trb = &dep->trb_pool[trb_dequeue];
 
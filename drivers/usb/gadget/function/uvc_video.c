@@ -126,6 +126,84 @@ uvc_video_encode_bulk(struct usb_request *req, struct uvc_video *video,
 		video->payload_size = 0;
 }
 
+/*
+ * A bulk payload spans several requests, only the first one of them starts
+ * with the header, which is sent from the request header buffer. The video
+ * data is sent straight from the pages of the buffer, so that imported
+ * dma-bufs are never touched by the CPU.
+ */
+static void
+uvc_video_encode_bulk_sg(struct usb_request *req, struct uvc_video *video,
+		struct uvc_buffer *buf)
+{
+	unsigned int pending = buf->bytesused - video->queue.buf_used;
+	struct uvc_request *ureq = req->context;
+	struct scatterlist *sg = ureq->sgt.sgl;
+	unsigned int len = video->req_size;
+	unsigned int header_len = 0, nbytes = 0, nents = 0;
+	unsigned int sg_left, part;
+
+	sg_init_table(sg, ureq->sgt.nents);
+
+	/* Add a header at the beginning of the payload. */
+	if (video->payload_size == 0) {
+		header_len = uvc_video_encode_header(video, buf, ureq->header,
+						     len);
+		sg_set_buf(sg, ureq->header, header_len);
+		sg = sg_next(sg);
+		nents++;
+		video->payload_size += header_len;
+		len -= header_len;
+	}
+
+	/* Process video data. */
+	len = min3(len, video->max_payload_size - video->payload_size,
+		   pending);
+
+	while (len && buf->sg && sg) {
+		sg_left = buf->sg->length - buf->offset;
+		part = min(len, sg_left);
+
+		sg_set_page(sg, sg_page(buf->sg), part,
+			    buf->sg->offset + buf->offset);
+		sg = sg_next(sg);
+		nents++;
+
+		if (part == sg_left) {
+			buf->offset = 0;
+			buf->sg = sg_next(buf->sg);
+		} else {
+			buf->offset += part;
+		}
+		nbytes += part;
+		len -= part;
+	}
+
+	req->buf = NULL;
+	req->sg = ureq->sgt.sgl;
+	req->num_sgs = nents;
+	req->length = header_len + nbytes;
+
+	video->queue.buf_used += nbytes;
+	video->payload_size += nbytes;
+	req->zero = video->payload_size == video->max_payload_size;
+
+	if (buf->bytesused == video->queue.buf_used || !buf->sg) {
+		video->queue.buf_used = 0;
+		buf->state = UVC_BUF_STATE_DONE;
+		buf->offset = 0;
+		list_del(&buf->queue);
+		video->fid ^= UVC_STREAM_FID;
+		ureq->last_buf = buf;
+
+		video->payload_size = 0;
+	}
+
+	if (video->payload_size == video->max_payload_size ||
+	    video->queue.flags & UVC_QUEUE_DROP_INCOMPLETE)
+		video->payload_size = 0;
+}
+
 static void
 uvc_video_encode_isoc_sg(struct usb_request *req, struct uvc_video *video,
 		struct uvc_buffer *buf)
@@ -490,7 +568,8 @@ int uvcg_video_enable(struct uvc_video *video, int enable)
 		return ret;
 
 	if (video->max_payload_size) {
-		video->encode = uvc_video_encode_bulk;
+		video->encode = video->queue.use_sg ?
+			uvc_video_encode_bulk_sg : uvc_video_encode_bulk;
 		video->payload_size = 0;
 	} else
 		video->encode = video->queue.use_sg ?
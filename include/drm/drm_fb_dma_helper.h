@@ -4,6 +4,7 @@
 
 #include <linux/types.h>
 
+struct device;
 struct drm_device;
 struct drm_framebuffer;
 struct drm_plane_state;
@@ -18,6 +19,9 @@ dma_addr_t drm_fb_dma_get_gem_addr(struct drm_framebuffer *fb,
 void drm_fb_dma_sync_non_coherent(struct drm_device *drm,
 				  struct drm_plane_state *old_state,
 				  struct drm_plane_state *state);
+void drm_fb_dma_sync_non_coherent_dev(struct device *dev,
+				      struct drm_plane_state *old_state,
+				      struct drm_plane_state *state);
 
 #endif
 
@@ -35,6 +35,7 @@
  */
 
 #include <linux/kref.h>
+#include <linux/dma-direction.h>
 #include <linux/dma-resv.h>
 
 #include <drm/drm_vma_manager.h>
@@ -151,6 +152,29 @@ struct drm_gem_object_funcs {
 	 */
 	void (*vunmap)(struct drm_gem_object *obj, struct iosys_map *map);
 
+	/**
+	 * @begin_cpu_access:
+	 *
+	 * Makes the buffer coherent for an access by the CPU in direction
+	 * @dir. Used by the drm_gem_dmabuf_begin_cpu_access() helper.
+	 *
+	 * This callback is optional.
+	 */
+	int (*begin_cpu_access)(struct drm_gem_object *obj,
+				enum dma_data_direction dir);
+
+	/**
+	 * @end_cpu_access:
+	 *
+	 * Makes the buffer coherent for the device again after a CPU access
+	 * in direction @dir. Used by the drm_gem_dmabuf_end_cpu_access()
+	 * helper.
+	 *
+	 * This callback is optional.
+	 */
+	int (*end_cpu_access)(struct drm_gem_object *obj,
+			      enum dma_data_direction dir);
+
 	/**
 	 * @mmap:
 	 *
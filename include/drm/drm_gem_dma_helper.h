@@ -34,6 +34,8 @@ struct drm_gem_dma_object {
 
 struct drm_gem_dma_object *drm_gem_dma_create(struct drm_device *drm,
 					      size_t size);
+struct drm_gem_dma_object *
+drm_gem_dma_create_noncoherent(struct drm_device *drm, size_t size);
 void drm_gem_dma_free(struct drm_gem_dma_object *dma_obj);
 void drm_gem_dma_print_info(const struct drm_gem_dma_object *dma_obj,
 			    struct drm_printer *p, unsigned int indent);
@@ -41,6 +43,10 @@ struct sg_table *drm_gem_dma_get_sg_table(struct drm_gem_dma_object *dma_obj);
 int drm_gem_dma_vmap(struct drm_gem_dma_object *dma_obj,
 		     struct iosys_map *map);
 int drm_gem_dma_mmap(struct drm_gem_dma_object *dma_obj, struct vm_area_struct *vma);
+int drm_gem_dma_begin_cpu_access(struct drm_gem_dma_object *dma_obj,
+				 enum dma_data_direction dir);
+int drm_gem_dma_end_cpu_access(struct drm_gem_dma_object *dma_obj,
+			       enum dma_data_direction dir);
 
 extern const struct vm_operations_struct drm_gem_dma_vm_ops;
 
@@ -133,6 +139,50 @@ static inline int drm_gem_dma_object_mmap(struct drm_gem_object *obj, struct vm_
 	return drm_gem_dma_mmap(dma_obj, vma);
 }
 
+/**
+ * drm_gem_dma_object_begin_cpu_access - GEM object function for
+ *	drm_gem_dma_begin_cpu_access()
+ * @obj: GEM object
+ * @dir: direction of the access
+ *
+ * This function wraps drm_gem_dma_begin_cpu_access(). Drivers that employ the
+ * DMA helpers should use it as their &drm_gem_object_funcs.begin_cpu_access
+ * handler.
+ *
+ * Returns:
+ * 0 on success or a negative error code on failure.
+ */
+static inline int
+drm_gem_dma_object_begin_cpu_access(struct drm_gem_object *obj,
+				    enum dma_data_direction dir)
+{
+	struct drm_gem_dma_object *dma_obj = to_drm_gem_dma_obj(obj);
+
+	return drm_gem_dma_begin_cpu_access(dma_obj, dir);
+}
+
+/**
+ * drm_gem_dma_object_end_cpu_access - GEM object function for
+ *	drm_gem_dma_end_cpu_access()
+ * @obj: GEM object
+ * @dir: direction of the access
+ *
+ * This function wraps drm_gem_dma_end_cpu_access(). Drivers that employ the
+ * DMA helpers should use it as their &drm_gem_object_funcs.end_cpu_access
+ * handler.
+ *
+ * Returns:
+ * 0 on success or a negative error code on failure.
+ */
+static inline int
+drm_gem_dma_object_end_cpu_access(struct drm_gem_object *obj,
+				  enum dma_data_direction dir)
+{
+	struct drm_gem_dma_object *dma_obj = to_drm_gem_dma_obj(obj);
+
+	return drm_gem_dma_end_cpu_access(dma_obj, dir);
+}
+
 /*
  * Driver ops
  */
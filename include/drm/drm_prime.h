@@ -32,6 +32,7 @@
 #ifndef __DRM_PRIME_H__
 #define __DRM_PRIME_H__
 
+#include <linux/list.h>
 #include <linux/mutex.h>
 #include <linux/rbtree.h>
 #include <linux/scatterlist.h>
@@ -40,13 +41,16 @@
  * struct drm_prime_file_private - per-file tracking for PRIME
  *
  * This just contains the internal &struct dma_buf and handle caches for each
- * &struct drm_file used by the PRIME core code.
+ * &struct drm_file used by the PRIME core code, and the small LRU of recently
+ * imported buffer objects kept alive across handle closes.
  */
 struct drm_prime_file_private {
 /* private: */
 	struct mutex lock;
 	struct rb_root dmabufs;
 	struct rb_root handles;
+	struct list_head imports;
+	unsigned int num_imports;
 };
 
 struct device;
@@ -85,6 +89,10 @@ void drm_gem_unmap_dma_buf(struct dma_buf_attachment *attach,
 			   enum dma_data_direction dir);
 int drm_gem_dmabuf_vmap(struct dma_buf *dma_buf, struct iosys_map *map);
 void drm_gem_dmabuf_vunmap(struct dma_buf *dma_buf, struct iosys_map *map);
+int drm_gem_dmabuf_begin_cpu_access(struct dma_buf *dma_buf,
+				    enum dma_data_direction dir);
+int drm_gem_dmabuf_end_cpu_access(struct dma_buf *dma_buf,
+				  enum dma_data_direction dir);
 
 int drm_gem_prime_mmap(struct drm_gem_object *obj, struct vm_area_struct *vma);
 int drm_gem_dmabuf_mmap(struct dma_buf *dma_buf, struct vm_area_struct *vma);
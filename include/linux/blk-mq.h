@@ -662,6 +662,11 @@ enum {
 	 */
 	BLK_MQ_F_STACKING	= 1 << 2,
 	BLK_MQ_F_TAG_HCTX_SHARED = 1 << 3,
+	/*
+	 * Default the queues to adaptive hybrid polling (io_poll_delay 0)
+	 * instead of classic busy polling.
+	 */
+	BLK_MQ_F_HYBRID_POLL	= 1 << 4,
 	BLK_MQ_F_BLOCKING	= 1 << 5,
 	/* Do not allow an I/O scheduler to be configured. */
 	BLK_MQ_F_NO_SCHED	= 1 << 6,
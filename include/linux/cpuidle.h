@@ -39,6 +39,10 @@ struct cpuidle_state_usage {
 	unsigned long long	above; /* Number of times it's been too deep */
 	unsigned long long	below; /* Number of times it's been too shallow */
 	unsigned long long	rejected; /* Number of times idle entry was rejected */
+	/* Wake-up delays past the next timer event, see measure_latency */
+	unsigned long long	latency_samples;
+	u64			latency_avg_ns;
+	u64			latency_max_ns;
 #ifdef CONFIG_SUSPEND
 	unsigned long long	s2idle_usage;
 	unsigned long long	s2idle_time; /* in US */
@@ -274,6 +278,33 @@ struct cpuidle_governor {
 extern int cpuidle_register_governor(struct cpuidle_governor *gov);
 extern s64 cpuidle_governor_latency_req(unsigned int cpu);
 
+extern bool cpuidle_use_measured_latency;
+
+#define CPUIDLE_LATENCY_MIN_SAMPLES	16
+
+/**
+ * cpuidle_state_exit_latency_ns - exit latency for the governor to check
+ * @drv: the cpuidle driver
+ * @dev: the cpuidle device
+ * @idx: index of the idle state
+ *
+ * Returns the declared exit latency of the state, or the latency measured on
+ * @dev once enough samples have been taken and the use_measured_latency
+ * parameter is set.
+ */
+static inline s64 cpuidle_state_exit_latency_ns(struct cpuidle_driver *drv,
+						struct cpuidle_device *dev,
+						int idx)
+{
+	struct cpuidle_state_usage *su = &dev->states_usage[idx];
+
+	if (READ_ONCE(cpuidle_use_measured_latency) &&
+	    READ_ONCE(su->latency_samples) >= CPUIDLE_LATENCY_MIN_SAMPLES)
+		return READ_ONCE(su->latency_avg_ns);
+
+	return drv->states[idx].exit_latency_ns;
+}
+
 #define __CPU_PM_CPU_IDLE_ENTER(low_level_idle_enter,			\
 				idx,					\
 				state,					\
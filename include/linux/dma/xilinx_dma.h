@@ -24,6 +24,10 @@
  * @reset: Reset Channel
  * @ext_fsync: External Frame Sync source
  * @vflip_en:  Vertical Flip enable
+ * @num_fstores: Number of frame stores to cycle through, up to the number
+ *		 the IP was built with, 0 to keep the current number. Can only
+ *		 be changed while the channel is halted, and only on IPs built
+ *		 with a writable frame store register.
  */
 struct xilinx_vdma_config {
 	int frm_dly;
@@ -37,9 +41,42 @@ struct xilinx_vdma_config {
 	int reset;
 	int ext_fsync;
 	bool vflip_en;
+	int num_fstores;
 };
 
 int xilinx_vdma_channel_set_config(struct dma_chan *dchan,
 					struct xilinx_vdma_config *cfg);
 
+/**
+ * enum xilinx_dma_poll_mode - AXI DMA/CDMA completion mode
+ * @XILINX_DMA_POLL_NONE: Completions are signalled by the IOC interrupt
+ * @XILINX_DMA_POLL_ALWAYS: The IOC interrupt stays masked, completions are
+ *			    picked up by dmaengine_tx_status() only
+ * @XILINX_DMA_POLL_HYBRID: dmaengine_tx_status() masks the IOC interrupt and
+ *			    spins for up to the poll budget before re-arming it
+ */
+enum xilinx_dma_poll_mode {
+	XILINX_DMA_POLL_NONE = 0,
+	XILINX_DMA_POLL_ALWAYS,
+	XILINX_DMA_POLL_HYBRID,
+};
+
+/**
+ * struct xilinx_dma_peripheral_config - AXI DMA/CDMA/MCDMA peripheral_config
+ * @poll_mode: Completion mode, AXI DMA/CDMA only
+ * @poll_budget_us: Spin time for XILINX_DMA_POLL_HYBRID in microseconds
+ * @weight: Weight of an AXI MCDMA MM2S channel in the weighted round robin
+ *	    scheduler, from 1 to XILINX_MCDMA_WEIGHT_MAX. 0 keeps the current
+ *	    weight. The scheduler shares the MM2S bandwidth between the busy
+ *	    channels in proportion to their weights; it has no effect when the
+ *	    IP is built with the strict priority scheduler.
+ */
+struct xilinx_dma_peripheral_config {
+	enum xilinx_dma_poll_mode poll_mode;
+	u32 poll_budget_us;
+	u32 weight;
+};
+
+#define XILINX_MCDMA_WEIGHT_MAX		15
+
 #endif
@@ -13,6 +13,9 @@
 #define __XILINX_FRMBUF_DMA_H
 
 #include <linux/dmaengine.h>
+#include <linux/err.h>
+
+struct dma_fence;
 
 /* Modes to enable early callback */
 /* To avoid first frame delay */
@@ -187,6 +190,24 @@ int xilinx_xdma_get_earlycb(struct dma_chan *chan,
 int xilinx_xdma_set_earlycb(struct dma_chan *chan,
 			    struct dma_async_tx_descriptor *async_tx,
 			    u32 earlycb);
+
+/**
+ * xilinx_xdma_get_timestamp - Get the capture times of a frame
+ * @chan: dma channel instance
+ * @async_tx: dma async tx descriptor for the buffer
+ * @sof_ns: Output param - time the IP started on the frame, 0 if not yet
+ * @eof_ns: Output param - time the IP completed the frame, 0 if not yet
+ *
+ * Both times are CLOCK_MONOTONIC, taken from the interrupt handler or when
+ * the frame is programmed, not when the descriptor callback runs. Must be
+ * called before the descriptor callback returns.
+ *
+ * Return: 0 on success, -EINVAL in case of invalid chan
+ */
+int xilinx_xdma_get_timestamp(struct dma_chan *chan,
+			      struct dma_async_tx_descriptor *async_tx,
+			      u64 *sof_ns, u64 *eof_ns);
+
 /**
  * xilinx_xdma_get_width_align - Get width alignment value
  *
@@ -197,6 +218,75 @@ int xilinx_xdma_set_earlycb(struct dma_chan *chan,
  */
 int xilinx_xdma_get_width_align(struct dma_chan *chan, u32 *width_align);
 
+/**
+ * xilinx_xdma_set_prefetch - Program frame registers one frame ahead
+ * @chan: dma channel instance
+ * @enable: true to program the next frame while the current one runs
+ *
+ * Only effective in auto-restart mode. The next pending descriptor is
+ * written to the frame registers as soon as the IP has latched the
+ * current one, instead of when the current frame is done, and a frame
+ * completes at the end of its own transfer rather than one frame later.
+ * This call must be made while the channel is idle, prior to
+ * dma_async_issue_pending(). It works alongside the early callback modes.
+ *
+ * Return: 0 on success, -EBUSY if the channel is running, -EINVAL in case
+ * of invalid chan
+ */
+int xilinx_xdma_set_prefetch(struct dma_chan *chan, bool enable);
+
+/**
+ * xilinx_xdma_set_bandwidth - Reserve the DDR bandwidth of a stream
+ * @chan: dma channel instance
+ * @width: Width of the frames in pixels
+ * @height: Height of the frames in lines
+ * @fps: Frame rate, 0 to release the reservation
+ *
+ * The bandwidth is computed from the video format, which must have been
+ * set beforehand, and the frame size and rate. When the ddr_budget_mbps
+ * module parameter is set, the reservations of all the framebuffer
+ * channels must fit in it, so that a pipeline that would oversubscribe the
+ * DDR is refused when it is set up rather than dropping frames later on.
+ * The reservation and the bandwidth actually used are reported in the
+ * bandwidth file of the dma device in debugfs.
+ *
+ * Return: 0 on success, -ENOSPC if the budget would be exceeded, -EINVAL in
+ * case of invalid chan or parameters
+ */
+int xilinx_xdma_set_bandwidth(struct dma_chan *chan, u32 width, u32 height,
+			      u32 fps);
+
+/**
+ * xilinx_xdma_set_qos - Set the QoS of the transfers of a channel
+ * @chan: dma channel instance
+ * @qos: AXI QoS, from 0 to 15
+ *
+ * Program the read or write QoS of the ZynqMP AFI FM port given by the
+ * xlnx,afi-qos property of the IP, which the DDR controller uses to
+ * arbitrate between the ports.
+ *
+ * Return: 0 on success, -ENODEV if the port is not described, -EINVAL in
+ * case of invalid chan or QoS
+ */
+int xilinx_xdma_set_qos(struct dma_chan *chan, u32 qos);
+
+/**
+ * xilinx_xdma_get_fence - Get the completion fence of a frame
+ * @chan: dma channel instance
+ * @async_tx: submitted dma async tx descriptor for the buffer
+ *
+ * The fence is signalled from the interrupt handler when the frame is
+ * complete, without waiting for the descriptor callback, so that a
+ * display or encode pipeline can wait on it directly. It is signalled
+ * with -ECANCELED if the channel is terminated first. Must be called
+ * after dmaengine_submit() and before the descriptor callback has run.
+ *
+ * Return: A fence reference owned by the caller, or an error pointer
+ */
+struct dma_fence *
+xilinx_xdma_get_fence(struct dma_chan *chan,
+		      struct dma_async_tx_descriptor *async_tx);
+
 #else
 static inline void xilinx_xdma_set_mode(struct dma_chan *chan,
 					enum operation_mode mode)
@@ -249,10 +339,41 @@ static inline int xilinx_xdma_set_earlycb(struct dma_chan *chan,
 	return -ENODEV;
 }
 
+static inline int
+xilinx_xdma_get_timestamp(struct dma_chan *chan,
+			  struct dma_async_tx_descriptor *async_tx,
+			  u64 *sof_ns, u64 *eof_ns)
+{
+	return -ENODEV;
+}
+
 static inline int xilinx_xdma_get_width_align(struct dma_chan *chan, u32 *width_align)
 {
 	return -ENODEV;
 }
+
+static inline int xilinx_xdma_set_prefetch(struct dma_chan *chan, bool enable)
+{
+	return -ENODEV;
+}
+
+static inline int xilinx_xdma_set_bandwidth(struct dma_chan *chan, u32 width,
+					    u32 height, u32 fps)
+{
+	return -ENODEV;
+}
+
+static inline int xilinx_xdma_set_qos(struct dma_chan *chan, u32 qos)
+{
+	return -ENODEV;
+}
+
+static inline struct dma_fence *
+xilinx_xdma_get_fence(struct dma_chan *chan,
+		      struct dma_async_tx_descriptor *async_tx)
+{
+	return ERR_PTR(-ENODEV);
+}
 #endif
 
 #endif /*__XILINX_FRMBUF_DMA_H*/
@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Platform data for the Xilinx XDMA PCIe DMA engine
+ *
+ * Copyright (C) 2023 Xilinx, Inc. All rights reserved.
+ */
+
+#ifndef __LINUX_DMA_XILINX_XDMA_H
+#define __LINUX_DMA_XILINX_XDMA_H
+
+#include <linux/dmaengine.h>
+#include <linux/types.h>
+
+/**
+ * struct xilinx_xdma_chan_info - Channel selector for a dma_slave_map entry
+ * @dir: DMA_MEM_TO_DEV for an H2C channel, DMA_DEV_TO_MEM for a C2H one
+ */
+struct xilinx_xdma_chan_info {
+	enum dma_transfer_direction dir;
+};
+
+/**
+ * struct xilinx_xdma_platdata - Platform data of an XDMA engine
+ * @max_dma_channels: Highest number of channels to probe per direction
+ * @device_map_cnt: Number of entries in @device_map
+ * @device_map: Slave map the clients request their channels through, with
+ *		a &struct xilinx_xdma_chan_info as the parameter of each entry
+ *
+ * The engine is normally instantiated by the PCI driver of the function that
+ * carries it. The memory resource is the DMA register BAR. The IRQ resource
+ * spans one MSI-X vector per channel, H2C channels first; a channel without
+ * a vector is completed by polling from dmaengine_tx_status().
+ */
+struct xilinx_xdma_platdata {
+	u32 max_dma_channels;
+	u32 device_map_cnt;
+	struct dma_slave_map *device_map;
+};
+
+#endif /* __LINUX_DMA_XILINX_XDMA_H */
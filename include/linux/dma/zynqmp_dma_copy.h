@@ -0,0 +1,45 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * ZynqMP DMA memory copy offload
+ *
+ * Copyright (C) 2023 Xilinx, Inc. All rights reserved.
+ */
+
+#ifndef __DMA_ZYNQMP_DMA_COPY_H
+#define __DMA_ZYNQMP_DMA_COPY_H
+
+#include <linux/dmaengine.h>
+#include <linux/scatterlist.h>
+
+struct dma_fence;
+
+#if IS_ENABLED(CONFIG_XILINX_ZYNQMP_DMA_COPY)
+struct dma_chan *zynqmp_dma_copy_get(size_t len);
+void zynqmp_dma_copy_put(struct dma_chan *chan);
+struct dma_fence *zynqmp_dma_copy_submit(struct dma_chan *chan,
+					 struct scatterlist *dst_sg,
+					 unsigned int dst_nents,
+					 struct scatterlist *src_sg,
+					 unsigned int src_nents,
+					 void (*done)(void *data), void *data);
+#else
+static inline struct dma_chan *zynqmp_dma_copy_get(size_t len)
+{
+	return NULL;
+}
+
+static inline void zynqmp_dma_copy_put(struct dma_chan *chan)
+{
+}
+
+static inline struct dma_fence *
+zynqmp_dma_copy_submit(struct dma_chan *chan, struct scatterlist *dst_sg,
+		       unsigned int dst_nents, struct scatterlist *src_sg,
+		       unsigned int src_nents, void (*done)(void *data),
+		       void *data)
+{
+	return ERR_PTR(-ENODEV);
+}
+#endif
+
+#endif /* __DMA_ZYNQMP_DMA_COPY_H */
@@ -35,6 +35,44 @@ struct sg_table;
  * @FPGA_MGR_STATE_WRITE_COMPLETE_ERR: Error during WRITE_COMPLETE
  * @FPGA_MGR_STATE_OPERATING: FPGA is programmed and operating
  */
+/**
+ * enum fpga_mgr_phase - timed phases of an FPGA reconfiguration
+ * @FPGA_MGR_PHASE_FIRMWARE: requesting the image from the firmware class
+ * @FPGA_MGR_PHASE_WRITE_INIT: header parsing and write_init
+ * @FPGA_MGR_PHASE_WRITE: writing the image, copy and configuration
+ * @FPGA_MGR_PHASE_WRITE_COMPLETE: write_complete
+ * @FPGA_MGR_PHASE_COPY: copy of the image into a DMA buffer
+ * @FPGA_MGR_PHASE_CONFIG: configuration call into the platform firmware
+ * @FPGA_MGR_PHASE_BRIDGES_DISABLE: disabling the bridges of a region
+ * @FPGA_MGR_PHASE_BRIDGES_ENABLE: enabling the bridges of a region
+ * @FPGA_MGR_PHASE_READBACK: configuration data readback
+ * @FPGA_MGR_PHASE_DECOMPRESS: decompression of a gzip or zstd image
+ * @FPGA_MGR_PHASE_MAX: number of phases
+ */
+enum fpga_mgr_phase {
+	FPGA_MGR_PHASE_FIRMWARE,
+	FPGA_MGR_PHASE_WRITE_INIT,
+	FPGA_MGR_PHASE_WRITE,
+	FPGA_MGR_PHASE_WRITE_COMPLETE,
+	FPGA_MGR_PHASE_COPY,
+	FPGA_MGR_PHASE_CONFIG,
+	FPGA_MGR_PHASE_BRIDGES_DISABLE,
+	FPGA_MGR_PHASE_BRIDGES_ENABLE,
+	FPGA_MGR_PHASE_READBACK,
+	FPGA_MGR_PHASE_DECOMPRESS,
+	FPGA_MGR_PHASE_MAX,
+};
+
+/**
+ * struct fpga_mgr_phase_stats - duration of the last run of a phase
+ * @ns: duration in nanoseconds
+ * @bytes: number of image bytes processed, 0 if not applicable
+ */
+struct fpga_mgr_phase_stats {
+	u64 ns;
+	u64 bytes;
+};
+
 enum fpga_mgr_states {
 	/* default FPGA states */
 	FPGA_MGR_STATE_UNKNOWN,
@@ -233,6 +271,9 @@ struct fpga_manager_ops {
  * @priv: low level driver private date
  * @err: low level driver error code
  * @dir: debugfs image directory
+ * @image_cache: list of preloaded firmware images
+ * @image_lock: protects @image_cache
+ * @stats: duration of the phases of the last reconfiguration
  */
 struct fpga_manager {
 	const char *name;
@@ -250,6 +291,9 @@ struct fpga_manager {
 #ifdef CONFIG_FPGA_MGR_DEBUG_FS
 	struct dentry *dir;
 #endif
+	struct list_head image_cache;
+	struct mutex image_lock;
+	struct fpga_mgr_phase_stats stats[FPGA_MGR_PHASE_MAX];
 };
 
 #define to_fpga_manager(d) container_of(d, struct fpga_manager, dev)
@@ -260,7 +304,11 @@ void fpga_image_info_free(struct fpga_image_info *info);
 
 int fpga_mgr_load(struct fpga_manager *mgr, struct fpga_image_info *info);
 
+void fpga_mgr_record_phase(struct fpga_manager *mgr,
+			   enum fpga_mgr_phase phase, ktime_t start, u64 bytes);
+
 int fpga_mgr_lock(struct fpga_manager *mgr);
+void fpga_mgr_lock_wait(struct fpga_manager *mgr);
 void fpga_mgr_unlock(struct fpga_manager *mgr);
 
 struct fpga_manager *of_fpga_mgr_get(struct device_node *node);
@@ -6,6 +6,7 @@
 #include <linux/device.h>
 #include <linux/fpga/fpga-mgr.h>
 #include <linux/fpga/fpga-bridge.h>
+#include <linux/workqueue.h>
 
 struct fpga_region;
 
@@ -38,6 +39,10 @@ struct fpga_region_info {
  * @compat_id: FPGA region id for compatibility check.
  * @priv: private data
  * @get_bridges: optional function to get bridges to a list
+ * @program_work: work programming the region asynchronously
+ * @program_status: result of the last asynchronous programming, -EINPROGRESS
+ *		    while it is queued or running
+ * @fw_info: FPGA image info owned by the firmware sysfs attribute
  */
 struct fpga_region {
 	struct device dev;
@@ -48,6 +53,9 @@ struct fpga_region {
 	struct fpga_compat_id *compat_id;
 	void *priv;
 	int (*get_bridges)(struct fpga_region *region);
+	struct work_struct program_work;
+	int program_status;
+	struct fpga_image_info *fw_info;
 };
 
 #define to_fpga_region(d) container_of(d, struct fpga_region, dev)
@@ -57,6 +65,7 @@ fpga_region_class_find(struct device *start, const void *data,
 		       int (*match)(struct device *, const void *));
 
 int fpga_region_program_fpga(struct fpga_region *region);
+int fpga_region_program_fpga_async(struct fpga_region *region);
 
 struct fpga_region *
 fpga_region_register_full(struct device *parent, const struct fpga_region_info *info);
@@ -11,11 +11,15 @@
 #include <linux/kref.h>
 #include <linux/spinlock.h>
 #include <linux/mutex.h>
+#include <linux/workqueue.h>
 #include <linux/iio/buffer_impl.h>
 
 struct iio_dma_buffer_queue;
 struct iio_dma_buffer_ops;
+struct iio_dma_buffer_consumer_ops;
 struct device;
+struct dma_buf;
+struct dma_fence;
 
 /**
  * enum iio_block_state - State of a struct iio_dma_buffer_block
@@ -43,6 +47,10 @@ enum iio_block_state {
  * @queue: Parent DMA buffer queue
  * @kref: kref used to manage the lifetime of block
  * @state: Current state of the block
+ * @dmabuf: dma-buf the block is exported as, if any
+ * @fence: Fence signalled when the block is done, while it is queued
+ * @start_timestamp: Time at which the transfer of the block started
+ * @sample_counter: Stream index of the first sample of the block
  */
 struct iio_dma_buffer_block {
 	/* May only be accessed by the owner of the block */
@@ -64,6 +72,15 @@ struct iio_dma_buffer_block {
 	 * queue->list_lock if the block is not owned by the core.
 	 */
 	enum iio_block_state state;
+
+	/* Must not be accessed outside the core. Protected by queue->lock. */
+	struct dma_buf *dmabuf;
+	/* Must not be accessed outside the core. Taken with xchg(). */
+	struct dma_fence *fence;
+
+	/* Must not be accessed outside the core. Protected by list_lock. */
+	u64 start_timestamp;
+	u64 sample_counter;
 };
 
 /**
@@ -95,6 +112,17 @@ struct iio_dma_buffer_queue_fileio {
  * @outgoing: List of buffers on the outgoing queue
  * @active: Whether the buffer is currently active
  * @fileio: FileIO state
+ * @fence_context: Fence context of the blocks exported as dma-bufs
+ * @fence_seqno: Sequence number of the last fence of @fence_context
+ * @ring: Completion ring shared with the application, if set up
+ * @ring_head: Kernel copy of the head index of @ring
+ * @num_active: Number of blocks submitted to the DMA and not yet done
+ * @sample_counter: Number of samples transferred since the buffer was enabled
+ * @last_timestamp: Completion time of the last block
+ * @consumer_ops: Callbacks of the in-kernel consumer, if one is attached.
+ *   Written with both @lock and @list_lock held
+ * @consumer_private: Private data passed to @consumer_ops
+ * @consumer_work: Hands completed blocks to the in-kernel consumer
  */
 struct iio_dma_buffer_queue {
 	struct iio_buffer buffer;
@@ -117,6 +145,20 @@ struct iio_dma_buffer_queue {
 	unsigned int max_offset;
 
 	struct iio_dma_buffer_queue_fileio fileio;
+
+	u64 fence_context;
+	u64 fence_seqno;
+
+	struct iio_buffer_block_ring *ring;
+	u32 ring_head;
+
+	unsigned int num_active;
+	u64 sample_counter;
+	u64 last_timestamp;
+
+	const struct iio_dma_buffer_consumer_ops *consumer_ops;
+	void *consumer_private;
+	struct work_struct consumer_work;
 };
 
 /**
@@ -130,6 +172,18 @@ struct iio_dma_buffer_ops {
 	void (*abort)(struct iio_dma_buffer_queue *queue);
 };
 
+/**
+ * struct iio_dma_buffer_consumer_ops - In-kernel DMA buffer consumer callbacks
+ * @block_done: Called from process context for each completed block. The
+ *   consumer owns the block, and may read its data as well as its size,
+ *   timestamps and sample counter, until it hands it back with
+ *   iio_dma_buffer_consumer_release_block(). A block with bytes_used of 0
+ *   has been aborted.
+ */
+struct iio_dma_buffer_consumer_ops {
+	void (*block_done)(struct iio_dma_buffer_block *block, void *private);
+};
+
 void iio_dma_buffer_block_done(struct iio_dma_buffer_block *block);
 void iio_dma_buffer_block_list_abort(struct iio_dma_buffer_queue *queue,
 	struct list_head *list);
@@ -140,6 +194,8 @@ int iio_dma_buffer_disable(struct iio_buffer *buffer,
 	struct iio_dev *indio_dev);
 int iio_dma_buffer_read(struct iio_buffer *buffer, size_t n,
 	char __user *user_buffer);
+int iio_dma_buffer_read_iter(struct iio_buffer *buffer, size_t n,
+	struct iov_iter *to);
 size_t iio_dma_buffer_data_available(struct iio_buffer *buffer);
 int iio_dma_buffer_set_bytes_per_datum(struct iio_buffer *buffer, size_t bpd);
 int iio_dma_buffer_set_length(struct iio_buffer *buffer, unsigned int length);
@@ -160,10 +216,22 @@ int iio_dma_buffer_enqueue_block(struct iio_buffer *buffer,
 	struct iio_buffer_block *block);
 int iio_dma_buffer_dequeue_block(struct iio_buffer *buffer,
 	struct iio_buffer_block *block);
+int iio_dma_buffer_dequeue_block_meta(struct iio_buffer *buffer,
+	struct iio_buffer_block_meta *meta);
 int iio_dma_buffer_mmap(struct iio_buffer *buffer,
 	struct vm_area_struct *vma);
+int iio_dma_buffer_export_block(struct iio_buffer *buffer,
+	struct iio_buffer_block_dmabuf *req);
+int iio_dma_buffer_setup_ring(struct iio_buffer *buffer,
+	struct iio_buffer_block_ring_info *info);
 int iio_dma_buffer_write(struct iio_buffer *buf, size_t n,
 	const char __user *user_buffer);
 bool iio_dma_buffer_space_available(struct iio_buffer *buf);
 
+int iio_dma_buffer_attach_consumer(struct iio_buffer *buffer,
+	unsigned int num_blocks, size_t block_size,
+	const struct iio_dma_buffer_consumer_ops *ops, void *private);
+void iio_dma_buffer_detach_consumer(struct iio_buffer *buffer);
+void iio_dma_buffer_consumer_release_block(struct iio_dma_buffer_block *block);
+
 #endif
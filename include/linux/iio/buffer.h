@@ -15,6 +15,8 @@ void iio_buffer_set_attrs(struct iio_buffer *buffer,
 			 const struct attribute **attrs);
 
 int iio_push_to_buffers(struct iio_dev *indio_dev, const void *data);
+int iio_push_to_buffers_n(struct iio_dev *indio_dev, const void *data,
+			  unsigned int n);
 int iio_buffer_remove_sample(struct iio_buffer *buffer, u8 *data);
 
 /**
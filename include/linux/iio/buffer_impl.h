@@ -8,12 +8,23 @@
 
 struct iio_dev;
 struct iio_buffer;
+struct iov_iter;
 
 #define IIO_BLOCK_ALLOC_IOCTL	_IOWR('i', 0xa0, struct iio_buffer_block_alloc_req)
 #define IIO_BLOCK_FREE_IOCTL	_IO('i', 0xa1)
 #define IIO_BLOCK_QUERY_IOCTL	_IOWR('i', 0xa2, struct iio_buffer_block)
 #define IIO_BLOCK_ENQUEUE_IOCTL	_IOWR('i', 0xa3, struct iio_buffer_block)
 #define IIO_BLOCK_DEQUEUE_IOCTL	_IOWR('i', 0xa4, struct iio_buffer_block)
+#define IIO_BLOCK_EXPORT_DMABUF_IOCTL \
+	_IOWR('i', 0xa5, struct iio_buffer_block_dmabuf)
+#define IIO_BLOCK_ENQUEUE_MULTI_IOCTL \
+	_IOWR('i', 0xa6, struct iio_buffer_block_multi)
+#define IIO_BLOCK_DEQUEUE_MULTI_IOCTL \
+	_IOWR('i', 0xa7, struct iio_buffer_block_multi)
+#define IIO_BLOCK_RING_IOCTL \
+	_IOR('i', 0xa8, struct iio_buffer_block_ring_info)
+#define IIO_BLOCK_DEQUEUE_META_IOCTL \
+	_IOWR('i', 0xa9, struct iio_buffer_block_meta)
 
 struct iio_buffer_block_alloc_req {
 	__u32 type;
@@ -22,8 +33,65 @@ struct iio_buffer_block_alloc_req {
 	__u32 id;
 };
 
+/*
+ * Export of a block as a dma-buf: @id selects the block, @flags takes O_CLOEXEC
+ * for the new file descriptor, which is returned in @fd.
+ */
+struct iio_buffer_block_dmabuf {
+	__u32 id;
+	__u32 flags;
+	__s32 fd;
+	__u32 reserved;
+};
+
+/*
+ * Enqueue or dequeue of up to IIO_BLOCK_MULTI_MAX blocks with one ioctl.
+ * @blocks points to an array of @count struct iio_buffer_block; @count is
+ * updated with the number of blocks that were processed.
+ */
+#define IIO_BLOCK_MULTI_MAX	64
+
+struct iio_buffer_block_multi {
+	__u32 count;
+	__u32 reserved;
+	__u64 blocks;
+};
+
+/*
+ * Completion ring, mapped at @offset of the buffer with mmap(). The kernel
+ * adds an entry for each completed block and then advances @head; the
+ * application consumes the entries up to @head and advances @tail. Blocks
+ * that find the ring full are counted in @overflow and are only reported by
+ * the dequeue ioctls. A block taken from the ring may be enqueued again
+ * without being dequeued.
+ */
+#define IIO_BLOCK_RING_ENTRIES	64
+#define IIO_BLOCK_RING_OFFSET	0x80000000
+
+struct iio_buffer_block_ring_entry {
+	__u32 id;
+	__u32 bytes_used;
+};
+
+struct iio_buffer_block_ring {
+	__u32 head;
+	__u32 tail;
+	__u32 overflow;
+	__u32 reserved;
+	struct iio_buffer_block_ring_entry entries[IIO_BLOCK_RING_ENTRIES];
+};
+
+struct iio_buffer_block_ring_info {
+	__u32 offset;
+	__u32 size;
+	__u32 entries;
+	__u32 reserved;
+};
+
 #define IIO_BUFFER_BLOCK_FLAG_TIMESTAMP_VALID (1 << 0)
 #define IIO_BUFFER_BLOCK_FLAG_CYCLIC (1 << 1)
+/* The transfer did not follow the previous one back to back */
+#define IIO_BUFFER_BLOCK_FLAG_OVERFLOW (1 << 2)
 
 struct iio_buffer_block {
 	__u32 id;
@@ -37,6 +105,20 @@ struct iio_buffer_block {
 	__u64 timestamp;
 };
 
+/*
+ * A dequeued block with its capture metadata. @block.timestamp is the
+ * CLOCK_TAI time at which the transfer completed and @start_timestamp the
+ * one at which it started: the submission time if the DMA was idle, else the
+ * completion of the previous block. @sample_counter is the index, counted
+ * from the enabling of the buffer, of the first sample of the block. It is
+ * only exact while no block has IIO_BUFFER_BLOCK_FLAG_OVERFLOW set.
+ */
+struct iio_buffer_block_meta {
+	struct iio_buffer_block block;
+	__u64 start_timestamp;
+	__u64 sample_counter;
+};
+
 /**
  * INDIO_BUFFER_FLAG_FIXED_WATERMARK - Watermark level of the buffer can not be
  *   configured. It has a fixed value which will be buffer specific.
@@ -46,7 +128,11 @@ struct iio_buffer_block {
 /**
  * struct iio_buffer_access_funcs - access functions for buffers.
  * @store_to:		actually store stuff to the buffer
+ * @store_to_n:		store a batch of consecutive scans, returns the
+ *			number of scans stored
  * @read:		try to get a specified number of bytes (must exist)
+ * @read_iter:		same as @read, but into an iov_iter. Backs splice() and
+ *			sendfile() from the buffer chrdev.
  * @data_available:	indicates how much data is available for reading from
  *			the buffer.
  * @request_update:	if a parameter change has been marked, update underlying
@@ -73,7 +159,11 @@ struct iio_buffer_block {
  **/
 struct iio_buffer_access_funcs {
 	int (*store_to)(struct iio_buffer *buffer, const void *data);
+	int (*store_to_n)(struct iio_buffer *buffer, const void *data,
+		unsigned int n);
 	int (*read)(struct iio_buffer *buffer, size_t n, char __user *buf);
+	int (*read_iter)(struct iio_buffer *buffer, size_t n,
+		struct iov_iter *to);
 	size_t (*data_available)(struct iio_buffer *buffer);
 	int (*remove_from)(struct iio_buffer *buffer, void *data);
 	int (*write)(struct iio_buffer *buffer, size_t n,
@@ -97,10 +187,16 @@ struct iio_buffer_access_funcs {
 		struct iio_buffer_block *block);
 	int (*dequeue_block)(struct iio_buffer *buffer,
 		struct iio_buffer_block *block);
+	int (*dequeue_block_meta)(struct iio_buffer *buffer,
+		struct iio_buffer_block_meta *meta);
 	int (*query_block)(struct iio_buffer *buffer,
 		struct iio_buffer_block *block);
 	int (*mmap)(struct iio_buffer *buffer,
 		struct vm_area_struct *vma);
+	int (*export_block)(struct iio_buffer *buffer,
+		struct iio_buffer_block_dmabuf *req);
+	int (*setup_ring)(struct iio_buffer *buffer,
+		struct iio_buffer_block_ring_info *info);
 
 	unsigned int modes;
 	unsigned int flags;
@@ -141,6 +237,12 @@ struct iio_buffer {
 	unsigned int watermark;
 
 	/* private: */
+	/* @wake_count: Scans pushed since the poll queue was last woken. */
+	unsigned int wake_count;
+
+	/* @read_wait: Scans a blocked read() waits for, 0 if none. */
+	unsigned int read_wait;
+
 	/* @scan_timestamp: Does the scan mode include a timestamp. */
 	bool scan_timestamp;
 
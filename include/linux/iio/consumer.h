@@ -169,6 +169,65 @@ struct iio_channel
 struct iio_dev
 *iio_channel_cb_get_iio_dev(const struct iio_cb_buffer *cb_buffer);
 
+struct iio_block_cb_buffer;
+struct iio_dma_buffer_block;
+/**
+ * iio_channel_get_all_block_cb() - register callback for block capture
+ * @dev:		Pointer to client device.
+ * @num_blocks:		Number of blocks to allocate in the DMA buffer.
+ * @block_size:		Size of each block in bytes.
+ * @cb:			Callback function, called from process context with
+ *			each completed block.
+ * @private:		Private data passed to callback.
+ *
+ * The channels must all belong to one device that uses an IIO DMA buffer.
+ * Blocks are passed by reference; the consumer owns each block until it hands
+ * it back with iio_dma_buffer_consumer_release_block(). The buffer can not be
+ * used from userspace while the callback is registered.
+ */
+struct iio_block_cb_buffer *iio_channel_get_all_block_cb(struct device *dev,
+	unsigned int num_blocks, size_t block_size,
+	void (*cb)(struct iio_dma_buffer_block *block, void *private),
+	void *private);
+
+/**
+ * iio_channel_release_all_block_cb() - release and unregister the callback.
+ * @cb_buffer:		The block callback buffer that was allocated.
+ *
+ * The flow of data must have been stopped and all blocks released.
+ */
+void iio_channel_release_all_block_cb(struct iio_block_cb_buffer *cb_buffer);
+
+/**
+ * iio_channel_start_all_block_cb() - start the flow of blocks to the callback.
+ * @cb_buff:		The block callback buffer we are starting.
+ */
+int iio_channel_start_all_block_cb(struct iio_block_cb_buffer *cb_buff);
+
+/**
+ * iio_channel_stop_all_block_cb() - stop the flow of blocks to the callback.
+ * @cb_buff:		The block callback buffer we are stopping.
+ *
+ * Blocks that are in flight are handed to the callback with bytes_used of 0.
+ */
+void iio_channel_stop_all_block_cb(struct iio_block_cb_buffer *cb_buff);
+
+/**
+ * iio_channel_block_cb_get_channels() - get access to the underlying channels.
+ * @cb_buffer:		The block callback buffer from whom we want the channel
+ *			information.
+ */
+struct iio_channel
+*iio_channel_block_cb_get_channels(const struct iio_block_cb_buffer *cb_buffer);
+
+/**
+ * iio_channel_block_cb_get_iio_dev() - get access to the underlying device.
+ * @cb_buffer:		The block callback buffer from whom we want the device
+ *			information.
+ */
+struct iio_dev
+*iio_channel_block_cb_get_iio_dev(const struct iio_block_cb_buffer *cb_buffer);
+
 /**
  * iio_read_channel_raw() - read from a given channel
  * @chan:		The channel being queried.
@@ -45,6 +45,7 @@
  * @logicore_reg_ba: logicore reg base address
  * @vcu_slcr_ba: vcu_slcr Register base address
  * @pll: handle for the VCU PLL
+ * @pll_clk: consumer handle of the VCU PLL, used to prewarm it
  * @pll_post: handle for the VCU PLL post divider
  * @clk_data: clocks provided by the vcu clock provider
  */
@@ -56,6 +57,7 @@ struct xvcu_device {
 	struct regmap *logicore_reg_ba;
 	void __iomem *vcu_slcr_ba;
 	struct clk_hw *pll;
+	struct clk *pll_clk;
 	struct clk_hw *pll_post;
 	struct clk_hw_onecell_data *clk_data;
 };
@@ -64,4 +66,6 @@ u32 xvcu_get_color_depth(struct xvcu_device *xvcu);
 u32 xvcu_get_memory_depth(struct xvcu_device *xvcu);
 u32 xvcu_get_clock_frequency(struct xvcu_device *xvcu);
 u32 xvcu_get_num_cores(struct xvcu_device *xvcu);
+int xvcu_clk_prewarm(struct xvcu_device *xvcu);
+void xvcu_clk_cooldown(struct xvcu_device *xvcu);
 #endif /* __XLNX_VCU_H */
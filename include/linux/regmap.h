@@ -1168,6 +1168,9 @@ int regmap_multi_reg_write(struct regmap *map, const struct reg_sequence *regs,
 int regmap_multi_reg_write_bypassed(struct regmap *map,
 				    const struct reg_sequence *regs,
 				    int num_regs);
+int regmap_multi_reg_write_async(struct regmap *map,
+				 const struct reg_sequence *regs,
+				 int num_regs);
 int regmap_raw_write_async(struct regmap *map, unsigned int reg,
 			   const void *val, size_t val_len);
 int regmap_read(struct regmap *map, unsigned int reg, unsigned int *val);
@@ -1681,6 +1684,14 @@ static inline int regmap_raw_write_async(struct regmap *map, unsigned int reg,
 	return -EINVAL;
 }
 
+static inline int regmap_multi_reg_write_async(struct regmap *map,
+					const struct reg_sequence *regs,
+					int num_regs)
+{
+	WARN_ONCE(1, "regmap API is disabled");
+	return -EINVAL;
+}
+
 static inline int regmap_noinc_write(struct regmap *map, unsigned int reg,
 				    const void *val, size_t val_len)
 {
@@ -345,6 +345,7 @@ struct rproc_mem_entry {
 	int (*release)(struct rproc *rproc, struct rproc_mem_entry *mem);
 };
 
+struct dma_chan;
 struct firmware;
 
 /**
@@ -550,6 +551,10 @@ enum rproc_features {
  * @cdev: character device of the rproc
  * @cdev_put_on_release: flag to indicate if remoteproc should be shutdown on @char_dev release
  * @features: indicate remoteproc features
+ * @load_chan: optional DMA memcpy channel used to load large segments into
+ *	       carveouts whose dma address is their physical address
+ * @fw_cache: flag to keep the firmware image in memory between boots
+ * @cached_fw: firmware image kept for the next boot, protected by @lock
  */
 struct rproc {
 	struct list_head node;
@@ -592,6 +597,9 @@ struct rproc {
 	struct cdev cdev;
 	bool cdev_put_on_release;
 	DECLARE_BITMAP(features, RPROC_MAX_FEATURES);
+	struct dma_chan *load_chan;
+	bool fw_cache;
+	const struct firmware *cached_fw;
 };
 
 /**
@@ -646,6 +654,10 @@ struct rproc_vring {
  * @vring: the vrings for this vdev
  * @rsc_offset: offset of the vdev's resource entry
  * @index: vdev position versus other vdev declared in resource table
+ * @poll_task: kthread polling the vrings while a burst of traffic lasts
+ * @polling: whether @poll_task is polling, otherwise it sleeps until the
+ *	     next notification from the remote processor
+ * @kick_pending: vrings whose kick is deferred to the next poll
  */
 struct rproc_vdev {
 
@@ -658,6 +670,9 @@ struct rproc_vdev {
 	struct rproc_vring vring[RVDEV_NUM_VRINGS];
 	u32 rsc_offset;
 	u32 index;
+	struct task_struct *poll_task;
+	bool polling;
+	unsigned long kick_pending;
 };
 
 struct rproc *rproc_get_by_phandle(phandle phandle);
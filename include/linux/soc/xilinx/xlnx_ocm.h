@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Xilinx on-chip memory manager
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ */
+
+#ifndef __SOC_XILINX_XLNX_OCM_H
+#define __SOC_XILINX_XLNX_OCM_H
+
+#include <linux/err.h>
+#include <linux/types.h>
+
+struct device;
+struct xlnx_ocm_client;
+
+#if IS_ENABLED(CONFIG_XLNX_OCM)
+
+struct xlnx_ocm_client *xlnx_ocm_get(struct device *dev);
+void xlnx_ocm_put(struct xlnx_ocm_client *client);
+void *xlnx_ocm_alloc(struct xlnx_ocm_client *client, size_t size,
+		     dma_addr_t *dma);
+void xlnx_ocm_free(struct xlnx_ocm_client *client, void *vaddr,
+		   size_t size);
+
+#else
+
+static inline struct xlnx_ocm_client *xlnx_ocm_get(struct device *dev)
+{
+	return ERR_PTR(-ENODEV);
+}
+
+static inline void xlnx_ocm_put(struct xlnx_ocm_client *client)
+{
+}
+
+static inline void *xlnx_ocm_alloc(struct xlnx_ocm_client *client,
+				   size_t size, dma_addr_t *dma)
+{
+	return NULL;
+}
+
+static inline void xlnx_ocm_free(struct xlnx_ocm_client *client,
+				 void *vaddr, size_t size)
+{
+}
+
+#endif
+
+#endif /* __SOC_XILINX_XLNX_OCM_H */
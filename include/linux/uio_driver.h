@@ -15,7 +15,9 @@
 
 #include <linux/device.h>
 #include <linux/fs.h>
+#include <linux/hrtimer.h>
 #include <linux/interrupt.h>
+#include <linux/workqueue.h>
 
 struct module;
 struct uio_map;
@@ -77,6 +79,15 @@ struct uio_device {
 	struct mutex		info_lock;
 	struct kobject          *map_dir;
 	struct kobject          *portio_dir;
+	/* interrupt delivery, see UIO_IOC_SET_IRQ_POLICY */
+	spinlock_t		irq_lock;
+	struct list_head	eventfds;
+	u32			irq_policy;
+	u32			coalesce_count;
+	u32			coalesce_usecs;
+	u32			pending;
+	struct hrtimer		coalesce_timer;
+	struct work_struct	reenable_work;
 };
 
 /**
@@ -94,6 +105,7 @@ struct uio_device {
  * @open:		open operation for this uio device
  * @release:		release operation for this uio device
  * @irqcontrol:		disable/enable irqs when 0/1 is written to /dev/uioX
+ * @ioctl:		device specific ioctls, not handled by the uio core
  */
 struct uio_info {
 	struct uio_device	*uio_dev;
@@ -109,6 +121,8 @@ struct uio_info {
 	int (*open)(struct uio_info *info, struct inode *inode);
 	int (*release)(struct uio_info *info, struct inode *inode);
 	int (*irqcontrol)(struct uio_info *info, s32 irq_on);
+	long (*ioctl)(struct uio_info *info, unsigned int cmd,
+		      unsigned long arg);
 };
 
 extern int __must_check
@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Xilinx polyphase scaler coefficient library
+ *
+ * Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+ */
+
+#ifndef _XLNX_SCALER_COEFF_H_
+#define _XLNX_SCALER_COEFF_H_
+
+#include <linux/types.h>
+
+#define XLNX_SCALER_COEFF_PHASES	64
+#define XLNX_SCALER_COEFF_MAX_TAPS	12
+
+/**
+ * enum xlnx_scaler_coeff_set - Family of filter coefficients
+ * @XLNX_SCALER_COEFF_VPSS: VPSS scaler, shared by the H and V scalers
+ * @XLNX_SCALER_COEFF_MSC_H: Multi-scaler horizontal filter
+ * @XLNX_SCALER_COEFF_MSC_V: Multi-scaler vertical filter
+ * @XLNX_SCALER_COEFF_NUM_SETS: number of coefficient families
+ */
+enum xlnx_scaler_coeff_set {
+	XLNX_SCALER_COEFF_VPSS,
+	XLNX_SCALER_COEFF_MSC_H,
+	XLNX_SCALER_COEFF_MSC_V,
+	XLNX_SCALER_COEFF_NUM_SETS,
+};
+
+/**
+ * enum xlnx_scaler_coeff_bank - Range of scaling ratio
+ * @XLNX_SCALER_COEFF_BANK_UP: upscaling, including 1:1
+ * @XLNX_SCALER_COEFF_BANK_SR1P2: downscaling by up to 1.5
+ * @XLNX_SCALER_COEFF_BANK_SR2: downscaling by up to 2.5
+ * @XLNX_SCALER_COEFF_BANK_SR3: downscaling by up to 3.5
+ * @XLNX_SCALER_COEFF_BANK_SR4: downscaling by more than 3.5
+ * @XLNX_SCALER_COEFF_NUM_BANKS: number of banks
+ */
+enum xlnx_scaler_coeff_bank {
+	XLNX_SCALER_COEFF_BANK_UP,
+	XLNX_SCALER_COEFF_BANK_SR1P2,
+	XLNX_SCALER_COEFF_BANK_SR2,
+	XLNX_SCALER_COEFF_BANK_SR3,
+	XLNX_SCALER_COEFF_BANK_SR4,
+	XLNX_SCALER_COEFF_NUM_BANKS,
+};
+
+/**
+ * struct xlnx_scaler_coeff_cache - Coefficient memory tracking
+ * @words: table currently held by the coefficient memory, or NULL
+ *
+ * The coefficient memories keep their content across a reset of the IP, so
+ * the cache only starts zeroed along with the device structure.
+ */
+struct xlnx_scaler_coeff_cache {
+	const u32 *words;
+};
+
+/**
+ * xlnx_scaler_coeff_nwords - Size of a packed coefficient table
+ * @taps: number of taps of the scaler
+ * @phases: number of phases of the scaler
+ *
+ * Return: the number of 32-bit register words holding the table
+ */
+static inline unsigned int xlnx_scaler_coeff_nwords(unsigned int taps,
+						    unsigned int phases)
+{
+	return phases * taps / 2;
+}
+
+enum xlnx_scaler_coeff_bank xlnx_scaler_coeff_bank(u32 in, u32 out);
+const u32 *xlnx_scaler_coeff_get(enum xlnx_scaler_coeff_set set,
+				 unsigned int taps,
+				 enum xlnx_scaler_coeff_bank bank);
+bool xlnx_scaler_coeff_load(struct xlnx_scaler_coeff_cache *cache,
+			    void __iomem *addr, const u32 *words,
+			    unsigned int nwords);
+u32 *xlnx_scaler_coeff_lanczos(unsigned int taps, unsigned int phases,
+			       unsigned int *nwords);
+
+#endif /* _XLNX_SCALER_COEFF_H_ */
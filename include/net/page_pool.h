@@ -63,11 +63,16 @@
  * this array, as it shares the same softirq/NAPI protection.  If
  * cache is already full (or partly full) then the XDP_DROP recycles
  * would have to take a slower code path.
+ *
+ * Pools serving small RX rings can hold fewer objects, see the
+ * cache_size parameter. The refill watermark is then half of it.
  */
 #define PP_ALLOC_CACHE_SIZE	128
 #define PP_ALLOC_CACHE_REFILL	64
 struct pp_alloc_cache {
 	u32 count;
+	u32 limit;	/* objects the cache holds at most */
+	u32 refill;	/* objects taken from the ring or allocator at once */
 	struct page *cache[PP_ALLOC_CACHE_SIZE];
 };
 
@@ -75,6 +80,7 @@ struct page_pool_params {
 	unsigned int	flags;
 	unsigned int	order;
 	unsigned int	pool_size;
+	unsigned int	cache_size; /* alloc cache, 0 for PP_ALLOC_CACHE_SIZE */
 	int		nid;  /* Numa node id to allocate from pages from */
 	struct device	*dev; /* device, for DMA pre-mapping purposes */
 	enum dma_data_direction dma_dir; /* DMA mapping direction */
@@ -207,6 +213,10 @@ struct page_pool {
 	refcount_t user_cnt;
 
 	u64 destroy_cnt;
+
+#ifdef CONFIG_DEBUG_FS
+	struct list_head debug_list; /* in the page_pool/pools debugfs file */
+#endif
 };
 
 struct page *page_pool_alloc_pages(struct page_pool *pool, gfp_t gfp);
@@ -16,10 +16,38 @@ struct tso_t {
 	u32	tcp_seq;
 };
 
+/* Pre-mapped header buffers, one per slot of a tx ring, for DMA engines
+ * that need aligned buffer addresses (e.g. AXI DMA without DRE).
+ */
+struct tso_hdr_arena {
+	void		*buf;
+	dma_addr_t	dma;
+	unsigned int	count;
+	unsigned int	stride;	/* TSO_HEADER_SIZE rounded up to the alignment */
+};
+
+static inline void *tso_hdr_va(const struct tso_hdr_arena *arena,
+			       unsigned int idx)
+{
+	return arena->buf + idx * arena->stride;
+}
+
+static inline dma_addr_t tso_hdr_dma(const struct tso_hdr_arena *arena,
+				     unsigned int idx)
+{
+	return arena->dma + idx * arena->stride;
+}
+
 int tso_count_descs(const struct sk_buff *skb);
+int tso_count_descs_aligned(const struct sk_buff *skb);
 void tso_build_hdr(const struct sk_buff *skb, char *hdr, struct tso_t *tso,
 		   int size, bool is_last);
 void tso_build_data(const struct sk_buff *skb, struct tso_t *tso, int size);
+int tso_align_data(const struct sk_buff *skb, struct tso_t *tso, char *buf,
+		   int size, unsigned int align);
 int tso_start(struct sk_buff *skb, struct tso_t *tso);
+int tso_hdr_arena_alloc(struct device *dev, struct tso_hdr_arena *arena,
+			unsigned int count, unsigned int align);
+void tso_hdr_arena_free(struct device *dev, struct tso_hdr_arena *arena);
 
 #endif	/* _TSO_H */
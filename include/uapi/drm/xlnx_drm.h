@@ -0,0 +1,34 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+/*
+ * Xilinx DRM KMS uapi
+ *
+ * Copyright (C) 2023 Xilinx, Inc. All rights reserved.
+ */
+
+#ifndef _UAPI_XLNX_DRM_H_
+#define _UAPI_XLNX_DRM_H_
+
+#include "drm.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*
+ * Flags of struct drm_mode_create_dumb
+ *
+ * XLNX_DRM_DUMB_CACHED allocates the buffer from cacheable memory. Its mmap()
+ * is then cached, instead of write-combined, which is much faster for
+ * software rendering and read back. CPU writes reach the display when a
+ * commit shows the buffer: the whole buffer when the plane switches to it,
+ * otherwise only the damage set with FB_DAMAGE_CLIPS or DRM_IOCTL_MODE_DIRTYFB.
+ * Other devices importing the buffer only see the CPU writes bracketed by
+ * DMA_BUF_IOCTL_SYNC.
+ */
+#define XLNX_DRM_DUMB_CACHED	(1 << 0)
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _UAPI_XLNX_DRM_H_ */
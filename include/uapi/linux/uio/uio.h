@@ -41,6 +41,18 @@ struct uio_dmabuf_args {
 	__u8	dir;
 };
 
+/**
+ * struct uio_dmabuf_batch - arguments from userspace to map / unmap dmabufs
+ * @args: Pointer to an array of struct uio_dmabuf_args
+ * @count: Number of entries in @args
+ * @done: Number of entries processed, set by the kernel
+ */
+struct uio_dmabuf_batch {
+	__u64	args;
+	__u32	count;
+	__u32	done;
+};
+
 #define UIO_IOC_BASE		'U'
 
 /**
@@ -62,4 +74,70 @@ struct uio_dmabuf_args {
  */
 #define	UIO_IOC_UNMAP_DMABUF	_IOWR(UIO_IOC_BASE, 0x2, struct uio_dmabuf_args)
 
+/**
+ * DOC: UIO_IOC_MAP_DMABUFS - Map an array of dma bufs
+ *
+ * This takes uio_dmabuf_batch, and maps each entry as UIO_IOC_MAP_DMABUF
+ * does. Processing stops at the first failure, and the number of processed
+ * entries is returned in @done. Unmapped dma bufs stay mapped to the device
+ * until they are evicted from a per file cache, so mapping them again is
+ * cheap.
+ * FIXME: This is experimental and may change at any time. Don't consider this
+ * as stable ABI.
+ */
+#define	UIO_IOC_MAP_DMABUFS	\
+	_IOWR(UIO_IOC_BASE, 0x3, struct uio_dmabuf_batch)
+
+/**
+ * DOC: UIO_IOC_UNMAP_DMABUFS - Unmap an array of dma bufs
+ *
+ * This takes uio_dmabuf_batch, and unmaps each entry as UIO_IOC_UNMAP_DMABUF
+ * does. Processing stops at the first failure, and the number of processed
+ * entries is returned in @done.
+ * FIXME: This is experimental and may change at any time. Don't consider this
+ * as stable ABI.
+ */
+#define	UIO_IOC_UNMAP_DMABUFS	\
+	_IOWR(UIO_IOC_BASE, 0x4, struct uio_dmabuf_batch)
+
+/* The core re-enables the interrupt after each one */
+#define UIO_IRQ_POLICY_AUTO_REENABLE		(1 << 0)
+/* A read() that returns an event count re-enables the interrupt */
+#define UIO_IRQ_POLICY_REENABLE_ON_READ		(1 << 1)
+
+/**
+ * struct uio_irq_policy - interrupt delivery policy of a uio device
+ * @flags: UIO_IRQ_POLICY_* flags
+ * @coalesce_count: Wake up listeners once that many interrupts are pending,
+ *		    1 to wake up on every interrupt
+ * @coalesce_usecs: Wake up listeners anyway that long after the first
+ *		    pending interrupt, 0 to only wake up on @coalesce_count
+ * @reserved: Must be zero
+ */
+struct uio_irq_policy {
+	__u32	flags;
+	__u32	coalesce_count;
+	__u32	coalesce_usecs;
+	__u32	reserved;
+};
+
+/**
+ * DOC: UIO_IOC_SET_EVENTFD - Signal an eventfd on every uio event
+ *
+ * This takes the fd of an eventfd, which is signalled whenever listeners are
+ * woken up, with the number of events delivered. Each open file of the
+ * device has its own eventfd, -1 removes it.
+ */
+#define	UIO_IOC_SET_EVENTFD	_IOW(UIO_IOC_BASE, 0x5, __s32)
+
+/**
+ * DOC: UIO_IOC_SET_IRQ_POLICY - Set the interrupt delivery policy
+ *
+ * This takes uio_irq_policy, which applies to the device and all its open
+ * files. Re-enabling flags need a device with an irqcontrol operation.
+ * Interrupts kept pending for coalescing are not counted until delivered.
+ */
+#define	UIO_IOC_SET_IRQ_POLICY	\
+	_IOW(UIO_IOC_BASE, 0x6, struct uio_irq_policy)
+
 #endif
@@ -0,0 +1,53 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+/*
+ * The header for Xilinx AI Engine UIO driver
+ *
+ * Copyright (C) 2018 Xilinx, Inc.
+ */
+
+#ifndef _UAPI_UIO_XILINX_AI_ENGINE_H_
+#define _UAPI_UIO_XILINX_AI_ENGINE_H_
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/**
+ * struct xilinx_ai_engine_irq_args - arguments to bind an interrupt eventfd
+ * @index: Index of the AI engine interrupt, 0 to 3 for interrupt0-interrupt3
+ * @fd: The eventfd to signal, or -1 to unbind
+ */
+struct xilinx_ai_engine_irq_args {
+	__u32	index;
+	__s32	fd;
+};
+
+#define XILINX_AI_ENGINE_IOC_BASE	'X'
+
+/**
+ * DOC: XILINX_AI_ENGINE_IOC_SET_IRQ_EVENTFD - Signal an eventfd on interrupt
+ *
+ * This takes xilinx_ai_engine_irq_args, and binds the eventfd @fd to the AI
+ * engine interrupt @index, so AI engine events routed to that interrupt, such
+ * as a lock or a shim DMA completion, can be waited for with poll() instead of
+ * polling the tile registers. The interrupt used by the uio device itself,
+ * which is signalled through read() and poll() on /dev/uioX, can't be bound.
+ *
+ * The interrupt is masked when it fires, and has to be unmasked with
+ * XILINX_AI_ENGINE_IOC_UNMASK_IRQ once the event has been acknowledged.
+ * FIXME: This is experimental and may change at any time. Don't consider this
+ * as stable ABI.
+ */
+#define XILINX_AI_ENGINE_IOC_SET_IRQ_EVENTFD	\
+	_IOW(XILINX_AI_ENGINE_IOC_BASE, 0x1, struct xilinx_ai_engine_irq_args)
+
+/**
+ * DOC: XILINX_AI_ENGINE_IOC_UNMASK_IRQ - Unmask an interrupt
+ *
+ * This takes the index of an interrupt bound to an eventfd, and unmasks it.
+ * FIXME: This is experimental and may change at any time. Don't consider this
+ * as stable ABI.
+ */
+#define XILINX_AI_ENGINE_IOC_UNMASK_IRQ	\
+	_IOW(XILINX_AI_ENGINE_IOC_BASE, 0x2, __u32)
+
+#endif
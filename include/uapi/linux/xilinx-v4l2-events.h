@@ -18,8 +18,49 @@
  * Events
  *
  * V4L2_EVENT_XLNXSCD: Scene Change Detection
+ * V4L2_EVENT_XLNXSCD_BATCH: Scene Change Detection results of all streams
  */
 #define V4L2_EVENT_XLNXSCD_CLASS	(V4L2_EVENT_PRIVATE_START | 0x300)
 #define V4L2_EVENT_XLNXSCD		(V4L2_EVENT_XLNXSCD_CLASS | 0x1)
+#define V4L2_EVENT_XLNXSCD_BATCH	(V4L2_EVENT_XLNXSCD_CLASS | 0x2)
+
+#define XSCD_BATCH_MAX_STREAMS		8
+
+/**
+ * struct xscd_batch_event - V4L2_EVENT_XLNXSCD_BATCH data
+ * @sequence: run counter, incremented for every run of the SCD core
+ * @channels: bitmask of the streams that took part in the run
+ * @scene_change: bitmask of the streams where a scene change was detected
+ * @reserved: must be zero
+ * @sad: normalized SAD of each stream, valid for streams in @channels
+ */
+struct xscd_batch_event {
+	__u32 sequence;
+	__u32 channels;
+	__u32 scene_change;
+	__u32 reserved;
+	__u32 sad[XSCD_BATCH_MAX_STREAMS];
+};
+
+/*
+ * V4L2_EVENT_XLNXVIP_FRAME_DONE: Frame written to memory
+ *
+ * In low latency capture a buffer is dequeued as soon as the DMA starts
+ * on it. This event then tells when the whole frame is in memory.
+ */
+#define V4L2_EVENT_XLNXVIP_CLASS	(V4L2_EVENT_PRIVATE_START | 0x400)
+#define V4L2_EVENT_XLNXVIP_FRAME_DONE	(V4L2_EVENT_XLNXVIP_CLASS | 0x1)
+
+/**
+ * struct xvip_frame_done_event - V4L2_EVENT_XLNXVIP_FRAME_DONE data
+ * @index: index of the V4L2 buffer the frame was written to
+ * @reserved: must be zero
+ * @timestamp: CLOCK_MONOTONIC time in ns the DMA completed the frame
+ */
+struct xvip_frame_done_event {
+	__u32 index;
+	__u32 reserved;
+	__u64 timestamp;
+};
 
 #endif /* __UAPI_XILINX_V4L2_EVENTS_H__ */
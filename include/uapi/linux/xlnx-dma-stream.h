@@ -0,0 +1,104 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+/*
+ * Xilinx AXI DMA streaming character device
+ *
+ * Copyright (C) 2023 Xilinx, Inc. All rights reserved.
+ */
+
+#ifndef __UAPI_XLNX_DMA_STREAM_H__
+#define __UAPI_XLNX_DMA_STREAM_H__
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/* The stream moves data from memory to the AXI4-Stream interface */
+#define XLNX_DMA_STREAM_TX		(1 << 0)
+/* The ring is run as a single cyclic transfer */
+#define XLNX_DMA_STREAM_CYCLIC		(1 << 1)
+
+/* The transfer of the buffer ended with an error */
+#define XLNX_DMA_STREAM_BUF_ERROR	(1 << 0)
+
+/**
+ * struct xlnx_dma_stream_buf - State of a ring buffer
+ * @len: Bytes received into the buffer, or to transmit from it
+ * @flags: XLNX_DMA_STREAM_BUF_* flags, set by the kernel
+ */
+struct xlnx_dma_stream_buf {
+	__u32 len;
+	__u32 flags;
+};
+
+/**
+ * struct xlnx_dma_stream_ring - Ring control area, mapped at offset 0
+ * @prod: Free running count of the buffers handed to the consumer
+ * @cons: Free running count of the buffers handed back by the consumer
+ * @num_bufs: Number of buffers in the ring
+ * @buf_size: Size in bytes of each buffer
+ * @overruns: Buffers the cyclic transfer went past before they were
+ *	      handed back (Rx), or sent again without being refilled (Tx)
+ * @errors: Transfers that ended with an error
+ * @reserved: Must be ignored
+ * @bufs: One entry per buffer, buffer i is at data_offset + i * buf_size
+ *
+ * Buffer i % num_bufs with cons <= i < prod is owned by the consumer, all
+ * the others by the producer. The kernel is the producer of a Rx stream and
+ * userspace that of a Tx stream, each side only writes its own index.
+ * Userspace must publish its index after the buffer contents and lengths,
+ * and read the kernel's index before looking at them.
+ *
+ * A cyclic stream never waits for userspace and the kernel index follows
+ * the hardware. When prod - cons exceeds num_bufs on a Rx stream the oldest
+ * buffers were overwritten, and userspace resumes at cons = prod - num_bufs.
+ * When cons passes prod on a Tx stream stale buffers were sent again, and
+ * userspace resumes at prod = cons. A cyclic Tx stream starts by sending
+ * the whole ring, which is filled before XLNX_DMA_STREAM_IOCTL_START, and
+ * the length of its buffers is always buf_size.
+ */
+struct xlnx_dma_stream_ring {
+	__u32 prod;
+	__u32 cons;
+	__u32 num_bufs;
+	__u32 buf_size;
+	__u32 overruns;
+	__u32 errors;
+	__u32 reserved[2];
+	struct xlnx_dma_stream_buf bufs[];
+};
+
+/**
+ * struct xlnx_dma_stream_info - Layout of the stream
+ * @flags: XLNX_DMA_STREAM_TX and XLNX_DMA_STREAM_CYCLIC flags
+ * @num_bufs: Number of buffers in the ring
+ * @buf_size: Size in bytes of each buffer
+ * @ctrl_size: Size of the ring control area, mapped at offset 0
+ * @data_offset: mmap() offset of the buffers
+ */
+struct xlnx_dma_stream_info {
+	__u32 flags;
+	__u32 num_bufs;
+	__u32 buf_size;
+	__u32 ctrl_size;
+	__u64 data_offset;
+};
+
+/**
+ * struct xlnx_dma_stream_coalesce - Wake up coalescing
+ * @count: Wake up once that many buffers are owned by userspace, 1 to
+ *	   wake up for every buffer
+ * @usecs: Wake up anyway that long after the first buffer was handed over,
+ *	   0 to only wake up on @count
+ */
+struct xlnx_dma_stream_coalesce {
+	__u32 count;
+	__u32 usecs;
+};
+
+#define XLNX_DMA_STREAM_IOCTL_INFO	_IOR('X', 0x00, struct xlnx_dma_stream_info)
+#define XLNX_DMA_STREAM_IOCTL_START	_IO('X', 0x01)
+#define XLNX_DMA_STREAM_IOCTL_STOP	_IO('X', 0x02)
+#define XLNX_DMA_STREAM_IOCTL_KICK	_IO('X', 0x03)
+#define XLNX_DMA_STREAM_IOCTL_EVENTFD	_IOW('X', 0x04, __s32)
+#define XLNX_DMA_STREAM_IOCTL_COALESCE	_IOW('X', 0x05, struct xlnx_dma_stream_coalesce)
+
+#endif /* __UAPI_XLNX_DMA_STREAM_H__ */
@@ -44,7 +44,8 @@ enum ts_mux_command {
  * @is_pcr_stream: flag for pcr stream
  * @is_valid_pts: flag for valid pts
  * @is_valid_dts: flag for valid dts
- * @is_dmabuf: flag to set if external src buffer is DMA allocated
+ * @is_dmabuf: flag to set if external src buffer is DMA allocated, or
+ *	MPG2MUX_DMABUF_IMPORT to pass a dma-buf fd in @srcbuf_id directly
  * @pid: packet id number
  * @size_data_in: size in bytes of input buffer
  * @pts: presentation time stamp
@@ -72,9 +73,17 @@ struct stream_context_in {
 	__u64 pcr_base;
 };
 
+/*
+ * Value of is_dmabuf in struct stream_context_in and struct muxer_context_in
+ * for a dma-buf fd that has not gone through MPG2MUX_VDBUF. The driver
+ * imports the buffer itself and keeps it mapped for later frames.
+ */
+#define MPG2MUX_DMABUF_IMPORT	2
+
 /**
  * struct mux_context_in - struct to enqueue a mux context descriptor
- * @is_dmabuf: flag to set if external src buffer is DMA allocated
+ * @is_dmabuf: flag to set if external src buffer is DMA allocated, or
+ *	MPG2MUX_DMABUF_IMPORT to pass a dma-buf fd in @dstbuf_id directly
  * @dstbuf_id: destination buffer id after mmap
  * @dmabuf_size: size in bytes of output buffer
  */
@@ -174,6 +183,24 @@ struct xlnx_tsmux_dmabuf_info {
 	enum xlnx_tsmux_dmabuf_flags flags;
 };
 
+/**
+ * struct mpg2mux_ctx_batch - struct to enqueue several contexts at once
+ * @strm_ctx: user pointer to an array of struct stream_context_in
+ * @mux_ctx: user pointer to an array of struct muxer_context_in
+ * @num_strm: number of entries in @strm_ctx
+ * @num_mux: number of entries in @mux_ctx
+ * @done_strm: stream contexts enqueued, returned by the driver
+ * @done_mux: mux contexts enqueued, returned by the driver
+ */
+struct mpg2mux_ctx_batch {
+	__u64 strm_ctx;
+	__u64 mux_ctx;
+	__u32 num_strm;
+	__u32 num_mux;
+	__u32 done_strm;
+	__u32 done_mux;
+};
+
 /* MPG2MUX IOCTL CALL LIST */
 
 #define MPG2MUX_MAGIC 'M'
@@ -250,4 +277,9 @@ struct xlnx_tsmux_dmabuf_info {
  */
 #define MPG2MUX_VDBUF _IOWR(MPG2MUX_MAGIC, 14, struct xlnx_tsmux_dmabuf_info *)
 
+/**
+ * MPG2MUX_SETCTXS - enqueue stream descriptors, then mux descriptors
+ */
+#define MPG2MUX_SETCTXS _IOWR(MPG2MUX_MAGIC, 15, struct mpg2mux_ctx_batch)
+
 #endif
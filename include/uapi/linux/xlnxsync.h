@@ -145,6 +145,31 @@ struct xlnxsync_stat {
 	struct xlnxsync_err_intr err;
 };
 
+/* Return a sync_file per programmed slot in xlnxsync_chan_config_batch */
+#define XLNXSYNC_CONFIG_FENCE_OUT	(1 << 0)
+
+/**
+ * struct xlnxsync_chan_config_batch - Program several framebuffers at once
+ * @hdr_ver: IOCTL header version
+ * @configs: User pointer to an array of struct xlnxsync_chan_config
+ * @fence_fds: User pointer to an array of __s32[XLNXSYNC_IO] receiving a
+ * sync_file fd per entry and direction, signalled when the slot is done.
+ * Only used with XLNXSYNC_CONFIG_FENCE_OUT
+ * @count: Number of entries in @configs
+ * @done: Number of entries programmed, filled in by the driver
+ * @flags: XLNXSYNC_CONFIG_* flags
+ * @reserved: Must be zero
+ */
+struct xlnxsync_chan_config_batch {
+	__u64 hdr_ver;
+	__u64 configs;
+	__u64 fence_fds;
+	__u32 count;
+	__u32 done;
+	__u32 flags;
+	__u32 reserved;
+};
+
 #define XLNXSYNC_MAGIC			'X'
 
 /*
@@ -176,4 +201,7 @@ struct xlnxsync_stat {
 					     struct xlnxsync_intr *)
 /* This is used to reset the last programmed slot */
 #define XLNXSYNC_RESET_SLOT		_IO(XLNXSYNC_MAGIC, 10)
+/* This is used to program several framebuffers and get their fences */
+#define XLNXSYNC_CHAN_SET_CONFIGS	_IOWR(XLNXSYNC_MAGIC, 11,\
+					      struct xlnxsync_chan_config_batch)
 #endif
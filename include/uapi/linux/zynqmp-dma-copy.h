@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+/*
+ * ZynqMP DMA memory copy offload
+ *
+ * Copyright (C) 2023 Xilinx, Inc. All rights reserved.
+ */
+
+#ifndef __UAPI_ZYNQMP_DMA_COPY_H__
+#define __UAPI_ZYNQMP_DMA_COPY_H__
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/**
+ * struct zynqmp_dma_copy_req - Copy between two dma-bufs
+ * @src_fd: dma-buf to copy from
+ * @dst_fd: dma-buf to copy to
+ * @src_offset: Byte offset into the source dma-buf
+ * @dst_offset: Byte offset into the destination dma-buf
+ * @len: Number of bytes to copy
+ * @flags: Must be zero
+ * @fence_fd: Returned sync_file, signalled once the copy is done
+ *
+ * The copy waits for earlier writers of the source and for all earlier
+ * users of the destination. Its fence is added to both reservation objects,
+ * so implicitly synchronized users are ordered after it as well.
+ */
+struct zynqmp_dma_copy_req {
+	__s32 src_fd;
+	__s32 dst_fd;
+	__u64 src_offset;
+	__u64 dst_offset;
+	__u64 len;
+	__u32 flags;
+	__s32 fence_fd;
+};
+
+#define ZYNQMP_DMA_COPY_IOCTL_COPY	_IOWR('Z', 0x00, struct zynqmp_dma_copy_req)
+
+#endif /* __UAPI_ZYNQMP_DMA_COPY_H__ */
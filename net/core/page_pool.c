@@ -19,6 +19,8 @@
 #include <linux/mm.h> /* for put_page() */
 #include <linux/poison.h>
 #include <linux/ethtool.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include <trace/events/page_pool.h>
 
@@ -133,6 +135,120 @@ EXPORT_SYMBOL(page_pool_ethtool_stats_get);
 #define recycle_stat_add(pool, __stat, val)
 #endif
 
+#ifdef CONFIG_DEBUG_FS
+/* All live pools, listed in debugfs as page_pool/pools: one line per pool
+ * with its sizing and, with stats enabled, how often pages were recycled
+ * straight into the alloc cache rather than through the ptr_ring.
+ */
+static LIST_HEAD(page_pool_debug_list);
+static DEFINE_SPINLOCK(page_pool_debug_lock);
+
+static void page_pool_debugfs_add(struct page_pool *pool)
+{
+	spin_lock_bh(&page_pool_debug_lock);
+	list_add_tail(&pool->debug_list, &page_pool_debug_list);
+	spin_unlock_bh(&page_pool_debug_lock);
+}
+
+static void page_pool_debugfs_del(struct page_pool *pool)
+{
+	spin_lock_bh(&page_pool_debug_lock);
+	list_del(&pool->debug_list);
+	spin_unlock_bh(&page_pool_debug_lock);
+}
+
+#ifdef CONFIG_PAGE_POOL_STATS
+static void page_pool_debugfs_recycle(struct seq_file *m,
+				      const struct page_pool_recycle_stats *r)
+{
+	u64 total = r->cached + r->cache_full + r->ring + r->ring_full;
+
+	seq_printf(m, " cached %llu cache_full %llu ring %llu ring_full %llu released %llu direct %llu%%",
+		   r->cached, r->cache_full, r->ring, r->ring_full,
+		   r->released_refcnt,
+		   total ? div64_u64(r->cached * 100, total) : 0);
+}
+
+static void page_pool_debugfs_stats(struct seq_file *m, struct page_pool *pool)
+{
+	struct page_pool_stats stats = { };
+	int cpu;
+
+	page_pool_get_stats(pool, &stats);
+	seq_printf(m, "  alloc fast %llu slow %llu slow_high_order %llu empty %llu refill %llu waive %llu\n",
+		   stats.alloc_stats.fast, stats.alloc_stats.slow,
+		   stats.alloc_stats.slow_high_order, stats.alloc_stats.empty,
+		   stats.alloc_stats.refill, stats.alloc_stats.waive);
+	seq_puts(m, "  recycle");
+	page_pool_debugfs_recycle(m, &stats.recycle_stats);
+	seq_putc(m, '\n');
+
+	/* Direct recycling only happens from the NAPI context the pool is
+	 * bound to, so the CPUs that did any recycling show where it ran.
+	 */
+	for_each_possible_cpu(cpu) {
+		const struct page_pool_recycle_stats *pcpu =
+			per_cpu_ptr(pool->recycle_stats, cpu);
+
+		if (!(pcpu->cached | pcpu->cache_full | pcpu->ring |
+		      pcpu->ring_full | pcpu->released_refcnt))
+			continue;
+
+		seq_printf(m, "  cpu%d", cpu);
+		page_pool_debugfs_recycle(m, pcpu);
+		seq_putc(m, '\n');
+	}
+}
+#else
+static void page_pool_debugfs_stats(struct seq_file *m, struct page_pool *pool)
+{
+}
+#endif
+
+static int page_pool_debugfs_show(struct seq_file *m, void *v)
+{
+	struct page_pool *pool;
+
+	spin_lock_bh(&page_pool_debug_lock);
+	list_for_each_entry(pool, &page_pool_debug_list, debug_list) {
+		u32 hold_cnt = READ_ONCE(pool->pages_state_hold_cnt);
+		u32 release_cnt = atomic_read(&pool->pages_state_release_cnt);
+
+		seq_printf(m, "%p mem_id %u dev %s order %u ring %d cache %u/%u refill %u inflight %d%s\n",
+			   pool, pool->xdp_mem_id,
+			   pool->p.dev ? dev_name(pool->p.dev) : "-",
+			   pool->p.order, pool->ring.size, pool->alloc.count,
+			   pool->alloc.limit, pool->alloc.refill,
+			   (s32)(hold_cnt - release_cnt),
+			   refcount_read(&pool->user_cnt) ? "" : " destroyed");
+		page_pool_debugfs_stats(m, pool);
+	}
+	spin_unlock_bh(&page_pool_debug_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(page_pool_debugfs);
+
+static int __init page_pool_debugfs_init(void)
+{
+	struct dentry *dir = debugfs_create_dir("page_pool", NULL);
+
+	debugfs_create_file("pools", 0400, dir, NULL,
+			    &page_pool_debugfs_fops);
+
+	return 0;
+}
+late_initcall(page_pool_debugfs_init);
+#else
+static void page_pool_debugfs_add(struct page_pool *pool)
+{
+}
+
+static void page_pool_debugfs_del(struct page_pool *pool)
+{
+}
+#endif
+
 static int page_pool_init(struct page_pool *pool,
 			  const struct page_pool_params *params)
 {
@@ -151,6 +267,14 @@ static int page_pool_init(struct page_pool *pool,
 	if (ring_qsize > 32768)
 		return -E2BIG;
 
+	pool->alloc.limit = PP_ALLOC_CACHE_SIZE;
+	if (pool->p.cache_size)
+		pool->alloc.limit = pool->p.cache_size;
+	if (pool->alloc.limit > PP_ALLOC_CACHE_SIZE)
+		return -E2BIG;
+	pool->alloc.refill = min_t(u32, PP_ALLOC_CACHE_REFILL,
+				   max(pool->alloc.limit / 2, 1U));
+
 	/* DMA direction is either DMA_FROM_DEVICE or DMA_BIDIRECTIONAL.
 	 * DMA_BIDIRECTIONAL is for allowing page used for DMA sending,
 	 * which is the XDP_TX use-case.
@@ -197,6 +321,8 @@ static int page_pool_init(struct page_pool *pool,
 	if (pool->p.flags & PP_FLAG_DMA_MAP)
 		get_device(pool->p.dev);
 
+	page_pool_debugfs_add(pool);
+
 	return 0;
 }
 
@@ -251,7 +377,8 @@ static struct page *page_pool_refill_alloc_cache(struct page_pool *pool)
 		if (unlikely(!page))
 			break;
 
-		if (likely(page_to_nid(page) == pref_nid)) {
+		if (!IS_ENABLED(CONFIG_NUMA) ||
+		    likely(page_to_nid(page) == pref_nid)) {
 			pool->alloc.cache[pool->alloc.count++] = page;
 		} else {
 			/* NUMA mismatch;
@@ -264,7 +391,7 @@ static struct page *page_pool_refill_alloc_cache(struct page_pool *pool)
 			page = NULL;
 			break;
 		}
-	} while (pool->alloc.count < PP_ALLOC_CACHE_REFILL);
+	} while (pool->alloc.count < pool->alloc.refill);
 
 	/* Return last page */
 	if (likely(pool->alloc.count > 0)) {
@@ -372,7 +499,7 @@ noinline
 static struct page *__page_pool_alloc_pages_slow(struct page_pool *pool,
 						 gfp_t gfp)
 {
-	const int bulk = PP_ALLOC_CACHE_REFILL;
+	const int bulk = pool->alloc.refill;
 	unsigned int pp_flags = pool->p.flags;
 	unsigned int pp_order = pool->p.order;
 	struct page *page;
@@ -533,7 +660,7 @@ static bool page_pool_recycle_in_ring(struct page_pool *pool, struct page *page)
 static bool page_pool_recycle_in_cache(struct page *page,
 				       struct page_pool *pool)
 {
-	if (unlikely(pool->alloc.count == PP_ALLOC_CACHE_SIZE)) {
+	if (unlikely(pool->alloc.count >= pool->alloc.limit)) {
 		recycle_stat_inc(pool, cache_full);
 		return false;
 	}
@@ -752,6 +879,8 @@ static void page_pool_empty_ring(struct page_pool *pool)
 
 static void page_pool_free(struct page_pool *pool)
 {
+	page_pool_debugfs_del(pool);
+
 	if (pool->disconnect)
 		pool->disconnect(pool);
 
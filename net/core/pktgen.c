@@ -200,6 +200,7 @@
 	pf(VID_RND)		/* Random VLAN ID */			\
 	pf(SVID_RND)		/* Random SVLAN ID */			\
 	pf(NODE)		/* Node memory alloc*/			\
+	pf(LATENCY)		/* Per-queue latency over a loopback */	\
 
 #define pf(flag)		flag##_SHIFT,
 enum pkt_flags {
@@ -422,7 +423,9 @@ struct pktgen_dev {
 	u16 queue_map_max;
 	__u32 skb_priority;	/* skb priority field */
 	unsigned int burst;	/* number of duplicated packets to burst */
+	unsigned int gro_segs;	/* UDP datagrams per GRO-coalesced skb */
 	int node;               /* Memory node */
+	struct pktgen_lat *lat;	/* LATENCY flag state */
 
 #ifdef CONFIG_XFRM
 	__u8	ipsmode;		/* IPSEC mode (config) */
@@ -441,6 +444,232 @@ struct pktgen_hdr {
 	__be32 tv_usec;
 };
 
+/* LATENCY flag: the transmit time of each packet is kept by sequence
+ * number and matched when the packet comes back on any interface, e.g.
+ * through a PHY or cable loopback. The receive side uses the driver's
+ * hardware timestamp when it attached one, which needs the PHC to track
+ * CLOCK_REALTIME. Each tx queue gets a histogram of log2 buckets split
+ * into PKTGEN_LAT_SUB linear steps. Needs clone_skb 0 and burst 1, so
+ * that every transmit carries its own sequence number.
+ */
+#define PKTGEN_LAT_SUB_SHIFT	2
+#define PKTGEN_LAT_SUB		(1 << PKTGEN_LAT_SUB_SHIFT)
+#define PKTGEN_LAT_BUCKETS	(64 * PKTGEN_LAT_SUB)
+#define PKTGEN_LAT_QUEUES	16	/* higher queues share the last one */
+#define PKTGEN_LAT_RING		1024	/* packets tracked in flight */
+
+struct pktgen_lat_slot {
+	u64 tx_ns;	/* 0 once matched */
+	u32 seq;
+	u16 queue;
+};
+
+struct pktgen_lat {
+	struct packet_type pt[2];	/* IPv4 and IPv6 */
+	struct pktgen_dev *pkt_dev;
+	spinlock_t lock;		/* everything below */
+	u64 unmatched;
+	u64 hw_stamped;
+	u64 count[PKTGEN_LAT_QUEUES];
+	u64 max[PKTGEN_LAT_QUEUES];
+	u32 hist[PKTGEN_LAT_QUEUES][PKTGEN_LAT_BUCKETS];
+	struct pktgen_lat_slot ring[PKTGEN_LAT_RING];
+};
+
+static unsigned int pktgen_lat_bucket(u64 ns)
+{
+	unsigned int msb;
+
+	if (ns < PKTGEN_LAT_SUB)
+		return ns;
+
+	msb = fls64(ns) - 1;
+	return ((msb - PKTGEN_LAT_SUB_SHIFT + 1) << PKTGEN_LAT_SUB_SHIFT) |
+	       ((ns >> (msb - PKTGEN_LAT_SUB_SHIFT)) & (PKTGEN_LAT_SUB - 1));
+}
+
+/* lowest latency that falls in bucket @idx */
+static u64 pktgen_lat_bucket_ns(unsigned int idx)
+{
+	unsigned int msb;
+	u64 sub;
+
+	if (idx < PKTGEN_LAT_SUB)
+		return idx;
+
+	msb = (idx >> PKTGEN_LAT_SUB_SHIFT) + PKTGEN_LAT_SUB_SHIFT - 1;
+	sub = idx & (PKTGEN_LAT_SUB - 1);
+	return (1ULL << msb) | (sub << (msb - PKTGEN_LAT_SUB_SHIFT));
+}
+
+static void pktgen_lat_reset(struct pktgen_lat *lat)
+{
+	spin_lock_bh(&lat->lock);
+	lat->unmatched = 0;
+	lat->hw_stamped = 0;
+	memset(lat->count, 0, sizeof(lat->count));
+	memset(lat->max, 0, sizeof(lat->max));
+	memset(lat->hist, 0, sizeof(lat->hist));
+	memset(lat->ring, 0, sizeof(lat->ring));
+	spin_unlock_bh(&lat->lock);
+}
+
+/* Called with BHs disabled, right before the packet is handed over */
+static void pktgen_lat_tx(struct pktgen_lat *lat, u32 seq, u16 queue)
+{
+	struct pktgen_lat_slot *slot = &lat->ring[seq & (PKTGEN_LAT_RING - 1)];
+
+	spin_lock(&lat->lock);
+	slot->seq = seq;
+	slot->queue = min_t(u16, queue, PKTGEN_LAT_QUEUES - 1);
+	slot->tx_ns = ktime_get_real_ns();
+	spin_unlock(&lat->lock);
+}
+
+static void pktgen_lat_rx(struct pktgen_lat *lat, u32 seq, u64 rx_ns, bool hw)
+{
+	struct pktgen_lat_slot *slot = &lat->ring[seq & (PKTGEN_LAT_RING - 1)];
+	unsigned int q;
+	u64 delta;
+
+	spin_lock(&lat->lock);
+	if (!slot->tx_ns || slot->seq != seq) {
+		lat->unmatched++;
+		goto unlock;
+	}
+
+	q = slot->queue;
+	delta = rx_ns > slot->tx_ns ? rx_ns - slot->tx_ns : 0;
+	slot->tx_ns = 0;
+
+	lat->hist[q][pktgen_lat_bucket(delta)]++;
+	lat->count[q]++;
+	lat->max[q] = max(lat->max[q], delta);
+	if (hw)
+		lat->hw_stamped++;
+unlock:
+	spin_unlock(&lat->lock);
+}
+
+static int pktgen_lat_rcv(struct sk_buff *skb, struct net_device *dev,
+			  struct packet_type *pt, struct net_device *orig_dev)
+{
+	struct pktgen_lat *lat = pt->af_packet_priv;
+	struct pktgen_dev *pkt_dev = lat->pkt_dev;
+	ktime_t hwtstamp = skb_hwtstamps(skb)->hwtstamp;
+	u64 rx_ns = hwtstamp ? ktime_to_ns(hwtstamp) : ktime_get_real_ns();
+	struct pktgen_hdr _pgh, *pgh;
+	struct udphdr _uh, *uh;
+	unsigned int off;
+	u16 port;
+
+	if (skb->protocol == htons(ETH_P_IP)) {
+		struct iphdr _iph, *iph;
+
+		iph = skb_header_pointer(skb, 0, sizeof(_iph), &_iph);
+		if (!iph || iph->protocol != IPPROTO_UDP || ip_is_fragment(iph))
+			goto out;
+		off = iph->ihl * 4;
+	} else {
+		struct ipv6hdr _ip6h, *ip6h;
+
+		ip6h = skb_header_pointer(skb, 0, sizeof(_ip6h), &_ip6h);
+		if (!ip6h || ip6h->nexthdr != IPPROTO_UDP)
+			goto out;
+		off = sizeof(*ip6h);
+	}
+
+	uh = skb_header_pointer(skb, off, sizeof(_uh), &_uh);
+	if (!uh)
+		goto out;
+
+	/* udp_dst_max is exclusive, see mod_cur_headers() */
+	port = ntohs(uh->dest);
+	if (port != pkt_dev->udp_dst_min &&
+	    (port < pkt_dev->udp_dst_min || port >= pkt_dev->udp_dst_max))
+		goto out;
+
+	pgh = skb_header_pointer(skb, off + sizeof(_uh), sizeof(_pgh), &_pgh);
+	if (pgh && pgh->pgh_magic == htonl(PKTGEN_MAGIC))
+		pktgen_lat_rx(lat, ntohl(pgh->seq_num), rx_ns, hwtstamp);
+out:
+	consume_skb(skb);
+	return NET_RX_SUCCESS;
+}
+
+static void pktgen_lat_free(struct pktgen_dev *pkt_dev)
+{
+	struct pktgen_lat *lat = pkt_dev->lat;
+
+	if (!lat)
+		return;
+
+	dev_remove_pack(&lat->pt[0]);
+	dev_remove_pack(&lat->pt[1]);
+	pkt_dev->lat = NULL;
+	vfree(lat);
+}
+
+/* Hook or unhook the receive side to follow the LATENCY flag */
+static int pktgen_lat_update(struct pktgen_dev *pkt_dev)
+{
+	struct pktgen_lat *lat;
+
+	if (!(pkt_dev->flags & F_LATENCY)) {
+		pktgen_lat_free(pkt_dev);
+		return 0;
+	}
+
+	if (pkt_dev->lat)
+		return 0;
+
+	lat = vzalloc(sizeof(*lat));
+	if (!lat)
+		return -ENOMEM;
+
+	spin_lock_init(&lat->lock);
+	lat->pkt_dev = pkt_dev;
+	lat->pt[0].type = htons(ETH_P_IP);
+	lat->pt[1].type = htons(ETH_P_IPV6);
+	lat->pt[0].func = lat->pt[1].func = pktgen_lat_rcv;
+	lat->pt[0].af_packet_priv = lat->pt[1].af_packet_priv = lat;
+	pkt_dev->lat = lat;
+
+	dev_add_pack(&lat->pt[0]);
+	dev_add_pack(&lat->pt[1]);
+	return 0;
+}
+
+static void pktgen_lat_show(struct seq_file *seq, struct pktgen_lat *lat)
+{
+	static const unsigned int permille[] = { 500, 990, 999 };
+	u64 at[ARRAY_SIZE(permille)] = { };
+	unsigned int q, b, p;
+	u64 sum;
+
+	spin_lock_bh(&lat->lock);
+	seq_printf(seq, "     latency: unmatched %llu hw_stamped %llu\n",
+		   lat->unmatched, lat->hw_stamped);
+
+	for (q = 0; q < PKTGEN_LAT_QUEUES; q++) {
+		if (!lat->count[q])
+			continue;
+
+		sum = 0;
+		p = 0;
+		for (b = 0; b < PKTGEN_LAT_BUCKETS && p < ARRAY_SIZE(at); b++) {
+			sum += lat->hist[q][b];
+			while (p < ARRAY_SIZE(at) &&
+			       sum * 1000 >= lat->count[q] * permille[p])
+				at[p++] = pktgen_lat_bucket_ns(b + 1);
+		}
+
+		seq_printf(seq, "     latency q%u: %llu pkts p50 %lluns p99 %lluns p999 %lluns max %lluns\n",
+			   q, lat->count[q], at[0], at[1], at[2], lat->max[q]);
+	}
+	spin_unlock_bh(&lat->lock);
+}
+
 
 static unsigned int pg_net_id __read_mostly;
 
@@ -658,6 +887,9 @@ static int pktgen_if_show(struct seq_file *seq, void *v)
 	if (pkt_dev->burst > 1)
 		seq_printf(seq, "     burst: %d\n", pkt_dev->burst);
 
+	if (pkt_dev->gro_segs > 1)
+		seq_printf(seq, "     gro_segs: %u\n", pkt_dev->gro_segs);
+
 	if (pkt_dev->node >= 0)
 		seq_printf(seq, "     node: %d\n", pkt_dev->node);
 
@@ -734,6 +966,9 @@ static int pktgen_if_show(struct seq_file *seq, void *v)
 
 	seq_printf(seq, "     flows: %u\n", pkt_dev->nflows);
 
+	if (pkt_dev->lat)
+		pktgen_lat_show(seq, pkt_dev->lat);
+
 	if (pkt_dev->result[0])
 		seq_printf(seq, "Result: %s\n", pkt_dev->result);
 	else
@@ -1261,6 +1496,25 @@ static ssize_t pktgen_if_write(struct file *file,
 		sprintf(pg_result, "OK: burst=%u", pkt_dev->burst);
 		return count;
 	}
+	if (!strcmp(name, "gro_segs")) {
+		len = num_arg(&user_buffer[i], 10, &value);
+		if (len < 0)
+			return len;
+
+		i += len;
+		/* Only meaningful when injecting into the local UDP stack,
+		 * which then sees what UDP GRO hands up from a NAPI poll.
+		 */
+		if ((value > 1) &&
+		    ((pkt_dev->xmit_mode != M_NETIF_RECEIVE) ||
+		     (pkt_dev->flags & F_IPV6)))
+			return -ENOTSUPP;
+		if (value > UDP_MAX_SEGMENTS)
+			return -EINVAL;
+		pkt_dev->gro_segs = value < 1 ? 1 : value;
+		sprintf(pg_result, "OK: gro_segs=%u", pkt_dev->gro_segs);
+		return count;
+	}
 	if (!strcmp(name, "node")) {
 		len = num_arg(&user_buffer[i], 10, &value);
 		if (len < 0)
@@ -1333,11 +1587,20 @@ static ssize_t pktgen_if_write(struct file *file,
 
 		flag = pktgen_read_flag(f, &disable);
 
+		/* the receive hook goes away with the flag */
+		if (flag == F_LATENCY && pkt_dev->running)
+			return -EBUSY;
+
 		if (flag) {
 			if (disable)
 				pkt_dev->flags &= ~flag;
 			else
 				pkt_dev->flags |= flag;
+
+			if (flag == F_LATENCY && pktgen_lat_update(pkt_dev)) {
+				pkt_dev->flags &= ~flag;
+				return -ENOMEM;
+			}
 		} else {
 			sprintf(pg_result,
 				"Flag -:%s:- unknown\nAvailable flags, (prepend ! to un-set flag):\n%s",
@@ -1346,7 +1609,7 @@ static ssize_t pktgen_if_write(struct file *file,
 				"MACSRC_RND, MACDST_RND, TXSIZE_RND, IPV6, "
 				"MPLS_RND, VID_RND, SVID_RND, FLOW_SEQ, "
 				"QUEUE_MAP_RND, QUEUE_MAP_CPU, UDPCSUM, "
-				"NO_TIMESTAMP, "
+				"NO_TIMESTAMP, LATENCY, "
 #ifdef CONFIG_XFRM
 				"IPSEC, "
 #endif
@@ -2837,7 +3100,8 @@ static struct sk_buff *pktgen_alloc_skb(struct net_device *dev,
 	struct sk_buff *skb = NULL;
 	unsigned int size;
 
-	size = pkt_dev->cur_pkt_size + 64 + extralen + pkt_dev->pkt_overhead;
+	size = pkt_dev->cur_pkt_size * pkt_dev->gro_segs + 64 + extralen +
+	       pkt_dev->pkt_overhead;
 	if (pkt_dev->flags & F_NODE) {
 		int node = pkt_dev->node >= 0 ? pkt_dev->node : numa_node_id();
 
@@ -2861,6 +3125,7 @@ static struct sk_buff *fill_packet_ipv4(struct net_device *odev,
 					struct pktgen_dev *pkt_dev)
 {
 	struct sk_buff *skb = NULL;
+	unsigned int segs = 1;
 	__u8 *eth;
 	struct udphdr *udph;
 	int datalen, iplen;
@@ -2936,9 +3201,14 @@ static struct sk_buff *fill_packet_ipv4(struct net_device *odev,
 	if (datalen < 0 || datalen < sizeof(struct pktgen_hdr))
 		datalen = sizeof(struct pktgen_hdr);
 
+	/* Emulate a UDP GRO train: one header, gro_segs datagrams of data */
+	if (pkt_dev->xmit_mode == M_NETIF_RECEIVE && pkt_dev->gro_segs > 1)
+		segs = min_t(unsigned int, pkt_dev->gro_segs,
+			     (IP_MAX_MTU - 20 - 8) / datalen);
+
 	udph->source = htons(pkt_dev->cur_udp_src);
 	udph->dest = htons(pkt_dev->cur_udp_dst);
-	udph->len = htons(datalen + 8);	/* DATA + udphdr */
+	udph->len = htons(datalen * segs + 8);	/* DATA + udphdr */
 	udph->check = 0;
 
 	iph->ihl = 5;
@@ -2951,16 +3221,24 @@ static struct sk_buff *fill_packet_ipv4(struct net_device *odev,
 	iph->id = htons(pkt_dev->ip_id);
 	pkt_dev->ip_id++;
 	iph->frag_off = 0;
-	iplen = 20 + 8 + datalen;
+	iplen = 20 + 8 + datalen * segs;
 	iph->tot_len = htons(iplen);
 	ip_send_check(iph);
 	skb->protocol = protocol;
 	skb->dev = odev;
 	skb->pkt_type = PACKET_HOST;
 
-	pktgen_finalize_skb(pkt_dev, skb, datalen);
+	pktgen_finalize_skb(pkt_dev, skb, datalen * segs);
 
-	if (!(pkt_dev->flags & F_UDPCSUM)) {
+	if (segs > 1) {
+		/* as udp_gro_complete() leaves it */
+		skb->ip_summed = CHECKSUM_PARTIAL;
+		skb->csum = 0;
+		udp4_hwcsum(skb, iph->saddr, iph->daddr);
+		skb_shinfo(skb)->gso_type = SKB_GSO_UDP_L4;
+		skb_shinfo(skb)->gso_size = datalen;
+		skb_shinfo(skb)->gso_segs = segs;
+	} else if (!(pkt_dev->flags & F_UDPCSUM)) {
 		skb->ip_summed = CHECKSUM_NONE;
 	} else if (odev->features & (NETIF_F_HW_CSUM | NETIF_F_IP_CSUM)) {
 		skb->ip_summed = CHECKSUM_PARTIAL;
@@ -3131,6 +3409,9 @@ static void pktgen_clear_counters(struct pktgen_dev *pkt_dev)
 	pkt_dev->sofar = 0;
 	pkt_dev->tx_bytes = 0;
 	pkt_dev->errors = 0;
+
+	if (pkt_dev->lat)
+		pktgen_lat_reset(pkt_dev->lat);
 }
 
 /* Set up structure for sending pkts, clear counters */
@@ -3513,6 +3794,10 @@ static void pktgen_xmit(struct pktgen_dev *pkt_dev)
 		local_bh_disable();
 		refcount_inc(&pkt_dev->skb->users);
 
+		if (pkt_dev->lat)
+			pktgen_lat_tx(pkt_dev->lat, pkt_dev->seq_num,
+				      skb_get_queue_mapping(pkt_dev->skb));
+
 		ret = dev_queue_xmit(pkt_dev->skb);
 		switch (ret) {
 		case NET_XMIT_SUCCESS:
@@ -3553,6 +3838,10 @@ static void pktgen_xmit(struct pktgen_dev *pkt_dev)
 	}
 	refcount_add(burst, &pkt_dev->skb->users);
 
+	if (pkt_dev->lat)
+		pktgen_lat_tx(pkt_dev->lat, pkt_dev->seq_num,
+			      skb_get_queue_mapping(pkt_dev->skb));
+
 xmit_more:
 	ret = netdev_start_xmit(pkt_dev->skb, odev, txq, --burst > 0);
 
@@ -3772,6 +4061,7 @@ static int pktgen_add_device(struct pktgen_thread *t, const char *ifname)
 	pkt_dev->svlan_cfi = 0;
 	pkt_dev->svlan_id = 0xffff;
 	pkt_dev->burst = 1;
+	pkt_dev->gro_segs = 1;
 	pkt_dev->node = NUMA_NO_NODE;
 
 	err = pktgen_setup_dev(t->net, pkt_dev, ifname);
@@ -3897,6 +4187,8 @@ static int pktgen_remove_device(struct pktgen_thread *t,
 		pktgen_stop_device(pkt_dev);
 	}
 
+	pktgen_lat_free(pkt_dev);
+
 	/* Dis-associate from the interface */
 
 	if (pkt_dev->odev) {
@@ -1,4 +1,5 @@
 // SPDX-License-Identifier: GPL-2.0
+#include <linux/dma-mapping.h>
 #include <linux/export.h>
 #include <linux/if_vlan.h>
 #include <net/ip.h>
@@ -13,6 +14,15 @@ int tso_count_descs(const struct sk_buff *skb)
 }
 EXPORT_SYMBOL(tso_count_descs);
 
+/* As above, when every data chunk but the first of a segment may need its
+ * unaligned head bounced through tso_align_data()
+ */
+int tso_count_descs_aligned(const struct sk_buff *skb)
+{
+	return (skb_shinfo(skb)->gso_segs + skb_shinfo(skb)->nr_frags + 1) * 2;
+}
+EXPORT_SYMBOL(tso_count_descs_aligned);
+
 void tso_build_hdr(const struct sk_buff *skb, char *hdr, struct tso_t *tso,
 		   int size, bool is_last)
 {
@@ -69,6 +79,28 @@ void tso_build_data(const struct sk_buff *skb, struct tso_t *tso, int size)
 }
 EXPORT_SYMBOL(tso_build_data);
 
+/* Copy the bytes of the current chunk that sit before an @align boundary
+ * into @buf and consume them, so that the rest of the chunk can be mapped
+ * by an engine that needs aligned buffers. @buf is either the space right
+ * after the header, which leaves room for up to 64 bytes of alignment in
+ * a TSO_HEADER_SIZE slot, or a spare slot of the header arena. @size is
+ * what is left of the segment. Returns the number of bytes copied.
+ */
+int tso_align_data(const struct sk_buff *skb, struct tso_t *tso, char *buf,
+		   int size, unsigned int align)
+{
+	int len = PTR_ALIGN(tso->data, align) - tso->data;
+
+	len = min3(len, tso->size, size);
+	if (!len)
+		return 0;
+
+	memcpy(buf, tso->data, len);
+	tso_build_data(skb, tso, len);
+	return len;
+}
+EXPORT_SYMBOL(tso_align_data);
+
 int tso_start(struct sk_buff *skb, struct tso_t *tso)
 {
 	int tlen = skb_is_gso_tcp(skb) ? tcp_hdrlen(skb) : sizeof(struct udphdr);
@@ -95,3 +127,32 @@ int tso_start(struct sk_buff *skb, struct tso_t *tso)
 	return hdr_len;
 }
 EXPORT_SYMBOL(tso_start);
+
+/* @align must be a power of two no larger than TSO_HEADER_SIZE */
+int tso_hdr_arena_alloc(struct device *dev, struct tso_hdr_arena *arena,
+			unsigned int count, unsigned int align)
+{
+	if (WARN_ON(!is_power_of_2(align) || align > TSO_HEADER_SIZE))
+		return -EINVAL;
+
+	arena->stride = ALIGN(TSO_HEADER_SIZE, align);
+	arena->buf = dma_alloc_coherent(dev, count * arena->stride,
+					&arena->dma, GFP_KERNEL);
+	if (!arena->buf)
+		return -ENOMEM;
+
+	arena->count = count;
+	return 0;
+}
+EXPORT_SYMBOL(tso_hdr_arena_alloc);
+
+void tso_hdr_arena_free(struct device *dev, struct tso_hdr_arena *arena)
+{
+	if (!arena->buf)
+		return;
+
+	dma_free_coherent(dev, arena->count * arena->stride, arena->buf,
+			  arena->dma);
+	arena->buf = NULL;
+}
+EXPORT_SYMBOL(tso_hdr_arena_free);
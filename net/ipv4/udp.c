@@ -1524,7 +1524,11 @@ static void busylock_release(spinlock_t *busy)
 		spin_unlock(busy);
 }
 
-int __udp_enqueue_schedule_skb(struct sock *sk, struct sk_buff *skb)
+/* @wake is false while a GRO train is being split for a socket that does
+ * not take it whole; the caller wakes the reader once after the last
+ * segment, so a recvmmsg() reader drains the batch in one pass.
+ */
+int __udp_enqueue_schedule_skb(struct sock *sk, struct sk_buff *skb, bool wake)
 {
 	struct sk_buff_head *list = &sk->sk_receive_queue;
 	int rmem, delta, amt, err = -ENOMEM;
@@ -1582,7 +1586,7 @@ int __udp_enqueue_schedule_skb(struct sock *sk, struct sk_buff *skb)
 	__skb_queue_tail(list, skb);
 	spin_unlock(&list->lock);
 
-	if (!sock_flag(sk, SOCK_DEAD))
+	if (wake && !sock_flag(sk, SOCK_DEAD))
 		sk->sk_data_ready(sk);
 
 	busylock_release(busy);
@@ -2072,7 +2076,7 @@ void udp_v4_rehash(struct sock *sk)
 	udp_lib_rehash(sk, new_hash);
 }
 
-static int __udp_queue_rcv_skb(struct sock *sk, struct sk_buff *skb)
+static int __udp_queue_rcv_skb(struct sock *sk, struct sk_buff *skb, bool wake)
 {
 	int rc;
 
@@ -2084,7 +2088,7 @@ static int __udp_queue_rcv_skb(struct sock *sk, struct sk_buff *skb)
 		sk_mark_napi_id_once(sk, skb);
 	}
 
-	rc = __udp_enqueue_schedule_skb(sk, skb);
+	rc = __udp_enqueue_schedule_skb(sk, skb, wake);
 	if (rc < 0) {
 		int is_udplite = IS_UDPLITE(sk);
 		int drop_reason;
@@ -2116,7 +2120,8 @@ static int __udp_queue_rcv_skb(struct sock *sk, struct sk_buff *skb)
  * Note that in the success and error cases, the skb is assumed to
  * have either been requeued or freed.
  */
-static int udp_queue_rcv_one_skb(struct sock *sk, struct sk_buff *skb)
+static int udp_queue_rcv_one_skb(struct sock *sk, struct sk_buff *skb,
+				 bool wake)
 {
 	int drop_reason = SKB_DROP_REASON_NOT_SPECIFIED;
 	struct udp_sock *up = udp_sk(sk);
@@ -2213,7 +2218,7 @@ static int udp_queue_rcv_one_skb(struct sock *sk, struct sk_buff *skb)
 	udp_csum_pull_header(skb);
 
 	ipv4_pktinfo_prepare(sk, skb);
-	return __udp_queue_rcv_skb(sk, skb);
+	return __udp_queue_rcv_skb(sk, skb, wake);
 
 csum_error:
 	drop_reason = SKB_DROP_REASON_UDP_CSUM;
@@ -2228,10 +2233,11 @@ static int udp_queue_rcv_one_skb(struct sock *sk, struct sk_buff *skb)
 static int udp_queue_rcv_skb(struct sock *sk, struct sk_buff *skb)
 {
 	struct sk_buff *next, *segs;
+	bool queued = false;
 	int ret;
 
 	if (likely(!udp_unexpected_gso(sk, skb)))
-		return udp_queue_rcv_one_skb(sk, skb);
+		return udp_queue_rcv_one_skb(sk, skb, true);
 
 	BUILD_BUG_ON(sizeof(struct udp_skb_cb) > SKB_GSO_CB_OFFSET);
 	__skb_push(skb, -skb_mac_offset(skb));
@@ -2240,10 +2246,16 @@ static int udp_queue_rcv_skb(struct sock *sk, struct sk_buff *skb)
 		__skb_pull(skb, skb_transport_offset(skb));
 
 		udp_post_segment_fix_csum(skb);
-		ret = udp_queue_rcv_one_skb(sk, skb);
+		ret = udp_queue_rcv_one_skb(sk, skb, false);
 		if (ret > 0)
 			ip_protocol_deliver_rcu(dev_net(skb->dev), skb, ret);
+		else if (!ret)
+			queued = true;
 	}
+
+	/* one wakeup for the whole train, see __udp_enqueue_schedule_skb() */
+	if (queued && !sock_flag(sk, SOCK_DEAD))
+		sk->sk_data_ready(sk);
 	return 0;
 }
 
@@ -649,7 +649,8 @@ int __udp6_lib_err(struct sk_buff *skb, struct inet6_skb_parm *opt,
 	return 0;
 }
 
-static int __udpv6_queue_rcv_skb(struct sock *sk, struct sk_buff *skb)
+static int __udpv6_queue_rcv_skb(struct sock *sk, struct sk_buff *skb,
+				 bool wake)
 {
 	int rc;
 
@@ -661,7 +662,7 @@ static int __udpv6_queue_rcv_skb(struct sock *sk, struct sk_buff *skb)
 		sk_mark_napi_id_once(sk, skb);
 	}
 
-	rc = __udp_enqueue_schedule_skb(sk, skb);
+	rc = __udp_enqueue_schedule_skb(sk, skb, wake);
 	if (rc < 0) {
 		int is_udplite = IS_UDPLITE(sk);
 		enum skb_drop_reason drop_reason;
@@ -691,7 +692,8 @@ static __inline__ int udpv6_err(struct sk_buff *skb,
 	return __udp6_lib_err(skb, opt, type, code, offset, info, &udp_table);
 }
 
-static int udpv6_queue_rcv_one_skb(struct sock *sk, struct sk_buff *skb)
+static int udpv6_queue_rcv_one_skb(struct sock *sk, struct sk_buff *skb,
+				   bool wake)
 {
 	enum skb_drop_reason drop_reason = SKB_DROP_REASON_NOT_SPECIFIED;
 	struct udp_sock *up = udp_sk(sk);
@@ -768,7 +770,7 @@ static int udpv6_queue_rcv_one_skb(struct sock *sk, struct sk_buff *skb)
 
 	skb_dst_drop(skb);
 
-	return __udpv6_queue_rcv_skb(sk, skb);
+	return __udpv6_queue_rcv_skb(sk, skb, wake);
 
 csum_error:
 	drop_reason = SKB_DROP_REASON_UDP_CSUM;
@@ -783,10 +785,11 @@ static int udpv6_queue_rcv_one_skb(struct sock *sk, struct sk_buff *skb)
 static int udpv6_queue_rcv_skb(struct sock *sk, struct sk_buff *skb)
 {
 	struct sk_buff *next, *segs;
+	bool queued = false;
 	int ret;
 
 	if (likely(!udp_unexpected_gso(sk, skb)))
-		return udpv6_queue_rcv_one_skb(sk, skb);
+		return udpv6_queue_rcv_one_skb(sk, skb, true);
 
 	__skb_push(skb, -skb_mac_offset(skb));
 	segs = udp_rcv_segment(sk, skb, false);
@@ -794,11 +797,16 @@ static int udpv6_queue_rcv_skb(struct sock *sk, struct sk_buff *skb)
 		__skb_pull(skb, skb_transport_offset(skb));
 
 		udp_post_segment_fix_csum(skb);
-		ret = udpv6_queue_rcv_one_skb(sk, skb);
+		ret = udpv6_queue_rcv_one_skb(sk, skb, false);
 		if (ret > 0)
 			ip6_protocol_deliver_rcu(dev_net(skb->dev), skb, ret,
 						 true);
+		else if (!ret)
+			queued = true;
 	}
+
+	if (queued && !sock_flag(sk, SOCK_DEAD))
+		sk->sk_data_ready(sk);
 	return 0;
 }
 
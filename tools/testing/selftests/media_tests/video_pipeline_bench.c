@@ -0,0 +1,597 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * video_pipeline_bench - Video Pipeline Benchmark
+ *
+ * Copyright (C) 2023 Xilinx, Inc. All rights reserved.
+ *
+ */
+
+/*
+ * This file adds a benchmark for video capture pipelines. This test should
+ * not be included in the Kselftest run. It should be run on a pipeline that
+ * has been configured with media-ctl, typically a Xilinx test pattern
+ * generator feeding the write channel of a frame buffer through the VIP
+ * pipeline.
+ *
+ * The benchmark streams the given number of frames from the capture device
+ * and reports:
+ *	- the sustained frame rate and the DDR bandwidth it implies
+ *	- the latency from the DMA end of frame timestamp to the dequeue
+ *	- the frames dropped, from the gaps between the frame timestamps
+ *	- the buffers completed with an error
+ *	- with -c or -C, the frames whose CRC32 does not match the given one,
+ *	  or that of the first frame
+ *
+ * -s and -p select the pattern of the TPG sub-device before streaming. -c
+ * is meant for static patterns, the CRC printed by a run on a known good
+ * bitstream and kernel can be given to later runs. The CRC is computed by
+ * the CPU over uncached buffers, which can limit the frame rate.
+ *
+ * With -o the captured buffers are also queued, through dmabuf and without
+ * a copy, to a video output device, such as the read channel of a frame
+ * buffer feeding a display or mem2mem pipeline, with the capture format.
+ * A buffer is only captured into again once the output device is done
+ * with it, so the output path takes part in the frame rate.
+ *
+ * Usage:
+ *	sudo ./video_pipeline_bench -d </dev/videoX> [-n frames] [-b buffers]
+ *		[-r fps] [-s </dev/v4l-subdevY> -p pattern] [-c crc | -C]
+ *		[-o </dev/videoZ>]
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <linux/videodev2.h>
+
+#define MAX_BUFFERS	32
+#define POLL_TIMEOUT_MS	2000
+
+struct bench_buf {
+	void *start[VIDEO_MAX_PLANES];
+	size_t length[VIDEO_MAX_PLANES];
+	int dmabuf[VIDEO_MAX_PLANES];
+};
+
+struct bench_dev {
+	int fd;
+	enum v4l2_buf_type type;
+	bool mplane;
+	unsigned int nplanes;
+	struct v4l2_format fmt;
+};
+
+static uint32_t crc_table[256];
+
+static void crc32_init(void)
+{
+	uint32_t c;
+	int i, j;
+
+	for (i = 0; i < 256; i++) {
+		c = i;
+		for (j = 0; j < 8; j++)
+			c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+		crc_table[i] = c;
+	}
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *p, size_t len)
+{
+	while (len--)
+		crc = crc_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+
+	return crc;
+}
+
+static int xioctl(int fd, unsigned long req, void *arg)
+{
+	int ret;
+
+	do {
+		ret = ioctl(fd, req, arg);
+	} while (ret == -1 && errno == EINTR);
+
+	return ret;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int dev_open(struct bench_dev *dev, const char *path, bool output)
+{
+	struct v4l2_capability vcap;
+	uint32_t caps;
+
+	dev->fd = open(path, O_RDWR | O_NONBLOCK);
+	if (dev->fd == -1) {
+		printf("%s open errno %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	if (xioctl(dev->fd, VIDIOC_QUERYCAP, &vcap)) {
+		printf("%s VIDIOC_QUERYCAP errno %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	caps = vcap.capabilities & V4L2_CAP_DEVICE_CAPS ?
+	       vcap.device_caps : vcap.capabilities;
+	if (!(caps & V4L2_CAP_STREAMING)) {
+		printf("%s does not support streaming\n", path);
+		return -1;
+	}
+
+	if (output && caps & V4L2_CAP_VIDEO_OUTPUT_MPLANE) {
+		dev->type = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
+	} else if (output && caps & V4L2_CAP_VIDEO_OUTPUT) {
+		dev->type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+	} else if (!output && caps & V4L2_CAP_VIDEO_CAPTURE_MPLANE) {
+		dev->type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+	} else if (!output && caps & V4L2_CAP_VIDEO_CAPTURE) {
+		dev->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	} else {
+		printf("%s is not a video %s device\n", path,
+		       output ? "output" : "capture");
+		return -1;
+	}
+	dev->mplane = dev->type == V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE ||
+		      dev->type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+
+	return 0;
+}
+
+static int dev_get_format(struct bench_dev *dev)
+{
+	memset(&dev->fmt, 0, sizeof(dev->fmt));
+	dev->fmt.type = dev->type;
+	if (xioctl(dev->fd, VIDIOC_G_FMT, &dev->fmt)) {
+		printf("VIDIOC_G_FMT errno %s\n", strerror(errno));
+		return -1;
+	}
+	dev->nplanes = dev->mplane ? dev->fmt.fmt.pix_mp.num_planes : 1;
+
+	return 0;
+}
+
+/* Give the output device the capture format */
+static int dev_set_format(struct bench_dev *dev, const struct bench_dev *src)
+{
+	if (dev->mplane != src->mplane) {
+		printf("Capture and output must both be single or multi-planar\n");
+		return -1;
+	}
+
+	dev->fmt = src->fmt;
+	dev->fmt.type = dev->type;
+	if (xioctl(dev->fd, VIDIOC_S_FMT, &dev->fmt)) {
+		printf("Output VIDIOC_S_FMT errno %s\n", strerror(errno));
+		return -1;
+	}
+	dev->nplanes = dev->mplane ? dev->fmt.fmt.pix_mp.num_planes : 1;
+
+	if (dev->nplanes != src->nplanes ||
+	    (dev->mplane ? dev->fmt.fmt.pix_mp.pixelformat !=
+			   src->fmt.fmt.pix_mp.pixelformat :
+			   dev->fmt.fmt.pix.pixelformat !=
+			   src->fmt.fmt.pix.pixelformat)) {
+		printf("Output device does not support the capture format\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static int dev_reqbufs(struct bench_dev *dev, unsigned int memory,
+		       unsigned int *count)
+{
+	struct v4l2_requestbuffers req;
+
+	memset(&req, 0, sizeof(req));
+	req.count = *count;
+	req.type = dev->type;
+	req.memory = memory;
+	if (xioctl(dev->fd, VIDIOC_REQBUFS, &req)) {
+		printf("VIDIOC_REQBUFS errno %s\n", strerror(errno));
+		return -1;
+	}
+
+	if (!req.count) {
+		printf("No buffers allocated\n");
+		return -1;
+	}
+	*count = req.count;
+
+	return 0;
+}
+
+static void buf_init(const struct bench_dev *dev, struct v4l2_buffer *buf,
+		     struct v4l2_plane *planes, unsigned int memory,
+		     unsigned int index)
+{
+	memset(buf, 0, sizeof(*buf));
+	buf->type = dev->type;
+	buf->memory = memory;
+	buf->index = index;
+	if (dev->mplane) {
+		memset(planes, 0, sizeof(*planes) * VIDEO_MAX_PLANES);
+		buf->m.planes = planes;
+		buf->length = dev->nplanes;
+	}
+}
+
+static int cap_map_buffers(struct bench_dev *dev, struct bench_buf *bufs,
+			   unsigned int count, bool export)
+{
+	struct v4l2_plane planes[VIDEO_MAX_PLANES];
+	struct v4l2_exportbuffer expbuf;
+	struct v4l2_buffer buf;
+	unsigned int i, p;
+	off_t offset;
+
+	for (i = 0; i < count; i++) {
+		buf_init(dev, &buf, planes, V4L2_MEMORY_MMAP, i);
+		if (xioctl(dev->fd, VIDIOC_QUERYBUF, &buf)) {
+			printf("VIDIOC_QUERYBUF errno %s\n", strerror(errno));
+			return -1;
+		}
+
+		for (p = 0; p < dev->nplanes; p++) {
+			bufs[i].length[p] = dev->mplane ?
+					    planes[p].length : buf.length;
+			offset = dev->mplane ? planes[p].m.mem_offset :
+				 buf.m.offset;
+			bufs[i].start[p] = mmap(NULL, bufs[i].length[p],
+						PROT_READ, MAP_SHARED,
+						dev->fd, offset);
+			if (bufs[i].start[p] == MAP_FAILED) {
+				printf("mmap errno %s\n", strerror(errno));
+				return -1;
+			}
+
+			bufs[i].dmabuf[p] = -1;
+			if (!export)
+				continue;
+
+			memset(&expbuf, 0, sizeof(expbuf));
+			expbuf.type = dev->type;
+			expbuf.index = i;
+			expbuf.plane = p;
+			expbuf.flags = O_RDWR;
+			if (xioctl(dev->fd, VIDIOC_EXPBUF, &expbuf)) {
+				printf("VIDIOC_EXPBUF errno %s\n",
+				       strerror(errno));
+				return -1;
+			}
+			bufs[i].dmabuf[p] = expbuf.fd;
+		}
+	}
+
+	return 0;
+}
+
+static int cap_queue(struct bench_dev *dev, unsigned int index)
+{
+	struct v4l2_plane planes[VIDEO_MAX_PLANES];
+	struct v4l2_buffer buf;
+
+	buf_init(dev, &buf, planes, V4L2_MEMORY_MMAP, index);
+	if (xioctl(dev->fd, VIDIOC_QBUF, &buf)) {
+		printf("Capture VIDIOC_QBUF errno %s\n", strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+static int out_queue(struct bench_dev *dev, const struct bench_buf *bb,
+		     const struct v4l2_buffer *cap, unsigned int index)
+{
+	struct v4l2_plane planes[VIDEO_MAX_PLANES];
+	struct v4l2_buffer buf;
+	unsigned int p;
+
+	buf_init(dev, &buf, planes, V4L2_MEMORY_DMABUF, index);
+	if (dev->mplane) {
+		for (p = 0; p < dev->nplanes; p++) {
+			planes[p].m.fd = bb->dmabuf[p];
+			planes[p].length = bb->length[p];
+			planes[p].bytesused = cap->m.planes[p].bytesused;
+		}
+	} else {
+		buf.m.fd = bb->dmabuf[0];
+		buf.length = bb->length[0];
+		buf.bytesused = cap->bytesused;
+	}
+
+	if (xioctl(dev->fd, VIDIOC_QBUF, &buf)) {
+		printf("Output VIDIOC_QBUF errno %s\n", strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+static int stream(struct bench_dev *dev, bool on)
+{
+	int type = dev->type;
+
+	if (xioctl(dev->fd, on ? VIDIOC_STREAMON : VIDIOC_STREAMOFF, &type)) {
+		printf("VIDIOC_STREAM%s errno %s\n", on ? "ON" : "OFF",
+		       strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+static int set_pattern(const char *path, int pattern)
+{
+	struct v4l2_control ctrl;
+	int fd, ret;
+
+	fd = open(path, O_RDWR);
+	if (fd == -1) {
+		printf("%s open errno %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	memset(&ctrl, 0, sizeof(ctrl));
+	ctrl.id = V4L2_CID_TEST_PATTERN;
+	ctrl.value = pattern;
+	ret = xioctl(fd, VIDIOC_S_CTRL, &ctrl);
+	if (ret)
+		printf("%s V4L2_CID_TEST_PATTERN errno %s\n", path,
+		       strerror(errno));
+	close(fd);
+
+	return ret;
+}
+
+static void usage(const char *name)
+{
+	printf("Usage: %s -d </dev/videoX> [-n frames] [-b buffers] [-r fps]\n"
+	       "\t[-s </dev/v4l-subdevY> -p pattern] [-c crc | -C]\n"
+	       "\t[-o </dev/videoZ>]\n", name);
+	exit(-1);
+}
+
+int main(int argc, char **argv)
+{
+	const char *video_dev = NULL, *out_dev = NULL, *tpg_dev = NULL;
+	unsigned int frames = 600, nbufs = 4, nframes = 0, i, p;
+	uint64_t *latency, *interval, first_ts = 0, prev_ts = 0;
+	uint64_t bytes = 0, period_ns = 0, dropped = 0, sum = 0;
+	struct bench_buf bufs[MAX_BUFFERS];
+	struct v4l2_plane planes[VIDEO_MAX_PLANES];
+	struct bench_dev cap, out = { .fd = -1 };
+	unsigned int errors = 0, mismatches = 0, out_queued = 0;
+	bool check_crc = false, check_first = false, out_on = false;
+	uint32_t crc, expected_crc = 0;
+	struct v4l2_buffer buf;
+	struct pollfd pfd[2];
+	int pattern = -1;
+	double fps, secs;
+	uint64_t ts, n;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "d:n:b:r:s:p:c:Co:")) != -1) {
+		switch (opt) {
+		case 'd':
+			video_dev = optarg;
+			break;
+		case 'n':
+			frames = strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			nbufs = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			fps = strtod(optarg, NULL);
+			if (fps > 0)
+				period_ns = 1000000000.0 / fps;
+			break;
+		case 's':
+			tpg_dev = optarg;
+			break;
+		case 'p':
+			pattern = strtol(optarg, NULL, 0);
+			break;
+		case 'c':
+			expected_crc = strtoul(optarg, NULL, 0);
+			check_crc = true;
+			break;
+		case 'C':
+			check_crc = true;
+			check_first = true;
+			break;
+		case 'o':
+			out_dev = optarg;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (!video_dev || frames < 2 || !nbufs || nbufs > MAX_BUFFERS ||
+	    (tpg_dev && pattern < 0))
+		usage(argv[0]);
+
+	crc32_init();
+	latency = calloc(frames, sizeof(*latency));
+	interval = calloc(frames, sizeof(*interval));
+	if (!latency || !interval) {
+		printf("Out of memory\n");
+		exit(-1);
+	}
+
+	if (tpg_dev && set_pattern(tpg_dev, pattern))
+		exit(-1);
+
+	if (dev_open(&cap, video_dev, false) || dev_get_format(&cap))
+		exit(-1);
+
+	if (out_dev && (dev_open(&out, out_dev, true) ||
+			dev_set_format(&out, &cap)))
+		exit(-1);
+
+	if (dev_reqbufs(&cap, V4L2_MEMORY_MMAP, &nbufs) ||
+	    cap_map_buffers(&cap, bufs, nbufs, out_dev != NULL))
+		exit(-1);
+
+	if (out_dev && dev_reqbufs(&out, V4L2_MEMORY_DMABUF, &nbufs))
+		exit(-1);
+
+	for (i = 0; i < nbufs; i++)
+		if (cap_queue(&cap, i))
+			exit(-1);
+
+	if (stream(&cap, true))
+		exit(-1);
+
+	pfd[0].fd = cap.fd;
+	pfd[0].events = POLLIN;
+	pfd[1].fd = out.fd;
+	pfd[1].events = POLLOUT;
+
+	while (nframes < frames) {
+		pfd[1].fd = out_queued ? out.fd : -1;
+		if (poll(pfd, 2, POLL_TIMEOUT_MS) <= 0) {
+			printf("No frame for %d ms, frame %u\n",
+			       POLL_TIMEOUT_MS, nframes);
+			exit(-1);
+		}
+
+		/* Output done with a buffer, capture into it again */
+		if (pfd[1].revents & POLLOUT) {
+			buf_init(&out, &buf, planes, V4L2_MEMORY_DMABUF, 0);
+			if (!xioctl(out.fd, VIDIOC_DQBUF, &buf)) {
+				out_queued--;
+				if (cap_queue(&cap, buf.index))
+					exit(-1);
+			} else if (errno != EAGAIN) {
+				printf("Output VIDIOC_DQBUF errno %s\n",
+				       strerror(errno));
+				exit(-1);
+			}
+		}
+
+		if (!(pfd[0].revents & POLLIN))
+			continue;
+
+		buf_init(&cap, &buf, planes, V4L2_MEMORY_MMAP, 0);
+		if (xioctl(cap.fd, VIDIOC_DQBUF, &buf)) {
+			if (errno == EAGAIN)
+				continue;
+			printf("Capture VIDIOC_DQBUF errno %s\n",
+			       strerror(errno));
+			exit(-1);
+		}
+
+		ts = buf.timestamp.tv_sec * 1000000000ULL +
+		     buf.timestamp.tv_usec * 1000ULL;
+		latency[nframes] = now_ns() - ts;
+		if (nframes) {
+			interval[nframes - 1] = ts - prev_ts;
+		} else {
+			first_ts = ts;
+		}
+		prev_ts = ts;
+
+		if (buf.flags & V4L2_BUF_FLAG_ERROR)
+			errors++;
+
+		crc = ~0U;
+		for (p = 0; p < cap.nplanes; p++) {
+			n = cap.mplane ? planes[p].bytesused : buf.bytesused;
+			bytes += n;
+			if (check_crc)
+				crc = crc32_update(crc,
+						   bufs[buf.index].start[p], n);
+		}
+		crc = ~crc;
+
+		if (check_crc) {
+			if (!nframes)
+				printf("Frame 0 CRC32 0x%08x\n", crc);
+			if (!nframes && check_first)
+				expected_crc = crc;
+			if (crc != expected_crc)
+				mismatches++;
+		}
+
+		nframes++;
+		if (out_dev) {
+			if (out_queue(&out, &bufs[buf.index], &buf,
+				      buf.index))
+				exit(-1);
+			out_queued++;
+			if (!out_on && stream(&out, true))
+				exit(-1);
+			out_on = true;
+		} else if (cap_queue(&cap, buf.index)) {
+			exit(-1);
+		}
+	}
+
+	stream(&cap, false);
+	if (out_dev)
+		stream(&out, false);
+
+	/* Without a nominal frame rate, the shortest interval is one frame */
+	qsort(interval, nframes - 1, sizeof(*interval), cmp_u64);
+	if (!period_ns)
+		period_ns = interval[0];
+	for (i = 0; i < nframes - 1 && period_ns; i++) {
+		n = (interval[i] + period_ns / 2) / period_ns;
+		if (n > 1)
+			dropped += n - 1;
+	}
+
+	qsort(latency, nframes, sizeof(*latency), cmp_u64);
+	for (i = 0; i < nframes; i++)
+		sum += latency[i];
+
+	secs = (prev_ts - first_ts) / 1e9;
+	fps = secs > 0 ? (nframes - 1) / secs : 0;
+
+	printf("Frames: %u in %.3f s, %.2f fps\n", nframes, secs, fps);
+	printf("Bandwidth: %.1f MB/s written%s\n",
+	       secs > 0 ? bytes * (nframes - 1.0) / nframes / secs / 1e6 : 0,
+	       out_dev ? ", as much read" : "");
+	printf("Interval: min %.3f ms, max %.3f ms\n",
+	       interval[0] / 1e6, interval[nframes - 2] / 1e6);
+	printf("Latency: min %.3f ms, avg %.3f ms, p99 %.3f ms, max %.3f ms\n",
+	       latency[0] / 1e6, sum / nframes / 1e6,
+	       latency[(nframes - 1) * 99 / 100] / 1e6,
+	       latency[nframes - 1] / 1e6);
+	printf("Dropped: %llu, errors: %u\n", (unsigned long long)dropped,
+	       errors);
+	if (check_crc)
+		printf("CRC32 0x%08x mismatches: %u\n", expected_crc,
+		       mismatches);
+
+	return errors || mismatches ? 1 : 0;
+}